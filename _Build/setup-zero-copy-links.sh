@@ -3,6 +3,11 @@
 #
 # This script creates symlinks from _Build/packages/ to Conan cache
 # packages, implementing the zero-copy deployment pattern.
+#
+# Usage: ./setup-zero-copy-links.sh [--verify] [--link-mode MODE]
+#   --verify             re-check recorded links on disk (repairs manual edits)
+#   --link-mode MODE     symlink (default), hardlink, reflink or copy
+#   ZERO_COPY_REPORT=1   also list the links and report disk usage
 
 set -e
 
@@ -21,17 +26,11 @@ echo -e "${BLUE}SpareTools Zero-Copy Symlink Setup${NC}"
 echo -e "${BLUE}━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━${NC}"
 echo
 
-# Create packages directory if it doesn't exist
-mkdir -p "$BUILD_DIR/packages"
-
-# Create symlink to Conan cache root
-echo -e "${BLUE}Setting up Conan cache symlink...${NC}"
-if [ -L "$BUILD_DIR/conan-cache" ]; then
-    rm "$BUILD_DIR/conan-cache"
-fi
-ln -sfn "$CONAN_CACHE" "$BUILD_DIR/conan-cache"
-echo -e "${GREEN}✓${NC} conan-cache -> $CONAN_CACHE"
-echo
+# Links are applied by the sparetools-base deployer: it diffs the wanted
+# set against the state file from the previous run and only touches links
+# that changed, so re-running on an unchanged cache is nearly free.
+DEPLOYER="$SCRIPT_DIR/../packages/sparetools-base/symlink-helpers.py"
+STATE_FILE="$BUILD_DIR/.zero-copy-links.json"
 
 # Package list
 packages=(
@@ -43,36 +42,39 @@ packages=(
     "sparetools-openssl"
 )
 
-echo -e "${BLUE}Setting up package symlinks...${NC}"
-found_count=0
-missing_count=0
+# One listing of the cache instead of one find per package
+cache_entries=()
+if [ -d "$CONAN_CACHE/p" ]; then
+    mapfile -t cache_entries < <(find "$CONAN_CACHE/p" -mindepth 1 -maxdepth 1 -type d 2>/dev/null | sort -V)
+fi
 
+links=(--link "$BUILD_DIR/conan-cache=$CONAN_CACHE")
+missing=()
 for pkg in "${packages[@]}"; do
-    # Find the latest package in Conan cache
-    pkg_path=$(find "$CONAN_CACHE/p" -maxdepth 1 -type d -name "${pkg}*" 2>/dev/null | sort -V | tail -1)
-    
-    if [ -n "$pkg_path" ] && [ -d "$pkg_path/p" ]; then
-        # Remove old symlink if exists
-        if [ -L "$BUILD_DIR/packages/$pkg" ]; then
-            rm "$BUILD_DIR/packages/$pkg"
-        fi
-        
-        # Create new symlink
-        ln -sfn "$pkg_path/p" "$BUILD_DIR/packages/$pkg"
-        echo -e "${GREEN}✓${NC} $pkg -> $pkg_path/p"
-        ((found_count++))
+    # Latest matching package folder (entries are version-sorted)
+    pkg_path=""
+    for entry in "${cache_entries[@]}"; do
+        case "${entry##*/}" in
+            "$pkg"*) [ -d "$entry/p" ] && pkg_path="$entry" ;;
+        esac
+    done
+    if [ -n "$pkg_path" ]; then
+        links+=(--link "$BUILD_DIR/packages/$pkg=$pkg_path/p")
     else
-        echo -e "${YELLOW}⚠${NC} $pkg not found in Conan cache"
-        ((missing_count++))
+        missing+=("$pkg")
     fi
 done
 
+echo -e "${BLUE}Applying link manifest...${NC}"
+python3 "$DEPLOYER" --state "$STATE_FILE" "${links[@]}" "$@"
+found_count=$(( ${#packages[@]} - ${#missing[@]} ))
+missing_count=${#missing[@]}
 echo
 echo -e "${BLUE}━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━${NC}"
 echo -e "${GREEN}Summary:${NC}"
 echo -e "  Packages linked: ${found_count}/${#packages[@]}"
 if [ $missing_count -gt 0 ]; then
-    echo -e "  ${YELLOW}Missing packages: ${missing_count}${NC}"
+    echo -e "  ${YELLOW}Missing packages: ${missing[*]}${NC}"
     echo
     echo -e "${YELLOW}To build missing packages:${NC}"
     echo -e "  cd /home/sparrow/sparetools"
@@ -81,17 +83,18 @@ fi
 echo -e "${BLUE}━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━${NC}"
 echo
 
-# Verify symlinks
-echo -e "${BLUE}Verifying symlinks...${NC}"
-ls -lh "$BUILD_DIR/packages/" 2>/dev/null | grep -E '^l' || echo "No symlinks created"
-echo
+# Listing and du walk the whole cache: only on request
+if [ -n "$ZERO_COPY_REPORT" ]; then
+    echo -e "${BLUE}Verifying symlinks...${NC}"
+    ls -lh "$BUILD_DIR/packages/" 2>/dev/null | grep -E '^l' || echo "No symlinks created"
+    echo
 
-# Show disk usage comparison
-echo -e "${BLUE}Disk Usage Analysis:${NC}"
-cache_usage=$(du -sh "$CONAN_CACHE" 2>/dev/null | awk '{print $1}' || echo "N/A")
-build_usage=$(du -sh "$BUILD_DIR/packages" 2>/dev/null | awk '{print $1}' || echo "N/A")
-echo -e "  Conan cache:      ${cache_usage}"
-echo -e "  _Build/packages:  ${build_usage} ${GREEN}(symlinks only)${NC}"
-echo
+    echo -e "${BLUE}Disk Usage Analysis:${NC}"
+    cache_usage=$(du -sh "$CONAN_CACHE" 2>/dev/null | awk '{print $1}' || echo "N/A")
+    build_usage=$(du -sh "$BUILD_DIR/packages" 2>/dev/null | awk '{print $1}' || echo "N/A")
+    echo -e "  Conan cache:      ${cache_usage}"
+    echo -e "  _Build/packages:  ${build_usage} ${GREEN}(symlinks only)${NC}"
+    echo
+fi
 
 echo -e "${GREEN}✓ Zero-copy setup complete!${NC}"
@@ -2,6 +2,14 @@
 from .symlink_helpers import (
     symlink_with_check,
     symlink_all_child_folders,
+    child_folder_manifest,
+    load_link_manifest,
+    deploy_link_manifest,
+    materialize,
+    reflink_file,
+    LINK_MODES,
+    consolidate_shared_libs,
+    patch_runpath,
     create_zero_copy_environment,
     validate_zero_copy_setup,
     get_conan_cache_stats
@@ -18,6 +26,14 @@ __version__ = "1.0.0"
 __all__ = [
     "symlink_with_check",
     "symlink_all_child_folders",
+    "child_folder_manifest",
+    "load_link_manifest",
+    "deploy_link_manifest",
+    "materialize",
+    "reflink_file",
+    "LINK_MODES",
+    "consolidate_shared_libs",
+    "patch_runpath",
     "create_zero_copy_environment",
     "validate_zero_copy_setup",
     "get_conan_cache_stats",
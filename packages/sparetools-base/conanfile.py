@@ -1,6 +1,205 @@
+import errno
+import hashlib
+import json
+import os
+import re
+import shutil
+import stat
+import subprocess
+import sys
+
 from conan import ConanFile
 from conan.tools.files import copy
 
+# Test suites are never imported by builds; skip them when precompiling
+PRECOMPILE_EXCLUDE = r"[/\\](?:test|tests|idle_test)[/\\]"
+
+
+def precompile_python(conanfile, folder, python=None, env=None, exclude=PRECOMPILE_EXCLUDE):
+    """
+    Write __pycache__/*.pyc for every module under folder, in
+    unchecked-hash mode: the interpreter trusts the .pyc without comparing
+    source mtimes, so the bytecode stays valid when Conan copies the
+    package to another cache or machine. Compiles with python (and env)
+    when given, so the .pyc tag matches that interpreter, else with the
+    interpreter running Conan.
+
+    Usage from a recipe with python_requires = "sparetools-base/...":
+        self.python_requires["sparetools-base"].module.precompile_python(self, folder)
+    """
+    if python:
+        cmd = [python, "-m", "compileall", "-q", "-j0", "--invalidation-mode", "unchecked-hash",
+               "-x", exclude, folder]
+        result = subprocess.run(cmd, env=env, capture_output=True, text=True)
+        # compileall exits 1 when some file fails to compile (e.g. Python 2
+        # leftovers in lib2to3 test data); the rest is still written
+        if result.returncode not in (0, 1):
+            raise RuntimeError(f"compileall failed: {result.stderr.strip()}")
+        conanfile.output.info(f"Precompiled {folder} with {python}")
+        return
+    import compileall
+    import py_compile
+    compileall.compile_dir(folder, quiet=1, workers=0, rx=re.compile(exclude),
+                           invalidation_mode=py_compile.PycInvalidationMode.UNCHECKED_HASH)
+    conanfile.output.info(f"Precompiled {folder} for {sys.implementation.cache_tag}")
+
+
+# What `make install_docs` / a CMake docs component add under the prefix
+DOC_FOLDERS = ("share/doc", "share/man", "share/html")
+
+
+def staged_root(stage, prefix):
+    """Where a DESTDIR=stage install of an absolute prefix lands"""
+    return os.path.join(stage, os.path.splitdrive(prefix)[1].lstrip("/\\"))
+
+
+def hardlink_duplicates(folder):
+    """
+    Replace byte-identical regular files under folder by hardlinks to
+    one of them (e.g. ssl/openssl.cnf and openssl.cnf.dist). Files are
+    bucketed by size first, so only candidates are hashed. Returns the
+    number of bytes no longer stored twice.
+    """
+    by_size = {}
+    for dirpath, _, filenames in os.walk(folder):
+        for name in filenames:
+            path = os.path.join(dirpath, name)
+            st = os.lstat(path)
+            if stat.S_ISREG(st.st_mode) and st.st_size:
+                by_size.setdefault(st.st_size, []).append((path, st))
+    saved = 0
+    for size, files in by_size.items():
+        if len(files) < 2:
+            continue
+        first = {}
+        for path, st in files:
+            digest = hashlib.sha256()
+            with open(path, "rb") as f:
+                for chunk in iter(lambda: f.read(1 << 20), b""):
+                    digest.update(chunk)
+            # Files differing in mode (e.g. an executable copy) stay separate
+            original, original_st = first.setdefault((digest.digest(), st.st_mode), (path, st))
+            if original == path or (original_st.st_ino, original_st.st_dev) == (st.st_ino, st.st_dev):
+                continue
+            temporary = f"{path}.link-tmp"
+            os.link(original, temporary)
+            os.replace(temporary, path)
+            saved += size
+    return saved
+
+
+def promote_staged_install(conanfile, root, docs=False):
+    """
+    Move a staged install tree into conanfile.package_folder by renaming
+    its top-level entries, so package() copies nothing. Documentation
+    folders are dropped unless docs is set, and identical files are
+    hardlinked first. The stage must live on the package folder's
+    filesystem (both are in the Conan cache); otherwise entries are moved.
+    """
+    if not os.path.isdir(root):
+        raise RuntimeError(f"No staged install at {root}; build() stages it")
+    if not docs:
+        for folder in DOC_FOLDERS:
+            shutil.rmtree(os.path.join(root, folder), ignore_errors=True)
+        share = os.path.join(root, "share")
+        if os.path.isdir(share) and not os.listdir(share):
+            os.rmdir(share)
+    saved = hardlink_duplicates(root)
+    os.makedirs(conanfile.package_folder, exist_ok=True)
+    for entry in os.listdir(root):
+        source = os.path.join(root, entry)
+        destination = os.path.join(conanfile.package_folder, entry)
+        if os.path.isdir(destination) and not os.path.islink(destination):
+            shutil.copytree(source, destination, symlinks=True, dirs_exist_ok=True)
+            shutil.rmtree(source)
+            continue
+        try:
+            os.replace(source, destination)
+        except OSError as e:
+            if e.errno != errno.EXDEV:
+                raise
+            shutil.move(source, destination)
+    conanfile.output.info(f"Packaged staged install from {root} ({saved} bytes hardlinked)")
+
+
+# Written by write_artifact_manifest, read by the orchestrator and status reporter
+ARTIFACT_MANIFEST = "res/sparetools-artifacts.json"
+
+
+def classify_artifact(rel, mode):
+    """Kind of a packaged file from its relative path and mode alone"""
+    name = rel.rsplit("/", 1)[-1]
+    top = rel.split("/", 1)[0]
+    if name.endswith(".debug") or ".dSYM/" in rel or name.endswith(".pdb"):
+        return "debug_symbols"
+    if top == "include":
+        return "header"
+    if name.endswith((".a", ".lib")):
+        return "static_library"
+    if "/ossl-modules/" in f"/{rel}" or "/engines-" in f"/{rel}":
+        return "module"
+    if re.search(r"\.(so(\.\d+)*|dylib|dll)$", name):
+        return "shared_library"
+    if top == "bin" or (stat.S_ISREG(mode) and mode & stat.S_IXUSR and top != "res"):
+        return "executable"
+    if name.endswith((".cnf", ".cnf.dist")):
+        return "config"
+    if name.endswith((".pem", ".crt")) or "/certs/" in f"/{rel}":
+        return "trust"
+    if top == "licenses":
+        return "license"
+    return "other"
+
+
+def write_artifact_manifest(conanfile, folder=None):
+    """
+    List every file of the package (default: conanfile.package_folder) in
+    ARTIFACT_MANIFEST with path, size, sha256 and kind, so consumers read
+    one JSON instead of walking and opening the tree. Hardlinked files are
+    hashed once. Symlinks are listed with their target and no digest.
+    Call it last in package(). Returns the manifest path.
+    """
+    folder = folder or conanfile.package_folder
+    manifest_path = os.path.join(folder, ARTIFACT_MANIFEST)
+    by_inode = {}
+    entries = []
+    for dirpath, dirnames, filenames in os.walk(folder):
+        dirnames.sort()
+        for name in sorted(filenames):
+            path = os.path.join(dirpath, name)
+            rel = os.path.relpath(path, folder).replace(os.sep, "/")
+            if path == manifest_path:
+                continue
+            st = os.lstat(path)
+            entry = {"path": rel, "kind": classify_artifact(rel, st.st_mode)}
+            if stat.S_ISLNK(st.st_mode):
+                entry.update(size=0, link=os.readlink(path))
+            elif stat.S_ISREG(st.st_mode):
+                key = (st.st_dev, st.st_ino)
+                if key not in by_inode:
+                    digest = hashlib.sha256()
+                    with open(path, "rb") as f:
+                        for chunk in iter(lambda: f.read(1 << 20), b""):
+                            digest.update(chunk)
+                    by_inode[key] = digest.hexdigest()
+                entry.update(size=st.st_size, sha256=by_inode[key])
+            else:
+                continue
+            entries.append(entry)
+    manifest = {
+        "format": "sparetools-artifacts/1",
+        "ref": str(conanfile.ref),
+        "package_id": conanfile.info.package_id(),
+        "total_size": sum(entry["size"] for entry in entries),
+        "artifacts": entries,
+    }
+    os.makedirs(os.path.dirname(manifest_path), exist_ok=True)
+    with open(manifest_path, "w") as f:
+        json.dump(manifest, f, indent=1)
+    conanfile.output.info(f"Artifact manifest: {len(entries)} files, {manifest['total_size']} bytes")
+    return manifest_path
+
+
 class SpareToolsBaseConan(ConanFile):
     name = "sparetools-base"
     version = "2.0.0"
@@ -9,6 +208,7 @@ class SpareToolsBaseConan(ConanFile):
     license = "Apache-2.0"
     url = "https://github.com/sparesparrow/sparetools"
     
+    exports = "*.py"
     exports_sources = "*.py"
     
     def package(self):
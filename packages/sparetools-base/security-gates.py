@@ -1,7 +1,11 @@
 """Security scanning and validation utilities for artifacts"""
+import hashlib
 import subprocess
 import json
 import os
+import re
+import shutil
+import time
 
 
 def run_trivy_scan(target_path, severity="CRITICAL,HIGH", fail_on_findings=True):
@@ -33,6 +37,9 @@ def run_trivy_scan(target_path, severity="CRITICAL,HIGH", fail_on_findings=True)
     
     try:
         result = subprocess.run(cmd, capture_output=True, text=True, check=False)
+        if result.returncode != 0:
+            # --exit-code 0 leaves nonzero for scanner errors (DB download, bad target)
+            raise subprocess.CalledProcessError(result.returncode, cmd, result.stdout, result.stderr)
         scan_data = json.loads(result.stdout) if result.stdout else {}
     except json.JSONDecodeError:
         raise Exception(f"Failed to parse Trivy output: {result.stdout}")
@@ -196,3 +203,142 @@ def check_fips_compliance(openssl_path):
         results["issues"].append(f"Failed to check FIPS provider: {e}")
     
     return results
+
+
+def source_tree_digest(target_path):
+    """sha256 over the relative path and content of every file under target_path"""
+    digest = hashlib.sha256()
+    for dirpath, dirnames, filenames in os.walk(target_path):
+        dirnames.sort()
+        for name in sorted(filenames):
+            path = os.path.join(dirpath, name)
+            if os.path.islink(path):
+                continue
+            digest.update(os.path.relpath(path, target_path).replace(os.sep, "/").encode() + b"\0")
+            with open(path, "rb") as f:
+                for chunk in iter(lambda: f.read(1 << 20), b""):
+                    digest.update(chunk)
+    return digest.hexdigest()
+
+
+def _tool_version(cmd, key):
+    try:
+        result = subprocess.run(cmd, capture_output=True, text=True, check=True)
+        return key(json.loads(result.stdout))
+    except (OSError, subprocess.CalledProcessError, ValueError, KeyError):
+        return None
+
+
+def scanner_versions():
+    """
+    Cache key parts per scanner, None when it is not installed: the Trivy
+    version plus its vulnerability DB timestamp, and the Syft version.
+    """
+    def trivy_key(data):
+        db = data.get("VulnerabilityDB") or {}
+        return f"{data['Version']}-db{db.get('UpdatedAt', 'none')}"
+
+    versions = {"trivy": None, "syft": None}
+    if shutil.which("trivy"):
+        versions["trivy"] = _tool_version(["trivy", "version", "--format", "json"], trivy_key)
+    if shutil.which("syft"):
+        versions["syft"] = _tool_version(["syft", "version", "-o", "json"], lambda data: data["version"])
+    return versions
+
+
+def _cache_file(cache_dir, kind, source_digest, version, ext):
+    version = re.sub(r"[^A-Za-z0-9.-]+", "_", version)
+    return os.path.join(cache_dir, f"{kind}-{source_digest[:32]}-{version}.{ext}")
+
+
+def run_cached_gates(target_path, source_digest, cache_dir, output_file,
+                     run_trivy=True, generate_sbom_file=True, severity="CRITICAL,HIGH"):
+    """
+    Trivy scan and Syft SBOM of target_path, reusing earlier results.
+
+    Results are cached in cache_dir by source_digest (see
+    source_tree_digest) and scanner version; the Trivy key also carries the
+    vulnerability DB timestamp, so a DB update triggers one rescan. The key
+    is taken after scanning because Trivy refreshes a stale DB as it scans.
+
+    Writes and returns {"digest", "trivy", "sbom", "cached", "timings",
+    "issues", "pid"}; timings are [start_us, duration_us] per scan that ran.
+    """
+    os.makedirs(cache_dir, exist_ok=True)
+    results = {"target": target_path, "digest": source_digest, "trivy": None, "sbom": None,
+               "cached": [], "timings": {}, "issues": [], "pid": os.getpid()}
+    versions = scanner_versions()
+
+    if run_trivy:
+        if not versions["trivy"]:
+            results["issues"].append("Trivy not installed, vulnerability scan skipped")
+        else:
+            cached = _cache_file(cache_dir, "trivy", source_digest, versions["trivy"], "json")
+            if os.path.exists(cached):
+                with open(cached) as f:
+                    results["trivy"] = json.load(f)
+                results["cached"].append("trivy")
+            else:
+                start = time.time_ns() // 1000
+                try:
+                    results["trivy"] = run_trivy_scan(target_path, severity, fail_on_findings=False)
+                    cached = _cache_file(cache_dir, "trivy", source_digest,
+                                         scanner_versions()["trivy"] or versions["trivy"], "json")
+                    with open(cached + ".tmp", "w") as f:
+                        json.dump(results["trivy"], f)
+                    os.replace(cached + ".tmp", cached)
+                except Exception as e:
+                    results["issues"].append(f"Trivy scan failed: {e}")
+                results["timings"]["trivy"] = [start, time.time_ns() // 1000 - start]
+
+    if generate_sbom_file:
+        if not versions["syft"]:
+            results["issues"].append("Syft not installed, SBOM skipped")
+        else:
+            cached = _cache_file(cache_dir, "sbom", source_digest, versions["syft"], "cdx.json")
+            if os.path.exists(cached):
+                results["cached"].append("sbom")
+            else:
+                start = time.time_ns() // 1000
+                try:
+                    generate_sbom(target_path, output_file=cached + ".tmp")
+                    os.replace(cached + ".tmp", cached)
+                except Exception as e:
+                    results["issues"].append(f"SBOM generation failed: {e}")
+                results["timings"]["sbom"] = [start, time.time_ns() // 1000 - start]
+            if os.path.exists(cached):
+                results["sbom"] = cached
+
+    os.makedirs(os.path.dirname(os.path.abspath(output_file)), exist_ok=True)
+    with open(output_file + ".tmp", "w") as f:
+        json.dump(results, f)
+    os.replace(output_file + ".tmp", output_file)
+    return results
+
+
+def main(argv=None):
+    """Run the cached gates from the command line (used as a background process)"""
+    import argparse
+
+    parser = argparse.ArgumentParser(description="Cached Trivy scan and Syft SBOM of a source tree")
+    parser.add_argument("target", help="Directory to scan")
+    parser.add_argument("--output", required=True, help="Results JSON file")
+    parser.add_argument("--cache-dir", required=True, help="Result cache directory")
+    parser.add_argument("--digest", help="Source tree digest (computed when omitted)")
+    parser.add_argument("--severity", default="CRITICAL,HIGH")
+    parser.add_argument("--no-trivy", action="store_true")
+    parser.add_argument("--no-sbom", action="store_true")
+    args = parser.parse_args(argv)
+
+    digest = args.digest or source_tree_digest(args.target)
+    results = run_cached_gates(args.target, digest, args.cache_dir, args.output,
+                               run_trivy=not args.no_trivy, generate_sbom_file=not args.no_sbom,
+                               severity=args.severity)
+    for issue in results["issues"]:
+        print(f"⚠ {issue}")
+    print(f"✓ Security gates done ({', '.join(results['cached']) or 'nothing'} cached): {args.output}")
+    return 0
+
+
+if __name__ == "__main__":
+    raise SystemExit(main())
@@ -0,0 +1,323 @@
+"""Checksum-verified source tarball mirror and prefetch cache"""
+import hashlib
+import os
+import shutil
+import sys
+import tarfile
+import tempfile
+import time
+import urllib.request
+from concurrent.futures import ThreadPoolExecutor
+
+# Shared by source() of every recipe on the host and by prefetch runs
+DEFAULT_CACHE_DIR = os.path.join("~", ".sparetools", "sources")
+
+# Versions CI runners warm before the builds that need them
+DEFAULT_PREFETCH = ("3.3.2", "3.6.0", "master")
+
+# A master snapshot moves; a cached one is only reused for this long
+SNAPSHOT_MAX_AGE = 24 * 3600
+
+_CHUNK = 1 << 20
+
+
+class ChecksumError(Exception):
+    """A tarball did not match its expected sha256"""
+
+
+def tarball_name(version):
+    return f"openssl-{version}.tar.gz"
+
+
+def upstream_url(version):
+    if version == "master":
+        return "https://github.com/openssl/openssl/archive/refs/heads/master.tar.gz"
+    # The release asset openssl.org also serves, whose sha256 is published;
+    # tag archives are regenerated by GitHub and their digests not stable
+    return f"https://github.com/openssl/openssl/releases/download/openssl-{version}/{tarball_name(version)}"
+
+
+class _HashingReader:
+    """File object that hashes (and optionally copies) everything read through it"""
+
+    def __init__(self, stream, tee=None):
+        self.stream = stream
+        self.tee = tee
+        self.digest = hashlib.sha256()
+
+    def read(self, size=-1):
+        data = self.stream.read(size)
+        self.digest.update(data)
+        if self.tee is not None:
+            self.tee.write(data)
+        return data
+
+    def drain(self):
+        while self.read(_CHUNK):
+            pass
+        return self.digest.hexdigest()
+
+
+def _is_url(location):
+    return location.startswith(("http://", "https://", "file://"))
+
+
+def _read_sidecar(text):
+    """First token of a sha256sum-style line ("<hex>  <name>"), as openssl.org publishes"""
+    token = text.strip().split()[0] if text.strip() else ""
+    return token.lower() if len(token) == 64 else None
+
+
+def _open(location, name, timeout=60):
+    """Stream of name in a directory or under a URL; None if absent"""
+    if _is_url(location):
+        try:
+            return urllib.request.urlopen(f"{location.rstrip('/')}/{name}", timeout=timeout)
+        except OSError:
+            return None
+    path = os.path.join(os.path.expanduser(location), name)
+    return open(path, "rb") if os.path.isfile(path) else None
+
+
+def _cached_sidecar(cache_dir, name):
+    """sha256 this cache recorded for name when it downloaded it, or None"""
+    path = os.path.join(os.path.expanduser(cache_dir), name + ".sha256")
+    if not os.path.isfile(path):
+        return None
+    with open(path) as f:
+        return _read_sidecar(f.read())
+
+
+def _escapes(path):
+    return os.path.isabs(path) or os.path.normpath(path).split(os.sep)[0] == ".."
+
+
+def _strip_root(member):
+    """Member path without its top-level directory; None for the root itself or unsafe members"""
+    parts = member.name.lstrip("./").split("/", 1)
+    if len(parts) < 2 or not parts[1] or _escapes(parts[1]):
+        return None
+    if member.islnk():
+        member.linkname = member.linkname.lstrip("./").split("/", 1)[-1]
+        if _escapes(member.linkname):
+            return None
+    elif member.issym() and _escapes(os.path.join(os.path.dirname(parts[1]), member.linkname)):
+        return None
+    return parts[1]
+
+
+def extract_verified(stream, dest, expected=None, tee=None):
+    """
+    Untar a .tar.gz stream into dest (top-level directory stripped) while
+    hashing it, in one pass over the data. On a sha256 mismatch everything
+    the extraction created in dest is removed and ChecksumError raised.
+    Returns the sha256.
+    """
+    os.makedirs(dest, exist_ok=True)
+    existing = set(os.listdir(dest))
+    reader = _HashingReader(stream, tee)
+    # Members are checked by _strip_root; the "data" filter would reject none of them
+    options = {"filter": "fully_trusted"} if hasattr(tarfile, "fully_trusted_filter") else {}
+    try:
+        with tarfile.open(fileobj=reader, mode="r|gz") as tar:
+            for member in tar:
+                path = _strip_root(member)
+                if path is None:
+                    continue
+                member.name = path
+                tar.extract(member, dest, **options)
+        # Trailing padding is part of the file the sidecar hashes
+        digest = reader.drain()
+        if expected and digest != expected:
+            raise ChecksumError(f"sha256 {digest}, expected {expected}")
+    except (ChecksumError, tarfile.TarError, OSError):
+        for name in set(os.listdir(dest)) - existing:
+            path = os.path.join(dest, name)
+            shutil.rmtree(path) if os.path.isdir(path) and not os.path.islink(path) else os.remove(path)
+        raise
+    return digest
+
+
+class _CacheWriter:
+    """Temporary file in the cache, published with its sidecar only once verified"""
+
+    def __init__(self, cache_dir, name):
+        self.cache_dir = os.path.expanduser(cache_dir)
+        self.name = name
+        os.makedirs(self.cache_dir, exist_ok=True)
+        fd, self.tmp = tempfile.mkstemp(prefix=f".{name}.", dir=self.cache_dir)
+        self.file = os.fdopen(fd, "wb")
+
+    def write(self, data):
+        self.file.write(data)
+
+    def commit(self, digest):
+        self.file.close()
+        path = os.path.join(self.cache_dir, self.name)
+        with open(self.tmp + ".sha256", "w") as f:
+            f.write(f"{digest}  {self.name}\n")
+        # Tarball first: a reader that sees the new sidecar also sees its tarball
+        os.replace(self.tmp, path)
+        os.replace(self.tmp + ".sha256", path + ".sha256")
+
+    def discard(self):
+        self.file.close()
+        for path in (self.tmp, self.tmp + ".sha256"):
+            if os.path.exists(path):
+                os.remove(path)
+
+
+def _fresh(cache_dir, version):
+    """Cached snapshot of a moving version still within SNAPSHOT_MAX_AGE"""
+    if version != "master":
+        return True
+    path = os.path.join(os.path.expanduser(cache_dir), tarball_name(version))
+    return os.path.exists(path) and time.time() - os.path.getmtime(path) < SNAPSHOT_MAX_AGE
+
+
+def fetch_source(version, dest, cache_dir=DEFAULT_CACHE_DIR, mirror=None, sha256=None, url=None, log=print):
+    """
+    Extract the OpenSSL `version` tarball into dest, consulting in order the
+    local cache, the mirror (directory or HTTP base URL) and upstream.
+
+    Every copy is checked against `sha256`, the digest the recipe pins for
+    the release; a <tarball>.sha256 sidecar next to a tarball never vouches
+    for it. Only a master snapshot may go unpinned: it is then taken from
+    the cache (checked against the digest recorded when it was downloaded)
+    or upstream, never from the mirror. Copies from the mirror and upstream
+    are written to the cache while they are extracted. Returns
+    (source, sha256).
+    """
+    name = tarball_name(version)
+    if not sha256 and version != "master":
+        raise ChecksumError(f"no pinned sha256 for {name}")
+    candidates = [("cache", cache_dir)] if _fresh(cache_dir, version) else []
+    if mirror and sha256:
+        candidates.append(("mirror", mirror))
+    for label, location in candidates:
+        expected = sha256 or _cached_sidecar(cache_dir, name)
+        if not expected:
+            continue
+        stream = _open(location, name)
+        if stream is None:
+            continue
+        writer = _CacheWriter(cache_dir, name) if label == "mirror" else None
+        try:
+            with stream:
+                digest = extract_verified(stream, dest, expected, tee=writer)
+        except (ChecksumError, tarfile.TarError, OSError) as e:
+            if writer:
+                writer.discard()
+            log(f"{label}: {name} rejected ({e})")
+            continue
+        if writer:
+            writer.commit(digest)
+        return label, digest
+
+    writer = _CacheWriter(cache_dir, name)
+    try:
+        with urllib.request.urlopen(url or upstream_url(version), timeout=300) as stream:
+            digest = extract_verified(stream, dest, sha256, tee=writer)
+    except BaseException:
+        writer.discard()
+        raise
+    writer.commit(digest)
+    return "upstream", digest
+
+
+def prefetch(versions, cache_dir=DEFAULT_CACHE_DIR, mirror=None, jobs=None, sha256=None):
+    """
+    Download tarballs of `versions` into the cache in parallel, without
+    extracting them, each verified against its digest in `sha256`
+    ({version: sha256}, as pinned by the recipe). Releases without one are
+    not fetched. Cached tarballs that still match (and master snapshots
+    younger than SNAPSHOT_MAX_AGE) are left alone.
+    Returns {version: "cached" | "mirror" | "upstream" | "failed: ..."}.
+    """
+    pins = sha256 or {}
+
+    def fetch_one(version):
+        name = tarball_name(version)
+        path = os.path.join(os.path.expanduser(cache_dir), name)
+        expected = pins.get(version)
+        if not expected and version != "master":
+            return "failed: no pinned sha256"
+        cached = expected or _cached_sidecar(cache_dir, name)
+        if _fresh(cache_dir, version) and cached and os.path.isfile(path):
+            with open(path, "rb") as f:
+                if _HashingReader(f).drain() == cached:
+                    return "cached"
+        sources = ([("mirror", mirror)] if mirror and expected else []) + [("upstream", None)]
+        for label, location in sources:
+            if label == "mirror":
+                stream = _open(location, name)
+                if stream is None:
+                    continue
+            else:
+                try:
+                    stream = urllib.request.urlopen(upstream_url(version), timeout=300)
+                except OSError as e:
+                    return f"failed: {e}"
+            writer = _CacheWriter(cache_dir, name)
+            try:
+                with stream:
+                    digest = _HashingReader(stream, writer).drain()
+                if expected and digest != expected:
+                    raise ChecksumError(f"sha256 {digest}, expected {expected}")
+            except (ChecksumError, OSError) as e:
+                writer.discard()
+                if label == "upstream":
+                    return f"failed: {e}"
+                continue
+            writer.commit(digest)
+            return label
+        return "failed: no source"
+
+    with ThreadPoolExecutor(max_workers=jobs or len(versions) or 1) as pool:
+        return dict(zip(versions, pool.map(fetch_one, versions)))
+
+
+def prefetch_in_background(versions, cache_dir=DEFAULT_CACHE_DIR, mirror=None, sha256=None):
+    """Start a detached `prefetch` of this file that outlives the caller; returns its pid"""
+    import subprocess
+
+    pins = sha256 or {}
+    versions = [f"{v}={pins[v]}" if v in pins else v for v in versions]
+    cmd = [sys.executable, os.path.abspath(__file__), "prefetch", "--cache", cache_dir] + versions
+    if mirror:
+        cmd += ["--mirror", mirror]
+    process = subprocess.Popen(cmd, stdin=subprocess.DEVNULL, stdout=subprocess.DEVNULL,
+                               stderr=subprocess.DEVNULL, start_new_session=True)
+    return process.pid
+
+
+def main(argv=None):
+    """
+    Command-line prefetcher; prints one line per version.
+
+        python3 source-mirror.py prefetch 3.3.2=<sha256> 3.6.0=<sha256> master
+        python3 source-mirror.py prefetch --cache /mnt/shared/sources --mirror https://mirror.example/openssl 3.6.0=<sha256>
+    """
+    import argparse
+
+    parser = argparse.ArgumentParser(description="Checksum-verified OpenSSL source cache")
+    subparsers = parser.add_subparsers(dest="command", required=True)
+    prefetch_parser = subparsers.add_parser("prefetch", help="Download tarballs into the cache")
+    prefetch_parser.add_argument("versions", nargs="*", default=list(DEFAULT_PREFETCH),
+                                 help="VERSION or VERSION=SHA256; releases need their sha256")
+    prefetch_parser.add_argument("--cache", default=DEFAULT_CACHE_DIR, help="Cache directory")
+    prefetch_parser.add_argument("--mirror", help="Mirror directory or HTTP base URL consulted first")
+    prefetch_parser.add_argument("--jobs", type=int, default=None, help="Parallel downloads")
+    args = parser.parse_args(argv)
+
+    pins = dict(v.split("=", 1) for v in args.versions if "=" in v)
+    versions = [v.split("=", 1)[0] for v in args.versions]
+    results = prefetch(versions, args.cache, args.mirror, args.jobs, pins)
+    for version, status in results.items():
+        mark = "✗" if status.startswith("failed") else "✓"
+        print(f"{mark} {tarball_name(version)}: {status}", file=sys.stderr if mark == "✗" else sys.stdout)
+    return 1 if any(status.startswith("failed") for status in results.values()) else 0
+
+
+if __name__ == "__main__":
+    raise SystemExit(main())
@@ -0,0 +1,294 @@
+"""
+Build Pipeline Tracing
+
+The one tracing module of the SpareTools packages: recipes load it with
+_base_module("sparetools_tracing.py", ...), the tool packages copy it
+into their package folder and import it as sparetools_tracing, with a
+no-op fallback when it is missing (e.g. run from a source checkout).
+
+OpenTelemetry spans for build phases, Conan commands and release
+cascades, linked across processes through the W3C trace context in the
+TRACEPARENT environment variable: a span started while TRACEPARENT is
+set becomes a child of that remote span, and child_env() hands the
+current span on to a subprocess. A release that runs the fan-out, the
+orchestrator, `conan create` and the recipe thus ends up as one trace.
+
+    with span("conan create", profile=profile):
+        subprocess.run(cmd, env=child_env())
+
+With the opentelemetry API installed, spans go through it; with the SDK
+and OTLP exporter also installed and OTEL_EXPORTER_OTLP_ENDPOINT set,
+a tracer provider is configured on first use (service name from
+OTEL_SERVICE_NAME) and flushed at exit. Without OpenTelemetry, spans
+still get W3C ids and propagate, and OPENSSL_TOOLS_SPAN_FILE appends
+each finished span to a JSON lines file; `python -m sparetools_tracing
+critical-path FILE` prints the chain of spans that determined a trace's
+duration. Otherwise span() costs next to nothing.
+
+Context follows contextvars, so asyncio tasks inherit it but thread pool
+workers do not: pass parent=current_context() to spans in workers.
+"""
+
+import atexit
+import contextlib
+import contextvars
+import json
+import logging
+import os
+import re
+import secrets
+import threading
+import time
+from dataclasses import dataclass
+from typing import Any, Dict, Iterator, List, Mapping, Optional
+
+log = logging.getLogger(__name__)
+
+TRACEPARENT_ENV = "TRACEPARENT"
+TRACESTATE_ENV = "TRACESTATE"
+SPAN_FILE_ENV = "OPENSSL_TOOLS_SPAN_FILE"
+
+_TRACEPARENT = re.compile(r"^00-([0-9a-f]{32})-([0-9a-f]{16})-([0-9a-f]{2})$")
+
+
+@dataclass(frozen=True)
+class SpanContext:
+    """W3C trace context of one span"""
+    trace_id: str
+    span_id: str
+    sampled: bool = True
+
+    @property
+    def traceparent(self) -> str:
+        return f"00-{self.trace_id}-{self.span_id}-{'01' if self.sampled else '00'}"
+
+    @classmethod
+    def parse(cls, value: Optional[str]) -> Optional["SpanContext"]:
+        match = _TRACEPARENT.match((value or "").strip().lower())
+        if not match or match.group(1) == "0" * 32 or match.group(2) == "0" * 16:
+            return None
+        return cls(match.group(1), match.group(2), bool(int(match.group(3), 16) & 1))
+
+
+_current: contextvars.ContextVar[Optional[SpanContext]] = contextvars.ContextVar("sparetools_span", default=None)
+_setup_lock = threading.Lock()
+_otel: Optional[Any] = None
+_otel_checked = False
+_file_lock = threading.Lock()
+
+
+def _opentelemetry():
+    """opentelemetry.trace, with an OTLP provider set up when configured; None without the API"""
+    global _otel, _otel_checked
+    if _otel_checked:
+        return _otel
+    with _setup_lock:
+        if _otel_checked:
+            return _otel
+        try:
+            from opentelemetry import trace
+            from opentelemetry.trace.propagation.tracecontext import TraceContextTextMapPropagator  # noqa: F401
+            _otel = trace
+        except ImportError:
+            _otel = None
+        if _otel and os.environ.get("OTEL_EXPORTER_OTLP_ENDPOINT"):
+            try:
+                from opentelemetry.exporter.otlp.proto.http.trace_exporter import OTLPSpanExporter
+                from opentelemetry.sdk.resources import Resource
+                from opentelemetry.sdk.trace import TracerProvider
+                from opentelemetry.sdk.trace.export import BatchSpanProcessor
+                if not isinstance(_otel.get_tracer_provider(), TracerProvider):
+                    provider = TracerProvider(resource=Resource.create(
+                        {"service.name": os.environ.get("OTEL_SERVICE_NAME", "sparetools")}))
+                    provider.add_span_processor(BatchSpanProcessor(OTLPSpanExporter()))
+                    _otel.set_tracer_provider(provider)
+                    # Short-lived processes (conan, recipe steps) exit right after their spans
+                    atexit.register(provider.shutdown)
+            except ImportError as e:
+                log.debug(f"OTLP export unavailable: {e}")
+        _otel_checked = True
+        return _otel
+
+
+def _environment_context() -> Optional[SpanContext]:
+    return SpanContext.parse(os.environ.get(TRACEPARENT_ENV))
+
+
+def current_context() -> Optional[SpanContext]:
+    """Context of the active span, else the one inherited through TRACEPARENT"""
+    otel = _opentelemetry()
+    if otel:
+        ctx = otel.get_current_span().get_span_context()
+        if ctx.is_valid:
+            return SpanContext(f"{ctx.trace_id:032x}", f"{ctx.span_id:016x}", bool(ctx.trace_flags & 1))
+    return _current.get() or _environment_context()
+
+
+def traceparent() -> Optional[str]:
+    context = current_context()
+    return context.traceparent if context else None
+
+
+def child_env(env: Optional[Mapping[str, str]] = None) -> Dict[str, str]:
+    """
+    Copy of env (default os.environ) carrying the current span to a
+    subprocess. A copy of env without a span context stays as it is.
+    """
+    result = dict(os.environ if env is None else env)
+    context = current_context()
+    if context:
+        result[TRACEPARENT_ENV] = context.traceparent
+        if os.environ.get(TRACESTATE_ENV):
+            result.setdefault(TRACESTATE_ENV, os.environ[TRACESTATE_ENV])
+    return result
+
+
+class Span:
+    """Handle of an active span"""
+
+    def __init__(self, name: str, context: Optional[SpanContext], attributes: Dict[str, Any], otel_span=None):
+        self.name = name
+        self.context = context
+        self.attributes = attributes
+        self._otel_span = otel_span
+
+    def set_attribute(self, key: str, value: Any) -> None:
+        value = value if isinstance(value, (str, bool, int, float)) else str(value)
+        self.attributes[key] = value
+        if self._otel_span is not None:
+            self._otel_span.set_attribute(key, value)
+
+
+def _write_span(path: str, record: Dict[str, Any]) -> None:
+    line = (json.dumps(record, default=str) + "\n").encode()
+    try:
+        with _file_lock:
+            # One O_APPEND write per span: processes sharing the file do not interleave
+            fd = os.open(path, os.O_WRONLY | os.O_APPEND | os.O_CREAT, 0o644)
+            try:
+                os.write(fd, line)
+            finally:
+                os.close(fd)
+    except OSError as e:
+        log.debug(f"Cannot write span to {path}: {e}")
+
+
+@contextlib.contextmanager
+def span(name: str, parent: Optional[SpanContext] = None, **attributes: Any) -> Iterator[Span]:
+    """
+    Trace the with-block. parent defaults to the active span or TRACEPARENT.
+    An exception marks the span as failed and propagates.
+    """
+    attributes = {k: v if isinstance(v, (str, bool, int, float)) else str(v)
+                  for k, v in attributes.items() if v is not None}
+    otel = _opentelemetry()
+    if otel:
+        from opentelemetry.trace.propagation.tracecontext import TraceContextTextMapPropagator
+        parent = parent or (None if otel.get_current_span().get_span_context().is_valid
+                            else _environment_context())
+        otel_context = (TraceContextTextMapPropagator().extract({"traceparent": parent.traceparent})
+                        if parent else None)
+        tracer = otel.get_tracer("sparetools")
+        with tracer.start_as_current_span(name, context=otel_context, attributes=attributes) as otel_span:
+            ctx = otel_span.get_span_context()
+            handle = Span(name, SpanContext(f"{ctx.trace_id:032x}", f"{ctx.span_id:016x}",
+                                            bool(ctx.trace_flags & 1)) if ctx.is_valid else None,
+                          attributes, otel_span)
+            token = _current.set(handle.context)
+            try:
+                yield handle
+            finally:
+                _current.reset(token)
+        return
+
+    span_file = os.environ.get(SPAN_FILE_ENV)
+    parent = parent or _current.get() or _environment_context()
+    if not span_file and parent is None:
+        # Nobody records or continues the trace: keep it free
+        yield Span(name, None, attributes)
+        return
+    context = SpanContext(parent.trace_id if parent else secrets.token_hex(16), secrets.token_hex(8),
+                          parent.sampled if parent else True)
+    handle = Span(name, context, attributes)
+    token = _current.set(context)
+    start = time.time_ns()
+    error = None
+    try:
+        yield handle
+    except BaseException as e:
+        error = f"{type(e).__name__}: {e}"
+        raise
+    finally:
+        _current.reset(token)
+        if span_file and context.sampled:
+            _write_span(span_file, {
+                "trace_id": context.trace_id, "span_id": context.span_id,
+                "parent_span_id": parent.span_id if parent else None, "name": name,
+                "start_unix_nano": start, "end_unix_nano": time.time_ns(), "pid": os.getpid(),
+                "attributes": handle.attributes, "status": "error" if error else "ok",
+                **({"error": error} if error else {}),
+            })
+
+
+def load_spans(path: str) -> List[Dict[str, Any]]:
+    spans = []
+    with open(path) as f:
+        for line in f:
+            line = line.strip()
+            if line:
+                try:
+                    spans.append(json.loads(line))
+                except ValueError:
+                    continue
+    return spans
+
+
+def critical_path(spans: List[Dict[str, Any]], trace_id: Optional[str] = None) -> List[Dict[str, Any]]:
+    """
+    From the root of the trace (the latest one if trace_id is None), the
+    chain of spans where each is the child that finished last: the links
+    the trace's total duration waited on.
+    """
+    if trace_id is None and spans:
+        trace_id = max(spans, key=lambda s: s["end_unix_nano"])["trace_id"]
+    trace = [s for s in spans if s["trace_id"] == trace_id]
+    ids = {s["span_id"] for s in trace}
+    children: Dict[Optional[str], List[Dict[str, Any]]] = {}
+    for s in trace:
+        # A parent outside the file (e.g. a CI job's TRACEPARENT) makes a root
+        parent = s["parent_span_id"] if s["parent_span_id"] in ids else None
+        children.setdefault(parent, []).append(s)
+    path = []
+    level = children.get(None, [])
+    while level:
+        last = max(level, key=lambda s: s["end_unix_nano"])
+        path.append(last)
+        level = children.get(last["span_id"], [])
+    return path
+
+
+def main(argv: Optional[List[str]] = None) -> int:
+    import argparse
+    parser = argparse.ArgumentParser(description="Inspect spans written to OPENSSL_TOOLS_SPAN_FILE")
+    subparsers = parser.add_subparsers(dest="command", required=True)
+    path_parser = subparsers.add_parser("critical-path", help="Spans the trace's duration waited on")
+    path_parser.add_argument("file", help="Span file (JSON lines)")
+    path_parser.add_argument("--trace-id", help="Trace to show (default: the latest)")
+    args = parser.parse_args(argv)
+
+    path = critical_path(load_spans(args.file), args.trace_id)
+    if not path:
+        print("No spans")
+        return 1
+    origin = path[0]["start_unix_nano"]
+    print(f"trace {path[0]['trace_id']}")
+    for depth, s in enumerate(path):
+        seconds = (s["end_unix_nano"] - s["start_unix_nano"]) / 1e9
+        offset = (s["start_unix_nano"] - origin) / 1e9
+        status = "" if s.get("status") == "ok" else f"  [{s.get('status')}]"
+        print(f"{'  ' * depth}{s['name']}  {seconds:.2f}s (+{offset:.2f}s){status}")
+    return 0
+
+
+if __name__ == "__main__":
+    raise SystemExit(main())
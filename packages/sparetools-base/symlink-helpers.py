@@ -1,7 +1,27 @@
 """Zero-copy symlink utilities for Conan packages (NGA pattern)"""
+import errno
+import json
 import os
+import shutil
+import sys
+import threading
+from concurrent.futures import ThreadPoolExecutor
 from pathlib import Path
 
+# Format of the deploy_link_manifest() state file (2: per-entry link modes)
+LINK_STATE_VERSION = 2
+
+# How a workspace entry refers to the cache:
+# - symlink:  zero bytes, but every lookup resolves through the link
+# - hardlink: real files sharing the cache inodes (same filesystem only);
+#   writes through them modify the cache, so treat them as read-only
+# - reflink:  copy-on-write clones (Btrfs/XFS FICLONE, APFS clonefile);
+#   copy semantics at near-zero cost, fails where cloning is unsupported
+# - copy:     plain copies
+LINK_MODES = ("symlink", "hardlink", "reflink", "copy")
+
+_FICLONE = 0x40049409  # _IOW(0x94, 9, int)
+
 
 def symlink_with_check(source, destination, target_is_directory=True):
     """
@@ -36,50 +56,318 @@ def symlink_with_check(source, destination, target_is_directory=True):
         return False
 
 
-def symlink_all_child_folders(source_root, dest_root):
+def symlink_all_child_folders(source_root, dest_root, state_file=None, max_workers=None,
+                              link_mode="symlink"):
     """
     Symlink all subdirectories from source to destination.
     
     Pattern from NGA - used to link dependencies from Conan cache to workspace.
+    Builds a link manifest from a single directory scan and applies it with
+    deploy_link_manifest(), so re-running against an unchanged source only
+    touches links that differ.
     
     Args:
         source_root: Source directory (e.g., Conan cache package folder)
         dest_root: Destination directory (e.g., workspace TOOLS/)
+        state_file: Optional state file; with it, unchanged links cost no syscalls
+        max_workers: Parallel link operations (default: up to 32)
+        link_mode: symlink, hardlink, reflink or copy (see LINK_MODES)
     
     Returns:
         dict with symlink statistics
     """
-    stats = {
-        "created": 0,
-        "skipped": 0,
-        "failed": 0,
-        "paths": []
+    if not os.path.exists(source_root):
+        raise FileNotFoundError(f"Source root not found: {source_root}")
+    
+    result = deploy_link_manifest(child_folder_manifest(source_root, dest_root),
+                                  state_file=state_file, max_workers=max_workers,
+                                  prune=state_file is not None, link_mode=link_mode)
+    return {
+        "created": result["created"] + result["updated"],
+        "skipped": result["unchanged"] + result["skipped"],
+        "failed": result["failed"],
+        "errors": result["errors"],
+        "paths": sorted(result["links"]),
     }
+
+
+def child_folder_manifest(source_root, dest_root):
+    """
+    Desired link set {dest_path: source_path} for every subdirectory of
+    source_root. One os.scandir() pass; directory entries carry their type,
+    so no per-entry stat is needed on most filesystems.
+    """
+    manifest = {}
+    with os.scandir(source_root) as entries:
+        for entry in entries:
+            if entry.is_dir():
+                manifest[os.path.join(dest_root, entry.name)] = entry.path
+    return manifest
+
+
+def load_link_manifest(path):
+    """
+    Read a link manifest: JSON object {dest: source}, or {"links": {...}}.
+    Relative paths resolve against the manifest's directory.
+    """
+    base = os.path.dirname(os.path.abspath(path))
+    with open(path) as f:
+        data = json.load(f)
+    links = data.get("links", data)
+    return {os.path.join(base, dest): os.path.join(base, source) for dest, source in links.items()}
+
+
+def _read_link_state(state_file):
+    """(links, modes) recorded by the previous run; v1 files are all symlinks"""
+    try:
+        with open(state_file) as f:
+            data = json.load(f)
+        return dict(data.get("links", {})), dict(data.get("modes", {}))
+    except (OSError, ValueError):
+        return {}, {}
+
+
+def _write_link_state(state_file, links, modes):
+    """Atomic replace: an interrupted run never leaves a truncated state file"""
+    os.makedirs(os.path.dirname(os.path.abspath(state_file)), exist_ok=True)
+    tmp = f"{state_file}.{os.getpid()}.tmp"
+    with open(tmp, "w") as f:
+        json.dump({"version": LINK_STATE_VERSION, "links": links, "modes": modes},
+                  f, indent=1, sort_keys=True)
+    os.replace(tmp, state_file)
+
+
+def reflink_file(source, dest):
+    """
+    Copy-on-write clone of one file (APFS clonefile, Linux FICLONE). Raises
+    OSError (EOPNOTSUPP/EXDEV/...) where the filesystem cannot clone.
+    """
+    if sys.platform == "darwin":
+        import ctypes
+        libc = ctypes.CDLL(None, use_errno=True)
+        if libc.clonefile(os.fsencode(source), os.fsencode(dest), 0) != 0:
+            err = ctypes.get_errno()
+            raise OSError(err, os.strerror(err), dest)
+        return
+    try:
+        import fcntl
+    except ImportError:
+        raise OSError(errno.EOPNOTSUPP, "reflinks are not supported on this platform", dest)
+    with open(source, "rb") as src, open(dest, "wb") as dst:
+        try:
+            fcntl.ioctl(dst.fileno(), _FICLONE, src.fileno())
+        except OSError:
+            dst.close()
+            os.unlink(dest)
+            raise
+    shutil.copystat(source, dest)
+
+
+def materialize(source, dest, link_mode="symlink"):
+    """
+    Create dest from source (file or directory tree) with the given
+    link_mode. Symlinks inside a tree are reproduced as symlinks.
+    """
+    if link_mode not in LINK_MODES:
+        raise ValueError(f"Unknown link_mode {link_mode!r}, expected one of {LINK_MODES}")
+    if link_mode == "symlink":
+        os.symlink(source, dest, target_is_directory=os.path.isdir(source))
+        return
+    if link_mode == "copy":
+        place = shutil.copy2
+    elif link_mode == "hardlink":
+        place = os.link
+    elif sys.platform == "darwin":
+        # clonefile clones whole directory trees in one call
+        reflink_file(source, dest)
+        return
+    else:
+        place = reflink_file
+    if os.path.isdir(source):
+        shutil.copytree(source, dest, symlinks=True, copy_function=place)
+    else:
+        place(source, dest)
+
+
+def _is_real_dir(path):
+    return os.path.isdir(path) and not os.path.islink(path)
+
+
+def _remove_entry(path):
+    if _is_real_dir(path):
+        shutil.rmtree(path)
+    else:
+        os.unlink(path)
+
+
+def _apply_link(dest, source, link_mode="symlink", owned=False):
+    """
+    Point dest at source. Returns "created", "updated", "unchanged" or
+    "skipped"; raises OSError on failure. Existing entries are replaced
+    atomically (build next to dest, then rename), so readers never see
+    dest missing. Real files or directories at dest are only replaced when
+    the state file records them as deployed (owned); anything else is
+    skipped.
+    """
+    try:
+        current = os.readlink(dest)
+    except FileNotFoundError:
+        current = None
+    except OSError:
+        # EINVAL: dest exists and is not a symlink
+        if not owned:
+            return "skipped"
+        current = ""
+    if link_mode == "symlink" and current == source:
+        return "unchanged"
+    if not os.path.exists(source):
+        raise FileNotFoundError(f"Source not found: {source}")
+    
+    if current is None:
+        os.makedirs(os.path.dirname(dest) or ".", exist_ok=True)
+        try:
+            _materialize_clean(source, dest, link_mode)
+            return "created"
+        except FileExistsError:
+            pass  # Raced with another deployer: fall through and replace
+    tmp = f"{dest}.{os.getpid()}.{threading.get_ident()}.tmp"
+    _materialize_clean(source, tmp, link_mode)
+    try:
+        if _is_real_dir(tmp) or _is_real_dir(dest):
+            # rename() cannot replace or be replaced by a directory: swap dest aside
+            old = f"{tmp}.old"
+            os.rename(dest, old)
+            os.rename(tmp, dest)
+            _remove_entry(old)
+        else:
+            os.replace(tmp, dest)
+    except OSError:
+        _remove_entry(tmp)
+        raise
+    return "updated"
+
+
+def _materialize_clean(source, dest, link_mode):
+    """materialize(), removing whatever part of dest was created on failure"""
+    try:
+        materialize(source, dest, link_mode)
+    except FileExistsError:
+        raise
+    except OSError:
+        if os.path.lexists(dest):
+            _remove_entry(dest)
+        raise
+
+
+def _remove_link(dest, link_mode="symlink"):
+    """Remove a previously deployed entry; foreign entries are left alone"""
+    if os.path.islink(dest):
+        os.unlink(dest)
+        return "removed"
+    if link_mode != "symlink" and os.path.lexists(dest):
+        _remove_entry(dest)
+        return "removed"
+    return "unchanged"
+
+
+def deploy_link_manifest(manifest, state_file=None, max_workers=None, prune=True, verify=False,
+                         link_mode="symlink"):
+    """
+    Bring a workspace to the desired link set with the fewest filesystem
+    operations.
     
-    os.makedirs(dest_root, exist_ok=True)
+    The manifest ({dest_path: source_path}) is diffed against state_file,
+    the link set recorded by the previous deployment. Links whose target
+    and mode are unchanged are skipped without touching the filesystem
+    (verify=True re-applies them instead, to repair entries changed behind
+    the deployer's back). Only new and changed entries are applied, in
+    parallel on a thread pool, since on network filesystems each operation
+    is a round trip. With prune, entries recorded in the state but no
+    longer in the manifest are removed. Nothing is printed; failures are
+    collected in the result.
     
-    if not os.path.exists(source_root):
-        raise FileNotFoundError(f"Source root not found: {source_root}")
+    Args:
+        manifest: dict {dest_path: source_path}
+        state_file: JSON state written after each run (None: no state, every
+            symlink is checked with one readlink; materialized entries that
+            already exist are skipped, since they cannot be told apart from
+            foreign files)
+        max_workers: Thread pool size (default: min(32, changes))
+        prune: Remove entries that were deployed before but are no longer wanted
+        verify: Check recorded entries on disk instead of trusting the state
+        link_mode: One of LINK_MODES; the mode is recorded per entry, so
+            switching modes rebuilds every entry once
+    
+    Returns:
+        dict with created/updated/removed/unchanged/skipped/failed counts,
+        errors ([(dest, message)]) and links (the deployed set, as recorded
+        in the state file)
+    """
+    if link_mode not in LINK_MODES:
+        raise ValueError(f"Unknown link_mode {link_mode!r}, expected one of {LINK_MODES}")
+    desired = {os.path.abspath(dest): os.path.abspath(source) for dest, source in manifest.items()}
+    previous, previous_modes = {}, {}
+    if state_file is not None and os.path.exists(state_file):
+        previous, previous_modes = _read_link_state(state_file)
     
-    for item in os.listdir(source_root):
-        source_path = os.path.join(source_root, item)
-        dest_path = os.path.join(dest_root, item)
-        
-        if os.path.isdir(source_path):
-            try:
-                if symlink_with_check(source_path, dest_path, target_is_directory=True):
-                    stats["created"] += 1
-                else:
-                    stats["skipped"] += 1
-                stats["paths"].append(dest_path)
-            except Exception as e:
-                print(f"✗ Failed to symlink {item}: {e}")
-                stats["failed"] += 1
+    result = {"created": 0, "updated": 0, "removed": 0, "unchanged": 0, "skipped": 0, "failed": 0,
+              "errors": [], "links": {}}
+    modes = {}
     
-    return stats
+    def record(dest, source, mode):
+        result["links"][dest] = source
+        if mode != "symlink":
+            modes[dest] = mode
+    
+    work = []
+    for dest, source in desired.items():
+        recorded = previous_modes.get(dest, "symlink")
+        if not verify and previous.get(dest) == source and recorded == link_mode:
+            result["unchanged"] += 1
+            record(dest, source, link_mode)
+        else:
+            work.append((dest, source, link_mode, dest in previous))
+    # Remove before apply: a removed link may be re-created elsewhere
+    stale = [(dest, previous_modes.get(dest, "symlink")) for dest in previous if dest not in desired] if prune else []
+    
+    def run(fn, items):
+        if not items:
+            return []
+        workers = max_workers or min(32, len(items))
+        with ThreadPoolExecutor(max_workers=workers) as pool:
+            futures = [(item, pool.submit(fn, *item)) for item in items]
+            outcomes = []
+            for item, future in futures:
+                try:
+                    outcomes.append((item, future.result(), None))
+                except OSError as e:
+                    outcomes.append((item, None, e))
+            return outcomes
+    
+    for (dest, mode), outcome, error in run(_remove_link, stale):
+        if error is not None:
+            result["failed"] += 1
+            result["errors"].append((dest, str(error)))
+            record(dest, previous[dest], mode)  # Still deployed, retry next run
+        elif outcome == "removed":
+            result["removed"] += 1
+    for (dest, source, mode, owned), outcome, error in run(_apply_link, work):
+        if error is not None:
+            result["failed"] += 1
+            result["errors"].append((dest, str(error)))
+            if owned:
+                record(dest, previous[dest], previous_modes.get(dest, "symlink"))
+        else:
+            result[outcome] += 1
+            if outcome != "skipped":
+                record(dest, source, mode)
+    
+    if state_file is not None and (work or stale or result["links"] != previous or modes != previous_modes):
+        _write_link_state(state_file, result["links"], modes)
+    return result
 
 
-def create_zero_copy_environment(conanfile, dependency_name, dest_folder):
+def create_zero_copy_environment(conanfile, dependency_name, dest_folder, link_mode="symlink"):
     """
     Zero-copy pattern: symlink entire dependency from Conan cache.
     
@@ -92,6 +380,9 @@ def create_zero_copy_environment(conanfile, dependency_name, dest_folder):
         conanfile: The consuming ConanFile instance
         dependency_name: Name of dependency (e.g., "sparetools-cpython", "openssl")
         dest_folder: Where to create symlink (e.g., "./TOOLS/python")
+        link_mode: symlink (default), or hardlink/reflink/copy for a real
+            directory tree, e.g. for container images that cannot follow
+            links into the Conan cache
     
     Returns:
         Path to Conan cache package folder
@@ -121,13 +412,118 @@ def create_zero_copy_environment(conanfile, dependency_name, dest_folder):
     # Create parent directory
     os.makedirs(os.path.dirname(dest_folder), exist_ok=True)
     
-    # Create symlink
-    symlink_with_check(cache_path, dest_folder, target_is_directory=True)
+    if link_mode == "symlink":
+        symlink_with_check(cache_path, dest_folder, target_is_directory=True)
+    elif os.path.exists(dest_folder):
+        print(f"⚠ Skipped (exists): {dest_folder}")
+    else:
+        materialize(cache_path, dest_folder, link_mode)
     
     print(f"✓ Zero-copy environment created: {dest_folder}")
     return cache_path
 
 
+def _is_shared_library(name):
+    return (name.endswith((".dylib", ".dll")) or ".so" in name) and not name.endswith((".a", ".la"))
+
+
+def consolidate_shared_libs(lib_dirs, dest_lib, link_mode="hardlink", ld_conf=None):
+    """
+    Gather the shared libraries of several packages into one real lib/
+    directory.
+    
+    Consumers of shared=True packages linked through symlinked Conan cache
+    paths make the dynamic loader walk an RPATH entry per dependency and
+    resolve every symlinked path component on each process start. The
+    consolidated directory holds real files (hardlink/reflink/copy of the
+    resolved library) and keeps only the soname links (libssl.so ->
+    libssl.so.3) as same-directory relative symlinks, so a single search
+    path entry finds everything.
+    
+    Args:
+        lib_dirs: Package lib directories (e.g. cpp_info libdirs of each dependency)
+        dest_lib: Consolidated directory to create or update
+        link_mode: hardlink (default), reflink or copy; symlink defeats the purpose
+        ld_conf: Optional path of an ld.so.conf.d snippet to write (Linux);
+            install it in /etc/ld.so.conf.d and run ldconfig
+    
+    Returns:
+        dict with libraries (name -> resolved source), links (soname
+        links), ld_conf and errors ([(name, message)])
+    """
+    if link_mode not in LINK_MODES or link_mode == "symlink":
+        raise ValueError(f"link_mode must be hardlink, reflink or copy, got {link_mode!r}")
+    dest_lib = os.path.abspath(dest_lib)
+    os.makedirs(dest_lib, exist_ok=True)
+    result = {"libraries": {}, "links": {}, "ld_conf": None, "errors": []}
+    
+    for lib_dir in lib_dirs:
+        if not os.path.isdir(lib_dir):
+            continue
+        with os.scandir(lib_dir) as entries:
+            for entry in entries:
+                if not _is_shared_library(entry.name) or entry.name in result["libraries"]:
+                    continue
+                target = os.readlink(entry.path) if entry.is_symlink() else None
+                if target is not None and os.path.dirname(target) == "":
+                    result["links"][entry.name] = target  # soname link within the directory
+                elif entry.is_file():
+                    result["libraries"][entry.name] = os.path.realpath(entry.path)
+    
+    for name, source in result["libraries"].items():
+        try:
+            _apply_link(os.path.join(dest_lib, name), source, link_mode, owned=True)
+        except OSError as e:
+            result["errors"].append((name, str(e)))
+    for name, target in result["links"].items():
+        dest = os.path.join(dest_lib, name)
+        if os.path.islink(dest) and os.readlink(dest) == target:
+            continue
+        tmp = f"{dest}.{os.getpid()}.tmp"
+        try:
+            os.symlink(target, tmp)
+            os.replace(tmp, dest)
+        except OSError as e:
+            result["errors"].append((name, str(e)))
+    
+    if ld_conf is not None:
+        os.makedirs(os.path.dirname(os.path.abspath(ld_conf)), exist_ok=True)
+        with open(ld_conf, "w") as f:
+            f.write(f"# Consolidated SpareTools shared libraries (run ldconfig after installing)\n{dest_lib}\n")
+        result["ld_conf"] = os.path.abspath(ld_conf)
+    return result
+
+
+def patch_runpath(binaries, lib_dir):
+    """
+    Point binaries at a consolidated lib directory with an $ORIGIN-relative
+    RUNPATH (patchelf; @loader_path rpath via install_name_tool on macOS),
+    so the search no longer depends on the Conan cache layout.
+    
+    Returns:
+        dict {binary: runpath} for patched binaries; raises RuntimeError if
+        the patch tool is missing or fails
+    """
+    import subprocess
+    
+    patched = {}
+    for binary in binaries:
+        rel = os.path.relpath(os.path.abspath(lib_dir), os.path.dirname(os.path.abspath(binary)))
+        if sys.platform == "darwin":
+            runpath = f"@loader_path/{rel}"
+            cmd = ["install_name_tool", "-add_rpath", runpath, binary]
+        else:
+            runpath = "$ORIGIN" if rel == "." else f"$ORIGIN/{rel}"
+            cmd = ["patchelf", "--set-rpath", runpath, binary]
+        if shutil.which(cmd[0]) is None:
+            raise RuntimeError(f"{cmd[0]} not found; install it to patch {binary}")
+        proc = subprocess.run(cmd, capture_output=True, text=True)
+        if proc.returncode != 0:
+            raise RuntimeError(f"{' '.join(cmd)} failed: {proc.stderr.strip()}")
+        patched[binary] = runpath
+    return patched
+
+
 def validate_zero_copy_setup(workspace_path, expected_symlinks=None):
     """
     Validate that workspace uses symlinks, not copies.
@@ -225,3 +621,75 @@ def get_conan_cache_stats():
             })
     
     return stats
+
+
+def main(argv=None):
+    """
+    Command-line deployer; prints one summary line (errors go to stderr).
+    
+        python3 symlink-helpers.py --state .links.json --manifest links.json
+        python3 symlink-helpers.py --state .links.json --link packages/foo=/cache/foo/p
+        python3 symlink-helpers.py --state .links.json --children /cache/tools TOOLS
+        python3 symlink-helpers.py --consolidate-libs TOOLS/lib --lib-dir /cache/openssl/lib \\
+            --ld-conf TOOLS/sparetools.conf --patch-runpath TOOLS/bin/app
+    """
+    import argparse
+    import sys
+    
+    parser = argparse.ArgumentParser(description="Apply a zero-copy link manifest")
+    parser.add_argument("--manifest", action="append", default=[], help="JSON manifest {dest: source}")
+    parser.add_argument("--link", action="append", default=[], metavar="DEST=SOURCE")
+    parser.add_argument("--children", nargs=2, action="append", default=[], metavar=("SOURCE_ROOT", "DEST_ROOT"),
+                        help="Link every subdirectory of SOURCE_ROOT into DEST_ROOT")
+    parser.add_argument("--state", help="State file recording the deployed links")
+    parser.add_argument("--jobs", type=int, default=None, help="Parallel link operations")
+    parser.add_argument("--verify", action="store_true", help="Re-check recorded links on disk")
+    parser.add_argument("--no-prune", action="store_true", help="Keep links dropped from the manifest")
+    parser.add_argument("--link-mode", choices=LINK_MODES, default="symlink",
+                        help="How entries refer to the source (default: symlink)")
+    parser.add_argument("--consolidate-libs", metavar="DEST_LIB",
+                        help="Gather shared libraries from --lib-dir directories into DEST_LIB")
+    parser.add_argument("--lib-dir", action="append", default=[], help="Library directory to consolidate")
+    parser.add_argument("--ld-conf", help="Write an ld.so.conf.d snippet for DEST_LIB")
+    parser.add_argument("--patch-runpath", action="append", default=[], metavar="BINARY",
+                        help="Set an $ORIGIN-relative RUNPATH to DEST_LIB")
+    args = parser.parse_args(argv)
+    
+    if args.consolidate_libs:
+        mode = args.link_mode if args.link_mode != "symlink" else "hardlink"
+        libs = consolidate_shared_libs(args.lib_dir, args.consolidate_libs, link_mode=mode, ld_conf=args.ld_conf)
+        for name, message in libs["errors"]:
+            print(f"✗ {name}: {message}", file=sys.stderr)
+        try:
+            patched = patch_runpath(args.patch_runpath, args.consolidate_libs)
+        except RuntimeError as e:
+            print(f"✗ {e}", file=sys.stderr)
+            return 1
+        print(f"Libraries: {len(libs['libraries'])} {mode}, {len(libs['links'])} soname links, "
+              f"{len(patched)} binaries patched" + (f", loader config {libs['ld_conf']}" if libs["ld_conf"] else ""))
+        return 1 if libs["errors"] else 0
+    
+    manifest = {}
+    for path in args.manifest:
+        manifest.update(load_link_manifest(path))
+    for spec in args.link:
+        dest, sep, source = spec.partition("=")
+        if not sep:
+            parser.error(f"--link expects DEST=SOURCE, got {spec!r}")
+        manifest[dest] = source
+    for source_root, dest_root in args.children:
+        if os.path.isdir(source_root):
+            manifest.update(child_folder_manifest(source_root, dest_root))
+    
+    result = deploy_link_manifest(manifest, state_file=args.state, max_workers=args.jobs,
+                                  prune=not args.no_prune, verify=args.verify, link_mode=args.link_mode)
+    for dest, message in result["errors"]:
+        print(f"✗ {dest}: {message}", file=sys.stderr)
+    print(f"Links: {result['created']} created, {result['updated']} updated, "
+          f"{result['removed']} removed, {result['unchanged']} unchanged, {result['skipped']} skipped, "
+          f"{result['failed']} failed")
+    return 1 if result["failed"] else 0
+
+
+if __name__ == "__main__":
+    raise SystemExit(main())
@@ -4,8 +4,10 @@ Conan Functions
 Core Conan package management utilities and functions.
 """
 
+import json
 import logging
 import os
+import sqlite3
 import sys
 import tempfile
 from functools import cache
@@ -71,6 +73,46 @@ def get_conan_home():
         return str(Path.home() / '.conan')
 
 
+def find_conan_home() -> Path:
+    """
+    Conan 2 home without starting conan: CONAN_HOME, else ~/.conan2.
+    For the milliseconds checks below; get_conan_home() asks conan itself.
+    """
+    home = os.environ.get('CONAN_HOME')
+    return Path(home).expanduser() if home else Path.home() / '.conan2'
+
+
+def read_conan_remotes(conan_home=None) -> list:
+    """Remotes from <conan home>/remotes.json ([] if there is none)"""
+    path = Path(conan_home or find_conan_home()) / 'remotes.json'
+    try:
+        with open(path, encoding='utf-8') as f:
+            return json.load(f).get('remotes', [])
+    except (OSError, ValueError):
+        return []
+
+
+def read_conan_cache_references(conan_home=None, binaries=False):
+    """
+    References ("name/version[@user/channel]") in the Conan 2 cache, read
+    from its database instead of `conan list`. With binaries, only those
+    with at least one package binary. None if the database cannot be read.
+    """
+    database = Path(conan_home or find_conan_home()) / 'p' / 'cache.sqlite3'
+    if not database.is_file():
+        return set()
+    table = 'packages' if binaries else 'recipes'
+    try:
+        connection = sqlite3.connect(f'{database.as_uri()}?mode=ro', uri=True, timeout=1.0)
+        try:
+            return {row[0] for row in connection.execute(f'SELECT DISTINCT reference FROM {table}')}
+        finally:
+            connection.close()
+    except sqlite3.Error as e:
+        log.debug(f'Cannot read the Conan cache database {database}: {e}')
+        return None
+
+
 def get_all_packages_in_cache() -> list:
     """Get all packages currently in the Conan cache."""
     rc, return_string = execute_command(f'{get_default_conan()} search --raw')
@@ -4,6 +4,11 @@ OpenSSL Deployment Utilities
 Provides deployment scripts and automation for OpenSSL packages.
 """
 
+from .first_run import (
+    BasePackage, BootstrapGraph, BootstrapReport, Checkpoint, Step, StepResult,
+    bootstrap_first_run, first_run_steps
+)
+
 def full_deploy_enhanced():
     """Enhanced deployment with SBOM generation and security scanning."""
     pass
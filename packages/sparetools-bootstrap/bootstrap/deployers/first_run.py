@@ -0,0 +1,444 @@
+"""
+First-Run Bootstrap
+
+Sets up a developer machine or CI runner for SpareTools as a graph of
+steps instead of one command after another:
+
+    profile-detect ──┬──────────────────────────────> deploy-profiles
+                     └──┐
+    remote-<name> ──────┼─> fetch-sparetools-base ──> install-sparetools-cpython
+                        ├─> fetch-sparetools-shared-dev-tools
+                        └─> fetch-sparetools-openssl-tools
+
+A step starts as soon as the steps it requires are done, so the recipe
+downloads, the binary install and the profile copy overlap (within one
+download, core.download:parallel fetches its files concurrently). No two
+steps touch the same reference.
+
+Before running, every step gets a satisfied() check that reads state
+directly (remotes.json, the Conan cache database, profile sizes and
+mtimes) instead of starting conan. A machine that is already set up is
+confirmed in milliseconds. Finished steps are checkpointed in
+<conan home>/.sparetools-bootstrap.json with a fingerprint of their
+inputs, so a rerun after a failure or an interrupt only does what is
+left. A binary install is trusted only with a matching checkpoint,
+because the cache does not tell which profile a binary is for.
+
+    report = bootstrap_first_run(profiles_source="profiles/", jobs=4)
+
+    python -m bootstrap.deployers.first_run --profiles profiles/ --jobs 4
+"""
+
+import argparse
+import asyncio
+import hashlib
+import json
+import logging
+import os
+import sys
+import time
+from dataclasses import dataclass, field
+from pathlib import Path
+from typing import Any, Callable, Dict, Iterable, List, Optional, Sequence, Tuple, Union
+
+from ..async_command import Command, execute_command_async, log_lines
+from ..conan_functions import (
+    find_conan_home, get_default_conan, read_conan_cache_references, read_conan_remotes
+)
+from ..exceptions import SharedDevToolsError
+from ..fast_copy import copy_tree, is_unchanged
+
+log = logging.getLogger(__name__)
+
+CHECKPOINT_NAME = '.sparetools-bootstrap.json'
+CHECKPOINT_VERSION = 1
+
+DEFAULT_REMOTE = ('sparesparrow-conan', 'https://conan.cloudsmith.io/sparesparrow-conan/openssl-conan/')
+
+
+@dataclass(frozen=True)
+class BasePackage:
+    """A package the bootstrap puts in the cache"""
+    reference: str
+    python_require: bool = True
+    # References among the bootstrap packages that must be fetched first
+    requires: Tuple[str, ...] = ()
+
+    @property
+    def name(self) -> str:
+        return self.reference.split('/', 1)[0]
+
+
+DEFAULT_PACKAGES = (
+    BasePackage('sparetools-base/2.0.0'),
+    BasePackage('sparetools-cpython/3.12.7', python_require=False, requires=('sparetools-base/2.0.0',)),
+    BasePackage('sparetools-shared-dev-tools/2.0.0'),
+    BasePackage('sparetools-openssl-tools/2.0.0'),
+)
+
+
+@dataclass
+class Step:
+    """
+    One bootstrap step.
+
+    run is a command (run like execute_command_async) or a function, called
+    in a thread, that raises on failure. The step is skipped when
+    satisfied() returns True, provided it is authoritative or the
+    checkpoint holds the same fingerprint. Without satisfied, only the
+    checkpoint counts. inputs (a value, or a function returning one at check
+    time) goes into the fingerprint, as does run when it is a command.
+    Steps sharing a lock never run at the same time.
+    """
+    name: str
+    run: Union[Command, Callable[[], Any]]
+    requires: Tuple[str, ...] = ()
+    satisfied: Optional[Callable[[], bool]] = None
+    authoritative: bool = True
+    inputs: Any = None
+    retries: int = 0
+    locks: Tuple[str, ...] = ()
+    timeout: Optional[float] = None
+
+    @property
+    def is_command(self) -> bool:
+        return isinstance(self.run, (str, list, tuple))
+
+    def fingerprint(self) -> str:
+        inputs = self.inputs() if callable(self.inputs) else self.inputs
+        payload = [self.name, list(self.run) if self.is_command else None, inputs]
+        return hashlib.sha256(json.dumps(payload, sort_keys=True, default=str).encode()).hexdigest()
+
+
+@dataclass
+class StepResult:
+    name: str
+    status: str  # satisfied, done, failed, blocked or cancelled
+    duration: float = 0.0
+    attempts: int = 0
+    error: Optional[str] = None
+
+    @property
+    def ok(self) -> bool:
+        return self.status in ('satisfied', 'done')
+
+
+@dataclass
+class BootstrapReport:
+    steps: Dict[str, StepResult] = field(default_factory=dict)
+    duration: float = 0.0
+    check_duration: float = 0.0
+
+    @property
+    def ok(self) -> bool:
+        return all(result.ok for result in self.steps.values())
+
+    def count(self, status: str) -> int:
+        return sum(1 for result in self.steps.values() if result.status == status)
+
+    def summary(self) -> str:
+        lines = [f'Bootstrap: {len(self.steps)} steps, {self.count("satisfied")} satisfied, '
+                 f'{self.count("done")} done, {self.count("failed")} failed, '
+                 f'{self.count("blocked") + self.count("cancelled")} not run in {self.duration:.2f} s '
+                 f'(checks {self.check_duration * 1000:.1f} ms)']
+        for result in self.steps.values():
+            detail = f'  {result.error}' if result.error else ''
+            lines.append(f'  {result.status:<10} {result.name:<40} {result.duration:8.2f} s{detail}')
+        return '\n'.join(lines)
+
+
+class Checkpoint:
+    """Fingerprints of finished steps, saved after each one (atomically)"""
+
+    def __init__(self, path: Union[str, Path, None]):
+        self.path = Path(path) if path else None
+        self.steps: Dict[str, Dict[str, Any]] = {}
+        if self.path is None:
+            return
+        try:
+            with open(self.path, encoding='utf-8') as f:
+                data = json.load(f)
+            if data.get('version') == CHECKPOINT_VERSION:
+                self.steps = data.get('steps', {})
+        except (OSError, ValueError):
+            pass
+
+    def matches(self, step: Step) -> bool:
+        return self.steps.get(step.name, {}).get('fingerprint') == step.fingerprint()
+
+    def record(self, step: Step, duration: float):
+        self.steps[step.name] = {'fingerprint': step.fingerprint(), 'completed': time.time(),
+                                 'duration': round(duration, 3)}
+        self._save()
+
+    def forget(self, name: str):
+        if self.steps.pop(name, None) is not None:
+            self._save()
+
+    def _save(self):
+        if self.path is None:
+            return
+        self.path.parent.mkdir(parents=True, exist_ok=True)
+        temporary = self.path.with_name(f'{self.path.name}.{os.getpid()}.tmp')
+        with open(temporary, 'w', encoding='utf-8') as f:
+            json.dump({'version': CHECKPOINT_VERSION, 'steps': self.steps}, f, indent=2, sort_keys=True)
+        os.replace(temporary, self.path)
+
+
+class BootstrapGraph:
+    """Steps and their dependencies, run concurrently in dependency order"""
+
+    def __init__(self, steps: Iterable[Step] = (), checkpoint: Optional[Checkpoint] = None):
+        self.steps: Dict[str, Step] = {}
+        self.checkpoint = checkpoint or Checkpoint(None)
+        for step in steps:
+            self.add(step)
+
+    def add(self, step: Step) -> Step:
+        if step.name in self.steps:
+            raise SharedDevToolsError(f'Duplicate bootstrap step: {step.name}')
+        self.steps[step.name] = step
+        return step
+
+    def order(self) -> List[str]:
+        """Topological order (insertion order among independent steps)"""
+        for step in self.steps.values():
+            unknown = [name for name in step.requires if name not in self.steps]
+            if unknown:
+                raise SharedDevToolsError(f'Bootstrap step {step.name} requires unknown steps: {unknown}')
+        order, placed = [], set()
+        while len(order) < len(self.steps):
+            ready = [name for name, step in self.steps.items()
+                     if name not in placed and all(r in placed for r in step.requires)]
+            if not ready:
+                cycle = sorted(set(self.steps) - placed)
+                raise SharedDevToolsError(f'Bootstrap steps have a dependency cycle: {cycle}')
+            order.extend(ready)
+            placed.update(ready)
+        return order
+
+    def is_satisfied(self, step: Step) -> bool:
+        if step.satisfied is None:
+            return self.checkpoint.matches(step)
+        try:
+            satisfied = bool(step.satisfied())
+        except Exception as e:
+            log.debug(f'Satisfied check of {step.name} failed: {e}')
+            return False
+        return satisfied and (step.authoritative or self.checkpoint.matches(step))
+
+    async def _execute(self, step: Step) -> StepResult:
+        start = time.monotonic()
+        error = None
+        for attempt in range(1, step.retries + 2):
+            if attempt > 1:
+                await asyncio.sleep(min(30.0, 2.0 ** (attempt - 2)))
+            try:
+                if step.is_command:
+                    command = step.run if isinstance(step.run, str) else list(step.run)
+                    result = await execute_command_async(command, on_line=log_lines(log, f'[{step.name}] '),
+                                                         combine_stdout_and_stderr=True, keep_output=False,
+                                                         timeout=step.timeout)
+                    if result.ok:
+                        return StepResult(step.name, 'done', time.monotonic() - start, attempt)
+                    error = result.error or ('timed out' if result.timed_out else f'exit code {result.returncode}')
+                else:
+                    await asyncio.get_running_loop().run_in_executor(None, step.run)
+                    return StepResult(step.name, 'done', time.monotonic() - start, attempt)
+            except Exception as e:
+                error = str(e) or type(e).__name__
+            log.warning(f'Bootstrap step {step.name} failed (attempt {attempt}/{step.retries + 1}): {error}')
+        return StepResult(step.name, 'failed', time.monotonic() - start, step.retries + 1, error)
+
+    async def run_async(self, jobs: Optional[int] = None, force: bool = False,
+                        fail_fast: bool = False) -> BootstrapReport:
+        """
+        Run the steps that are not satisfied, at most jobs at a time
+        (default: all that are ready). force reruns every step. A failed
+        step blocks the steps that require it; the others keep going
+        unless fail_fast.
+        """
+        start = time.monotonic()
+        order = self.order()
+        report = BootstrapReport()
+        results = report.steps
+        pending = []
+        for name in order:
+            if not force and self.is_satisfied(self.steps[name]):
+                results[name] = StepResult(name, 'satisfied')
+            else:
+                pending.append(name)
+        report.check_duration = time.monotonic() - start
+        jobs = jobs or len(pending) or 1
+
+        running: Dict[asyncio.Future, str] = {}
+        held: set = set()
+        try:
+            while pending or running:
+                for name in list(pending):
+                    step = self.steps[name]
+                    requirements = [results.get(r) for r in step.requires]
+                    failed = [r.name for r in requirements if r is not None and not r.ok]
+                    if failed:
+                        results[name] = StepResult(name, 'blocked', error=f'requires {", ".join(failed)}')
+                        pending.remove(name)
+                        continue
+                    if len(running) >= jobs or None in requirements or held.intersection(step.locks):
+                        continue
+                    pending.remove(name)
+                    held.update(step.locks)
+                    log.info(f'Bootstrap step {name} started')
+                    running[asyncio.ensure_future(self._execute(step))] = name
+                if not running:
+                    break
+                finished, _ = await asyncio.wait(list(running), return_when=asyncio.FIRST_COMPLETED)
+                failed = False
+                for task in finished:
+                    name = running.pop(task)
+                    step = self.steps[name]
+                    held.difference_update(step.locks)
+                    results[name] = result = task.result()
+                    if result.ok:
+                        self.checkpoint.record(step, result.duration)
+                        log.info(f'Bootstrap step {name} done in {result.duration:.2f} s')
+                    else:
+                        self.checkpoint.forget(name)
+                        failed = True
+                if failed and fail_fast:
+                    pending.clear()
+                    break
+        finally:
+            for task in running:
+                task.cancel()
+            if running:
+                await asyncio.gather(*running, return_exceptions=True)
+
+        for name in order:
+            results.setdefault(name, StepResult(name, 'cancelled'))
+        report.steps = {name: results[name] for name in order}
+        report.duration = time.monotonic() - start
+        return report
+
+    def run(self, jobs: Optional[int] = None, force: bool = False, fail_fast: bool = False) -> BootstrapReport:
+        """run_async() for synchronous callers (starts its own event loop)"""
+        return asyncio.run(self.run_async(jobs, force, fail_fast))
+
+
+def _tree_deployed(source: Path, destination: Path) -> bool:
+    """Every file under source is at destination with the same size and mtime"""
+    for directory, _, files in os.walk(source):
+        target = destination / os.path.relpath(directory, source)
+        for name in files:
+            if not is_unchanged(os.path.join(directory, name), target / name, verify_digest=False):
+                return False
+    return True
+
+
+def _file_digest(path: Path) -> Optional[str]:
+    try:
+        return hashlib.sha256(path.read_bytes()).hexdigest()
+    except OSError:
+        return None
+
+
+def first_run_steps(conan: Union[str, Path, None] = None,
+                    conan_home: Union[str, Path, None] = None,
+                    remote: Tuple[str, str] = DEFAULT_REMOTE,
+                    packages: Sequence[BasePackage] = DEFAULT_PACKAGES,
+                    profiles_source: Union[str, Path, None] = None,
+                    parallel_downloads: int = 4,
+                    retries: int = 2,
+                    serial_cache: bool = False) -> List[Step]:
+    """
+    The first-run steps: default profile, remote, a recipe fetch per
+    python-require, an install per binary package and, with
+    profiles_source, the profile deployment. serial_cache keeps every
+    step that writes the Conan cache from overlapping with another.
+    """
+    conan = str(conan or get_default_conan())
+    home = Path(conan_home or find_conan_home())
+    remote_name, remote_url = remote
+    core_conf = ['-cc', f'core.download:parallel={parallel_downloads}']
+    cache_locks = ('conan-cache',) if serial_cache else ()
+    default_profile = home / 'profiles' / 'default'
+
+    steps = [
+        Step('profile-detect', [conan, 'profile', 'detect', '--exist-ok'],
+             satisfied=default_profile.is_file),
+        Step(f'remote-{remote_name}', [conan, 'remote', 'add', '--force', remote_name, remote_url],
+             satisfied=lambda: any(r.get('name') == remote_name and r.get('url') == remote_url
+                                   for r in read_conan_remotes(home))),
+    ]
+    fetch_steps = {p.reference: f'fetch-{p.name}' for p in packages if p.python_require}
+    for package in packages:
+        requires = [f'remote-{remote_name}'] + [fetch_steps[r] for r in package.requires if r in fetch_steps]
+        if package.python_require:
+            steps.append(Step(
+                fetch_steps[package.reference],
+                [conan, 'download', package.reference, '-r', remote_name, '--only-recipe'] + core_conf,
+                requires=tuple(requires), retries=retries, locks=cache_locks,
+                satisfied=lambda ref=package.reference: ref in (read_conan_cache_references(home) or ())))
+        else:
+            steps.append(Step(
+                f'install-{package.name}',
+                [conan, 'install', f'--requires={package.reference}', '-r', remote_name, '--build=missing'] + core_conf,
+                requires=tuple(requires + ['profile-detect']), retries=retries, locks=cache_locks,
+                satisfied=lambda ref=package.reference: ref in (read_conan_cache_references(home, binaries=True) or ()),
+                authoritative=False, inputs=lambda: _file_digest(default_profile)))
+
+    if profiles_source:
+        source, destination = Path(profiles_source), home / 'profiles'
+        if not source.is_dir():
+            raise SharedDevToolsError(f'Profile directory not found: {source}')
+        steps.append(Step('deploy-profiles', lambda: copy_tree(source, destination),
+                          requires=('profile-detect',), inputs=str(source.resolve()),
+                          satisfied=lambda: _tree_deployed(source, destination)))
+    return steps
+
+
+def bootstrap_first_run(profiles_source: Union[str, Path, None] = None,
+                        jobs: Optional[int] = None,
+                        force: bool = False,
+                        fail_fast: bool = False,
+                        conan_home: Union[str, Path, None] = None,
+                        **kwargs) -> BootstrapReport:
+    """
+    Bring this machine's Conan setup to the SpareTools baseline, resuming
+    from the checkpoint. kwargs go to first_run_steps().
+    """
+    home = Path(conan_home or find_conan_home())
+    graph = BootstrapGraph(first_run_steps(conan_home=home, profiles_source=profiles_source, **kwargs),
+                           Checkpoint(home / CHECKPOINT_NAME))
+    report = graph.run(jobs=jobs, force=force, fail_fast=fail_fast)
+    log.info(report.summary())
+    return report
+
+
+def main(argv: Optional[List[str]] = None) -> int:
+    parser = argparse.ArgumentParser(description='Parallel, resumable SpareTools first-run bootstrap')
+    parser.add_argument('--profiles', help='directory of Conan profiles to deploy')
+    parser.add_argument('--remote', nargs=2, metavar=('NAME', 'URL'), default=DEFAULT_REMOTE)
+    parser.add_argument('--conan-home', help='Conan home (default: CONAN_HOME or ~/.conan2)')
+    parser.add_argument('--jobs', type=int, help='steps running at once (default: all that are ready)')
+    parser.add_argument('--parallel-downloads', type=int, default=4,
+                        help='core.download:parallel for each download')
+    parser.add_argument('--serial-cache', action='store_true',
+                        help='never run two steps that write the Conan cache at once')
+    parser.add_argument('--force', action='store_true', help='rerun every step')
+    parser.add_argument('--fail-fast', action='store_true', help='stop at the first failed step')
+    parser.add_argument('--verbose', '-v', action='store_true')
+    args = parser.parse_args(argv)
+
+    logging.basicConfig(level=logging.DEBUG if args.verbose else logging.INFO, format='%(message)s')
+    try:
+        report = bootstrap_first_run(args.profiles, jobs=args.jobs, force=args.force, fail_fast=args.fail_fast,
+                                     conan_home=args.conan_home, remote=tuple(args.remote),
+                                     parallel_downloads=args.parallel_downloads, serial_cache=args.serial_cache)
+    except SharedDevToolsError as e:
+        log.error(str(e))
+        return 2
+    return 0 if report.ok else 1
+
+
+if __name__ == '__main__':
+    sys.exit(main())
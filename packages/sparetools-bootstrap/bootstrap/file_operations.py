@@ -13,6 +13,7 @@ from pathlib import Path
 from typing import List, Optional, Union
 
 from .exceptions import FileOperationError
+from .fast_copy import copy_file, copy_tree
 
 log = logging.getLogger(__name__)
 
@@ -94,11 +95,12 @@ def create_whole_dir_path(dir_path: Union[str, Path]) -> Path:
 
 def copy_file_with_metadata(source: Union[str, Path], destination: Union[str, Path]):
     """Copy a file while preserving metadata."""
-    source = Path(source)
-    destination = Path(destination)
+    copy_file(source, destination)
+
 
-    destination.parent.mkdir(parents=True, exist_ok=True)
-    shutil.copy2(source, destination)
+def copy_directory_tree(source: Union[str, Path], destination: Union[str, Path], mirror: bool = False):
+    """Copy a directory tree, leaving files that are already up to date (see fast_copy.copy_tree)."""
+    return copy_tree(source, destination, delete=mirror)
 
 
 def get_file_metadata(file_path: Union[str, Path]) -> dict:
@@ -4,9 +4,45 @@ Cryptographic Configuration Manager for OpenSSL
 
 This module provides comprehensive management of OpenSSL cryptographic configurations,
 including FIPS settings, algorithm enablement, and security policy enforcement.
+
+Configurations may also carry PerformanceSettings, which add an ssl_conf
+section tuned for handshake cost: explicit provider activation, key
+exchange groups fastest first, kernel TLS where the host supports it and
+session ticket settings. compare_configurations() can predict the
+per-handshake cost of two configurations from bench_handshake results.
+max_early_data > 0 allows TLS 1.3 0-RTT resumption; with bench_handshake
+ttfb-* results the prediction also covers time to first byte and round
+trips.
+
+The SSL_CTX settings without an ssl_conf command (read buffer length,
+max_send_fragment, pipelines, server session cache size) are written as
+the calls the application makes; sslctx_tuner searches them, with the
+group order and ticket count, on the host with bench_sslctx.
+
+RandomSettings add a [random] section choosing the DRBG (CTR, HASH or
+HMAC, with its cipher or digest) and seed source that every primary,
+public and private DRBG of the library context is created with. The
+public and private DRBGs are per thread in OpenSSL 3.x either way;
+bench_rand measures what each choice costs on RAND_bytes.
+
+AcceleratorSettings activate an offload provider such as the Intel QAT
+provider (qatprovider) next to the software one and make fetches prefer it
+(default_properties = ?provider=qatprovider), so algorithms it lacks
+still come from default. generate_provider_config() writes just that
+activation, the ssl/openssl-qat.cnf of qat_provider packages; bench_async
+shows whether the operations actually offload.
+
+SecureHeapSettings ask for OpenSSL's secure heap (CRYPTO_secure_malloc_init),
+the mlock()ed arena private keys are allocated from. openssl.cnf has no
+directive for it: the generated configs carry the start-up call as a
+comment, and secure_heap_environment() gives SPARETOOLS_SECURE_HEAP for
+SpareTools::secheap (or a secure_heap=SIZE[:MINSIZE] package) to set it
+up at load time. bench_secheap measures its global lock on key operations
+and handshakes.
 """
 
 import configparser
+import json
 import os
 import re
 import shutil
@@ -15,6 +51,11 @@ from typing import Dict, List, Optional, Set, Tuple, Any, NamedTuple
 from dataclasses import dataclass, field
 from enum import Enum
 
+try:
+    import resource  # POSIX only, for the RLIMIT_MEMLOCK check
+except ImportError:
+    resource = None
+
 
 class SecurityLevel(Enum):
     """OpenSSL security levels."""
@@ -32,6 +73,169 @@ class CipherSuite(Enum):
     FIPS = "fips"
 
 
+# Key exchange groups, cheapest full handshake first (bench_handshake order)
+FAST_GROUPS = ["X25519", "P-256", "X448", "P-384", "P-521"]
+FIPS_GROUPS = ["P-256", "P-384", "P-521"]
+# Post-quantum hybrids (OpenSSL 3.5+): ~2.3 KB more on the wire per full
+# handshake, CPU cost close to the classical half (bench_handshake)
+PQC_HYBRID_GROUPS = ["X25519MLKEM768", "SecP256r1MLKEM768"]
+FIPS_PQC_HYBRID_GROUPS = ["SecP256r1MLKEM768", "SecP384r1MLKEM1024"]
+
+
+@dataclass
+class PerformanceSettings:
+    """Handshake-cost settings for the generated ssl_conf section."""
+    groups: List[str] = field(default_factory=lambda: list(FAST_GROUPS))
+    ktls: bool = True               # Options = KTLS, when the host has the tls module
+    session_tickets: bool = True
+    num_tickets: int = 1            # TLS 1.3 tickets per full handshake (OpenSSL default 2)
+    max_early_data: int = 0         # 0-RTT bytes a ticket allows (0: no early data)
+    anti_replay: bool = True        # Single-use (stateful) tickets when early data is allowed
+    load_legacy: bool = False       # Activating legacy costs startup time
+    resumption_rate: float = 0.5    # Expected share of resumed handshakes, for cost prediction
+    # SSL_CTX API only, 0 keeps the library default
+    read_buffer_len: int = 0        # SSL_CTX_set_default_read_buffer_len, with read-ahead
+    max_send_fragment: int = 0      # SSL_CTX_set_max_send_fragment (default 16384)
+    max_pipelines: int = 0          # SSL_CTX_set_max_pipelines
+    split_send_fragment: int = 0    # SSL_CTX_set_split_send_fragment, with max_pipelines
+    session_cache_size: int = 0     # SSL_CTX_sess_set_cache_size on servers (default 20480)
+
+    @property
+    def server_cache(self) -> bool:
+        """Whether servers resume from their session cache (stateful tickets)"""
+        return not self.session_tickets or (self.max_early_data > 0 and self.anti_replay)
+
+    def ssl_ctx_calls(self) -> List[str]:
+        """The SSL_CTX calls that apply the API-only settings"""
+        calls = []
+        if self.read_buffer_len:
+            calls += [f"SSL_CTX_set_default_read_buffer_len(ctx, {self.read_buffer_len})",
+                      "SSL_CTX_set_read_ahead(ctx, 1)"]
+        if self.max_send_fragment:
+            calls.append(f"SSL_CTX_set_max_send_fragment(ctx, {self.max_send_fragment})")
+        if self.max_pipelines:
+            calls.append(f"SSL_CTX_set_max_pipelines(ctx, {self.max_pipelines})")
+            if self.split_send_fragment:
+                calls.append(f"SSL_CTX_set_split_send_fragment(ctx, {self.split_send_fragment})")
+        if self.session_cache_size:
+            calls.append(f"SSL_CTX_sess_set_cache_size(ctx, {self.session_cache_size})  (servers)")
+        return calls
+
+    def to_dict(self) -> Dict[str, Any]:
+        return {
+            "groups": list(self.groups),
+            "ktls": self.ktls,
+            "session_tickets": self.session_tickets,
+            "num_tickets": self.num_tickets,
+            "max_early_data": self.max_early_data,
+            "anti_replay": self.anti_replay,
+            "load_legacy": self.load_legacy,
+            "resumption_rate": self.resumption_rate,
+            "read_buffer_len": self.read_buffer_len,
+            "max_send_fragment": self.max_send_fragment,
+            "max_pipelines": self.max_pipelines,
+            "split_send_fragment": self.split_send_fragment,
+            "session_cache_size": self.session_cache_size,
+        }
+
+
+DRBG_TYPES = ["CTR-DRBG", "HASH-DRBG", "HMAC-DRBG"]
+
+
+def _version_tuple(version: str) -> Tuple[int, ...]:
+    return tuple(int(part) for part in re.findall(r"\d+", version)[:3]) or (0,)
+
+
+@dataclass
+class RandomSettings:
+    """DRBG choice for the generated [random] section."""
+    drbg: str = "CTR-DRBG"          # CTR-DRBG, HASH-DRBG or HMAC-DRBG
+    cipher: str = "AES-256-CTR"     # CTR-DRBG only
+    digest: str = "SHA2-256"        # HASH-DRBG and HMAC-DRBG only
+    seed: Optional[str] = None      # Seed source, e.g. JITTER (3.5+); None keeps SEED-SRC
+    properties: Optional[str] = None
+    openssl_version: Optional[str] = None  # Target library; None assumes a current (3.5+) one
+
+    def to_dict(self) -> Dict[str, Any]:
+        return {
+            "drbg": self.drbg,
+            "cipher": self.cipher,
+            "digest": self.digest,
+            "seed": self.seed,
+            "properties": self.properties,
+            "openssl_version": self.openssl_version,
+        }
+
+    def effective_drbg(self) -> str:
+        """
+        The DRBG the [random] section can actually select. From 3.5 an
+        HMAC-DRBG chosen there fails to instantiate ("error instantiating
+        drbg"), so HASH-DRBG, with the same digest, stands in for it.
+        """
+        if self.drbg == "HMAC-DRBG" and _version_tuple(self.openssl_version or "3.5") >= (3, 5):
+            return "HASH-DRBG"
+        return self.drbg
+
+
+@dataclass
+class AcceleratorSettings:
+    """Offload provider activated next to the software providers."""
+    provider: str = "qatprovider"
+    module: Optional[str] = None    # Module path; None finds <provider>.so in OPENSSL_MODULES
+    prefer: bool = True             # Fetch with ?provider=<provider> (default stays the fallback)
+
+    def to_dict(self) -> Dict[str, Any]:
+        return {
+            "provider": self.provider,
+            "module": self.module,
+            "prefer": self.prefer,
+        }
+
+
+_SIZE_UNITS = {"K": 1 << 10, "M": 1 << 20, "G": 1 << 30}
+
+
+def parse_heap_size(value: Any) -> int:
+    """Bytes from an int or a string with an optional K/M/G suffix ("1M")"""
+    if isinstance(value, int):
+        return value
+    match = re.fullmatch(r"\s*(\d+)\s*([KMG]?)i?B?\s*", str(value), re.IGNORECASE)
+    if not match:
+        raise ValueError(f"Invalid size {value!r}")
+    return int(match.group(1)) * _SIZE_UNITS.get(match.group(2).upper(), 1)
+
+
+@dataclass
+class SecureHeapSettings:
+    """OpenSSL secure heap, set up with CRYPTO_secure_malloc_init at start-up."""
+    size: int = 1 << 20             # Arena bytes, a power of two; full arena = failed key allocations
+    min_size: int = 32              # Smallest allocation unit, a power of two below size
+
+    @property
+    def spec(self) -> str:
+        """SIZE:MINSIZE as SPARETOOLS_SECURE_HEAP and the secure_heap recipe option take it"""
+        return f"{self.size}:{self.min_size}"
+
+    def startup_call(self) -> str:
+        return f"CRYPTO_secure_malloc_init({self.size}, {self.min_size})"
+
+    def to_dict(self) -> Dict[str, Any]:
+        return {
+            "size": self.size,
+            "min_size": self.min_size,
+        }
+
+
+def ktls_supported() -> bool:
+    """True when the running kernel has TLS offload (Linux tls module)"""
+    if os.path.exists("/sys/module/tls"):
+        return True
+    try:
+        return re.search(r"^tls\s", Path("/proc/modules").read_text(), re.M) is not None
+    except OSError:
+        return False
+
+
 @dataclass
 class CryptoConfiguration:
     """Complete cryptographic configuration."""
@@ -53,6 +257,10 @@ class CryptoConfiguration:
         "TLSv1.2", "TLSv1.3"
     })
     custom_options: Dict[str, Any] = field(default_factory=dict)
+    performance: Optional[PerformanceSettings] = None
+    random: Optional[RandomSettings] = None
+    accelerator: Optional[AcceleratorSettings] = None
+    secure_heap: Optional[SecureHeapSettings] = None
 
     def to_dict(self) -> Dict[str, Any]:
         """Convert configuration to dictionary."""
@@ -64,7 +272,11 @@ class CryptoConfiguration:
             "cipher_suites": self.cipher_suites.value,
             "fips_enabled": self.fips_enabled,
             "tls_versions": list(self.tls_versions),
-            "custom_options": self.custom_options
+            "custom_options": self.custom_options,
+            "performance": self.performance.to_dict() if self.performance else None,
+            "random": self.random.to_dict() if self.random else None,
+            "accelerator": self.accelerator.to_dict() if self.accelerator else None,
+            "secure_heap": self.secure_heap.to_dict() if self.secure_heap else None
         }
 
 
@@ -127,7 +339,7 @@ class CryptoConfigManager:
             Path.cwd() / "openssl_crypto.conf",
             Path.cwd() / ".openssl" / "crypto.conf",
             Path.home() / ".openssl_crypto.conf",
-            "/etc/ssl/openssl_crypto.conf"
+            Path("/etc/ssl/openssl_crypto.conf")
         ]
 
         for path in possible_paths:
@@ -178,6 +390,48 @@ class CryptoConfigManager:
             if 'versions' in tls:
                 crypto_config.tls_versions = set(tls['versions'].split(','))
 
+        if 'performance' in config:
+            perf = config['performance']
+            settings = PerformanceSettings()
+            if 'groups' in perf:
+                settings.groups = [g for g in perf['groups'].split(',') if g]
+            settings.ktls = perf.getboolean('ktls', settings.ktls)
+            settings.session_tickets = perf.getboolean('session_tickets', settings.session_tickets)
+            settings.num_tickets = perf.getint('num_tickets', settings.num_tickets)
+            settings.max_early_data = perf.getint('max_early_data', settings.max_early_data)
+            settings.anti_replay = perf.getboolean('anti_replay', settings.anti_replay)
+            settings.load_legacy = perf.getboolean('load_legacy', settings.load_legacy)
+            settings.resumption_rate = perf.getfloat('resumption_rate', settings.resumption_rate)
+            for key in ('read_buffer_len', 'max_send_fragment', 'max_pipelines',
+                        'split_send_fragment', 'session_cache_size'):
+                setattr(settings, key, perf.getint(key, getattr(settings, key)))
+            crypto_config.performance = settings
+
+        if 'random' in config:
+            rnd = config['random']
+            settings = RandomSettings()
+            for key in ('drbg', 'cipher', 'digest'):
+                setattr(settings, key, rnd.get(key, getattr(settings, key)))
+            settings.seed = rnd.get('seed') or None
+            settings.properties = rnd.get('properties') or None
+            settings.openssl_version = rnd.get('openssl_version') or None
+            crypto_config.random = settings
+
+        if 'accelerator' in config:
+            acc = config['accelerator']
+            settings = AcceleratorSettings()
+            settings.provider = acc.get('provider', settings.provider)
+            settings.module = acc.get('module') or None
+            settings.prefer = acc.getboolean('prefer', settings.prefer)
+            crypto_config.accelerator = settings
+
+        if 'secure_heap' in config:
+            heap = config['secure_heap']
+            settings = SecureHeapSettings()
+            settings.size = parse_heap_size(heap.get('size', settings.size))
+            settings.min_size = parse_heap_size(heap.get('min_size', settings.min_size))
+            crypto_config.secure_heap = settings
+
         return crypto_config
 
     def save_configuration(self, config_path: Optional[str] = None) -> None:
@@ -210,6 +464,28 @@ class CryptoConfigManager:
         config.add_section('tls')
         config.set('tls', 'versions', ','.join(self.current_config.tls_versions))
 
+        if self.current_config.performance:
+            config.add_section('performance')
+            for key, value in self.current_config.performance.to_dict().items():
+                config.set('performance', key, ','.join(value) if isinstance(value, list) else str(value))
+
+        if self.current_config.random:
+            config.add_section('random')
+            for key, value in self.current_config.random.to_dict().items():
+                if value is not None:
+                    config.set('random', key, value)
+
+        if self.current_config.accelerator:
+            config.add_section('accelerator')
+            for key, value in self.current_config.accelerator.to_dict().items():
+                if value is not None:
+                    config.set('accelerator', key, str(value))
+
+        if self.current_config.secure_heap:
+            config.add_section('secure_heap')
+            for key, value in self.current_config.secure_heap.to_dict().items():
+                config.set('secure_heap', key, str(value))
+
         # Create directory if it doesn't exist
         Path(save_path).parent.mkdir(parents=True, exist_ok=True)
 
@@ -273,6 +549,271 @@ class CryptoConfigManager:
         self.current_config.fips_enabled = False
         self.current_config.cipher_suites = CipherSuite.INTERMEDIATE
 
+    def enable_performance_tuning(self, settings: Optional[PerformanceSettings] = None,
+                                  pq_hybrid: bool = False) -> PerformanceSettings:
+        """
+        Add performance settings to the current configuration. In FIPS mode
+        the default group list is limited to the approved NIST curves (and
+        their ML-KEM hybrids). pq_hybrid puts the post-quantum hybrid groups
+        first, keeping the classical ones as fallback for older peers.
+        """
+        if settings is None:
+            settings = PerformanceSettings()
+            if self.current_config.fips_enabled:
+                settings.groups = list(FIPS_GROUPS)
+            if pq_hybrid:
+                hybrids = FIPS_PQC_HYBRID_GROUPS if self.current_config.fips_enabled else PQC_HYBRID_GROUPS
+                settings.groups = list(hybrids) + settings.groups
+        self.current_config.performance = settings
+        return settings
+
+    def set_random_settings(self, drbg: str = "CTR-DRBG", cipher: Optional[str] = None,
+                            digest: Optional[str] = None, seed: Optional[str] = None,
+                            properties: Optional[str] = None,
+                            openssl_version: Optional[str] = None) -> RandomSettings:
+        """
+        Add DRBG settings to the current configuration. drbg accepts the
+        short forms CTR, HASH and HMAC. In FIPS mode the DRBG is fetched with
+        fips=yes unless properties say otherwise. openssl_version is the
+        library the configuration is for: HMAC is only written for versions
+        before 3.5 (see RandomSettings.effective_drbg).
+        """
+        drbg = drbg.upper()
+        if not drbg.endswith("-DRBG"):
+            drbg += "-DRBG"
+        if drbg not in DRBG_TYPES:
+            raise ValueError(f"Unknown DRBG type {drbg}, expected one of {', '.join(DRBG_TYPES)}")
+        settings = RandomSettings(drbg=drbg, seed=seed, properties=properties,
+                                  openssl_version=openssl_version)
+        if settings.effective_drbg() != drbg:
+            print(f"Warning: {drbg} cannot be the library DRBG in OpenSSL "
+                  f"{openssl_version or '3.5+'}, writing {settings.effective_drbg()} instead")
+        if cipher:
+            settings.cipher = cipher
+        if digest:
+            settings.digest = digest
+        if settings.properties is None and self.current_config.fips_enabled:
+            settings.properties = "fips=yes"
+        self.current_config.random = settings
+        return settings
+
+    def enable_accelerator(self, settings: Optional[AcceleratorSettings] = None) -> AcceleratorSettings:
+        """
+        Add an offload provider (default: qatprovider from OPENSSL_MODULES)
+        to the current configuration.
+        """
+        settings = settings or AcceleratorSettings()
+        self.current_config.accelerator = settings
+        return settings
+
+    def set_secure_heap(self, size: Any = "1M", min_size: Any = 32) -> SecureHeapSettings:
+        """
+        Ask for a secure heap of size bytes (int or "64K"/"1M"/...) with
+        min_size as the smallest allocation. Both must be powers of two
+        and min_size below size, which CRYPTO_secure_malloc_init asserts.
+        Size it for the private keys held at once: every handshake in
+        flight holds an ephemeral key share next to the long-term keys.
+        """
+        settings = SecureHeapSettings(size=parse_heap_size(size), min_size=parse_heap_size(min_size))
+        for name in ("size", "min_size"):
+            value = getattr(settings, name)
+            if value <= 0 or value & (value - 1):
+                raise ValueError(f"Secure heap {name} must be a power of two, not {value}")
+        if settings.min_size >= settings.size:
+            raise ValueError("Secure heap min_size must be smaller than size")
+        self.current_config.secure_heap = settings
+        return settings
+
+    def secure_heap_environment(self) -> Dict[str, str]:
+        """
+        Run environment for processes linking SpareTools::secheap:
+        SPARETOOLS_SECURE_HEAP=SIZE:MINSIZE, or "0" (no heap) when the
+        configuration has none, overriding a secure_heap package default.
+        """
+        heap = self.current_config.secure_heap
+        return {"SPARETOOLS_SECURE_HEAP": heap.spec if heap else "0"}
+
+    def generate_secure_heap_lines(self) -> List[str]:
+        """
+        openssl.cnf comments for the secure heap, which has no config
+        directive and must be set up before the first key is created.
+        """
+        heap = self.current_config.secure_heap
+        if not heap:
+            return []
+        return [
+            "",
+            f"# Secure heap ({heap.size} bytes, min {heap.min_size}): no openssl.cnf directive, call",
+            f"#   {heap.startup_call()}",
+            "# before creating keys, or link SpareTools::secheap and set",
+            f"#   SPARETOOLS_SECURE_HEAP={heap.spec}",
+        ]
+
+    def _default_properties(self) -> Optional[str]:
+        """[algorithm_sect] default_properties, None when nothing is set"""
+        if self.current_config.fips_enabled:
+            return "fips=yes"
+        acc = self.current_config.accelerator
+        if acc and acc.prefer:
+            return f"?provider={acc.provider}"
+        return None
+
+    def generate_provider_section(self, load_legacy: bool = False) -> List[str]:
+        """
+        openssl.cnf lines of [provider_sect], the sections it names and
+        [algorithm_sect] when _default_properties() sets any ("providers =
+        provider_sect" and "alg_section = algorithm_sect" go into
+        [openssl_init]). The accelerator comes first and has no
+        default_properties of its own: a FIPS configuration keeps fips=yes
+        and only uses it for what is fetched without properties.
+        """
+        fips = self.current_config.fips_enabled
+        acc = self.current_config.accelerator
+        providers = ["fips", "base"] if fips else ["default"]
+        if load_legacy and not fips:
+            providers.append("legacy")
+        if acc:
+            providers.insert(0, acc.provider)
+
+        lines = ["", "[provider_sect]"]
+        lines += [f"{name} = {name}_sect" for name in providers]
+        for name in providers:
+            if name != "fips":  # [fips_sect] comes from fipsmodule.cnf
+                lines += ["", f"[{name}_sect]"]
+                if acc and name == acc.provider and acc.module:
+                    lines.append(f"module = {acc.module}")
+                lines.append("activate = 1")
+        properties = self._default_properties()
+        if properties:
+            lines += ["", "[algorithm_sect]", f"default_properties = {properties}"]
+        return lines
+
+    def generate_provider_config(self, output_path: str) -> None:
+        """
+        Write an openssl.cnf that only activates the providers (and the
+        DRBG settings, if any): the drop-in OPENSSL_CONF for
+        applications that should pick up an accelerator without other
+        policy changes.
+        """
+        lines = [
+            "# OpenSSL Configuration Generated by CryptoConfigManager (providers)",
+            "",
+        ]
+        if self.current_config.fips_enabled:
+            lines += [".include fipsmodule.cnf", ""]
+        lines += [
+            "openssl_conf = openssl_init",
+            "",
+            "[openssl_init]",
+            "providers = provider_sect",
+        ]
+        if self._default_properties():
+            lines.append("alg_section = algorithm_sect")
+        if self.current_config.random:
+            lines.append("random = random_sect")
+        lines += self.generate_provider_section()
+        if self.current_config.random:
+            lines += self.generate_random_section()
+        lines += self.generate_secure_heap_lines()
+        Path(output_path).parent.mkdir(parents=True, exist_ok=True)
+        with open(output_path, 'w') as f:
+            f.write('\n'.join(lines) + '\n')
+        print(f"OpenSSL provider configuration generated: {output_path}")
+
+    def generate_random_section(self, settings: Optional[RandomSettings] = None) -> List[str]:
+        """
+        openssl.cnf lines of the [random] section ("random = random_sect"
+        goes into [openssl_init]). CTR-DRBG takes a cipher, the HASH and
+        HMAC DRBGs a digest; the other key is left out.
+        """
+        settings = settings or self.current_config.random or RandomSettings()
+        drbg = settings.effective_drbg()
+        lines = ["", "[random_sect]"]
+        if drbg != settings.drbg:
+            lines.append(f"# {settings.drbg} fails to instantiate from [random] in 3.5+; {drbg} uses the same digest")
+        lines.append(f"random = {drbg}")
+        if drbg == "CTR-DRBG":
+            lines.append(f"cipher = {settings.cipher}")
+        else:
+            lines.append(f"digest = {settings.digest}")
+        if settings.properties:
+            lines.append(f"properties = {settings.properties}")
+        if settings.seed:
+            lines.append(f"seed = {settings.seed}")
+        return lines
+
+    def generate_performance_section(self, settings: Optional[PerformanceSettings] = None,
+                                     ktls: Optional[bool] = None) -> List[str]:
+        """
+        openssl.cnf lines for a handshake-tuned configuration.
+
+        Providers are activated explicitly, so nothing depends on the
+        implicit default-provider fallback and only the providers listed are
+        loaded. ssl_conf applies Groups, Options and NumTickets to every
+        SSL_CTX through system_default. ktls=None probes the running kernel.
+
+        Session cache size and timeout are SSL_CTX API settings
+        (SSL_CTX_sess_set_cache_size, SSL_CTX_set_timeout) with no
+        openssl.cnf equivalent; only ticket behaviour is set here. The same
+        holds for max_early_data (SSL_CTX_set_max_early_data) and the
+        ssl_ctx_calls() settings: they are written as comments for the
+        application to apply, while anti_replay maps to Options = -AntiReplay.
+        """
+        settings = settings or self.current_config.performance or PerformanceSettings()
+        fips = self.current_config.fips_enabled
+        use_ktls = settings.ktls and (ktls_supported() if ktls is None else ktls)
+
+        lines = [
+            "openssl_conf = openssl_init",
+            "",
+            "[openssl_init]",
+            "providers = provider_sect",
+            "ssl_conf = ssl_sect",
+        ]
+        if self.current_config.random:
+            lines.append("random = random_sect")
+        if self._default_properties():
+            lines.append("alg_section = algorithm_sect")
+        lines += self.generate_provider_section(settings.load_legacy)
+
+        options = ["SessionTicket" if settings.session_tickets else "-SessionTicket"]
+        if use_ktls:
+            options.append("KTLS")
+        early_data = settings.session_tickets and settings.max_early_data > 0
+        if early_data and not settings.anti_replay:
+            options.append("-AntiReplay")
+        min_protocol = min(self.current_config.tls_versions, key=self._tls_version_key, default="TLSv1.2")
+        lines += [
+            "",
+            "[ssl_sect]",
+            "system_default = system_default_sect",
+            "",
+            "[system_default_sect]",
+            f"MinProtocol = {min_protocol}",
+            f"Groups = {':'.join(settings.groups)}",
+            f"CipherString = {':'.join(self.get_cipher_suite_list())}",
+            f"Options = {','.join(options)}",
+        ]
+        if settings.session_tickets:
+            lines.append(f"NumTickets = {settings.num_tickets}")
+        if early_data:
+            lines += [
+                f"# max_early_data = {settings.max_early_data}: no ssl_conf command, apply with",
+                f"# SSL_CTX_set_max_early_data(ctx, {settings.max_early_data}) on the server SSL_CTX",
+            ]
+        calls = settings.ssl_ctx_calls()
+        if calls:
+            lines.append("# No ssl_conf commands for these, apply on the SSL_CTX:")
+            lines += [f"#   {call}" for call in calls]
+        if self.current_config.random:
+            lines += self.generate_random_section()
+        lines += self.generate_secure_heap_lines()
+        return lines
+
+    @staticmethod
+    def _tls_version_key(version: str) -> Tuple[int, ...]:
+        return tuple(int(part) for part in re.findall(r"\d+", version)) or (0,)
+
     def get_cipher_suite_list(self) -> List[str]:
         """
         Get the list of cipher suites for current configuration.
@@ -282,25 +823,51 @@ class CryptoConfigManager:
         """
         return self.CIPHER_SUITES[self.current_config.cipher_suites].copy()
 
-    def generate_openssl_config(self, output_path: str) -> None:
+    def generate_openssl_config(self, output_path: str, performance: Optional[bool] = None) -> None:
         """
         Generate an OpenSSL configuration file based on current settings.
 
         Args:
             output_path: Path to save the OpenSSL configuration
+            performance: Emit the handshake-tuned variant
+                (generate_performance_section); defaults to whether the
+                configuration has performance settings
         """
+        if performance is None:
+            performance = self.current_config.performance is not None
+        if performance:
+            config_lines = [
+                "# OpenSSL Configuration Generated by CryptoConfigManager (performance)",
+                "# Security Level: " + str(self.current_config.security_level.value),
+                "",
+            ]
+            if self.current_config.fips_enabled:
+                config_lines += [".include fipsmodule.cnf", ""]
+            config_lines += self.generate_performance_section()
+            with open(output_path, 'w') as f:
+                f.write('\n'.join(config_lines) + '\n')
+            print(f"OpenSSL configuration generated: {output_path}")
+            return
+
         config_lines = [
             "# OpenSSL Configuration Generated by CryptoConfigManager",
             "# Security Level: " + str(self.current_config.security_level.value),
             "",
             "[openssl_init]",
             "providers = provider_sect",
+        ]
+        if self.current_config.random:
+            config_lines.append("random = random_sect")
+        config_lines += [
             "",
             "[provider_sect]",
             "default = default_sect",
             "legacy = legacy_sect",
         ]
 
+        if self.current_config.accelerator:
+            config_lines.append(f"{self.current_config.accelerator.provider} = accelerator_sect")
+
         if self.current_config.fips_enabled:
             config_lines.extend([
                 "fips = fips_sect",
@@ -309,6 +876,12 @@ class CryptoConfigManager:
                 "activate = 1"
             ])
 
+        if self.current_config.accelerator:
+            config_lines += ["", "[accelerator_sect]"]
+            if self.current_config.accelerator.module:
+                config_lines.append(f"module = {self.current_config.accelerator.module}")
+            config_lines.append("activate = 1")
+
         config_lines.extend([
             "",
             "[default_sect]",
@@ -341,6 +914,10 @@ class CryptoConfigManager:
                 "CIPHER = ALL:!{}".format(":!".join(disabled_ciphers))
             ])
 
+        if self.current_config.random:
+            config_lines.extend(self.generate_random_section())
+        config_lines.extend(self.generate_secure_heap_lines())
+
         # Write configuration file
         with open(output_path, 'w') as f:
             f.write('\n'.join(config_lines))
@@ -377,6 +954,44 @@ class CryptoConfigManager:
             if "TLSv1.0" in self.current_config.tls_versions or "TLSv1.1" in self.current_config.tls_versions:
                 warnings.append("Security level 2+ should disable TLS 1.0 and 1.1")
 
+        # Check early data settings
+        perf = self.current_config.performance
+        if perf and perf.max_early_data > 0:
+            if not perf.session_tickets:
+                warnings.append("max_early_data has no effect without session tickets")
+            if "TLSv1.3" not in self.current_config.tls_versions:
+                warnings.append("Early data (0-RTT) requires TLS 1.3")
+            if not perf.anti_replay:
+                warnings.append("Early data without anti-replay: 0-RTT requests can be replayed")
+
+        # Check DRBG settings
+        rnd = self.current_config.random
+        if rnd:
+            if rnd.drbg not in DRBG_TYPES:
+                warnings.append(f"Unknown DRBG type {rnd.drbg}")
+            elif rnd.drbg == "CTR-DRBG" and not re.fullmatch(r"AES-(128|192|256)-CTR", rnd.cipher):
+                warnings.append("CTR-DRBG requires an AES-CTR cipher")
+            elif rnd.drbg != "CTR-DRBG" and rnd.digest.upper() in ("SHA1", "SHA-1", "MD5"):
+                warnings.append(f"{rnd.drbg} with {rnd.digest} is below security level 2")
+            if self.current_config.fips_enabled and rnd.seed and rnd.seed.upper() != "SEED-SRC":
+                warnings.append(f"Seed source {rnd.seed} is not part of the FIPS provider")
+
+        # Check accelerator settings
+        acc = self.current_config.accelerator
+        if acc and self.current_config.fips_enabled:
+            warnings.append(f"{acc.provider} is not FIPS validated: fips=yes fetches never use it")
+
+        # Check secure heap settings
+        heap = self.current_config.secure_heap
+        if heap:
+            if heap.size <= 0 or heap.size & (heap.size - 1) or heap.min_size <= 0 \
+                    or heap.min_size & (heap.min_size - 1) or heap.min_size >= heap.size:
+                warnings.append("Secure heap size and min_size must be powers of two with min_size < size")
+            soft = resource.getrlimit(resource.RLIMIT_MEMLOCK)[0] if resource else None
+            if soft is not None and soft != resource.RLIM_INFINITY and soft < heap.size:
+                warnings.append(f"Secure heap of {heap.size} bytes exceeds RLIMIT_MEMLOCK ({soft}): "
+                                "it will be used but not locked")
+
         return warnings
 
     def export_configuration_profile(self, profile_name: str, output_dir: str = ".") -> None:
@@ -435,12 +1050,16 @@ class CryptoConfigManager:
         else:
             raise FileNotFoundError(f"Configuration file not found in profile: {config_path}")
 
-    def compare_configurations(self, other_config: 'CryptoConfiguration') -> Dict[str, Any]:
+    def compare_configurations(self, other_config: 'CryptoConfiguration',
+                               handshake_results: Optional[Any] = None) -> Dict[str, Any]:
         """
         Compare current configuration with another configuration.
 
         Args:
             other_config: Configuration to compare against
+            handshake_results: bench_handshake JSON (path or parsed dict);
+                adds "handshake_cost" predicting the per-handshake latency
+                of each configuration
 
         Returns:
             Dictionary containing differences
@@ -493,6 +1112,24 @@ class CryptoConfigManager:
                 "other": other_config.cipher_suites.value
             }
 
+        current_perf = self.current_config.performance
+        other_perf = other_config.performance
+        if (current_perf.to_dict() if current_perf else None) != (other_perf.to_dict() if other_perf else None):
+            differences["performance"] = {
+                "current": current_perf.to_dict() if current_perf else None,
+                "other": other_perf.to_dict() if other_perf else None
+            }
+
+        if handshake_results is not None:
+            costs = load_handshake_costs(handshake_results)
+            current = predict_handshake_cost(self.current_config, costs)
+            other = predict_handshake_cost(other_config, costs)
+            differences["handshake_cost"] = {"current": current, "other": other}
+            if current["p50_us"] and other["p50_us"]:
+                delta = other["p50_us"] - current["p50_us"]
+                differences["handshake_cost"]["delta_us"] = round(delta, 1)
+                differences["handshake_cost"]["delta_percent"] = round(100.0 * delta / current["p50_us"], 1)
+
         return differences
 
     def get_security_recommendations(self) -> List[str]:
@@ -521,4 +1158,80 @@ class CryptoConfigManager:
         if old_tls:
             recommendations.append(f"Consider disabling outdated TLS versions: {', '.join(old_tls)}")
 
-        return recommendations
\ No newline at end of file
+        return recommendations
+
+
+def load_handshake_costs(results: Any) -> Dict[str, Dict[str, float]]:
+    """
+    {group: {"full": p50_us, "resumed": p50_us}} from bench_handshake JSON;
+    results that report bytes on the wire add "full_wire_bytes" and
+    "resumed_wire_bytes", and the ttfb-* modes (time to first byte) add
+    "<mode>_round_trips".
+    """
+    if not isinstance(results, dict):
+        results = json.loads(Path(results).read_text())
+    costs: Dict[str, Dict[str, float]] = {}
+    for record in results.get("results", []):
+        if "group" in record and "p50_us" in record:
+            mode = record.get("mode", "full")
+            group = costs.setdefault(record["group"], {})
+            group[mode] = float(record["p50_us"])
+            if "wire_bytes" in record:
+                group[f"{mode}_wire_bytes"] = float(record["wire_bytes"])
+            if "round_trips" in record:
+                group[f"{mode}_round_trips"] = float(record["round_trips"])
+    return costs
+
+
+def predict_handshake_cost(config: CryptoConfiguration, costs: Dict[str, Dict[str, float]],
+                           rtt_ms: float = 0.0) -> Dict[str, Any]:
+    """
+    Expected p50 handshake latency for a configuration: clients and
+    servers settle on the first mutually supported group in preference
+    order, so the first configured group with benchmark data sets the full
+    handshake cost; with session tickets, resumption_rate of handshakes
+    cost the resumed figure instead. Configurations without performance
+    settings use OpenSSL's default group order (X25519 first).
+
+    With ttfb-* data the time to first response byte is predicted the same
+    way, resumptions using 0-RTT when max_early_data allows it, together
+    with the expected round trips; rtt_ms > 0 adds the time to first byte
+    at that network RTT.
+    """
+    perf = config.performance
+    groups = perf.groups if perf else list(FAST_GROUPS)
+    group = next((g for g in groups if "full" in costs.get(g, {})), None)
+    if group is None:
+        return {"group": None, "p50_us": None, "note": "no bench_handshake data for the configured groups"}
+
+    full = costs[group]["full"]
+    resumed = costs[group].get("resumed")
+    tickets = perf.session_tickets if perf else True
+    rate = perf.resumption_rate if perf else 0.0
+    if tickets and resumed is not None and rate > 0:
+        p50 = (1.0 - rate) * full + rate * resumed
+    else:
+        p50, rate = full, 0.0
+    prediction = {"group": group, "full_us": full, "resumed_us": resumed, "resumption_rate": rate,
+                  "p50_us": round(p50, 1)}
+    full_wire = costs[group].get("full_wire_bytes")
+    if full_wire is not None:
+        resumed_wire = costs[group].get("resumed_wire_bytes", full_wire)
+        prediction["wire_bytes"] = round((1.0 - rate) * full_wire + rate * resumed_wire)
+
+    if "ttfb-full" in costs[group]:
+        early = bool(perf and tickets and perf.max_early_data > 0)
+        resumed_mode = "ttfb-resumed"
+        if early:
+            resumed_mode = "ttfb-0rtt" if perf.anti_replay else "ttfb-0rtt-noreplay"
+        if rate > 0 and resumed_mode in costs[group]:
+            modes = [("ttfb-full", 1.0 - rate), (resumed_mode, rate)]
+        else:
+            modes = [("ttfb-full", 1.0)]
+        ttfb = sum(costs[group][m] * share for m, share in modes)
+        round_trips = sum(costs[group].get(f"{m}_round_trips", 2.0) * share for m, share in modes)
+        prediction.update({"early_data": early, "ttfb_us": round(ttfb, 1),
+                           "round_trips": round(round_trips, 2)})
+        if rtt_ms > 0:
+            prediction["ttfb_at_rtt_ms"] = round(round_trips * rtt_ms + ttfb / 1e3, 1)
+    return prediction
@@ -1,5 +1,8 @@
 import os
+import subprocess
+import zipfile
 from conan import ConanFile
+from conan.tools.build import can_run
 from conan.tools.files import copy, save
 
 
@@ -17,6 +20,14 @@ class CPythonToolConan(ConanFile):
     python_requires = "sparetools-base/2.0.0"
     
     settings = "os", "arch", "compiler", "build_type"
+    options = {
+        "precompile": [True, False],
+        "stdlib_zip": [True, False],
+    }
+    default_options = {
+        "precompile": True,
+        "stdlib_zip": False,
+    }
     
     def export_sources(self):
         """No sources needed for prebuilt package"""
@@ -54,11 +65,79 @@ class CPythonToolConan(ConanFile):
         # python → python3.12 (for bare 'python' command)
         if os.path.exists(python3_12_bin) and not os.path.exists(python_bin):
             os.symlink("python3.12", python_bin)
+        
+        if self.options.precompile or self.options.stdlib_zip:
+            self._precompile_stdlib(python3_12_bin)
+        if self.options.stdlib_zip:
+            self._write_stdlib_zip()
+        self._check_frozen_modules(python3_12_bin)
+
+    def _python_env(self):
+        env = dict(os.environ, PYTHONHOME=self.package_folder, PYTHONNOUSERSITE="1")
+        env.pop("PYTHONPATH", None)
+        lib_dir = os.path.join(self.package_folder, "lib")
+        env["LD_LIBRARY_PATH"] = os.pathsep.join(filter(None, [lib_dir, env.get("LD_LIBRARY_PATH")]))
+        return env
+
+    def _precompile_stdlib(self, python):
+        """
+        Unchecked-hash .pyc for the whole stdlib and site-packages, so every
+        consumer's first import of a module skips compiling it and the
+        bytecode survives the cache copying files with new mtimes
+        """
+        stdlib = os.path.join(self.package_folder, "lib", "python3.12")
+        base = self.python_requires["sparetools-base"].module
+        if can_run(self) and os.path.exists(python):
+            base.precompile_python(self, stdlib, python=python, env=self._python_env())
+        else:
+            self.output.warning("Cannot run the packaged interpreter: stdlib left without .pyc")
+
+    def _write_stdlib_zip(self):
+        """
+        lib/python312.zip with the pure-Python stdlib, stored uncompressed:
+        it comes first on the default sys.path, so imports are served from
+        one open archive instead of a stat() per path entry and module.
+        Each module goes in as module.py plus its precompiled module.pyc
+        (zipimport looks for bytecode next to the source, not in __pycache__).
+        """
+        lib_dir = os.path.join(self.package_folder, "lib")
+        stdlib = os.path.join(lib_dir, "python3.12")
+        skip = {"site-packages", "lib-dynload", "__pycache__", "test", "idlelib", "tkinter", "turtledemo"}
+        count = 0
+        with zipfile.ZipFile(os.path.join(lib_dir, "python312.zip"), "w", zipfile.ZIP_STORED) as bundle:
+            for root, dirs, files in os.walk(stdlib):
+                dirs[:] = sorted(d for d in dirs if d not in skip and not d.startswith("config-"))
+                for name in sorted(files):
+                    path = os.path.join(root, name)
+                    arcname = os.path.relpath(path, stdlib).replace(os.sep, "/")
+                    bundle.write(path, arcname)
+                    if name.endswith(".py"):
+                        pyc = os.path.join(root, "__pycache__", f"{name[:-3]}.cpython-312.pyc")
+                        if os.path.exists(pyc):
+                            bundle.write(pyc, arcname + "c")
+                            count += 1
+        self.output.info(f"Wrote lib/python312.zip ({count} precompiled modules)")
+
+    def _check_frozen_modules(self, python):
+        """
+        -X frozen_modules=on is the default of an installed, non-debug
+        CPython: the startup modules (os, site, codecs, ...) come from
+        bytecode linked into the binary. A debug build or a staging tree
+        that still looks like a source checkout turns it off; say so.
+        """
+        if not can_run(self) or not os.path.exists(python):
+            return
+        result = subprocess.run([python, "-c", "import os; print(os.__spec__.origin)"],
+                                env=self._python_env(), capture_output=True, text=True)
+        if result.stdout.strip() != "frozen":
+            self.output.warning("Frozen stdlib modules are off for this interpreter "
+                                "(debug build or source-tree layout in the staging dir)")
 
 
     def package_id(self):
-        """Package ID depends on OS and architecture only"""
-        self.info.clear()    
+        """Package ID depends on the packaging options only (the binary is prebuilt)"""
+        self.info.settings.clear()
+        self.info.requires.clear()
 
     def package_info(self):
         """Expose package information and environment setup"""
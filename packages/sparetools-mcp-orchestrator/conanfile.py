@@ -1,3 +1,6 @@
+import importlib.util
+import os
+
 from conan import ConanFile
 from conan.tools.files import copy
 
@@ -10,10 +13,28 @@ class SpareToolsMCPOrchestratorConan(ConanFile):
     url = "https://github.com/sparesparrow/sparetools"
     
     exports_sources = "mcp_project_orchestrator/**", "scripts/**"
+
+    python_requires = "sparetools-base/2.0.0"
     
     def package(self):
         copy(self, "*.py", src=self.source_folder, dst=self.package_folder, keep_path=True)
         copy(self, "*.sh", src=self.source_folder, dst=self.package_folder, keep_path=True)
+        # Ship the tracing module: a python_requires never puts sparetools-base on PYTHONPATH
+        copy(self, "sparetools_tracing.py", src=self.python_requires["sparetools-base"].path,
+             dst=self.package_folder)
+        copy(self, "*.json", src=os.path.join(self.source_folder, "mcp_project_orchestrator"),
+             dst=os.path.join(self.package_folder, "mcp_project_orchestrator"), keep_path=True)
+        self._build_catalog_indexes()
+    
+    def _build_catalog_indexes(self):
+        """Prebuilt catalog indexes let the server list prompts without parsing them"""
+        root = os.path.join(self.package_folder, "mcp_project_orchestrator")
+        spec = importlib.util.spec_from_file_location("catalog_index", os.path.join(root, "catalog_index.py"))
+        catalog_index = importlib.util.module_from_spec(spec)
+        spec.loader.exec_module(catalog_index)
+        index = catalog_index.CatalogIndex.build(os.path.join(root, "prompts"), "prompt")
+        index.save()
+        self.output.info(f"Catalog index: {len(index.entries)} of {len(index.stamps)} prompt files")
     
     def package_info(self):
         self.cpp_info.libs = []
@@ -14,12 +14,23 @@ from .prompt_manager import PromptLoader, PromptManager, PromptTemplate
 # AWS MCP integration (optional)
 try:
     from .aws_mcp import AWSConfig, AWSMCPIntegration, register_aws_mcp_tools
+    from .s3_transfer import S3TransferManager
     _AWS_AVAILABLE = True
 except ImportError:
     _AWS_AVAILABLE = False
     AWSConfig = None
     AWSMCPIntegration = None
     register_aws_mcp_tools = None
+    S3TransferManager = None
+
+# Persistent shell sessions (POSIX only)
+try:
+    from .shell_sessions import ShellSessionPool, register_shell_tools
+    _SHELL_AVAILABLE = True
+except ImportError:
+    _SHELL_AVAILABLE = False
+    ShellSessionPool = None
+    register_shell_tools = None
 
 __all__ = [
     "FastMCPServer",
@@ -40,4 +51,11 @@ if _AWS_AVAILABLE:
         "AWSConfig",
         "AWSMCPIntegration",
         "register_aws_mcp_tools",
+        "S3TransferManager",
+    ])
+
+if _SHELL_AVAILABLE:
+    __all__.extend([
+        "ShellSessionPool",
+        "register_shell_tools",
     ])
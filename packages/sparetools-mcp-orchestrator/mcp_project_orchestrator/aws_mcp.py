@@ -15,6 +15,7 @@ Environment Variables Required:
 - AWS_SECRET_ACCESS_KEY: AWS secret access key (optional if using IAM roles)
 - AWS_SESSION_TOKEN: AWS session token (optional for temporary credentials)
 - AWS_PROFILE: AWS CLI profile name (optional)
+- AWS_S3_MAX_CONCURRENCY: concurrent S3 transfer connections (default: 32)
 """
 
 import os
@@ -23,6 +24,8 @@ import logging
 from typing import Dict, Any, Optional, List
 from dataclasses import dataclass, field
 
+from .s3_transfer import S3TransferManager
+
 logger = logging.getLogger(__name__)
 
 
@@ -112,6 +115,8 @@ class AWSMCPIntegration:
         self.config = config or AWSConfig()
         self._boto3_available = False
         self._clients: Dict[str, Any] = {}
+        self._transfer_manager: Optional[S3TransferManager] = None
+        self.s3_max_concurrency = int(os.getenv("AWS_S3_MAX_CONCURRENCY", "32"))
         
         # Validate configuration
         if not self.config.validate():
@@ -127,12 +132,13 @@ class AWSMCPIntegration:
                 "boto3 is not installed. Install it with: pip install boto3 botocore"
             )
     
-    def _get_client(self, service_name: str):
+    def _get_client(self, service_name: str, max_pool_connections: Optional[int] = None):
         """
         Get or create a boto3 client for the specified service.
         
         Args:
             service_name: AWS service name (e.g., 's3', 'ec2', 'lambda')
+            max_pool_connections: HTTP connection pool size (a separate client per size)
             
         Returns:
             Boto3 client instance
@@ -144,26 +150,43 @@ class AWSMCPIntegration:
         if not self._boto3_available:
             raise ImportError("boto3 is not installed")
         
-        if service_name not in self._clients:
+        cache_key = f"{service_name}:{max_pool_connections}" if max_pool_connections else service_name
+        if cache_key not in self._clients:
             import boto3
             
+            extra = {}
+            if max_pool_connections:
+                from botocore.config import Config
+                extra["config"] = Config(max_pool_connections=max_pool_connections,
+                                         retries={"mode": "adaptive", "max_attempts": 10})
+            
             # Use profile if specified, otherwise use credentials
             if self.config.profile:
                 session = boto3.Session(profile_name=self.config.profile)
-                self._clients[service_name] = session.client(
+                self._clients[cache_key] = session.client(
                     service_name,
                     region_name=self.config.region,
-                    endpoint_url=self.config.endpoint_url
+                    endpoint_url=self.config.endpoint_url,
+                    **extra
                 )
             else:
-                self._clients[service_name] = boto3.client(
+                self._clients[cache_key] = boto3.client(
                     service_name,
-                    **self.config.to_boto3_config()
+                    **self.config.to_boto3_config(),
+                    **extra
                 )
             
             logger.info(f"Created {service_name} client for region {self.config.region}")
         
-        return self._clients[service_name]
+        return self._clients[cache_key]
+    
+    def get_transfer_manager(self) -> S3TransferManager:
+        """S3 transfer manager on a client whose pool fits s3_max_concurrency"""
+        if self._transfer_manager is None:
+            # Each file worker may run part threads: leave room for both
+            client = self._get_client('s3', max_pool_connections=self.s3_max_concurrency * 2)
+            self._transfer_manager = S3TransferManager(client, max_concurrency=self.s3_max_concurrency)
+        return self._transfer_manager
     
     # S3 Operations
     def list_s3_buckets(self) -> List[Dict[str, Any]]:
@@ -193,34 +216,97 @@ class AWSMCPIntegration:
             List of object information dictionaries
         """
         try:
-            s3 = self._get_client('s3')
-            response = s3.list_objects_v2(Bucket=bucket_name, Prefix=prefix)
-            return response.get('Contents', [])
+            # Every page; sub-prefixes are listed concurrently
+            return self.get_transfer_manager().list_objects(bucket_name, prefix)
         except Exception as e:
             logger.error(f"Error listing S3 objects in {bucket_name}: {e}")
             return []
     
-    def upload_to_s3(self, bucket_name: str, file_path: str, object_key: str) -> bool:
+    def upload_to_s3(self, bucket_name: str, file_path: str, object_key: str,
+                     skip_unchanged: bool = True) -> bool:
         """
-        Upload a file to S3.
+        Upload a file to S3 (multipart with concurrent parts when large).
         
         Args:
             bucket_name: Name of the S3 bucket
             file_path: Local file path to upload
             object_key: S3 object key (destination path)
+            skip_unchanged: Do not send a file whose ETag or SHA-256 already matches
             
         Returns:
-            True if upload successful, False otherwise
+            True if upload successful (or already up to date), False otherwise
         """
         try:
-            s3 = self._get_client('s3')
-            s3.upload_file(file_path, bucket_name, object_key)
-            logger.info(f"Uploaded {file_path} to s3://{bucket_name}/{object_key}")
+            sent = self.get_transfer_manager().upload_file(file_path, bucket_name, object_key,
+                                                           skip_unchanged=skip_unchanged)
+            action = "Uploaded" if sent else "Unchanged, skipped"
+            logger.info(f"{action} {file_path} -> s3://{bucket_name}/{object_key}")
             return True
         except Exception as e:
             logger.error(f"Error uploading to S3: {e}")
             return False
     
+    def download_from_s3(self, bucket_name: str, object_key: str, file_path: str,
+                         skip_unchanged: bool = True) -> bool:
+        """
+        Download an S3 object (concurrent ranged parts when large).
+        
+        Returns:
+            True if download successful (or already up to date), False otherwise
+        """
+        try:
+            sent = self.get_transfer_manager().download_file(bucket_name, object_key, file_path,
+                                                             skip_unchanged=skip_unchanged)
+            action = "Downloaded" if sent else "Unchanged, skipped"
+            logger.info(f"{action} s3://{bucket_name}/{object_key} -> {file_path}")
+            return True
+        except Exception as e:
+            logger.error(f"Error downloading from S3: {e}")
+            return False
+    
+    def sync_s3_directory(
+        self,
+        local_dir: str,
+        bucket_name: str,
+        prefix: str = "",
+        direction: str = "upload",
+        delete: bool = False,
+        exclude: Optional[List[str]] = None
+    ) -> Dict[str, Any]:
+        """
+        Mirror a directory (a Conan package tree, a benchmark corpus) to or
+        from s3://bucket_name/prefix, transferring only new and changed files.
+        
+        Args:
+            local_dir: Local directory
+            bucket_name: Name of the S3 bucket
+            prefix: Key prefix the directory maps to
+            direction: "upload" (local -> S3) or "download" (S3 -> local)
+            delete: Remove files missing from the source side
+            exclude: fnmatch patterns of relative paths to leave out
+            
+        Returns:
+            TransferReport summary (counts, bytes, seconds, throughput)
+        """
+        try:
+            manager = self.get_transfer_manager()
+            if direction == "upload":
+                report = manager.sync_to_s3(local_dir, bucket_name, prefix, delete=delete,
+                                            exclude=exclude or ())
+            elif direction == "download":
+                report = manager.sync_from_s3(bucket_name, prefix, local_dir, delete=delete,
+                                              exclude=exclude or ())
+            else:
+                return {'error': f"Unknown direction: {direction}"}
+            summary = report.summary()
+            if report.failed:
+                summary['failures'] = report.failed
+            logger.info(f"S3 sync {direction} {local_dir} <-> s3://{bucket_name}/{prefix}: {summary}")
+            return summary
+        except Exception as e:
+            logger.error(f"Error syncing with S3: {e}")
+            return {'error': str(e)}
+    
     # EC2 Operations
     def list_ec2_instances(self) -> List[Dict[str, Any]]:
         """
@@ -503,6 +589,22 @@ def register_aws_mcp_tools(mcp_server):
             result += f"- {bucket['Name']} (Created: {bucket['CreationDate']})\n"
         return result
     
+    @mcp_server.tool(
+        name="aws_s3_sync",
+        description="Mirror a local directory to or from S3 (direction: upload/download), "
+                    "sending only new and changed files over concurrent multipart transfers"
+    )
+    def s3_sync(local_dir: str, bucket: str, prefix: str = "", direction: str = "upload",
+                delete: bool = False) -> str:
+        """Sync a directory with S3."""
+        summary = aws.sync_s3_directory(local_dir, bucket, prefix, direction=direction, delete=delete)
+        if 'error' in summary:
+            return f"S3 sync failed: {summary['error']}"
+        return (f"S3 sync ({direction}): {summary['transferred']} transferred, "
+                f"{summary['skipped']} unchanged, {summary['deleted']} deleted, "
+                f"{summary['failed']} failed; {summary['bytes_transferred'] / 1e6:.1f} MB in "
+                f"{summary['seconds']}s ({summary['throughput_mb_s']} MB/s)")
+    
     @mcp_server.tool(
         name="aws_list_ec2_instances",
         description="List all EC2 instances in the current region"
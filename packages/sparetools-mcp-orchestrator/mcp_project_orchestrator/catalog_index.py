@@ -0,0 +1,260 @@
+"""
+Persistent index of JSON prompt and template catalogs
+
+Discovering a catalog used to mean parsing every file in it (838 prompt
+files) before the first request could be answered. A CatalogIndex holds
+what listing and selection need for each entry - name, category, tags,
+version and a few kind-specific summary fields - together with the file
+and byte range of its body, so bodies are only read and parsed when an
+entry is first used.
+
+A catalog is either a directory of JSON files, one entry each, or a single
+JSON file holding a list of entries (project_templates.json), whose
+elements are indexed by offset. The index is written next to the catalog
+(catalog-index.json in the directory, <file>.index beside a list file) and
+is generated at package time for the catalogs shipped with the package:
+
+    python catalog_index.py mcp_project_orchestrator/prompts --kind prompt
+
+It stays valid while the size and mtime of every source file match; a
+stale or missing index is rebuilt on open and saved when the location is
+writable.
+
+This module only uses the standard library, so the Conan recipe can run
+it without the package's dependencies.
+"""
+
+import argparse
+import json
+import logging
+import os
+from dataclasses import asdict, dataclass, field
+from pathlib import Path
+from typing import Any, Callable, Dict, List, Optional
+
+logger = logging.getLogger(__name__)
+
+INDEX_VERSION = 1
+INDEX_NAME = "catalog-index.json"
+LIST_INDEX_SUFFIX = ".index"
+
+
+@dataclass
+class CatalogEntry:
+    """Summary of one catalog entry and where its body is stored"""
+    name: str
+    file: str
+    offset: int
+    length: int
+    category: Optional[str] = None
+    tags: List[str] = field(default_factory=list)
+    version: Optional[str] = None
+    extra: Dict[str, Any] = field(default_factory=dict)
+
+
+def describe_prompt(data: Any) -> Optional[Dict[str, Any]]:
+    """Summary of a PromptTemplate file ({"metadata": {...}, "content": ...})"""
+    if not isinstance(data, dict) or "content" not in data or not isinstance(data.get("metadata"), dict):
+        return None
+    metadata = data["metadata"]
+    if not all(key in metadata for key in ("name", "description", "category")):
+        return None
+    return {"name": metadata["name"], "category": metadata["category"],
+            "tags": list(metadata.get("tags", [])), "version": metadata.get("version", "1.0.0")}
+
+
+def describe_template(data: Any) -> Optional[Dict[str, Any]]:
+    """Summary of a project/component template (an element of *_templates.json)"""
+    if not isinstance(data, dict) or "project_name" not in data:
+        return None
+    extra = {"description": data.get("description", "")}
+    if "extends" in data:
+        extra["extends"] = data["extends"]
+    return {"name": data["project_name"], "category": data.get("category"),
+            "tags": list(data.get("keywords", [])), "version": data.get("version", "0.1.0"), "extra": extra}
+
+
+DESCRIBERS: Dict[str, Callable[[Any], Optional[Dict[str, Any]]]] = {
+    "prompt": describe_prompt,
+    "template": describe_template,
+}
+
+
+def _list_elements(raw: bytes):
+    """(offset, length, value) of each element of a JSON list, offsets in bytes"""
+    text = raw.decode("utf-8")
+    decoder = json.JSONDecoder()
+    position = text.index("[") + 1
+    byte_position = len(text[:position].encode("utf-8"))
+    while True:
+        while position < len(text) and text[position] in " \t\r\n,":
+            byte_position += 1
+            position += 1
+        if position >= len(text) or text[position] == "]":
+            return
+        value, end = decoder.raw_decode(text, position)
+        length = len(text[position:end].encode("utf-8"))
+        yield byte_position, length, value
+        byte_position += length
+        position = end
+
+
+class CatalogIndex:
+    """Entries of one catalog by name, with bodies loaded on first access"""
+
+    def __init__(self, root: Path, kind: str, entries: Dict[str, CatalogEntry],
+                 stamps: Dict[str, List[int]], pattern: str = "**/*.json"):
+        self.root = Path(root)
+        self.kind = kind
+        self.entries = entries
+        self.stamps = stamps
+        self.pattern = pattern
+        self._bodies: Dict[str, Any] = {}
+
+    # -- sources ------------------------------------------------------------
+
+    @property
+    def base_dir(self) -> Path:
+        return self.root.parent if self.root.is_file() else self.root
+
+    @property
+    def index_path(self) -> Path:
+        if self.root.is_file():
+            return self.root.with_name(self.root.name + LIST_INDEX_SUFFIX)
+        return self.root / INDEX_NAME
+
+    def _sources(self) -> List[Path]:
+        if self.root.is_file():
+            return [self.root]
+        if not self.root.is_dir():
+            return []
+        return sorted(path for path in self.root.glob(self.pattern)
+                      if path.is_file() and path.name != INDEX_NAME)
+
+    def _scan(self) -> Dict[str, List[int]]:
+        stamps = {}
+        for path in self._sources():
+            stat = path.stat()
+            stamps[path.relative_to(self.base_dir).as_posix()] = [stat.st_size, stat.st_mtime_ns]
+        return stamps
+
+    def is_fresh(self) -> bool:
+        return self._scan() == self.stamps
+
+    # -- build / persist ----------------------------------------------------
+
+    @classmethod
+    def build(cls, root: Path, kind: str, pattern: str = "**/*.json",
+              validate: Optional[Callable[[Any], bool]] = None) -> "CatalogIndex":
+        """
+        Index a catalog. validate, when given, is applied to each body as
+        well and entries it rejects (or raises on) are left out.
+        """
+        index = cls(Path(root), kind, {}, {}, pattern)
+        describe = DESCRIBERS[kind]
+        index.stamps = index._scan()
+        for relative in index.stamps:
+            path = index.base_dir / relative
+            try:
+                raw = path.read_bytes()
+                if index.root.is_file():
+                    elements = list(_list_elements(raw))
+                else:
+                    elements = [(0, len(raw), json.loads(raw))]
+            except (OSError, ValueError) as e:
+                logger.debug(f"Skipping {path}: {e}")
+                continue
+            for offset, length, data in elements:
+                summary = describe(data)
+                if summary is None:
+                    continue
+                if validate is not None:
+                    try:
+                        if not validate(data):
+                            continue
+                    except Exception:
+                        continue
+                # Like eager discovery, a later file wins on duplicate names
+                index.entries[summary["name"]] = CatalogEntry(file=relative, offset=offset, length=length,
+                                                              **summary)
+        return index
+
+    @classmethod
+    def load(cls, root: Path, kind: str, pattern: str = "**/*.json") -> Optional["CatalogIndex"]:
+        """The saved index of a catalog, if there is one"""
+        index = cls(Path(root), kind, {}, {}, pattern)
+        try:
+            with open(index.index_path) as f:
+                data = json.load(f)
+        except (OSError, ValueError):
+            return None
+        if data.get("version") != INDEX_VERSION or data.get("kind") != kind or data.get("pattern") != pattern:
+            return None
+        index.stamps = data["stamps"]
+        index.entries = {entry["name"]: CatalogEntry(**entry) for entry in data["entries"]}
+        return index
+
+    def save(self) -> Optional[Path]:
+        """Write the index next to the catalog; None when that is not writable"""
+        path = self.index_path
+        tmp = path.with_name(f"{path.name}.{os.getpid()}.tmp")
+        try:
+            with open(tmp, "w") as f:
+                json.dump({"version": INDEX_VERSION, "kind": self.kind, "pattern": self.pattern,
+                           "stamps": self.stamps, "entries": [asdict(e) for e in self.entries.values()]}, f)
+            os.replace(tmp, path)
+        except OSError as e:
+            logger.debug(f"Catalog index not saved to {path}: {e}")
+            return None
+        return path
+
+    @classmethod
+    def open(cls, root: Path, kind: str, pattern: str = "**/*.json",
+             validate: Optional[Callable[[Any], bool]] = None) -> "CatalogIndex":
+        """The saved index if it is still fresh, otherwise a rebuilt (and saved) one"""
+        index = cls.load(root, kind, pattern)
+        if index is not None and index.is_fresh():
+            return index
+        index = cls.build(root, kind, pattern, validate)
+        index.save()
+        return index
+
+    # -- access -------------------------------------------------------------
+
+    def names(self) -> List[str]:
+        return list(self.entries)
+
+    def get(self, name: str) -> Optional[CatalogEntry]:
+        return self.entries.get(name)
+
+    def body(self, name: str) -> Any:
+        """The parsed body of an entry (read once); KeyError if unknown"""
+        if name not in self._bodies:
+            entry = self.entries[name]
+            with open(self.base_dir / entry.file, "rb") as f:
+                f.seek(entry.offset)
+                self._bodies[name] = json.loads(f.read(entry.length))
+        return self._bodies[name]
+
+    def discard(self, name: str) -> None:
+        """Drop an entry whose body turned out to be unusable"""
+        self.entries.pop(name, None)
+        self._bodies.pop(name, None)
+
+
+def main() -> None:
+    parser = argparse.ArgumentParser(description="Build the catalog index of a prompt or template catalog")
+    parser.add_argument("catalogs", nargs="+", type=Path, help="Catalog directories or list files")
+    parser.add_argument("--kind", choices=sorted(DESCRIBERS), required=True)
+    parser.add_argument("--pattern", default="**/*.json", help="Source files of directory catalogs")
+    args = parser.parse_args()
+
+    for catalog in args.catalogs:
+        index = CatalogIndex.build(catalog, args.kind, args.pattern)
+        path = index.save()
+        print(f"📇 {catalog}: {len(index.entries)} of {len(index.stamps)} files indexed"
+              + (f" -> {path}" if path else " (not writable)"))
+
+
+if __name__ == "__main__":
+    main()
@@ -50,6 +50,14 @@ class Settings(BaseModel):
         default=False,
         description="Enable debug mode"
     )
+    max_concurrent_requests: int = Field(
+        default=16,
+        description="Requests the server handles at once across all connections"
+    )
+    tool_concurrency: Dict[str, int] = Field(
+        default_factory=dict,
+        description="Per-tool limits on calls running at once"
+    )
 
     # Component settings
     mermaid_path: Optional[str] = Field(
@@ -6,6 +6,16 @@ This module provides a comprehensive MCP server that handles communication
 with MCP clients like Claude Desktop, exposing project orchestration,
 prompt management, and diagram generation capabilities through the Model
 Context Protocol.
+
+Every message is handled in a task of its own, so a slow tool (a build,
+a scan) does not hold up other requests on the same or other
+connections. Synchronous tools run on worker threads. Concurrency is
+bounded server-wide (max_concurrent_requests) and per tool
+(max_concurrency=, or the tool_concurrency setting). A request is
+cancelled by `notifications/cancelled` and then gets no response; a tool
+already running on a worker thread finishes there, but its result is
+dropped. Tools that take a `progress` argument, or are async generators,
+stream `notifications/progress` to clients that sent a progressToken.
 """
 import os
 import sys
@@ -13,7 +23,9 @@ import signal
 import logging
 import json
 import asyncio
-from typing import Dict, Any, Optional, Callable, List
+import contextlib
+import inspect
+from typing import Dict, Any, Optional, Callable, List, Awaitable, AsyncIterator
 
 # Set up logging
 logging.basicConfig(
@@ -27,6 +39,62 @@ class MCP_Error(Exception):
     """Base exception class for MCP server errors."""
     pass
 
+
+# Requests handled at once across all connections, unless configured
+DEFAULT_MAX_CONCURRENT_REQUESTS = 16
+
+
+class _Connection:
+    """A client connection: how to send to it and its requests still running"""
+
+    def __init__(self, send: Callable[[Dict[str, Any]], Awaitable[None]]):
+        self.send = send
+        self.in_flight: Dict[Any, asyncio.Task] = {}
+
+    def cancel_all(self) -> None:
+        for task in list(self.in_flight.values()):
+            task.cancel()
+
+
+class _Progress:
+    """
+    The progress(done, total=None, message=None) callback of a tool call.
+    It sends notifications/progress for the request's progressToken, may be
+    called from the tool's worker thread, and does nothing when the client
+    sent no token.
+    """
+
+    def __init__(self, connection: Optional[_Connection], token: Any):
+        self.connection = connection
+        self.token = token
+        self.loop = asyncio.get_running_loop()
+        self.pending: List[asyncio.Future] = []
+
+    def __call__(self, done: float, total: Optional[float] = None, message: Optional[str] = None) -> None:
+        if self.connection is None or self.token is None:
+            return
+        params: Dict[str, Any] = {"progressToken": self.token, "progress": done}
+        if total is not None:
+            params["total"] = total
+        if message is not None:
+            params["message"] = str(message)
+        notification = {"jsonrpc": "2.0", "method": "notifications/progress", "params": params}
+        try:
+            self.loop.call_soon_threadsafe(self._send, notification)
+        except RuntimeError:
+            # The loop has shut down; nobody is left to tell
+            pass
+
+    def _send(self, notification: Dict[str, Any]) -> None:
+        self.pending.append(asyncio.ensure_future(self.connection.send(notification)))
+
+    async def flush(self) -> None:
+        """Wait until the notifications reported so far are sent, so none trails the response."""
+        await asyncio.sleep(0)
+        if self.pending:
+            await asyncio.gather(*self.pending, return_exceptions=True)
+
+
 class FastMCPServer:
     """
     Enhanced FastMCP server implementation for project orchestration.
@@ -47,6 +115,15 @@ class FastMCPServer:
         self.config = config
         self.tools: Dict[str, Dict[str, Any]] = {}
         self.resources: Dict[str, Any] = {}
+
+        settings = getattr(config, "settings", config)
+        self.max_concurrent_requests = (getattr(settings, "max_concurrent_requests", None)
+                                        or DEFAULT_MAX_CONCURRENT_REQUESTS)
+        # Tool name -> calls of it that may run at once
+        self.tool_concurrency: Dict[str, int] = dict(getattr(settings, "tool_concurrency", None) or {})
+        # Created on first use, inside the serving event loop
+        self._request_slots: Optional[asyncio.Semaphore] = None
+        self._tool_slots: Dict[str, asyncio.Semaphore] = {}
         
         # Set up signal handlers
         signal.signal(signal.SIGINT, self._handle_signal)
@@ -98,7 +175,8 @@ class FastMCPServer:
     def tool(self, func: Optional[Callable] = None, 
              name: Optional[str] = None, 
              description: Optional[str] = None,
-             parameters: Optional[Dict[str, Any]] = None):
+             parameters: Optional[Dict[str, Any]] = None,
+             max_concurrency: Optional[int] = None):
         """
         Decorator to register a function as an MCP tool.
         
@@ -107,6 +185,7 @@ class FastMCPServer:
             name: Optional name for the tool (defaults to function name)
             description: Optional description of the tool
             parameters: Optional parameters schema for the tool
+            max_concurrency: Optional limit on calls of this tool running at once
         
         Returns:
             The decorated function
@@ -127,7 +206,8 @@ class FastMCPServer:
                 }
                 
                 for param_name, param in sig.parameters.items():
-                    if param_name == "self":
+                    # progress is supplied by the server, not the client
+                    if param_name in ("self", "progress"):
                         continue
                         
                     param_type = "string"  # Default type
@@ -157,7 +237,9 @@ class FastMCPServer:
             self.tools[tool_name] = {
                 "function": fn,
                 "description": tool_desc,
-                "parameters": tool_params
+                "parameters": tool_params,
+                "max_concurrency": max_concurrency,
+                "progress": self._accepts_progress(fn)
             }
             
             logger.info(f"Registered tool '{tool_name}'")
@@ -178,7 +260,8 @@ class FastMCPServer:
         self.resources[name] = content
         logger.info(f"Registered resource '{name}'")
     
-    def register_tool(self, name: str, description: str, parameters: Dict[str, Any], handler: Callable):
+    def register_tool(self, name: str, description: str, parameters: Dict[str, Any], handler: Callable,
+                      max_concurrency: Optional[int] = None):
         """
         Register a tool with the MCP server.
         
@@ -187,17 +270,28 @@ class FastMCPServer:
             description: Description of the tool
             parameters: Parameters schema for the tool
             handler: Handler function for the tool
+            max_concurrency: Optional limit on calls of this tool running at once
         """
         logger.info(f"Registering tool: {name}")
         
         self.tools[name] = {
             "function": handler,
             "description": description,
-            "parameters": parameters
+            "parameters": parameters,
+            "max_concurrency": max_concurrency,
+            "progress": self._accepts_progress(handler)
         }
         
         logger.debug(f"Tool registered: {name} - {description}")
     
+    @staticmethod
+    def _accepts_progress(fn: Callable) -> bool:
+        """Whether fn takes the progress(done, total=None, message=None) callback"""
+        try:
+            return "progress" in inspect.signature(fn).parameters
+        except (TypeError, ValueError):
+            return False
+    
     def _handle_signal(self, signum: int, frame: Any) -> None:
         """
         Handle termination signals gracefully.
@@ -215,15 +309,29 @@ class FastMCPServer:
         # Allow some time for cleanup
         loop.call_later(2, loop.stop)
     
-    def _handle_client_message(self, message: Dict[str, Any]) -> Dict[str, Any]:
+    async def handle_message(self, message: Dict[str, Any]) -> Optional[Dict[str, Any]]:
+        """
+        Handle one MCP message outside a transport.
+        
+        Args:
+            message: The message from the client
+        
+        Returns:
+            The response, or None for a notification
+        """
+        return await self._handle_client_message(message)
+    
+    async def _handle_client_message(self, message: Dict[str, Any],
+                                     connection: Optional[_Connection] = None) -> Optional[Dict[str, Any]]:
         """
         Handle an MCP protocol message from a client.
         
         Args:
             message: The message from the client
+            connection: The connection it came in on, for cancellation and progress
         
         Returns:
-            The response to send back to the client
+            The response to send back to the client, or None for a notification
         """
         try:
             if "jsonrpc" not in message or message["jsonrpc"] != "2.0":
@@ -235,12 +343,18 @@ class FastMCPServer:
             method = message["method"]
             params = message.get("params", {})
             
+            # Notifications carry no id and get no response
+            if "id" not in message:
+                if method == "notifications/cancelled":
+                    self._handle_cancelled(connection, params)
+                return None
+            
             if method == "mcp/initialize":
                 return self._handle_initialize(message["id"], params)
             elif method == "mcp/listTools":
                 return self._handle_list_tools(message["id"])
             elif method == "mcp/callTool":
-                return self._handle_call_tool(message["id"], params)
+                return await self._handle_call_tool(message["id"], params, connection)
             elif method == "mcp/listResources":
                 return self._handle_list_resources(message["id"])
             elif method == "mcp/readResource":
@@ -252,6 +366,48 @@ class FastMCPServer:
             logger.error(f"Error handling message: {str(e)}")
             return self._error_response(message.get("id"), -32603, f"Internal error: {str(e)}")
     
+    def _dispatch(self, connection: _Connection, message: Any) -> None:
+        """Handle a message in a task of its own and send its response when done."""
+        request_id = message.get("id") if isinstance(message, dict) else None
+        
+        async def respond() -> None:
+            if not isinstance(message, dict):
+                response = self._error_response(None, -32600, "Invalid request")
+            else:
+                try:
+                    response = await self._handle_client_message(message, connection)
+                except asyncio.CancelledError:
+                    # Cancelled by the client, or the connection closed: no response
+                    logger.info(f"Request {request_id} cancelled")
+                    return
+            if response is not None:
+                logger.debug(f"Sending response: {response}")
+                await connection.send(response)
+        
+        task = asyncio.ensure_future(respond())
+        if request_id is not None:
+            connection.in_flight[request_id] = task
+            
+            def forget(done: asyncio.Task) -> None:
+                # The id may have been reused by a later request
+                if connection.in_flight.get(request_id) is done:
+                    del connection.in_flight[request_id]
+            
+            task.add_done_callback(forget)
+    
+    def _handle_cancelled(self, connection: Optional[_Connection], params: Dict[str, Any]) -> None:
+        """
+        Handle the notifications/cancelled notification.
+        
+        Args:
+            connection: The connection the cancelled request came in on
+            params: The notification parameters (requestId, reason)
+        """
+        task = connection.in_flight.get(params.get("requestId")) if connection else None
+        if task is not None and not task.done():
+            logger.info(f"Cancelling request {params.get('requestId')}: {params.get('reason', 'no reason given')}")
+            task.cancel()
+    
     def _error_response(self, id: Any, code: int, message: str) -> Dict[str, Any]:
         """
         Create an error response according to the JSON-RPC 2.0 spec.
@@ -326,13 +482,15 @@ class FastMCPServer:
             }
         }
     
-    def _handle_call_tool(self, id: Any, params: Dict[str, Any]) -> Dict[str, Any]:
+    async def _handle_call_tool(self, id: Any, params: Dict[str, Any],
+                                connection: Optional[_Connection] = None) -> Dict[str, Any]:
         """
         Handle the mcp/callTool method.
         
         Args:
             id: The request ID
             params: The method parameters
+            connection: The connection to send progress notifications to
         
         Returns:
             The response
@@ -347,8 +505,15 @@ class FastMCPServer:
             return self._error_response(id, -32602, f"Tool '{tool_name}' not found")
         
         try:
-            tool = self.tools[tool_name]["function"]
-            result = tool(**tool_params)
+            tool = self.tools[tool_name]
+            progress = _Progress(connection, (params.get("_meta") or {}).get("progressToken"))
+            kwargs = dict(tool_params)
+            if tool.get("progress"):
+                kwargs["progress"] = progress
+            
+            async with self._slots(tool_name):
+                result = await self._invoke(tool["function"], kwargs, progress)
+            await progress.flush()
             
             return {
                 "jsonrpc": "2.0",
@@ -361,6 +526,46 @@ class FastMCPServer:
             logger.error(f"Error calling tool '{tool_name}': {str(e)}")
             return self._error_response(id, -32603, f"Error calling tool '{tool_name}': {str(e)}")
     
+    @contextlib.asynccontextmanager
+    async def _slots(self, tool_name: str) -> AsyncIterator[None]:
+        """
+        Hold a server-wide request slot and, if the tool is limited, one of
+        its slots. The tool slot is taken first, so calls queued on a busy
+        tool do not hold server-wide slots other tools could use.
+        """
+        if self._request_slots is None:
+            self._request_slots = asyncio.Semaphore(self.max_concurrent_requests)
+        limit = self.tools[tool_name].get("max_concurrency") or self.tool_concurrency.get(tool_name)
+        if not limit:
+            async with self._request_slots:
+                yield
+            return
+        if tool_name not in self._tool_slots:
+            self._tool_slots[tool_name] = asyncio.Semaphore(limit)
+        async with self._tool_slots[tool_name]:
+            async with self._request_slots:
+                yield
+    
+    async def _invoke(self, fn: Callable, kwargs: Dict[str, Any], progress: _Progress) -> Any:
+        """
+        Call a tool function: coroutines are awaited, async generators are
+        streamed (each chunk as a progress notification, the result is all
+        chunks, joined if they are text) and plain functions run on a
+        worker thread.
+        """
+        if inspect.isasyncgenfunction(fn):
+            chunks = []
+            async for chunk in fn(**kwargs):
+                chunks.append(chunk)
+                progress(len(chunks), message=chunk if isinstance(chunk, str) else json.dumps(chunk, default=str))
+            return "".join(chunks) if all(isinstance(c, str) for c in chunks) else chunks
+        if inspect.iscoroutinefunction(fn):
+            return await fn(**kwargs)
+        result = await asyncio.to_thread(fn, **kwargs)
+        if inspect.isawaitable(result):
+            result = await result
+        return result
+    
     def _handle_list_resources(self, id: Any) -> Dict[str, Any]:
         """
         Handle the mcp/listResources method.
@@ -429,23 +634,30 @@ class FastMCPServer:
             import asyncio
             import websockets
             
-            async def handle_websocket(websocket: Any, path: str) -> None:
+            async def handle_websocket(websocket: Any, path: str = "") -> None:
                 """Handle a websocket connection."""
-                async for message in websocket:
-                    try:
-                        request = json.loads(message)
+                lock = asyncio.Lock()
+                
+                async def send(message: Dict[str, Any]) -> None:
+                    async with lock:
+                        await websocket.send(json.dumps(message))
+                
+                connection = _Connection(send)
+                try:
+                    async for message in websocket:
+                        try:
+                            request = json.loads(message)
+                        except json.JSONDecodeError as e:
+                            logger.error(f"Error decoding message: {str(e)}")
+                            await send(self._error_response(None, -32700, "Parse error"))
+                            continue
                         logger.debug(f"Received message: {request}")
-                        
-                        response = self._handle_client_message(request)
-                        logger.debug(f"Sending response: {response}")
-                        
-                        await websocket.send(json.dumps(response))
-                    except json.JSONDecodeError as e:
-                        logger.error(f"Error decoding message: {str(e)}")
-                        await websocket.send(json.dumps(self._error_response(None, -32700, "Parse error")))
-                    except Exception as e:
-                        logger.error(f"Error handling message: {str(e)}")
-                        await websocket.send(json.dumps(self._error_response(None, -32603, f"Internal error: {str(e)}")))
+                        self._dispatch(connection, request)
+                except Exception as e:
+                    logger.error(f"Error handling connection: {str(e)}")
+                finally:
+                    # Nobody is left to answer
+                    connection.cancel_all()
             
             # Start the server
             start_server = websockets.serve(handle_websocket, host, port)
@@ -480,35 +692,50 @@ class FastMCPServer:
             sys.stdout = open(sys.stdout.fileno(), mode='w', encoding='utf-8', buffering=1)
             sys.stdin = open(sys.stdin.fileno(), mode='r', encoding='utf-8', buffering=1)
         
+        asyncio.run(self._serve_stdio())
+    
+    async def _serve_stdio(self) -> None:
+        """Read framed messages on a worker thread and handle each in a task of its own."""
+        loop = asyncio.get_running_loop()
+        lock = asyncio.Lock()
+        
+        async def send(message: Dict[str, Any]) -> None:
+            response_json = json.dumps(message)
+            response_bytes = response_json.encode('utf-8')
+            async with lock:
+                sys.stdout.write(f"Content-Length: {len(response_bytes)}\r\n\r\n")
+                sys.stdout.write(response_json)
+                sys.stdout.flush()
+        
+        connection = _Connection(send)
         while True:
             try:
                 # Read the content length header
-                header = sys.stdin.readline().strip()
+                header = await loop.run_in_executor(None, sys.stdin.readline)
+                if not header:
+                    break  # EOF: the client is done
+                header = header.strip()
                 if not header:
                     continue
                 
                 content_length = int(header.split(":")[1].strip())
                 
                 # Skip the empty line
-                sys.stdin.readline()
+                await loop.run_in_executor(None, sys.stdin.readline)
                 
                 # Read the message content
-                content = sys.stdin.read(content_length)
+                content = await loop.run_in_executor(None, sys.stdin.read, content_length)
                 
-                # Parse and handle the message
-                message = json.loads(content)
-                response = self._handle_client_message(message)
-                
-                # Send the response
-                response_json = json.dumps(response)
-                response_bytes = response_json.encode('utf-8')
-                sys.stdout.write(f"Content-Length: {len(response_bytes)}\r\n\r\n")
-                sys.stdout.write(response_json)
-                sys.stdout.flush()
+                self._dispatch(connection, json.loads(content))
                 
             except Exception as e:
                 logger.error(f"Error in stdio loop: {str(e)}")
                 # Try to recover and continue
+        
+        # stdout is still open: let the requests already read finish
+        pending = list(connection.in_flight.values())
+        if pending:
+            await asyncio.gather(*pending, return_exceptions=True)
 
 if __name__ == "__main__":
     import argparse
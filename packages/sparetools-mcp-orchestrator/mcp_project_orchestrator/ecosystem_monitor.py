@@ -3,20 +3,32 @@ OpenSSL Ecosystem Workflow Monitor
 
 Monitors workflow runs across all OpenSSL repositories and provides
 AI-assisted failure analysis and automated issue creation.
+
+Repositories, runs and failed jobs are scanned concurrently through
+AsyncGitHubClient: one connection pool, ETag revalidation of run listings,
+jobs and logs of completed runs served from the local cache, and
+concurrency bounded by the remaining rate limit.
+
+Classified failures are persisted in a FailureIndex (SQLite/FTS5): a run
+whose failed job is already indexed is not fetched or classified again,
+and analyze_patterns() without a failure list answers from the index over
+any time window.
 """
 
 import asyncio
+import hashlib
 import json
 import logging
 from datetime import datetime, timedelta
 from typing import Dict, List, Optional, Tuple
 from dataclasses import dataclass
 from enum import Enum
+from pathlib import Path
 
-import httpx
 from github import Github
-from github.WorkflowRun import WorkflowRun
-from github.Repository import Repository
+
+from .github_client import AsyncGitHubClient, DEFAULT_CACHE_DIR, DEFAULT_MAX_CONCURRENCY
+from .failure_index import FailureIndex, DEFAULT_INDEX_PATH
 
 logger = logging.getLogger(__name__)
 
@@ -47,6 +59,8 @@ class WorkflowFailure:
     branch: Optional[str] = None
     commit_sha: Optional[str] = None
     actor: Optional[str] = None
+    job_id: Optional[int] = None
+    job_name: Optional[str] = None
 
 
 @dataclass
@@ -61,80 +75,160 @@ class FailurePattern:
     suggested_fix: str
 
 
+def _parse_timestamp(value: str) -> datetime:
+    """GitHub timestamp as naive UTC, matching datetime.utcnow()"""
+    return datetime.fromisoformat(value.replace("Z", "+00:00")).replace(tzinfo=None)
+
+
+def _duration_ms(started: str, finished: Optional[str]) -> int:
+    if not finished:
+        return 0
+    return int((_parse_timestamp(finished) - _parse_timestamp(started)).total_seconds() * 1000)
+
+
+def _log_digest(logs: str) -> str:
+    """Digest stored with an indexed failure, of the log it was classified from"""
+    return hashlib.sha256(logs.encode()).hexdigest()
+
+
 class EcosystemMonitor:
     """Monitors OpenSSL ecosystem workflows and analyzes failures."""
     
-    def __init__(self, github_token: str, repositories: List[str]):
+    def __init__(self, github_token: str, repositories: List[str],
+                 cache_dir: Optional[Path] = DEFAULT_CACHE_DIR,
+                 max_concurrency: int = DEFAULT_MAX_CONCURRENCY,
+                 index_path: Optional[Path] = DEFAULT_INDEX_PATH):
         self.github = Github(github_token)
+        self.github_token = github_token
         self.repositories = repositories
+        self.cache_dir = cache_dir
+        self.max_concurrency = max_concurrency
         self.failure_patterns: Dict[str, FailurePattern] = {}
+        self.index = FailureIndex(index_path) if index_path else None
+        if self.index:
+            self.index.reclassify(lambda error, job: self._classify_failure(error, job).value)
         
     async def monitor_workflows(self, hours_back: int = 4) -> List[WorkflowFailure]:
         """Monitor workflows across all repositories for failures."""
-        failures = []
         cutoff_time = datetime.utcnow() - timedelta(hours=hours_back)
         
-        for repo_name in self.repositories:
-            try:
-                repo = self.github.get_repo(repo_name)
-                workflow_runs = repo.get_workflow_runs(
-                    status="completed",
-                    created=f">={cutoff_time.isoformat()}"
-                )
-                
-                for run in workflow_runs:
-                    if run.conclusion == "failure":
-                        failure = await self._analyze_failure(run, repo_name)
-                        if failure:
-                            failures.append(failure)
-                            
-            except Exception as e:
-                logger.error(f"Error monitoring {repo_name}: {e}")
-                
-        return failures
+        async with AsyncGitHubClient(self.github_token, self.cache_dir, self.max_concurrency) as client:
+            per_repo = await asyncio.gather(*(self._monitor_repository(client, repo_name, cutoff_time)
+                                              for repo_name in self.repositories))
+        return [failure for failures in per_repo for failure in failures]
     
-    async def _analyze_failure(self, run: WorkflowRun, repo_name: str) -> Optional[WorkflowFailure]:
+    async def _monitor_repository(self, client: AsyncGitHubClient, repo_name: str,
+                                  cutoff_time: datetime) -> List[WorkflowFailure]:
+        try:
+            # Whole hours keep the listing URL, and so its ETag, stable between scans
+            workflow_runs = await client.get_items(
+                f"repos/{repo_name}/actions/runs", "workflow_runs",
+                params={"status": "completed", "created": f">={cutoff_time.strftime('%Y-%m-%dT%H:00:00Z')}"}
+            )
+        except Exception as e:
+            logger.error(f"Error monitoring {repo_name}: {e}")
+            return []
+        
+        failed_runs = [run for run in workflow_runs if run.get("conclusion") == "failure"
+                       and _parse_timestamp(run["created_at"]) >= cutoff_time]
+        results = await asyncio.gather(*(self._analyze_failure(client, run, repo_name) for run in failed_runs))
+        return [failure for failure in results if failure]
+    
+    async def _analyze_failure(self, client: AsyncGitHubClient, run: Dict,
+                               repo_name: str) -> Optional[WorkflowFailure]:
         """Analyze a failed workflow run and classify the failure."""
+        if self.index:
+            indexed = self.index.for_run(run["id"])
+            if indexed:
+                # Verified against the log when it is cached; no request otherwise
+                logs = client.cached(f"repos/{repo_name}/actions/jobs/{indexed['job_id']}/logs")
+                if logs is None or _log_digest(logs) == indexed["log_digest"]:
+                    return self._failure_from_record(indexed)
+                logger.info(f"Log of {repo_name} job {indexed['job_id']} changed, reclassifying")
+                self.index.remove(indexed["job_id"])
         try:
-            # Get workflow run details
-            run_details = run.get_workflow_run()
-            jobs = run_details.get_jobs()
+            # A completed run's jobs and logs never change: cached without revalidation
+            jobs = await client.get_items(f"repos/{repo_name}/actions/runs/{run['id']}/jobs", "jobs",
+                                          params={"filter": "latest"}, immutable=True)
             
             # Find the failed job
-            failed_job = None
-            for job in jobs:
-                if job.conclusion == "failure":
-                    failed_job = job
-                    break
-            
+            failed_job = next((job for job in jobs if job.get("conclusion") == "failure"), None)
             if not failed_job:
                 return None
                 
             # Get job logs
-            logs = failed_job.get_logs()
+            logs = await client.get_text(f"repos/{repo_name}/actions/jobs/{failed_job['id']}/logs",
+                                         immutable=True)
             error_message = self._extract_error_message(logs)
             
             # Classify failure type
-            failure_type = self._classify_failure(error_message, failed_job.name)
+            failure_type = self._classify_failure(error_message, failed_job["name"])
             
-            return WorkflowFailure(
+            failure = WorkflowFailure(
                 repository=repo_name,
-                workflow_name=run.name,
-                run_id=run.id,
+                workflow_name=run["name"],
+                run_id=run["id"],
                 failure_type=failure_type,
                 error_message=error_message,
-                failed_at=run.created_at,
-                duration=run.run_duration_ms or 0,
-                platform=self._extract_platform(failed_job.name),
-                branch=run.head_branch,
-                commit_sha=run.head_sha,
-                actor=run.actor.login if run.actor else None
+                failed_at=_parse_timestamp(run["created_at"]),
+                duration=_duration_ms(run.get("run_started_at") or run["created_at"], run.get("updated_at")),
+                platform=self._extract_platform(failed_job["name"]),
+                branch=run.get("head_branch"),
+                commit_sha=run.get("head_sha"),
+                actor=(run.get("actor") or {}).get("login"),
+                job_id=failed_job["id"],
+                job_name=failed_job["name"]
             )
+            if self.index:
+                self.index.add(self._failure_record(failure, _log_digest(logs)))
+            return failure
             
         except Exception as e:
-            logger.error(f"Error analyzing failure in {repo_name} run {run.id}: {e}")
+            logger.error(f"Error analyzing failure in {repo_name} run {run.get('id')}: {e}")
             return None
     
+    @staticmethod
+    def _failure_record(failure: WorkflowFailure, log_digest: str) -> Dict:
+        return {
+            "job_id": failure.job_id, "log_digest": log_digest, "repository": failure.repository,
+            "workflow_name": failure.workflow_name, "run_id": failure.run_id, "job_name": failure.job_name,
+            "failure_type": failure.failure_type.value, "error_message": failure.error_message,
+            "failed_at": failure.failed_at, "duration": failure.duration, "platform": failure.platform,
+            "branch": failure.branch, "commit_sha": failure.commit_sha, "actor": failure.actor,
+        }
+    
+    @staticmethod
+    def _failure_from_record(record: Dict) -> WorkflowFailure:
+        return WorkflowFailure(
+            repository=record["repository"],
+            workflow_name=record["workflow_name"],
+            run_id=record["run_id"],
+            failure_type=FailureType(record["failure_type"]),
+            error_message=record["error_message"],
+            failed_at=datetime.fromisoformat(record["failed_at"]),
+            duration=record["duration"],
+            platform=record["platform"],
+            branch=record["branch"],
+            commit_sha=record["commit_sha"],
+            actor=record["actor"],
+            job_id=record["job_id"],
+            job_name=record["job_name"]
+        )
+    
+    def indexed_failures(self, since: Optional[datetime] = None, until: Optional[datetime] = None,
+                         failure_type: Optional[FailureType] = None) -> List[WorkflowFailure]:
+        """Indexed failures of the monitored repositories, oldest first"""
+        if not self.index:
+            return []
+        return [self._failure_from_record(record) for record in self.index.failures(
+            since, until, self.repositories, failure_type.value if failure_type else None)]
+    
+    def search_failures(self, query: str, limit: int = 50) -> List[WorkflowFailure]:
+        """Full-text search (FTS5 syntax) over indexed error messages and job names"""
+        if not self.index:
+            return []
+        return [self._failure_from_record(record) for record in self.index.search(query, limit)]
+    
     def _extract_error_message(self, logs: str) -> str:
         """Extract the most relevant error message from job logs."""
         lines = logs.split('\n')
@@ -182,8 +276,18 @@ class EcosystemMonitor:
                 return platform
         return None
     
-    def analyze_patterns(self, failures: List[WorkflowFailure]) -> List[FailurePattern]:
-        """Analyze failures to identify recurring patterns."""
+    def analyze_patterns(self, failures: Optional[List[WorkflowFailure]] = None,
+                         since: Optional[datetime] = None,
+                         until: Optional[datetime] = None) -> List[FailurePattern]:
+        """
+        Analyze failures to identify recurring patterns.
+        
+        Without a failure list the patterns are aggregated by the index over
+        [since, until) for the monitored repositories.
+        """
+        if failures is None:
+            return self._indexed_patterns(since, until)
+        
         patterns = {}
         
         # Group failures by type and error message
@@ -223,6 +327,23 @@ class EcosystemMonitor:
         
         return failure_patterns
     
+    def _indexed_patterns(self, since: Optional[datetime], until: Optional[datetime]) -> List[FailurePattern]:
+        if not self.index:
+            return []
+        failure_patterns = []
+        for row in self.index.patterns(since, until, self.repositories):
+            failure_type = FailureType(row["failure_type"])
+            failure_patterns.append(FailurePattern(
+                failure_type=failure_type,
+                repositories=row["repositories"],
+                frequency=row["frequency"],
+                first_seen=datetime.fromisoformat(row["first_seen"]),
+                last_seen=datetime.fromisoformat(row["last_seen"]),
+                common_error=row["common_error"],
+                suggested_fix=self._generate_fix_suggestion(failure_type, row["common_error"])
+            ))
+        return failure_patterns
+    
     def _generate_fix_suggestion(self, failure_type: FailureType, error_message: str) -> str:
         """Generate AI-assisted fix suggestions based on failure type."""
         suggestions = {
@@ -377,6 +498,7 @@ async def main():
     
     # Monitor workflows
     logger.info("Starting ecosystem monitoring...")
+    since = datetime.utcnow() - timedelta(hours=4)
     failures = await monitor.monitor_workflows(hours_back=4)
     
     if not failures:
@@ -386,7 +508,7 @@ async def main():
     logger.info(f"Found {len(failures)} failures across {len(set(f.repository for f in failures))} repositories")
     
     # Analyze patterns
-    patterns = monitor.analyze_patterns(failures)
+    patterns = monitor.analyze_patterns(since=since)
     logger.info(f"Identified {len(patterns)} recurring failure patterns")
     
     # Create issues for significant patterns
@@ -0,0 +1,212 @@
+"""
+Persistent index of classified CI job failures
+
+EcosystemMonitor records every failed job it has classified in a SQLite
+database, keyed by job ID together with the digest of the log it was
+classified from. A later scan only fetches and classifies jobs it has not
+seen, and pattern queries are answered with SQL over the whole history
+instead of re-reading logs. Error messages and job names are also indexed
+with FTS5 for free-text search ("openssl_fips AND timeout").
+
+A row whose job log is still in the response cache is checked against its
+digest when it is read; a log that changed under the same job ID (a
+re-run, a replaced cache entry) drops the row so the job is classified
+again.
+
+Rows remember the classifier version that produced them; when the rules
+change, reclassify() updates the old rows from the stored error messages
+without touching any log.
+"""
+
+import logging
+import os
+import sqlite3
+import threading
+from datetime import datetime
+from pathlib import Path
+from typing import Any, Callable, Dict, Iterable, List, Optional, Set
+
+logger = logging.getLogger(__name__)
+
+DEFAULT_INDEX_PATH = Path(os.environ.get("XDG_CACHE_HOME", Path.home() / ".cache")) / "mcp-orchestrator" / "failures.sqlite"
+
+# Bump when EcosystemMonitor._classify_failure or _extract_error_message change
+CLASSIFIER_VERSION = 1
+
+COLUMNS = ["job_id", "log_digest", "repository", "workflow_name", "run_id", "job_name",
+           "failure_type", "error_message", "failed_at", "duration", "platform", "branch",
+           "commit_sha", "actor", "classifier_version", "indexed_at"]
+
+_SCHEMA = """
+CREATE TABLE IF NOT EXISTS failures (
+    job_id INTEGER PRIMARY KEY,
+    log_digest TEXT NOT NULL,
+    repository TEXT NOT NULL,
+    workflow_name TEXT NOT NULL,
+    run_id INTEGER NOT NULL,
+    job_name TEXT NOT NULL,
+    failure_type TEXT NOT NULL,
+    error_message TEXT NOT NULL,
+    failed_at TEXT NOT NULL,
+    duration INTEGER NOT NULL DEFAULT 0,
+    platform TEXT,
+    branch TEXT,
+    commit_sha TEXT,
+    actor TEXT,
+    classifier_version INTEGER NOT NULL,
+    indexed_at TEXT NOT NULL
+);
+CREATE INDEX IF NOT EXISTS failures_time ON failures (failed_at);
+CREATE INDEX IF NOT EXISTS failures_type ON failures (failure_type, failed_at);
+CREATE INDEX IF NOT EXISTS failures_repo ON failures (repository, failed_at);
+CREATE INDEX IF NOT EXISTS failures_run ON failures (run_id);
+CREATE VIRTUAL TABLE IF NOT EXISTS failures_fts USING fts5(
+    error_message, job_name, repository, workflow_name,
+    content='failures', content_rowid='job_id'
+);
+CREATE TRIGGER IF NOT EXISTS failures_ai AFTER INSERT ON failures BEGIN
+    INSERT INTO failures_fts (rowid, error_message, job_name, repository, workflow_name)
+    VALUES (new.job_id, new.error_message, new.job_name, new.repository, new.workflow_name);
+END;
+CREATE TRIGGER IF NOT EXISTS failures_ad AFTER DELETE ON failures BEGIN
+    INSERT INTO failures_fts (failures_fts, rowid, error_message, job_name, repository, workflow_name)
+    VALUES ('delete', old.job_id, old.error_message, old.job_name, old.repository, old.workflow_name);
+END;
+CREATE TRIGGER IF NOT EXISTS failures_au AFTER UPDATE ON failures BEGIN
+    INSERT INTO failures_fts (failures_fts, rowid, error_message, job_name, repository, workflow_name)
+    VALUES ('delete', old.job_id, old.error_message, old.job_name, old.repository, old.workflow_name);
+    INSERT INTO failures_fts (rowid, error_message, job_name, repository, workflow_name)
+    VALUES (new.job_id, new.error_message, new.job_name, new.repository, new.workflow_name);
+END;
+"""
+
+
+def _iso(value: Optional[datetime]) -> Optional[str]:
+    return value.isoformat() if value is not None else None
+
+
+class FailureIndex:
+    """SQLite (WAL) failure store; safe to share between the monitor's tasks"""
+
+    def __init__(self, path: Path = DEFAULT_INDEX_PATH):
+        self.path = Path(path)
+        self.path.parent.mkdir(parents=True, exist_ok=True)
+        self._lock = threading.Lock()
+        self.conn = sqlite3.connect(str(self.path), check_same_thread=False)
+        self.conn.row_factory = sqlite3.Row
+        self.conn.execute("PRAGMA journal_mode=WAL")
+        self.conn.execute("PRAGMA synchronous=NORMAL")
+        self.conn.executescript(_SCHEMA)
+
+    def close(self) -> None:
+        self.conn.close()
+
+    def get(self, job_id: int) -> Optional[Dict[str, Any]]:
+        with self._lock:
+            row = self.conn.execute("SELECT * FROM failures WHERE job_id = ?", (job_id,)).fetchone()
+        return dict(row) if row else None
+
+    def for_run(self, run_id: int) -> Optional[Dict[str, Any]]:
+        """The failure indexed for a workflow run, if any"""
+        with self._lock:
+            row = self.conn.execute("SELECT * FROM failures WHERE run_id = ? ORDER BY job_id LIMIT 1",
+                                    (run_id,)).fetchone()
+        return dict(row) if row else None
+
+    def remove(self, job_id: int) -> None:
+        with self._lock, self.conn:
+            self.conn.execute("DELETE FROM failures WHERE job_id = ?", (job_id,))
+
+    def known_jobs(self, job_ids: Iterable[int]) -> Set[int]:
+        """The given job IDs that are already indexed"""
+        job_ids = list(job_ids)
+        known: Set[int] = set()
+        with self._lock:
+            for start in range(0, len(job_ids), 500):
+                chunk = job_ids[start:start + 500]
+                rows = self.conn.execute(
+                    f"SELECT job_id FROM failures WHERE job_id IN ({','.join('?' * len(chunk))})", chunk)
+                known.update(row[0] for row in rows)
+        return known
+
+    def add(self, record: Dict[str, Any]) -> None:
+        """Insert or replace one failure (a dict with the COLUMNS keys; datetimes allowed)"""
+        values = dict(record, classifier_version=record.get("classifier_version", CLASSIFIER_VERSION),
+                      indexed_at=datetime.utcnow().isoformat())
+        values["failed_at"] = _iso(values["failed_at"]) if isinstance(values["failed_at"], datetime) \
+            else values["failed_at"]
+        with self._lock, self.conn:
+            self.conn.execute(
+                f"INSERT INTO failures ({', '.join(COLUMNS)}) VALUES ({', '.join('?' * len(COLUMNS))}) "
+                "ON CONFLICT(job_id) DO UPDATE SET "
+                + ", ".join(f"{c} = excluded.{c}" for c in COLUMNS if c != "job_id"),
+                [values.get(c) for c in COLUMNS])
+
+    def _where(self, since: Optional[datetime], until: Optional[datetime],
+               repositories: Optional[List[str]], failure_type: Optional[str]):
+        clauses, params = [], []
+        if since is not None:
+            clauses.append("failed_at >= ?")
+            params.append(_iso(since))
+        if until is not None:
+            clauses.append("failed_at < ?")
+            params.append(_iso(until))
+        if repositories:
+            clauses.append(f"repository IN ({','.join('?' * len(repositories))})")
+            params.extend(repositories)
+        if failure_type:
+            clauses.append("failure_type = ?")
+            params.append(failure_type)
+        return (" WHERE " + " AND ".join(clauses)) if clauses else "", params
+
+    def failures(self, since: Optional[datetime] = None, until: Optional[datetime] = None,
+                 repositories: Optional[List[str]] = None,
+                 failure_type: Optional[str] = None) -> List[Dict[str, Any]]:
+        where, params = self._where(since, until, repositories, failure_type)
+        with self._lock:
+            rows = self.conn.execute(f"SELECT * FROM failures{where} ORDER BY failed_at", params).fetchall()
+        return [dict(row) for row in rows]
+
+    def patterns(self, since: Optional[datetime] = None, until: Optional[datetime] = None,
+                 repositories: Optional[List[str]] = None, min_frequency: int = 2) -> List[Dict[str, Any]]:
+        """
+        Failures grouped like EcosystemMonitor.analyze_patterns (type and
+        first 100 characters of the error), most frequent first
+        """
+        where, params = self._where(since, until, repositories, None)
+        query = f"""
+            SELECT failure_type, substr(error_message, 1, 100) AS error_key,
+                   COUNT(*) AS frequency, MIN(failed_at) AS first_seen, MAX(failed_at) AS last_seen,
+                   GROUP_CONCAT(DISTINCT repository) AS repositories,
+                   MIN(error_message) AS common_error
+            FROM failures{where}
+            GROUP BY failure_type, error_key
+            HAVING COUNT(*) >= ?
+            ORDER BY frequency DESC, last_seen DESC
+        """
+        with self._lock:
+            rows = self.conn.execute(query, params + [min_frequency]).fetchall()
+        return [dict(row, repositories=row["repositories"].split(",")) for row in rows]
+
+    def search(self, query: str, limit: int = 50) -> List[Dict[str, Any]]:
+        """Full-text search (FTS5 query syntax) over error messages, job names and repositories"""
+        with self._lock:
+            rows = self.conn.execute(
+                "SELECT failures.* FROM failures_fts JOIN failures ON failures.job_id = failures_fts.rowid "
+                "WHERE failures_fts MATCH ? ORDER BY rank LIMIT ?", (query, limit)).fetchall()
+        return [dict(row) for row in rows]
+
+    def reclassify(self, classify: Callable[[str, str], str]) -> int:
+        """Re-run classify(error_message, job_name) on rows from older classifier versions"""
+        with self._lock:
+            rows = self.conn.execute(
+                "SELECT job_id, error_message, job_name FROM failures WHERE classifier_version < ?",
+                (CLASSIFIER_VERSION,)).fetchall()
+            with self.conn:
+                self.conn.executemany(
+                    "UPDATE failures SET failure_type = ?, classifier_version = ? WHERE job_id = ?",
+                    [(classify(row["error_message"], row["job_name"]), CLASSIFIER_VERSION, row["job_id"])
+                     for row in rows])
+        if rows:
+            logger.info(f"Reclassified {len(rows)} indexed failures (classifier v{CLASSIFIER_VERSION})")
+        return len(rows)
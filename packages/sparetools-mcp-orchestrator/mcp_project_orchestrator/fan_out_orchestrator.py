@@ -8,7 +8,7 @@ workflows in dependent repositories based on dependency relationships.
 import asyncio
 import json
 import logging
-from datetime import datetime
+from datetime import datetime, timezone
 from typing import Dict, List, Optional, Set
 from dataclasses import dataclass
 from enum import Enum
@@ -17,8 +17,28 @@ import httpx
 from github import Github
 from github.Repository import Repository
 
+try:
+    from sparetools_tracing import span, traceparent
+except ImportError:  # sparetools-base not on PYTHONPATH: tracing is off
+    import contextlib
+
+    def traceparent():
+        return None
+
+    @contextlib.contextmanager
+    def span(name, **attributes):
+        yield type("Span", (), {"set_attribute": lambda self, key, value: None})()
+
 logger = logging.getLogger(__name__)
 
+GITHUB_GRAPHQL_URL = "https://api.github.com/graphql"
+# Workflow dispatches in flight at once during a cascade
+DEFAULT_MAX_CONCURRENT_DISPATCHES = 4
+# Repositories per batched GraphQL status query
+STATUS_BATCH_SIZE = 20
+TERMINAL_STATUSES = {"success", "failure", "cancelled", "timed_out", "action_required",
+                     "skipped", "neutral", "stale", "startup_failure", "not_found", "error"}
+
 
 class ReleaseType(Enum):
     """Types of releases that can trigger fan-out."""
@@ -53,8 +73,15 @@ class ReleaseTrigger:
 class FanOutOrchestrator:
     """Orchestrates cross-repository releases and dependency updates."""
     
-    def __init__(self, github_token: str):
+    def __init__(self, github_token: str,
+                 max_concurrent_dispatches: int = DEFAULT_MAX_CONCURRENT_DISPATCHES,
+                 trace_input: Optional[str] = None):
         self.github = Github(github_token)
+        self.github_token = github_token
+        self.max_concurrent_dispatches = max(1, max_concurrent_dispatches)
+        # workflow_dispatch input receiving the cascade's traceparent, for
+        # release workflows that declare it and export it as TRACEPARENT
+        self.trace_input = trace_input
         self.repositories = self._initialize_repositories()
         self.dependency_graph = self._build_dependency_graph()
         
@@ -108,6 +135,17 @@ class FanOutOrchestrator:
             )
         }
     
+    async def ecosystem_versions(self, conan_remotes: Optional[Dict[str, str]] = None,
+                                 on_row=None) -> "VersionTable":
+        """
+        Versions of every repository (release, conanfile, version file,
+        dependency pins, Conan remotes), fetched concurrently; on_row(row,
+        table) is called as each repository completes.
+        """
+        from .version_table import VersionAggregator
+        aggregator = VersionAggregator(self.github_token, self.repositories, conan_remotes)
+        return await aggregator.aggregate(on_row)
+    
     def _build_dependency_graph(self) -> Dict[str, Set[str]]:
         """Build dependency graph for release ordering."""
         graph = {}
@@ -115,9 +153,35 @@ class FanOutOrchestrator:
             graph[repo_name] = set(repo_info.dependencies)
         return graph
     
-    async def trigger_release_cascade(self, source_repo: str, version: str, 
-                                    release_type: ReleaseType) -> List[ReleaseTrigger]:
-        """Trigger a release cascade starting from a source repository."""
+    async def trigger_release_cascade(self, source_repo: str, version: str,
+                                    release_type: ReleaseType,
+                                    wait_for_completion: bool = False,
+                                    poll_interval: float = 30.0) -> List[ReleaseTrigger]:
+        """
+        Trigger a release cascade starting from a source repository.
+
+        The dependents of source_repo are scheduled as a DAG over
+        dependency_graph: a repository is dispatched as soon as every
+        dependency it has inside the cascade has been, so independent
+        repositories run concurrently (at most max_concurrent_dispatches
+        at once) and the cascade takes as long as its critical path. With
+        wait_for_completion a repository also waits for its dependencies'
+        workflow runs to finish successfully. Repositories whose
+        dependencies failed are skipped.
+
+        The cascade is one trace: a span per repository starts when its
+        dependencies are done and covers its dispatch and, if waited for,
+        its workflow run, so the longest chain of spans is the critical path.
+        """
+        with span("release cascade", source_repo=source_repo, version=version,
+                  release_type=release_type.value) as cascade_span:
+            triggers = await self._release_cascade(source_repo, version, release_type,
+                                                   wait_for_completion, poll_interval)
+            cascade_span.set_attribute("released", len(triggers) - 1)
+        return triggers
+    
+    async def _release_cascade(self, source_repo: str, version: str, release_type: ReleaseType,
+                               wait_for_completion: bool, poll_interval: float) -> List[ReleaseTrigger]:
         triggers = []
         
         # Create initial trigger
@@ -131,29 +195,56 @@ class FanOutOrchestrator:
         triggers.append(initial_trigger)
         
         # Find all dependent repositories
-        dependents = self._get_all_dependents(source_repo)
+        cascade = set(self._get_all_dependents(source_repo))
+        semaphore = asyncio.Semaphore(self.max_concurrent_dispatches)
+        tasks: Dict[str, asyncio.Task] = {}
         
-        # Trigger releases in dependency order
-        for dependent in dependents:
-            try:
-                success = await self._trigger_dependent_release(
-                    dependent, source_repo, version
-                )
-                if success:
-                    trigger = ReleaseTrigger(
-                        source_repo=dependent,
-                        version=version,
-                        release_type=self.repositories[dependent].release_type,
-                        triggered_at=datetime.utcnow(),
-                        dependencies_updated=[source_repo]
-                    )
-                    triggers.append(trigger)
-                    logger.info(f"Successfully triggered release in {dependent}")
-                else:
+        async def release(dependent: str) -> Optional[ReleaseTrigger]:
+            upstream = self.dependency_graph.get(dependent, set()) & cascade
+            results = await asyncio.gather(*(tasks[dep] for dep in upstream))
+            if any(result is None for result in results):
+                logger.warning(f"Skipping {dependent}: a dependency failed to release")
+                return None
+            updated = sorted(upstream) or [source_repo]
+            with span(f"release {dependent}", repository=self.repositories[dependent].full_name,
+                      dependencies=",".join(updated)) as repo_span:
+                try:
+                    async with semaphore:
+                        with span(f"dispatch {dependent}"):
+                            success = await self._trigger_dependent_release(dependent, source_repo, version)
+                except Exception as e:
+                    logger.error(f"Error triggering release in {dependent}: {e}")
+                    repo_span.set_attribute("status", "error")
+                    return None
+                if not success:
                     logger.error(f"Failed to trigger release in {dependent}")
-                    
-            except Exception as e:
-                logger.error(f"Error triggering release in {dependent}: {e}")
+                    repo_span.set_attribute("status", "dispatch_failed")
+                    return None
+                trigger = ReleaseTrigger(
+                    source_repo=dependent,
+                    version=version,
+                    release_type=self.repositories[dependent].release_type,
+                    triggered_at=datetime.utcnow(),
+                    dependencies_updated=updated
+                )
+                logger.info(f"Successfully triggered release in {dependent}")
+                if wait_for_completion and self._dependents_in(dependent, cascade):
+                    with span(f"workflow run {dependent}"):
+                        status = await self.wait_for_release(trigger, poll_interval)
+                    repo_span.set_attribute("status", status)
+                    if status != "success":
+                        logger.error(f"Release in {dependent} finished with {status}")
+                        return None
+                return trigger
+        
+        # Tasks are created in topological order, so every task's upstream
+        # tasks exist before it first runs
+        for dependent in self._topological_order(cascade):
+            tasks[dependent] = asyncio.create_task(release(dependent))
+        for dependent, task in tasks.items():
+            trigger = await task
+            if trigger is not None:
+                triggers.append(trigger)
         
         return triggers
     
@@ -171,9 +262,28 @@ class FanOutOrchestrator:
         
         return list(dependents)
     
+    def _dependents_in(self, repo_name: str, cascade: Set[str]) -> bool:
+        return any(repo_name in self.dependency_graph.get(other, set()) for other in cascade)
+    
+    def _topological_order(self, repos: Set[str]) -> List[str]:
+        """repos ordered so that each comes after its dependencies among them"""
+        order: List[str] = []
+        remaining = set(repos)
+        while remaining:
+            ready = sorted(r for r in remaining if not (self.dependency_graph.get(r, set()) & remaining))
+            if not ready:
+                raise ValueError(f"Dependency cycle among {sorted(remaining)}")
+            order.extend(ready)
+            remaining.difference_update(ready)
+        return order
+    
     async def _trigger_dependent_release(self, dependent_repo: str, 
                                        source_repo: str, version: str) -> bool:
         """Trigger a release in a dependent repository."""
+        # PyGithub blocks; a worker thread keeps concurrent dispatches concurrent
+        return await asyncio.to_thread(self._dispatch_release_workflow, dependent_repo, source_repo, version)
+    
+    def _dispatch_release_workflow(self, dependent_repo: str, source_repo: str, version: str) -> bool:
         try:
             repo = self.github.get_repo(self.repositories[dependent_repo].full_name)
             
@@ -184,6 +294,9 @@ class FanOutOrchestrator:
                 "dependency_update": "true",
                 "triggered_by": "fan-out-orchestrator"
             }
+            context = traceparent()
+            if self.trace_input and context:
+                workflow_dispatch_inputs[self.trace_input] = context
             
             # Find the appropriate workflow to trigger
             workflows = repo.get_workflows()
@@ -285,34 +398,96 @@ This PR updates the following dependencies:
             return False
     
     async def get_release_status(self, triggers: List[ReleaseTrigger]) -> Dict[str, str]:
-        """Get the status of release triggers."""
+        """
+        Get the status of release triggers: the conclusion (or status while
+        running) of the newest workflow run created since each trigger.
+        Repositories are queried STATUS_BATCH_SIZE at a time in one GraphQL
+        request each, with the REST API as fallback.
+        """
         status = {}
         
-        for trigger in triggers:
-            try:
-                repo = self.github.get_repo(self.repositories[trigger.source_repo].full_name)
-                workflows = repo.get_workflow_runs(
-                    head_sha=trigger.triggered_at.isoformat(),
-                    per_page=10
-                )
-                
-                # Find the most recent workflow run
-                latest_run = None
-                for run in workflows:
-                    if run.created_at >= trigger.triggered_at:
-                        latest_run = run
-                        break
-                
-                if latest_run:
-                    status[trigger.source_repo] = latest_run.conclusion or latest_run.status
-                else:
-                    status[trigger.source_repo] = "not_found"
-                    
-            except Exception as e:
-                logger.error(f"Error getting status for {trigger.source_repo}: {e}")
-                status[trigger.source_repo] = "error"
+        async with httpx.AsyncClient(timeout=30.0) as client:
+            for start in range(0, len(triggers), STATUS_BATCH_SIZE):
+                batch = triggers[start:start + STATUS_BATCH_SIZE]
+                try:
+                    status.update(await self._graphql_release_status(client, batch))
+                except Exception as e:
+                    logger.warning(f"GraphQL status query failed, using REST: {e}")
+                    for trigger in batch:
+                        status[trigger.source_repo] = await asyncio.to_thread(self._rest_release_status, trigger)
+        
+        return status
+    
+    async def _graphql_release_status(self, client: "httpx.AsyncClient",
+                                      triggers: List[ReleaseTrigger]) -> Dict[str, str]:
+        fields = []
+        for i, trigger in enumerate(triggers):
+            owner, name = self.repositories[trigger.source_repo].full_name.split("/", 1)
+            fields.append(
+                f"r{i}: repository(owner: {json.dumps(owner)}, name: {json.dumps(name)}) {{"
+                " defaultBranchRef { target { ... on Commit {"
+                " checkSuites(last: 20) { nodes { status conclusion"
+                " workflowRun { createdAt } } } } } } }"
+            )
+        response = await client.post(
+            GITHUB_GRAPHQL_URL,
+            json={"query": "query { " + " ".join(fields) + " }"},
+            headers={"Authorization": f"bearer {self.github_token}"},
+        )
+        response.raise_for_status()
+        payload = response.json()
+        if payload.get("errors") and not payload.get("data"):
+            raise RuntimeError(payload["errors"][0].get("message", "GraphQL error"))
         
+        status = {}
+        for i, trigger in enumerate(triggers):
+            repo = (payload.get("data") or {}).get(f"r{i}")
+            if repo is None:
+                status[trigger.source_repo] = "error"
+                continue
+            target = (repo.get("defaultBranchRef") or {}).get("target") or {}
+            since = trigger.triggered_at.replace(tzinfo=timezone.utc)
+            latest = None
+            for suite in (target.get("checkSuites") or {}).get("nodes") or []:
+                run = suite.get("workflowRun")
+                if not run:
+                    continue
+                created = datetime.fromisoformat(run["createdAt"].replace("Z", "+00:00"))
+                if created >= since and (latest is None or created > latest[0]):
+                    latest = (created, suite)
+            if latest is None:
+                status[trigger.source_repo] = "not_found"
+            else:
+                suite = latest[1]
+                status[trigger.source_repo] = (suite.get("conclusion") or suite.get("status") or "unknown").lower()
         return status
+    
+    def _rest_release_status(self, trigger: ReleaseTrigger) -> str:
+        try:
+            repo = self.github.get_repo(self.repositories[trigger.source_repo].full_name)
+            since = trigger.triggered_at.replace(tzinfo=timezone.utc)
+            for run in repo.get_workflow_runs(event="workflow_dispatch"):
+                created = run.created_at if run.created_at.tzinfo else run.created_at.replace(tzinfo=timezone.utc)
+                if created < since:
+                    break  # Newest first
+                return run.conclusion or run.status
+            return "not_found"
+        except Exception as e:
+            logger.error(f"Error getting status for {trigger.source_repo}: {e}")
+            return "error"
+    
+    async def wait_for_release(self, trigger: ReleaseTrigger, poll_interval: float = 30.0,
+                               timeout: float = 6 * 3600) -> str:
+        """Poll get_release_status until trigger's workflow run has finished"""
+        deadline = asyncio.get_running_loop().time() + timeout
+        while True:
+            status = (await self.get_release_status([trigger]))[trigger.source_repo]
+            # A run that has not shown up yet is still starting, not missing
+            if status in TERMINAL_STATUSES and status != "not_found":
+                return status
+            if asyncio.get_running_loop().time() >= deadline:
+                return "timed_out"
+            await asyncio.sleep(poll_interval)
 
 
 class ReleaseCoordinator:
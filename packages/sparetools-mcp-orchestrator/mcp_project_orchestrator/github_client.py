@@ -0,0 +1,223 @@
+"""
+Asynchronous GitHub REST client for the ecosystem monitors
+
+One pooled httpx.AsyncClient serves every request, so scanning many
+repositories reuses a handful of keep-alive connections instead of a TLS
+handshake per call. Responses are cached on disk:
+
+- mutable listings (workflow runs) are revalidated with If-None-Match;
+  GitHub answers an unchanged listing with 304, which costs no quota;
+- immutable resources (the jobs and logs of a completed run) are served
+  from the cache without any request.
+
+Concurrency follows the rate limit: up to max_concurrency requests are in
+flight while quota is plentiful, fewer as X-RateLimit-Remaining falls
+towards min_remaining, and requests wait for X-RateLimit-Reset once it is
+reached. 403/429 responses with Retry-After (secondary limits) are retried.
+"""
+
+import asyncio
+import hashlib
+import json
+import logging
+import os
+import time
+from pathlib import Path
+from typing import Any, Dict, List, Optional
+
+import httpx
+
+logger = logging.getLogger(__name__)
+
+GITHUB_API_URL = "https://api.github.com"
+DEFAULT_CACHE_DIR = Path(os.environ.get("XDG_CACHE_HOME", Path.home() / ".cache")) / "mcp-orchestrator" / "github"
+DEFAULT_MAX_CONCURRENCY = 8
+# Requests kept in reserve for other tools sharing the token
+DEFAULT_MIN_REMAINING = 100
+# Remaining quota per concurrent request slot
+QUOTA_PER_SLOT = 50
+MAX_RETRIES = 3
+
+
+class ResponseCache:
+    """Responses by request key, one JSON file each"""
+
+    def __init__(self, cache_dir: Optional[Path]):
+        self.cache_dir = Path(cache_dir) if cache_dir else None
+
+    @staticmethod
+    def key(url: str, params: Optional[Dict[str, Any]] = None) -> str:
+        query = json.dumps(sorted((params or {}).items()), default=str)
+        return hashlib.sha256(f"{url}?{query}".encode()).hexdigest()
+
+    def _path(self, key: str) -> Path:
+        return self.cache_dir / key[:2] / f"{key}.json"
+
+    def get(self, key: str) -> Optional[Dict[str, Any]]:
+        if self.cache_dir is None:
+            return None
+        try:
+            with open(self._path(key)) as f:
+                return json.load(f)
+        except (OSError, ValueError):
+            return None
+
+    def put(self, key: str, entry: Dict[str, Any]) -> None:
+        if self.cache_dir is None:
+            return
+        path = self._path(key)
+        path.parent.mkdir(parents=True, exist_ok=True)
+        tmp = path.with_suffix(f".{os.getpid()}.{id(entry)}.tmp")
+        with open(tmp, "w") as f:
+            json.dump(entry, f)
+        os.replace(tmp, path)
+
+
+class AsyncGitHubClient:
+    """Pooled, cached and rate-limit-aware GitHub REST access (use as async context manager)"""
+
+    def __init__(self, token: str, cache_dir: Optional[Path] = DEFAULT_CACHE_DIR,
+                 max_concurrency: int = DEFAULT_MAX_CONCURRENCY,
+                 min_remaining: int = DEFAULT_MIN_REMAINING, base_url: str = GITHUB_API_URL):
+        self.token = token
+        self.base_url = base_url.rstrip("/")
+        self.cache = ResponseCache(cache_dir)
+        self.max_concurrency = max(1, max_concurrency)
+        self.min_remaining = min_remaining
+        self.remaining: Optional[int] = None
+        self.reset_at: Optional[float] = None
+        self.stats = {"requests": 0, "not_modified": 0, "cached": 0}
+        self._client: Optional[httpx.AsyncClient] = None
+        self._in_flight = 0
+        self._slots: Optional[asyncio.Condition] = None
+
+    async def __aenter__(self) -> "AsyncGitHubClient":
+        self._client = httpx.AsyncClient(
+            timeout=httpx.Timeout(30.0, read=120.0),
+            follow_redirects=True,  # Log downloads redirect to blob storage
+            limits=httpx.Limits(max_connections=self.max_concurrency,
+                                max_keepalive_connections=self.max_concurrency),
+            headers={
+                "Authorization": f"Bearer {self.token}",
+                "Accept": "application/vnd.github+json",
+                "X-GitHub-Api-Version": "2022-11-28",
+                "User-Agent": "mcp-project-orchestrator",
+            },
+        )
+        self._slots = asyncio.Condition()
+        return self
+
+    async def __aexit__(self, *exc_info) -> None:
+        await self._client.aclose()
+        self._client = None
+        logger.info(f"GitHub API: {self.stats['requests']} requests "
+                    f"({self.stats['not_modified']} not modified), {self.stats['cached']} served from cache"
+                    + (f", {self.remaining} remaining" if self.remaining is not None else ""))
+
+    # -- rate limit ---------------------------------------------------------
+
+    def _limit(self) -> int:
+        """Concurrent requests the remaining quota allows"""
+        if self.remaining is None:
+            return self.max_concurrency
+        spare = self.remaining - self.min_remaining
+        return max(1, min(self.max_concurrency, spare // QUOTA_PER_SLOT))
+
+    async def _acquire(self) -> None:
+        async with self._slots:
+            await self._slots.wait_for(lambda: self._in_flight < self._limit())
+            self._in_flight += 1
+        if self.remaining is not None and self.remaining <= self.min_remaining and self.reset_at:
+            delay = self.reset_at - time.time()
+            if delay > 0:
+                logger.warning(f"GitHub rate limit reserve reached, waiting {delay:.0f}s for reset")
+                await asyncio.sleep(delay + 1)
+                self.remaining = None
+
+    async def _release(self) -> None:
+        async with self._slots:
+            self._in_flight -= 1
+            self._slots.notify_all()
+
+    def _update_rate_limit(self, response: httpx.Response) -> None:
+        remaining = response.headers.get("X-RateLimit-Remaining")
+        if remaining is not None:
+            self.remaining = int(remaining)
+            self.reset_at = float(response.headers.get("X-RateLimit-Reset", 0)) or None
+
+    @staticmethod
+    def _retry_delay(response: httpx.Response) -> Optional[float]:
+        if response.status_code not in (403, 429):
+            return None
+        if "Retry-After" in response.headers:
+            return float(response.headers["Retry-After"])
+        if response.headers.get("X-RateLimit-Remaining") == "0":
+            return max(0.0, float(response.headers.get("X-RateLimit-Reset", 0)) - time.time()) + 1
+        return None
+
+    # -- requests -----------------------------------------------------------
+
+    async def _get(self, path: str, params: Optional[Dict[str, Any]], immutable: bool,
+                   text: bool) -> Any:
+        url = path if path.startswith("http") else f"{self.base_url}/{path.lstrip('/')}"
+        key = self.cache.key(url, params)
+        cached = self.cache.get(key)
+        if cached is not None and immutable:
+            self.stats["cached"] += 1
+            return cached["body"]
+
+        headers = {}
+        if cached is not None and cached.get("etag"):
+            headers["If-None-Match"] = cached["etag"]
+        for attempt in range(MAX_RETRIES + 1):
+            await self._acquire()
+            try:
+                self.stats["requests"] += 1
+                response = await self._client.get(url, params=params, headers=headers)
+                self._update_rate_limit(response)
+            finally:
+                await self._release()
+            delay = self._retry_delay(response)
+            if delay is None or attempt == MAX_RETRIES:
+                break
+            logger.warning(f"GitHub API throttled ({response.status_code}), retrying in {delay:.0f}s")
+            await asyncio.sleep(delay)
+
+        if response.status_code == 304 and cached is not None:
+            self.stats["not_modified"] += 1
+            return cached["body"]
+        response.raise_for_status()
+        body = response.text if text else response.json()
+        self.cache.put(key, {"etag": response.headers.get("ETag"), "fetched": time.time(), "body": body})
+        return body
+
+    def cached(self, path: str, params: Optional[Dict[str, Any]] = None) -> Optional[Any]:
+        """The cached body of a GET, without any request; None if not cached"""
+        url = path if path.startswith("http") else f"{self.base_url}/{path.lstrip('/')}"
+        entry = self.cache.get(self.cache.key(url, params))
+        return entry["body"] if entry is not None else None
+
+    async def get_json(self, path: str, params: Optional[Dict[str, Any]] = None,
+                       immutable: bool = False) -> Any:
+        """GET path (relative to the API root, or a full URL) as JSON"""
+        return await self._get(path, params, immutable, text=False)
+
+    async def get_text(self, path: str, params: Optional[Dict[str, Any]] = None,
+                       immutable: bool = False) -> str:
+        return await self._get(path, params, immutable, text=True)
+
+    async def get_items(self, path: str, item_key: str, params: Optional[Dict[str, Any]] = None,
+                        limit: Optional[int] = None, immutable: bool = False) -> List[Dict[str, Any]]:
+        """All items of a paged listing ({"total_count": n, item_key: [...]}), up to limit"""
+        params = dict(params or {}, per_page=100)
+        first = await self.get_json(path, dict(params, page=1), immutable)
+        items = list(first.get(item_key, []))
+        total = first.get("total_count", len(items))
+        pages = -(-min(total, limit or total) // 100)
+        if pages > 1:
+            # Page count is known from total_count, so the rest are fetched concurrently
+            rest = await asyncio.gather(*(self.get_json(path, dict(params, page=page), immutable)
+                                          for page in range(2, pages + 1)))
+            for page in rest:
+                items.extend(page.get(item_key, []))
+        return items[:limit] if limit else items
@@ -9,11 +9,15 @@ from pathlib import Path
 from typing import Any, Dict, List, Optional, Set
 import asyncio
 import json
+import logging
 
 from ..core import Config
+from ..catalog_index import CatalogIndex
 from .template import PromptTemplate, PromptCategory
 from .loader import PromptLoader
 
+logger = logging.getLogger(__name__)
+
 
 class PromptManager:
     """Main class for managing prompt templates."""
@@ -28,6 +32,7 @@ class PromptManager:
         self.loader = PromptLoader(config)
         self.cache: Dict[str, Dict[str, Any]] = {}
         self._templates: Dict[str, PromptTemplate] = {}
+        self._index: Optional[CatalogIndex] = None
         
     async def initialize(self) -> None:
         """Initialize the prompt manager.
@@ -240,18 +245,19 @@ class PromptManager:
         return self.loader.get_all_tags()
     
     def discover_prompts(self) -> None:
-        """Discover and load all prompt templates from the prompts directory."""
+        """Discover the prompt templates in the prompts directory.
+        
+        Only the catalog index (see catalog_index) is read; a prompt's file is
+        parsed when the prompt is first used.
+        """
         prompts_dir = self.config.settings.prompts_dir
+        self._templates.clear()
+        self._index = None
         if not prompts_dir.exists():
             return
         
-        for prompt_file in prompts_dir.rglob("*.json"):
-            try:
-                template = PromptTemplate.from_file(prompt_file)
-                self._templates[template.metadata.name] = template
-            except Exception as e:
-                # Skip invalid templates
-                pass
+        self._index = CatalogIndex.open(prompts_dir, "prompt",
+                                        validate=lambda data: bool(PromptTemplate.from_dict(data)))
     
     def list_prompts(self, category: Optional[PromptCategory] = None) -> List[str]:
         """List all available prompt templates.
@@ -262,10 +268,14 @@ class PromptManager:
         Returns:
             List of prompt names
         """
+        entries = self._index.entries if self._index else {}
         if category is None:
-            return list(self._templates.keys())
+            return list(dict.fromkeys([*entries, *self._templates]))
         
         return [
+            name for name, entry in entries.items()
+            if entry.category == str(category) and name not in self._templates
+        ] + [
             name for name, template in self._templates.items()
             if template.metadata.category == category
         ]
@@ -279,11 +289,20 @@ class PromptManager:
         Returns:
             Prompt template or None if not found
         """
+        if name not in self._templates and self._index and self._index.get(name):
+            try:
+                self._templates[name] = PromptTemplate.from_dict(self._index.body(name))
+            except (OSError, ValueError, TypeError, KeyError) as e:
+                logger.warning(f"Skipping invalid prompt template {name}: {e}")
+                self._index.discard(name)
         return self._templates.get(name)
     
     def render_prompt(self, name: str, variables: Dict[str, Any]) -> str:
         """Render a prompt template with variables.
         
+        The template's content is parsed on its first render and reused
+        until the prompt is rediscovered or its content changes.
+        
         Args:
             name: Name of the prompt template
             variables: Variables to substitute
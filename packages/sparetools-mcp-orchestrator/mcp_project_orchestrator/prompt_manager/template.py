@@ -7,9 +7,16 @@ prompt template with its metadata and rendering capabilities.
 
 from dataclasses import dataclass, field
 from enum import Enum
-from typing import Any, Dict, List, Optional, Union
+from typing import Any, Dict, List, Optional, Tuple, Union
 from pathlib import Path
 import json
+import re
+
+
+# Variables as checked for presence: {{ var }} with any spacing
+VARIABLE_PATTERN = re.compile(r'\{\{\s*(\w+)\s*\}\}')
+# Placeholders substituted on render: exactly {{ var }} or {{var}}
+PLACEHOLDER_PATTERN = re.compile(r'\{\{(?: (\w+) |(\w+))\}\}')
 
 
 class PromptCategory(Enum):
@@ -80,6 +87,8 @@ class PromptTemplate:
     metadata: PromptMetadata
     content: str
     examples: List[Dict[str, str]] = field(default_factory=list)
+    _compiled: Optional[Tuple[str, List[Union[str, Tuple[str, str]]], frozenset]] = field(
+        default=None, init=False, repr=False, compare=False)
     
     @classmethod
     def from_file(cls, path: Path) -> "PromptTemplate":
@@ -101,10 +110,25 @@ class PromptTemplate:
         with open(path) as f:
             data = json.load(f)
             
+        return cls.from_dict(data)
+        
+    @classmethod
+    def from_dict(cls, data: Dict[str, Any]) -> "PromptTemplate":
+        """Create a prompt template from its JSON representation.
+        
+        Args:
+            data: Dictionary with 'metadata', 'content' and optional 'examples'
+            
+        Returns:
+            PromptTemplate instance
+            
+        Raises:
+            ValueError: If the template is invalid
+        """
         if "metadata" not in data or "content" not in data:
             raise ValueError("Template must have 'metadata' and 'content' fields")
             
-        metadata = PromptMetadata.from_dict(data["metadata"])
+        metadata = PromptMetadata.from_dict(dict(data["metadata"]))
         return cls(metadata=metadata, content=data["content"], examples=data.get("examples", []))
         
     def render(self, variables: Dict[str, Any]) -> str:
@@ -119,14 +143,7 @@ class PromptTemplate:
         Raises:
             KeyError: If a required variable is missing
         """
-        import re
-        
-        result = self.content
-        
-        # Extract all variables from content using regex
-        # Match both {{ var }} and {{var}} patterns
-        pattern = r'\{\{\s*(\w+)\s*\}\}'
-        content_vars = set(re.findall(pattern, result))
+        segments, content_vars = self.compile()
         
         # Check if required metadata variables are provided
         for var_name, var_desc in self.metadata.variables.items():
@@ -141,15 +158,36 @@ class PromptTemplate:
                 if var_name not in variables:
                     raise KeyError(f"Missing required variable '{var_name}'")
         
-        # Substitute all provided variables
-        for var_name, var_value in variables.items():
-            # Support both {{ var }} and {{var}} formats
-            placeholder_with_spaces = f"{{{{ {var_name} }}}}"
-            placeholder_without_spaces = f"{{{{{var_name}}}}}"
-            result = result.replace(placeholder_with_spaces, str(var_value))
-            result = result.replace(placeholder_without_spaces, str(var_value))
-            
-        return result
+        # Substitute all provided variables, leaving other placeholders as they are
+        return "".join(
+            segment if isinstance(segment, str)
+            else str(variables[segment[0]]) if segment[0] in variables else segment[1]
+            for segment in segments
+        )
+        
+    def compile(self) -> Tuple[List[Union[str, Tuple[str, str]]], frozenset]:
+        """Parse the content into literal and placeholder segments.
+        
+        The result is kept until the content changes, so rendering a
+        template repeatedly parses it once.
+        
+        Returns:
+            Segments (literal strings and (variable, placeholder) pairs) and
+            the set of variables referenced by the content
+        """
+        if self._compiled is None or self._compiled[0] is not self.content:
+            segments: List[Union[str, Tuple[str, str]]] = []
+            position = 0
+            for match in PLACEHOLDER_PATTERN.finditer(self.content):
+                if match.start() > position:
+                    segments.append(self.content[position:match.start()])
+                segments.append((match.group(1) or match.group(2), match.group(0)))
+                position = match.end()
+            if position < len(self.content):
+                segments.append(self.content[position:])
+            content_vars = frozenset(VARIABLE_PATTERN.findall(self.content))
+            self._compiled = (self.content, segments, content_vars)
+        return self._compiled[1], self._compiled[2]
         
     def to_dict(self) -> Dict[str, Any]:
         """Convert the template to a dictionary.
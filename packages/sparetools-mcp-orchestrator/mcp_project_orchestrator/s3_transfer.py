@@ -0,0 +1,336 @@
+"""
+Concurrent S3 transfers that skip unchanged objects
+
+Package mirrors and benchmark corpora are many files, a few of them
+large. S3TransferManager moves them with one thread pool over files and
+boto3's multipart transfers inside each large file, so many connections
+are busy at once. Part sizes grow with the file so that large artifacts
+are not split into thousands of 8 MB parts, and never exceed S3's 10,000
+part limit.
+
+A file is only sent when it differs from the object. Sizes are compared
+first. For an equal size, the ETag S3 would have assigned is computed:
+MD5 for a single PUT, MD5 of the part MD5s plus "-N" for a multipart
+upload with the same part size. An ETag that cannot be predicted (SSE-KMS,
+or another tool's part size) falls back to the SHA-256 this manager
+stores in the object metadata (x-amz-meta-sha256). Downloads use the same
+test in reverse.
+
+Listing a large prefix is split on its first-level "directories", which
+are then paged concurrently, one paginator per sub-prefix.
+
+boto3 is imported lazily. The client is passed in, so any S3-compatible
+endpoint works.
+"""
+
+import fnmatch
+import hashlib
+import logging
+import math
+import os
+import threading
+import time
+from concurrent.futures import ThreadPoolExecutor
+from dataclasses import dataclass, field
+from typing import Any, Callable, Dict, Iterable, List, Optional, Tuple
+
+logger = logging.getLogger(__name__)
+
+MiB = 1024 * 1024
+# Single PUT below this size
+MULTIPART_THRESHOLD = 16 * MiB
+MAX_PARTS = 10000
+SHA256_METADATA = "sha256"
+DIGEST_CHUNK_SIZE = 4 * MiB
+
+
+def part_size_for(size: int) -> int:
+    """Multipart part size for an object of size bytes"""
+    if size <= 256 * MiB:
+        return 8 * MiB
+    if size <= 4096 * MiB:
+        return 32 * MiB
+    return max(64 * MiB, math.ceil(size / MAX_PARTS / MiB) * MiB)
+
+
+def expected_etag_and_sha256(path: str, part_size: Optional[int] = None,
+                             multipart: Optional[bool] = None) -> Tuple[str, str]:
+    """
+    The ETag S3 gives path when uploaded as this manager would (or as a
+    multipart upload with part_size), and its SHA-256, from one read
+    """
+    size = os.path.getsize(path)
+    if multipart is None:
+        multipart = size >= MULTIPART_THRESHOLD
+    part_size = part_size or part_size_for(size)
+    sha256 = hashlib.sha256()
+    whole_md5 = hashlib.md5()
+    part_md5s: List[bytes] = []
+    part = hashlib.md5()
+    in_part = 0
+    with open(path, 'rb') as f:
+        for chunk in iter(lambda: f.read(DIGEST_CHUNK_SIZE), b''):
+            sha256.update(chunk)
+            if not multipart:
+                whole_md5.update(chunk)
+                continue
+            view = memoryview(chunk)
+            while view:
+                take = min(len(view), part_size - in_part)
+                part.update(view[:take])
+                in_part += take
+                view = view[take:]
+                if in_part == part_size:
+                    part_md5s.append(part.digest())
+                    part, in_part = hashlib.md5(), 0
+    if not multipart:
+        return whole_md5.hexdigest(), sha256.hexdigest()
+    if in_part:
+        part_md5s.append(part.digest())
+    return f"{hashlib.md5(b''.join(part_md5s)).hexdigest()}-{len(part_md5s)}", sha256.hexdigest()
+
+
+def _etag_part_count(etag: str) -> Optional[int]:
+    etag = etag.strip('"')
+    if '-' not in etag:
+        return None
+    try:
+        return int(etag.rsplit('-', 1)[1])
+    except ValueError:
+        return None
+
+
+@dataclass
+class TransferReport:
+    """Outcome of a transfer or sync"""
+    transferred: List[str] = field(default_factory=list)
+    skipped: List[str] = field(default_factory=list)
+    deleted: List[str] = field(default_factory=list)
+    failed: Dict[str, str] = field(default_factory=dict)
+    bytes_transferred: int = 0
+    seconds: float = 0.0
+
+    @property
+    def throughput_mb_s(self) -> float:
+        return self.bytes_transferred / MiB / self.seconds if self.seconds else 0.0
+
+    def summary(self) -> Dict[str, Any]:
+        return {
+            "transferred": len(self.transferred),
+            "skipped": len(self.skipped),
+            "deleted": len(self.deleted),
+            "failed": len(self.failed),
+            "bytes_transferred": self.bytes_transferred,
+            "seconds": round(self.seconds, 2),
+            "throughput_mb_s": round(self.throughput_mb_s, 1),
+        }
+
+
+class S3TransferManager:
+    """Concurrent multipart uploads, downloads and directory syncs for one S3 client"""
+
+    def __init__(self, client, max_concurrency: int = 32):
+        self.client = client
+        self.max_concurrency = max(1, max_concurrency)
+
+    # Configuration
+
+    def _transfer_config(self, size: int, part_concurrency: int):
+        from boto3.s3.transfer import TransferConfig
+        part_size = part_size_for(size)
+        return TransferConfig(multipart_threshold=MULTIPART_THRESHOLD, multipart_chunksize=part_size,
+                              max_concurrency=part_concurrency, use_threads=part_concurrency > 1)
+
+    def _pools(self, count: int) -> Tuple[int, int]:
+        """(file workers, part threads per file): many small files or a few large ones"""
+        file_workers = max(1, min(self.max_concurrency, count))
+        return file_workers, max(2, self.max_concurrency // file_workers)
+
+    # Listing
+
+    def _paginate(self, bucket: str, prefix: str, delimiter: Optional[str] = None):
+        params = {"Bucket": bucket, "Prefix": prefix}
+        if delimiter:
+            params["Delimiter"] = delimiter
+        for page in self.client.get_paginator('list_objects_v2').paginate(**params):
+            yield page
+
+    def list_objects(self, bucket: str, prefix: str = "") -> List[Dict[str, Any]]:
+        """Every object under prefix, first-level sub-prefixes listed concurrently"""
+        objects: List[Dict[str, Any]] = []
+        sub_prefixes: List[str] = []
+        for page in self._paginate(bucket, prefix, delimiter='/'):
+            objects.extend(page.get('Contents', []))
+            sub_prefixes.extend(p['Prefix'] for p in page.get('CommonPrefixes', []))
+        if not sub_prefixes:
+            return objects
+
+        def list_all(sub_prefix: str) -> List[Dict[str, Any]]:
+            return [obj for page in self._paginate(bucket, sub_prefix) for obj in page.get('Contents', [])]
+
+        with ThreadPoolExecutor(max_workers=min(self.max_concurrency, len(sub_prefixes))) as pool:
+            for listed in pool.map(list_all, sub_prefixes):
+                objects.extend(listed)
+        return objects
+
+    # Change detection
+
+    def _remote_sha256(self, bucket: str, key: str) -> Optional[str]:
+        try:
+            return self.client.head_object(Bucket=bucket, Key=key).get('Metadata', {}).get(SHA256_METADATA)
+        except Exception:
+            return None
+
+    def is_unchanged(self, path: str, bucket: str, key: str, remote: Optional[Dict[str, Any]]) -> bool:
+        """Whether the object (a listing or head_object entry) already holds path's content"""
+        if remote is None:
+            return False
+        size = os.path.getsize(path)
+        if remote.get('Size', remote.get('ContentLength')) != size:
+            return False
+        etag = str(remote.get('ETag', '')).strip('"')
+        parts = _etag_part_count(etag)
+        part_size = None
+        if parts is not None:
+            # Our part size if it gives the same part count, else the equal split it implies
+            part_size = part_size_for(size)
+            if max(1, math.ceil(size / part_size)) != parts:
+                part_size = math.ceil(size / parts / MiB) * MiB
+        local_etag, local_sha256 = expected_etag_and_sha256(path, part_size, multipart=parts is not None)
+        if local_etag == etag:
+            return True
+        metadata = remote.get('Metadata')
+        remote_sha256 = metadata.get(SHA256_METADATA) if metadata is not None else self._remote_sha256(bucket, key)
+        return remote_sha256 == local_sha256
+
+    # Transfers
+
+    def upload_file(self, path: str, bucket: str, key: str, skip_unchanged: bool = True,
+                    remote: Optional[Dict[str, Any]] = None, part_concurrency: Optional[int] = None,
+                    extra_args: Optional[Dict[str, Any]] = None) -> bool:
+        """Upload path unless the object matches; True if it was sent"""
+        if skip_unchanged:
+            if remote is None:
+                try:
+                    remote = self.client.head_object(Bucket=bucket, Key=key)
+                except Exception:
+                    remote = None
+            if self.is_unchanged(path, bucket, key, remote):
+                return False
+        size = os.path.getsize(path)
+        args = dict(extra_args or {})
+        args['Metadata'] = dict(args.get('Metadata', {}), **{SHA256_METADATA: _sha256(path)})
+        self.client.upload_file(path, bucket, key, ExtraArgs=args,
+                                Config=self._transfer_config(size, part_concurrency or self.max_concurrency))
+        return True
+
+    def download_file(self, bucket: str, key: str, path: str, skip_unchanged: bool = True,
+                      remote: Optional[Dict[str, Any]] = None, part_concurrency: Optional[int] = None) -> bool:
+        """Download the object unless path already matches; True if it was fetched"""
+        if remote is None:
+            remote = self.client.head_object(Bucket=bucket, Key=key)
+        if skip_unchanged and os.path.isfile(path) and self.is_unchanged(path, bucket, key, remote):
+            return False
+        os.makedirs(os.path.dirname(os.path.abspath(path)), exist_ok=True)
+        size = remote.get('Size', remote.get('ContentLength', 0))
+        temporary = f"{path}.part-{os.getpid()}"
+        self.client.download_file(bucket, key, temporary,
+                                  Config=self._transfer_config(size, part_concurrency or self.max_concurrency))
+        os.replace(temporary, path)
+        return True
+
+    @staticmethod
+    def _local_files(root: str, exclude: Iterable[str]) -> Dict[str, str]:
+        """relative POSIX path -> absolute path for files under root"""
+        files = {}
+        patterns = list(exclude)
+        for directory, dirs, names in os.walk(root):
+            dirs.sort()
+            for name in sorted(names):
+                path = os.path.join(directory, name)
+                relative = os.path.relpath(path, root).replace(os.sep, '/')
+                if not any(fnmatch.fnmatch(relative, p) for p in patterns):
+                    files[relative] = path
+        return files
+
+    def _run(self, items: List, work: Callable, report: TransferReport, label: Callable):
+        file_workers, part_concurrency = self._pools(len(items))
+        start = time.monotonic()
+        lock = threading.Lock()
+
+        def run(item):
+            try:
+                sent, size = work(item, part_concurrency)
+                with lock:
+                    (report.transferred if sent else report.skipped).append(label(item))
+                    if sent:
+                        report.bytes_transferred += size
+            except Exception as e:
+                with lock:
+                    report.failed[label(item)] = str(e)
+                logger.error(f"Transfer of {label(item)} failed: {e}")
+
+        with ThreadPoolExecutor(max_workers=file_workers) as pool:
+            list(pool.map(run, items))
+        report.seconds += time.monotonic() - start
+
+    def sync_to_s3(self, local_dir: str, bucket: str, prefix: str = "", delete: bool = False,
+                   exclude: Iterable[str] = (), extra_args: Optional[Dict[str, Any]] = None) -> TransferReport:
+        """Upload new and changed files under local_dir to s3://bucket/prefix"""
+        report = TransferReport()
+        prefix = prefix.rstrip('/') + '/' if prefix else ''
+        local = self._local_files(local_dir, exclude)
+        remote = {obj['Key'][len(prefix):]: obj for obj in self.list_objects(bucket, prefix)}
+        # Large files first, so they are not the tail of the batch
+        items = sorted(local.items(), key=lambda item: -os.path.getsize(item[1]))
+
+        def upload(item, part_concurrency):
+            relative, path = item
+            sent = self.upload_file(path, bucket, prefix + relative, remote=remote.get(relative),
+                                    part_concurrency=part_concurrency, extra_args=extra_args,
+                                    skip_unchanged=relative in remote)
+            return sent, os.path.getsize(path)
+
+        self._run(items, upload, report, lambda item: item[0])
+        if delete:
+            stale = [prefix + relative for relative in remote if relative not in local]
+            for start in range(0, len(stale), 1000):
+                batch = stale[start:start + 1000]
+                self.client.delete_objects(Bucket=bucket, Delete={'Objects': [{'Key': k} for k in batch],
+                                                                  'Quiet': True})
+                report.deleted.extend(batch)
+        return report
+
+    def sync_from_s3(self, bucket: str, prefix: str, local_dir: str, delete: bool = False,
+                     exclude: Iterable[str] = ()) -> TransferReport:
+        """Download new and changed objects under s3://bucket/prefix into local_dir"""
+        report = TransferReport()
+        prefix = prefix.rstrip('/') + '/' if prefix else ''
+        patterns = list(exclude)
+        remote = {obj['Key'][len(prefix):]: obj for obj in self.list_objects(bucket, prefix)
+                  if not obj['Key'].endswith('/')}
+        remote = {k: v for k, v in remote.items() if not any(fnmatch.fnmatch(k, p) for p in patterns)}
+        # Large objects first, so they are not the tail of the batch
+        items = sorted(remote.items(), key=lambda item: -item[1].get('Size', 0))
+
+        def download(item, part_concurrency):
+            relative, obj = item
+            path = os.path.join(local_dir, *relative.split('/'))
+            return self.download_file(bucket, prefix + relative, path, remote=obj,
+                                      part_concurrency=part_concurrency), obj.get('Size', 0)
+
+        self._run(items, download, report, lambda item: item[0])
+        if delete:
+            for relative, path in self._local_files(local_dir, patterns).items():
+                if relative not in remote:
+                    os.remove(path)
+                    report.deleted.append(relative)
+        return report
+
+
+def _sha256(path: str) -> str:
+    hasher = hashlib.sha256()
+    with open(path, 'rb') as f:
+        for chunk in iter(lambda: f.read(DIGEST_CHUNK_SIZE), b''):
+            hasher.update(chunk)
+    return hasher.hexdigest()
@@ -0,0 +1,458 @@
+"""
+Persistent shell sessions for agent tools
+
+Running every command in a fresh shell pays shell startup, profile
+sourcing and environment setup (activating the Conan virtualenv, module
+loads) each time; for an agent issuing dozens of short commands that is
+most of the wall time. A ShellSessionPool keeps named bash sessions alive
+on pseudo-terminals instead: the profile and setup run once per session,
+and cd/export/activate in one command carry over to the next.
+
+Commands are written to a script file that the session sources with
+stdin from /dev/null, so quoting, multi-line scripts and a command that
+waits for input cannot wedge the shell. Completion is detected by a
+per-session marker line carrying the exit code and working directory.
+Output is streamed line by line to an optional callback while it is
+collected. A command past its timeout is interrupted (SIGINT); if the
+session does not recover, it is killed and the next call gets a new one.
+Sessions idle longer than idle_timeout are reaped by a background thread.
+
+POSIX only (pty).
+"""
+
+import atexit
+import codecs
+import fcntl
+import logging
+import os
+import pty
+import select
+import shlex
+import shutil
+import signal
+import subprocess
+import tempfile
+import termios
+import threading
+import time
+import uuid
+from dataclasses import dataclass
+from typing import Callable, Dict, List, Optional
+
+logger = logging.getLogger(__name__)
+
+DEFAULT_TIMEOUT = 120.0
+DEFAULT_IDLE_TIMEOUT = 600.0
+DEFAULT_MAX_SESSIONS = 8
+# Output kept per command; the rest is still streamed
+DEFAULT_MAX_OUTPUT = 1 << 20
+# Time an interrupted command gets to return to the prompt
+INTERRUPT_GRACE = 2.0
+
+# Prompt, echo, history and job control off: the terminal only carries output
+_SETUP = "stty -echo; set +m; PS1=''; PS2=''; PROMPT_COMMAND=''; unset HISTFILE"
+
+
+class ShellSessionError(Exception):
+    """A session could not be started, or died"""
+
+
+@dataclass
+class ShellResult:
+    """Outcome of one command"""
+    session: str
+    exit_code: Optional[int]
+    output: str
+    cwd: str
+    seconds: float
+    timed_out: bool = False
+    truncated: bool = False
+    # The shell exited (e.g. `exit` in the command); the session is gone
+    session_closed: bool = False
+
+
+class ShellSession:
+    """One bash process on a pseudo-terminal, running one command at a time"""
+
+    def __init__(self, name: str, cwd: Optional[str] = None, env: Optional[Dict[str, str]] = None,
+                 shell: str = "bash", login: bool = True, init: Optional[List[str]] = None):
+        self.name = name
+        self.cwd = os.path.abspath(cwd or os.getcwd())
+        self.lock = threading.Lock()
+        self.last_used = time.monotonic()
+        self.commands = 0
+        self._marker = f"__MCP_SESSION_DONE_{uuid.uuid4().hex}__"
+        self._dir = tempfile.mkdtemp(prefix="mcp-shell-")
+        self._script = os.path.join(self._dir, "command.sh")
+
+        child_env = dict(os.environ, TERM="dumb")
+        child_env.update(env or {})
+        argv = [shutil.which(shell) or shell, "--noediting"] + (["--login"] if login else [])
+        master, slave = pty.openpty()
+        try:
+            self._proc = subprocess.Popen(
+                argv, stdin=slave, stdout=slave, stderr=slave, cwd=self.cwd, env=child_env,
+                start_new_session=True, close_fds=True,
+                # Make the pty the controlling terminal, so SIGINT reaches the foreground job
+                preexec_fn=lambda: fcntl.ioctl(0, termios.TIOCSCTTY, 0))
+        except OSError as e:
+            os.close(master)
+            shutil.rmtree(self._dir, ignore_errors=True)
+            raise ShellSessionError(f"Cannot start {argv[0]}: {e}") from e
+        finally:
+            os.close(slave)
+        self._fd = master
+        self._decoder = codecs.getincrementaldecoder("utf-8")(errors="replace")
+
+        # Profile banners and the echo of the setup line are dropped
+        setup = [_SETUP] + list(init or [])
+        result = self._execute("\n".join(setup), DEFAULT_TIMEOUT, None, DEFAULT_MAX_OUTPUT, raw=True)
+        if result.exit_code is None:
+            self.close()
+            raise ShellSessionError(f"Session '{name}' did not start: {result.output[-500:]}")
+        logger.info(f"Started shell session '{name}' (pid {self._proc.pid}) in {self.cwd}")
+
+    @property
+    def alive(self) -> bool:
+        return self._fd is not None and self._proc.poll() is None
+
+    def run(self, command: str, timeout: float = DEFAULT_TIMEOUT,
+            on_output: Optional[Callable[[str], None]] = None,
+            max_output: int = DEFAULT_MAX_OUTPUT) -> ShellResult:
+        """Run a command in this session; the caller holds self.lock"""
+        if not self.alive:
+            raise ShellSessionError(f"Session '{self.name}' is closed")
+        with open(self._script, "w") as f:
+            f.write(command + "\n")
+        self.commands += 1
+        try:
+            return self._execute(f". {shlex.quote(self._script)} </dev/null", timeout, on_output, max_output)
+        finally:
+            self.last_used = time.monotonic()
+
+    def _execute(self, line: str, timeout: float, on_output: Optional[Callable[[str], None]],
+                 max_output: int, raw: bool = False) -> ShellResult:
+        # Separate lines: an interrupted command aborts only the first
+        os.write(self._fd, (f"{line}\n__mcp_rc=$?; printf '\\n{self._marker}%s %s\\n' "
+                            f"\"$__mcp_rc\" \"$PWD\"\n").encode())
+        start = time.monotonic()
+        deadline = start + timeout
+        chunks: List[str] = []
+        kept = 0
+        truncated = timed_out = False
+        pending = ""           # Text not yet split into lines
+        deferred_newline = False  # The last line's newline; the final one is the marker's
+        done: Optional[str] = None
+
+        def emit(text: str) -> None:
+            nonlocal kept, truncated
+            if not text:
+                return
+            room = max_output - kept
+            if room > 0:
+                chunks.append(text[:room])
+                kept += len(chunks[-1])
+            truncated = truncated or len(text) > room
+            if on_output is not None and not raw:
+                on_output(text)
+
+        while done is None:
+            now = time.monotonic()
+            if now >= deadline:
+                if timed_out:
+                    break
+                timed_out = True
+                self._interrupt()
+                deadline = now + INTERRUPT_GRACE
+            ready, _, _ = select.select([self._fd], [], [], min(deadline - now, 0.5))
+            if not ready:
+                continue
+            try:
+                data = os.read(self._fd, 65536)
+            except OSError:
+                data = b""
+            if not data:
+                break  # EIO/EOF: the shell exited
+            pending += self._decoder.decode(data)
+            # The pty turns \n into \r\n; keep a trailing \r until its \n arrives
+            pending = pending.replace("\r\n", "\n")
+            *lines, pending = pending.split("\n")
+            for text in lines:
+                if text.startswith(self._marker):
+                    done = text[len(self._marker):]
+                    break
+                emit(("\n" if deferred_newline else "") + text.rstrip("\r"))
+                deferred_newline = True
+            # Stream partial lines (progress bars, prompts) unless they may be the marker
+            if done is None and pending and not pending.endswith("\r") \
+                    and not self._marker.startswith(pending) and not pending.startswith(self._marker):
+                emit(("\n" if deferred_newline else "") + pending)
+                deferred_newline = False
+                pending = ""
+
+        exit_code, closed = None, False
+        if done is not None:
+            rc, _, cwd = done.partition(" ")
+            exit_code = int(rc) if rc.lstrip("-").isdigit() else None
+            self.cwd = cwd or self.cwd
+        else:
+            closed = True
+            if self._proc.poll() is None:
+                self.close()
+            exit_code = self._proc.poll()
+        return ShellResult(session=self.name, exit_code=exit_code, output="".join(chunks),
+                           cwd=self.cwd, seconds=round(time.monotonic() - start, 3),
+                           timed_out=timed_out, truncated=truncated, session_closed=closed)
+
+    def _interrupt(self) -> None:
+        try:
+            os.killpg(os.tcgetpgrp(self._fd), signal.SIGINT)
+        except OSError:
+            pass
+
+    def close(self) -> None:
+        """Kill the shell and everything it started"""
+        if self._proc.poll() is None:
+            try:
+                os.killpg(self._proc.pid, signal.SIGKILL)
+            except OSError:
+                pass
+            self._proc.wait()
+        if self._fd is not None:
+            os.close(self._fd)
+            self._fd = None
+        shutil.rmtree(self._dir, ignore_errors=True)
+
+
+class ShellSessionPool:
+    """
+    Named persistent shell sessions, created on first use.
+
+    Each session runs one command at a time; calls to different sessions
+    run in parallel. At most max_sessions are kept: a new one evicts the
+    least recently used idle session, and fails if all are busy.
+    """
+
+    def __init__(self, max_sessions: int = DEFAULT_MAX_SESSIONS,
+                 idle_timeout: float = DEFAULT_IDLE_TIMEOUT, shell: str = "bash",
+                 login: bool = True, init: Optional[List[str]] = None,
+                 env: Optional[Dict[str, str]] = None):
+        """
+        Args:
+            max_sessions: Sessions kept alive at once
+            idle_timeout: Seconds after which an unused session is closed (0: never)
+            shell: The shell to run (bash compatible)
+            login: Start login shells, so the profile is sourced (once per session)
+            init: Commands run when a session starts, e.g. sourcing conanbuild.sh
+            env: Environment added to every session
+        """
+        self.max_sessions = max_sessions
+        self.idle_timeout = idle_timeout
+        self.shell = shell
+        self.login = login
+        self.init = list(init or [])
+        self.env = dict(env or {})
+        self._sessions: Dict[str, ShellSession] = {}
+        self._starting: Dict[str, threading.Lock] = {}
+        self._reserved = 0  # Sessions being started
+        self._lock = threading.Lock()
+        self._stop = threading.Event()
+        self._reaper: Optional[threading.Thread] = None
+        atexit.register(self.close_all)
+
+    def run(self, command: str, session: str = "default", cwd: Optional[str] = None,
+            env: Optional[Dict[str, str]] = None, timeout: float = DEFAULT_TIMEOUT,
+            on_output: Optional[Callable[[str], None]] = None,
+            max_output: int = DEFAULT_MAX_OUTPUT) -> ShellResult:
+        """
+        Run a command in a session, starting the session if needed.
+
+        Args:
+            command: Shell command or script
+            session: Session name; state (cwd, variables) persists per name
+            cwd: Directory to change to first (stays the session's directory)
+            env: Variables to export first (stay in the session)
+            timeout: Seconds before the command is interrupted
+            on_output: Called with output text as it arrives
+            max_output: Characters of output kept in the result
+
+        Returns:
+            The command's ShellResult
+        """
+        prefix = [f"export {key}={shlex.quote(str(value))}" for key, value in (env or {}).items()]
+        if cwd:
+            prefix.append(f"cd -- {shlex.quote(cwd)} || return")
+        script = "\n".join(prefix + [command])
+
+        shell = self._acquire(session, cwd)
+        try:
+            result = shell.run(script, timeout=timeout, on_output=on_output, max_output=max_output)
+        finally:
+            shell.lock.release()
+        if not shell.alive:
+            with self._lock:
+                if self._sessions.get(session) is shell:
+                    del self._sessions[session]
+            shell.close()
+        return result
+
+    def _acquire(self, name: str, cwd: Optional[str]) -> ShellSession:
+        """The session, locked for the caller; started if missing or dead"""
+        while True:
+            with self._lock:
+                shell = self._sessions.get(name)
+                if shell is not None and not shell.alive:
+                    del self._sessions[name]
+                    shell.close()
+                    shell = None
+                if shell is None:
+                    # Sessions start outside the pool lock, one at a time per name
+                    starting = self._starting.setdefault(name, threading.Lock())
+            if shell is None:
+                with starting:
+                    with self._lock:
+                        shell = self._sessions.get(name)
+                        if shell is None:
+                            self._make_room()
+                            self._reserved += 1
+                    if shell is None:
+                        try:
+                            shell = ShellSession(name, cwd=cwd, env=self.env, shell=self.shell,
+                                                 login=self.login, init=self.init)
+                        finally:
+                            with self._lock:
+                                self._reserved -= 1
+                        with self._lock:
+                            self._sessions[name] = shell
+                            self._start_reaper()
+            shell.lock.acquire()
+            if shell.alive:
+                return shell
+            shell.lock.release()
+
+    def _make_room(self) -> None:
+        """Close the least recently used idle session if the pool is full; caller holds _lock"""
+        if len(self._sessions) + self._reserved < self.max_sessions:
+            return
+        for name, shell in sorted(self._sessions.items(), key=lambda item: item[1].last_used):
+            if shell.lock.acquire(blocking=False):
+                del self._sessions[name]
+                shell.close()
+                shell.lock.release()
+                logger.info(f"Evicted shell session '{name}'")
+                return
+        raise ShellSessionError(f"All {self.max_sessions} shell sessions are busy")
+
+    def _start_reaper(self) -> None:
+        if self._reaper is None and self.idle_timeout > 0:
+            self._reaper = threading.Thread(target=self._reap, name="shell-session-reaper", daemon=True)
+            self._reaper.start()
+
+    def _reap(self) -> None:
+        while not self._stop.wait(max(self.idle_timeout / 4, 1.0)):
+            self.reap_idle()
+
+    def reap_idle(self) -> int:
+        """Close sessions idle longer than idle_timeout; returns how many"""
+        cutoff = time.monotonic() - self.idle_timeout
+        reaped = []
+        with self._lock:
+            for name, shell in list(self._sessions.items()):
+                if (shell.last_used < cutoff or not shell.alive) and shell.lock.acquire(blocking=False):
+                    del self._sessions[name]
+                    shell.close()
+                    shell.lock.release()
+                    reaped.append(name)
+        for name in reaped:
+            logger.info(f"Reaped idle shell session '{name}'")
+        return len(reaped)
+
+    def sessions(self) -> List[Dict[str, object]]:
+        """Name, pid, cwd, commands run and idle seconds of each session"""
+        now = time.monotonic()
+        with self._lock:
+            return [{"session": name, "pid": shell._proc.pid, "cwd": shell.cwd,
+                     "commands": shell.commands, "busy": shell.lock.locked(),
+                     "idle_seconds": round(now - shell.last_used, 1)}
+                    for name, shell in self._sessions.items()]
+
+    def close(self, name: str) -> bool:
+        """Close one session (waiting for its command); False if there is none"""
+        with self._lock:
+            shell = self._sessions.pop(name, None)
+        if shell is None:
+            return False
+        with shell.lock:
+            shell.close()
+        return True
+
+    def close_all(self) -> None:
+        self._stop.set()
+        with self._lock:
+            sessions, self._sessions = list(self._sessions.values()), {}
+        for shell in sessions:
+            shell.close()
+
+
+def register_shell_tools(mcp_server, pool: Optional[ShellSessionPool] = None) -> ShellSessionPool:
+    """
+    Register persistent shell tools with a FastMCP server instance.
+
+    Args:
+        mcp_server: FastMCP server instance
+        pool: Session pool to use (default: a new one)
+
+    Returns:
+        The pool backing the tools
+    """
+    pool = pool or ShellSessionPool()
+
+    @mcp_server.tool(
+        name="shell_run",
+        description="Run a bash command in a persistent named session (cwd, variables and "
+                    "activated environments carry over between calls); output streams as progress"
+    )
+    def shell_run(command: str, session: str = "default", cwd: str = "",
+                  timeout: float = DEFAULT_TIMEOUT, progress=None) -> str:
+        """Run a command in a persistent shell session."""
+        lines = 0
+
+        def stream(text: str) -> None:
+            nonlocal lines
+            lines += text.count("\n")
+            if progress is not None:
+                progress(lines, message=text)
+
+        result = pool.run(command, session=session, cwd=cwd or None, timeout=timeout, on_output=stream)
+        status = f"exit {result.exit_code}"
+        if result.timed_out:
+            status += ", timed out"
+        if result.session_closed:
+            status += ", session closed"
+        if result.truncated:
+            status += ", output truncated"
+        return f"{result.output}\n[{status}; {result.seconds}s; cwd {result.cwd}]"
+
+    @mcp_server.tool(
+        name="shell_sessions",
+        description="List the persistent shell sessions"
+    )
+    def shell_sessions() -> str:
+        """List shell sessions."""
+        sessions = pool.sessions()
+        if not sessions:
+            return "No shell sessions."
+        return "\n".join(f"- {s['session']} (pid {s['pid']}): {s['cwd']}, {s['commands']} commands, "
+                         f"{'busy' if s['busy'] else 'idle ' + str(s['idle_seconds']) + 's'}"
+                         for s in sessions)
+
+    @mcp_server.tool(
+        name="shell_close",
+        description="Close a persistent shell session"
+    )
+    def shell_close(session: str = "default") -> str:
+        """Close a shell session."""
+        return f"Closed session '{session}'" if pool.close(session) else f"No session '{session}'"
+
+    logger.info("Shell session tools registered successfully")
+    return pool
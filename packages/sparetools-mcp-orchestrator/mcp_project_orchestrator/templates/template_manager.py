@@ -6,16 +6,23 @@ This module manages the retrieval, selection, and application of project templat
 and component templates. It loads templates from JSON files, allows selection 
 based on design patterns, applies templates by creating the project structure, 
 and generates basic documentation.
+
+Template files are read through a CatalogIndex: names, versions,
+inheritance and the fields used for selection come from the index, and a
+template's body is parsed when it is first used. Resolved (inheritance-merged) templates and the file contents generated
+for their components are cached until the templates are reloaded, which
+the watch_templates() hook does whenever a template file changes.
 """
 
 import os
-import json
 import re
 from typing import Any, Dict, List, Optional, Tuple
 from dataclasses import dataclass
 from datetime import datetime
 from pathlib import Path
 
+from ..catalog_index import CatalogIndex
+
 @dataclass
 class TemplateVersion:
     """Represents a template version with metadata."""
@@ -35,6 +42,16 @@ class TemplateVersion:
     def __str__(self) -> str:
         return f"{self.major}.{self.minor}.{self.patch}"
 
+# Directories created in every generated project
+PROJECT_DIRECTORIES = [
+    os.path.join("src", "components"),
+    os.path.join("src", "interfaces"),
+    os.path.join("src", "services"),
+    os.path.join("src", "utils"),
+    "tests",
+    "docs",
+]
+
 class TemplateManager:
     """
     Manager for project and component templates.
@@ -45,6 +62,9 @@ class TemplateManager:
         component_templates: List of component templates loaded from JSON.
         template_versions: Dictionary mapping template names to their versions.
         template_inheritance: Dictionary tracking template inheritance relationships.
+        
+    Templates returned by get_template_with_inheritance() are cached and shared;
+    callers must not modify them.
     """
     
     def __init__(self, templates_path: Optional[str] = None) -> None:
@@ -59,8 +79,10 @@ class TemplateManager:
         self.templates_path = templates_path
         self.template_versions: Dict[str, TemplateVersion] = {}
         self.template_inheritance: Dict[str, List[str]] = {}
-        self.project_templates = self._load_templates("project_templates.json")
-        self.component_templates = self._load_templates("component_templates.json")
+        self._resolved: Dict[str, Optional[Dict[str, Any]]] = {}
+        self._compiled: Dict[str, List[Tuple[str, str]]] = {}
+        self._project_index = self._load_templates("project_templates.json")
+        self._component_index = self._load_templates("component_templates.json")
     
     def _validate_template(self, template: Dict[str, Any]) -> Tuple[bool, str]:
         """
@@ -95,15 +117,17 @@ class TemplateManager:
                 
         return True, ""
 
-    def _load_templates(self, filename: str) -> List[Dict[str, Any]]:
+    def _load_templates(self, filename: str) -> Optional[CatalogIndex]:
         """
-        Load templates from the specified JSON file.
+        Index templates from the specified JSON file.
+        
+        Only valid templates are indexed; their bodies are parsed on first access.
         
         Args:
             filename: The JSON file name to load templates from.
         
         Returns:
-            A list of template dictionaries. If file not found or error occurs, returns an empty list.
+            The catalog index of the first file with valid templates, or None.
         """
         paths_to_try = [
             self.templates_path if self.templates_path else filename,
@@ -113,37 +137,45 @@ class TemplateManager:
         ]
         
         for path in paths_to_try:
-            if os.path.exists(path):
-                try:
-                    with open(path, "r") as f:
-                        templates = json.load(f)
-                    if not isinstance(templates, list):
-                        continue
-                        
-                    # Validate and process each template
-                    valid_templates = []
-                    for template in templates:
-                        is_valid, error = self._validate_template(template)
-                        if is_valid:
-                            # Process version
-                            name = template["project_name"]
-                            version = template.get("version", "0.1.0")
-                            self.template_versions[name] = TemplateVersion.from_string(version)
-                            
-                            # Process inheritance
-                            if "extends" in template:
-                                parent = template["extends"]
-                                if parent not in self.template_inheritance:
-                                    self.template_inheritance[parent] = []
-                                self.template_inheritance[parent].append(name)
-                                
-                            valid_templates.append(template)
-                            
-                    return valid_templates
-                except (json.JSONDecodeError, OSError):
+            if os.path.isfile(path):
+                index = CatalogIndex.open(Path(path), "template",
+                                          validate=lambda template: self._validate_template(template)[0])
+                if not index.entries:
                     continue
                     
-        return []
+                for name, entry in index.entries.items():
+                    # Process version
+                    self.template_versions[name] = TemplateVersion.from_string(entry.version)
+                    
+                    # Process inheritance
+                    if "extends" in entry.extra:
+                        parent = entry.extra["extends"]
+                        if parent not in self.template_inheritance:
+                            self.template_inheritance[parent] = []
+                        self.template_inheritance[parent].append(name)
+                        
+                return index
+                    
+        return None
+    
+    @staticmethod
+    def _all_templates(index: Optional[CatalogIndex]) -> List[Dict[str, Any]]:
+        return [index.body(name) for name in index.names()] if index else []
+    
+    @property
+    def project_templates(self) -> List[Dict[str, Any]]:
+        """Project templates (parses every body; prefer lookups by name)."""
+        return self._all_templates(self._project_index)
+    
+    @property
+    def component_templates(self) -> List[Dict[str, Any]]:
+        """Component templates (parses every body; prefer lookups by name)."""
+        return self._all_templates(self._component_index)
+    
+    def _project_template(self, template_name: str) -> Optional[Dict[str, Any]]:
+        if self._project_index is None or self._project_index.get(template_name) is None:
+            return None
+        return self._project_index.body(template_name)
 
     def get_template_version(self, template_name: str) -> Optional[TemplateVersion]:
         """
@@ -232,7 +264,10 @@ class TemplateManager:
         Returns:
             The merged template dictionary if found, None otherwise.
         """
-        template = next((t for t in self.project_templates if t["project_name"] == template_name), None)
+        if template_name in self._resolved:
+            return self._resolved[template_name]
+            
+        template = self._project_template(template_name)
         if not template:
             return None
             
@@ -243,14 +278,49 @@ class TemplateManager:
             if parent:
                 template = self._merge_templates(template, parent)
                 
+        self._resolved[template_name] = template
         return template
+    
+    def _component_files(self, template_name: str) -> Optional[List[Tuple[str, str]]]:
+        """
+        Get the placeholder files generated for a template's components.
+        
+        Args:
+            template_name: Name of the template.
+            
+        Returns:
+            (path relative to the project root, content) pairs, or None if the
+            template is not found.
+        """
+        if template_name in self._compiled:
+            return self._compiled[template_name]
+            
+        template = self.get_template_with_inheritance(template_name)
+        if not template:
+            return None
+            
+        files = []
+        for comp in template.get("components", []):
+            comp_name = comp.get("name", "Component")
+            # Interface, implementation and service placeholder files
+            files.append((os.path.join("src", "interfaces", f"i_{comp_name.lower()}.py"),
+                          f"# TODO: Define interface methods for {comp_name}\nclass I{comp_name}:\n    pass\n"))
+            files.append((os.path.join("src", "components", f"{comp_name.lower()}.py"),
+                          f"# TODO: Implement {comp_name} logic\nclass {comp_name}:\n    pass\n"))
+            files.append((os.path.join("src", "services", f"{comp_name.lower()}_service.py"),
+                          f"# TODO: Implement service logic for {comp_name}\n"))
+            
+        self._compiled[template_name] = files
+        return files
 
     def reload_templates(self) -> None:
         """Reload all templates from disk."""
         self.template_versions.clear()
         self.template_inheritance.clear()
-        self.project_templates = self._load_templates("project_templates.json")
-        self.component_templates = self._load_templates("component_templates.json")
+        self._resolved.clear()
+        self._compiled.clear()
+        self._project_index = self._load_templates("project_templates.json")
+        self._component_index = self._load_templates("component_templates.json")
 
     def watch_templates(self, callback: Optional[callable] = None) -> None:
         """
@@ -303,35 +373,36 @@ class TemplateManager:
         best_match = None
         max_score = -1
         
-        for template in self.project_templates:
+        entries = list(self._project_index.entries.values()) if self._project_index else []
+        for entry in entries:
             score = 0
             
             # Score based on keyword matches
-            keywords = template.get("keywords", [])
+            keywords = entry.tags
             for pattern in patterns:
                 if pattern in keywords:
                     score += 2
                     
             # Score based on description similarity
-            template_desc = template.get("description", "").lower()
+            template_desc = entry.extra.get("description", "").lower()
             description = description.lower()
             common_words = set(template_desc.split()) & set(description.split())
             score += len(common_words)
             
             # Check inheritance - templates that are more specialized (inherit from others) get a bonus
-            if "extends" in template:
+            if "extends" in entry.extra:
                 score += 1
                 
             if score > max_score:
                 max_score = score
-                best_match = template
+                best_match = entry
                 
         if best_match:
-            return best_match.get("project_name", "DefaultProject")
+            return best_match.name
             
         # Fallback to first template if available
-        if self.project_templates:
-            return self.project_templates[0].get("project_name", "DefaultProject")
+        if entries:
+            return entries[0].name
             
         return "DefaultProject"
     
@@ -350,9 +421,8 @@ class TemplateManager:
         Returns:
             A dictionary containing the project path and a success message; otherwise, error details.
         """
-        # Find the template by matching project_name
-        template = next((t for t in self.project_templates if t.get("project_name") == template_name), None)
-        if not template:
+        files = self._component_files(template_name)
+        if files is None:
             return {"error": f"Template '{template_name}' not found."}
         
         project_path = os.path.join(output_dir, project_name)
@@ -361,38 +431,43 @@ class TemplateManager:
         
         try:
             # Create project structure directories
-            os.makedirs(os.path.join(project_path, "src", "components"), exist_ok=True)
-            os.makedirs(os.path.join(project_path, "src", "interfaces"), exist_ok=True)
-            os.makedirs(os.path.join(project_path, "src", "services"), exist_ok=True)
-            os.makedirs(os.path.join(project_path, "src", "utils"), exist_ok=True)
-            os.makedirs(os.path.join(project_path, "tests"), exist_ok=True)
-            os.makedirs(os.path.join(project_path, "docs"), exist_ok=True)
+            for directory in PROJECT_DIRECTORIES:
+                os.makedirs(os.path.join(project_path, directory), exist_ok=True)
             
-            # Generate placeholder files for each component defined in the template
-            components = template.get("components", [])
-            for comp in components:
-                comp_name = comp.get("name", "Component")
-                # Create interface file
-                interface_path = os.path.join(project_path, "src", "interfaces", f"i_{comp_name.lower()}.py")
-                with open(interface_path, "w") as f:
-                    f.write(f"# TODO: Define interface methods for {comp_name}\nclass I{comp_name}:\n    pass\n")
-                # Create implementation file
-                impl_path = os.path.join(project_path, "src", "components", f"{comp_name.lower()}.py")
-                with open(impl_path, "w") as f:
-                    f.write(f"# TODO: Implement {comp_name} logic\nclass {comp_name}:\n    pass\n")
-                # Create service file (optional placeholder)
-                service_path = os.path.join(project_path, "src", "services", f"{comp_name.lower()}_service.py")
-                with open(service_path, "w") as f:
-                    f.write(f"# TODO: Implement service logic for {comp_name}\n")
+            # Write the placeholder files for each component defined in the template
+            for relative_path, content in files:
+                with open(os.path.join(project_path, relative_path), "w") as f:
+                    f.write(content)
+            if files:
                 # Create a basic README file
-                readme_path = os.path.join(project_path, "README.md")
-                with open(readme_path, "w") as f:
+                with open(os.path.join(project_path, "README.md"), "w") as f:
                     f.write(f"# {project_name}\n\n{description}\n")
             
             return {"project_path": project_path, "message": "Project created successfully."}
         except Exception as e:
             return {"error": str(e)}
     
+    def apply_templates(self, projects: List[Dict[str, Any]], output_dir: str) -> List[Dict[str, Any]]:
+        """
+        Apply templates for many projects in one pass.
+        
+        Each template is resolved and its component files generated once, however
+        many projects use it.
+        
+        Args:
+            projects: Dictionaries with the apply_template arguments
+                      (template_name, project_name, description and optionally patterns).
+            output_dir: Directory where the projects will be created.
+        
+        Returns:
+            One apply_template result per project, in order.
+        """
+        return [
+            self.apply_template(project["template_name"], project["project_name"],
+                                project.get("description", ""), project.get("patterns", []), output_dir)
+            for project in projects
+        ]
+    
     def generate_documentation(self, project_path: str) -> str:
         """
         Generate documentation for the project at the given path.
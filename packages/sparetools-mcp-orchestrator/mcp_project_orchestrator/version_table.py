@@ -0,0 +1,328 @@
+"""
+Ecosystem version table
+
+Collects, for every repository of the release fan-out, the latest GitHub
+release (or tag), the version declared in its conanfile.py and version
+file, the versions it pins its ecosystem dependencies at, and the newest
+version found on each configured Conan remote. The fan-out tooling reads
+the table to see what a cascade would move and which pins are stale.
+
+All sources are fetched concurrently. GitHub goes through
+AsyncGitHubClient (one connection pool, rate-limit aware); Conan remotes
+share one httpx client of their own, so the GitHub token is never sent to
+a registry. Both revalidate cached responses with If-None-Match, so an
+unchanged source answers 304 and a repeated dry run costs almost nothing.
+Rows are reported as they complete: aggregate() calls on_row with the
+table so far, and the CLI rewrites its output files each time.
+"""
+
+import asyncio
+import base64
+import json
+import logging
+import os
+import re
+import time
+from dataclasses import asdict, dataclass, field
+from pathlib import Path
+from typing import Any, Callable, Dict, Iterable, List, Optional, Tuple
+
+import httpx
+
+from .github_client import AsyncGitHubClient, DEFAULT_CACHE_DIR, DEFAULT_MAX_CONCURRENCY, ResponseCache
+
+logger = logging.getLogger(__name__)
+
+DEFAULT_REGISTRY_CACHE_DIR = DEFAULT_CACHE_DIR.parent / "registries"
+
+_CONANFILE_VERSION = re.compile(r"^\s*version\s*=\s*[\"']([^\"']+)[\"']", re.MULTILINE)
+_VERSION_DAT_FIELD = re.compile(r"^\s*(MAJOR|MINOR|PATCH|PRE_RELEASE_TAG)\s*=\s*(\S*)", re.MULTILINE)
+
+
+@dataclass
+class VersionRow:
+    """Versions of one repository, from every source that has one"""
+    repository: str
+    full_name: str
+    release_type: str
+    release: Optional[str] = None
+    conanfile_version: Optional[str] = None
+    version_file: Optional[str] = None
+    # Ecosystem dependency -> version its conanfile requires
+    pins: Dict[str, str] = field(default_factory=dict)
+    # Conan remote -> newest version published there
+    registries: Dict[str, str] = field(default_factory=dict)
+    errors: List[str] = field(default_factory=list)
+    seconds: float = 0.0
+
+    @property
+    def version(self) -> Optional[str]:
+        """The repository's current version: released, else declared"""
+        tag = self.release.lstrip("v") if self.release else None
+        return tag or self.conanfile_version or self.version_file
+
+
+def version_key(version: str) -> Tuple:
+    """Sort key for dotted versions; numeric parts compare as numbers"""
+    parts = re.split(r"[.\-+]", version.lstrip("v"))
+    return tuple((0, int(p), "") if p.isdigit() else (1, 0, p) for p in parts)
+
+
+class VersionTable:
+    """Rows by repository, with staleness derived from the rows present so far"""
+
+    def __init__(self, repositories: Iterable[str]):
+        self.order = list(repositories)
+        self.rows: Dict[str, VersionRow] = {}
+
+    def add(self, row: VersionRow) -> None:
+        self.rows[row.repository] = row
+
+    @property
+    def complete(self) -> bool:
+        return all(name in self.rows for name in self.order)
+
+    def issues(self, row: VersionRow) -> List[str]:
+        """Disagreements between the row's sources, and pins behind their dependency"""
+        found = []
+        declared = row.conanfile_version or row.version_file
+        if row.release and declared and row.release.lstrip("v") != declared:
+            found.append(f"release {row.release} != declared {declared}")
+        for dependency, pinned in sorted(row.pins.items()):
+            upstream = self.rows.get(dependency)
+            current = upstream.version if upstream else None
+            if current and version_key(pinned) < version_key(current):
+                found.append(f"pins {dependency} {pinned} < {current}")
+        for remote, published in sorted(row.registries.items()):
+            if row.version and version_key(published) < version_key(row.version):
+                found.append(f"{remote} has {published}")
+        return found
+
+    def to_dict(self) -> Dict[str, Any]:
+        return {
+            "complete": self.complete,
+            "repositories": [dict(asdict(self.rows[name]), version=self.rows[name].version,
+                                  issues=self.issues(self.rows[name]))
+                             for name in self.order if name in self.rows],
+            "pending": [name for name in self.order if name not in self.rows],
+        }
+
+    def to_markdown(self) -> str:
+        remotes = sorted({remote for row in self.rows.values() for remote in row.registries})
+        header = ["Repository", "Release", "conanfile", "Version file", "Pins"] + remotes + ["Issues"]
+        lines = ["| " + " | ".join(header) + " |", "|" + "---|" * len(header)]
+        for name in self.order:
+            row = self.rows.get(name)
+            if row is None:
+                lines.append(f"| {name} | " + " | ".join(["…"] * (len(header) - 1)) + " |")
+                continue
+            pins = ", ".join(f"{dep} {ver}" for dep, ver in sorted(row.pins.items()))
+            issues = "; ".join(self.issues(row) + row.errors)
+            cells = [name, row.release or "-", row.conanfile_version or "-", row.version_file or "-",
+                     pins or "-"] + [row.registries.get(r, "-") for r in remotes] + [issues or "ok"]
+            lines.append("| " + " | ".join(cells) + " |")
+        return "\n".join(lines) + "\n"
+
+    def write(self, markdown: Optional[Path] = None, json_path: Optional[Path] = None) -> None:
+        """Replace the output files atomically, so readers never see half a table"""
+        for path, text in ((markdown, self.to_markdown),
+                           (json_path, lambda: json.dumps(self.to_dict(), indent=2) + "\n")):
+            if path is None:
+                continue
+            path = Path(path)
+            path.parent.mkdir(parents=True, exist_ok=True)
+            tmp = path.with_suffix(path.suffix + f".{os.getpid()}.tmp")
+            tmp.write_text(text())
+            os.replace(tmp, path)
+
+
+class RegistryClient:
+    """Anonymous, cached GETs against Conan remotes (use as async context manager)"""
+
+    def __init__(self, cache_dir: Optional[Path] = DEFAULT_REGISTRY_CACHE_DIR,
+                 max_concurrency: int = DEFAULT_MAX_CONCURRENCY):
+        self.cache = ResponseCache(cache_dir)
+        self.max_concurrency = max(1, max_concurrency)
+        self.stats = {"requests": 0, "not_modified": 0}
+        self._client: Optional[httpx.AsyncClient] = None
+
+    async def __aenter__(self) -> "RegistryClient":
+        self._client = httpx.AsyncClient(
+            timeout=30.0, follow_redirects=True,
+            limits=httpx.Limits(max_connections=self.max_concurrency,
+                                max_keepalive_connections=self.max_concurrency),
+            headers={"User-Agent": "mcp-project-orchestrator"})
+        return self
+
+    async def __aexit__(self, *exc_info) -> None:
+        await self._client.aclose()
+        self._client = None
+
+    async def get_json(self, url: str, params: Optional[Dict[str, Any]] = None) -> Any:
+        key = self.cache.key(url, params)
+        cached = self.cache.get(key)
+        headers = {"If-None-Match": cached["etag"]} if cached and cached.get("etag") else {}
+        self.stats["requests"] += 1
+        response = await self._client.get(url, params=params, headers=headers)
+        if response.status_code == 304 and cached is not None:
+            self.stats["not_modified"] += 1
+            return cached["body"]
+        response.raise_for_status()
+        body = response.json()
+        self.cache.put(key, {"etag": response.headers.get("ETag"), "fetched": time.time(), "body": body})
+        return body
+
+    async def latest_conan_version(self, remote_url: str, package: str) -> Optional[str]:
+        """Newest version of package on a Conan v2 remote (conan_server, Artifactory)"""
+        body = await self.get_json(f"{remote_url.rstrip('/')}/v2/conans/search", {"q": f"{package}/*"})
+        versions = [ref.split("@")[0].split("/", 1)[1] for ref in body.get("results", [])
+                    if ref.split("/", 1)[0] == package and "/" in ref]
+        return max(versions, key=version_key) if versions else None
+
+
+def parse_conanfile(text: str, dependencies: Iterable[str]) -> Tuple[Optional[str], Dict[str, str]]:
+    """The declared version and the versions required of the given dependencies"""
+    match = _CONANFILE_VERSION.search(text)
+    pins = {}
+    for dependency in dependencies:
+        pin = re.search(rf"[\"']{re.escape(dependency)}/([^@\"'#\s]+)", text)
+        if pin:
+            pins[dependency] = pin.group(1)
+    return (match.group(1) if match else None), pins
+
+
+def parse_version_dat(text: str) -> Optional[str]:
+    """OpenSSL's VERSION.dat as MAJOR.MINOR.PATCH[-PRE_RELEASE_TAG]"""
+    fields = {name: value.strip("\"'") for name, value in _VERSION_DAT_FIELD.findall(text)}
+    if not all(fields.get(part) for part in ("MAJOR", "MINOR", "PATCH")):
+        return None
+    version = f"{fields['MAJOR']}.{fields['MINOR']}.{fields['PATCH']}"
+    return f"{version}-{fields['PRE_RELEASE_TAG']}" if fields.get("PRE_RELEASE_TAG") else version
+
+
+class VersionAggregator:
+    """Builds the VersionTable for the fan-out's repositories (RepositoryInfo)"""
+
+    def __init__(self, github_token: str, repositories: Dict[str, Any],
+                 conan_remotes: Optional[Dict[str, str]] = None,
+                 cache_dir: Optional[Path] = DEFAULT_CACHE_DIR,
+                 registry_cache_dir: Optional[Path] = DEFAULT_REGISTRY_CACHE_DIR,
+                 max_concurrency: int = DEFAULT_MAX_CONCURRENCY):
+        self.github_token = github_token
+        self.repositories = repositories
+        self.conan_remotes = dict(conan_remotes or {})
+        self.cache_dir = cache_dir
+        self.registry_cache_dir = registry_cache_dir
+        self.max_concurrency = max_concurrency
+
+    async def aggregate(self, on_row: Optional[Callable[[VersionRow, VersionTable], None]] = None) -> VersionTable:
+        """Fetch every repository concurrently; on_row(row, table) as each completes"""
+        table = VersionTable(self.repositories)
+        async with AsyncGitHubClient(self.github_token, self.cache_dir, self.max_concurrency) as github, \
+                RegistryClient(self.registry_cache_dir, self.max_concurrency) as registry:
+            pending = [asyncio.create_task(self._collect(github, registry, info))
+                       for info in self.repositories.values()]
+            for finished in asyncio.as_completed(pending):
+                row = await finished
+                table.add(row)
+                if on_row is not None:
+                    on_row(row, table)
+            logger.info(f"Conan remotes: {registry.stats['requests']} requests "
+                        f"({registry.stats['not_modified']} not modified)")
+        return table
+
+    async def _collect(self, github: AsyncGitHubClient, registry: RegistryClient, info: Any) -> VersionRow:
+        start = time.monotonic()
+        row = VersionRow(repository=info.name, full_name=info.full_name,
+                         release_type=getattr(info.release_type, "value", str(info.release_type)))
+        ecosystem = [dep for dep in self.repositories if dep != info.name]
+
+        async def guarded(label: str, fetch) -> Any:
+            try:
+                return await fetch
+            except httpx.HTTPStatusError as e:
+                if e.response.status_code != 404:
+                    row.errors.append(f"{label}: HTTP {e.response.status_code}")
+            except (httpx.HTTPError, ValueError, KeyError) as e:
+                row.errors.append(f"{label}: {e}")
+            return None
+
+        fetches = [guarded("release", self._release(github, info.full_name)),
+                   guarded("conanfile", self._file(github, info.full_name, info.conanfile_path))]
+        if info.version_file:
+            fetches.append(guarded("version file", self._file(github, info.full_name, info.version_file)))
+        fetches += [guarded(f"remote {remote}", registry.latest_conan_version(url, info.name))
+                    for remote, url in sorted(self.conan_remotes.items())]
+        results = await asyncio.gather(*fetches)
+
+        row.release = results[0]
+        if results[1]:
+            row.conanfile_version, row.pins = parse_conanfile(results[1], ecosystem)
+        rest = results[2:]
+        if info.version_file:
+            row.version_file = parse_version_dat(rest[0]) if rest[0] else None
+            rest = rest[1:]
+        for remote, published in zip(sorted(self.conan_remotes), rest):
+            if published:
+                row.registries[remote] = published
+        row.seconds = round(time.monotonic() - start, 3)
+        return row
+
+    @staticmethod
+    async def _release(github: AsyncGitHubClient, full_name: str) -> Optional[str]:
+        """The latest release's tag, else the newest tag"""
+        try:
+            return (await github.get_json(f"repos/{full_name}/releases/latest"))["tag_name"]
+        except httpx.HTTPStatusError as e:
+            if e.response.status_code != 404:
+                raise
+        tags = await github.get_json(f"repos/{full_name}/tags", {"per_page": 1})
+        return tags[0]["name"] if tags else None
+
+    @staticmethod
+    async def _file(github: AsyncGitHubClient, full_name: str, path: str) -> str:
+        body = await github.get_json(f"repos/{full_name}/contents/{path}")
+        return base64.b64decode(body["content"]).decode("utf-8", errors="replace")
+
+
+def main(argv: Optional[List[str]] = None) -> int:
+    import argparse
+
+    parser = argparse.ArgumentParser(description="Aggregate versions across the OpenSSL ecosystem")
+    parser.add_argument("--markdown", type=Path, help="Markdown table, rewritten as rows arrive")
+    parser.add_argument("--json", type=Path, dest="json_path", help="JSON table, rewritten as rows arrive")
+    parser.add_argument("--remote", action="append", default=[], metavar="NAME=URL",
+                        help="Conan remote to look up published versions on (repeatable)")
+    parser.add_argument("--max-concurrency", type=int, default=DEFAULT_MAX_CONCURRENCY)
+    parser.add_argument("--no-cache", action="store_true", help="Do not read or write the response cache")
+    args = parser.parse_args(argv)
+
+    token = os.environ.get("GITHUB_TOKEN")
+    if not token:
+        parser.error("GITHUB_TOKEN is not set")
+    remotes = dict(spec.split("=", 1) for spec in args.remote if "=" in spec)
+
+    from .fan_out_orchestrator import FanOutOrchestrator
+    aggregator = VersionAggregator(token, FanOutOrchestrator(token).repositories, remotes,
+                                   cache_dir=None if args.no_cache else DEFAULT_CACHE_DIR,
+                                   registry_cache_dir=None if args.no_cache else DEFAULT_REGISTRY_CACHE_DIR,
+                                   max_concurrency=args.max_concurrency)
+
+    def report(row: VersionRow, table: VersionTable) -> None:
+        issues = table.issues(row) + row.errors
+        print(f"{row.repository:28} {row.version or '-':14} {row.seconds:6.2f}s  "
+              f"{'; '.join(issues) if issues else 'ok'}", flush=True)
+        table.write(args.markdown, args.json_path)
+
+    table = asyncio.run(aggregator.aggregate(report))
+    # Pins are judged against rows that arrived later, so the final files are complete
+    table.write(args.markdown, args.json_path)
+    if not args.markdown and not args.json_path:
+        print()
+        print(table.to_markdown(), end="")
+    return 0
+
+
+if __name__ == "__main__":
+    logging.basicConfig(level=logging.INFO)
+    raise SystemExit(main())
@@ -1,7 +1,7 @@
 from conan import ConanFile
 from conan.tools.gnu import Autotools, AutotoolsToolchain
 from conan.tools.layout import basic_layout
-from conan.tools.files import get
+from conan.tools.files import get, rmdir
 import os
 
 class SpareToolsOpenSSLAutotools(ConanFile):
@@ -17,12 +17,16 @@ class SpareToolsOpenSSLAutotools(ConanFile):
     options = {
         "shared": [True, False],
         "fPIC": [True, False],
+        "docs": [True, False],
     }
     default_options = {
         "shared": False,
         "fPIC": True,
+        "docs": False,
     }
     
+    python_requires = "sparetools-base/2.0.0"
+    
     def layout(self):
         basic_layout(self)
     
@@ -50,10 +54,28 @@ class SpareToolsOpenSSLAutotools(ConanFile):
         autotools.configure(args=configure_args)
         autotools.make()
         autotools.make(args=["test"], ignore_errors=True)
+        self._stage_install(autotools)
+    
+    @property
+    def _stage(self):
+        return os.path.join(self.build_folder, "stage")
+    
+    def _stage_install(self, autotools):
+        """
+        Install into a DESTDIR stage with the same parallel make as the
+        build, and only what the Perl recipe installs: install_sw and
+        install_ssldirs, plus install_docs (man/html pages) with docs=True.
+        Autotools.install() would run a serial docs-included `make install`.
+        """
+        rmdir(self, self._stage)
+        targets = ["install_sw", "install_ssldirs"] + (["install_docs"] if self.options.docs else [])
+        autotools.make(target=" ".join(targets), args=[f"DESTDIR={self._stage}"])
     
     def package(self):
-        autotools = Autotools(self)
-        autotools.install()
+        base = self.python_requires["sparetools-base"].module
+        base.promote_staged_install(self, base.staged_root(self._stage, self.package_folder),
+                                    docs=bool(self.options.docs))
+        base.write_artifact_manifest(self)
     
     def package_info(self):
         self.cpp_info.libs = ["ssl", "crypto"]
@@ -1,61 +1,208 @@
 from conan import ConanFile
 from conan.tools.cmake import CMake, CMakeToolchain, cmake_layout
-from conan.tools.files import copy, get
+from conan.tools.files import copy, get, rmdir, save
+import glob
+import json
 import os
+import time
 
 class SpareToolsOpenSSLCMake(ConanFile):
     """OpenSSL built with CMake (if supported)"""
     name = "sparetools-openssl-cmake"
     version = "3.3.2"
-    
+
     package_type = "library"
     description = "OpenSSL built with CMake build system"
     license = "Apache-2.0"
-    
+
     settings = "os", "arch", "compiler", "build_type"
     options = {
         "shared": [True, False],
         "fPIC": [True, False],
+        "ninja": [True, False],
+        "unity_build": [True, False],
+        "precompiled_headers": [True, False],
+        "docs": [True, False],
     }
     default_options = {
         "shared": False,
         "fPIC": True,
+        "ninja": True,
+        "unity_build": False,
+        "precompiled_headers": False,
+        "docs": False,
     }
-    
+
+    python_requires = "sparetools-base/2.0.0"
+
+    # Headers nearly every libcrypto/libssl source pulls in, besides internal/*.h
+    _pch_headers = ["openssl/evp.h", "openssl/ssl.h"]
+
     def layout(self):
         cmake_layout(self)
-    
+
+    def build_requirements(self):
+        if self.options.ninja:
+            self.tool_requires("ninja/1.12.1")
+
     def source(self):
-        get(self, 
+        get(self,
             "https://github.com/openssl/openssl/archive/refs/tags/openssl-3.3.2.tar.gz",
             strip_root=True)
-    
+
+    @property
+    def _has_cmake(self):
+        return os.path.exists(os.path.join(self.source_folder, "CMakeLists.txt"))
+
+    @property
+    def _unity_batch_size(self):
+        """Sources per unity unit, user.sparetools:unity_batch_size (default 16)"""
+        return self.conf.get("user.sparetools:unity_batch_size", default=16, check_type=int)
+
+    @property
+    def _build_times_file(self):
+        """
+        JSON of build wall times per method, user.sparetools:build_times_file
+        (default: the build folder). Point CMake and Perl builds at one file
+        to have the recipe print their delta.
+        """
+        return self.conf.get("user.sparetools:build_times_file", check_type=str,
+                             default=os.path.join(self.build_folder, "sparetools-build-times.json"))
+
     def generate(self):
         tc = CMakeToolchain(self)
+        if self.options.ninja:
+            tc.generator = "Ninja"
         tc.variables["BUILD_SHARED_LIBS"] = self.options.shared
         tc.variables["CMAKE_INSTALL_PREFIX"] = self.package_folder
+        if self.options.unity_build:
+            tc.cache_variables["CMAKE_UNITY_BUILD"] = True
+            tc.cache_variables["CMAKE_UNITY_BUILD_BATCH_SIZE"] = self._unity_batch_size
+        if self.options.precompiled_headers:
+            tc.cache_variables["CMAKE_PROJECT_INCLUDE"] = self._write_pch_include()
         tc.generate()
-    
+
+    def _write_pch_include(self):
+        """
+        CMake snippet that gives every library target a precompiled header
+        of internal/*.h, openssl/evp.h and openssl/ssl.h. It is injected with
+        CMAKE_PROJECT_INCLUDE so the upstream lists stay untouched, and it
+        runs deferred, once the whole tree has declared its targets.
+        """
+        include_dir = os.path.join(self.source_folder, "include")
+        headers = sorted(glob.glob(os.path.join(include_dir, "internal", "*.h")))
+        headers += [os.path.join(include_dir, h) for h in self._pch_headers]
+        headers = "\n".join(f'    "{h}"' for h in
+                            (h.replace("\\", "/") for h in headers if os.path.exists(h)))
+        path = os.path.join(self.generators_folder, "sparetools_pch.cmake")
+        save(self, path, f"""\
+get_property(_sparetools_pch_done GLOBAL PROPERTY SPARETOOLS_PCH_DEFERRED)
+if(NOT _sparetools_pch_done)
+  set_property(GLOBAL PROPERTY SPARETOOLS_PCH_DEFERRED TRUE)
+  set(SPARETOOLS_PCH_HEADERS
+{headers})
+
+  function(_sparetools_apply_pch dir)
+    get_property(targets DIRECTORY "${{dir}}" PROPERTY BUILDSYSTEM_TARGETS)
+    foreach(target IN LISTS targets)
+      get_target_property(type ${{target}} TYPE)
+      if(type MATCHES "^(STATIC|SHARED|MODULE|OBJECT)_LIBRARY$")
+        foreach(header IN LISTS SPARETOOLS_PCH_HEADERS)
+          target_precompile_headers(${{target}} PRIVATE "$<$<COMPILE_LANGUAGE:C>:${{header}}>")
+        endforeach()
+      endif()
+    endforeach()
+    get_property(subdirs DIRECTORY "${{dir}}" PROPERTY SUBDIRECTORIES)
+    foreach(subdir IN LISTS subdirs)
+      _sparetools_apply_pch("${{subdir}}")
+    endforeach()
+  endfunction()
+
+  cmake_language(DEFER DIRECTORY "${{CMAKE_SOURCE_DIR}}" CALL _sparetools_apply_pch "${{CMAKE_SOURCE_DIR}}")
+endif()
+""")
+        return path.replace("\\", "/")
+
     def build(self):
         """Try CMake build, fallback to Perl Configure if needed"""
-        cmake_dir = self.source_folder / "cmake"
-        
-        if cmake_dir.exists():
-            # OpenSSL has CMake support
+        start = time.monotonic()
+        if self._has_cmake:
             cmake = CMake(self)
             cmake.configure()
             cmake.build()
             cmake.test()
+            method = "cmake"
         else:
             # Fallback to Perl Configure
-            self.output.warn("CMake not available, using Perl Configure")
-            self.run("perl Configure linux-x86_64 no-shared --prefix=%s" % self.package_folder)
+            self.output.warning("CMake not available, using Perl Configure")
+            for option in ("unity_build", "precompiled_headers"):
+                if self.options.get_safe(option):
+                    self.output.warning(f"{option} has no effect on the Perl Configure fallback")
+            configure = os.path.join(self.source_folder, "Configure")
+            self.run(f'perl "{configure}" linux-x86_64 no-shared --prefix="{self.package_folder}"')
             self.run(f"make -j{os.cpu_count() or 4}")
-    
+            method = "perl"
+        self._record_build_time(method, time.monotonic() - start)
+        self._stage_install()
+
+    @property
+    def _stage(self):
+        return os.path.join(self.build_folder, "stage")
+
+    def _stage_install(self):
+        """
+        Install into a stage under the build folder so package() is a
+        rename. The Perl fallback runs what the Perl recipe does (a
+        parallel `make install_sw install_ssldirs`, install_docs only with
+        docs=True, into DESTDIR). CMake installs to the stage prefix and
+        promote_staged_install drops the doc folders unless docs is set.
+        """
+        rmdir(self, self._stage)
+        if self._has_cmake:
+            build_type = self.settings.build_type
+            self.run(f'cmake --install "{self.build_folder}" --config {build_type} --prefix "{self._stage}"')
+        else:
+            targets = "install_sw install_ssldirs" + (" install_docs" if self.options.docs else "")
+            self.run(f'make -j{os.cpu_count() or 4} DESTDIR="{self._stage}" {targets}')
+
+    @property
+    def _staged_root(self):
+        if self._has_cmake:
+            return self._stage
+        return self.python_requires["sparetools-base"].module.staged_root(self._stage, self.package_folder)
+
+    def _record_build_time(self, method, seconds):
+        """
+        Keep the wall time of this build next to the last build of the
+        other method and print the delta, so a CMake build is compared with
+        a Perl Configure build of the same machine and job count.
+        """
+        try:
+            with open(self._build_times_file) as f:
+                times = json.load(f)
+        except (OSError, ValueError):
+            times = {}
+        key = method
+        if method == "cmake":
+            key += "".join(f"+{option}" for option in ("ninja", "unity_build", "precompiled_headers")
+                           if self.options.get_safe(option))
+        times[key] = {"seconds": round(seconds, 1), "jobs": os.cpu_count() or 4}
+        save(self, self._build_times_file, json.dumps(times, indent=2, sort_keys=True))
+        self.output.info(f"Build time ({key}): {seconds:.1f}s")
+        perl = times.get("perl")
+        if method == "cmake" and perl:
+            delta = seconds - perl["seconds"]
+            self.output.info(f"Build time vs Perl Configure: {delta:+.1f}s "
+                             f"({seconds / max(perl['seconds'], 0.1):.2f}x)")
+
     def package(self):
-        cmake = CMake(self)
-        cmake.install()
-    
+        self.python_requires["sparetools-base"].module.promote_staged_install(
+            self, self._staged_root, docs=bool(self.options.docs))
+        if os.path.exists(self._build_times_file):
+            copy(self, os.path.basename(self._build_times_file), os.path.dirname(self._build_times_file),
+                 os.path.join(self.package_folder, "res"))
+        self.python_requires["sparetools-base"].module.write_artifact_manifest(self)
+
     def package_info(self):
         self.cpp_info.libs = ["ssl", "crypto"]
         self.cpp_info.libdirs = ["lib"]
@@ -0,0 +1,46 @@
+from conan import ConanFile
+from conan.tools.build import check_min_cppstd
+from conan.tools.files import copy
+from conan.tools.layout import basic_layout
+import os
+
+
+class SpareToolsOpenSSLCxxConan(ConanFile):
+    """Header-only C++17 RAII handles and pooled EVP contexts for sparetools-openssl."""
+
+    name = "sparetools-openssl-cxx"
+    version = "3.3.2"
+
+    package_type = "header-library"
+    description = "Move-only RAII handles and thread-local EVP context pools for sparetools-openssl"
+    license = "Apache-2.0"
+    url = "https://github.com/sparesparrow/sparetools"
+    topics = ("openssl", "c++17", "raii", "header-only")
+
+    settings = "os", "arch", "compiler", "build_type"
+    exports_sources = "include/*"
+    no_copy_source = True
+
+    def layout(self):
+        basic_layout(self)
+
+    def requirements(self):
+        # Consumers include <openssl/*.h> through our headers and link libcrypto/libssl
+        self.requires(f"sparetools-openssl/{self.version}", transitive_headers=True, transitive_libs=True)
+
+    def validate(self):
+        check_min_cppstd(self, 17)
+
+    def package_id(self):
+        self.info.clear()
+
+    def package(self):
+        copy(self, "*.hpp", src=os.path.join(self.source_folder, "include"),
+             dst=os.path.join(self.package_folder, "include"))
+
+    def package_info(self):
+        self.cpp_info.set_property("cmake_file_name", "sparetools-openssl-cxx")
+        self.cpp_info.set_property("cmake_target_name", "SpareTools::openssl-cxx")
+        self.cpp_info.bindirs = []
+        self.cpp_info.libdirs = []
+        self.cpp_info.requires = ["sparetools-openssl::crypto", "sparetools-openssl::ssl"]
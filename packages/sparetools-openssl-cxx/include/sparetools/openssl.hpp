@@ -0,0 +1,16 @@
+#ifndef SPARETOOLS_OPENSSL_HPP
+#define SPARETOOLS_OPENSSL_HPP
+
+/**
+ * sparetools-openssl-cxx: header-only C++17 wrappers for sparetools-openssl
+ *
+ * - handles.hpp: move-only RAII handles (MdCtx, CipherCtx, PkeyCtx, Pkey,
+ *   SslCtx, Ssl) and the Error exception
+ * - pool.hpp: thread-local pools of reset-and-reused digest and cipher
+ *   contexts (md_pool, cipher_pool)
+ */
+
+#include <sparetools/openssl/handles.hpp>
+#include <sparetools/openssl/pool.hpp>
+
+#endif /* SPARETOOLS_OPENSSL_HPP */
@@ -0,0 +1,190 @@
+#ifndef SPARETOOLS_OPENSSL_HANDLES_HPP
+#define SPARETOOLS_OPENSSL_HANDLES_HPP
+
+/**
+ * Move-only RAII handles for libcrypto/libssl objects
+ *
+ * Each handle owns one object and frees it with the matching *_free
+ * function. Handles cannot be copied (OpenSSL's up_ref semantics differ
+ * per type and are better made explicit); get() passes the raw pointer to
+ * OpenSSL calls and release() hands ownership back to C code.
+ *
+ * Constructors that allocate throw sparetools::openssl::Error, carrying
+ * the OpenSSL error queue, when the allocation fails.
+ */
+
+#include <openssl/err.h>
+#include <openssl/evp.h>
+#include <openssl/ssl.h>
+
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+namespace sparetools {
+namespace openssl {
+
+/** Failure of an OpenSSL call; code() is the first error on the queue */
+class Error : public std::runtime_error {
+public:
+    Error(const std::string &what, unsigned long code)
+        : std::runtime_error(what), code_(code) {}
+
+    unsigned long code() const noexcept { return code_; }
+
+private:
+    unsigned long code_;
+};
+
+/** Throw an Error for a failed call, draining the thread's error queue */
+[[noreturn]] inline void throw_last_error(const char *call) {
+    unsigned long code = ERR_get_error();
+    std::string what = std::string(call) + " failed";
+    if (code != 0) {
+        char reason[256];
+        ERR_error_string_n(code, reason, sizeof(reason));
+        what += ": ";
+        what += reason;
+    }
+    ERR_clear_error();
+    throw Error(what, code);
+}
+
+namespace detail {
+
+template <typename T, void (*Free)(T *)>
+struct Deleter {
+    void operator()(T *ptr) const noexcept { Free(ptr); }
+};
+
+} // namespace detail
+
+/**
+ * Owning handle for T, freed with Free. The typedefs below cover the
+ * types this library pools or wraps; others can be added the same way.
+ */
+template <typename T, void (*Free)(T *)>
+class Handle {
+public:
+    using element_type = T;
+
+    Handle() noexcept = default;
+    explicit Handle(T *ptr) noexcept : ptr_(ptr) {}
+
+    Handle(Handle &&) noexcept = default;
+    Handle &operator=(Handle &&) noexcept = default;
+    Handle(const Handle &) = delete;
+    Handle &operator=(const Handle &) = delete;
+
+    T *get() const noexcept { return ptr_.get(); }
+    T *release() noexcept { return ptr_.release(); }
+    void reset(T *ptr = nullptr) noexcept { ptr_.reset(ptr); }
+    explicit operator bool() const noexcept { return static_cast<bool>(ptr_); }
+
+private:
+    std::unique_ptr<T, detail::Deleter<T, Free>> ptr_;
+};
+
+/** Digest context (EVP_MD_CTX_new); reusable after EVP_MD_CTX_reset */
+class MdCtx : public Handle<EVP_MD_CTX, EVP_MD_CTX_free> {
+public:
+    using Handle::Handle;
+
+    static MdCtx create() {
+        MdCtx ctx(EVP_MD_CTX_new());
+        if (!ctx)
+            throw_last_error("EVP_MD_CTX_new");
+        return ctx;
+    }
+
+    /** Drop the digest state and keys; the context stays allocated */
+    void clear() noexcept { EVP_MD_CTX_reset(get()); }
+};
+
+/** Cipher context (EVP_CIPHER_CTX_new); reusable after EVP_CIPHER_CTX_reset */
+class CipherCtx : public Handle<EVP_CIPHER_CTX, EVP_CIPHER_CTX_free> {
+public:
+    using Handle::Handle;
+
+    static CipherCtx create() {
+        CipherCtx ctx(EVP_CIPHER_CTX_new());
+        if (!ctx)
+            throw_last_error("EVP_CIPHER_CTX_new");
+        return ctx;
+    }
+
+    /** Drop the cipher state and keys; the context stays allocated */
+    void clear() noexcept { EVP_CIPHER_CTX_reset(get()); }
+};
+
+/** Key (EVP_PKEY), e.g. from EVP_PKEY_Q_keygen or a PEM reader */
+using Pkey = Handle<EVP_PKEY, EVP_PKEY_free>;
+
+/**
+ * Public key algorithm context. There is no reset for these: a context
+ * is bound to its key, so reuse one per key rather than pooling them.
+ */
+class PkeyCtx : public Handle<EVP_PKEY_CTX, EVP_PKEY_CTX_free> {
+public:
+    using Handle::Handle;
+
+    /** Context for operations with key (EVP_PKEY_CTX_new_from_pkey) */
+    static PkeyCtx for_key(EVP_PKEY *key, OSSL_LIB_CTX *libctx = nullptr,
+                           const char *propquery = nullptr) {
+        PkeyCtx ctx(EVP_PKEY_CTX_new_from_pkey(libctx, key, propquery));
+        if (!ctx)
+            throw_last_error("EVP_PKEY_CTX_new_from_pkey");
+        return ctx;
+    }
+
+    /** Context for key generation or parameters of an algorithm ("EC", "ED25519", ...) */
+    static PkeyCtx for_name(const char *name, OSSL_LIB_CTX *libctx = nullptr,
+                            const char *propquery = nullptr) {
+        PkeyCtx ctx(EVP_PKEY_CTX_new_from_name(libctx, name, propquery));
+        if (!ctx)
+            throw_last_error("EVP_PKEY_CTX_new_from_name");
+        return ctx;
+    }
+};
+
+/** TLS context shared by connections (SSL_CTX_new_ex) */
+class SslCtx : public Handle<SSL_CTX, SSL_CTX_free> {
+public:
+    using Handle::Handle;
+
+    static SslCtx create(const SSL_METHOD *method, OSSL_LIB_CTX *libctx = nullptr,
+                         const char *propquery = nullptr) {
+        SslCtx ctx(SSL_CTX_new_ex(libctx, propquery, method));
+        if (!ctx)
+            throw_last_error("SSL_CTX_new_ex");
+        return ctx;
+    }
+};
+
+/** One TLS connection (SSL_new) */
+class Ssl : public Handle<SSL, SSL_free> {
+public:
+    using Handle::Handle;
+
+    static Ssl create(SSL_CTX *ctx) {
+        Ssl ssl(SSL_new(ctx));
+        if (!ssl)
+            throw_last_error("SSL_new");
+        return ssl;
+    }
+
+    /**
+     * Prepare the connection for another handshake with the same
+     * SSL_CTX settings (SSL_clear), avoiding a new SSL per connection.
+     */
+    void clear() {
+        if (SSL_clear(get()) != 1)
+            throw_last_error("SSL_clear");
+    }
+};
+
+} // namespace openssl
+} // namespace sparetools
+
+#endif /* SPARETOOLS_OPENSSL_HANDLES_HPP */
@@ -0,0 +1,124 @@
+#ifndef SPARETOOLS_OPENSSL_POOL_HPP
+#define SPARETOOLS_OPENSSL_POOL_HPP
+
+/**
+ * Thread-local pools of digest and cipher contexts
+ *
+ * The usual pattern (see test_openssl.c) is EVP_MD_CTX_new, init, update,
+ * final and EVP_MD_CTX_free for every operation: an allocation and a free
+ * of the context each time, plus locking in the allocator under load.
+ * ContextPool keeps a few cleared contexts per thread instead. acquire()
+ * pops one (allocating only when the thread has none left) and the
+ * returned Lease clears it with EVP_MD_CTX_reset / EVP_CIPHER_CTX_reset
+ * and pushes it back when it goes out of scope, so no key or digest state
+ * outlives the operation.
+ *
+ *     auto ctx = sparetools::openssl::md_pool::acquire();
+ *     EVP_DigestInit_ex2(ctx.get(), sha256, nullptr);
+ *
+ * Per-thread lists need no locking. A lease released on another thread
+ * than the one that acquired it simply joins that thread's list. Pooled
+ * contexts are freed when their thread exits.
+ */
+
+#include <sparetools/openssl/handles.hpp>
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace sparetools {
+namespace openssl {
+
+/**
+ * Pool of Ctx (MdCtx or CipherCtx: create() and a noexcept clear()),
+ * keeping at most Capacity idle contexts per thread.
+ */
+template <typename Ctx, std::size_t Capacity = 8>
+class ContextPool {
+public:
+    using element_type = typename Ctx::element_type;
+
+    /** A pooled context, returned to the pool (cleared) on destruction */
+    class Lease {
+    public:
+        Lease(Lease &&other) noexcept : ctx_(std::move(other.ctx_)) {}
+        Lease &operator=(Lease &&other) noexcept {
+            if (this != &other) {
+                give_back();
+                ctx_ = std::move(other.ctx_);
+            }
+            return *this;
+        }
+        Lease(const Lease &) = delete;
+        Lease &operator=(const Lease &) = delete;
+        ~Lease() { give_back(); }
+
+        element_type *get() const noexcept { return ctx_.get(); }
+        Ctx &handle() noexcept { return ctx_; }
+
+        /** Keep the context for good instead of returning it */
+        Ctx detach() noexcept { return std::move(ctx_); }
+
+    private:
+        friend class ContextPool;
+        explicit Lease(Ctx ctx) noexcept : ctx_(std::move(ctx)) {}
+
+        void give_back() noexcept {
+            if (ctx_) {
+                ctx_.clear();
+                ContextPool::release(std::move(ctx_));
+            }
+        }
+
+        Ctx ctx_;
+    };
+
+    /** A cleared context of this thread's pool, or a new one when it is empty */
+    static Lease acquire() {
+        std::vector<Ctx> &idle = free_list();
+        if (idle.empty())
+            return Lease(Ctx::create());
+        Ctx ctx = std::move(idle.back());
+        idle.pop_back();
+        return Lease(std::move(ctx));
+    }
+
+    /** Fill this thread's pool ahead of a burst of operations */
+    static void reserve(std::size_t count) {
+        std::vector<Ctx> &idle = free_list();
+        while (idle.size() < count && idle.size() < Capacity)
+            idle.push_back(Ctx::create());
+    }
+
+    /** Idle contexts held by the calling thread */
+    static std::size_t idle() { return free_list().size(); }
+
+    /** Free this thread's idle contexts */
+    static void drain() { free_list().clear(); }
+
+private:
+    static std::vector<Ctx> &free_list() {
+        thread_local std::vector<Ctx> idle = [] {
+            std::vector<Ctx> list;
+            list.reserve(Capacity);
+            return list;
+        }();
+        return idle;
+    }
+
+    static void release(Ctx ctx) noexcept {
+        std::vector<Ctx> &idle = free_list();
+        // Capacity was reserved, so push_back does not allocate (or throw)
+        if (idle.size() < Capacity)
+            idle.push_back(std::move(ctx));
+    }
+};
+
+using md_pool = ContextPool<MdCtx>;
+using cipher_pool = ContextPool<CipherCtx>;
+
+} // namespace openssl
+} // namespace sparetools
+
+#endif /* SPARETOOLS_OPENSSL_POOL_HPP */
@@ -0,0 +1,214 @@
+#include <sparetools/openssl.hpp>
+
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "bench_common.h"
+#include "sparetools_memtrace.h"
+
+/**
+ * Pooled vs per-operation EVP contexts
+ *
+ * Small-message SHA2-256 digests and AES-128-GCM seals, each done either
+ * the test_openssl.c way (EVP_*_CTX_new, init, update, final, free per
+ * operation) or with a context leased from md_pool / cipher_pool. The
+ * algorithms are fetched once up front, so remaining allocations are the
+ * context itself and the provider state the init call creates.
+ *
+ * OpenSSL allocations are counted with sparetools_memtrace and reported
+ * per operation, next to throughput on 1 and 4 threads (allocator
+ * contention is where per-operation contexts hurt the most). One JSON
+ * record is written per (operation, mode, threads).
+ */
+
+namespace ossl = sparetools::openssl;
+
+static const size_t MESSAGE_SIZE = 64;
+static const int thread_counts[] = {1, 4};
+
+static EVP_MD *sha256;
+static EVP_CIPHER *aes_gcm;
+
+struct Workload {
+    const char *name;
+    bool (*per_op)(const unsigned char *msg);
+    bool (*pooled)(const unsigned char *msg);
+};
+
+static bool digest(EVP_MD_CTX *ctx, const unsigned char *msg) {
+    unsigned char md[EVP_MAX_MD_SIZE];
+    unsigned int len;
+    return EVP_DigestInit_ex2(ctx, sha256, nullptr)
+        && EVP_DigestUpdate(ctx, msg, MESSAGE_SIZE)
+        && EVP_DigestFinal_ex(ctx, md, &len);
+}
+
+static bool seal(EVP_CIPHER_CTX *ctx, const unsigned char *msg) {
+    static const unsigned char key[16] = {1}, iv[12] = {2};
+    unsigned char out[MESSAGE_SIZE + 16], tag[16];
+    int len = 0, tmp = 0;
+    return EVP_EncryptInit_ex2(ctx, aes_gcm, key, iv, nullptr)
+        && EVP_EncryptUpdate(ctx, out, &len, msg, (int)MESSAGE_SIZE)
+        && EVP_EncryptFinal_ex(ctx, out + len, &tmp)
+        && EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_AEAD_GET_TAG, sizeof(tag), tag);
+}
+
+static bool digest_per_op(const unsigned char *msg) {
+    EVP_MD_CTX *ctx = EVP_MD_CTX_new();
+    bool ok = ctx != nullptr && digest(ctx, msg);
+    EVP_MD_CTX_free(ctx);
+    return ok;
+}
+
+static bool digest_pooled(const unsigned char *msg) {
+    auto ctx = ossl::md_pool::acquire();
+    return digest(ctx.get(), msg);
+}
+
+static bool seal_per_op(const unsigned char *msg) {
+    EVP_CIPHER_CTX *ctx = EVP_CIPHER_CTX_new();
+    bool ok = ctx != nullptr && seal(ctx, msg);
+    EVP_CIPHER_CTX_free(ctx);
+    return ok;
+}
+
+static bool seal_pooled(const unsigned char *msg) {
+    auto ctx = ossl::cipher_pool::acquire();
+    return seal(ctx.get(), msg);
+}
+
+static const Workload workloads[] = {
+    {"SHA2-256", digest_per_op, digest_pooled},
+    {"AES-128-GCM", seal_per_op, seal_pooled},
+};
+
+struct Result {
+    uint64_t ops;
+    double seconds;
+    SPARETOOLS_MEMTRACE_TOTALS allocs;
+    bool ok;
+};
+
+static Result run(bool (*op)(const unsigned char *), int threads, double min_seconds) {
+    std::atomic<uint64_t> ops{0};
+    std::atomic<bool> ok{true};
+    std::vector<std::thread> workers;
+    SPARETOOLS_MEMTRACE_TOTALS before, after;
+    Result result{};
+
+    // Warm each thread's pool outside the measurement, like a long-running service
+    auto worker = [&](bool measured, double seconds) {
+        unsigned char msg[MESSAGE_SIZE] = {0};
+        uint64_t done = 0;
+        double start = bench_now();
+        do {
+            for (int i = 0; i < 256; i++) {
+                if (!op(msg))
+                    ok = false;
+                msg[0]++;
+            }
+            done += 256;
+        } while (bench_now() - start < seconds);
+        if (measured)
+            ops += done;
+    };
+
+    sparetools_memtrace_totals(&before);
+    double start = bench_now();
+    for (int t = 0; t < threads; t++)
+        workers.emplace_back([&] {
+            worker(false, 0.0);
+            worker(true, min_seconds);
+        });
+    for (auto &w : workers)
+        w.join();
+    result.seconds = bench_now() - start;
+    sparetools_memtrace_totals(&after);
+
+    result.ops = ops;
+    result.ok = ok;
+    result.allocs.allocs = after.allocs - before.allocs;
+    result.allocs.frees = after.frees - before.frees;
+    result.allocs.bytes = after.bytes - before.bytes;
+    return result;
+}
+
+int main(int argc, char **argv) {
+    bench_options opts;
+    bench_json json;
+    int failures = 0;
+
+    int argi = bench_parse_args(argc, argv, "bench_ctx_pool.json", &opts);
+    if (argi < 0)
+        return 2;
+    if (argi != argc) {
+        bench_usage(argv[0]);
+        return 2;
+    }
+    /* Before any OpenSSL allocation */
+    bool traced = sparetools_memtrace_install() == 1;
+    if (!traced)
+        std::fprintf(stderr, "⚠ Allocation tracing unavailable (hooks already installed)\n");
+
+    std::printf("=================================\n");
+    std::printf("Pooled EVP Context Benchmark\n");
+    std::printf("=================================\n");
+    std::printf("OpenSSL version: %s\n\n", OpenSSL_version(OPENSSL_VERSION));
+
+    sha256 = EVP_MD_fetch(nullptr, "SHA2-256", nullptr);
+    aes_gcm = EVP_CIPHER_fetch(nullptr, "AES-128-GCM", nullptr);
+    if (sha256 == nullptr || aes_gcm == nullptr || bench_json_begin(&json, &opts, "ctx_pool") != 0) {
+        EVP_MD_free(sha256);
+        EVP_CIPHER_free(aes_gcm);
+        return 1;
+    }
+
+    std::printf("%-12s %-8s %7s %14s %12s %12s\n", "Operation", "Mode", "Threads", "ops/s",
+                "allocs/op", "bytes/op");
+    for (const Workload &w : workloads) {
+        for (int threads : thread_counts) {
+            double per_op_rate = 0.0;
+            for (int pooled = 0; pooled < 2; pooled++) {
+                const char *mode = pooled ? "pooled" : "per_op";
+                Result r = run(pooled ? w.pooled : w.per_op, threads, opts.min_seconds);
+                double rate = r.ops / r.seconds;
+                // Warm-up operations allocate too; divide by all of them
+                double total_ops = (double)r.ops + 256.0 * threads;
+                double allocs_per_op = r.allocs.allocs / total_ops;
+                double bytes_per_op = r.allocs.bytes / total_ops;
+
+                if (!r.ok)
+                    failures++;
+                if (!pooled)
+                    per_op_rate = rate;
+                std::printf("%-12s %-8s %7d %14.0f %12.2f %12.1f", w.name, mode, threads, rate,
+                            allocs_per_op, bytes_per_op);
+                if (pooled && per_op_rate > 0.0)
+                    std::printf("   (%.2fx)", rate / per_op_rate);
+                std::printf("%s\n", r.ok ? "" : "   FAILED");
+
+                bench_json_record_begin(&json);
+                bench_json_str(&json, "operation", w.name);
+                bench_json_str(&json, "mode", mode);
+                bench_json_int(&json, "threads", (uint64_t)threads);
+                bench_json_int(&json, "message_bytes", MESSAGE_SIZE);
+                bench_json_int(&json, "ops", r.ops);
+                bench_json_num(&json, "ops_per_sec", rate);
+                if (traced) {
+                    bench_json_num(&json, "allocs_per_op", allocs_per_op);
+                    bench_json_num(&json, "alloc_bytes_per_op", bytes_per_op);
+                }
+                bench_json_int(&json, "ok", r.ok ? 1 : 0);
+                bench_json_record_end(&json);
+            }
+        }
+    }
+
+    bench_json_end(&json);
+    EVP_MD_free(sha256);
+    EVP_CIPHER_free(aes_gcm);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,30 @@
+from conan import ConanFile
+from conan.tools.build import can_run
+from conan.tools.cmake import cmake_layout, CMake
+import os
+
+
+class SpareToolsOpenSSLCxxTestConan(ConanFile):
+    settings = "os", "compiler", "build_type", "arch"
+    generators = "CMakeDeps", "CMakeToolchain"
+    test_type = "explicit"
+
+    def requirements(self):
+        self.requires(self.tested_reference_str)
+
+    def layout(self):
+        cmake_layout(self)
+
+    def build(self):
+        cmake = CMake(self)
+        cmake.configure()
+        cmake.build()
+
+    def test(self):
+        if can_run(self):
+            bin_path = os.path.join(self.cpp.build.bindir, "test_openssl_cxx")
+            self.run(bin_path, env="conanrun")
+
+            # Pooled vs per-operation contexts, kept with the test results
+            bench_path = os.path.join(self.cpp.build.bindir, "bench_ctx_pool")
+            self.run(f'"{bench_path}" --quick --json bench_ctx_pool.json', env="conanrun")
@@ -0,0 +1,122 @@
+#include <sparetools/openssl.hpp>
+
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <utility>
+
+/**
+ * Basic checks of the RAII handles and context pools
+ *
+ * - SHA-256 through a pooled context matches the known digest, also on
+ *   a context that was reset and reused
+ * - AES-256-GCM round trip through pooled cipher contexts
+ * - leases return their context to the pool, per thread
+ * - PkeyCtx/Pkey key generation, SslCtx/Ssl creation
+ * - failures surface as sparetools::openssl::Error
+ */
+
+namespace ossl = sparetools::openssl;
+
+static int failures = 0;
+
+#define CHECK(cond, what)                                   \
+    do {                                                    \
+        if (cond) {                                         \
+            std::printf("✓ %s\n", what);                    \
+        } else {                                            \
+            std::printf("✗ %s\n", what);                    \
+            failures++;                                     \
+        }                                                   \
+    } while (0)
+
+static const unsigned char abc_sha256[32] = {
+    0xba, 0x78, 0x16, 0xbf, 0x8f, 0x01, 0xcf, 0xea, 0x41, 0x41, 0x40, 0xde, 0x5d, 0xae, 0x22, 0x23,
+    0xb0, 0x03, 0x61, 0xa3, 0x96, 0x17, 0x7a, 0x9c, 0xb4, 0x10, 0xff, 0x61, 0xf2, 0x00, 0x15, 0xad
+};
+
+static bool sha256_abc() {
+    auto ctx = ossl::md_pool::acquire();
+    unsigned char md[EVP_MAX_MD_SIZE];
+    unsigned int len = 0;
+    return EVP_DigestInit_ex2(ctx.get(), EVP_sha256(), nullptr)
+        && EVP_DigestUpdate(ctx.get(), "abc", 3)
+        && EVP_DigestFinal_ex(ctx.get(), md, &len)
+        && len == sizeof(abc_sha256) && std::memcmp(md, abc_sha256, len) == 0;
+}
+
+static bool gcm_round_trip() {
+    const unsigned char key[32] = {1}, iv[12] = {2};
+    const char *message = "sparetools-openssl-cxx";
+    int message_len = (int)std::strlen(message);
+    unsigned char sealed[64], opened[64], tag[16];
+    int len = 0, tmp = 0;
+
+    {
+        auto ctx = ossl::cipher_pool::acquire();
+        if (!EVP_EncryptInit_ex2(ctx.get(), EVP_aes_256_gcm(), key, iv, nullptr)
+            || !EVP_EncryptUpdate(ctx.get(), sealed, &len, (const unsigned char *)message, message_len)
+            || !EVP_EncryptFinal_ex(ctx.get(), sealed + len, &tmp)
+            || !EVP_CIPHER_CTX_ctrl(ctx.get(), EVP_CTRL_AEAD_GET_TAG, sizeof(tag), tag))
+            return false;
+    }
+    auto ctx = ossl::cipher_pool::acquire();
+    if (!EVP_DecryptInit_ex2(ctx.get(), EVP_aes_256_gcm(), key, iv, nullptr)
+        || !EVP_DecryptUpdate(ctx.get(), opened, &len, sealed, message_len)
+        || !EVP_CIPHER_CTX_ctrl(ctx.get(), EVP_CTRL_AEAD_SET_TAG, sizeof(tag), tag)
+        || !EVP_DecryptFinal_ex(ctx.get(), opened + len, &tmp))
+        return false;
+    return len == message_len && std::memcmp(opened, message, len) == 0;
+}
+
+int main() {
+    std::printf("OpenSSL C++ wrapper tests (%s)\n\n", OpenSSL_version(OPENSSL_VERSION));
+
+    CHECK(sha256_abc(), "SHA-256 through a pooled context");
+    CHECK(ossl::md_pool::idle() == 1, "Lease returned its context to the pool");
+    CHECK(sha256_abc(), "SHA-256 on a reset, reused context");
+    CHECK(ossl::md_pool::idle() == 1, "Reuse did not allocate a second context");
+    CHECK(gcm_round_trip(), "AES-256-GCM round trip through pooled contexts");
+
+    {
+        auto first = ossl::md_pool::acquire();
+        EVP_MD_CTX *raw = first.get();
+        ossl::md_pool::Lease second = std::move(first);
+        CHECK(second.get() == raw && first.get() == nullptr, "Leases move without copying");
+    }
+
+    std::size_t other_idle = 99;
+    std::thread([&] {
+        sha256_abc();
+        other_idle = ossl::md_pool::idle();
+    }).join();
+    CHECK(other_idle == 1 && ossl::md_pool::idle() == 1, "Pools are per thread");
+
+    ossl::md_pool::drain();
+    ossl::md_pool::reserve(4);
+    CHECK(ossl::md_pool::idle() == 4, "reserve() fills the thread's pool");
+
+    {
+        ossl::Pkey key(EVP_PKEY_Q_keygen(nullptr, nullptr, "ED25519"));
+        auto ctx = key ? ossl::PkeyCtx::for_key(key.get()) : ossl::PkeyCtx();
+        CHECK(key && ctx && EVP_PKEY_public_check(ctx.get()) == 1, "PkeyCtx for a generated Ed25519 key");
+    }
+
+    {
+        auto ctx = ossl::SslCtx::create(TLS_client_method());
+        auto ssl = ossl::Ssl::create(ctx.get());
+        ssl.clear();
+        CHECK(SSL_get_SSL_CTX(ssl.get()) == ctx.get(), "SslCtx and Ssl handles");
+    }
+
+    bool threw = false;
+    try {
+        ossl::PkeyCtx::for_name("NO-SUCH-ALGORITHM");
+    } catch (const ossl::Error &e) {
+        threw = std::strstr(e.what(), "EVP_PKEY_CTX_new_from_name") != nullptr;
+    }
+    CHECK(threw, "Failures throw sparetools::openssl::Error");
+
+    std::printf("\n%s\n", failures ? "✗ Some tests failed" : "✓ All tests passed");
+    return failures ? 1 : 0;
+}
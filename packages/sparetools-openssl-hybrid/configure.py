@@ -6,9 +6,13 @@ Configures OpenSSL build system with Python-based approach.
 """
 
 import argparse
+import fnmatch
+import glob
 import json
 import os
 import platform
+import re
+import shlex
 import shutil
 import subprocess
 import sys
@@ -17,6 +21,352 @@ from pathlib import Path
 from typing import Dict, List, Optional, Set, Tuple
 
 
+# Source trees compiled into each object group, as (name, glob patterns,
+# make-style filter-out patterns with their reason). Shared by the Makefile
+# and build.ninja generators so both build exactly the same objects.
+SOURCE_GROUPS = [
+    ('CRYPTO', ['crypto/*.c', 'crypto/*/*.c', 'crypto/*/*/*.c'], [
+        ('crypto/arm%', None),
+        ('crypto/ia64%', None),
+    ]),
+    ('SSL', ['ssl/*.c', 'ssl/*/*.c'], [
+        ('ssl/arm%', None),
+    ]),
+    ('PROVIDERS', ['providers/*.c', 'providers/*/*.c', 'providers/*/*/*.c'], [
+        ('providers/fips%', 'Exclude FIPS for now'),
+        ('providers/common/der/%', 'Exclude DER files that depend on FIPS'),
+        ('providers/common/securitycheck_fips.c', 'Exclude FIPS security checks'),
+        ('providers/implementations/asymciphers/rsa_enc.c', 'Exclude RSA encryption with FIPS indicators'),
+        ('providers/implementations/ciphers/cipher_desx.c', 'Exclude DESX with FIPS indicators'),
+        ('providers/implementations/ciphers/cipher_desx_hw.c', 'Exclude DESX HW with FIPS indicators'),
+        ('providers/implementations/ciphers/cipher_rc5.c', 'Exclude RC5 cipher (patented algorithm)'),
+        ('providers/implementations/ciphers/cipher_rc5_hw.c', 'Exclude RC5 HW cipher'),
+        ('providers/implementations/ciphers/cipher_tdes.c', 'Exclude TDES with FIPS indicators'),
+        ('providers/implementations/ciphers/cipher_tdes_common.c', 'Exclude TDES common with FIPS indicators'),
+        ('providers/implementations/ciphers/cipher_tdes_default.c', 'Exclude TDES default with FIPS indicators'),
+        ('providers/implementations/ciphers/cipher_tdes_default_hw.c',
+         'Exclude TDES default HW with FIPS indicators'),
+        ('providers/implementations/ciphers/cipher_tdes_hw.c', 'Exclude TDES HW with FIPS indicators'),
+        ('providers/implementations/ciphers/cipher_tdes_wrap.c', 'Exclude TDES wrap with FIPS indicators'),
+        ('providers/implementations/ciphers/cipher_tdes_wrap_hw.c', 'Exclude TDES wrap HW with FIPS indicators'),
+        ('providers/implementations/digests/md2_prov.c', 'Exclude MD2 provider (deprecated)'),
+        ('providers/implementations/digests/md4_prov.c', 'Exclude MD4 provider (deprecated)'),
+    ]),
+]
+
+# Build targets that build.ninja provides; in ninja mode the Makefile
+# forwards them so `make install_sw` and the Conan recipe keep working.
+NINJA_TARGETS = ['all', 'build_libs', 'build_apps', 'libcrypto.a', 'libssl.a', 'apps/openssl',
+                 'crypto_objects', 'ssl_objects', 'providers']
+
+# Features Perl Configure leaves disabled unless enable-<feature> is given
+# (its %disabled defaults), as seen by build.info conditions
+BUILDINFO_DEFAULT_DISABLED = {
+    'acvp-tests', 'asan', 'brotli', 'brotli-dynamic', 'buildtest-c++', 'crypto-mdebug',
+    'crypto-mdebug-backtrace', 'devcryptoeng', 'ec_nistp_64_gcc_128', 'egd', 'external-tests',
+    'fips', 'fips-jitter', 'fuzz-afl', 'fuzz-libfuzzer', 'jitter', 'ktls', 'md2', 'msan', 'rc5',
+    'sctp', 'ssl3', 'ssl3-method', 'tfo', 'trace', 'ubsan', 'unit-test', 'weak-ssl-ciphers',
+    'zlib', 'zlib-dynamic', 'zstd', 'zstd-dynamic',
+}
+
+# Features that disabling another one disables too (a subset of Configure's
+# @disable_cascades)
+BUILDINFO_CASCADES = {
+    'shared': ['dynamic-engine'],
+    'ssl3': ['ssl3-method'],
+    'zlib': ['zlib-dynamic'],
+    'ec': ['ec2m', 'ecdsa', 'ecdh', 'sm2', 'ecx'],
+    'sock': ['dgram', 'ktls', 'quic'],
+    'dgram': ['dtls', 'sctp', 'quic'],
+    'threads': ['thread-pool', 'quic'],
+    'module': ['dynamic-engine'],
+}
+
+# Object name infix per product kind, as Perl Configure names them
+# (crypto/aes/libcrypto-lib-aes_core.o, apps/openssl-bin-openssl.o)
+BUILDINFO_KINDS = {'LIBS': 'lib', 'PROGRAMS': 'bin', 'MODULES': 'dso'}
+
+
+class BuildInfoGraph:
+    """
+    Products, objects and link dependencies read from OpenSSL's build.info
+    tree, the description Perl Configure turns into %unified_info.
+
+    Every object gets its own rule with the INCLUDE/DEFINE of its product,
+    named <dir>/<product>-<kind>-<stem>.o like Configure names it, so one
+    source built into two products is compiled twice with the right flags.
+    Sources of noinst static libraries that an installed library lists in
+    SOURCE or DEPEND (providers/libdefault.a in libcrypto) are archived into
+    it, and programs link their noinst libraries and installed libraries in
+    dependency order.
+
+    {- -} Perl fragments are evaluated when they are simple expressions over
+    $disabled{}, $config{} and $target{} (!, &&, ||, eq, ne, =~); any other
+    fragment expands to nothing and is reported. Only static archives and
+    programs are built: MODULES and SHARED_SOURCE are skipped, asm counts as
+    disabled (no perlasm step), and GENERATE outputs are used as sources only
+    if they already exist in the tree.
+    """
+
+    _PERL = re.compile(r'\{-(.*?)-\}', re.S)
+    _PERL_TOKEN = re.compile(r'''\s*(?:
+        (?P<hash>\$(?P<table>disabled|config|target)\{\s*(?:"(?P<dq>[^"]*)"|'(?P<sq>[^']*)'|(?P<bare>[\w.+-]+))\s*\})
+      | (?P<match>(?P<neg>[=!])~\s*/(?P<re>(?:[^/\\]|\\.)*)/(?P<flags>[a-z]*))
+      | (?P<str>"[^"$@]*"|'[^']*')
+      | (?P<num>\d+)
+      | (?P<op>&&|\|\||==|!=|!|\(|\)|\b(?:and|or|not|eq|ne)\b)
+    )''', re.X)
+    _PERL_OPS = {'&&': ' and ', '||': ' or ', '!': ' not ', 'and': ' and ', 'or': ' or ',
+                 'not': ' not ', 'eq': ' == ', 'ne': ' != ', '==': ' == ', '!=': ' != '}
+    _STATEMENT = re.compile(r'^(\w+)(?:\[([^\]]*)\])?(?:\{([^}]*)\})?\s*=\s*(.*)$')
+    _VARIABLE = re.compile(r'\$(?:\{(\w+)\}|(\w+))')
+
+    def __init__(self, disabled: Set[str], config: Dict[str, str], target: Dict[str, str]):
+        self.disabled = disabled
+        self.config = config
+        self.target = target
+        self.files: List[str] = []
+        self.warnings: List[str] = []
+        self.products: Dict[str, Tuple[str, Set[str]]] = {}    # path -> (kind, attributes)
+        self._sources: Dict[str, List[str]] = {}
+        self._depends: Dict[str, List[str]] = {}
+        self._includes: Dict[str, List[str]] = {}
+        self._defines: Dict[str, List[str]] = {}
+        self._generated: Set[str] = set()
+        # Results of resolve()
+        self.objects: Dict[str, Tuple[str, Tuple[str, ...]]] = {}  # object -> (source, flags)
+        self.archives: Dict[str, List[str]] = {}                   # static library -> members
+        self.programs: Dict[str, Tuple[List[str], List[str]]] = {}  # program -> (objects, archives)
+
+    def read(self, top: str = '.') -> 'BuildInfoGraph':
+        """Parse top/build.info and every SUBDIRS entry below it, then resolve()."""
+        pending = ['.']
+        while pending:
+            directory = pending.pop(0)
+            path = os.path.normpath(os.path.join(top, directory, 'build.info'))
+            if os.path.exists(path):
+                self.files.append(path.replace(os.sep, '/'))
+                pending += self._parse(directory, path)
+        self.resolve()
+        return self
+
+    @staticmethod
+    def _path(directory: str, name: str) -> str:
+        if os.path.isabs(name):
+            return name
+        return os.path.normpath(os.path.join(directory, name)).replace(os.sep, '/')
+
+    def _perl(self, code: str, where: str) -> str:
+        """Value of a {- -} fragment: '1' or '' for conditions, else the string."""
+        tokens: List[str] = []
+        pos, code = 0, code.strip().rstrip(';').strip()
+        while pos < len(code):
+            m = self._PERL_TOKEN.match(code, pos)
+            if not m or m.end() == pos:
+                break
+            pos = m.end()
+            if m.group('hash'):
+                key = m.group('dq') if m.group('dq') is not None else (m.group('sq') or m.group('bare'))
+                tokens.append(f"{m.group('table')[0].upper()}({key!r})")
+            elif m.group('match'):
+                if not tokens or tokens[-1] in self._PERL_OPS.values() or tokens[-1] == '(':
+                    break
+                flags = re.I if 'i' in m.group('flags') else 0
+                call = f"M({tokens.pop()}, {m.group('re')!r}, {flags})"
+                tokens.append(f"(not {call})" if m.group('neg') == '!' else call)
+            elif m.group('str'):
+                tokens.append(repr(m.group('str')[1:-1]))
+            elif m.group('num'):
+                tokens.append(m.group('num'))
+            else:
+                tokens.append(self._PERL_OPS.get(m.group('op'), m.group('op')))
+        value = None
+        if code and pos == len(code):
+            names = {
+                'D': lambda k: k in self.disabled,
+                'C': lambda k: self.config.get(k, ''),
+                'T': lambda k: self.target.get(k, ''),
+                'M': lambda s, r, f: re.search(r, s, f) is not None,
+            }
+            try:
+                value = eval(''.join(tokens), {'__builtins__': {}}, names)
+            except Exception:
+                value = None
+        if value is None:
+            self.warnings.append(f"{where}: {{-{code}-}} not evaluated")
+            return ''
+        if isinstance(value, bool):
+            return '1' if value else ''
+        return str(value)
+
+    def _expand(self, text: str, variables: Dict[str, str], where: str) -> str:
+        text = self._PERL.sub(lambda m: self._perl(m.group(1), where), text)
+        return self._VARIABLE.sub(lambda m: variables.get(m.group(1) or m.group(2), ''), text)
+
+    def _parse(self, directory: str, path: str) -> List[str]:
+        """Record one build.info; returns the SUBDIRS it names."""
+        with open(path, 'r', errors='replace') as f:
+            text = f.read()
+        text = re.sub(r'\\\r?\n', ' ', text)
+        text = self._PERL.sub(lambda m: m.group(0).replace('\n', ' '), text)
+        variables: Dict[str, str] = {}
+        subdirs: List[str] = []
+        stack: List[Tuple[bool, bool]] = []  # (branch active, some branch taken)
+
+        def cond(c: str) -> bool:
+            return self._expand(c, variables, path).strip() not in ('', '0')
+
+        for line in text.split('\n'):
+            line = line.strip()
+            if not line or line.startswith('#'):
+                continue
+            outer = all(active for active, _ in stack)
+            keyword = re.match(r'^(IF|ELSIF)\[(.*)\]$|^(ELSE|ENDIF)$', line)
+            if keyword:
+                if keyword.group(1) == 'IF':
+                    taken = outer and cond(keyword.group(2))
+                    stack.append((taken, taken or not outer))
+                elif not stack:
+                    self.warnings.append(f"{path}: {line} without IF")
+                elif keyword.group(3) == 'ENDIF':
+                    stack.pop()
+                else:
+                    _, taken = stack.pop()
+                    outer = all(active for active, _ in stack)
+                    active = not taken and (keyword.group(3) == 'ELSE' or cond(keyword.group(2)))
+                    stack.append((active, taken or active))
+                continue
+            if not outer:
+                continue
+            if line.startswith('{-'):
+                # Fragment producing build.info text (usually none)
+                line = self._PERL.sub(lambda m: self._perl(m.group(1), path), line).strip()
+                if not line:
+                    continue
+            var = re.match(r'^\$(\w+)\s*=\s*(.*)$', line)
+            if var:
+                variables[var.group(1)] = self._expand(var.group(2), variables, path).strip()
+                continue
+            m = self._STATEMENT.match(line)
+            if not m:
+                self.warnings.append(f"{path}: unrecognised line {line[:60]!r}")
+                continue
+            kind, index, attrs = m.group(1), m.group(2), m.group(3)
+            values = self._expand(m.group(4), variables, path).split()
+            index = self._expand(index, variables, path).strip() if index is not None else None
+            if kind == 'SUBDIRS':
+                subdirs += [self._path(directory, d) for d in values]
+            elif kind in BUILDINFO_KINDS:
+                attributes = {a.strip() for a in (attrs or '').split(',') if a.strip()}
+                for name in values:
+                    product = self._path(directory, name)
+                    if kind == 'LIBS' and not product.endswith('.a'):
+                        product += '.a'
+                    self.products[product] = (kind, attributes)
+            elif index is None:
+                continue  # SCRIPTS, DEPEND[]= and other statements without a product
+            elif kind in ('SOURCE', 'DEPEND', 'INCLUDE'):
+                table = {'SOURCE': self._sources, 'DEPEND': self._depends, 'INCLUDE': self._includes}[kind]
+                for key in index.split():
+                    table.setdefault(self._path(directory, key), []).extend(
+                        self._path(directory, v) for v in values)
+            elif kind == 'DEFINE':
+                for key in index.split():
+                    self._defines.setdefault(self._path(directory, key), []).extend(values)
+            elif kind == 'GENERATE':
+                self._generated.add(self._path(directory, index))
+        if stack:
+            self.warnings.append(f"{path}: IF without ENDIF")
+        return subdirs
+
+    def _product(self, key: str) -> Optional[str]:
+        if key in self.products:
+            return key
+        return key + '.a' if key + '.a' in self.products else None
+
+    def _entries(self, table: Dict[str, List[str]], product: str) -> List[str]:
+        """Entries recorded for product under either of its names (../libcrypto, libcrypto.a)."""
+        names = [product, product[:-2]] if product.endswith('.a') else [product]
+        return [v for name in names for v in table.get(name, [])]
+
+    def _noinst(self, product: Optional[str]) -> bool:
+        return product is not None and 'noinst' in self.products[product][1]
+
+    def _own_objects(self, product: str) -> List[str]:
+        kind = BUILDINFO_KINDS[self.products[product][0]]
+        base = os.path.basename(product)[:-2] if product.endswith('.a') else os.path.basename(product)
+        flags = [f"-I{d}" for d in self._entries(self._includes, product)]
+        flags += [f"-D{d}" for d in self._entries(self._defines, product)]
+        objects = []
+        for source in self._entries(self._sources, product):
+            stem, ext = os.path.splitext(source)
+            if self._product(source) or ext not in ('.c', '.s', '.S'):
+                continue  # Folded libraries, linker scripts, headers
+            if not os.path.exists(source):
+                if source in self._generated:
+                    self.warnings.append(f"{product}: {source} is generated by Perl Configure, skipped")
+                else:
+                    self.warnings.append(f"{product}: {source} not found, skipped")
+                continue
+            directory = os.path.dirname(source)
+            obj = f"{directory}/{base}-{kind}-{os.path.basename(stem)}.o" if directory else \
+                f"{base}-{kind}-{os.path.basename(stem)}.o"
+            extra = [f"-I{d}" for d in self._includes.get(stem + '.o', [])]
+            extra += [f"-D{d}" for d in self._defines.get(stem + '.o', [])]
+            self.objects[obj] = (source, tuple(flags + extra))
+            objects.append(obj)
+        return objects
+
+    def _library_deps(self, product: str) -> List[str]:
+        deps = []
+        for entry in self._entries(self._sources, product) + self._entries(self._depends, product):
+            dep = self._product(entry)
+            if dep and dep != product and self.products[dep][0] == 'LIBS' and dep not in deps:
+                deps.append(dep)
+        return deps
+
+    def resolve(self) -> None:
+        """Work out objects, archive members and program link lines."""
+        own = {p: self._own_objects(p) for p, (kind, _) in self.products.items() if kind != 'MODULES'}
+
+        def members(lib: str, seen: Set[str]) -> List[str]:
+            result = list(own[lib])
+            for dep in self._library_deps(lib):
+                if self._noinst(dep) and dep not in seen:
+                    seen.add(dep)
+                    result += [o for o in members(dep, seen) if o not in result]
+            return result
+
+        def link_order(product: str) -> List[str]:
+            """
+            Libraries a program links: each DEPEND entry followed by what it
+            needs, keeping the last occurrence (Configure's resolvedepends).
+            """
+            def expand(lib: str, path: Tuple[str, ...]) -> List[str]:
+                deps = self._library_deps(lib)
+                if not self._noinst(lib):
+                    # Noinst libraries folded into an installed one are not linked again
+                    deps = [d for d in deps if not self._noinst(d)]
+                return [lib] + [x for d in deps if d not in path for x in expand(d, path + (d,))]
+
+            expanded = [x for d in self._library_deps(product) for x in expand(d, (product, d))]
+            return [lib for i, lib in enumerate(expanded) if lib not in expanded[i + 1:]]
+
+        linked: Set[str] = set()
+        for product, (kind, attrs) in self.products.items():
+            if kind == 'PROGRAMS' and 'noinst' not in attrs:
+                archives = link_order(product)
+                self.programs[product] = (own[product], archives)
+                linked.update(archives)
+        for product, (kind, attrs) in self.products.items():
+            if kind == 'LIBS' and ('noinst' not in attrs or product in linked):
+                self.archives[product] = members(product, {product})
+        # Objects of products that are neither archived nor linked are not built
+        used = {o for objs in self.archives.values() for o in objs}
+        used.update(o for objs, _ in self.programs.values() for o in objs)
+        self.objects = {o: v for o, v in self.objects.items() if o in used}
+
+
 class OpenSSLConfigurer:
     """OpenSSL build configuration handler."""
 
@@ -33,6 +383,19 @@ class OpenSSLConfigurer:
         self.includes: List[str] = []
         self.libdirs: List[str] = []
         self.libs: List[str] = []
+        self.extra_cflags: List[str] = []
+        self.extra_ldflags: List[str] = []
+        self.shared_ldflags: List[str] = []
+        self.variables: Dict[str, str] = {}
+        # As Configure's CROSS_COMPILE: prepended to CC, AR and RANLIB
+        self.cross_compile_prefix = ''
+        self.generator = 'make'
+        self.unity = False
+        self.unity_batch_size = 16
+        self.sources = 'auto'
+        self._graph: Optional[BuildInfoGraph] = None
+        self._units: Dict[str, List[Tuple[str, List[str]]]] = {}
+        self.argv: List[str] = []
 
         # Platform detection
         self.system = platform.system().lower()
@@ -54,27 +417,24 @@ class OpenSSLConfigurer:
 
     def detect_platform(self) -> str:
         """Detect the build platform and return appropriate target."""
-        system = self.system
-        machine = self.machine
-
-        # Platform mapping
-        platform_map = {
-            ('linux', 'x86_64'): 'linux-x86_64',
-            ('linux', 'i386'): 'linux-x86',
-            ('linux', 'i686'): 'linux-x86',
-            ('linux', 'aarch64'): 'linux-aarch64',
-            ('linux', 'armv7l'): 'linux-armv4',
-            ('darwin', 'x86_64'): 'darwin64-x86_64-cc',
-            ('darwin', 'arm64'): 'darwin64-arm64-cc',
-            ('freebsd', 'x86_64'): 'BSD-x86_64',
-            ('openbsd', 'x86_64'): 'BSD-x86_64',
-            ('netbsd', 'x86_64'): 'BSD-x86_64',
-            ('windows', 'x86_64'): 'VC-WIN64A',
-            ('windows', 'i386'): 'VC-WIN32',
-            ('windows', 'amd64'): 'VC-WIN64A',
-        }
-
-        return platform_map.get((system, machine), 'linux-x86_64')
+        return self.PLATFORM_TARGETS.get((self.system, self.machine), 'linux-x86_64')
+
+    # (system, machine) -> Configure target
+    PLATFORM_TARGETS = {
+        ('linux', 'x86_64'): 'linux-x86_64',
+        ('linux', 'i386'): 'linux-x86',
+        ('linux', 'i686'): 'linux-x86',
+        ('linux', 'aarch64'): 'linux-aarch64',
+        ('linux', 'armv7l'): 'linux-armv4',
+        ('darwin', 'x86_64'): 'darwin64-x86_64-cc',
+        ('darwin', 'arm64'): 'darwin64-arm64-cc',
+        ('freebsd', 'x86_64'): 'BSD-x86_64',
+        ('openbsd', 'x86_64'): 'BSD-x86_64',
+        ('netbsd', 'x86_64'): 'BSD-x86_64',
+        ('windows', 'x86_64'): 'VC-WIN64A',
+        ('windows', 'i386'): 'VC-WIN32',
+        ('windows', 'amd64'): 'VC-WIN64A',
+    }
 
     def parse_arguments(self, args: List[str]) -> None:
         """Parse command line arguments."""
@@ -113,9 +473,53 @@ class OpenSSLConfigurer:
             elif arg.startswith('-l'):
                 # Library
                 self.libs.append(arg[2:])
+            elif arg == 'shared':
+                self.build_config['shared'] = True
+            elif arg.startswith('-Wl,-Bsymbolic'):
+                # Binding flags are only meaningful for the shared libraries
+                self.shared_ldflags.append(arg)
+            elif arg.startswith('-Wl,'):
+                # Linker flag
+                self.extra_ldflags.append(arg)
+            elif arg.startswith(('-f', '-m', '-O', '-W', '-g')) and not arg.startswith('--'):
+                # Compiler flag (as accepted by Perl Configure); LTO and
+                # profile instrumentation are needed at link time as well
+                self.extra_cflags.append(arg)
+                if arg.startswith(('-flto', '-fprofile', '-march', '-mcpu')):
+                    self.extra_ldflags.append(arg)
+            elif re.match(r'^[A-Z][A-Z0-9_]*=', arg):
+                # Build variable, e.g. AR=gcc-ar or CFLAGS=...
+                key, value = arg.split('=', 1)
+                self.variables[key] = value
             elif arg == '--help' or arg == '-h':
                 self.show_help()
                 sys.exit(0)
+            elif arg.startswith('--generator=') or arg == '--generator':
+                if '=' in arg:
+                    self.generator = arg.split('=', 1)[1].lower()
+                elif i + 1 < len(args):
+                    self.generator = args[i + 1].lower()
+                    i += 1
+                if self.generator not in ('make', 'ninja'):
+                    print(f"Error: Unknown generator {self.generator} (expected make or ninja)", file=sys.stderr)
+                    sys.exit(1)
+            elif arg.startswith('--sources='):
+                self.sources = arg.split('=', 1)[1].lower()
+                if self.sources not in ('auto', 'build.info', 'glob'):
+                    print(f"Error: Unknown source mode {self.sources} (expected auto, build.info or glob)",
+                          file=sys.stderr)
+                    sys.exit(1)
+            elif arg.startswith('--cross-compile-prefix='):
+                self.cross_compile_prefix = arg.split('=', 1)[1]
+            elif arg.startswith('--sysroot='):
+                # Headers and libraries of the target, when compiling and linking
+                self.extra_cflags.append(arg)
+                self.extra_ldflags.append(arg)
+            elif arg == '--unity':
+                self.unity = True
+            elif arg.startswith('--unity-batch-size='):
+                self.unity = True
+                self.unity_batch_size = max(1, int(arg.split('=', 1)[1]))
             elif arg == '--debug':
                 self.debug = True
             elif arg == '--quiet':
@@ -159,6 +563,18 @@ Options:
     -I<dir>            Add include directory
     -L<dir>            Add library directory
     -l<lib>            Add library
+    -f*, -m*, -O*, -W* Add compiler flag (e.g. -flto=thin, -march=x86-64-v3)
+    -Wl,<flag>         Add linker flag (-Wl,-Bsymbolic* only with 'shared')
+    VAR=value          Set build variable (CC, AR, RANLIB, CFLAGS, LDFLAGS)
+    --cross-compile-prefix=<p>  Prefix for CC, AR and RANLIB (aarch64-linux-gnu-)
+    --sysroot=<dir>    Target headers and libraries (compile and link)
+    --generator=<gen>  Build files to write: make (default) or ninja
+                       (build.ninja plus a Makefile forwarding to it)
+    --sources=<mode>   Object graph: build.info (per-object rules from the
+                       build.info tree), glob (SOURCE_GROUPS) or auto
+                       (default: build.info when present and not --unity)
+    --unity            Compile each source directory as batched unity units
+    --unity-batch-size=<n>  Sources per unity unit (default 16)
     --debug            Enable debug output
     --quiet            Suppress non-essential output
     --help             Show this help
@@ -190,6 +606,9 @@ Common targets:
         if self.build_config['no_asm'] and self.build_config['asm']:
             errors.append("Cannot specify both 'no-asm' and 'asm'")
 
+        if self.shared_ldflags and not self.build_config['shared']:
+            print(f"Warning: {' '.join(self.shared_ldflags)} ignored without 'shared'", file=sys.stderr)
+
         if errors:
             for error in errors:
                 print(f"Error: {error}", file=sys.stderr)
@@ -324,12 +743,22 @@ Common targets:
             self._install_prefix = prefix
             self._openssldir = openssldir
 
+            self._graph = self._load_build_graph()
+
             # Generate Makefile directly
             makefile_content = self._generate_makefile_content(prefix, openssldir)
 
             with open('Makefile', 'w') as f:
                 f.write(makefile_content)
 
+            if self.generator == 'ninja':
+                # Rewritten only when it changes, so the restat regeneration
+                # edge does not make ninja re-plan an unchanged build
+                self._write_if_changed('build.ninja', self._generate_ninja_content(openssldir))
+                if not shutil.which('ninja') and not getattr(self, '_ninja_warned', False):
+                    print("Warning: ninja not found on PATH, build.ninja written anyway", file=sys.stderr)
+                    self._ninja_warned = True
+
             if not self.quiet:
                 print("? Makefile generated successfully")
 
@@ -365,6 +794,16 @@ Common targets:
         # Platform-specific settings
         platform_settings = self._get_platform_settings()
 
+        if self.generator == 'ninja':
+            build_rules = self._ninja_forward_rules()
+            extra_phony = " " + " ".join(t for t in NINJA_TARGETS if '.' in t or '/' in t)
+        elif self._graph is not None:
+            build_rules = self._make_graph_rules(self._graph)
+            extra_phony = ""
+        else:
+            build_rules = self._make_build_rules()
+            extra_phony = ""
+
         makefile = f'''# Generated by Python configure.py - Modern OpenSSL build system
 # Do not edit manually - regenerate with: python3 configure.py [options]
 
@@ -380,8 +819,8 @@ MANDIR = $(INSTALLTOP)/share/man
 # Compiler and tools
 CC = {cc}
 CXX = g++
-AR = ar
-RANLIB = ranlib
+AR = {self._tool('AR', 'ar')}
+RANLIB = {self._tool('RANLIB', 'ranlib')}
 MAKE = make
 
 # Compiler flags
@@ -399,69 +838,7 @@ CPPFLAGS = -DOPENSSLDIR=\\\"{openssldir}\\\" -DENGINESDIR=\\\"{os.path.join(open
 # Build configuration flags
 BUILD_CONFIG = {shared_flag} {threads_flag} {asm_flag} {fips_flag}
 
-# Main targets
-all: build_libs build_apps
-
-build_libs: providers libcrypto.a libssl.a
-
-build_apps: build_libs apps/openssl
-
-# Library targets - build directly without subdirectories
-libcrypto.a: crypto_objects
-	@echo "Building libcrypto.a..."
-	$(AR) rcs libcrypto.a $(CRYPTO_OBJECTS)
-	$(RANLIB) libcrypto.a
-
-libssl.a: libcrypto.a ssl_objects
-	@echo "Building libssl.a..."
-	$(AR) rcs libssl.a $(SSL_OBJECTS)
-	$(RANLIB) libssl.a
-
-# Application targets
-apps/openssl: apps/openssl.o
-	@echo "Building openssl binary..."
-	$(CC) $(CPPFLAGS) $(CFLAGS) $(LDFLAGS) apps/openssl.o $(LIBS) -o apps/openssl
-
-# Object compilation rules
-%.o: %.c
-	$(CC) $(CPPFLAGS) $(CFLAGS) -Iinclude -I. -Iproviders/common/include -Iproviders/implementations/include -c $< -o $@
-
-# Source file collections - exclude architecture-specific files when not supported
-CRYPTO_SOURCES = $(wildcard crypto/*.c crypto/*/*.c crypto/*/*/*.c)
-CRYPTO_SOURCES := $(filter-out crypto/arm%,$(CRYPTO_SOURCES))
-CRYPTO_SOURCES := $(filter-out crypto/ia64%,$(CRYPTO_SOURCES))
-CRYPTO_OBJECTS = $(CRYPTO_SOURCES:.c=.o)
-
-SSL_SOURCES = $(wildcard ssl/*.c ssl/*/*.c)
-SSL_SOURCES := $(filter-out ssl/arm%,$(SSL_SOURCES))
-SSL_OBJECTS = $(SSL_SOURCES:.c=.o)
-
-PROVIDERS_SOURCES = $(wildcard providers/*.c providers/*/*.c providers/*/*/*.c)
-PROVIDERS_SOURCES := $(filter-out providers/fips%,$(PROVIDERS_SOURCES))  # Exclude FIPS for now
-PROVIDERS_SOURCES := $(filter-out providers/common/der/%,$(PROVIDERS_SOURCES))  # Exclude DER files that depend on FIPS
-PROVIDERS_SOURCES := $(filter-out providers/common/securitycheck_fips.c,$(PROVIDERS_SOURCES))  # Exclude FIPS security checks
-PROVIDERS_SOURCES := $(filter-out providers/implementations/asymciphers/rsa_enc.c,$(PROVIDERS_SOURCES))  # Exclude RSA encryption with FIPS indicators
-PROVIDERS_SOURCES := $(filter-out providers/implementations/ciphers/cipher_desx.c,$(PROVIDERS_SOURCES))  # Exclude DESX with FIPS indicators
-PROVIDERS_SOURCES := $(filter-out providers/implementations/ciphers/cipher_desx_hw.c,$(PROVIDERS_SOURCES))  # Exclude DESX HW with FIPS indicators
-PROVIDERS_SOURCES := $(filter-out providers/implementations/ciphers/cipher_rc5.c,$(PROVIDERS_SOURCES))  # Exclude RC5 cipher (patented algorithm)
-PROVIDERS_SOURCES := $(filter-out providers/implementations/ciphers/cipher_rc5_hw.c,$(PROVIDERS_SOURCES))  # Exclude RC5 HW cipher
-PROVIDERS_SOURCES := $(filter-out providers/implementations/ciphers/cipher_tdes.c,$(PROVIDERS_SOURCES))  # Exclude TDES with FIPS indicators
-PROVIDERS_SOURCES := $(filter-out providers/implementations/ciphers/cipher_tdes_common.c,$(PROVIDERS_SOURCES))  # Exclude TDES common with FIPS indicators
-PROVIDERS_SOURCES := $(filter-out providers/implementations/ciphers/cipher_tdes_default.c,$(PROVIDERS_SOURCES))  # Exclude TDES default with FIPS indicators
-PROVIDERS_SOURCES := $(filter-out providers/implementations/ciphers/cipher_tdes_default_hw.c,$(PROVIDERS_SOURCES))  # Exclude TDES default HW with FIPS indicators
-PROVIDERS_SOURCES := $(filter-out providers/implementations/ciphers/cipher_tdes_hw.c,$(PROVIDERS_SOURCES))  # Exclude TDES HW with FIPS indicators
-PROVIDERS_SOURCES := $(filter-out providers/implementations/ciphers/cipher_tdes_wrap.c,$(PROVIDERS_SOURCES))  # Exclude TDES wrap with FIPS indicators
-PROVIDERS_SOURCES := $(filter-out providers/implementations/ciphers/cipher_tdes_wrap_hw.c,$(PROVIDERS_SOURCES))  # Exclude TDES wrap HW with FIPS indicators
-PROVIDERS_SOURCES := $(filter-out providers/implementations/digests/md2_prov.c,$(PROVIDERS_SOURCES))  # Exclude MD2 provider (deprecated)
-PROVIDERS_SOURCES := $(filter-out providers/implementations/digests/md4_prov.c,$(PROVIDERS_SOURCES))  # Exclude MD4 provider (deprecated)
-PROVIDERS_OBJECTS = $(PROVIDERS_SOURCES:.c=.o)
-
-# Pseudo targets for object compilation
-crypto_objects: $(CRYPTO_OBJECTS)
-ssl_objects: $(SSL_OBJECTS)
-providers: $(PROVIDERS_OBJECTS)
-
-# Installation targets
+{build_rules}# Installation targets
 install: install_libs install_headers install_apps install_docs
 
 install_libs: build_libs
@@ -507,14 +884,15 @@ install_dev: install_sw install_ssldirs
 # Clean targets
 clean:
 	@echo "Cleaning build artifacts..."
-	@rm -f *.o crypto/*.o crypto/*/*.o ssl/*.o apps/*.o providers/*.o providers/*/*.o
+	@find . -type f \\( -name "*.o" -o -name "*.o.d" \\) -delete
 	@rm -f libcrypto.a libssl.a
 	@rm -f apps/openssl
 	@find . -name "*.so" -delete
 
 distclean: clean
 	@echo "Removing generated files..."
-	@rm -f Makefile configdata.pm include/openssl/buildinf.h openssl.cps
+	@rm -f Makefile build.ninja .ninja_log .ninja_deps configdata.pm include/openssl/buildinf.h openssl.cps
+	@rm -rf unity
 	@rm -rf $(LIBDIR) $(INCDIR) $(BINDIR)
 
 # Test target
@@ -536,24 +914,492 @@ help:
 	@echo "  test         - Run tests"
 	@echo "  help         - Show this help"
 
-.PHONY: all build_libs build_apps install install_sw install_ssldirs install_dev clean distclean test help crypto_objects ssl_objects providers
+.PHONY: all build_libs build_apps install install_sw install_ssldirs install_dev clean distclean test help crypto_objects ssl_objects providers{extra_phony}
 '''
 
         return makefile
 
+    def _load_build_graph(self) -> Optional[BuildInfoGraph]:
+        """The build.info graph when --sources selects it, else None (SOURCE_GROUPS)."""
+        if self._graph is not None:
+            return self._graph
+        if self.sources == 'glob' or (self.sources == 'auto' and (self.unity or not os.path.exists('build.info'))):
+            return None
+        if self.unity:
+            print("Warning: --unity builds from SOURCE_GROUPS, ignoring --sources=build.info", file=sys.stderr)
+            return None
+
+        disabled = (BUILDINFO_DEFAULT_DISABLED - self.enabled_features) | self.disabled_features | {'asm'}
+        if not self.build_config.get('shared', False):
+            disabled.add('shared')
+        if not self.build_config.get('threads', True):
+            disabled.add('threads')
+        if self.build_config.get('enable_fips', False):
+            disabled.discard('fips')
+        pending = list(disabled)
+        while pending:
+            for feature in BUILDINFO_CASCADES.get(pending.pop(), []):
+                if feature not in disabled:
+                    disabled.add(feature)
+                    pending.append(feature)
+        windows = self.system == 'windows'
+        config = {'target': self.target or '', 'processor': '',
+                  'build_type': 'debug' if self.debug else 'release'}
+        target = {'asm_arch': '', 'sys_id': '', 'dso_scheme': 'win32' if windows else 'dlfcn',
+                  'thread_scheme': 'winthreads' if windows else 'pthreads'}
+        graph = BuildInfoGraph(disabled, config, target).read()
+
+        missing = [lib for lib in ('libcrypto.a', 'libssl.a') if lib not in graph.archives]
+        if missing:
+            if self.sources == 'build.info':
+                raise RuntimeError(f"build.info tree defines no {', '.join(missing)}")
+            print(f"Warning: build.info tree defines no {', '.join(missing)}, using SOURCE_GROUPS",
+                  file=sys.stderr)
+            return None
+        if not self.quiet:
+            print(f"Read {len(graph.files)} build.info files: {len(graph.objects)} objects, "
+                  f"{len(graph.archives)} archives, {len(graph.programs)} programs")
+            for warning in graph.warnings if self.debug else graph.warnings[:5]:
+                print(f"Warning: {warning}", file=sys.stderr)
+            if len(graph.warnings) > 5 and not self.debug:
+                print(f"Warning: {len(graph.warnings) - 5} more build.info warnings (--debug lists them)",
+                      file=sys.stderr)
+        return graph
+
+    @staticmethod
+    def _graph_groups(graph: BuildInfoGraph) -> Dict[str, List[str]]:
+        """Objects behind the crypto_objects, ssl_objects and providers targets."""
+        crypto = [o for o in graph.archives['libcrypto.a'] if not o.startswith('providers/')]
+        providers = sorted({o for o in graph.objects if o.startswith('providers/')})
+        return {'CRYPTO': crypto, 'SSL': graph.archives['libssl.a'], 'PROVIDERS': providers}
+
+    @staticmethod
+    def _make_var(product: str) -> str:
+        return re.sub(r'\W', '_', product).upper() + '_OBJECTS'
+
+    def _make_graph_rules(self, graph: BuildInfoGraph) -> str:
+        """
+        Makefile rules for the build.info graph: explicit prerequisites on
+        every archive, program and object, and -MMD -MP depfiles so a header
+        edit rebuilds only the objects that include it.
+        """
+        def wrap(items: List[str]) -> str:
+            return " \\\n\t".join(items)
+
+        installed = [lib for lib in graph.archives if lib in ('libcrypto.a', 'libssl.a')]
+        lines = [
+            f"# Object graph from {len(graph.files)} build.info files (configure.py --sources=build.info)",
+            "EX_LIBS = " + ("-ldl -pthread" if self.system == 'linux' else ""),
+            "",
+            "all: build_libs build_apps",
+            "",
+            "build_libs: " + " ".join(installed),
+            "",
+            "build_apps: build_libs " + " ".join(graph.programs),
+            "",
+        ]
+        for name, objects in self._graph_groups(graph).items():
+            lines.append(f"{name}_OBJECTS = {wrap(objects)}")
+        lines += [
+            "",
+            "crypto_objects: $(CRYPTO_OBJECTS)",
+            "ssl_objects: $(SSL_OBJECTS)",
+            "providers: $(PROVIDERS_OBJECTS)",
+            "",
+        ]
+        for lib, members in graph.archives.items():
+            var = self._make_var(lib)
+            lines += [
+                f"{var} = {wrap(members)}",
+                f"{lib}: $({var})",
+                f"\t@echo \"Building {lib}...\"",
+                "\trm -f $@",
+                f"\t$(AR) rcs $@ $({var})",
+                "\t$(RANLIB) $@",
+                "",
+            ]
+        for program, (objects, archives) in graph.programs.items():
+            var = self._make_var(program)
+            lines += [
+                f"{var} = {wrap(objects)}",
+                f"{program}: $({var}) {' '.join(archives)}",
+                f"\t@echo \"Building {program}...\"",
+                f"\t$(CC) $(CFLAGS) $(LDFLAGS) -o $@ $({var}) {' '.join(archives)} $(EX_LIBS)",
+                "",
+            ]
+
+        # One flags variable per distinct INCLUDE/DEFINE set keeps the rules short
+        flag_sets: Dict[Tuple[str, ...], str] = {}
+        lines.append("# Per-object compile rules")
+        for flags in dict.fromkeys(flags for _, flags in graph.objects.values()):
+            if flags:
+                flag_sets[flags] = f"$(BI_FLAGS_{len(flag_sets)}) "
+                lines.append(f"BI_FLAGS_{len(flag_sets) - 1} = {' '.join(flags)}")
+        lines.append("")
+        for obj, (source, flags) in graph.objects.items():
+            lines += [
+                f"{obj}: {source}",
+                f"\t$(CC) $(CPPFLAGS) $(CFLAGS) -Iinclude -I. {flag_sets.get(flags, '')}-MMD -MP -MF $@.d -c $< -o $@",
+            ]
+        lines += [
+            "",
+            "DEPS = " + wrap(obj + '.d' for obj in graph.objects),
+            "-include $(DEPS)",
+            "",
+            "# Re-run configure.py when it or a build.info changes",
+            f"Makefile: {' '.join(shlex.quote(p) for p in [self._script_path()] + graph.files)}",
+            f"\t{shlex.quote(sys.executable)} {shlex.quote(self._script_path())} "
+            f"{' '.join(shlex.quote(a) for a in self.argv)}",
+            "",
+        ]
+        return "\n".join(lines) + "\n"
+
+    @staticmethod
+    def _script_path() -> str:
+        """configure.py, relative when it lives inside the build tree."""
+        script = os.path.abspath(__file__)
+        if os.path.commonpath([script, os.getcwd()]) == os.getcwd():
+            script = os.path.relpath(script)
+        return script
+
+    def _make_build_rules(self) -> str:
+        """Makefile rules that compile and archive everything with make."""
+        return '''# Main targets
+all: build_libs build_apps
+
+build_libs: providers libcrypto.a libssl.a
+
+build_apps: build_libs apps/openssl
+
+# Library targets - build directly without subdirectories
+libcrypto.a: $(CRYPTO_OBJECTS)
+	@echo "Building libcrypto.a..."
+	$(AR) rcs libcrypto.a $(CRYPTO_OBJECTS)
+	$(RANLIB) libcrypto.a
+
+libssl.a: $(SSL_OBJECTS)
+	@echo "Building libssl.a..."
+	$(AR) rcs libssl.a $(SSL_OBJECTS)
+	$(RANLIB) libssl.a
+
+# Application targets
+apps/openssl: apps/openssl.o libcrypto.a libssl.a
+	@echo "Building openssl binary..."
+	$(CC) $(CPPFLAGS) $(CFLAGS) $(LDFLAGS) apps/openssl.o $(LIBS) -o apps/openssl
+
+# Object compilation rules
+%.o: %.c
+	$(CC) $(CPPFLAGS) $(CFLAGS) -Iinclude -I. -Iproviders/common/include -Iproviders/implementations/include -MMD -MP -MF $@.d -c $< -o $@
+
+''' + self._make_source_collections() + '''
+# Pseudo targets for object compilation
+crypto_objects: $(CRYPTO_OBJECTS)
+ssl_objects: $(SSL_OBJECTS)
+providers: $(PROVIDERS_OBJECTS)
+
+# Header dependencies recorded by -MMD on the previous build
+-include $(wildcard $(addsuffix .d,$(CRYPTO_OBJECTS) $(SSL_OBJECTS) $(PROVIDERS_OBJECTS) apps/openssl.o))
+
+'''
+
+    def _make_source_collections(self) -> str:
+        """SOURCE_GROUPS as $(wildcard)/$(filter-out) Makefile variables."""
+        if self.unity:
+            return self._make_unity_collections()
+        lines = ["# Source file collections - exclude architecture-specific files when not supported"]
+        for name, patterns, excludes in SOURCE_GROUPS:
+            lines.append(f"{name}_SOURCES = $(wildcard {' '.join(patterns)})")
+            for pattern, reason in excludes:
+                comment = f"  # {reason}" if reason else ""
+                lines.append(f"{name}_SOURCES := $(filter-out {pattern},$({name}_SOURCES)){comment}")
+            lines.append(f"{name}_OBJECTS = $({name}_SOURCES:.c=.o)")
+            lines.append("")
+        return "\n".join(lines)
+
+    def _make_unity_collections(self) -> str:
+        """Explicit unity object lists; each unit depends on the sources it includes."""
+        lines = [f"# Unity build (configure.py --unity): up to {self.unity_batch_size} sources per unit"]
+        for name, patterns, excludes in SOURCE_GROUPS:
+            units = self._compile_units(name, patterns, excludes)
+            lines.append(f"{name}_OBJECTS = " + " \\\n\t".join(unit[:-2] + '.o' for unit, _ in units))
+            lines.append("")
+            for unit, included in units:
+                if included != [unit]:
+                    lines.append(f"{unit[:-2]}.o: {' '.join(included)}")
+            lines.append("")
+        return "\n".join(lines)
+
+    def _compile_units(self, name: str, patterns: List[str],
+                       excludes: List[Tuple[str, Optional[str]]]) -> List[Tuple[str, List[str]]]:
+        """
+        (source to compile, sources it covers) for one SOURCE_GROUPS entry.
+
+        Without --unity every source is its own unit. With --unity the sources
+        of each directory are concatenated into unity/<dir>_<n>.c files that
+        #include them. A unit is closed early when the next source would
+        redefine a static symbol, type or macro already in it, and sources
+        that #define anything before their first #include (they tune the
+        headers they pull in) are compiled on their own.
+        """
+        if name in self._units:
+            return self._units[name]
+        sources = self._collect_sources(patterns, excludes)
+        if not self.unity:
+            self._units[name] = [(src, [src]) for src in sources]
+            return self._units[name]
+
+        by_dir: Dict[str, List[str]] = {}
+        for src in sources:
+            by_dir.setdefault(os.path.dirname(src), []).append(src)
+
+        units: List[Tuple[str, List[str]]] = []
+        os.makedirs('unity', exist_ok=True)
+        for directory, files in by_dir.items():
+            batches: List[List[str]] = []
+            batch: List[str] = []
+            seen: Set[str] = set()
+            for src in files:
+                symbols = self._unity_symbols(src)
+                if symbols is None:
+                    units.append((src, [src]))
+                    continue
+                if batch and (len(batch) >= self.unity_batch_size or symbols & seen):
+                    batches.append(batch)
+                    batch, seen = [], set()
+                batch.append(src)
+                seen |= symbols
+            if batch:
+                batches.append(batch)
+            for n, batch in enumerate(batches):
+                if len(batch) == 1:
+                    units.append((batch[0], batch))
+                    continue
+                unit = f"unity/{directory.replace('/', '_')}_{n}.c"
+                content = "/* Generated by configure.py --unity - do not edit */\n" + "".join(
+                    f'#include "{src}"\n' for src in batch)
+                self._write_if_changed(unit, content)
+                units.append((unit, batch))
+        self._units[name] = units
+        return units
+
+    _STATIC_DEF = re.compile(r'^static\s+(?:const\s+)?[\w\s\*]*?\b(\w+)\s*(?:\(|\[|=|;)', re.M)
+    _TYPE_DEF = re.compile(r'^(?:typedef\s+)?(?:struct|union|enum)\s+(\w+)\s*\{|^typedef\b[^;{]*?\b(\w+)\s*;', re.M)
+    _MACRO_DEF = re.compile(r'^\s*#\s*define\s+(\w+)', re.M)
+
+    def _unity_symbols(self, path: str) -> Optional[Set[str]]:
+        """File-scope names a source defines, or None if it must not join a unit."""
+        try:
+            with open(path, 'r', errors='replace') as f:
+                text = f.read()
+        except OSError:
+            return None
+        first_include = text.find('#include')
+        first_define = self._MACRO_DEF.search(text)
+        if first_define and (first_include < 0 or first_define.start() < first_include):
+            return None
+        symbols = set(self._STATIC_DEF.findall(text)) | set(self._MACRO_DEF.findall(text))
+        for struct, typedef in self._TYPE_DEF.findall(text):
+            symbols.add(struct or typedef)
+        return symbols
+
+    def _ninja_forward_rules(self) -> str:
+        """Makefile rules handing every build target to ninja."""
+        targets = " ".join(NINJA_TARGETS)
+        return f'''# Build targets are provided by build.ninja (configure.py --generator=ninja)
+NINJA = ninja
+
+# ninja schedules the compile jobs itself; never run two instances at once
+.NOTPARALLEL:
+
+{targets}:
+	$(NINJA) $@
+
+'''
+
+    @staticmethod
+    def _write_if_changed(path: str, content: str) -> bool:
+        """Write content unless the file already holds it; True if written."""
+        try:
+            with open(path, 'r') as f:
+                if f.read() == content:
+                    return False
+        except OSError:
+            pass
+        with open(path, 'w') as f:
+            f.write(content)
+        return True
+
+    @staticmethod
+    def _collect_sources(patterns: List[str], excludes: List[Tuple[str, Optional[str]]]) -> List[str]:
+        """Expand a SOURCE_GROUPS entry the way $(wildcard) and $(filter-out) do."""
+        exclude_globs = [pattern.replace('%', '*') for pattern, _ in excludes]
+        sources = []
+        for pattern in patterns:
+            for path in sorted(glob.glob(pattern)):
+                path = path.replace(os.sep, '/')
+                if not any(fnmatch.fnmatchcase(path, g) for g in exclude_globs):
+                    sources.append(path)
+        return sources
+
+    @staticmethod
+    def _ninja_escape(value: str) -> str:
+        """Escape a path for use in a ninja build statement."""
+        return value.replace('$', '$$').replace(' ', '$ ').replace(':', '$:')
+
+    def _generate_ninja_content(self, openssldir: str) -> str:
+        """
+        Generate build.ninja: one compile edge per object with a gcc-style
+        depfile (-MD -MF), so header edits rebuild exactly the objects that
+        include them and a no-op build is a stat() pass. The build.ninja edge
+        re-runs configure.py when it (or, with --sources=build.info, a
+        build.info) changes; restat and _write_if_changed keep an unchanged
+        regeneration from dirtying anything.
+        """
+        cc = self._detect_compiler()
+        esc = self._ninja_escape
+        graph = self._graph
+        cppflags = (f'-DOPENSSLDIR=\\"{openssldir}\\" '
+                    f'-DENGINESDIR=\\"{os.path.join(openssldir, "engines")}\\" '
+                    f'-DMODULESDIR=\\"{os.path.join(openssldir, "modules")}\\"')
+        script = self._script_path()
+        configure_args = " ".join(shlex.quote(a) for a in self.argv)
+
+        lines = [
+            "# Generated by Python configure.py --generator=ninja",
+            "# Do not edit manually - regenerate with: python3 configure.py [options]",
+            "ninja_required_version = 1.3",
+            "",
+            f"cc = {cc}",
+            f"ar = {self._tool('AR', 'ar')}",
+            f"ranlib = {self._tool('RANLIB', 'ranlib')}",
+            f"cflags = {self._get_cflags()}",
+            f"cppflags = {cppflags}",
+            "includes = -Iinclude -I." + ("" if graph else " -Iproviders/common/include -Iproviders/implementations/include"),
+            f"ldflags = {self._get_ldflags()}",
+            f"libs = {self._get_libs()}",
+            "",
+            "rule cc",
+            "  command = $cc -MD -MF $out.d $cppflags $cflags $includes $flags -c $in -o $out",
+            "  depfile = $out.d",
+            "  deps = gcc",
+            "  description = CC $out",
+            "",
+            "rule ar",
+            "  command = rm -f $out && $ar rcs $out $in && $ranlib $out",
+            "  description = AR $out",
+            "",
+            "rule link",
+            "  command = $cc $cppflags $cflags $ldflags $in $libs -o $out",
+            "  description = LINK $out",
+            "",
+            "rule configure",
+            f"  command = {sys.executable.replace('$', '$$')} {script.replace('$', '$$')} "
+            f"{configure_args.replace('$', '$$')}",
+            "  generator = 1",
+            "  restat = 1",
+            "  description = CONFIGURE (configure.py changed)",
+            "",
+            f"build build.ninja: configure {esc(script)}"
+            + (" | " + " ".join(esc(f) for f in graph.files) if graph else ""),
+            "",
+        ]
+        if graph is not None:
+            return "\n".join(lines + self._ninja_graph_edges(graph))
+
+        objects: Dict[str, List[str]] = {}
+        for name, patterns, excludes in SOURCE_GROUPS:
+            objects[name] = []
+            lines.append(f"# {name.lower()} sources{' (unity)' if self.unity else ''}")
+            for source, _ in self._compile_units(name, patterns, excludes):
+                obj = source[:-2] + '.o'
+                objects[name].append(esc(obj))
+                lines.append(f"build {esc(obj)}: cc {esc(source)}")
+            lines.append("")
+
+        crypto, ssl, providers = objects['CRYPTO'], objects['SSL'], objects['PROVIDERS']
+        lines += [
+            "build apps/openssl.o: cc apps/openssl.c",
+            "",
+            "build libcrypto.a: ar " + " ".join(crypto),
+            "build libssl.a: ar " + " ".join(ssl) + " || libcrypto.a",
+            "build apps/openssl: link apps/openssl.o | libcrypto.a libssl.a",
+            "",
+            "build crypto_objects: phony " + " ".join(crypto),
+            "build ssl_objects: phony " + " ".join(ssl),
+            "build providers: phony " + " ".join(providers),
+            "build build_libs: phony providers libcrypto.a libssl.a",
+            "build build_apps: phony build_libs apps/openssl",
+            "build all: phony build_libs build_apps",
+            "",
+            "default all",
+            "",
+        ]
+        return "\n".join(lines)
+
+    def _ninja_graph_edges(self, graph: BuildInfoGraph) -> List[str]:
+        """build.ninja edges for the build.info graph."""
+        esc = self._ninja_escape
+        lines = ["# Objects from build.info"]
+        for obj, (source, flags) in graph.objects.items():
+            lines.append(f"build {esc(obj)}: cc {esc(source)}")
+            if flags:
+                lines.append(f"  flags = {' '.join(flags).replace('$', '$$')}")
+        lines.append("")
+        for lib, members in graph.archives.items():
+            lines.append(f"build {esc(lib)}: ar " + " ".join(esc(o) for o in members))
+        ex_libs = "-ldl -pthread" if self.system == 'linux' else ""
+        for program, (objects, archives) in graph.programs.items():
+            lines += [
+                f"build {esc(program)}: link " + " ".join(esc(o) for o in objects + archives),
+                f"  libs = {ex_libs}",
+            ]
+        groups = self._graph_groups(graph)
+        installed = [lib for lib in graph.archives if lib in ('libcrypto.a', 'libssl.a')]
+        lines += [
+            "",
+            "build crypto_objects: phony " + " ".join(esc(o) for o in groups['CRYPTO']),
+            "build ssl_objects: phony " + " ".join(esc(o) for o in groups['SSL']),
+            "build providers: phony " + " ".join(esc(o) for o in groups['PROVIDERS']),
+            "build build_libs: phony " + " ".join(installed),
+            "build build_apps: phony build_libs " + " ".join(esc(p) for p in graph.programs),
+            "build all: phony build_libs build_apps",
+            "",
+            "default all",
+            "",
+        ]
+        return lines
+
+    def _tool(self, variable: str, default: str) -> str:
+        """AR/RANLIB command, with the cross-compile prefix"""
+        return self.cross_compile_prefix + self.variables.get(variable, default)
+
     def _detect_compiler(self) -> str:
-        """Detect available compiler."""
-        # Try to detect compiler from environment or system
-        cc = os.environ.get('CC', 'gcc')
-        if os.path.exists(cc) or shutil.which(cc):
-            return cc
+        """Detect available compiler, keeping a ccache/sccache launcher prefix."""
+        # Try to detect compiler from environment or system. CC may carry a
+        # launcher ("ccache gcc"); CC_LAUNCHER adds one to a plain compiler.
+        cc = self.variables.get('CC') or os.environ.get('CC', 'gcc')
+        launcher = self.variables.get('CC_LAUNCHER') or os.environ.get('CC_LAUNCHER', '')
+        words = cc.split()
+        if len(words) > 1 and os.path.basename(words[0]) in ('ccache', 'sccache'):
+            launcher, words = words[0], words[1:]
+        if launcher and not shutil.which(launcher):
+            print(f"Warning: compiler launcher {launcher} not found, ignoring it", file=sys.stderr)
+            launcher = ''
+        prefix = f"{launcher} " if launcher else ''
+
+        compiler = words[0] if words else 'gcc'
+        if self.cross_compile_prefix:
+            # No native fallback: that would build for the wrong target
+            return prefix + ' '.join([self.cross_compile_prefix + compiler] + words[1:])
+        if os.path.exists(compiler) or shutil.which(compiler):
+            return prefix + ' '.join(words)
 
         # Fallback to common compilers
         for compiler in ['gcc', 'clang', 'cc']:
             if shutil.which(compiler):
-                return compiler
+                return prefix + compiler
 
-        return 'gcc'  # Ultimate fallback
+        return prefix + 'gcc'  # Ultimate fallback
 
     def _get_cflags(self) -> str:
         """Get appropriate C compiler flags."""
@@ -584,6 +1430,12 @@ help:
         if self.build_config.get('shared', False):
             base_flags += " -fPIC"
 
+        # User flags (LTO, -march tuning, PGO) and CFLAGS= override last
+        if self.extra_cflags:
+            base_flags += " " + " ".join(self.extra_cflags)
+        if self.variables.get('CFLAGS'):
+            base_flags += " " + self.variables['CFLAGS']
+
         return base_flags
 
     def _get_ldflags(self) -> str:
@@ -595,8 +1447,17 @@ help:
 
         if self.build_config.get('shared', False):
             flags += " -shared"
+            # -Bsymbolic-functions binds the libraries' calls to their own
+            # exported functions at link time (no PLT, no interposition)
+            if self.shared_ldflags:
+                flags += " " + " ".join(self.shared_ldflags)
+
+        if self.extra_ldflags:
+            flags += " " + " ".join(self.extra_ldflags)
+        if self.variables.get('LDFLAGS'):
+            flags += " " + self.variables['LDFLAGS']
 
-        return flags
+        return flags.strip()
 
     def _get_libs(self) -> str:
         """Get required libraries."""
@@ -659,17 +1520,27 @@ help:
                 print(f"  {lib}")
 
         print("\nConfiguration completed successfully!")
-        print("Run 'make' to build OpenSSL.")
+        if self.generator == 'ninja':
+            print("Run 'ninja' (or 'make', which forwards to it) to build OpenSSL.")
+        else:
+            print("Run 'make' to build OpenSSL.")
 
     def run(self, args: List[str]) -> int:
         """Main execution method."""
-        # Detect platform if no target specified
-        if not self.target:
-            self.target = self.detect_platform()
-
         # Parse command line arguments
+        self.argv = list(args)
         self.parse_arguments(args)
 
+        # Detect platform if no target specified; a given target (cross
+        # builds) decides the architecture flags instead of this host
+        if not self.target:
+            self.target = self.detect_platform()
+        else:
+            for (system, machine), target in self.PLATFORM_TARGETS.items():
+                if target == self.target:
+                    self.system, self.machine = system, machine
+                    break
+
         if self.debug:
             print(f"Debug: Target = {self.target}")
             print(f"Debug: System = {self.system}")
@@ -10,10 +10,15 @@ class SpareToolsOpenSSLToolsMiniConan(ConanFile):
     url = "https://github.com/sparesparrow/sparetools"
     
     exports_sources = "openssl_tools/**", "scripts/**"
+
+    python_requires = "sparetools-base/2.0.0"
     
     def package(self):
         copy(self, "*.py", src=self.source_folder, dst=self.package_folder, keep_path=True)
         copy(self, "*.sh", src=self.source_folder, dst=self.package_folder, keep_path=True)
+        # Ship the tracing module: a python_requires never puts sparetools-base on PYTHONPATH
+        copy(self, "sparetools_tracing.py", src=self.python_requires["sparetools-base"].path,
+             dst=self.package_folder)
     
     def package_info(self):
         self.cpp_info.libs = []
@@ -5,17 +5,35 @@ Coordinates multi-phase build process and CMake integration
 
 import os
 import shutil
+import threading
+import time
+from concurrent.futures import FIRST_COMPLETED, Future, ThreadPoolExecutor, wait
 from pathlib import Path
 from typing import Dict, List, Optional, Any
-from dataclasses import dataclass
+from dataclasses import dataclass, field
+
+try:
+    from sparetools_tracing import SpanContext, current_context, span
+except ImportError:  # sparetools-base not on PYTHONPATH: tracing is off
+    import contextlib
+
+    SpanContext = Any
+
+    def current_context():
+        return None
+
+    @contextlib.contextmanager
+    def span(name, parent=None, **attributes):
+        yield type("Span", (), {"set_attribute": lambda self, key, value: None})()
 
 
 @dataclass
 class BuildPhase:
-    """Represents a build phase"""
+    """Represents a build phase; it starts once every phase in depends_on succeeded"""
     name: str
     description: str
     required: bool = True
+    depends_on: List[str] = field(default_factory=list)
 
 
 @dataclass
@@ -40,48 +58,136 @@ class BuildOrchestrator:
     4. Test - Unit and integration tests
     5. FIPS Validation - FIPS compliance checks
     6. Installation - Package installation and verification
+
+    The phases form a dependency graph rather than a sequence: test, FIPS
+    validation and installation staging all need only the build, so they
+    run concurrently and a configuration takes as long as its longest
+    path. The build still fails if a required phase does, installed or not.
+
+    The build and each phase are traced (see sparetools-base/sparetools_tracing.py); phases run in
+    worker threads, so they get the build's span as an explicit parent.
     """
 
     def __init__(self, config: BuildConfig):
         self.config = config
         self.phases = [
             BuildPhase("preparation", "Source setup and dependency validation"),
-            BuildPhase("configuration", "CMake/configure script execution"),
-            BuildPhase("build", "Compilation and linking"),
-            BuildPhase("test", "Unit and integration tests"),
-            BuildPhase("fips_validation", "FIPS compliance validation", required=False),
-            BuildPhase("installation", "Package installation and verification"),
+            BuildPhase("configuration", "CMake/configure script execution", depends_on=["preparation"]),
+            BuildPhase("build", "Compilation and linking", depends_on=["configuration"]),
+            BuildPhase("test", "Unit and integration tests", depends_on=["build"]),
+            BuildPhase("fips_validation", "FIPS compliance validation", required=False,
+                       depends_on=["build"]),
+            BuildPhase("installation", "Package installation and verification", depends_on=["build"]),
         ]
+        self.phase_results: Dict[str, Dict[str, Any]] = {}
+        self._lock = threading.Lock()
 
-    def execute_build(self) -> bool:
+    def _phase(self, name: str) -> BuildPhase:
+        return next(phase for phase in self.phases if phase.name == name)
+
+    def _run_phase(self, phase: BuildPhase, parent: Optional[SpanContext] = None) -> bool:
+        print(f"Executing phase: {phase.name} - {phase.description}")
+        started = time.perf_counter()
+        with span(f"phase {phase.name}", parent=parent, required=phase.required,
+                  build_dir=str(self.config.build_dir)) as phase_span:
+            try:
+                success = bool(getattr(self, f"_execute_{phase.name}_phase")())
+                error = None
+            except Exception as e:
+                success, error = False, str(e)
+            phase_span.set_attribute("success", success)
+        with self._lock:
+            self.phase_results[phase.name] = {
+                "success": success,
+                "seconds": time.perf_counter() - started,
+                **({"error": error} if error else {}),
+            }
+        if not success:
+            kind = "Required" if phase.required else "Optional"
+            detail = f" with error: {error}" if error else ""
+            print(f"{kind} phase {phase.name} failed{detail}" + ("" if phase.required else ", continuing"))
+        return success
+
+    def execute_build(self, prepared: Optional[Future] = None) -> bool:
         """
-        Execute the complete build process
+        Execute the complete build process, each phase as soon as its
+        dependencies have succeeded
+
+        Args:
+            prepared: Future of this configuration's preparation phase when
+                it was already started (see execute_matrix)
 
         Returns:
             True if build successful, False otherwise
         """
-        print(f"Starting OpenSSL build in {self.config.build_dir}")
+        with span("openssl build", build_dir=str(self.config.build_dir), fips=self.config.fips_enabled,
+                  shared=self.config.shared_libs) as build_span:
+            success = self._execute_phases(prepared, build_span.context)
+            build_span.set_attribute("success", success)
+        return success
 
-        for phase in self.phases:
-            print(f"Executing phase: {phase.name} - {phase.description}")
+    def _execute_phases(self, prepared: Optional[Future], parent: Optional[SpanContext]) -> bool:
+        """execute_build() inside its span; parent is that span's context"""
+        print(f"Starting OpenSSL build in {self.config.build_dir}")
+        by_name = {phase.name: phase for phase in self.phases}
+        done: Dict[str, bool] = {}
+        failed = False
 
-            try:
-                success = getattr(self, f"_execute_{phase.name}_phase")()
-                if not success and phase.required:
-                    print(f"Required phase {phase.name} failed")
-                    return False
-                elif not success:
-                    print(f"Optional phase {phase.name} failed, continuing")
-            except Exception as e:
-                if phase.required:
-                    print(f"Phase {phase.name} failed with error: {e}")
-                    return False
-                else:
-                    print(f"Optional phase {phase.name} failed with error: {e}, continuing")
+        with ThreadPoolExecutor(max_workers=len(self.phases)) as pool:
+            running: Dict[Future, BuildPhase] = {}
+            if prepared is not None and "preparation" in by_name:
+                running[prepared] = by_name["preparation"]
+            while True:
+                if not failed:
+                    for phase in self.phases:
+                        if phase.name in done or phase in running.values():
+                            continue
+                        if all(done.get(dep) for dep in phase.depends_on):
+                            running[pool.submit(self._run_phase, phase, parent)] = phase
+                if not running:
+                    break
+                finished, _ = wait(running, return_when=FIRST_COMPLETED)
+                for future in finished:
+                    phase = running.pop(future)
+                    try:
+                        success = future.result()
+                    except Exception as e:
+                        print(f"Phase {phase.name} failed with error: {e}")
+                        success = False
+                    # Optional phases never hold up their dependents
+                    done[phase.name] = success or not phase.required
+                    if not success and phase.required:
+                        failed = True  # Start nothing new; let running phases finish
 
+        if failed:
+            return False
         print("Build completed successfully")
         return True
 
+    @classmethod
+    def execute_matrix(cls, configs: List[BuildConfig]) -> List[bool]:
+        """
+        Build several configurations one after another, running the next
+        configuration's preparation (source download and verification)
+        while the current one builds
+        """
+        results = []
+        orchestrators = [cls(config) for config in configs]
+        with span("openssl build matrix", configurations=len(configs)), \
+                ThreadPoolExecutor(max_workers=1) as prefetch:
+            # Prefetched preparations run before their build's span exists
+            parent = current_context()
+            pending: Optional[Future] = None
+            for i, orchestrator in enumerate(orchestrators):
+                prepared = pending or prefetch.submit(orchestrator._run_phase,
+                                                      orchestrator._phase("preparation"), parent)
+                pending = None
+                if i + 1 < len(orchestrators):
+                    upcoming = orchestrators[i + 1]
+                    pending = prefetch.submit(upcoming._run_phase, upcoming._phase("preparation"), parent)
+                results.append(orchestrator.execute_build(prepared=prepared))
+        return results
+
     def _execute_preparation_phase(self) -> bool:
         """Prepare build environment"""
         try:
@@ -181,5 +287,6 @@ class BuildOrchestrator:
             "fips_enabled": self.config.fips_enabled,
             "shared_libs": self.config.shared_libs,
             "cross_compiling": self.config.cross_compiling,
-            "phases": [phase.name for phase in self.phases]
+            "phases": [phase.name for phase in self.phases],
+            "phase_results": dict(self.phase_results),
         }
\ No newline at end of file
@@ -1,3 +1,5 @@
+import os
+
 from conan import ConanFile
 from conan.tools.files import copy
 
@@ -16,7 +18,14 @@ class SpareToolsOpenSSLToolsConan(ConanFile):
     def package(self):
         copy(self, "*.py", src=self.source_folder, dst=self.package_folder, keep_path=True)
         copy(self, "*.sh", src=self.source_folder, dst=self.package_folder, keep_path=True)
+        # Ship the tracing module: a python_requires never puts sparetools-base on PYTHONPATH
+        copy(self, "sparetools_tracing.py", src=self.python_requires["sparetools-base"].path,
+             dst=self.package_folder)
         copy(self, "profiles/**", src=self.source_folder, dst=self.package_folder, keep_path=True)
+        # Consuming recipes import these modules in Conan's interpreter on
+        # every conan create; ship the bytecode instead of compiling it there
+        self.python_requires["sparetools-base"].module.precompile_python(
+            self, os.path.join(self.package_folder, "openssl_tools"))
     
     def package_info(self):
         self.cpp_info.libs = []
@@ -0,0 +1,64 @@
+#!/usr/bin/env python3
+"""
+Reader for the artifact manifest packages write at package() time
+
+sparetools-base's write_artifact_manifest lists every packaged file in
+res/sparetools-artifacts.json with path, size, sha256 and kind
+(shared_library, static_library, module, executable, header, config,
+trust, license, debug_symbols, other). Consumers that need the package's
+files or a summary read it instead of walking and opening the tree.
+Without a manifest (older packages) they fall back to walking.
+"""
+
+import json
+from pathlib import Path
+from typing import Dict, Iterable, List, Optional
+
+ARTIFACT_MANIFEST = "res/sparetools-artifacts.json"
+MANIFEST_FORMAT = "sparetools-artifacts/1"
+
+# What the orchestrator reports as build artifacts
+BINARY_KINDS = ("shared_library", "static_library", "module", "executable")
+
+
+def find_manifest(folder: Path) -> Optional[Path]:
+    """Manifest of a package folder, or of a CI artifact holding one at its top"""
+    folder = Path(folder)
+    for candidate in (folder / ARTIFACT_MANIFEST, folder / Path(ARTIFACT_MANIFEST).name):
+        if candidate.is_file():
+            return candidate
+    return None
+
+
+def load_manifest(folder: Path) -> Optional[Dict]:
+    """Parsed manifest of folder, None if absent, unreadable or of another format"""
+    path = find_manifest(folder)
+    if path is None:
+        return None
+    try:
+        with open(path) as f:
+            manifest = json.load(f)
+    except (OSError, ValueError):
+        return None
+    return manifest if manifest.get("format") == MANIFEST_FORMAT else None
+
+
+def artifact_paths(folder: Path, manifest: Dict, kinds: Iterable[str] = BINARY_KINDS) -> List[Path]:
+    """Files of the given kinds, symlinks excluded, as paths under folder"""
+    kinds = set(kinds)
+    return [Path(folder) / entry["path"] for entry in manifest["artifacts"]
+            if entry["kind"] in kinds and "link" not in entry]
+
+
+def summarize(manifest: Dict) -> Dict:
+    """File count and bytes, in total and per kind"""
+    by_kind: Dict[str, Dict[str, int]] = {}
+    for entry in manifest["artifacts"]:
+        kind = by_kind.setdefault(entry["kind"], {"files": 0, "bytes": 0})
+        kind["files"] += 1
+        kind["bytes"] += entry["size"]
+    return {
+        "files": len(manifest["artifacts"]),
+        "bytes": manifest.get("total_size", sum(entry["size"] for entry in manifest["artifacts"])),
+        "by_kind": by_kind,
+    }
@@ -0,0 +1,236 @@
+"""
+Asynchronous Command Execution
+
+asyncio counterpart of execute_command(): output is streamed line by
+line to callbacks while the command runs instead of being buffered until
+it exits, and one event loop can drive many commands at once.
+
+    async def main():
+        results = await run_commands_async(
+            [["conan", "create", ".", "-pr", p] for p in profiles],
+            concurrency=4, on_line=log_lines(log), timeout=3600)
+
+Callbacks get (stream, line) with stream "stdout" or "stderr" and the
+line without its newline; they may be plain functions or coroutines.
+On timeout the command's process group gets SIGTERM and, after
+kill_grace seconds, SIGKILL. Cancelling the awaiting task does the same
+before the CancelledError propagates, so no child outlives its task.
+"""
+
+import asyncio
+import inspect
+import logging
+import os
+import signal
+import time
+from dataclasses import dataclass, field
+from typing import Any, Awaitable, Callable, Dict, Iterable, List, Optional, Union
+
+log = logging.getLogger(__name__)
+
+Command = Union[str, List[str]]
+LineCallback = Callable[[str, str], Optional[Awaitable[None]]]
+
+# StreamReader line limit; longer lines are delivered in pieces of about this size
+LINE_LIMIT = 1 << 20
+
+
+@dataclass
+class CommandResult:
+    """Outcome of one asynchronous command"""
+    command: Command
+    returncode: Optional[int]
+    stdout: List[str] = field(default_factory=list)
+    stderr: List[str] = field(default_factory=list)
+    duration: float = 0.0
+    timed_out: bool = False
+    cancelled: bool = False
+    error: Optional[str] = None
+
+    @property
+    def ok(self) -> bool:
+        return self.returncode == 0 and not self.timed_out
+
+
+def log_lines(logger: logging.Logger = log, prefix: str = "") -> LineCallback:
+    """Callback logging stdout as OUT: and stderr as ERR:, like execute_command()"""
+    def callback(stream: str, line: str):
+        if stream == "stdout":
+            logger.info(f"{prefix}OUT: {line}")
+        else:
+            logger.error(f"{prefix}ERR: {line}")
+    return callback
+
+
+async def _call(callback: Optional[LineCallback], stream: str, line: str):
+    if callback is None:
+        return
+    result = callback(stream, line)
+    if inspect.isawaitable(result):
+        await result
+
+
+async def _pump(reader: asyncio.StreamReader, stream: str, lines: Optional[List[str]],
+                callbacks: List[Optional[LineCallback]], encoding: str):
+    while True:
+        try:
+            raw = await reader.readuntil(b"\n")
+        except asyncio.IncompleteReadError as e:
+            # Last line without a newline, or EOF
+            raw = e.partial
+        except asyncio.LimitOverrunError as e:
+            # Line longer than LINE_LIMIT: deliver it in LINE_LIMIT pieces
+            raw = await reader.readexactly(e.consumed)
+        if not raw:
+            return
+        line = raw.decode(encoding, errors="replace").rstrip("\r\n")
+        if lines is not None:
+            lines.append(line)
+        for callback in callbacks:
+            await _call(callback, stream, line)
+
+
+def _signal_group(process: asyncio.subprocess.Process, sig: int):
+    try:
+        if os.name == "posix":
+            os.killpg(process.pid, sig)
+        elif sig == signal.SIGTERM:
+            process.terminate()
+        else:
+            process.kill()
+    except (ProcessLookupError, PermissionError):
+        pass
+
+
+async def _stop(process: asyncio.subprocess.Process, kill_grace: float):
+    """SIGTERM the process group, SIGKILL it if it is still there after kill_grace seconds"""
+    if process.returncode is not None:
+        return
+    _signal_group(process, signal.SIGTERM)
+    try:
+        await asyncio.wait_for(process.wait(), kill_grace)
+    except asyncio.TimeoutError:
+        _signal_group(process, getattr(signal, "SIGKILL", signal.SIGTERM))
+        await process.wait()
+
+
+async def execute_command_async(command: Command,
+                                cwd: Optional[str] = None,
+                                env: Optional[Dict[str, str]] = None,
+                                on_stdout: Optional[LineCallback] = None,
+                                on_stderr: Optional[LineCallback] = None,
+                                on_line: Optional[LineCallback] = None,
+                                timeout: Optional[float] = None,
+                                combine_stdout_and_stderr: bool = False,
+                                keep_output: bool = True,
+                                kill_grace: float = 5.0,
+                                encoding: str = "utf-8",
+                                print_command: bool = True) -> CommandResult:
+    """
+    Run one command, streaming its output to the callbacks.
+
+    Args:
+        command: string (run through the shell) or argument list
+        on_stdout / on_stderr: callbacks for one stream; on_line gets both
+        timeout: seconds before the command is stopped (result.timed_out)
+        combine_stdout_and_stderr: merge stderr into stdout, as execute_command does
+        keep_output: collect the lines in the result (off for very chatty commands)
+        kill_grace: seconds between SIGTERM and SIGKILL when stopping
+
+    Returns:
+        CommandResult; a command that cannot be started has returncode None and error set
+    """
+    if print_command:
+        log.info(f'Executing command: {command}')
+    start = time.monotonic()
+    result = CommandResult(command, None)
+    stderr_target = asyncio.subprocess.STDOUT if combine_stdout_and_stderr else asyncio.subprocess.PIPE
+    options: Dict[str, Any] = dict(cwd=cwd, env=env, stdout=asyncio.subprocess.PIPE, stderr=stderr_target,
+                                   stdin=asyncio.subprocess.DEVNULL, limit=LINE_LIMIT)
+    if os.name == "posix":
+        options["start_new_session"] = True
+    try:
+        if isinstance(command, str):
+            process = await asyncio.create_subprocess_shell(command, **options)
+        else:
+            process = await asyncio.create_subprocess_exec(*command, **options)
+    except OSError as e:
+        log.error(f'Failed to execute command {command}: {e}')
+        result.error = str(e)
+        return result
+
+    pumps = [_pump(process.stdout, "stdout", result.stdout if keep_output else None,
+                   [on_stdout, on_line], encoding)]
+    if not combine_stdout_and_stderr:
+        pumps.append(_pump(process.stderr, "stderr", result.stderr if keep_output else None,
+                           [on_stderr, on_line], encoding))
+
+    async def communicate():
+        await asyncio.gather(*pumps)
+        return await process.wait()
+
+    task = asyncio.ensure_future(communicate())
+    try:
+        result.returncode = await asyncio.wait_for(asyncio.shield(task), timeout)
+    except asyncio.TimeoutError:
+        log.warning(f'Command timed out after {timeout} seconds: {command}')
+        result.timed_out = True
+        await _stop(process, kill_grace)
+        # The pipes close with the process group; drain what is left
+        try:
+            await asyncio.wait_for(task, kill_grace)
+        except asyncio.TimeoutError:
+            task.cancel()
+        result.returncode = process.returncode
+    except asyncio.CancelledError:
+        result.cancelled = True
+        task.cancel()
+        await _stop(process, kill_grace)
+        raise
+    finally:
+        result.duration = time.monotonic() - start
+    if result.returncode != 0 and not result.timed_out:
+        log.warning(f'Command failed (exit code: {result.returncode}): {command}')
+    return result
+
+
+async def run_commands_async(commands: Iterable[Command], concurrency: Optional[int] = None,
+                             fail_fast: bool = False, **kwargs) -> List[CommandResult]:
+    """
+    Run commands concurrently, at most concurrency at a time (default: one
+    per CPU), with the keyword arguments of execute_command_async().
+    With fail_fast, the first failure cancels the commands still running
+    or waiting; their results have cancelled set. Results keep the order
+    of commands.
+    """
+    commands = list(commands)
+    semaphore = asyncio.Semaphore(concurrency or os.cpu_count() or 1)
+    results: List[Optional[CommandResult]] = [None] * len(commands)
+
+    async def run(index: int, command: Command):
+        async with semaphore:
+            results[index] = await execute_command_async(command, **kwargs)
+        return results[index]
+
+    tasks = [asyncio.ensure_future(run(i, command)) for i, command in enumerate(commands)]
+    try:
+        if fail_fast:
+            for finished in asyncio.as_completed(tasks):
+                if not (await finished).ok:
+                    break
+            for task in tasks:
+                task.cancel()
+        await asyncio.gather(*tasks, return_exceptions=True)
+    except asyncio.CancelledError:
+        for task in tasks:
+            task.cancel()
+        await asyncio.gather(*tasks, return_exceptions=True)
+        raise
+    return [result or CommandResult(command, None, cancelled=True)
+            for command, result in zip(commands, results)]
+
+
+def run_commands(commands: Iterable[Command], concurrency: Optional[int] = None,
+                 **kwargs) -> List[CommandResult]:
+    """run_commands_async() for synchronous callers (starts its own event loop)"""
+    return asyncio.run(run_commands_async(commands, concurrency, **kwargs))
@@ -0,0 +1,182 @@
+#!/usr/bin/env python3
+"""
+Build job queue for the build MCP server
+
+A tool call submits a job and returns its id at once. Jobs wait for one
+of `workers` slots and then run their commands in order. Output is
+appended line by line, and on_update(job) fires for every line and state
+change. The server throttles the notifications it sends to subscribers.
+
+Jobs are keyed by what they build. For a single component that is
+(operation, component, profile, source revision). A submission whose key
+matches a queued or running job joins that job, so concurrent agents
+asking for the same build share one `conan create`. A key that already
+succeeded returns the finished job unless force is set. Failed,
+cancelled and timed-out jobs are never reused.
+
+Finished jobs are kept for inspection (the newest `retain`). Each job
+keeps its last MAX_LOG_LINES lines. Line offsets stay absolute, so a
+reader that polls with from_line never sees a line twice.
+"""
+
+import asyncio
+import itertools
+import time
+from dataclasses import dataclass, field
+from typing import Callable, Dict, List, Optional, Tuple
+
+MAX_LOG_LINES = 20000
+# Longest output line a build may print (StreamReader limit)
+LINE_LIMIT = 1024 * 1024
+ACTIVE_STATES = ("queued", "running")
+
+
+@dataclass
+class BuildJob:
+    """One queued build and its output"""
+    id: str
+    key: Tuple
+    commands: List[List[str]]
+    timeout: float
+    description: str = ""
+    state: str = "queued"          # queued, running, succeeded, failed, cancelled, timeout
+    returncode: Optional[int] = None
+    requesters: int = 1
+    created_at: float = field(default_factory=time.time)
+    started_at: Optional[float] = None
+    finished_at: Optional[float] = None
+    lines: List[str] = field(default_factory=list)
+    dropped_lines: int = 0
+    _done: asyncio.Event = field(default_factory=asyncio.Event, repr=False)
+    _process: Optional[asyncio.subprocess.Process] = field(default=None, repr=False)
+    _task: Optional[asyncio.Task] = field(default=None, repr=False)
+
+    @property
+    def line_count(self) -> int:
+        return self.dropped_lines + len(self.lines)
+
+    def append(self, line: str):
+        self.lines.append(line)
+        if len(self.lines) > MAX_LOG_LINES:
+            drop = len(self.lines) - MAX_LOG_LINES
+            del self.lines[:drop]
+            self.dropped_lines += drop
+
+    def log_since(self, from_line: int = 0) -> Tuple[str, int]:
+        """Log text from absolute line from_line, and the offset to resume at"""
+        start = max(from_line - self.dropped_lines, 0)
+        return "".join(self.lines[start:]), self.line_count
+
+    def status(self) -> Dict:
+        end = self.finished_at or time.time()
+        return {
+            "id": self.id,
+            "description": self.description,
+            "state": self.state,
+            "returncode": self.returncode,
+            "requesters": self.requesters,
+            "queued_seconds": round((self.started_at or end) - self.created_at, 1),
+            "run_seconds": round(end - self.started_at, 1) if self.started_at else None,
+            "log_lines": self.line_count,
+        }
+
+    async def wait(self):
+        await self._done.wait()
+
+
+class BuildQueue:
+    """Bounded-concurrency build queue with coalescing of identical requests"""
+
+    def __init__(self, workers: int = 2, cwd: Optional[str] = None,
+                 on_update: Optional[Callable[[BuildJob], None]] = None, retain: int = 100):
+        self.workers = max(1, workers)
+        self.cwd = cwd
+        self.on_update = on_update
+        self.retain = retain
+        self._slots = asyncio.Semaphore(self.workers)
+        self._jobs: Dict[str, BuildJob] = {}
+        self._ids = itertools.count(1)
+
+    def submit(self, key: Tuple, commands: List[List[str]], timeout: float,
+               description: str = "", force: bool = False) -> Tuple[BuildJob, bool]:
+        """The job for key, and whether an existing job was reused"""
+        for job in reversed(list(self._jobs.values())):
+            if job.key != key:
+                continue
+            if job.state in ACTIVE_STATES or (job.state == "succeeded" and not force):
+                job.requesters += 1
+                return job, True
+        job = BuildJob(id=f"build-{next(self._ids)}", key=key, commands=commands,
+                       timeout=timeout, description=description)
+        self._jobs[job.id] = job
+        job._task = asyncio.get_running_loop().create_task(self._run(job))
+        self._prune()
+        return job, False
+
+    def get(self, job_id: str) -> Optional[BuildJob]:
+        return self._jobs.get(job_id)
+
+    def jobs(self) -> List[BuildJob]:
+        return list(self._jobs.values())
+
+    def cancel(self, job_id: str) -> bool:
+        job = self._jobs.get(job_id)
+        if job is None or job.state not in ACTIVE_STATES:
+            return False
+        if job._process is not None and job._process.returncode is None:
+            job._process.kill()
+        if job._task is not None:
+            job._task.cancel()
+        return True
+
+    def _prune(self):
+        finished = [j for j in self._jobs.values() if j.state not in ACTIVE_STATES]
+        for job in finished[:max(0, len(finished) - self.retain)]:
+            del self._jobs[job.id]
+
+    def _notify(self, job: BuildJob):
+        if self.on_update is not None:
+            self.on_update(job)
+
+    async def _run(self, job: BuildJob):
+        try:
+            async with self._slots:
+                job.state = "running"
+                job.started_at = time.time()
+                self._notify(job)
+                try:
+                    job.returncode = await asyncio.wait_for(self._run_commands(job), job.timeout)
+                    job.state = "succeeded" if job.returncode == 0 else "failed"
+                except asyncio.TimeoutError:
+                    if job._process is not None and job._process.returncode is None:
+                        job._process.kill()
+                    job.append(f"⏰ Timed out after {job.timeout:.0f}s\n")
+                    job.state = "timeout"
+        except asyncio.CancelledError:
+            job.state = "cancelled"
+        except Exception as e:
+            job.append(f"💥 {e}\n")
+            job.state = "failed"
+        finally:
+            job.finished_at = time.time()
+            job._process = None
+            job._done.set()
+            self._notify(job)
+
+    async def _run_commands(self, job: BuildJob) -> int:
+        returncode = 0
+        for command in job.commands:
+            job.append(f"$ {' '.join(command)}\n")
+            job._process = await asyncio.create_subprocess_exec(
+                *command, cwd=self.cwd, limit=LINE_LIMIT,
+                stdout=asyncio.subprocess.PIPE, stderr=asyncio.subprocess.STDOUT)
+            while True:
+                line = await job._process.stdout.readline()
+                if not line:
+                    break
+                job.append(line.decode(errors="replace"))
+                self._notify(job)
+            returncode = await job._process.wait()
+            if returncode != 0:
+                break
+        return returncode
@@ -2,24 +2,40 @@
 """
 OpenSSL Build MCP Server - Production Implementation
 Integrates with existing working build system via MCP protocol
+
+Builds are queued (build_jobs.BuildQueue): build tools return a job id at
+once, OPENSSL_BUILD_MCP_WORKERS builds run at a time, and identical
+requests for the same source revision share one job. Each job is exposed
+as resources (build://jobs/<id> for status, build://jobs/<id>/log for
+output, with ?from=<line> for the part not yet read). Subscribers get
+resources/updated notifications, at most every NOTIFY_INTERVAL seconds
+per job, while it runs.
 """
 
 import asyncio
+import hashlib
 import subprocess
 import os
 import sys
 import json
+import time
 from pathlib import Path
+from urllib.parse import parse_qs, urlparse
 
 # MCP Server imports
 try:
     from mcp.server import Server
     from mcp.server.stdio import stdio_server
-    from mcp.types import Tool, TextContent, CallToolResult
+    from mcp.types import Tool, TextContent, CallToolResult, Resource
 except ImportError:
     print("❌ MCP SDK not installed. Run: pip install mcp", file=sys.stderr)
     sys.exit(1)
 
+try:
+    from .build_jobs import BuildQueue
+except ImportError:  # Run as a script
+    from build_jobs import BuildQueue
+
 # Initialize MCP server
 server = Server("openssl-build")
 
@@ -27,6 +43,69 @@ server = Server("openssl-build")
 WORKSPACE_ROOT = Path(__file__).parent.parent.parent
 os.chdir(WORKSPACE_ROOT)
 
+NOTIFY_INTERVAL = 0.5
+
+# uri -> sessions subscribed to it
+_subscriptions: dict = {}
+# job id -> time of the last notification, and the pending one if throttled
+_last_notified: dict = {}
+_pending_notify: dict = {}
+
+
+def _job_uris(job_id: str) -> list:
+    return [f"build://jobs/{job_id}", f"build://jobs/{job_id}/log"]
+
+
+async def _send_updates(job_id: str):
+    _last_notified[job_id] = time.monotonic()
+    _pending_notify.pop(job_id, None)
+    for uri in _job_uris(job_id):
+        for session in list(_subscriptions.get(uri, ())):
+            try:
+                await session.send_resource_updated(uri)
+            except Exception:
+                # Client went away
+                _subscriptions[uri].discard(session)
+
+
+def _job_updated(job):
+    """BuildQueue callback: notify subscribers, throttled per job"""
+    if not any(_subscriptions.get(uri) for uri in _job_uris(job.id)):
+        return
+    if job.id in _pending_notify:
+        return
+    finished = job.state not in ("queued", "running")
+    delay = 0 if finished else max(0.0, NOTIFY_INTERVAL - (time.monotonic() - _last_notified.get(job.id, 0)))
+    loop = asyncio.get_running_loop()
+    _pending_notify[job.id] = loop.call_later(delay, lambda: loop.create_task(_send_updates(job.id)))
+
+
+JOBS = BuildQueue(workers=int(os.environ.get("OPENSSL_BUILD_MCP_WORKERS", "2")),
+                  cwd=str(WORKSPACE_ROOT), on_update=_job_updated)
+
+
+async def _source_revision(path: str) -> str:
+    """Commit plus a digest of uncommitted changes under path"""
+    async def git(*args) -> str:
+        process = await asyncio.create_subprocess_exec(
+            "git", *args, cwd=str(WORKSPACE_ROOT),
+            stdout=asyncio.subprocess.PIPE, stderr=asyncio.subprocess.DEVNULL)
+        out, _ = await process.communicate()
+        return out.decode().strip() if process.returncode == 0 else ""
+    
+    commit, diff = await asyncio.gather(git("rev-parse", "HEAD"), git("diff", "HEAD", "--", path))
+    if not commit:
+        return f"untracked-{time.time_ns()}"
+    return f"{commit}+{hashlib.sha256(diff.encode()).hexdigest()[:12]}" if diff else commit
+
+
+def _job_text(job, coalesced: bool) -> str:
+    output = f"{'🔁 Joined existing' if coalesced else '🚀 Queued'} build job {job.id} ({job.state})\n"
+    output += f"   {job.description}\n"
+    output += f"   Status: build://jobs/{job.id}\n"
+    output += f"   Log:    build://jobs/{job.id}/log (subscribe, or get_build_job with from_line)\n"
+    return output
+
 @server.list_tools()
 async def handle_list_tools():
     """List available tools for OpenSSL build operations"""
@@ -41,6 +120,11 @@ async def handle_list_tools():
                         "type": "boolean",
                         "default": False,
                         "description": "Clean Conan cache before building"
+                    },
+                    "force": {
+                        "type": "boolean",
+                        "default": False,
+                        "description": "Rebuild even if this revision already built successfully"
                     }
                 }
             }
@@ -82,11 +166,51 @@ async def handle_list_tools():
                         "type": "string",
                         "default": "Release",
                         "description": "Build profile (Release/Debug)"
+                    },
+                    "force": {
+                        "type": "boolean",
+                        "default": False,
+                        "description": "Rebuild even if this revision already built successfully"
                     }
                 },
                 "required": ["component"]
             }
         ),
+        Tool(
+            name="get_build_job",
+            description="Status and new log output of a queued build job",
+            inputSchema={
+                "type": "object",
+                "properties": {
+                    "job_id": {"type": "string"},
+                    "from_line": {
+                        "type": "integer",
+                        "default": 0,
+                        "description": "First log line to return (next_line of the previous call)"
+                    }
+                },
+                "required": ["job_id"]
+            }
+        ),
+        Tool(
+            name="list_build_jobs",
+            description="List queued, running and recent build jobs",
+            inputSchema={
+                "type": "object",
+                "properties": {}
+            }
+        ),
+        Tool(
+            name="cancel_build_job",
+            description="Cancel a queued or running build job",
+            inputSchema={
+                "type": "object",
+                "properties": {
+                    "job_id": {"type": "string"}
+                },
+                "required": ["job_id"]
+            }
+        ),
         Tool(
             name="upload_to_registries",
             description="Upload packages to configured registries",
@@ -103,7 +227,7 @@ async def handle_call_tool(name: str, arguments: dict) -> list[TextContent]:
     
     try:
         if name == "build_all_components":
-            return await build_all_components(arguments.get("clean", False))
+            return await build_all_components(arguments.get("clean", False), arguments.get("force", False))
             
         elif name == "check_conan_cache":
             return await check_conan_cache()
@@ -114,7 +238,16 @@ async def handle_call_tool(name: str, arguments: dict) -> list[TextContent]:
         elif name == "build_single_component":
             component = arguments["component"]
             profile = arguments.get("profile", "Release")
-            return await build_single_component(component, profile)
+            return await build_single_component(component, profile, arguments.get("force", False))
+        
+        elif name == "get_build_job":
+            return await get_build_job(arguments["job_id"], arguments.get("from_line", 0))
+        
+        elif name == "list_build_jobs":
+            return await list_build_jobs()
+        
+        elif name == "cancel_build_job":
+            return await cancel_build_job(arguments["job_id"])
             
         elif name == "upload_to_registries":
             return await upload_to_registries()
@@ -125,44 +258,22 @@ async def handle_call_tool(name: str, arguments: dict) -> list[TextContent]:
     except Exception as e:
         return [TextContent(type="text", text=f"❌ Error executing {name}: {str(e)}")]
 
-async def build_all_components(clean: bool = False) -> list[TextContent]:
-    """Execute the existing working build script"""
-    
-    output = "🔨 Building All OpenSSL Components\n"
-    output += "=" * 50 + "\n"
+async def build_all_components(clean: bool = False, force: bool = False) -> list[TextContent]:
+    """Queue the existing working build script"""
     
-    try:
-        # Clean cache if requested
-        if clean:
-            output += "🧹 Cleaning Conan cache...\n"
-            clean_result = subprocess.run(
-                ["conan", "remove", "openssl-*", "-f"],
-                capture_output=True, text=True
-            )
-            output += f"Cache cleaned: {clean_result.returncode == 0}\n\n"
-        
-        # Execute existing working script
-        output += "🚀 Executing build-all-components.sh...\n"
-        result = subprocess.run(
-            ["./scripts/build/build-all-components.sh"],
-            capture_output=True, text=True, timeout=600  # 10 minute timeout
-        )
-        
-        if result.returncode == 0:
-            output += "✅ Build completed successfully!\n\n"
-            output += "📊 Build Output:\n"
-            output += result.stdout[-1000:]  # Last 1000 chars
-        else:
-            output += "❌ Build failed!\n\n"
-            output += "🔍 Error Output:\n"
-            output += result.stderr[-1000:]  # Last 1000 chars
-            
-    except subprocess.TimeoutExpired:
-        output += "⏰ Build timed out after 10 minutes\n"
-    except Exception as e:
-        output += f"💥 Unexpected error: {str(e)}\n"
+    commands = []
+    # Clean cache if requested
+    if clean:
+        commands.append(["conan", "remove", "openssl-*", "-f"])
+    # Execute existing working script
+    commands.append(["./scripts/build/build-all-components.sh"])
     
-    return [TextContent(type="text", text=output)]
+    revision = await _source_revision(".")
+    job, coalesced = JOBS.submit(("build_all_components", clean, revision), commands,
+                                 timeout=600,  # 10 minute timeout
+                                 description=f"All components{' (clean)' if clean else ''} @ {revision[:12]}",
+                                 force=force)
+    return [TextContent(type="text", text=_job_text(job, coalesced))]
 
 async def check_conan_cache() -> list[TextContent]:
     """Check Conan cache status for OpenSSL packages"""
@@ -228,49 +339,89 @@ async def get_build_status(limit: int) -> list[TextContent]:
     
     return [TextContent(type="text", text=output)]
 
-async def build_single_component(component: str, profile: str) -> list[TextContent]:
-    """Build a single OpenSSL component"""
+async def build_single_component(component: str, profile: str, force: bool = False) -> list[TextContent]:
+    """Queue a build of a single OpenSSL component"""
     
-    output = f"🔨 Building OpenSSL {component.title()} Component\n"
-    output += "=" * 50 + "\n"
+    component_dir = f"openssl-{component}"
+    if not os.path.exists(component_dir):
+        return [TextContent(type="text", text=f"❌ Component directory {component_dir} not found")]
     
-    try:
-        component_dir = f"openssl-{component}"
-        if not os.path.exists(component_dir):
-            return [TextContent(type="text", text=f"❌ Component directory {component_dir} not found")]
-        
-        # Execute Conan build
-        cmd = [
-            "conan", "create", f"{component_dir}/",
-            "--profile:build=default", "--profile:host=default",
-            f"-s build_type={profile}",
-            "-o", "*:shared=True",
-            "--build=missing"
-        ]
-        
-        output += f"🚀 Executing: {' '.join(cmd)}\n\n"
-        
-        result = subprocess.run(cmd, capture_output=True, text=True, timeout=300)
-        
-        if result.returncode == 0:
-            output += f"✅ {component} build completed successfully!\n\n"
-            output += "📝 Build Summary:\n"
-            # Extract key information from stdout
-            lines = result.stdout.split('\n')
-            for line in lines[-20:]:  # Last 20 lines
-                if any(word in line.lower() for word in ['package', 'created', 'exported', 'success']):
-                    output += f"   {line}\n"
-        else:
-            output += f"❌ {component} build failed!\n\n"
-            output += "🔍 Error Details:\n"
-            output += result.stderr[-500:]  # Last 500 chars
-            
-    except subprocess.TimeoutExpired:
-        output += f"⏰ {component} build timed out after 5 minutes\n"
-    except Exception as e:
-        output += f"💥 Build error: {str(e)}\n"
+    # Execute Conan build
+    cmd = [
+        "conan", "create", f"{component_dir}/",
+        "--profile:build=default", "--profile:host=default",
+        f"-s build_type={profile}",
+        "-o", "*:shared=True",
+        "--build=missing"
+    ]
     
-    return [TextContent(type="text", text=output)]
+    # Same component, profile and sources: one build however many agents ask
+    revision = await _source_revision(component_dir)
+    job, coalesced = JOBS.submit(("build_single_component", component, profile, revision), [cmd],
+                                 timeout=300, description=f"{component} {profile} @ {revision[:12]}",
+                                 force=force)
+    return [TextContent(type="text", text=_job_text(job, coalesced))]
+
+async def get_build_job(job_id: str, from_line: int = 0) -> list[TextContent]:
+    """Status of a build job and its log from from_line"""
+    
+    job = JOBS.get(job_id)
+    if job is None:
+        return [TextContent(type="text", text=f"❌ Unknown build job: {job_id}")]
+    log, next_line = job.log_since(from_line)
+    status = dict(job.status(), next_line=next_line)
+    return [TextContent(type="text", text=json.dumps(status, indent=2)),
+            TextContent(type="text", text=log)]
+
+async def list_build_jobs() -> list[TextContent]:
+    """Queued, running and recent build jobs"""
+    
+    jobs = [job.status() for job in JOBS.jobs()]
+    return [TextContent(type="text", text=json.dumps(jobs, indent=2))]
+
+async def cancel_build_job(job_id: str) -> list[TextContent]:
+    """Cancel a build job"""
+    
+    if JOBS.cancel(job_id):
+        return [TextContent(type="text", text=f"🛑 Cancelled build job {job_id}")]
+    return [TextContent(type="text", text=f"❌ Build job {job_id} is not queued or running")]
+
+@server.list_resources()
+async def handle_list_resources():
+    """Status and log resources of the build jobs"""
+    resources = []
+    for job in JOBS.jobs():
+        resources.append(Resource(uri=f"build://jobs/{job.id}", name=f"{job.id} status",
+                                  description=job.description, mimeType="application/json"))
+        resources.append(Resource(uri=f"build://jobs/{job.id}/log", name=f"{job.id} log",
+                                  description=job.description, mimeType="text/plain"))
+    return resources
+
+@server.read_resource()
+async def handle_read_resource(uri) -> str:
+    """build://jobs/<id> (JSON status) or build://jobs/<id>/log[?from=<line>]"""
+    parsed = urlparse(str(uri))
+    parts = [parsed.netloc] + [p for p in parsed.path.split("/") if p]
+    if parsed.scheme != "build" or len(parts) < 2 or parts[0] != "jobs":
+        raise ValueError(f"Unknown resource: {uri}")
+    job = JOBS.get(parts[1])
+    if job is None:
+        raise ValueError(f"Unknown build job: {parts[1]}")
+    if len(parts) == 2:
+        return json.dumps(job.status(), indent=2)
+    from_line = int(parse_qs(parsed.query).get("from", ["0"])[0])
+    return job.log_since(from_line)[0]
+
+@server.subscribe_resource()
+async def handle_subscribe_resource(uri):
+    """Send resources/updated for uri while its job runs"""
+    base = str(uri).split("?", 1)[0]
+    _subscriptions.setdefault(base, set()).add(server.request_context.session)
+
+@server.unsubscribe_resource()
+async def handle_unsubscribe_resource(uri):
+    base = str(uri).split("?", 1)[0]
+    _subscriptions.get(base, set()).discard(server.request_context.session)
 
 async def upload_to_registries() -> list[TextContent]:
     """Execute registry upload script"""
@@ -304,6 +455,11 @@ async def upload_to_registries() -> list[TextContent]:
 async def main():
     """Main entry point for MCP server"""
     from mcp.server.models import InitializationOptions
+    from mcp.server.lowlevel.server import NotificationOptions
+    
+    capabilities = server.get_capabilities(NotificationOptions(resources_changed=True), {})
+    if capabilities.resources is not None:
+        capabilities.resources.subscribe = True
     
     async with stdio_server() as (read_stream, write_stream):
         await server.run(
@@ -312,7 +468,7 @@ async def main():
             InitializationOptions(
                 server_name="openssl-build",
                 server_version="1.0.0",
-                capabilities={}
+                capabilities=capabilities
             )
         )
 
@@ -1,13 +1,24 @@
 #!/usr/bin/env python3
-"""MCP Server for OpenSSL Database Operations"""
+"""MCP Server for OpenSSL Database Operations
+
+Tool calls share a psycopg2 connection pool instead of connecting per call,
+and each query is PREPAREd once per pooled connection and then only
+EXECUTEd. History listings are paged with keyset cursors: a page returns at
+most `limit` rows plus an opaque `next_cursor` to pass back for the rows
+after it, so large histories are never read in one result. Queries run in
+worker threads, so concurrent tool calls do not block the event loop.
+"""
 
 import asyncio
+import base64
 import json
 import os
 import sys
-from typing import Any, Sequence
+import threading
+from typing import Any, Dict, List, Optional, Sequence, Set, Tuple
 
 import psycopg2
+from psycopg2 import pool as pg_pool
 from mcp.server import Server
 from mcp.server.models import InitializationOptions
 from mcp.server.stdio import stdio_server
@@ -20,6 +31,53 @@ from mcp.types import (
     TextContent
 )
 
+POOL_MIN_CONNECTIONS = int(os.getenv('POSTGRES_POOL_MIN', 1))
+POOL_MAX_CONNECTIONS = int(os.getenv('POSTGRES_POOL_MAX', 8))
+MAX_PAGE_SIZE = 500
+
+# name -> SQL; {after} is replaced by the keyset condition of follow-up pages
+STATEMENTS = {
+    'build_status': """
+        SELECT b.id, c.name, b.status, b.build_duration_seconds, b.build_date
+        FROM builds b
+        JOIN components c ON b.component_id = c.id
+        WHERE TRUE {after}
+        ORDER BY b.build_date DESC, b.id DESC
+        LIMIT $1
+    """,
+    'component_history': """
+        SELECT b.id, b.status, b.build_duration_seconds, b.build_date, b.platform, b.profile
+        FROM builds b
+        JOIN components c ON b.component_id = c.id
+        WHERE c.name = $2 {after}
+        ORDER BY b.build_date DESC, b.id DESC
+        LIMIT $1
+    """,
+    'build_metrics': """
+        SELECT 
+            COUNT(*) as total_builds,
+            COUNT(CASE WHEN status = 'completed' THEN 1 END) as successful,
+            AVG(build_duration_seconds) as avg_duration
+        FROM builds
+        WHERE build_date >= NOW() - $1::integer * INTERVAL '1 day'
+    """,
+}
+
+
+def encode_cursor(build_date: Any, build_id: int) -> str:
+    """Opaque cursor for the rows after (build_date, build_id)"""
+    raw = json.dumps([build_date.isoformat() if hasattr(build_date, 'isoformat') else str(build_date), build_id])
+    return base64.urlsafe_b64encode(raw.encode()).decode().rstrip('=')
+
+
+def decode_cursor(cursor: str) -> Tuple[str, int]:
+    try:
+        build_date, build_id = json.loads(base64.urlsafe_b64decode(cursor + '=' * (-len(cursor) % 4)))
+        return str(build_date), int(build_id)
+    except (ValueError, TypeError) as e:
+        raise ValueError(f"Invalid cursor: {cursor}") from e
+
+
 class DatabaseMCPServer:
     def __init__(self):
         self.server = Server("openssl-database")
@@ -30,6 +88,12 @@ class DatabaseMCPServer:
             'user': os.getenv('POSTGRES_USER', 'openssl_admin'),
             'password': os.getenv('POSTGRES_PASSWORD', 'openssl_secure_pass')
         }
+        self._pool: Optional[pg_pool.ThreadedConnectionPool] = None
+        self._pool_lock = threading.Lock()
+        # getconn() raises once every connection is out, so callers wait their turn here
+        self._pool_slots = threading.BoundedSemaphore(POOL_MAX_CONNECTIONS)
+        # Statements prepared on each pooled connection, by id(connection)
+        self._prepared: Dict[int, Set[str]] = {}
         self.setup_handlers()
     
     def setup_handlers(self):
@@ -42,7 +106,8 @@ class DatabaseMCPServer:
                     inputSchema={
                         "type": "object",
                         "properties": {
-                            "limit": {"type": "integer", "default": 10}
+                            "limit": {"type": "integer", "default": 10, "maximum": MAX_PAGE_SIZE},
+                            "cursor": {"type": "string", "description": "next_cursor of the previous page"}
                         }
                     }
                 ),
@@ -53,7 +118,8 @@ class DatabaseMCPServer:
                         "type": "object",
                         "properties": {
                             "component": {"type": "string"},
-                            "limit": {"type": "integer", "default": 20}
+                            "limit": {"type": "integer", "default": 20, "maximum": MAX_PAGE_SIZE},
+                            "cursor": {"type": "string", "description": "next_cursor of the previous page"}
                         },
                         "required": ["component"]
                     }
@@ -73,55 +139,110 @@ class DatabaseMCPServer:
         @self.server.call_tool()
         async def handle_call_tool(name: str, arguments: dict) -> list[TextContent]:
             if name == "get_build_status":
-                return await self.get_build_status(arguments.get("limit", 10))
+                return await self.get_build_status(arguments.get("limit", 10), arguments.get("cursor"))
             elif name == "get_component_history":
                 return await self.get_component_history(
                     arguments["component"], 
-                    arguments.get("limit", 20)
+                    arguments.get("limit", 20),
+                    arguments.get("cursor")
                 )
             elif name == "get_build_metrics":
                 return await self.get_build_metrics(arguments.get("days", 7))
             else:
                 raise ValueError(f"Unknown tool: {name}")
     
-    async def get_build_status(self, limit: int) -> list[TextContent]:
+    # -- connection pool and prepared statements ------------------------------
+    
+    @property
+    def pool(self) -> pg_pool.ThreadedConnectionPool:
+        with self._pool_lock:
+            if self._pool is None:
+                self._pool = pg_pool.ThreadedConnectionPool(POOL_MIN_CONNECTIONS, POOL_MAX_CONNECTIONS,
+                                                            **self.db_config)
+            return self._pool
+    
+    def close(self) -> None:
+        with self._pool_lock:
+            if self._pool is not None:
+                self._pool.closeall()
+                self._pool = None
+                self._prepared.clear()
+    
+    def _execute(self, statement: str, params: Sequence[Any], after: bool = False) -> List[tuple]:
+        """
+        EXECUTE a prepared statement on a pooled connection, preparing it
+        first if that connection has not seen it yet.
+        """
+        name = f"{statement}_after" if after else statement
+        with self._pool_slots:
+            return self._execute_on(self.pool.getconn(), name, statement, params, after)
+    
+    def _execute_on(self, conn, name: str, statement: str, params: Sequence[Any], after: bool) -> List[tuple]:
+        broken = False
         try:
-            with psycopg2.connect(**self.db_config) as conn:
-                with conn.cursor() as cur:
-                    cur.execute("""
-                        SELECT c.name, b.status, b.build_duration_seconds, b.build_date
-                        FROM builds b
-                        JOIN components c ON b.component_id = c.id
-                        ORDER BY b.build_date DESC
-                        LIMIT %s
-                    """, (limit,))
-                    results = cur.fetchall()
+            conn.autocommit = True  # Read-only queries; no transaction left open in the pool
+            prepared = self._prepared.setdefault(id(conn), set())
+            with conn.cursor() as cur:
+                if name not in prepared:
+                    keyset = f"AND (b.build_date, b.id) < (${len(params) - 1}, ${len(params)})" if after else ""
+                    cur.execute(f"PREPARE {name} AS {STATEMENTS[statement].format(after=keyset)}")
+                    prepared.add(name)
+                cur.execute(f"EXECUTE {name} ({', '.join(['%s'] * len(params))})", tuple(params))
+                return cur.fetchall()
+        except (psycopg2.OperationalError, psycopg2.InterfaceError):
+            broken = True
+            raise
+        finally:
+            if broken or conn.closed:
+                self._prepared.pop(id(conn), None)
+            self.pool.putconn(conn, close=broken or bool(conn.closed))
+    
+    async def _query(self, statement: str, params: Sequence[Any], after: bool = False) -> List[tuple]:
+        return await asyncio.to_thread(self._execute, statement, params, after)
+    
+    async def _page(self, statement: str, params: Sequence[Any], limit: int,
+                    cursor: Optional[str]) -> Tuple[List[tuple], Optional[str]]:
+        """Up to limit rows (id first, build_date at date_column) and the cursor for the next page"""
+        limit = max(1, min(int(limit), MAX_PAGE_SIZE))
+        params = [limit + 1, *params]
+        if cursor:
+            params.extend(decode_cursor(cursor))
+        rows = await self._query(statement, params, after=bool(cursor))
+        if len(rows) <= limit:
+            return rows, None
+        rows = rows[:limit]
+        return rows, encode_cursor(rows[-1][self._date_column(statement)], rows[-1][0])
+    
+    @staticmethod
+    def _date_column(statement: str) -> int:
+        return {'build_status': 4, 'component_history': 3}[statement]
+    
+    # -- tools ----------------------------------------------------------------
+    
+    async def get_build_status(self, limit: int, cursor: Optional[str] = None) -> list[TextContent]:
+        try:
+            results, next_cursor = await self._page('build_status', [], limit, cursor)
                     
             status_text = "Recent Build Status:\n"
-            for name, status, duration, date in results:
+            for _, name, status, duration, date in results:
                 status_text += f"• {name}: {status} ({duration}s) at {date}\n"
+            if next_cursor:
+                status_text += f"next_cursor: {next_cursor}\n"
                 
             return [TextContent(type="text", text=status_text)]
         except Exception as e:
             return [TextContent(type="text", text=f"Database error: {e}")]
     
-    async def get_component_history(self, component: str, limit: int) -> list[TextContent]:
+    async def get_component_history(self, component: str, limit: int,
+                                    cursor: Optional[str] = None) -> list[TextContent]:
         try:
-            with psycopg2.connect(**self.db_config) as conn:
-                with conn.cursor() as cur:
-                    cur.execute("""
-                        SELECT b.status, b.build_duration_seconds, b.build_date, b.platform, b.profile
-                        FROM builds b
-                        JOIN components c ON b.component_id = c.id
-                        WHERE c.name = %s
-                        ORDER BY b.build_date DESC
-                        LIMIT %s
-                    """, (component, limit))
-                    results = cur.fetchall()
+            results, next_cursor = await self._page('component_history', [component], limit, cursor)
                     
             history_text = f"Build History for {component}:\n"
-            for status, duration, date, platform, profile in results:
+            for _, status, duration, date, platform, profile in results:
                 history_text += f"• {date}: {status} ({duration}s) - {platform}/{profile}\n"
+            if next_cursor:
+                history_text += f"next_cursor: {next_cursor}\n"
                 
             return [TextContent(type="text", text=history_text)]
         except Exception as e:
@@ -129,24 +250,14 @@ class DatabaseMCPServer:
     
     async def get_build_metrics(self, days: int) -> list[TextContent]:
         try:
-            with psycopg2.connect(**self.db_config) as conn:
-                with conn.cursor() as cur:
-                    cur.execute("""
-                        SELECT 
-                            COUNT(*) as total_builds,
-                            COUNT(CASE WHEN status = 'completed' THEN 1 END) as successful,
-                            AVG(build_duration_seconds) as avg_duration
-                        FROM builds
-                        WHERE build_date >= NOW() - INTERVAL '%s days'
-                    """, (days,))
-                    total, successful, avg_duration = cur.fetchone()
+            (total, successful, avg_duration), = await self._query('build_metrics', [int(days)])
                     
             success_rate = (successful / total * 100) if total > 0 else 0
             metrics_text = f"Build Metrics (Last {days} days):\n"
             metrics_text += f"• Total builds: {total}\n"
             metrics_text += f"• Successful: {successful}\n"
             metrics_text += f"• Success rate: {success_rate:.1f}%\n"
-            metrics_text += f"• Average duration: {avg_duration:.1f}s\n"
+            metrics_text += f"• Average duration: {avg_duration or 0:.1f}s\n"
                 
             return [TextContent(type="text", text=metrics_text)]
         except Exception as e:
@@ -154,14 +265,17 @@ class DatabaseMCPServer:
 
 async def main():
     server_instance = DatabaseMCPServer()
-    async with stdio_server() as (read_stream, write_stream):
-        await server_instance.server.run(
-            read_stream, write_stream, InitializationOptions(
-                server_name="openssl-database",
-                server_version="1.0.0",
-                capabilities={}
+    try:
+        async with stdio_server() as (read_stream, write_stream):
+            await server_instance.server.run(
+                read_stream, write_stream, InitializationOptions(
+                    server_name="openssl-database",
+                    server_version="1.0.0",
+                    capabilities={}
+                )
             )
-        )
+    finally:
+        server_instance.close()
 
 if __name__ == "__main__":
     asyncio.run(main())
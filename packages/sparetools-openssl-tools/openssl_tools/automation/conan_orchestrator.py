@@ -2,6 +2,15 @@
 """
 Conan Orchestrator - Advanced CI/CD automation for OpenSSL
 Based on ngapy-dev patterns with enhanced error handling and monitoring
+
+The performance stage builds the test_package C benchmarks against the
+package just created and gates build_package on significant regressions
+(development/build_system/perf_gate.py).
+
+build_profiles() builds several profiles at once, each worker in its own
+copy-on-write Conan home over a shared download cache
+(development/package_management/cache_workspaces.py), and merges the
+created packages back into the main cache.
 """
 
 import os
@@ -12,13 +21,42 @@ import shutil
 import time
 import json
 import logging
+import threading
 from pathlib import Path
 from typing import Dict, List, Optional, Tuple, Any
 import argparse
 import yaml
+from concurrent.futures import ThreadPoolExecutor
 from dataclasses import dataclass
 from enum import Enum
 
+try:
+    from openssl_tools.config_snapshot import load_config
+except ImportError:  # Run as a script without openssl_tools installed
+    def load_config(path, default=None):
+        if not os.path.exists(path):
+            return default
+        with open(path, 'r') as f:
+            return yaml.safe_load(f)
+
+try:
+    from sparetools_tracing import child_env, span
+except ImportError:  # Run as a script without sparetools-base on PYTHONPATH
+    import contextlib
+
+    def child_env(env=None):
+        return env
+
+    @contextlib.contextmanager
+    def span(name, **attributes):
+        yield type("Span", (), {"set_attribute": lambda self, key, value: None})()
+
+try:
+    from openssl_tools.artifact_manifest import artifact_paths, load_manifest
+except ImportError:  # Run as a script without openssl_tools installed
+    def load_manifest(folder):
+        return None
+
 # Configure logging
 logging.basicConfig(
     level=logging.INFO,
@@ -81,6 +119,9 @@ class ConanOrchestrator:
         # Platform detection
         self.current_platform = self._detect_platform()
         
+        # Package folder and revision of the last successful build_package
+        self.last_package: Optional[Dict[str, str]] = None
+        
         logger.info(f"🚀 Conan Orchestrator initialized for {self.current_platform.value}")
     
     def _initialize_directories(self):
@@ -97,12 +138,11 @@ class ConanOrchestrator:
     
     def _load_configuration(self) -> Dict:
         """Load configuration from YAML file"""
-        if self.config_file.exists():
-            with open(self.config_file, 'r') as f:
-                return yaml.safe_load(f)
-        else:
-            # Create default configuration
-            return self._create_default_config()
+        config = load_config(self.config_file)
+        if config is not None:
+            return config
+        # Create default configuration
+        return self._create_default_config()
     
     def _create_default_config(self) -> Dict:
         """Create default configuration"""
@@ -117,12 +157,31 @@ class ConanOrchestrator:
                 "source_dir": ".",
                 "build_dir": "build",
                 "install_dir": "install",
-                "jobs": os.environ.get("CONAN_CPU_COUNT", "1")
+                "jobs": os.environ.get("CONAN_CPU_COUNT", "1"),
+                "parallel_profiles": 4,
+                "workspaces_dir": "conan/workspaces",
+                "download_cache": None
             },
             "tests": {
                 "results_dir": "test_results",
                 "unit_test_command": "pytest",
-                "performance_test_output": "performance_report.json"
+                "performance_test_output": "performance_report.json",
+                "performance": {
+                    "benches": ["bench_evp", "bench_handshake"],
+                    "trials": 5,
+                    "warmup": 1,
+                    "quick": True,
+                    "alpha": 0.01,
+                    "min_effect_percent": 2.0,
+                    "baselines": "test_results/baselines.json",
+                    "history_store": "test_results/perf_history.sqlite"
+                },
+                "binary_size": {
+                    "enabled": True,
+                    "threshold_percent": 2.0,
+                    "min_bytes": 4096,
+                    "fail_on_growth": False
+                }
             },
             "deployment": {
                 "target_registry": "your-docker-registry.io/openssl",
@@ -209,37 +268,43 @@ tools.cmake.cmaketoolchain:jobs={self.config['build']['jobs']}
         return profile_path
     
     def _run_conan_command(self, command: List[str], cwd: Optional[Path] = None, 
-                          capture_output: bool = False) -> Tuple[bool, str, str]:
+                          capture_output: bool = False,
+                          env: Optional[Dict[str, str]] = None) -> Tuple[bool, str, str]:
         """Run Conan command with error handling"""
         full_command = ["conan"] + command
         
         logger.info(f"🔧 Running: {' '.join(full_command)}")
         
-        try:
-            if capture_output:
-                result = subprocess.run(
-                    full_command,
-                    cwd=cwd or self.project_root,
-                    capture_output=True,
-                    text=True,
-                    check=True
-                )
-                return True, result.stdout, result.stderr
-            else:
-                result = subprocess.run(
-                    full_command,
-                    cwd=cwd or self.project_root,
-                    check=True
-                )
-                return True, "", ""
+        # The conan process and its recipe continue this span through TRACEPARENT
+        with span(f"conan {command[0] if command else ''}".strip(), command=" ".join(full_command)) as conan_span:
+            try:
+                if capture_output:
+                    result = subprocess.run(
+                        full_command,
+                        cwd=cwd or self.project_root,
+                        capture_output=True,
+                        text=True,
+                        env=child_env(env),
+                        check=True
+                    )
+                    return True, result.stdout, result.stderr
+                else:
+                    result = subprocess.run(
+                        full_command,
+                        cwd=cwd or self.project_root,
+                        env=child_env(env),
+                        check=True
+                    )
+                    return True, "", ""
+                    
+            except subprocess.CalledProcessError as e:
+                conan_span.set_attribute("returncode", e.returncode)
+                error_msg = f"Command failed with return code {e.returncode}"
+                if capture_output:
+                    error_msg += f"\nSTDOUT: {e.stdout}\nSTDERR: {e.stderr}"
                 
-        except subprocess.CalledProcessError as e:
-            error_msg = f"Command failed with return code {e.returncode}"
-            if capture_output:
-                error_msg += f"\nSTDOUT: {e.stdout}\nSTDERR: {e.stderr}"
-            
-            logger.error(f"❌ {error_msg}")
-            return False, e.stdout if capture_output else "", e.stderr if capture_output else str(e)
+                logger.error(f"❌ {error_msg}")
+                return False, e.stdout if capture_output else "", e.stderr if capture_output else str(e)
     
     def setup_conan_remote(self) -> bool:
         """Set up Conan remote - pattern from ngapy-dev artifactory_functions.py"""
@@ -298,8 +363,13 @@ tools.cmake.cmaketoolchain:jobs={self.config['build']['jobs']}
         
         return success
     
-    def build_package(self, profile_name: str, test: bool = False) -> BuildResult:
-        """Build Conan package with comprehensive monitoring"""
+    def build_package(self, profile_name: str, test: bool = False, performance: bool = False,
+                      update_baseline: bool = False, env: Optional[Dict[str, str]] = None,
+                      jobs: Optional[int] = None) -> BuildResult:
+        """
+        Build Conan package with comprehensive monitoring; performance gates it on benchmark regressions.
+        env selects another Conan home (CONAN_HOME), jobs overrides tools.build:jobs.
+        """
         logger.info(f"🔨 Building package with profile: {profile_name}")
         
         start_time = time.time()
@@ -318,9 +388,16 @@ tools.cmake.cmaketoolchain:jobs={self.config['build']['jobs']}
         
         if test:
             build_cmd.append("--test")
+        if jobs:
+            build_cmd += ["-c", f"tools.build:jobs={jobs}"]
+        # The JSON graph tells where the package landed
+        build_cmd.append("--format=json")
         
         # Run build
-        success, stdout, stderr = self._run_conan_command(build_cmd, capture_output=True)
+        success, stdout, stderr = self._run_conan_command(build_cmd, capture_output=True, env=env)
+        package = self._created_package(stdout) if success else None
+        if package:
+            self.last_package = package
         
         duration = time.time() - start_time
         
@@ -329,13 +406,14 @@ tools.cmake.cmaketoolchain:jobs={self.config['build']['jobs']}
             "build_duration": duration,
             "profile": profile_name,
             "platform": self.current_platform.value,
-            "timestamp": time.time()
+            "timestamp": time.time(),
+            "package": package
         }
         
         # Collect artifacts
         artifacts = []
         if success:
-            artifacts = self._collect_build_artifacts()
+            artifacts = self._collect_build_artifacts(package)
         
         result = BuildResult(
             success=success,
@@ -351,10 +429,145 @@ tools.cmake.cmaketoolchain:jobs={self.config['build']['jobs']}
         else:
             logger.error(f"❌ Package build failed after {duration:.2f}s")
         
+        # Size history of every created revision, flagged against the previous one
+        if success and package:
+            size = self._record_binary_size(package, profile_name)
+            metrics["binary_size"] = size
+            if size.get("flagged") and self.config["tests"].get("binary_size", {}).get("fail_on_growth"):
+                result.success = False
+                result.error = f"binary size growth: {', '.join(c['metric'] for c in size['flagged'])}"
+        
+        # Performance gate against the package just built
+        if success and performance:
+            results_dir = Path(self.config["tests"]["results_dir"])
+            results_dir.mkdir(parents=True, exist_ok=True)
+            gate = self._run_performance_tests(results_dir, profile=profile_name,
+                                               update_baseline=update_baseline, package=package)
+            metrics["performance"] = gate
+            if not gate["passed"]:
+                result.success = False
+                result.error = gate.get("error") or f"performance regression: {'; '.join(gate['regressions'])}"
+        
         return result
     
-    def _collect_build_artifacts(self) -> List[Path]:
-        """Collect build artifacts"""
+    def _record_binary_size(self, package: Dict[str, str], profile: str) -> Dict[str, Any]:
+        """Append the package's libcrypto/libssl sizes to the perf history and compare them"""
+        from openssl_tools.development.build_system.binary_size import BinarySizeTracker
+        from openssl_tools.development.build_system.perf_history import PerfHistoryStore, current_git_commit
+        
+        settings = self.config["tests"].get("binary_size", {})
+        if not settings.get("enabled", True):
+            return {}
+        perf = self.config["tests"].get("performance", {})
+        store = PerfHistoryStore(Path(perf.get("history_store", "test_results/perf_history.sqlite")))
+        try:
+            tracker = BinarySizeTracker(store, threshold_percent=float(settings.get("threshold_percent", 2.0)),
+                                        min_bytes=int(settings.get("min_bytes", 4096)))
+            report = tracker.record(Path(package["package_folder"]), package["prev"], profile,
+                                    f"{platform.system().lower()}-{platform.machine().lower()}",
+                                    current_git_commit(self.project_root)).to_dict()
+        except (OSError, RuntimeError) as e:
+            logger.warning(f"⚠️ Binary size not recorded: {e}")
+            return {"error": str(e)}
+        finally:
+            store.close()
+        for change in report["flagged"]:
+            logger.warning(f"⚠️ {change['metric']} grew by {change['delta']:+,.0f} bytes")
+        # The full change list lives in the perf history
+        report.pop("changes")
+        return report
+    
+    def _created_package(self, graph_json: str) -> Optional[Dict[str, str]]:
+        """Package folder and revisions of the created package in `conan create --format=json` output"""
+        try:
+            graph = json.loads(graph_json)
+        except json.JSONDecodeError:
+            return None
+        nodes = graph.get("graph", {}).get("nodes", {})
+        root = nodes.get("0", {})
+        # The root is the test_package (or virtual) consumer; the created package is its direct host requirement
+        candidates = [root] + [nodes.get(dep_id, {}) for dep_id, dep in root.get("dependencies", {}).items()
+                               if dep.get("direct") and not dep.get("build")]
+        for node in candidates:
+            if node.get("package_folder"):
+                return {"package_folder": node["package_folder"], "ref": str(node.get("ref", "")),
+                        "package_id": str(node.get("package_id", "")),
+                        "prev": str(node.get("prev") or "unknown")}
+        return None
+    
+    def build_profiles(self, profile_names: List[str], parallel: Optional[int] = None, test: bool = False,
+                       performance: bool = False, update_baseline: bool = False) -> Dict[str, BuildResult]:
+        """
+        Build several profiles concurrently, one isolated Conan home per worker.
+        Created packages are merged into the main cache; performance gates run
+        afterwards, one at a time, so benchmarks never share the machine with builds.
+        """
+        from openssl_tools.development.package_management.cache_workspaces import WorkspacePool
+        
+        build_config = self.config["build"]
+        workers = max(1, min(int(parallel or build_config.get("parallel_profiles", 4)), len(profile_names)))
+        download_cache = build_config.get("download_cache")
+        pool = WorkspacePool(self.project_root / build_config.get("workspaces_dir", "conan/workspaces"), workers,
+                             download_cache=Path(download_cache) if download_cache else None)
+        workspaces = pool.prepare()
+        free = list(workspaces)
+        lock = threading.Lock()
+        jobs = max(1, (os.cpu_count() or 1) // workers)
+        logger.info(f"🔨 Building {len(profile_names)} profile(s), {workers} in flight, {jobs} jobs each")
+        
+        def build(profile_name: str) -> BuildResult:
+            with lock:
+                workspace = free.pop()
+            try:
+                result = self.build_package(profile_name, test=test, env=workspace.env(), jobs=jobs)
+                result.metrics = result.metrics or {}
+                result.metrics["workspace"] = workspace.name
+                package = result.metrics.get("package")
+                if result.success and package:
+                    result.metrics["merged"] = pool.merge(workspace, package)
+                    if not result.metrics["merged"]:
+                        result.success = False
+                        result.error = f"could not merge {package['ref']} from {workspace.name}"
+                return result
+            finally:
+                with lock:
+                    free.append(workspace)
+        
+        with ThreadPoolExecutor(max_workers=workers) as executor:
+            results = dict(zip(profile_names, executor.map(build, profile_names)))
+        
+        if performance:
+            results_dir = Path(self.config["tests"]["results_dir"])
+            results_dir.mkdir(parents=True, exist_ok=True)
+            for profile_name, result in results.items():
+                if not result.success:
+                    continue
+                gate = self._run_performance_tests(results_dir, profile=profile_name, update_baseline=update_baseline,
+                                                   package=result.metrics.get("package"))
+                result.metrics["performance"] = gate
+                if not gate["passed"]:
+                    result.success = False
+                    result.error = gate.get("error") or f"performance regression: {'; '.join(gate['regressions'])}"
+        
+        failed = [name for name, result in results.items() if not result.success]
+        if failed:
+            logger.error(f"❌ {len(failed)}/{len(results)} profile build(s) failed: {', '.join(failed)}")
+        else:
+            logger.info(f"✅ All {len(results)} profile builds succeeded")
+        return results
+    
+    def _collect_build_artifacts(self, package: Optional[Dict[str, str]] = None) -> List[Path]:
+        """
+        Collect build artifacts: the binaries listed in the created package's
+        artifact manifest, or, for packages without one, a search of the project
+        """
+        if package:
+            manifest = load_manifest(Path(package["package_folder"]))
+            if manifest is not None:
+                artifacts = artifact_paths(Path(package["package_folder"]), manifest)
+                logger.info(f"📦 Collected {len(artifacts)} build artifacts from the package manifest")
+                return artifacts
+        
         artifacts = []
         
         # Look for common OpenSSL artifacts
@@ -386,7 +599,7 @@ tools.cmake.cmaketoolchain:jobs={self.config['build']['jobs']}
         if test_type == "unit":
             return self._run_unit_tests(test_results_dir)
         elif test_type == "performance":
-            return self._run_performance_tests(test_results_dir)
+            return self._run_performance_tests(test_results_dir)["passed"]
         else:
             logger.error(f"❌ Unknown test type: {test_type}")
             return False
@@ -407,29 +620,60 @@ tools.cmake.cmaketoolchain:jobs={self.config['build']['jobs']}
         
         return success
     
-    def _run_performance_tests(self, results_dir: Path) -> bool:
-        """Run performance tests"""
+    def _run_performance_tests(self, results_dir: Path, profile: Optional[str] = None,
+                               update_baseline: bool = False,
+                               package: Optional[Dict[str, str]] = None) -> Dict[str, Any]:
+        """
+        Run the native test_package benchmarks against package (default: the last built one),
+        compare them with the baselines and append them to the perf history.
+        Returns the gate result; "passed" is False on a significant regression.
+        """
+        from openssl_tools.development.build_system.perf_gate import PerformanceGate
+        
         logger.info("⚡ Running performance tests...")
+        performance_report = results_dir / self.config["tests"].get("performance_test_output",
+                                                                     "performance_report.json")
+        settings = self.config["tests"].get("performance", {})
+        package = package or self.last_package
         
-        # This would integrate with the performance testing script
-        # For now, we'll create a placeholder
-        performance_report = results_dir / "performance_report.json"
+        if not package:
+            gate = {"passed": False, "error": "no package built in this run to benchmark"}
+        else:
+            gate_runner = PerformanceGate(
+                test_package_dir=self.project_root / "test_package",
+                work_dir=self.cache_dir / "perf" / (profile or "default"),
+                benches=settings.get("benches"),
+                trials=int(settings.get("trials", 5)),
+                warmup=int(settings.get("warmup", 1)),
+                quick=bool(settings.get("quick", True)),
+                baselines=Path(settings.get("baselines", results_dir / "baselines.json")),
+                store=Path(settings.get("history_store", results_dir / "perf_history.sqlite")),
+                alpha=float(settings.get("alpha", 0.01)),
+                min_effect_percent=float(settings.get("min_effect_percent", 2.0)),
+                update_baseline=update_baseline
+            )
+            try:
+                gate = gate_runner.run(Path(package["package_folder"]), profile or "default",
+                                       package_revision=package["prev"],
+                                       git_commit=None).to_dict()
+            except (OSError, RuntimeError, ValueError, subprocess.TimeoutExpired) as e:
+                gate = {"passed": False, "error": f"benchmark run failed: {e}"}
         
-        # Simulate performance test
         test_data = {
             "timestamp": time.time(),
             "platform": self.current_platform.value,
-            "tests": {
-                "build_time": 120.5,
-                "test_execution_time": 45.2
-            }
+            "profile": profile,
+            "package": package,
+            "gate": gate
         }
-        
         with open(performance_report, 'w') as f:
             json.dump(test_data, f, indent=2)
         
-        logger.info(f"✅ Performance tests completed. Report: {performance_report}")
-        return True
+        if gate["passed"]:
+            logger.info(f"✅ Performance tests passed. Report: {performance_report}")
+        else:
+            logger.error(f"❌ Performance gate failed: {gate.get('error') or '; '.join(gate['regressions'])}")
+        return gate
     
     def upload_package(self, package_name: str, package_version: str) -> bool:
         """Upload package to remote repository"""
@@ -506,12 +750,18 @@ def main():
     parser.add_argument("--project-root", type=Path, default=Path.cwd(),
                        help="Project root directory")
     parser.add_argument("--profile", "-p", required=True,
-                       help="Conan profile to use")
+                       help="Conan profile to use (build: comma-separated list for concurrent builds)")
     parser.add_argument("--action", "-a", required=True,
                        choices=["setup", "install", "build", "test", "upload", "clean"],
                        help="Action to perform")
     parser.add_argument("--test", "-t", action="store_true",
                        help="Run tests after build")
+    parser.add_argument("--performance", action="store_true",
+                       help="Benchmark the built package and fail on significant regressions")
+    parser.add_argument("--update-baseline", action="store_true",
+                       help="With --performance, replace the baselines when no metric regressed")
+    parser.add_argument("--parallel", type=int,
+                       help="Profiles built at once, each in its own Conan home (default: build.parallel_profiles)")
     parser.add_argument("--package-name", default="openssl",
                        help="Package name for upload")
     parser.add_argument("--package-version", default="3.5.0",
@@ -537,8 +787,17 @@ def main():
             success = orchestrator.install_dependencies(args.profile)
             
         elif args.action == "build":
-            result = orchestrator.build_package(args.profile, test=args.test)
-            success = result.success
+            profiles = [p.strip() for p in args.profile.split(",") if p.strip()]
+            if len(profiles) > 1 or (args.parallel or 1) > 1:
+                results = orchestrator.build_profiles(profiles, parallel=args.parallel, test=args.test,
+                                                      performance=args.performance,
+                                                      update_baseline=args.update_baseline)
+                orchestrator.generate_report(list(results.values()))
+                success = all(result.success for result in results.values())
+            else:
+                result = orchestrator.build_package(args.profile, test=args.test, performance=args.performance,
+                                                    update_baseline=args.update_baseline)
+                success = result.success
             
             if args.test and success:
                 success = orchestrator.run_tests("unit")
@@ -22,6 +22,15 @@ import yaml
 from conan import ConanFile
 from conan.tools.files import load, save
 
+try:
+    from openssl_tools.config_snapshot import load_config
+except ImportError:  # Run as a script without openssl_tools installed
+    def load_config(path, default=None):
+        if not os.path.exists(path):
+            return default
+        with open(path, 'r') as f:
+            return yaml.safe_load(f)
+
 # Configure logging
 logging.basicConfig(
     level=logging.INFO,
@@ -41,13 +50,11 @@ class ConanAutomation:
         
     def _load_config(self) -> Dict:
         """Load CI configuration from YAML file"""
-        if not self.config_path.exists():
+        config = load_config(self.config_path)
+        if config is None:
             log.warning(f"Config file {self.config_path} not found, using defaults")
             return self._get_default_config()
             
-        with open(self.config_path, 'r') as f:
-            config = yaml.safe_load(f)
-            
         # Resolve environment variables
         config = self._resolve_env_vars(config)
         return config
@@ -18,6 +18,15 @@ from typing import Dict, List, Optional, Tuple
 import yaml
 import requests
 
+try:
+    from openssl_tools.config_snapshot import load_config
+except ImportError:  # Run as a script without openssl_tools installed
+    def load_config(path, default=None):
+        if not os.path.exists(path):
+            return default
+        with open(path, 'r') as f:
+            return yaml.safe_load(f)
+
 
 class DeploymentManager:
     """Deployment manager for OpenSSL packages"""
@@ -43,13 +52,11 @@ class DeploymentManager:
         
     def _load_config(self) -> Dict:
         """Load deployment configuration"""
-        if not self.config_path.exists():
+        config = load_config(self.config_path)
+        if config is None:
             self.logger.warning(f"Config file {self.config_path} not found, using defaults")
             return self._get_default_config()
             
-        with open(self.config_path, 'r') as f:
-            config = yaml.safe_load(f)
-            
         return config
         
     def _get_default_config(self) -> Dict:
@@ -0,0 +1,128 @@
+#!/usr/bin/env python3
+"""
+Package archive compression: gzip (Conan's default) or multi-threaded zstd
+
+Conan packs every package as conan_package.tgz with single-threaded
+gzip, which dominates upload time for the multi-hundred-MB static and
+debug OpenSSL builds. Recent Conan releases can write zstd archives
+(conan_package.tzst) themselves, selected with the
+core.upload:compression_format conf. conan_compression_args() returns
+that conf when the installed Conan knows it, so `conan upload` uses zstd
+where it can and stays on gzip otherwise. Clients resolve the archive
+format from the file name, so zstd uploads need consumers on a Conan
+that reads .tzst as well.
+
+Release assets that are not Conan packages (package_upload.py) are
+packed here directly: tar streamed into the `zstandard` module with one
+compression thread per core, or into `zstd -T0` when only the CLI is
+installed. benchmark() packs the same folder both ways and reports
+seconds and bytes for each.
+"""
+
+import os
+import shutil
+import subprocess
+import tarfile
+import time
+from pathlib import Path
+from typing import Dict, List, Optional
+
+FORMATS = ("gzip", "zstd")
+EXTENSIONS = {"gzip": ".tgz", "zstd": ".tar.zst"}
+# gzip 9 is Conan's core.gzip:compresslevel default; zstd 10 packs smaller than it, much faster
+DEFAULT_LEVELS = {"gzip": 9, "zstd": 10}
+CONAN_COMPRESSION_CONF = "core.upload:compression_format"
+
+
+def _zstandard():
+    try:
+        import zstandard
+        return zstandard
+    except ImportError:
+        return None
+
+
+def zstd_available() -> bool:
+    return _zstandard() is not None or shutil.which("zstd") is not None
+
+
+def conan_supports_zstd(conan: str = "conan") -> bool:
+    """Whether this Conan has the compression format conf (it lists known confs)"""
+    try:
+        result = subprocess.run([conan, "config", "list", "compression"], capture_output=True, text=True)
+    except OSError:
+        return False
+    return result.returncode == 0 and CONAN_COMPRESSION_CONF in result.stdout
+
+
+def conan_compression_args(fmt: str, conan: str = "conan") -> List[str]:
+    """Extra `conan upload` arguments for fmt; [] keeps Conan's gzip"""
+    if fmt == "zstd" and conan_supports_zstd(conan):
+        return ["-c", f"{CONAN_COMPRESSION_CONF}=zst"]
+    return []
+
+
+def _add_tree(tar: tarfile.TarFile, folder: Path) -> None:
+    # Sorted, so identical folders give identical archives
+    for path in sorted(folder.rglob("*")):
+        tar.add(path, arcname=path.relative_to(folder).as_posix(), recursive=False)
+
+
+def create_archive(folder: Path, output: Path, fmt: str = "zstd", level: Optional[int] = None,
+                   threads: int = 0) -> Path:
+    """
+    Pack folder into output (EXTENSIONS[fmt] appended when missing).
+    threads=0 uses one zstd worker per core; gzip is always single-threaded.
+    """
+    if fmt not in FORMATS:
+        raise ValueError(f"Unknown compression {fmt!r} (expected one of {', '.join(FORMATS)})")
+    level = DEFAULT_LEVELS[fmt] if level is None else level
+    if not output.name.endswith(EXTENSIONS[fmt]):
+        output = output.with_name(output.name + EXTENSIONS[fmt])
+
+    if fmt == "gzip":
+        with tarfile.open(output, "w:gz", compresslevel=level) as tar:
+            _add_tree(tar, folder)
+        return output
+
+    zstandard = _zstandard()
+    if zstandard is not None:
+        compressor = zstandard.ZstdCompressor(level=level, threads=threads or -1)
+        with open(output, "wb") as raw, compressor.stream_writer(raw) as writer:
+            with tarfile.open(fileobj=writer, mode="w|") as tar:
+                _add_tree(tar, folder)
+        return output
+    if shutil.which("zstd") is None:
+        raise RuntimeError("zstd compression needs the zstandard module or the zstd command")
+    with open(output, "wb") as raw:
+        process = subprocess.Popen(["zstd", "-q", f"-{level}", f"-T{threads}", "-c"],
+                                   stdin=subprocess.PIPE, stdout=raw)
+        with tarfile.open(fileobj=process.stdin, mode="w|") as tar:
+            _add_tree(tar, folder)
+        process.stdin.close()
+        if process.wait() != 0:
+            raise RuntimeError(f"zstd exited with {process.returncode}")
+    return output
+
+
+def benchmark(folder: Path, work_dir: Path, formats: Optional[List[str]] = None,
+              levels: Optional[Dict[str, int]] = None, threads: int = 0) -> List[Dict]:
+    """Pack folder once per format; seconds, bytes and ratio against the uncompressed size"""
+    work_dir.mkdir(parents=True, exist_ok=True)
+    raw_bytes = sum(p.stat().st_size for p in folder.rglob("*") if p.is_file() and not p.is_symlink())
+    results = []
+    for fmt in formats or [f for f in FORMATS if f != "zstd" or zstd_available()]:
+        level = (levels or {}).get(fmt, DEFAULT_LEVELS[fmt])
+        start = time.perf_counter()
+        archive = create_archive(folder, work_dir / f"benchmark-{fmt}", fmt, level, threads)
+        seconds = time.perf_counter() - start
+        size = archive.stat().st_size
+        results.append({"format": fmt, "level": level, "threads": (threads or os.cpu_count()) if fmt == "zstd" else 1,
+                        "seconds": round(seconds, 3), "bytes": size, "input_bytes": raw_bytes,
+                        "ratio": round(size / raw_bytes, 4) if raw_bytes else None})
+        archive.unlink()
+    if results and results[0]["format"] == "gzip":
+        for result in results:
+            result["speedup_vs_gzip"] = round(results[0]["seconds"] / result["seconds"], 2) if result["seconds"] else None
+            result["size_vs_gzip"] = round(result["bytes"] / results[0]["bytes"], 3) if results[0]["bytes"] else None
+    return results
@@ -2,6 +2,23 @@
 """
 Enhanced Multi-Registry Upload Script
 Supports Artifactory, GitHub Packages, and future registries
+
+Uploads run concurrently on a bounded worker pool, with a concurrency cap
+and a request rate limit per registry. A component whose recipe and
+package revisions the remote already has is skipped, and completed
+uploads are recorded in a state file so a rerun after an interruption
+resumes with what is still missing.
+
+Release files (--files DIR, to ARTIFACTORY_GENERIC_URL) are deployed by
+checksum: identical files are hashed and sent once, a file the target
+path already holds (HEAD, X-Checksum-Sha256) is skipped, and content the
+server stores anywhere else is linked with X-Checksum-Deploy instead of
+being transferred again. Headers and licenses shared by every matrix
+package therefore cost one request each rather than one upload each.
+
+--compression zstd makes `conan upload` write conan_package.tzst when the
+installed Conan supports it (see archive_compression.py), and falls back
+to gzip with a warning otherwise.
 """
 
 import os
@@ -9,21 +26,141 @@ import sys
 import subprocess
 import json
 import time
+import hashlib
+import threading
+import urllib.error
+import urllib.parse
+import urllib.request
+from concurrent.futures import ThreadPoolExecutor
 from datetime import datetime
 from pathlib import Path
+from typing import Dict, Iterable, Optional, Set, Tuple
+
+try:
+    from .archive_compression import FORMATS, conan_compression_args
+except ImportError:  # run as a script
+    from archive_compression import FORMATS, conan_compression_args
+
+HASH_CHUNK_SIZE = 1024 * 1024
+UPLOAD_RETRIES = 3
+
+
+def file_checksums(path: Path) -> Tuple[str, str]:
+    """(sha256, sha1) of a file; Artifactory checksum deploy wants both"""
+    sha256, sha1 = hashlib.sha256(), hashlib.sha1()
+    with open(path, "rb") as f:
+        for chunk in iter(lambda: f.read(HASH_CHUNK_SIZE), b""):
+            sha256.update(chunk)
+            sha1.update(chunk)
+    return sha256.hexdigest(), sha1.hexdigest()
+
+
+def conan_revisions(listing: Dict) -> Set[Tuple[str, ...]]:
+    """
+    (ref, recipe revision) and (ref, recipe revision, package id, package
+    revision) tuples from `conan list --format=json` output, local or remote
+    """
+    found: Set[Tuple[str, ...]] = set()
+    for refs in listing.values():
+        if not isinstance(refs, dict) or "error" in refs:
+            continue
+        for ref, info in refs.items():
+            for rrev, recipe in (info.get("revisions") or {}).items():
+                found.add((ref, rrev))
+                for package_id, package in (recipe.get("packages") or {}).items():
+                    for prev in (package.get("revisions") or {}):
+                        found.add((ref, rrev, package_id, prev))
+    return found
+
+
+class RateLimiter:
+    """Token bucket: at most `rate` acquisitions per second, bursts up to `burst`"""
+
+    def __init__(self, rate: Optional[float], burst: int = 1):
+        self.rate = rate
+        self.burst = max(1, burst)
+        self.tokens = float(self.burst)
+        self.updated = time.monotonic()
+        self._lock = threading.Lock()
+
+    def acquire(self) -> None:
+        if not self.rate:
+            return
+        while True:
+            with self._lock:
+                now = time.monotonic()
+                self.tokens = min(self.burst, self.tokens + (now - self.updated) * self.rate)
+                self.updated = now
+                if self.tokens >= 1:
+                    self.tokens -= 1
+                    return
+                wait = (1 - self.tokens) / self.rate
+            time.sleep(wait)
+
+
+class RegistryLimits:
+    """Concurrent upload cap and request rate limit for one registry"""
+
+    def __init__(self, max_concurrent: int = 4, rate: Optional[float] = None):
+        self.slots = threading.BoundedSemaphore(max(1, max_concurrent))
+        self.limiter = RateLimiter(rate, burst=max(1, max_concurrent))
+
+    def __enter__(self):
+        self.slots.acquire()
+        self.limiter.acquire()
+        return self
+
+    def __exit__(self, *exc):
+        self.slots.release()
+        return False
+
 
 class MultiRegistryUploader:
-    def __init__(self):
+    def __init__(self, max_workers: int = 8, max_per_registry: int = 4,
+                 rates: Optional[Dict[str, float]] = None, state_file: Optional[Path] = None,
+                 compression: str = "gzip"):
         self.components = ["openssl-crypto", "openssl-ssl", "openssl-tools"]
         self.version = "3.2.0"
         self.upload_stats = {
             "started_at": datetime.now().isoformat(),
             "uploads": []
         }
+        self.max_workers = max(1, max_workers)
+        rates = rates or {}
+        self.limits = {registry: RegistryLimits(max_per_registry, rates.get(registry))
+                       for registry in ("artifactory", "github_packages", "artifactory_generic")}
+        self.state_file = Path(state_file or "upload-state.json")
+        self.state = self._load_state()
+        self._lock = threading.Lock()
+        self.compression = compression
+        self._compression_args: Optional[list] = None
     
     def log(self, message, level="INFO"):
         timestamp = datetime.now().strftime("%H:%M:%S")
-        print(f"[{timestamp}] {level}: {message}")
+        print(f"[{timestamp}] {level}: {message}", flush=True)
+    
+    def _load_state(self) -> Dict:
+        try:
+            state = json.loads(self.state_file.read_text(encoding="utf-8"))
+            if isinstance(state, dict):
+                state.setdefault("uploaded", {})
+                return state
+        except (OSError, ValueError):
+            pass
+        return {"uploaded": {}}
+    
+    def _mark_uploaded(self, key: str, value) -> None:
+        """Record a finished upload; written after each one so an interrupted run can resume"""
+        with self._lock:
+            self.state["uploaded"][key] = value
+            tmp = self.state_file.with_name(f".{self.state_file.name}.tmp")
+            tmp.write_text(json.dumps(self.state, indent=2), encoding="utf-8")
+            os.replace(tmp, self.state_file)
+    
+    def _record(self, entry: Dict) -> None:
+        entry["timestamp"] = datetime.now().isoformat()
+        with self._lock:
+            self.upload_stats["uploads"].append(entry)
     
     def run_command(self, cmd, check=True):
         """Execute command and return result"""
@@ -69,74 +206,224 @@ class MultiRegistryUploader:
         self.log("📦 GitHub Packages setup (placeholder)")
         return True
     
-    def upload_component_to_artifactory(self, component):
-        """Upload single component to Artifactory"""
+    def _conan_list(self, pattern: str, remote: Optional[str] = None) -> Set[Tuple[str, ...]]:
+        cmd = ["conan", "list", pattern, "--format=json"]
+        if remote:
+            cmd += ["-r", remote]
+        result = subprocess.run(cmd, capture_output=True, text=True)
+        if result.returncode != 0:
+            return set()
+        try:
+            return conan_revisions(json.loads(result.stdout))
+        except ValueError:
+            return set()
+    
+    def compression_args(self) -> list:
+        """conan upload conf for self.compression, resolved once per run"""
+        if self._compression_args is None:
+            self._compression_args = conan_compression_args(self.compression)
+            if self.compression == "zstd" and not self._compression_args:
+                self.log("Conan has no zstd package archives, uploading gzip", "WARN")
+            self.upload_stats["compression"] = "zstd" if self._compression_args else "gzip"
+        return self._compression_args
+    
+    def component_revisions(self, component) -> Set[Tuple[str, ...]]:
+        """Latest recipe revision of component in the local cache, with all its package revisions"""
+        return self._conan_list(f"{component}/{self.version}#latest:*#latest")
+    
+    def upload_component_to_artifactory(self, component, local_revisions: Optional[Set[Tuple[str, ...]]] = None):
+        """
+        Upload single component to Artifactory, unless the remote already has
+        every local recipe and package revision. Retried with backoff; conan
+        skips the revisions that did get through, so a retry resumes.
+        """
         start_time = time.time()
+        key = f"artifactory:{component}/{self.version}"
+        local = local_revisions if local_revisions is not None else self.component_revisions(component)
         
-        try:
-            result = self.run_command([
-                "conan", "upload", f"{component}/{self.version}",
-                "-r=artifactory", "--confirm"
-            ])
-            
-            duration = time.time() - start_time
-            self.upload_stats["uploads"].append({
-                "component": component,
-                "registry": "artifactory",
-                "status": "success",
-                "duration": duration,
-                "timestamp": datetime.now().isoformat()
-            })
-            
-            self.log(f"✅ {component} uploaded to Artifactory ({duration:.1f}s)")
+        if local and sorted(map(list, local)) == self.state["uploaded"].get(key):
+            self._record({"component": component, "registry": "artifactory", "status": "skipped",
+                          "reason": "state file"})
+            self.log(f"⏭️ {component} already uploaded to Artifactory (state file)")
             return True
-            
-        except subprocess.CalledProcessError:
-            self.upload_stats["uploads"].append({
-                "component": component,
-                "registry": "artifactory", 
-                "status": "failed",
-                "timestamp": datetime.now().isoformat()
-            })
-            self.log(f"❌ {component} upload to Artifactory failed", "ERROR")
-            return False
+        
+        limits = self.limits["artifactory"]
+        with limits:
+            remote = self._conan_list(f"{component}/{self.version}#*:*#*", remote="artifactory") if local else set()
+        if local and local <= remote:
+            self._mark_uploaded(key, sorted(map(list, local)))
+            self._record({"component": component, "registry": "artifactory", "status": "skipped",
+                          "reason": "remote has all revisions"})
+            self.log(f"⏭️ {component} already on Artifactory, skipping")
+            return True
+        
+        for attempt in range(1, UPLOAD_RETRIES + 1):
+            try:
+                with limits:
+                    self.run_command([
+                        "conan", "upload", f"{component}/{self.version}",
+                        "-r=artifactory", "--confirm"
+                    ] + self.compression_args())
+                break
+            except subprocess.CalledProcessError:
+                if attempt == UPLOAD_RETRIES:
+                    self._record({"component": component, "registry": "artifactory",
+                                  "status": "failed", "attempts": attempt})
+                    self.log(f"❌ {component} upload to Artifactory failed", "ERROR")
+                    return False
+                self.log(f"⚠️ {component} upload attempt {attempt} failed, retrying", "WARN")
+                time.sleep(2 ** attempt)
+        
+        duration = time.time() - start_time
+        if local:
+            self._mark_uploaded(key, sorted(map(list, local)))
+        self._record({"component": component, "registry": "artifactory", "status": "success",
+                      "duration": duration, "attempts": attempt,
+                      "compression": self.upload_stats.get("compression", "gzip")})
+        self.log(f"✅ {component} uploaded to Artifactory ({duration:.1f}s)")
+        return True
     
     def upload_component_to_github(self, component):
         """Upload single component to GitHub Packages"""
-        self.log(f"📦 {component} → GitHub Packages (placeholder)")
+        with self.limits["github_packages"]:
+            self.log(f"📦 {component} → GitHub Packages (placeholder)")
         
-        self.upload_stats["uploads"].append({
+        self._record({
             "component": component,
             "registry": "github_packages",
-            "status": "placeholder",
-            "timestamp": datetime.now().isoformat()
+            "status": "placeholder"
         })
         return True
     
-    def upload_all_components(self):
-        """Upload all components to all configured registries"""
+    # -- release files (Artifactory generic repository) ---------------------
+    
+    def _generic_request(self, method: str, url: str, headers: Dict[str, str], data=None,
+                         length: Optional[int] = None):
+        request = urllib.request.Request(url, data=data, method=method, headers=dict(headers))
+        if length is not None:
+            request.add_header("Content-Length", str(length))
+        with self.limits["artifactory_generic"]:
+            return urllib.request.urlopen(request, timeout=300)
+    
+    def deploy_file(self, base_url: str, rel_path: str, path: Path, sha256: str, sha1: str,
+                    headers: Dict[str, str]) -> str:
+        """
+        Deploy one file by checksum; returns "present", "linked" or "uploaded".
+        HEAD first: an identical file already at the path costs nothing more.
+        Then a checksum deploy, which the server satisfies from content it
+        already stores anywhere; only on 404 is the body sent.
+        """
+        url = f"{base_url.rstrip('/')}/{urllib.parse.quote(rel_path)}"
+        try:
+            with self._generic_request("HEAD", url, headers) as response:
+                if response.headers.get("X-Checksum-Sha256") == sha256:
+                    return "present"
+        except urllib.error.HTTPError as e:
+            if e.code != 404:
+                raise
+        
+        checksum_headers = dict(headers, **{"X-Checksum-Sha256": sha256, "X-Checksum-Sha1": sha1})
+        try:
+            with self._generic_request("PUT", url, dict(checksum_headers, **{"X-Checksum-Deploy": "true"}),
+                                       data=b"", length=0):
+                return "linked"
+        except urllib.error.HTTPError as e:
+            if e.code != 404:
+                raise
+        
+        with open(path, "rb") as f:
+            with self._generic_request("PUT", url, checksum_headers, data=f, length=path.stat().st_size):
+                return "uploaded"
+    
+    def upload_release_files(self, files_dir: Path, base_url: str, prefix: str = "") -> bool:
+        """
+        Upload every file under files_dir to base_url/prefix/<relative path>
+        on the worker pool, by checksum (see deploy_file). Files with the
+        same content are sent once; files recorded in the state file with
+        the same checksum are not contacted again on a resumed run.
+        """
+        headers = {}
+        if os.getenv("ARTIFACTORY_TOKEN"):
+            headers["Authorization"] = f"Bearer {os.environ['ARTIFACTORY_TOKEN']}"
+        if os.getenv("ARTIFACTORY_API_KEY"):
+            headers["X-JFrog-Art-Api"] = os.environ["ARTIFACTORY_API_KEY"]
+        
+        files = sorted(p for p in files_dir.rglob("*") if p.is_file() and not p.is_symlink())
+        counts = {"present": 0, "linked": 0, "uploaded": 0, "resumed": 0, "failed": 0}
+        start_time = time.time()
+        
+        def deploy(item: Tuple[Path, Tuple[str, str]]) -> str:
+            path, (sha256, sha1) = item
+            rel_path = "/".join(p for p in (prefix.strip("/"), path.relative_to(files_dir).as_posix()) if p)
+            key = f"generic:{rel_path}"
+            if self.state["uploaded"].get(key) == sha256:
+                return "resumed"
+            for attempt in range(1, UPLOAD_RETRIES + 1):
+                try:
+                    outcome = self.deploy_file(base_url, rel_path, path, sha256, sha1, headers)
+                    break
+                except (urllib.error.URLError, OSError) as e:
+                    if attempt == UPLOAD_RETRIES:
+                        self.log(f"❌ {rel_path}: {e}", "ERROR")
+                        return "failed"
+                    time.sleep(2 ** attempt)
+            self._mark_uploaded(key, sha256)
+            return outcome
+        
+        self.log(f"📤 Deploying {len(files)} release files to {base_url}")
+        with ThreadPoolExecutor(max_workers=self.max_workers) as pool:
+            items = list(zip(files, pool.map(file_checksums, files)))
+            # One file per distinct content first; its duplicates follow once
+            # the server has the content and become checksum deploys
+            first, duplicates, seen = [], [], set()
+            for item in items:
+                (duplicates if item[1][0] in seen else first).append(item)
+                seen.add(item[1][0])
+            for batch in (first, duplicates):
+                for outcome in pool.map(deploy, batch):
+                    counts[outcome] += 1
+        
+        duration = time.time() - start_time
+        self._record({"component": str(files_dir), "registry": "artifactory_generic",
+                      "status": "failed" if counts["failed"] else "success",
+                      "duration": duration, "files": counts})
+        self.log(f"📊 {counts['uploaded']} uploaded, {counts['linked']} linked by checksum, "
+                 f"{counts['present'] + counts['resumed']} already present, {counts['failed']} failed "
+                 f"({duration:.1f}s)")
+        return counts["failed"] == 0
+    
+    def upload_all_components(self, files_dir: Optional[Path] = None):
+        """
+        Upload all components to all configured registries, concurrently on
+        max_workers threads within each registry's limits, then the optional
+        release files
+        """
         self.log("🚀 Starting multi-registry upload process")
         
         artifactory_available = self.setup_artifactory()
         github_available = self.setup_github_packages()
+        generic_url = os.getenv("ARTIFACTORY_GENERIC_URL") if files_dir else None
+        if files_dir and not generic_url:
+            self.log("ARTIFACTORY_GENERIC_URL not set, skipping release files", "WARN")
         
-        if not artifactory_available and not github_available:
+        if not artifactory_available and not github_available and not generic_url:
             self.log("No registries available for upload", "ERROR")
             return False
         
-        success_count = 0
-        total_uploads = 0
-        
+        tasks = []
         for component in self.components:
             if artifactory_available:
-                total_uploads += 1
-                if self.upload_component_to_artifactory(component):
-                    success_count += 1
-            
+                tasks.append((self.upload_component_to_artifactory, component))
             if github_available:
-                total_uploads += 1
-                if self.upload_component_to_github(component):
-                    success_count += 1
+                tasks.append((self.upload_component_to_github, component))
+        
+        with ThreadPoolExecutor(max_workers=self.max_workers) as pool:
+            results = list(pool.map(lambda task: task[0](task[1]), tasks))
+        if generic_url:
+            results.append(self.upload_release_files(files_dir, generic_url, prefix=self.version))
+        
+        success_count = sum(1 for ok in results if ok)
+        total_uploads = len(results)
         
         success_rate = (success_count / total_uploads * 100) if total_uploads > 0 else 0
         self.log(f"📊 Upload Summary: {success_count}/{total_uploads} successful ({success_rate:.1f}%)")
@@ -149,10 +436,38 @@ class MultiRegistryUploader:
         
         return success_rate == 100.0
 
+def parse_rates(values: Iterable[str]) -> Dict[str, float]:
+    """REGISTRY=REQUESTS_PER_SECOND pairs"""
+    rates = {}
+    for value in values:
+        registry, _, rate = value.partition("=")
+        try:
+            rates[registry] = float(rate)
+        except ValueError:
+            raise SystemExit(f"--rate expects REGISTRY=REQUESTS_PER_SECOND, got {value!r}")
+    return rates
+
+
 def main():
-    uploader = MultiRegistryUploader()
+    import argparse
+    
+    parser = argparse.ArgumentParser(description="Upload components to all configured registries")
+    parser.add_argument("--jobs", type=int, default=8, help="Concurrent uploads overall")
+    parser.add_argument("--per-registry", type=int, default=4, help="Concurrent uploads per registry")
+    parser.add_argument("--rate", action="append", default=[], metavar="REGISTRY=RPS",
+                        help="Request rate limit, e.g. artifactory=2 or artifactory_generic=20")
+    parser.add_argument("--files", type=Path, help="Release files to deploy to ARTIFACTORY_GENERIC_URL")
+    parser.add_argument("--state", type=Path, default=Path("upload-state.json"),
+                        help="Completed uploads, used to resume an interrupted run")
+    parser.add_argument("--compression", choices=FORMATS, default="gzip",
+                        help="Conan package archive format (zstd needs Conan support)")
+    args = parser.parse_args()
+    
+    uploader = MultiRegistryUploader(max_workers=args.jobs, max_per_registry=args.per_registry,
+                                     rates=parse_rates(args.rate), state_file=args.state,
+                                     compression=args.compression)
     
-    if uploader.upload_all_components():
+    if uploader.upload_all_components(args.files):
         print("🎉 All uploads completed successfully!")
         sys.exit(0)
     else:
@@ -15,6 +15,13 @@ import json
 import requests
 from datetime import datetime
 
+try:
+    from .archive_compression import FORMATS, benchmark, create_archive
+except ImportError:  # run as a script
+    from archive_compression import FORMATS, benchmark, create_archive
+
+ASSET_CONTENT_TYPES = {".zip": "application/zip", ".tgz": "application/gzip", ".zst": "application/zstd"}
+
 def get_package_info():
     """Get package information from Conan cache"""
     try:
@@ -54,12 +61,18 @@ def get_package_info():
         print(f"❌ Failed to get package info: {e}")
         return None
 
-def create_package_archive(package_info, output_dir):
-    """Create a zip archive of the Conan package"""
+def create_package_archive(package_info, output_dir, compression="zip"):
+    """Create a zip, .tgz or multi-threaded .tar.zst archive of the Conan package"""
     try:
         # Get package folder path
         package_folder = Path(package_info["package_folder"])
         
+        if compression != "zip":
+            zip_path = create_archive(package_folder, output_dir / f"openssl-tools-{package_info['version']}",
+                                      compression)
+            print(f"✅ Created package archive: {zip_path}")
+            return zip_path
+        
         # Create zip file
         zip_path = output_dir / f"openssl-tools-{package_info['version']}.zip"
         
@@ -123,7 +136,7 @@ def create_github_release(owner, repo, version, token, zip_path):
             
             asset_headers = {
                 "Authorization": f"token {token}",
-                "Content-Type": "application/zip"
+                "Content-Type": ASSET_CONTENT_TYPES.get(zip_path.suffix, "application/octet-stream")
             }
             
             asset_response = requests.post(
@@ -153,16 +166,30 @@ def main():
     parser.add_argument("--github-repo", required=True, help="GitHub repository name")
     parser.add_argument("--github-token", help="GitHub Personal Access Token")
     parser.add_argument("--version", help="Package version (auto-detected if not provided)")
+    parser.add_argument("--compression", choices=("zip",) + FORMATS, default="zip",
+                        help="Release asset format; zstd compresses on every core")
+    parser.add_argument("--benchmark-compression", type=Path, metavar="REPORT",
+                        help="Only time gzip vs zstd on the package folder and write a JSON report")
     
     args = parser.parse_args()
     
-    print("🚀 Uploading Conan package to GitHub...")
-    
     # Get package info
     package_info = get_package_info()
     if not package_info:
         return 1
     
+    if args.benchmark_compression:
+        with tempfile.TemporaryDirectory() as temp_dir:
+            results = benchmark(Path(package_info["package_folder"]), Path(temp_dir))
+        for result in results:
+            print(f"📊 {result['format']:5} level {result['level']:2}: {result['seconds']:8.2f}s "
+                  f"{result['bytes'] / 1e6:10.1f} MB ({result['ratio']:.1%} of input)")
+        args.benchmark_compression.write_text(json.dumps(results, indent=2))
+        print(f"✅ Compression benchmark written: {args.benchmark_compression}")
+        return 0
+    
+    print("🚀 Uploading Conan package to GitHub...")
+    
     version = args.version or package_info.get("version", "unknown")
     print(f"📦 Package: {package_info['name']} {version}")
     
@@ -180,7 +207,7 @@ def main():
         temp_path = Path(temp_dir)
         
         # Create package archive
-        zip_path = create_package_archive(package_info, temp_path)
+        zip_path = create_package_archive(package_info, temp_path, args.compression)
         if not zip_path:
             return 1
         
@@ -14,6 +14,12 @@ from typing import Dict, List, Optional
 import argparse
 import logging
 
+try:
+    from ...util.python_env_cache import LockFileError, PythonEnvCache, find_requirements_lock
+except ImportError:
+    # Run as a script: no tool environment cache
+    PythonEnvCache = None
+
 # Configure logging
 logging.basicConfig(level=logging.INFO, format='%(asctime)s - %(levelname)s - %(message)s')
 logger = logging.getLogger(__name__)
@@ -37,7 +43,7 @@ class ConanPythonEnvironmentSetup:
             self._create_directory_structure()
             
             # Set up Python environment
-            self._setup_python_environment()
+            self._setup_python_environment(force=force)
             
             # Create platform-specific launchers
             self._create_platform_launchers()
@@ -74,7 +80,7 @@ class ConanPythonEnvironmentSetup:
             directory.mkdir(parents=True, exist_ok=True)
             logger.info(f"📁 Created directory: {directory}")
     
-    def _setup_python_environment(self):
+    def _setup_python_environment(self, force: bool = False):
         """Set up Python environment with Conan orchestrator"""
         logger.info("🐍 Setting up Python environment...")
         
@@ -94,7 +100,22 @@ class ConanPythonEnvironmentSetup:
                 if self.platform != "windows":
                     os.chmod(script_path, 0o755)
                 logger.info(f"✅ Made executable: {script}")
-    
+
+        self._setup_tool_venv(force)
+
+    def _setup_tool_venv(self, force: bool = False):
+        """conan-dev/venv from the requirements lock, linked from the environment cache"""
+        lock_file = find_requirements_lock(self.project_root) if PythonEnvCache else None
+        if lock_file is None:
+            logger.info("No requirements lock (conan-dev/locks/requirements.lock): tool venv not set up")
+            return
+        try:
+            result = PythonEnvCache().materialize(sys.executable, lock_file, self.conan_dir / "venv", force=force)
+        except LockFileError as e:
+            raise RuntimeError(f"Cannot use the requirements lock: {e}") from e
+        state = "up to date" if result.up_to_date else "from cache" if result.cache_hit else "built"
+        logger.info(f"✅ Tool venv {state}: {result.target} ({result.key})")
+
     def _create_platform_launchers(self):
         """Create platform-specific launcher scripts"""
         logger.info("🔗 Creating platform-specific launchers...")
@@ -10,6 +10,8 @@ Classes:
     WorkflowRecovery: Automated workflow recovery and retry logic
     WorkflowHealthChecker: Workflow health analysis and recommendations
     UnifiedWorkflowManager: Unified interface combining legacy tools with MCP capabilities
+    GitHubClient: Pooled, ETag-cached and rate-limit-aware GitHub REST access
+    WorkflowEventStore: Webhook receiver with the latest state of each run
 """
 
 from .manager import WorkflowManager
@@ -17,6 +19,8 @@ from .monitor import WorkflowMonitor
 from .recovery import WorkflowRecovery
 from .health_check import WorkflowHealthChecker
 from .unified import UnifiedWorkflowManager
+from .github_client import GitHubClient
+from .events import WorkflowEventStore
 
 __all__ = [
     "WorkflowManager",
@@ -24,4 +28,6 @@ __all__ = [
     "WorkflowRecovery",
     "WorkflowHealthChecker",
     "UnifiedWorkflowManager",
+    "GitHubClient",
+    "WorkflowEventStore",
 ]
\ No newline at end of file
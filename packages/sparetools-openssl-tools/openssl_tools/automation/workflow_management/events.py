@@ -0,0 +1,120 @@
+#!/usr/bin/env python3
+"""
+GitHub Actions webhook event store
+
+Keeps the latest workflow_run payload per run and the failed job names
+reported by workflow_job events. WorkflowRecovery waits on it instead of
+polling each run, and WorkflowHealthChecker subscribes to it to update its
+run summaries as runs complete. serve() accepts the webhook deliveries
+itself (X-Hub-Signature-256 checked when a secret is set). Deliveries
+received another way can be passed to handle().
+"""
+
+import hashlib
+import hmac
+import json
+import threading
+import time
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+from typing import Callable, Dict, List, Optional, Set
+
+
+class WorkflowEventStore:
+    """Latest workflow run state from webhook deliveries, safe for concurrent use"""
+
+    def __init__(self, secret: Optional[str] = None):
+        self.secret = secret.encode() if secret else None
+        self.runs: Dict[int, Dict] = {}
+        self.received_at: Dict[int, float] = {}
+        self.failed_jobs: Dict[int, Set[str]] = {}
+        self._listeners: List[Callable[[Dict, Optional[Set[str]]], None]] = []
+        self._changed = threading.Condition()
+        self._server: Optional[ThreadingHTTPServer] = None
+
+    def subscribe(self, listener: Callable[[Dict, Optional[Set[str]]], None]) -> None:
+        """Call listener(run, failed_job_names) for every completed run"""
+        self._listeners.append(listener)
+
+    def verify(self, body: bytes, signature: Optional[str]) -> bool:
+        if self.secret is None:
+            return True
+        expected = "sha256=" + hmac.new(self.secret, body, hashlib.sha256).hexdigest()
+        return signature is not None and hmac.compare_digest(expected, signature)
+
+    def handle(self, event: str, payload: Dict) -> bool:
+        """Record one delivery (X-GitHub-Event name and JSON body); False if ignored"""
+        if event == "workflow_job":
+            job = payload.get("workflow_job") or {}
+            if job.get("status") != "completed" or job.get("conclusion") != "failure":
+                return False
+            with self._changed:
+                self.failed_jobs.setdefault(job["run_id"], set()).add(job["name"])
+            return True
+        if event != "workflow_run" or "workflow_run" not in payload:
+            return False
+
+        run = payload["workflow_run"]
+        with self._changed:
+            previous = self.runs.get(run["id"])
+            # Deliveries can arrive out of order; keep the newest state
+            if previous and (previous.get("run_attempt", 1), previous.get("updated_at", "")) > \
+                    (run.get("run_attempt", 1), run.get("updated_at", "")):
+                return False
+            if previous and run.get("run_attempt", 1) > previous.get("run_attempt", 1):
+                self.failed_jobs.pop(run["id"], None)  # Failures of the earlier attempt
+            self.runs[run["id"]] = run
+            self.received_at[run["id"]] = time.monotonic()
+            failed = set(self.failed_jobs.get(run["id"], ())) or None
+            self._changed.notify_all()
+        if run.get("status") == "completed":
+            for listener in self._listeners:
+                listener(run, failed)
+        return True
+
+    def get(self, run_id: int) -> Optional[Dict]:
+        with self._changed:
+            return self.runs.get(run_id)
+
+    def last_received(self, run_id: int) -> Optional[float]:
+        """time.monotonic() of the latest delivery for run_id, None if none yet"""
+        with self._changed:
+            return self.received_at.get(run_id)
+
+    def wait(self, timeout: float) -> None:
+        """Block until the next delivery or timeout"""
+        with self._changed:
+            self._changed.wait(timeout)
+
+    def serve(self, host: str = "0.0.0.0", port: int = 8787) -> ThreadingHTTPServer:
+        """Accept webhook POSTs on a background thread"""
+        store = self
+
+        class Handler(BaseHTTPRequestHandler):
+            def do_POST(self):
+                body = self.rfile.read(int(self.headers.get("Content-Length", 0)))
+                if not store.verify(body, self.headers.get("X-Hub-Signature-256")):
+                    self.send_response(401)
+                    self.end_headers()
+                    return
+                try:
+                    store.handle(self.headers.get("X-GitHub-Event", ""), json.loads(body or b"{}"))
+                except (ValueError, KeyError):
+                    self.send_response(400)
+                    self.end_headers()
+                    return
+                self.send_response(204)
+                self.end_headers()
+
+            def log_message(self, format, *args):
+                pass
+
+        self._server = ThreadingHTTPServer((host, port), Handler)
+        threading.Thread(target=self._server.serve_forever, daemon=True).start()
+        print(f"📡 Receiving GitHub webhooks on {host}:{self._server.server_address[1]}")
+        return self._server
+
+    def close(self) -> None:
+        if self._server is not None:
+            self._server.shutdown()
+            self._server.server_close()
+            self._server = None
@@ -0,0 +1,180 @@
+#!/usr/bin/env python3
+"""
+GitHub REST client shared by the workflow management tools
+
+A pooled requests.Session whose connection pool fits every worker, so
+fan-outs over many runs and jobs reuse a few keep-alive connections.
+Responses are cached under ~/.cache/openssl-tools/github: listings are
+revalidated with If-None-Match (an unchanged listing comes back as a
+304, which costs no rate-limit quota) and resources that cannot change
+any more - the jobs and logs of a completed run - are served from the
+cache without a request.
+
+map() runs calls on a thread pool whose effective width follows the rate
+limit: full width while X-RateLimit-Remaining is plentiful, narrower as
+it falls towards min_remaining, and calls wait for X-RateLimit-Reset once
+it is reached. Throttled responses (403/429 with Retry-After or no
+remaining quota) are retried.
+"""
+
+import hashlib
+import json
+import os
+import threading
+import time
+from concurrent.futures import ThreadPoolExecutor
+from pathlib import Path
+from typing import Any, Callable, Dict, Iterable, List, Optional
+
+import requests
+from requests.adapters import HTTPAdapter
+
+GITHUB_API_URL = "https://api.github.com"
+DEFAULT_CACHE_DIR = Path(os.environ.get("XDG_CACHE_HOME", Path.home() / ".cache")) / "openssl-tools" / "github"
+DEFAULT_MAX_WORKERS = 8
+# Requests kept in reserve for other tools sharing the token
+DEFAULT_MIN_REMAINING = 100
+# Remaining quota per concurrent request slot
+QUOTA_PER_SLOT = 50
+MAX_RETRIES = 3
+
+
+class GitHubClient:
+    """Cached, rate-limit-aware GitHub REST access for concurrent callers"""
+
+    def __init__(self, token: Optional[str], cache_dir: Optional[Path] = DEFAULT_CACHE_DIR,
+                 max_workers: int = DEFAULT_MAX_WORKERS, min_remaining: int = DEFAULT_MIN_REMAINING,
+                 user_agent: str = "OpenSSL-Tools"):
+        self.cache_dir = Path(cache_dir) if cache_dir else None
+        self.max_workers = max(1, max_workers)
+        self.min_remaining = min_remaining
+        self.remaining: Optional[int] = None
+        self.reset_at: Optional[float] = None
+        self.stats = {"requests": 0, "not_modified": 0, "cached": 0}
+
+        self.session = requests.Session()
+        self.session.headers.update({
+            'Accept': 'application/vnd.github.v3+json',
+            'User-Agent': user_agent,
+        })
+        if token:
+            self.session.headers['Authorization'] = f'token {token}'
+        adapter = HTTPAdapter(pool_connections=4, pool_maxsize=self.max_workers + 2)
+        self.session.mount("https://", adapter)
+        self.session.mount("http://", adapter)
+
+        self._in_flight = 0
+        self._slots = threading.Condition()
+
+    # -- cache ----------------------------------------------------------------
+
+    def _cache_path(self, url: str, params: Optional[Dict]) -> Optional[Path]:
+        if self.cache_dir is None:
+            return None
+        key = hashlib.sha256(f"{url}?{json.dumps(sorted((params or {}).items()), default=str)}".encode())
+        digest = key.hexdigest()
+        return self.cache_dir / digest[:2] / f"{digest}.json"
+
+    @staticmethod
+    def _cache_read(path: Optional[Path]) -> Optional[Dict]:
+        if path is None:
+            return None
+        try:
+            with open(path) as f:
+                return json.load(f)
+        except (OSError, ValueError):
+            return None
+
+    @staticmethod
+    def _cache_write(path: Optional[Path], entry: Dict) -> None:
+        if path is None:
+            return
+        path.parent.mkdir(parents=True, exist_ok=True)
+        tmp = path.with_suffix(f".{os.getpid()}.{threading.get_ident()}.tmp")
+        with open(tmp, 'w') as f:
+            json.dump(entry, f)
+        os.replace(tmp, path)
+
+    # -- rate limit -----------------------------------------------------------
+
+    def _limit(self) -> int:
+        if self.remaining is None:
+            return self.max_workers
+        return max(1, min(self.max_workers, (self.remaining - self.min_remaining) // QUOTA_PER_SLOT))
+
+    def _acquire(self) -> None:
+        with self._slots:
+            self._slots.wait_for(lambda: self._in_flight < self._limit())
+            self._in_flight += 1
+        if self.remaining is not None and self.remaining <= self.min_remaining and self.reset_at:
+            delay = self.reset_at - time.time()
+            if delay > 0:
+                print(f"⏳ GitHub rate limit reserve reached, waiting {delay:.0f}s for reset")
+                time.sleep(delay + 1)
+                self.remaining = None
+
+    def _release(self, response: Optional[requests.Response]) -> None:
+        with self._slots:
+            if response is not None and 'X-RateLimit-Remaining' in response.headers:
+                self.remaining = int(response.headers['X-RateLimit-Remaining'])
+                self.reset_at = float(response.headers.get('X-RateLimit-Reset', 0)) or None
+            self._in_flight -= 1
+            self._slots.notify_all()
+
+    @staticmethod
+    def _retry_delay(response: requests.Response) -> Optional[float]:
+        if response.status_code not in (403, 429):
+            return None
+        if 'Retry-After' in response.headers:
+            return float(response.headers['Retry-After'])
+        if response.headers.get('X-RateLimit-Remaining') == '0':
+            return max(0.0, float(response.headers.get('X-RateLimit-Reset', 0)) - time.time()) + 1
+        return None
+
+    # -- requests -------------------------------------------------------------
+
+    def get(self, url: str, params: Optional[Dict] = None, immutable: bool = False,
+            text: bool = False) -> Any:
+        """
+        GET url (absolute, or relative to the API root), as JSON or text.
+        Raises requests.RequestException like requests itself.
+        """
+        if not url.startswith("http"):
+            url = f"{GITHUB_API_URL}/{url.lstrip('/')}"
+        cache_path = self._cache_path(url, params)
+        cached = self._cache_read(cache_path)
+        if cached is not None and immutable:
+            self.stats["cached"] += 1
+            return cached["body"]
+
+        headers = {'If-None-Match': cached["etag"]} if cached and cached.get("etag") else {}
+        for attempt in range(MAX_RETRIES + 1):
+            self._acquire()
+            response = None
+            try:
+                self.stats["requests"] += 1
+                response = self.session.get(url, params=params, headers=headers, timeout=(30, 120))
+            finally:
+                self._release(response)
+            delay = self._retry_delay(response)
+            if delay is None or attempt == MAX_RETRIES:
+                break
+            print(f"⏳ GitHub API throttled ({response.status_code}), retrying in {delay:.0f}s")
+            time.sleep(delay)
+
+        if response.status_code == 304 and cached is not None:
+            self.stats["not_modified"] += 1
+            return cached["body"]
+        response.raise_for_status()
+        body = response.text if text else response.json()
+        self._cache_write(cache_path, {"etag": response.headers.get('ETag'), "fetched": time.time(),
+                                       "body": body})
+        return body
+
+    def map(self, fn: Callable[[Any], Any], items: Iterable[Any]) -> List[Any]:
+        """fn over items on the worker pool, results in order"""
+        items = list(items)
+        if len(items) <= 1:
+            return [fn(item) for item in items]
+        with ThreadPoolExecutor(max_workers=min(self.max_workers, len(items))) as pool:
+            return list(pool.map(fn, items))
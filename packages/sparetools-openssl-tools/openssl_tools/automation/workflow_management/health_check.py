@@ -2,6 +2,13 @@
 """
 GitHub Actions Workflow Health Check
 Monitors workflow health and provides recommendations for improvement.
+
+Health metrics are computed from per-run summaries kept in the
+GitHubClient cache directory. A completed run is summarized once, and its
+jobs are fetched only if it failed. Run listings are revalidated by ETag,
+so later analyses only fetch runs that are new since the last one. With a
+WorkflowEventStore attached, webhook deliveries add summaries as runs
+complete, and analyze_workflow_health(refresh=False) needs no API calls.
 """
 
 import os
@@ -12,10 +19,19 @@ import requests
 from datetime import datetime, timedelta
 from typing import List, Dict, Optional, Tuple
 from pathlib import Path
+import threading
 import yaml
 
+from .github_client import GitHubClient, DEFAULT_CACHE_DIR, DEFAULT_MAX_WORKERS
+
+# Run summaries older than this are dropped
+SUMMARY_RETENTION_DAYS = 90
+RUNS_PER_PAGE = 100
+
 class WorkflowHealthChecker:
-    def __init__(self, repo_owner: str, repo_name: str, token: str = None):
+    def __init__(self, repo_owner: str, repo_name: str, token: str = None,
+                 cache_dir: Optional[Path] = DEFAULT_CACHE_DIR, max_workers: int = DEFAULT_MAX_WORKERS,
+                 events=None):
         self.repo_owner = repo_owner
         self.repo_name = repo_name
         self.token = token or os.getenv('GITHUB_TOKEN')
@@ -25,54 +41,134 @@ class WorkflowHealthChecker:
             'Accept': 'application/vnd.github.v3+json',
             'User-Agent': 'OpenSSL-Tools-Health-Checker'
         }
+        self.client = GitHubClient(self.token, cache_dir, max_workers,
+                                   user_agent='OpenSSL-Tools-Health-Checker')
+        self.state_path = Path(cache_dir) / f"health-{repo_owner}-{repo_name}.json" if cache_dir else None
+        self._lock = threading.Lock()
+        self.summaries = self._load_summaries()
+        if events is not None:
+            events.subscribe(self.record_run)
+    
+    def _load_summaries(self) -> Dict[str, Dict]:
+        try:
+            with open(self.state_path) as f:
+                return json.load(f)
+        except (TypeError, OSError, ValueError):
+            return {}
+    
+    def _save_summaries(self):
+        if self.state_path is None:
+            return
+        cutoff = (datetime.utcnow() - timedelta(days=SUMMARY_RETENTION_DAYS)).isoformat()
+        with self._lock:
+            self.summaries = {run_id: summary for run_id, summary in self.summaries.items()
+                              if summary['created_at'] >= cutoff}
+            data = json.dumps(self.summaries)
+        self.state_path.parent.mkdir(parents=True, exist_ok=True)
+        tmp = self.state_path.with_suffix(f".{os.getpid()}.tmp")
+        tmp.write_text(data)
+        os.replace(tmp, self.state_path)
     
-    def get_workflow_runs(self, workflow_id: str = None, limit: int = 100) -> List[Dict]:
-        """Get recent workflow runs"""
+    def get_workflow_runs(self, workflow_id: str = None, limit: int = 100, created: str = None) -> List[Dict]:
+        """Get recent workflow runs, paging up to limit (created: GitHub date filter)"""
         url = f"{self.base_url}/actions/runs"
-        params = {'per_page': limit}
+        params = {'per_page': min(limit, RUNS_PER_PAGE)}
         
         if workflow_id:
             params['workflow_id'] = workflow_id
-            
+        if created:
+            params['created'] = created
+        
+        runs = []
         try:
-            response = requests.get(url, headers=self.headers, params=params)
-            response.raise_for_status()
-            return response.json().get('workflow_runs', [])
+            page = 1
+            while len(runs) < limit:
+                batch = self.client.get(url, dict(params, page=page)).get('workflow_runs', [])
+                runs.extend(batch)
+                if len(batch) < params['per_page']:
+                    break
+                page += 1
         except requests.RequestException as e:
             print(f"Error fetching workflow runs: {e}")
-            return []
+        return runs[:limit]
     
-    def get_workflow_jobs(self, run_id: int) -> List[Dict]:
-        """Get jobs for a specific workflow run"""
+    def get_workflow_jobs(self, run_id: int, completed: bool = False) -> List[Dict]:
+        """Get jobs for a specific workflow run (cached for good once the run completed)"""
         url = f"{self.base_url}/actions/runs/{run_id}/jobs"
         
         try:
-            response = requests.get(url, headers=self.headers)
-            response.raise_for_status()
-            return response.json().get('jobs', [])
+            return self.client.get(url, {'per_page': 100}, immutable=completed).get('jobs', [])
         except requests.RequestException as e:
             print(f"Error fetching jobs for run {run_id}: {e}")
             return []
     
-    def analyze_workflow_health(self, days_back: int = 30) -> Dict:
-        """Analyze overall workflow health"""
-        cutoff_date = datetime.now() - timedelta(days=days_back)
+    def record_run(self, run: Dict, failed_jobs=None):
+        """
+        Summarize a completed run (a workflow_run payload or API object).
+        failed_jobs are the names of its failed jobs, if already known.
+        """
+        if run.get('status') != 'completed':
+            return
+        duration = None
+        if run.get('run_started_at') and run.get('updated_at'):
+            start = datetime.fromisoformat(run['run_started_at'].replace('Z', '+00:00'))
+            end = datetime.fromisoformat(run['updated_at'].replace('Z', '+00:00'))
+            duration = (end - start).total_seconds()
+        summary = {
+            'created_at': run['created_at'].replace('Z', ''),
+            'attempt': run.get('run_attempt', 1),
+            'conclusion': run.get('conclusion'),
+            'duration': duration,
+            'failed_jobs': sorted(failed_jobs) if failed_jobs is not None else None
+        }
+        with self._lock:
+            previous = self.summaries.get(str(run['id']))
+            if previous and previous['attempt'] > summary['attempt']:
+                return
+            self.summaries[str(run['id'])] = summary
+    
+    def _refresh_summaries(self, days_back: int) -> int:
+        """Summarize runs created in the window that are new or re-run; returns runs in progress"""
+        # Whole days keep the listing URLs, and so their ETags, stable
+        created = (datetime.utcnow() - timedelta(days=days_back)).strftime('>=%Y-%m-%d')
+        runs = self.get_workflow_runs(limit=1000, created=created)
         
-        # Get all workflow runs
-        runs = self.get_workflow_runs(limit=200)
-        recent_runs = []
+        in_progress = 0
         for run in runs:
-            run_time = datetime.fromisoformat(run['created_at'].replace('Z', '+00:00'))
-            cutoff_time_aware = cutoff_date.replace(tzinfo=run_time.tzinfo)
-            if run_time > cutoff_time_aware:
-                recent_runs.append(run)
+            if run['status'] in ['queued', 'in_progress']:
+                in_progress += 1
+                continue
+            known = self.summaries.get(str(run['id']))
+            if run['status'] == 'completed' and (known is None or known['attempt'] < run.get('run_attempt', 1)):
+                self.record_run(run)
+        
+        # Failure patterns: jobs of failed runs not yet analyzed, all at once
+        missing = [int(run_id) for run_id, summary in self.summaries.items()
+                   if summary['conclusion'] == 'failure' and summary['failed_jobs'] is None]
+        jobs_by_run = self.client.map(lambda run_id: self.get_workflow_jobs(run_id, completed=True), missing)
+        with self._lock:
+            for run_id, jobs in zip(missing, jobs_by_run):
+                self.summaries[str(run_id)]['failed_jobs'] = sorted(
+                    job['name'] for job in jobs if job['conclusion'] == 'failure')
+        self._save_summaries()
+        return in_progress
+    
+    def analyze_workflow_health(self, days_back: int = 30, refresh: bool = True) -> Dict:
+        """
+        Analyze overall workflow health. refresh=False uses only the
+        summaries recorded so far (e.g. from webhook events).
+        """
+        in_progress = self._refresh_summaries(days_back) if refresh else 0
+        cutoff = (datetime.utcnow() - timedelta(days=days_back)).isoformat()
+        with self._lock:
+            recent = [summary for summary in self.summaries.values() if summary['created_at'] > cutoff]
         
         health_metrics = {
-            'total_runs': len(recent_runs),
+            'total_runs': len(recent) + in_progress,
             'successful_runs': 0,
             'failed_runs': 0,
             'cancelled_runs': 0,
-            'in_progress_runs': 0,
+            'in_progress_runs': in_progress,
             'success_rate': 0.0,
             'average_duration': 0.0,
             'failure_patterns': {},
@@ -81,52 +177,29 @@ class WorkflowHealthChecker:
         }
         
         total_duration = 0
-        completed_runs = 0
-        
-        for run in recent_runs:
-            status = run['status']
-            conclusion = run.get('conclusion')
-            
-            if status == 'completed':
-                completed_runs += 1
-                if conclusion == 'success':
-                    health_metrics['successful_runs'] += 1
-                elif conclusion == 'failure':
-                    health_metrics['failed_runs'] += 1
-                    self._analyze_failure_pattern(run, health_metrics)
-                elif conclusion == 'cancelled':
-                    health_metrics['cancelled_runs'] += 1
-                
-                # Calculate duration
-                if run.get('run_started_at') and run.get('updated_at'):
-                    start = datetime.fromisoformat(run['run_started_at'].replace('Z', '+00:00'))
-                    end = datetime.fromisoformat(run['updated_at'].replace('Z', '+00:00'))
-                    duration = (end - start).total_seconds()
-                    total_duration += duration
-            elif status in ['queued', 'in_progress']:
-                health_metrics['in_progress_runs'] += 1
+        for summary in recent:
+            conclusion = summary['conclusion']
+            if conclusion == 'success':
+                health_metrics['successful_runs'] += 1
+            elif conclusion == 'failure':
+                health_metrics['failed_runs'] += 1
+                for job_name in summary['failed_jobs'] or []:
+                    health_metrics['failure_patterns'][job_name] = \
+                        health_metrics['failure_patterns'].get(job_name, 0) + 1
+            elif conclusion == 'cancelled':
+                health_metrics['cancelled_runs'] += 1
+            total_duration += summary['duration'] or 0
         
         # Calculate metrics
-        if completed_runs > 0:
-            health_metrics['success_rate'] = (health_metrics['successful_runs'] / completed_runs) * 100
-            health_metrics['average_duration'] = total_duration / completed_runs
+        if recent:
+            health_metrics['success_rate'] = (health_metrics['successful_runs'] / len(recent)) * 100
+            health_metrics['average_duration'] = total_duration / len(recent)
         
         # Generate recommendations
         health_metrics['recommendations'] = self._generate_recommendations(health_metrics)
         
         return health_metrics
     
-    def _analyze_failure_pattern(self, run: Dict, health_metrics: Dict):
-        """Analyze failure patterns in a workflow run"""
-        jobs = self.get_workflow_jobs(run['id'])
-        
-        for job in jobs:
-            if job['conclusion'] == 'failure':
-                job_name = job['name']
-                if job_name not in health_metrics['failure_patterns']:
-                    health_metrics['failure_patterns'][job_name] = 0
-                health_metrics['failure_patterns'][job_name] += 1
-    
     def _generate_recommendations(self, metrics: Dict) -> List[str]:
         """Generate recommendations based on health metrics"""
         recommendations = []
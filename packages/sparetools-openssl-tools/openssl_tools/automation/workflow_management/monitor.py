@@ -2,6 +2,10 @@
 """
 GitHub Actions Workflow Monitor
 Monitors workflow runs and identifies failed jobs for automated remediation.
+
+API calls go through GitHubClient: jobs and logs of failed runs are fetched
+concurrently, listings are revalidated by ETag and completed runs' jobs and
+logs are cached locally, so repeated scans cost little quota.
 """
 
 import os
@@ -13,8 +17,13 @@ from datetime import datetime, timedelta
 from typing import List, Dict, Optional
 from pathlib import Path
 
+from .github_client import GitHubClient, DEFAULT_CACHE_DIR, DEFAULT_MAX_WORKERS
+
+FAILED_CONCLUSIONS = ['failure', 'cancelled', 'timed_out']
+
 class WorkflowMonitor:
-    def __init__(self, repo_owner: str, repo_name: str, token: str = None):
+    def __init__(self, repo_owner: str, repo_name: str, token: str = None,
+                 cache_dir: Optional[Path] = DEFAULT_CACHE_DIR, max_workers: int = DEFAULT_MAX_WORKERS):
         self.repo_owner = repo_owner
         self.repo_name = repo_name
         self.token = token or os.getenv('GITHUB_TOKEN')
@@ -24,9 +33,12 @@ class WorkflowMonitor:
             'Accept': 'application/vnd.github.v3+json',
             'User-Agent': 'OpenSSL-Tools-Workflow-Monitor'
         }
+        self.client = GitHubClient(self.token, cache_dir, max_workers,
+                                   user_agent='OpenSSL-Tools-Workflow-Monitor')
     
-    def get_workflow_runs(self, workflow_id: str = None, status: str = None, limit: int = 10) -> List[Dict]:
-        """Get recent workflow runs"""
+    def get_workflow_runs(self, workflow_id: str = None, status: str = None, limit: int = 10,
+                          created: str = None) -> List[Dict]:
+        """Get recent workflow runs (created: GitHub date filter such as '>=2025-01-01T00:00:00Z')"""
         url = f"{self.base_url}/actions/runs"
         params = {'per_page': limit}
         
@@ -34,23 +46,21 @@ class WorkflowMonitor:
             params['workflow_id'] = workflow_id
         if status:
             params['status'] = status
-            
+        if created:
+            params['created'] = created
+        
         try:
-            response = requests.get(url, headers=self.headers, params=params)
-            response.raise_for_status()
-            return response.json().get('workflow_runs', [])
+            return self.client.get(url, params).get('workflow_runs', [])
         except requests.RequestException as e:
             print(f"Error fetching workflow runs: {e}")
             return []
     
-    def get_workflow_jobs(self, run_id: int) -> List[Dict]:
-        """Get jobs for a specific workflow run"""
+    def get_workflow_jobs(self, run_id: int, completed: bool = False) -> List[Dict]:
+        """Get jobs for a specific workflow run (cached for good once the run completed)"""
         url = f"{self.base_url}/actions/runs/{run_id}/jobs"
         
         try:
-            response = requests.get(url, headers=self.headers)
-            response.raise_for_status()
-            return response.json().get('jobs', [])
+            return self.client.get(url, {'per_page': 100}, immutable=completed).get('jobs', [])
         except requests.RequestException as e:
             print(f"Error fetching jobs for run {run_id}: {e}")
             return []
@@ -60,44 +70,56 @@ class WorkflowMonitor:
         url = f"{self.base_url}/actions/jobs/{job_id}/logs"
         
         try:
-            response = requests.get(url, headers=self.headers)
-            response.raise_for_status()
-            return response.text
+            # Logs only exist for finished jobs and never change afterwards
+            return self.client.get(url, immutable=True, text=True)
         except requests.RequestException as e:
             print(f"Error fetching logs for job {job_id}: {e}")
             return None
     
+    def get_logs_for_jobs(self, jobs: List[Dict]) -> Dict[int, Optional[str]]:
+        """Logs of many jobs (analyze_failed_jobs entries), fetched concurrently, by job_id"""
+        logs = self.client.map(lambda job: self.get_job_logs(job['run_id'], job['job_id']), jobs)
+        return {job['job_id']: log for job, log in zip(jobs, logs)}
+    
     def analyze_failed_jobs(self, hours_back: int = 24) -> List[Dict]:
         """Analyze failed jobs from the last N hours"""
         failed_jobs = []
         cutoff_time = datetime.now() - timedelta(hours=hours_back)
+        # Whole hours keep the listing URL, and so its ETag, stable between scans
+        created = (datetime.utcnow() - timedelta(hours=hours_back)).strftime('>=%Y-%m-%dT%H:00:00Z')
         
         # Get all workflow runs
-        runs = self.get_workflow_runs(status='completed', limit=50)
+        runs = self.get_workflow_runs(status='completed', limit=50, created=created)
         
+        failed_runs = []
         for run in runs:
             run_time = datetime.fromisoformat(run['created_at'].replace('Z', '+00:00'))
             # Make cutoff_time timezone-aware for comparison
             cutoff_time_aware = cutoff_time.replace(tzinfo=run_time.tzinfo)
             if run_time < cutoff_time_aware:
                 continue
-                
-            if run['conclusion'] in ['failure', 'cancelled', 'timed_out']:
-                jobs = self.get_workflow_jobs(run['id'])
-                
-                for job in jobs:
-                    if job['conclusion'] in ['failure', 'cancelled', 'timed_out']:
-                        failed_jobs.append({
-                            'run_id': run['id'],
-                            'run_number': run['run_number'],
-                            'workflow_name': run['name'],
-                            'job_id': job['id'],
-                            'job_name': job['name'],
-                            'conclusion': job['conclusion'],
-                            'created_at': run['created_at'],
-                            'html_url': run['html_url'],
-                            'job_url': job['html_url']
-                        })
+            
+            if run['conclusion'] in FAILED_CONCLUSIONS:
+                failed_runs.append(run)
+        
+        # Jobs of all failed runs at once
+        jobs_by_run = self.client.map(lambda run: self.get_workflow_jobs(run['id'], completed=True),
+                                      failed_runs)
+        
+        for run, jobs in zip(failed_runs, jobs_by_run):
+            for job in jobs:
+                if job['conclusion'] in FAILED_CONCLUSIONS:
+                    failed_jobs.append({
+                        'run_id': run['id'],
+                        'run_number': run['run_number'],
+                        'workflow_name': run['name'],
+                        'job_id': job['id'],
+                        'job_name': job['name'],
+                        'conclusion': job['conclusion'],
+                        'created_at': run['created_at'],
+                        'html_url': run['html_url'],
+                        'job_url': job['html_url']
+                    })
         
         return failed_jobs
     
@@ -134,6 +156,8 @@ class WorkflowMonitor:
         report = f"🚨 Workflow Failure Report - {len(failed_jobs)} failed jobs found\n"
         report += "=" * 60 + "\n\n"
         
+        logs_by_job = self.get_logs_for_jobs(failed_jobs)
+        
         # Group by workflow
         by_workflow = {}
         for job in failed_jobs:
@@ -152,8 +176,8 @@ class WorkflowMonitor:
                 report += f"     Run: #{job['run_number']}\n"
                 report += f"     URL: {job['job_url']}\n"
                 
-                # Get logs and categorize failure
-                logs = self.get_job_logs(job['run_id'], job['job_id'])
+                # Categorize failure from its logs
+                logs = logs_by_job.get(job['job_id'])
                 if logs:
                     categories = self.categorize_failure(logs)
                     report += f"     Category: {categories['primary_category']}\n"
@@ -168,8 +192,7 @@ class WorkflowMonitor:
         
         # Analyze patterns
         failure_categories = {}
-        for job in failed_jobs:
-            logs = self.get_job_logs(job['run_id'], job['job_id'])
+        for logs in self.get_logs_for_jobs(failed_jobs).values():
             if logs:
                 categories = self.categorize_failure(logs)
                 category = categories['primary_category']
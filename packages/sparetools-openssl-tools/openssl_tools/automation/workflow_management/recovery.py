@@ -2,6 +2,12 @@
 """
 GitHub Actions Workflow Recovery Script
 Automatically retries failed jobs and implements recovery strategies.
+
+wait_for_runs() waits for many runs at once. Runs are polled together,
+one round per interval, through GitHubClient (an unchanged run costs a
+304 and no quota). With a WorkflowEventStore the webhook deliveries
+settle runs as they complete, and a run is only polled when no delivery
+for it arrived within the interval.
 """
 
 import os
@@ -13,8 +19,15 @@ from datetime import datetime, timedelta
 from typing import List, Dict, Optional
 from pathlib import Path
 
+from .github_client import GitHubClient, DEFAULT_CACHE_DIR, DEFAULT_MAX_WORKERS
+from .events import WorkflowEventStore
+
+DEFAULT_POLL_SECONDS = 30
+
 class WorkflowRecovery:
-    def __init__(self, repo_owner: str, repo_name: str, token: str = None):
+    def __init__(self, repo_owner: str, repo_name: str, token: str = None,
+                 cache_dir: Optional[Path] = DEFAULT_CACHE_DIR, max_workers: int = DEFAULT_MAX_WORKERS,
+                 events=None):
         self.repo_owner = repo_owner
         self.repo_name = repo_name
         self.token = token or os.getenv('GITHUB_TOKEN')
@@ -24,6 +37,10 @@ class WorkflowRecovery:
             'Accept': 'application/vnd.github.v3+json',
             'User-Agent': 'OpenSSL-Tools-Workflow-Recovery'
         }
+        self.client = GitHubClient(self.token, cache_dir, max_workers,
+                                   user_agent='OpenSSL-Tools-Workflow-Recovery')
+        # Optional WorkflowEventStore fed by webhooks
+        self.events = events
     
     def rerun_failed_jobs(self, run_id: int) -> bool:
         """Re-run only the failed jobs in a workflow run"""
@@ -69,41 +86,70 @@ class WorkflowRecovery:
         url = f"{self.base_url}/actions/runs/{run_id}"
         
         try:
-            response = requests.get(url, headers=self.headers)
-            response.raise_for_status()
-            return response.json()
+            return self.client.get(url)
         except requests.RequestException as e:
             print(f"❌ Failed to get status for run {run_id}: {e}")
             return None
     
-    def wait_for_completion(self, run_id: int, timeout_minutes: int = 30) -> bool:
-        """Wait for a workflow run to complete"""
-        timeout_seconds = timeout_minutes * 60
-        start_time = time.time()
+    def wait_for_runs(self, run_ids: List[int], timeout_minutes: int = 30,
+                      poll_seconds: float = DEFAULT_POLL_SECONDS) -> Dict[int, Optional[str]]:
+        """
+        Wait for many workflow runs to complete. Returns each run's
+        conclusion, or None if it could not be read or timed out.
+        """
+        deadline = time.monotonic() + timeout_minutes * 60
+        pending = set(run_ids)
+        results: Dict[int, Optional[str]] = {}
+        
+        print(f"⏳ Waiting for {len(pending)} workflow run(s) (timeout: {timeout_minutes} minutes)...")
         
-        print(f"⏳ Waiting for workflow {run_id} to complete (timeout: {timeout_minutes} minutes)...")
+        def settle(run_id: int, status: Optional[Dict]):
+            if status is None:
+                results[run_id] = None
+                pending.discard(run_id)
+            elif status['status'] == 'completed':
+                results[run_id] = status.get('conclusion')
+                pending.discard(run_id)
+                mark = '✅' if results[run_id] == 'success' else '❌'
+                print(f"{mark} Workflow {run_id} completed with status: {results[run_id]}")
         
-        while time.time() - start_time < timeout_seconds:
-            status = self.get_workflow_status(run_id)
-            if not status:
-                return False
+        def last_received(run_id: int) -> Optional[float]:
+            return self.events.last_received(run_id) if self.events is not None else None
+        
+        started = next_poll = time.monotonic()
+        while pending and time.monotonic() < deadline:
+            # Only deliveries since the wait began: older ones may predate a re-run
+            for run_id in list(pending):
+                received = last_received(run_id)
+                if received is not None and received >= started:
+                    settle(run_id, self.events.get(run_id))
             
-            current_status = status['status']
-            conclusion = status.get('conclusion')
+            if pending and time.monotonic() >= next_poll:
+                # Runs the webhooks have not reported on lately, all at once
+                now = time.monotonic()
+                stale = sorted(run_id for run_id in pending
+                               if last_received(run_id) is None or now - last_received(run_id) >= poll_seconds)
+                for run_id, status in zip(stale, self.client.map(self.get_workflow_status, stale)):
+                    settle(run_id, status)
+                next_poll = time.monotonic() + poll_seconds
+                if pending:
+                    print(f"   {len(pending)} run(s) still in progress")
             
-            if current_status == 'completed':
-                if conclusion == 'success':
-                    print(f"✅ Workflow {run_id} completed successfully")
-                    return True
+            if pending:
+                wait = max(0.0, min(next_poll, deadline) - time.monotonic())
+                if self.events is not None:
+                    self.events.wait(wait)
                 else:
-                    print(f"❌ Workflow {run_id} completed with status: {conclusion}")
-                    return False
-            
-            print(f"   Status: {current_status}")
-            time.sleep(30)  # Check every 30 seconds
+                    time.sleep(wait)
         
-        print(f"⏰ Timeout reached for workflow {run_id}")
-        return False
+        for run_id in pending:
+            print(f"⏰ Timeout reached for workflow {run_id}")
+            results[run_id] = None
+        return results
+    
+    def wait_for_completion(self, run_id: int, timeout_minutes: int = 30) -> bool:
+        """Wait for a workflow run to complete"""
+        return self.wait_for_runs([run_id], timeout_minutes)[run_id] == 'success'
     
     def implement_retry_strategy(self, failed_jobs: List[Dict], max_retries: int = 3) -> Dict:
         """Implement intelligent retry strategy for failed jobs"""
@@ -126,6 +172,7 @@ class WorkflowRecovery:
                 }
             runs_to_retry[run_id]['failed_jobs'].append(job)
         
+        retried = []
         for run_id, run_info in runs_to_retry.items():
             print(f"\n🔄 Processing workflow run {run_id} ({run_info['workflow_name']})")
             print(f"   Failed jobs: {len(run_info['failed_jobs'])}")
@@ -152,13 +199,7 @@ class WorkflowRecovery:
                     'action': 'retried',
                     'status': 'success'
                 })
-                
-                # Wait for completion
-                if self.wait_for_completion(run_id):
-                    print(f"   ✅ Retry successful for run {run_id}")
-                else:
-                    print(f"   ❌ Retry failed for run {run_id}")
-                    results['failed_retries'] += 1
+                retried.append(run_id)
             else:
                 results['failed_retries'] += 1
                 results['details'].append({
@@ -167,6 +208,15 @@ class WorkflowRecovery:
                     'status': 'error'
                 })
         
+        # Wait for all re-runs together rather than one after another
+        if retried:
+            for run_id, conclusion in self.wait_for_runs(retried).items():
+                if conclusion == 'success':
+                    print(f"   ✅ Retry successful for run {run_id}")
+                else:
+                    print(f"   ❌ Retry failed for run {run_id}")
+                    results['failed_retries'] += 1
+        
         return results
     
     def _should_retry_run(self, failed_jobs: List[Dict]) -> bool:
@@ -206,7 +256,10 @@ def main():
     parser = argparse.ArgumentParser(description='Recover from failed GitHub Actions workflows')
     parser.add_argument('--owner', default='sparesparrow', help='Repository owner')
     parser.add_argument('--repo', default='openssl-tools', help='Repository name')
-    parser.add_argument('--run-id', type=int, help='Specific run ID to retry')
+    parser.add_argument('--run-id', type=int, nargs='+', help='Run IDs to retry (waited for together)')
+    parser.add_argument('--webhook-port', type=int,
+                        help='Receive workflow_run webhooks on this port instead of polling '
+                             '(secret from GITHUB_WEBHOOK_SECRET)')
     parser.add_argument('--auto-retry', action='store_true', help='Automatically retry failed jobs')
     parser.add_argument('--max-retries', type=int, default=3, help='Maximum number of retries')
     
@@ -218,14 +271,18 @@ def main():
         print("Please set your GitHub token: export GITHUB_TOKEN=your_token")
         sys.exit(1)
     
-    recovery = WorkflowRecovery(args.owner, args.repo)
+    events = None
+    if args.webhook_port:
+        events = WorkflowEventStore(os.getenv('GITHUB_WEBHOOK_SECRET'))
+        events.serve(port=args.webhook_port)
+    recovery = WorkflowRecovery(args.owner, args.repo, events=events)
     
     if args.run_id:
-        # Retry specific run
-        print(f"🔄 Retrying workflow run {args.run_id}")
-        success = recovery.rerun_failed_jobs(args.run_id)
-        if success:
-            recovery.wait_for_completion(args.run_id)
+        # Retry specific runs
+        print(f"🔄 Retrying workflow runs {', '.join(map(str, args.run_id))}")
+        retried = [run_id for run_id in args.run_id if recovery.rerun_failed_jobs(run_id)]
+        if retried:
+            recovery.wait_for_runs(retried)
     elif args.auto_retry:
         # Auto-retry failed jobs
         print("🤖 Auto-retry mode enabled")
@@ -6,6 +6,18 @@ import os
 import subprocess
 from pathlib import Path
 
+try:
+    from sparetools_tracing import child_env, span
+except ImportError:  # sparetools-base not on PYTHONPATH: tracing is off
+    import contextlib
+
+    def child_env(env=None):
+        return env
+
+    @contextlib.contextmanager
+    def span(name, **attributes):
+        yield type("Span", (), {"set_attribute": lambda self, key, value: None})()
+
 
 class BuildOrchestrator:
     """Orchestrates OpenSSL build processes"""
@@ -20,7 +32,9 @@ class BuildOrchestrator:
         if options:
             cmd.extend(options)
         
-        result = subprocess.run(cmd, cwd=self.build_dir)
+        with span("configure", command=" ".join(cmd)) as configure_span:
+            result = subprocess.run(cmd, cwd=self.build_dir, env=child_env())
+            configure_span.set_attribute("returncode", result.returncode)
         return result.returncode == 0
     
     def build(self, jobs=None):
@@ -29,7 +43,9 @@ class BuildOrchestrator:
         if jobs:
             cmd.extend(["-j", str(jobs)])
         
-        result = subprocess.run(cmd, cwd=self.build_dir)
+        with span("build", command=" ".join(cmd)) as build_span:
+            result = subprocess.run(cmd, cwd=self.build_dir, env=child_env())
+            build_span.set_attribute("returncode", result.returncode)
         return result.returncode == 0
 
 
@@ -11,6 +11,14 @@ from pathlib import Path
 from openssl_tools.openssl.build_matrix import SmartBuildMatrix
 
 
+def _positive_int(value: str) -> int:
+    """argparse type for counts that must be at least 1 (--trials)"""
+    number = int(value)
+    if number < 1:
+        raise argparse.ArgumentTypeError(f"must be at least 1, not {number}")
+    return number
+
+
 def create_parser() -> argparse.ArgumentParser:
     """Create and return the argument parser."""
     parser = argparse.ArgumentParser(
@@ -26,6 +34,58 @@ Examples:
 
   # Use a custom config file
   %(prog)s matrix generate --config my-config.json --output matrix.json
+
+  # Four test jobs per build on its deferred test bundle, balanced on earlier runs
+  %(prog)s matrix generate --github-actions --test-shards 4 --test-history test_results/
+
+  # Build the matrix on the builder nodes listed in nodes.yaml
+  %(prog)s matrix dispatch --nodes nodes.yaml --optimization medium --follow
+
+  # Cross-node handshake rate and latency for two server variants
+  %(prog)s loadgen --nodes loadgen-nodes.yaml --variant vanilla=/opt/v/bench_loadgen --variant python=/opt/p/bench_loadgen
+
+  # Compare prebuilt installs across variants, releases and SIMD profiles
+  %(prog)s benchmark-matrix --install-root _Build/openssl-builds --quick
+
+  # Build with each base compiler profile and pick the fastest binary per algorithm class
+  %(prog)s compiler-shootout --version 3.6.0 --publish sparesparrow-conan
+
+  # Compile flags, asm modules and bench_evp of the python build against vanilla
+  %(prog)s build-parity --version 3.6.0 --quick
+
+  # Cost of each hardening flag (and of all of them) against the performance profile
+  %(prog)s hardening-cost --base linux-clang18 --version 3.6.0
+
+  # Tune SSL_CTX settings for this host against the package's bench_sslctx
+  %(prog)s sslctx-tune build/test_package/bench_sslctx --output openssl-tuned.cnf
+
+  # Build the vanilla and python variants concurrently from one shared source per version
+  %(prog)s build-variants --versions 3.6.0,master --prune-legacy
+
+  # Pre-download the sparetools-* revisions pinned by consumer lockfiles
+  %(prog)s cache warm --lockfile consumers/ --remote sparesparrow-conan --package-query "os=Linux"
+
+  # Append a benchmark run to the performance history, then bisect a drop
+  %(prog)s perf record build/bench_evp --profile assembly-optimized
+  %(prog)s perf bisect --good openssl-3.5.0 --bad master --metric AES-128-GCM/16384/mb_per_s
+
+  # Record the package's libcrypto/libssl sizes and flag growth over the previous revision
+  %(prog)s perf size ~/.conan2/p/b/sparetools-openssl*/p --package-revision $PREV --profile linux-gcc11
+
+  # Chart the history and check whether 3.6.0 performs at least as well as 3.3.2
+  %(prog)s perf dashboard --compare 3.3.2 3.6.0
+
+  # Install the sparetools-openssl binary matching this host's CPU as ./openssl
+  %(prog)s host-variant sparetools-openssl/3.6.0 --dest openssl --remote sparesparrow-conan
+
+  # Run the tests a cross-compiled arm64 build deferred, on an arm64 runner
+  %(prog)s deferred-tests deferred-tests/<package id>-fast.tar.gz --results-dir test_results
+
+  # Validate the configuration files and rebuild the cached snapshot
+  %(prog)s config snapshot conan-dev/cache-optimization.yml
+
+  # Run only the benchmarks whose covered OpenSSL sources a PR changed
+  %(prog)s perf select --source openssl --base origin/master --run build/test_package
         """
     )
 
@@ -61,16 +121,803 @@ Examples:
         action="store_true",
         help="Output in GitHub Actions matrix format"
     )
+    generate_parser.add_argument("--test-shards", type=int, default=1,
+                                 help="With --github-actions: split each build's test suite into this many "
+                                      "jobs on its deferred test bundle")
+    generate_parser.add_argument("--test-history", type=Path, action="append", default=[], metavar="PATH",
+                                 help="JUnit reports or make-test.log files of earlier runs (repeatable), "
+                                      "for balancing the test shards")
+    add_history_arguments(generate_parser)
+
+    # Dispatch subcommand
+    dispatch_parser = matrix_subparsers.add_parser(
+        "dispatch",
+        help="Build the generated matrix on remote builder nodes over SSH"
+    )
+    dispatch_parser.add_argument("--nodes", type=Path, required=True,
+                                 help="Builder node list (YAML or JSON)")
+    dispatch_parser.add_argument("--optimization", choices=["high", "medium", "low"], default="high",
+                                 help="Optimization level (default: high)")
+    dispatch_parser.add_argument("--config", type=str, help="Path to configuration file (optional)")
+    dispatch_parser.add_argument("--recipe", type=Path, default=Path("packages/sparetools-openssl"),
+                                 help="Recipe directory copied to each node")
+    dispatch_parser.add_argument("--log-dir", type=Path, default=Path("build-logs/remote"),
+                                 help="build-summary-*.json output directory")
+    dispatch_parser.add_argument("--retries", type=int, default=1, help="Retries per failed build")
+    dispatch_parser.add_argument("--timeout", type=float, help="Per-step timeout in seconds")
+    dispatch_parser.add_argument("--no-restore", action="store_true",
+                                 help="Leave packages on the nodes instead of restoring them locally")
+    dispatch_parser.add_argument("--follow", action="store_true",
+                                 help="Stream status with scripts/aggregate-build-logs.py --follow")
+    add_history_arguments(dispatch_parser)
+
+    # Multi-node load test command
+    loadgen_parser = subparsers.add_parser(
+        "loadgen",
+        help="Run bench_loadgen across a server node and client nodes and aggregate the results"
+    )
+    loadgen_parser.add_argument("--nodes", type=Path, required=True,
+                                help="Server and client nodes (YAML or JSON)")
+    loadgen_parser.add_argument("--variant", action="append", default=[], metavar="NAME=PATH",
+                                help="Server bench_loadgen binary per package variant (repeatable)")
+    loadgen_parser.add_argument("--duration", type=float, default=30.0, help="Seconds per variant")
+    loadgen_parser.add_argument("--requests", type=int, default=1,
+                                help="Requests per connection before reconnecting (0: keep-alive)")
+    loadgen_parser.add_argument("--size", type=int, default=1024, help="Response size in bytes")
+    loadgen_parser.add_argument("--key", default="EC", help="Server key type (EC, RSA, ML-DSA-65, ...)")
+    loadgen_parser.add_argument("--port", type=int, default=8443, help="Server port")
+    loadgen_parser.add_argument("--output", type=Path, default=Path("test_results/loadgen-summary.json"),
+                                help="Aggregated summary (JSON)")
+
+    # Benchmark matrix command
+    bench_parser = subparsers.add_parser(
+        "benchmark-matrix",
+        help="Benchmark variant x release x SIMD profile combinations"
+    )
+    bench_parser.add_argument("--axes", type=Path, help="axes.yaml (default: bundled profiles/axes.yaml)")
+    bench_parser.add_argument("--variants", help="Comma-separated variant labels (default: all axes)")
+    bench_parser.add_argument("--releases", help="Comma-separated OpenSSL releases (default: all axes)")
+    bench_parser.add_argument(
+        "--simd",
+        default="assembly-optimized,assembly-avx2-only,assembly-avx-only,assembly-minimal",
+        help="Comma-separated SIMD feature profiles"
+    )
+    bench_parser.add_argument("--install-root", type=Path, default=Path("_Build/openssl-builds"),
+                              help="Prebuilt installs as <release>/<variant>/install")
+    bench_parser.add_argument("--build", action="store_true",
+                              help="conan create cells without a prebuilt install")
+    bench_parser.add_argument("--recipe", type=Path, default=Path("packages/sparetools-openssl"),
+                              help="sparetools-openssl recipe directory (benchmark sources)")
+    bench_parser.add_argument("--host-profile", default="default", help="Conan host profile for --build")
+    bench_parser.add_argument("--reference", help="Cell id used as 1.00x (default: first measured)")
+    bench_parser.add_argument("--benches", default="bench_evp,bench_handshake",
+                              help="Comma-separated test_package bench targets")
+    bench_parser.add_argument("--trials", type=_positive_int, default=5, help="Trials per benchmark and cell")
+    bench_parser.add_argument("--warmup", type=int, default=1, help="Warm-up runs per benchmark and cell")
+    bench_parser.add_argument("--cpus", help="Pin benchmarks to CPUs, e.g. 2,3 or 0-3")
+    bench_parser.add_argument("--quick", action="store_true", help="Short benchmark runs")
+    bench_parser.add_argument("--output-dir", type=Path, default=Path("test_results/benchmark-matrix"),
+                              help="Work and report directory")
+
+    # Compiler shoot-out command
+    shootout_parser = subparsers.add_parser(
+        "compiler-shootout",
+        help="Benchmark one build per compiler profile and recommend the fastest"
+    )
+    shootout_parser.add_argument("--contenders", default="linux-gcc11,linux-clang14,linux-clang18",
+                                 help="Comma-separated base profiles, each optionally +feature[+feature]")
+    shootout_parser.add_argument("--version", default="3.6.0", help="sparetools-openssl version to create")
+    shootout_parser.add_argument("--prefix", action="append", default=[], metavar="CONTENDER=PATH",
+                                 help="Use a prebuilt install for a contender instead of conan create")
+    shootout_parser.add_argument("--recipe", type=Path, default=Path("packages/sparetools-openssl"),
+                                 help="sparetools-openssl recipe directory (benchmark sources)")
+    shootout_parser.add_argument("--profiles-dir", type=Path,
+                                 help="Directory with base/ and features/ (default: bundled profiles)")
+    shootout_parser.add_argument("--build-profile", default="default", help="Conan build profile")
+    shootout_parser.add_argument("--benches", default="bench_evp,bench_handshake,bench_bn",
+                                 help="Comma-separated test_package bench targets")
+    shootout_parser.add_argument("--trials", type=_positive_int, default=5, help="Trials per benchmark and contender")
+    shootout_parser.add_argument("--warmup", type=int, default=1, help="Warm-up runs per benchmark and contender")
+    shootout_parser.add_argument("--cpus", help="Pin benchmarks to CPUs, e.g. 2,3 or 0-3")
+    shootout_parser.add_argument("--quick", action="store_true", help="Short benchmark runs")
+    shootout_parser.add_argument("--publish", metavar="REMOTE",
+                                 help="Upload the recommended package revision to this Conan remote")
+    shootout_parser.add_argument("--output-dir", type=Path, default=Path("test_results/compiler-shootout"),
+                                 help="Work and report directory")
+
+    # Shared-source variant builds
+    hardening_parser = subparsers.add_parser(
+        "hardening-cost",
+        help="Throughput and handshake cost of each hardening flag against the performance profile"
+    )
+    hardening_parser.add_argument("--base", default="linux-gcc11", help="Base profile for every build")
+    hardening_parser.add_argument("--flags", help="Comma-separated hardening flags (default: all)")
+    hardening_parser.add_argument("--version", default="3.6.0", help="sparetools-openssl version to create")
+    hardening_parser.add_argument("--prefix", action="append", default=[], metavar="BUILD=PATH",
+                                  help="Use a prebuilt install for a build (performance, a flag or hardened)")
+    hardening_parser.add_argument("--recipe", type=Path, default=Path("packages/sparetools-openssl"),
+                                  help="sparetools-openssl recipe directory (benchmark sources)")
+    hardening_parser.add_argument("--profiles-dir", type=Path,
+                                  help="Directory with base/ and features/ (default: bundled profiles)")
+    hardening_parser.add_argument("--build-profile", default="default", help="Conan build profile")
+    hardening_parser.add_argument("--trials", type=_positive_int, default=5, help="Trials per benchmark and build")
+    hardening_parser.add_argument("--warmup", type=int, default=1, help="Warm-up runs per benchmark and build")
+    hardening_parser.add_argument("--cpus", help="Pin benchmarks to CPUs, e.g. 2,3 or 0-3")
+    hardening_parser.add_argument("--quick", action="store_true", help="Short benchmark runs")
+    hardening_parser.add_argument("--output-dir", type=Path, default=Path("test_results/hardening-cost"),
+                                  help="Work and report directory")
+
+    # Vanilla vs python build parity command
+    parity_parser = subparsers.add_parser(
+        "build-parity",
+        help="Compare compile flags, asm modules and bench_evp of the python build against vanilla"
+    )
+    parity_parser.add_argument("--version", required=True, help="Version directory under --build-root")
+    parity_parser.add_argument("--build-root", type=Path, default=Path("_Build/openssl-builds"),
+                               help="Root of <version>/<variant>/build and install")
+    parity_parser.add_argument("--recipe", type=Path, default=Path("packages/sparetools-openssl"),
+                               help="sparetools-openssl recipe directory (benchmark sources)")
+    parity_parser.add_argument("--no-bench", action="store_true", help="Compare flags and asm only")
+    parity_parser.add_argument("--min-effect", type=float, default=3.0,
+                               help="Slowdown in percent that counts as a regression (default: 3)")
+    parity_parser.add_argument("--trials", type=_positive_int, default=5, help="Trials per variant")
+    parity_parser.add_argument("--warmup", type=int, default=1, help="Warm-up runs per variant")
+    parity_parser.add_argument("--cpus", help="Pin benchmarks to CPUs, e.g. 2,3 or 0-3")
+    parity_parser.add_argument("--quick", action="store_true", help="Short benchmark runs")
+    parity_parser.add_argument("--output-dir", type=Path, default=Path("test_results/build-parity"),
+                               help="Work and report directory")
+
+    # SSL_CTX autotuner command
+    tune_parser = subparsers.add_parser(
+        "sslctx-tune", help="Search the SSL_CTX settings that perform best on this host and build")
+    tune_parser.add_argument("probe", type=Path, help="test_package bench_sslctx binary")
+    tune_parser.add_argument("--config", help="CryptoConfigManager configuration to start from")
+    tune_parser.add_argument("--output", type=Path, default=Path("test_results/openssl-tuned.cnf"),
+                             help="Tuned openssl.cnf to write")
+    tune_parser.add_argument("--save-config", help="Also save the tuned CryptoConfigManager configuration here")
+    tune_parser.add_argument("--parameters", help="Comma-separated parameters to search (default: all)")
+    tune_parser.add_argument("--clients", type=int, default=256, help="Resuming client population")
+    tune_parser.add_argument("--handshake-weight", type=float, default=0.5,
+                             help="Share of the score from connections/s, the rest from bulk MB/s")
+    tune_parser.add_argument("--trials", type=_positive_int, default=5, help="Trials per candidate")
+    tune_parser.add_argument("--warmup", type=int, default=1, help="Warm-up runs per candidate")
+    tune_parser.add_argument("--cpus", help="Pin the probe to CPUs, e.g. 2,3 or 0-3")
+    tune_parser.add_argument("--quick", action="store_true", help="Short probe runs")
+    tune_parser.add_argument("--output-dir", type=Path, default=Path("test_results/sslctx-tune"),
+                             help="Trial results and report directory")
+
+    variants_parser = subparsers.add_parser(
+        "build-variants",
+        help="Build _Build/openssl-builds variants out of tree from one shared source per version"
+    )
+    variants_parser.add_argument("--root", type=Path, default=Path("_Build/openssl-builds"),
+                                 help="Build root holding <version>/src and <version>/<variant>/install")
+    variants_parser.add_argument("--versions", default="3.6.0,master", help="Comma-separated versions or master")
+    variants_parser.add_argument("--variants", default="vanilla,python", help="Comma-separated variants")
+    variants_parser.add_argument("--url", default="https://github.com/openssl/openssl.git",
+                                 help="Upstream repository for the shared bare clone")
+    variants_parser.add_argument("--configure-py", type=Path,
+                                 help="configure.py for the python variant (default: sparetools-openssl-hybrid)")
+    variants_parser.add_argument("--configure-arg", action="append", default=[],
+                                 help="Extra argument for Configure/configure.py (repeatable)")
+    variants_parser.add_argument("--jobs", type=int, help="Total make jobs, split across the builds")
+    variants_parser.add_argument("--update", action="store_true",
+                                 help="Fetch upstream and move existing worktrees to their ref")
+    variants_parser.add_argument("--prune-legacy", action="store_true",
+                                 help="Delete per-variant <version>/<variant>/src copies afterwards")
+
+    # Conan cache command
+    cache_parser = subparsers.add_parser("cache", help="Conan cache maintenance")
+    cache_subparsers = cache_parser.add_subparsers(dest="cache_command", help="Cache operations")
+    warm_parser = cache_subparsers.add_parser(
+        "warm", help="Pre-download the sparetools-* revisions pinned by lockfiles")
+    warm_parser.add_argument("--lockfile", type=Path, action="append", required=True,
+                             help="Lockfile, or directory searched for *.lock (repeatable)")
+    warm_parser.add_argument("--remote", required=True, help="Conan remote to download from")
+    warm_parser.add_argument("--cache", type=Path, action="append", default=[],
+                             help="Conan home to warm (repeatable; first one downloads, default: CONAN_HOME)")
+    warm_parser.add_argument("--pattern", default="sparetools-*", help="Package names to warm")
+    warm_parser.add_argument("--package-query", help='Binaries to fetch, e.g. "os=Linux AND arch=x86_64"')
+    warm_parser.add_argument("--parallel", type=int, default=8, help="Parallel transfers")
+    warm_parser.add_argument("--watch", type=float, metavar="SECONDS",
+                             help="Keep running and re-warm when a lockfile changes")
+    warm_parser.add_argument("--zero-copy", action="store_true",
+                             help="Refresh _Build zero-copy links against the first cache afterwards")
+
+    # Host-CPU variant command
+    host_parser = subparsers.add_parser(
+        "host-variant", help="Install the package variant matching this host's CPU features")
+    host_parser.add_argument("reference", nargs="?", help="Package to install, e.g. sparetools-openssl/3.6.0")
+    host_parser.add_argument("--dest", type=Path, default=Path("openssl"),
+                             help="Where to place the package (default: ./openssl)")
+    host_parser.add_argument("--profile", default="default", help="Base host profile for the feature profile")
+    host_parser.add_argument("--remote", help="Conan remote to fetch binaries from")
+    host_parser.add_argument("--link-mode", choices=["symlink", "hardlink", "reflink", "copy"], default="symlink",
+                             help="How dest refers to the package folder (default: symlink)")
+    host_parser.add_argument("--build-missing", action="store_true",
+                             help="Build the best variant if it has no binary instead of falling back")
+    host_parser.add_argument("--detect", action="store_true",
+                             help="Only print the detected features and the ranked profiles")
+
+    # Deferred cross-build tests command
+    deferred_parser = subparsers.add_parser(
+        "deferred-tests", help="Run a cross build's bundled OpenSSL tests on a native runner")
+    deferred_parser.add_argument("bundle", type=Path, help="<package id>-<tier>.tar.gz written by the recipe")
+    deferred_parser.add_argument("--results-dir", type=Path, default=Path("test_results"),
+                                 help="JUnit report and log directory (default: test_results)")
+    deferred_parser.add_argument("--work-dir", type=Path, help="Extract here and keep it (default: temporary)")
+    deferred_parser.add_argument("--jobs", type=int, help="HARNESS_JOBS (default: CPU count)")
+    deferred_parser.add_argument("--tests", nargs="+",
+                                 help="Test recipes to run instead of the bundle's selection; a matrix "
+                                      "shard's tests_arg as --tests=\"$TESTS\"")
+    deferred_parser.add_argument("--any-arch", action="store_true",
+                                 help="Run even if this host's arch differs (binfmt/QEMU)")
+
+    # Configuration snapshot command
+    config_parser = subparsers.add_parser("config", help="Configuration snapshot")
+    config_subparsers = config_parser.add_subparsers(dest="config_command", help="Configuration operations")
+    snapshot_parser = config_subparsers.add_parser(
+        "snapshot", help="Validate the bundled configuration and rebuild the cached snapshot")
+    snapshot_parser.add_argument("files", nargs="*", type=Path,
+                                 help="Other YAML/JSON configuration files to validate and cache")
+
+    # Performance history command
+    perf_parser = subparsers.add_parser("perf", help="Performance history and regression bisection")
+    perf_parser.add_argument("--store", type=Path, default=Path("test_results/perf_history.sqlite"),
+                             help="Append-only results store (SQLite)")
+    perf_subparsers = perf_parser.add_subparsers(dest="perf_command", help="Performance operations")
+
+    record_parser = perf_subparsers.add_parser("record", help="Run a bench binary and append its samples")
+    record_parser.add_argument("bench_binary", type=Path, help="test_package bench_* binary")
+    record_parser.add_argument("--git-commit", help="Commit the package was built from (default: HEAD)")
+    record_parser.add_argument("--package-revision", default="local", help="Conan package revision")
+    record_parser.add_argument("--profile", default="default", help="Build profile name")
+
+    size_parser = perf_subparsers.add_parser(
+        "size", help="Record libcrypto/libssl section, symbol and compile-unit sizes of a package")
+    size_parser.add_argument("package_folder", type=Path, help="Package folder (lib/, include/)")
+    size_parser.add_argument("--git-commit", help="Commit the package was built from (default: HEAD)")
+    size_parser.add_argument("--package-revision", default="local", help="Conan package revision")
+    size_parser.add_argument("--profile", default="default", help="Build profile name")
+    size_parser.add_argument("--against", help="Compare with this package revision (default: the previous one)")
+    size_parser.add_argument("--threshold", type=float, default=2.0,
+                             help="Growth in percent that flags a total or section (default: 2)")
+    size_parser.add_argument("--min-bytes", type=int, default=4096,
+                             help="Growth in bytes that flags a symbol or compile unit (default: 4096)")
+    size_parser.add_argument("--json", type=Path, help="Also write the comparison as JSON")
+
+    history_parser = perf_subparsers.add_parser("history", help="Median of a metric across stored runs")
+    history_parser.add_argument("metric", help="Metric id, e.g. AES-128-GCM/16384/mb_per_s")
+    history_parser.add_argument("--benchmark", help="Benchmark type (evp, handshake, ...)")
+    history_parser.add_argument("--profile", help="Only runs of this profile")
+    history_parser.add_argument("--limit", type=int, default=50, help="Most recent runs to show")
+
+    dashboard_parser = perf_subparsers.add_parser(
+        "dashboard", help="Static HTML trend dashboard with regression annotations")
+    dashboard_parser.add_argument("--output", type=Path, default=Path("test_results/perf-dashboard.html"),
+                                  help="HTML file to write")
+    dashboard_parser.add_argument("--compare", nargs=2, metavar=("BASELINE", "CANDIDATE"),
+                                  help="OpenSSL versions to compare for release readiness, e.g. 3.3.2 3.6.0")
+    dashboard_parser.add_argument("--profiles", help="Only these profiles (comma-separated)")
+    dashboard_parser.add_argument("--commit-url", default="https://github.com/openssl/openssl/commit/{commit}",
+                                  help="Link for annotated commits ({commit} is replaced; empty for none)")
+
+    bisect_parser = perf_subparsers.add_parser("bisect", help="Find the upstream commit causing a drop")
+    bisect_parser.add_argument("--good", required=True, help="Known-good OpenSSL commit or tag")
+    bisect_parser.add_argument("--bad", required=True, help="Known-bad OpenSSL commit or tag")
+    bisect_parser.add_argument("--metric", required=True, help="Metric id that regressed")
+    bisect_parser.add_argument("--bench", default="bench_evp", help="Benchmark target measuring it")
+    bisect_parser.add_argument("--source", type=Path, default=Path("_Build/openssl-builds/master/src"),
+                               help="OpenSSL git checkout (left untouched, a worktree is used)")
+    bisect_parser.add_argument("--recipe", type=Path, default=Path("packages/sparetools-openssl"),
+                               help="sparetools-openssl recipe directory (benchmark sources)")
+    bisect_parser.add_argument("--work-dir", type=Path, default=Path("test_results/perf-bisect"),
+                               help="Builds, installs and trial output")
+    bisect_parser.add_argument("--keep-worktree", action="store_true", help="Keep the bisect worktree")
+
+    map_parser = perf_subparsers.add_parser(
+        "coverage-map", help="Record which OpenSSL sources each benchmark case executes")
+    map_parser.add_argument("--openssl-build", type=Path, required=True,
+                            help="OpenSSL build tree configured with --coverage (.gcno/.gcda files)")
+    map_parser.add_argument("--bench-build", type=Path, required=True,
+                            help="test_package build directory with bench_* linked against it")
+    map_parser.add_argument("--source", type=Path, help="OpenSSL source root (default: --openssl-build)")
+    map_parser.add_argument("--work-dir", type=Path, default=Path("test_results/benchmark-coverage"),
+                            help="Per-case lcov tracefiles")
+
+    select_parser = perf_subparsers.add_parser(
+        "select", help="Benchmark cases covering the files a change touches")
+    select_parser.add_argument("--source", type=Path, default=Path("."), help="OpenSSL git checkout")
+    select_parser.add_argument("--base", help="Base ref of the change (git diff base...head)")
+    select_parser.add_argument("--head", default="HEAD", help="Head ref of the change")
+    select_parser.add_argument("--changed", nargs="+", help="Changed files instead of --base/--head")
+    select_parser.add_argument("--json", action="store_true", help="Print the selection as JSON")
+    select_parser.add_argument("--run", type=Path, metavar="BENCH_BUILD",
+                               help="Run the selected cases from this test_package build and record them")
+    select_parser.add_argument("--git-commit", help="Commit recorded with --run (default: HEAD of --source)")
+    select_parser.add_argument("--package-revision", default="local", help="Conan package revision")
+    select_parser.add_argument("--profile", default="default", help="Build profile name")
+
+    for sub in (map_parser, select_parser):
+        sub.add_argument("--map", type=Path, default=Path("test_results/benchmark-coverage.json"),
+                         help="Benchmark coverage map (JSON)")
+
+    for sub in (record_parser, bisect_parser, select_parser):
+        sub.add_argument("--trials", type=_positive_int, default=5, help="Trials per measurement")
+        sub.add_argument("--warmup", type=int, default=1, help="Warm-up runs per measurement")
+        sub.add_argument("--cpus", help="Pin benchmarks to CPUs, e.g. 2,3 or 0-3")
+        sub.add_argument("--quick", action="store_true", help="Short benchmark runs")
 
     return parser
 
 
+def perf_command(args) -> int:
+    """Run a perf record/history/bisect operation."""
+    from openssl_tools.development.build_system.perf_history import (
+        PerfBisector, PerfHistoryStore, current_git_commit)
+    from openssl_tools.development.build_system.statistical_runner import (
+        StatisticalBenchmarkRunner, _parse_cpus)
+
+    if args.perf_command in ("coverage-map", "select"):
+        return bench_selection_command(args)
+
+    store = PerfHistoryStore(args.store)
+    try:
+        if args.perf_command == "record":
+            runner = StatisticalBenchmarkRunner(args.store.parent / "trials", trials=args.trials,
+                                                warmup=args.warmup,
+                                                cpus=_parse_cpus(args.cpus) if args.cpus else None)
+            trials = runner.run(args.bench_binary, ["--quick"] if args.quick else [])
+            run_id = store.record(trials, git_commit=args.git_commit or current_git_commit(),
+                                  package_revision=args.package_revision, profile=args.profile,
+                                  platform=runner.platform, cpu_model=runner.cpu_model)
+            print(f"✓ Recorded run {run_id}: {trials.benchmark}, {len(trials.samples)} metrics "
+                  f"x {args.trials} trials ({args.store})", file=sys.stderr)
+            return 0
+
+        if args.perf_command == "size":
+            import platform
+            from openssl_tools.development.build_system.binary_size import BinarySizeTracker, format_size_report
+            tracker = BinarySizeTracker(store, threshold_percent=args.threshold, min_bytes=args.min_bytes)
+            report = tracker.record(args.package_folder, args.package_revision, args.profile,
+                                    f"{platform.system().lower()}-{platform.machine().lower()}",
+                                    args.git_commit or current_git_commit(), against=args.against)
+            print(format_size_report(report))
+            if args.json:
+                args.json.write_text(json.dumps(report.to_dict(), indent=2), encoding="utf-8")
+            print(f"✓ Recorded size run {report.run_id} ({args.store})", file=sys.stderr)
+            return 1 if report.flagged else 0
+
+        if args.perf_command == "history":
+            for entry in store.history(args.metric, args.benchmark, args.profile, args.limit):
+                print(f"{entry['timestamp'][:19]}  {entry['git_commit'][:12]}  {entry['profile']:<20} "
+                      f"{entry['package_revision'][:12]:<12}  {entry['median']:12.3f}")
+            return 0
+
+        if args.perf_command == "dashboard":
+            from openssl_tools.development.build_system.perf_dashboard import PerfDashboard
+            dashboard = PerfDashboard(store, commit_url=args.commit_url or None,
+                                      profiles=args.profiles.split(",") if args.profiles else None)
+            data = dashboard.render(args.output, tuple(args.compare) if args.compare else None)
+            print(f"✓ Dashboard written to {args.output}", file=sys.stderr)
+            if args.compare:
+                summary = data["summary"]
+                print(f"{args.compare[1]} against {args.compare[0]}: {summary['regression']} regression(s), "
+                      f"{summary['improvement']} improvement(s), {summary['no-change']} unchanged")
+                for row in data["readiness"]:
+                    if row["verdict"] == "regression":
+                        print(f"  {row['benchmark']:<10} {row['metric']:<40} {row['profile']:<20} "
+                              f"{row['change_percent']:+.2f}%")
+            return 0
+
+        if args.perf_command == "bisect":
+            bisector = PerfBisector(args.source, args.work_dir, args.recipe / "test_package", args.bench,
+                                    args.metric, store=store, trials=args.trials, warmup=args.warmup,
+                                    cpus=_parse_cpus(args.cpus) if args.cpus else None, quick=args.quick)
+            try:
+                first_bad = bisector.bisect(args.good, args.bad)
+            finally:
+                if not args.keep_worktree:
+                    bisector.cleanup()
+            for step in bisector.steps:
+                change = f"{step.change_percent:+.2f}%" if step.change_percent is not None else "-"
+                print(f"{step.verdict:<5} {step.commit[:12]}  {change}")
+            if first_bad is None:
+                print("✓ No significant regression between good and bad", file=sys.stderr)
+                return 0
+            print(f"✗ First bad commit: {first_bad}", file=sys.stderr)
+            return 1
+
+    except Exception as e:
+        print(f"✗ Error in perf {args.perf_command}: {e}", file=sys.stderr)
+        return 1
+    finally:
+        store.close()
+
+    return 1
+
+
+def bench_selection_command(args) -> int:
+    """Build the benchmark coverage map, or select (and run) cases for a change."""
+    from openssl_tools.development.build_system.bench_selection import (
+        BenchmarkCoverageMap, changed_files)
+    from openssl_tools.development.build_system.benchmark_matrix import find_bench_binary
+    from openssl_tools.development.build_system.perf_history import PerfHistoryStore, current_git_commit
+    from openssl_tools.development.build_system.statistical_runner import (
+        StatisticalBenchmarkRunner, _parse_cpus)
+
+    try:
+        if args.perf_command == "coverage-map":
+            coverage = BenchmarkCoverageMap.capture(args.openssl_build, args.bench_build, args.work_dir,
+                                                    source_dir=args.source)
+            coverage.save(args.map)
+            print(f"✓ Coverage map for {len(coverage.cases)} cases written: {args.map}", file=sys.stderr)
+            return 0 if coverage.cases else 1
+
+        coverage = BenchmarkCoverageMap.load(args.map)
+        if args.changed:
+            changed = args.changed
+        elif args.base:
+            changed = changed_files(args.source, args.base, args.head)
+        else:
+            print("✗ Either --changed or --base is required", file=sys.stderr)
+            return 1
+        selection = coverage.select(changed)
+
+        if args.json:
+            print(json.dumps(selection.to_dict(), indent=2))
+        else:
+            for case in selection.cases:
+                print(case)
+        scope = "all cases (global change)" if selection.run_all else \
+            f"{len(selection.cases)}/{len(coverage.cases)} cases"
+        print(f"✓ {len(changed)} changed files select {scope}", file=sys.stderr)
+
+        if args.run and selection.cases:
+            store = PerfHistoryStore(args.store)
+            try:
+                runner = StatisticalBenchmarkRunner(args.store.parent / "trials", trials=args.trials,
+                                                    warmup=args.warmup,
+                                                    cpus=_parse_cpus(args.cpus) if args.cpus else None)
+                for case in selection.cases:
+                    argv = coverage.cases[case]["argv"]
+                    binary = find_bench_binary(args.run, argv[0])
+                    if binary is None:
+                        print(f"✗ {case}: {argv[0]} not found in {args.run}", file=sys.stderr)
+                        return 1
+                    trials = runner.run(binary, (["--quick"] if args.quick else []) + argv[1:])
+                    run_id = store.record(trials, git_commit=args.git_commit or current_git_commit(args.source),
+                                          package_revision=args.package_revision, profile=args.profile,
+                                          platform=runner.platform, cpu_model=runner.cpu_model)
+                    print(f"✓ Recorded run {run_id}: {case}", file=sys.stderr)
+            finally:
+                store.close()
+        return 0
+
+    except Exception as e:
+        print(f"✗ Error in perf {args.perf_command}: {e}", file=sys.stderr)
+        return 1
+
+
+def benchmark_matrix(args) -> int:
+    """Run the benchmark comparison matrix."""
+    from openssl_tools.development.build_system.benchmark_matrix import (
+        BenchmarkMatrix, DEFAULT_AXES_FILE, discover_installs, load_axes)
+    from openssl_tools.development.build_system.statistical_runner import _parse_cpus
+
+    try:
+        variants, releases = load_axes(args.axes or DEFAULT_AXES_FILE)
+        if args.variants:
+            variants = args.variants.split(",")
+        if args.releases:
+            releases = args.releases.split(",")
+
+        matrix = BenchmarkMatrix(args.output_dir, args.recipe, benches=args.benches.split(","),
+                                 trials=args.trials, warmup=args.warmup,
+                                 cpus=_parse_cpus(args.cpus) if args.cpus else None,
+                                 quick=args.quick, build=args.build, host_profile=args.host_profile)
+        cells = matrix.plan(variants, releases, args.simd.split(","), discover_installs(args.install_root))
+        comparison = matrix.compare(matrix.run(cells), args.reference)
+        json_path, md_path = matrix.write_reports(comparison)
+
+        print(md_path.read_text())
+        print(f"✓ Benchmark matrix written: {md_path}, {json_path}", file=sys.stderr)
+        return 0 if comparison["reference"] else 1
+
+    except Exception as e:
+        print(f"✗ Error running benchmark matrix: {e}", file=sys.stderr)
+        return 1
+
+
+def compiler_shootout(args) -> int:
+    """Run the compiler shoot-out and optionally publish the winner."""
+    from openssl_tools.development.build_system.compiler_shootout import (
+        CompilerShootout, DEFAULT_PROFILES_DIR)
+    from openssl_tools.development.build_system.statistical_runner import _parse_cpus
+
+    try:
+        prefixes = {}
+        for entry in args.prefix:
+            name, sep, path = entry.partition("=")
+            if not sep:
+                print(f"✗ --prefix expects CONTENDER=PATH, got {entry}", file=sys.stderr)
+                return 1
+            prefixes[name] = Path(path)
+
+        shootout = CompilerShootout(args.output_dir, args.recipe, args.version,
+                                    profiles_dir=args.profiles_dir or DEFAULT_PROFILES_DIR,
+                                    benches=args.benches.split(","), trials=args.trials,
+                                    warmup=args.warmup, cpus=_parse_cpus(args.cpus) if args.cpus else None,
+                                    quick=args.quick, build_profile=args.build_profile)
+        contenders = shootout.plan(args.contenders.split(","), prefixes)
+        comparison = shootout.compare(shootout.run(contenders))
+        json_path, md_path = shootout.write_reports(comparison)
+
+        print(md_path.read_text())
+        print(f"✓ Compiler shoot-out written: {md_path}, {json_path}", file=sys.stderr)
+        if not comparison["recommended"]:
+            return 1
+        if args.publish:
+            package_ref = shootout.publish(comparison, args.publish)
+            if package_ref is None:
+                print("✗ Recommended contender has no package revision to publish", file=sys.stderr)
+                return 1
+            print(f"✓ Published {package_ref} to {args.publish}", file=sys.stderr)
+        return 0
+
+    except Exception as e:
+        print(f"✗ Error running compiler shoot-out: {e}", file=sys.stderr)
+        return 1
+
+
+def hardening_cost(args) -> int:
+    """Benchmark each hardening flag and the hardened profile against the performance profile."""
+    from openssl_tools.development.build_system.compiler_shootout import DEFAULT_PROFILES_DIR
+    from openssl_tools.development.build_system.hardening_cost import HardeningCost
+    from openssl_tools.development.build_system.statistical_runner import _parse_cpus
+
+    try:
+        prefixes = {}
+        for entry in args.prefix:
+            name, sep, path = entry.partition("=")
+            if not sep:
+                print(f"✗ --prefix expects BUILD=PATH, got {entry}", file=sys.stderr)
+                return 1
+            prefixes[name] = Path(path)
+
+        cost = HardeningCost(args.output_dir, args.recipe, args.version,
+                             profiles_dir=args.profiles_dir or DEFAULT_PROFILES_DIR,
+                             benches=["bench_evp", "bench_handshake"], trials=args.trials,
+                             warmup=args.warmup, cpus=_parse_cpus(args.cpus) if args.cpus else None,
+                             quick=args.quick, build_profile=args.build_profile)
+        contenders = cost.plan_flags(args.base, args.flags.split(",") if args.flags else None, prefixes)
+        costs = cost.costs(cost.run(contenders))
+        json_path, md_path = cost.write_cost_reports(costs)
+
+        print(md_path.read_text())
+        print(f"✓ Hardening cost report written: {md_path}, {json_path}", file=sys.stderr)
+        return 0 if costs["flags"] or costs["hardened"] else 1
+
+    except Exception as e:
+        print(f"✗ Error measuring hardening cost: {e}", file=sys.stderr)
+        return 1
+
+
+def build_parity(args) -> int:
+    """Compare one version's python build against its vanilla build."""
+    from openssl_tools.development.build_system.build_parity import BuildParityChecker
+    from openssl_tools.development.build_system.statistical_runner import _parse_cpus
+
+    try:
+        checker = BuildParityChecker(args.build_root, args.output_dir, args.recipe / "test_package",
+                                     trials=args.trials, warmup=args.warmup,
+                                     cpus=_parse_cpus(args.cpus) if args.cpus else None, quick=args.quick,
+                                     min_effect_percent=args.min_effect)
+        report = checker.run(args.version, benchmark=not args.no_bench)
+        json_path, md_path = checker.write_reports(report)
+
+        print(md_path.read_text())
+        print(f"{'✓' if report.passed else '✗'} Build parity report written: {md_path}, {json_path}",
+              file=sys.stderr)
+        return 0 if report.passed else 1
+
+    except Exception as e:
+        print(f"✗ Error comparing builds: {e}", file=sys.stderr)
+        return 1
+
+
+def sslctx_tune(args) -> int:
+    """Coordinate-descent search over SSL_CTX settings with the bench_sslctx probe."""
+    from openssl_tools.development.build_system.sslctx_tuner import SSLCtxTuner
+    from openssl_tools.development.build_system.statistical_runner import _parse_cpus
+    from openssl_tools.openssl.crypto_config import CryptoConfigManager
+
+    try:
+        manager = CryptoConfigManager(args.config)
+        start = manager.current_config.performance or manager.enable_performance_tuning()
+        tuner = SSLCtxTuner(args.probe, args.output_dir / "trials", trials=args.trials, warmup=args.warmup,
+                            cpus=_parse_cpus(args.cpus) if args.cpus else None, quick=args.quick,
+                            clients=args.clients, handshake_weight=args.handshake_weight)
+        tuned = tuner.tune(start, args.parameters.split(",") if args.parameters else None)
+        report = args.output_dir / "sslctx-tuning.json"
+        tuner.write_outputs(tuned, manager, args.output, report)
+        if args.save_config:
+            manager.save_configuration(args.save_config)
+
+        for call in tuned.ssl_ctx_calls():
+            print(f"  {call}")
+        print(f"✓ Tuned configuration written: {args.output}, {report}", file=sys.stderr)
+        return 0
+
+    except Exception as e:
+        print(f"✗ Error tuning SSL_CTX settings: {e}", file=sys.stderr)
+        return 1
+
+
+def build_variants(args) -> int:
+    """Build the requested variants from shared pristine sources."""
+    from openssl_tools.development.build_system.source_trees import DEFAULT_CONFIGURE_PY, SharedSourceBuilder
+
+    try:
+        builder = SharedSourceBuilder(args.root, url=args.url, configure_py=args.configure_py or DEFAULT_CONFIGURE_PY,
+                                      jobs=args.jobs, configure_args=args.configure_arg)
+        versions = args.versions.split(",")
+        results = builder.build(versions, args.variants.split(","), update=args.update)
+        for result in results:
+            mark = "✓" if result.ok else "✗"
+            detail = result.prefix if result.ok else f"{result.error} (log: {result.log})"
+            print(f"{mark} {result.version}/{result.variant}: {detail}")
+        if args.prune_legacy and all(result.ok for result in results):
+            for legacy in builder.prune_legacy(versions):
+                print(f"✓ Removed legacy source copy {legacy}", file=sys.stderr)
+        return 0 if all(result.ok for result in results) else 1
+
+    except Exception as e:
+        print(f"✗ Error building variants: {e}", file=sys.stderr)
+        return 1
+
+
+def cache_command(args) -> int:
+    """Warm Conan caches from lockfiles, once or as a watcher."""
+    from openssl_tools.development.package_management.cache_warmer import CacheWarmer, find_lockfiles
+
+    try:
+        warmer = CacheWarmer(args.remote, args.cache or None, pattern=args.pattern,
+                             package_query=args.package_query, parallel=args.parallel)
+        failed = []
+
+        def report(result) -> None:
+            for cache, packages in result.packages.items():
+                print(f"✓ {cache}: {result.recipes[cache]} recipe(s), {packages} package(s) fetched")
+            for error in result.errors:
+                print(f"✗ {error}", file=sys.stderr)
+            print(f"✓ {len(result.refs)} pinned revision(s) warm in {result.seconds:.1f}s", file=sys.stderr)
+            if args.zero_copy and warmer.link_zero_copy() != 0:
+                result.errors.append("setup-zero-copy-links.sh failed")
+            failed[:] = result.errors
+
+        if args.watch:
+            warmer.watch(args.lockfile, args.watch, on_pass=report)
+            return 0
+        lockfiles = find_lockfiles(args.lockfile)
+        if not lockfiles:
+            print("✗ No lockfiles found", file=sys.stderr)
+            return 1
+        report(warmer.warm(lockfiles))
+        return 1 if failed else 0
+
+    except Exception as e:
+        print(f"✗ Error warming cache: {e}", file=sys.stderr)
+        return 1
+
+
+def host_variant(args) -> int:
+    """Select and place the package variant for this host."""
+    from openssl_tools.foundation.profile_deployer import (
+        deploy_host_variant, detect_cpu_features, host_arch, rank_simd_profiles)
+
+    if args.detect or not args.reference:
+        features = detect_cpu_features()
+        print(json.dumps({"arch": host_arch(), "features": sorted(features),
+                          "profiles": rank_simd_profiles(features)}, indent=2))
+        return 0
+    try:
+        selection = deploy_host_variant(args.reference, args.dest, base_profile=args.profile,
+                                        remote=args.remote, link_mode=args.link_mode,
+                                        build_missing=args.build_missing)
+    except Exception as e:
+        print(f"✗ Error installing host variant: {e}", file=sys.stderr)
+        return 1
+    return 0 if selection else 1
+
+
+def deferred_tests(args) -> int:
+    """Run a cross build's deferred test bundle on this (native) host."""
+    from openssl_tools.testing.deferred_tests import print_summary, run_bundle
+
+    try:
+        results, junit, returncode = run_bundle(args.bundle, args.results_dir, args.work_dir, args.jobs,
+                                                args.tests, args.any_arch)
+    except Exception as e:
+        print(f"✗ Error running deferred tests: {e}", file=sys.stderr)
+        return 1
+    return print_summary(results, junit, returncode)
+
+
+def add_history_arguments(parser) -> None:
+    """Build history options shared by `matrix generate` and `matrix dispatch`"""
+    parser.add_argument("--history", type=Path, action="append", default=[], metavar="DIR",
+                        help="build-summary-*.json directory of earlier runs (repeatable)")
+    parser.add_argument("--failure-index", type=Path,
+                        help="EcosystemMonitor failure index (SQLite) merged into the failure rates")
+    parser.add_argument("--time-budget", type=float, metavar="MINUTES",
+                        help="Builder-minutes the matrix may take (default: per optimization level)")
+
+
+def matrix_history(args):
+    """BuildHistory from --history/--failure-index, or None without them"""
+    from openssl_tools.openssl.build_history import BuildHistory
+
+    if not args.history and not args.failure_index:
+        return None
+    return BuildHistory.load(args.history, args.failure_index)
+
+
+def dispatch_matrix(args) -> int:
+    """Build the generated matrix on remote builder nodes."""
+    from openssl_tools.openssl.remote_executor import RemoteBuildExecutor, load_nodes
+
+    try:
+        nodes = load_nodes(args.nodes)
+        if not nodes:
+            print(f"✗ No builder nodes in {args.nodes}", file=sys.stderr)
+            return 1
+        matrix = SmartBuildMatrix(config_file=args.config, history=matrix_history(args)).generate_matrix(
+            args.optimization, args.time_budget)
+        executor = RemoteBuildExecutor(nodes, args.recipe, args.log_dir, retries=args.retries,
+                                       restore=not args.no_restore, timeout=args.timeout)
+        jobs = executor.run(matrix, follow=args.follow)
+
+        failed = [job for job in jobs if not job.success]
+        for job in failed:
+            print(f"✗ {job.name}: {job.error} (node {job.node or '-'})", file=sys.stderr)
+        print(f"✓ {len(jobs) - len(failed)}/{len(jobs)} builds succeeded, summaries in {args.log_dir}",
+              file=sys.stderr)
+        return 0 if not failed else 1
+
+    except Exception as e:
+        print(f"✗ Error dispatching matrix: {e}", file=sys.stderr)
+        return 1
+
+
+def loadgen(args) -> int:
+    """Run a multi-node load test per variant and write the aggregated summary."""
+    from openssl_tools.openssl.loadgen_controller import (
+        LoadTestController, format_summary, load_plan, parse_variants)
+
+    try:
+        plan = load_plan(args.nodes, duration=args.duration, requests=args.requests, size=args.size,
+                         key_type=args.key, port=args.port)
+        controller = LoadTestController(plan, args.output.parent / "loadgen")
+        summary = controller.run(parse_variants(args.variant))
+        args.output.parent.mkdir(parents=True, exist_ok=True)
+        args.output.write_text(json.dumps(summary, indent=2), encoding="utf-8")
+        print(format_summary(summary))
+        print(f"✓ Summary written to {args.output}", file=sys.stderr)
+        return 0 if all(row["clients"] and not row["failed_clients"] for row in summary["variants"]) else 1
+
+    except Exception as e:
+        print(f"✗ Error running load test: {e}", file=sys.stderr)
+        return 1
+
+
 def generate_matrix(args) -> int:
     """Generate build matrix based on arguments."""
     try:
         # Initialize the matrix generator
         config_file = args.config if hasattr(args, 'config') and args.config else None
-        matrix_gen = SmartBuildMatrix(config_file=config_file)
+        matrix_gen = SmartBuildMatrix(config_file=config_file, history=matrix_history(args))
+        time_budget = getattr(args, 'time_budget', None)
 
         # Get optimization level
         optimization = getattr(args, 'optimization', 'high')
@@ -78,10 +925,15 @@ def generate_matrix(args) -> int:
         # Generate matrix
         if getattr(args, 'github_actions', False):
             # GitHub Actions format
-            matrix_json = matrix_gen.generate_github_actions_matrix(optimization)
+            test_durations = None
+            if args.test_shards > 1:
+                from openssl_tools.testing.test_sharding import load_recipe_durations
+                test_durations = load_recipe_durations(args.test_history)
+            matrix_json = matrix_gen.generate_github_actions_matrix(optimization, time_budget,
+                                                                    args.test_shards, test_durations)
         else:
             # Standard format
-            matrix = matrix_gen.generate_matrix(optimization)
+            matrix = matrix_gen.generate_matrix(optimization, time_budget)
             matrix_json = json.dumps(
                 [config.to_dict() for config in matrix],
                 indent=2
@@ -124,6 +976,55 @@ def main() -> int:
         if args.matrix_command == "generate":
             return generate_matrix(args)
 
+        if args.matrix_command == "dispatch":
+            return dispatch_matrix(args)
+
+    if args.command == "loadgen":
+        return loadgen(args)
+
+    if args.command == "benchmark-matrix":
+        return benchmark_matrix(args)
+
+    if args.command == "compiler-shootout":
+        return compiler_shootout(args)
+
+    if args.command == "hardening-cost":
+        return hardening_cost(args)
+
+    if args.command == "build-parity":
+        return build_parity(args)
+
+    if args.command == "sslctx-tune":
+        return sslctx_tune(args)
+
+    if args.command == "build-variants":
+        return build_variants(args)
+
+    if args.command == "cache":
+        if not getattr(args, 'cache_command', None):
+            parser.print_help()
+            return 0
+        return cache_command(args)
+
+    if args.command == "host-variant":
+        return host_variant(args)
+
+    if args.command == "deferred-tests":
+        return deferred_tests(args)
+
+    if args.command == "config":
+        if not getattr(args, 'config_command', None):
+            parser.print_help()
+            return 0
+        from openssl_tools.config_snapshot import main as config_snapshot_main
+        return config_snapshot_main([str(f) for f in args.files])
+
+    if args.command == "perf":
+        if not getattr(args, 'perf_command', None):
+            parser.print_help()
+            return 0
+        return perf_command(args)
+
     # Unknown command
     parser.print_help()
     return 1
@@ -11,6 +11,7 @@ import tempfile
 from functools import cache
 from pathlib import Path
 
+from .conan_session import get_conan_session, run_conan
 from .execute_command import execute_command
 from .file_operations import find_executable_in_path, find_first_existing_file
 from .exceptions import SharedDevToolsError
@@ -64,7 +65,7 @@ def get_default_conan() -> Path:
 @cache
 def get_conan_home():
     """Get the Conan home directory."""
-    rc, return_string = execute_command(f'{get_default_conan()} config home')
+    rc, return_string = execute_conan_command('config home')
     if rc == 0 and return_string:
         conan_home = return_string[-1].strip()
         return conan_home
@@ -76,7 +77,7 @@ def get_conan_home():
 def get_all_packages_in_cache() -> list:
     """Get all packages currently in the Conan cache."""
     # Use conan list to get all packages in cache (Conan 2.x format)
-    rc, return_string = execute_command(f'{get_default_conan()} list "*"')
+    rc, return_string = execute_conan_command('list "*"')
     if rc == 0:
         # Parse the text output to extract package references
         packages = []
@@ -92,18 +93,43 @@ def get_all_packages_in_cache() -> list:
 
 def remove_conan_package_from_cache(package_name):
     """Remove a package from the Conan cache."""
-    return execute_command(f'{get_default_conan()} remove {package_name} --force')
+    return execute_conan_command(f'remove {package_name} --force')
 
 
 def execute_conan_command(command, **kwargs):
-    """Execute a Conan command with proper error handling."""
-    full_command = f'{get_default_conan()} {command}'
-    return execute_command(full_command, **kwargs)
+    """
+    Execute a Conan command with proper error handling.
+
+    Runs in the shared in-process Conan session (see conan_session) when
+    Conan is importable, with execute_command()'s output conventions:
+    log lines (stderr) first, then results (stdout). A custom_env or
+    wait_till_finish=False still needs a subprocess.
+    """
+    if get_conan_session() is None or kwargs.get('custom_env') or not kwargs.get('wait_till_finish', True):
+        full_command = f'{get_default_conan()} {command}'
+        return execute_command(full_command, **kwargs)
+
+    if kwargs.get('print_command', True):
+        log.info(f'Executing conan command: {command}')
+    result = run_conan(command, wait=True)
+    output_lines = result.stdout.splitlines()
+    error_lines = result.stderr.splitlines()
+    if kwargs.get('combine_stdout_and_stderr', True):
+        output_lines, error_lines = error_lines + output_lines, []
+    if kwargs.get('print_out', True):
+        for line in output_lines:
+            log.info(f'OUT: {line}')
+    if kwargs.get('print_error', True):
+        for line in error_lines:
+            log.error(f'ERR: {line}')
+    if kwargs.get('print_err_code', True) and result.returncode != 0:
+        log.warning(f'Command failed (exit code: {result.returncode})')
+    return result.returncode, output_lines
 
 
 def get_conan_version():
     """Get the Conan version."""
-    rc, output = execute_command(f'{get_default_conan()} --version')
+    rc, output = execute_conan_command('--version')
     if rc == 0 and output:
         return output[0].strip()
     return None
@@ -0,0 +1,157 @@
+"""
+Conan Session
+
+One long-lived, in-process Conan 2 API instance shared by every module that
+runs Conan commands. A `conan` subprocess pays Python startup, the Conan
+import and cache/remote/profile loading on every call; the session pays
+them once, so the hundreds of `list`/`install`/`upload` calls an
+orchestration script makes cost only the work they do.
+
+Commands go through Conan's own CLI layer (`conan.cli.cli.Cli`), so the
+arguments and output are those of the `conan` executable. Conan writes to
+the process-wide stdout/stderr and resolves paths against the working
+directory, so in-process commands are serialized. A caller that finds the
+session busy - parallel matrix builds, say - runs its command in a
+subprocess instead rather than waiting, which keeps concurrent builds
+concurrent. Without the `conan` Python package, or with
+OPENSSL_TOOLS_CONAN_SUBPROCESS=1, everything runs as a subprocess.
+"""
+
+import contextlib
+import io
+import logging
+import os
+import shlex
+import subprocess
+import threading
+from typing import List, Optional, Sequence, Union
+
+log = logging.getLogger(__name__)
+
+# conan.cli.exit_codes
+ERROR_GENERAL = 1
+ERROR_INVALID_CONFIGURATION = 6
+ERROR_UNEXPECTED = 7
+
+
+class ConanSession:
+    """Lazily created ConanAPI plus CLI dispatcher, reused across commands"""
+
+    def __init__(self, cache_folder: Optional[str] = None):
+        self.cache_folder = cache_folder
+        self.lock = threading.Lock()
+        self._api = None
+        self._cli = None
+
+    @staticmethod
+    def available() -> bool:
+        if os.environ.get("OPENSSL_TOOLS_CONAN_SUBPROCESS") == "1":
+            return False
+        try:
+            import conan.api.conan_api  # noqa: F401
+        except ImportError:
+            return False
+        return True
+
+    @property
+    def api(self):
+        """The shared conan.api.conan_api.ConanAPI (profiles, remotes, cache DB)"""
+        if self._api is None:
+            from conan.api.conan_api import ConanAPI
+            self._api = ConanAPI(self.cache_folder)
+        return self._api
+
+    def _cli_instance(self):
+        if self._cli is None:
+            from conan.cli.cli import Cli
+            cli = Cli(self.api)
+            if hasattr(cli, "add_commands"):  # Conan < 2.1 registers commands explicitly
+                cli.add_commands()
+            self._cli = cli
+        return self._cli
+
+    def run(self, args: Sequence[str], cwd: Optional[str] = None) -> subprocess.CompletedProcess:
+        """Run one conan command in-process; the caller must hold self.lock"""
+        from conan.errors import ConanException, ConanInvalidConfiguration
+
+        stdout, stderr = io.StringIO(), io.StringIO()
+        previous_cwd = os.getcwd()
+        returncode = 0
+        try:
+            if cwd:
+                os.chdir(cwd)
+            with contextlib.redirect_stdout(stdout), contextlib.redirect_stderr(stderr):
+                try:
+                    self._cli_instance().run(list(args))
+                except SystemExit as e:
+                    returncode = e.code if isinstance(e.code, int) else ERROR_GENERAL
+                except ConanInvalidConfiguration as e:
+                    stderr.write(f"ERROR: {e}\n")
+                    returncode = ERROR_INVALID_CONFIGURATION
+                except ConanException as e:
+                    stderr.write(f"ERROR: {e}\n")
+                    returncode = ERROR_GENERAL
+                except Exception as e:
+                    stderr.write(f"ERROR: {type(e).__name__}: {e}\n")
+                    returncode = ERROR_UNEXPECTED
+        finally:
+            os.chdir(previous_cwd)
+            if any(a in ("remote", "config", "profile") for a in args[:1]):
+                # Commands that change configuration: reload it for the next call
+                reinit = getattr(self.api, "reinit", None)
+                if reinit:
+                    reinit()
+        return subprocess.CompletedProcess(["conan", *args], returncode,
+                                           stdout.getvalue(), stderr.getvalue())
+
+
+_session: Optional[ConanSession] = None
+_session_guard = threading.Lock()
+
+
+def get_conan_session() -> Optional[ConanSession]:
+    """The process-wide session, or None when Conan is not importable"""
+    global _session
+    with _session_guard:
+        if _session is None and ConanSession.available():
+            _session = ConanSession()
+        return _session
+
+
+def _conan_executable() -> str:
+    try:
+        from .conan_functions import get_default_conan
+        return str(get_default_conan())
+    except Exception:
+        return "conan"
+
+
+def run_conan(args: Union[str, Sequence[str]], cwd: Optional[Union[str, os.PathLike]] = None,
+              check: bool = False, wait: bool = False) -> subprocess.CompletedProcess:
+    """
+    Run a conan command (arguments without the leading "conan"), with the
+    result shaped like subprocess.run(..., capture_output=True, text=True).
+    In-process through the shared session when it is free; when another
+    thread is using it, wait=False runs this command as a subprocess.
+    With check=True a non-zero exit raises subprocess.CalledProcessError.
+    """
+    if isinstance(args, str):
+        args = shlex.split(args)
+    args: List[str] = list(args)
+    cwd = os.fspath(cwd) if cwd is not None else None
+
+    session = get_conan_session()
+    result = None
+    if session is not None and session.lock.acquire(blocking=wait):
+        try:
+            log.debug(f"conan (in-process): {' '.join(args)}")
+            result = session.run(args, cwd)
+        finally:
+            session.lock.release()
+    if result is None:
+        log.debug(f"conan (subprocess): {' '.join(args)}")
+        result = subprocess.run([_conan_executable(), *args], capture_output=True, text=True, cwd=cwd)
+
+    if check and result.returncode != 0:
+        raise subprocess.CalledProcessError(result.returncode, result.args, result.stdout, result.stderr)
+    return result
@@ -0,0 +1,270 @@
+"""
+Configuration Snapshot
+
+Parsed, validated configuration shared by every openssl_tools module and
+by the processes a build spawns. YAML parsing with PyYAML's pure-Python
+loader costs milliseconds per file, and each CacheOptimizer,
+RegistryVersioningManager, orchestrator or CLI run used to pay it again
+for the same files.
+
+- The bundled files (config/*.yaml, config/*.json, profiles/index.json,
+  profiles/axes.yaml) are compiled into one snapshot pickle. A process
+  whose files still have the size and mtime recorded in the snapshot
+  loads it with one read and no parsing; a changed file is re-parsed
+  and the snapshot rewritten.
+- Any other file given to load_config() is cached under the SHA-256 of
+  its name and content, so identical files parse once per machine.
+
+Files are validated when they are parsed, never on cache hits. Every
+call returns a fresh copy, so callers may modify what they get.
+
+The cache lives in $OPENSSL_TOOLS_CONFIG_CACHE (default
+~/.cache/openssl-tools/config); OPENSSL_TOOLS_CONFIG_CACHE=off keeps it
+in memory only.
+"""
+
+import hashlib
+import json
+import logging
+import os
+import pickle
+import threading
+from pathlib import Path
+from typing import Any, Callable, Dict, Optional, Tuple, Union
+
+import yaml
+
+from .exceptions import ConfigurationError
+
+log = logging.getLogger(__name__)
+
+PACKAGE_DIR = Path(__file__).resolve().parent
+BUNDLED_PATTERNS = ["config/*.yaml", "config/*.json", "profiles/index.json", "profiles/axes.yaml"]
+
+# Bump when the pickled layout or the parsing changes
+SNAPSHOT_FORMAT = 1
+SCHEMA_MAJOR = "1"
+
+_lock = threading.Lock()
+# path -> ((size, mtime_ns), pickled data) for this process
+_memo: Dict[str, Tuple[Tuple[int, int], bytes]] = {}
+_snapshot: Optional["ConfigSnapshot"] = None
+
+
+def cache_dir() -> Optional[Path]:
+    setting = os.environ.get("OPENSSL_TOOLS_CONFIG_CACHE")
+    if setting == "off":
+        return None
+    if setting:
+        return Path(setting)
+    base = os.environ.get("XDG_CACHE_HOME") or os.path.join(os.path.expanduser("~"), ".cache")
+    return Path(base) / "openssl-tools" / "config"
+
+
+def _require_profiles(key: str) -> Callable[[str, Any], None]:
+    def check(path: str, data: Any):
+        profiles = data.get("profiles")
+        if not isinstance(profiles, list):
+            raise ConfigurationError(f"{path}: 'profiles' must be a list")
+        for i, profile in enumerate(profiles):
+            if not isinstance(profile, dict) or key not in profile:
+                raise ConfigurationError(f"{path}: profiles[{i}] has no '{key}'")
+    return check
+
+
+# Checks by file name, on top of the generic ones in validate()
+VALIDATORS: Dict[str, Callable[[str, Any], None]] = {
+    "build-profiles.json": _require_profiles("name"),
+    "index.json": _require_profiles("id"),
+}
+
+
+def validate(path: str, data: Any) -> Any:
+    """Raise ConfigurationError unless data is a usable configuration mapping"""
+    if data is None:
+        return {}
+    if not isinstance(data, dict):
+        raise ConfigurationError(f"{path}: top level must be a mapping, not {type(data).__name__}")
+    sections = [data] + [v for v in data.values() if isinstance(v, dict)]
+    for section in sections:
+        version = section.get("schema_version")
+        if version is not None and str(version).split(".")[0] != SCHEMA_MAJOR:
+            raise ConfigurationError(f"{path}: unsupported schema_version {version} "
+                                     f"(expected {SCHEMA_MAJOR}.x)")
+    check = VALIDATORS.get(os.path.basename(path))
+    if check:
+        check(path, data)
+    return data
+
+
+def parse_config(path: Union[str, Path], content: bytes) -> Any:
+    """Parse YAML or JSON (by suffix) and validate it"""
+    path = os.fspath(path)
+    try:
+        if path.endswith(".json"):
+            data = json.loads(content)
+        else:
+            data = yaml.safe_load(content)
+    except (ValueError, yaml.YAMLError) as e:
+        raise ConfigurationError(f"{path}: {e}") from e
+    return validate(path, data)
+
+
+def _stat_key(path: str) -> Tuple[int, int]:
+    st = os.stat(path)
+    return st.st_size, st.st_mtime_ns
+
+
+def _write_atomic(path: Path, payload: bytes):
+    try:
+        path.parent.mkdir(parents=True, exist_ok=True)
+        tmp = path.with_name(f".{path.name}.{os.getpid()}.tmp")
+        tmp.write_bytes(payload)
+        os.replace(tmp, path)
+    except OSError as e:
+        log.debug(f"Cannot write configuration cache {path}: {e}")
+
+
+def _read_cached(path: Path) -> Tuple[Optional[bytes], Any]:
+    """Pickled cache entry and its contents, or (None, None) if missing or unreadable"""
+    try:
+        blob = path.read_bytes()
+        return blob, pickle.loads(blob)
+    except FileNotFoundError:
+        return None, None
+    except Exception as e:  # truncated or from another Python
+        log.debug(f"Ignoring configuration cache {path}: {e}")
+        return None, None
+
+
+class ConfigSnapshot:
+    """Parsed bundled configuration, keyed by path relative to the package"""
+
+    def __init__(self, files: Dict[str, Tuple[int, int, str]], blobs: Dict[str, bytes]):
+        self.files = files
+        self._blobs = blobs
+
+    def __contains__(self, name: str) -> bool:
+        return name in self._blobs
+
+    def names(self):
+        return sorted(self._blobs)
+
+    def get(self, name: str, default: Any = None) -> Any:
+        blob = self._blobs.get(name)
+        return default if blob is None else pickle.loads(blob)
+
+    @classmethod
+    def build(cls, root: Path = PACKAGE_DIR) -> "ConfigSnapshot":
+        paths = sorted({p for pattern in BUNDLED_PATTERNS for p in root.glob(pattern) if p.is_file()})
+        names = [p.relative_to(root).as_posix() for p in paths]
+        location = cache_dir()
+        snapshot_file = None
+        cached = None
+        if location:
+            snapshot_file = location / f"snapshot-{hashlib.sha256(str(root).encode()).hexdigest()[:16]}.pickle"
+            _, cached = _read_cached(snapshot_file)
+            if not (isinstance(cached, dict) and cached.get("format") == SNAPSHOT_FORMAT
+                    and sorted(cached.get("files", {})) == names):
+                cached = None
+
+        stats = {name: _stat_key(str(path)) for name, path in zip(names, paths)}
+        if cached and all(tuple(cached["files"][n][:2]) == stats[n] for n in names):
+            return cls(cached["files"], cached["blobs"])
+
+        # Something changed (or was only touched): re-parse what differs by content
+        files, blobs = {}, {}
+        for name, path in zip(names, paths):
+            content = path.read_bytes()
+            digest = hashlib.sha256(content).hexdigest()
+            if cached and cached["files"][name][2] == digest:
+                blobs[name] = cached["blobs"][name]
+            else:
+                blobs[name] = pickle.dumps(parse_config(path, content), pickle.HIGHEST_PROTOCOL)
+            files[name] = (*stats[name], digest)
+        if snapshot_file:
+            _write_atomic(snapshot_file, pickle.dumps({"format": SNAPSHOT_FORMAT, "files": files, "blobs": blobs},
+                                                     pickle.HIGHEST_PROTOCOL))
+        log.debug(f"Compiled configuration snapshot of {len(names)} files")
+        return cls(files, blobs)
+
+
+def snapshot(refresh: bool = False) -> ConfigSnapshot:
+    """The bundled configuration, compiled once per process"""
+    global _snapshot
+    with _lock:
+        if _snapshot is None or refresh:
+            _snapshot = ConfigSnapshot.build()
+        return _snapshot
+
+
+def bundled_config(name: str, default: Any = None) -> Any:
+    """A bundled file by package-relative name, e.g. "config/1_build.yaml" or "profiles/index.json" """
+    return snapshot().get(name, default)
+
+
+def load_config(path: Union[str, Path], default: Any = None) -> Any:
+    """
+    Parsed and validated contents of a YAML/JSON configuration file, or
+    default when it does not exist. Raises ConfigurationError for files
+    that do not parse or validate.
+    """
+    path = os.path.abspath(os.fspath(path))
+    try:
+        key = _stat_key(path)
+    except FileNotFoundError:
+        return default
+
+    try:
+        name = Path(path).relative_to(PACKAGE_DIR).as_posix()
+    except ValueError:
+        name = None
+    if name is not None:
+        current = snapshot()
+        if name in current and tuple(current.files[name][:2]) == key:
+            return current.get(name)
+
+    with _lock:
+        memo = _memo.get(path)
+    if memo and memo[0] == key:
+        return pickle.loads(memo[1])
+
+    with open(path, "rb") as f:
+        content = f.read()
+    location = cache_dir()
+    # The file name picks the parser and validators, so it is part of the key
+    digest = hashlib.sha256(os.path.basename(path).encode() + b"\0" + content).hexdigest()
+    entry = location / f"{digest}.v{SNAPSHOT_FORMAT}.pickle" if location else None
+    blob, data = _read_cached(entry) if entry else (None, None)
+    if blob is None:
+        data = parse_config(path, content)
+        blob = pickle.dumps(data, pickle.HIGHEST_PROTOCOL)
+        if entry:
+            _write_atomic(entry, blob)
+    with _lock:
+        _memo[path] = (key, blob)
+    return data
+
+
+def main(argv=None) -> int:
+    import argparse
+    parser = argparse.ArgumentParser(description="Compile and validate the openssl_tools configuration snapshot")
+    parser.add_argument("files", nargs="*", type=Path, help="Other configuration files to validate and cache")
+    args = parser.parse_args(argv)
+    try:
+        current = snapshot(refresh=True)
+        for name in current.names():
+            print(f"{name}  {current.files[name][2][:12]}")
+        for path in args.files:
+            if load_config(path) is None:
+                raise ConfigurationError(f"{path}: not found")
+            print(f"{path}  ok")
+    except ConfigurationError as e:
+        print(f"Invalid configuration: {e}")
+        return 1
+    print(f"Cache: {cache_dir() or 'memory only'}")
+    return 0
+
+
+if __name__ == "__main__":
+    raise SystemExit(main())
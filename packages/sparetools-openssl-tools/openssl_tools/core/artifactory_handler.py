@@ -2,11 +2,23 @@
 """
 OpenSSL Tools Artifactory Handler
 Based on openssl-tools patterns for package repository management
+
+Tree downloads (get_all_in_path) list the whole tree with one paged AQL
+query where the server allows it, and otherwise walk it through the
+storage API with directory listings running concurrently. Downloads start
+as soon as files are listed, share one pooled HTTP session, and are
+checksum-verified while they stream; files already present locally with
+the right checksum are not fetched again.
 """
 
+import hashlib
+import json
 import logging
 import os
-from pathlib import Path
+import threading
+import urllib.parse
+from concurrent.futures import FIRST_COMPLETED, ThreadPoolExecutor, wait
+from typing import Dict, Iterator, List, Optional, Tuple
 
 try:
     import artifactory
@@ -16,20 +28,38 @@ except ImportError:
     ARTIFACTORY_AVAILABLE = False
     ArtifactoryPath = None
 
+try:
+    import requests
+    from requests.adapters import HTTPAdapter
+    REQUESTS_AVAILABLE = True
+except ImportError:
+    REQUESTS_AVAILABLE = False
+
 from openssl_tools.util.copy_tools import ensure_target_exists
 
 log = logging.getLogger('__main__.' + __name__)
 
+DOWNLOAD_CHUNK_SIZE = 1024 * 1024
+AQL_PAGE_SIZE = 10000
+DEFAULT_WORKERS = 8
+
+
+class ChecksumMismatch(IOError):
+    pass
+
 
 class ArtifactoryHandler:
-    def __init__(self, config_loader):
+    def __init__(self, config_loader, max_workers: int = DEFAULT_WORKERS):
         self.config = config_loader
         self.connector = None
+        self.max_workers = max(1, max_workers)
+        self._session = None
+        self._session_lock = threading.Lock()
 
     def _jfrog_authentication(self, repository_path) -> ArtifactoryPath:
         if not ARTIFACTORY_AVAILABLE:
             raise ImportError("artifactory package not available. Install with: pip install artifactory")
-            
+
         artifactory_path = ArtifactoryPath(
             self.config.artifactory.root + '/' + repository_path,
             auth=(self.config.artifactory.user, self.config.artifactory.password)
@@ -43,24 +73,97 @@ class ArtifactoryHandler:
         """
         return self._jfrog_authentication(repository_path)
 
-    def get_all_in_path(self, repository_path, target):
+    # -- REST access ----------------------------------------------------------
+
+    def session(self) -> "requests.Session":
+        """One authenticated session whose connection pool fits every worker"""
+        if not REQUESTS_AVAILABLE:
+            raise ImportError("requests package not available. Install with: pip install requests")
+        with self._session_lock:
+            if self._session is None:
+                session = requests.Session()
+                session.auth = (self.config.artifactory.user, self.config.artifactory.password)
+                adapter = HTTPAdapter(pool_connections=4, pool_maxsize=self.max_workers + 2, max_retries=3)
+                session.mount("https://", adapter)
+                session.mount("http://", adapter)
+                self._session = session
+            return self._session
+
+    def _url(self, *parts: str) -> str:
+        path = "/".join(p.strip("/") for p in parts if p and p.strip("/"))
+        return self.config.artifactory.root.rstrip("/") + "/" + urllib.parse.quote(path)
+
+    @staticmethod
+    def _split(repository_path) -> Tuple[str, str]:
+        repo, _, path = str(repository_path).strip("/").partition("/")
+        return repo, path
+
+    def aql_files(self, repository_path) -> Optional[List[Dict]]:
         """
-        Download all files in folder and its subdirectories
-        :param repository_path: Artifactory path to get data from
-        :param target: Target location to store files to
-        :return: None
+        Every file below repository_path from AQL, paged, as dicts with the
+        path relative to repository_path, size, sha256 and sha1. None when
+        the server refuses AQL (it needs a non-anonymous user on most
+        installations), so callers fall back to walking.
         """
-        self.original_path = repository_path
-        self.__get_all_in_path(repository_path, target)
+        repo, path = self._split(repository_path)
+        criteria = {"repo": repo, "type": "file"}
+        if path:
+            criteria["$or"] = [{"path": path}, {"path": {"$match": f"{path}/*"}}]
+        files: List[Dict] = []
+        while True:
+            query = (f"items.find({json.dumps(criteria)})"
+                     f'.include("path","name","size","sha256","actual_sha1")'
+                     f'.sort({{"$asc":["path","name"]}}).offset({len(files)}).limit({AQL_PAGE_SIZE})')
+            response = self.session().post(self._url("api/search/aql"), data=query,
+                                           headers={"Content-Type": "text/plain"})
+            if response.status_code in (400, 401, 403, 404, 405):
+                log.debug(f'Artifactory - AQL not available ({response.status_code}), walking {repository_path}')
+                return None
+            response.raise_for_status()
+            results = response.json().get("results", [])
+            for item in results:
+                item_path = "" if item["path"] == "." else item["path"]
+                rel_dir = item_path[len(path):].strip("/") if path else item_path
+                files.append({
+                    "path": f"{rel_dir}/{item['name']}" if rel_dir else item["name"],
+                    "size": item.get("size"),
+                    "sha256": item.get("sha256"),
+                    "sha1": item.get("actual_sha1"),
+                })
+            if len(results) < AQL_PAGE_SIZE:
+                return files
 
-    def __get_all_in_path(self, repository_path, target):
-        connector = self.connect_to_artifactory(repository_path)
-        for p in connector:
-            if p.is_dir():
-                self.__get_all_in_path(p, target)
+    def _list_directory(self, repository_path, rel_dir: str) -> Tuple[List[str], List[Dict]]:
+        """(subdirectories, files) of one directory through the storage API"""
+        response = self.session().get(self._url("api/storage", str(repository_path), rel_dir))
+        response.raise_for_status()
+        dirs, files = [], []
+        for child in response.json().get("children", []):
+            rel = f"{rel_dir}/{child['uri'].strip('/')}" if rel_dir else child["uri"].strip("/")
+            if child.get("folder"):
+                dirs.append(rel)
             else:
-                subfolders = str(p.parent).replace(str(self.original_path), "")[1:]
-                self.store_single_file(p, os.path.join(target, subfolders))
+                files.append({"path": rel, "size": None, "sha256": None, "sha1": None})
+        return dirs, files
+
+    def list_tree(self, repository_path) -> Iterator[Dict]:
+        """
+        Files below repository_path as they are found: AQL when possible,
+        else a breadth-first walk with up to max_workers directory listings
+        in flight at once
+        """
+        files = self.aql_files(repository_path)
+        if files is not None:
+            yield from files
+            return
+        with ThreadPoolExecutor(max_workers=self.max_workers) as pool:
+            pending = {pool.submit(self._list_directory, repository_path, "")}
+            while pending:
+                done, pending = wait(pending, return_when=FIRST_COMPLETED)
+                for future in done:
+                    dirs, found = future.result()
+                    pending.update(pool.submit(self._list_directory, repository_path, d) for d in dirs)
+                    yield from found
 
     @staticmethod
     def artifactory_walk(repository_path, topdown=True):
@@ -68,6 +171,75 @@ class ArtifactoryHandler:
             raise ImportError("artifactory package not available. Install with: pip install artifactory")
         return artifactory.walk(repository_path, topdown)
 
+    # -- downloads ------------------------------------------------------------
+
+    def get_all_in_path(self, repository_path, target):
+        """
+        Download all files in folder and its subdirectories
+        :param repository_path: Artifactory path to get data from
+        :param target: Target location to store files to
+        :return: Number of files downloaded (files already up to date are not counted)
+        """
+        self.original_path = repository_path
+        downloaded = 0
+        with ThreadPoolExecutor(max_workers=self.max_workers) as pool:
+            # Listing keeps going while the first files download
+            futures = [pool.submit(self.download_file, repository_path, entry,
+                                   os.path.join(target, *entry["path"].split("/")))
+                       for entry in self.list_tree(repository_path)]
+            for future in futures:
+                downloaded += bool(future.result())
+        log.debug(f'Artifactory - {downloaded}/{len(futures)} files downloaded from {repository_path}')
+        return downloaded
+
+    @staticmethod
+    def _local_matches(target, entry: Dict) -> bool:
+        if not os.path.isfile(target) or not entry.get("sha256"):
+            return False
+        if entry.get("size") is not None and os.path.getsize(target) != entry["size"]:
+            return False
+        hasher = hashlib.sha256()
+        with open(target, "rb") as f:
+            for chunk in iter(lambda: f.read(DOWNLOAD_CHUNK_SIZE), b""):
+                hasher.update(chunk)
+        return hasher.hexdigest() == entry["sha256"]
+
+    def download_file(self, repository_path, entry: Dict, target) -> bool:
+        """
+        Stream one file to target, hashing it on the way; the checksums come
+        from the listing or the X-Checksum-* response headers. The file only
+        replaces target once verified. False if target was already current.
+        """
+        if os.path.isfile(target) and not entry.get("sha256"):
+            # Walked listings carry no checksums: a HEAD is cheaper than a refetch
+            head = self.session().head(self._url(str(repository_path), entry["path"]))
+            if head.status_code == 200:
+                entry = dict(entry, sha256=head.headers.get("X-Checksum-Sha256"))
+        if self._local_matches(target, entry):
+            return False
+        ensure_target_exists(target)
+        tmp = f"{target}.part"
+        response = self.session().get(self._url(str(repository_path), entry["path"]), stream=True)
+        try:
+            response.raise_for_status()
+            expected_sha256 = entry.get("sha256") or response.headers.get("X-Checksum-Sha256")
+            expected_sha1 = entry.get("sha1") or response.headers.get("X-Checksum-Sha1")
+            sha256, sha1 = hashlib.sha256(), hashlib.sha1()
+            with open(tmp, "wb") as out:
+                for chunk in response.iter_content(DOWNLOAD_CHUNK_SIZE):
+                    sha256.update(chunk)
+                    sha1.update(chunk)
+                    out.write(chunk)
+        finally:
+            response.close()
+        if (expected_sha256 and sha256.hexdigest() != expected_sha256) or \
+                (not expected_sha256 and expected_sha1 and sha1.hexdigest() != expected_sha1):
+            os.unlink(tmp)
+            raise ChecksumMismatch(f"Checksum mismatch for {repository_path}/{entry['path']}")
+        os.replace(tmp, target)
+        log.debug(f'Artifactory - Stored {repository_path}/{entry["path"]} to {target}')
+        return True
+
     @staticmethod
     def store_single_file(p, target):
         """
@@ -77,7 +249,17 @@ class ArtifactoryHandler:
         :return: None
         """
         ensure_target_exists(target)
-        log.debug(f'Artifactory - Storing file: {p} to {target}, metadata: {p.stat()}')
+        stat = p.stat()
+        log.debug(f'Artifactory - Storing file: {p} to {target}, metadata: {stat}')
+        hasher = hashlib.sha256()
+        written = 0
         with p.open() as fd:
             with open(target, "wb") as out:
-                return out.write(fd.read()) > 0
\ No newline at end of file
+                for chunk in iter(lambda: fd.read(DOWNLOAD_CHUNK_SIZE), b""):
+                    hasher.update(chunk)
+                    written += out.write(chunk)
+        expected = getattr(stat, "sha256", None)
+        if expected and hasher.hexdigest() != expected:
+            os.unlink(target)
+            raise ChecksumMismatch(f"Checksum mismatch for {p}")
+        return written > 0
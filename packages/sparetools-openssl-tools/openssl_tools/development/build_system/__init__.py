@@ -6,18 +6,65 @@ capabilities for OpenSSL development.
 
 Classes:
     BuildCacheManager: Build cache management and optimization
+    ContentAddressedStore: Deduplicated artifact objects with a remote tier
+    FileHasher: Parallel file hashing behind a persistent stat cache
     BuildOptimizer: Build optimization strategies and analysis
     BuildMatrixGenerator: Build matrix generation for CI/CD
+    ImpactGraph: Profile axes and configurations a diff's functions affect
     PerformanceAnalyzer: Build performance analysis and benchmarking
+    StatisticalBenchmarkRunner: Repeated, pinned benchmark trials with
+        baselines keyed by platform, CPU model, profile and OpenSSL version
+    InProcessCryptoDriver: ctypes libcrypto driver timing EVP operations in-process
+    PerfHistoryStore: Append-only SQLite history of benchmark samples
+    PerformanceGate: Benchmark regression gate for a freshly built package
+    BenchmarkCoverageMap: OpenSSL sources each benchmark case executes, for
+        selecting the cases a change can affect
+    BuildMatrixScheduler: Concurrent matrix builds sharing a core/RAM token pool
+    BuildTrace: Chrome trace export of build phases and Clang -ftime-trace data
+    CompilerShootout: One build per compiler profile, winners per algorithm class
+    SharedSourceBuilder: Out-of-tree variant builds from one pristine worktree per version
+    SSLCtxTuner: Benchmark-driven search for the host's best SSL_CTX settings
 """
 
 from .optimizer import BuildCacheManager, BuildOptimizer
+from .artifact_store import ContentAddressedStore, create_remote_backend
+from .file_hashing import FileHasher
 from .matrix_generator import BuildMatrixGenerator
+from .change_impact import ImpactGraph
 from .performance import PerformanceAnalyzer
+from .inprocess_driver import InProcessCryptoDriver
+from .statistical_runner import StatisticalBenchmarkRunner, BaselineStore, compare_samples
+from .perf_history import PerfHistoryStore, PerfBisector
+from .perf_gate import PerformanceGate
+from .perf_dashboard import PerfDashboard
+from .bench_selection import BenchmarkCoverageMap
+from .build_scheduler import BuildMatrixScheduler
+from .build_trace import BuildTrace
+from .compiler_shootout import CompilerShootout
+from .source_trees import SharedSourceBuilder
+from .sslctx_tuner import SSLCtxTuner
 
 __all__ = [
     "BuildCacheManager",
     "BuildOptimizer",
+    "ContentAddressedStore",
+    "create_remote_backend",
+    "FileHasher",
     "BuildMatrixGenerator", 
+    "ImpactGraph",
     "PerformanceAnalyzer",
+    "StatisticalBenchmarkRunner",
+    "BaselineStore",
+    "compare_samples",
+    "InProcessCryptoDriver",
+    "PerfHistoryStore",
+    "PerfBisector",
+    "PerformanceGate",
+    "PerfDashboard",
+    "BenchmarkCoverageMap",
+    "BuildMatrixScheduler",
+    "BuildTrace",
+    "CompilerShootout",
+    "SharedSourceBuilder",
+    "SSLCtxTuner",
 ]
\ No newline at end of file
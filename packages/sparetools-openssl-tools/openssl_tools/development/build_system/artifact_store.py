@@ -0,0 +1,362 @@
+#!/usr/bin/env python3
+"""
+OpenSSL Tools - Content-Addressed Artifact Store
+Deduplicated file storage for the build cache, with an optional remote tier.
+
+Every artifact file is stored once under objects/<aa>/<digest>, where the
+digest is the SHA-256 of its content (plus an ".x" suffix for executables,
+since hard links share permissions). A build is a manifest listing its
+relative paths, digests and symlinks. Headers, object files and docs that
+are identical between profiles or OpenSSL releases therefore take space
+once no matter how many builds reference them.
+
+Remote backends hold the same keys ("objects/<aa>/<digest>" and
+"manifests/<build_hash>.json") so CI runners can share hits:
+
+    s3://bucket/prefix            S3 (boto3, credentials from the environment)
+    https://host/artifactory/...  Artifactory generic repo or any HTTP store
+                                  accepting GET/HEAD/PUT
+    file:///mnt/shared-cache      Shared directory (NFS, etc.)
+"""
+
+import hashlib
+import json
+import logging
+import os
+import shutil
+import stat
+import urllib.error
+import urllib.request
+from abc import ABC, abstractmethod
+from pathlib import Path
+from typing import Dict, Iterable, List, Optional, Set
+
+logger = logging.getLogger(__name__)
+
+HASH_CHUNK_SIZE = 1024 * 1024
+
+
+def file_digest(path: Path) -> str:
+    """SHA-256 of a file's content"""
+    hasher = hashlib.sha256()
+    with open(path, "rb") as f:
+        for chunk in iter(lambda: f.read(HASH_CHUNK_SIZE), b""):
+            hasher.update(chunk)
+    return hasher.hexdigest()
+
+
+def object_key(digest: str) -> str:
+    return f"objects/{digest[:2]}/{digest}"
+
+
+def manifest_key(build_hash: str) -> str:
+    return f"manifests/{build_hash}.json"
+
+
+class RemoteCacheBackend(ABC):
+    """Remote tier of the artifact store, addressed by object/manifest keys"""
+
+    @abstractmethod
+    def has(self, key: str) -> bool:
+        """True if the key exists remotely"""
+
+    @abstractmethod
+    def get(self, key: str, dest: Path) -> bool:
+        """Download key to dest; False if it does not exist"""
+
+    @abstractmethod
+    def put(self, key: str, src: Path) -> None:
+        """Upload src under key"""
+
+
+class DirectoryCacheBackend(RemoteCacheBackend):
+    """Remote tier on a shared file system"""
+
+    def __init__(self, root: Path):
+        self.root = Path(root)
+
+    def has(self, key: str) -> bool:
+        return (self.root / key).exists()
+
+    def get(self, key: str, dest: Path) -> bool:
+        src = self.root / key
+        if not src.exists():
+            return False
+        shutil.copyfile(src, dest)
+        return True
+
+    def put(self, key: str, src: Path) -> None:
+        dest = self.root / key
+        dest.parent.mkdir(parents=True, exist_ok=True)
+        tmp = dest.with_name(f".{dest.name}.{os.getpid()}.tmp")
+        shutil.copyfile(src, tmp)
+        os.replace(tmp, dest)
+
+
+class HTTPCacheBackend(RemoteCacheBackend):
+    """
+    Plain HTTP store (GET/HEAD/PUT): Artifactory generic repositories,
+    Nexus raw repositories, nginx WebDAV, bazel-remote and similar.
+    Authentication via bearer token or API key header.
+    """
+
+    def __init__(self, base_url: str, token: Optional[str] = None,
+                 headers: Optional[Dict[str, str]] = None, timeout: float = 60.0):
+        self.base_url = base_url.rstrip("/")
+        self.headers = dict(headers or {})
+        if token:
+            self.headers.setdefault("Authorization", f"Bearer {token}")
+        self.timeout = timeout
+
+    def _request(self, method: str, key: str, data=None, length: Optional[int] = None):
+        request = urllib.request.Request(f"{self.base_url}/{key}", data=data, method=method,
+                                         headers=dict(self.headers))
+        if length is not None:
+            request.add_header("Content-Length", str(length))
+        return urllib.request.urlopen(request, timeout=self.timeout)
+
+    def has(self, key: str) -> bool:
+        try:
+            with self._request("HEAD", key):
+                return True
+        except urllib.error.HTTPError as e:
+            if e.code == 404:
+                return False
+            raise
+
+    def get(self, key: str, dest: Path) -> bool:
+        try:
+            with self._request("GET", key) as response, open(dest, "wb") as f:
+                shutil.copyfileobj(response, f, HASH_CHUNK_SIZE)
+            return True
+        except urllib.error.HTTPError as e:
+            if e.code == 404:
+                return False
+            raise
+
+    def put(self, key: str, src: Path) -> None:
+        with open(src, "rb") as f:
+            with self._request("PUT", key, data=f, length=src.stat().st_size):
+                pass
+
+
+class S3CacheBackend(RemoteCacheBackend):
+    """S3 or S3-compatible object storage (requires boto3)"""
+
+    def __init__(self, bucket: str, prefix: str = "", endpoint_url: Optional[str] = None):
+        try:
+            import boto3
+            from botocore.exceptions import ClientError
+        except ImportError as e:
+            raise RuntimeError("S3 cache backend requires boto3") from e
+        self._client_error = ClientError
+        self.client = boto3.client("s3", endpoint_url=endpoint_url or os.environ.get("AWS_ENDPOINT_URL"))
+        self.bucket = bucket
+        self.prefix = prefix.strip("/")
+
+    def _key(self, key: str) -> str:
+        return f"{self.prefix}/{key}" if self.prefix else key
+
+    def has(self, key: str) -> bool:
+        try:
+            self.client.head_object(Bucket=self.bucket, Key=self._key(key))
+            return True
+        except self._client_error as e:
+            if e.response.get("Error", {}).get("Code") in ("404", "NoSuchKey", "NotFound"):
+                return False
+            raise
+
+    def get(self, key: str, dest: Path) -> bool:
+        if not self.has(key):
+            return False
+        self.client.download_file(self.bucket, self._key(key), str(dest))
+        return True
+
+    def put(self, key: str, src: Path) -> None:
+        self.client.upload_file(str(src), self.bucket, self._key(key))
+
+
+def create_remote_backend(url: Optional[str]) -> Optional[RemoteCacheBackend]:
+    """Backend for an s3://, http(s)://, file:// URL or a plain directory path"""
+    if not url:
+        return None
+    if url.startswith("s3://"):
+        bucket, _, prefix = url[len("s3://"):].partition("/")
+        return S3CacheBackend(bucket, prefix)
+    if url.startswith(("http://", "https://")):
+        headers = {}
+        if os.environ.get("ARTIFACTORY_API_KEY"):
+            headers["X-JFrog-Art-Api"] = os.environ["ARTIFACTORY_API_KEY"]
+        return HTTPCacheBackend(url, token=os.environ.get("OPENSSL_BUILD_CACHE_TOKEN"), headers=headers)
+    if url.startswith("file://"):
+        url = url[len("file://"):]
+    return DirectoryCacheBackend(Path(url).expanduser())
+
+
+class ContentAddressedStore:
+    """Local object store plus build manifests, optionally backed by a remote"""
+
+    def __init__(self, root: Path, remote: Optional[RemoteCacheBackend] = None):
+        self.root = Path(root)
+        self.objects_dir = self.root / "objects"
+        self.manifests_dir = self.root / "manifests"
+        self.objects_dir.mkdir(parents=True, exist_ok=True)
+        self.manifests_dir.mkdir(parents=True, exist_ok=True)
+        self.remote = remote
+
+    # -- objects ------------------------------------------------------------
+
+    def object_path(self, key: str) -> Path:
+        return self.root / key
+
+    def _ingest(self, path: Path) -> str:
+        """Store one file, returning its object key"""
+        executable = bool(path.stat().st_mode & stat.S_IXUSR)
+        key = object_key(file_digest(path) + (".x" if executable else ""))
+        dest = self.object_path(key)
+        if not dest.exists():
+            dest.parent.mkdir(parents=True, exist_ok=True)
+            tmp = dest.with_name(f".{dest.name}.{os.getpid()}.tmp")
+            shutil.copyfile(path, tmp)
+            # Objects are shared through hard links; keep them read-only
+            os.chmod(tmp, 0o555 if executable else 0o444)
+            os.replace(tmp, dest)
+        return key
+
+    def _fetch_object(self, key: str) -> bool:
+        dest = self.object_path(key)
+        if dest.exists():
+            return True
+        if not self.remote:
+            return False
+        dest.parent.mkdir(parents=True, exist_ok=True)
+        tmp = dest.with_name(f".{dest.name}.{os.getpid()}.tmp")
+        if not self.remote.get(key, tmp):
+            return False
+        os.chmod(tmp, 0o555 if key.endswith(".x") else 0o444)
+        os.replace(tmp, dest)
+        return True
+
+    # -- manifests ----------------------------------------------------------
+
+    def _manifest_file(self, build_hash: str) -> Path:
+        return self.manifests_dir / f"{build_hash}.json"
+
+    def load_manifest(self, build_hash: str) -> Optional[Dict]:
+        path = self._manifest_file(build_hash)
+        if not path.exists() and self.remote:
+            try:
+                self.remote.get(manifest_key(build_hash), path)
+            except Exception as e:
+                logger.warning(f"⚠️ Remote cache unavailable: {e}")
+        if not path.exists():
+            return None
+        try:
+            return json.loads(path.read_text(encoding="utf-8"))
+        except (json.JSONDecodeError, OSError) as e:
+            logger.warning(f"⚠️ Corrupt manifest {path.name}: {e}")
+            return None
+
+    def has(self, build_hash: str) -> bool:
+        return self._manifest_file(build_hash).exists()
+
+    def put_tree(self, build_hash: str, source: Path) -> Dict:
+        """Ingest a directory tree; returns the manifest"""
+        source = Path(source)
+        files, links = [], []
+        for path in sorted(source.rglob("*")):
+            rel = path.relative_to(source).as_posix()
+            if path.is_symlink():
+                links.append({"path": rel, "target": os.readlink(path)})
+            elif path.is_file():
+                files.append({"path": rel, "key": self._ingest(path), "size": path.stat().st_size})
+        manifest = {"build_hash": build_hash, "files": files, "symlinks": links,
+                    "size_bytes": sum(f["size"] for f in files)}
+        path = self._manifest_file(build_hash)
+        tmp = path.with_name(f".{path.name}.tmp")
+        tmp.write_text(json.dumps(manifest, indent=1), encoding="utf-8")
+        os.replace(tmp, path)
+        return manifest
+
+    def push(self, build_hash: str, manifest: Optional[Dict] = None) -> int:
+        """Upload a build to the remote tier; returns the number of new objects sent"""
+        if not self.remote:
+            return 0
+        manifest = manifest or self.load_manifest(build_hash)
+        if not manifest:
+            return 0
+        sent = 0
+        for key in sorted({f["key"] for f in manifest["files"]}):
+            if not self.remote.has(key):
+                self.remote.put(key, self.object_path(key))
+                sent += 1
+        # Manifest last, so a remote hit always finds its objects
+        self.remote.put(manifest_key(build_hash), self._manifest_file(build_hash))
+        return sent
+
+    def materialize(self, build_hash: str, dest: Path) -> bool:
+        """Recreate a build tree at dest from hard links (copies across devices)"""
+        manifest = self.load_manifest(build_hash)
+        if not manifest:
+            return False
+        for entry in manifest["files"]:
+            if not self._fetch_object(entry["key"]):
+                logger.warning(f"⚠️ Missing object {entry['key']} for {build_hash[:8]}...")
+                return False
+
+        tmp = dest.with_name(f".{dest.name}.tmp")
+        if tmp.exists():
+            shutil.rmtree(tmp)
+        tmp.mkdir(parents=True)
+        for entry in manifest["files"]:
+            target = tmp / entry["path"]
+            target.parent.mkdir(parents=True, exist_ok=True)
+            try:
+                os.link(self.object_path(entry["key"]), target)
+            except OSError:
+                shutil.copy2(self.object_path(entry["key"]), target)
+        for entry in manifest["symlinks"]:
+            target = tmp / entry["path"]
+            target.parent.mkdir(parents=True, exist_ok=True)
+            os.symlink(entry["target"], target)
+        if dest.exists():
+            shutil.rmtree(dest)
+        os.replace(tmp, dest)
+        return True
+
+    def remove(self, build_hash: str) -> None:
+        self._manifest_file(build_hash).unlink(missing_ok=True)
+
+    # -- accounting ---------------------------------------------------------
+
+    def manifests(self) -> Iterable[Dict]:
+        for path in self.manifests_dir.glob("*.json"):
+            try:
+                yield json.loads(path.read_text(encoding="utf-8"))
+            except (json.JSONDecodeError, OSError):
+                continue
+
+    def referenced_keys(self) -> Set[str]:
+        return {f["key"] for m in self.manifests() for f in m.get("files", [])}
+
+    def _object_files(self) -> List[Path]:
+        return [p for p in self.objects_dir.glob("*/*") if not p.name.startswith(".")]
+
+    def stored_bytes(self) -> int:
+        """Disk used by unique objects"""
+        return sum(p.stat().st_size for p in self._object_files())
+
+    def logical_bytes(self) -> int:
+        """Size the builds would take as separate copies"""
+        return sum(m.get("size_bytes", 0) for m in self.manifests())
+
+    def garbage_collect(self) -> int:
+        """Delete objects no manifest references; returns bytes freed"""
+        referenced = self.referenced_keys()
+        freed = 0
+        for path in self._object_files():
+            key = path.relative_to(self.root).as_posix()
+            if key not in referenced:
+                freed += path.stat().st_size
+                path.unlink()
+        return freed
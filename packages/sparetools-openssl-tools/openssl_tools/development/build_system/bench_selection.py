@@ -0,0 +1,189 @@
+#!/usr/bin/env python3
+"""
+Coverage-guided benchmark selection
+
+A benchmark case only measures the OpenSSL code it executes, so a change
+to code that no case executes cannot move any benchmark. This module
+records, once per OpenSSL revision, which source files each test_package
+benchmark case covers (from lcov tracefiles captured against a
+--coverage build of OpenSSL) and, for a change, picks only the cases
+whose covered files it touches. A change to crypto/chacha then runs the
+bench_evp case, which drives ChaCha20-Poly1305, and skips the RSA
+handshakes.
+
+The map is written as JSON:
+
+    {"version": 1, "openssl_commit": "...", "created": "...",
+     "cases": {"bench_handshake-rsa": {"argv": [...], "files": [...]}}}
+
+with files relative to the OpenSSL source root. Selection is conservative
+where coverage says nothing:
+- documentation and tests select nothing;
+- headers and build configuration (Configure, build.info, perlasm
+  drivers) can change any object, so they select every case;
+- a file no case covers selects the cases covering its directory
+  (the parent for asm/ directories: perlasm output is not in lcov data,
+  but the C glue next to it is), and nothing when none does.
+"""
+
+import fnmatch
+import json
+import logging
+import os
+import subprocess
+from dataclasses import dataclass, field
+from datetime import datetime
+from pathlib import Path, PurePosixPath
+from typing import Dict, List, Optional
+
+from .benchmark_matrix import find_bench_binary
+from ...testing.quality_manager import lcov_covered_files
+
+logger = logging.getLogger(__name__)
+
+MAP_VERSION = 1
+DEFAULT_MAP = Path("test_results") / "benchmark-coverage.json"
+
+# Case name -> bench target and its arguments (always run with --quick
+# while mapping: coverage does not depend on the run length)
+DEFAULT_CASES: Dict[str, List[str]] = {
+    "bench_evp": ["bench_evp"],
+    "bench_handshake-ec": ["bench_handshake", "--cert", "EC"],
+    "bench_handshake-rsa": ["bench_handshake", "--cert", "RSA"],
+    "bench_handshake-mldsa": ["bench_handshake", "--cert", "ML-DSA-65"],
+    "bench_pqc": ["bench_pqc"],
+    "bench_fetch": ["bench_fetch"],
+    "bench_fips": ["bench_fips"],
+    "bench_threads": ["bench_threads"],
+    "bench_async": ["bench_async"],
+    "bench_quic": ["bench_quic"],
+    "bench_sesscache": ["bench_sesscache"],
+    "bench_ktls": ["bench_ktls"],
+    "bench_startup": ["bench_startup"],
+}
+
+IGNORED_PATTERNS = ["doc/*", "test/*", "fuzz/*", "demos/*", ".github/*", "*.md", "*.pod",
+                    "CHANGES*", "NEWS*", "README*", "AUTHORS*", "LICENSE*"]
+GLOBAL_PATTERNS = ["*.h", "*.h.in", "Configure", "config", "Configurations/*", "*build.info",
+                   "util/perl/*", "*.pm", "providers/common/der/*"]
+
+
+@dataclass
+class Selection:
+    """Cases to run for a change, with the changed files that selected each"""
+    cases: List[str]
+    reasons: Dict[str, List[str]] = field(default_factory=dict)
+    run_all: bool = False
+
+    def to_dict(self) -> Dict:
+        return {"cases": self.cases, "run_all": self.run_all, "reasons": self.reasons}
+
+
+def _matches(path: str, patterns: List[str]) -> bool:
+    name = PurePosixPath(path).name
+    return any(fnmatch.fnmatch(path, p) or fnmatch.fnmatch(name, p) for p in patterns)
+
+
+def changed_files(source_dir: Path, base: str, head: str = "HEAD") -> List[str]:
+    """Files changed between the merge base of base and head, and head"""
+    result = subprocess.run(["git", "diff", "--name-only", f"{base}...{head}"], cwd=source_dir,
+                            capture_output=True, text=True)
+    if result.returncode != 0:
+        raise RuntimeError(f"git diff {base}...{head} failed: {result.stderr.strip()}")
+    return [line for line in result.stdout.splitlines() if line]
+
+
+class BenchmarkCoverageMap:
+    """Source files executed by each benchmark case"""
+
+    def __init__(self, cases: Optional[Dict[str, Dict]] = None, openssl_commit: str = "unknown",
+                 created: Optional[str] = None):
+        self.cases: Dict[str, Dict] = cases or {}
+        self.openssl_commit = openssl_commit
+        self.created = created or datetime.now().isoformat()
+
+    @classmethod
+    def load(cls, path: Path) -> "BenchmarkCoverageMap":
+        with open(path, 'r') as f:
+            data = json.load(f)
+        if data.get("version") != MAP_VERSION:
+            raise ValueError(f"{path}: unsupported coverage map version {data.get('version')}")
+        return cls(data["cases"], data.get("openssl_commit", "unknown"), data.get("created"))
+
+    def save(self, path: Path) -> Path:
+        path.parent.mkdir(parents=True, exist_ok=True)
+        with open(path, 'w') as f:
+            json.dump({"version": MAP_VERSION, "openssl_commit": self.openssl_commit,
+                       "created": self.created, "cases": self.cases}, f, indent=2, sort_keys=True)
+        return path
+
+    @classmethod
+    def capture(cls, openssl_build: Path, bench_build: Path, work_dir: Path,
+                cases: Optional[Dict[str, List[str]]] = None, source_dir: Optional[Path] = None,
+                env: Optional[Dict[str, str]] = None) -> "BenchmarkCoverageMap":
+        """
+        Run each case once against a --coverage OpenSSL build, capturing
+        the counters it produced with lcov. Counters are zeroed before each
+        case, so the cases must run one at a time.
+        """
+        source_dir = source_dir or openssl_build
+        work_dir.mkdir(parents=True, exist_ok=True)
+        captured: Dict[str, Dict] = {}
+        run_env = dict(os.environ, **(env or {}))
+
+        for name, argv in (cases or DEFAULT_CASES).items():
+            binary = find_bench_binary(bench_build, argv[0])
+            if binary is None:
+                logger.info(f"⏭️ {name}: {argv[0]} not built, skipped")
+                continue
+            subprocess.run(["lcov", "--zerocounters", "--directory", str(openssl_build), "--quiet"],
+                           check=True, capture_output=True)
+            # Common options first, then the bench-specific ones
+            run = subprocess.run([str(binary), "--quick", "--json", str(work_dir / f"{name}.json"), *argv[1:]],
+                                 cwd=work_dir, env=run_env, capture_output=True, text=True)
+            if run.returncode != 0:
+                logger.warning(f"⚠️ {name}: benchmark exited {run.returncode}, coverage may be partial")
+            tracefile = work_dir / f"{name}.info"
+            subprocess.run(["lcov", "--capture", "--directory", str(openssl_build),
+                            "--base-directory", str(source_dir), "--output-file", str(tracefile),
+                            "--quiet", "--ignore-errors", "source"], check=True, capture_output=True)
+            files = lcov_covered_files(tracefile, source_dir)
+            captured[name] = {"argv": argv, "files": files}
+            logger.info(f"📊 {name}: {len(files)} source files covered")
+
+        return cls(captured, openssl_commit=_git_head(source_dir))
+
+    def files_by_case(self) -> Dict[str, set]:
+        return {name: set(case["files"]) for name, case in self.cases.items()}
+
+    def select(self, changed: List[str]) -> Selection:
+        """Cases whose covered files a change touches (see module docstring)"""
+        by_case = self.files_by_case()
+        reasons: Dict[str, List[str]] = {}
+
+        def pick(names, path):
+            for case in names:
+                reasons.setdefault(case, []).append(path)
+
+        for path in changed:
+            if _matches(path, IGNORED_PATTERNS):
+                continue
+            if _matches(path, GLOBAL_PATTERNS) or (path.endswith(".pl") and "/asm/" not in path):
+                return Selection(sorted(by_case), {case: [path] for case in sorted(by_case)}, run_all=True)
+            direct = [case for case, files in by_case.items() if path in files]
+            if direct:
+                pick(direct, path)
+                continue
+            directory = PurePosixPath(path).parent
+            if directory.name == "asm":
+                directory = directory.parent
+            prefix = f"{directory.as_posix()}/" if directory.as_posix() != "." else ""
+            pick([case for case, files in by_case.items()
+                  if any(f.startswith(prefix) for f in files)] if prefix else [], path)
+
+        return Selection(sorted(reasons), {case: sorted(paths) for case, paths in reasons.items()})
+
+
+def _git_head(source_dir: Path) -> str:
+    result = subprocess.run(["git", "rev-parse", "HEAD"], cwd=source_dir, capture_output=True, text=True)
+    return result.stdout.strip() if result.returncode == 0 else "unknown"
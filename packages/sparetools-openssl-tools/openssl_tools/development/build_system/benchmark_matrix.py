@@ -0,0 +1,358 @@
+#!/usr/bin/env python3
+"""
+Benchmark comparison matrix across build methods and OpenSSL versions
+
+Combines the variant and openssl_release axes from profiles/axes.yaml with
+SIMD feature profiles (profiles/features/assembly-*), runs the native
+test_package benchmarks against each combination and writes one Markdown
+and JSON comparison with speed-ups relative to a reference cell.
+
+Each cell's OpenSSL comes from one of:
+- an existing install under --install-root, laid out as
+  <release>/<variant>/install (the _Build/openssl-builds layout; the
+  "vanilla" and "python" directories are the perl and hybrid variants).
+  A prebuilt install cannot be rebuilt per SIMD profile, so the profile is
+  emulated by masking CPU capabilities (OPENSSL_ia32cap/OPENSSL_armcap),
+  which disables the same runtime code paths;
+- `conan create` of the sparetools-openssl recipe with the variant's
+  build_method and the SIMD feature profile (--build).
+
+Medians come from StatisticalBenchmarkRunner trials; a speed-up is marked
+significant using the same Mann-Whitney U / bootstrap test as baselines.
+"""
+
+import json
+import logging
+import platform
+import re
+import subprocess
+import yaml
+from dataclasses import dataclass, field, asdict
+from datetime import datetime
+from pathlib import Path
+from typing import Any, Dict, List, Optional, Tuple
+
+from .statistical_runner import StatisticalBenchmarkRunner, compare_samples
+
+logger = logging.getLogger(__name__)
+
+TOOLS_ROOT = Path(__file__).resolve().parents[3]
+DEFAULT_AXES_FILE = TOOLS_ROOT / "openssl_tools" / "profiles" / "axes.yaml"
+DEFAULT_FEATURES_DIR = TOOLS_ROOT / "profiles" / "features"
+
+# Axis variant label -> sparetools-openssl build_method option
+VARIANT_BUILD_METHODS = {
+    "perl": "perl",
+    "cmake": "cmake",
+    "autotools": "autotools",
+    "hybrid": "python",
+}
+
+# _Build/openssl-builds directory names -> variant label
+INSTALL_DIR_ALIASES = {
+    "vanilla": "perl",
+    "python": "hybrid",
+}
+
+IS_X86 = platform.machine().lower() in ("x86_64", "amd64", "i386", "i686", "x86")
+IS_ARM = platform.machine().lower() in ("aarch64", "arm64") or platform.machine().lower().startswith("arm")
+
+# SIMD feature profile -> capability mask emulating it on a prebuilt
+# install (same masks as bench_cpu_dispatch). None: not for this arch.
+SIMD_CAP_MASKS: Dict[str, Optional[Dict[str, str]]] = {
+    "assembly-optimized": {},
+    "assembly-avx2-only": {"OPENSSL_ia32cap": ":~0x600D0230000"} if IS_X86 else None,
+    "assembly-avx-only": {"OPENSSL_ia32cap": ":~0x600D02B0128"} if IS_X86 else None,
+    "assembly-neon": {"OPENSSL_armcap": "0x1"} if IS_ARM else None,
+    "assembly-sve2": {} if IS_ARM else None,
+    "assembly-minimal": ({"OPENSSL_ia32cap": "~0x1200020200000000:~0x600F02B0128"} if IS_X86
+                         else {"OPENSSL_armcap": "0x0"}),
+}
+
+DEFAULT_BENCHES = ["bench_evp", "bench_handshake"]
+
+# Metrics shown in the Markdown table (JSON always has all of them)
+DEFAULT_TABLE_FILTER = r"/16384/|handshakes_per_s"
+
+
+@dataclass
+class MatrixCell:
+    """One variant x release x SIMD profile combination"""
+    variant: str
+    release: str
+    simd: str
+    source: str = "missing"  # "install", "conan" or "missing"
+    prefix: Optional[str] = None
+    cap_env: Dict[str, str] = field(default_factory=dict)
+    skip_reason: Optional[str] = None
+    openssl_version: Optional[str] = None
+    samples: Dict[str, List[float]] = field(default_factory=dict)
+    higher_is_better: Dict[str, bool] = field(default_factory=dict)
+
+    @property
+    def id(self) -> str:
+        return f"{self.variant}-{self.release}-{self.simd}"
+
+
+def load_axes(axes_file: Path) -> Tuple[List[str], List[str]]:
+    """Variant and OpenSSL release labels from axes.yaml"""
+    with open(axes_file, 'r') as f:
+        axes = yaml.safe_load(f)["axes"]
+    variants = [v["label"] for v in axes["variant"]["values"]]
+    releases = [str(v["label"]) for v in axes["openssl_release"]["values"]]
+    return variants, releases
+
+
+def discover_installs(install_root: Path) -> Dict[Tuple[str, str], Path]:
+    """(release, variant) -> install prefix for <release>/<variant>/install"""
+    installs = {}
+    if not install_root.is_dir():
+        return installs
+    for prefix in sorted(install_root.glob("*/*/install")):
+        release, variant = prefix.parent.parent.name, prefix.parent.name
+        variant = INSTALL_DIR_ALIASES.get(variant, variant)
+        if (prefix / "include" / "openssl" / "opensslv.h").exists():
+            installs[(release, variant)] = prefix
+    return installs
+
+
+def build_benchmarks(test_package_dir: Path, prefix: Path, build_dir: Path, benches: List[str],
+                     cmake_args: Optional[List[str]] = None) -> Tuple[Optional[Path], Optional[str]]:
+    """
+    Configure test_package against the OpenSSL in `prefix` and build the
+    given bench targets. Returns (build_dir, None) or (None, first error line).
+    """
+    prefix = prefix.resolve()
+    configure = ["cmake", "-S", str(test_package_dir), "-B", str(build_dir),
+                 "-DCMAKE_BUILD_TYPE=Release", f"-DOPENSSL_ROOT_DIR={prefix}"] + (cmake_args or [])
+    # FindOpenSSL skips static-only prefixes unless asked for static libs
+    shared = [p for pattern in ("lib*/libcrypto.so*", "lib*/libcrypto*.dylib", "bin/libcrypto*.dll")
+              for p in prefix.glob(pattern)]
+    if not shared:
+        configure.append("-DOPENSSL_USE_STATIC_LIBS=TRUE")
+    build = ["cmake", "--build", str(build_dir), "--config", "Release", "--target"] + benches
+    for cmd in (configure, build):
+        result = subprocess.run(cmd, capture_output=True, text=True)
+        if result.returncode != 0:
+            output = (result.stderr + result.stdout).splitlines()
+            first_error = next((line for line in output if re.search(r"error|undefined", line, re.I)),
+                               output[-1] if output else "")
+            return None, first_error.strip()
+    return build_dir, None
+
+
+def find_bench_binary(build_dir: Path, bench: str) -> Optional[Path]:
+    """Single- or multi-config generator output of a bench target"""
+    return next((p for p in (build_dir / bench, build_dir / "Release" / f"{bench}.exe")
+                 if p.exists()), None)
+
+
+class BenchmarkMatrix:
+    """Builds benchmarks per matrix cell, runs them and compares the cells"""
+
+    def __init__(self, work_dir: Path, recipe_dir: Path, features_dir: Path = DEFAULT_FEATURES_DIR,
+                 benches: Optional[List[str]] = None, trials: int = 5, warmup: int = 1,
+                 cpus: Optional[List[int]] = None, quick: bool = False, build: bool = False,
+                 host_profile: str = "default", alpha: float = 0.01, min_effect_percent: float = 2.0):
+        self.work_dir = work_dir
+        self.work_dir.mkdir(parents=True, exist_ok=True)
+        self.recipe_dir = recipe_dir
+        self.test_package_dir = recipe_dir / "test_package"
+        self.features_dir = features_dir
+        self.benches = benches or DEFAULT_BENCHES
+        self.trials = trials
+        self.warmup = warmup
+        self.cpus = cpus
+        self.quick = quick
+        self.build = build
+        self.host_profile = host_profile
+        self.alpha = alpha
+        self.min_effect_percent = min_effect_percent
+
+    def plan(self, variants: List[str], releases: List[str], simd_profiles: List[str],
+             installs: Dict[Tuple[str, str], Path]) -> List[MatrixCell]:
+        """Resolve where each cell's OpenSSL comes from"""
+        cells = []
+        for release in releases:
+            for variant in variants:
+                for simd in simd_profiles:
+                    cell = MatrixCell(variant=variant, release=release, simd=simd)
+                    prefix = installs.get((release, variant))
+                    if prefix is not None:
+                        mask = SIMD_CAP_MASKS.get(simd)
+                        if mask is None:
+                            cell.skip_reason = f"{simd} cannot be emulated on {platform.machine()}"
+                        else:
+                            cell.source, cell.prefix, cell.cap_env = "install", str(prefix), mask
+                    elif self.build:
+                        cell.source = "conan"
+                    else:
+                        cell.skip_reason = "no install found (use --build to create it)"
+                    cells.append(cell)
+        return cells
+
+    def _conan_create(self, cell: MatrixCell) -> Optional[Path]:
+        """conan create the recipe for this cell, returning its package folder"""
+        profile = self.features_dir / cell.simd
+        if not profile.exists():
+            cell.skip_reason = f"feature profile {profile} not found"
+            return None
+        cmd = ["conan", "create", str(self.recipe_dir), "--version", cell.release,
+               "-o", f"sparetools-openssl/*:build_method={VARIANT_BUILD_METHODS.get(cell.variant, cell.variant)}",
+               "-pr:h", self.host_profile, "-pr:h", str(profile),
+               "-c", "tools.build:skip_test=True", "--build=missing", "--format=json"]
+        logger.info(f"🔨 Building {cell.id}: {' '.join(cmd)}")
+        result = subprocess.run(cmd, capture_output=True, text=True)
+        if result.returncode != 0:
+            cell.skip_reason = f"conan create failed: {result.stderr.strip().splitlines()[-1:]}"
+            return None
+        graph = json.loads(result.stdout)
+        for node in graph.get("graph", {}).get("nodes", {}).values():
+            if str(node.get("ref", "")).startswith("sparetools-openssl/") and node.get("package_folder"):
+                return Path(node["package_folder"])
+        cell.skip_reason = "package folder not found in conan output"
+        return None
+
+    def _build_benches(self, cell: MatrixCell) -> Optional[Path]:
+        """Configure test_package against the cell's OpenSSL and build the benches"""
+        build_dir, error = build_benchmarks(self.test_package_dir, Path(cell.prefix),
+                                            self.work_dir / "build" / cell.id, self.benches)
+        if error:
+            cell.skip_reason = f"benchmark build failed: {error}"
+        return build_dir
+
+    def _measure(self, cell: MatrixCell, build_dir: Path) -> None:
+        for bench in self.benches:
+            binary = find_bench_binary(build_dir, bench)
+            if binary is None:
+                logger.warning(f"⚠️ {bench} not built for {cell.id}")
+                continue
+            runner = StatisticalBenchmarkRunner(self.work_dir / "trials" / cell.id, trials=self.trials,
+                                                warmup=self.warmup, cpus=self.cpus, env=cell.cap_env)
+            trials = runner.run(binary, ["--quick"] if self.quick else [])
+            cell.openssl_version = trials.openssl_version
+            for metric_id, samples in trials.samples.items():
+                cell.samples[f"{bench}:{metric_id}"] = samples
+                cell.higher_is_better[f"{bench}:{metric_id}"] = trials.higher_is_better
+
+    def run(self, cells: List[MatrixCell]) -> List[MatrixCell]:
+        """Build (if needed) and benchmark every runnable cell, in order"""
+        for cell in cells:
+            if cell.skip_reason:
+                logger.info(f"⏭️ {cell.id}: {cell.skip_reason}")
+                continue
+            if cell.source == "conan":
+                prefix = self._conan_create(cell)
+                if prefix is None:
+                    logger.warning(f"⚠️ {cell.id}: {cell.skip_reason}")
+                    continue
+                cell.prefix = str(prefix)
+            build_dir = self._build_benches(cell)
+            if build_dir is None:
+                logger.warning(f"⚠️ {cell.id}: {cell.skip_reason}")
+                continue
+            try:
+                self._measure(cell, build_dir)
+            except (OSError, RuntimeError, ValueError, subprocess.TimeoutExpired) as e:
+                cell.skip_reason = f"benchmark failed: {e}"
+                logger.warning(f"⚠️ {cell.id}: {cell.skip_reason}")
+                continue
+            if cell.release not in (cell.openssl_version or ""):
+                cell.skip_reason = f"benchmarks ran against {cell.openssl_version}, not {cell.release}"
+                cell.samples.clear()
+                logger.warning(f"⚠️ {cell.id}: {cell.skip_reason}")
+                continue
+            logger.info(f"✅ {cell.id}: {len(cell.samples)} metrics ({cell.openssl_version})")
+        return cells
+
+    def compare(self, cells: List[MatrixCell], reference: Optional[str] = None) -> Dict[str, Any]:
+        """Per-metric medians and speed-ups of every measured cell vs the reference"""
+        cell_data = []
+        for c in cells:
+            data = asdict(c)
+            data.pop("samples")
+            data.pop("higher_is_better")
+            data["id"] = c.id
+            cell_data.append(data)
+
+        measured = [c for c in cells if c.samples]
+        if not measured:
+            return {"reference": None, "measured": [], "cells": cell_data, "metrics": {}}
+        ref = next((c for c in measured if c.id == reference), measured[0])
+        if reference and ref.id != reference:
+            logger.warning(f"⚠️ Reference {reference} not measured, using {ref.id}")
+
+        metrics: Dict[str, Dict[str, Any]] = {}
+        for metric_id in sorted(ref.samples):
+            higher = ref.higher_is_better[metric_id]
+            row = {}
+            for cell in measured:
+                samples = cell.samples.get(metric_id)
+                if not samples:
+                    continue
+                comparison = compare_samples(metric_id, samples, ref.samples[metric_id], higher,
+                                             self.alpha, self.min_effect_percent)
+                base, cur = comparison.baseline_median, comparison.current_median
+                speedup = (cur / base if higher else base / cur) if base and cur else 0.0
+                row[cell.id] = {
+                    "median": cur,
+                    "speedup": speedup,
+                    "significant": cell is not ref and comparison.verdict in ("regression", "improvement"),
+                    "p_value": comparison.p_value,
+                }
+            metrics[metric_id] = row
+
+        return {"reference": ref.id, "measured": [c.id for c in measured],
+                "cells": cell_data, "metrics": metrics}
+
+    def write_reports(self, comparison: Dict[str, Any], table_filter: str = DEFAULT_TABLE_FILTER) -> Tuple[Path, Path]:
+        """Write benchmark_matrix_<ts>.json and .md into the work directory"""
+        timestamp = datetime.now().strftime("%Y%m%d_%H%M%S")
+        json_path = self.work_dir / f"benchmark_matrix_{timestamp}.json"
+        md_path = self.work_dir / f"benchmark_matrix_{timestamp}.md"
+
+        report = {
+            "timestamp": datetime.now().isoformat(),
+            "platform": f"{platform.system().lower()}-{platform.machine().lower()}",
+            "trials": self.trials,
+            "quick": self.quick,
+            **comparison,
+        }
+        with open(json_path, 'w') as f:
+            json.dump(report, f, indent=2)
+
+        measured = comparison["measured"]
+        lines = [
+            "# OpenSSL Benchmark Matrix",
+            "",
+            f"Reference: `{comparison['reference']}`. Cells show the median and the speed-up "
+            f"vs the reference; `*` marks a significant difference (Mann-Whitney U, "
+            f"alpha={self.alpha}, {self.trials} trials).",
+            "",
+        ]
+        if measured:
+            lines.append("| Metric | " + " | ".join(measured) + " |")
+            lines.append("|---|" + "---:|" * len(measured))
+            pattern = re.compile(table_filter)
+            for metric_id, row in comparison["metrics"].items():
+                if not pattern.search(metric_id):
+                    continue
+                cells = []
+                for cell_id in measured:
+                    entry = row.get(cell_id)
+                    if entry is None:
+                        cells.append("-")
+                    elif cell_id == comparison["reference"]:
+                        cells.append(f"{entry['median']:.1f} (ref)")
+                    else:
+                        mark = "*" if entry["significant"] else ""
+                        cells.append(f"{entry['median']:.1f} ({entry['speedup']:.2f}x{mark})")
+                lines.append(f"| {metric_id} | " + " | ".join(cells) + " |")
+        skipped = [c for c in comparison["cells"] if c["skip_reason"]]
+        if skipped:
+            lines += ["", "## Skipped", ""]
+            lines += [f"- `{c['id']}`: {c['skip_reason']}" for c in skipped]
+        with open(md_path, 'w') as f:
+            f.write("\n".join(lines) + "\n")
+
+        return json_path, md_path
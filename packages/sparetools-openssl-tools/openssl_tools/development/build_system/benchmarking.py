@@ -18,6 +18,15 @@ from datetime import datetime
 import argparse
 import yaml
 
+try:
+    from .statistical_runner import (StatisticalBenchmarkRunner, compare_samples,
+                                     detect_cpu_model, detect_numa_topology, _parse_cpus, _positive_int)
+    from .inprocess_driver import InProcessCryptoDriver
+except ImportError:  # run as a script
+    from statistical_runner import (StatisticalBenchmarkRunner, compare_samples,
+                                    detect_cpu_model, detect_numa_topology, _parse_cpus, _positive_int)
+    from inprocess_driver import InProcessCryptoDriver
+
 # Configure logging
 logging.basicConfig(
     level=logging.INFO,
@@ -41,33 +50,69 @@ class BenchmarkResult:
     platform: str
     timestamp: str
     metadata: Dict[str, Any] = field(default_factory=dict)
+    # Median hardware counters across trials (cycles, instructions, ipc,
+    # l1d_misses, llc_misses, branch_misses, itlb_misses, cycles_per_op,
+    # itlb_misses_per_op); empty when not collected or unavailable on the host
+    perf_counters: Dict[str, float] = field(default_factory=dict)
+
+# Hardware counter fields written by bench_perf.h
+PERF_COUNTER_FIELDS = ["cycles", "instructions", "ipc", "l1d_misses", "llc_misses",
+                       "branch_misses", "itlb_misses", "cycles_per_op", "itlb_misses_per_op"]
 
 @dataclass
 class PerformanceBaseline:
-    """Performance baseline data class"""
+    """
+    Performance baseline: raw trial samples for one measurement, valid only
+    for the (platform, cpu_model, profile, version) it was recorded on.
+    """
     name: str
     algorithm: str
     key_size: int
-    expected_avg_time: float
-    expected_throughput: float
-    tolerance_percent: float
     platform: str
     version: str
     timestamp: str
+    cpu_model: str = "unknown"
+    profile: str = "default"
+    samples: List[float] = field(default_factory=list)
+    higher_is_better: bool = False
+    expected_avg_time: float = 0.0
+    expected_throughput: float = 0.0
+    tolerance_percent: Optional[float] = None  # Legacy files only, ignored
 
 class OpenSSLPerformanceBenchmark:
     """OpenSSL performance benchmarking with baseline comparison"""
     
-    def __init__(self, results_dir: Path, baseline_file: Optional[Path] = None):
+    def __init__(self, results_dir: Path, baseline_file: Optional[Path] = None,
+                 profile: str = "default", alpha: float = 0.01, min_effect_percent: float = 2.0,
+                 libcrypto: Optional[str] = None):
         self.results_dir = results_dir
         self.results_dir.mkdir(parents=True, exist_ok=True)
         
+        # Baseline key: results only compare within the same
+        # (platform, CPU model, profile, OpenSSL version)
+        self.platform = self._detect_platform()
+        self.cpu_model = detect_cpu_model()
+        self.profile = profile
+        self.openssl_version = self._detect_openssl_version()
+        # Recorded with every result: on multi-socket hosts numbers depend
+        # on the node layout, so histories from different hosts must match it
+        self.topology = detect_numa_topology()
+        
+        # In-process driver; None falls back to openssl subprocesses
+        try:
+            self.driver = InProcessCryptoDriver(libcrypto)
+            logger.info(f"⚡ In-process driver: {self.driver.version} ({self.driver.library_path})")
+        except (OSError, AttributeError) as e:
+            logger.warning(f"⚠️ In-process driver unavailable ({e}), using openssl subprocesses")
+            self.driver = None
+        
+        # Significance level and smallest reported change (percent)
+        self.alpha = alpha
+        self.min_effect_percent = min_effect_percent
+        
         # Load baselines
         self.baselines = self._load_baselines(baseline_file)
         
-        # Platform detection
-        self.platform = self._detect_platform()
-        
         # Benchmark configurations
         self.benchmark_configs = self._get_benchmark_configs()
         
@@ -80,8 +125,22 @@ class OpenSSLPerformanceBenchmark:
         arch = platform.machine().lower()
         return f"{system}-{arch}"
     
+    def _detect_openssl_version(self) -> str:
+        """Version string of the openssl binary on PATH"""
+        try:
+            result = subprocess.run(["openssl", "version"], capture_output=True, text=True, timeout=10)
+            if result.returncode == 0:
+                return result.stdout.strip()
+        except (OSError, subprocess.TimeoutExpired):
+            pass
+        return "unknown"
+    
     def _load_baselines(self, baseline_file: Optional[Path]) -> Dict[str, PerformanceBaseline]:
-        """Load performance baselines"""
+        """
+        Load performance baselines. There are no built-in defaults: numbers
+        from another machine, profile or OpenSSL release are not comparable,
+        so baselines must be recorded on the target with --save-baseline.
+        """
         baselines = {}
         
         if baseline_file and baseline_file.exists():
@@ -89,44 +148,11 @@ class OpenSSLPerformanceBenchmark:
                 baseline_data = json.load(f)
             
             for baseline_info in baseline_data.get("baselines", []):
-                key = f"{baseline_info['algorithm']}_{baseline_info['key_size']}"
-                baselines[key] = PerformanceBaseline(**baseline_info)
+                baselines[baseline_info["name"]] = PerformanceBaseline(**baseline_info)
             
             logger.info(f"📊 Loaded {len(baselines)} performance baselines")
         else:
-            # Create default baselines
-            baselines = self._create_default_baselines()
-            logger.info("📊 Using default performance baselines")
-        
-        return baselines
-    
-    def _create_default_baselines(self) -> Dict[str, PerformanceBaseline]:
-        """Create default performance baselines"""
-        baselines = {}
-        
-        # Default baselines for common algorithms
-        default_configs = [
-            {"algorithm": "rsa", "key_size": 2048, "expected_avg_time": 0.1, "expected_throughput": 10.0},
-            {"algorithm": "rsa", "key_size": 4096, "expected_avg_time": 0.5, "expected_throughput": 2.0},
-            {"algorithm": "aes-128-cbc", "key_size": 128, "expected_avg_time": 0.01, "expected_throughput": 100.0},
-            {"algorithm": "aes-256-cbc", "key_size": 256, "expected_avg_time": 0.02, "expected_throughput": 50.0},
-            {"algorithm": "sha256", "key_size": 256, "expected_avg_time": 0.005, "expected_throughput": 200.0},
-            {"algorithm": "sha512", "key_size": 512, "expected_avg_time": 0.01, "expected_throughput": 100.0},
-        ]
-        
-        for config in default_configs:
-            key = f"{config['algorithm']}_{config['key_size']}"
-            baselines[key] = PerformanceBaseline(
-                name=f"{config['algorithm']}_{config['key_size']}",
-                algorithm=config["algorithm"],
-                key_size=config["key_size"],
-                expected_avg_time=config["expected_avg_time"],
-                expected_throughput=config["expected_throughput"],
-                tolerance_percent=20.0,  # 20% tolerance
-                platform=self.platform,
-                version="3.5.0",
-                timestamp=datetime.now().isoformat()
-            )
+            logger.info("📊 No baseline file, results will be reported without comparison")
         
         return baselines
     
@@ -225,52 +251,280 @@ class OpenSSLPerformanceBenchmark:
         
         return times
     
+    def _run_inprocess_benchmark(self, algorithm: str, key_size: int, iterations: int) -> List[float]:
+        """Time the operation in-process through libcrypto (crypto work only)"""
+        logger.info(f"⚡ Running in-process benchmark: {algorithm} {key_size} bits ({iterations} iterations)")
+        
+        try:
+            return self.driver.time_operation(algorithm, key_size, iterations)
+        except (RuntimeError, ValueError) as e:
+            logger.warning(f"⚠️ In-process benchmark failed: {e}")
+            return []
+    
     def _run_custom_benchmark(self, algorithm: str, key_size: int, iterations: int) -> List[float]:
-        """Run custom benchmark for algorithms not well supported by openssl speed"""
+        """
+        Run custom benchmark for algorithms not well supported by openssl speed.
+        Used only without the in-process driver: each iteration is a new
+        openssl process, so timings include process startup.
+        """
         logger.info(f"🔧 Running custom benchmark: {algorithm} {key_size} bits")
         
         times = []
         
         try:
             for i in range(iterations):
-                start_time = time.time()
-                
                 if algorithm.startswith("rsa"):
                     # RSA key generation benchmark
                     cmd = ["openssl", "genrsa", str(key_size)]
-                    result = subprocess.run(cmd, capture_output=True, text=True, timeout=30)
-                    
                 elif algorithm.startswith("aes"):
                     # AES encryption benchmark
                     cmd = ["openssl", "enc", "-aes-256-cbc", "-in", "/dev/zero", "-out", "/dev/null", "-pass", "pass:test"]
-                    result = subprocess.run(cmd, capture_output=True, text=True, timeout=30)
-                    
                 elif algorithm.startswith("sha"):
                     # Hash benchmark
                     cmd = ["openssl", "dgst", f"-{algorithm}", "/dev/zero"]
-                    result = subprocess.run(cmd, capture_output=True, text=True, timeout=30)
+                else:
+                    logger.warning(f"⚠️ No custom benchmark for {algorithm}")
+                    break
                 
-                end_time = time.time()
+                start_time = time.perf_counter()
+                result = subprocess.run(cmd, capture_output=True, text=True, timeout=30)
+                end_time = time.perf_counter()
                 
                 if result.returncode == 0:
                     times.append(end_time - start_time)
                 else:
                     logger.warning(f"⚠️ Custom benchmark iteration {i} failed")
                 
-                # Small delay to avoid overwhelming the system
-                time.sleep(0.01)
-                
         except Exception as e:
             logger.error(f"❌ Custom benchmark error: {e}")
         
         return times
     
+    def run_native_evp_benchmark(self, bench_binary: Path, quick: bool = False, trials: int = 10,
+                                 warmup: int = 1, cpus: Optional[List[int]] = None,
+                                 perf_counters: bool = False) -> List[BenchmarkResult]:
+        """Run the test_package bench_evp binary repeatedly and load its JSON reports
+
+        Unlike _run_openssl_speed_test this measures pre-fetched EVP objects
+        in-process, so results are comparable across build profiles
+        (e.g. assembly-optimized vs assembly-minimal). Each trial contributes
+        one throughput sample per algorithm and buffer size. With
+        perf_counters the binary also records hardware counters per case.
+        """
+        logger.info(f"⚡ Running native EVP benchmark: {bench_binary}")
+
+        runner = StatisticalBenchmarkRunner(self.results_dir, trials=trials, warmup=warmup, cpus=cpus)
+        try:
+            extra_args = (["--quick"] if quick else []) + (["--perf-counters"] if perf_counters else [])
+            trial_results = runner.run(bench_binary, extra_args)
+        except (OSError, RuntimeError, ValueError, subprocess.TimeoutExpired) as e:
+            logger.error(f"❌ Native EVP benchmark failed: {e}")
+            return []
+        self.openssl_version = trial_results.openssl_version
+
+        # Last trial's report supplies the per-record fields; counters are
+        # the median over all trials
+        reports = []
+        for i in range(trials):
+            with open(self.results_dir / f"{bench_binary.name}.trial{i}.json", 'r') as f:
+                reports.append(json.load(f))
+        report = reports[-1]
+        counters: Dict[Tuple[str, int], Dict[str, List[float]]] = {}
+        for trial_report in reports:
+            for record in trial_report.get("results", []):
+                key = (record["algorithm"], record["buffer_size"])
+                for name in PERF_COUNTER_FIELDS:
+                    if name in record:
+                        counters.setdefault(key, {}).setdefault(name, []).append(float(record[name]))
+
+        results = []
+        for record in report.get("results", []):
+            buffer_size = record["buffer_size"]
+            iterations = record["iterations"]
+            samples = trial_results.samples[f"{record['algorithm']}/{buffer_size}/mb_per_s"]
+            mb_per_s = statistics.median(samples)
+            # Per-operation time derived from throughput, so the usual
+            # avg/min/max fields stay meaningful for downstream reports
+            op_time = buffer_size / (mb_per_s * 1e6) if mb_per_s > 0 else 0.0
+            results.append(BenchmarkResult(
+                name=f"{record['algorithm']}_{buffer_size}",
+                algorithm=record["algorithm"].lower(),
+                key_size=0,
+                iterations=iterations,
+                total_time=op_time * iterations,
+                avg_time=op_time,
+                min_time=op_time,
+                max_time=op_time,
+                median_time=op_time,
+                throughput=mb_per_s,
+                platform=self.platform,
+                timestamp=datetime.now().isoformat(),
+                metadata={
+                    "source": "bench_evp",
+                    "samples": samples,
+                    "higher_is_better": True,
+                    "type": record["type"],
+                    "buffer_size": buffer_size,
+                    "throughput_unit": "MB/s",
+                    "openssl_version": report.get("openssl_version"),
+                    "numa_topology": trial_results.topology,
+                },
+                perf_counters={name: statistics.median(values) for name, values
+                               in counters.get((record["algorithm"], buffer_size), {}).items()}
+            ))
+
+        logger.info(f"✅ Loaded {len(results)} native EVP measurements")
+        return results
+
+    def run_native_numa_benchmark(self, bench_binary: Path, quick: bool = False, trials: int = 10,
+                                  warmup: int = 1) -> List[BenchmarkResult]:
+        """Run the test_package bench_threads binary in --numa mode
+
+        One result per workload and (CPU node, memory node) pair: threads
+        run on the CPU node with their contexts and buffers on the memory
+        node, so the local rows are the per-node numbers and the rest show
+        the cross-node penalty (vs_local). No --cpus pinning; the binary
+        places its own threads.
+        """
+        logger.info(f"⚡ Running native NUMA benchmark: {bench_binary}")
+
+        runner = StatisticalBenchmarkRunner(self.results_dir, trials=trials, warmup=warmup)
+        try:
+            trial_results = runner.run(bench_binary, (["--quick"] if quick else []) + ["--numa"])
+        except (OSError, RuntimeError, ValueError, subprocess.TimeoutExpired) as e:
+            logger.error(f"❌ Native NUMA benchmark failed: {e}")
+            return []
+        if trial_results.benchmark != "threads_numa":
+            logger.error(f"❌ {bench_binary.name} is not bench_threads ({trial_results.benchmark})")
+            return []
+        self.openssl_version = trial_results.openssl_version
+
+        with open(self.results_dir / f"{bench_binary.name}.trial{trials - 1}.json", 'r') as f:
+            report = json.load(f)
+        records = [r for r in report.get("results", []) if "cpu_node" in r]
+        local = {}
+        for record in records:
+            samples = trial_results.samples[f"{record['workload']}/{record['cpu_node']}/{record['mem_node']}/ops_per_s"]
+            if record["cpu_node"] == record["mem_node"]:
+                local[(record["workload"], record["cpu_node"])] = statistics.median(samples)
+
+        results = []
+        for record in records:
+            samples = trial_results.samples[f"{record['workload']}/{record['cpu_node']}/{record['mem_node']}/ops_per_s"]
+            ops_per_s = statistics.median(samples)
+            local_ops = local.get((record["workload"], record["cpu_node"]))
+            op_time = record["threads"] / ops_per_s if ops_per_s > 0 else 0.0
+            results.append(BenchmarkResult(
+                name=f"{record['workload']}_cpu{record['cpu_node']}_mem{record['mem_node']}",
+                algorithm=record["workload"],
+                key_size=0,
+                iterations=len(samples),
+                total_time=op_time * len(samples),
+                avg_time=op_time,
+                min_time=op_time,
+                max_time=op_time,
+                median_time=op_time,
+                throughput=ops_per_s,
+                platform=self.platform,
+                timestamp=datetime.now().isoformat(),
+                metadata={
+                    "source": "bench_threads_numa",
+                    "samples": samples,
+                    "higher_is_better": True,
+                    "cpu_node": record["cpu_node"],
+                    "mem_node": record["mem_node"],
+                    "threads": record["threads"],
+                    "distance": record["distance"],
+                    "local": record["cpu_node"] == record["mem_node"],
+                    "vs_local": ops_per_s / local_ops if local_ops else None,
+                    "throughput_unit": "ops/s",
+                    "openssl_version": report.get("openssl_version"),
+                    "numa_topology": trial_results.topology,
+                },
+            ))
+
+        logger.info(f"✅ Loaded {len(results)} native NUMA measurements "
+                    f"({trial_results.topology['signature']})")
+        return results
+
+    def run_native_replay_benchmark(self, bench_binary: Path, profile: Optional[Path] = None, quick: bool = False,
+                                    trials: int = 10, warmup: int = 1) -> List[BenchmarkResult]:
+        """Replay a traffic profile with the test_package bench_replay binary
+
+        profile is a JSON histogram of cipher suites, key types, groups,
+        record sizes, resumption ratio and connection lifetimes (see
+        test_package/replay_profiles/); None uses the binary's built-in mix.
+        One result for the whole mix (scope "total", time per connection)
+        plus one per handshake mode, suite, key type, group and record
+        size, each with its share of the replay time. Every trial replays
+        the same seeded connection plan.
+        """
+        logger.info(f"⚡ Running native traffic replay: {bench_binary} ({profile or 'built-in profile'})")
+
+        extra_args = (["--quick"] if quick else []) + (["--profile", str(profile)] if profile else [])
+        runner = StatisticalBenchmarkRunner(self.results_dir, trials=trials, warmup=warmup)
+        try:
+            trial_results = runner.run(bench_binary, extra_args)
+        except (OSError, RuntimeError, ValueError, subprocess.TimeoutExpired) as e:
+            logger.error(f"❌ Native traffic replay failed: {e}")
+            return []
+        if trial_results.benchmark != "replay":
+            logger.error(f"❌ {bench_binary.name} is not bench_replay ({trial_results.benchmark})")
+            return []
+        self.openssl_version = trial_results.openssl_version
+
+        with open(self.results_dir / f"{bench_binary.name}.trial{trials - 1}.json", 'r') as f:
+            report = json.load(f)
+
+        results = []
+        for record in report.get("results", []):
+            samples = trial_results.samples.get(f"{record['scope']}/{record['value']}/us")
+            if not samples:
+                continue
+            us = statistics.median(samples)
+            op_time = us / 1e6
+            metadata = {
+                "source": "bench_replay",
+                "samples": samples,
+                "higher_is_better": False,
+                "scope": record["scope"],
+                "per": record["per"],
+                "count": record["count"],
+                "throughput_unit": f"{record['per']}s/s",
+                "openssl_version": report.get("openssl_version"),
+            }
+            # Breakdown rows carry their share of the time, the total the whole mix
+            for field in ("cpu_share", "weight", "connections_per_sec", "cpu_us_per_connection",
+                          "handshake_share", "bulk_share", "resumption_ratio", "bulk_mb_per_sec", "seed"):
+                if field in record:
+                    metadata[field] = record[field]
+            results.append(BenchmarkResult(
+                name=f"replay_{record['scope']}_{record['value']}",
+                algorithm=record["value"],
+                key_size=0,
+                iterations=len(samples),
+                total_time=op_time * len(samples),
+                avg_time=op_time,
+                min_time=op_time,
+                max_time=op_time,
+                median_time=op_time,
+                throughput=1.0 / op_time if op_time > 0 else 0.0,
+                platform=self.platform,
+                timestamp=datetime.now().isoformat(),
+                metadata=metadata,
+            ))
+
+        logger.info(f"✅ Loaded {len(results)} traffic replay measurements")
+        return results
+
     def run_benchmark(self, algorithm: str, key_size: int, iterations: int) -> Optional[BenchmarkResult]:
         """Run benchmark for specific algorithm and key size"""
         logger.info(f"🚀 Starting benchmark: {algorithm} {key_size} bits")
         
-        # Try OpenSSL speed first
-        times = self._run_openssl_speed_test(algorithm, key_size, iterations)
+        # In-process first, then OpenSSL speed
+        times = self._run_inprocess_benchmark(algorithm, key_size, iterations) if self.driver else []
+        if not times:
+            times = self._run_openssl_speed_test(algorithm, key_size, iterations)
         
         # Fallback to custom benchmark if needed
         if not times:
@@ -304,8 +558,12 @@ class OpenSSLPerformanceBenchmark:
             platform=self.platform,
             timestamp=datetime.now().isoformat(),
             metadata={
+                "source": "inprocess" if self.driver else "openssl",
                 "raw_times": times,
-                "std_dev": statistics.stdev(times) if len(times) > 1 else 0
+                "samples": times,
+                "higher_is_better": False,
+                "std_dev": statistics.stdev(times) if len(times) > 1 else 0,
+                "numa_topology": self.topology
             }
         )
         
@@ -334,40 +592,52 @@ class OpenSSLPerformanceBenchmark:
         return results
     
     def compare_with_baseline(self, result: BenchmarkResult) -> Dict[str, Any]:
-        """Compare benchmark result with baseline"""
-        key = f"{result.algorithm}_{result.key_size}"
-        baseline = self.baselines.get(key)
+        """
+        Compare a result's samples with its baseline using a Mann-Whitney U
+        test and a bootstrap CI of the median change (see statistical_runner).
+        """
+        baseline = self.baselines.get(result.name)
         
         if not baseline:
             return {
                 "has_baseline": False,
-                "message": f"No baseline found for {key}"
+                "message": f"No baseline found for {result.name}"
             }
         
-        # Calculate performance difference
-        time_diff_percent = ((result.avg_time - baseline.expected_avg_time) / 
-                           baseline.expected_avg_time) * 100
-        
-        throughput_diff_percent = ((result.throughput - baseline.expected_throughput) / 
-                                 baseline.expected_throughput) * 100
+        key = (self.platform, self.cpu_model, self.profile,
+               result.metadata.get("openssl_version") or self.openssl_version)
+        baseline_key = (baseline.platform, baseline.cpu_model, baseline.profile, baseline.version)
+        if key != baseline_key:
+            return {
+                "has_baseline": False,
+                "message": f"Baseline for {result.name} was recorded on {baseline_key}, not {key}"
+            }
         
-        # Check if within tolerance
-        time_within_tolerance = abs(time_diff_percent) <= baseline.tolerance_percent
-        throughput_within_tolerance = abs(throughput_diff_percent) <= baseline.tolerance_percent
+        samples = result.metadata.get("samples", [])
+        if len(samples) < 2 or len(baseline.samples) < 2:
+            return {
+                "has_baseline": False,
+                "message": f"Baseline or result for {result.name} has too few samples; "
+                           f"re-record with --save-baseline"
+            }
         
-        overall_pass = time_within_tolerance and throughput_within_tolerance
+        comparison = compare_samples(result.name, samples, baseline.samples,
+                                     higher_is_better=baseline.higher_is_better,
+                                     alpha=self.alpha, min_effect_percent=self.min_effect_percent)
         
         return {
             "has_baseline": True,
             "baseline_name": baseline.name,
-            "time_diff_percent": time_diff_percent,
-            "throughput_diff_percent": throughput_diff_percent,
-            "time_within_tolerance": time_within_tolerance,
-            "throughput_within_tolerance": throughput_within_tolerance,
-            "overall_pass": overall_pass,
-            "tolerance_percent": baseline.tolerance_percent,
-            "baseline_avg_time": baseline.expected_avg_time,
-            "baseline_throughput": baseline.expected_throughput
+            "verdict": comparison.verdict,
+            "change_percent": comparison.change_percent,
+            "ci_low_percent": comparison.ci_low_percent,
+            "ci_high_percent": comparison.ci_high_percent,
+            "p_value": comparison.p_value,
+            "overall_pass": comparison.verdict != "regression",
+            "current_median": comparison.current_median,
+            "baseline_median": comparison.baseline_median,
+            "alpha": self.alpha,
+            "min_effect_percent": self.min_effect_percent
         }
     
     def generate_report(self, results: List[BenchmarkResult]) -> Path:
@@ -381,12 +651,14 @@ class OpenSSLPerformanceBenchmark:
         report_data = {
             "timestamp": datetime.now().isoformat(),
             "platform": self.platform,
+            "numa_topology": self.topology,
             "total_benchmarks": len(results),
             "benchmarks": [],
             "summary": {
                 "passed_baselines": 0,
                 "failed_baselines": 0,
-                "no_baseline": 0
+                "no_baseline": 0,
+                "with_perf_counters": 0
             }
         }
         
@@ -408,12 +680,15 @@ class OpenSSLPerformanceBenchmark:
                 "platform": result.platform,
                 "timestamp": result.timestamp,
                 "baseline_comparison": comparison,
+                "perf_counters": result.perf_counters,
                 "metadata": result.metadata
             }
             
             report_data["benchmarks"].append(benchmark_data)
             
             # Update summary
+            if result.perf_counters:
+                report_data["summary"]["with_perf_counters"] += 1
             if comparison["has_baseline"]:
                 if comparison["overall_pass"]:
                     report_data["summary"]["passed_baselines"] += 1
@@ -434,6 +709,8 @@ class OpenSSLPerformanceBenchmark:
         logger.info(f"   ✅ Passed baselines: {summary['passed_baselines']}")
         logger.info(f"   ❌ Failed baselines: {summary['failed_baselines']}")
         logger.info(f"   ⚠️ No baseline: {summary['no_baseline']}")
+        if summary["with_perf_counters"]:
+            logger.info(f"   🔬 With hardware counters: {summary['with_perf_counters']}")
         
         return report_path
     
@@ -447,6 +724,8 @@ class OpenSSLPerformanceBenchmark:
         baseline_data = {
             "name": baseline_name,
             "platform": self.platform,
+            "cpu_model": self.cpu_model,
+            "profile": self.profile,
             "timestamp": datetime.now().isoformat(),
             "baselines": []
         }
@@ -458,9 +737,12 @@ class OpenSSLPerformanceBenchmark:
                 "key_size": result.key_size,
                 "expected_avg_time": result.avg_time,
                 "expected_throughput": result.throughput,
-                "tolerance_percent": 20.0,
+                "samples": result.metadata.get("samples", []),
+                "higher_is_better": result.metadata.get("higher_is_better", False),
                 "platform": self.platform,
-                "version": "3.5.0",
+                "cpu_model": self.cpu_model,
+                "profile": self.profile,
+                "version": result.metadata.get("openssl_version") or self.openssl_version,
                 "timestamp": result.timestamp
             }
             baseline_data["baselines"].append(baseline_info)
@@ -484,6 +766,32 @@ def main():
                        help="Specific key size to benchmark")
     parser.add_argument("--iterations", type=int, default=100,
                        help="Number of iterations")
+    parser.add_argument("--libcrypto",
+                       help="libcrypto for the in-process driver (default: search the system)")
+    parser.add_argument("--native-bench", type=Path,
+                       help="Path to the test_package bench_evp binary (replaces openssl speed)")
+    parser.add_argument("--native-numa", type=Path,
+                       help="Path to the test_package bench_threads binary, run per NUMA node pair")
+    parser.add_argument("--native-replay", type=Path,
+                       help="Path to the test_package bench_replay binary (traffic profile replay)")
+    parser.add_argument("--replay-profile", type=Path,
+                       help="JSON traffic profile for --native-replay (default: the built-in mix)")
+    parser.add_argument("--quick", action="store_true",
+                       help="Short native benchmark run (smoke test)")
+    parser.add_argument("--perf-counters", action="store_true",
+                       help="Record hardware counters in native benchmarks (Linux perf_event)")
+    parser.add_argument("--trials", type=_positive_int, default=10,
+                       help="Native benchmark trials (one sample per trial)")
+    parser.add_argument("--warmup", type=int, default=1,
+                       help="Discarded warm-up runs before the trials")
+    parser.add_argument("--cpus", type=_parse_cpus,
+                       help="Pin native benchmark runs to CPUs, e.g. 2,3 or 0-3")
+    parser.add_argument("--profile", default="default",
+                       help="Build profile name, part of the baseline key")
+    parser.add_argument("--alpha", type=float, default=0.01,
+                       help="Significance level for regression detection")
+    parser.add_argument("--min-effect", type=float, default=2.0,
+                       help="Smallest median change (%%) reported as a regression")
     parser.add_argument("--save-baseline", 
                        help="Save results as baseline with given name")
     parser.add_argument("--verbose", "-v", action="store_true",
@@ -495,10 +803,24 @@ def main():
         logging.getLogger().setLevel(logging.DEBUG)
     
     # Initialize benchmark
-    benchmark = OpenSSLPerformanceBenchmark(args.results_dir, args.baseline_file)
+    benchmark = OpenSSLPerformanceBenchmark(args.results_dir, args.baseline_file, profile=args.profile,
+                                            alpha=args.alpha, min_effect_percent=args.min_effect,
+                                            libcrypto=args.libcrypto)
     
     try:
-        if args.algorithm and args.key_size:
+        if args.native_replay:
+            results = benchmark.run_native_replay_benchmark(args.native_replay, args.replay_profile,
+                                                            quick=args.quick, trials=args.trials,
+                                                            warmup=args.warmup)
+        elif args.native_numa:
+            results = benchmark.run_native_numa_benchmark(args.native_numa, quick=args.quick,
+                                                          trials=args.trials, warmup=args.warmup)
+        elif args.native_bench:
+            results = benchmark.run_native_evp_benchmark(args.native_bench, quick=args.quick,
+                                                         trials=args.trials, warmup=args.warmup,
+                                                         cpus=args.cpus,
+                                                         perf_counters=args.perf_counters)
+        elif args.algorithm and args.key_size:
             # Run specific benchmark
             result = benchmark.run_benchmark(args.algorithm, args.key_size, args.iterations)
             if result:
@@ -0,0 +1,344 @@
+#!/usr/bin/env python3
+"""
+Per-revision binary size and symbol bloat of libcrypto/libssl
+
+Text size growth costs startup time (more pages to fault in and relocate)
+and iTLB reach, and nothing fails when it happens. Every package revision
+therefore gets a size run in the PerfHistoryStore, as benchmark
+"binsize" with one sample per metric (bytes, lower is better):
+
+    libcrypto/total/loaded/bytes       loaded sections (code + data)
+    libcrypto/section/.text/bytes      per section (.text.* counted as .text)
+    libcrypto/symbol/<name>/bytes      symbols of at least MIN_SYMBOL_BYTES,
+    libcrypto/symbol/[other]/bytes     the rest summed
+    libcrypto/cu/<source>/bytes        per compile unit
+
+Compile units come from bloaty (`-d compileunits`) when it is on PATH,
+otherwise from DWARF: .debug_aranges code ranges summed per unit named in
+.debug_info, which leaves out data. A static libcrypto.a needs neither,
+its members are the compile units. Without debug info there is no
+compile-unit attribution (e.g. split_debug packages, whose .debug files
+are not read).
+
+A run is compared with the latest earlier run of another revision for
+the same profile and platform. Totals and sections are flagged when they
+grow by at least threshold_percent, symbols and compile units when they
+grow (or appear) by at least min_bytes.
+"""
+
+import logging
+import re
+import shutil
+import subprocess
+from dataclasses import asdict, dataclass, field
+from pathlib import Path
+from typing import Any, Dict, List, Optional, Tuple
+
+from .perf_history import PerfHistoryStore
+from .statistical_runner import TrialResults
+
+logger = logging.getLogger(__name__)
+
+BENCHMARK = "binsize"
+LIBRARIES = ("libcrypto", "libssl")
+# Smaller symbols are summed into [other]
+MIN_SYMBOL_BYTES = 256
+OTHER_SYMBOLS = "[other]"
+
+# Sections that are never mapped at run time
+UNLOADED_PREFIXES = (".debug", ".zdebug", ".comment", ".symtab", ".strtab", ".shstrtab", ".group",
+                     ".gnu_debuglink", ".gnu_debugaltlink", ".note.GNU-stack", ".gnu.build.attributes")
+# -ffunction-sections/-fdata-sections names folded into their section
+SECTION_FAMILIES = (".text", ".rodata", ".data.rel.ro", ".data", ".bss", ".tdata", ".tbss")
+
+
+def metric_id(library: str, kind: str, name: str) -> str:
+    return f"{library}/{kind}/{name}/bytes"
+
+
+def parse_metric(metric: str) -> Tuple[str, str, str]:
+    """(library, kind, name) of a metric id"""
+    library, kind, rest = metric.split("/", 2)
+    return library, kind, rest[:-len("/bytes")] if rest.endswith("/bytes") else rest
+
+
+def is_trend_metric(benchmark: str, metric: str) -> bool:
+    """Whether a stored metric is worth a trend line: every metric but binsize symbols and units"""
+    return benchmark != BENCHMARK or parse_metric(metric)[1] in ("total", "section")
+
+
+def section_family(name: str) -> str:
+    for family in sorted(SECTION_FAMILIES, key=len, reverse=True):
+        if name == family or name.startswith(family + "."):
+            return family
+    return name
+
+
+def is_loaded(name: str, archive: bool) -> bool:
+    if name.startswith(UNLOADED_PREFIXES):
+        return False
+    # An object's relocations are applied by the linker, not loaded
+    return not (archive and name.startswith((".rela", ".rel.")))
+
+
+def _run(cmd: List[str]) -> str:
+    result = subprocess.run(cmd, capture_output=True, text=True)
+    if result.returncode != 0:
+        raise RuntimeError(f"{cmd[0]} {cmd[-1]}: {(result.stderr.strip().splitlines() or [''])[-1]}")
+    return result.stdout
+
+
+def section_sizes(library: Path) -> Tuple[Dict[str, int], Dict[str, int]]:
+    """(section family -> bytes, archive member -> loaded bytes) from `size -A`"""
+    archive = library.suffix == ".a"
+    sections: Dict[str, int] = {}
+    members: Dict[str, int] = {}
+    member = library.name
+    for line in _run(["size", "-A", "-d", str(library)]).splitlines():
+        parts = line.split()
+        if line.endswith(":") and parts:
+            # "libcrypto-lib-aes_core.o   (ex libcrypto.a):" or "libcrypto.so.3  :"
+            member = parts[0]
+            continue
+        if len(parts) != 3 or not parts[1].isdigit() or parts[0] == "Total":
+            continue
+        name, size = parts[0], int(parts[1])
+        if not is_loaded(name, archive):
+            continue
+        family = section_family(name)
+        sections[family] = sections.get(family, 0) + size
+        members[member] = members.get(member, 0) + size
+    return sections, members if archive else {}
+
+
+def symbol_sizes(library: Path) -> Dict[str, int]:
+    """Defined symbol -> bytes (summed across archive members), small ones in [other]"""
+    cmd = ["nm", "-S", "--defined-only", str(library)]
+    result = subprocess.run(cmd, capture_output=True, text=True)
+    if "no symbols" in result.stderr and library.suffix != ".a":
+        # Stripped: only the dynamic symbol table is left
+        result = subprocess.run(["nm", "-D", "-S", "--defined-only", str(library)], capture_output=True, text=True)
+    if result.returncode != 0:
+        raise RuntimeError(f"nm {library}: {(result.stderr.strip().splitlines() or [''])[-1]}")
+    sizes: Dict[str, int] = {}
+    for line in result.stdout.splitlines():
+        parts = line.split()
+        if len(parts) != 4:
+            continue
+        try:
+            size = int(parts[1], 16)
+        except ValueError:
+            continue
+        sizes[parts[3]] = sizes.get(parts[3], 0) + size
+    result_sizes = {name: size for name, size in sizes.items() if size >= MIN_SYMBOL_BYTES}
+    other = sum(size for size in sizes.values() if size < MIN_SYMBOL_BYTES)
+    if other:
+        result_sizes[OTHER_SYMBOLS] = other
+    return result_sizes
+
+
+def _bloaty_units(library: Path) -> Optional[Dict[str, int]]:
+    if not shutil.which("bloaty"):
+        return None
+    result = subprocess.run(["bloaty", "-d", "compileunits", "-n", "0", "--csv", str(library)],
+                            capture_output=True, text=True)
+    if result.returncode != 0:
+        logger.warning(f"bloaty {library}: {result.stderr.strip()[:200]}")
+        return None
+    units = {}
+    # compileunits,vmsize,filesize
+    for line in result.stdout.splitlines()[1:]:
+        parts = line.rsplit(",", 2)
+        if len(parts) == 3 and parts[1].isdigit():
+            units[parts[0]] = int(parts[1])
+    return units
+
+
+def _dwarf_units(library: Path) -> Dict[str, int]:
+    """Code bytes per compile unit: .debug_aranges ranges summed per .debug_info unit"""
+    names: Dict[int, str] = {}
+    offset = None
+    info = subprocess.run(["readelf", "--debug-dump=info", "--dwarf-depth=1", str(library)],
+                          capture_output=True, text=True)
+    for line in info.stdout.splitlines():
+        match = re.match(r"\s*Compilation Unit @ offset (?:0x)?([0-9a-f]+):", line)
+        if match:
+            offset = int(match.group(1), 16)
+            continue
+        if offset is not None and offset not in names and "DW_AT_name" in line:
+            names[offset] = line.rsplit(": ", 1)[-1].strip()
+    if not names:
+        return {}
+
+    units: Dict[str, int] = {}
+    offset = None
+    aranges = subprocess.run(["readelf", "--debug-dump=aranges", str(library)], capture_output=True, text=True)
+    for line in aranges.stdout.splitlines():
+        match = re.match(r"\s*Offset into \.debug_info:\s+(?:0x)?([0-9a-f]+)", line)
+        if match:
+            offset = int(match.group(1), 16)
+            continue
+        match = re.match(r"\s*([0-9a-f]{8,})\s+([0-9a-f]{8,})\s*$", line)
+        if match and offset in names:
+            units[names[offset]] = units.get(names[offset], 0) + int(match.group(2), 16)
+    return {name: size for name, size in units.items() if size}
+
+
+def compile_unit_sizes(library: Path, members: Dict[str, int]) -> Dict[str, int]:
+    if library.suffix == ".a":
+        return members
+    units = _bloaty_units(library)
+    return units if units is not None else _dwarf_units(library)
+
+
+def find_library(package_folder: Path, name: str) -> Optional[Path]:
+    """The shared library if the package has one (what consumers load), else the archive"""
+    for pattern in (f"lib*/{name}.so.*", f"lib*/{name}.so", f"lib*/{name}*.dylib", f"lib*/{name}.a"):
+        found = sorted(p for p in package_folder.glob(pattern) if not p.is_symlink() or p.suffix == ".a")
+        if found:
+            return found[0]
+    return None
+
+
+def package_openssl_version(package_folder: Path) -> str:
+    header = package_folder / "include" / "openssl" / "opensslv.h"
+    try:
+        match = re.search(r'define\s+OPENSSL_VERSION_TEXT\s+"([^"]+)"', header.read_text(errors="replace"))
+    except OSError:
+        match = None
+    return match.group(1) if match else "unknown"
+
+
+def measure_package(package_folder: Path) -> TrialResults:
+    """One binsize "trial" for the libraries of a package folder"""
+    trials = TrialResults(benchmark=BENCHMARK, openssl_version=package_openssl_version(package_folder),
+                          higher_is_better=False)
+    for name in LIBRARIES:
+        library = find_library(package_folder, name)
+        if library is None:
+            logger.warning(f"⚠️ {name} not found in {package_folder}")
+            continue
+        sections, members = section_sizes(library)
+        trials.samples[metric_id(name, "total", "loaded")] = [float(sum(sections.values()))]
+        for kind, sizes in (("section", sections), ("symbol", symbol_sizes(library)),
+                            ("cu", compile_unit_sizes(library, members))):
+            for item, size in sizes.items():
+                trials.samples[metric_id(name, kind, item)] = [float(size)]
+        logger.info(f"📏 {library.name}: {sum(sections.values())} loaded bytes, "
+                    f"{sections.get('.text', 0)} .text")
+    return trials
+
+
+@dataclass
+class SizeChange:
+    metric: str
+    previous: float
+    current: float
+    flagged: bool
+
+    @property
+    def delta(self) -> float:
+        return self.current - self.previous
+
+    @property
+    def percent(self) -> Optional[float]:
+        return (self.current / self.previous - 1.0) * 100.0 if self.previous else None
+
+
+@dataclass
+class SizeReport:
+    run_id: int
+    package_revision: str
+    baseline_run: Optional[Dict[str, Any]] = None
+    totals: Dict[str, float] = field(default_factory=dict)
+    changes: List[SizeChange] = field(default_factory=list)
+
+    @property
+    def flagged(self) -> List[SizeChange]:
+        return [c for c in self.changes if c.flagged]
+
+    def to_dict(self) -> Dict[str, Any]:
+        return {
+            "run_id": self.run_id,
+            "package_revision": self.package_revision,
+            "baseline_run": self.baseline_run,
+            "totals": self.totals,
+            "flagged": [dict(asdict(c), delta=c.delta, percent=c.percent) for c in self.flagged],
+            "changes": [dict(asdict(c), delta=c.delta, percent=c.percent) for c in self.changes],
+        }
+
+
+def compare_sizes(current: Dict[str, List[float]], previous: Dict[str, List[float]],
+                  threshold_percent: float = 2.0, min_bytes: int = 4096) -> List[SizeChange]:
+    """Every metric that changed, largest growth first, flagged per the module docstring"""
+    changes = []
+    for metric in set(current) | set(previous):
+        now = current.get(metric, [0.0])[0]
+        before = previous.get(metric, [0.0])[0]
+        if now == before:
+            continue
+        kind = parse_metric(metric)[1]
+        if kind in ("total", "section"):
+            flagged = before > 0 and now > before and (now / before - 1.0) * 100.0 >= threshold_percent
+        else:
+            flagged = now - before >= min_bytes
+        changes.append(SizeChange(metric, before, now, flagged))
+    return sorted(changes, key=lambda c: -c.delta)
+
+
+class BinarySizeTracker:
+    """Records a package's sizes in the perf history and compares them with the previous revision"""
+
+    def __init__(self, store: PerfHistoryStore, threshold_percent: float = 2.0, min_bytes: int = 4096):
+        self.store = store
+        self.threshold_percent = threshold_percent
+        self.min_bytes = min_bytes
+
+    def baseline(self, profile: str, platform: str, package_revision: str,
+                 against: Optional[str] = None) -> Optional[Dict[str, Any]]:
+        """Latest size run of another revision (or of `against`) for this profile and platform"""
+        for run in self.store.runs(benchmark=BENCHMARK, profile=profile, limit=1000):
+            if run["platform"] != platform:
+                continue
+            if against is not None and run["package_revision"] == against:
+                return run
+            if against is None and run["package_revision"] != package_revision:
+                return run
+        return None
+
+    def record(self, package_folder: Path, package_revision: str, profile: str, platform: str,
+               git_commit: str, against: Optional[str] = None) -> SizeReport:
+        trials = measure_package(package_folder)
+        if not trials.samples:
+            raise RuntimeError(f"no libcrypto or libssl in {package_folder}")
+        baseline = self.baseline(profile, platform, package_revision, against)
+        run_id = self.store.record(trials, git_commit=git_commit, package_revision=package_revision,
+                                   profile=profile, platform=platform, cpu_model="-")
+        report = SizeReport(run_id=run_id, package_revision=package_revision, baseline_run=baseline,
+                            totals={m: v[0] for m, v in trials.samples.items()
+                                    if parse_metric(m)[1] == "total" or m.endswith("/section/.text/bytes")})
+        if baseline is not None:
+            report.changes = compare_sizes(trials.samples, self.store.samples(baseline["id"]),
+                                           self.threshold_percent, self.min_bytes)
+        return report
+
+
+def format_size_report(report: SizeReport, top: int = 15) -> str:
+    lines = []
+    base = report.baseline_run
+    against = f"{base['package_revision'][:12]} ({base['timestamp'][:10]})" if base else "nothing (first run)"
+    lines.append(f"Binary size of {report.package_revision[:12]} vs {against}")
+    for metric, value in sorted(report.totals.items()):
+        change = next((c for c in report.changes if c.metric == metric), None)
+        delta = f"  {change.delta:+,.0f} ({change.percent:+.2f}%)" if change and change.percent is not None else ""
+        lines.append(f"  {metric:<36} {value:>12,.0f}{delta}")
+    grown = [c for c in report.changes if c.delta > 0 and parse_metric(c.metric)[1] in ("symbol", "cu")][:top]
+    if grown:
+        lines.append("  Largest growth:")
+        for change in grown:
+            library, kind, name = parse_metric(change.metric)
+            mark = "✗" if change.flagged else " "
+            lines.append(f"  {mark} {library:<9} {kind:<6} {name[:60]:<60} {change.delta:>+10,.0f}")
+    flagged = report.flagged
+    lines.append(f"{'✗' if flagged else '✓'} {len(flagged)} size increase(s) over the thresholds")
+    return "\n".join(lines)
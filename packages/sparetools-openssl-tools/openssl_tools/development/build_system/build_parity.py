@@ -0,0 +1,485 @@
+#!/usr/bin/env python3
+"""
+Build-flag and codegen parity between the vanilla and python variants
+
+_Build/openssl-builds/<version>/vanilla and .../python build the same
+pristine sources (source_trees.py), one through Perl Configure and one
+through the hybrid configure.py, whose _get_cflags writes its own flag
+line. The two can drift apart without any build failing: a different -O
+level, a missing -D, or no perlasm modules at all. This report shows
+where they differ and whether it matters:
+
+- compile flags: the effective command of every object, taken from
+  compile_commands.json, `ninja -t commands` or a `make -n -B` dry run of
+  each build tree, diffed per object. Differences shared by most objects
+  are listed once as systematic; include paths are compared relative to
+  the build or source tree, since the perl build is out of tree.
+- asm modules: objects built from .s/.S sources in each tree, arch-named
+  members of each installed libcrypto.a, and which asm entry points
+  (OPENSSL_ia32_cpuid, aesni_gcm_encrypt, ...) each libcrypto defines.
+  OPENSSL_cpuid_setup is defined in both asm and no-asm builds, so it is
+  reported but does not decide anything.
+- performance: bench_evp built against both installs, trials compared
+  with the regression test the performance gate uses.
+
+The python variant passes (exit 0) only when no bench_evp metric is a
+significant regression against vanilla and it is not missing asm entry
+points vanilla has.
+"""
+
+import json
+import logging
+import platform
+import re
+import shlex
+import subprocess
+from collections import Counter
+from dataclasses import asdict, dataclass, field
+from pathlib import Path
+from typing import Any, Dict, List, Optional, Tuple
+
+from .benchmark_matrix import build_benchmarks, find_bench_binary
+from .statistical_runner import StatisticalBenchmarkRunner, compare_samples
+
+logger = logging.getLogger(__name__)
+
+TOOLS_ROOT = Path(__file__).resolve().parents[3]
+DEFAULT_TEST_PACKAGE = TOOLS_ROOT.parent / "sparetools-openssl" / "test_package"
+VARIANTS = ("vanilla", "python")
+
+SOURCE_SUFFIXES = (".c", ".s", ".S")
+# Dependency generation flags; the first three take an argument
+DEPENDENCY_FLAGS = {"-MF", "-MT", "-MQ", "-MMD", "-MD", "-MP"}
+DEPENDENCY_ARG_FLAGS = {"-MF", "-MT", "-MQ"}
+# A flag shared by at least this share of common objects is systematic
+SYSTEMATIC_SHARE = 0.5
+# Objects listed per flag in per-object differences
+MAX_EXAMPLES = 5
+
+# libcrypto.a members of arch-specific modules (aesni-x86_64.o, sha256-armv8.o)
+ARCH_MEMBER = re.compile(r"x86_64|avx2|avx512|avxifma|586|armv4|armv8|aarch64|ppc|s390x|riscv|mips|sparcv9")
+
+# Entry points only the perlasm modules define, per machine
+ASM_MARKERS = {
+    "x86_64": ["OPENSSL_ia32_cpuid", "aesni_encrypt", "aesni_gcm_encrypt", "gcm_ghash_avx",
+               "sha256_block_data_order", "sha512_block_data_order", "bn_mul_mont_gather5",
+               "ecp_nistz256_mul_mont", "ChaCha20_ctr32", "x25519_fe51_mul", "poly1305_blocks"],
+    "aarch64": ["_armv7_tick", "aes_v8_encrypt", "gcm_ghash_v8", "sha256_block_data_order",
+                "sha512_block_data_order", "bn_mul_mont", "ecp_nistz256_mul_mont", "ChaCha20_ctr32",
+                "poly1305_blocks"],
+}
+ASM_MARKERS["amd64"] = ASM_MARKERS["x86_64"]
+ASM_MARKERS["arm64"] = ASM_MARKERS["aarch64"]
+ALWAYS_DEFINED = "OPENSSL_cpuid_setup"
+
+
+@dataclass
+class CompileCommand:
+    """One object's compile: compiler and flags without output, source or dependency flags"""
+    object: str
+    source: str
+    compiler: str
+    flags: List[str] = field(default_factory=list)
+
+    @property
+    def is_asm(self) -> bool:
+        return self.source.endswith((".s", ".S"))
+
+
+def flag_category(flag: str) -> str:
+    if flag.startswith("-O"):
+        return "optimization"
+    if flag.startswith(("-D", "-U")):
+        return "defines"
+    if flag.startswith(("-I", "-isystem", "-iquote", "-include")):
+        return "includes"
+    if flag.startswith(("-Wa,", "-Wp,", "-Wl,")):
+        return "passthrough"
+    if flag.startswith("-W") or flag in ("-pedantic", "-w"):
+        return "warnings"
+    if flag.startswith("-m"):
+        return "target"
+    if flag.startswith("-f"):
+        return "codegen"
+    if flag.startswith("-g"):
+        return "debug"
+    if flag.startswith("-std"):
+        return "language"
+    return "other"
+
+
+def _normalize_include(path: str, build_dir: Path, src_dir: Optional[Path]) -> str:
+    """An include directory relative to the build tree or, outside it, the source tree"""
+    resolved = (build_dir / path).resolve() if not Path(path).is_absolute() else Path(path).resolve()
+    for root in (build_dir.resolve(), src_dir.resolve() if src_dir else None):
+        if root is not None:
+            try:
+                return str(resolved.relative_to(root)) or "."
+            except ValueError:
+                continue
+    return str(resolved)
+
+
+def parse_compile_line(tokens: List[str], build_dir: Path,
+                       src_dir: Optional[Path] = None) -> Optional[CompileCommand]:
+    """A CompileCommand from one command's argv, or None if it does not compile an object"""
+    if "-c" not in tokens or "-o" not in tokens:
+        return None
+    start = 1 if Path(tokens[0]).name in ("ccache", "sccache") and len(tokens) > 1 else 0
+    compiler, args = Path(tokens[start]).name, tokens[start + 1:]
+    obj, source, flags = None, None, []
+    i = 0
+    while i < len(args):
+        arg = args[i]
+        if arg == "-o" and i + 1 < len(args):
+            obj = args[i + 1]
+            i += 2
+            continue
+        if arg in DEPENDENCY_ARG_FLAGS:
+            i += 2
+            continue
+        if arg in DEPENDENCY_FLAGS or arg == "-c":
+            i += 1
+            continue
+        if arg.endswith(SOURCE_SUFFIXES) and not arg.startswith("-"):
+            source = arg
+        elif arg in ("-I", "-isystem", "-iquote") and i + 1 < len(args):
+            flags.append(arg + _normalize_include(args[i + 1], build_dir, src_dir))
+            i += 2
+            continue
+        elif arg.startswith("-I"):
+            flags.append("-I" + _normalize_include(arg[2:], build_dir, src_dir))
+        else:
+            flags.append(arg)
+        i += 1
+    if obj is None or source is None or not obj.endswith(".o"):
+        return None
+    return CompileCommand(object=obj[2:] if obj.startswith("./") else obj, source=source,
+                          compiler=compiler, flags=flags)
+
+
+def _split_commands(line: str) -> List[List[str]]:
+    """argv of each command in a shell line (a && b; c)"""
+    lexer = shlex.shlex(line, posix=True, punctuation_chars=";&|")
+    lexer.whitespace_split = True
+    commands, current = [], []
+    try:
+        for token in lexer:
+            if token and set(token) <= set(";&|"):
+                if current:
+                    commands.append(current)
+                current = []
+            else:
+                current.append(token)
+    except ValueError:
+        return []
+    if current:
+        commands.append(current)
+    return commands
+
+
+def _dry_run(build_dir: Path) -> Tuple[List[str], str]:
+    """Compile command lines of a build tree without building, and how they were found"""
+    database = build_dir / "compile_commands.json"
+    if database.exists():
+        lines = []
+        for entry in json.loads(database.read_text(encoding="utf-8")):
+            args = entry.get("arguments")
+            lines.append(shlex.join(args) if args else entry.get("command", ""))
+        return lines, "compile_commands.json"
+    if (build_dir / "build.ninja").exists():
+        cmd, how = ["ninja", "-C", str(build_dir), "-t", "commands"], "ninja -t commands"
+    else:
+        # build_libs in both Makefiles; -B lists objects that are already up to date
+        cmd, how = ["make", "-C", str(build_dir), "-n", "-B", "build_libs"], "make -n -B build_libs"
+    result = subprocess.run(cmd, capture_output=True, text=True)
+    if result.returncode != 0 and not result.stdout:
+        raise RuntimeError(f"{how} failed in {build_dir}: {(result.stderr.strip().splitlines() or [''])[-1]}")
+    return result.stdout.splitlines(), how
+
+
+def extract_compile_commands(build_dir: Path, src_dir: Optional[Path] = None
+                             ) -> Tuple[Dict[str, CompileCommand], str]:
+    """object -> CompileCommand for every object the build tree compiles"""
+    lines, how = _dry_run(build_dir)
+    commands = {}
+    for line in lines:
+        for tokens in _split_commands(line):
+            command = parse_compile_line(tokens, build_dir, src_dir)
+            if command is not None:
+                commands[command.object] = command
+    return commands, how
+
+
+def diff_compile_commands(vanilla: Dict[str, CompileCommand],
+                          python: Dict[str, CompileCommand]) -> Dict[str, Any]:
+    """Objects built by only one variant, and flag differences on the common ones"""
+    common = sorted(set(vanilla) & set(python))
+    only_vanilla = Counter()
+    only_python = Counter()
+    examples: Dict[Tuple[str, str], List[str]] = {}
+    objects = {}
+    for obj in common:
+        v_flags, p_flags = vanilla[obj].flags, python[obj].flags
+        missing = [f for f in dict.fromkeys(v_flags) if f not in p_flags]
+        extra = [f for f in dict.fromkeys(p_flags) if f not in v_flags]
+        if missing or extra:
+            objects[obj] = {"only_vanilla": missing, "only_python": extra}
+        for side, flags, counter in (("vanilla", missing, only_vanilla), ("python", extra, only_python)):
+            for flag in flags:
+                counter[flag] += 1
+                examples.setdefault((side, flag), []).append(obj)
+
+    def summarize(side: str, counter: Counter) -> Dict[str, List[Dict[str, Any]]]:
+        by_category: Dict[str, List[Dict[str, Any]]] = {}
+        for flag, count in sorted(counter.items(), key=lambda item: (-item[1], item[0])):
+            by_category.setdefault(flag_category(flag), []).append({
+                "flag": flag,
+                "objects": count,
+                "systematic": count >= SYSTEMATIC_SHARE * len(common),
+                "examples": examples[(side, flag)][:MAX_EXAMPLES],
+            })
+        return by_category
+
+    def opt_level(commands: Dict[str, CompileCommand]) -> Optional[str]:
+        levels = Counter(next((f for f in reversed(c.flags) if f.startswith("-O")), "-O0")
+                         for c in commands.values() if not c.is_asm)
+        return levels.most_common(1)[0][0] if levels else None
+
+    return {
+        "objects": {"vanilla": len(vanilla), "python": len(python), "common": len(common)},
+        "compilers": {
+            "vanilla": sorted({c.compiler for c in vanilla.values()}),
+            "python": sorted({c.compiler for c in python.values()}),
+        },
+        "optimization": {"vanilla": opt_level(vanilla), "python": opt_level(python)},
+        "asm_objects": {
+            "vanilla": sorted(o for o, c in vanilla.items() if c.is_asm),
+            "python": sorted(o for o, c in python.items() if c.is_asm),
+        },
+        "only_in_vanilla": sorted(set(vanilla) - set(python)),
+        "only_in_python": sorted(set(python) - set(vanilla)),
+        "flags_only_vanilla": summarize("vanilla", only_vanilla),
+        "flags_only_python": summarize("python", only_python),
+        "per_object": objects,
+    }
+
+
+def find_libcrypto(prefix: Path) -> Optional[Path]:
+    """Installed libcrypto, the static archive first (its members name the modules)"""
+    for pattern in ("lib*/libcrypto.a", "lib*/libcrypto.so", "lib*/libcrypto.so.*", "lib*/libcrypto*.dylib"):
+        found = sorted(prefix.glob(pattern))
+        if found:
+            return found[0]
+    return None
+
+
+def inspect_asm(library: Path, machine: Optional[str] = None) -> Dict[str, Any]:
+    """Arch-specific archive members and asm entry points defined by a libcrypto"""
+    machine = (machine or platform.machine()).lower()
+    markers = ASM_MARKERS.get(machine, [])
+    members: List[str] = []
+    if library.suffix == ".a":
+        result = subprocess.run(["ar", "t", str(library)], capture_output=True, text=True)
+        members = sorted(m for m in result.stdout.split() if ARCH_MEMBER.search(m))
+    # The entry points are local in a shared libcrypto (version script), so read
+    # its full symbol table; a stripped one only tells what it exports
+    nm = ["nm", "--defined-only", str(library)]
+    if library.suffix == ".a":
+        nm.insert(1, "-g")
+    result = subprocess.run(nm, capture_output=True, text=True)
+    stripped = library.suffix != ".a" and "no symbols" in result.stderr
+    if stripped:
+        result = subprocess.run(["nm", "-D", "--defined-only", str(library)], capture_output=True, text=True)
+    if result.returncode != 0:
+        raise RuntimeError(f"nm {library}: {(result.stderr.strip().splitlines() or [''])[-1]}")
+    defined = {line.split()[-1] for line in result.stdout.splitlines()
+               if len(line.split()) >= 3 and line.split()[-2] in "TtWi"}
+    return {
+        "library": str(library),
+        "machine": machine,
+        "stripped": stripped,
+        "arch_members": members,
+        "asm_entry_points": [m for m in markers if m in defined],
+        "missing_entry_points": [m for m in markers if m not in defined],
+        ALWAYS_DEFINED: ALWAYS_DEFINED in defined,
+    }
+
+
+@dataclass
+class ParityReport:
+    version: str
+    flags: Optional[Dict[str, Any]] = None
+    asm: Dict[str, Any] = field(default_factory=dict)
+    benchmark: Dict[str, Any] = field(default_factory=dict)
+    problems: List[str] = field(default_factory=list)
+    notes: List[str] = field(default_factory=list)
+
+    @property
+    def passed(self) -> bool:
+        return not self.problems
+
+    def to_dict(self) -> Dict[str, Any]:
+        return dict(asdict(self), passed=self.passed)
+
+
+class BuildParityChecker:
+    """Compares one version's vanilla and python builds under a build root"""
+
+    def __init__(self, build_root: Path, work_dir: Path, test_package_dir: Path = DEFAULT_TEST_PACKAGE,
+                 trials: int = 5, warmup: int = 1, cpus: Optional[List[int]] = None, quick: bool = False,
+                 alpha: float = 0.01, min_effect_percent: float = 3.0):
+        self.build_root = build_root
+        self.work_dir = work_dir
+        self.test_package_dir = test_package_dir
+        self.trials = trials
+        self.warmup = warmup
+        self.cpus = cpus
+        self.quick = quick
+        self.alpha = alpha
+        self.min_effect_percent = min_effect_percent
+
+    def _dir(self, version: str, variant: str, kind: str) -> Path:
+        return self.build_root / version / variant / kind
+
+    def compare_flags(self, version: str, report: ParityReport) -> None:
+        trees = {v: self._dir(version, v, "build") for v in VARIANTS}
+        missing = [str(path) for path in trees.values() if not path.is_dir()]
+        if missing:
+            report.notes.append(f"flag comparison skipped, no build tree: {', '.join(missing)}")
+            return
+        src = self.build_root / version / "src"
+        commands, sources = {}, {}
+        for variant, tree in trees.items():
+            commands[variant], sources[variant] = extract_compile_commands(tree, src if src.is_dir() else None)
+            logger.info(f"{version}/{variant}: {len(commands[variant])} objects ({sources[variant]})")
+        report.flags = dict(diff_compile_commands(commands["vanilla"], commands["python"]), sources=sources)
+        opt = report.flags["optimization"]
+        if opt["vanilla"] != opt["python"]:
+            report.notes.append(f"optimization level differs: vanilla {opt['vanilla']}, python {opt['python']}")
+        asm = report.flags["asm_objects"]
+        if asm["vanilla"] and not asm["python"]:
+            report.notes.append(f"python compiles no asm sources (vanilla: {len(asm['vanilla'])})")
+
+    def compare_asm(self, version: str, report: ParityReport) -> None:
+        for variant in VARIANTS:
+            library = find_libcrypto(self._dir(version, variant, "install"))
+            if library is None:
+                report.notes.append(f"asm check skipped for {variant}: no installed libcrypto")
+                continue
+            report.asm[variant] = inspect_asm(library)
+        if len(report.asm) < len(VARIANTS):
+            return
+        vanilla, python = report.asm["vanilla"], report.asm["python"]
+        lost = [m for m in vanilla["asm_entry_points"] if m not in python["asm_entry_points"]]
+        if python["stripped"]:
+            report.notes.append("python libcrypto is stripped, asm entry points not compared")
+        elif lost:
+            report.problems.append(f"python libcrypto lacks asm entry points vanilla has: {', '.join(lost)}")
+        members = set(vanilla["arch_members"]) - set(python["arch_members"])
+        if members and python["library"].endswith(".a"):
+            report.asm["members_only_vanilla"] = sorted(members)
+
+    def compare_performance(self, version: str, report: ParityReport, bench: str = "bench_evp") -> None:
+        samples: Dict[str, Dict[str, List[float]]] = {}
+        higher_is_better = True
+        for variant in VARIANTS:
+            prefix = self._dir(version, variant, "install")
+            if find_libcrypto(prefix) is None:
+                report.problems.append(f"{bench} not run: no {variant} install in {prefix}")
+                return
+            build_dir, error = build_benchmarks(self.test_package_dir, prefix,
+                                                self.work_dir / "build" / f"{version}-{variant}", [bench])
+            binary = find_bench_binary(build_dir, bench) if build_dir else None
+            if binary is None:
+                report.problems.append(f"{bench} did not build against {variant}: {error}")
+                return
+            runner = StatisticalBenchmarkRunner(self.work_dir / "trials" / f"{version}-{variant}",
+                                                trials=self.trials, warmup=self.warmup, cpus=self.cpus)
+            trials = runner.run(binary, ["--quick"] if self.quick else [])
+            samples[variant] = trials.samples
+            higher_is_better = trials.higher_is_better
+
+        metrics, regressions = {}, []
+        for metric in sorted(set(samples["vanilla"]) & set(samples["python"])):
+            comparison = compare_samples(metric, samples["python"][metric], samples["vanilla"][metric],
+                                         higher_is_better, self.alpha, self.min_effect_percent)
+            metrics[metric] = {
+                "vanilla": comparison.baseline_median,
+                "python": comparison.current_median,
+                "change_percent": comparison.change_percent,
+                "p_value": comparison.p_value,
+                "verdict": comparison.verdict,
+            }
+            if comparison.verdict == "regression":
+                regressions.append(metric)
+        report.benchmark = {"bench": bench, "trials": self.trials, "quick": self.quick, "metrics": metrics,
+                            "regressions": regressions}
+        if regressions:
+            report.problems.append(f"python is slower than vanilla on {len(regressions)} {bench} metrics "
+                                   f"(e.g. {regressions[0]})")
+
+    def run(self, version: str, benchmark: bool = True) -> ParityReport:
+        report = ParityReport(version=version)
+        self.compare_flags(version, report)
+        self.compare_asm(version, report)
+        if benchmark:
+            self.compare_performance(version, report)
+        return report
+
+    def write_reports(self, report: ParityReport) -> Tuple[Path, Path]:
+        """build-parity-<version>.json and .md in the work directory"""
+        self.work_dir.mkdir(parents=True, exist_ok=True)
+        json_path = self.work_dir / f"build-parity-{report.version}.json"
+        md_path = self.work_dir / f"build-parity-{report.version}.md"
+        json_path.write_text(json.dumps(report.to_dict(), indent=2), encoding="utf-8")
+        md_path.write_text(format_report(report) + "\n", encoding="utf-8")
+        return json_path, md_path
+
+
+def format_report(report: ParityReport) -> str:
+    lines = [f"# Build Parity: OpenSSL {report.version}, vanilla vs python", "",
+             f"**{'PASS' if report.passed else 'FAIL'}**" + ("" if report.passed else ": python should not ship"), ""]
+    lines += [f"- ✗ {problem}" for problem in report.problems]
+    lines += [f"- {note}" for note in report.notes]
+
+    flags = report.flags
+    if flags:
+        lines += ["", "## Compile Flags", "",
+                  f"Objects: vanilla {flags['objects']['vanilla']}, python {flags['objects']['python']}, "
+                  f"common {flags['objects']['common']}. Optimization: vanilla `{flags['optimization']['vanilla']}`, "
+                  f"python `{flags['optimization']['python']}`. Asm sources: vanilla "
+                  f"{len(flags['asm_objects']['vanilla'])}, python {len(flags['asm_objects']['python'])}.", ""]
+        for side in ("vanilla", "python"):
+            rows = [(category, entry) for category, entries in flags[f"flags_only_{side}"].items()
+                    for entry in entries if category != "includes"]
+            if not rows:
+                continue
+            lines += [f"Only in {side}:", "", "| Category | Flag | Objects | Systematic |", "|---|---|---:|---|"]
+            lines += [f"| {category} | `{entry['flag']}` | {entry['objects']} | {'yes' if entry['systematic'] else ''} |"
+                      for category, entry in rows]
+            lines.append("")
+        for side in ("vanilla", "python"):
+            only = flags[f"only_in_{side}"]
+            if only:
+                shown = ", ".join(f"`{o}`" for o in only[:20])
+                lines.append(f"Objects only in {side} ({len(only)}): {shown}{' ...' if len(only) > 20 else ''}")
+                lines.append("")
+
+    if report.asm:
+        lines += ["", "## Asm Modules", "", "| | vanilla | python |", "|---|---|---|"]
+        vanilla, python = report.asm.get("vanilla", {}), report.asm.get("python", {})
+        lines.append(f"| arch members | {len(vanilla.get('arch_members', []))} | {len(python.get('arch_members', []))} |")
+        lines.append(f"| {ALWAYS_DEFINED} | {vanilla.get(ALWAYS_DEFINED, '-')} | {python.get(ALWAYS_DEFINED, '-')} |")
+        for marker in ASM_MARKERS.get(vanilla.get("machine") or python.get("machine") or "", []):
+            lines.append(f"| `{marker}` | {'✓' if marker in vanilla.get('asm_entry_points', []) else '-'} | "
+                         f"{'✓' if marker in python.get('asm_entry_points', []) else '-'} |")
+
+    bench = report.benchmark
+    if bench:
+        lines += ["", f"## {bench['bench']}", "", "| Metric | vanilla | python | Change | Verdict |",
+                  "|---|---:|---:|---:|---|"]
+        for metric, row in bench["metrics"].items():
+            lines.append(f"| {metric} | {row['vanilla']:.1f} | {row['python']:.1f} | "
+                         f"{row['change_percent']:+.1f}% | {row['verdict']} |")
+    return "\n".join(lines)
@@ -0,0 +1,245 @@
+#!/usr/bin/env python3
+"""
+Resource-aware build matrix scheduler
+
+Runs several build-matrix entries concurrently on one builder. Cores and
+RAM are handed out from a jobserver-style token pool: every job holds a
+number of core tokens (its `make -j`/tools.build:jobs value) plus the
+memory those compile jobs need, and returns them when it finishes. Jobs
+are started longest-first using durations recorded in previous
+build-summary-*.json files, so the long FIPS/debug builds do not end up
+as a serial tail after everything else has finished.
+
+Jobs that have no history are treated as the longest ones; the first run
+of a new configuration is the one we know least about.
+"""
+
+import json
+import logging
+import os
+import statistics
+import threading
+import time
+from dataclasses import dataclass, field
+from datetime import datetime, timezone
+from pathlib import Path
+from typing import Any, Callable, Dict, Iterable, List, Optional
+
+logger = logging.getLogger(__name__)
+
+# Peak resident memory of one OpenSSL compile job (cc1 on the larger
+# crypto/ sources plus the linker for libcrypto), with some headroom.
+DEFAULT_MEMORY_PER_CORE_MB = 768
+
+
+def available_memory_mb() -> int:
+    """MemAvailable from /proc/meminfo, falling back to total physical memory"""
+    try:
+        with open("/proc/meminfo", "r") as f:
+            for line in f:
+                if line.startswith("MemAvailable:"):
+                    return int(line.split()[1]) // 1024
+    except OSError:
+        pass
+    try:
+        return os.sysconf("SC_PAGE_SIZE") * os.sysconf("SC_PHYS_PAGES") // (1024 * 1024)
+    except (ValueError, OSError, AttributeError):
+        return 0
+
+
+def load_build_durations(log_dirs: Iterable[Path]) -> Dict[str, float]:
+    """Median duration_seconds per job_name over all build-summary-*.json files"""
+    samples: Dict[str, List[float]] = {}
+    for log_dir in log_dirs:
+        log_dir = Path(log_dir)
+        if not log_dir.is_dir():
+            continue
+        for path in log_dir.glob("build-summary-*.json"):
+            try:
+                data = json.loads(path.read_text(encoding="utf-8"))
+            except (OSError, json.JSONDecodeError):
+                continue
+            name = data.get("job_name")
+            duration = data.get("duration_seconds")
+            if name and isinstance(duration, (int, float)) and duration > 0:
+                samples.setdefault(name, []).append(float(duration))
+    return {name: statistics.median(values) for name, values in samples.items()}
+
+
+def write_build_summary(log_dir: Path, job_name: str, started: datetime, finished: datetime,
+                        jobs: int, success: bool, extra: Optional[Dict[str, Any]] = None) -> Path:
+    """Write a build-summary-*.json compatible with scripts/aggregate-build-logs.py"""
+    log_dir.mkdir(parents=True, exist_ok=True)
+    path = log_dir / f"build-summary-{started.strftime('%Y%m%d-%H%M%S')}-{job_name}.json"
+    summary = {
+        "job_name": job_name,
+        "jobs": jobs,
+        "success": success,
+        "started": started.isoformat().replace("+00:00", "Z"),
+        "finished": finished.isoformat().replace("+00:00", "Z"),
+        "duration_seconds": (finished - started).total_seconds(),
+    }
+    summary.update(extra or {})
+    path.write_text(json.dumps(summary, indent=2), encoding="utf-8")
+    return path
+
+
+class ResourcePool:
+    """Counting token pool for cores and memory shared by concurrent jobs"""
+
+    def __init__(self, cores: int, memory_mb: int):
+        self.total_cores = max(1, cores)
+        self.total_memory_mb = max(0, memory_mb)
+        self.free_cores = self.total_cores
+        self.free_memory_mb = self.total_memory_mb
+        self._cond = threading.Condition()
+
+    def try_acquire(self, cores: int, memory_mb: int) -> bool:
+        with self._cond:
+            if cores > self.free_cores or memory_mb > self.free_memory_mb:
+                return False
+            self.free_cores -= cores
+            self.free_memory_mb -= memory_mb
+            return True
+
+    def release(self, cores: int, memory_mb: int) -> None:
+        with self._cond:
+            self.free_cores += cores
+            self.free_memory_mb += memory_mb
+            self._cond.notify_all()
+
+    def wait(self, timeout: Optional[float] = None) -> None:
+        """Block until some job releases its tokens"""
+        with self._cond:
+            self._cond.wait(timeout)
+
+
+@dataclass
+class ScheduledJob:
+    """One matrix entry and the resources it ran with"""
+    name: str
+    config: Dict[str, Any]
+    estimated_seconds: Optional[float] = None
+    cores: int = 0
+    memory_mb: int = 0
+    success: Optional[bool] = None
+    started: Optional[datetime] = None
+    finished: Optional[datetime] = None
+    error: Optional[str] = None
+
+    @property
+    def duration_seconds(self) -> float:
+        if self.started and self.finished:
+            return (self.finished - self.started).total_seconds()
+        return 0.0
+
+
+@dataclass
+class ScheduleResult:
+    jobs: List[ScheduledJob] = field(default_factory=list)
+    wall_seconds: float = 0.0
+
+    @property
+    def success_count(self) -> int:
+        return sum(1 for job in self.jobs if job.success)
+
+    @property
+    def serial_seconds(self) -> float:
+        return sum(job.duration_seconds for job in self.jobs)
+
+
+class BuildMatrixScheduler:
+    """Packs matrix builds onto the local cores and RAM, longest jobs first"""
+
+    def __init__(self, max_cores: Optional[int] = None, max_memory_mb: Optional[int] = None,
+                 max_parallel: Optional[int] = None, min_cores_per_job: int = 2,
+                 memory_per_core_mb: int = DEFAULT_MEMORY_PER_CORE_MB,
+                 history: Optional[Dict[str, float]] = None, log_dir: Optional[Path] = None):
+        self.max_cores = max_cores or os.cpu_count() or 1
+        self.max_memory_mb = max_memory_mb or available_memory_mb() or self.max_cores * memory_per_core_mb
+        self.min_cores_per_job = max(1, min(min_cores_per_job, self.max_cores))
+        self.memory_per_core_mb = memory_per_core_mb
+        # Never more concurrent jobs than min-sized core shares fit on the machine
+        fit = max(1, self.max_cores // self.min_cores_per_job)
+        self.max_parallel = max(1, min(max_parallel or fit, fit))
+        self.history = history or {}
+        self.log_dir = Path(log_dir) if log_dir else None
+        self.pool = ResourcePool(self.max_cores, self.max_memory_mb)
+
+    def order(self, configs: List[Dict[str, Any]]) -> List[ScheduledJob]:
+        """Longest-first by historical median; jobs without history go first"""
+        jobs = [ScheduledJob(name=c["job_name"], config=c, estimated_seconds=self.history.get(c["job_name"]))
+                for c in configs]
+        return sorted(jobs, key=lambda j: (j.estimated_seconds is not None, -(j.estimated_seconds or 0.0)))
+
+    def _share(self, pending: int, running: int) -> int:
+        """
+        Cores for the next job: the free core and memory tokens split evenly
+        over the jobs that can still start alongside the running ones. The
+        first job always starts, with its memory capped at the pool size.
+        """
+        slots = max(1, min(self.max_parallel - running, pending))
+        free = self.pool.free_cores
+        if self.memory_per_core_mb > 0 and running:
+            free = min(free, self.pool.free_memory_mb // self.memory_per_core_mb)
+        return min(free, max(self.min_cores_per_job, free // slots))
+
+    def _memory_for(self, cores: int) -> int:
+        return min(cores * self.memory_per_core_mb, self.pool.total_memory_mb)
+
+    def run(self, configs: List[Dict[str, Any]],
+            build_fn: Callable[[Dict[str, Any], int], bool]) -> ScheduleResult:
+        """
+        Run build_fn(config, cores) for every config, at most max_parallel at
+        a time. The scheduler shrinks a job's core share down to
+        min_cores_per_job when few tokens are free rather than leave cores idle.
+        """
+        pending = self.order(configs)
+        result = ScheduleResult(jobs=list(pending))
+        running: List[threading.Thread] = []
+        started_at = time.perf_counter()
+
+        logger.info(f"🚀 Scheduling {len(pending)} builds on {self.max_cores} cores / "
+                    f"{self.max_memory_mb} MB (up to {self.max_parallel} concurrent)")
+
+        def worker(job: ScheduledJob) -> None:
+            job.started = datetime.now(timezone.utc)
+            try:
+                job.success = bool(build_fn(job.config, job.cores))
+            except Exception as e:
+                job.success = False
+                job.error = str(e)
+                logger.error(f"❌ {job.name}: {e}")
+            finally:
+                job.finished = datetime.now(timezone.utc)
+                if self.log_dir:
+                    write_build_summary(self.log_dir, job.name, job.started, job.finished,
+                                        job.cores, bool(job.success))
+                self.pool.release(job.cores, job.memory_mb)
+
+        while pending or running:
+            running = [t for t in running if t.is_alive()]
+            launched = False
+            if pending and len(running) < self.max_parallel:
+                job = pending[0]
+                cores = self._share(len(pending), len(running))
+                if cores >= self.min_cores_per_job or (not running and cores > 0):
+                    memory = self._memory_for(cores)
+                    if self.pool.try_acquire(cores, memory):
+                        pending.pop(0)
+                        job.cores, job.memory_mb = cores, memory
+                        eta = f", ~{job.estimated_seconds:.0f}s" if job.estimated_seconds else ""
+                        logger.info(f"🔨 {job.name}: -j{cores}, {memory} MB{eta}")
+                        thread = threading.Thread(target=worker, args=(job,), name=job.name, daemon=True)
+                        thread.start()
+                        running.append(thread)
+                        launched = True
+            if not launched and running:
+                self.pool.wait(timeout=1.0)
+
+        result.wall_seconds = time.perf_counter() - started_at
+        serial = result.serial_seconds
+        if result.wall_seconds > 0 and serial > 0:
+            logger.info(f"📊 Wall time {result.wall_seconds:.0f}s for {serial:.0f}s of builds "
+                        f"({serial / result.wall_seconds:.1f}x concurrency)")
+        return result
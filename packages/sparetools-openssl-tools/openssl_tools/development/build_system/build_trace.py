@@ -0,0 +1,168 @@
+#!/usr/bin/env python3
+"""
+Build timing traces in Chrome trace event format
+
+BuildTrace records nested build phases (source, Configure, make, test,
+security gates, package) as complete ("X") events in a Chrome trace JSON
+file that chrome://tracing, ui.perfetto.dev and speedscope show as a flame
+view. Timestamps are wall-clock microseconds, so events recorded by
+separate processes line up: opening an existing trace appends to it, which
+is how `conan source`, `conan build` and the package step end up in one
+file.
+
+merge_clang_time_traces() folds in the per-translation-unit traces Clang
+writes with -ftime-trace (foo.json next to foo.o). Each TU becomes one
+event named after its object file with Clang's Frontend/Backend breakdown
+nested inside, packed onto "cc" lanes the way make -j ran them.
+"""
+
+import json
+import logging
+import os
+import threading
+import time
+from contextlib import contextmanager
+from pathlib import Path
+from typing import Any, Dict, Iterator, List, Optional
+
+logger = logging.getLogger(__name__)
+
+# Lane thread IDs for merged compiler traces, clear of real thread IDs
+CC_LANE_BASE = 1_000_000
+
+_OBJECT_SUFFIXES = (".o", ".obj")
+
+
+def now_us() -> int:
+    return time.time_ns() // 1000
+
+
+class BuildTrace:
+    """Chrome trace of one build, appended to across processes"""
+
+    def __init__(self, path: os.PathLike, process_name: str = "build"):
+        self.path = Path(path)
+        self.pid = os.getpid()
+        self.events: List[Dict[str, Any]] = []
+        if self.path.exists():
+            try:
+                self.events = json.loads(self.path.read_text()).get("traceEvents", [])
+            except (OSError, ValueError) as e:
+                logger.warning(f"⚠️ Ignoring unreadable trace {self.path}: {e}")
+        self._metadata("process_name", {"name": f"{process_name} ({self.pid})"})
+        self._named_threads = set()
+
+    def _metadata(self, name: str, args: Dict[str, Any], tid: int = 0) -> None:
+        self.events.append({"name": name, "ph": "M", "pid": self.pid, "tid": tid, "args": args})
+
+    def _tid(self) -> int:
+        tid = threading.get_native_id()
+        if tid not in self._named_threads:
+            self._named_threads.add(tid)
+            self._metadata("thread_name", {"name": threading.current_thread().name}, tid)
+        return tid
+
+    def add(self, name: str, start_us: int, duration_us: int, category: str = "build",
+            args: Optional[Dict[str, Any]] = None, tid: Optional[int] = None) -> None:
+        """A complete event; tid defaults to the calling thread"""
+        event = {"name": name, "cat": category, "ph": "X", "ts": start_us, "dur": max(duration_us, 0),
+                 "pid": self.pid, "tid": self._tid() if tid is None else tid}
+        if args:
+            event["args"] = args
+        self.events.append(event)
+
+    @contextmanager
+    def span(self, name: str, category: str = "build", **args: Any) -> Iterator[Dict[str, Any]]:
+        """
+        Time the with-block as one event. The yielded dict becomes the
+        event's args, so callers can attach results (exit codes, counts).
+        A block that raises is recorded with args["error"].
+        """
+        start = now_us()
+        try:
+            yield args
+        except BaseException as e:
+            args["error"] = type(e).__name__
+            raise
+        finally:
+            self.add(name, start, now_us() - start, category, args)
+
+    def merge_clang_time_traces(self, build_dir: os.PathLike, since_us: int = 0) -> int:
+        """
+        Add the -ftime-trace files under build_dir written after since_us.
+        Returns the number of translation units merged.
+        """
+        build_dir = Path(build_dir)
+        units = []
+        for trace_file in build_dir.rglob("*.json"):
+            if not any(trace_file.with_suffix(s).exists() for s in _OBJECT_SUFFIXES):
+                continue
+            try:
+                if trace_file.stat().st_mtime_ns // 1000 < since_us:
+                    continue
+                unit = _load_clang_trace(trace_file)
+            except (OSError, ValueError):
+                continue
+            if unit:
+                units.append((unit[0], unit[1], trace_file, unit[2]))
+
+        lanes: List[int] = []
+        for start, duration, trace_file, events in sorted(units, key=lambda u: u[0]):
+            lane = next((i for i, end in enumerate(lanes) if end <= start), len(lanes))
+            if lane == len(lanes):
+                lanes.append(0)
+                self._metadata("thread_name", {"name": f"cc {lane + 1}"}, CC_LANE_BASE + lane)
+            lanes[lane] = start + duration
+            tid = CC_LANE_BASE + lane
+            name = str(trace_file.with_suffix(".o").relative_to(build_dir))
+            self.add(name, start, duration, "compile", tid=tid)
+            for event in events:
+                self.add(event["name"], start + event["ts"], event["dur"], "clang",
+                         event.get("args"), tid=tid)
+        if units:
+            logger.info(f"⏱️ Merged {len(units)} -ftime-trace files on {len(lanes)} lanes")
+        return len(units)
+
+    def save(self) -> Path:
+        self.path.parent.mkdir(parents=True, exist_ok=True)
+        tmp = self.path.with_suffix(self.path.suffix + ".tmp")
+        tmp.write_text(json.dumps({"traceEvents": self.events, "displayTimeUnit": "ms"}))
+        os.replace(tmp, self.path)
+        return self.path
+
+
+def _load_clang_trace(path: Path):
+    """
+    (start_us, duration_us, events) of one Clang time trace. Event ts are
+    relative to the compiler's start; "beginningOfTime" (Clang 11+) gives
+    the absolute start, otherwise it is derived from the file's mtime.
+    """
+    data = json.loads(path.read_text())
+    if not isinstance(data, dict) or "traceEvents" not in data:
+        return None
+    events = [e for e in data["traceEvents"]
+              if e.get("ph") == "X" and not str(e.get("name", "")).startswith("Total ")]
+    if not events:
+        return None
+    duration = max(e["ts"] + e["dur"] for e in events)
+    start = data.get("beginningOfTime") or path.stat().st_mtime_ns // 1000 - duration
+    return int(start), int(duration), events
+
+
+def main() -> int:
+    """Merge -ftime-trace files from a build tree into a trace file"""
+    import argparse
+
+    parser = argparse.ArgumentParser(description="Merge Clang -ftime-trace output into a Chrome trace")
+    parser.add_argument("build_dir", type=Path, help="Build tree holding *.o and their *.json traces")
+    parser.add_argument("-o", "--output", type=Path, default=Path("build-trace.json"), help="Trace file")
+    args = parser.parse_args()
+
+    trace = BuildTrace(args.output, "compile")
+    merged = trace.merge_clang_time_traces(args.build_dir)
+    print(f"{merged} translation units -> {trace.save()}")
+    return 0
+
+
+if __name__ == "__main__":
+    raise SystemExit(main())
@@ -14,6 +14,20 @@ from pathlib import Path
 from typing import Dict, List, Optional, Tuple
 import argparse
 
+try:
+    from .file_hashing import FileHasher, hash_file
+except ImportError:
+    from file_hashing import FileHasher, hash_file
+
+try:
+    from openssl_tools.config_snapshot import load_config
+except ImportError:  # Run as a script without openssl_tools installed
+    def load_config(path, default=None):
+        if not os.path.exists(path):
+            return default
+        with open(path, 'r') as f:
+            return yaml.safe_load(f)
+
 
 class CacheOptimizer:
     """Cache optimization for OpenSSL Conan packages"""
@@ -21,13 +35,12 @@ class CacheOptimizer:
     def __init__(self, config_file: str = "conan-dev/cache-optimization.yml"):
         self.config_file = config_file
         self.config = self._load_config()
+        self.file_hasher = FileHasher()
         
     def _load_config(self) -> Dict:
         """Load cache optimization configuration"""
-        if os.path.exists(self.config_file):
-            with open(self.config_file, 'r') as f:
-                return yaml.safe_load(f)
-        return self._get_default_config()
+        config = load_config(self.config_file)
+        return config if config is not None else self._get_default_config()
     
     def _get_default_config(self) -> Dict:
         """Get default cache optimization configuration"""
@@ -81,19 +94,21 @@ class CacheOptimizer:
         
         # Include important source files
         include_files = self.config['cache']['key_strategies']['source']['include']
+        files = []
         for file_pattern in include_files:
             if '*' in file_pattern:
                 # Handle glob patterns
                 import glob
-                files = glob.glob(file_pattern)
-            else:
-                files = [file_pattern] if os.path.exists(file_pattern) else []
-            
-            for file_path in files:
-                if os.path.exists(file_path):
-                    file_hash = self._calculate_file_hash(file_path)
-                    if file_hash:
-                        key_parts.append(f"{file_path}:{file_hash[:8]}")
+                files.extend(glob.glob(file_pattern, recursive=True))
+            elif os.path.exists(file_pattern):
+                files.append(file_pattern)
+        
+        # One batch: unchanged files come from the stat cache, the rest in parallel
+        digests = self.file_hasher.hash_files(files)
+        for file_path in files:
+            file_hash = digests.get(os.path.abspath(file_path))
+            if file_hash:
+                key_parts.append(f"{file_path}:{file_hash[:8]}")
         
         # Sort for consistent ordering
         key_parts.sort()
@@ -158,14 +173,12 @@ class CacheOptimizer:
         combined_content = f"source:{source_key}|binary:{binary_key}"
         return hashlib.sha256(combined_content.encode()).hexdigest()
     
-    def _calculate_file_hash(self, file_path: str, algorithm: str = 'sha256') -> Optional[str]:
-        """Calculate hash of a file"""
+    def _calculate_file_hash(self, file_path: str, algorithm: Optional[str] = None) -> Optional[str]:
+        """Calculate hash of a file (stat-cached fast hash unless an algorithm is given)"""
         try:
-            hash_func = getattr(hashlib, algorithm)()
-            with open(file_path, 'rb') as f:
-                for chunk in iter(lambda: f.read(4096), b""):
-                    hash_func.update(chunk)
-            return hash_func.hexdigest()
+            if algorithm is None:
+                return self.file_hasher.hash_file(file_path)
+            return hash_file(file_path, algorithm)
         except Exception as e:
             print(f"Warning: Could not calculate hash for {file_path}: {e}")
             return None
@@ -304,13 +317,14 @@ class CacheOptimizer:
         except Exception as e:
             print(f"Warning: Could not clean cache: {e}")
     
-    def generate_cache_report(self) -> Dict:
+    def generate_cache_report(self, report_file: str = 'cache-performance-report.json',
+                              include_keys: bool = True) -> Dict:
         """Generate cache performance report"""
         print("📊 Generating cache report...")
         
         report = {
             'timestamp': str(os.environ.get('SOURCE_DATE_EPOCH', '')),
-            'cache_keys': self.optimize_cache_keys(),
+            'cache_keys': self.optimize_cache_keys() if include_keys else {},
             'environment': {
                 'CONAN_CPU_COUNT': os.environ.get('CONAN_CPU_COUNT', ''),
                 'CCACHE_DIR': os.environ.get('CCACHE_DIR', ''),
@@ -320,7 +334,6 @@ class CacheOptimizer:
         }
         
         # Save report
-        report_file = 'cache-performance-report.json'
         with open(report_file, 'w') as f:
             json.dump(report, f, indent=2)
         
@@ -350,21 +363,50 @@ class CacheOptimizer:
         return performance
     
     def _parse_ccache_stats(self, stats_output: str) -> Dict:
-        """Parse CCache statistics"""
+        """Parse CCache statistics (ccache 4 "Hits: 12 / 20" or ccache 3 counters)"""
         stats = {}
+        hits = misses = 0
         for line in stats_output.split('\n'):
             if ':' in line:
                 key, value = line.split(':', 1)
                 stats[key.strip()] = value.strip()
-        return stats
+                words = value.split()
+                if key.strip() in ('Hits', 'Misses') and words and words[0].isdigit():
+                    # ccache 4 prints the cacheable-call totals first
+                    if key.strip() == 'Hits' and 'hits' not in stats:
+                        stats['hits'] = hits = int(words[0])
+                    elif key.strip() == 'Misses' and 'misses' not in stats:
+                        stats['misses'] = misses = int(words[0])
+            else:
+                # ccache 3: "cache hit (direct)             12"
+                key, _, value = line.strip().rpartition(' ')
+                if key and value.isdigit():
+                    stats[key.strip()] = value
+                    if key.startswith('cache hit'):
+                        hits += int(value)
+                    elif key.strip() == 'cache miss':
+                        misses += int(value)
+        return self._with_hit_rate(stats, hits, misses)
     
     def _parse_sccache_stats(self, stats_output: str) -> Dict:
-        """Parse SCCache statistics"""
+        """Parse SCCache statistics ("Cache hits   12" columns)"""
         stats = {}
+        hits = misses = 0
         for line in stats_output.split('\n'):
-            if ':' in line:
-                key, value = line.split(':', 1)
-                stats[key.strip()] = value.strip()
+            key, _, value = line.strip().rpartition(' ')
+            if not key or not value.isdigit():
+                continue
+            key = key.strip()
+            stats[key] = value
+            if key == 'Cache hits':
+                hits = int(value)
+            elif key == 'Cache misses':
+                misses = int(value)
+        return self._with_hit_rate(stats, hits, misses)
+    
+    def _with_hit_rate(self, stats: Dict, hits: int, misses: int) -> Dict:
+        if hits + misses:
+            stats.update(hits=hits, misses=misses, hit_rate=hits / (hits + misses))
         return stats
     
     def run_optimization(self):
@@ -0,0 +1,431 @@
+#!/usr/bin/env python3
+"""
+Change impact graph for CI profile selection
+
+Maps what a change touches to the profile axes (profiles/axes.yaml) it
+can affect, and from there to the configurations that need a rebuild:
+
+- recipe methods: the call graph of the sparetools-openssl ConanFile
+  (`self.<name>` references). A changed method affects the variants whose
+  build entry point (_build_with_perl, _build_with_python, ...) reaches
+  it; one reached from a public Conan hook (build, package, ...) affects
+  every configuration.
+- profiles: a changed profile affects itself and every configuration
+  that include()s it, directly or transitively. A fragment nobody
+  includes affects the axes its own settings/options pin (os=Macos,
+  *:fips=True, *:build_method=cmake, ...).
+- configure.py functions only run in the hybrid (python) variant.
+- provider_ordering.py, which only the hybrid builder uses: a
+  PROVIDER_GRAPH entry affects the hybrid configurations of the releases
+  it applies to (openssl_version_min), and the fips entry only FIPS ones.
+
+Impacts are selectors, {axis: allowed values}; an axis a configuration
+does not define never excludes it, and {} selects everything. Python
+files are diffed at function granularity, so a hunk inside
+_build_with_cmake does not rebuild the perl profiles. Files the graph has
+no rule for are left to the caller (BuildMatrixGenerator's path
+categories).
+"""
+
+import ast
+import fnmatch
+import re
+import subprocess
+from dataclasses import dataclass, field
+from pathlib import Path, PurePosixPath
+from typing import Dict, Iterable, List, Optional, Set, Tuple
+
+Selector = Dict[str, Set[str]]
+
+RECIPE_PATTERN = "*sparetools-openssl/conanfile.py"
+CONFIGURE_PY_PATTERN = "*sparetools-openssl-hybrid/configure.py"
+PROVIDER_ORDERING_PATTERN = "*openssl_tools/openssl/provider_ordering.py"
+PROFILE_PATTERNS = ["*.profile", "*profiles/base/*", "*profiles/features/*", "*profiles/build-methods/*"]
+PROFILE_INDEX_PATTERNS = ["*profiles/axes.yaml", "*profiles/index.json"]
+
+HYBRID: Selector = {"variant": {"hybrid"}}
+
+# Recipe methods that only some configurations run
+RECIPE_ENTRY_POINTS: Dict[str, Selector] = {
+    "_build_with_perl": {"variant": {"perl-configure"}},
+    "_build_with_cmake": {"variant": {"cmake"}},
+    "_build_with_autotools": {"variant": {"autotools"}},
+    "_build_with_python": HYBRID,
+    "_build_universal": {"operating_system": {"macos"}},
+    # Returns None unless build_method is perl or python
+    "_incremental_dir": {"variant": {"perl-configure", "hybrid"}},
+}
+
+# Profile [settings]/[options]/[conf] values that pin an axis
+PROFILE_AXES = {
+    "os": ("operating_system", {"linux": "linux", "windows": "windows", "macos": "macos"}),
+    "arch": ("architecture", {"x86_64": "x86_64", "armv8": "arm64", "x86": "x86"}),
+    "compiler": ("compiler", {"gcc": "gcc", "clang": "clang", "apple-clang": "clang", "msvc": "msvc"}),
+    "fips": ("fips_mode", {"true": "fips-on", "false": "fips-off"}),
+    "enable_fips": ("fips_mode", {"true": "fips-on", "false": "fips-off"}),
+    "shared": ("linkage", {"true": "shared", "false": "static"}),
+    # SIMD and fat-binary options only mean something on their architecture/OS
+    "enable_neon": ("architecture", {"true": "arm64"}),
+    "enable_sve": ("architecture", {"true": "arm64"}),
+    "enable_avx": ("architecture", {"true": "x86_64"}),
+    "enable_avx2": ("architecture", {"true": "x86_64"}),
+    "universal": ("operating_system", {"true": "macos"}),
+    "build_method": ("variant", {"perl": "perl-configure", "cmake": "cmake", "autotools": "autotools",
+                                 "python": "hybrid"}),
+    "user.sparetools.openssl:variant": ("variant", {"perl-configure": "perl-configure", "cmake": "cmake",
+                                                    "autotools": "autotools", "hybrid": "hybrid"}),
+}
+
+_HUNK = re.compile(r"^@@ -\d+(?:,\d+)? \+(\d+)(?:,(\d+))? @@")
+_INCLUDE = re.compile(r"^\s*include\((.+)\)\s*$")
+
+
+@dataclass
+class ChangedFile:
+    """A changed path, the line ranges changed in its new version and that version's text"""
+    path: str
+    lines: Optional[List[Tuple[int, int]]] = None  # None: the whole file
+    source: Optional[str] = None  # None: deleted or unavailable
+
+
+@dataclass
+class Impact:
+    """Configurations a change affects, and why"""
+    selector: Selector
+    reason: str
+
+
+@dataclass
+class ImpactSelection:
+    """Configurations to rebuild, each with the reasons that selected it"""
+    configurations: List[str]
+    reasons: Dict[str, List[str]] = field(default_factory=dict)
+    uncovered: List[str] = field(default_factory=list)
+
+    def to_dict(self) -> Dict:
+        return {"configurations": self.configurations, "reasons": self.reasons, "uncovered": self.uncovered}
+
+
+def hunk_ranges(patch: str) -> List[Tuple[int, int]]:
+    """New-file line ranges of a unified diff's hunks; a pure deletion marks the line next to it"""
+    ranges = []
+    for line in patch.splitlines():
+        match = _HUNK.match(line)
+        if match:
+            start, length = int(match.group(1)), int(match.group(2) or 1)
+            ranges.append((start, start + max(length, 1) - 1))
+    return ranges
+
+
+def git_changes(repo_dir: Path, base: str, head: str = "HEAD") -> List[ChangedFile]:
+    """Changes between the merge base of base and head, and head"""
+    def git(*args: str) -> subprocess.CompletedProcess:
+        return subprocess.run(["git"] + list(args), cwd=repo_dir, capture_output=True, text=True)
+
+    result = git("diff", "-U0", "--no-color", "--no-ext-diff", f"{base}...{head}")
+    if result.returncode != 0:
+        raise RuntimeError(f"git diff {base}...{head} failed: {result.stderr.strip()}")
+    patches: Dict[str, List[str]] = {}
+    current = None
+    for line in result.stdout.splitlines():
+        if line.startswith("diff --git "):
+            current = line.split(" b/", 1)[-1]
+            patches[current] = []
+        elif line.startswith("+++ ") and current is not None and line[4:] != "/dev/null":
+            current_lines = patches.pop(current)
+            current = line[6:] if line.startswith("+++ b/") else line[4:]
+            patches[current] = current_lines
+        elif current is not None:
+            patches[current].append(line)
+
+    changes = []
+    for path, lines in patches.items():
+        shown = git("show", f"{head}:{path}")
+        changes.append(ChangedFile(path, hunk_ranges("\n".join(lines)) or None,
+                                   shown.stdout if shown.returncode == 0 else None))
+    return changes
+
+
+def python_symbols(source: str) -> List[Tuple[str, int, int]]:
+    """
+    (name, first line, last line) of the functions, classes and top-level
+    assignments in source. Methods are "Class.method", dict entries of a
+    top-level assignment "NAME[key]". Innermost spans come last.
+    """
+    symbols = []
+
+    def visit(nodes, prefix):
+        for node in nodes:
+            if isinstance(node, (ast.FunctionDef, ast.AsyncFunctionDef, ast.ClassDef)):
+                name = f"{prefix}{node.name}"
+                start = min([node.lineno] + [d.lineno for d in node.decorator_list])
+                symbols.append((name, start, node.end_lineno))
+                if isinstance(node, ast.ClassDef):
+                    visit(node.body, f"{name}.")
+            elif isinstance(node, (ast.Assign, ast.AnnAssign)):
+                targets = node.targets if isinstance(node, ast.Assign) else [node.target]
+                for target in targets:
+                    if not isinstance(target, ast.Name):
+                        continue
+                    name = f"{prefix}{target.id}"
+                    symbols.append((name, node.lineno, node.end_lineno))
+                    if isinstance(node.value, ast.Dict):
+                        for key, value in zip(node.value.keys, node.value.values):
+                            if isinstance(key, ast.Constant):
+                                symbols.append((f"{name}[{key.value}]", key.lineno, value.end_lineno))
+
+    visit(ast.parse(source).body, "")
+    return symbols
+
+
+def changed_symbols(change: ChangedFile) -> Set[str]:
+    """Innermost symbols the changed lines fall in; "<module>" for lines outside all of them"""
+    if change.source is None or change.lines is None:
+        return {"<module>"}
+    try:
+        symbols = python_symbols(change.source)
+    except SyntaxError:
+        return {"<module>"}
+    text = change.source.splitlines()
+    touched = set()
+    for first, last in change.lines:
+        for line in range(first, last + 1):
+            # Blank and comment lines between definitions change nothing
+            if line <= len(text) and text[line - 1].strip().startswith("#") or \
+                    line <= len(text) and not text[line - 1].strip():
+                continue
+            enclosing = [s for s in symbols if s[1] <= line <= s[2]]
+            # Innermost: the enclosing span that starts last
+            touched.add(max(enclosing, key=lambda s: (s[1], -s[2]))[0] if enclosing else "<module>")
+    return touched
+
+
+def self_references(source: str, class_name: Optional[str] = None) -> Dict[str, Set[str]]:
+    """{member: names it references as self.<name>} for the members of class_name (or the first class)"""
+    tree = ast.parse(source)
+    classes = [n for n in tree.body if isinstance(n, ast.ClassDef) and class_name in (None, n.name)]
+    if not classes:
+        return {}
+    graph: Dict[str, Set[str]] = {}
+    for node in classes[0].body:
+        if isinstance(node, (ast.FunctionDef, ast.AsyncFunctionDef)):
+            names = [node.name]
+        elif isinstance(node, ast.Assign):
+            names = [t.id for t in node.targets if isinstance(t, ast.Name)]
+        else:
+            continue
+        refs = {n.attr for n in ast.walk(node) if isinstance(n, ast.Attribute)
+                and isinstance(n.value, ast.Name) and n.value.id == "self"}
+        for name in names:
+            graph[name] = refs
+    return graph
+
+
+def profile_includes(text: str) -> List[str]:
+    return [m.group(1).strip().strip("\"'") for m in map(_INCLUDE.match, text.splitlines()) if m]
+
+
+def profile_selector(text: str) -> Selector:
+    """Axes a profile fragment's own settings, options and conf pin"""
+    selector: Selector = {}
+    for line in text.splitlines():
+        line = line.split("#", 1)[0].strip()
+        if "=" not in line or line.startswith("["):
+            continue
+        key, value = (part.strip() for part in line.split("=", 1))
+        key = key.rsplit(":", 1)[-1] if not key.startswith("user.") else key
+        axis = PROFILE_AXES.get(key)
+        if axis and value.lower() in axis[1]:
+            selector.setdefault(axis[0], set()).add(axis[1][value.lower()])
+    return selector
+
+
+def describe(selector: Selector) -> str:
+    """"variant=hybrid, fips_mode=fips-on" for a selector"""
+    return ", ".join(f"{axis}={'|'.join(sorted(values))}" for axis, values in sorted(selector.items()))
+
+
+def _release_key(value: str) -> Tuple[int, ...]:
+    """"v3_6_0" (axes.yaml id) or "3.6.0" as a comparable tuple"""
+    return tuple(int(part) for part in re.findall(r"\d+", value))
+
+
+def _matches(path: str, patterns: Iterable[str]) -> bool:
+    return any(fnmatch.fnmatch(path, p) for p in patterns)
+
+
+class ImpactGraph:
+    """Change impact over a set of configurations ({"id", "axes", optional "path" of its profile})"""
+
+    def __init__(self, configurations: List[Dict], profile_roots: Optional[List[Path]] = None):
+        self.configurations = configurations
+        self.profile_roots = [Path(p) for p in profile_roots or []]
+        self._includes: Optional[Dict[str, Set[Path]]] = None
+
+    # -- selectors ----------------------------------------------------------
+
+    @staticmethod
+    def _selects(selector: Selector, configuration: Dict) -> bool:
+        axes = configuration.get("axes", {})
+        for axis, values in selector.items():
+            value = configuration.get("id") if axis == "profile" else axes.get(axis)
+            if value is not None and value not in values:
+                return False
+        return True
+
+    def releases_from(self, minimum: str) -> Set[str]:
+        """openssl_release values of the configurations at or above a version"""
+        return {c["axes"]["openssl_release"] for c in self.configurations
+                if "openssl_release" in c.get("axes", {})
+                and _release_key(c["axes"]["openssl_release"]) >= _release_key(minimum)}
+
+    # -- rules --------------------------------------------------------------
+
+    def _recipe_impacts(self, change: ChangedFile) -> List[Impact]:
+        if change.source is None:
+            return [Impact({}, f"{change.path}: recipe removed")]
+        graph = self_references(change.source)
+        callers: Dict[str, Set[str]] = {}
+        for member, refs in graph.items():
+            for ref in refs:
+                callers.setdefault(ref, set()).add(member)
+
+        impacts = []
+        for symbol in sorted(changed_symbols(change)):
+            member = symbol.split("[", 1)[0].split(".")[-1] if "." in symbol else None
+            where = f"{change.path}: {symbol}"
+            if member is None or member in ("options", "default_options", "settings"):
+                impacts.append(Impact({}, f"{where} (recipe-wide)"))
+                continue
+            # Walk up the callers, stopping at entry points and public Conan hooks
+            entries, hooks, seen, todo = set(), set(), {member}, [member]
+            while todo:
+                name = todo.pop()
+                if name in RECIPE_ENTRY_POINTS:
+                    entries.add(name)
+                    continue
+                if not name.startswith("_") and name in graph:
+                    hooks.add(name)
+                    continue
+                for caller in callers.get(name, ()):
+                    if caller not in seen:
+                        seen.add(caller)
+                        todo.append(caller)
+            if hooks or not entries:
+                via = ("Conan hook" if hooks == {member} else f"reached from {', '.join(sorted(hooks))}()") \
+                    if hooks else "no build entry point reaches it"
+                impacts.append(Impact({}, f"{where} ({via})"))
+                continue
+            for entry in sorted(entries):
+                via = "" if entry == member else f"via {entry}(), "
+                impacts.append(Impact(RECIPE_ENTRY_POINTS[entry],
+                                      f"{where} ({via}{describe(RECIPE_ENTRY_POINTS[entry])} only)"))
+        return impacts
+
+    def _configure_py_impacts(self, change: ChangedFile) -> List[Impact]:
+        return [Impact(HYBRID, f"{change.path}: {symbol} (configure.py runs in the hybrid variant)")
+                for symbol in sorted(changed_symbols(change))]
+
+    def _provider_ordering_impacts(self, change: ChangedFile) -> List[Impact]:
+        minimums: Dict[str, str] = {}
+        if change.source is not None:
+            for node in ast.walk(ast.parse(change.source)):
+                if isinstance(node, ast.Call):
+                    keywords = {k.arg: k.value for k in node.keywords}
+                    name, minimum = keywords.get("name"), keywords.get("openssl_version_min")
+                    if isinstance(name, ast.Constant) and isinstance(minimum, ast.Constant):
+                        minimums[name.value] = minimum.value
+        impacts = []
+        for symbol in sorted(changed_symbols(change)):
+            where = f"{change.path}: {symbol}"
+            match = re.fullmatch(r"PROVIDER_GRAPH\[(.+)\]", symbol)
+            if not match:
+                impacts.append(Impact(HYBRID, f"{where} (provider ordering runs in the hybrid variant)"))
+                continue
+            provider = match.group(1)
+            selector = dict(HYBRID)
+            if provider == "fips":
+                selector["fips_mode"] = {"fips-on"}
+            if provider in minimums:
+                selector["openssl_release"] = self.releases_from(minimums[provider])
+            impacts.append(Impact(selector, f"{where} (provider {provider}, OpenSSL >= "
+                                            f"{minimums.get(provider, '3.0.0')})"))
+        return impacts
+
+    def _resolve_include(self, name: str, including: Path) -> Optional[Path]:
+        for base in [including.parent] + self.profile_roots:
+            candidate = (base / name).resolve()
+            if candidate.is_file():
+                return candidate
+        return None
+
+    def _include_closure(self) -> Dict[str, Set[Path]]:
+        """{configuration id: its profile and everything it includes, as resolved paths}"""
+        if self._includes is None:
+            self._includes = {}
+            for configuration in self.configurations:
+                if not configuration.get("path"):
+                    continue
+                closure: Set[Path] = set()
+                todo = [Path(configuration["path"]).resolve()]
+                while todo:
+                    path = todo.pop()
+                    if path in closure or not path.is_file():
+                        continue
+                    closure.add(path)
+                    for name in profile_includes(path.read_text(encoding="utf-8", errors="replace")):
+                        included = self._resolve_include(name, path)
+                        if included is not None:
+                            todo.append(included)
+                self._includes[configuration["id"]] = closure
+        return self._includes
+
+    def _profile_impacts(self, change: ChangedFile, repo_dir: Path) -> List[Impact]:
+        path = (repo_dir / change.path).resolve()
+        including = sorted(config_id for config_id, closure in self._include_closure().items() if path in closure)
+        if including:
+            return [Impact({"profile": set(including)}, f"{change.path}: profile included by "
+                                                          f"{', '.join(including)}")]
+        selector = profile_selector(change.source or "")
+        return [Impact(selector, f"{change.path}: profile fragment pinning {describe(selector) or 'no axis'}")]
+
+    def impacts(self, change: ChangedFile, repo_dir: Path = Path(".")) -> Optional[List[Impact]]:
+        """Impacts of one changed file; None when the graph has no rule for it"""
+        path = change.path
+        if fnmatch.fnmatch(path, RECIPE_PATTERN):
+            return self._recipe_impacts(change)
+        if fnmatch.fnmatch(path, CONFIGURE_PY_PATTERN):
+            return self._configure_py_impacts(change)
+        if fnmatch.fnmatch(path, PROVIDER_ORDERING_PATTERN):
+            return self._provider_ordering_impacts(change)
+        if _matches(path, PROFILE_INDEX_PATTERNS):
+            return [Impact({}, f"{path}: profile axes definition")]
+        if _matches(path, PROFILE_PATTERNS) and PurePosixPath(path).suffix not in (".md", ".json", ".yaml"):
+            return self._profile_impacts(change, repo_dir)
+        return None
+
+    def select(self, impacts: List[Impact]) -> ImpactSelection:
+        """The configurations any impact selects, with reasons; impacts no configuration covers"""
+        reasons: Dict[str, List[str]] = {}
+        uncovered = []
+        for impact in impacts:
+            hit = [c["id"] for c in self.configurations if self._selects(impact.selector, c)]
+            if not hit:
+                uncovered.append(impact.reason)
+            for config_id in hit:
+                if impact.reason not in reasons.setdefault(config_id, []):
+                    reasons[config_id].append(impact.reason)
+        order = [c["id"] for c in self.configurations if c["id"] in reasons]
+        return ImpactSelection(order, reasons, uncovered)
+
+
+def format_report(selection: ImpactSelection, total: int) -> str:
+    """Dry-run explanation of a selection"""
+    lines = [f"Selected {len(selection.configurations)} of {total} configurations"]
+    for config_id in selection.configurations:
+        lines.append(f"  {config_id}")
+        lines += [f"    - {reason}" for reason in selection.reasons[config_id]]
+    if selection.uncovered:
+        lines.append("Changes no configuration exercises:")
+        lines += [f"  - {reason}" for reason in selection.uncovered]
+    return "\n".join(lines)
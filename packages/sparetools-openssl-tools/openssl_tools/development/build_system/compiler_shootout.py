@@ -0,0 +1,374 @@
+#!/usr/bin/env python3
+"""
+Compiler shoot-out across the base profiles
+
+Builds sparetools-openssl once per contender — a base profile
+(profiles/base/linux-gcc11, ...) optionally overlaid with feature profiles
+("linux-clang18+tuned-x86-64-v4") — builds the test_package benchmarks
+with the same compiler, and runs them with StatisticalBenchmarkRunner.
+
+Metrics are grouped into algorithm classes (AES, ChaCha20-Poly1305,
+digests, ECC and PQC handshakes, bignum). A contender's class score is the
+geometric mean of its speed-ups over the reference contender on the
+class's metrics; the class winner's lead over the runner-up is marked
+significant when most of those metrics improve under the same
+Mann-Whitney U test as baselines. The contender with the best geometric
+mean over all class scores is the recommended binary, and can be uploaded
+to a remote as the recommended package revision.
+
+The package reference of every contender comes from `conan create
+--format=json`; prebuilt installs given with --prefix have none and are
+never published.
+"""
+
+import json
+import logging
+import math
+import platform
+import re
+import shlex
+import statistics
+import subprocess
+from dataclasses import dataclass, field, asdict
+from datetime import datetime
+from pathlib import Path
+from typing import Any, Dict, List, Optional, Tuple
+
+from .benchmark_matrix import build_benchmarks, find_bench_binary
+from .statistical_runner import StatisticalBenchmarkRunner, compare_samples
+
+logger = logging.getLogger(__name__)
+
+TOOLS_ROOT = Path(__file__).resolve().parents[3]
+DEFAULT_PROFILES_DIR = TOOLS_ROOT / "profiles"
+
+DEFAULT_CONTENDERS = ["linux-gcc11", "linux-clang14", "linux-clang18"]
+DEFAULT_BENCHES = ["bench_evp", "bench_handshake", "bench_bn"]
+
+# First match wins; ids are "<bench>:<metric id>" as in BenchmarkMatrix
+ALGORITHM_CLASSES: List[Tuple[str, str]] = [
+    ("aes", r"^bench_evp:AES-"),
+    ("chacha20-poly1305", r"^bench_evp:ChaCha20"),
+    ("digest", r"^bench_evp:(SHA|SHA3|HMAC)"),
+    ("pqc-handshake", r"^bench_handshake:.*MLKEM"),
+    ("ecc-handshake", r"^bench_handshake:"),
+    # mod_exp, mont_mul, prime_gen and rsa_sign, under each bench_bn capability profile
+    ("bignum", r"^bench_bn:"),
+]
+
+
+def algorithm_class(metric_id: str) -> str:
+    """Algorithm class of a metric, "other" when no class matches"""
+    return next((name for name, pattern in ALGORITHM_CLASSES if re.search(pattern, metric_id)), "other")
+
+
+def read_profile(path: Path) -> Dict[str, Dict[str, str]]:
+    """Sections of a Conan profile as {section: {key: value}}"""
+    sections: Dict[str, Dict[str, str]] = {}
+    current = None
+    for line in path.read_text().splitlines():
+        line = line.strip()
+        if not line or line.startswith("#"):
+            continue
+        if line.startswith("[") and line.endswith("]"):
+            current = sections.setdefault(line[1:-1], {})
+        elif current is not None and "=" in line:
+            key, value = line.split("=", 1)
+            current[key.strip()] = value.strip()
+    return sections
+
+
+@dataclass
+class Contender:
+    """One base profile plus optional feature overlays"""
+    name: str
+    profiles: List[str] = field(default_factory=list)
+    compiler: str = "unknown"
+    compiler_executables: Dict[str, str] = field(default_factory=dict)
+    flags: Dict[str, str] = field(default_factory=dict)
+    prefix: Optional[str] = None
+    # Recipe options passed with -o on top of the profiles
+    options: Dict[str, str] = field(default_factory=dict)
+    package_ref: Optional[str] = None
+    skip_reason: Optional[str] = None
+    openssl_version: Optional[str] = None
+    samples: Dict[str, List[float]] = field(default_factory=dict)
+    higher_is_better: Dict[str, bool] = field(default_factory=dict)
+
+    @classmethod
+    def from_spec(cls, spec: str, profiles_dir: Path) -> "Contender":
+        """"linux-clang18+tuned-x86-64-v4": base profile, then feature overlays"""
+        base, *features = spec.split("+")
+        contender = cls(name=spec)
+        paths = [profiles_dir / "base" / base] + [profiles_dir / "features" / f for f in features]
+        missing = [str(p) for p in paths if not p.exists()]
+        if missing:
+            contender.skip_reason = f"profile not found: {', '.join(missing)}"
+            return contender
+        contender.profiles = [str(p) for p in paths]
+        for path in paths:
+            sections = read_profile(path)
+            settings = sections.get("settings", {})
+            if "compiler" in settings:
+                contender.compiler = f"{settings['compiler']} {settings.get('compiler.version', '')}".strip()
+            conf = sections.get("conf", {})
+            if "tools.build:compiler_executables" in conf:
+                contender.compiler_executables = json.loads(conf["tools.build:compiler_executables"])
+            for key in ("tools.build:cflags", "tools.build:exelinkflags", "tools.build:sharedlinkflags"):
+                if key in conf:
+                    contender.flags[key] = conf[key]
+            for key, value in sections.get("buildenv", {}).items():
+                if key in ("CFLAGS", "LDFLAGS"):
+                    contender.flags[key] = value
+            for key, value in sections.get("options", {}).items():
+                contender.flags[key] = value
+        return contender
+
+
+class CompilerShootout:
+    """Builds and benchmarks each contender, then picks winners per algorithm class"""
+
+    def __init__(self, work_dir: Path, recipe_dir: Path, version: str,
+                 profiles_dir: Path = DEFAULT_PROFILES_DIR, benches: Optional[List[str]] = None,
+                 trials: int = 5, warmup: int = 1, cpus: Optional[List[int]] = None,
+                 quick: bool = False, build_profile: str = "default",
+                 alpha: float = 0.01, min_effect_percent: float = 2.0):
+        self.work_dir = work_dir
+        self.work_dir.mkdir(parents=True, exist_ok=True)
+        self.recipe_dir = recipe_dir
+        self.test_package_dir = recipe_dir / "test_package"
+        self.version = version
+        self.profiles_dir = profiles_dir
+        self.benches = benches or DEFAULT_BENCHES
+        self.trials = trials
+        self.warmup = warmup
+        self.cpus = cpus
+        self.quick = quick
+        self.build_profile = build_profile
+        self.alpha = alpha
+        self.min_effect_percent = min_effect_percent
+
+    def plan(self, specs: List[str], prefixes: Optional[Dict[str, Path]] = None) -> List[Contender]:
+        """Resolve the contenders' profiles; prefixes maps a spec to a prebuilt install"""
+        contenders = []
+        for spec in specs:
+            contender = Contender.from_spec(spec, self.profiles_dir)
+            if (prefixes or {}).get(spec) is not None:
+                contender.prefix = str(prefixes[spec])
+            contenders.append(contender)
+        return contenders
+
+    def _conan_create(self, contender: Contender) -> Optional[Path]:
+        """conan create the recipe with the contender's profiles, returning its package folder"""
+        cmd = ["conan", "create", str(self.recipe_dir), "--version", self.version,
+               "-pr:b", self.build_profile]
+        for profile in contender.profiles:
+            cmd += ["-pr:h", profile]
+        for key, value in contender.options.items():
+            cmd += ["-o", f"{key}={value}"]
+        cmd += ["-c", "tools.build:skip_test=True", "--build=missing", "--format=json"]
+        logger.info(f"🔨 Building {contender.name}: {' '.join(cmd)}")
+        result = subprocess.run(cmd, capture_output=True, text=True)
+        if result.returncode != 0:
+            contender.skip_reason = f"conan create failed: {result.stderr.strip().splitlines()[-1:]}"
+            return None
+        graph = json.loads(result.stdout)
+        for node in graph.get("graph", {}).get("nodes", {}).values():
+            ref = str(node.get("ref", ""))
+            if ref.startswith("sparetools-openssl/") and node.get("package_folder"):
+                if node.get("package_id") and node.get("prev"):
+                    contender.package_ref = f"{ref}:{node['package_id']}#{node['prev']}"
+                return Path(node["package_folder"])
+        contender.skip_reason = "package folder not found in conan output"
+        return None
+
+    def _build_benches(self, contender: Contender) -> Optional[Path]:
+        """Build the benchmarks with the contender's compiler, so harness code matches"""
+        cmake_args = []
+        if "c" in contender.compiler_executables:
+            cmake_args.append(f"-DCMAKE_C_COMPILER={contender.compiler_executables['c']}")
+        build_dir, error = build_benchmarks(self.test_package_dir, Path(contender.prefix),
+                                            self.work_dir / "build" / contender.name, self.benches,
+                                            cmake_args)
+        if error:
+            contender.skip_reason = f"benchmark build failed: {error}"
+        return build_dir
+
+    def _measure(self, contender: Contender, build_dir: Path) -> None:
+        for bench in self.benches:
+            binary = find_bench_binary(build_dir, bench)
+            if binary is None:
+                logger.warning(f"⚠️ {bench} not built for {contender.name}")
+                continue
+            runner = StatisticalBenchmarkRunner(self.work_dir / "trials" / contender.name,
+                                                trials=self.trials, warmup=self.warmup, cpus=self.cpus)
+            trials = runner.run(binary, ["--quick"] if self.quick else [])
+            contender.openssl_version = trials.openssl_version
+            for metric_id, samples in trials.samples.items():
+                contender.samples[f"{bench}:{metric_id}"] = samples
+                contender.higher_is_better[f"{bench}:{metric_id}"] = trials.higher_is_better
+
+    def run(self, contenders: List[Contender]) -> List[Contender]:
+        """Build (unless prebuilt) and benchmark every contender, in order"""
+        for contender in contenders:
+            if contender.skip_reason:
+                logger.info(f"⏭️ {contender.name}: {contender.skip_reason}")
+                continue
+            if contender.prefix is None:
+                prefix = self._conan_create(contender)
+                if prefix is None:
+                    logger.warning(f"⚠️ {contender.name}: {contender.skip_reason}")
+                    continue
+                contender.prefix = str(prefix)
+            build_dir = self._build_benches(contender)
+            if build_dir is None:
+                logger.warning(f"⚠️ {contender.name}: {contender.skip_reason}")
+                continue
+            try:
+                self._measure(contender, build_dir)
+            except (OSError, RuntimeError, ValueError, subprocess.TimeoutExpired) as e:
+                contender.skip_reason = f"benchmark failed: {e}"
+                logger.warning(f"⚠️ {contender.name}: {contender.skip_reason}")
+                continue
+            logger.info(f"✅ {contender.name}: {len(contender.samples)} metrics ({contender.openssl_version})")
+        return contenders
+
+    @staticmethod
+    def _geomean(values: List[float]) -> float:
+        values = [v for v in values if v > 0]
+        return math.exp(sum(math.log(v) for v in values) / len(values)) if values else 0.0
+
+    def _speedup(self, metric_id: str, current: Contender, reference: Contender) -> float:
+        cur = statistics.median(current.samples[metric_id])
+        base = statistics.median(reference.samples[metric_id])
+        if not cur or not base:
+            return 0.0
+        return cur / base if reference.higher_is_better[metric_id] else base / cur
+
+    def compare(self, contenders: List[Contender]) -> Dict[str, Any]:
+        """Class scores, per-class winners and the overall recommendation"""
+        contender_data = []
+        for c in contenders:
+            data = asdict(c)
+            data.pop("samples")
+            data.pop("higher_is_better")
+            contender_data.append(data)
+
+        measured = [c for c in contenders if c.samples]
+        result: Dict[str, Any] = {"reference": None, "measured": [c.name for c in measured],
+                                  "contenders": contender_data, "classes": {}, "recommended": None}
+        if not measured:
+            return result
+        ref = measured[0]
+        result["reference"] = ref.name
+
+        # Only metrics every contender measured, so the scores cover the same work
+        common = [m for m in sorted(ref.samples) if all(m in c.samples for c in measured)]
+        by_class: Dict[str, List[str]] = {}
+        for metric_id in common:
+            by_class.setdefault(algorithm_class(metric_id), []).append(metric_id)
+
+        overall: Dict[str, List[float]] = {c.name: [] for c in measured}
+        for class_name, metrics in by_class.items():
+            scores = {c.name: self._geomean([self._speedup(m, c, ref) for m in metrics]) for c in measured}
+            ranking = sorted(measured, key=lambda c: scores[c.name], reverse=True)
+            winner = ranking[0]
+            improvements = 0
+            if len(ranking) > 1:
+                runner_up = ranking[1]
+                for metric_id in metrics:
+                    comparison = compare_samples(metric_id, winner.samples[metric_id],
+                                                 runner_up.samples[metric_id],
+                                                 winner.higher_is_better[metric_id],
+                                                 self.alpha, self.min_effect_percent)
+                    improvements += comparison.verdict == "improvement"
+            result["classes"][class_name] = {
+                "metrics": metrics,
+                "scores": scores,
+                "winner": winner.name,
+                "winner_compiler": winner.compiler,
+                "runner_up": ranking[1].name if len(ranking) > 1 else None,
+                "lead_significant": len(ranking) > 1 and improvements > len(metrics) / 2,
+            }
+            for name, score in scores.items():
+                overall[name].append(score)
+
+        totals = {name: self._geomean(scores) for name, scores in overall.items()}
+        best = max(measured, key=lambda c: totals[c.name])
+        result["overall_scores"] = totals
+        result["recommended"] = {
+            "contender": best.name,
+            "compiler": best.compiler,
+            "flags": best.flags,
+            "profiles": best.profiles,
+            "package_ref": best.package_ref,
+            "openssl_version": best.openssl_version,
+            "score": totals[best.name],
+        }
+        return result
+
+    def publish(self, comparison: Dict[str, Any], remote: str) -> Optional[str]:
+        """Upload the recommended contender's package revision to remote"""
+        recommended = comparison.get("recommended") or {}
+        package_ref = recommended.get("package_ref")
+        if not package_ref:
+            logger.warning("⚠️ Recommended contender has no package revision (prebuilt install?)")
+            return None
+        cmd = ["conan", "upload", package_ref, "-r", remote, "--confirm"]
+        logger.info(f"📦 Publishing {recommended['contender']}: {shlex.join(cmd)}")
+        result = subprocess.run(cmd, capture_output=True, text=True)
+        if result.returncode != 0:
+            raise RuntimeError(f"conan upload failed: {result.stderr.strip()}")
+        return package_ref
+
+    def write_reports(self, comparison: Dict[str, Any]) -> Tuple[Path, Path]:
+        """Write compiler_shootout_<ts>.json/.md and recommended-package.json"""
+        timestamp = datetime.now().strftime("%Y%m%d_%H%M%S")
+        json_path = self.work_dir / f"compiler_shootout_{timestamp}.json"
+        md_path = self.work_dir / f"compiler_shootout_{timestamp}.md"
+
+        report = {
+            "timestamp": datetime.now().isoformat(),
+            "platform": f"{platform.system().lower()}-{platform.machine().lower()}",
+            "version": self.version,
+            "trials": self.trials,
+            "quick": self.quick,
+            **comparison,
+        }
+        with open(json_path, 'w') as f:
+            json.dump(report, f, indent=2)
+        if comparison["recommended"]:
+            with open(self.work_dir / "recommended-package.json", 'w') as f:
+                json.dump({"timestamp": report["timestamp"], "platform": report["platform"],
+                           **comparison["recommended"]}, f, indent=2)
+
+        measured = comparison["measured"]
+        lines = [
+            "# Compiler Shoot-out",
+            "",
+            f"Scores are geometric-mean speed-ups vs `{comparison['reference']}` over each "
+            f"class's metrics; `*` marks a winner whose lead over the runner-up is significant "
+            f"on most of them (Mann-Whitney U, alpha={self.alpha}, {self.trials} trials).",
+            "",
+        ]
+        if measured:
+            lines.append("| Class | " + " | ".join(measured) + " | Winner |")
+            lines.append("|---|" + "---:|" * len(measured) + "---|")
+            for class_name, entry in comparison["classes"].items():
+                scores = [f"{entry['scores'][name]:.3f}" for name in measured]
+                mark = "*" if entry["lead_significant"] else ""
+                lines.append(f"| {class_name} ({len(entry['metrics'])}) | " + " | ".join(scores)
+                             + f" | {entry['winner']}{mark} |")
+            totals = [f"**{comparison['overall_scores'][name]:.3f}**" for name in measured]
+            lines.append("| overall | " + " | ".join(totals) + f" | {comparison['recommended']['contender']} |")
+            recommended = comparison["recommended"]
+            lines += ["", f"Recommended: `{recommended['contender']}` ({recommended['compiler']})"
+                      + (f", `{recommended['package_ref']}`" if recommended["package_ref"] else "")]
+        skipped = [c for c in comparison["contenders"] if c["skip_reason"]]
+        if skipped:
+            lines += ["", "## Skipped", ""]
+            lines += [f"- `{c['name']}`: {c['skip_reason']}" for c in skipped]
+        with open(md_path, 'w') as f:
+            f.write("\n".join(lines) + "\n")
+
+        return json_path, md_path
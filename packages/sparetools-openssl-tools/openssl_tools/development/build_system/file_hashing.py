@@ -0,0 +1,185 @@
+#!/usr/bin/env python3
+"""
+OpenSSL Tools - Fast File Hashing
+Parallel content hashing with a persistent stat cache for build cache keys.
+
+A file whose (path, size, mtime_ns, inode) matches the stat cache keeps
+its stored digest without being read, so a lookup over an unchanged
+OpenSSL tree costs one stat() per file. Changed files are hashed from
+memory-mapped reads on a thread pool (the hash functions release the GIL
+on large buffers).
+
+Algorithm preference: BLAKE3 (blake3 package), XXH3-128 (xxhash package),
+then BLAKE2b from hashlib. Cache entries remember their algorithm, so
+installing one of the optional packages just invalidates the cache.
+
+Files modified less than RACY_WINDOW_NS before they were hashed are not
+cached: an edit within the same timestamp tick would otherwise keep a
+stale digest (the same "racily clean" rule git applies to its index).
+"""
+
+import hashlib
+import logging
+import mmap
+import os
+import sqlite3
+import time
+from concurrent.futures import ThreadPoolExecutor
+from pathlib import Path
+from typing import Callable, Dict, Iterable, List, Optional, Tuple
+
+logger = logging.getLogger(__name__)
+
+DEFAULT_STAT_CACHE = Path.home() / ".openssl-build-cache" / "stat_cache.sqlite"
+
+RACY_WINDOW_NS = 2 * 1_000_000_000
+
+MMAP_CHUNK_SIZE = 8 * 1024 * 1024
+
+
+def _hasher_factories() -> Dict[str, Callable]:
+    factories: Dict[str, Callable] = {}
+    try:
+        import blake3
+        factories["blake3"] = lambda: blake3.blake3(max_threads=1)
+    except ImportError:
+        pass
+    try:
+        import xxhash
+        factories["xxh3_128"] = xxhash.xxh3_128
+    except ImportError:
+        pass
+    factories["blake2b"] = hashlib.blake2b
+    factories["sha256"] = hashlib.sha256
+    return factories
+
+
+HASHERS = _hasher_factories()
+
+DEFAULT_ALGORITHM = next(iter(HASHERS))
+
+
+def hash_file(path: str, algorithm: str = DEFAULT_ALGORITHM) -> str:
+    """Digest of a file's content using memory-mapped reads"""
+    factory = HASHERS.get(algorithm) or getattr(hashlib, algorithm)
+    hasher = factory()
+    with open(path, "rb") as f:
+        size = os.fstat(f.fileno()).st_size
+        if size:
+            with mmap.mmap(f.fileno(), 0, access=mmap.ACCESS_READ) as mapped:
+                view = memoryview(mapped)
+                try:
+                    for offset in range(0, size, MMAP_CHUNK_SIZE):
+                        hasher.update(view[offset:offset + MMAP_CHUNK_SIZE])
+                finally:
+                    view.release()
+    return hasher.hexdigest()
+
+
+class StatCache:
+    """Persistent digest cache keyed by (path, size, mtime_ns, inode)"""
+
+    def __init__(self, db_path: Path = DEFAULT_STAT_CACHE):
+        self.db_path = Path(db_path)
+        self.db_path.parent.mkdir(parents=True, exist_ok=True)
+        self.conn = sqlite3.connect(str(self.db_path), timeout=30)
+        self.conn.execute("PRAGMA journal_mode=WAL")
+        self.conn.execute("PRAGMA synchronous=NORMAL")
+        self.conn.execute("""
+            CREATE TABLE IF NOT EXISTS files (
+                path TEXT PRIMARY KEY,
+                size INTEGER NOT NULL,
+                mtime_ns INTEGER NOT NULL,
+                inode INTEGER NOT NULL,
+                algorithm TEXT NOT NULL,
+                digest TEXT NOT NULL
+            )""")
+        self._entries: Optional[Dict[str, Tuple[int, int, int, str, str]]] = None
+
+    def _load(self) -> Dict[str, Tuple[int, int, int, str, str]]:
+        if self._entries is None:
+            rows = self.conn.execute("SELECT path, size, mtime_ns, inode, algorithm, digest FROM files")
+            self._entries = {row[0]: row[1:] for row in rows}
+        return self._entries
+
+    def lookup(self, path: str, st: os.stat_result, algorithm: str) -> Optional[str]:
+        entry = self._load().get(path)
+        if entry and entry[:4] == (st.st_size, st.st_mtime_ns, st.st_ino, algorithm):
+            return entry[4]
+        return None
+
+    def update(self, rows: List[Tuple[str, int, int, int, str, str]]) -> None:
+        if not rows:
+            return
+        with self.conn:
+            self.conn.executemany("INSERT OR REPLACE INTO files VALUES (?, ?, ?, ?, ?, ?)", rows)
+        entries = self._load()
+        for row in rows:
+            entries[row[0]] = row[1:]
+
+    def close(self) -> None:
+        self.conn.close()
+
+
+class FileHasher:
+    """Hashes many files at once, skipping the ones the stat cache vouches for"""
+
+    def __init__(self, cache_path: Optional[Path] = DEFAULT_STAT_CACHE, algorithm: str = DEFAULT_ALGORITHM,
+                 workers: Optional[int] = None):
+        self.algorithm = algorithm
+        self.workers = workers or min(32, (os.cpu_count() or 1) * 2)
+        self.cache = StatCache(cache_path) if cache_path else None
+        self.last_hits = 0
+        self.last_misses = 0
+
+    def hash_files(self, paths: Iterable[os.PathLike]) -> Dict[str, str]:
+        """Digest per absolute path; missing or unreadable files are left out"""
+        results: Dict[str, str] = {}
+        todo: List[Tuple[str, os.stat_result]] = []
+        for path in paths:
+            path = os.path.abspath(path)
+            try:
+                st = os.stat(path)
+            except OSError:
+                continue
+            digest = self.cache.lookup(path, st, self.algorithm) if self.cache else None
+            if digest:
+                results[path] = digest
+            else:
+                todo.append((path, st))
+
+        self.last_hits, self.last_misses = len(results), len(todo)
+        if not todo:
+            return results
+
+        def work(item: Tuple[str, os.stat_result]) -> Tuple[str, os.stat_result, Optional[str]]:
+            try:
+                return item[0], item[1], hash_file(item[0], self.algorithm)
+            except OSError as e:
+                logger.warning(f"⚠️ Could not hash {item[0]}: {e}")
+                return item[0], item[1], None
+
+        if len(todo) == 1 or self.workers == 1:
+            hashed = [work(item) for item in todo]
+        else:
+            with ThreadPoolExecutor(max_workers=self.workers) as pool:
+                hashed = list(pool.map(work, todo))
+
+        now_ns = time.time_ns()
+        rows = []
+        for path, st, digest in hashed:
+            if digest is None:
+                continue
+            results[path] = digest
+            if now_ns - st.st_mtime_ns > RACY_WINDOW_NS:
+                rows.append((path, st.st_size, st.st_mtime_ns, st.st_ino, self.algorithm, digest))
+        if self.cache:
+            self.cache.update(rows)
+        return results
+
+    def hash_file(self, path: os.PathLike) -> Optional[str]:
+        return self.hash_files([path]).get(os.path.abspath(path))
+
+    def close(self) -> None:
+        if self.cache:
+            self.cache.close()
@@ -0,0 +1,182 @@
+#!/usr/bin/env python3
+"""
+Per-flag cost of the hardened build
+
+Builds sparetools-openssl with the `performance` feature profile as the
+reference, then once per hardening flag (the recipe's hardening option
+set to that flag alone) and once with the full `hardened` profile, all on
+the same base profile. Each build is benchmarked with the shoot-out
+machinery (CompilerShootout), and every build is expressed as a cost
+against the reference:
+
+- throughput cost: 1 - geometric-mean speed-up over the bench_evp metrics
+- handshake cost: the same over the bench_handshake metrics
+
+with the number of metrics that regress significantly (compare_samples),
+so a flag whose cost is within the noise is reported as such. The sum of
+the single-flag costs next to the measured cost of the full profile shows
+whether the flags interact.
+"""
+
+import json
+import platform
+from dataclasses import asdict
+from datetime import datetime
+from pathlib import Path
+from typing import Any, Dict, List, Optional, Tuple
+
+from .compiler_shootout import CompilerShootout, Contender, algorithm_class
+from .statistical_runner import compare_samples
+
+REFERENCE_FEATURE = "performance"
+HARDENED_FEATURE = "hardened"
+
+# The recipe's hardening flags (sparetools-openssl _hardening_flags), in
+# report order, with what each adds
+HARDENING_FLAGS: Dict[str, str] = {
+    "stack_protector": "-fstack-protector-strong",
+    "fortify": "-D_FORTIFY_SOURCE=3",
+    "cf_protection": "-fcf-protection=full (x86_64) / -mbranch-protection=standard (armv8)",
+    "auto_var_init": "-ftrivial-auto-var-init=zero",
+    "relro": "-Wl,-z,relro -Wl,-z,now",
+}
+
+# Metric id prefix -> cost column
+COST_GROUPS: List[Tuple[str, str]] = [("throughput", "bench_evp:"), ("handshake", "bench_handshake:")]
+
+
+class HardeningCost(CompilerShootout):
+    """Benchmarks each hardening flag, and all of them, against the performance profile"""
+
+    def plan_flags(self, base: str, flags: Optional[List[str]] = None,
+                   prefixes: Optional[Dict[str, Path]] = None) -> List[Contender]:
+        """Reference, one contender per flag, then the full hardened profile"""
+        unknown = [f for f in flags or [] if f not in HARDENING_FLAGS]
+        if unknown:
+            raise ValueError(f"Unknown hardening flags: {', '.join(unknown)} "
+                             f"(known: {', '.join(HARDENING_FLAGS)})")
+        reference_spec = f"{base}+{REFERENCE_FEATURE}"
+        contenders = [Contender.from_spec(reference_spec, self.profiles_dir)]
+        contenders[0].name = REFERENCE_FEATURE
+        for flag in flags or list(HARDENING_FLAGS):
+            contender = Contender.from_spec(reference_spec, self.profiles_dir)
+            contender.name = flag
+            contender.options = {"sparetools-openssl/*:hardening": flag}
+            contender.flags["sparetools-openssl/*:hardening"] = flag
+            contenders.append(contender)
+        hardened = Contender.from_spec(f"{reference_spec}+{HARDENED_FEATURE}", self.profiles_dir)
+        hardened.name = HARDENED_FEATURE
+        contenders.append(hardened)
+        for contender in contenders:
+            if (prefixes or {}).get(contender.name) is not None:
+                contender.prefix = str(prefixes[contender.name])
+        return contenders
+
+    def _cost(self, contender: Contender, reference: Contender, metrics: List[str]) -> Dict[str, Any]:
+        speedup = self._geomean([self._speedup(m, contender, reference) for m in metrics])
+        regressions = [m for m in metrics
+                       if compare_samples(m, contender.samples[m], reference.samples[m],
+                                          reference.higher_is_better[m], self.alpha,
+                                          self.min_effect_percent).verdict == "regression"]
+        return {
+            "metrics": len(metrics),
+            "cost_percent": (1.0 - speedup) * 100.0 if speedup else None,
+            "significant_regressions": regressions,
+        }
+
+    def costs(self, contenders: List[Contender]) -> Dict[str, Any]:
+        """Cost of every measured build against the reference, per group and algorithm class"""
+        reference = contenders[0]
+        result: Dict[str, Any] = {
+            "reference": reference.name,
+            "reference_profiles": reference.profiles,
+            "openssl_version": reference.openssl_version,
+            "contenders": [{k: v for k, v in asdict(c).items() if k not in ("samples", "higher_is_better")}
+                           for c in contenders],
+            "flags": {},
+            "sum_of_flags": {},
+            "hardened": None,
+        }
+        if not reference.samples:
+            return result
+
+        for contender in contenders[1:]:
+            if not contender.samples:
+                continue
+            common = [m for m in sorted(reference.samples) if m in contender.samples]
+            entry: Dict[str, Any] = {
+                "description": HARDENING_FLAGS.get(contender.name, "all flags, profiles/features/hardened"),
+                "classes": {},
+            }
+            for group, prefix in COST_GROUPS:
+                entry[group] = self._cost(contender, reference, [m for m in common if m.startswith(prefix)])
+            by_class: Dict[str, List[str]] = {}
+            for metric_id in common:
+                by_class.setdefault(algorithm_class(metric_id), []).append(metric_id)
+            for class_name, metrics in sorted(by_class.items()):
+                entry["classes"][class_name] = self._cost(contender, reference, metrics)["cost_percent"]
+            if contender.name == HARDENED_FEATURE:
+                result["hardened"] = entry
+            else:
+                result["flags"][contender.name] = entry
+
+        for group, _ in COST_GROUPS:
+            costs = [e[group]["cost_percent"] for e in result["flags"].values()
+                     if e[group]["cost_percent"] is not None]
+            result["sum_of_flags"][group] = sum(costs) if costs else None
+        return result
+
+    def write_cost_reports(self, costs: Dict[str, Any]) -> Tuple[Path, Path]:
+        """Write hardening_cost_<ts>.json/.md"""
+        timestamp = datetime.now().strftime("%Y%m%d_%H%M%S")
+        json_path = self.work_dir / f"hardening_cost_{timestamp}.json"
+        md_path = self.work_dir / f"hardening_cost_{timestamp}.md"
+        report = {
+            "timestamp": datetime.now().isoformat(),
+            "platform": f"{platform.system().lower()}-{platform.machine().lower()}",
+            "version": self.version,
+            "trials": self.trials,
+            "quick": self.quick,
+            **costs,
+        }
+        with open(json_path, 'w') as f:
+            json.dump(report, f, indent=2)
+
+        def cell(entry: Dict[str, Any]) -> str:
+            if entry["cost_percent"] is None:
+                return "-"
+            significant = len(entry["significant_regressions"])
+            return f"{entry['cost_percent']:+.2f}% ({significant}/{entry['metrics']})"
+
+        lines = [
+            "# Hardening Cost",
+            "",
+            f"Cost against `{costs['reference']}` ({costs['openssl_version'] or 'unknown version'}): "
+            f"1 - geometric-mean speed-up, positive is slower. In brackets: metrics that regress "
+            f"significantly (Mann-Whitney U, alpha={self.alpha}, at least {self.min_effect_percent}%) "
+            f"of those measured, {self.trials} trials.",
+            "",
+            "| Flag | Adds | Throughput | Handshakes |",
+            "|---|---|---:|---:|",
+        ]
+        for name, entry in costs["flags"].items():
+            lines.append(f"| {name} | `{entry['description']}` | {cell(entry['throughput'])} "
+                         f"| {cell(entry['handshake'])} |")
+        sums = costs["sum_of_flags"]
+        if costs["flags"]:
+            lines.append("| sum of flags | | " + " | ".join(
+                "-" if sums.get(g) is None else f"{sums[g]:+.2f}%" for g, _ in COST_GROUPS) + " |")
+        if costs["hardened"]:
+            hardened = costs["hardened"]
+            lines.append(f"| **{HARDENED_FEATURE}** | all | **{cell(hardened['throughput'])}** "
+                         f"| **{cell(hardened['handshake'])}** |")
+            lines += ["", "## Hardened build by algorithm class", ""]
+            lines += [f"- {name}: {cost:+.2f}%" for name, cost in hardened["classes"].items()
+                      if cost is not None]
+        skipped = [c for c in costs["contenders"] if c["skip_reason"]]
+        if skipped:
+            lines += ["", "## Skipped", ""]
+            lines += [f"- `{c['name']}`: {c['skip_reason']}" for c in skipped]
+        with open(md_path, 'w') as f:
+            f.write("\n".join(lines) + "\n")
+        return json_path, md_path
@@ -0,0 +1,214 @@
+#!/usr/bin/env python3
+"""
+In-process OpenSSL benchmark driver
+
+Loads libcrypto with ctypes and times EVP operations directly, so a
+measurement covers the crypto work only: no process startup, no config
+loading and no key parsing per iteration. Algorithm and key objects are
+fetched or generated once in setup, as in the native bench binaries.
+
+Operations per algorithm family:
+- sha*:   digest of a 16 KiB buffer
+- aes-*:  encryption of a 16 KiB buffer (fresh IV per iteration)
+- rsa:    RSA-SHA256 signature, key of key_size bits
+- ecdsa:  ECDSA-SHA256 signature on P-256/P-384/P-521
+
+Requires OpenSSL 3.x (EVP_*_fetch and EVP_PKEY_CTX_new_from_name).
+"""
+
+import ctypes
+import ctypes.util
+import logging
+import os
+import sys
+import time
+from pathlib import Path
+from typing import List, Optional
+
+logger = logging.getLogger(__name__)
+
+BUFFER_SIZE = 16384
+
+_EC_CURVES = {256: b"P-256", 384: b"P-384", 521: b"P-521"}
+
+_LIBRARY_NAMES = ["crypto", "crypto.3", "libcrypto-3-x64", "libcrypto-3"]
+
+
+def find_libcrypto(search_dirs: Optional[List[Path]] = None) -> Optional[str]:
+    """Locate libcrypto, preferring the given directories over the system"""
+    for directory in search_dirs or []:
+        for pattern in ("libcrypto.so*", "libcrypto*.dylib", "libcrypto-3*.dll"):
+            matches = sorted(Path(directory).glob(pattern))
+            if matches:
+                return str(matches[0])
+    for name in _LIBRARY_NAMES:
+        path = ctypes.util.find_library(name)
+        if path:
+            return path
+    return None
+
+
+class InProcessCryptoDriver:
+    """ctypes bindings for the EVP calls the benchmarks need"""
+
+    def __init__(self, library: Optional[str] = None):
+        path = library or find_libcrypto()
+        if not path:
+            raise OSError("libcrypto not found")
+        self.library_path = path
+        self._lib = ctypes.CDLL(path)
+        self._bind()
+        self.version = self._lib.OpenSSL_version(0).decode()
+
+    def _bind(self):
+        lib = self._lib
+        vp, cp, sz, ip = ctypes.c_void_p, ctypes.c_char_p, ctypes.c_size_t, ctypes.c_int
+        signatures = {
+            "OpenSSL_version": (cp, [ip]),
+            "EVP_MD_fetch": (vp, [vp, cp, cp]),
+            "EVP_MD_free": (None, [vp]),
+            "EVP_MD_CTX_new": (vp, []),
+            "EVP_MD_CTX_free": (None, [vp]),
+            "EVP_DigestInit_ex2": (ip, [vp, vp, vp]),
+            "EVP_DigestUpdate": (ip, [vp, vp, sz]),
+            "EVP_DigestFinal_ex": (ip, [vp, vp, ctypes.POINTER(ctypes.c_uint)]),
+            "EVP_CIPHER_fetch": (vp, [vp, cp, cp]),
+            "EVP_CIPHER_free": (None, [vp]),
+            "EVP_CIPHER_CTX_new": (vp, []),
+            "EVP_CIPHER_CTX_free": (None, [vp]),
+            "EVP_EncryptInit_ex2": (ip, [vp, vp, vp, vp, vp]),
+            "EVP_EncryptUpdate": (ip, [vp, vp, ctypes.POINTER(ip), vp, ip]),
+            "EVP_EncryptFinal_ex": (ip, [vp, vp, ctypes.POINTER(ip)]),
+            "EVP_PKEY_CTX_new_from_name": (vp, [vp, cp, cp]),
+            "EVP_PKEY_CTX_free": (None, [vp]),
+            "EVP_PKEY_keygen_init": (ip, [vp]),
+            "EVP_PKEY_CTX_set_rsa_keygen_bits": (ip, [vp, ip]),
+            "EVP_PKEY_CTX_set_group_name": (ip, [vp, cp]),
+            "EVP_PKEY_generate": (ip, [vp, ctypes.POINTER(vp)]),
+            "EVP_PKEY_free": (None, [vp]),
+            "EVP_DigestSignInit_ex": (ip, [vp, vp, cp, vp, cp, vp, vp]),
+            "EVP_DigestSign": (ip, [vp, vp, ctypes.POINTER(sz), vp, sz]),
+        }
+        for name, (restype, argtypes) in signatures.items():
+            fn = getattr(lib, name)
+            fn.restype = restype
+            fn.argtypes = argtypes
+
+    def _generate_key(self, algorithm: str, key_size: int) -> int:
+        lib = self._lib
+        name = b"RSA" if algorithm.startswith("rsa") else b"EC"
+        ctx = lib.EVP_PKEY_CTX_new_from_name(None, name, None)
+        pkey = ctypes.c_void_p()
+        try:
+            if not ctx or lib.EVP_PKEY_keygen_init(ctx) <= 0:
+                raise RuntimeError(f"{name.decode()} key generation unavailable")
+            if name == b"RSA":
+                ok = lib.EVP_PKEY_CTX_set_rsa_keygen_bits(ctx, key_size) > 0
+            else:
+                curve = _EC_CURVES.get(key_size)
+                ok = curve is not None and lib.EVP_PKEY_CTX_set_group_name(ctx, curve) > 0
+            if not ok or lib.EVP_PKEY_generate(ctx, ctypes.byref(pkey)) <= 0:
+                raise RuntimeError(f"Cannot generate {algorithm} {key_size} key")
+        finally:
+            lib.EVP_PKEY_CTX_free(ctx)
+        return pkey.value
+
+    def _time_digest(self, name: str, iterations: int) -> List[float]:
+        lib = self._lib
+        md = lib.EVP_MD_fetch(None, name.encode(), None)
+        ctx = lib.EVP_MD_CTX_new()
+        buf = ctypes.create_string_buffer(b"\xa5" * BUFFER_SIZE, BUFFER_SIZE)
+        out = ctypes.create_string_buffer(64)
+        outl = ctypes.c_uint()
+        times = []
+        try:
+            if not md or not ctx:
+                raise RuntimeError(f"Digest {name} unavailable")
+            for _ in range(iterations):
+                start = time.perf_counter()
+                ok = (lib.EVP_DigestInit_ex2(ctx, md, None)
+                      and lib.EVP_DigestUpdate(ctx, buf, BUFFER_SIZE)
+                      and lib.EVP_DigestFinal_ex(ctx, out, ctypes.byref(outl)))
+                times.append(time.perf_counter() - start)
+                if not ok:
+                    raise RuntimeError(f"Digest {name} failed")
+        finally:
+            lib.EVP_MD_CTX_free(ctx)
+            lib.EVP_MD_free(md)
+        return times
+
+    def _time_cipher(self, name: str, iterations: int) -> List[float]:
+        lib = self._lib
+        cipher = lib.EVP_CIPHER_fetch(None, name.encode(), None)
+        ctx = lib.EVP_CIPHER_CTX_new()
+        key = ctypes.create_string_buffer(64)
+        iv = ctypes.create_string_buffer(16)
+        buf = ctypes.create_string_buffer(b"\xa5" * BUFFER_SIZE, BUFFER_SIZE)
+        out = ctypes.create_string_buffer(BUFFER_SIZE + 32)
+        outl = ctypes.c_int()
+        times = []
+        try:
+            if not cipher or not ctx or not lib.EVP_EncryptInit_ex2(ctx, cipher, key, iv, None):
+                raise RuntimeError(f"Cipher {name} unavailable")
+            for i in range(iterations):
+                iv[0] = i & 0xff
+                start = time.perf_counter()
+                ok = (lib.EVP_EncryptInit_ex2(ctx, None, None, iv, None)
+                      and lib.EVP_EncryptUpdate(ctx, out, ctypes.byref(outl), buf, BUFFER_SIZE)
+                      and lib.EVP_EncryptFinal_ex(ctx, ctypes.byref(out, outl.value),
+                                                  ctypes.byref(outl)))
+                times.append(time.perf_counter() - start)
+                if not ok:
+                    raise RuntimeError(f"Cipher {name} failed")
+        finally:
+            lib.EVP_CIPHER_CTX_free(ctx)
+            lib.EVP_CIPHER_free(cipher)
+        return times
+
+    def _time_sign(self, algorithm: str, key_size: int, iterations: int) -> List[float]:
+        lib = self._lib
+        pkey = self._generate_key(algorithm, key_size)
+        ctx = lib.EVP_MD_CTX_new()
+        tbs = ctypes.create_string_buffer(b"\x5a" * 32, 32)
+        sig = ctypes.create_string_buffer(1024)
+        times = []
+        try:
+            for _ in range(iterations):
+                siglen = ctypes.c_size_t(len(sig))
+                start = time.perf_counter()
+                ok = (lib.EVP_DigestSignInit_ex(ctx, None, b"SHA256", None, None, pkey, None) > 0
+                      and lib.EVP_DigestSign(ctx, sig, ctypes.byref(siglen), tbs, 32) > 0)
+                times.append(time.perf_counter() - start)
+                if not ok:
+                    raise RuntimeError(f"{algorithm} {key_size} signing failed")
+        finally:
+            lib.EVP_MD_CTX_free(ctx)
+            lib.EVP_PKEY_free(pkey)
+        return times
+
+    def time_operation(self, algorithm: str, key_size: int, iterations: int) -> List[float]:
+        """Per-iteration seconds for the operation benchmarked for `algorithm`"""
+        if algorithm.startswith("sha"):
+            return self._time_digest(algorithm, iterations)
+        if algorithm.startswith("aes"):
+            return self._time_cipher(algorithm, iterations)
+        if algorithm.startswith(("rsa", "ecdsa")):
+            return self._time_sign(algorithm, key_size, iterations)
+        raise ValueError(f"Unsupported algorithm: {algorithm}")
+
+
+def main():
+    """Time one operation: inprocess_driver.py ALGORITHM KEY_SIZE [ITERATIONS] [LIBCRYPTO]"""
+    if len(sys.argv) < 3:
+        print(main.__doc__)
+        sys.exit(2)
+    iterations = int(sys.argv[3]) if len(sys.argv) > 3 else 1000
+    driver = InProcessCryptoDriver(sys.argv[4] if len(sys.argv) > 4 else os.environ.get("SPARETOOLS_LIBCRYPTO"))
+    times = driver.time_operation(sys.argv[1], int(sys.argv[2]), iterations)
+    total = sum(times)
+    print(f"{driver.version} ({driver.library_path})")
+    print(f"{sys.argv[1]} {sys.argv[2]}: {len(times)} ops in {total:.3f}s, {len(times) / total:.1f} ops/s")
+
+
+if __name__ == "__main__":
+    main()
@@ -4,22 +4,52 @@ Intelligent build matrix generator for OpenSSL CI.
 
 Analyzes changed files in OpenSSL repository and generates an optimized
 build matrix based on the type of changes detected.
+
+Recipe, profile, configure.py and provider_ordering.py changes go through
+the change impact graph (change_impact.py), which selects only the
+configurations whose axes they affect; other paths fall back to the
+category patterns below. --dry-run prints why each entry was selected.
+
+--test-shards N splits each selected configuration's test suite into N
+TESTS= shards balanced on --test-history (testing/test_sharding.py). The
+build entries then carry the artifact name of their deferred test bundle
+and "test_shards" is the matrix of jobs that run the shards on it.
 """
 
 import argparse
+import fnmatch
 import json
 import sys
-from typing import Dict, List, Set, Any
+from pathlib import Path
+from typing import Dict, List, Optional, Set, Tuple, Any
 from github import Github
 from github.GithubException import GithubException
 
+from .change_impact import (ChangedFile, Impact, ImpactGraph, ImpactSelection, git_changes, hunk_ranges,
+                            format_report, RECIPE_PATTERN, CONFIGURE_PY_PATTERN, PROVIDER_ORDERING_PATTERN,
+                            PROFILE_PATTERNS)
+from ...config_snapshot import load_config
+from ...testing.test_sharding import load_recipe_durations, shard_tests
+
+TOOLS_ROOT = Path(__file__).resolve().parents[3]
+DEFAULT_PROFILES_INDEX = TOOLS_ROOT / "openssl_tools" / "profiles" / "index.json"
+PROFILE_ROOTS = [TOOLS_ROOT / "openssl_tools" / "profiles" / "conan", TOOLS_ROOT / "profiles"]
+# Files whose new contents the impact graph reads
+GRAPH_SOURCE_PATTERNS = [RECIPE_PATTERN, CONFIGURE_PY_PATTERN, PROVIDER_ORDERING_PATTERN] + PROFILE_PATTERNS
+RUNNERS = {"linux": "ubuntu-22.04", "windows": "windows-2022", "macos": "macos-14"}
+
 
 class BuildMatrixGenerator:
     """Generates optimized build matrices based on file changes."""
     
-    def __init__(self, github_token: str):
-        """Initialize with GitHub API token."""
-        self.github = Github(github_token)
+    def __init__(self, github_token: Optional[str] = None, profiles_index: Optional[Path] = None):
+        """
+        Initialize with GitHub API token (not needed for local git changes).
+        With profiles_index (profiles/index.json), the matrix is built from
+        its profiles instead of the base configurations below.
+        """
+        self.github = Github(github_token) if github_token else None
+        self.profiles_index = profiles_index
         
         # Define file category mappings
         self.category_mappings = {
@@ -61,28 +91,38 @@ class BuildMatrixGenerator:
             'linux-gcc-release': {
                 'os': 'ubuntu-22.04',
                 'profile': 'linux-gcc-release',
-                'cache_key': 'linux-gcc11-rel'
+                'cache_key': 'linux-gcc11-rel',
+                'axes': {'operating_system': 'linux', 'compiler': 'gcc', 'variant': 'perl-configure',
+                         'fips_mode': 'fips-off', 'optimization_tier': 'opt-balanced'}
             },
             'linux-gcc-debug': {
                 'os': 'ubuntu-22.04',
                 'profile': 'linux-gcc-debug',
-                'cache_key': 'linux-gcc11-debug'
+                'cache_key': 'linux-gcc11-debug',
+                'axes': {'operating_system': 'linux', 'compiler': 'gcc', 'variant': 'perl-configure',
+                         'fips_mode': 'fips-off', 'optimization_tier': 'opt-debug'}
             },
             'linux-fips': {
                 'os': 'ubuntu-22.04',
                 'profile': 'linux-fips',
                 'cache_key': 'linux-fips',
-                'separate_cache': True
+                'separate_cache': True,
+                'axes': {'operating_system': 'linux', 'compiler': 'gcc', 'variant': 'perl-configure',
+                         'fips_mode': 'fips-on', 'optimization_tier': 'opt-balanced'}
             },
             'windows-msvc': {
                 'os': 'windows-2022',
                 'profile': 'windows-msvc',
-                'cache_key': 'win-msvc2022'
+                'cache_key': 'win-msvc2022',
+                'axes': {'operating_system': 'windows', 'compiler': 'msvc', 'variant': 'perl-configure',
+                         'fips_mode': 'fips-off', 'optimization_tier': 'opt-balanced'}
             },
             'macos-clang': {
                 'os': 'macos-13',
                 'profile': 'macos-clang',
-                'cache_key': 'macos-clang15'
+                'cache_key': 'macos-clang15',
+                'axes': {'operating_system': 'macos', 'compiler': 'clang', 'variant': 'perl-configure',
+                         'fips_mode': 'fips-off', 'optimization_tier': 'opt-balanced'}
             }
         }
     
@@ -96,6 +136,58 @@ class BuildMatrixGenerator:
             print(f"Error fetching changed files: {e}", file=sys.stderr)
             return []
     
+    def get_changes(self, repo_name: str, sha: str) -> List[ChangedFile]:
+        """Changed files of a commit with their hunks, and new contents where the impact graph reads them"""
+        try:
+            repo = self.github.get_repo(repo_name)
+            commit = repo.get_commit(sha)
+            changes = []
+            for file in commit.files:
+                source = None
+                if file.status != 'removed' and any(fnmatch.fnmatch(file.filename, p)
+                                                    for p in GRAPH_SOURCE_PATTERNS):
+                    source = repo.get_contents(file.filename, ref=sha).decoded_content.decode('utf-8', 'replace')
+                changes.append(ChangedFile(file.filename, hunk_ranges(file.patch or '') or None, source))
+            return changes
+        except GithubException as e:
+            print(f"Error fetching changed files: {e}", file=sys.stderr)
+            return []
+    
+    def configurations(self) -> List[Dict[str, Any]]:
+        """Candidate matrix entries with their axes: the profiles index, or the base configurations"""
+        if not self.profiles_index:
+            return [dict(config, id=name) for name, config in self.base_configs.items()]
+        index_dir = Path(self.profiles_index).parent
+        profiles = load_config(self.profiles_index, {'profiles': []})['profiles']
+        return [{'id': p['id'], 'os': RUNNERS.get(p['axes'].get('operating_system'), 'ubuntu-22.04'),
+                 'profile': p['id'], 'cache_key': p['id'], 'path': str(index_dir / p['path']),
+                 'axes': p['axes']} for p in profiles]
+    
+    def select_configurations(self, changes: List[ChangedFile], repo_dir: Path = Path('.')
+                              ) -> Tuple[ImpactSelection, Dict[str, Set[str]], int]:
+        """
+        Configurations to rebuild for changes, with reasons. Files without an
+        impact rule select the configurations of their category's profiles.
+        Returns the selection, those categories and the candidate count.
+        """
+        configurations = self.configurations()
+        graph = ImpactGraph(configurations, PROFILE_ROOTS)
+        impacts: List[Impact] = []
+        fallback = []
+        for change in changes:
+            found = graph.impacts(change, repo_dir)
+            if found is None:
+                fallback.append(change.path)
+            else:
+                impacts += found
+        categories = self.categorize_changes(fallback)
+        for category, files in categories.items():
+            for profile in self.category_mappings[category]['profiles']:
+                selector = {axis: {value} for axis, value in self.base_configs[profile]['axes'].items()}
+                for path in sorted(files):
+                    impacts.append(Impact(selector, f"{path}: {category} change builds {profile}"))
+        return graph.select(impacts), categories, len(configurations)
+    
     def categorize_changes(self, changed_files: List[str]) -> Dict[str, Set[str]]:
         """Categorize changed files by type."""
         categories = {category: set() for category in self.category_mappings.keys()}
@@ -163,69 +255,138 @@ class BuildMatrixGenerator:
         
         return matrix
     
-    def generate_build_matrix(self, repo_name: str, sha: str, reason: str = "") -> Dict[str, Any]:
-        """Generate complete build matrix for given repository and commit."""
+    def generate_build_matrix(self, repo_name: str, sha: str, reason: str = "",
+                              changes: Optional[List[ChangedFile]] = None,
+                              repo_dir: Path = Path('.'), test_shards: int = 1,
+                              test_durations: Optional[Dict[str, float]] = None) -> Dict[str, Any]:
+        """
+        Generate complete build matrix for given repository and commit.
+        changes (e.g. from change_impact.git_changes) replaces the GitHub lookup.
+        test_shards > 1 adds the "test_shards" matrix (see add_test_shards).
+        """
         print(f"Analyzing changes in {repo_name}@{sha}", file=sys.stderr)
         print(f"Build reason: {reason}", file=sys.stderr)
         
         # Get changed files
-        changed_files = self.get_changed_files(repo_name, sha)
-        if not changed_files:
+        if changes is None:
+            changes = self.get_changes(repo_name, sha)
+        if not changes:
             print("No changed files found, using minimal build", file=sys.stderr)
-            changed_files = []
         
-        print(f"Found {len(changed_files)} changed files", file=sys.stderr)
+        print(f"Found {len(changes)} changed files", file=sys.stderr)
         
-        # Categorize changes
-        categories = self.categorize_changes(changed_files)
-        
-        # Select profiles
-        selected_profiles = self.select_profiles(categories)
+        # Impact graph, with path categories for the rest
+        selection, categories, total = self.select_configurations(changes, repo_dir)
+        configurations = {c['id']: c for c in self.configurations()}
+        if not selection.configurations:
+            minimal = next(iter(configurations))
+            print(f"No configuration affected, using minimal build ({minimal})", file=sys.stderr)
+            selection.configurations.append(minimal)
+            selection.reasons[minimal] = ["minimal build: no configuration affected"]
         
         # Generate matrix
-        matrix = self.generate_matrix(selected_profiles)
+        matrix = [{k: v for k, v in configurations[config_id].items() if k not in ('id', 'axes', 'path')}
+                  for config_id in selection.configurations]
         
         # Create result
         result = {
             'include': matrix,
             'total_jobs': len(matrix),
-            'selected_profiles': list(selected_profiles),
-            'changed_files_count': len(changed_files),
-            'categories': {k: list(v) for k, v in categories.items() if v},
+            'candidate_jobs': total,
+            'selected_profiles': selection.configurations,
+            'reasons': selection.reasons,
+            'uncovered': selection.uncovered,
+            'changed_files_count': len(changes),
+            'categories': {k: sorted(v) for k, v in categories.items() if v},
             'reason': reason,
             'sha': sha
         }
+        if test_shards > 1:
+            self.add_test_shards(result, test_shards, test_durations or {})
         
         return result
+    
+    def add_test_shards(self, result: Dict[str, Any], shards: int, durations: Dict[str, float]) -> None:
+        """
+        Give each non-Windows entry a test_artifact (its deferred test
+        bundle, built once with user.sparetools:defer_tests) and add one
+        "test_shards" entry per entry and shard, with the shard's TESTS=
+        selection for `deferred-tests --tests=`. Windows entries test in
+        their build job.
+        """
+        selection = shard_tests(durations, shards)
+        if len(selection) < 2:
+            return
+        entries = []
+        for entry in result['include']:
+            if entry.get('os', '').startswith('windows'):
+                continue
+            entry['test_artifact'] = f"deferred-tests-{entry['profile']}"
+            for shard in selection:
+                entries.append(dict(entry, shard=f"{shard.index + 1}/{shard.count}", tests=shard.tests_arg,
+                                    expected_seconds=round(shard.expected_seconds, 1)))
+        result['test_shards'] = {'include': entries}
+        result['total_test_jobs'] = len(entries)
 
 
 def main() -> None:
     """Main entry point."""
     parser = argparse.ArgumentParser(description='Generate build matrix for OpenSSL CI')
-    parser.add_argument('--repo', required=True, help='Repository name (owner/repo)')
-    parser.add_argument('--sha', required=True, help='Commit SHA to analyze')
-    parser.add_argument('--output', required=True, help='Output JSON file')
+    parser.add_argument('--repo', help='Repository name (owner/repo), for changes read from GitHub')
+    parser.add_argument('--sha', help='Commit SHA to analyze')
+    parser.add_argument('--repo-dir', type=Path, help='Local checkout: read changes with git instead of GitHub')
+    parser.add_argument('--base', default='origin/main', help='Base ref for --repo-dir (merge base with --sha)')
+    parser.add_argument('--output', help='Output JSON file')
     parser.add_argument('--reason', default='', help='Build reason/trigger')
     parser.add_argument('--github-token', help='GitHub token (or use GITHUB_TOKEN env var)')
+    parser.add_argument('--profiles-index', type=Path, nargs='?', const=DEFAULT_PROFILES_INDEX,
+                        help=f'Select from profiles/index.json (default {DEFAULT_PROFILES_INDEX.name} '
+                             'when given without a path) instead of the base configurations')
+    parser.add_argument('--dry-run', action='store_true',
+                        help='Print why each entry is selected instead of writing the matrix')
+    parser.add_argument('--test-shards', type=int, default=1,
+                        help='Split each entry\'s test suite into this many jobs on its deferred test bundle')
+    parser.add_argument('--test-history', type=Path, action='append', default=[], metavar='PATH',
+                        help='JUnit reports or make-test.log files of earlier runs (repeatable), '
+                             'for balancing the shards')
     
     args = parser.parse_args()
+    if not args.dry_run and not args.output:
+        parser.error('--output is required unless --dry-run is given')
+    if args.repo_dir is None and not (args.repo and args.sha):
+        parser.error('--repo and --sha are required unless --repo-dir is given')
     
     # Get GitHub token
-    github_token = args.github_token or sys.stdin.read().strip()
-    if not github_token:
-        print("Error: GitHub token required", file=sys.stderr)
-        sys.exit(1)
+    github_token = None
+    if args.repo_dir is None:
+        github_token = args.github_token or sys.stdin.read().strip()
+        if not github_token:
+            print("Error: GitHub token required", file=sys.stderr)
+            sys.exit(1)
     
     try:
         # Generate build matrix
-        generator = BuildMatrixGenerator(github_token)
-        result = generator.generate_build_matrix(args.repo, args.sha, args.reason)
+        generator = BuildMatrixGenerator(github_token, args.profiles_index)
+        changes = None
+        head = args.sha or 'HEAD'
+        if args.repo_dir is not None:
+            changes = git_changes(args.repo_dir, args.base, head)
+        result = generator.generate_build_matrix(args.repo or str(args.repo_dir), head, args.reason,
+                                                 changes, args.repo_dir or Path('.'), args.test_shards,
+                                                 load_recipe_durations(args.test_history))
+        
+        if args.dry_run:
+            print(format_report(ImpactSelection(result['selected_profiles'], result['reasons'],
+                                                result['uncovered']), result['candidate_jobs']))
+            return
         
         # Write output
         with open(args.output, 'w') as f:
             json.dump(result, f, indent=2)
         
         print(f"Generated build matrix with {result['total_jobs']} jobs", file=sys.stderr)
+        if 'test_shards' in result:
+            print(f"Test shards: {result['total_test_jobs']} jobs", file=sys.stderr)
         print(f"Selected profiles: {', '.join(result['selected_profiles'])}", file=sys.stderr)
         print(f"Matrix written to: {args.output}", file=sys.stderr)
         
@@ -235,4 +396,4 @@ def main() -> None:
 
 
 if __name__ == '__main__':
-    main()
\ No newline at end of file
+    main()
@@ -14,6 +14,17 @@ from typing import Dict, List, Any, Optional
 import subprocess
 import logging
 
+try:
+    from .build_scheduler import BuildMatrixScheduler, load_build_durations
+except ImportError:
+    from build_scheduler import BuildMatrixScheduler, load_build_durations
+
+try:
+    from openssl_tools.conan_session import run_conan
+except ImportError:  # Run as a script without openssl_tools installed
+    def run_conan(args, cwd=None, check=False, wait=False):
+        return subprocess.run(["conan", *args], capture_output=True, text=True, cwd=cwd, check=check)
+
 # Configure logging
 logging.basicConfig(level=logging.INFO, format='%(asctime)s - %(levelname)s - %(message)s')
 logger = logging.getLogger(__name__)
@@ -27,6 +38,7 @@ class OpenSSLBuildMatrixManager:
         self.profiles_dir = self.conan_dev_dir / "profiles"
         self.build_matrix_file = self.conan_dev_dir / "openssl_build_matrix.json"
         self.docs_dir = project_root / "docs"
+        self.build_log_dir = project_root / "build-logs"
         
     def load_build_matrix(self) -> Dict[str, Any]:
         """Load build matrix configuration from JSON file"""
@@ -218,8 +230,18 @@ jobs:
         
         return True
     
-    def run_build_matrix(self, selected_configs: Optional[List[str]] = None) -> bool:
-        """Run build matrix for selected or all configurations"""
+    def run_build_matrix(self, selected_configs: Optional[List[str]] = None,
+                         parallel: int = 1, max_cores: Optional[int] = None,
+                         max_memory_mb: Optional[int] = None,
+                         log_dir: Optional[Path] = None) -> bool:
+        """
+        Run build matrix for selected or all configurations.
+
+        Builds go through BuildMatrixScheduler: up to `parallel` run at once,
+        each with its own share of cores and RAM, longest first according to
+        the build-summary-*.json files in log_dir. Every finished build adds
+        its own summary there for the next run.
+        """
         logger.info("Running build matrix...")
         
         matrix = self.load_build_matrix()
@@ -231,23 +253,25 @@ jobs:
         if selected_configs:
             configurations = [c for c in configurations if c["job_name"] in selected_configs]
         
-        success_count = 0
         total_count = len(configurations)
         
-        for config in configurations:
-            logger.info(f"Building configuration: {config['job_name']}")
-            
-            if self._run_single_build(config):
-                success_count += 1
-                logger.info(f"✅ {config['job_name']} - SUCCESS")
+        log_dir = log_dir or self.build_log_dir
+        scheduler = BuildMatrixScheduler(
+            max_cores=max_cores, max_memory_mb=max_memory_mb, max_parallel=parallel,
+            history=load_build_durations([log_dir]), log_dir=log_dir)
+        result = scheduler.run(configurations, self._run_single_build)
+        for job in result.jobs:
+            if job.success:
+                logger.info(f"✅ {job.name} - SUCCESS ({job.duration_seconds:.0f}s, -j{job.cores})")
             else:
-                logger.error(f"❌ {config['job_name']} - FAILED")
+                logger.error(f"❌ {job.name} - FAILED")
+        success_count = result.success_count
         
         logger.info(f"Build matrix completed: {success_count}/{total_count} successful")
         return success_count == total_count
     
-    def _run_single_build(self, config: Dict[str, Any]) -> bool:
-        """Run a single build configuration"""
+    def _run_single_build(self, config: Dict[str, Any], jobs: Optional[int] = None) -> bool:
+        """Run a single build configuration, limited to `jobs` compile jobs when given"""
         try:
             # Determine profile
             profile = f"{config['compiler']}-{config.get('arch', 'x86_64')}"
@@ -263,8 +287,10 @@ jobs:
                 f"--profile=conan-dev/profiles/{profile}.profile",
                 *options.split()
             ]
+            if jobs:
+                cmd += ["-c", f"tools.build:jobs={jobs}"]
             
-            result = subprocess.run(cmd, capture_output=True, text=True, cwd=self.project_root)
+            result = run_conan(cmd[1:], cwd=self.project_root)
             
             if result.returncode == 0:
                 return True
@@ -350,6 +376,14 @@ def main():
                        help="Run build matrix")
     parser.add_argument("--configs", nargs="+",
                        help="Specific configurations to run")
+    parser.add_argument("--parallel", type=int, default=1,
+                       help="Matrix entries to build concurrently")
+    parser.add_argument("--max-cores", type=int,
+                       help="Cores shared by all builds (default: all)")
+    parser.add_argument("--max-memory-mb", type=int,
+                       help="RAM shared by all builds (default: MemAvailable)")
+    parser.add_argument("--log-dir", type=Path,
+                       help="build-summary-*.json directory used for durations (default: build-logs)")
     parser.add_argument("--generate-docs", action="store_true",
                        help="Generate documentation")
     parser.add_argument("--all", action="store_true",
@@ -370,7 +404,8 @@ def main():
             sys.exit(1)
     
     if args.all or args.run_matrix:
-        if not manager.run_build_matrix(args.configs):
+        if not manager.run_build_matrix(args.configs, args.parallel, args.max_cores,
+                                        args.max_memory_mb, args.log_dir):
             sys.exit(1)
     
     if args.all or args.generate_docs:
@@ -2,6 +2,19 @@
 """
 OpenSSL Tools - Build Cache Manager
 Manages build cache and optimization for faster builds.
+
+Artifacts are kept in a content-addressed store (see artifact_store.py):
+files identical across builds are stored once, and an optional remote
+tier (S3, Artifactory/HTTP or a shared directory) lets CI runners share
+hits. Cached trees are materialized on demand from hard links.
+
+Eviction is GreedyDual-Size with frequency: each entry's priority is the
+rebuild minutes it saves per GB (hits times the recorded build time,
+over its size) on top of a clock that rises to the priority of every
+evicted entry. Long FIPS or Windows builds that keep getting hit outlive
+cheap ones, and idle entries still age out as the clock passes them.
+Retention likewise counts from the last hit and is stretched for
+entries worth more than the cache median.
 """
 
 import hashlib
@@ -17,6 +30,13 @@ import subprocess
 from dataclasses import dataclass, asdict
 from datetime import datetime, timedelta
 
+try:
+    from .artifact_store import ContentAddressedStore, RemoteCacheBackend, create_remote_backend
+    from .file_hashing import FileHasher
+except ImportError:
+    from artifact_store import ContentAddressedStore, RemoteCacheBackend, create_remote_backend
+    from file_hashing import FileHasher
+
 # Configure logging
 logging.basicConfig(
     level=logging.INFO,
@@ -42,19 +62,39 @@ class BuildInfo:
     success: bool
 
 
+# Rebuild estimate for entries without a recorded build time (remote hits,
+# old indexes), in minutes, and the extra weight of slow configurations
+DEFAULT_REBUILD_MINUTES = 10.0
+FIPS_COST_FACTOR = 2.0      # fipsmodule, self-test and KAT install steps
+WINDOWS_COST_FACTOR = 1.5   # MSVC/nmake builds run without ccache on our runners
+
+# Build hashes are shared through the remote tier, so every runner must
+# hash source files the same way whatever optional hash packages it has
+BUILD_HASH_FILE_ALGORITHM = "blake2b"
+
+
 class BuildCacheManager:
     """Manages build cache and optimization."""
     
-    def __init__(self, cache_dir: Path = None, max_cache_size_gb: int = 10, retention_days: int = 30):
+    def __init__(self, cache_dir: Path = None, max_cache_size_gb: int = 10, retention_days: int = 30,
+                 remote: Optional[Any] = None, max_retention_factor: float = 4.0):
         self.cache_dir = cache_dir or Path.home() / ".openssl-build-cache"
         self.max_cache_size_gb = max_cache_size_gb
         self.retention_days = retention_days  # Cache retention policy in days
+        # Valuable entries are kept up to this many times retention_days
+        self.max_retention_factor = max(1.0, max_retention_factor)
         self.index_file = self.cache_dir / "build_index.json"
         self.stats_file = self.cache_dir / "cache_stats.json"
         
         # Create cache directory
         self.cache_dir.mkdir(parents=True, exist_ok=True)
         
+        # Deduplicated object store; remote is a backend or URL (default: $OPENSSL_BUILD_CACHE_REMOTE)
+        if not isinstance(remote, RemoteCacheBackend):
+            remote = create_remote_backend(remote or os.environ.get("OPENSSL_BUILD_CACHE_REMOTE"))
+        self.store = ContentAddressedStore(self.cache_dir / "cas", remote)
+        self.file_hasher = FileHasher(self.cache_dir / "stat_cache.sqlite", algorithm=BUILD_HASH_FILE_ALGORITHM)
+        
         # Load existing index
         self.build_index = self._load_index()
         self.cache_stats = self._load_stats()
@@ -65,7 +105,8 @@ class BuildCacheManager:
     def calculate_build_hash(self, source_files: List[Path], 
                            build_options: Dict[str, Any],
                            dependencies: List[str] = None,
-                           compiler_info: Dict[str, str] = None) -> str:
+                           compiler_info: Dict[str, str] = None,
+                           source_root: Optional[Path] = None) -> str:
         """
         Calculate hash for build configuration.
         
@@ -74,21 +115,38 @@ class BuildCacheManager:
             build_options: Build configuration options
             dependencies: List of dependency names/versions
             compiler_info: Compiler information
+            source_root: Checkout the paths are hashed relative to
+                (default: the common directory of source_files)
             
         Returns:
             str: SHA256 hash of the build configuration
+            
+        File contents are hashed in parallel and unchanged files are served
+        from the stat cache, so repeated lookups over the same tree only
+        stat() each file. Contents are always hashed with
+        BUILD_HASH_FILE_ALGORITHM and paths are taken relative to
+        source_root, so the same tree checked out elsewhere, or on a runner
+        with other hash packages installed, gives the same hash.
         """
         hasher = hashlib.sha256()
         
-        # Hash source files
-        for file_path in sorted(source_files):
-            if file_path.exists():
-                # Include file content and modification time
-                stat = file_path.stat()
-                hasher.update(f"{file_path}:{stat.st_mtime}:{stat.st_size}".encode())
-                hasher.update(file_path.read_bytes())
+        # Hash source files by content (not mtime, so fresh checkouts still hit)
+        digests = self.file_hasher.hash_files(source_files)
+        hasher.update(self.file_hasher.algorithm.encode())
+        absolute = {os.path.abspath(f): f for f in source_files}
+        if source_root is not None:
+            root = os.path.abspath(source_root)
+        elif len(absolute) == 1:
+            root = os.path.dirname(next(iter(absolute)))
+        else:
+            root = os.path.commonpath(list(absolute)) if absolute else ""
+        entries = sorted((Path(os.path.relpath(path, root)).as_posix(), path) for path in absolute)
+        for rel_path, path in entries:
+            digest = digests.get(path)
+            if digest:
+                hasher.update(f"{rel_path}:{digest}".encode())
             else:
-                logger.warning(f"Source file not found: {file_path}")
+                logger.warning(f"Source file not found: {absolute[path]}")
                 
         # Hash build options (sorted for consistency)
         hasher.update(json.dumps(build_options, sort_keys=True).encode())
@@ -113,11 +171,24 @@ class BuildCacheManager:
         Returns:
             Path to cached artifacts or None if not found
         """
+        cache_path = self.cache_dir / build_hash
+        if build_hash not in self.build_index and self.store.remote:
+            # Remote tier: another runner may have stored this build
+            manifest = self.store.load_manifest(build_hash)
+            if manifest:
+                now = datetime.now().isoformat()
+                self.build_index[build_hash] = {"build_info": {}, "created_at": now, "last_accessed": now,
+                                                "size_bytes": manifest.get("size_bytes", 0), "remote": True}
+                
         if build_hash in self.build_index:
-            cache_path = self.cache_dir / build_hash
+            if not cache_path.exists() and self.store.load_manifest(build_hash):
+                self.store.materialize(build_hash, cache_path)
             if cache_path.exists():
-                # Update access time
-                self.build_index[build_hash]["last_accessed"] = datetime.now().isoformat()
+                # Update access time, hit count and eviction priority
+                entry = self.build_index[build_hash]
+                entry["last_accessed"] = datetime.now().isoformat()
+                entry["hits"] = entry.get("hits", 0) + 1
+                entry["priority"] = self._eviction_clock() + self._entry_value(entry)
                 self._save_index()
                 
                 # Update cache stats
@@ -154,20 +225,32 @@ class BuildCacheManager:
             if cache_path.exists():
                 shutil.rmtree(cache_path)
                 
-            # Copy artifacts to cache
-            shutil.copytree(artifacts_path, cache_path)
+            # Deduplicate artifacts into the object store; the tree itself
+            # is materialized from hard links on the first cache hit
+            manifest = self.store.put_tree(build_hash, artifacts_path)
             
             # Store build info
             build_info.artifacts_path = str(cache_path)
-            self.build_index[build_hash] = {
+            entry = {
                 "build_info": asdict(build_info),
                 "created_at": datetime.now().isoformat(),
                 "last_accessed": datetime.now().isoformat(),
-                "size_bytes": self._get_directory_size(cache_path)
+                "size_bytes": manifest["size_bytes"],
+                "hits": 0
             }
+            entry["rebuild_minutes"] = self._rebuild_minutes(entry)
+            entry["priority"] = self._eviction_clock() + self._entry_value(entry)
+            self.build_index[build_hash] = entry
             
             self._save_index()
             
+            if self.store.remote:
+                try:
+                    sent = self.store.push(build_hash, manifest)
+                    logger.info(f"Pushed {build_hash[:8]}... to remote cache ({sent} new objects)")
+                except Exception as e:
+                    logger.warning(f"Failed to push to remote cache: {e}")
+            
             # Update cache stats
             self.cache_stats["total_builds"] += 1
             self.cache_stats["cache_size_bytes"] = self._get_cache_size()
@@ -188,13 +271,64 @@ class BuildCacheManager:
             return False
             
     def _get_directory_size(self, path: Path) -> int:
-        """Calculate total size of directory in bytes."""
+        """Calculate total size of directory in bytes, counting hard-linked files once."""
         total_size = 0
+        seen = set()
         for file_path in path.rglob("*"):
-            if file_path.is_file():
-                total_size += file_path.stat().st_size
+            if file_path.is_file() and not file_path.is_symlink():
+                st = file_path.stat()
+                if (st.st_dev, st.st_ino) in seen:
+                    continue
+                seen.add((st.st_dev, st.st_ino))
+                total_size += st.st_size
         return total_size
         
+    def _remove_entry(self, build_hash: str):
+        """Drop a build's tree and manifest; unreferenced objects go in _collect_garbage."""
+        cache_path = self.cache_dir / build_hash
+        if cache_path.exists():
+            shutil.rmtree(cache_path)
+        self.store.remove(build_hash)
+        self.build_index.pop(build_hash, None)
+        
+    def _collect_garbage(self) -> int:
+        freed = self.store.garbage_collect()
+        if freed:
+            logger.info(f"Freed {freed / (1024**2):.1f} MB of unreferenced cache objects")
+        return freed
+        
+    def _rebuild_minutes(self, entry: Dict) -> float:
+        """Minutes it takes to rebuild an entry: its recorded build time, else an estimate."""
+        if entry.get("rebuild_minutes"):
+            return entry["rebuild_minutes"]
+        build_info = entry.get("build_info") or {}
+        if build_info.get("build_time"):
+            return build_info["build_time"] / 60.0
+        # Only the estimate is weighted; recorded times already include the slow steps
+        options = json.dumps(build_info.get("build_options", {})).lower()
+        target = f"{build_info.get('target_arch', '')} {build_info.get('compiler', '')}".lower()
+        minutes = DEFAULT_REBUILD_MINUTES
+        if "fips" in options:
+            minutes *= FIPS_COST_FACTOR
+        if any(k in target or k in options for k in ("windows", "msvc", "vc-win", "mingw")):
+            minutes *= WINDOWS_COST_FACTOR
+        return minutes
+        
+    def _entry_value(self, entry: Dict) -> float:
+        """Rebuild minutes per GB an entry saves; the store itself counts as one reference."""
+        size_gb = max(entry.get("size_bytes", 0), 1024**2) / (1024**3)
+        return (entry.get("hits", 0) + 1) * self._rebuild_minutes(entry) / size_gb
+        
+    def _eviction_clock(self) -> float:
+        """GreedyDual-Size inflation value: priority of the last evicted entry."""
+        return self.cache_stats.get("eviction_clock", 0.0)
+        
+    def _priority(self, entry: Dict) -> float:
+        # Entries from older indexes have no priority yet and start at the clock
+        if "priority" not in entry:
+            entry["priority"] = self._eviction_clock() + self._entry_value(entry)
+        return entry["priority"]
+        
     def _get_cache_size(self) -> int:
         """Get total cache size in bytes."""
         return self._get_directory_size(self.cache_dir)
@@ -208,14 +342,14 @@ class BuildCacheManager:
             self._cleanup_cache()
             
     def _cleanup_cache(self):
-        """Clean up cache by removing oldest entries."""
-        # Sort by last accessed time
+        """Clean up cache by removing the entries that save the fewest rebuild minutes per GB."""
+        # Lowest GreedyDual-Size priority first, least recently used among equals
         sorted_entries = sorted(
             self.build_index.items(),
-            key=lambda x: x[1].get("last_accessed", "1970-01-01")
+            key=lambda x: (self._priority(x[1]), x[1].get("last_accessed", "1970-01-01"))
         )
         
-        # Remove oldest entries until we're under the limit
+        # Remove entries until we're under the limit
         target_size_gb = self.max_cache_size_gb * 0.8  # Clean to 80% of limit
         
         for build_hash, entry in sorted_entries:
@@ -223,48 +357,67 @@ class BuildCacheManager:
             if cache_size_gb <= target_size_gb:
                 break
                 
-            cache_path = self.cache_dir / build_hash
-            if cache_path.exists():
-                shutil.rmtree(cache_path)
-                del self.build_index[build_hash]
-                logger.info(f"Removed cache entry: {build_hash[:8]}...")
+            # Survivors are now worth this much less relative to new entries
+            self.cache_stats["eviction_clock"] = max(self._eviction_clock(), entry["priority"])
+            self._remove_entry(build_hash)
+            self._collect_garbage()
+            logger.info(f"Removed cache entry: {build_hash[:8]}... "
+                        f"({entry.get('hits', 0)} hits, {self._rebuild_minutes(entry):.1f} min rebuild)")
                 
         self._save_index()
+        self._save_stats()
+        
+    def _retention_days_for(self, entry: Dict, median_value: float) -> float:
+        """retention_days, stretched by how far an entry's value exceeds the cache median."""
+        if median_value <= 0:
+            return self.retention_days
+        factor = min(max(self._entry_value(entry) / median_value, 1.0), self.max_retention_factor)
+        return self.retention_days * factor
+        
+    def _median_value(self) -> float:
+        values = sorted(self._entry_value(entry) for entry in self.build_index.values())
+        if not values:
+            return 0.0
+        mid = len(values) // 2
+        return values[mid] if len(values) % 2 else (values[mid - 1] + values[mid]) / 2
+        
+    def _last_used(self, entry: Dict) -> datetime:
+        return datetime.fromisoformat(entry.get("last_accessed") or entry.get("created_at", "1970-01-01"))
         
     def _apply_retention_policy(self):
-        """Apply retention policy to remove old cache entries."""
+        """Apply retention policy to remove cache entries unused for their retention period."""
         if self.retention_days <= 0:
             return
             
-        cutoff_date = datetime.now() - timedelta(days=self.retention_days)
+        now = datetime.now()
+        median_value = self._median_value()
         removed_count = 0
         
         for build_hash, entry in list(self.build_index.items()):
             try:
-                created_at = datetime.fromisoformat(entry.get("created_at", "1970-01-01"))
-                if created_at < cutoff_date:
-                    cache_path = self.cache_dir / build_hash
-                    if cache_path.exists():
-                        shutil.rmtree(cache_path)
-                    del self.build_index[build_hash]
+                last_used = self._last_used(entry)
+                retention = self._retention_days_for(entry, median_value)
+                if last_used < now - timedelta(days=retention):
+                    self._remove_entry(build_hash)
                     removed_count += 1
-                    logger.info(f"Removed expired cache entry: {build_hash[:8]}... (created: {created_at.date()})")
+                    logger.info(f"Removed expired cache entry: {build_hash[:8]}... "
+                                f"(last used: {last_used.date()}, kept {retention:.0f} days)")
             except (ValueError, TypeError) as e:
                 logger.warning(f"Invalid date format in cache entry {build_hash[:8]}: {e}")
                 # Remove malformed entries
-                cache_path = self.cache_dir / build_hash
-                if cache_path.exists():
-                    shutil.rmtree(cache_path)
-                del self.build_index[build_hash]
+                self._remove_entry(build_hash)
                 removed_count += 1
                 
         if removed_count > 0:
+            self._collect_garbage()
             self._save_index()
             logger.info(f"Retention policy applied: removed {removed_count} expired cache entries (older than {self.retention_days} days)")
             
     def get_retention_stats(self) -> Dict:
         """Get retention policy statistics."""
-        cutoff_date = datetime.now() - timedelta(days=self.retention_days)
+        now = datetime.now()
+        cutoff_date = now - timedelta(days=self.retention_days)
+        median_value = self._median_value()
         total_entries = len(self.build_index)
         expired_entries = 0
         total_size_bytes = 0
@@ -272,11 +425,11 @@ class BuildCacheManager:
         
         for build_hash, entry in self.build_index.items():
             try:
-                created_at = datetime.fromisoformat(entry.get("created_at", "1970-01-01"))
+                last_used = self._last_used(entry)
                 size_bytes = entry.get("size_bytes", 0)
                 total_size_bytes += size_bytes
                 
-                if created_at < cutoff_date:
+                if last_used < now - timedelta(days=self._retention_days_for(entry, median_value)):
                     expired_entries += 1
                     expired_size_bytes += size_bytes
             except (ValueError, TypeError):
@@ -286,6 +439,7 @@ class BuildCacheManager:
                 
         return {
             "retention_days": self.retention_days,
+            "max_retention_factor": self.max_retention_factor,
             "total_entries": total_entries,
             "expired_entries": expired_entries,
             "active_entries": total_entries - expired_entries,
@@ -306,7 +460,10 @@ class BuildCacheManager:
                 "last_accessed": entry.get("last_accessed"),
                 "size_bytes": entry.get("size_bytes", 0),
                 "build_time": build_info.get("build_time", 0),
-                "success": build_info.get("success", False)
+                "success": build_info.get("success", False),
+                "hits": entry.get("hits", 0),
+                "rebuild_minutes": self._rebuild_minutes(entry),
+                "priority": self._priority(entry)
             })
             
         return sorted(builds, key=lambda x: x["last_accessed"], reverse=True)
@@ -322,15 +479,25 @@ class BuildCacheManager:
             
         # Get retention statistics
         retention_stats = self.get_retention_stats()
+        
+        stored_bytes = self.store.stored_bytes()
+        logical_bytes = self.store.logical_bytes()
+        saved_minutes = sum(entry.get("hits", 0) * self._rebuild_minutes(entry)
+                            for entry in self.build_index.values())
             
         return {
             "cache_size_gb": cache_size_gb,
+            "logical_size_gb": logical_bytes / (1024**3),
+            "dedup_ratio": logical_bytes / stored_bytes if stored_bytes else 1.0,
+            "remote": type(self.store.remote).__name__ if self.store.remote else None,
             "max_cache_size_gb": self.max_cache_size_gb,
             "cache_hits": self.cache_stats.get("cache_hits", 0),
             "cache_misses": self.cache_stats.get("cache_misses", 0),
             "hit_rate": hit_rate,
             "total_builds": self.cache_stats.get("total_builds", 0),
             "cached_builds": len(self.build_index),
+            "rebuild_minutes_saved": saved_minutes,
+            "eviction_clock": self._eviction_clock(),
             "retention_policy": {
                 "retention_days": self.retention_days,
                 "active_entries": retention_stats["active_entries"],
@@ -340,6 +507,18 @@ class BuildCacheManager:
             }
         }
         
+    def optimize_cache(self) -> Dict:
+        """
+        Apply retention and size limits, then drop unreferenced objects.
+        
+        Returns:
+            Dict: Cache statistics after optimization
+        """
+        self._apply_retention_policy()
+        self._cleanup_cache_if_needed()
+        self._collect_garbage()
+        return self.get_cache_stats()
+        
     def clear_cache(self, older_than_days: int = None) -> int:
         """
         Clear cache entries.
@@ -366,13 +545,11 @@ class BuildCacheManager:
                 should_clear = True
                 
             if should_clear:
-                cache_path = self.cache_dir / build_hash
-                if cache_path.exists():
-                    shutil.rmtree(cache_path)
-                del self.build_index[build_hash]
+                self._remove_entry(build_hash)
                 cleared_count += 1
                 
         if cleared_count > 0:
+            self._collect_garbage()
             self._save_index()
             logger.info(f"Cleared {cleared_count} cache entries")
             
@@ -513,19 +690,25 @@ def main():
     parser.add_argument("--cache-dir", type=Path, help="Cache directory path")
     parser.add_argument("--max-size", type=int, default=10, help="Max cache size in GB")
     parser.add_argument("--retention-days", type=int, default=30, help="Cache retention policy in days (default: 30)")
+    parser.add_argument("--max-retention-factor", type=float, default=4.0,
+                        help="Keep entries that save many rebuild minutes per GB up to this many times "
+                             "--retention-days (default: 4)")
     parser.add_argument("--list", action="store_true", help="List cached builds")
     parser.add_argument("--stats", action="store_true", help="Show cache statistics")
     parser.add_argument("--retention-stats", action="store_true", help="Show retention policy statistics")
     parser.add_argument("--apply-retention", action="store_true", help="Apply retention policy manually")
     parser.add_argument("--clear", type=int, help="Clear cache entries older than N days")
     parser.add_argument("--clear-all", action="store_true", help="Clear all cache entries")
+    parser.add_argument("--remote", help="Remote cache tier: s3://bucket/prefix, https://... or a shared directory")
     
     args = parser.parse_args()
     
     cache_manager = BuildCacheManager(
         cache_dir=args.cache_dir,
         max_cache_size_gb=args.max_size,
-        retention_days=args.retention_days
+        retention_days=args.retention_days,
+        remote=args.remote,
+        max_retention_factor=args.max_retention_factor
     )
     
     if args.list:
@@ -534,7 +717,8 @@ def main():
             print("Cached builds:")
             for build in builds:
                 size_mb = build["size_bytes"] / (1024**2)
-                print(f"  {build['hash'][:8]}... - {size_mb:.1f} MB - {build['last_accessed']}")
+                print(f"  {build['hash'][:8]}... - {size_mb:.1f} MB - {build['last_accessed']} - "
+                      f"{build['hits']} hits - {build['rebuild_minutes']:.1f} min rebuild")
         else:
             print("No cached builds found")
             
@@ -542,11 +726,14 @@ def main():
         stats = cache_manager.get_cache_stats()
         print("Cache Statistics:")
         print(f"  Size: {stats['cache_size_gb']:.2f} GB / {stats['max_cache_size_gb']} GB")
+        print(f"  Logical Size: {stats['logical_size_gb']:.2f} GB ({stats['dedup_ratio']:.1f}x deduplication)")
+        print(f"  Remote: {stats['remote'] or 'none'}")
         print(f"  Hit Rate: {stats['hit_rate']:.1%}")
         print(f"  Cache Hits: {stats['cache_hits']}")
         print(f"  Cache Misses: {stats['cache_misses']}")
         print(f"  Total Builds: {stats['total_builds']}")
         print(f"  Cached Builds: {stats['cached_builds']}")
+        print(f"  Rebuild Time Saved: {stats['rebuild_minutes_saved']:.0f} min")
         print(f"  Retention Policy: {stats['retention_policy']['retention_days']} days")
         print(f"  Active Entries: {stats['retention_policy']['active_entries']}")
         print(f"  Expired Entries: {stats['retention_policy']['expired_entries']}")
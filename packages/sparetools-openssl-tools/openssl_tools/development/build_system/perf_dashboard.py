@@ -0,0 +1,308 @@
+#!/usr/bin/env python3
+"""
+Benchmark trend dashboard over the performance history
+
+Renders the PerfHistoryStore as one static HTML file (no server, no
+external scripts, so it can be published as a CI artifact): per
+benchmark metric, the median of every run over time, one line per
+profile and OpenSSL version.
+
+- Regression annotations: a run whose samples regress significantly
+  (compare_samples) against the previous run of the same line on the
+  same CPU model is marked and linked to its commit.
+- Release readiness: with compare=(baseline, candidate), e.g.
+  ("3.3.2", "3.6.0"), the latest runs of both versions are compared per
+  metric and profile, on a CPU model both were measured on.
+"""
+
+import json
+import logging
+import statistics
+from dataclasses import asdict, dataclass
+from datetime import datetime
+from pathlib import Path
+from typing import Any, Dict, List, Optional, Sequence, Tuple
+
+from .binary_size import is_trend_metric
+from .perf_history import PerfHistoryStore
+from .statistical_runner import compare_samples
+
+logger = logging.getLogger(__name__)
+
+DEFAULT_OUTPUT = Path("test_results") / "perf-dashboard.html"
+
+
+@dataclass
+class ReadinessRow:
+    """Candidate against baseline version for one metric and profile"""
+    benchmark: str
+    metric: str
+    profile: str
+    cpu_model: str
+    baseline_median: float
+    candidate_median: float
+    change_percent: float
+    p_value: float
+    verdict: str
+    baseline_commit: str
+    candidate_commit: str
+
+
+class PerfDashboard:
+    """Trend charts, regression annotations and a version comparison from a PerfHistoryStore"""
+
+    def __init__(self, store: PerfHistoryStore, commit_url: Optional[str] = None,
+                 profiles: Optional[Sequence[str]] = None, alpha: float = 0.01,
+                 min_effect_percent: float = 2.0):
+        self.store = store
+        # e.g. https://github.com/openssl/openssl/commit/{commit}
+        self.commit_url = commit_url
+        self.profiles = set(profiles) if profiles else None
+        self.alpha = alpha
+        self.min_effect_percent = min_effect_percent
+
+    def _link(self, commit: str) -> Optional[str]:
+        if not self.commit_url or commit in ("unknown", ""):
+            return None
+        return self.commit_url.format(commit=commit)
+
+    def _runs(self) -> List[Tuple[Dict[str, Any], Dict[str, List[float]]]]:
+        return [(run, samples) for run, samples in self.store.runs_with_samples()
+                if self.profiles is None or run["profile"] in self.profiles]
+
+    def series(self) -> Dict[str, Any]:
+        """Chart data: {benchmark: {metric: {"higher_is_better", "lines": {line: [point]}}}}"""
+        charts: Dict[str, Dict[str, Any]] = {}
+        # (benchmark, metric, line, cpu_model) -> samples of the previous run
+        previous: Dict[Tuple[str, str, str, str], List[float]] = {}
+        for run, samples in self._runs():
+            line = f"{run['profile']} / {run['openssl_version']}"
+            for metric, values in samples.items():
+                # Thousands of symbol and compile-unit sizes per run stay in the store
+                if not is_trend_metric(run["benchmark"], metric):
+                    continue
+                chart = charts.setdefault(run["benchmark"], {}).setdefault(
+                    metric, {"higher_is_better": bool(run["higher_is_better"]), "lines": {}})
+                point = {
+                    "t": run["timestamp"], "median": statistics.median(values), "trials": len(values),
+                    "commit": run["git_commit"], "revision": run["package_revision"],
+                    "cpu": run["cpu_model"], "run": run["id"],
+                }
+                key = (run["benchmark"], metric, line, run["cpu_model"])
+                before = previous.get(key)
+                if before and len(values) > 1 and len(before) > 1:
+                    comparison = compare_samples(metric, values, before, bool(run["higher_is_better"]),
+                                                 self.alpha, self.min_effect_percent)
+                    if comparison.verdict == "regression":
+                        point["regression"] = round(comparison.change_percent, 2)
+                        point["link"] = self._link(run["git_commit"])
+                previous[key] = values
+                chart["lines"].setdefault(line, []).append(point)
+        return charts
+
+    def readiness(self, baseline: str, candidate: str) -> List[ReadinessRow]:
+        """Latest candidate run against the latest baseline run per metric and profile"""
+        latest: Dict[Tuple[str, str, str, str, str], Tuple[Dict[str, Any], List[float]]] = {}
+        for run, samples in self._runs():
+            if run["openssl_version"] not in (baseline, candidate):
+                continue
+            for metric, values in samples.items():
+                latest[(run["openssl_version"], run["benchmark"], metric, run["profile"],
+                        run["cpu_model"])] = (run, values)
+
+        rows = []
+        for (version, benchmark, metric, profile, cpu), (run, values) in sorted(latest.items()):
+            if version != candidate:
+                continue
+            reference = latest.get((baseline, benchmark, metric, profile, cpu))
+            if reference is None:
+                continue
+            base_run, base_values = reference
+            comparison = compare_samples(metric, values, base_values, bool(run["higher_is_better"]),
+                                         self.alpha, self.min_effect_percent)
+            rows.append(ReadinessRow(benchmark, metric, profile, cpu, comparison.baseline_median,
+                                     comparison.current_median, comparison.change_percent,
+                                     comparison.p_value, comparison.verdict,
+                                     base_run["git_commit"], run["git_commit"]))
+        return rows
+
+    def render(self, output: Path = DEFAULT_OUTPUT,
+               compare: Optional[Tuple[str, str]] = None) -> Dict[str, Any]:
+        """Write the dashboard; returns its data (charts, readiness rows and summary)"""
+        charts = self.series()
+        rows = self.readiness(*compare) if compare else []
+        summary = {verdict: sum(1 for r in rows if r.verdict == verdict)
+                   for verdict in ("regression", "improvement", "no-change")}
+        data = {
+            "generated": datetime.now().isoformat(timespec="seconds"),
+            "store": str(self.store.path),
+            "charts": charts,
+            "compare": list(compare) if compare else None,
+            "readiness": [asdict(r) for r in rows],
+            "summary": summary,
+        }
+        output.parent.mkdir(parents=True, exist_ok=True)
+        # "</" would end the script element early
+        payload = json.dumps(data, separators=(",", ":")).replace("</", "<\\/")
+        output.write_text(_TEMPLATE.replace("__DATA__", payload), encoding="utf-8")
+        regressions = sum(1 for lines in (m["lines"] for b in charts.values() for m in b.values())
+                          for points in lines.values() for p in points if "regression" in p)
+        logger.info(f"📈 Dashboard written to {output}: {sum(len(m) for m in charts.values())} metrics, "
+                    f"{regressions} regression annotation(s)")
+        return data
+
+
+_TEMPLATE = """<!DOCTYPE html>
+<html lang="en">
+<head>
+<meta charset="utf-8">
+<title>OpenSSL benchmark trends</title>
+<style>
+body { font-family: system-ui, sans-serif; margin: 1.5em; color: #222; }
+h1 { font-size: 1.4em; } h2 { font-size: 1.15em; margin-top: 1.5em; }
+select { margin-right: 1em; }
+.chart { margin: 1em 0; }
+.legend span { display: inline-block; margin-right: 1.2em; font-size: 0.9em; }
+.legend i { display: inline-block; width: 1.2em; height: 0.3em; margin-right: 0.3em; vertical-align: middle; }
+table { border-collapse: collapse; font-size: 0.9em; }
+th, td { border: 1px solid #ccc; padding: 0.25em 0.6em; text-align: right; }
+th:first-child, td:first-child, td.text { text-align: left; }
+tr.regression td { background: #fde2e2; } tr.improvement td { background: #e2f5e2; }
+.verdict { font-weight: bold; } .muted { color: #777; }
+</style>
+</head>
+<body>
+<h1>OpenSSL benchmark trends</h1>
+<p class="muted" id="meta"></p>
+<div id="readiness"></div>
+<h2>History</h2>
+<label>Benchmark <select id="benchmark"></select></label>
+<label>Metric <select id="metric"></select></label>
+<div class="chart" id="chart"></div>
+<div class="legend" id="legend"></div>
+<div id="annotations"></div>
+<script id="data" type="application/json">__DATA__</script>
+<script>
+"use strict";
+const data = JSON.parse(document.getElementById("data").textContent);
+const colors = ["#1f77b4", "#ff7f0e", "#2ca02c", "#d62728", "#9467bd", "#8c564b", "#e377c2", "#7f7f7f",
+                "#bcbd22", "#17becf"];
+const svgNS = "http://www.w3.org/2000/svg";
+
+function el(tag, attrs, text) {
+  const node = tag.startsWith("svg:") ? document.createElementNS(svgNS, tag.slice(4)) : document.createElement(tag);
+  for (const [k, v] of Object.entries(attrs || {})) node.setAttribute(k, v);
+  if (text !== undefined) node.textContent = text;
+  return node;
+}
+
+function fmt(v) { return Math.abs(v) >= 100 ? v.toFixed(0) : v.toPrecision(3); }
+
+document.getElementById("meta").textContent =
+  `Generated ${data.generated} from ${data.store}. Red markers: significant regression against ` +
+  `the previous run of the same line on the same CPU.`;
+
+function renderReadiness() {
+  const box = document.getElementById("readiness");
+  if (!data.compare) return;
+  const [baseline, candidate] = data.compare;
+  const s = data.summary;
+  box.appendChild(el("h2", {}, `Release readiness: ${candidate} against ${baseline}`));
+  box.appendChild(el("p", {}, data.readiness.length
+    ? `${s.regression} regression(s), ${s.improvement} improvement(s), ${s["no-change"]} unchanged ` +
+      `of ${data.readiness.length} metric/profile pairs measured on both versions.`
+    : `No metric was measured for both versions on the same CPU model and profile.`));
+  if (!data.readiness.length) return;
+  const table = el("table");
+  const head = el("tr");
+  for (const h of ["benchmark", "metric", "profile", "cpu", baseline, candidate, "change", "p", "verdict"])
+    head.appendChild(el("th", {}, h));
+  table.appendChild(head);
+  const order = {regression: 0, improvement: 1, "no-change": 2};
+  const rows = [...data.readiness].sort((a, b) => order[a.verdict] - order[b.verdict] ||
+                                                  a.change_percent - b.change_percent);
+  for (const r of rows) {
+    const tr = el("tr", {class: r.verdict});
+    for (const [v, cls] of [[r.benchmark, "text"], [r.metric, "text"], [r.profile, "text"], [r.cpu_model, "text"],
+                            [fmt(r.baseline_median)], [fmt(r.candidate_median)],
+                            [(r.change_percent >= 0 ? "+" : "") + r.change_percent.toFixed(2) + "%"],
+                            [r.p_value.toFixed(4)], [r.verdict, "verdict"]])
+      tr.appendChild(el("td", cls ? {class: cls} : {}, v));
+    table.appendChild(tr);
+  }
+  box.appendChild(table);
+}
+
+function renderChart(benchmark, metric) {
+  const chart = data.charts[benchmark][metric];
+  const box = document.getElementById("chart"), legend = document.getElementById("legend");
+  const notes = document.getElementById("annotations");
+  box.replaceChildren(); legend.replaceChildren(); notes.replaceChildren();
+  const lines = Object.entries(chart.lines);
+  const points = lines.flatMap(([, pts]) => pts);
+  const times = points.map(p => Date.parse(p.t)), values = points.map(p => p.median);
+  const W = 960, H = 360, L = 70, R = 20, T = 15, B = 40;
+  let t0 = Math.min(...times), t1 = Math.max(...times);
+  if (t0 === t1) { t0 -= 3600e3; t1 += 3600e3; }
+  let v0 = Math.min(...values), v1 = Math.max(...values);
+  const pad = (v1 - v0) * 0.1 || Math.abs(v1) * 0.1 || 1;
+  v0 = Math.max(0, v0 - pad); v1 += pad;
+  const x = t => L + (t - t0) / (t1 - t0) * (W - L - R);
+  const y = v => T + (1 - (v - v0) / (v1 - v0)) * (H - T - B);
+  const svg = el("svg:svg", {width: W, height: H, viewBox: `0 0 ${W} ${H}`});
+  for (let i = 0; i <= 4; i++) {
+    const v = v0 + (v1 - v0) * i / 4;
+    svg.appendChild(el("svg:line", {x1: L, x2: W - R, y1: y(v), y2: y(v), stroke: "#eee"}));
+    svg.appendChild(el("svg:text", {x: L - 6, y: y(v) + 4, "text-anchor": "end", "font-size": 11}, fmt(v)));
+    const t = t0 + (t1 - t0) * i / 4;
+    svg.appendChild(el("svg:text", {x: x(t), y: H - B + 16, "text-anchor": "middle", "font-size": 11},
+                       new Date(t).toISOString().slice(0, 10)));
+  }
+  svg.appendChild(el("svg:text", {x: 12, y: T + 8, "font-size": 11},
+                     metric.split("/").pop() + (chart.higher_is_better ? " (higher is better)" : " (lower is better)")));
+  lines.forEach(([name, pts], i) => {
+    const color = colors[i % colors.length];
+    svg.appendChild(el("svg:polyline", {fill: "none", stroke: color, "stroke-width": 1.5,
+      points: pts.map(p => `${x(Date.parse(p.t))},${y(p.median)}`).join(" ")}));
+    for (const p of pts) {
+      const cx = x(Date.parse(p.t)), cy = y(p.median);
+      const tip = `${name}\\n${p.t.slice(0, 19)}  ${fmt(p.median)} (${p.trials} trials)\\n` +
+                  `commit ${p.commit.slice(0, 12)}  revision ${p.revision.slice(0, 12)}\\n${p.cpu}` +
+                  (p.regression !== undefined ? `\\nregression ${p.regression}%` : "");
+      let mark = el("svg:circle", {cx, cy, r: p.regression !== undefined ? 5 : 3,
+                                   fill: p.regression !== undefined ? "#d00" : color});
+      mark.appendChild(el("svg:title", {}, tip));
+      if (p.link) { const a = el("svg:a", {href: p.link, target: "_blank"}); a.appendChild(mark); mark = a; }
+      svg.appendChild(mark);
+      if (p.regression !== undefined) {
+        const item = el("div");
+        item.appendChild(document.createTextNode(`${p.t.slice(0, 19)}  ${name}: ${p.regression}% at `));
+        item.appendChild(p.link ? el("a", {href: p.link}, p.commit.slice(0, 12))
+                                : document.createTextNode(p.commit.slice(0, 12)));
+        notes.appendChild(item);
+      }
+    }
+    const key = el("span"); const swatch = el("i"); swatch.style.background = color;
+    key.appendChild(swatch); key.appendChild(document.createTextNode(`${name} (${pts.length})`));
+    legend.appendChild(key);
+  });
+  box.appendChild(svg);
+  if (notes.childElementCount) notes.prepend(el("h2", {}, "Regressions"));
+}
+
+const benchSelect = document.getElementById("benchmark"), metricSelect = document.getElementById("metric");
+function fillMetrics() {
+  metricSelect.replaceChildren();
+  for (const m of Object.keys(data.charts[benchSelect.value]).sort()) metricSelect.appendChild(el("option", {}, m));
+  renderChart(benchSelect.value, metricSelect.value);
+}
+for (const b of Object.keys(data.charts).sort()) benchSelect.appendChild(el("option", {}, b));
+benchSelect.onchange = fillMetrics;
+metricSelect.onchange = () => renderChart(benchSelect.value, metricSelect.value);
+renderReadiness();
+if (benchSelect.options.length) fillMetrics();
+else document.getElementById("chart").textContent = "No runs in the performance history.";
+</script>
+</body>
+</html>
+"""
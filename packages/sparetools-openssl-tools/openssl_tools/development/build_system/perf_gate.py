@@ -0,0 +1,110 @@
+#!/usr/bin/env python3
+"""
+Performance gate for freshly built packages
+
+Builds the native test_package benchmarks (bench_evp, bench_handshake,
+...) against a package folder, runs them with StatisticalBenchmarkRunner
+and compares every metric with the stored baseline for the same
+platform, CPU model, profile and OpenSSL version. Every run is appended
+to the PerfHistoryStore. The gate fails when any metric is a significant
+regression (compare_samples: Mann-Whitney p < alpha, bootstrap CI
+excluding zero, at least min_effect_percent).
+
+A missing baseline is seeded from the first run. Later runs replace it
+only when update_baseline is set, e.g. on the main branch, so a pull
+request cannot move its own reference.
+"""
+
+import logging
+from dataclasses import asdict, dataclass, field
+from pathlib import Path
+from typing import Any, Dict, List, Optional
+
+from .benchmark_matrix import DEFAULT_BENCHES, build_benchmarks, find_bench_binary
+from .perf_history import DEFAULT_STORE, PerfHistoryStore, current_git_commit
+from .statistical_runner import BaselineStore, StatisticalBenchmarkRunner
+
+logger = logging.getLogger(__name__)
+
+DEFAULT_BASELINES = Path("test_results") / "baselines.json"
+
+
+@dataclass
+class GateResult:
+    """Outcome of one gate run over all benchmarks"""
+    passed: bool
+    regressions: List[str] = field(default_factory=list)
+    reports: List[str] = field(default_factory=list)
+    run_ids: List[int] = field(default_factory=list)
+    seeded: List[str] = field(default_factory=list)
+    error: Optional[str] = None
+
+    def to_dict(self) -> Dict[str, Any]:
+        return asdict(self)
+
+
+class PerformanceGate:
+    """Benchmarks a package against baselines and the perf history"""
+
+    def __init__(self, test_package_dir: Path, work_dir: Path, benches: Optional[List[str]] = None,
+                 trials: int = 5, warmup: int = 1, cpus: Optional[List[int]] = None, quick: bool = True,
+                 baselines: Path = DEFAULT_BASELINES, store: Path = DEFAULT_STORE,
+                 alpha: float = 0.01, min_effect_percent: float = 2.0, update_baseline: bool = False):
+        self.test_package_dir = test_package_dir.resolve()
+        self.work_dir = work_dir
+        self.benches = benches or list(DEFAULT_BENCHES)
+        self.trials = trials
+        self.warmup = warmup
+        self.cpus = cpus
+        self.quick = quick
+        self.baselines = baselines
+        self.store = store
+        self.alpha = alpha
+        self.min_effect_percent = min_effect_percent
+        self.update_baseline = update_baseline
+
+    def run(self, prefix: Path, profile: str, package_revision: str = "unknown",
+            git_commit: Optional[str] = None) -> GateResult:
+        """Build and run the benchmarks against the package in prefix"""
+        build_dir, error = build_benchmarks(self.test_package_dir, prefix, self.work_dir / "build", self.benches)
+        if error:
+            return GateResult(False, error=f"benchmark build failed: {error}")
+
+        baselines = BaselineStore(self.baselines)
+        history = PerfHistoryStore(self.store)
+        result = GateResult(True)
+        try:
+            for bench in self.benches:
+                binary = find_bench_binary(build_dir, bench)
+                if binary is None:
+                    logger.warning(f"⚠️ {bench} was not built, skipped")
+                    continue
+                runner = StatisticalBenchmarkRunner(self.work_dir / "trials", trials=self.trials,
+                                                    warmup=self.warmup, cpus=self.cpus)
+                trials = runner.run(binary, ["--quick"] if self.quick else [])
+                key = runner.baseline_key(trials, profile)
+                baseline = baselines.get(key)
+                comparisons = runner.compare(trials, baseline, self.alpha, self.min_effect_percent)
+                result.reports.append(str(runner.write_report(trials, key, comparisons)))
+                result.run_ids.append(history.record(trials, git_commit or current_git_commit(self.test_package_dir),
+                                                     package_revision, profile, runner.platform,
+                                                     runner.cpu_model))
+                regressions = [c for c in comparisons if c.verdict == "regression"]
+                for c in regressions:
+                    result.regressions.append(f"{bench}:{c.metric} {c.change_percent:+.1f}% "
+                                              f"(CI {c.ci_low_percent:+.1f}..{c.ci_high_percent:+.1f}%, "
+                                              f"p={c.p_value:.4f})")
+                if baseline is None or (self.update_baseline and not regressions):
+                    baselines.put(key, trials.samples)
+                    if baseline is None:
+                        result.seeded.append(bench)
+        finally:
+            history.close()
+            baselines.save()
+
+        result.passed = not result.regressions
+        for line in result.regressions:
+            logger.error(f"❌ Regression: {line}")
+        if result.seeded:
+            logger.info(f"📝 Seeded baselines for {', '.join(result.seeded)} ({self.baselines})")
+        return result
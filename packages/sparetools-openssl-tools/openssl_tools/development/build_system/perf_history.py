@@ -0,0 +1,303 @@
+#!/usr/bin/env python3
+"""
+Continuous performance history and regression bisection
+
+PerfHistoryStore is an append-only SQLite database (by default
+test_results/perf_history.sqlite) of benchmark trial samples. Every run is
+keyed by git commit, package revision and profile, together with the
+platform, CPU model and OpenSSL version, so runs are never overwritten
+and any two can be compared later with compare_samples.
+
+PerfBisector binary-searches the commits between a good and a bad
+upstream OpenSSL revision in a source checkout (by default the shared
+_Build/openssl-builds/master/src worktree). Each probed commit is built
+into its own prefix in a detached worktree, so the checkout itself is
+never modified. The test_package benchmark is then built against that
+prefix. A commit counts as bad when the chosen metric regresses
+significantly against the good commit's samples.
+"""
+
+import logging
+import os
+import sqlite3
+import statistics
+import subprocess
+from dataclasses import dataclass
+from datetime import datetime
+from pathlib import Path
+from typing import Any, Dict, Iterator, List, Optional, Tuple
+
+from .benchmark_matrix import build_benchmarks, find_bench_binary
+from .statistical_runner import StatisticalBenchmarkRunner, TrialResults, compare_samples, detect_cpu_model
+
+logger = logging.getLogger(__name__)
+
+DEFAULT_STORE = Path("test_results") / "perf_history.sqlite"
+DEFAULT_BISECT_SOURCE = Path("_Build") / "openssl-builds" / "master" / "src"
+
+_SCHEMA = """
+CREATE TABLE IF NOT EXISTS runs (
+    id INTEGER PRIMARY KEY AUTOINCREMENT,
+    timestamp TEXT NOT NULL,
+    git_commit TEXT NOT NULL,
+    package_revision TEXT NOT NULL,
+    profile TEXT NOT NULL,
+    platform TEXT NOT NULL,
+    cpu_model TEXT NOT NULL,
+    openssl_version TEXT NOT NULL,
+    benchmark TEXT NOT NULL,
+    higher_is_better INTEGER NOT NULL
+);
+CREATE TABLE IF NOT EXISTS samples (
+    run_id INTEGER NOT NULL REFERENCES runs(id),
+    metric TEXT NOT NULL,
+    trial INTEGER NOT NULL,
+    value REAL NOT NULL
+);
+CREATE INDEX IF NOT EXISTS runs_key ON runs (git_commit, package_revision, profile);
+CREATE INDEX IF NOT EXISTS samples_run ON samples (run_id, metric);
+CREATE TRIGGER IF NOT EXISTS runs_append_only BEFORE UPDATE ON runs
+BEGIN SELECT RAISE(ABORT, 'perf history is append-only'); END;
+CREATE TRIGGER IF NOT EXISTS samples_append_only BEFORE UPDATE ON samples
+BEGIN SELECT RAISE(ABORT, 'perf history is append-only'); END;
+CREATE TRIGGER IF NOT EXISTS runs_no_delete BEFORE DELETE ON runs
+BEGIN SELECT RAISE(ABORT, 'perf history is append-only'); END;
+CREATE TRIGGER IF NOT EXISTS samples_no_delete BEFORE DELETE ON samples
+BEGIN SELECT RAISE(ABORT, 'perf history is append-only'); END;
+"""
+
+
+def current_git_commit(path: Path = Path(".")) -> str:
+    """HEAD commit of the repository containing `path` ("unknown" outside git)"""
+    try:
+        result = subprocess.run(["git", "-C", str(path), "rev-parse", "HEAD"],
+                                capture_output=True, text=True, timeout=30)
+        if result.returncode == 0:
+            return result.stdout.strip()
+    except (OSError, subprocess.TimeoutExpired):
+        pass
+    return "unknown"
+
+
+class PerfHistoryStore:
+    """Append-only SQLite store of benchmark samples"""
+
+    def __init__(self, path: Path = DEFAULT_STORE):
+        self.path = path
+        self.path.parent.mkdir(parents=True, exist_ok=True)
+        self._db = sqlite3.connect(str(path))
+        self._db.executescript(_SCHEMA)
+
+    def close(self) -> None:
+        self._db.close()
+
+    def record(self, trials: TrialResults, git_commit: str, package_revision: str,
+               profile: str, platform: str, cpu_model: Optional[str] = None) -> int:
+        """Append one run of trial samples, returning its run id"""
+        with self._db:
+            cursor = self._db.execute(
+                "INSERT INTO runs (timestamp, git_commit, package_revision, profile, platform, "
+                "cpu_model, openssl_version, benchmark, higher_is_better) VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?)",
+                (datetime.now().isoformat(), git_commit, package_revision, profile, platform,
+                 cpu_model or detect_cpu_model(), trials.openssl_version, trials.benchmark,
+                 int(trials.higher_is_better)))
+            run_id = cursor.lastrowid
+            self._db.executemany(
+                "INSERT INTO samples (run_id, metric, trial, value) VALUES (?, ?, ?, ?)",
+                [(run_id, metric, i, value)
+                 for metric, values in trials.samples.items() for i, value in enumerate(values)])
+        return run_id
+
+    def samples(self, run_id: int) -> Dict[str, List[float]]:
+        rows = self._db.execute("SELECT metric, value FROM samples WHERE run_id = ? ORDER BY metric, trial",
+                                (run_id,))
+        result: Dict[str, List[float]] = {}
+        for metric, value in rows:
+            result.setdefault(metric, []).append(value)
+        return result
+
+    def runs(self, benchmark: Optional[str] = None, profile: Optional[str] = None,
+             git_commit: Optional[str] = None, limit: int = 50) -> List[Dict[str, Any]]:
+        """Most recent runs first, optionally filtered"""
+        query = "SELECT * FROM runs WHERE 1 = 1"
+        params: List[Any] = []
+        for column, value in (("benchmark", benchmark), ("profile", profile), ("git_commit", git_commit)):
+            if value is not None:
+                query += f" AND {column} = ?"
+                params.append(value)
+        query += " ORDER BY id DESC LIMIT ?"
+        params.append(limit)
+        cursor = self._db.execute(query, params)
+        columns = [c[0] for c in cursor.description]
+        return [dict(zip(columns, row)) for row in cursor]
+
+    def runs_with_samples(self, benchmark: Optional[str] = None
+                          ) -> Iterator[Tuple[Dict[str, Any], Dict[str, List[float]]]]:
+        """Every run with its samples by metric, oldest first, in one query"""
+        query = ("SELECT runs.*, samples.metric, samples.value FROM runs JOIN samples ON samples.run_id = runs.id"
+                 + (" WHERE runs.benchmark = ?" if benchmark is not None else "")
+                 + " ORDER BY runs.id, samples.metric, samples.trial")
+        cursor = self._db.execute(query, (benchmark,) if benchmark is not None else ())
+        columns = [c[0] for c in cursor.description][:-2]
+        run: Optional[Dict[str, Any]] = None
+        samples: Dict[str, List[float]] = {}
+        for row in cursor:
+            if run is None or row[0] != run["id"]:
+                if run is not None:
+                    yield run, samples
+                run, samples = dict(zip(columns, row[:-2])), {}
+            samples.setdefault(row[-2], []).append(row[-1])
+        if run is not None:
+            yield run, samples
+
+    def history(self, metric: str, benchmark: Optional[str] = None,
+                profile: Optional[str] = None, limit: int = 50) -> List[Dict[str, Any]]:
+        """Median of `metric` per run, oldest first"""
+        history = []
+        for run in reversed(self.runs(benchmark, profile, limit=limit)):
+            values = self.samples(run["id"]).get(metric)
+            if values:
+                history.append({**run, "metric": metric, "median": statistics.median(values),
+                                "trials": len(values)})
+        return history
+
+
+@dataclass
+class BisectStep:
+    commit: str
+    median: Optional[float]
+    change_percent: Optional[float]
+    verdict: str  # "good", "bad" or "skip"
+
+
+class PerfBisector:
+    """Finds the first upstream commit where a metric regresses"""
+
+    def __init__(self, source_dir: Path, work_dir: Path, test_package_dir: Path, bench: str,
+                 metric: str, store: Optional[PerfHistoryStore] = None, trials: int = 5,
+                 warmup: int = 1, cpus: Optional[List[int]] = None, quick: bool = False,
+                 alpha: float = 0.01, min_effect_percent: float = 2.0, jobs: Optional[int] = None):
+        self.source_dir = source_dir.resolve()
+        self.work_dir = work_dir.resolve()
+        self.work_dir.mkdir(parents=True, exist_ok=True)
+        self.test_package_dir = test_package_dir.resolve()
+        self.bench = bench
+        self.metric = metric
+        self.store = store
+        self.trials = trials
+        self.warmup = warmup
+        self.cpus = cpus
+        self.quick = quick
+        self.alpha = alpha
+        self.min_effect_percent = min_effect_percent
+        self.jobs = jobs or os.cpu_count() or 1
+        self.worktree = self.work_dir / "src"
+        self.steps: List[BisectStep] = []
+
+    def _git(self, *args: str, cwd: Optional[Path] = None) -> str:
+        result = subprocess.run(["git", "-C", str(cwd or self.source_dir)] + list(args),
+                                capture_output=True, text=True)
+        if result.returncode != 0:
+            raise RuntimeError(f"git {' '.join(args)} failed: {result.stderr.strip()}")
+        return result.stdout.strip()
+
+    def commits(self, good: str, bad: str) -> List[str]:
+        """Commits after `good` up to and including `bad`, oldest first"""
+        return self._git("rev-list", "--reverse", "--ancestry-path", f"{good}..{bad}").split()
+
+    def _build_openssl(self, commit: str) -> Optional[Path]:
+        """Build `commit` into work_dir/install/<commit>, reusing earlier builds"""
+        prefix = self.work_dir / "install" / commit
+        if (prefix / "include" / "openssl" / "opensslv.h").exists():
+            return prefix
+        if not self.worktree.exists():
+            self._git("worktree", "add", "--detach", str(self.worktree), commit)
+        else:
+            self._git("checkout", "--detach", "--force", commit, cwd=self.worktree)
+            self._git("clean", "-fdxq", cwd=self.worktree)
+
+        logger.info(f"🔨 Building OpenSSL {commit[:12]}")
+        for cmd in (["./Configure", f"--prefix={prefix}", "--libdir=lib", "no-tests"],
+                    ["make", f"-j{self.jobs}", "build_libs"],
+                    ["make", "install_dev"]):
+            result = subprocess.run(cmd, cwd=self.worktree, capture_output=True, text=True)
+            if result.returncode != 0:
+                logger.warning(f"⚠️ {commit[:12]}: {' '.join(cmd)} failed")
+                return None
+        return prefix
+
+    def measure(self, commit: str) -> Optional[TrialResults]:
+        """Build and benchmark one commit; None if it cannot be built"""
+        prefix = self._build_openssl(commit)
+        if prefix is None:
+            return None
+        build_dir, error = build_benchmarks(self.test_package_dir, prefix,
+                                            self.work_dir / "bench" / commit, [self.bench])
+        binary = find_bench_binary(build_dir, self.bench) if build_dir else None
+        if binary is None:
+            logger.warning(f"⚠️ {commit[:12]}: benchmark build failed: {error}")
+            return None
+        runner = StatisticalBenchmarkRunner(self.work_dir / "trials" / commit, trials=self.trials,
+                                            warmup=self.warmup, cpus=self.cpus,
+                                            env={"LD_LIBRARY_PATH": str(prefix / "lib")})
+        trials = runner.run(binary, ["--quick"] if self.quick else [])
+        if self.store is not None:
+            self.store.record(trials, git_commit=commit, package_revision="upstream",
+                              profile="bisect", platform=runner.platform, cpu_model=runner.cpu_model)
+        return trials
+
+    def bisect(self, good: str, bad: str) -> Optional[str]:
+        """First commit in good..bad whose metric regresses against `good`"""
+        good, bad = self._git("rev-parse", good), self._git("rev-parse", bad)
+        # Checked before any build: an empty range has nothing to bisect
+        commits = self.commits(good, bad)
+        if not commits:
+            raise ValueError(f"No commits in {good[:12]}..{bad[:12]}; bad must be a descendant of good")
+        reference = self.measure(good)
+        if reference is None or self.metric not in reference.samples:
+            raise RuntimeError(f"Cannot measure {self.metric} at good commit {good[:12]}")
+        baseline = reference.samples[self.metric]
+        self.steps.append(BisectStep(good, statistics.median(baseline), 0.0, "good"))
+
+        def is_bad(commit: str) -> Optional[bool]:
+            trials = self.measure(commit)
+            samples = trials.samples.get(self.metric) if trials else None
+            if not samples:
+                self.steps.append(BisectStep(commit, None, None, "skip"))
+                return None
+            comparison = compare_samples(self.metric, samples, baseline, reference.higher_is_better,
+                                         self.alpha, self.min_effect_percent)
+            regressed = comparison.verdict == "regression"
+            self.steps.append(BisectStep(commit, comparison.current_median, comparison.change_percent,
+                                         "bad" if regressed else "good"))
+            logger.info(f"{'❌' if regressed else '✅'} {commit[:12]}: {comparison.change_percent:+.2f}% "
+                        f"(p={comparison.p_value:.4f})")
+            return regressed
+
+        logger.info(f"🔍 Bisecting {len(commits)} commits for {self.metric}")
+        if is_bad(commits[-1]) is not True:
+            logger.info(f"✅ No significant regression at {bad[:12]}")
+            return None
+
+        # Invariant: everything at or before lo is good, commits[hi] is bad
+        lo, hi = -1, len(commits) - 1
+        while hi - lo > 1:
+            mid = (lo + hi) // 2
+            verdict = is_bad(commits[mid])
+            if verdict is None:
+                # Unbuildable: drop it, as `git bisect skip` would
+                commits.pop(mid)
+                hi -= 1
+            elif verdict:
+                hi = mid
+            else:
+                lo = mid
+        skipped = [step.commit for step in self.steps if step.verdict == "skip"]
+        if skipped:
+            logger.warning(f"⚠️ {len(skipped)} unbuildable commit(s) skipped; the regression may be "
+                           f"in one of them if it directly precedes {commits[hi][:12]}")
+        return commits[hi]
+
+    def cleanup(self) -> None:
+        if self.worktree.exists():
+            self._git("worktree", "remove", "--force", str(self.worktree))
@@ -0,0 +1,230 @@
+#!/usr/bin/env python3
+"""
+Shared pristine OpenSSL sources for the _Build/openssl-builds variants
+
+Every version keeps a single source tree that no build ever writes to, and
+each variant builds out of tree next to it:
+
+    openssl-builds/
+    ├── .openssl.git/           bare clone, one object store for all versions
+    ├── <version>/src/          git worktree at openssl-<version> (or master)
+    ├── <version>/vanilla/build perl ../../src/Configure
+    ├── <version>/python/build  configure.py over a symlink view of ../../src
+    ├── <version>/<variant>/install
+    └── logs/<version>-<variant>-build.log
+
+The sources are git worktrees of one bare repository, so master and the
+release tags share their objects, as do the worktrees PerfBisector adds
+for bisection. The perl variant uses OpenSSL's own out-of-tree support.
+configure.py only builds in its working directory, so the python variant
+builds in a tree of directories whose files are symlinks into src/; the
+files configure.py generates are never linked, so they are written into
+the build tree instead of through the links. Because src/ stays pristine,
+both variants of a version build concurrently from it.
+
+Installs stay at <version>/<variant>/install, the layout
+discover_installs reads.
+"""
+
+import logging
+import os
+import shlex
+import shutil
+import subprocess
+import time
+from concurrent.futures import ThreadPoolExecutor
+from dataclasses import dataclass
+from pathlib import Path
+from typing import List, Optional
+
+logger = logging.getLogger(__name__)
+
+TOOLS_ROOT = Path(__file__).resolve().parents[3]
+DEFAULT_BUILD_ROOT = Path("_Build") / "openssl-builds"
+DEFAULT_CONFIGURE_PY = TOOLS_ROOT.parent / "sparetools-openssl-hybrid" / "configure.py"
+UPSTREAM_URL = "https://github.com/openssl/openssl.git"
+VARIANTS = ["vanilla", "python"]
+
+# Paths configure.py writes into its working directory (linking them would
+# make it write through the link into the pristine source), plus git's own
+PYTHON_UNLINKED = {"Makefile", "build.ninja", "configdata.pm", "buildinf.h", "openssl.cps",
+                   "configure.py", "include/openssl/buildinf.h", "unity", ".git"}
+
+
+@dataclass
+class VariantBuild:
+    """Outcome of building one variant of one version"""
+    version: str
+    variant: str
+    prefix: Path
+    log: Path
+    ok: bool
+    seconds: float
+    error: Optional[str] = None
+
+
+class SharedSourceBuilder:
+    """Pristine per-version worktrees and concurrent out-of-tree variant builds"""
+
+    def __init__(self, root: Path = DEFAULT_BUILD_ROOT, url: str = UPSTREAM_URL,
+                 configure_py: Path = DEFAULT_CONFIGURE_PY, jobs: Optional[int] = None,
+                 configure_args: Optional[List[str]] = None):
+        self.root = root.resolve()
+        self.url = url
+        self.configure_py = configure_py.resolve()
+        self.jobs = jobs or os.cpu_count() or 1
+        self.configure_args = configure_args or []
+        self.repository = self.root / ".openssl.git"
+        self.log_dir = self.root / "logs"
+
+    def _git(self, *args: str) -> str:
+        result = subprocess.run(["git", "--git-dir", str(self.repository)] + list(args),
+                                capture_output=True, text=True)
+        if result.returncode != 0:
+            raise RuntimeError(f"git {' '.join(args)} failed: {result.stderr.strip()}")
+        return result.stdout.strip()
+
+    @staticmethod
+    def ref_for(version: str) -> str:
+        return version if version == "master" else f"openssl-{version}"
+
+    def source_dir(self, version: str) -> Path:
+        return self.root / version / "src"
+
+    def _legacy_sources(self) -> List[Path]:
+        return sorted(p for variant in VARIANTS for p in self.root.glob(f"*/{variant}/src") if p.is_dir())
+
+    def ensure_repository(self, update: bool = False) -> None:
+        """Create the bare clone, seeded from a legacy per-variant checkout when possible"""
+        if not self.repository.exists():
+            self.root.mkdir(parents=True, exist_ok=True)
+            seed = next((p for p in self._legacy_sources() if (p / ".git").exists()), None)
+            logger.info(f"📥 Cloning {seed or self.url} into {self.repository}")
+            subprocess.run(["git", "clone", "--bare", "--quiet", str(seed or self.url), str(self.repository)],
+                           check=True)
+            self._git("remote", "set-url", "origin", self.url)
+            if seed is not None:
+                # The seed may lack other versions' tags; offline it is still usable
+                try:
+                    self._git("fetch", "--quiet", "--tags", "origin", "+refs/heads/*:refs/heads/*")
+                except RuntimeError as e:
+                    logger.warning(f"⚠️ Could not fetch {self.url}: {e}")
+                return
+            update = True
+        if update:
+            self._git("fetch", "--quiet", "--prune", "--tags", "origin", "+refs/heads/*:refs/heads/*")
+
+    def ensure_source(self, version: str, update: bool = False) -> Path:
+        """Worktree for `version`; an existing tree is moved only when `update` is set"""
+        src = self.source_dir(version)
+        ref = self.ref_for(version)
+        if not (src / ".git").exists():
+            if src.exists() and any(src.iterdir()):
+                # A plain source copy (e.g. an unpacked tarball) is used as-is
+                logger.info(f"📂 Using existing source tree {src}")
+                return src
+            self._git("worktree", "prune")
+            self._git("worktree", "add", "--detach", str(src), ref)
+        elif update:
+            subprocess.run(["git", "-C", str(src), "checkout", "--quiet", "--detach", ref], check=True)
+        for marker in ("configdata.pm", "Makefile"):
+            if (src / marker).exists():
+                raise RuntimeError(f"{src} holds an in-tree build ({marker}); "
+                                   f"run `git -C {src} clean -fdx` to share it")
+        return src
+
+    @staticmethod
+    def link_tree(src: Path, build_dir: Path) -> int:
+        """Mirror src's directories in build_dir with file symlinks; returns links created"""
+        created = 0
+        for dirpath, dirnames, filenames in os.walk(src):
+            rel = Path(dirpath).relative_to(src)
+            dirnames[:] = [d for d in dirnames if (rel / d).as_posix() not in PYTHON_UNLINKED]
+            target_dir = build_dir / rel
+            target_dir.mkdir(parents=True, exist_ok=True)
+            for name in filenames:
+                if (rel / name).as_posix() in PYTHON_UNLINKED:
+                    continue
+                link = target_dir / name
+                source = Path(dirpath) / name
+                if link.is_symlink():
+                    if os.readlink(link) == str(source):
+                        continue
+                    link.unlink()
+                elif link.exists():
+                    continue
+                link.symlink_to(source)
+                created += 1
+        return created
+
+    def _commands(self, version: str, variant: str, src: Path, build_dir: Path,
+                  prefix: Path, jobs: int) -> List[List[str]]:
+        if variant == "vanilla":
+            configure = ["perl", os.path.relpath(src / "Configure", build_dir), f"--prefix={prefix}"]
+            return [configure + self.configure_args,
+                    ["make", f"-j{jobs}"],
+                    ["make", "install_sw", "install_ssldirs"]]
+        if variant == "python":
+            created = self.link_tree(src, build_dir)
+            shutil.copy2(self.configure_py, build_dir / "configure.py")
+            logger.debug(f"{version}/python: {created} new source links")
+            return [["python3", "configure.py", f"--prefix={prefix}"] + self.configure_args,
+                    ["make", f"-j{jobs}", "build_libs"],
+                    ["make", "install_sw"]]
+        raise ValueError(f"Unknown variant {variant!r} (expected one of {', '.join(VARIANTS)})")
+
+    def build_variant(self, version: str, variant: str, jobs: int) -> VariantBuild:
+        """Configure, build and install one variant out of tree, logging to logs/"""
+        src = self.source_dir(version)
+        build_dir = self.root / version / variant / "build"
+        prefix = self.root / version / variant / "install"
+        build_dir.mkdir(parents=True, exist_ok=True)
+        self.log_dir.mkdir(parents=True, exist_ok=True)
+        log = self.log_dir / f"{version}-{variant}-build.log"
+        start = time.monotonic()
+
+        with open(log, "w") as out:
+            for cmd in self._commands(version, variant, src, build_dir, prefix, jobs):
+                out.write(f"$ {shlex.join(cmd)}\n")
+                out.flush()
+                result = subprocess.run(cmd, cwd=build_dir, stdout=out, stderr=subprocess.STDOUT)
+                if result.returncode != 0:
+                    return VariantBuild(version, variant, prefix, log, False, time.monotonic() - start,
+                                        f"{cmd[0]} {cmd[1]} exited with {result.returncode}")
+        return VariantBuild(version, variant, prefix, log, True, time.monotonic() - start)
+
+    def build(self, versions: List[str], variants: List[str], update: bool = False) -> List[VariantBuild]:
+        """Prepare each version's source once, then build all variants concurrently"""
+        unknown = [v for v in variants if v not in VARIANTS]
+        if unknown:
+            raise ValueError(f"Unknown variant(s): {', '.join(unknown)}")
+        if not all((self.source_dir(v) / "Configure").exists() for v in versions) or update:
+            self.ensure_repository(update)
+        for version in versions:
+            self.ensure_source(version, update)
+
+        tasks = [(version, variant) for version in versions for variant in variants]
+        # Split the job budget so concurrent builds do not oversubscribe the host
+        jobs = max(1, self.jobs // len(tasks))
+        logger.info(f"🔨 Building {len(tasks)} variant(s), {jobs} job(s) each")
+        with ThreadPoolExecutor(max_workers=len(tasks)) as pool:
+            results = list(pool.map(lambda task: self.build_variant(*task, jobs), tasks))
+        for result in results:
+            if result.ok:
+                logger.info(f"✅ {result.version}/{result.variant}: {result.prefix} ({result.seconds:.0f}s)")
+            else:
+                logger.warning(f"❌ {result.version}/{result.variant}: {result.error}, see {result.log}")
+        return results
+
+    def prune_legacy(self, versions: List[str]) -> List[Path]:
+        """Remove per-variant source copies of versions that now have a shared src/"""
+        removed = []
+        for version in versions:
+            if not (self.source_dir(version) / "Configure").exists():
+                continue
+            for variant in VARIANTS:
+                legacy = self.root / version / variant / "src"
+                if legacy.is_dir() and not legacy.is_symlink():
+                    shutil.rmtree(legacy)
+                    removed.append(legacy)
+        return removed
@@ -0,0 +1,269 @@
+#!/usr/bin/env python3
+"""
+Benchmark-driven SSL_CTX autotuner
+
+Searches the SSL_CTX parameters whose best values depend on the host and
+the build: read buffer length (with read-ahead), max_send_fragment,
+max_pipelines with split_send_fragment, the key exchange group order, the
+server session cache size and the TLS 1.3 ticket count. Every candidate is
+measured with the test_package bench_sslctx probe (full and resumed
+handshakes over a BIO pair, bulk transfer over TCP loopback), repeated by
+StatisticalBenchmarkRunner.
+
+A candidate's score per trial is
+
+    exp(handshake_weight * ln(connections/s) + (1 - handshake_weight) * ln(MB/s))
+
+where connections/s mixes the full and resumed rates at the settings'
+resumption_rate. The search is coordinate descent from the starting
+settings (library defaults unless a CryptoConfigManager configuration
+says otherwise): one parameter at a time, every candidate value, and a
+value only replaces the incumbent when compare_samples() calls the
+difference an improvement, so noise never moves a setting away from its
+default. Passes repeat until one changes nothing. The session cache size
+is only searched when servers resume from it (stateful tickets, see
+PerformanceSettings.server_cache); --clients should then be the number of
+clients expected to resume.
+
+The result is written through CryptoConfigManager as the performance
+openssl.cnf: Groups and NumTickets as ssl_conf commands, the API-only
+settings as the SSL_CTX calls to make. The JSON report lists every trial.
+"""
+
+import argparse
+import json
+import logging
+import math
+import platform
+import statistics
+import subprocess
+import sys
+from dataclasses import asdict, dataclass, field, replace
+from datetime import datetime
+from pathlib import Path
+from typing import Any, Dict, List, Optional, Tuple
+
+try:
+    from .statistical_runner import StatisticalBenchmarkRunner, compare_samples, _parse_cpus, _positive_int
+    from ...openssl.crypto_config import CryptoConfigManager, PerformanceSettings
+except ImportError:
+    sys.path.insert(0, str(Path(__file__).resolve().parents[2] / "openssl"))
+    from statistical_runner import StatisticalBenchmarkRunner, compare_samples, _parse_cpus, _positive_int
+    from crypto_config import CryptoConfigManager, PerformanceSettings
+
+logger = logging.getLogger(__name__)
+
+# Parameter -> candidate values. The pipelines entries set max_pipelines
+# and split_send_fragment together; groups candidates are the starting
+# list rotated so each group leads once.
+SEARCH_SPACE: Dict[str, List[Any]] = {
+    "groups": [],
+    "num_tickets": [1, 2, 4],
+    "session_cache_size": [0, 1024, 4096, 65536, 262144],
+    "read_buffer_len": [0, 32768, 65536, 131072],
+    "max_send_fragment": [0, 4096, 8192],
+    "pipelines": [(0, 0), (2, 8192), (4, 4096), (8, 2048)],
+}
+
+
+@dataclass
+class TuneTrial:
+    """One measured candidate"""
+    parameter: str
+    value: Any
+    args: List[str]
+    medians: Dict[str, float] = field(default_factory=dict)
+    score: float = 0.0
+    change_percent: float = 0.0
+    verdict: str = ""
+    error: Optional[str] = None
+
+
+def _get(settings: PerformanceSettings, parameter: str) -> Any:
+    if parameter == "pipelines":
+        return (settings.max_pipelines, settings.split_send_fragment)
+    return getattr(settings, parameter)
+
+
+def _set(settings: PerformanceSettings, parameter: str, value: Any) -> PerformanceSettings:
+    if parameter == "pipelines":
+        return replace(settings, max_pipelines=value[0], split_send_fragment=value[1])
+    return replace(settings, **{parameter: list(value) if parameter == "groups" else value})
+
+
+def probe_args(settings: PerformanceSettings, clients: int) -> List[str]:
+    """bench_sslctx arguments measuring settings"""
+    args = ["--groups", ":".join(settings.groups), "--num-tickets", str(settings.num_tickets),
+            "--clients", str(clients)]
+    if settings.server_cache:
+        args += ["--stateful", "--session-cache-size", str(settings.session_cache_size)]
+    for flag, value in (("--read-buffer", settings.read_buffer_len),
+                        ("--max-send-fragment", settings.max_send_fragment),
+                        ("--pipelines", settings.max_pipelines),
+                        ("--split-send-fragment", settings.split_send_fragment)):
+        if value:
+            args += [flag, str(value)]
+    return args
+
+
+class SSLCtxTuner:
+    """Coordinate descent over SEARCH_SPACE with bench_sslctx measurements"""
+
+    def __init__(self, probe: Path, results_dir: Path, trials: int = 5, warmup: int = 1,
+                 cpus: Optional[List[int]] = None, quick: bool = False, clients: int = 256,
+                 handshake_weight: float = 0.5, alpha: float = 0.05, min_effect_percent: float = 2.0,
+                 max_passes: int = 3):
+        if not 0.0 <= handshake_weight <= 1.0:
+            raise ValueError("handshake_weight must be between 0 and 1")
+        self.probe = probe
+        self.results_dir = results_dir
+        self.runner = StatisticalBenchmarkRunner(results_dir, trials, warmup, cpus)
+        self.quick = quick
+        self.clients = clients
+        self.handshake_weight = handshake_weight
+        self.alpha = alpha
+        self.min_effect_percent = min_effect_percent
+        self.max_passes = max_passes
+        self.trials: List[TuneTrial] = []
+        self._measured: Dict[Tuple[str, ...], Tuple[List[float], Dict[str, float]]] = {}
+
+    def _scores(self, samples: Dict[str, List[float]], resumption_rate: float) -> List[float]:
+        w = self.handshake_weight
+        scores = []
+        for full, resumed, bulk in zip(samples["full/rate"], samples["resumed/rate"], samples["bulk/rate"]):
+            connections = 1.0 / ((1.0 - resumption_rate) / full + resumption_rate / resumed)
+            scores.append(math.exp(w * math.log(connections) + (1.0 - w) * math.log(bulk)))
+        return scores
+
+    def measure(self, settings: PerformanceSettings) -> Tuple[List[float], Dict[str, float]]:
+        """Per-trial scores and per-phase medians; identical arguments are measured once"""
+        args = probe_args(settings, self.clients)
+        key = tuple(args)
+        if key not in self._measured:
+            trials = self.runner.run(self.probe, (["--quick"] if self.quick else []) + args)
+            if not all(m in trials.samples for m in ("full/rate", "resumed/rate", "bulk/rate")):
+                raise RuntimeError(f"{self.probe.name} reported {sorted(trials.samples)}")
+            medians = {m.split("/")[0]: statistics.median(v) for m, v in trials.samples.items()}
+            self._measured[key] = (self._scores(trials.samples, settings.resumption_rate), medians)
+        return self._measured[key]
+
+    def candidates(self, parameter: str, settings: PerformanceSettings) -> List[Any]:
+        if parameter == "groups":
+            return [[g] + [o for o in settings.groups if o != g] for g in settings.groups]
+        return list(SEARCH_SPACE[parameter])
+
+    def tune(self, settings: Optional[PerformanceSettings] = None,
+             parameters: Optional[List[str]] = None) -> PerformanceSettings:
+        """Best settings found, starting from settings (default PerformanceSettings())"""
+        best = settings or PerformanceSettings()
+        parameters = parameters or list(SEARCH_SPACE)
+        unknown = [p for p in parameters if p not in SEARCH_SPACE]
+        if unknown:
+            raise ValueError(f"Unknown parameters: {', '.join(unknown)} (known: {', '.join(SEARCH_SPACE)})")
+        if "session_cache_size" in parameters and not best.server_cache:
+            logger.info("ℹ️ session_cache_size not searched: stateless tickets do not use the server cache")
+            parameters = [p for p in parameters if p != "session_cache_size"]
+
+        best_scores, _ = self.measure(best)
+        for number in range(1, self.max_passes + 1):
+            changed = False
+            for parameter in parameters:
+                incumbent = _get(best, parameter)
+                for value in self.candidates(parameter, best):
+                    if value == incumbent or (parameter == "groups" and list(value) == list(incumbent)):
+                        continue
+                    candidate = _set(best, parameter, value)
+                    trial = TuneTrial(parameter, value, probe_args(candidate, self.clients))
+                    try:
+                        scores, trial.medians = self.measure(candidate)
+                    except (OSError, RuntimeError, ValueError, subprocess.TimeoutExpired) as e:
+                        # Groups the library lacks, fragment sizes libssl refuses
+                        trial.error, trial.verdict = str(e), "failed"
+                        self.trials.append(trial)
+                        logger.warning(f"⚠️ {parameter}={value}: {e}")
+                        continue
+                    comparison = compare_samples(f"{parameter}={value}", scores, best_scores, True,
+                                                 self.alpha, self.min_effect_percent)
+                    trial.score = statistics.median(scores)
+                    trial.change_percent = comparison.change_percent
+                    trial.verdict = comparison.verdict
+                    self.trials.append(trial)
+                    logger.info(f"  pass {number} {parameter}={value}: {comparison.change_percent:+.1f}% "
+                                f"({comparison.verdict})")
+                    if comparison.verdict == "improvement":
+                        best, best_scores, incumbent, changed = candidate, scores, value, True
+            if not changed:
+                break
+        return best
+
+    def write_outputs(self, tuned: PerformanceSettings, manager: CryptoConfigManager,
+                      config_path: Path, report_path: Path) -> None:
+        """Tuned openssl.cnf through CryptoConfigManager and the JSON trial report"""
+        manager.enable_performance_tuning(tuned)
+        config_path.parent.mkdir(parents=True, exist_ok=True)
+        manager.generate_openssl_config(str(config_path), performance=True)
+        scores, medians = self.measure(tuned)
+        report = {
+            "timestamp": datetime.now().isoformat(),
+            "probe": str(self.probe),
+            "platform": f"{platform.system().lower()}-{platform.machine().lower()}",
+            "cpu_model": self.runner.cpu_model,
+            "numa_topology": self.runner.topology,
+            "trials_per_candidate": self.runner.trials,
+            "clients": self.clients,
+            "handshake_weight": self.handshake_weight,
+            "tuned": tuned.to_dict(),
+            "tuned_medians": medians,
+            "tuned_score": statistics.median(scores),
+            "ssl_ctx_calls": tuned.ssl_ctx_calls(),
+            "candidates": [asdict(t) for t in self.trials],
+        }
+        report_path.parent.mkdir(parents=True, exist_ok=True)
+        report_path.write_text(json.dumps(report, indent=2))
+
+
+def main(argv: Optional[List[str]] = None) -> int:
+    logging.basicConfig(level=logging.INFO, format='%(asctime)s - %(levelname)s - %(message)s')
+    parser = argparse.ArgumentParser(description="Tune SSL_CTX parameters with bench_sslctx")
+    parser.add_argument("probe", type=Path, help="test_package bench_sslctx binary")
+    parser.add_argument("--config", help="CryptoConfigManager configuration to start from")
+    parser.add_argument("--output", type=Path, default=Path("openssl-tuned.cnf"), help="Tuned openssl.cnf")
+    parser.add_argument("--report", type=Path, default=Path("performance_results/sslctx-tuning.json"))
+    parser.add_argument("--results-dir", type=Path, default=Path("performance_results/sslctx"))
+    parser.add_argument("--save-config", help="Also save the tuned CryptoConfigManager configuration here")
+    parser.add_argument("--parameters", nargs="+", choices=list(SEARCH_SPACE), help="Search only these")
+    parser.add_argument("--trials", type=_positive_int, default=5)
+    parser.add_argument("--warmup", type=int, default=1)
+    parser.add_argument("--cpus", type=_parse_cpus, help="Pin to CPUs, e.g. 2,3 or 0-3")
+    parser.add_argument("--quick", action="store_true", help="Pass --quick to the probe (smoke runs)")
+    parser.add_argument("--clients", type=int, default=256, help="Resuming client population")
+    parser.add_argument("--handshake-weight", type=float, default=0.5,
+                        help="Share of the score from connections/s, the rest from bulk MB/s")
+    parser.add_argument("--alpha", type=float, default=0.05, help="Mann-Whitney significance level")
+    parser.add_argument("--min-effect", type=float, default=2.0,
+                        help="Smallest median score change (%%) that replaces a setting")
+    args = parser.parse_args(argv)
+
+    manager = CryptoConfigManager(args.config)
+    start = manager.current_config.performance or manager.enable_performance_tuning()
+    tuner = SSLCtxTuner(args.probe, args.results_dir, args.trials, args.warmup, args.cpus, args.quick,
+                        args.clients, args.handshake_weight, args.alpha, args.min_effect)
+    try:
+        tuned = tuner.tune(start, args.parameters)
+        tuner.write_outputs(tuned, manager, args.output, args.report)
+    except (OSError, RuntimeError, ValueError, subprocess.TimeoutExpired) as e:
+        logger.error(f"❌ Tuning failed: {e}")
+        return 1
+    if args.save_config:
+        manager.save_configuration(args.save_config)
+
+    for parameter in SEARCH_SPACE:
+        before, after = _get(start, parameter), _get(tuned, parameter)
+        if before != after:
+            logger.info(f"✅ {parameter}: {before} -> {after}")
+    logger.info(f"📊 Report: {args.report}")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,476 @@
+#!/usr/bin/env python3
+"""
+Statistically Rigorous Benchmark Runner for the test_package bench_* binaries
+
+Replaces fixed-tolerance baseline checks with repeated trials:
+- warm-up runs that are discarded
+- CPU pinning (sched_setaffinity) so trials do not migrate between cores
+- N independent trials per benchmark, one sample per trial and metric
+- bootstrap confidence interval of the median change vs. the baseline
+- Mann-Whitney U test (exact for small samples, normal approximation otherwise)
+
+Baselines store the raw trial samples and are keyed by
+(platform, CPU model, profile, OpenSSL version), so a Graviton baseline is
+never compared against an x86 run, nor 3.3 against 3.6.
+"""
+
+import os
+import sys
+import json
+import math
+import random
+import logging
+import platform
+import subprocess
+import statistics
+from pathlib import Path
+from typing import Dict, List, Optional, Any, Tuple
+from dataclasses import dataclass, field, asdict
+from datetime import datetime
+import argparse
+
+logger = logging.getLogger(__name__)
+
+# Per benchmark (JSON "benchmark" field): record fields identifying a
+# measurement, the metric to compare and whether higher is better
+BENCH_METRICS: Dict[str, Tuple[Tuple[str, ...], str, bool]] = {
+    "evp": (("algorithm", "buffer_size"), "mb_per_s", True),
+    "handshake": (("group", "mode"), "handshakes_per_s", True),
+    "fetch": (("operation", "mode"), "ns_per_op", False),
+    "params": (("group", "method"), "ns_per_op", False),
+    "mac": (("algorithm", "message_bytes", "pattern"), "ns_per_op", False),
+    "bn": (("profile", "operation", "bits"), "ops_per_s", True),
+    "threads": (("workload", "threads"), "ops_per_s", True),
+    "threads_numa": (("workload", "cpu_node", "mem_node"), "ops_per_s", True),
+    "ktls": (("mode",), "gbit_per_s", True),
+    "certcomp": (("algorithm", "mode"), "server_cpu_us", False),
+    "ocsp": (("mode",), "server_cpu_us", False),
+    "crl": (("mode", "entries"), "verify_us", False),
+    "cpu_dispatch": (("profile", "workload"), "mb_per_s", True),
+    "cli": (("cli", "workload"), "wall_ms_p50", False),
+    "afalg": (("backend", "algorithm", "buffer_size"), "mb_per_s", True),
+    "sslctx": (("phase",), "rate", True),
+    "loadgen": (("mode",), "handshakes_per_s", True),
+    "secheap": (("heap", "workload", "threads"), "ops_per_sec", True),
+    "libctx": (("mode", "workload", "threads"), "ops_per_sec", True),
+    "signctx": (("alg", "method", "threads"), "signs_per_sec", True),
+    "replay": (("scope", "value"), "us", False),
+}
+
+
+def detect_cpu_model() -> str:
+    """CPU model string of this host (used in baseline keys)"""
+    try:
+        with open("/proc/cpuinfo") as f:
+            for line in f:
+                # x86 "model name", ARM "CPU part" (e.g. 0xd0c = Neoverse N1)
+                if line.startswith(("model name", "CPU part")):
+                    return line.split(":", 1)[1].strip()
+    except OSError:
+        pass
+    if sys.platform == "darwin":
+        try:
+            return subprocess.run(["sysctl", "-n", "machdep.cpu.brand_string"],
+                                  capture_output=True, text=True).stdout.strip()
+        except OSError:
+            pass
+    return platform.processor() or platform.machine()
+
+
+def detect_numa_topology() -> Dict[str, Any]:
+    """
+    NUMA topology of this host, as bench_numa.h sees it: the nodes with
+    CPUs, their CPU lists and SLIT distances, plus a signature string so
+    results from hosts with different layouts are not compared blindly.
+    Hosts without /sys/devices/system/node are one node.
+    """
+    node_dir = Path("/sys/devices/system/node")
+    nodes: List[Dict[str, Any]] = []
+    try:
+        online = _parse_cpus((node_dir / "online").read_text())
+        for node_id in online:
+            cpulist = (node_dir / f"node{node_id}" / "cpulist").read_text().strip()
+            if not cpulist:
+                continue  # Memory-only node
+            distances = [int(d) for d in (node_dir / f"node{node_id}" / "distance").read_text().split()]
+            nodes.append({"id": node_id, "cpus": cpulist, "ncpus": len(_parse_cpus(cpulist)),
+                          "distances": dict(zip(online, distances))})
+    except (OSError, ValueError):
+        nodes = []
+    if not nodes:
+        ncpu = os.cpu_count() or 1
+        nodes = [{"id": 0, "cpus": f"0-{ncpu - 1}", "ncpus": ncpu, "distances": {0: 10}}]
+    ids = [n["id"] for n in nodes]
+    # Distances between CPU nodes only, in node order
+    matrix = [[n["distances"].get(i, 0) for i in ids] for n in nodes]
+    for node, row in zip(nodes, matrix):
+        node["distances"] = row
+    return {
+        "nodes": nodes,
+        "signature": f"nodes={len(nodes)};cpus={','.join(str(n['ncpus']) for n in nodes)};"
+                     f"distances={'/'.join(','.join(map(str, row)) for row in matrix)}",
+    }
+
+
+@dataclass(frozen=True)
+class BaselineKey:
+    """Identity of a baseline: results only compare within the same key"""
+    platform: str
+    cpu_model: str
+    profile: str
+    openssl_version: str
+
+    @property
+    def id(self) -> str:
+        return "|".join([self.platform, self.cpu_model, self.profile, self.openssl_version])
+
+
+@dataclass
+class MetricComparison:
+    """Result of comparing one metric's trial samples with its baseline"""
+    metric: str
+    higher_is_better: bool
+    current_median: float
+    baseline_median: float
+    change_percent: float
+    ci_low_percent: float
+    ci_high_percent: float
+    p_value: float
+    verdict: str  # "regression", "improvement", "no-change" or "no-baseline"
+
+
+def bootstrap_median_change(current: List[float], baseline: List[float],
+                            confidence: float = 0.95, resamples: int = 5000,
+                            seed: int = 1) -> Tuple[float, float]:
+    """
+    Percentile bootstrap CI of the relative median change
+    (median(current) / median(baseline) - 1) in percent.
+    """
+    rng = random.Random(seed)
+    changes = []
+    for _ in range(resamples):
+        cur = statistics.median(rng.choices(current, k=len(current)))
+        base = statistics.median(rng.choices(baseline, k=len(baseline)))
+        if base != 0:
+            changes.append((cur / base - 1.0) * 100.0)
+    if not changes:
+        return 0.0, 0.0
+    changes.sort()
+    alpha = (1.0 - confidence) / 2.0
+    low = changes[int(alpha * (len(changes) - 1))]
+    high = changes[int(math.ceil((1.0 - alpha) * (len(changes) - 1)))]
+    return low, high
+
+
+def _exact_u_distribution(n1: int, n2: int) -> List[int]:
+    """Number of arrangements giving each U value (no ties), U = 0..n1*n2"""
+    # counts[i][j] over U for i elements of sample 1 and j of sample 2
+    prev = [[1] for _ in range(n2 + 1)]  # i = 0: U is always 0
+    for i in range(1, n1 + 1):
+        cur = [[1]]  # j = 0: U is always 0
+        for j in range(1, n2 + 1):
+            # Largest element from sample 1 adds j to U, from sample 2 adds 0
+            a = [0] * j + prev[j]
+            b = cur[j - 1]
+            size = max(len(a), len(b))
+            cur.append([(a[k] if k < len(a) else 0) + (b[k] if k < len(b) else 0)
+                        for k in range(size)])
+        prev = cur
+    return prev[n2]
+
+
+def mann_whitney_u(a: List[float], b: List[float]) -> Tuple[float, float]:
+    """
+    Two-sided Mann-Whitney U test. Returns (U of sample a, p-value).
+    Exact distribution for small samples without ties, otherwise the normal
+    approximation with tie and continuity correction.
+    """
+    n1, n2 = len(a), len(b)
+    if n1 == 0 or n2 == 0:
+        return 0.0, 1.0
+
+    combined = sorted([(v, 0) for v in a] + [(v, 1) for v in b])
+    ranks = [0.0] * len(combined)
+    tie_term = 0.0
+    i = 0
+    while i < len(combined):
+        j = i
+        while j + 1 < len(combined) and combined[j + 1][0] == combined[i][0]:
+            j += 1
+        rank = (i + j) / 2.0 + 1.0
+        for k in range(i, j + 1):
+            ranks[k] = rank
+        t = j - i + 1
+        tie_term += t ** 3 - t
+        i = j + 1
+
+    rank_sum_a = sum(r for r, (_, group) in zip(ranks, combined) if group == 0)
+    u_a = rank_sum_a - n1 * (n1 + 1) / 2.0
+    mean_u = n1 * n2 / 2.0
+
+    if tie_term == 0 and n1 * n2 <= 400:
+        counts = _exact_u_distribution(n1, n2)
+        total = sum(counts)
+        u_low = int(round(min(u_a, n1 * n2 - u_a)))
+        p = 2.0 * sum(counts[:u_low + 1]) / total
+        return u_a, min(p, 1.0)
+
+    n = n1 + n2
+    variance = n1 * n2 / 12.0 * ((n + 1) - tie_term / (n * (n - 1)))
+    if variance <= 0:
+        return u_a, 1.0
+    z = (abs(u_a - mean_u) - 0.5) / math.sqrt(variance)
+    p = math.erfc(max(z, 0.0) / math.sqrt(2.0))
+    return u_a, min(p, 1.0)
+
+
+def compare_samples(metric: str, current: List[float], baseline: List[float],
+                    higher_is_better: bool = True, alpha: float = 0.01,
+                    min_effect_percent: float = 2.0,
+                    confidence: float = 0.95) -> MetricComparison:
+    """
+    Classify the change between two sample sets. A regression requires all
+    of: Mann-Whitney p < alpha, a bootstrap CI that excludes zero, and a
+    median change of at least min_effect_percent, so a noisy runner needs
+    consistent evidence rather than one slow trial.
+    """
+    cur_med = statistics.median(current)
+    base_med = statistics.median(baseline)
+    change = (cur_med / base_med - 1.0) * 100.0 if base_med else 0.0
+    low, high = bootstrap_median_change(current, baseline, confidence)
+    _, p = mann_whitney_u(current, baseline)
+
+    verdict = "no-change"
+    if p < alpha and abs(change) >= min_effect_percent and (low > 0 or high < 0):
+        worse = change < 0 if higher_is_better else change > 0
+        verdict = "regression" if worse else "improvement"
+
+    return MetricComparison(metric=metric, higher_is_better=higher_is_better,
+                            current_median=cur_med, baseline_median=base_med,
+                            change_percent=change, ci_low_percent=low,
+                            ci_high_percent=high, p_value=p, verdict=verdict)
+
+
+class BaselineStore:
+    """JSON file of baseline trial samples keyed by BaselineKey"""
+
+    def __init__(self, path: Path):
+        self.path = path
+        self.data: Dict[str, Any] = {"baselines": {}}
+        if path.exists():
+            with open(path, 'r') as f:
+                self.data = json.load(f)
+            self.data.setdefault("baselines", {})
+
+    def get(self, key: BaselineKey) -> Optional[Dict[str, List[float]]]:
+        entry = self.data["baselines"].get(key.id)
+        return entry["samples"] if entry else None
+
+    def put(self, key: BaselineKey, samples: Dict[str, List[float]]) -> None:
+        self.data["baselines"][key.id] = {
+            "key": asdict(key),
+            "timestamp": datetime.now().isoformat(),
+            "samples": samples,
+        }
+
+    def save(self) -> None:
+        self.path.parent.mkdir(parents=True, exist_ok=True)
+        with open(self.path, 'w') as f:
+            json.dump(self.data, f, indent=2, sort_keys=True)
+
+
+@dataclass
+class TrialResults:
+    """Samples collected by StatisticalBenchmarkRunner.run()"""
+    benchmark: str
+    openssl_version: str
+    higher_is_better: bool
+    samples: Dict[str, List[float]] = field(default_factory=dict)
+    # detect_numa_topology() of the host the trials ran on
+    topology: Dict[str, Any] = field(default_factory=dict)
+
+
+class StatisticalBenchmarkRunner:
+    """Runs a bench_* binary repeatedly and compares against stored baselines"""
+
+    def __init__(self, results_dir: Path, trials: int = 10, warmup: int = 1,
+                 cpus: Optional[List[int]] = None, env: Optional[Dict[str, str]] = None):
+        if trials < 1:
+            raise ValueError(f"trials must be at least 1, not {trials}")
+        self.results_dir = results_dir
+        self.results_dir.mkdir(parents=True, exist_ok=True)
+        self.trials = trials
+        self.warmup = warmup
+        self.cpus = cpus
+        # Extra environment for the benchmark (e.g. OPENSSL_ia32cap masks)
+        self.env = env or {}
+        self.platform = f"{platform.system().lower()}-{platform.machine().lower()}"
+        self.cpu_model = detect_cpu_model()
+        self.topology = detect_numa_topology()
+
+    def _pin(self) -> None:
+        """preexec_fn: pin the benchmark process to the selected CPUs"""
+        if self.cpus and hasattr(os, "sched_setaffinity"):
+            os.sched_setaffinity(0, set(self.cpus))
+
+    def _run_once(self, bench_binary: Path, extra_args: List[str], index: int) -> Dict[str, Any]:
+        json_path = self.results_dir / f"{bench_binary.name}.trial{index}.json"
+        cmd = [str(bench_binary), "--json", str(json_path)] + extra_args
+        if self.cpus and not hasattr(os, "sched_setaffinity"):
+            logger.warning("⚠️ CPU pinning not supported on this platform")
+        result = subprocess.run(cmd, capture_output=True, text=True, timeout=3600,
+                                env={**os.environ, **self.env} if self.env else None,
+                                preexec_fn=self._pin if os.name == "posix" else None)
+        if result.returncode != 0 or not json_path.exists():
+            raise RuntimeError(f"{bench_binary.name} failed: {result.stderr.strip()}")
+        with open(json_path, 'r') as f:
+            return json.load(f)
+
+    def run(self, bench_binary: Path, extra_args: Optional[List[str]] = None) -> TrialResults:
+        """Warm up, then collect one sample per metric and trial"""
+        extra_args = extra_args or []
+        logger.info(f"⚡ {bench_binary.name}: {self.warmup} warm-up + {self.trials} trials"
+                    + (f" pinned to CPUs {self.cpus}" if self.cpus else ""))
+
+        for i in range(self.warmup):
+            self._run_once(bench_binary, extra_args, -1 - i)
+
+        trials: Optional[TrialResults] = None
+        for i in range(self.trials):
+            report = self._run_once(bench_binary, extra_args, i)
+            name = report.get("benchmark", bench_binary.name)
+            if name not in BENCH_METRICS:
+                raise ValueError(f"Unknown benchmark type: {name}")
+            key_fields, metric, higher_is_better = BENCH_METRICS[name]
+            if trials is None:
+                trials = TrialResults(benchmark=name,
+                                      openssl_version=report.get("openssl_version", "unknown"),
+                                      higher_is_better=higher_is_better,
+                                      topology=self.topology)
+            for record in report.get("results", []):
+                # Topology and lock-profile records carry no measurement
+                if metric not in record or any(k not in record for k in key_fields):
+                    continue
+                metric_id = "/".join(str(record[k]) for k in key_fields) + f"/{metric}"
+                trials.samples.setdefault(metric_id, []).append(float(record[metric]))
+
+        logger.info(f"✅ Collected {len(trials.samples)} metrics x {self.trials} trials")
+        return trials
+
+    def baseline_key(self, trials: TrialResults, profile: str) -> BaselineKey:
+        return BaselineKey(platform=self.platform, cpu_model=self.cpu_model,
+                           profile=profile, openssl_version=trials.openssl_version)
+
+    def compare(self, trials: TrialResults, baseline: Optional[Dict[str, List[float]]],
+                alpha: float = 0.01, min_effect_percent: float = 2.0) -> List[MetricComparison]:
+        comparisons = []
+        for metric_id, samples in sorted(trials.samples.items()):
+            base = (baseline or {}).get(metric_id)
+            if not base:
+                med = statistics.median(samples)
+                comparisons.append(MetricComparison(metric_id, trials.higher_is_better, med, 0.0,
+                                                    0.0, 0.0, 0.0, 1.0, "no-baseline"))
+                continue
+            comparisons.append(compare_samples(metric_id, samples, base, trials.higher_is_better,
+                                               alpha, min_effect_percent))
+        return comparisons
+
+    def write_report(self, trials: TrialResults, key: BaselineKey,
+                     comparisons: List[MetricComparison]) -> Path:
+        timestamp = datetime.now().strftime("%Y%m%d_%H%M%S")
+        report_path = self.results_dir / f"statistical_report_{trials.benchmark}_{timestamp}.json"
+        report = {
+            "timestamp": datetime.now().isoformat(),
+            "benchmark": trials.benchmark,
+            "baseline_key": asdict(key),
+            "trials": self.trials,
+            "warmup": self.warmup,
+            "cpus": self.cpus,
+            "numa_topology": trials.topology,
+            "comparisons": [asdict(c) for c in comparisons],
+            "summary": {v: sum(1 for c in comparisons if c.verdict == v)
+                        for v in ["regression", "improvement", "no-change", "no-baseline"]},
+        }
+        with open(report_path, 'w') as f:
+            json.dump(report, f, indent=2)
+        return report_path
+
+
+def _positive_int(value: str) -> int:
+    """argparse type for counts that must be at least 1 (--trials)"""
+    number = int(value)
+    if number < 1:
+        raise argparse.ArgumentTypeError(f"must be at least 1, not {number}")
+    return number
+
+
+def _parse_cpus(spec: str) -> List[int]:
+    """"2,3" or "0-3" -> list of CPU ids"""
+    cpus = []
+    for part in spec.split(","):
+        if "-" in part:
+            start, end = part.split("-", 1)
+            cpus.extend(range(int(start), int(end) + 1))
+        elif part:
+            cpus.append(int(part))
+    return cpus
+
+
+def main():
+    """Main entry point"""
+    logging.basicConfig(level=logging.INFO,
+                        format='%(asctime)s - %(name)s - %(levelname)s - %(message)s')
+    parser = argparse.ArgumentParser(description="Statistical benchmark runner for bench_* binaries")
+    parser.add_argument("bench_binary", type=Path, help="test_package bench_* binary")
+    parser.add_argument("--results-dir", type=Path, default=Path("performance_results"))
+    parser.add_argument("--baselines", type=Path, default=Path("performance_results/baselines.json"),
+                        help="Baseline store (JSON)")
+    parser.add_argument("--profile", default="default",
+                        help="Build profile name, part of the baseline key")
+    parser.add_argument("--trials", type=_positive_int, default=10)
+    parser.add_argument("--warmup", type=int, default=1)
+    parser.add_argument("--cpus", type=_parse_cpus, help="Pin to CPUs, e.g. 2,3 or 0-3")
+    parser.add_argument("--alpha", type=float, default=0.01, help="Mann-Whitney significance level")
+    parser.add_argument("--min-effect", type=float, default=2.0,
+                        help="Smallest median change (%%) reported as a regression")
+    parser.add_argument("--quick", action="store_true", help="Pass --quick to the benchmark")
+    parser.add_argument("--save-baseline", action="store_true",
+                        help="Store this run as the baseline for its key")
+    args = parser.parse_args()
+
+    runner = StatisticalBenchmarkRunner(args.results_dir, args.trials, args.warmup, args.cpus)
+    try:
+        trials = runner.run(args.bench_binary, ["--quick"] if args.quick else [])
+    except (OSError, RuntimeError, ValueError, subprocess.TimeoutExpired) as e:
+        logger.error(f"❌ Benchmark run failed: {e}")
+        sys.exit(1)
+
+    store = BaselineStore(args.baselines)
+    key = runner.baseline_key(trials, args.profile)
+    comparisons = runner.compare(trials, store.get(key), args.alpha, args.min_effect)
+    report_path = runner.write_report(trials, key, comparisons)
+
+    for c in comparisons:
+        if c.verdict == "no-baseline":
+            continue
+        icon = {"regression": "❌", "improvement": "✅"}.get(c.verdict, "  ")
+        logger.info(f"{icon} {c.metric}: {c.change_percent:+.2f}% "
+                    f"[{c.ci_low_percent:+.2f}%, {c.ci_high_percent:+.2f}%] p={c.p_value:.4f}")
+
+    regressions = [c for c in comparisons if c.verdict == "regression"]
+    if all(c.verdict == "no-baseline" for c in comparisons):
+        logger.info(f"⚠️ No baseline for {key.id}")
+    if args.save_baseline:
+        store.put(key, trials.samples)
+        store.save()
+        logger.info(f"💾 Baseline saved for {key.id}: {args.baselines}")
+
+    logger.info(f"📊 Report: {report_path}")
+    if regressions:
+        logger.error(f"❌ {len(regressions)} statistically significant regression(s)")
+        sys.exit(1)
+    logger.info("🎉 No significant regressions")
+
+
+if __name__ == "__main__":
+    main()
@@ -8,14 +8,23 @@ Classes:
     ConanRemoteManager: Conan remote configuration and management
     ConanOrchestrator: Conan build orchestration and coordination
     DependencyManager: Dependency management and resolution
+    LookupCache: TTL cache for vulnerability, license and version lookups
+    CacheWarmer: Lockfile-driven pre-download of sparetools-* revisions
+    WorkspacePool: Isolated per-worker Conan homes for concurrent builds
 """
 
 from .remote_manager import ConanRemoteManager
 from .orchestrator import ConanOrchestrator
 from .dependency_manager import DependencyManager
+from .lookup_cache import LookupCache
+from .cache_warmer import CacheWarmer
+from .cache_workspaces import WorkspacePool
 
 __all__ = [
     "ConanRemoteManager",
     "ConanOrchestrator",
     "DependencyManager",
+    "LookupCache",
+    "CacheWarmer",
+    "WorkspacePool",
 ]
\ No newline at end of file
@@ -0,0 +1,214 @@
+#!/usr/bin/env python3
+"""
+Conan cache warmer driven by consumer lockfiles
+
+Reads Conan 2 lockfiles (conan.lock), picks the sparetools-* recipe
+revisions they pin and downloads exactly those revisions, plus their
+binaries, into one or more Conan caches before jobs start. The binaries
+can be narrowed with a package query. What a cache already holds is
+listed first and skipped. The rest goes through a single
+`conan download --list` with core.download:parallel, because concurrent
+conan processes must not share a cache. Further caches, such as per-runner
+homes or the shared cache behind _Build/setup-zero-copy-links.sh, are
+filled from the first with `conan cache save`/`conan cache restore` and
+never touch the network.
+
+watch() turns the warmer into a small daemon that re-warms
+whenever a lockfile changes.
+"""
+
+import fnmatch
+import json
+import logging
+import os
+import subprocess
+import tempfile
+import time
+from dataclasses import dataclass, field
+from pathlib import Path
+from typing import Any, Dict, List, Optional, Tuple
+
+logger = logging.getLogger(__name__)
+
+LOCAL_CACHE = "Local Cache"
+LOCKFILE_SECTIONS = ("requires", "build_requires", "python_requires")
+ZERO_COPY_SCRIPT = Path("_Build") / "setup-zero-copy-links.sh"
+
+
+@dataclass
+class WarmResult:
+    """What one warm pass fetched into each cache"""
+    refs: List[str]
+    packages: Dict[str, int] = field(default_factory=dict)
+    recipes: Dict[str, int] = field(default_factory=dict)
+    seconds: float = 0.0
+    errors: List[str] = field(default_factory=list)
+
+
+def find_lockfiles(paths: List[Path]) -> List[Path]:
+    """Lockfiles given directly, or every conan.lock / *.lock below a directory"""
+    found = []
+    for path in paths:
+        if path.is_dir():
+            found += sorted(p for p in path.rglob("*.lock") if p.is_file())
+        elif path.is_file():
+            found.append(path)
+    return found
+
+
+def lockfile_refs(lockfiles: List[Path], pattern: str = "sparetools-*") -> List[str]:
+    """Unique "name/version[@user/channel]#rrev" pinned by the lockfiles whose name matches pattern"""
+    refs = set()
+    for lockfile in lockfiles:
+        data = json.loads(lockfile.read_text())
+        for section in LOCKFILE_SECTIONS:
+            for entry in data.get(section, []):
+                ref = entry.split("%", 1)[0]  # "%<timestamp>" suffix
+                if "#" in ref and fnmatch.fnmatchcase(ref.split("/", 1)[0], pattern):
+                    refs.add(ref)
+    return sorted(refs)
+
+
+def _revisions(package_list: Dict[str, Any]) -> Dict[str, Dict[str, Any]]:
+    """{"name/version": {"revisions": ...}} without the per-pattern "error" entries conan list emits"""
+    return {ref: entry for ref, entry in package_list.items() if isinstance(entry, dict) and "revisions" in entry}
+
+
+def subtract(wanted: Dict[str, Any], present: Dict[str, Any]) -> Dict[str, Any]:
+    """The part of a package list (recipe and package revisions) missing from another"""
+    missing: Dict[str, Any] = {}
+    for ref, entry in _revisions(wanted).items():
+        for rrev, recipe in entry["revisions"].items():
+            have = _revisions(present).get(ref, {}).get("revisions", {}).get(rrev)
+            if have is None:
+                missing.setdefault(ref, {"revisions": {}})["revisions"][rrev] = recipe
+                continue
+            packages = {}
+            for package_id, package in recipe.get("packages", {}).items():
+                have_package = have.get("packages", {}).get(package_id)
+                prevs = package.get("revisions", {})
+                have_prevs = (have_package or {}).get("revisions", {})
+                if have_package is None or any(prev not in have_prevs for prev in prevs):
+                    packages[package_id] = package
+            if packages:
+                missing.setdefault(ref, {"revisions": {}})["revisions"][rrev] = dict(recipe, packages=packages)
+    return missing
+
+
+def count(package_list: Dict[str, Any]) -> Tuple[int, int]:
+    """(recipe revisions, packages) in a package list"""
+    recipes = packages = 0
+    for entry in _revisions(package_list).values():
+        for recipe in entry["revisions"].values():
+            recipes += 1
+            packages += len(recipe.get("packages", {}))
+    return recipes, packages
+
+
+class CacheWarmer:
+    """Pre-download lockfile-pinned sparetools-* revisions into Conan caches"""
+
+    def __init__(self, remote: str, caches: Optional[List[Path]] = None, pattern: str = "sparetools-*",
+                 package_query: Optional[str] = None, parallel: int = 8, conan: str = "conan"):
+        self.remote = remote
+        # None is the default cache of the environment (CONAN_HOME or ~/.conan2)
+        self.caches: List[Optional[Path]] = [c.expanduser().resolve() for c in caches] if caches else [None]
+        self.pattern = pattern
+        self.package_query = package_query
+        self.parallel = parallel
+        self.conan = conan
+
+    def _run(self, args: List[str], cache: Optional[Path] = None) -> subprocess.CompletedProcess:
+        env = dict(os.environ)
+        if cache is not None:
+            env["CONAN_HOME"] = str(cache)
+        return subprocess.run([self.conan] + args, capture_output=True, text=True, env=env)
+
+    def list_packages(self, refs: List[str], remote: Optional[str] = None,
+                      cache: Optional[Path] = None) -> Dict[str, Any]:
+        """Merged `conan list <ref>:*#latest` of refs, in a remote or a cache"""
+        merged: Dict[str, Any] = {}
+        for ref in refs:
+            args = ["list", f"{ref}:*#latest", "--format=json"]
+            if self.package_query:
+                args += ["-p", self.package_query]
+            if remote:
+                args += ["-r", remote]
+            result = self._run(args, cache)
+            if result.returncode != 0:
+                logger.debug(f"conan list {ref} failed: {result.stderr.strip()}")
+                continue
+            origin = json.loads(result.stdout).get(remote or LOCAL_CACHE, {})
+            for name, entry in _revisions(origin).items():
+                merged.setdefault(name, {"revisions": {}})["revisions"].update(entry["revisions"])
+        return merged
+
+    def _write_list(self, directory: str, origin: str, package_list: Dict[str, Any]) -> str:
+        path = os.path.join(directory, f"{origin.replace(' ', '-')}.json")
+        with open(path, "w") as f:
+            json.dump({origin: package_list}, f)
+        return path
+
+    def warm(self, lockfiles: List[Path]) -> WarmResult:
+        """One pass: fill the first cache from the remote, the others from the first"""
+        start = time.monotonic()
+        refs = lockfile_refs(lockfiles, self.pattern)
+        result = WarmResult(refs)
+        if not refs:
+            return result
+        primary = self.caches[0]
+        # Remote listings and downloads use the first cache's remote configuration
+        wanted = self.list_packages(refs, remote=self.remote, cache=primary)
+        for ref in refs:
+            name, rrev = ref.split("#", 1)
+            if rrev not in wanted.get(name, {}).get("revisions", {}):
+                result.errors.append(f"{ref} not found in {self.remote}")
+
+        with tempfile.TemporaryDirectory(prefix="cache-warm-") as tmp:
+            for index, cache in enumerate(self.caches):
+                label = str(cache or "default")
+                todo = subtract(wanted, self.list_packages(refs, cache=cache))
+                result.recipes[label], result.packages[label] = count(todo)
+                if not todo:
+                    logger.info(f"✅ {label}: already warm")
+                    continue
+                if index == 0:
+                    logger.info(f"📥 {label}: downloading {result.packages[label]} package(s) "
+                                f"({self.parallel} parallel transfers)")
+                    run = self._run(["download", "--list", self._write_list(tmp, self.remote, todo),
+                                     "-r", self.remote, "-c", f"core.download:parallel={self.parallel}"], cache)
+                else:
+                    archive = os.path.join(tmp, f"warm-{index}.tgz")
+                    logger.info(f"📦 {label}: restoring {result.packages[label]} package(s) from {primary or 'default'}")
+                    run = self._run(["cache", "save", "--list", self._write_list(tmp, LOCAL_CACHE, todo),
+                                     "--file", archive], primary)
+                    if run.returncode == 0:
+                        run = self._run(["cache", "restore", archive], cache)
+                if run.returncode != 0:
+                    result.errors.append(f"{label}: {run.stderr.strip().splitlines()[-1:] or run.returncode}")
+        result.seconds = time.monotonic() - start
+        return result
+
+    def link_zero_copy(self, script: Path = ZERO_COPY_SCRIPT) -> int:
+        """Re-run the zero-copy link setup against the first cache"""
+        env = dict(os.environ)
+        if self.caches[0] is not None:
+            env["CONAN_USER_HOME"] = str(self.caches[0])
+        return subprocess.run(["bash", str(script)], env=env).returncode
+
+    def watch(self, lockfile_paths: List[Path], interval: float, passes: Optional[int] = None,
+              on_pass=None) -> None:
+        """Re-warm whenever the set of lockfiles or one of their mtimes changes"""
+        seen: Optional[Dict[Path, float]] = None
+        done = 0
+        while passes is None or done < passes:
+            lockfiles = find_lockfiles(lockfile_paths)
+            stamps = {p: p.stat().st_mtime for p in lockfiles}
+            if stamps != seen:
+                warm_result = self.warm(lockfiles)
+                if on_pass:
+                    on_pass(warm_result)
+                seen = stamps
+                done += 1
+            if passes is None or done < passes:
+                time.sleep(interval)
@@ -0,0 +1,137 @@
+#!/usr/bin/env python3
+"""
+Isolated Conan homes for concurrent profile builds
+
+Concurrent `conan create` runs against one Conan home contend for its
+cache locks and race on the package database. WorkspacePool hands every
+worker its own home below <root>/worker-<n>:
+
+- the home is a copy-on-write clone (`cp --reflink`) of the base home
+  (CONAN_HOME or ~/.conan2), so recipes and binaries already in the
+  base cache are visible without copying their bytes. On filesystems
+  without reflinks only the configuration (global.conf, remotes,
+  profiles, settings, extensions) is copied and the worker starts with
+  an empty package cache.
+- all workers share one download cache (core.download:download_cache),
+  the layer Conan itself locks for concurrent processes, so a source
+  tarball or remote binary is fetched once per builder.
+- test_package build folders get the worker name as a build folder var,
+  so workers building from the same checkout do not overwrite each
+  other's test builds.
+
+merge() copies a worker's created package back into the base home with
+`conan cache save`/`conan cache restore`, one merge at a time.
+"""
+
+import logging
+import os
+import shutil
+import subprocess
+import tempfile
+import threading
+from dataclasses import dataclass
+from pathlib import Path
+from typing import Dict, List, Optional
+
+logger = logging.getLogger(__name__)
+
+CONFIG_ENTRIES = ("global.conf", "remotes.json", "settings.yml", "settings_user.yml", "profiles", "extensions")
+WORKSPACE_CONF_MARKER = "# conan workspace overrides"
+
+
+def default_conan_home() -> Path:
+    return Path(os.environ.get("CONAN_HOME") or Path.home() / ".conan2")
+
+
+def reflink_supported(directory: Path) -> bool:
+    """Whether `cp --reflink=always` works between files in directory"""
+    directory.mkdir(parents=True, exist_ok=True)
+    with tempfile.TemporaryDirectory(dir=directory) as tmp:
+        source = Path(tmp) / "probe"
+        source.write_bytes(b"reflink")
+        result = subprocess.run(["cp", "--reflink=always", str(source), str(Path(tmp) / "clone")],
+                                capture_output=True)
+        return result.returncode == 0
+
+
+@dataclass
+class ConanWorkspace:
+    """One worker's Conan home"""
+    name: str
+    home: Path
+
+    def env(self) -> Dict[str, str]:
+        env = dict(os.environ)
+        env["CONAN_HOME"] = str(self.home)
+        return env
+
+
+class WorkspacePool:
+    """Per-worker Conan homes over a shared download cache, plus merge-back"""
+
+    def __init__(self, root: Path, workers: int, base_home: Optional[Path] = None,
+                 download_cache: Optional[Path] = None, conan: str = "conan"):
+        self.root = root
+        self.workers = workers
+        self.base_home = base_home or default_conan_home()
+        self.download_cache = download_cache or root / "download-cache"
+        self.conan = conan
+        self._merge_lock = threading.Lock()
+        self.workspaces: List[ConanWorkspace] = []
+
+    def prepare(self) -> List[ConanWorkspace]:
+        """Create or refresh the worker homes"""
+        self.root.mkdir(parents=True, exist_ok=True)
+        self.download_cache.mkdir(parents=True, exist_ok=True)
+        clone = self.base_home.is_dir() and reflink_supported(self.root)
+        self.workspaces = []
+        for index in range(self.workers):
+            workspace = ConanWorkspace(f"worker-{index}", self.root / f"worker-{index}")
+            if clone and not workspace.home.exists():
+                # Copy-on-write: the clone shares extents with the base cache until either side writes
+                subprocess.run(["cp", "-a", "--reflink=always", str(self.base_home), str(workspace.home)], check=True)
+            self._sync_config(workspace)
+            self.workspaces.append(workspace)
+        logger.info(f"🗂️ {self.workers} Conan workspace(s) in {self.root} "
+                    f"({'reflink clones' if clone else 'configuration only'}, "
+                    f"shared download cache {self.download_cache})")
+        return self.workspaces
+
+    def _sync_config(self, workspace: ConanWorkspace) -> None:
+        workspace.home.mkdir(parents=True, exist_ok=True)
+        for entry in CONFIG_ENTRIES:
+            source = self.base_home / entry
+            target = workspace.home / entry
+            if source.is_dir():
+                shutil.copytree(source, target, dirs_exist_ok=True)
+            elif source.is_file():
+                shutil.copy2(source, target)
+        global_conf = workspace.home / "global.conf"
+        lines = global_conf.read_text().splitlines() if global_conf.is_file() else []
+        if WORKSPACE_CONF_MARKER in lines:
+            lines = lines[:lines.index(WORKSPACE_CONF_MARKER)]
+        lines += [
+            WORKSPACE_CONF_MARKER,
+            f"core.download:download_cache={self.download_cache.resolve()}",
+            f"tools.cmake.cmake_layout:build_folder_vars=['const.{workspace.name}', 'settings.build_type']",
+        ]
+        global_conf.write_text("\n".join(lines) + "\n")
+
+    def merge(self, workspace: ConanWorkspace, package: Dict[str, str]) -> bool:
+        """Copy one created package revision from a worker home into the base home"""
+        pattern = f"{package['ref']}:{package['package_id']}#{package['prev']}"
+        with self._merge_lock, tempfile.TemporaryDirectory(prefix="workspace-merge-") as tmp:
+            archive = os.path.join(tmp, f"{workspace.name}.tgz")
+            saved = subprocess.run([self.conan, "cache", "save", pattern, "--file", archive],
+                                   capture_output=True, text=True, env=workspace.env())
+            if saved.returncode != 0:
+                logger.error(f"❌ {workspace.name}: conan cache save {pattern} failed: {saved.stderr.strip()}")
+                return False
+            env = dict(os.environ, CONAN_HOME=str(self.base_home))
+            restored = subprocess.run([self.conan, "cache", "restore", archive],
+                                      capture_output=True, text=True, env=env)
+            if restored.returncode != 0:
+                logger.error(f"❌ {workspace.name}: conan cache restore failed: {restored.stderr.strip()}")
+                return False
+        logger.info(f"🔀 Merged {pattern} from {workspace.name} into {self.base_home}")
+        return True
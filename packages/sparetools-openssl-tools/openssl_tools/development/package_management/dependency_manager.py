@@ -16,15 +16,29 @@ from typing import Dict, List, Optional, Tuple
 from datetime import datetime, timedelta
 import hashlib
 import re
+import threading
+import time
+from concurrent.futures import ThreadPoolExecutor
+
+from .lookup_cache import LookupCache
 
 # Configure logging
 logging.basicConfig(level=logging.INFO, format='%(asctime)s - %(levelname)s - %(message)s')
 logger = logging.getLogger(__name__)
 
+OSV_API = "https://api.osv.dev/v1"
+OSV_ECOSYSTEM = "ConanCenter"
+# querybatch takes at most 1000 queries per request
+OSV_BATCH_SIZE = 1000
+# The ecosystem export's ETag changes whenever an advisory does
+OSV_REVISION_URL = "https://osv-vulnerabilities.storage.googleapis.com/{ecosystem}/all.zip"
+LOOKUP_WORKERS = 16
+
+
 class DependencyManager:
     """Advanced dependency management with automated updates and vulnerability scanning"""
     
-    def __init__(self, project_root: Path):
+    def __init__(self, project_root: Path, max_workers: int = LOOKUP_WORKERS, use_cache: bool = True):
         self.project_root = project_root
         self.conanfile_path = project_root / "conanfile.py"
         self.dependency_config_path = project_root / "conan-dev" / "dependency-config.yml"
@@ -33,6 +47,12 @@ class DependencyManager:
         
         # Create directories
         self.dependency_config_path.parent.mkdir(parents=True, exist_ok=True)
+
+        # Lookups run on max_workers threads and are cached with a TTL
+        self.max_workers = max_workers
+        self.lookup_cache = LookupCache(project_root / "conan-dev" / "lookup-cache.json", enabled=use_cache)
+        self._session: Optional[requests.Session] = None
+        self._session_lock = threading.Lock()
         
     def setup_dependency_config(self):
         """Set up dependency configuration based on oms-dev patterns"""
@@ -120,10 +140,10 @@ class DependencyManager:
             # Get current dependencies from conanfile.py
             dependencies = self._extract_dependencies()
             vulnerabilities["packages_scanned"] = len(dependencies)
+            start = time.monotonic()
             
-            for dep_name, dep_version in dependencies.items():
-                # Check against known vulnerability databases
-                vulns = self._check_package_vulnerabilities(dep_name, dep_version)
+            # One querybatch for every package, then each advisory once
+            for dep_name, vulns in self._lookup_vulnerabilities(dependencies).items():
                 vulnerabilities["vulnerabilities_found"].extend(vulns)
                 
                 # Update severity summary
@@ -132,6 +152,10 @@ class DependencyManager:
                     if severity in vulnerabilities["severity_summary"]:
                         vulnerabilities["severity_summary"][severity] += 1
             
+            vulnerabilities["lookup_seconds"] = round(time.monotonic() - start, 3)
+            logger.info(f"🔎 Lookups: {self.lookup_cache.hits} cached, {self.lookup_cache.misses} queried "
+                        f"in {vulnerabilities['lookup_seconds']}s")
+            
             # Save vulnerability report
             self._save_vulnerability_report(vulnerabilities)
             
@@ -144,6 +168,8 @@ class DependencyManager:
         except Exception as e:
             logger.error(f"❌ Vulnerability scan failed: {e}")
             return vulnerabilities
+        finally:
+            self.lookup_cache.save()
     
     def check_for_updates(self) -> Dict:
         """Check for available dependency updates"""
@@ -163,9 +189,10 @@ class DependencyManager:
         try:
             dependencies = self._extract_dependencies()
             updates["packages_checked"] = len(dependencies)
+            latest_versions = dict(zip(dependencies, self._map(self._get_latest_version, list(dependencies))))
             
             for dep_name, current_version in dependencies.items():
-                latest_version = self._get_latest_version(dep_name)
+                latest_version = latest_versions[dep_name]
                 if latest_version and latest_version != current_version:
                     update_type = self._determine_update_type(current_version, latest_version)
                     
@@ -190,6 +217,8 @@ class DependencyManager:
         except Exception as e:
             logger.error(f"❌ Update check failed: {e}")
             return updates
+        finally:
+            self.lookup_cache.save()
     
     def auto_update_dependencies(self, update_types: List[str] = ["patch"]) -> bool:
         """Automatically update dependencies based on configuration"""
@@ -279,9 +308,10 @@ class DependencyManager:
             
             dependencies = self._extract_dependencies()
             license_report["packages_validated"] = len(dependencies)
+            licenses = self._get_package_licenses(dependencies)
             
             for dep_name, dep_version in dependencies.items():
-                license_info = self._get_package_license(dep_name, dep_version)
+                license_info = licenses[dep_name]
                 
                 if license_info["license"] in allowed_licenses:
                     license_report["license_summary"]["approved"].append({
@@ -318,6 +348,8 @@ class DependencyManager:
         except Exception as e:
             logger.error(f"❌ License validation failed: {e}")
             return license_report
+        finally:
+            self.lookup_cache.save()
     
     def _extract_dependencies(self) -> Dict[str, str]:
         """Extract dependencies from conanfile.py"""
@@ -354,40 +386,117 @@ class DependencyManager:
         
         return dependencies
     
+    def _map(self, function, items: List) -> List:
+        """function over items on the lookup threads, results in order"""
+        if len(items) <= 1:
+            return [function(item) for item in items]
+        with ThreadPoolExecutor(max_workers=min(self.max_workers, len(items))) as pool:
+            return list(pool.map(function, items))
+
+    def _http(self) -> requests.Session:
+        """One keep-alive session shared by the lookup threads"""
+        with self._session_lock:
+            if self._session is None:
+                self._session = requests.Session()
+                adapter = requests.adapters.HTTPAdapter(pool_connections=4, pool_maxsize=self.max_workers)
+                self._session.mount("https://", adapter)
+            return self._session
+
+    def _advisory_revision(self) -> str:
+        """Revision of the OSV advisory data for the ecosystem ("" if unknown)"""
+        revision = self.lookup_cache.get("osv-revision", OSV_ECOSYSTEM)
+        if revision is not None:
+            return revision
+        try:
+            response = self._http().head(OSV_REVISION_URL.format(ecosystem=OSV_ECOSYSTEM), timeout=10)
+            revision = response.headers.get("ETag") or response.headers.get("Last-Modified") or ""
+        except requests.RequestException as e:
+            logger.debug(f"Cannot read the OSV revision: {e}")
+            return ""
+        self.lookup_cache.put("osv-revision", OSV_ECOSYSTEM, revision.strip('"'))
+        return revision.strip('"')
+
+    def _query_osv_batch(self, dependencies: Dict[str, str]) -> Dict[str, List[List[str]]]:
+        """
+        [id, modified] of the advisories for each package, from the cache or
+        /v1/querybatch (OSV_BATCH_SIZE packages per request, pages followed).
+        Packages whose query failed are missing from the result.
+        """
+        revision = self._advisory_revision()
+        found: Dict[str, List[List[str]]] = {}
+        queries = []
+        for name, version in dependencies.items():
+            cached = self.lookup_cache.get("osv", f"{name}@{version}", revision)
+            if cached is not None:
+                found[name] = cached
+            else:
+                queries.append((name, version, None))
+                found[name] = []
+
+        while queries:
+            batch, queries = queries[:OSV_BATCH_SIZE], queries[OSV_BATCH_SIZE:]
+            payload = {"queries": [dict({"package": {"name": name, "ecosystem": OSV_ECOSYSTEM}, "version": version},
+                                        **({"page_token": token} if token else {}))
+                                   for name, version, token in batch]}
+            try:
+                response = self._http().post(f"{OSV_API}/querybatch", json=payload, timeout=30)
+                response.raise_for_status()
+                results = response.json().get("results", [])
+            except (requests.RequestException, ValueError) as e:
+                logger.warning(f"OSV querybatch failed for {len(batch)} packages: {e}")
+                for name, _, _ in batch:
+                    found.pop(name, None)
+                continue
+            for (name, version, _), result in zip(batch, results):
+                found[name].extend([v.get("id"), v.get("modified", "")] for v in result.get("vulns", []))
+                if result.get("next_page_token"):
+                    queries.append((name, version, result["next_page_token"]))
+                else:
+                    self.lookup_cache.put("osv", f"{name}@{version}", found[name], revision)
+        return found
+
+    def _get_vulnerability(self, vuln_ref: Tuple[str, str]) -> Optional[Dict]:
+        """Advisory details (cached by id and modification time)"""
+        vuln_id, modified = vuln_ref
+        subject = f"{vuln_id}@{modified}"
+        vuln = self.lookup_cache.get("osv-vuln", subject)
+        if vuln is None:
+            try:
+                response = self._http().get(f"{OSV_API}/vulns/{vuln_id}", timeout=10)
+                response.raise_for_status()
+                vuln = response.json()
+            except (requests.RequestException, ValueError) as e:
+                logger.debug(f"Failed to fetch vulnerability {vuln_id}: {e}")
+                return None
+            self.lookup_cache.put("osv-vuln", subject, vuln)
+        return {
+            "id": vuln.get("id", vuln_id),
+            "summary": vuln.get("summary"),
+            "severity": self._extract_severity(vuln),
+            "references": vuln.get("references", []),
+            "database": "OSV"
+        }
+
+    def _lookup_vulnerabilities(self, dependencies: Dict[str, str]) -> Dict[str, List[Dict]]:
+        """Vulnerabilities per package: one batch query, then each advisory fetched once, concurrently"""
+        ids = self._query_osv_batch(dependencies)
+        unique = sorted({(vuln_id, modified) for refs in ids.values() for vuln_id, modified in refs})
+        details = dict(zip(unique, self._map(self._get_vulnerability, unique)))
+        result = {}
+        for name, refs in ids.items():
+            result[name] = [dict(details[(vuln_id, modified)], package=name, version=dependencies[name])
+                            for vuln_id, modified in refs if details.get((vuln_id, modified))]
+        return result
+
     def _check_package_vulnerabilities(self, package_name: str, version: str) -> List[Dict]:
         """Check package against vulnerability databases"""
-        vulnerabilities = []
-        
-        try:
-            # Check against OSV (Open Source Vulnerabilities)
-            osv_url = f"https://api.osv.dev/v1/query"
-            payload = {
-                "package": {
-                    "name": package_name,
-                    "ecosystem": "conan"
-                },
-                "version": version
-            }
-            
-            response = requests.post(osv_url, json=payload, timeout=10)
-            if response.status_code == 200:
-                data = response.json()
-                for vuln in data.get("vulns", []):
-                    vulnerabilities.append({
-                        "id": vuln.get("id"),
-                        "summary": vuln.get("summary"),
-                        "severity": self._extract_severity(vuln),
-                        "references": vuln.get("references", []),
-                        "database": "OSV"
-                    })
-            
-        except Exception as e:
-            logger.debug(f"Failed to check vulnerabilities for {package_name}: {e}")
-        
-        return vulnerabilities
+        return self._lookup_vulnerabilities({package_name: version}).get(package_name, [])
     
     def _get_latest_version(self, package_name: str) -> Optional[str]:
         """Get latest version of a package"""
+        cached = self.lookup_cache.get("latest", f"{package_name}@conancenter")
+        if cached is not None:
+            return cached or None
         try:
             # Use Conan search to find latest version
             result = subprocess.run(
@@ -401,7 +510,10 @@ class DependencyManager:
                     if package_name in line and '/' in line:
                         version = line.split('/')[1].strip()
                         if version and version != "latest":
+                            self.lookup_cache.put("latest", f"{package_name}@conancenter", version)
                             return version
+                # Answered, but nothing newer to offer
+                self.lookup_cache.put("latest", f"{package_name}@conancenter", "")
             
         except Exception as e:
             logger.debug(f"Failed to get latest version for {package_name}: {e}")
@@ -531,7 +643,11 @@ class DependencyManager:
         if "severity" in vuln:
             for sev in vuln["severity"]:
                 if sev.get("type") == "CVSS_V3":
-                    score = sev.get("score", 0)
+                    try:
+                        score = float(sev.get("score", 0))
+                    except (TypeError, ValueError):
+                        # OSV gives the CVSS vector, not the score
+                        break
                     if score >= 9.0:
                         severity = "critical"
                     elif score >= 7.0:
@@ -542,6 +658,13 @@ class DependencyManager:
                         severity = "low"
                     break
         
+        if severity == "unknown":
+            # GHSA and others rate the advisory themselves
+            rating = str(vuln.get("database_specific", {}).get("severity", "")).lower()
+            severity = {"moderate": "medium"}.get(rating, rating) or "unknown"
+            if severity not in ("critical", "high", "medium", "low"):
+                severity = "unknown"
+        
         return severity
     
     def _get_changelog_url(self, package_name: str, version: str) -> str:
@@ -554,14 +677,58 @@ class DependencyManager:
         # This would check against security advisories
         return False  # Simplified for now
     
+    @staticmethod
+    def _graph_licenses(refs: List[str]) -> Dict[str, str]:
+        """name@version -> license from one `conan graph info` over refs ({} if it fails)"""
+        command = ["conan", "graph", "info"] + [f"--requires={ref}" for ref in refs] + \
+                  ["--remote", "conancenter", "--format=json"]
+        try:
+            result = subprocess.run(command, capture_output=True, text=True, timeout=300)
+            nodes = json.loads(result.stdout)["graph"]["nodes"].values() if result.returncode == 0 else []
+        except (OSError, subprocess.TimeoutExpired, ValueError, KeyError) as e:
+            logger.debug(f"conan graph info failed for {len(refs)} packages: {e}")
+            return {}
+        licenses = {}
+        for node in nodes:
+            license_value = node.get("license")
+            if isinstance(license_value, (list, tuple)):
+                license_value = ", ".join(license_value)
+            if node.get("name") and node.get("version") and license_value:
+                licenses[f"{node['name']}@{node['version']}"] = license_value
+        return licenses
+
+    def _get_package_licenses(self, dependencies: Dict[str, str]) -> Dict[str, Dict]:
+        """
+        License information per package: cached, else one graph for all the
+        uncached packages, else (a version conflict fails the shared graph)
+        one graph per package, concurrently
+        """
+        licenses = {}
+        missing = []
+        for name, version in dependencies.items():
+            cached = self.lookup_cache.get("license", f"{name}@{version}")
+            if cached is not None:
+                licenses[f"{name}@{version}"] = cached
+            else:
+                missing.append(f"{name}/{version}")
+        if missing:
+            found = self._graph_licenses(missing)
+            retry = [ref for ref in missing if ref.replace("/", "@", 1) not in found]
+            if len(retry) > 1 or (retry and len(missing) > 1):
+                for result in self._map(lambda ref: self._graph_licenses([ref]), retry):
+                    found.update(result)
+            for ref in missing:
+                subject = ref.replace("/", "@", 1)
+                if subject in found:
+                    self.lookup_cache.put("license", subject, found[subject])
+                    licenses[subject] = found[subject]
+        return {name: {"package": name, "version": version,
+                       "license": licenses.get(f"{name}@{version}", "Unknown")}
+                for name, version in dependencies.items()}
+
     def _get_package_license(self, package_name: str, version: str) -> Dict:
         """Get license information for a package"""
-        # This would query package metadata
-        return {
-            "package": package_name,
-            "version": version,
-            "license": "Unknown"  # Would be populated from actual metadata
-        }
+        return self._get_package_licenses({package_name: version})[package_name]
     
     def _generate_vulnerability_alerts(self, vulnerabilities: Dict):
         """Generate alerts for high-severity vulnerabilities"""
@@ -583,10 +750,14 @@ def main():
     parser.add_argument("--update-types", nargs="+", default=["patch"],
                        choices=["patch", "minor", "major"],
                        help="Types of updates to apply (for auto-update)")
+    parser.add_argument("--workers", type=int, default=LOOKUP_WORKERS,
+                       help="Concurrent lookups")
+    parser.add_argument("--no-cache", action="store_true",
+                       help="Ignore conan-dev/lookup-cache.json and query everything")
     
     args = parser.parse_args()
     
-    dm = DependencyManager(args.project_root)
+    dm = DependencyManager(args.project_root, max_workers=args.workers, use_cache=not args.no_cache)
     
     if args.action == "setup":
         dm.setup_dependency_config()
@@ -0,0 +1,100 @@
+#!/usr/bin/env python3
+"""
+TTL cache for dependency metadata lookups
+
+Vulnerability, license and latest-version lookups are network round
+trips whose answers change slowly. LookupCache keeps them in one JSON
+file per project (conan-dev/lookup-cache.json), keyed by kind and
+subject, e.g. ("osv", "zlib@1.3.1", <advisory DB revision>). A key that
+includes the advisory database revision goes stale as soon as the
+database changes, whatever its TTL. Entries are read and written from
+worker threads. save() writes the file once, atomically, after a scan.
+"""
+
+import json
+import logging
+import os
+import threading
+import time
+from pathlib import Path
+from typing import Any, Dict, Optional
+
+logger = logging.getLogger(__name__)
+
+CACHE_VERSION = 1
+
+# Seconds an answer stays fresh, per kind
+DEFAULT_TTLS = {
+    "osv": 6 * 3600,            # package@version -> vulnerability ids
+    "osv-vuln": 7 * 86400,      # vulnerability id@modified -> details (immutable)
+    "osv-revision": 900,        # advisory database revision
+    "license": 30 * 86400,      # package@version -> license (fixed per version)
+    "latest": 6 * 3600,         # package@remote -> latest version
+}
+
+_MISSING = object()
+
+
+class LookupCache:
+    """Thread-safe TTL cache persisted as JSON"""
+
+    def __init__(self, path: Optional[Path], ttls: Optional[Dict[str, float]] = None, enabled: bool = True):
+        self.path = Path(path) if path else None
+        self.ttls = {**DEFAULT_TTLS, **(ttls or {})}
+        self.enabled = enabled
+        self.hits = 0
+        self.misses = 0
+        self._lock = threading.Lock()
+        self._entries: Dict[str, Dict[str, Any]] = {}
+        self._dirty = False
+        if self.path is not None and enabled:
+            try:
+                with open(self.path) as f:
+                    data = json.load(f)
+                if data.get("version") == CACHE_VERSION:
+                    self._entries = data.get("entries", {})
+            except (OSError, ValueError):
+                pass
+
+    @staticmethod
+    def key(kind: str, subject: str, revision: str = "") -> str:
+        return f"{kind}|{subject}|{revision}"
+
+    def get(self, kind: str, subject: str, revision: str = "", default: Any = None) -> Any:
+        """The cached value, or default when missing or older than the kind's TTL"""
+        if not self.enabled:
+            return default
+        with self._lock:
+            entry = self._entries.get(self.key(kind, subject, revision))
+            if entry is None or time.time() - entry["time"] > self.ttls.get(kind, 0):
+                self.misses += 1
+                return default
+            self.hits += 1
+            return entry["value"]
+
+    def has(self, kind: str, subject: str, revision: str = "") -> bool:
+        return self.get(kind, subject, revision, _MISSING) is not _MISSING
+
+    def put(self, kind: str, subject: str, value: Any, revision: str = ""):
+        if not self.enabled:
+            return
+        with self._lock:
+            self._entries[self.key(kind, subject, revision)] = {"time": time.time(), "value": value}
+            self._dirty = True
+
+    def save(self):
+        """Write the cache (dropping expired entries) if anything changed"""
+        if self.path is None or not self.enabled:
+            return
+        with self._lock:
+            if not self._dirty:
+                return
+            now = time.time()
+            self._entries = {k: e for k, e in self._entries.items()
+                             if now - e["time"] <= self.ttls.get(k.split("|", 1)[0], 0)}
+            self.path.parent.mkdir(parents=True, exist_ok=True)
+            temporary = self.path.with_name(f"{self.path.name}.{os.getpid()}.tmp")
+            with open(temporary, "w") as f:
+                json.dump({"version": CACHE_VERSION, "entries": self._entries}, f)
+            os.replace(temporary, self.path)
+            self._dirty = False
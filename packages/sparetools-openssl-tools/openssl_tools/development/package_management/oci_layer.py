@@ -0,0 +1,317 @@
+#!/usr/bin/env python3
+"""
+Runtime OCI layers from sparetools-openssl packages
+
+Writes the runtime part of a package folder - libcrypto/libssl shared
+libraries, provider and engine modules, the trust store and one selected
+openssl.cnf - into an OCI image layout (oci-layout, index.json,
+blobs/sha256) that skopeo, crane or oras push as is. Headers, static
+libraries, the CLI, debug symbols and res/ stay out.
+
+The files go into separate layers, most widely shared first: trust store,
+configuration, shared libraries, modules. Layers are reproducible: entries
+sorted, mtime SOURCE_DATE_EPOCH (default 0), owner root, modes normalized,
+gzip without name or timestamp. So a layer whose files are identical in
+two variants (the trust store of every variant, the libraries of two
+builds that differ only in their modules) has the same digest, is stored
+once in the layout and is pulled once per node. Several packages written
+into one layout share its blobs; index.json names one manifest per tag.
+
+The package's artifact manifest (res/sparetools-artifacts.json) lists the
+files when present; older packages are walked.
+"""
+
+import argparse
+import gzip
+import hashlib
+import io
+import json
+import os
+import stat
+import subprocess
+import sys
+import tarfile
+import time
+from pathlib import Path
+from typing import Dict, List, Optional, Tuple
+
+try:
+    from openssl_tools.artifact_manifest import load_manifest
+except ImportError:  # Run as a script without openssl_tools installed
+    def load_manifest(folder):
+        return None
+
+DEFAULT_PREFIX = "/opt/sparetools-openssl"
+LAYER_MEDIA_TYPE = "application/vnd.oci.image.layer.v1.tar"
+CONFIG_MEDIA_TYPE = "application/vnd.oci.image.config.v1+json"
+MANIFEST_MEDIA_TYPE = "application/vnd.oci.image.manifest.v1+json"
+OCI_ARCH = {"x86_64": "amd64", "armv8": "arm64", "x86": "386", "armv7": "arm", "armv7hf": "arm"}
+
+# Layers in image order, most widely shared first
+LAYERS = ("trust", "config", "libraries", "modules")
+
+
+def _layer_of(rel: str, kind: Optional[str]) -> Optional[str]:
+    """Runtime layer of a packaged file, None for build-time files"""
+    name = rel.rsplit("/", 1)[-1]
+    if kind == "module" or "/ossl-modules/" in f"/{rel}" or "/engines-" in f"/{rel}" \
+            or rel == "ssl/fipsmodule.cnf":
+        return "modules"  # fipsmodule.cnf holds the FIPS module's own MAC
+    if kind == "shared_library" or (rel.startswith("lib/") and (".so" in name or name.endswith(".dylib"))):
+        return "libraries" if name.startswith(("libcrypto", "libssl")) else None
+    if rel.startswith("ssl/") and (kind == "trust" or name.endswith((".pem", ".stb", ".crt"))
+                                   or "/certs/" in f"/{rel}"):
+        return "trust"
+    return None
+
+
+def _conaninfo(folder: Path) -> Dict[str, str]:
+    """[settings] of the package's conaninfo.txt"""
+    settings, section = {}, None
+    try:
+        for line in (folder / "conaninfo.txt").read_text().splitlines():
+            line = line.strip()
+            if line.startswith("["):
+                section = line
+            elif section == "[settings]" and "=" in line:
+                key, value = line.split("=", 1)
+                settings[key] = value
+    except OSError:
+        pass
+    return settings
+
+
+class RuntimeLayerBuilder:
+    """OCI image layout holding runtime images of one or more packages"""
+
+    def __init__(self, layout: Path, prefix: str = DEFAULT_PREFIX, compression: str = "gzip"):
+        if compression not in ("gzip", "none"):
+            raise ValueError(f"Unknown compression {compression!r} (gzip or none)")
+        self.layout = Path(layout)
+        self.prefix = prefix.strip("/")
+        self.compression = compression
+        self.mtime = int(os.environ.get("SOURCE_DATE_EPOCH", 0))
+        (self.layout / "blobs" / "sha256").mkdir(parents=True, exist_ok=True)
+        (self.layout / "oci-layout").write_text('{"imageLayoutVersion": "1.0.0"}')
+        self.index_path = self.layout / "index.json"
+        if self.index_path.exists():
+            self.index = json.loads(self.index_path.read_text())
+        else:
+            self.index = {"schemaVersion": 2, "mediaType": "application/vnd.oci.image.index.v1+json",
+                          "manifests": []}
+
+    def _blob(self, data: bytes) -> Tuple[str, int, bool]:
+        """Store data by digest; (digest, size, already present)"""
+        digest = "sha256:" + hashlib.sha256(data).hexdigest()
+        path = self.layout / "blobs" / "sha256" / digest[7:]
+        existed = path.exists()
+        if not existed:
+            tmp = path.with_name(f".{path.name}.{os.getpid()}.tmp")
+            tmp.write_bytes(data)
+            os.replace(tmp, path)
+        return digest, len(data), existed
+
+    def _files(self, folder: Path) -> Dict[str, List[str]]:
+        """Package-relative runtime files per layer"""
+        manifest = load_manifest(folder)
+        if manifest is not None:
+            entries = [(e["path"], e["kind"]) for e in manifest["artifacts"]]
+        else:
+            entries = [(os.path.relpath(os.path.join(root, name), folder).replace(os.sep, "/"), None)
+                       for root, _, names in os.walk(folder) for name in names]
+        layers: Dict[str, List[str]] = {layer: [] for layer in LAYERS}
+        for rel, kind in entries:
+            layer = _layer_of(rel, kind)
+            if layer:
+                layers[layer].append(rel)
+        return layers
+
+    def _add(self, tar: tarfile.TarFile, name: str, source: Optional[Path] = None,
+             data: Optional[bytes] = None, directories: Optional[set] = None) -> None:
+        """One entry with normalized metadata, after any parent directory not yet added"""
+        parts = name.split("/")
+        for depth in range(1, len(parts)):
+            parent = "/".join(parts[:depth])
+            if parent not in directories:
+                directories.add(parent)
+                info = tarfile.TarInfo(parent)
+                info.type, info.mode = tarfile.DIRTYPE, 0o755
+                self._normalize(info)
+                tar.addfile(info)
+        info = tarfile.TarInfo(name)
+        fileobj = None
+        if data is not None:
+            info.size, info.mode, fileobj = len(data), 0o644, io.BytesIO(data)
+        elif source.is_symlink():
+            info.type, info.linkname, info.mode = tarfile.SYMTYPE, os.readlink(source), 0o777
+        else:
+            st = source.stat()
+            info.size = st.st_size
+            info.mode = 0o755 if st.st_mode & stat.S_IXUSR else 0o644
+            fileobj = open(source, "rb")
+        self._normalize(info)
+        try:
+            tar.addfile(info, fileobj)
+        finally:
+            if fileobj is not None:
+                fileobj.close()
+
+    def _normalize(self, info: tarfile.TarInfo) -> None:
+        info.mtime = self.mtime
+        info.uid = info.gid = 0
+        info.uname = info.gname = ""
+
+    def _layer(self, folder: Path, files: List[str], extra: Dict[str, bytes]) -> Tuple[Dict, str, bool]:
+        """(descriptor, diff_id, blob already present) of one layer"""
+        raw = io.BytesIO()
+        directories: set = set()
+        with tarfile.open(fileobj=raw, mode="w", format=tarfile.PAX_FORMAT) as tar:
+            entries = {f"{self.prefix}/{rel}": (folder / rel, None) for rel in files}
+            entries.update({f"{self.prefix}/{rel}": (None, data) for rel, data in extra.items()})
+            for name in sorted(entries):
+                source, data = entries[name]
+                self._add(tar, name, source=source, data=data, directories=directories)
+        uncompressed = raw.getvalue()
+        diff_id = "sha256:" + hashlib.sha256(uncompressed).hexdigest()
+        media_type = LAYER_MEDIA_TYPE
+        blob = uncompressed
+        if self.compression == "gzip":
+            compressed = io.BytesIO()
+            with gzip.GzipFile(filename="", mode="wb", fileobj=compressed, compresslevel=9, mtime=0) as gz:
+                gz.write(uncompressed)
+            blob, media_type = compressed.getvalue(), LAYER_MEDIA_TYPE + "+gzip"
+        digest, size, existed = self._blob(blob)
+        return {"mediaType": media_type, "digest": digest, "size": size}, diff_id, existed
+
+    def add_package(self, folder: Path, tag: Optional[str] = None, openssl_cnf: str = "package") -> Dict:
+        """
+        Write the runtime image of one package folder and name it tag in
+        index.json (replacing an earlier image of that tag).
+
+        openssl_cnf selects ssl/openssl.cnf: "package" (as packaged, e.g. the
+        startup_config=minimal one), "dist" (the stock openssl.cnf.dist) or
+        a path to another file. Returns a summary with the layer digests.
+        """
+        folder = Path(folder)
+        layers = self._files(folder)
+        if not layers["libraries"]:
+            raise ValueError(f"{folder}: no libcrypto/libssl shared libraries (build with shared=True)")
+        if openssl_cnf in ("package", "dist"):
+            cnf_path = folder / "ssl" / ("openssl.cnf" if openssl_cnf == "package" else "openssl.cnf.dist")
+        else:
+            cnf_path = Path(openssl_cnf)
+        cnf = {"ssl/openssl.cnf": cnf_path.read_bytes()} if cnf_path.is_file() else {}
+
+        manifest = load_manifest(folder) or {}
+        summary = {"package": str(folder), "ref": manifest.get("ref"), "package_id": manifest.get("package_id"),
+                   "layers": []}
+        descriptors, diff_ids = [], []
+        for name in LAYERS:
+            extra = cnf if name == "config" else {}
+            if not layers[name] and not extra:
+                continue
+            descriptor, diff_id, shared = self._layer(folder, layers[name], extra)
+            descriptors.append(descriptor)
+            diff_ids.append(diff_id)
+            summary["layers"].append({"name": name, "files": len(layers[name]) + len(extra),
+                                      "digest": descriptor["digest"], "size": descriptor["size"],
+                                      "reused": shared})
+
+        settings = _conaninfo(folder)
+        created = time.strftime("%Y-%m-%dT%H:%M:%SZ", time.gmtime(self.mtime))
+        root = f"/{self.prefix}"
+        modules_dir = next((os.path.dirname(rel) for rel in layers["modules"] if "/ossl-modules/" in f"/{rel}"),
+                           "lib/ossl-modules")
+        env = [f"LD_LIBRARY_PATH={root}/lib", f"OPENSSL_MODULES={root}/{modules_dir}"]
+        if cnf:
+            env.append(f"OPENSSL_CONF={root}/ssl/openssl.cnf")
+        if any(rel == "ssl/cert.pem" for rel in layers["trust"]):
+            env.append(f"SSL_CERT_FILE={root}/ssl/cert.pem")
+        config = {
+            "architecture": OCI_ARCH.get(settings.get("arch", ""), settings.get("arch", "unknown")),
+            "os": settings.get("os", "Linux").lower(),
+            "config": {"Env": env},
+            "rootfs": {"type": "layers", "diff_ids": diff_ids},
+            "history": [{"created": created, "created_by": f"sparetools oci-layer {layer['name']}"}
+                        for layer in summary["layers"]],
+        }
+        config_digest, config_size, _ = self._blob(json.dumps(config, sort_keys=True).encode())
+        image = {
+            "schemaVersion": 2,
+            "mediaType": MANIFEST_MEDIA_TYPE,
+            "config": {"mediaType": CONFIG_MEDIA_TYPE, "digest": config_digest, "size": config_size},
+            "layers": descriptors,
+        }
+        if summary["ref"]:
+            image["annotations"] = {"dev.sparetools.package": f"{summary['ref']}:{summary['package_id']}"}
+        manifest_digest, manifest_size, _ = self._blob(json.dumps(image, sort_keys=True).encode())
+
+        tag = tag or (f"{summary['ref'].split('#')[0].replace('/', '-')}-{(summary['package_id'] or '')[:12]}"
+                      if summary["ref"] else folder.name)
+        self.index["manifests"] = [m for m in self.index["manifests"]
+                                   if m.get("annotations", {}).get("org.opencontainers.image.ref.name") != tag]
+        self.index["manifests"].append({
+            "mediaType": MANIFEST_MEDIA_TYPE, "digest": manifest_digest, "size": manifest_size,
+            "platform": {"architecture": config["architecture"], "os": config["os"]},
+            "annotations": {"org.opencontainers.image.ref.name": tag},
+        })
+        tmp = self.index_path.with_name(".index.json.tmp")
+        tmp.write_text(json.dumps(self.index, indent=2, sort_keys=True))
+        os.replace(tmp, self.index_path)
+        summary.update({"tag": tag, "manifest": manifest_digest})
+        return summary
+
+
+def _package_folder(value: str) -> Path:
+    """A package folder path, or a pkg reference resolved with conan cache path"""
+    if os.path.isdir(value):
+        return Path(value)
+    try:
+        from openssl_tools.conan_session import run_conan
+        result = run_conan(["cache", "path", value])
+    except ImportError:
+        result = subprocess.run(["conan", "cache", "path", value], capture_output=True, text=True)
+    if result.returncode != 0:
+        raise ValueError(f"{value}: not a directory and not in the Conan cache ({result.stderr.strip()})")
+    return Path(result.stdout.strip())
+
+
+def main(argv: Optional[List[str]] = None) -> int:
+    parser = argparse.ArgumentParser(description="Write runtime OCI layers of sparetools-openssl packages")
+    parser.add_argument("packages", nargs="+",
+                        help="Package folders or references (sparetools-openssl/3.6.0#rrev:pkgid)")
+    parser.add_argument("--layout", type=Path, default=Path("oci-runtime"), help="OCI image layout directory")
+    parser.add_argument("--tag", action="append", default=[], help="Tag per package, in order (repeatable)")
+    parser.add_argument("--prefix", default=DEFAULT_PREFIX, help="Install prefix inside the image")
+    parser.add_argument("--openssl-cnf", default="package",
+                        help="openssl.cnf to ship: package, dist (openssl.cnf.dist) or a file path")
+    parser.add_argument("--compression", choices=["gzip", "none"], default="gzip", help="Layer compression")
+    parser.add_argument("--json", action="store_true", help="Print the summaries as JSON")
+    args = parser.parse_args(argv)
+
+    builder = RuntimeLayerBuilder(args.layout, args.prefix, args.compression)
+    summaries = []
+    try:
+        for i, package in enumerate(args.packages):
+            tag = args.tag[i] if i < len(args.tag) else None
+            summaries.append(builder.add_package(_package_folder(package), tag, args.openssl_cnf))
+    except (OSError, ValueError) as e:
+        print(f"✗ {e}", file=sys.stderr)
+        return 1
+
+    if args.json:
+        print(json.dumps(summaries, indent=2))
+        return 0
+    for summary in summaries:
+        print(f"📦 {summary['tag']} ({summary['manifest'][:19]})")
+        for layer in summary["layers"]:
+            note = " (shared)" if layer["reused"] else ""
+            print(f"  {layer['name']:<10} {layer['files']:>4} files {layer['size'] / 1024:>9.1f} KiB "
+                  f"{layer['digest'][:19]}{note}")
+    blobs = sum(f.stat().st_size for f in (args.layout / "blobs" / "sha256").iterdir())
+    print(f"✓ {len(summaries)} image(s) in {args.layout}, {blobs / 1024:.1f} KiB of blobs")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
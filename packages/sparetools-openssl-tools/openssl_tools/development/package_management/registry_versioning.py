@@ -2,19 +2,146 @@
 """
 Registry Versioning Manager for OpenSSL Conan packages
 Ensures proper versioning and rollback protection for Conan registries
+
+Version lookups are answered from a local metadata cache of the registry,
+filled by one bulk `conan list "*" --format=json` and refreshed when older
+than registry.cache_ttl_minutes. Packages the bulk listing does not cover
+(a remote that refuses "*", or a version uploaded since the refresh) are
+listed individually, in parallel.
 """
 
 import os
 import sys
 import json
+import time
+import threading
 import yaml
 import subprocess
+from concurrent.futures import ThreadPoolExecutor
 from pathlib import Path
-from typing import Dict, List, Optional, Tuple
+from typing import Dict, Iterable, List, Optional, Tuple
 import argparse
 from datetime import datetime, timedelta
 import semver
 
+try:
+    from openssl_tools.config_snapshot import load_config
+except ImportError:  # Run as a script without openssl_tools installed
+    def load_config(path, default=None):
+        if not os.path.exists(path):
+            return default
+        with open(path, 'r') as f:
+            return yaml.safe_load(f)
+
+DEFAULT_CACHE_DIR = Path(os.environ.get("XDG_CACHE_HOME", Path.home() / ".cache")) / "openssl-tools" / "registry"
+
+
+class RegistryMetadataCache:
+    """Package versions of a registry (all configured remotes when remote is None)"""
+    
+    def __init__(self, remote: Optional[str] = None, ttl_minutes: float = 15, max_workers: int = 8,
+                 cache_dir: Path = DEFAULT_CACHE_DIR):
+        self.remote = remote
+        self.ttl = ttl_minutes * 60
+        self.max_workers = max(1, max_workers)
+        self.cache_file = Path(cache_dir) / f"{remote or 'all-remotes'}.json"
+        self.packages: Dict[str, List[str]] = {}
+        self.fetched = 0.0
+        self.complete = False  # the bulk listing succeeded
+        self._lock = threading.Lock()
+        self._load()
+    
+    def _load(self):
+        try:
+            with open(self.cache_file) as f:
+                data = json.load(f)
+            self.packages = data["packages"]
+            self.fetched = data["fetched"]
+            self.complete = data.get("complete", False)
+        except (OSError, ValueError, KeyError):
+            pass
+    
+    def _save(self):
+        self.cache_file.parent.mkdir(parents=True, exist_ok=True)
+        tmp = self.cache_file.with_suffix(f".{os.getpid()}.tmp")
+        with open(tmp, 'w') as f:
+            json.dump({"remote": self.remote, "fetched": self.fetched, "complete": self.complete,
+                       "packages": self.packages}, f)
+        os.replace(tmp, self.cache_file)
+    
+    def _conan_list(self, pattern: str) -> Optional[Dict[str, List[str]]]:
+        """name -> versions matching pattern, None if the listing failed"""
+        cmd = ['conan', 'list', pattern, '--format=json', '-r', self.remote or '*']
+        try:
+            result = subprocess.run(cmd, capture_output=True, text=True, timeout=300)
+            listing = json.loads(result.stdout) if result.returncode == 0 else None
+        except (OSError, subprocess.TimeoutExpired, ValueError):
+            listing = None
+        if not isinstance(listing, dict):
+            return None
+        
+        found: Dict[str, List[str]] = {}
+        failed = False
+        for refs in listing.values():
+            if not isinstance(refs, dict) or "error" in refs:
+                failed = True
+                continue
+            for ref in refs:
+                name, _, version = ref.split('@')[0].partition('/')
+                if version and version not in found.setdefault(name, []):
+                    found[name].append(version)
+        return None if failed and not found else found
+    
+    @property
+    def stale(self) -> bool:
+        return not self.complete or time.time() - self.fetched > self.ttl
+    
+    def refresh(self, force: bool = False) -> bool:
+        """One bulk listing of every package, unless the cache is still fresh"""
+        if not force and not self.stale:
+            return True
+        listing = self._conan_list('*')
+        with self._lock:
+            if listing is None:
+                self.complete = False
+                return False
+            self.packages = listing
+            self.fetched = time.time()
+            self.complete = True
+            self._save()
+        return True
+    
+    def fetch(self, names: Iterable[str]) -> None:
+        """List packages one by one (in parallel) and merge them into the cache"""
+        names = list(dict.fromkeys(names))
+        if not names:
+            return
+        with ThreadPoolExecutor(max_workers=min(self.max_workers, len(names))) as pool:
+            listings = list(pool.map(lambda name: self._conan_list(f"{name}/*"), names))
+        with self._lock:
+            for name, listing in zip(names, listings):
+                if listing is not None:
+                    self.packages[name] = listing.get(name, [])
+            self._save()
+    
+    def names(self) -> List[str]:
+        self.refresh()
+        return sorted(self.packages)
+    
+    def versions(self, name: str) -> List[str]:
+        """Versions of a package; listed on its own when the bulk listing did not have it"""
+        self.refresh()
+        if name not in self.packages:
+            self.fetch([name])
+        return list(self.packages.get(name, []))
+    
+    def has_version(self, name: str, version: str) -> bool:
+        if version in self.versions(name):
+            return True
+        # Possibly uploaded since the last refresh
+        self.fetch([name])
+        return version in self.packages.get(name, [])
+
 
 class RegistryVersioningManager:
     """Manages registry versioning and rollback protection"""
@@ -23,13 +150,15 @@ class RegistryVersioningManager:
         self.config_file = config_file
         self.config = self._load_config()
         self.version_registry = {}
+        registry = self.config.get('registry', {})
+        self.registry = RegistryMetadataCache(remote=registry.get('remote'),
+                                              ttl_minutes=registry.get('cache_ttl_minutes', 15),
+                                              max_workers=registry.get('max_workers', 8))
         
     def _load_config(self) -> Dict:
         """Load registry versioning configuration"""
-        if os.path.exists(self.config_file):
-            with open(self.config_file, 'r') as f:
-                return yaml.safe_load(f)
-        return self._get_default_config()
+        config = load_config(self.config_file)
+        return config if config is not None else self._get_default_config()
     
     def _get_default_config(self) -> Dict:
         """Get default registry versioning configuration"""
@@ -51,6 +180,11 @@ class RegistryVersioningManager:
                 'compatibility_checks': True,
                 'dependency_validation': True
             },
+            'registry': {
+                'remote': None,  # None: all configured remotes
+                'cache_ttl_minutes': 15,
+                'max_workers': 8
+            },
             'registries': {
                 'development': {
                     'versioning': 'dev',
@@ -100,27 +234,8 @@ class RegistryVersioningManager:
     def _get_latest_version(self, package_name: str) -> str:
         """Get latest version of package from registry"""
         try:
-            # Try to get from Conan registry
-            result = subprocess.run(['conan', 'search', package_name], 
-                                 capture_output=True, text=True)
-            if result.returncode == 0:
-                # Parse versions from output
-                lines = result.stdout.split('\n')
-                versions = []
-                for line in lines:
-                    if 'versions:' in line:
-                        continue
-                    if line.strip() and not line.startswith('Available versions:'):
-                        version = line.strip()
-                        if self._is_valid_version(version):
-                            versions.append(version)
-                
-                if versions:
-                    # Sort versions and return latest
-                    versions.sort(key=lambda v: semver.VersionInfo.parse(v), reverse=True)
-                    return versions[0]
-            
-            return None
+            versions = self._get_package_versions(package_name)
+            return versions[0] if versions else None
             
         except Exception as e:
             print(f"Warning: Could not get latest version for {package_name}: {e}")
@@ -211,10 +326,8 @@ class RegistryVersioningManager:
     def _version_exists(self, package_name: str, version: str) -> bool:
         """Check if version exists in registry"""
         try:
-            result = subprocess.run(['conan', 'search', f"{package_name}/{version}"], 
-                                 capture_output=True, text=True)
-            return result.returncode == 0
-        except:
+            return self.registry.has_version(package_name, version)
+        except Exception:
             return False
     
     def _check_compatibility(self, package_name: str, version: str) -> bool:
@@ -375,7 +488,8 @@ class RegistryVersioningManager:
             'version_statistics': {}
         }
         
-        # Get all packages and their versions
+        # Get all packages and their versions (one bulk registry listing)
+        self.registry.refresh()
         packages = self._get_all_packages()
         
         for package in packages:
@@ -386,14 +500,16 @@ class RegistryVersioningManager:
                 'versions': versions
             }
         
-        # Check rollback status
-        for package, info in report['packages'].items():
-            if info['latest_version']:
-                rollback_safe = self.validate_rollback(package, info['latest_version'])
-                report['rollback_status'][package] = {
-                    'safe': rollback_safe,
-                    'latest_version': info['latest_version']
-                }
+        # Check rollback status (dependency checks run conan per package, so in parallel)
+        candidates = [(package, info['latest_version']) for package, info in report['packages'].items()
+                      if info['latest_version']]
+        with ThreadPoolExecutor(max_workers=max(1, min(self.registry.max_workers, len(candidates) or 1))) as pool:
+            verdicts = list(pool.map(lambda candidate: self.validate_rollback(*candidate), candidates))
+        for (package, latest_version), rollback_safe in zip(candidates, verdicts):
+            report['rollback_status'][package] = {
+                'safe': rollback_safe,
+                'latest_version': latest_version
+            }
         
         # Save report
         report_file = 'version-management-report.json'
@@ -406,33 +522,17 @@ class RegistryVersioningManager:
     def _get_all_packages(self) -> List[str]:
         """Get all packages in registry"""
         try:
-            result = subprocess.run(['conan', 'search'], capture_output=True, text=True)
-            if result.returncode == 0:
-                packages = []
-                for line in result.stdout.split('\n'):
-                    if line.strip() and not line.startswith('Available packages:'):
-                        packages.append(line.strip())
-                return packages
-        except:
-            pass
-        return []
+            return self.registry.names()
+        except Exception:
+            return []
     
     def _get_package_versions(self, package_name: str) -> List[str]:
         """Get all versions of a package"""
         try:
-            result = subprocess.run(['conan', 'search', package_name], 
-                                 capture_output=True, text=True)
-            if result.returncode == 0:
-                versions = []
-                for line in result.stdout.split('\n'):
-                    if line.strip() and not line.startswith('Available versions:'):
-                        version = line.strip()
-                        if self._is_valid_version(version):
-                            versions.append(version)
-                return sorted(versions, key=lambda v: semver.VersionInfo.parse(v), reverse=True)
-        except:
-            pass
-        return []
+            versions = [v for v in self.registry.versions(package_name) if self._is_valid_version(v)]
+            return sorted(versions, key=lambda v: semver.VersionInfo.parse(v), reverse=True)
+        except Exception:
+            return []
 
 
 def main():
@@ -450,10 +550,14 @@ def main():
                        help='Execute rollback')
     parser.add_argument('--report', action='store_true',
                        help='Generate version report')
+    parser.add_argument('--refresh', action='store_true',
+                       help='Refresh the registry metadata cache before acting')
     
     args = parser.parse_args()
     
     manager = RegistryVersioningManager(args.config)
+    if args.refresh:
+        manager.registry.refresh(force=True)
     
     if args.generate_version:
         package, change_type = args.generate_version
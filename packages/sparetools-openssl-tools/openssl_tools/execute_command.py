@@ -11,6 +11,11 @@ import subprocess
 from pathlib import Path
 from typing import Optional, Tuple, List, Union
 
+# Streaming asyncio variants: many concurrent commands on one event loop
+from .async_command import (
+    CommandResult, execute_command_async, log_lines, run_commands, run_commands_async
+)
+
 log = logging.getLogger(__name__)
 
 
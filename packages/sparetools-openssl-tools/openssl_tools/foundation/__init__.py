@@ -5,11 +5,15 @@ Core foundation utilities for OpenSSL Conan ecosystem.
 """
 
 from .version_manager import get_openssl_version, parse_openssl_version
-from .profile_deployer import deploy_openssl_profiles, list_openssl_profiles
+from .profile_deployer import (deploy_openssl_profiles, list_openssl_profiles, detect_cpu_features,
+                               select_simd_profile, deploy_host_variant)
 
 __all__ = [
     'get_openssl_version',
     'parse_openssl_version', 
     'deploy_openssl_profiles',
-    'list_openssl_profiles'
+    'list_openssl_profiles',
+    'detect_cpu_features',
+    'select_simd_profile',
+    'deploy_host_variant'
 ]
\ No newline at end of file
@@ -92,6 +92,7 @@ Examples:
     )
     optimize_parser.add_argument("--cache-dir", help="Build cache directory")
     optimize_parser.add_argument("--max-size", type=int, default=10, help="Maximum cache size in GB")
+    optimize_parser.add_argument("--remote", help="Remote cache tier (s3://, https:// or shared directory)")
     
     # Conan management commands
     conan_parser = subparsers.add_parser(
@@ -204,7 +205,7 @@ def handle_build_command(args):
     """Handle build optimization commands."""
     if args.build_action == "optimize":
         cache_dir = Path(args.cache_dir) if args.cache_dir else None
-        optimizer = BuildCacheManager(cache_dir, max_cache_size_gb=args.max_size)
+        optimizer = BuildCacheManager(cache_dir, max_cache_size_gb=args.max_size, remote=args.remote)
         result = optimizer.optimize_cache()
         print(f"Build optimization completed: {result}")
 
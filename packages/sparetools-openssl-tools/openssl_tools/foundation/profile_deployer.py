@@ -1,9 +1,100 @@
 from pathlib import Path
+import errno
+import json
+import platform
 import shutil
 import os
-from typing import List
+import subprocess
+import sys
+from typing import Dict, List, Optional, Set
 
-def deploy_openssl_profiles(force: bool = False, verbose: bool = True) -> None:
+# symlink: profiles follow package upgrades; hardlink/reflink: real files at
+# (near) zero cost; copy: independent files (default, previous behaviour)
+LINK_MODES = ("symlink", "hardlink", "reflink", "copy")
+
+_FICLONE = 0x40049409
+
+# sparetools-openssl feature profiles per architecture, best first, with the
+# CPU features (Linux /proc/cpuinfo names) a host needs for each. The asm
+# profiles dispatch at runtime, so the ladder only skips code paths the host
+# cannot use; the tuned profiles build with -march/-mcpu and must not run on
+# a host without their baseline.
+SIMD_PROFILES = {
+    "x86_64": [
+        ("tuned-x86-64-v4", {"avx512f", "avx512bw", "avx512cd", "avx512dq", "avx512vl", "avx2", "bmi2", "fma"}),
+        ("assembly-avx2-only", {"avx", "avx2"}),
+        ("assembly-avx-only", {"avx"}),
+        ("assembly-minimal", set()),
+    ],
+    "armv8": [
+        ("assembly-sve2", {"asimd", "sve"}),
+        ("tuned-neoverse-n1", {"asimd", "atomics", "asimddp", "lrcpc", "fphp"}),
+        ("assembly-neon", {"asimd"}),
+        ("assembly-minimal", set()),
+    ],
+}
+
+# Environment override for the selected profile (e.g. in a container image
+# built on a different host than it runs on)
+SIMD_PROFILE_ENV = "SPARETOOLS_SIMD_PROFILE"
+
+# macOS sysctl hw.optional names, as /proc/cpuinfo names
+_SYSCTL_FEATURES = {
+    "avx1_0": "avx", "avx2_0": "avx2", "bmi2": "bmi2", "fma": "fma", "avx512f": "avx512f",
+    "avx512bw": "avx512bw", "avx512cd": "avx512cd", "avx512dq": "avx512dq", "avx512vl": "avx512vl",
+    "neon": "asimd", "arm.FEAT_LSE": "atomics", "arm.FEAT_DotProd": "asimddp",
+    "arm.FEAT_LRCPC": "lrcpc", "arm.FEAT_FP16": "fphp", "arm.FEAT_SVE": "sve", "arm.FEAT_SVE2": "sve2",
+}
+
+# Windows IsProcessorFeaturePresent constants, as /proc/cpuinfo names
+_WINDOWS_FEATURES = {
+    39: "avx", 40: "avx2", 41: "avx512f", 19: "asimd", 34: "atomics",
+    43: "asimddp", 46: "sve", 47: "sve2",
+}
+
+
+def _reflink(source: Path, dest: Path) -> None:
+    """Copy-on-write clone (APFS clonefile, Btrfs/XFS FICLONE)"""
+    if sys.platform == "darwin":
+        import ctypes
+        libc = ctypes.CDLL(None, use_errno=True)
+        if libc.clonefile(os.fsencode(source), os.fsencode(dest), 0) != 0:
+            err = ctypes.get_errno()
+            raise OSError(err, os.strerror(err), str(dest))
+        return
+    try:
+        import fcntl
+    except ImportError:
+        raise OSError(errno.EOPNOTSUPP, "reflinks are not supported on this platform", str(dest))
+    with open(source, "rb") as src, open(dest, "wb") as dst:
+        try:
+            fcntl.ioctl(dst.fileno(), _FICLONE, src.fileno())
+        except OSError:
+            dst.close()
+            dest.unlink()
+            raise
+    shutil.copystat(source, dest)
+
+
+def _place_profile(source: Path, dest: Path, link_mode: str) -> None:
+    """Build next to dest and rename over it: a failed mode keeps the old profile"""
+    tmp = dest.with_name(f".{dest.name}.{os.getpid()}.tmp")
+    if os.path.lexists(tmp):
+        tmp.unlink()
+    if link_mode == "symlink":
+        tmp.symlink_to(source.resolve())
+    elif link_mode == "hardlink":
+        os.link(source, tmp)
+    elif link_mode == "reflink":
+        _reflink(source, tmp)
+    else:
+        shutil.copy2(source, tmp)
+    os.replace(tmp, dest)
+
+
+def deploy_openssl_profiles(force: bool = False, verbose: bool = True, link_mode: str = "copy") -> None:
+    if link_mode not in LINK_MODES:
+        raise ValueError(f"Unknown link_mode {link_mode!r}, expected one of {LINK_MODES}")
     conan_home = Path(os.environ.get("CONAN_USER_HOME", Path.home() / ".conan2"))
     profiles_dir = conan_home / "profiles"
     profiles_dir.mkdir(parents=True, exist_ok=True)
@@ -25,18 +116,23 @@ def deploy_openssl_profiles(force: bool = False, verbose: bool = True) -> None:
             continue
         for profile_file in subdir.glob("*.profile"):
             dest_profile = profiles_dir / profile_file.name
-            if dest_profile.exists() and not force:
+            if os.path.lexists(dest_profile) and not force:
                 if verbose:
                     print(f"ℹ️  Profile exists: {profile_file.name} (use --force)")
                 skipped_count += 1
                 continue
-            shutil.copy2(profile_file, dest_profile)
+            try:
+                _place_profile(profile_file, dest_profile, link_mode)
+            except OSError as e:
+                if verbose:
+                    print(f"❌ Failed to deploy {profile_file.name} ({link_mode}): {e}")
+                continue
             if verbose:
                 print(f"📄 Deployed: {profile_file.name}")
             deployed_count += 1
 
     if verbose:
-        print(f"\n✅ Deployed {deployed_count} profiles to {profiles_dir}")
+        print(f"\n✅ Deployed {deployed_count} profiles to {profiles_dir} ({link_mode})")
         if skipped_count > 0:
             print(f"ℹ️  Skipped {skipped_count} existing profiles")
 
@@ -52,3 +148,168 @@ def list_openssl_profiles() -> List[str]:
         if "openssl" in content.lower() or profile_file.stem.startswith(("linux-", "windows-", "fips-")):
             profiles.append(profile_file.stem)
     return sorted(profiles)
+
+
+def host_arch() -> str:
+    """Conan arch of this host (x86_64, armv8, or the raw machine name)"""
+    machine = platform.machine().lower()
+    if machine in ("x86_64", "amd64"):
+        return "x86_64"
+    if machine in ("aarch64", "arm64"):
+        return "armv8"
+    return machine
+
+
+def detect_cpu_features() -> Set[str]:
+    """
+    SIMD and ISA features of this host, named as in /proc/cpuinfo (avx2,
+    avx512f, asimd, sve, ...). Read from /proc/cpuinfo on Linux, sysctl
+    hw.optional on macOS and IsProcessorFeaturePresent on Windows.
+    """
+    features: Set[str] = set()
+    if sys.platform.startswith("linux"):
+        try:
+            with open("/proc/cpuinfo") as f:
+                for line in f:
+                    key, _, value = line.partition(":")
+                    if key.strip() in ("flags", "Features"):
+                        features.update(value.split())
+                        break  # Every core reports the same set
+        except OSError:
+            pass
+    elif sys.platform == "darwin":
+        try:
+            out = subprocess.run(["sysctl", "hw.optional"], capture_output=True, text=True).stdout
+        except OSError:
+            out = ""
+        for line in out.splitlines():
+            key, _, value = line.partition(":")
+            name = _SYSCTL_FEATURES.get(key.strip()[len("hw.optional."):])
+            if name and value.strip() == "1":
+                features.add(name)
+    elif sys.platform == "win32":
+        import ctypes
+        present = ctypes.windll.kernel32.IsProcessorFeaturePresent
+        features.update(name for number, name in _WINDOWS_FEATURES.items() if present(number))
+    # Windows cannot query the rest of x86-64-v4 one by one; AVX-512F CPUs have it
+    if "avx512f" in features and sys.platform == "win32":
+        features.update({"avx512bw", "avx512cd", "avx512dq", "avx512vl", "bmi2", "fma"})
+    return features
+
+
+def rank_simd_profiles(features: Set[str], arch: Optional[str] = None) -> List[str]:
+    """Feature profiles this host can run, best first"""
+    ladder = SIMD_PROFILES.get(arch or host_arch(), [("assembly-minimal", set())])
+    return [name for name, needs in ladder if needs <= features]
+
+
+def select_simd_profile(features: Optional[Set[str]] = None, arch: Optional[str] = None) -> str:
+    """Best feature profile for this host; SPARETOOLS_SIMD_PROFILE overrides it"""
+    if os.environ.get(SIMD_PROFILE_ENV):
+        return os.environ[SIMD_PROFILE_ENV]
+    return rank_simd_profiles(detect_cpu_features() if features is None else features, arch)[0]
+
+
+def _feature_profile(name: str) -> str:
+    """Path of a bundled feature profile (repository checkout), else the name for Conan to resolve"""
+    bundled = Path(__file__).resolve().parents[2] / "profiles" / "features" / name
+    return str(bundled) if bundled.is_file() else name
+
+
+def _place_tree(source: Path, dest: Path, link_mode: str) -> None:
+    """dest as a view of the source directory, built aside and then swapped in"""
+    tmp = dest.with_name(f".{dest.name}.{os.getpid()}.tmp")
+    if os.path.islink(tmp) or tmp.is_file():
+        tmp.unlink()
+    elif tmp.exists():
+        shutil.rmtree(tmp)
+    if link_mode == "symlink":
+        tmp.symlink_to(source.resolve(), target_is_directory=True)
+    else:
+        for root, _, files in os.walk(source):
+            target = tmp / Path(root).relative_to(source)
+            target.mkdir(parents=True, exist_ok=True)
+            for name in files:
+                src = Path(root) / name
+                if src.is_symlink():
+                    (target / name).symlink_to(os.readlink(src))
+                else:
+                    _place_profile(src, target / name, link_mode)
+    # A symlink replaces a symlink in one rename; anything else is moved aside first
+    old = dest.with_name(f".{dest.name}.{os.getpid()}.old")
+    if os.path.lexists(dest) and not (dest.is_symlink() and tmp.is_symlink()):
+        os.replace(dest, old)
+    os.replace(tmp, dest)
+    if old.is_symlink() or old.is_file():
+        old.unlink()
+    elif old.exists():
+        shutil.rmtree(old)
+
+
+def _install(reference: str, profiles: List[str], remote: Optional[str], build_missing: bool) -> Optional[Dict]:
+    """conan install of reference with the given host profiles; the package node, or None"""
+    from ..conan_session import run_conan
+
+    args = ["install", f"--requires={reference}", "--format=json"]
+    for profile in profiles:
+        args += ["-pr:h", profile]
+    args += ["-pr:b", "default", "--build=missing:sparetools-openssl*" if build_missing else "--build=never"]
+    if remote:
+        args += ["-r", remote]
+    result = run_conan(args)
+    if result.returncode != 0:
+        return None
+    name = reference.split("/", 1)[0]
+    for node in json.loads(result.stdout)["graph"]["nodes"].values():
+        if node.get("ref", "").startswith(name + "/") and node.get("package_folder"):
+            return node
+    return None
+
+
+def deploy_host_variant(reference: str, dest: Path, base_profile: str = "default",
+                        remote: Optional[str] = None, link_mode: str = "symlink", build_missing: bool = False,
+                        verbose: bool = True) -> Optional[Dict]:
+    """
+    Install the sparetools-openssl binary best suited to this host's CPU and
+    place it at dest (a symlink to the package folder by default).
+
+    The feature profiles this host can run are tried best first, each layered
+    on base_profile, and the first one with a binary in the cache or on remote
+    wins; build_missing=True builds the best one instead. The selection
+    (features, profile, package id and folder) is written to dest.json next
+    to dest. Returns it, or None if no profile had a binary.
+    """
+    if link_mode not in LINK_MODES:
+        raise ValueError(f"Unknown link_mode {link_mode!r}, expected one of {LINK_MODES}")
+    features = detect_cpu_features()
+    forced = os.environ.get(SIMD_PROFILE_ENV)
+    candidates = [forced] if forced else rank_simd_profiles(features)
+    if verbose:
+        print(f"🔍 {host_arch()} host, {len(features)} CPU features; candidates: {', '.join(candidates)}")
+
+    for i, profile in enumerate(candidates):
+        node = _install(reference, [base_profile, _feature_profile(profile)], remote, build_missing and i == 0)
+        if node is None:
+            if verbose:
+                print(f"ℹ️  No {reference} binary for {profile}")
+            continue
+        dest = Path(dest)
+        dest.parent.mkdir(parents=True, exist_ok=True)
+        _place_tree(Path(node["package_folder"]), dest, link_mode)
+        selection = {
+            "arch": host_arch(),
+            "features": sorted(features),
+            "profile": profile,
+            "ref": node["ref"],
+            "package_id": node.get("package_id"),
+            "package_folder": node["package_folder"],
+            "link_mode": link_mode,
+        }
+        with open(dest.with_name(dest.name + ".json"), "w") as f:
+            json.dump(selection, f, indent=2)
+        if verbose:
+            print(f"✅ {profile}: {node['ref']}:{node.get('package_id')} -> {dest} ({link_mode})")
+        return selection
+    if verbose:
+        print(f"❌ No {reference} binary for any of {', '.join(candidates)}")
+    return None
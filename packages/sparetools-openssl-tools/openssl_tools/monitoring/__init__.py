@@ -7,12 +7,15 @@ including status reporting, log management, and system monitoring.
 Classes:
     StatusReporter: Reports system and build status
     LogManager: Manages logging and log filtering
+    MetricsExporter: Prometheus metrics for builds, caches and benchmarks
 """
 
 from .status_reporter import StatusReporter
 from .log_manager import LogWhitelistManager
+from .metrics_exporter import MetricsExporter
 
 __all__ = [
     "StatusReporter",
     "LogWhitelistManager",
+    "MetricsExporter",
 ]
@@ -19,6 +19,120 @@ import fnmatch
 logging.basicConfig(level=logging.INFO, format='%(asctime)s - %(levelname)s - %(message)s')
 logger = logging.getLogger(__name__)
 
+# Lines read per batch when streaming logs (bytes, passed to readlines())
+STREAM_CHUNK_BYTES = 4 * 1024 * 1024
+# new_patterns keeps the first entries only; new_pattern_counts has the totals
+MAX_NEW_PATTERN_EXAMPLES = 1000
+
+# _detect_new_pattern() alternatives, tried in this order at line start
+NEW_PATTERN_RE = re.compile(
+    r"(?P<timestamp_pattern>\d{4}-\d{2}-\d{2})"
+    r"|(?P<bracket_format>\[.*\])"
+    r"|(?P<category_format>\w+:\s)"
+)
+
+
+def _strip_wildcards(pattern: str) -> str:
+    """
+    Drop leading/trailing ".*" from a search pattern: re.search() already
+    finds matches anywhere in the line, and the wildcards only make the
+    engine scan to the end of the line and backtrack at every position.
+    """
+    while pattern.startswith((".*?", ".*")) and len(pattern) > 2:
+        pattern = pattern[3:] if pattern.startswith(".*?") else pattern[2:]
+    while pattern.endswith(".*") and len(pattern) > 2:
+        backslashes = len(pattern[:-2]) - len(pattern[:-2].rstrip("\\"))
+        if backslashes % 2:
+            break  # "\\.*" is a literal dot followed by "*"
+        pattern = pattern[:-2]
+    return pattern
+
+
+class CompiledWhitelist:
+    """
+    All whitelist patterns compiled once into a single alternation.
+
+    Most log lines match no pattern, and the combined regex rejects them in
+    one scan. For a line that does match, the label is the first pattern
+    in priority order that matches (fixed, full, regex, then the OpenSSL
+    categories), as with a pattern-by-pattern check: only the patterns
+    ahead of the one the alternation found are re-tested. Never-whitelist
+    security patterns get a separate case-insensitive alternation that can
+    also screen a whole chunk of lines at once.
+    """
+
+    _PREFIXES = {"fixed_faults": "fixed", "full_faults": "full", "regex_faults": "regex"}
+
+    def __init__(self, whitelist_patterns: Dict[str, List[str]], security_patterns: List[str]):
+        self.entries: List[Tuple[str, "re.Pattern"]] = []
+        parts = []
+        for category, patterns in whitelist_patterns.items():
+            if category not in self._PREFIXES and not category.startswith("openssl_"):
+                continue
+            literal = category in ("fixed_faults", "full_faults")
+            for pattern in patterns:
+                source = re.escape(pattern) if literal else _strip_wildcards(pattern)
+                try:
+                    compiled = re.compile(source)
+                except re.error:
+                    logger.warning(f"Invalid regex pattern: {pattern}")
+                    continue
+                parts.append(f"(?P<p{len(self.entries)}>{source})")
+                self.entries.append((f"{self._PREFIXES.get(category, category)}:{pattern}", compiled))
+        self.combined = self._combine(parts, 0)
+
+        security = []
+        for pattern in security_patterns:
+            try:
+                security.append(re.compile(_strip_wildcards(pattern), re.IGNORECASE))
+            except re.error:
+                logger.warning(f"Invalid security pattern: {pattern}")
+        parts = [f"(?:{p.pattern})" for p in security]
+        self.security = self._combine(parts, re.IGNORECASE)
+        # Chunk screening: MULTILINE keeps ^/$ meaning line start/end
+        self.security_chunk = self._combine(parts, re.IGNORECASE | re.MULTILINE)
+        self._security_list = security
+
+    @staticmethod
+    def _combine(parts: List[str], flags: int) -> Optional["re.Pattern"]:
+        if not parts:
+            return None
+        try:
+            return re.compile("|".join(parts), flags)
+        except re.error:
+            # e.g. numbered backreferences that shift when patterns are joined
+            return None
+
+    def match(self, line: str) -> Optional[str]:
+        """Label of the first whitelist pattern matching line, or None"""
+        line = line.strip()
+        if self.combined is None:
+            for label, compiled in self.entries:
+                if compiled.search(line):
+                    return label
+            return None
+        m = self.combined.search(line)
+        if m is None:
+            return None
+        found = int(m.lastgroup[1:])
+        for label, compiled in self.entries[:found]:
+            if compiled.search(line):
+                return label
+        return self.entries[found][0]
+
+    def is_security_related(self, line: str) -> bool:
+        """True if line hits a never-whitelist pattern"""
+        if self.security is not None:
+            return self.security.search(line) is not None
+        return any(p.search(line) for p in self._security_list)
+
+    def chunk_is_security_related(self, chunk: str) -> bool:
+        """False only if no line of chunk can hit a never-whitelist pattern"""
+        if self.security_chunk is not None:
+            return self.security_chunk.search(chunk) is not None
+        return bool(self._security_list)
+
+
 class LogWhitelistManager:
     """Log whitelist management system based on oms-dev patterns"""
     
@@ -109,10 +223,151 @@ class LogWhitelistManager:
         logger.info(f"✅ Log whitelist configuration created: {self.whitelist_config_path}")
     
     def filter_logs(self, log_file_path: Path, output_path: Optional[Path] = None) -> Dict:
-        """Filter logs using whitelist patterns"""
+        """
+        Filter logs using whitelist patterns. The log is streamed in chunks
+        of STREAM_CHUNK_BYTES and kept lines are written out as they are
+        read, so memory use does not grow with the log size.
+        """
         logger.info(f"🔍 Filtering logs: {log_file_path}")
         
-        filter_results = {
+        filter_results = self._new_filter_results(log_file_path, output_path)
+        
+        try:
+            with open(self.whitelist_config_path, 'r') as f:
+                config = yaml.safe_load(f)
+            
+            if not config["log_whitelist"]["enabled"]:
+                logger.info("⏸️ Log filtering is disabled")
+                return filter_results
+            
+            self._filter_file(log_file_path, output_path, self._compile_whitelist(config), config, filter_results)
+            self._finish_filter(filter_results, config)
+            
+        except Exception as e:
+            logger.error(f"❌ Log filtering failed: {e}")
+        
+        return filter_results
+    
+    def filter_logs_parallel(self, log_file_paths: List[Path], output_dir: Optional[Path] = None,
+                             max_workers: Optional[int] = None) -> Dict:
+        """
+        Filter many logs (e.g. every raw log of a build matrix) in a process
+        pool and merge the results into one report. Each worker compiles the
+        whitelist once and streams its file like filter_logs(); kept lines go
+        to output_dir/<name>.filtered when output_dir is given. Line numbers
+        in new_patterns and security_violations are per file, tagged "file".
+        """
+        from concurrent.futures import ProcessPoolExecutor
+        
+        logger.info(f"🔍 Filtering {len(log_file_paths)} logs in parallel")
+        merged = self._new_filter_results(Path(), output_dir)
+        merged["input_file"] = [str(p) for p in log_file_paths]
+        merged["files"] = []
+        
+        with open(self.whitelist_config_path, 'r') as f:
+            config = yaml.safe_load(f)
+        if not config["log_whitelist"]["enabled"]:
+            logger.info("⏸️ Log filtering is disabled")
+            return merged
+        if output_dir:
+            output_dir.mkdir(parents=True, exist_ok=True)
+        
+        tasks = [(self.project_root, path, output_dir / f"{path.name}.filtered" if output_dir else None)
+                 for path in log_file_paths]
+        with ProcessPoolExecutor(max_workers=max_workers) as pool:
+            for results in pool.map(_filter_log_worker, tasks):
+                self._merge_filter_results(merged, results)
+        
+        self._finish_filter(merged, config)
+        return merged
+    
+    def _merge_filter_results(self, merged: Dict, results: Dict) -> None:
+        merged["files"].append({key: results[key] for key in
+                                ("input_file", "output_file", "total_lines", "filtered_lines", "suppressed_lines")})
+        if results.get("error"):
+            merged["files"][-1]["error"] = results["error"]
+        for key in ("total_lines", "filtered_lines", "suppressed_lines"):
+            merged[key] += results[key]
+        for key in ("suppressed_patterns", "new_pattern_counts"):
+            for pattern, count in results[key].items():
+                merged[key][pattern] = merged[key].get(pattern, 0) + count
+        room = MAX_NEW_PATTERN_EXAMPLES - len(merged["new_patterns"])
+        merged["new_patterns"].extend(dict(p, file=results["input_file"])
+                                      for p in results["new_patterns"][:max(0, room)])
+        merged["security_violations"].extend(dict(v, file=results["input_file"])
+                                             for v in results["security_violations"])
+    
+    def follow_logs(self, log_file_path: Path, output_path: Optional[Path] = None,
+                    poll_interval: float = 0.5, idle_timeout: Optional[float] = None) -> Dict:
+        """
+        Filter a log that is still being written (a live build log), like
+        tail -f: kept lines go to output_path (stdout by default) as soon as
+        they are complete, and security-related lines are reported
+        immediately. Handles truncation and rotation by reopening. Stops on
+        Ctrl-C, or after idle_timeout seconds without new data.
+        """
+        import time
+        
+        logger.info(f"👀 Following logs: {log_file_path}")
+        filter_results = self._new_filter_results(log_file_path, output_path)
+        with open(self.whitelist_config_path, 'r') as f:
+            config = yaml.safe_load(f)
+        if not config["log_whitelist"]["enabled"]:
+            logger.info("⏸️ Log filtering is disabled")
+            return filter_results
+        whitelist = self._compile_whitelist(config)
+        
+        out = open(output_path, 'a') if output_path else sys.stdout
+        f = None
+        pending = ""
+        idle_since = time.monotonic()
+        try:
+            while True:
+                if f is None:
+                    try:
+                        f = open(log_file_path, 'r', encoding='utf-8', errors='ignore')
+                        inode = os.fstat(f.fileno()).st_ino
+                    except FileNotFoundError:
+                        f = None
+                data = f.read(STREAM_CHUNK_BYTES) if f else ""
+                if data:
+                    idle_since = time.monotonic()
+                    lines = (pending + data).splitlines(keepends=True)
+                    # Hold back a partial last line until its newline arrives
+                    pending = lines.pop() if lines and not lines[-1].endswith("\n") else ""
+                    violations = len(filter_results["security_violations"])
+                    self._filter_chunk(lines, whitelist, config, filter_results, out)
+                    out.flush()
+                    for violation in filter_results["security_violations"][violations:]:
+                        logger.error(f"🚨 Line {violation['line_number']}: {violation['line']}")
+                    continue
+                if idle_timeout is not None and time.monotonic() - idle_since >= idle_timeout:
+                    break
+                time.sleep(poll_interval)
+                if f is not None:
+                    try:
+                        st = os.stat(log_file_path)
+                    except FileNotFoundError:
+                        continue
+                    if st.st_ino != inode or st.st_size < f.tell():
+                        f.close()  # Rotated or truncated: start over on the new file
+                        f = None
+                        pending = ""
+        except KeyboardInterrupt:
+            pass
+        finally:
+            if pending:
+                self._filter_chunk([pending], whitelist, config, filter_results, out)
+            if f is not None:
+                f.close()
+            if output_path:
+                out.close()
+        
+        self._finish_filter(filter_results, config)
+        return filter_results
+    
+    def _new_filter_results(self, log_file_path: Path, output_path: Optional[Path]) -> Dict:
+        return {
             "filter_timestamp": datetime.now().isoformat(),
             "input_file": str(log_file_path),
             "output_file": str(output_path) if output_path else "",
@@ -121,94 +376,84 @@ class LogWhitelistManager:
             "suppressed_lines": 0,
             "suppressed_patterns": {},
             "new_patterns": [],
+            "new_pattern_counts": {},
             "security_violations": []
         }
-        
+    
+    def _filter_file(self, log_file_path: Path, output_path: Optional[Path], whitelist: CompiledWhitelist,
+                     config: Dict, filter_results: Dict) -> None:
+        out = open(output_path, 'w') if output_path else None
         try:
-            with open(self.whitelist_config_path, 'r') as f:
-                config = yaml.safe_load(f)
-            
-            if not config["log_whitelist"]["enabled"]:
-                logger.info("⏸️ Log filtering is disabled")
-                return filter_results
-            
-            # Load whitelist patterns
-            whitelist_patterns = self._load_whitelist_patterns(config)
+            with open(log_file_path, 'r', encoding='utf-8', errors='ignore') as f:
+                for lines in iter(lambda: f.readlines(STREAM_CHUNK_BYTES), []):
+                    self._filter_chunk(lines, whitelist, config, filter_results, out)
+        finally:
+            if out:
+                out.close()
+    
+    def _compile_whitelist(self, config: Dict) -> CompiledWhitelist:
+        return CompiledWhitelist(self._load_whitelist_patterns(config),
+                                 config["log_whitelist"]["security_filters"]["never_whitelist"])
+    
+    def _filter_chunk(self, lines: List[str], whitelist: CompiledWhitelist, config: Dict,
+                      results: Dict, out) -> None:
+        """Filter one batch of lines, updating results and writing kept lines to out"""
+        first_line = results["total_lines"] + 1
+        results["total_lines"] += len(lines)
+        detect_new = config["ci_integration"]["fail_on_new_patterns"] and config["ci_integration"]["opt_in_mode"]
+        # One scan usually clears the whole chunk of security patterns
+        check_security = whitelist.chunk_is_security_related("".join(lines))
+        suppressed_patterns = results["suppressed_patterns"]
+        kept = []
+        
+        for line_num, line in enumerate(lines, first_line):
+            # Check for security violations first
+            if check_security and whitelist.is_security_related(line):
+                results["security_violations"].append({
+                    "line_number": line_num,
+                    "line": line.strip(),
+                    "violation_type": "security_related"
+                })
+                continue
             
-            # Process log file
-            filtered_lines = []
-            suppressed_count = 0
-            suppressed_patterns = {}
-            new_patterns = []
-            security_violations = []
+            matched_pattern = whitelist.match(line)
+            if matched_pattern is not None:
+                results["suppressed_lines"] += 1
+                suppressed_patterns[matched_pattern] = suppressed_patterns.get(matched_pattern, 0) + 1
+                continue
             
-            with open(log_file_path, 'r', encoding='utf-8', errors='ignore') as f:
-                for line_num, line in enumerate(f, 1):
-                    filter_results["total_lines"] += 1
-                    
-                    # Check for security violations first
-                    if self._check_security_violations(line, config):
-                        security_violations.append({
+            kept.append(line)
+            if detect_new:
+                new_pattern = self._detect_new_pattern(line)
+                if new_pattern:
+                    counts = results["new_pattern_counts"]
+                    counts[new_pattern] = counts.get(new_pattern, 0) + 1
+                    if len(results["new_patterns"]) < MAX_NEW_PATTERN_EXAMPLES:
+                        results["new_patterns"].append({
                             "line_number": line_num,
-                            "line": line.strip(),
-                            "violation_type": "security_related"
+                            "pattern": new_pattern,
+                            "line": line.strip()
                         })
-                        continue
-                    
-                    # Check if line should be filtered
-                    should_filter, matched_pattern = self._should_filter_line(line, whitelist_patterns)
-                    
-                    if should_filter:
-                        suppressed_count += 1
-                        if matched_pattern:
-                            if matched_pattern not in suppressed_patterns:
-                                suppressed_patterns[matched_pattern] = 0
-                            suppressed_patterns[matched_pattern] += 1
-                    else:
-                        filtered_lines.append(line)
-                        
-                        # Check for new patterns (opt-in mode)
-                        if config["ci_integration"]["fail_on_new_patterns"] and config["ci_integration"]["opt_in_mode"]:
-                            new_pattern = self._detect_new_pattern(line)
-                            if new_pattern:
-                                new_patterns.append({
-                                    "line_number": line_num,
-                                    "pattern": new_pattern,
-                                    "line": line.strip()
-                                })
-            
-            # Update results
-            filter_results["filtered_lines"] = len(filtered_lines)
-            filter_results["suppressed_lines"] = suppressed_count
-            filter_results["suppressed_patterns"] = suppressed_patterns
-            filter_results["new_patterns"] = new_patterns
-            filter_results["security_violations"] = security_violations
-            
-            # Write filtered output
-            if output_path:
-                with open(output_path, 'w') as f:
-                    f.writelines(filtered_lines)
-                filter_results["output_file"] = str(output_path)
-            
-            # Save filter metrics
-            self._save_filter_metrics(filter_results)
-            
-            # Check for new patterns
-            if new_patterns and config["ci_integration"]["fail_on_new_patterns"]:
-                logger.warning(f"⚠️ {len(new_patterns)} new log patterns detected")
-                self._report_new_patterns(new_patterns)
-            
-            # Check for security violations
-            if security_violations:
-                logger.error(f"🚨 {len(security_violations)} security-related log entries found")
-                self._report_security_violations(security_violations)
-            
-            logger.info(f"✅ Log filtering complete: {suppressed_count}/{filter_results['total_lines']} lines suppressed")
-            
-        except Exception as e:
-            logger.error(f"❌ Log filtering failed: {e}")
         
-        return filter_results
+        results["filtered_lines"] += len(kept)
+        if out is not None:
+            out.writelines(kept)
+    
+    def _finish_filter(self, filter_results: Dict, config: Dict) -> None:
+        """Save metrics and report new patterns and security violations"""
+        self._save_filter_metrics(filter_results)
+        
+        new_patterns = filter_results["new_patterns"]
+        if new_patterns and config["ci_integration"]["fail_on_new_patterns"]:
+            logger.warning(f"⚠️ {sum(filter_results['new_pattern_counts'].values())} new log patterns detected")
+            self._report_new_patterns(new_patterns)
+        
+        security_violations = filter_results["security_violations"]
+        if security_violations:
+            logger.error(f"🚨 {len(security_violations)} security-related log entries found")
+            self._report_security_violations(security_violations)
+        
+        logger.info(f"✅ Log filtering complete: {filter_results['suppressed_lines']}/{filter_results['total_lines']} lines suppressed")
     
     def validate_whitelist_patterns(self) -> Dict:
         """Validate whitelist patterns for correctness"""
@@ -328,66 +573,19 @@ class LogWhitelistManager:
         return patterns
     
     def _should_filter_line(self, line: str, whitelist_patterns: Dict[str, List[str]]) -> Tuple[bool, Optional[str]]:
-        """Check if line should be filtered based on whitelist patterns"""
-        line = line.strip()
-        
-        # Check fixed message patterns
-        for pattern in whitelist_patterns.get("fixed_faults", []):
-            if pattern in line:
-                return True, f"fixed:{pattern}"
-        
-        # Check full message patterns
-        for pattern in whitelist_patterns.get("full_faults", []):
-            if pattern in line:
-                return True, f"full:{pattern}"
-        
-        # Check regex patterns
-        for pattern in whitelist_patterns.get("regex_faults", []):
-            try:
-                if re.search(pattern, line):
-                    return True, f"regex:{pattern}"
-            except re.error:
-                logger.warning(f"Invalid regex pattern: {pattern}")
-        
-        # Check OpenSSL specific patterns
-        for category, patterns in whitelist_patterns.items():
-            if category.startswith("openssl_"):
-                for pattern in patterns:
-                    try:
-                        if re.search(pattern, line):
-                            return True, f"{category}:{pattern}"
-                    except re.error:
-                        logger.warning(f"Invalid regex pattern: {pattern}")
-        
-        return False, None
+        """Check if line should be filtered based on whitelist patterns (compiles per call; filter_logs reuses one CompiledWhitelist)"""
+        matched = CompiledWhitelist(whitelist_patterns, []).match(line)
+        return matched is not None, matched
     
     def _check_security_violations(self, line: str, config: Dict) -> bool:
         """Check if line contains security-related content that should never be whitelisted"""
-        security_patterns = config["log_whitelist"]["security_filters"]["never_whitelist"]
-        
-        for pattern in security_patterns:
-            try:
-                if re.search(pattern, line, re.IGNORECASE):
-                    return True
-            except re.error:
-                logger.warning(f"Invalid security pattern: {pattern}")
-        
-        return False
+        return CompiledWhitelist({}, config["log_whitelist"]["security_filters"]["never_whitelist"]).is_security_related(line)
     
     def _detect_new_pattern(self, line: str) -> Optional[str]:
         """Detect new log patterns that might need whitelisting"""
         # Simple pattern detection - in real implementation, this would be more sophisticated
-        line = line.strip()
-        
-        # Look for common log patterns
-        if re.match(r'^\d{4}-\d{2}-\d{2}', line):  # Timestamp
-            return "timestamp_pattern"
-        elif re.match(r'^\[.*\]', line):  # Bracket format
-            return "bracket_format"
-        elif re.match(r'^\w+:\s', line):  # Category format
-            return "category_format"
-        
-        return None
+        m = NEW_PATTERN_RE.match(line.strip())
+        return m.lastgroup if m else None
     
     def _validate_pattern(self, pattern: str, pattern_type: str) -> bool:
         """Validate a whitelist pattern"""
@@ -638,6 +836,20 @@ if __name__ == "__main__":
         for violation in security_violations:
             logger.error(f"  Line {violation['line_number']}: {violation['line']}")
 
+def _filter_log_worker(task: Tuple[Path, Path, Optional[Path]]) -> Dict:
+    """filter_logs_parallel() worker: filter one log, without saving metrics"""
+    project_root, log_file_path, output_path = task
+    lwm = LogWhitelistManager(project_root)
+    results = lwm._new_filter_results(log_file_path, output_path)
+    try:
+        with open(lwm.whitelist_config_path, 'r') as f:
+            config = yaml.safe_load(f)
+        lwm._filter_file(log_file_path, output_path, lwm._compile_whitelist(config), config, results)
+    except Exception as e:
+        logger.error(f"❌ Log filtering failed for {log_file_path}: {e}")
+        results["error"] = str(e)
+    return results
+
 def main():
     """Main entry point for log whitelist management"""
     import argparse
@@ -647,8 +859,15 @@ def main():
                        help="Project root directory")
     parser.add_argument("--action", choices=["setup", "filter", "validate", "report"],
                        required=True, help="Action to perform")
-    parser.add_argument("--input", type=Path, help="Input log file (for filter action)")
-    parser.add_argument("--output", type=Path, help="Output file (for filter action)")
+    parser.add_argument("--input", type=Path, nargs="+",
+                        help="Input log file(s) (for filter action); several are filtered in parallel")
+    parser.add_argument("--output", type=Path,
+                        help="Output file (for filter action); a directory with several inputs")
+    parser.add_argument("--jobs", type=int, help="Worker processes when filtering several inputs")
+    parser.add_argument("--follow", action="store_true",
+                        help="Keep filtering as the input grows (live build logs)")
+    parser.add_argument("--interval", type=float, default=0.5, help="Poll interval for --follow (seconds)")
+    parser.add_argument("--idle-timeout", type=float, help="Stop --follow after this many idle seconds")
     
     args = parser.parse_args()
     
@@ -657,8 +876,15 @@ def main():
     if args.action == "setup":
         lwm.setup_log_whitelist_config()
     elif args.action == "filter":
-        if args.input:
-            lwm.filter_logs(args.input, args.output)
+        if args.input and len(args.input) > 1:
+            if args.follow:
+                logger.error("--follow takes a single --input")
+            else:
+                lwm.filter_logs_parallel(args.input, args.output, max_workers=args.jobs)
+        elif args.input and args.follow:
+            lwm.follow_logs(args.input[0], args.output, poll_interval=args.interval, idle_timeout=args.idle_timeout)
+        elif args.input:
+            lwm.filter_logs(args.input[0], args.output)
         else:
             logger.error("--input argument required for filter action")
     elif args.action == "validate":
@@ -0,0 +1,310 @@
+#!/usr/bin/env python3
+"""
+Prometheus metrics for builds, caches and benchmarks.
+
+MetricsExporter gathers, on every scrape:
+
+- CI build results from an artifacts directory (StatusReporter.analyze_artifacts):
+  job counts, build time per profile and OS, artifact cache hits
+- build phase durations from build-trace.json files (BuildTrace)
+- ccache/sccache hits and misses (CacheOptimizer._get_cache_performance)
+- build cache hits, size and dedup ratio (BuildCacheManager.get_cache_stats)
+- the latest benchmark medians per benchmark and profile (PerfHistoryStore)
+
+and renders them in the Prometheus text format, served on /metrics or
+pushed to a Pushgateway:
+
+    python -m openssl_tools.monitoring.metrics_exporter --artifacts artifacts \\
+        --trace '_Build/**/build-trace.json' --perf-store test_results/perf_history.sqlite \\
+        --compiler-caches --serve 9464
+
+Each source is optional; one that fails is logged and sets
+openssl_metrics_source_up{source=...} to 0 instead of failing the scrape.
+"""
+
+import argparse
+import glob
+import json
+import logging
+import sqlite3
+import statistics
+import sys
+import threading
+import time
+import urllib.parse
+import urllib.request
+from collections import defaultdict
+from dataclasses import dataclass, field
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+from pathlib import Path
+from typing import Callable, Dict, List, Optional, Tuple
+
+logger = logging.getLogger(__name__)
+
+CONTENT_TYPE = "text/plain; version=0.0.4; charset=utf-8"
+
+Labels = Tuple[Tuple[str, str], ...]
+
+
+def _escape(value: str) -> str:
+    return str(value).replace("\\", "\\\\").replace("\n", "\\n").replace('"', '\\"')
+
+
+def _format_value(value: float) -> str:
+    if value != value:
+        return "NaN"
+    if value in (float("inf"), float("-inf")):
+        return "+Inf" if value > 0 else "-Inf"
+    return repr(float(value)) if not float(value).is_integer() else str(int(value))
+
+
+@dataclass
+class MetricFamily:
+    """One metric name with its samples"""
+    name: str
+    help: str
+    type: str = "gauge"
+    samples: Dict[Labels, float] = field(default_factory=dict)
+
+    def set(self, value: float, **labels: str) -> None:
+        self.samples[tuple(sorted((k, str(v)) for k, v in labels.items()))] = float(value)
+
+    def render(self) -> str:
+        lines = [f"# HELP {self.name} {self.help}", f"# TYPE {self.name} {self.type}"]
+        for labels, value in sorted(self.samples.items()):
+            label_text = ",".join(f'{k}="{_escape(v)}"' for k, v in labels)
+            lines.append(f"{self.name}{{{label_text}}} {_format_value(value)}" if labels
+                         else f"{self.name} {_format_value(value)}")
+        return "\n".join(lines)
+
+
+class MetricsExporter:
+    """Collects the configured metric sources into Prometheus text"""
+
+    def __init__(self, artifacts_dir: Optional[Path] = None, trace_patterns: Optional[List[str]] = None,
+                 perf_store: Optional[Path] = None, build_cache_dir: Optional[Path] = None,
+                 compiler_caches: bool = False, min_interval: float = 10.0):
+        self.artifacts_dir = artifacts_dir
+        self.trace_patterns = trace_patterns or []
+        self.perf_store = perf_store
+        self.build_cache_dir = build_cache_dir
+        self.compiler_caches = compiler_caches
+        # Scrapes closer together than this get the previous result (ccache -s is a subprocess)
+        self.min_interval = min_interval
+        self._lock = threading.Lock()
+        self._cached: Optional[Tuple[float, str]] = None
+
+    def _family(self, families: Dict[str, MetricFamily], name: str, help: str,
+                type: str = "gauge") -> MetricFamily:
+        if name not in families:
+            families[name] = MetricFamily(name, help, type)
+        return families[name]
+
+    def _sources(self) -> List[Tuple[str, Callable[[Dict[str, MetricFamily]], None]]]:
+        sources = []
+        if self.artifacts_dir:
+            sources.append(("artifacts", self.collect_artifacts))
+        if self.trace_patterns:
+            sources.append(("build_trace", self.collect_build_phases))
+        if self.compiler_caches:
+            sources.append(("compiler_cache", self.collect_compiler_caches))
+        if self.build_cache_dir:
+            sources.append(("build_cache", self.collect_build_cache))
+        if self.perf_store:
+            sources.append(("perf_history", self.collect_benchmarks))
+        return sources
+
+    def collect(self) -> Dict[str, MetricFamily]:
+        families: Dict[str, MetricFamily] = {}
+        up = self._family(families, "openssl_metrics_source_up", "Whether the metric source was readable")
+        duration = self._family(families, "openssl_metrics_source_duration_seconds", "Time taken to collect the source")
+        for name, collect in self._sources():
+            start = time.monotonic()
+            try:
+                collect(families)
+                up.set(1, source=name)
+            except Exception as e:
+                logger.warning(f"⚠️ Metrics source {name} failed: {e}")
+                up.set(0, source=name)
+            duration.set(time.monotonic() - start, source=name)
+        return families
+
+    def render(self) -> str:
+        with self._lock:
+            now = time.monotonic()
+            if self._cached and now - self._cached[0] < self.min_interval:
+                return self._cached[1]
+            text = "\n".join(f.render() for f in self.collect().values() if f.samples) + "\n"
+            self._cached = (now, text)
+            return text
+
+    def collect_artifacts(self, families: Dict[str, MetricFamily]) -> None:
+        from .status_reporter import StatusReporter
+        results = StatusReporter.analyze_artifacts(str(self.artifacts_dir))
+        jobs = self._family(families, "openssl_ci_jobs", "CI build jobs in the artifacts directory by result")
+        jobs.set(results["successful_jobs"], status="success")
+        jobs.set(results["failed_jobs"], status="failed")
+        build_time = self._family(families, "openssl_ci_build_duration_seconds", "Build time per profile and OS")
+        cache_hit = self._family(families, "openssl_ci_cache_hit", "Whether the job's build came from cache")
+        for build in results["builds"]:
+            build_time.set(build["build_time"], profile=build["profile"], os=build["os"])
+            cache_hit.set(int(bool(build["cache_hit"])), profile=build["profile"], os=build["os"])
+        performance = results["performance"]
+        lookups = performance["cache_hits"] + performance["cache_misses"]
+        if lookups:
+            self._family(families, "openssl_ci_cache_hit_ratio", "Share of CI jobs served from cache").set(
+                performance["cache_hits"] / lookups)
+
+    def collect_build_phases(self, families: Dict[str, MetricFamily]) -> None:
+        phases = self._family(families, "openssl_build_phase_duration_seconds",
+                              "Time spent per build phase, summed over each build-trace.json")
+        last_run = self._family(families, "openssl_build_trace_timestamp_seconds",
+                                "Modification time of the build trace")
+        for pattern in self.trace_patterns:
+            for path in sorted(glob.glob(pattern, recursive=True)):
+                with open(path) as f:
+                    events = json.load(f).get("traceEvents", [])
+                names = {e["pid"]: e["args"]["name"].rsplit(" (", 1)[0] for e in events
+                         if e.get("ph") == "M" and e.get("name") == "process_name"}
+                totals: Dict[Tuple[str, str], float] = defaultdict(float)
+                for event in events:
+                    if event.get("ph") == "X" and event.get("cat") == "build":
+                        totals[(names.get(event.get("pid"), "build"), event["name"])] += event["dur"] / 1e6
+                for (build, phase), seconds in totals.items():
+                    phases.set(seconds, build=build, phase=phase, trace=path)
+                last_run.set(Path(path).stat().st_mtime, trace=path)
+
+    def collect_compiler_caches(self, families: Dict[str, MetricFamily]) -> None:
+        from openssl_tools.development.build_system.cache_optimization import CacheOptimizer
+        performance = CacheOptimizer()._get_cache_performance()
+        hits = self._family(families, "openssl_compiler_cache_hits_total", "Compiler cache hits", "counter")
+        misses = self._family(families, "openssl_compiler_cache_misses_total", "Compiler cache misses", "counter")
+        ratio = self._family(families, "openssl_compiler_cache_hit_ratio", "Compiler cache hit rate")
+        for cache, stats in performance.items():
+            if "hits" in stats:
+                hits.set(stats["hits"], cache=cache)
+                misses.set(stats["misses"], cache=cache)
+                ratio.set(stats["hit_rate"], cache=cache)
+
+    def collect_build_cache(self, families: Dict[str, MetricFamily]) -> None:
+        from openssl_tools.development.build_system.optimizer import BuildCacheManager
+        stats = BuildCacheManager(self.build_cache_dir).get_cache_stats()
+        gib = 1024 ** 3
+        for name, description, value, kind in (
+                ("openssl_build_cache_hits_total", "Build cache hits", stats["cache_hits"], "counter"),
+                ("openssl_build_cache_misses_total", "Build cache misses", stats["cache_misses"], "counter"),
+                ("openssl_build_cache_hit_ratio", "Build cache hit rate", stats["hit_rate"], "gauge"),
+                ("openssl_build_cache_size_bytes", "Stored size of the build cache", stats["cache_size_gb"] * gib, "gauge"),
+                ("openssl_build_cache_logical_bytes", "Size of the cached builds before deduplication",
+                 stats["logical_size_gb"] * gib, "gauge"),
+                ("openssl_build_cache_dedup_ratio", "Logical over stored size", stats["dedup_ratio"], "gauge"),
+                ("openssl_build_cache_entries", "Cached builds", stats["cached_builds"], "gauge"),
+                ("openssl_build_cache_rebuild_minutes_saved", "Rebuild minutes saved by hits on cached builds",
+                 stats["rebuild_minutes_saved"], "gauge")):
+            self._family(families, name, description, kind).set(value, cache=str(self.build_cache_dir))
+
+    def collect_benchmarks(self, families: Dict[str, MetricFamily]) -> None:
+        # Read-only: the exporter must not create or lock the store
+        db = sqlite3.connect(f"file:{self.perf_store}?mode=ro", uri=True)
+        try:
+            runs = db.execute(
+                "SELECT id, benchmark, profile, higher_is_better, timestamp FROM runs WHERE id IN "
+                "(SELECT MAX(id) FROM runs GROUP BY benchmark, profile)").fetchall()
+            throughput = self._family(families, "openssl_benchmark_throughput",
+                                      "Median of the latest run per benchmark and profile (higher is better)")
+            latency = self._family(families, "openssl_benchmark_latency",
+                                   "Median of the latest run per benchmark and profile (lower is better)")
+            run_time = self._family(families, "openssl_benchmark_run_timestamp_seconds",
+                                    "When the latest run per benchmark and profile was recorded")
+            for run_id, benchmark, profile, higher_is_better, timestamp in runs:
+                values: Dict[str, List[float]] = defaultdict(list)
+                for metric, value in db.execute("SELECT metric, value FROM samples WHERE run_id = ?", (run_id,)):
+                    values[metric].append(value)
+                family = throughput if higher_is_better else latency
+                for metric, samples in values.items():
+                    # binsize: totals and sections only, not one series per symbol
+                    if benchmark == "binsize" and metric.split("/")[1] not in ("total", "section"):
+                        continue
+                    family.set(statistics.median(samples), benchmark=benchmark, profile=profile, metric=metric)
+                run_time.set(time.mktime(time.strptime(timestamp[:19], "%Y-%m-%dT%H:%M:%S")),
+                             benchmark=benchmark, profile=profile)
+        finally:
+            db.close()
+
+    def serve(self, port: int, address: str = "") -> ThreadingHTTPServer:
+        """Serve /metrics until interrupted"""
+        exporter = self
+
+        class Handler(BaseHTTPRequestHandler):
+            def do_GET(self):
+                if self.path.split("?")[0] != "/metrics":
+                    self.send_error(404, "Metrics are at /metrics")
+                    return
+                body = exporter.render().encode()
+                self.send_response(200)
+                self.send_header("Content-Type", CONTENT_TYPE)
+                self.send_header("Content-Length", str(len(body)))
+                self.end_headers()
+                self.wfile.write(body)
+
+            def log_message(self, format, *args):
+                logger.debug(format % args)
+
+        server = ThreadingHTTPServer((address, port), Handler)
+        logger.info(f"📈 Serving metrics on http://{address or '0.0.0.0'}:{server.server_port}/metrics")
+        return server
+
+    def push(self, gateway: str, job: str = "openssl-build", instance: Optional[str] = None,
+             timeout: float = 30) -> None:
+        """Replace this job's metrics on a Prometheus Pushgateway"""
+        url = f"{gateway.rstrip('/')}/metrics/job/{urllib.parse.quote(job, safe='')}"
+        if instance:
+            url += f"/instance/{urllib.parse.quote(instance, safe='')}"
+        self._cached = None
+        request = urllib.request.Request(url, data=self.render().encode(), method="PUT",
+                                         headers={"Content-Type": CONTENT_TYPE})
+        with urllib.request.urlopen(request, timeout=timeout) as response:
+            logger.info(f"📤 Pushed metrics to {url} ({response.status})")
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(description="Export build, cache and benchmark metrics to Prometheus")
+    parser.add_argument("--artifacts", type=Path, help="CI artifacts directory (openssl-<profile>-<os>/performance_report.json)")
+    parser.add_argument("--trace", action="append", default=[], help="build-trace.json files, glob (repeatable)")
+    parser.add_argument("--perf-store", type=Path, help="Performance history database")
+    parser.add_argument("--build-cache", type=Path, help="BuildCacheManager cache directory")
+    parser.add_argument("--compiler-caches", action="store_true", help="Include ccache/sccache statistics")
+    parser.add_argument("--min-interval", type=float, default=10.0, help="Seconds a collected result is reused")
+    output = parser.add_mutually_exclusive_group()
+    output.add_argument("--serve", type=int, metavar="PORT", help="Serve /metrics on this port")
+    output.add_argument("--push", metavar="URL", help="Push once to this Pushgateway")
+    parser.add_argument("--address", default="", help="Address to serve on")
+    parser.add_argument("--job", default="openssl-build", help="Pushgateway job name")
+    parser.add_argument("--instance", help="Pushgateway instance label")
+    args = parser.parse_args()
+
+    logging.basicConfig(level=logging.INFO, format="%(message)s")
+    exporter = MetricsExporter(args.artifacts, args.trace, args.perf_store, args.build_cache,
+                               args.compiler_caches, args.min_interval)
+    if args.serve is not None:
+        server = exporter.serve(args.serve, args.address)
+        try:
+            server.serve_forever()
+        except KeyboardInterrupt:
+            pass
+        finally:
+            server.server_close()
+        return 0
+    if args.push:
+        try:
+            exporter.push(args.push, args.job, args.instance)
+        except OSError as e:
+            logger.error(f"❌ Push to {args.push} failed: {e}")
+            return 1
+        return 0
+    sys.stdout.write(exporter.render())
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -6,6 +6,10 @@ Reports build results back to the OpenSSL repository using GitHub APIs:
 - Commit Status API for status checks
 - Check Runs API for detailed reports
 - PR Comments for formatted results
+
+Artifact sizes come from the res/sparetools-artifacts.json manifest each
+package writes (copied into the CI artifact as is), so reporting never
+walks or opens the artifact files themselves.
 """
 
 import argparse
@@ -17,6 +21,12 @@ from typing import Dict, List, Any, Optional
 from github import Github
 from github.GithubException import GithubException
 
+try:
+    from openssl_tools.artifact_manifest import load_manifest, summarize
+except ImportError:  # Run as a script without openssl_tools installed
+    def load_manifest(folder):
+        return None
+
 
 class StatusReporter:
     """Reports build status back to OpenSSL repository."""
@@ -27,8 +37,9 @@ class StatusReporter:
         self.max_retries = max_retries
         self.retry_delay = retry_delay
     
-    def analyze_artifacts(self, artifacts_dir: str) -> Dict[str, Any]:
-        """Analyze build artifacts and generate summary."""
+    @staticmethod
+    def analyze_artifacts(artifacts_dir: str) -> Dict[str, Any]:
+        """Analyze build artifacts and generate summary (needs no GitHub access)."""
         results = {
             'total_jobs': 0,
             'successful_jobs': 0,
@@ -39,7 +50,8 @@ class StatusReporter:
                 'average_build_time': 0,
                 'cache_hits': 0,
                 'cache_misses': 0
-            }
+            },
+            'artifacts': {'files': 0, 'bytes': 0, 'by_kind': {}, 'manifests': 0}
         }
         
         if not os.path.exists(artifacts_dir):
@@ -78,6 +90,20 @@ class StatusReporter:
                         'packages': perf_data.get('packages', 0)
                     }
                     
+                    # Package contents from its manifest, not from the files
+                    manifest = load_manifest(item_path)
+                    if manifest is not None:
+                        summary = summarize(manifest)
+                        build_info['artifacts'] = summary
+                        totals = results['artifacts']
+                        totals['manifests'] += 1
+                        totals['files'] += summary['files']
+                        totals['bytes'] += summary['bytes']
+                        for kind, counts in summary['by_kind'].items():
+                            total = totals['by_kind'].setdefault(kind, {'files': 0, 'bytes': 0})
+                            total['files'] += counts['files']
+                            total['bytes'] += counts['bytes']
+                    
                     results['builds'].append(build_info)
                     results['total_jobs'] += 1
                     
@@ -254,6 +280,14 @@ class StatusReporter:
         text += f"- **Cache Hits**: {results['performance']['cache_hits']}\n"
         text += f"- **Cache Misses**: {results['performance']['cache_misses']}\n"
         
+        artifacts = results.get('artifacts', {})
+        if artifacts.get('manifests'):
+            text += "\n## Package Contents\n\n"
+            text += f"{artifacts['files']} files, {artifacts['bytes'] / 1e6:.1f} MB in {artifacts['manifests']} packages\n\n"
+            text += "| Kind | Files | Size |\n|------|-------|------|\n"
+            for kind, counts in sorted(artifacts['by_kind'].items(), key=lambda item: -item[1]['bytes']):
+                text += f"| {kind} | {counts['files']} | {counts['bytes'] / 1e6:.1f} MB |\n"
+        
         return text
     
     def create_pr_comment(self, repo_name: str, pr_number: int, results: Dict[str, Any]) -> str:
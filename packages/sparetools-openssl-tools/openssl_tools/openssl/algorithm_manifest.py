@@ -0,0 +1,198 @@
+"""Algorithm usage manifests for pruned OpenSSL builds.
+
+A manifest lists the algorithm names a consumer actually uses, as passed
+to EVP_*_fetch() ("SHA256", "AES-256-GCM", "X25519", ...). Every optional
+OpenSSL feature that none of those names needs becomes a ``no-<feature>``
+Configure flag, and the matching provider sources are excluded from
+ProviderOrderer. Features OpenSSL cannot build without (AES, SHA, HMAC,
+DRBG, RSA) are never disabled.
+
+Manifests are JSON (``{"algorithms": [...], "keep": [...]}``) or plain text
+with one name per line. ``scan`` produces one from a consumer's sources by
+collecting fetch names and EVP_<alg>() calls.
+"""
+
+from __future__ import annotations
+
+import json
+import logging
+import re
+from pathlib import Path
+from typing import Dict, Iterable, List, Set
+
+LOG = logging.getLogger(__name__)
+
+# Optional Configure features and the algorithm names that need them,
+# matched against upper-case names with "_" normalized to "-".
+FEATURES: Dict[str, str] = {
+    "aria": r"^ARIA",
+    "bf": r"^(BF|BLOWFISH)\b",
+    "blake2": r"^BLAKE2",
+    "camellia": r"^CAMELLIA",
+    "cast": r"^CAST",
+    "chacha": r"CHACHA20",
+    "cmac": r"^CMAC$",
+    "des": r"^(DES|3DES|DESX)\b|^DES-",
+    "dh": r"^(DH|DHX|FFDHE\d*)$",
+    "dsa": r"^DSA",
+    "ec": r"^(EC|ECDSA|ECDH|SM2|X25519|X448|ED25519|ED448|P-(256|384|521)|PRIME\d+V\d|SECP\d+)",
+    "ec2m": r"^(SECT\d+|C2PNB|C2TNB|B-\d+|K-\d+)",
+    "ecx": r"^(X25519|X448|ED25519|ED448)$",
+    "idea": r"^IDEA",
+    "md4": r"^MD4$",
+    "mdc2": r"^MDC2$",
+    "ocb": r"-OCB$",
+    "poly1305": r"POLY1305",
+    "rc2": r"^RC2",
+    "rc4": r"^RC4",
+    "rc5": r"^RC5",
+    "rmd160": r"^(RIPEMD|RMD)160$|^RIPEMD",
+    "scrypt": r"^(ID-)?SCRYPT$",
+    "seed": r"^SEED",
+    "siphash": r"^SIPHASH$",
+    "siv": r"-SIV$",
+    "sm2": r"^SM2$",
+    "sm3": r"^SM3$",
+    "sm4": r"^SM4",
+    "whirlpool": r"^WHIRLPOOL$",
+}
+
+# Features that a kept feature cannot be built without
+REQUIRES: Dict[str, List[str]] = {
+    "ecx": ["ec"],
+    "ec2m": ["ec"],
+    "sm2": ["ec", "sm3"],
+}
+
+# ProviderOrderer matches excluded algorithms as substrings of source file
+# names; only tokens that cannot hit an unrelated file are listed (dsa/dh/ec
+# would also match ecdsa_sig.c / ecdh_exch.c).
+PROVIDER_TOKENS: Dict[str, str] = {
+    "aria": "aria",
+    "bf": "blowfish",
+    "blake2": "blake2",
+    "camellia": "camellia",
+    "cast": "cast",
+    "chacha": "chacha",
+    "cmac": "cmac_prov",
+    "des": "des",
+    "idea": "idea",
+    "md4": "md4",
+    "mdc2": "mdc2",
+    "ocb": "ocb",
+    "poly1305": "poly1305",
+    "rc2": "rc2",
+    "rc4": "rc4",
+    "rc5": "rc5",
+    "rmd160": "ripemd",
+    "scrypt": "scrypt",
+    "seed": "seed",
+    "siphash": "siphash",
+    "siv": "siv",
+    "sm3": "sm3",
+    "sm4": "sm4",
+    "whirlpool": "wp_prov",
+}
+
+_FETCH = re.compile(r'EVP_[A-Z_]+_fetch\s*\([^,]*,\s*"([^"]+)"')
+_BY_NAME = re.compile(r'EVP_get_(?:digest|cipher)byname\s*\(\s*"([^"]+)"')
+_IMPLICIT = re.compile(r'\bEVP_((?:aes|aria|bf|blake2|camellia|cast5|chacha20|des|idea|md4|md5|mdc2|rc2|rc4|rc5|'
+                       r'ripemd160|seed|sha1|sha224|sha256|sha384|sha512|sha3|shake|sm3|sm4|whirlpool)[a-z0-9_]*)\s*\(')
+_PKEY = re.compile(r'EVP_PKEY_CTX_new_from_name\s*\([^,]*,\s*"([^"]+)"|EVP_PKEY_Q_keygen\s*\([^,]*,[^,]*,\s*"([^"]+)"')
+
+
+def normalize(name: str) -> str:
+    return name.strip().upper().replace("_", "-")
+
+
+def load_manifest(path: Path) -> Dict[str, Set[str]]:
+    """{"algorithms": names, "keep": features} from a JSON or text manifest"""
+    text = Path(path).read_text(encoding="utf-8")
+    if text.lstrip().startswith(("{", "[")):
+        data = json.loads(text)
+        if isinstance(data, list):
+            data = {"algorithms": data}
+    else:
+        lines = [line.split("#", 1)[0].strip() for line in text.splitlines()]
+        data = {"algorithms": [line for line in lines if line]}
+    return {
+        "algorithms": {normalize(n) for n in data.get("algorithms", [])},
+        "keep": {str(f).lower() for f in data.get("keep", [])},
+    }
+
+
+def needed_features(algorithms: Iterable[str], keep: Iterable[str] = ()) -> Set[str]:
+    """Optional features required by the algorithm names, plus their dependencies"""
+    needed = {f for f in keep if f in FEATURES}
+    for name in algorithms:
+        name = normalize(name)
+        needed.update(f for f, pattern in FEATURES.items() if re.search(pattern, name))
+    pending = list(needed)
+    while pending:
+        for dep in REQUIRES.get(pending.pop(), []):
+            if dep not in needed:
+                needed.add(dep)
+                pending.append(dep)
+    return needed
+
+
+def disabled_features(algorithms: Iterable[str], keep: Iterable[str] = ()) -> List[str]:
+    """Optional features nothing in the manifest needs, sorted"""
+    needed = needed_features(algorithms, keep)
+    return sorted(f for f in FEATURES if f not in needed)
+
+
+def configure_flags(manifest: Dict[str, Set[str]]) -> List[str]:
+    """no-<feature> flags for Configure / configure.py"""
+    return [f"no-{f}" for f in disabled_features(manifest["algorithms"], manifest["keep"])]
+
+
+def excluded_algorithms(manifest: Dict[str, Set[str]]) -> Set[str]:
+    """ProviderOrderer(excluded_algorithms=...) for the disabled features"""
+    return {PROVIDER_TOKENS[f] for f in disabled_features(manifest["algorithms"], manifest["keep"])
+            if f in PROVIDER_TOKENS}
+
+
+def scan_sources(paths: Iterable[Path]) -> Set[str]:
+    """Algorithm names fetched or called by name in C/C++ sources under paths"""
+    found: Set[str] = set()
+    for root in paths:
+        root = Path(root)
+        files = [root] if root.is_file() else [p for p in root.rglob("*")
+                                               if p.suffix in (".c", ".cc", ".cpp", ".cxx", ".h", ".hpp")]
+        for path in files:
+            try:
+                text = path.read_text(encoding="utf-8", errors="replace")
+            except OSError:
+                continue
+            for regex in (_FETCH, _BY_NAME):
+                found.update(normalize(m) for m in regex.findall(text))
+            found.update(normalize(m) for m in _IMPLICIT.findall(text))
+            for groups in _PKEY.findall(text):
+                found.update(normalize(g) for g in groups if g)
+    return found
+
+
+def main() -> int:
+    import argparse
+
+    parser = argparse.ArgumentParser(description="OpenSSL algorithm usage manifests")
+    sub = parser.add_subparsers(dest="command", required=True)
+    scan = sub.add_parser("scan", help="Write a manifest from EVP fetch names in sources")
+    scan.add_argument("paths", nargs="+", type=Path)
+    scan.add_argument("-o", "--output", type=Path, default=Path("algorithm-manifest.json"))
+    flags = sub.add_parser("flags", help="Print the Configure flags for a manifest")
+    flags.add_argument("manifest", type=Path)
+    args = parser.parse_args()
+
+    if args.command == "scan":
+        algorithms = sorted(scan_sources(args.paths))
+        args.output.write_text(json.dumps({"algorithms": algorithms, "keep": []}, indent=2) + "\n")
+        print(f"{len(algorithms)} algorithms -> {args.output}")
+    else:
+        print(" ".join(configure_flags(load_manifest(args.manifest))))
+    return 0
+
+
+if __name__ == "__main__":
+    raise SystemExit(main())
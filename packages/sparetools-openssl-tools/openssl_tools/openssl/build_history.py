@@ -0,0 +1,94 @@
+#!/usr/bin/env python3
+"""
+Build history for cost-aware matrix selection
+
+Collects, per matrix job name (remote_executor.job_name), what earlier
+runs cost and how often they failed:
+
+- durations: the median duration_seconds of the build-summary-*.json
+  files (build_scheduler.load_build_durations)
+- outcomes: the same files' `success` flag (build_scheduler) or final
+  `status` (remote_executor); "running" summaries are ignored
+- optionally the FailureIndex SQLite database EcosystemMonitor keeps for
+  the CI workflows it watches. It only records failures, so each indexed
+  failure of a job name counts as one more failed run.
+
+SmartBuildMatrix turns this into expected defects found per
+builder-minute when a matrix has to be cut down.
+"""
+
+import json
+import sqlite3
+import statistics
+from dataclasses import dataclass, field
+from pathlib import Path
+from typing import Dict, Iterable, Optional
+
+
+@dataclass
+class BuildHistory:
+    """Median duration and pass/fail counts per job name"""
+    durations: Dict[str, float] = field(default_factory=dict)
+    runs: Dict[str, int] = field(default_factory=dict)
+    failures: Dict[str, int] = field(default_factory=dict)
+
+    @classmethod
+    def load(cls, log_dirs: Iterable[Path], failure_index: Optional[Path] = None) -> "BuildHistory":
+        # Deferred: the development package pulls in the GitHub client
+        from ..development.build_system.build_scheduler import load_build_durations
+
+        log_dirs = [Path(d) for d in log_dirs]
+        history = cls(durations=load_build_durations(log_dirs))
+        for log_dir in log_dirs:
+            if not log_dir.is_dir():
+                continue
+            for path in log_dir.glob("build-summary-*.json"):
+                try:
+                    data = json.loads(path.read_text(encoding="utf-8"))
+                except (OSError, json.JSONDecodeError):
+                    continue
+                name = data.get("job_name")
+                if "success" in data:
+                    failed = not data["success"]
+                elif data.get("status") in ("success", "failed"):
+                    failed = data["status"] == "failed"
+                else:
+                    continue
+                if name:
+                    history.record(name, failed)
+        if failure_index is not None and Path(failure_index).is_file():
+            history.merge_failure_index(Path(failure_index))
+        return history
+
+    def record(self, name: str, failed: bool, count: int = 1) -> None:
+        self.runs[name] = self.runs.get(name, 0) + count
+        if failed:
+            self.failures[name] = self.failures.get(name, 0) + count
+
+    def merge_failure_index(self, path: Path) -> None:
+        """Add EcosystemMonitor's indexed failures, grouped by job name"""
+        conn = sqlite3.connect(f"file:{path}?mode=ro", uri=True)
+        try:
+            rows = conn.execute("SELECT job_name, COUNT(*) FROM failures GROUP BY job_name").fetchall()
+        except sqlite3.Error:
+            rows = []
+        finally:
+            conn.close()
+        for name, count in rows:
+            if name:
+                self.record(name, True, count)
+
+    def __bool__(self) -> bool:
+        return bool(self.durations or self.runs)
+
+    def failure_rate(self, name: str) -> float:
+        """Laplace-smoothed failure probability; 0.5 for a job never seen"""
+        return (self.failures.get(name, 0) + 1) / (self.runs.get(name, 0) + 2)
+
+    def duration_minutes(self, name: str) -> Optional[float]:
+        seconds = self.durations.get(name)
+        return seconds / 60 if seconds else None
+
+    def typical_minutes(self) -> Optional[float]:
+        """Median over all jobs, the cost assumed for a job without history"""
+        return statistics.median(self.durations.values()) / 60 if self.durations else None
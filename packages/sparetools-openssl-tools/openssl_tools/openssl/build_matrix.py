@@ -7,12 +7,14 @@ optimizing for 60-75% CI time reduction through strategic matrix reduction.
 """
 
 import json
-import os
 from pathlib import Path
 from typing import Dict, List, Optional, Set, Tuple, Any
 from dataclasses import dataclass, asdict
 from enum import Enum
 
+from .build_history import BuildHistory
+from ..config_snapshot import load_config
+
 
 class BuildType(Enum):
     """OpenSSL build configuration types."""
@@ -72,14 +74,17 @@ class SmartBuildMatrix:
     build matrices that reduce CI time by 60-75% while maintaining coverage.
     """
 
-    def __init__(self, config_file: Optional[str] = None):
+    def __init__(self, config_file: Optional[str] = None, history: Optional[BuildHistory] = None):
         """
         Initialize the Smart Build Matrix.
 
         Args:
             config_file: Path to configuration file for matrix generation
+            history: Durations and failure rates of earlier runs (BuildHistory);
+                with it, subsets are chosen per builder-minute within a time budget
         """
         self.config_file = config_file or self._find_default_config()
+        self.history = history
         self.base_configurations = self._load_base_configurations()
         self.optimization_rules = self._load_optimization_rules()
 
@@ -116,12 +121,10 @@ class SmartBuildMatrix:
 
     def _load_base_configurations(self) -> List[BuildConfiguration]:
         """Load base build configurations from config file."""
-        if not os.path.exists(self.config_file):
+        config = load_config(self.config_file)
+        if config is None:
             return self._get_default_configurations()
 
-        with open(self.config_file, 'r') as f:
-            config = json.load(f)
-
         configurations = []
         for platform in config.get('platforms', ['linux']):
             for compiler in config.get('compilers', ['gcc']):
@@ -198,28 +201,34 @@ class SmartBuildMatrix:
                 "remove_redundant_builds": True,
                 "prioritize_critical_paths": True,
                 "skip_unnecessary_combinations": True,
-                "max_matrix_size": 8
+                "max_matrix_size": 8,
+                "time_budget_minutes": 120
             },
             "medium": {
                 "remove_redundant_builds": True,
                 "prioritize_critical_paths": False,
                 "skip_unnecessary_combinations": True,
-                "max_matrix_size": 12
+                "max_matrix_size": 12,
+                "time_budget_minutes": 240
             },
             "low": {
                 "remove_redundant_builds": False,
                 "prioritize_critical_paths": False,
                 "skip_unnecessary_combinations": False,
-                "max_matrix_size": 20
+                "max_matrix_size": 20,
+                "time_budget_minutes": None
             }
         }
 
-    def generate_matrix(self, optimization_level: str = "high") -> List[BuildConfiguration]:
+    def generate_matrix(self, optimization_level: str = "high",
+                        time_budget_minutes: Optional[float] = None) -> List[BuildConfiguration]:
         """
         Generate an optimized build matrix.
 
         Args:
             optimization_level: Level of optimization ("high", "medium", "low")
+            time_budget_minutes: Total builder-minutes the matrix may take;
+                overrides the level's budget (only applied with history)
 
         Returns:
             List of optimized build configurations
@@ -239,9 +248,12 @@ class SmartBuildMatrix:
         if rules["skip_unnecessary_combinations"]:
             matrix = self._skip_unnecessary_combinations(matrix)
 
-        # Limit matrix size
+        # Limit matrix size, and with history its builder-minutes
         max_size = rules["max_matrix_size"]
-        if len(matrix) > max_size:
+        budget = time_budget_minutes if time_budget_minutes is not None else rules["time_budget_minutes"]
+        if self.history and budget is not None:
+            matrix = self._select_within_budget(matrix, max_size, budget)
+        elif len(matrix) > max_size:
             matrix = self._select_optimal_subset(matrix, max_size)
 
         return matrix
@@ -306,6 +318,36 @@ class SmartBuildMatrix:
         scored.sort(key=lambda x: x[0], reverse=True)
         return [config for _, config in scored[:max_size]]
 
+    def _select_within_budget(self, matrix: List[BuildConfiguration], max_size: int,
+                              budget_minutes: float) -> List[BuildConfiguration]:
+        """
+        Greedy knapsack over expected defect detection per builder-minute:
+        configurations are taken in order of value/cost while they fit the
+        budget, up to max_size. The best one is always kept, so a budget
+        below any single build still yields a matrix.
+        """
+        from .remote_executor import job_name
+
+        fallback = self.history.typical_minutes() or 1.0
+        candidates = []
+        for index, config in enumerate(matrix):
+            name = job_name(config)
+            value = self._calculate_configuration_score(config) * self.history.failure_rate(name)
+            cost = self.history.duration_minutes(name) or fallback
+            candidates.append((value / cost, index, cost, config))
+        candidates.sort(key=lambda c: (-c[0], c[1]))
+
+        selected, spent = [], 0.0
+        for _, index, cost, config in candidates:
+            if len(selected) >= max_size:
+                break
+            if selected and spent + cost > budget_minutes:
+                continue
+            selected.append((index, config))
+            spent += cost
+        # Keep the order the earlier passes established
+        return [config for _, config in sorted(selected, key=lambda s: s[0])]
+
     def _calculate_configuration_score(self, config: BuildConfiguration) -> float:
         """Calculate importance score for a build configuration."""
         score = 0.0
@@ -343,23 +385,46 @@ class SmartBuildMatrix:
 
         return score
 
-    def generate_github_actions_matrix(self, optimization_level: str = "high") -> str:
+    def generate_github_actions_matrix(self, optimization_level: str = "high",
+                                       time_budget_minutes: Optional[float] = None,
+                                       test_shards: int = 1,
+                                       test_durations: Optional[Dict[str, float]] = None) -> str:
         """
         Generate GitHub Actions build matrix in JSON format.
 
         Args:
             optimization_level: Optimization level for matrix generation
+            time_budget_minutes: Builder-minute budget (see generate_matrix)
+            test_shards: Split each configuration's `make test` into this many
+                shards (testing.test_sharding), balanced on test_durations
+            test_durations: Seconds per test recipe in earlier runs
+                (test_sharding.load_recipe_durations)
 
         Returns:
-            JSON string representing the GitHub Actions matrix
+            JSON string representing the GitHub Actions matrix. With
+            test_shards > 1, sharded build entries carry `test_artifact`:
+            build with run_tests=full and user.sparetools:defer_tests=True
+            and upload the deferred test bundle under that name. The
+            "test_shards" matrix then has one entry per configuration and
+            shard, for jobs that download the artifact and run
+            `deferred-tests --tests="${{ matrix.tests }}"` instead of
+            rebuilding. Windows entries keep running their tests in the
+            build job (deferred bundles run POSIX test trees only).
         """
-        matrix = self.generate_matrix(optimization_level)
+        from .remote_executor import job_name
+
+        matrix = self.generate_matrix(optimization_level, time_budget_minutes)
 
         # Convert to GitHub Actions format
         github_matrix = {
             "include": []
         }
+        shards = []
+        if test_shards > 1:
+            from ..testing.test_sharding import shard_tests
+            shards = shard_tests(test_durations or {}, test_shards)
 
+        shard_entries = []
         for config in matrix:
             entry = {
                 "platform": config.platform.value,
@@ -371,8 +436,16 @@ class SmartBuildMatrix:
                 "shared_libs": config.shared_libs,
                 "threads_enabled": config.threads_enabled
             }
+            if len(shards) > 1 and config.platform != Platform.WINDOWS:
+                entry["test_artifact"] = f"deferred-tests-{job_name(config)}"
+                for shard in shards:
+                    shard_entries.append(dict(entry, shard=f"{shard.index + 1}/{shard.count}",
+                                              tests=shard.tests_arg,
+                                              expected_seconds=round(shard.expected_seconds, 1)))
             github_matrix["include"].append(entry)
 
+        if shard_entries:
+            github_matrix["test_shards"] = {"include": shard_entries}
         return json.dumps(github_matrix, indent=2)
 
     def save_matrix_to_file(self, output_path: str, optimization_level: str = "high") -> None:
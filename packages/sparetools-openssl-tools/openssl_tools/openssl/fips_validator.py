@@ -4,12 +4,19 @@ FIPS Compliance Validator for OpenSSL
 
 This module provides automated FIPS 140-2/140-3 compliance validation
 for OpenSSL builds and configurations.
+
+Provider, algorithm and self-test checks run in-process through the
+sparetools_fips_check helper (shipped in bin/ of fips=True packages) when
+it is available: one process loads the FIPS provider once, records every
+power-on self-test and exercises the approved algorithms, instead of one
+openssl CLI launch per check. Without the helper the CLI checks are used.
 """
 
 import hashlib
 import json
 import os
 import re
+import shutil
 import subprocess
 import tempfile
 from pathlib import Path
@@ -87,17 +94,42 @@ class FIPSValidator:
         "DRBG": {"mechanisms": ["CTR_DRBG", "HMAC_DRBG", "HASH_DRBG"]}
     }
 
-    def __init__(self, openssl_path: Optional[str] = None, fips_level: FIPSLevel = FIPSLevel.FIPS_140_3):
+    HELPER_NAME = "sparetools_fips_check"
+
+    def __init__(self, openssl_path: Optional[str] = None, fips_level: FIPSLevel = FIPSLevel.FIPS_140_3,
+                 backend: str = "auto", helper_path: Optional[str] = None,
+                 openssl_config: Optional[str] = None, module_dir: Optional[str] = None):
         """
         Initialize the FIPS validator.
 
         Args:
             openssl_path: Path to OpenSSL executable
             fips_level: FIPS compliance level to validate against
+            backend: "helper" (sparetools_fips_check), "cli" (openssl
+                subprocesses) or "auto" (helper when found, else CLI)
+            helper_path: Path to sparetools_fips_check; looked up next to
+                openssl_path and in PATH when omitted
+            openssl_config: openssl.cnf that activates the FIPS provider
+                (passed to the helper as --config)
+            module_dir: Directory holding fips.so (the helper's --module-dir)
         """
-        self.openssl_path = openssl_path or self._find_openssl()
+        if backend not in ("auto", "helper", "cli"):
+            raise ValueError(f"backend must be auto, helper or cli, not {backend}")
+        if openssl_path and not (os.path.isfile(openssl_path) or shutil.which(openssl_path)):
+            raise FileNotFoundError(f"OpenSSL executable not found: {openssl_path}")
         self.fips_level = fips_level
+        self.openssl_config = openssl_config
+        self.module_dir = module_dir
+        self.helper_path = None if backend == "cli" else (helper_path or self._find_helper(openssl_path))
+        if backend == "helper" and self.helper_path is None:
+            raise FileNotFoundError(f"{self.HELPER_NAME} not found")
+        if self.helper_path and not openssl_path:
+            # Only the CLI checks need it, see _openssl()
+            self.openssl_path = shutil.which("openssl")
+        else:
+            self.openssl_path = openssl_path or self._find_openssl()
         self.validation_cache: Dict[str, ValidationResult] = {}
+        self._helper_result: Optional[Dict[str, Any]] = None
 
     def _find_openssl(self) -> str:
         """Find OpenSSL executable in PATH."""
@@ -114,6 +146,61 @@ class FIPSValidator:
 
         raise FileNotFoundError("OpenSSL executable not found")
 
+    def _openssl(self) -> str:
+        """The openssl executable for a CLI check"""
+        if not self.openssl_path:
+            raise FileNotFoundError("OpenSSL executable not found in PATH; pass openssl_path for the CLI checks")
+        return self.openssl_path
+
+    def _find_helper(self, openssl_path: Optional[str]) -> Optional[str]:
+        """sparetools_fips_check next to the openssl executable, else in PATH"""
+        if openssl_path:
+            candidate = Path(openssl_path).resolve().parent / self.HELPER_NAME
+            for path in (candidate, candidate.with_suffix(".exe")):
+                if path.is_file() and os.access(path, os.X_OK):
+                    return str(path)
+        return shutil.which(self.HELPER_NAME)
+
+    def _helper_report(self) -> Dict[str, Any]:
+        """
+        The helper's JSON report, run once per validator. A helper that
+        cannot run yields {"error": ...} so the dependent checks fail
+        rather than silently falling back.
+        """
+        if self._helper_result is None:
+            cmd = [self.helper_path]
+            if self.openssl_config:
+                cmd += ["--config", self.openssl_config]
+            if self.module_dir:
+                cmd += ["--module-dir", self.module_dir]
+            try:
+                # Exit status 1 only means a check failed; the report is still complete
+                result = subprocess.run(cmd, capture_output=True, text=True, timeout=120)
+                self._helper_result = json.loads(result.stdout)
+            except (OSError, subprocess.TimeoutExpired, ValueError) as e:
+                self._helper_result = {"error": f"{self.HELPER_NAME} failed: {e}"}
+        return self._helper_result
+
+    def _helper_checks(self, report: Dict[str, Any], kind: str, approved: bool = True) -> List[Dict[str, Any]]:
+        return [c for c in report.get("checks", []) if c["kind"] == kind and c.get("approved", True) == approved]
+
+    def _helper_check_result(self, check_name: str, label: str,
+                             checks: List[Dict[str, Any]], report: Dict[str, Any]) -> ValidationResult:
+        """One ValidationResult for a group of helper checks"""
+        if "error" in report:
+            return ValidationResult(check_name, ValidationStatus.FAIL, report["error"])
+        if not report["provider"]["loaded"]:
+            return ValidationResult(check_name, ValidationStatus.FAIL,
+                                    f"{label}: FIPS provider not loaded ({report['provider']['error']})")
+        failed = [c for c in checks if c["result"] != "pass"]
+        details = {c["name"]: c["detail"] or c["result"] for c in checks}
+        if failed:
+            return ValidationResult(check_name, ValidationStatus.FAIL,
+                                    f"{label} failed: " + ", ".join(f"{c['name']} ({c['detail']})" for c in failed),
+                                    details)
+        return ValidationResult(check_name, ValidationStatus.PASS,
+                                f"{label} verified: {', '.join(c['name'] for c in checks)}", details)
+
     def _is_command_available(self, command: str) -> bool:
         """Check if a command is available in PATH."""
         try:
@@ -169,8 +256,10 @@ class FIPSValidator:
 
     def _get_openssl_version(self) -> str:
         """Get OpenSSL version string."""
+        if self.helper_path:
+            return self._helper_report().get("openssl_version", "unknown")
         try:
-            result = subprocess.run([self.openssl_path, "version"],
+            result = subprocess.run([self._openssl(), "version"],
                                   capture_output=True,
                                   text=True,
                                   timeout=10)
@@ -180,11 +269,58 @@ class FIPSValidator:
 
     def _validate_fips_mode(self) -> List[ValidationResult]:
         """Validate FIPS mode configuration."""
+        results = self._helper_fips_mode() if self.helper_path else self._cli_fips_mode()
+
+        # Check FIPS configuration file
+        fips_config_paths = [
+            "/etc/ssl/fipsmodule.cnf",
+            "/usr/local/ssl/fipsmodule.cnf",
+            "/opt/openssl/ssl/fipsmodule.cnf"
+        ]
+
+        fips_config_found = any(os.path.exists(path) for path in fips_config_paths)
+        if fips_config_found:
+            results.append(ValidationResult(
+                "fips_configuration_file",
+                ValidationStatus.PASS,
+                "FIPS configuration file found"
+            ))
+        else:
+            results.append(ValidationResult(
+                "fips_configuration_file",
+                ValidationStatus.WARNING,
+                "FIPS configuration file not found in standard locations"
+            ))
+
+        return results
+
+    def _helper_fips_mode(self) -> List[ValidationResult]:
+        """FIPS provider load and fips=yes default properties, from the helper"""
+        report = self._helper_report()
+        if "error" in report:
+            return [ValidationResult("fips_provider_available", ValidationStatus.FAIL, report["error"])]
+        provider = report["provider"]
+        if not provider["loaded"]:
+            return [ValidationResult("fips_provider_available", ValidationStatus.FAIL,
+                                     f"FIPS provider failed to load: {provider['error']}", provider)]
+        return [
+            ValidationResult("fips_provider_available", ValidationStatus.PASS,
+                             f"FIPS provider loaded: {provider.get('module_name', 'fips')} "
+                             f"{provider.get('module_version', '')} in {provider['load_ms']:.1f} ms",
+                             provider),
+            ValidationResult("fips_mode_enabled",
+                             ValidationStatus.PASS if report["fips_mode"] else ValidationStatus.FAIL,
+                             "fips=yes default properties enabled" if report["fips_mode"]
+                             else "Could not enable fips=yes default properties"),
+        ]
+
+    def _cli_fips_mode(self) -> List[ValidationResult]:
+        """FIPS provider availability from `openssl list -providers`"""
         results = []
 
         try:
             # Check if FIPS is available
-            result = subprocess.run([self.openssl_path, "list", "-providers"],
+            result = subprocess.run([self._openssl(), "list", "-providers"],
                                   capture_output=True,
                                   text=True,
                                   timeout=10)
@@ -216,36 +352,36 @@ class FIPSValidator:
                 "Timeout querying FIPS provider"
             ))
 
-        # Check FIPS configuration file
-        fips_config_paths = [
-            "/etc/ssl/fipsmodule.cnf",
-            "/usr/local/ssl/fipsmodule.cnf",
-            "/opt/openssl/ssl/fipsmodule.cnf"
-        ]
-
-        fips_config_found = any(os.path.exists(path) for path in fips_config_paths)
-        if fips_config_found:
-            results.append(ValidationResult(
-                "fips_configuration_file",
-                ValidationStatus.PASS,
-                "FIPS configuration file found"
-            ))
-        else:
-            results.append(ValidationResult(
-                "fips_configuration_file",
-                ValidationStatus.WARNING,
-                "FIPS configuration file not found in standard locations"
-            ))
-
         return results
 
     def _validate_algorithms(self) -> List[ValidationResult]:
         """Validate FIPS-required algorithms."""
+        if self.helper_path:
+            return self._helper_algorithms()
+        return self._cli_algorithms()
+
+    def _helper_algorithms(self) -> List[ValidationResult]:
+        """Approved algorithms exercised under fips=yes, non-approved ones unavailable"""
+        report = self._helper_report()
+        checks = [
+            ("aes_algorithms", "AES algorithms", self._helper_checks(report, "cipher")),
+            ("digest_algorithms", "Digest algorithms", self._helper_checks(report, "digest")),
+            ("mac_kdf_algorithms", "MAC and KDF algorithms",
+             self._helper_checks(report, "mac") + self._helper_checks(report, "kdf")),
+            ("drbg", "DRBG", self._helper_checks(report, "rand")),
+            ("signature_algorithms", "Signature algorithms", self._helper_checks(report, "signature")),
+            ("non_approved_blocked", "Non-approved algorithm blocking",
+             [c for c in report.get("checks", []) if not c.get("approved", True)]),
+        ]
+        return [self._helper_check_result(name, label, group, report) for name, label, group in checks]
+
+    def _cli_algorithms(self) -> List[ValidationResult]:
+        """Algorithm availability from `openssl ciphers` and `openssl dgst -list`"""
         results = []
 
         try:
             # Get list of supported ciphers
-            result = subprocess.run([self.openssl_path, "ciphers"],
+            result = subprocess.run([self._openssl(), "ciphers"],
                                   capture_output=True,
                                   text=True,
                                   timeout=10)
@@ -285,7 +421,7 @@ class FIPSValidator:
 
         # Check digest algorithms
         try:
-            result = subprocess.run([self.openssl_path, "dgst", "-list"],
+            result = subprocess.run([self._openssl(), "dgst", "-list"],
                                   capture_output=True,
                                   text=True,
                                   timeout=10)
@@ -352,11 +488,38 @@ class FIPSValidator:
 
     def _validate_self_tests(self) -> List[ValidationResult]:
         """Validate that FIPS self-tests are working."""
+        if self.helper_path:
+            return self._helper_self_tests()
+        return self._cli_self_tests()
+
+    def _helper_self_tests(self) -> List[ValidationResult]:
+        """Power-on self-tests (integrity check and KATs) recorded while the provider loaded"""
+        report = self._helper_report()
+        if "error" in report:
+            return [ValidationResult("fips_self_test", ValidationStatus.FAIL, report["error"])]
+        self_tests = report["self_tests"]
+        details = {"tests": self_tests["tests"], "load_ms": report["provider"]["load_ms"]}
+        if self_tests["failed"]:
+            failed = [f"{t['type']} {t['desc']}" for t in self_tests["tests"] if t["result"] != "pass"]
+            return [ValidationResult("fips_self_test", ValidationStatus.FAIL,
+                                     f"{self_tests['failed']} FIPS self-tests failed: {', '.join(failed)}", details)]
+        if not report["provider"]["loaded"]:
+            return [ValidationResult("fips_self_test", ValidationStatus.FAIL,
+                                     f"FIPS provider not loaded, self-tests did not run "
+                                     f"({report['provider']['error']})", details)]
+        if not self_tests["count"]:
+            return [ValidationResult("fips_self_test", ValidationStatus.WARNING,
+                                     "FIPS provider loaded but reported no self-test events", details)]
+        return [ValidationResult("fips_self_test", ValidationStatus.PASS,
+                                 f"{self_tests['count']} FIPS self-tests passed", details)]
+
+    def _cli_self_tests(self) -> List[ValidationResult]:
+        """Module verification via `openssl fipsinstall -verify`"""
         results = []
 
         # Run basic self-test
         try:
-            result = subprocess.run([self.openssl_path, "fipsinstall", "-verify"],
+            result = subprocess.run([self._openssl(), "fipsinstall", "-verify"],
                                   capture_output=True,
                                   text=True,
                                   timeout=30)
@@ -380,11 +543,11 @@ class FIPSValidator:
                 ValidationStatus.FAIL,
                 "FIPS self-test timed out"
             ))
-        except FileNotFoundError:
+        except FileNotFoundError as e:
             results.append(ValidationResult(
                 "fips_self_test",
                 ValidationStatus.SKIP,
-                "fipsinstall command not available"
+                f"fipsinstall command not available: {e}"
             ))
 
         return results
@@ -5,16 +5,24 @@ from __future__ import annotations
 import logging
 import os
 import shutil
+import threading
+import time
+from concurrent.futures import ThreadPoolExecutor
+from contextlib import nullcontext
 from dataclasses import dataclass
 from importlib import resources
 from pathlib import Path
-from typing import Mapping, Optional, Sequence
+from typing import Callable, Dict, List, Mapping, Optional, Sequence
 
 from ..execute_command import execute_command
+from .algorithm_manifest import configure_flags, excluded_algorithms, load_manifest
 from .provider_ordering import ProviderOrderer, get_provider_exclusions_for_version
 
 LOG = logging.getLogger(__name__)
 
+# BuildTrace of the run_hybrid_build() in progress, if it asked for one
+_TRACE = None
+
 
 @dataclass(slots=True)
 class HybridBuildConfig:
@@ -34,21 +42,77 @@ class HybridBuildConfig:
     run_tests: bool = True
     openssl_version: str = "3.6.0"  # For provider ordering
     enable_legacy: bool = False  # Enable legacy provider
-
-
-def run_hybrid_build(config: HybridBuildConfig) -> None:
-    """Execute the four-stage hybrid build.
-
-    1. Provider ordering analysis (OpenSSL 3.6+)
-    2. Perl Configure (authoritative dependency ordering)
-    3. Python enhancement script (optional)
-    4. make / make test / make install_sw
+    algorithm_manifest: Optional[Path] = None  # Prune algorithms the consumer does not use
+    trace_file: Optional[Path] = None  # Chrome trace of the stages and commands
+
+
+class StageTimings:
+    """Start offset and duration of each stage, recorded from any thread"""
+
+    def __init__(self) -> None:
+        self.origin = time.monotonic()
+        self._stages: List[Dict[str, object]] = []
+        self._lock = threading.Lock()
+
+    def run(self, name: str, stage: Callable, *args, **kwargs):
+        start = time.monotonic()
+        try:
+            with _TRACE.span(name, "stage") if _TRACE else nullcontext():
+                return stage(*args, **kwargs)
+        finally:
+            end = time.monotonic()
+            with self._lock:
+                self._stages.append({"name": name, "start_seconds": round(start - self.origin, 3),
+                                     "duration_seconds": round(end - start, 3)})
+
+    def as_list(self) -> List[Dict[str, object]]:
+        with self._lock:
+            return sorted(self._stages, key=lambda stage: stage["start_seconds"])
+
+
+def run_hybrid_build(config: HybridBuildConfig) -> List[Dict[str, object]]:
+    """Execute the hybrid build, overlapping the stages that are independent.
+
+    1. Perl Configure (authoritative dependency ordering), while the
+       provider ordering analysis (OpenSSL 3.6+) and the configure.py
+       deployment run alongside it: neither reads what Configure writes
+    2. Python enhancement script (optional); it edits Configure's Makefile
+    3. make build_sw, one jobserver for libraries, modules and programs
+    4. make install_sw, with make test (best effort) running alongside it
+       on the finished tree
+
+    Returns the stages as {"name", "start_seconds", "duration_seconds"} in
+    start order; build-openssl-source.py puts them in its build summary.
+
+    With ``trace_file`` set, every stage and command is recorded as a
+    Chrome trace event, together with Clang -ftime-trace data found in
+    the source tree.
     """
 
-    _analyze_provider_ordering(config)
-    _run_perl_configure(config)
-    _run_python_enhancement(config)
-    _run_make_targets(config)
+    global _TRACE
+    if config.trace_file:
+        from ..development.build_system.build_trace import BuildTrace, now_us
+
+        _TRACE, start = BuildTrace(config.trace_file, "hybrid build"), now_us()
+    timings = StageTimings()
+    try:
+        with ThreadPoolExecutor(max_workers=2, thread_name_prefix="hybrid-stage") as pool:
+            ordering = pool.submit(timings.run, "provider ordering", _analyze_provider_ordering, config)
+            script = pool.submit(timings.run, "configure.py deployment", _prepare_enhancement_script, config)
+            timings.run("Configure", _run_perl_configure, config)
+            ordering.result()
+            script_path = script.result()
+        timings.run("python enhancement", _run_python_enhancement, config, script_path)
+        _run_make_targets(config, timings)
+        return timings.as_list()
+    finally:
+        for stage in timings.as_list():
+            LOG.info("Hybrid build: %-24s +%7.1fs %7.1fs", stage["name"], stage["start_seconds"],
+                     stage["duration_seconds"])
+        if _TRACE:
+            _TRACE.merge_clang_time_traces(config.source_dir, since_us=start)
+            LOG.info("Hybrid build: trace written to %s", _TRACE.save())
+            _TRACE = None
 
 
 def _analyze_provider_ordering(config: HybridBuildConfig) -> None:
@@ -57,6 +121,8 @@ def _analyze_provider_ordering(config: HybridBuildConfig) -> None:
     
     # Get recommended exclusions
     exclusions = get_provider_exclusions_for_version(config.openssl_version)
+    if config.algorithm_manifest:
+        exclusions |= excluded_algorithms(load_manifest(config.algorithm_manifest))
     
     # Create provider orderer
     orderer = ProviderOrderer(
@@ -77,7 +143,7 @@ def _analyze_provider_ordering(config: HybridBuildConfig) -> None:
         LOG.warning("Missing provider sources: %s", ", ".join(missing))
     
     # Generate Makefile fragment for provider dependencies
-    makefile_fragment = orderer.get_make_dependencies()
+    makefile_fragment = orderer.get_make_dependencies(str(config.source_dir))
     fragment_path = config.source_dir / "providers.mk"
     with open(fragment_path, "w") as f:
         f.write(makefile_fragment)
@@ -99,6 +165,8 @@ def _run_perl_configure(config: HybridBuildConfig) -> None:
         args.append("enable-fips")
 
     args.extend(config.configure_args)
+    if config.algorithm_manifest:
+        args.extend(configure_flags(load_manifest(config.algorithm_manifest)))
     args.extend(
         [
             f"--prefix={config.install_prefix}",
@@ -111,10 +179,17 @@ def _run_perl_configure(config: HybridBuildConfig) -> None:
     _run(command, cwd=config.source_dir, env=config.environment)
 
 
-def _run_python_enhancement(config: HybridBuildConfig) -> None:
+def _prepare_enhancement_script(config: HybridBuildConfig) -> Optional[Path]:
+    """configure.py to run after Configure, deployed into the tree if needed; None to skip"""
     script = config.configure_script or _ensure_configure_script(config.source_dir)
     if not script.exists():
         LOG.warning("Hybrid build: configure.py not found at %s, skipping enhancement stage", script)
+        return None
+    return script
+
+
+def _run_python_enhancement(config: HybridBuildConfig, script: Optional[Path]) -> None:
+    if script is None:
         return
 
     command = f"{config.python_executable} {script} enhance --makefile-only"
@@ -122,25 +197,43 @@ def _run_python_enhancement(config: HybridBuildConfig) -> None:
     _run(command, cwd=config.source_dir, env=config.environment, ignore_errors=True)
 
 
-def _run_make_targets(config: HybridBuildConfig) -> None:
+def _run_make_targets(config: HybridBuildConfig, timings: Optional[StageTimings] = None) -> None:
+    timings = timings or StageTimings()
     jobs_flag = f"-j{config.jobs}" if config.jobs else ""
 
     make_command = "make" if os.name != "nt" else "nmake"
 
-    build_cmd = " ".join(filter(None, [make_command, jobs_flag]))
+    # build_sw, not the default target: install_sw never installs the
+    # generated docs, and one make run keeps every job slot busy from the
+    # first libcrypto object to the last program link
+    build_cmd = " ".join(filter(None, [make_command, jobs_flag, "build_sw"]))
     LOG.info("Hybrid build: compiling with %s", build_cmd.strip())
-    _run(build_cmd, cwd=config.source_dir, env=config.environment)
-
-    if config.run_tests:
-        LOG.info("Hybrid build: running test suite (best effort)")
-        _run(f"{make_command} test", cwd=config.source_dir, env=config.environment, ignore_errors=True)
-
-    LOG.info("Hybrid build: installing to %s", config.install_prefix)
-    _run(f"{make_command} install_sw", cwd=config.source_dir, env=config.environment)
+    timings.run("make", _run, build_cmd, cwd=config.source_dir, env=config.environment)
+
+    # Both only read the finished build tree
+    with ThreadPoolExecutor(max_workers=1, thread_name_prefix="hybrid-test") as pool:
+        tests = None
+        if config.run_tests:
+            LOG.info("Hybrid build: running test suite (best effort)")
+            test_env = dict(config.environment if config.environment is not None else os.environ)
+            if config.jobs:
+                test_env.setdefault("HARNESS_JOBS", str(config.jobs))
+            tests = pool.submit(timings.run, "make test", _run, f"{make_command} test",
+                                cwd=config.source_dir, env=test_env, ignore_errors=True)
+
+        LOG.info("Hybrid build: installing to %s", config.install_prefix)
+        timings.run("make install_sw", _run, f"{make_command} install_sw", cwd=config.source_dir,
+                    env=config.environment)
+        if tests is not None:
+            tests.result()
 
 
 def _run(command: str, *, cwd: Path, env: Optional[Mapping[str, str]], ignore_errors: bool = False) -> None:
-    rc, output = execute_command(command, cwd=cwd, env=env)
+    name = " ".join(w for w in command.split()[:2] if not w.startswith(("-", "/")))  # "make test"
+    with _TRACE.span(name, "command", command=command) if _TRACE else nullcontext({}) as args:
+        # execute_command takes the environment as custom_env (env= is overwritten)
+        rc, output = execute_command(command, cwd=cwd, custom_env=dict(env) if env is not None else None)
+        args["exit_code"] = rc
     if rc != 0 and not ignore_errors:
         raise RuntimeError(f"Command failed ({rc}): {command}\nOutput: {os.linesep.join(output)}")
 
@@ -0,0 +1,324 @@
+#!/usr/bin/env python3
+"""
+Multi-node TLS load test controller
+
+Drives the test_package bench_loadgen binary across machines: one node
+runs the reference server (`--serve`), the client nodes run many
+connections per core against it (`--connect`), all started at the same
+wall-clock time. Loopback benchmarks leave out the NIC, IRQ affinity and
+the kernel network stack; these numbers include them.
+
+Nodes use the RemoteBuildExecutor node format (BuilderNode: host, user,
+port, transport, ssh_options) and are reached over plain SSH:
+
+    server:
+      host: tls-server-1
+      user: ci
+      binary: /opt/loadgen/bench_loadgen   # default for every variant
+    clients:
+      - host: tls-client-1
+        binary: /opt/loadgen/bench_loadgen
+      - host: tls-client-2
+        threads: 16                        # default: all cores
+        conns: 64                          # per thread
+
+Each package variant is one round: `--variant NAME=PATH` names the
+server binary built against that variant (on the server node); the
+clients keep theirs, so only the server side changes between rounds.
+
+The clients write their latency histograms (bench_loadgen --hist); the
+controller sums the bucket counts over all clients before taking
+percentiles, so aggregate p99/p99.9 are exact rather than averages of
+per-node percentiles. Rates and throughput are summed over the clients,
+which run over the same window.
+"""
+
+import json
+import logging
+import shlex
+import subprocess
+import tempfile
+import threading
+import time
+from dataclasses import dataclass, field
+from pathlib import Path
+from typing import Dict, List, Optional, Tuple
+
+from .remote_executor import BuilderNode
+
+logger = logging.getLogger(__name__)
+
+DEFAULT_PORT = 8443
+# Time for ssh to reach every client node before the common start
+DEFAULT_START_DELAY = 5.0
+# Extra time a client gets beyond --duration before it is abandoned
+CLIENT_GRACE_SECONDS = 60.0
+
+PERCENTILES = (("p50", 50.0), ("p90", 90.0), ("p99", 99.0), ("p999", 99.9))
+
+
+@dataclass
+class LoadNode:
+    """A BuilderNode with the bench_loadgen binary and its load settings"""
+    node: BuilderNode
+    binary: str = "bench_loadgen"
+    threads: Optional[int] = None
+    conns: Optional[int] = None
+
+
+@dataclass
+class LoadTestPlan:
+    server: LoadNode
+    clients: List[LoadNode]
+    # Server-side address the clients connect to (default: the server host)
+    target: Optional[str] = None
+    port: int = DEFAULT_PORT
+    duration: float = 30.0
+    requests: int = 1
+    size: int = 1024
+    key_type: str = "EC"
+    start_delay: float = DEFAULT_START_DELAY
+
+
+def _load_node(entry: Dict) -> LoadNode:
+    known = set(BuilderNode.__dataclass_fields__) - {"healthy", "busy"}
+    node = BuilderNode(**{k: v for k, v in entry.items() if k in known})
+    return LoadNode(node, binary=entry.get("binary", "bench_loadgen"),
+                    threads=entry.get("threads"), conns=entry.get("conns"))
+
+
+def load_plan(path: Path, **overrides) -> LoadTestPlan:
+    """Read the server and client nodes from YAML or JSON (see the module docstring)"""
+    text = Path(path).read_text(encoding="utf-8")
+    if Path(path).suffix in (".yaml", ".yml"):
+        import yaml
+        data = yaml.safe_load(text)
+    else:
+        data = json.loads(text)
+    if not data.get("server") or not data.get("clients"):
+        raise ValueError(f"{path}: needs a server and at least one client")
+    plan = LoadTestPlan(server=_load_node(data["server"]),
+                        clients=[_load_node(entry) for entry in data["clients"]],
+                        target=data.get("target"))
+    for key, value in overrides.items():
+        if value is not None:
+            setattr(plan, key, value)
+    return plan
+
+
+class Histogram:
+    """bench_loadgen --hist buckets (microseconds), summed across nodes"""
+
+    def __init__(self):
+        self.buckets: Dict[Tuple[int, int], int] = {}
+        self.max_us = 0.0
+
+    @property
+    def total(self) -> int:
+        return sum(self.buckets.values())
+
+    def add(self, low: int, high: int, count: int) -> None:
+        self.buckets[(low, high)] = self.buckets.get((low, high), 0) + count
+
+    def percentile(self, pct: float) -> float:
+        """Same rule as the binary: the middle of the bucket holding the rank"""
+        total = self.total
+        if total == 0:
+            return 0.0
+        rank, seen = max(1, int(pct / 100.0 * total + 0.5)), 0
+        for (low, high), count in sorted(self.buckets.items()):
+            seen += count
+            if seen >= rank:
+                mid = low + (high - low - 1) / 2.0
+                return min(mid, self.max_us) if self.max_us else mid
+        return self.max_us
+
+
+def read_histograms(path: Path) -> Dict[str, Histogram]:
+    """Parse "name low_us high_us count" lines"""
+    hists: Dict[str, Histogram] = {}
+    for line in Path(path).read_text(encoding="utf-8").splitlines():
+        parts = line.split()
+        if len(parts) == 4:
+            hists.setdefault(parts[0], Histogram()).add(int(parts[1]), int(parts[2]), int(parts[3]))
+    return hists
+
+
+def read_records(path: Path) -> List[Dict]:
+    return json.loads(Path(path).read_text(encoding="utf-8")).get("results", [])
+
+
+@dataclass
+class ClientRun:
+    node: str
+    returncode: Optional[int] = None
+    record: Dict = field(default_factory=dict)
+    hists: Dict[str, Histogram] = field(default_factory=dict)
+    error: Optional[str] = None
+
+
+class LoadTestController:
+    """Runs one load test round per server variant and aggregates the clients"""
+
+    def __init__(self, plan: LoadTestPlan, work_dir: Optional[Path] = None):
+        self.plan = plan
+        self.work_dir = Path(work_dir or tempfile.mkdtemp(prefix="loadgen-"))
+        self.work_dir.mkdir(parents=True, exist_ok=True)
+
+    def _fetch(self, node: BuilderNode, remote_path: str, local_path: Path) -> bool:
+        result = subprocess.run(node.fetch_command(remote_path, local_path),
+                                capture_output=True, text=True, timeout=120)
+        if result.returncode != 0:
+            logger.warning("%s: cannot fetch %s: %s", node.name, remote_path, result.stderr.strip())
+        return result.returncode == 0
+
+    def _start_server(self, variant: str, binary: str) -> Tuple[subprocess.Popen, str, int]:
+        plan, server = self.plan, self.plan.server
+        remote_json = f"/tmp/sparetools-loadgen-{variant}-server.json"
+        cmd = [binary, "--json", remote_json, "--serve", str(plan.port), "--key", plan.key_type,
+               "--stop-on-eof"]
+        if server.threads:
+            cmd += ["--threads", str(server.threads)]
+        # Closing stdin stops the server, over ssh as well as locally
+        proc = subprocess.Popen(server.node.command(shlex.join(cmd)), stdin=subprocess.PIPE,
+                                stdout=subprocess.PIPE, stderr=subprocess.STDOUT, text=True)
+        for line in proc.stdout:
+            logger.debug("server: %s", line.rstrip())
+            if line.startswith("listening on port"):
+                # The bound port, which is the point of --port 0
+                return proc, remote_json, int(line.split()[3])
+        proc.wait()
+        raise RuntimeError(f"{server.node.name}: server {binary} exited with {proc.returncode} "
+                           f"before listening")
+
+    def _run_client(self, index: int, client: LoadNode, variant: str, port: int, start_at: float,
+                    run: ClientRun) -> None:
+        plan = self.plan
+        target = plan.target or plan.server.node.host
+        remote = f"/tmp/sparetools-loadgen-{variant}-client{index}"
+        cmd = [client.binary, "--json", f"{remote}.json", "--connect", f"{target}:{port}",
+               "--requests", str(plan.requests), "--size", str(plan.size),
+               "--duration", str(plan.duration), "--start-at", f"{start_at:.3f}",
+               "--hist", f"{remote}.hist"]
+        if client.threads:
+            cmd += ["--threads", str(client.threads)]
+        if client.conns:
+            cmd += ["--conns", str(client.conns)]
+        try:
+            result = subprocess.run(client.node.command(shlex.join(cmd)), capture_output=True, text=True,
+                                    timeout=plan.start_delay + plan.duration + CLIENT_GRACE_SECONDS)
+        except subprocess.TimeoutExpired:
+            run.error = "timed out"
+            return
+        run.returncode = result.returncode
+        if result.returncode != 0:
+            output = (result.stderr or result.stdout).strip().splitlines()
+            run.error = output[-1] if output else f"exit code {result.returncode}"
+            return
+
+        local = self.work_dir / f"{variant}-client{index}"
+        if not (self._fetch(client.node, f"{remote}.json", local.with_suffix(".json"))
+                and self._fetch(client.node, f"{remote}.hist", local.with_suffix(".hist"))):
+            run.error = "results not fetched"
+            return
+        records = read_records(local.with_suffix(".json"))
+        run.record = records[0] if records else {}
+        run.hists = read_histograms(local.with_suffix(".hist"))
+        for name in run.hists:
+            run.hists[name].max_us = float(run.record.get(f"{name}_max_us", 0.0))
+
+    def run_variant(self, variant: str, server_binary: Optional[str] = None) -> Dict:
+        """One round against a server built with this variant"""
+        plan = self.plan
+        proc, server_json, port = self._start_server(variant, server_binary or plan.server.binary)
+        runs = [ClientRun(client.node.name) for client in plan.clients]
+        try:
+            start_at = time.time() + plan.start_delay
+            threads = [threading.Thread(target=self._run_client,
+                                        args=(i, client, variant, port, start_at, runs[i]))
+                       for i, client in enumerate(plan.clients)]
+            for thread in threads:
+                thread.start()
+            for thread in threads:
+                thread.join()
+        finally:
+            proc.stdin.close()
+            try:
+                proc.wait(timeout=30)
+            except subprocess.TimeoutExpired:
+                proc.kill()
+                proc.wait()
+
+        server_record = {}
+        local = self.work_dir / f"{variant}-server.json"
+        if self._fetch(plan.server.node, server_json, local):
+            records = read_records(local)
+            server_record = records[0] if records else {}
+        return self.aggregate(variant, runs, server_record)
+
+    @staticmethod
+    def aggregate(variant: str, runs: List[ClientRun], server_record: Dict) -> Dict:
+        ok = [run for run in runs if run.error is None]
+        merged: Dict[str, Histogram] = {}
+        for run in ok:
+            for name, hist in run.hists.items():
+                into = merged.setdefault(name, Histogram())
+                for (low, high), count in hist.buckets.items():
+                    into.add(low, high, count)
+                into.max_us = max(into.max_us, hist.max_us)
+
+        summary = {
+            "variant": variant,
+            "clients": len(ok),
+            "failed_clients": {run.node: run.error for run in runs if run.error is not None},
+            "connections": sum(int(run.record.get("threads", 0)) * int(run.record.get("conns_per_thread", 0))
+                               for run in ok),
+        }
+        for key in ("handshakes", "requests", "errors", "handshakes_per_s", "requests_per_s", "mb_per_s"):
+            summary[key] = sum(run.record.get(key, 0) for run in ok)
+        for name in ("handshake", "request"):
+            hist = merged.get(name, Histogram())
+            for label, pct in PERCENTILES:
+                summary[f"{name}_{label}_us"] = hist.percentile(pct)
+            summary[f"{name}_max_us"] = hist.max_us
+        summary["per_client"] = {run.node: run.record for run in ok}
+        summary["server"] = server_record
+        return summary
+
+    def run(self, variants: List[Tuple[str, Optional[str]]]) -> Dict:
+        results = []
+        for name, binary in variants:
+            logger.info("Load test round %s", name)
+            results.append(self.run_variant(name, binary))
+        return {
+            "server": self.plan.server.node.name,
+            "clients": [client.node.name for client in self.plan.clients],
+            "duration": self.plan.duration,
+            "requests_per_conn": self.plan.requests,
+            "response_size": self.plan.size,
+            "key_type": self.plan.key_type,
+            "variants": results,
+        }
+
+
+def format_summary(summary: Dict) -> str:
+    lines = [f"{'variant':<20} {'conns':>7} {'hs/s':>11} {'req/s':>11} {'MB/s':>9} "
+             f"{'hs p50':>9} {'hs p99':>9} {'req p99':>9} {'errors':>7}"]
+    for row in summary["variants"]:
+        lines.append(f"{row['variant']:<20} {row['connections']:>7} {row['handshakes_per_s']:>11.1f} "
+                     f"{row['requests_per_s']:>11.1f} {row['mb_per_s']:>9.2f} "
+                     f"{row['handshake_p50_us'] / 1000:>7.2f}ms {row['handshake_p99_us'] / 1000:>7.2f}ms "
+                     f"{row['request_p99_us'] / 1000:>7.2f}ms {row['errors']:>7}")
+        for node, error in row["failed_clients"].items():
+            lines.append(f"  ✗ {node}: {error}")
+    return "\n".join(lines)
+
+
+def parse_variants(specs: List[str]) -> List[Tuple[str, Optional[str]]]:
+    """NAME=PATH (server binary for that variant) or NAME (the server node's binary)"""
+    variants = []
+    for spec in specs or ["default"]:
+        name, _, binary = spec.partition("=")
+        variants.append((name, binary or None))
+    return variants
+
@@ -3,8 +3,10 @@
 from __future__ import annotations
 
 import logging
+import os
 from dataclasses import dataclass
 from enum import Enum
+from pathlib import Path
 from typing import Dict, List, Optional, Set
 
 LOG = logging.getLogger(__name__)
@@ -147,7 +149,8 @@ class ProviderOrderer:
         self.excluded_algorithms = excluded_algorithms or set()
         
         self._build_order: Optional[List[str]] = None
-        self._filtered_sources: Optional[Dict[str, List[str]]] = None
+        # resolve_sources() results by source tree
+        self._filtered_sources: Dict[str, Dict[str, List[str]]] = {}
 
     def get_build_order(self) -> List[str]:
         """Get provider build order using topological sort.
@@ -186,7 +189,7 @@ class ProviderOrderer:
                 return
 
             # Visit dependencies first
-            for dep in provider.dependencies:
+            for dep in sorted(provider.dependencies):
                 if dep in providers_to_build:
                     visit(dep)
 
@@ -194,8 +197,8 @@ class ProviderOrderer:
             visited.add(provider_name)
             build_order.append(provider_name)
 
-        # Visit all selected providers
-        for provider_name in providers_to_build:
+        # Visit all selected providers (sorted, so generated files are stable)
+        for provider_name in sorted(providers_to_build):
             if provider_name not in visited:
                 visit(provider_name)
 
@@ -234,57 +237,163 @@ class ProviderOrderer:
 
         return filtered
 
-    def get_make_dependencies(self) -> str:
-        """Generate Makefile dependencies for providers.
-        
+    def resolve_sources(self, source_dir: str = ".") -> Dict[str, List[str]]:
+        """Concrete source files per provider in build order.
+
+        Patterns are expanded against ``source_dir``. A file that one of the
+        optional providers names explicitly (the legacy ciphers and digests)
+        is never compiled into the default provider, whether or not that
+        provider is enabled. Files whose name contains an excluded algorithm
+        are dropped everywhere. FIPS sources are not taken away from the
+        default provider: the FIPS module builds its own copies with
+        -DFIPS_MODULE.
+
+        Args:
+            source_dir: OpenSSL source tree the patterns are relative to
+
+        Returns:
+            Dictionary mapping provider names to relative source paths
+        """
+        root = Path(source_dir)
+        key = str(root.resolve())
+        if key in self._filtered_sources:
+            return self._filtered_sources[key]
+
+        def expand(patterns: List[str]) -> List[str]:
+            files: List[str] = []
+            for pattern in patterns:
+                for path in sorted(root.glob(pattern)):
+                    rel = path.relative_to(root).as_posix()
+                    if path.is_file() and rel not in files:
+                        files.append(rel)
+            return files
+
+        claimed: Set[str] = set()
+        for name, info in PROVIDER_GRAPH.items():
+            if info.optional and info.provider_type != ProviderType.FIPS:
+                claimed.update(expand([p for p in info.source_files if Path(p).name != f"{name}prov.c"]))
+
+        resolved: Dict[str, List[str]] = {}
+        for provider in self.get_build_order():
+            files = expand(self.get_filtered_sources(provider))
+            if provider == "default":
+                files = [f for f in files if f not in claimed]
+            kept = []
+            for rel in files:
+                algo = self._excluded_algorithm(Path(rel).name)
+                if algo:
+                    LOG.info(f"Excluding {rel} (algorithm: {algo})")
+                else:
+                    kept.append(rel)
+            resolved[provider] = kept
+
+        self._filtered_sources[key] = resolved
+        return resolved
+
+    def _excluded_algorithm(self, file_name: str) -> Optional[str]:
+        for algo in self.excluded_algorithms:
+            if algo.lower() in file_name.lower():
+                return algo
+        return None
+
+    @staticmethod
+    def archive_name(provider_name: str) -> str:
+        """Static archive of a provider, named as in OpenSSL's own build"""
+        return "libcommon" if provider_name == "base" else f"lib{provider_name}"
+
+    def get_make_dependencies(self, source_dir: str = ".") -> str:
+        """Generate Makefile rules that build every provider archive.
+
+        Each enabled provider gets an object rule per source file and a
+        ``providers/lib<name>.a`` archive. Objects are named like OpenSSL's
+        (``dir/libdefault-lib-foo.o``) so a provider's FIPS and default copies
+        of a file do not collide. Provider dependencies from the graph are
+        order-only prerequisites of the ``provider_<name>`` targets: the
+        archives of independent providers, and all their objects, build in
+        parallel under ``make -j``. Disabled providers and excluded sources
+        get no rules at all. Tools and flags use ``?=`` so the fragment can
+        be included from the main Makefile or run with ``make -f``.
+
+        Args:
+            source_dir: OpenSSL source tree used to expand source patterns
+
         Returns:
-            Makefile fragment with provider dependencies
+            Makefile fragment with provider build rules
         """
         build_order = self.get_build_order()
-        
+        sources = self.resolve_sources(source_dir)
+
         makefile_lines = [
             "# Provider build order and dependencies",
             "# Generated by provider_ordering.py",
-            ""
+            "",
+            "CC ?= cc",
+            "AR ?= ar",
+            "RANLIB ?= ranlib",
+            "CFLAGS ?= -O2",
+            "PROVIDER_INCLUDES ?= -Iinclude -I. -Iproviders/common/include "
+            "-Iproviders/implementations/include -Iproviders/fips/include",
+            "",
         ]
 
-        for i, provider in enumerate(build_order):
+        archives = []
+        all_objects = []
+        for provider in build_order:
             provider_info = PROVIDER_GRAPH[provider]
-            
-            # Build target name
-            target = f"provider_{provider}"
-            
-            # Dependencies
-            deps = []
-            if provider_info.requires_crypto:
-                deps.append("libcrypto.a")
-            
-            # Add provider dependencies
-            for dep in provider_info.dependencies:
-                if dep in build_order:
-                    deps.append(f"provider_{dep}")
-            
-            deps_str = " ".join(deps) if deps else ""
-            
-            makefile_lines.append(f"{target}: {deps_str}")
-            
-            # Source files
-            sources = self.get_filtered_sources(provider)
-            if sources:
-                makefile_lines.append(f"\t# Build {provider} provider")
-                for source in sources[:3]:  # Show first 3 as examples
-                    makefile_lines.append(f"\t# Source: {source}")
-                if len(sources) > 3:
-                    makefile_lines.append(f"\t# ... and {len(sources) - 3} more files")
+            archive_stem = self.archive_name(provider)
+            archive = f"providers/{archive_stem}.a"
+            var = f"PROVIDER_{provider.upper()}"
+            defines = "-DFIPS_MODULE" if provider_info.provider_type == ProviderType.FIPS else ""
+
+            objects = []
+            rules = []
+            for src in sources.get(provider, []):
+                directory, name = os.path.split(src)
+                obj = os.path.join(directory, f"{archive_stem}-lib-{name[:-2]}.o").replace(os.sep, "/")
+                objects.append(obj)
+                rules.extend([
+                    f"{obj}: {src}",
+                    f"\t$(CC) $(CPPFLAGS) $(CFLAGS) {defines + ' ' if defines else ''}"
+                    f"$(PROVIDER_INCLUDES) -MMD -MP -c $< -o $@",
+                ])
+            all_objects.extend(objects)
+
+            makefile_lines.append(f"# {provider} provider: {len(objects)} sources")
+            makefile_lines.append(f"{var}_OBJECTS = " + " \\\n\t".join(objects))
+            makefile_lines.append("")
+            makefile_lines.extend(rules)
+            makefile_lines.append("")
+
+            deps = [f"provider_{dep}" for dep in sorted(provider_info.dependencies) if dep in build_order]
+            order_only = f" | {' '.join(deps)}" if deps else ""
+            if objects:
+                archives.append(archive)
+                makefile_lines.extend([
+                    f"{archive}: $({var}_OBJECTS)",
+                    "\t@rm -f $@",
+                    "\t$(AR) rcs $@ $^",
+                    "\t$(RANLIB) $@",
+                    "",
+                    f"provider_{provider}: {archive}{order_only}",
+                ])
+            else:
+                makefile_lines.append(f"provider_{provider}:{order_only}")
             makefile_lines.append("")
 
         # All providers target
         all_providers = " ".join(f"provider_{p}" for p in build_order)
         makefile_lines.extend([
-            "# Build all providers in correct order",
+            "# Build all providers; independent providers compile in parallel",
             f"providers: {all_providers}",
             "",
-            ".PHONY: providers " + " ".join(f"provider_{p}" for p in build_order)
+            "providers_clean:",
+            "\trm -f " + " ".join(archives) + " $(PROVIDER_ALL_OBJECTS) $(PROVIDER_ALL_OBJECTS:.o=.d)",
+            "",
+            "PROVIDER_ALL_OBJECTS = " + " ".join(f"$(PROVIDER_{p.upper()}_OBJECTS)" for p in build_order),
+            "-include $(PROVIDER_ALL_OBJECTS:.o=.d)",
+            "",
+            ".PHONY: providers providers_clean " + " ".join(f"provider_{p}" for p in build_order),
+            "",
         ])
 
         return "\n".join(makefile_lines)
@@ -365,15 +474,17 @@ def generate_provider_makefile_fragment(
     openssl_version: str = "3.6.0",
     enable_fips: bool = False,
     enable_legacy: bool = False,
-    output_file: Optional[str] = None
+    output_file: Optional[str] = None,
+    source_dir: str = "."
 ) -> str:
-    """Generate Makefile fragment with provider dependencies.
+    """Generate Makefile fragment with provider build rules.
     
     Args:
         openssl_version: OpenSSL version
         enable_fips: Enable FIPS provider
         enable_legacy: Enable legacy provider  
         output_file: Optional output file path
+        source_dir: OpenSSL source tree to expand source patterns in
         
     Returns:
         Makefile fragment as string
@@ -387,7 +498,7 @@ def generate_provider_makefile_fragment(
         excluded_algorithms=exclusions
     )
     
-    makefile_content = orderer.get_make_dependencies()
+    makefile_content = orderer.get_make_dependencies(source_dir)
     
     if output_file:
         with open(output_file, "w") as f:
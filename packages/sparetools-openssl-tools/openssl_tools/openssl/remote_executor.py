@@ -0,0 +1,327 @@
+#!/usr/bin/env python3
+"""
+Remote Build Executor for OpenSSL Build Matrices
+
+Dispatches the BuildConfiguration list produced by
+SmartBuildMatrix.generate_matrix to a pool of builder hosts over SSH.
+Each job copies the recipe to the node, runs `conan create` there, saves
+the resulting packages with `conan cache save` and restores them into the
+local Conan cache. Progress is written as build-summary-*.json files, so
+`scripts/aggregate-build-logs.py --follow <log-dir>` shows live status.
+
+Nodes are described in a YAML or JSON file:
+
+    nodes:
+      - host: linux-x64-1
+        user: ci
+        platforms: [linux]
+        architectures: [x86_64]
+        slots: 2
+        profile: gcc13
+      - host: localhost
+        transport: local      # run on this machine, no SSH
+
+A node whose SSH connection fails is taken out of the pool and its job is
+requeued on another node; a failed build is retried up to `retries`
+times, preferring a node it has not failed on yet.
+"""
+
+import json
+import logging
+import os
+import shlex
+import subprocess
+import sys
+import tempfile
+import threading
+import time
+from dataclasses import dataclass, field
+from datetime import datetime, timezone
+from pathlib import Path
+from typing import List, Optional
+
+from .build_matrix import BuildConfiguration, BuildType
+
+logger = logging.getLogger(__name__)
+
+# ssh exits with 255 for connection and authentication errors
+SSH_CONNECTION_ERROR = 255
+
+# Conan setting values for the architectures used in the matrix config
+CONAN_ARCH = {"x86_64": "x86_64", "arm64": "armv8", "aarch64": "armv8", "x86": "x86"}
+
+AGGREGATE_SCRIPT = Path(__file__).resolve().parents[4] / "scripts" / "aggregate-build-logs.py"
+
+
+@dataclass
+class BuilderNode:
+    """A remote (or local) machine that can build some platforms/architectures"""
+    host: str
+    user: Optional[str] = None
+    port: Optional[int] = None
+    platforms: List[str] = field(default_factory=lambda: ["linux"])
+    architectures: List[str] = field(default_factory=lambda: ["x86_64"])
+    slots: int = 1
+    workdir: str = "sparetools-remote"
+    profile: Optional[str] = None
+    transport: str = "ssh"
+    ssh_options: List[str] = field(default_factory=list)
+    healthy: bool = True
+    busy: int = 0
+
+    @property
+    def name(self) -> str:
+        return f"{self.user}@{self.host}" if self.user else self.host
+
+    def can_build(self, config: BuildConfiguration) -> bool:
+        return (config.platform.value in self.platforms
+                and config.architecture in self.architectures)
+
+    def command(self, remote_cmd: str) -> List[str]:
+        """argv that runs a shell command on the node"""
+        if self.transport == "local":
+            return ["sh", "-c", remote_cmd]
+        cmd = ["ssh", "-o", "BatchMode=yes", "-o", "ConnectTimeout=15", *self.ssh_options]
+        if self.port:
+            cmd += ["-p", str(self.port)]
+        return cmd + [self.name, remote_cmd]
+
+    def fetch_command(self, remote_path: str, local_path: Path) -> List[str]:
+        """argv that copies a file from the node"""
+        if self.transport == "local":
+            return ["cp", os.path.expanduser(remote_path), str(local_path)]
+        cmd = ["scp", "-q", "-o", "BatchMode=yes", *self.ssh_options]
+        if self.port:
+            cmd += ["-P", str(self.port)]
+        return cmd + [f"{self.name}:{remote_path}", str(local_path)]
+
+
+def load_nodes(path: Path) -> List[BuilderNode]:
+    """Read builder nodes from a YAML or JSON file ({"nodes": [...]} or a list)"""
+    text = Path(path).read_text(encoding="utf-8")
+    if Path(path).suffix in (".yaml", ".yml"):
+        import yaml
+        data = yaml.safe_load(text)
+    else:
+        data = json.loads(text)
+    entries = data.get("nodes", []) if isinstance(data, dict) else data
+    known = set(BuilderNode.__dataclass_fields__) - {"healthy", "busy"}
+    return [BuilderNode(**{k: v for k, v in entry.items() if k in known}) for entry in entries]
+
+
+def job_name(config: BuildConfiguration) -> str:
+    fips = "-fips" if config.fips_enabled else ""
+    return (f"{config.platform.value}-{config.architecture}-{config.compiler.value}-"
+            f"{config.build_type.value}{fips}-{config.openssl_version}")
+
+
+def conan_create_args(config: BuildConfiguration, profile: Optional[str] = None) -> List[str]:
+    """conan create arguments for one matrix entry"""
+    fips = config.fips_enabled or config.build_type == BuildType.FIPS
+    args = ["--version", config.openssl_version,
+            "-s", f"build_type={'Debug' if config.build_type == BuildType.DEBUG else 'Release'}",
+            "-s", f"arch={CONAN_ARCH.get(config.architecture, config.architecture)}",
+            "-o", f"*:shared={config.shared_libs}",
+            "-o", f"*:fips={fips}",
+            "-o", f"*:enable_threads={config.threads_enabled}",
+            "--build=missing"]
+    if profile:
+        args += ["-pr:h", profile]
+    return args
+
+
+@dataclass
+class RemoteJob:
+    config: BuildConfiguration
+    name: str
+    attempts: int = 0
+    failed_on: List[str] = field(default_factory=list)
+    node: Optional[str] = None
+    success: bool = False
+    error: Optional[str] = None
+    duration_seconds: float = 0.0
+
+
+class RemoteBuildExecutor:
+    """Runs a build matrix on a pool of builder nodes"""
+
+    def __init__(self, nodes: List[BuilderNode], recipe_dir: Path, log_dir: Path,
+                 retries: int = 1, restore: bool = True, timeout: Optional[float] = None):
+        self.nodes = nodes
+        self.recipe_dir = Path(recipe_dir).resolve()
+        self.log_dir = Path(log_dir).resolve()
+        self.retries = retries
+        self.restore = restore
+        self.timeout = timeout
+        self.package_name = "sparetools-openssl"
+        self._cond = threading.Condition()
+
+    # -- per-job steps ------------------------------------------------------
+
+    def _run(self, argv: List[str], input_data: Optional[bytes] = None) -> subprocess.CompletedProcess:
+        return subprocess.run(argv, input=input_data, capture_output=True, timeout=self.timeout)
+
+    def _upload_recipe(self, node: BuilderNode, remote_dir: str) -> subprocess.CompletedProcess:
+        """Stream the recipe as a tarball (no rsync needed on the node)"""
+        with tempfile.TemporaryFile() as archive:
+            subprocess.run(["tar", "-C", str(self.recipe_dir), "--exclude=build", "--exclude=test_package/build",
+                            "-czf", "-", "."], stdout=archive, check=True)
+            archive.seek(0)
+            return self._run(node.command(f"rm -rf {remote_dir} && mkdir -p {remote_dir} && "
+                                          f"tar -C {remote_dir} -xzf -"), archive.read())
+
+    def _build_on(self, job: RemoteJob, node: BuilderNode) -> subprocess.CompletedProcess:
+        base = f"{node.workdir}/{job.name}"
+        recipe = f"{base}/recipe"
+        bundle = f"{base}/packages.tgz"
+        ref = f"{self.package_name}/{job.config.openssl_version}"
+
+        result = self._upload_recipe(node, recipe)
+        if result.returncode != 0:
+            return result
+
+        create = " ".join(shlex.quote(a) for a in conan_create_args(job.config, node.profile))
+        result = self._run(node.command(
+            f"cd {recipe} && conan create . {create} > {base}/create.log 2>&1; status=$?; "
+            f"tail -n 40 {base}/create.log; "
+            f"[ $status -eq 0 ] && conan cache save {shlex.quote(ref + ':*')} --file {bundle}; "
+            f"exit $status"))
+        if result.returncode != 0 or not self.restore:
+            return result
+
+        local_bundle = self.log_dir / f"{job.name}.tgz"
+        fetched = self._run(node.fetch_command(bundle, local_bundle))
+        if fetched.returncode != 0:
+            return fetched
+        restored = self._run(["conan", "cache", "restore", str(local_bundle)])
+        local_bundle.unlink(missing_ok=True)
+        return restored
+
+    def _write_summary(self, path: Path, job: RemoteJob, status: str, started: datetime,
+                       finished: Optional[datetime] = None) -> None:
+        """build-summary-*.json in the format aggregate-build-logs.py prints"""
+        config = job.config
+        summary = {
+            "job_name": job.name,
+            "node": job.node,
+            "status": status,
+            "attempt": job.attempts,
+            "target": f"{config.platform.value}-{config.architecture}-{config.compiler.value}",
+            "shared": config.shared_libs,
+            "enable_fips": config.fips_enabled,
+            "jobs": None,
+            "install_prefix": f"{job.node}:{self.package_name}/{config.openssl_version}",
+            "started": started.isoformat().replace("+00:00", "Z"),
+            "finished": (finished or started).isoformat().replace("+00:00", "Z"),
+            "duration_seconds": ((finished or started) - started).total_seconds(),
+        }
+        if job.error:
+            summary["error"] = job.error
+        path.write_text(json.dumps(summary, indent=2), encoding="utf-8")
+
+    # -- scheduling ---------------------------------------------------------
+
+    def _pick_node(self, job: RemoteJob) -> Optional[BuilderNode]:
+        candidates = [n for n in self.nodes
+                      if n.healthy and n.busy < n.slots and n.can_build(job.config)]
+        if not candidates:
+            return None
+        # Prefer nodes this job has not failed on, then the least loaded one
+        return min(candidates, key=lambda n: (n.name in job.failed_on, n.busy / n.slots))
+
+    def _can_ever_run(self, job: RemoteJob) -> bool:
+        return any(n.healthy and n.can_build(job.config) for n in self.nodes)
+
+    def _execute(self, job: RemoteJob, node: BuilderNode, queue: List[RemoteJob]) -> None:
+        started = datetime.now(timezone.utc)
+        job.attempts += 1
+        job.node = node.name
+        job.error = None
+        # One file per attempt, rewritten when the attempt finishes
+        summary_path = self.log_dir / f"build-summary-{started.strftime('%Y%m%d-%H%M%S')}-{job.name}-{len(job.failed_on)}.json"
+        logger.info(f"🚀 {job.name} -> {node.name} (attempt {job.attempts})")
+
+        # Anything raised here must still release the node slot below
+        try:
+            self._write_summary(summary_path, job, "running", started)
+            result = self._build_on(job, node)
+            returncode = result.returncode
+            output = (result.stdout or b"").decode(errors="replace") + (result.stderr or b"").decode(errors="replace")
+        except subprocess.TimeoutExpired:
+            returncode, output = -1, f"timed out after {self.timeout}s"
+        except Exception as e:
+            returncode, output = -1, str(e)
+        finished = datetime.now(timezone.utc)
+        job.duration_seconds = (finished - started).total_seconds()
+        # Raw log next to the summary, picked up by aggregate-build-logs.py
+        try:
+            summary_path.with_suffix(".log").write_text(output, encoding="utf-8")
+        except OSError as e:
+            logger.warning(f"⚠️ Could not write the log of {job.name}: {e}")
+
+        with self._cond:
+            node.busy -= 1
+            if returncode == 0:
+                job.success = True
+                logger.info(f"✅ {job.name} on {node.name} ({job.duration_seconds:.0f}s)")
+            else:
+                lines = [line for line in output.strip().splitlines() if line.strip()]
+                job.error = lines[-1] if lines else f"exit code {returncode}"
+                job.failed_on.append(node.name)
+                if returncode == SSH_CONNECTION_ERROR and node.transport == "ssh":
+                    node.healthy = False
+                    logger.warning(f"⚠️ {node.name} unreachable, removed from pool: {job.error}")
+                    # A lost node does not count against the build itself
+                    job.attempts -= 1
+                    queue.append(job)
+                elif job.attempts <= self.retries:
+                    logger.warning(f"⚠️ {job.name} failed on {node.name}, retrying: {job.error}")
+                    queue.append(job)
+                else:
+                    logger.error(f"❌ {job.name} failed on {node.name}: {job.error}")
+            self._cond.notify_all()
+        try:
+            self._write_summary(summary_path, job, "success" if job.success else "failed", started, finished)
+        except OSError as e:
+            logger.warning(f"⚠️ Could not write the summary of {job.name}: {e}")
+
+    def run(self, configurations: List[BuildConfiguration], follow: bool = False) -> List[RemoteJob]:
+        """Build every configuration; returns the jobs with their final state"""
+        self.log_dir.mkdir(parents=True, exist_ok=True)
+        jobs = [RemoteJob(config=c, name=job_name(c)) for c in configurations]
+        queue = list(jobs)
+        threads: List[threading.Thread] = []
+
+        follower = None
+        if follow and AGGREGATE_SCRIPT.exists():
+            follower = subprocess.Popen([sys.executable, str(AGGREGATE_SCRIPT), str(self.log_dir),
+                                         "--follow", "--interval", "2"])
+
+        logger.info(f"📊 Dispatching {len(jobs)} builds to {len(self.nodes)} nodes")
+        try:
+            with self._cond:
+                while queue or any(t.is_alive() for t in threads):
+                    for job in list(queue):
+                        if not self._can_ever_run(job):
+                            queue.remove(job)
+                            job.error = job.error or "no healthy node for this platform/architecture"
+                            logger.error(f"❌ {job.name}: {job.error}")
+                            continue
+                        node = self._pick_node(job)
+                        if node is None:
+                            continue
+                        queue.remove(job)
+                        node.busy += 1
+                        thread = threading.Thread(target=self._execute, args=(job, node, queue),
+                                                  name=job.name, daemon=True)
+                        thread.start()
+                        threads.append(thread)
+                    self._cond.wait(timeout=1.0)
+        finally:
+            if follower:
+                time.sleep(2.5)
+                follower.terminate()
+
+        succeeded = sum(1 for job in jobs if job.success)
+        logger.info(f"🎉 Remote matrix finished: {succeeded}/{len(jobs)} successful")
+        return jobs
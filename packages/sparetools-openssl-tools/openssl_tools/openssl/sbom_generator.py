@@ -8,10 +8,13 @@ including SPDX, CycloneDX, and custom formats.
 
 import hashlib
 import json
+import mmap
 import os
 import re
 import subprocess
 import tempfile
+import threading
+from concurrent.futures import ThreadPoolExecutor
 from pathlib import Path
 from typing import Dict, List, Optional, Set, Tuple, Any, NamedTuple
 from dataclasses import dataclass, field
@@ -45,6 +48,216 @@ class LicenseType(Enum):
     CUSTOM = "custom"
 
 
+# Digests recorded per artifact, in one pass over each file
+HASH_ALGORITHMS = ("sha256", "sha512", "sha1")
+
+# CycloneDX / SPDX spellings of the hashlib names
+CYCLONEDX_HASH_NAMES = {"sha1": "SHA-1", "sha256": "SHA-256", "sha512": "SHA-512"}
+SPDX_HASH_NAMES = {"sha1": "SHA1", "sha256": "SHA256", "sha512": "SHA512"}
+
+MMAP_CHUNK_SIZE = 8 * 1024 * 1024
+
+
+def hash_file_multi(file_path: str, algorithms: Tuple[str, ...] = HASH_ALGORITHMS) -> Dict[str, str]:
+    """All requested digests of a file from a single memory-mapped read."""
+    hashers = {name: hashlib.new(name) for name in algorithms}
+    with open(file_path, 'rb') as f:
+        size = os.fstat(f.fileno()).st_size
+        if size:
+            with mmap.mmap(f.fileno(), 0, access=mmap.ACCESS_READ) as mapped:
+                view = memoryview(mapped)
+                try:
+                    for offset in range(0, size, MMAP_CHUNK_SIZE):
+                        with view[offset:offset + MMAP_CHUNK_SIZE] as chunk:
+                            for hasher in hashers.values():
+                                hasher.update(chunk)
+                finally:
+                    view.release()
+    return {name: hasher.hexdigest() for name, hasher in hashers.items()}
+
+
+class ArtifactHashCache:
+    """
+    Artifact digests keyed by path and (inode, size, mtime_ns), so an
+    unchanged library is not read again. Persisted as JSON when a path is
+    given, otherwise kept for the lifetime of the process.
+    """
+
+    def __init__(self, cache_path: Optional[str] = None):
+        self.cache_path = Path(cache_path) if cache_path else None
+        self.entries: Dict[str, Dict[str, Any]] = {}
+        self._lock = threading.Lock()
+        if self.cache_path and self.cache_path.exists():
+            try:
+                with open(self.cache_path, 'r') as f:
+                    self.entries = json.load(f)
+            except (OSError, ValueError):
+                self.entries = {}
+
+    @staticmethod
+    def _stamp(st: os.stat_result) -> List[int]:
+        return [st.st_ino, st.st_size, st.st_mtime_ns]
+
+    def hashes(self, file_path: str) -> Dict[str, str]:
+        """Digests of file_path, reading it only if it changed since last time."""
+        path = os.path.abspath(file_path)
+        st = os.stat(path)
+        with self._lock:
+            entry = self.entries.get(path)
+        if entry and entry["stamp"] == self._stamp(st) and all(a in entry["hashes"] for a in HASH_ALGORITHMS):
+            return entry["hashes"]
+        digests = hash_file_multi(path)
+        with self._lock:
+            self.entries[path] = {"stamp": self._stamp(st), "hashes": digests}
+        return digests
+
+    def save(self) -> None:
+        if not self.cache_path:
+            return
+        self.cache_path.parent.mkdir(parents=True, exist_ok=True)
+        tmp_path = self.cache_path.with_suffix(self.cache_path.suffix + ".tmp")
+        with self._lock, open(tmp_path, 'w') as f:
+            json.dump(self.entries, f)
+        os.replace(tmp_path, self.cache_path)
+
+
+# Shared by SBOMComponent.calculate_hash calls that do not pass a cache
+_PROCESS_HASH_CACHE = ArtifactHashCache()
+
+
+def hash_files_parallel(file_paths: List[str], cache: Optional[ArtifactHashCache] = None,
+                        workers: Optional[int] = None) -> Dict[str, Dict[str, str]]:
+    """Digests per path on a thread pool (hashlib releases the GIL on large buffers)."""
+    cache = cache or _PROCESS_HASH_CACHE
+    if len(file_paths) <= 1:
+        return {path: cache.hashes(path) for path in file_paths}
+    with ThreadPoolExecutor(max_workers=workers or min(8, os.cpu_count() or 1)) as pool:
+        return dict(zip(file_paths, pool.map(cache.hashes, file_paths)))
+
+
+# Top-level arrays holding components and relationships, per input format
+SBOM_COMPONENT_KEYS = ("components", "packages")
+SBOM_RELATIONSHIP_KEYS = ("relationships", "dependencies")
+
+STREAM_CHUNK_SIZE = 1024 * 1024
+
+
+def _iter_json_arrays_builtin(file_path: str, keys: Tuple[str, ...]):
+    """
+    (key, item) for every element of the top-level arrays named in keys,
+    decoding one element at a time from a bounded read buffer. Other
+    top-level values are decoded and discarded.
+    """
+    decoder = json.JSONDecoder()
+    with open(file_path, 'r', encoding='utf-8') as f:
+        buf, pos, eof = "", 0, False
+
+        def fill() -> bool:
+            nonlocal buf, pos, eof
+            if eof:
+                return False
+            chunk = f.read(STREAM_CHUNK_SIZE)
+            if not chunk:
+                eof = True
+                return False
+            buf, pos = buf[pos:] + chunk, 0
+            return True
+
+        def skip_ws() -> str:
+            nonlocal pos
+            while True:
+                while pos < len(buf) and buf[pos] in " \t\r\n":
+                    pos += 1
+                if pos < len(buf) or not fill():
+                    return buf[pos] if pos < len(buf) else ""
+
+        def decode() -> Any:
+            # A value ending exactly at the buffer end may be truncated ("12" of "123")
+            nonlocal pos
+            skip_ws()
+            while True:
+                try:
+                    value, end = decoder.raw_decode(buf, pos)
+                    if end < len(buf) or eof:
+                        pos = end
+                        return value
+                except json.JSONDecodeError:
+                    if eof:
+                        raise
+                fill()
+
+        def expect(chars: str) -> str:
+            nonlocal pos
+            char = skip_ws()
+            if not char or char not in chars:
+                raise ValueError(f"{file_path}: expected one of {chars!r} at offset {f.tell()}")
+            pos += 1
+            return char
+
+        expect("{")
+        if skip_ws() == "}":
+            return
+        while True:
+            key = decode()
+            expect(":")
+            if key in keys and skip_ws() == "[":
+                pos += 1
+                if skip_ws() == "]":
+                    pos += 1
+                else:
+                    while True:
+                        yield key, decode()
+                        if expect(",]") == "]":
+                            break
+            else:
+                decode()
+            if expect(",}") == "}":
+                return
+
+
+def iter_sbom_arrays(file_path: str, keys: Tuple[str, ...]):
+    """
+    Stream (key, item) pairs out of an SBOM's top-level arrays without
+    loading the document: ijson when installed, a built-in incremental
+    decoder otherwise.
+    """
+    try:
+        import ijson
+    except ImportError:
+        yield from _iter_json_arrays_builtin(file_path, keys)
+        return
+    for key in keys:
+        with open(file_path, 'rb') as f:
+            for item in ijson.items(f, f"{key}.item", use_float=True):
+                yield key, item
+
+
+def component_dedup_key(component: Dict[str, Any]) -> bytes:
+    """
+    Index key of a component: its purl and digests (CycloneDX hashes,
+    SPDX checksums, custom hashes/hash_value), falling back to name and
+    version when it has neither. Stored as a 16-byte BLAKE2b digest.
+    """
+    purl = component.get("purl") or next(
+        (ref.get("referenceLocator") for ref in component.get("externalRefs", [])
+         if ref.get("referenceType") == "purl"), None)
+    digests = []
+    for entry in component.get("hashes") or []:
+        if isinstance(entry, dict):
+            digests.append(f"{entry.get('alg', '')}:{entry.get('content', '')}".lower())
+    if isinstance(component.get("hashes"), dict):
+        digests.extend(f"{alg}:{value}".lower() for alg, value in component["hashes"].items())
+    for entry in component.get("checksums", []):
+        digests.append(f"{entry.get('algorithm', '')}:{entry.get('checksumValue', '')}".lower())
+    if not digests and component.get("hash_value"):
+        digests.append(f"sha256:{component['hash_value']}")
+    if purl or digests:
+        raw = json.dumps([purl, sorted(digests)])
+    else:
+        raw = f"{component.get('name')}:{component.get('version', component.get('versionInfo'))}"
+    return hashlib.blake2b(raw.encode(), digest_size=16).digest()
+
+
 @dataclass
 class SBOMComponent:
     """Represents a component in the SBOM."""
@@ -58,17 +271,21 @@ class SBOMComponent:
     download_location: Optional[str] = None
     hash_algorithm: str = "SHA256"
     hash_value: Optional[str] = None
+    hashes: Dict[str, str] = field(default_factory=dict)
     dependencies: List[str] = field(default_factory=list)
     metadata: Dict[str, Any] = field(default_factory=dict)
 
-    def calculate_hash(self, file_path: Optional[str] = None, data: Optional[bytes] = None) -> None:
-        """Calculate hash for the component."""
+    def calculate_hash(self, file_path: Optional[str] = None, data: Optional[bytes] = None,
+                       cache: Optional[ArtifactHashCache] = None) -> None:
+        """Calculate SHA-256/SHA-512/SHA-1 for the component in one pass."""
         if file_path and os.path.exists(file_path):
-            with open(file_path, 'rb') as f:
-                data = f.read()
+            self.set_hashes((cache or _PROCESS_HASH_CACHE).hashes(file_path))
+        elif data:
+            self.set_hashes({name: hashlib.new(name, data).hexdigest() for name in HASH_ALGORITHMS})
 
-        if data:
-            self.hash_value = hashlib.sha256(data).hexdigest()
+    def set_hashes(self, hashes: Dict[str, str]) -> None:
+        self.hashes = dict(hashes)
+        self.hash_value = self.hashes.get("sha256")
 
 
 @dataclass
@@ -119,33 +336,130 @@ class SBOMGenerator:
         }
     }
 
-    def __init__(self, openssl_source_path: Optional[str] = None, build_path: Optional[str] = None):
+    def __init__(self, openssl_source_path: Optional[str] = None, build_path: Optional[str] = None,
+                 hash_cache_path: Optional[str] = None, hash_workers: Optional[int] = None):
         """
         Initialize the SBOM generator.
 
         Args:
             openssl_source_path: Path to OpenSSL source directory
             build_path: Path to OpenSSL build directory
+            hash_cache_path: JSON file persisting artifact digests between runs
+            hash_workers: Threads hashing build artifacts (default: CPU count, at most 8)
         """
         self.openssl_source = Path(openssl_source_path) if openssl_source_path else None
         self.build_path = Path(build_path) if build_path else None
         self.components_cache: Dict[str, SBOMComponent] = {}
+        self.hash_cache = ArtifactHashCache(hash_cache_path) if hash_cache_path else _PROCESS_HASH_CACHE
+        self.hash_workers = hash_workers
+        self._begin_analysis()
+
+    def _begin_analysis(self, base_sbom: Optional[str] = None, changed_files: Optional[List[str]] = None,
+                        openssl_version: Optional[str] = None) -> None:
+        """
+        Reset the per-run analysis state: what this run analyzed (written to
+        metadata["analysis_state"]), the base SBOM's state and the change set.
+        """
+        self._analysis_state: Dict[str, Any] = {"tarball": None, "makefile": None, "artifacts": {}}
+        self._reuse_stats = {"reused": 0, "reanalyzed": 0}
+        self._base_state: Optional[Dict[str, Any]] = None
+        self._changed: Optional[Set[str]] = None
+
+        if changed_files is not None:
+            self._changed = set()
+            for path in changed_files:
+                if os.path.isabs(path):
+                    self._changed.add(os.path.abspath(path))
+                    continue
+                for root in (self.build_path, self.openssl_source):
+                    if root:
+                        self._changed.add(os.path.abspath(root / path))
+
+        if base_sbom:
+            base = self._load_base_state(base_sbom)
+            if base and base.get("openssl_version") != openssl_version:
+                print(f"Base SBOM documents OpenSSL {base.get('openssl_version')}, analyzing everything")
+                base = None
+            self._base_state = base["analysis_state"] if base else None
+
+    def _load_base_state(self, sbom_path: str) -> Optional[Dict[str, Any]]:
+        """
+        {"openssl_version", "analysis_state"} recorded in a previous custom
+        or CycloneDX export of this generator, None if it has none.
+        """
+        try:
+            with open(sbom_path, 'r') as f:
+                data = json.load(f)
+        except (OSError, ValueError) as e:
+            print(f"Warning: Could not load base SBOM {sbom_path}: {e}")
+            return None
+
+        if data.get("bomFormat") == "CycloneDX":
+            metadata = {}
+            for prop in data.get("metadata", {}).get("properties", []):
+                if prop.get("name", "").startswith("sparetools:"):
+                    try:
+                        metadata[prop["name"][len("sparetools:"):]] = json.loads(prop["value"])
+                    except (KeyError, ValueError):
+                        continue
+        else:
+            metadata = data.get("metadata", {})
+
+        if "analysis_state" not in metadata:
+            print(f"Warning: {sbom_path} has no analysis state (SPDX or older SBOM), analyzing everything")
+            return None
+        return {"openssl_version": metadata.get("openssl_version"), "analysis_state": metadata["analysis_state"]}
+
+    def _base_entry(self, section: str, key: Optional[str] = None) -> Optional[Dict[str, Any]]:
+        entry = (self._base_state or {}).get(section)
+        if key is not None:
+            entry = (entry or {}).get(key)
+        return entry
+
+    def _reusable(self, file_path: Path, entry: Optional[Dict[str, Any]]) -> bool:
+        """
+        Whether the base SBOM's analysis of file_path still holds: the file
+        is not in the change set, or without one, its (inode, size,
+        mtime_ns) stamp matches the recorded one.
+        """
+        if not entry:
+            return False
+        if self._changed is not None:
+            return os.path.abspath(file_path) not in self._changed
+        try:
+            return entry.get("stamp") == ArtifactHashCache._stamp(os.stat(file_path))
+        except OSError:
+            return False
 
     def generate_sbom(self,
                      format_type: SBOMFormat = SBOMFormat.SPDX,
                      openssl_version: str = "3.1.0",
-                     include_build_artifacts: bool = True) -> SBOMDocument:
+                     include_build_artifacts: bool = True,
+                     base_sbom: Optional[str] = None,
+                     changed_files: Optional[List[str]] = None) -> SBOMDocument:
         """
         Generate a comprehensive SBOM for OpenSSL.
 
+        With base_sbom, only changed inputs are re-analyzed: the source
+        tarball and build artifacts are rehashed and the Makefile reparsed
+        only if they changed since base_sbom was generated for the same
+        OpenSSL version; everything else is taken from its analysis state.
+
         Args:
             format_type: SBOM format to generate
             openssl_version: OpenSSL version being documented
             include_build_artifacts: Whether to include build artifacts
+            base_sbom: Previous custom or CycloneDX SBOM from this generator
+            changed_files: Paths known to have changed (absolute or relative
+                to the build/source directory), e.g. the list passed to
+                ArtifactLifecycleManager.invalidate_cache. Without it, files
+                whose stat-cache stamp (inode, size, mtime_ns) differs count.
 
         Returns:
             Complete SBOM document
         """
+        self._begin_analysis(base_sbom, changed_files, openssl_version)
+
         # Create main OpenSSL component
         openssl_component = self._create_openssl_component(openssl_version)
 
@@ -187,10 +501,16 @@ class SBOMGenerator:
                 "tool_name": "shared-dev-tools SBOM Generator",
                 "tool_version": "1.0.0",
                 "openssl_version": openssl_version,
-                "generation_date": datetime.now().isoformat()
+                "generation_date": datetime.now().isoformat(),
+                "analysis_state": self._analysis_state
             }
         )
 
+        if self._base_state is not None:
+            document.metadata["incremental"] = {"base_sbom": base_sbom, **self._reuse_stats}
+            print(f"Incremental SBOM: {self._reuse_stats['reused']} inputs reused, "
+                  f"{self._reuse_stats['reanalyzed']} re-analyzed")
+
         return document
 
     def _create_openssl_component(self, version: str) -> SBOMComponent:
@@ -210,7 +530,16 @@ class SBOMGenerator:
         if self.openssl_source:
             tarball_path = self._find_openssl_tarball()
             if tarball_path:
-                component.calculate_hash(tarball_path)
+                entry = self._base_entry("tarball")
+                if self._reusable(Path(tarball_path), entry) and entry.get("name") == os.path.basename(tarball_path):
+                    component.set_hashes(entry["hashes"])
+                    self._reuse_stats["reused"] += 1
+                else:
+                    component.calculate_hash(tarball_path, cache=self.hash_cache)
+                    self._reuse_stats["reanalyzed"] += 1
+                self._analysis_state["tarball"] = {"name": os.path.basename(tarball_path),
+                                                   "stamp": ArtifactHashCache._stamp(os.stat(tarball_path)),
+                                                   "hashes": component.hashes}
 
         return component
 
@@ -234,8 +563,18 @@ class SBOMGenerator:
             # Check Makefile or configure script for dependencies
             makefile_path = self.openssl_source / "Makefile"
             if makefile_path.exists():
-                deps = self._parse_makefile_dependencies(makefile_path)
-                for dep_name in deps:
+                entry = self._base_entry("makefile")
+                if self._reusable(makefile_path, entry):
+                    deps = set(entry["dependencies"])
+                    self._reuse_stats["reused"] += 1
+                else:
+                    deps = self._parse_makefile_dependencies(makefile_path)
+                    self._reuse_stats["reanalyzed"] += 1
+                self._analysis_state["makefile"] = {
+                    "stamp": ArtifactHashCache._stamp(os.stat(makefile_path)),
+                    "dependencies": sorted(d for d in deps if d in self.KNOWN_DEPENDENCIES)
+                }
+                for dep_name in sorted(deps):
                     if dep_name in self.KNOWN_DEPENDENCIES:
                         dep_info = self.KNOWN_DEPENDENCIES[dep_name]
                         component = SBOMComponent(
@@ -316,19 +655,54 @@ class SBOMGenerator:
             ("engines/*.so", ComponentType.LIBRARY, "OpenSSL engine modules")
         ]
 
+        artifacts = []
         for pattern, comp_type, description in artifact_patterns:
             for file_path in self.build_path.glob(pattern):
                 if file_path.is_file():
-                    component = SBOMComponent(
-                        name=file_path.name,
-                        version=self._get_file_version(file_path),
-                        component_type=comp_type,
-                        license=LicenseType.OPENSSL,
-                        supplier="OpenSSL Software Foundation",
-                        description=description
-                    )
-                    component.calculate_hash(str(file_path))
-                    components.append(component)
+                    artifacts.append((file_path, comp_type, description))
+
+        # Unchanged artifacts keep the base SBOM's digests and version
+        analyzed: Dict[Path, Tuple[Dict[str, str], str]] = {}
+        todo = []
+        for file_path, _, _ in artifacts:
+            entry = self._base_entry("artifacts", file_path.relative_to(self.build_path).as_posix())
+            if self._reusable(file_path, entry):
+                analyzed[file_path] = (entry["hashes"], entry["version"])
+            else:
+                todo.append(file_path)
+        self._reuse_stats["reused"] += len(analyzed)
+        self._reuse_stats["reanalyzed"] += len(todo)
+
+        # Hash and identify the rest concurrently, each file read once
+        def analyze(file_path: Path) -> Tuple[Dict[str, str], str]:
+            return self.hash_cache.hashes(str(file_path)), self._get_file_version(file_path)
+
+        workers = self.hash_workers or min(8, os.cpu_count() or 1)
+        if len(todo) > 1 and workers > 1:
+            with ThreadPoolExecutor(max_workers=workers) as pool:
+                analyzed.update(zip(todo, pool.map(analyze, todo)))
+        else:
+            analyzed.update((file_path, analyze(file_path)) for file_path in todo)
+        if todo:
+            self.hash_cache.save()
+
+        for file_path, comp_type, description in artifacts:
+            hashes, version = analyzed[file_path]
+            relative = file_path.relative_to(self.build_path).as_posix()
+            self._analysis_state["artifacts"][relative] = {
+                "stamp": ArtifactHashCache._stamp(os.stat(file_path)), "hashes": hashes, "version": version
+            }
+            component = SBOMComponent(
+                name=file_path.name,
+                version=version,
+                component_type=comp_type,
+                license=LicenseType.OPENSSL,
+                supplier="OpenSSL Software Foundation",
+                description=description
+            )
+            component.set_hashes(hashes)
+            component.metadata["path"] = relative
+            components.append(component)
 
         return components
 
@@ -402,6 +776,10 @@ class SBOMGenerator:
             if component.description:
                 package["description"] = component.description
 
+            if component.hashes:
+                package["checksums"] = [{"algorithm": SPDX_HASH_NAMES[alg], "checksumValue": value}
+                                        for alg, value in component.hashes.items() if alg in SPDX_HASH_NAMES]
+
             spdx_data["packages"].append(package)
 
         with open(output_path, 'w') as f:
@@ -425,7 +803,11 @@ class SBOMGenerator:
                     "type": "library",
                     "name": document.name,
                     "version": document.version
-                }
+                },
+                # Generator metadata (including the analysis state that
+                # generate_sbom(base_sbom=...) reuses) as JSON properties
+                "properties": [{"name": f"sparetools:{key}", "value": json.dumps(value)}
+                               for key, value in document.metadata.items()]
             },
             "components": []
         }
@@ -448,7 +830,14 @@ class SBOMGenerator:
             if component.description:
                 comp_data["description"] = component.description
 
-            if component.hash_value:
+            if component.metadata:
+                comp_data["properties"] = [{"name": f"sparetools:{key}", "value": json.dumps(value)}
+                                           for key, value in component.metadata.items()]
+
+            if component.hashes:
+                comp_data["hashes"] = [{"alg": CYCLONEDX_HASH_NAMES[alg], "content": value}
+                                       for alg, value in component.hashes.items() if alg in CYCLONEDX_HASH_NAMES]
+            elif component.hash_value:
                 comp_data["hashes"] = [{
                     "alg": component.hash_algorithm,
                     "content": component.hash_value
@@ -465,7 +854,7 @@ class SBOMGenerator:
 
         # Convert enums to values
         custom_data["format"] = document.format.value
-        custom_data["components"] = [comp.__dict__ for comp in document.components]
+        custom_data["components"] = [dict(comp.__dict__) for comp in document.components]
 
         for comp in custom_data["components"]:
             comp["component_type"] = comp["component_type"].value
@@ -530,56 +919,83 @@ class SBOMGenerator:
 
         return errors
 
-    def merge_sboms(self, sbom_paths: List[str], output_path: str) -> None:
+    def merge_sboms_streaming(self, sbom_paths: List[str], output_path: str,
+                              output_format: SBOMFormat = SBOMFormat.CUSTOM) -> Dict[str, int]:
         """
-        Merge multiple SBOM files into a single comprehensive SBOM.
+        Merge SBOM files with memory bounded by the number of unique
+        components (16 bytes each), not by document size.
+
+        Components ("components" / SPDX "packages") are read one at a time
+        with iter_sbom_arrays, deduplicated through a hash index on
+        component_dedup_key (purl + digests) and written to output_path as
+        they arrive. Relationships (CycloneDX "dependencies" too) are
+        spooled to a temporary file and appended after the components.
+        Items keep their input schema; merge inputs of one format.
 
         Args:
             sbom_paths: List of SBOM file paths to merge
             output_path: Path to save the merged SBOM
+            output_format: Document layout: CycloneDX, SPDX or custom
+
+        Returns:
+            Counts of components read, written and relationships
         """
-        merged_components = []
-        merged_relationships = []
-        seen_components = set()
+        now = datetime.now().isoformat()
+        if output_format == SBOMFormat.CYCLONEDX:
+            header = {"bomFormat": "CycloneDX", "specVersion": "1.4", "version": 1,
+                      "metadata": {"timestamp": now, "tools": [{"vendor": "shared-dev-tools",
+                                                                 "name": "SBOM Merger", "version": "1.0.0"}]}}
+            component_key, relationship_key = "components", "dependencies"
+        elif output_format == SBOMFormat.SPDX:
+            header = {"spdxVersion": "SPDX-2.3", "dataLicense": "CC0-1.0", "SPDXID": "SPDXRef-DOCUMENT",
+                      "documentName": "Merged-OpenSSL-SBOM",
+                      "documentNamespace": f"urn:merged-openssl:sbom:{now}",
+                      "creationInfo": {"created": now, "creators": ["Tool: OpenSSL SBOM Merger"]}}
+            component_key, relationship_key = "packages", "relationships"
+        else:
+            header = {"format": "custom", "version": "1.0", "name": "Merged-OpenSSL-SBOM",
+                      "namespace": f"urn:merged-openssl:sbom:{now}", "creation_timestamp": now,
+                      "creators": ["OpenSSL SBOM Merger"],
+                      "metadata": {"merged_from": sbom_paths, "merge_timestamp": now}}
+            component_key, relationship_key = "components", "relationships"
+
+        seen: Set[bytes] = set()
+        stats = {"components_read": 0, "components_written": 0, "relationships": 0}
+        with open(output_path, 'w') as out, tempfile.TemporaryFile('w+') as spool:
+            out.write(json.dumps(header)[:-1] + f', "{component_key}": [\n')
+            for sbom_path in sbom_paths:
+                try:
+                    for key, item in iter_sbom_arrays(sbom_path, SBOM_COMPONENT_KEYS + SBOM_RELATIONSHIP_KEYS):
+                        if key in SBOM_RELATIONSHIP_KEYS:
+                            spool.write(json.dumps(item) + "\n")
+                            stats["relationships"] += 1
+                            continue
+                        stats["components_read"] += 1
+                        dedup_key = component_dedup_key(item)
+                        if dedup_key in seen:
+                            continue
+                        seen.add(dedup_key)
+                        out.write((",\n" if stats["components_written"] else "") + json.dumps(item))
+                        stats["components_written"] += 1
+                except Exception as e:
+                    print(f"Warning: Could not process SBOM {sbom_path}: {e}")
+
+            out.write(f'\n], "{relationship_key}": [\n')
+            spool.seek(0)
+            for index, line in enumerate(spool):
+                out.write((",\n" if index else "") + line.rstrip("\n"))
+            out.write("\n]}\n")
+        return stats
 
-        for sbom_path in sbom_paths:
-            try:
-                with open(sbom_path, 'r') as f:
-                    sbom_data = json.load(f)
-
-                # Extract components
-                if "components" in sbom_data:
-                    for comp in sbom_data["components"]:
-                        comp_key = f"{comp['name']}:{comp['version']}"
-                        if comp_key not in seen_components:
-                            merged_components.append(comp)
-                            seen_components.add(comp_key)
-
-                # Extract relationships if available
-                if "relationships" in sbom_data:
-                    merged_relationships.extend(sbom_data["relationships"])
-
-            except Exception as e:
-                print(f"Warning: Could not process SBOM {sbom_path}: {e}")
-
-        # Create merged SBOM
-        merged_sbom = {
-            "format": "custom",
-            "version": "1.0",
-            "name": "Merged-OpenSSL-SBOM",
-            "namespace": f"urn:merged-openssl:sbom:{datetime.now().isoformat()}",
-            "creation_timestamp": datetime.now().isoformat(),
-            "creators": ["OpenSSL SBOM Merger"],
-            "components": merged_components,
-            "relationships": merged_relationships,
-            "metadata": {
-                "merged_from": sbom_paths,
-                "merge_timestamp": datetime.now().isoformat()
-            }
-        }
+    def merge_sboms(self, sbom_paths: List[str], output_path: str) -> None:
+        """
+        Merge multiple SBOM files into a single comprehensive SBOM.
 
-        with open(output_path, 'w') as f:
-            json.dump(merged_sbom, f, indent=2)
+        Args:
+            sbom_paths: List of SBOM file paths to merge
+            output_path: Path to save the merged SBOM
+        """
+        stats = self.merge_sboms_streaming(sbom_paths, output_path)
 
         print(f"Merged SBOM saved to: {output_path}")
-        print(f"Total components: {len(merged_components)}")
+        print(f"Total components: {stats['components_written']}")
@@ -41,7 +41,7 @@ def main() -> int:
     )
 
     started = dt.datetime.utcnow()
-    run_hybrid_build(config)
+    stages = run_hybrid_build(config)
     finished = dt.datetime.utcnow()
 
     if args.log_dir:
@@ -58,6 +58,8 @@ def main() -> int:
             "started": started.isoformat() + "Z",
             "finished": finished.isoformat() + "Z",
             "duration_seconds": (finished - started).total_seconds(),
+            # Overlapping stages: start_seconds is the offset from the build start
+            "stages": stages,
         }
         summary_path.write_text(json.dumps(summary, indent=2), encoding="utf-8")
 
@@ -2,6 +2,18 @@
 """
 Artifact Lifecycle Manager for OpenSSL Conan packages
 Ensures proper cache invalidation and artifact lifecycle management
+
+The registry is a SQLite database (artifact-registry.sqlite3) with
+indexed edge tables: the source files each artifact was built from, the
+binary settings it depends on, and its dependencies (other artifacts or
+package references). Invalidation is a few indexed queries. The changed
+files are matched against the source edges, including their parent
+directories. Artifacts that depend on an invalidated one, directly or
+transitively, follow through a recursive query over the dependency
+index. A change to a global build input (the cache_invalidation patterns,
+e.g. conanfile.py) still invalidates everything, as one UPDATE.
+Checksums are computed for all algorithms in one read of the file.
+An existing artifact-registry.json is imported on first use.
 """
 
 import os
@@ -9,27 +21,140 @@ import sys
 import json
 import yaml
 import hashlib
+import sqlite3
 import subprocess
 from pathlib import Path
 from typing import Dict, List, Optional, Tuple
 import argparse
 from datetime import datetime, timedelta
 
+try:
+    from openssl_tools.config_snapshot import load_config
+except ImportError:  # Run as a script without openssl_tools installed
+    def load_config(path, default=None):
+        if not os.path.exists(path):
+            return default
+        with open(path, 'r') as f:
+            return yaml.safe_load(f)
+
+_SCHEMA = """
+CREATE TABLE IF NOT EXISTS artifacts (
+    id TEXT PRIMARY KEY,
+    type TEXT,
+    stage TEXT,
+    status TEXT NOT NULL DEFAULT 'active',
+    path TEXT,
+    created_at TEXT NOT NULL,
+    invalidated_at TEXT,
+    entry TEXT NOT NULL
+);
+CREATE TABLE IF NOT EXISTS artifact_sources (
+    artifact_id TEXT NOT NULL REFERENCES artifacts(id) ON DELETE CASCADE,
+    path TEXT NOT NULL,
+    PRIMARY KEY (artifact_id, path)
+);
+CREATE TABLE IF NOT EXISTS artifact_settings (
+    artifact_id TEXT NOT NULL REFERENCES artifacts(id) ON DELETE CASCADE,
+    setting TEXT NOT NULL,
+    PRIMARY KEY (artifact_id, setting)
+);
+CREATE TABLE IF NOT EXISTS artifact_dependencies (
+    artifact_id TEXT NOT NULL REFERENCES artifacts(id) ON DELETE CASCADE,
+    dependency TEXT NOT NULL,
+    name TEXT NOT NULL,
+    PRIMARY KEY (artifact_id, dependency)
+);
+CREATE INDEX IF NOT EXISTS artifacts_stage ON artifacts (stage, created_at);
+CREATE INDEX IF NOT EXISTS artifacts_status ON artifacts (status);
+CREATE INDEX IF NOT EXISTS artifact_sources_path ON artifact_sources (path);
+CREATE INDEX IF NOT EXISTS artifact_settings_setting ON artifact_settings (setting);
+CREATE INDEX IF NOT EXISTS artifact_dependencies_dependency ON artifact_dependencies (dependency);
+CREATE INDEX IF NOT EXISTS artifact_dependencies_name ON artifact_dependencies (name);
+"""
+
+# Artifacts on top of the seed set that depend on it, transitively
+_DEPENDENTS_QUERY = """
+WITH RECURSIVE affected(id) AS (
+    SELECT value FROM temp.seed
+    UNION
+    SELECT d.artifact_id FROM artifact_dependencies d JOIN affected a ON d.dependency = a.id
+)
+SELECT a.id FROM affected JOIN artifacts a ON a.id = affected.id WHERE a.status != 'invalidated'
+"""
+
+CHECKSUM_CHUNK_SIZE = 1024 * 1024
+# Invalidated artifacts printed one per line before summarizing
+INVALIDATION_LOG_LIMIT = 20
+
+
+def _source_key(path: str) -> str:
+    return os.path.normpath(path).replace(os.sep, '/')
+
+
+def _with_parents(path: str) -> List[str]:
+    """path and each of its parent directories"""
+    parts = _source_key(path).split('/')
+    return ['/'.join(parts[:i]) for i in range(len(parts), 0, -1)]
+
 
 class ArtifactLifecycleManager:
     """Manages artifact lifecycle and cache invalidation"""
     
-    def __init__(self, config_file: str = "conan-dev/artifact-lifecycle.yml"):
+    def __init__(self, config_file: str = "conan-dev/artifact-lifecycle.yml",
+                 registry_path: str = "artifact-registry.sqlite3"):
         self.config_file = config_file
         self.config = self._load_config()
-        self.artifact_registry = {}
+        self.registry_path = registry_path
+        self._db = sqlite3.connect(registry_path)
+        self._db.execute("PRAGMA journal_mode=WAL")
+        self._db.execute("PRAGMA synchronous=NORMAL")
+        self._db.execute("PRAGMA foreign_keys=ON")
+        self._db.executescript(_SCHEMA)
+        self._import_json_registry('artifact-registry.json')
+    
+    def close(self):
+        self._db.close()
+    
+    @property
+    def artifact_registry(self) -> Dict[str, Dict]:
+        """All registry entries by id (loads the whole registry)"""
+        return {row[0]: self._entry(row) for row in
+                self._db.execute("SELECT id, entry, status, invalidated_at FROM artifacts")}
+    
+    @staticmethod
+    def _entry(row) -> Dict:
+        entry = json.loads(row[1])
+        entry['status'] = row[2]
+        if row[3]:
+            entry['invalidated_at'] = row[3]
+        return entry
+    
+    def get_artifact(self, artifact_id: str) -> Optional[Dict]:
+        row = self._db.execute("SELECT id, entry, status, invalidated_at FROM artifacts WHERE id = ?",
+                               (artifact_id,)).fetchone()
+        return self._entry(row) if row else None
+    
+    def _import_json_registry(self, registry_file: str):
+        """Carry over the JSON registry of earlier versions, once"""
+        if not os.path.exists(registry_file):
+            return
+        if self._db.execute("SELECT 1 FROM artifacts LIMIT 1").fetchone():
+            return
+        try:
+            with open(registry_file, 'r') as f:
+                entries = json.load(f)
+        except (OSError, ValueError) as e:
+            print(f"Warning: Could not import {registry_file}: {e}")
+            return
+        with self._db:
+            for entry in entries.values():
+                self._store_entry(entry)
+        print(f"✓ Imported {len(entries)} artifacts from {registry_file}")
         
     def _load_config(self) -> Dict:
         """Load artifact lifecycle configuration"""
-        if os.path.exists(self.config_file):
-            with open(self.config_file, 'r') as f:
-                return yaml.safe_load(f)
-        return self._get_default_config()
+        config = load_config(self.config_file)
+        return config if config is not None else self._get_default_config()
     
     def _get_default_config(self) -> Dict:
         """Get default artifact lifecycle configuration"""
@@ -67,13 +192,13 @@ class ArtifactLifecycleManager:
                 'metadata': metadata,
                 'checksums': self._calculate_checksums(metadata.get('path', '')),
                 'dependencies': metadata.get('dependencies', []),
+                'sources': metadata.get('sources', []),
                 'cache_keys': metadata.get('cache_keys', {})
             }
             
-            self.artifact_registry[artifact_id] = artifact_entry
-            
-            # Save to persistent storage
-            self._save_artifact_registry()
+            # Entry and its edges in one transaction
+            with self._db:
+                self._store_entry(artifact_entry)
             
             print(f"✓ Tracked artifact {artifact_id} in stage {stage}")
             return True
@@ -82,34 +207,55 @@ class ArtifactLifecycleManager:
             print(f"❌ Failed to track artifact {artifact_id}: {e}")
             return False
     
+    def _store_entry(self, entry: Dict):
+        """Insert or replace an entry and its index edges (caller holds the transaction)"""
+        artifact_id = entry['id']
+        self._db.execute("DELETE FROM artifacts WHERE id = ?", (artifact_id,))
+        self._db.execute(
+            "INSERT INTO artifacts (id, type, stage, status, path, created_at, invalidated_at, entry) "
+            "VALUES (?, ?, ?, ?, ?, ?, ?, ?)",
+            (artifact_id, entry.get('type'), entry.get('stage'), entry.get('status', 'active'),
+             entry.get('metadata', {}).get('path'), entry.get('created_at') or datetime.now().isoformat(),
+             entry.get('invalidated_at'), json.dumps(entry)))
+        self._db.executemany("INSERT OR IGNORE INTO artifact_sources VALUES (?, ?)",
+                             [(artifact_id, _source_key(p)) for p in entry.get('sources', [])])
+        binary_keys = entry.get('cache_keys', {}).get('binary')
+        if isinstance(binary_keys, dict):
+            self._db.executemany("INSERT OR IGNORE INTO artifact_settings VALUES (?, ?)",
+                                 [(artifact_id, setting) for setting in binary_keys])
+        self._db.executemany("INSERT OR IGNORE INTO artifact_dependencies VALUES (?, ?, ?)",
+                             [(artifact_id, str(d), str(d).split('/')[0])
+                              for d in entry.get('dependencies', [])])
+    
     def _calculate_checksums(self, file_path: str) -> Dict[str, str]:
-        """Calculate checksums for artifact"""
+        """Calculate checksums for artifact, every algorithm in one read"""
         checksums = {}
         
-        if not os.path.exists(file_path):
+        if not os.path.isfile(file_path):
             return checksums
         
-        algorithms = self.config['artifacts']['checksum_algorithms']
-        
-        for algorithm in algorithms:
+        hashers = {}
+        for algorithm in self.config['artifacts']['checksum_algorithms']:
             try:
-                hash_func = getattr(hashlib, algorithm)()
-                with open(file_path, 'rb') as f:
-                    for chunk in iter(lambda: f.read(4096), b""):
-                        hash_func.update(chunk)
-                checksums[algorithm] = hash_func.hexdigest()
-            except Exception as e:
+                hashers[algorithm] = hashlib.new(algorithm)
+            except ValueError as e:
                 print(f"Warning: Could not calculate {algorithm} for {file_path}: {e}")
         
-        return checksums
+        try:
+            with open(file_path, 'rb') as f:
+                for chunk in iter(lambda: f.read(CHECKSUM_CHUNK_SIZE), b""):
+                    for hash_func in hashers.values():
+                        hash_func.update(chunk)
+        except OSError as e:
+            print(f"Warning: Could not read {file_path}: {e}")
+            return checksums
+        
+        return {algorithm: h.hexdigest() for algorithm, h in hashers.items()}
     
     def invalidate_cache(self, change_type: str, changed_files: List[str]) -> List[str]:
         """Invalidate cache based on change type and files"""
         print(f"🔄 Invalidating cache for {change_type} changes...")
         
-        invalidated_artifacts = []
-        invalidation_rules = self.config['lifecycle']['cache_invalidation']
-        
         # Determine what needs to be invalidated
         if change_type == 'source':
             affected_artifacts = self._find_artifacts_by_source_changes(changed_files)
@@ -119,91 +265,105 @@ class ArtifactLifecycleManager:
             affected_artifacts = self._find_artifacts_by_dependency_changes(changed_files)
         else:
             # Full invalidation
-            affected_artifacts = list(self.artifact_registry.keys())
+            affected_artifacts = self._active_artifacts()
         
-        # Invalidate affected artifacts
-        for artifact_id in affected_artifacts:
-            if self._invalidate_artifact(artifact_id):
-                invalidated_artifacts.append(artifact_id)
+        invalidated_artifacts = self._invalidate_artifacts(affected_artifacts)
         
         print(f"✓ Invalidated {len(invalidated_artifacts)} artifacts")
         return invalidated_artifacts
     
+    def _active_artifacts(self) -> List[str]:
+        return [row[0] for row in self._db.execute("SELECT id FROM artifacts WHERE status != 'invalidated'")]
+    
+    def _with_dependents(self, seed: List[str]) -> List[str]:
+        """seed plus every active artifact depending on it, directly or transitively"""
+        self._db.execute("CREATE TEMP TABLE IF NOT EXISTS seed (value TEXT PRIMARY KEY)")
+        self._db.execute("DELETE FROM temp.seed")
+        self._db.executemany("INSERT OR IGNORE INTO temp.seed VALUES (?)", [(s,) for s in seed])
+        return [row[0] for row in self._db.execute(_DEPENDENTS_QUERY)]
+    
+    def _edge_matches(self, query: str, values: List[str]) -> List[str]:
+        """Artifact ids from an edge query over temp.changed"""
+        self._db.execute("CREATE TEMP TABLE IF NOT EXISTS changed (value TEXT PRIMARY KEY)")
+        self._db.execute("DELETE FROM temp.changed")
+        self._db.executemany("INSERT OR IGNORE INTO temp.changed VALUES (?)", [(v,) for v in values])
+        return [row[0] for row in self._db.execute(query)]
+    
+    @staticmethod
+    def _matches_global_input(changed_files: List[str], patterns: List[str]) -> bool:
+        return any(pattern in changed_file for changed_file in changed_files for pattern in patterns)
+    
     def _find_artifacts_by_source_changes(self, changed_files: List[str]) -> List[str]:
         """Find artifacts affected by source changes"""
-        affected = []
         source_patterns = self.config['lifecycle']['cache_invalidation']['source_changes']
+        if self._matches_global_input(changed_files, source_patterns):
+            return self._active_artifacts()
         
-        for artifact_id, artifact in self.artifact_registry.items():
-            cache_keys = artifact.get('cache_keys', {})
-            source_key = cache_keys.get('source', '')
-            
-            # Check if any changed file affects this artifact
-            for changed_file in changed_files:
-                if any(pattern in changed_file for pattern in source_patterns):
-                    affected.append(artifact_id)
-                    break
-        
-        return affected
+        # Sources recorded as a file or as a directory containing it
+        keys = [key for changed_file in changed_files for key in _with_parents(changed_file)]
+        seed = self._edge_matches(
+            "SELECT DISTINCT s.artifact_id FROM temp.changed c JOIN artifact_sources s ON s.path = c.value", keys)
+        return self._with_dependents(seed)
     
     def _find_artifacts_by_binary_changes(self, changed_files: List[str]) -> List[str]:
         """Find artifacts affected by binary changes"""
-        affected = []
         binary_patterns = self.config['lifecycle']['cache_invalidation']['binary_changes']
+        if self._matches_global_input(changed_files, binary_patterns):
+            return self._active_artifacts()
         
-        for artifact_id, artifact in self.artifact_registry.items():
-            cache_keys = artifact.get('cache_keys', {})
-            binary_key = cache_keys.get('binary', '')
-            
-            # Check if any changed file affects this artifact
-            for changed_file in changed_files:
-                if any(pattern in changed_file for pattern in binary_patterns):
-                    affected.append(artifact_id)
-                    break
-        
-        return affected
+        seed = self._edge_matches(
+            "SELECT DISTINCT s.artifact_id FROM temp.changed c JOIN artifact_settings s ON s.setting = c.value",
+            changed_files)
+        return self._with_dependents(seed)
     
     def _find_artifacts_by_dependency_changes(self, changed_files: List[str]) -> List[str]:
         """Find artifacts affected by dependency changes"""
-        affected = []
         dep_patterns = self.config['lifecycle']['cache_invalidation']['dependency_changes']
+        if self._matches_global_input(changed_files, dep_patterns):
+            return self._active_artifacts()
         
-        for artifact_id, artifact in self.artifact_registry.items():
-            dependencies = artifact.get('dependencies', [])
-            
-            # Check if any changed file affects dependencies
-            for changed_file in changed_files:
-                if any(pattern in changed_file for pattern in dep_patterns):
-                    affected.append(artifact_id)
-                    break
-        
-        return affected
+        # Full reference, bare package name or artifact id
+        seed = self._edge_matches(
+            "SELECT d.artifact_id FROM temp.changed c JOIN artifact_dependencies d ON d.dependency = c.value "
+            "UNION SELECT d.artifact_id FROM temp.changed c JOIN artifact_dependencies d ON d.name = c.value "
+            "UNION SELECT a.id FROM temp.changed c JOIN artifacts a ON a.id = c.value",
+            changed_files)
+        return self._with_dependents(seed)
     
     def _invalidate_artifact(self, artifact_id: str) -> bool:
         """Invalidate a specific artifact"""
+        return bool(self._invalidate_artifacts([artifact_id]))
+    
+    def _invalidate_artifacts(self, artifact_ids: List[str]) -> List[str]:
+        """Mark artifacts invalidated in one transaction and drop them from the caches"""
         try:
-            if artifact_id not in self.artifact_registry:
-                return False
-            
-            artifact = self.artifact_registry[artifact_id]
-            
-            # Mark as invalidated
-            artifact['invalidated_at'] = datetime.now().isoformat()
-            artifact['status'] = 'invalidated'
-            
-            # Remove from cache
+            now = datetime.now().isoformat()
+            with self._db:
+                self._db.execute("CREATE TEMP TABLE IF NOT EXISTS seed (value TEXT PRIMARY KEY)")
+                self._db.execute("DELETE FROM temp.seed")
+                self._db.executemany("INSERT OR IGNORE INTO temp.seed VALUES (?)", [(i,) for i in artifact_ids])
+                rows = self._db.execute(
+                    "SELECT id, entry, status, invalidated_at FROM artifacts "
+                    "WHERE id IN (SELECT value FROM temp.seed) AND status != 'invalidated'").fetchall()
+                self._db.execute(
+                    "UPDATE artifacts SET status = 'invalidated', invalidated_at = ? "
+                    "WHERE id IN (SELECT value FROM temp.seed) AND status != 'invalidated'", (now,))
+        except sqlite3.Error as e:
+            print(f"  ❌ Failed to invalidate artifacts: {e}")
+            return []
+        
+        artifacts = [self._entry(row) for row in rows]
+        for artifact in artifacts:
             self._remove_artifact_from_cache(artifact)
-            
-            # Update registry
-            self.artifact_registry[artifact_id] = artifact
-            self._save_artifact_registry()
-            
-            print(f"  ✓ Invalidated artifact {artifact_id}")
-            return True
-            
-        except Exception as e:
-            print(f"  ❌ Failed to invalidate artifact {artifact_id}: {e}")
-            return False
+        # One compiler cache flush covers the whole batch
+        if artifacts and 'CCACHE_DIR' in os.environ:
+            subprocess.run(['ccache', '-C'], check=False, capture_output=True)
+        
+        for artifact in artifacts[:INVALIDATION_LOG_LIMIT]:
+            print(f"  ✓ Invalidated artifact {artifact['id']}")
+        if len(artifacts) > INVALIDATION_LOG_LIMIT:
+            print(f"  ... and {len(artifacts) - INVALIDATION_LOG_LIMIT} more")
+        return [artifact['id'] for artifact in artifacts]
     
     def _remove_artifact_from_cache(self, artifact: Dict):
         """Remove artifact from cache"""
@@ -214,10 +374,6 @@ class ArtifactLifecycleManager:
                 subprocess.run(['conan', 'cache', 'clean', artifact_path], 
                              check=False, capture_output=True)
             
-            # Remove from compiler cache if applicable
-            if 'CCACHE_DIR' in os.environ:
-                subprocess.run(['ccache', '-C'], check=False, capture_output=True)
-            
         except Exception as e:
             print(f"Warning: Could not remove artifact from cache: {e}")
     
@@ -228,17 +384,14 @@ class ArtifactLifecycleManager:
         cleaned_count = 0
         retention_policies = self.config['lifecycle']['retention_policies']
         
-        for artifact_id, artifact in list(self.artifact_registry.items()):
-            stage = artifact.get('stage', 'development')
-            created_at = datetime.fromisoformat(artifact.get('created_at', ''))
-            
-            if stage in retention_policies:
-                policy = retention_policies[stage]
-                max_age = timedelta(days=policy['days'])
-                
-                if datetime.now() - created_at > max_age:
-                    if self._cleanup_artifact(artifact_id, artifact):
-                        cleaned_count += 1
+        for stage, policy in retention_policies.items():
+            cutoff = (datetime.now() - timedelta(days=policy['days'])).isoformat()
+            rows = self._db.execute(
+                "SELECT id, entry, status, invalidated_at FROM artifacts WHERE stage = ? AND created_at < ?",
+                (stage, cutoff)).fetchall()
+            for row in rows:
+                if self._cleanup_artifact(row[0], self._entry(row)):
+                    cleaned_count += 1
         
         print(f"✓ Cleaned up {cleaned_count} old artifacts")
         return cleaned_count
@@ -255,9 +408,9 @@ class ArtifactLifecycleManager:
                     import shutil
                     shutil.rmtree(artifact_path)
             
-            # Remove from registry
-            del self.artifact_registry[artifact_id]
-            self._save_artifact_registry()
+            # Remove from registry (edges cascade)
+            with self._db:
+                self._db.execute("DELETE FROM artifacts WHERE id = ?", (artifact_id,))
             
             print(f"  ✓ Cleaned up artifact {artifact_id}")
             return True
@@ -266,55 +419,44 @@ class ArtifactLifecycleManager:
             print(f"  ❌ Failed to cleanup artifact {artifact_id}: {e}")
             return False
     
-    def _save_artifact_registry(self):
-        """Save artifact registry to persistent storage"""
-        registry_file = 'artifact-registry.json'
-        with open(registry_file, 'w') as f:
-            json.dump(self.artifact_registry, f, indent=2)
-    
     def generate_lifecycle_report(self) -> Dict:
         """Generate artifact lifecycle report"""
         print("📊 Generating lifecycle report...")
         
         report = {
             'timestamp': datetime.now().isoformat(),
-            'total_artifacts': len(self.artifact_registry),
+            'total_artifacts': self._db.execute("SELECT COUNT(*) FROM artifacts").fetchone()[0],
             'by_stage': {},
             'by_type': {},
             'retention_status': {},
             'cache_status': {}
         }
         
-        # Analyze by stage
-        for artifact in self.artifact_registry.values():
-            stage = artifact.get('stage', 'unknown')
-            artifact_type = artifact.get('type', 'unknown')
-            
-            if stage not in report['by_stage']:
-                report['by_stage'][stage] = 0
-            report['by_stage'][stage] += 1
-            
-            if artifact_type not in report['by_type']:
-                report['by_type'][artifact_type] = 0
-            report['by_type'][artifact_type] += 1
+        # Analyze by stage and type
+        for stage, count in self._db.execute(
+                "SELECT COALESCE(stage, 'unknown'), COUNT(*) FROM artifacts GROUP BY 1"):
+            report['by_stage'][stage] = count
+        for artifact_type, count in self._db.execute(
+                "SELECT COALESCE(type, 'unknown'), COUNT(*) FROM artifacts GROUP BY 1"):
+            report['by_type'][artifact_type] = count
+        for status, count in self._db.execute("SELECT status, COUNT(*) FROM artifacts GROUP BY 1"):
+            report['cache_status'][status] = count
         
         # Check retention status
         retention_policies = self.config['lifecycle']['retention_policies']
         for stage, policy in retention_policies.items():
-            max_age = timedelta(days=policy['days'])
+            cutoff = (datetime.now() - timedelta(days=policy['days'])).isoformat()
             max_versions = policy['versions']
             
-            stage_artifacts = [a for a in self.artifact_registry.values() 
-                             if a.get('stage') == stage]
-            
-            old_artifacts = [a for a in stage_artifacts 
-                           if datetime.now() - datetime.fromisoformat(a.get('created_at', '')) > max_age]
+            total, old = self._db.execute(
+                "SELECT COUNT(*), COALESCE(SUM(created_at < ?), 0) FROM artifacts WHERE stage = ?",
+                (cutoff, stage)).fetchone()
             
             report['retention_status'][stage] = {
-                'total': len(stage_artifacts),
-                'old': len(old_artifacts),
+                'total': total,
+                'old': old,
                 'max_versions': max_versions,
-                'needs_cleanup': len(stage_artifacts) > max_versions or len(old_artifacts) > 0
+                'needs_cleanup': total > max_versions or old > 0
             }
         
         # Save report
@@ -331,6 +473,8 @@ def main():
     parser = argparse.ArgumentParser(description='Artifact Lifecycle Manager for OpenSSL Conan packages')
     parser.add_argument('--config', default='conan-dev/artifact-lifecycle.yml',
                        help='Path to artifact lifecycle configuration file')
+    parser.add_argument('--registry', default='artifact-registry.sqlite3',
+                       help='Path to the artifact registry database')
     parser.add_argument('--track', nargs=3, metavar=('ID', 'TYPE', 'STAGE'),
                        help='Track a new artifact')
     parser.add_argument('--invalidate', nargs=2, metavar=('TYPE', 'FILES'),
@@ -342,7 +486,7 @@ def main():
     
     args = parser.parse_args()
     
-    manager = ArtifactLifecycleManager(args.config)
+    manager = ArtifactLifecycleManager(args.config, args.registry)
     
     if args.track:
         artifact_id, artifact_type, stage = args.track
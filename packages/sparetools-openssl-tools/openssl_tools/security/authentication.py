@@ -15,6 +15,15 @@ from pathlib import Path
 from typing import Dict, List, Optional, Tuple
 import argparse
 
+try:
+    from openssl_tools.config_snapshot import load_config
+except ImportError:  # Run as a script without openssl_tools installed
+    def load_config(path, default=None):
+        if not os.path.exists(path):
+            return default
+        with open(path, 'r') as f:
+            return yaml.safe_load(f)
+
 
 class AuthTokenManager:
     """Authentication token manager for Conan remotes"""
@@ -26,10 +35,7 @@ class AuthTokenManager:
         
     def _load_config(self) -> Dict:
         """Load package registries configuration"""
-        if os.path.exists(self.config_file):
-            with open(self.config_file, 'r') as f:
-                return yaml.safe_load(f)
-        return {}
+        return load_config(self.config_file, {})
     
     def validate_tokens(self) -> bool:
         """Validate all authentication tokens"""
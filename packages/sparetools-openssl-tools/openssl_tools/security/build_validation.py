@@ -2,42 +2,141 @@
 """
 Pre-build validation script for OpenSSL Conan packages
 Comprehensive validation of environment, dependencies, and configuration
+
+The check groups run concurrently. Each writes into its own copy of the
+findings lists, merged back in the fixed group order, so the report reads
+the same as a serial run. System probes (conan --version, conan remote
+list, the installed package list, Conan Center reachability) are cached
+in conan-dev/.validation-cache.json for probe_ttl seconds. Where a probe
+has an obvious invalidator (the dpkg status file, remotes.json, the conan
+binary), it is part of the key. The secret scan uses one compiled
+pattern and only re-reads files whose (size, mtime) changed since the
+last run. Findings for unchanged files come from the cache.
 """
 
 import os
+import re
 import sys
+import copy
+import glob
 import subprocess
 import json
 import yaml
 import hashlib
 import platform
 import shutil
+import threading
+import time
+from concurrent.futures import ThreadPoolExecutor
 from pathlib import Path
 from typing import Dict, List, Optional, Tuple
 import argparse
 
+try:
+    from openssl_tools.config_snapshot import load_config
+except ImportError:  # Run as a script without openssl_tools installed
+    def load_config(path, default=None):
+        if not os.path.exists(path):
+            return default
+        with open(path, 'r') as f:
+            return yaml.safe_load(f)
+
 
 class ValidationError(Exception):
     """Custom exception for validation errors"""
     pass
 
 
+PROBE_CACHE_FILE = "conan-dev/.validation-cache.json"
+PROBE_TTL_SECONDS = 300
+
+# password/token/secret/key = "..." in one pass
+SECRET_PATTERN = re.compile(r'(?:password|token|secret|key)\s*=\s*["\'][^"\']+["\']', re.IGNORECASE)
+
+
+def _stamp(path: str) -> Optional[List[int]]:
+    try:
+        st = os.stat(path)
+        return [st.st_size, st.st_mtime_ns]
+    except OSError:
+        return None
+
+
+class ProbeCache:
+    """Probe results with a TTL and secret-scan results per file stamp, as JSON"""
+    
+    def __init__(self, path: Optional[str], ttl: float = PROBE_TTL_SECONDS):
+        self.path = path
+        self.ttl = ttl
+        self._lock = threading.Lock()
+        self._data = {'probes': {}, 'secrets': {}}
+        if path and os.path.exists(path):
+            try:
+                with open(path, 'r') as f:
+                    data = json.load(f)
+                self._data['probes'] = data.get('probes', {})
+                self._data['secrets'] = data.get('secrets', {})
+            except (OSError, ValueError):
+                pass
+    
+    def probe(self, name: str, invalidator, compute):
+        """compute() once per ttl, or sooner when invalidator changes"""
+        with self._lock:
+            entry = self._data['probes'].get(name)
+        if entry and entry['invalidator'] == invalidator and time.time() - entry['time'] < self.ttl:
+            return entry['value']
+        value = compute()
+        with self._lock:
+            self._data['probes'][name] = {'time': time.time(), 'invalidator': invalidator, 'value': value}
+        return value
+    
+    def secret_scan(self, path: str, scan) -> bool:
+        """scan(path) unless the file is unchanged since the last run"""
+        stamp = _stamp(path)
+        with self._lock:
+            entry = self._data['secrets'].get(path)
+        if entry and stamp and entry['stamp'] == stamp:
+            return entry['found']
+        found = scan(path)
+        with self._lock:
+            self._data['secrets'][path] = {'stamp': stamp, 'found': found}
+        return found
+    
+    def save(self):
+        if not self.path:
+            return
+        os.makedirs(os.path.dirname(self.path) or '.', exist_ok=True)
+        tmp_path = f"{self.path}.{os.getpid()}.tmp"
+        with self._lock, open(tmp_path, 'w') as f:
+            json.dump(self._data, f)
+        os.replace(tmp_path, self.path)
+
+
+def _run(command: List[str], timeout: float = 60) -> Dict:
+    """returncode and stdout of a probe command (returncode None if it cannot run)"""
+    try:
+        result = subprocess.run(command, capture_output=True, text=True, timeout=timeout)
+        return {'returncode': result.returncode, 'stdout': result.stdout, 'error': None}
+    except (OSError, subprocess.TimeoutExpired) as e:
+        return {'returncode': None, 'stdout': '', 'error': str(e)}
+
+
 class PreBuildValidator:
     """Comprehensive pre-build validation for OpenSSL Conan packages"""
     
-    def __init__(self, config_file: str = "conan-dev/validation-config.yml"):
+    def __init__(self, config_file: str = "conan-dev/validation-config.yml",
+                 probe_ttl: float = PROBE_TTL_SECONDS, use_cache: bool = True):
         self.config_file = config_file
         self.config = self._load_config()
         self.errors = []
         self.warnings = []
         self.info = []
+        self.probes = ProbeCache(PROBE_CACHE_FILE if use_cache else None, probe_ttl if use_cache else 0)
         
     def _load_config(self) -> Dict:
         """Load validation configuration"""
-        if os.path.exists(self.config_file):
-            with open(self.config_file, 'r') as f:
-                return yaml.safe_load(f)
-        return self._get_default_config()
+        config = load_config(self.config_file)
+        return config if config is not None else self._get_default_config()
     
     def _get_default_config(self) -> Dict:
         """Get default validation configuration"""
@@ -73,12 +172,15 @@ class PreBuildValidator:
         print("🔍 Starting comprehensive pre-build validation...")
         
         try:
-            self._validate_environment()
-            self._validate_dependencies()
-            self._validate_configuration()
-            self._validate_security()
-            self._validate_cache_configuration()
-            self._validate_build_environment()
+            self._run_parallel([
+                PreBuildValidator._validate_environment,
+                PreBuildValidator._validate_dependencies,
+                PreBuildValidator._validate_configuration,
+                PreBuildValidator._validate_security,
+                PreBuildValidator._validate_cache_configuration,
+                PreBuildValidator._validate_build_environment,
+            ])
+            self.probes.save()
             
             self._print_summary()
             return len(self.errors) == 0
@@ -87,6 +189,30 @@ class PreBuildValidator:
             self.errors.append(f"Validation failed with exception: {e}")
             return False
     
+    def _run_parallel(self, checks: List):
+        """
+        Run independent checks concurrently. Each gets a copy of the
+        validator with empty findings lists, merged back in list order.
+        """
+        def run(check):
+            scoped = copy.copy(self)
+            scoped.errors, scoped.warnings, scoped.info = [], [], []
+            try:
+                check(scoped)
+            except Exception as e:
+                scoped.errors.append(f"Validation failed with exception: {e}")
+            return scoped
+        
+        if len(checks) <= 1:
+            results = [run(check) for check in checks]
+        else:
+            with ThreadPoolExecutor(max_workers=len(checks)) as pool:
+                results = list(pool.map(run, checks))
+        for scoped in results:
+            self.errors.extend(scoped.errors)
+            self.warnings.extend(scoped.warnings)
+            self.info.extend(scoped.info)
+    
     def _validate_environment(self):
         """Validate build environment"""
         print("  📋 Validating environment...")
@@ -99,15 +225,16 @@ class PreBuildValidator:
                 self.info.append(f"✓ Found tool: {tool}")
         
         # Check Conan version
-        try:
-            result = subprocess.run(['conan', '--version'], capture_output=True, text=True)
-            if result.returncode == 0:
-                version = result.stdout.strip().split()[-1]
-                self.info.append(f"✓ Conan version: {version}")
-            else:
-                self.errors.append("Failed to get Conan version")
-        except Exception as e:
-            self.errors.append(f"Error checking Conan version: {e}")
+        conan = shutil.which('conan')
+        result = self.probes.probe('conan-version', [conan, _stamp(conan) if conan else None],
+                                   lambda: _run(['conan', '--version']))
+        if result['returncode'] == 0 and result['stdout'].strip():
+            version = result['stdout'].strip().split()[-1]
+            self.info.append(f"✓ Conan version: {version}")
+        elif result['returncode'] is None:
+            self.errors.append(f"Error checking Conan version: {result['error']}")
+        else:
+            self.errors.append("Failed to get Conan version")
         
         # Check Python version
         if sys.version_info < (3, 8):
@@ -139,11 +266,13 @@ class PreBuildValidator:
         """Validate system and Conan dependencies"""
         print("  📦 Validating dependencies...")
         
+        checks = []
         if self.config['dependencies']['check_system_packages']:
-            self._check_system_packages()
+            checks.append(PreBuildValidator._check_system_packages)
         
         if self.config['dependencies']['check_conan_remotes']:
-            self._check_conan_remotes()
+            checks.append(PreBuildValidator._check_conan_remotes)
+        self._run_parallel(checks)
     
     def _check_system_packages(self):
         """Check system package dependencies"""
@@ -164,9 +293,13 @@ class PreBuildValidator:
     def _check_apt_packages(self):
         """Check APT packages on Debian/Ubuntu"""
         try:
-            result = subprocess.run(['dpkg', '-l'], capture_output=True, text=True)
-            if result.returncode == 0:
-                installed_packages = result.stdout
+            # Changes whenever a package is installed or removed
+            result = self.probes.probe('dpkg-packages', _stamp('/var/lib/dpkg/status'),
+                                       lambda: _run(['dpkg-query', '-W', '-f=${Package}\n']))
+            if result['returncode'] is None:
+                raise RuntimeError(result['error'])
+            if result['returncode'] == 0:
+                installed_packages = set(result['stdout'].split())
                 for package in self.config['dependencies']['required_system_packages']:
                     if package in installed_packages:
                         self.info.append(f"✓ System package installed: {package}")
@@ -178,9 +311,11 @@ class PreBuildValidator:
     def _check_brew_packages(self):
         """Check Homebrew packages on macOS"""
         try:
-            result = subprocess.run(['brew', 'list'], capture_output=True, text=True)
-            if result.returncode == 0:
-                installed_packages = result.stdout
+            result = self.probes.probe('brew-packages', None, lambda: _run(['brew', 'list', '-1']))
+            if result['returncode'] is None:
+                raise RuntimeError(result['error'])
+            if result['returncode'] == 0:
+                installed_packages = set(result['stdout'].split())
                 for package in ['gcc', 'make', 'perl']:
                     if package in installed_packages:
                         self.info.append(f"✓ Homebrew package installed: {package}")
@@ -197,9 +332,13 @@ class PreBuildValidator:
     def _check_conan_remotes(self):
         """Check Conan remote configuration"""
         try:
-            result = subprocess.run(['conan', 'remote', 'list'], capture_output=True, text=True)
-            if result.returncode == 0:
-                remotes = result.stdout
+            conan_home = os.getenv('CONAN_HOME', os.path.expanduser('~/.conan2'))
+            result = self.probes.probe('conan-remotes', _stamp(os.path.join(conan_home, 'remotes.json')),
+                                       lambda: _run(['conan', 'remote', 'list']))
+            if result['returncode'] is None:
+                raise RuntimeError(result['error'])
+            if result['returncode'] == 0:
+                remotes = result['stdout']
                 for remote in self.config['dependencies']['required_remotes']:
                     if remote in remotes:
                         self.info.append(f"✓ Conan remote configured: {remote}")
@@ -301,62 +440,61 @@ class PreBuildValidator:
         """Validate security configuration"""
         print("  🔒 Validating security...")
         
+        checks = []
         if self.config['security']['check_secrets']:
-            self._check_secrets()
+            checks.append(PreBuildValidator._check_secrets)
         
         if self.config['security']['validate_ssl_certs']:
-            self._validate_ssl_certs()
+            checks.append(PreBuildValidator._validate_ssl_certs)
         
         if self.config['security']['check_file_permissions']:
-            self._check_file_permissions()
+            checks.append(PreBuildValidator._check_file_permissions)
+        self._run_parallel(checks)
     
     def _check_secrets(self):
         """Check for exposed secrets"""
         sensitive_files = ['conanfile.py', 'conan-dev/conan.conf', '.github/workflows/*.yml']
-        sensitive_patterns = [
-            r'password\s*=\s*["\'][^"\']+["\']',
-            r'token\s*=\s*["\'][^"\']+["\']',
-            r'secret\s*=\s*["\'][^"\']+["\']',
-            r'key\s*=\s*["\'][^"\']+["\']'
-        ]
+        
+        def scan(file_path: str) -> bool:
+            with open(file_path, 'r', errors='ignore') as f:
+                return SECRET_PATTERN.search(f.read()) is not None
         
         for file_pattern in sensitive_files:
             if '*' in file_pattern:
                 # Handle glob patterns
-                import glob
-                files = glob.glob(file_pattern)
+                files = sorted(glob.glob(file_pattern))
             else:
                 files = [file_pattern] if os.path.exists(file_pattern) else []
             
             for file_path in files:
-                if os.path.exists(file_path):
-                    try:
-                        with open(file_path, 'r') as f:
-                            content = f.read()
-                        
-                        for pattern in sensitive_patterns:
-                            import re
-                            if re.search(pattern, content, re.IGNORECASE):
-                                self.warnings.append(f"Potential secret found in {file_path}")
-                    except Exception as e:
-                        self.warnings.append(f"Error checking {file_path} for secrets: {e}")
+                try:
+                    if self.probes.secret_scan(file_path, scan):
+                        self.warnings.append(f"Potential secret found in {file_path}")
+                except Exception as e:
+                    self.warnings.append(f"Error checking {file_path} for secrets: {e}")
     
     def _validate_ssl_certs(self):
         """Validate SSL certificate configuration"""
-        try:
+        def connect() -> Dict:
             # Check if we can make HTTPS requests
             import urllib.request
             import ssl
             
-            # Test connection to Conan Center
-            context = ssl.create_default_context()
-            with urllib.request.urlopen('https://center.conan.io', context=context) as response:
-                if response.status == 200:
-                    self.info.append("✓ SSL connection to Conan Center successful")
-                else:
-                    self.warnings.append("SSL connection to Conan Center returned non-200 status")
-        except Exception as e:
-            self.warnings.append(f"SSL validation failed: {e}")
+            try:
+                # Test connection to Conan Center
+                context = ssl.create_default_context()
+                with urllib.request.urlopen('https://center.conan.io', context=context, timeout=10) as response:
+                    return {'status': response.status, 'error': None}
+            except Exception as e:
+                return {'status': None, 'error': str(e)}
+        
+        result = self.probes.probe('conancenter-ssl', None, connect)
+        if result['error']:
+            self.warnings.append(f"SSL validation failed: {result['error']}")
+        elif result['status'] == 200:
+            self.info.append("✓ SSL connection to Conan Center successful")
+        else:
+            self.warnings.append("SSL connection to Conan Center returned non-200 status")
     
     def _check_file_permissions(self):
         """Check file permissions for security"""
@@ -456,19 +594,22 @@ def main():
                        help='Path to validation configuration file')
     parser.add_argument('--strict', action='store_true',
                        help='Treat warnings as errors')
+    parser.add_argument('--probe-ttl', type=float, default=PROBE_TTL_SECONDS,
+                       help='Seconds cached system probes stay valid')
+    parser.add_argument('--no-cache', action='store_true',
+                       help='Probe everything and rescan every file')
     
     args = parser.parse_args()
     
-    validator = PreBuildValidator(args.config)
-    
-    if args.strict:
-        # In strict mode, treat warnings as errors
-        original_warnings = validator.warnings
-        validator.warnings = []
-        validator.errors.extend(original_warnings)
+    validator = PreBuildValidator(args.config, probe_ttl=args.probe_ttl, use_cache=not args.no_cache)
     
     success = validator.validate_all()
     
+    if args.strict and validator.warnings:
+        # In strict mode, treat warnings as errors
+        print(f"❌ Strict mode: {len(validator.warnings)} warnings count as errors")
+        success = False
+    
     if not success:
         sys.exit(1)
     else:
@@ -2,6 +2,18 @@
 """
 Secure Key Manager for OpenSSL Conan packages
 Ensures secure key management and supply chain security
+
+Releases are signed in one batch (sign_release). Artifacts are streamed
+through SHA-256 in chunks, or their digests are taken from the SBOM
+ArtifactHashCache, and the digests are signed with RSA-PSS on a thread
+pool. The batch writes a single detached manifest: per-artifact size,
+digest and signature, plus a signature over the manifest itself. The
+private key is loaded once per batch. A PKCS#11 token keeps one logged-in
+session per worker open for the whole batch.
+
+With key_pool.enabled (or SPARETOOLS_KEY_POOL set to a pool directory),
+generate_key_pair and rotate_keys take pre-generated keys from a KeyPool
+instead of running RSA keygen inline.
 """
 
 import os
@@ -12,6 +24,9 @@ import hashlib
 import subprocess
 import secrets
 import base64
+import queue
+import time
+from concurrent.futures import ThreadPoolExecutor
 from pathlib import Path
 from typing import Dict, List, Optional, Tuple
 import argparse
@@ -20,8 +35,129 @@ import cryptography
 from cryptography.fernet import Fernet
 from cryptography.hazmat.primitives import hashes, serialization
 from cryptography.hazmat.primitives.asymmetric import rsa, padding
+from cryptography.hazmat.primitives.asymmetric.utils import Prehashed
 from cryptography.hazmat.primitives.kdf.pbkdf2 import PBKDF2HMAC
 
+try:
+    from openssl_tools.config_snapshot import load_config
+except ImportError:  # Run as a script without openssl_tools installed
+    def load_config(path, default=None):
+        if not os.path.exists(path):
+            return default
+        with open(path, 'r') as f:
+            return yaml.safe_load(f)
+
+try:
+    from openssl_tools.openssl.sbom_generator import ArtifactHashCache
+except ImportError:
+    ArtifactHashCache = None
+
+try:
+    from openssl_tools.security.key_pool import KeyPool
+except ImportError:
+    KeyPool = None
+
+MANIFEST_FORMAT = "sparetools-signature-manifest/1"
+DIGEST_CHUNK_SIZE = 4 * 1024 * 1024
+# Salt length of the token's CKM_RSA_PKCS_PSS signatures (the digest size)
+PKCS11_SALT_LENGTH = 32
+
+
+def _pss(salt_length="max") -> padding.PSS:
+    return padding.PSS(
+        mgf=padding.MGF1(hashes.SHA256()),
+        salt_length=padding.PSS.MAX_LENGTH if salt_length == "max" else int(salt_length)
+    )
+
+
+def _stream_digest(path: str) -> bytes:
+    """SHA-256 of a file, read in DIGEST_CHUNK_SIZE chunks"""
+    hasher = hashlib.sha256()
+    with open(path, 'rb') as f:
+        for chunk in iter(lambda: f.read(DIGEST_CHUNK_SIZE), b''):
+            hasher.update(chunk)
+    return hasher.digest()
+
+
+class SoftwareSigner:
+    """
+    RSA-PSS over a SHA-256 digest with a private key loaded once.
+    SecureKeyManager keeps one per key, so single-artifact signing does
+    not re-read and re-parse the PEM each time (the C-side equivalent for
+    servers is SpareTools::signctx).
+    """
+
+    salt_length = "max"
+
+    def __init__(self, private_key_path: str):
+        self.path = private_key_path
+        with open(private_key_path, 'rb') as f:
+            self.private_key = serialization.load_pem_private_key(f.read(), password=None)
+
+    def sign_digest(self, digest: bytes) -> bytes:
+        return self.private_key.sign(digest, _pss(self.salt_length), Prehashed(hashes.SHA256()))
+
+    def close(self):
+        pass
+
+
+class Pkcs11Signer:
+    """
+    RSA-PSS on a PKCS#11 token (PyKCS11). One session per worker is opened
+    and logged in when the batch starts and closed when it ends, instead of
+    a session per signature. The key never leaves the token.
+    """
+
+    salt_length = PKCS11_SALT_LENGTH
+
+    def __init__(self, module: str, key_label: str, token_label: Optional[str] = None,
+                 pin: Optional[str] = None, sessions: int = 1):
+        import PyKCS11
+        self._lib = PyKCS11.PyKCS11Lib()
+        self._lib.load(module)
+        slots = [slot for slot in self._lib.getSlotList(tokenPresent=True)
+                 if token_label is None or self._lib.getTokenInfo(slot).label.strip() == token_label]
+        if not slots:
+            raise ValueError(f"PKCS#11 token {token_label or '(any)'} not found in {module}")
+        self._opened = [self._lib.openSession(slots[0], PyKCS11.CKF_SERIAL_SESSION)
+                        for _ in range(max(1, sessions))]
+        # Login state is per token, shared by all of our sessions
+        if pin:
+            self._opened[0].login(pin)
+        keys = self._opened[0].findObjects([(PyKCS11.CKA_CLASS, PyKCS11.CKO_PRIVATE_KEY),
+                                            (PyKCS11.CKA_LABEL, key_label)])
+        if not keys:
+            self.close()
+            raise ValueError(f"PKCS#11 private key {key_label} not found")
+        self._key = keys[0]
+        self._mechanism = PyKCS11.RSA_PSS_Mechanism(PyKCS11.CKM_RSA_PKCS_PSS, PyKCS11.CKM_SHA256,
+                                                    PyKCS11.CKG_MGF1_SHA256, PKCS11_SALT_LENGTH)
+        self._idle = queue.Queue()
+        for session in self._opened:
+            self._idle.put(session)
+        self._logged_in = bool(pin)
+
+    def sign_digest(self, digest: bytes) -> bytes:
+        # A session is used by one thread at a time
+        session = self._idle.get()
+        try:
+            return bytes(session.sign(self._key, digest, self._mechanism))
+        finally:
+            self._idle.put(session)
+
+    def close(self):
+        if self._opened and getattr(self, '_logged_in', False):
+            try:
+                self._opened[0].logout()
+            except Exception:
+                pass
+        for session in self._opened:
+            try:
+                session.closeSession()
+            except Exception:
+                pass
+        self._opened = []
+
 
 class SecureKeyManager:
     """Manages secure keys and supply chain security"""
@@ -29,14 +165,31 @@ class SecureKeyManager:
     def __init__(self, config_file: str = "conan-dev/secure-key-management.yml"):
         self.config_file = config_file
         self.config = self._load_config()
-        self.key_registry = {}
+        self.key_registry = self._load_key_registry()
+        self.key_pool = self._open_key_pool()
+        self._signers: Dict[str, SoftwareSigner] = {}
         
+    def _software_signer(self, key_id: str) -> SoftwareSigner:
+        """Signer for a registered key, loaded on first use and then reused"""
+        path = self.key_registry[key_id]['private_key_path']
+        signer = self._signers.get(key_id)
+        if signer is None or signer.path != path:
+            signer = self._signers[key_id] = SoftwareSigner(path)
+        return signer
+        
+    def _open_key_pool(self):
+        """KeyPool from the key_pool config section or SPARETOOLS_KEY_POOL, else None"""
+        pool_config = self.config.get('key_pool') or {}
+        directory = os.environ.get('SPARETOOLS_KEY_POOL')
+        if KeyPool is None or not (directory or pool_config.get('enabled')):
+            return None
+        return KeyPool(directory or pool_config.get('directory', 'conan-dev/key-pool'),
+                       depth=pool_config.get('depth', {}), workers=pool_config.get('workers'))
+    
     def _load_config(self) -> Dict:
         """Load secure key management configuration"""
-        if os.path.exists(self.config_file):
-            with open(self.config_file, 'r') as f:
-                return yaml.safe_load(f)
-        return self._get_default_config()
+        config = load_config(self.config_file)
+        return config if config is not None else self._get_default_config()
     
     def _get_default_config(self) -> Dict:
         """Get default secure key management configuration"""
@@ -61,6 +214,12 @@ class SecureKeyManager:
                 'hash_algorithm': 'SHA-256',
                 'key_size': 4096
             },
+            'key_pool': {
+                'enabled': False,
+                'directory': 'conan-dev/key-pool',
+                'depth': {'rsa-4096': 2},
+                'workers': None
+            },
             'workflow': {
                 'signing_required': True,
                 'verification_required': True,
@@ -74,11 +233,12 @@ class SecureKeyManager:
         print(f"🔑 Generating {key_type} key pair: {key_name}...")
         
         try:
-            # Generate RSA key pair
-            private_key = rsa.generate_private_key(
-                public_exponent=65537,
-                key_size=self.config['security']['key_size']
-            )
+            # Generate RSA key pair (pre-generated when a key pool is configured)
+            key_size = self.config['security']['key_size']
+            if self.key_pool is not None:
+                private_key = self.key_pool.take(f"rsa-{key_size}")
+            else:
+                private_key = rsa.generate_private_key(public_exponent=65537, key_size=key_size)
             
             public_key = private_key.public_key()
             
@@ -156,26 +316,10 @@ class SecureKeyManager:
             if key_id not in self.key_registry:
                 raise ValueError(f"Key {key_id} not found")
             
-            key_info = self.key_registry[key_id]
-            private_key_path = key_info['private_key_path']
-            
-            # Load private key
-            with open(private_key_path, 'rb') as f:
-                private_key = serialization.load_pem_private_key(f.read(), password=None)
-            
-            # Read artifact
-            with open(artifact_path, 'rb') as f:
-                artifact_data = f.read()
-            
-            # Create signature
-            signature = private_key.sign(
-                artifact_data,
-                padding.PSS(
-                    mgf=padding.MGF1(hashes.SHA256()),
-                    salt_length=padding.PSS.MAX_LENGTH
-                ),
-                hashes.SHA256()
-            )
+            signer = self._software_signer(key_id)
+            
+            # Same signature as over the whole file, without holding it in memory
+            signature = signer.sign_digest(_stream_digest(artifact_path))
             
             # Save signature
             signature_path = f"{artifact_path}.sig"
@@ -230,10 +374,6 @@ class SecureKeyManager:
             with open(public_key_path, 'rb') as f:
                 public_key = serialization.load_pem_public_key(f.read())
             
-            # Read artifact and signature
-            with open(artifact_path, 'rb') as f:
-                artifact_data = f.read()
-            
             with open(signature_path, 'rb') as f:
                 signature = f.read()
             
@@ -241,12 +381,9 @@ class SecureKeyManager:
             try:
                 public_key.verify(
                     signature,
-                    artifact_data,
-                    padding.PSS(
-                        mgf=padding.MGF1(hashes.SHA256()),
-                        salt_length=padding.PSS.MAX_LENGTH
-                    ),
-                    hashes.SHA256()
+                    _stream_digest(artifact_path),
+                    _pss(metadata.get('salt_length', 'max')),
+                    Prehashed(hashes.SHA256())
                 )
                 print(f"✓ Signature verified: {key_id}")
                 return True
@@ -259,6 +396,173 @@ class SecureKeyManager:
             print(f"❌ Failed to verify signature: {e}")
             return False
     
+    @staticmethod
+    def _collect_artifacts(artifacts: List[str], manifest_path: str) -> List[str]:
+        """Files to sign: the given files plus everything under given directories"""
+        skip = {os.path.abspath(manifest_path), os.path.abspath(manifest_path) + '.sig'}
+        files = []
+        for artifact in artifacts:
+            if os.path.isdir(artifact):
+                for root, dirs, names in os.walk(artifact):
+                    dirs.sort()
+                    files.extend(os.path.join(root, name) for name in sorted(names))
+            else:
+                files.append(artifact)
+        return [f for f in dict.fromkeys(files)
+                if os.path.abspath(f) not in skip and not f.endswith(('.sig', '.sig.meta'))]
+
+    def _open_signer(self, key_id: str, pkcs11: Optional[Dict], workers: int):
+        if pkcs11:
+            return Pkcs11Signer(pkcs11['module'], pkcs11['key_label'], pkcs11.get('token_label'),
+                                pkcs11.get('pin'), sessions=workers)
+        return self._software_signer(key_id)
+
+    def sign_release(self, artifacts: List[str], key_id: str,
+                     manifest_path: str = "release-signatures.json", release: Optional[str] = None,
+                     base_dir: Optional[str] = None, workers: Optional[int] = None,
+                     hash_cache=None, pkcs11: Optional[Dict] = None) -> str:
+        """
+        Sign every artifact of a release into one detached manifest.
+
+        Args:
+            artifacts: Files and directories (walked recursively)
+            key_id: Registered key; its public key verifies the manifest
+            manifest_path: Manifest to write; its signature goes to <manifest>.sig
+            base_dir: Paths in the manifest are relative to it (default: manifest directory)
+            workers: Concurrent digests and signatures
+            hash_cache: ArtifactHashCache (or its JSON path) whose SHA-256 digests are reused
+            pkcs11: {'module', 'key_label', 'token_label', 'pin'} to sign on a token
+
+        Returns the manifest path, or "" on failure.
+        """
+        print(f"✍️  Signing release: {release or manifest_path}...")
+        
+        try:
+            if key_id not in self.key_registry:
+                raise ValueError(f"Key {key_id} not found")
+            files = self._collect_artifacts(artifacts, manifest_path)
+            if not files:
+                raise ValueError("No artifacts to sign")
+            base_dir = os.path.abspath(base_dir or os.path.dirname(os.path.abspath(manifest_path)))
+            workers = workers or min(32, (os.cpu_count() or 1) + 4)
+            if isinstance(hash_cache, (str, Path)) and ArtifactHashCache is not None:
+                hash_cache = ArtifactHashCache(str(hash_cache))
+            start = time.monotonic()
+            
+            signer = self._open_signer(key_id, pkcs11, workers)
+            try:
+                def sign_one(path: str) -> Dict:
+                    if hash_cache is not None:
+                        digest = bytes.fromhex(hash_cache.hashes(path)['sha256'])
+                    else:
+                        digest = _stream_digest(path)
+                    return {
+                        'path': os.path.relpath(os.path.abspath(path), base_dir).replace(os.sep, '/'),
+                        'size': os.path.getsize(path),
+                        'sha256': digest.hex(),
+                        'signature': base64.b64encode(signer.sign_digest(digest)).decode()
+                    }
+                
+                with ThreadPoolExecutor(max_workers=min(workers, len(files))) as pool:
+                    entries = sorted(pool.map(sign_one, files), key=lambda e: e['path'])
+                
+                manifest = {
+                    'format': MANIFEST_FORMAT,
+                    'release': release,
+                    'key_id': key_id,
+                    'signer': 'pkcs11' if pkcs11 else 'software',
+                    'algorithm': self.config['security']['signing_algorithm'],
+                    'hash_algorithm': self.config['security']['hash_algorithm'],
+                    'salt_length': signer.salt_length,
+                    'signed_at': datetime.now().isoformat(),
+                    'artifacts': entries
+                }
+                manifest_bytes = json.dumps(manifest, indent=2, sort_keys=True).encode()
+                manifest_signature = signer.sign_digest(hashlib.sha256(manifest_bytes).digest())
+            finally:
+                signer.close()
+            
+            if hasattr(hash_cache, 'save'):
+                hash_cache.save()
+            Path(manifest_path).parent.mkdir(parents=True, exist_ok=True)
+            with open(manifest_path, 'wb') as f:
+                f.write(manifest_bytes)
+            with open(f"{manifest_path}.sig", 'wb') as f:
+                f.write(manifest_signature)
+            
+            total = sum(e['size'] for e in entries)
+            print(f"✓ Signed {len(entries)} artifacts ({total / 1e6:.1f} MB) in "
+                  f"{time.monotonic() - start:.2f}s: {manifest_path}")
+            return manifest_path
+            
+        except Exception as e:
+            print(f"❌ Failed to sign release: {e}")
+            return ""
+    
+    def verify_release(self, manifest_path: str, base_dir: Optional[str] = None,
+                       workers: Optional[int] = None) -> bool:
+        """Verify a release manifest and every artifact in it (digests recomputed)"""
+        print(f"🔍 Verifying release: {manifest_path}...")
+        
+        try:
+            with open(manifest_path, 'rb') as f:
+                manifest_bytes = f.read()
+            with open(f"{manifest_path}.sig", 'rb') as f:
+                manifest_signature = f.read()
+            manifest = json.loads(manifest_bytes)
+            if manifest.get('format') != MANIFEST_FORMAT:
+                print(f"❌ Unknown manifest format: {manifest.get('format')}")
+                return False
+            
+            key_id = manifest['key_id']
+            if key_id not in self.key_registry:
+                print(f"❌ Key {key_id} not found in registry")
+                return False
+            with open(self.key_registry[key_id]['public_key_path'], 'rb') as f:
+                public_key = serialization.load_pem_public_key(f.read())
+            pss = _pss(manifest.get('salt_length', 'max'))
+            
+            try:
+                public_key.verify(manifest_signature, hashlib.sha256(manifest_bytes).digest(),
+                                  pss, Prehashed(hashes.SHA256()))
+            except Exception as e:
+                print(f"❌ Manifest signature verification failed: {e}")
+                return False
+            
+            base_dir = os.path.abspath(base_dir or os.path.dirname(os.path.abspath(manifest_path)))
+            
+            def check(entry: Dict) -> Optional[str]:
+                path = os.path.join(base_dir, entry['path'])
+                if not os.path.isfile(path):
+                    return f"{entry['path']}: missing"
+                if os.path.getsize(path) != entry['size']:
+                    return f"{entry['path']}: size changed"
+                digest = _stream_digest(path)
+                if digest.hex() != entry['sha256']:
+                    return f"{entry['path']}: digest mismatch"
+                try:
+                    public_key.verify(base64.b64decode(entry['signature']), digest,
+                                      pss, Prehashed(hashes.SHA256()))
+                except Exception:
+                    return f"{entry['path']}: bad signature"
+                return None
+            
+            entries = manifest['artifacts']
+            workers = workers or min(32, (os.cpu_count() or 1) + 4)
+            with ThreadPoolExecutor(max_workers=max(1, min(workers, len(entries)))) as pool:
+                failures = [failure for failure in pool.map(check, entries) if failure]
+            
+            for failure in failures:
+                print(f"❌ {failure}")
+            if failures:
+                return False
+            print(f"✓ Release verified: {len(entries)} artifacts signed by {key_id}")
+            return True
+            
+        except Exception as e:
+            print(f"❌ Failed to verify release: {e}")
+            return False
+    
     def scan_vulnerabilities(self, package_path: str) -> Dict:
         """Scan package for vulnerabilities"""
         print(f"🔍 Scanning vulnerabilities: {package_path}...")
@@ -426,6 +730,17 @@ class SecureKeyManager:
         print(f"✓ Rotated {rotated_count} keys")
         return rotated_count
     
+    def _load_key_registry(self) -> Dict:
+        """Load the key registry written by earlier runs"""
+        registry_file = 'key-registry.json'
+        if not os.path.exists(registry_file):
+            return {}
+        try:
+            with open(registry_file, 'r') as f:
+                return json.load(f)
+        except (OSError, ValueError):
+            return {}
+    
     def _save_key_registry(self):
         """Save key registry to persistent storage"""
         registry_file = 'key-registry.json'
@@ -477,6 +792,19 @@ def main():
                        help='Sign artifact with key')
     parser.add_argument('--verify', nargs=2, metavar=('ARTIFACT', 'SIGNATURE'),
                        help='Verify artifact signature')
+    parser.add_argument('--sign-release', nargs=2, metavar=('MANIFEST', 'KEY_ID'),
+                       help='Sign --artifacts into one detached signature manifest')
+    parser.add_argument('--verify-release', metavar='MANIFEST',
+                       help='Verify a signature manifest and its artifacts')
+    parser.add_argument('--artifacts', nargs='+', default=[],
+                       help='Files and directories for --sign-release')
+    parser.add_argument('--release', help='Release name recorded in the manifest')
+    parser.add_argument('--base-dir', help='Directory manifest paths are relative to')
+    parser.add_argument('--workers', type=int, help='Concurrent digests and signatures')
+    parser.add_argument('--hash-cache', help='SBOM ArtifactHashCache JSON whose digests are reused')
+    parser.add_argument('--pkcs11-module', help='PKCS#11 module; the PIN is read from SPARETOOLS_PKCS11_PIN')
+    parser.add_argument('--pkcs11-token', help='PKCS#11 token label')
+    parser.add_argument('--pkcs11-key', help='PKCS#11 private key label')
     parser.add_argument('--scan-vulnerabilities', metavar='PACKAGE_PATH',
                        help='Scan package for vulnerabilities')
     parser.add_argument('--audit-keys', action='store_true',
@@ -485,6 +813,8 @@ def main():
                        help='Rotate expired keys')
     parser.add_argument('--report', action='store_true',
                        help='Generate security report')
+    parser.add_argument('--fill-key-pool', action='store_true',
+                       help='Pre-generate the configured key_pool depth and wait for it')
     
     args = parser.parse_args()
     
@@ -499,6 +829,17 @@ def main():
     elif args.verify:
         artifact, signature = args.verify
         success = manager.verify_signature(artifact, signature)
+    elif args.sign_release:
+        manifest, key_id = args.sign_release
+        pkcs11 = None
+        if args.pkcs11_module:
+            pkcs11 = {'module': args.pkcs11_module, 'key_label': args.pkcs11_key,
+                      'token_label': args.pkcs11_token, 'pin': os.environ.get('SPARETOOLS_PKCS11_PIN')}
+        success = bool(manager.sign_release(args.artifacts, key_id, manifest, release=args.release,
+                                            base_dir=args.base_dir, workers=args.workers,
+                                            hash_cache=args.hash_cache, pkcs11=pkcs11))
+    elif args.verify_release:
+        success = manager.verify_release(args.verify_release, base_dir=args.base_dir, workers=args.workers)
     elif args.scan_vulnerabilities:
         vulnerabilities = manager.scan_vulnerabilities(args.scan_vulnerabilities)
     elif args.audit_keys:
@@ -507,6 +848,13 @@ def main():
         rotated = manager.rotate_keys()
     elif args.report:
         report = manager.generate_security_report()
+    elif args.fill_key_pool:
+        if manager.key_pool is None:
+            print("❌ No key pool configured (key_pool.enabled or SPARETOOLS_KEY_POOL)")
+            success = False
+        else:
+            scheduled = manager.key_pool.fill(wait=True)
+            print(f"✓ Generated {scheduled} pooled keys")
     else:
         print("Please specify an action")
         success = False
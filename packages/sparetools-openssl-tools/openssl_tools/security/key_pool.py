@@ -0,0 +1,289 @@
+#!/usr/bin/env python3
+"""
+Pre-generated key pool for key management and tests
+
+RSA-4096 keygen takes seconds, so keys of the configured specs
+("rsa-2048", "rsa-4096", "ec-p256", "ed25519", ...) are generated ahead of
+time in worker processes and stored encrypted (PKCS#8, passphrase from
+SPARETOOLS_KEY_POOL_PASSPHRASE or a 0600 file in the pool directory), one
+file per key. take() claims a stored key with an atomic rename, so test
+workers and CI jobs sharing a pool never get the same key, and falls back
+to inline generation when the pool is empty. Taken keys are replenished in
+the background.
+
+fixture() returns the same key for the same name on every call. EC and
+Ed25519 fixture keys are derived from the name, so they are identical on
+every machine. RSA cannot be derived that way, so an RSA fixture is the
+first pooled key taken for that name, pinned under fixtures/ for as long
+as the pool directory is kept (e.g. in a CI cache).
+"""
+
+import argparse
+import hashlib
+import logging
+import os
+import secrets
+import sys
+import threading
+from concurrent.futures import ProcessPoolExecutor
+from pathlib import Path
+from typing import Dict, List, Optional
+
+from cryptography.hazmat.primitives import serialization
+from cryptography.hazmat.primitives.asymmetric import ec, ed25519, rsa
+
+logger = logging.getLogger(__name__)
+
+DEFAULT_POOL_DIR = "conan-dev/key-pool"
+PASSPHRASE_ENV = "SPARETOOLS_KEY_POOL_PASSPHRASE"
+FIXTURE_SEED = b"sparetools-fixture-key/1"
+
+EC_CURVES = {"p256": ec.SECP256R1, "p384": ec.SECP384R1, "p521": ec.SECP521R1}
+# Group orders, for mapping a digest onto a valid private scalar
+EC_ORDERS = {
+    "p256": 0xFFFFFFFF00000000FFFFFFFFFFFFFFFFBCE6FAADA7179E84F3B9CAC2FC632551,
+    "p384": int("FFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFC7634D81F4372DDF"
+                "581A0DB248B0A77AECEC196ACCC52973", 16),
+    "p521": int("01FFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFF"
+                "FA51868783BF2F966B7FCC0148F709A5D03BB5C9B8899C47AEBB6FB71E91386409", 16),
+}
+
+
+def _check_spec(spec: str) -> str:
+    kind, _, arg = spec.lower().partition("-")
+    if kind == "rsa" and arg.isdigit() and int(arg) >= 1024:
+        return spec.lower()
+    if kind == "ec" and arg in EC_CURVES:
+        return spec.lower()
+    if spec.lower() == "ed25519":
+        return "ed25519"
+    raise ValueError(f"Unknown key spec {spec!r} (rsa-BITS, ec-p256|p384|p521, ed25519)")
+
+
+def generate_key(spec: str):
+    """New private key for a spec"""
+    kind, _, arg = _check_spec(spec).partition("-")
+    if kind == "rsa":
+        return rsa.generate_private_key(public_exponent=65537, key_size=int(arg))
+    if kind == "ec":
+        return ec.generate_private_key(EC_CURVES[arg]())
+    return ed25519.Ed25519PrivateKey.generate()
+
+
+def _derive_key(spec: str, name: str):
+    """Deterministic EC/Ed25519 key for a fixture name, None for RSA"""
+    kind, _, arg = _check_spec(spec).partition("-")
+    seed = hashlib.sha512(FIXTURE_SEED + b"\0" + spec.encode() + b"\0" + name.encode()).digest()
+    if kind == "ec":
+        order = EC_ORDERS[arg]
+        return ec.derive_private_key(int.from_bytes(seed, "big") % (order - 1) + 1, EC_CURVES[arg]())
+    if kind == "ed25519":
+        return ed25519.Ed25519PrivateKey.from_private_bytes(seed[:32])
+    return None
+
+
+def _encrypt(key, passphrase: bytes) -> bytes:
+    return key.private_bytes(encoding=serialization.Encoding.PEM,
+                             format=serialization.PrivateFormat.PKCS8,
+                             encryption_algorithm=serialization.BestAvailableEncryption(passphrase))
+
+
+def _write_atomic(path: Path, data: bytes):
+    tmp = path.with_name(f".{path.name}.{os.getpid()}.{secrets.token_hex(4)}.tmp")
+    fd = os.open(tmp, os.O_WRONLY | os.O_CREAT | os.O_EXCL, 0o600)
+    with os.fdopen(fd, "wb") as f:
+        f.write(data)
+    os.replace(tmp, path)
+
+
+def _generate_into(directory: str, spec: str, passphrase: bytes) -> str:
+    """Worker process: generate one key and store it in the pool"""
+    key = generate_key(spec)
+    path = Path(directory) / spec / f"{secrets.token_hex(8)}.pem"
+    _write_atomic(path, _encrypt(key, passphrase))
+    return str(path)
+
+
+class KeyPool:
+    """Encrypted on-disk pool of pre-generated private keys"""
+
+    def __init__(self, directory: str = DEFAULT_POOL_DIR, depth: Optional[Dict[str, int]] = None,
+                 workers: Optional[int] = None, passphrase: Optional[bytes] = None):
+        """
+        Args:
+            directory: Pool directory, shared by every process using the pool
+            depth: Keys to keep in stock per spec, e.g. {'rsa-4096': 4}
+            workers: Keygen processes (default: CPU count)
+            passphrase: Key encryption passphrase (default: environment or pool file)
+        """
+        self.directory = Path(directory)
+        self.depth = {_check_spec(spec): count for spec, count in (depth or {}).items()}
+        self.workers = workers or os.cpu_count() or 1
+        self.directory.mkdir(parents=True, exist_ok=True)
+        os.chmod(self.directory, 0o700)
+        self._passphrase = passphrase or self._load_passphrase()
+        self._executor: Optional[ProcessPoolExecutor] = None
+        self._pending: Dict[str, int] = {}
+        # Reentrant: a done callback may run in fill() itself
+        self._lock = threading.RLock()
+        self.hits = 0
+        self.misses = 0
+
+    def _load_passphrase(self) -> bytes:
+        if os.environ.get(PASSPHRASE_ENV):
+            return os.environ[PASSPHRASE_ENV].encode()
+        path = self.directory / "passphrase"
+        if not path.exists():
+            # Written in full before it appears, so concurrent first users agree
+            tmp = path.with_name(f".passphrase.{os.getpid()}.tmp")
+            fd = os.open(tmp, os.O_WRONLY | os.O_CREAT | os.O_TRUNC, 0o600)
+            with os.fdopen(fd, "wb") as f:
+                f.write(secrets.token_urlsafe(32).encode())
+            try:
+                os.link(tmp, path)
+            except FileExistsError:
+                pass
+            finally:
+                tmp.unlink()
+        return path.read_bytes().strip()
+
+    def available(self, spec: str) -> int:
+        """Keys in stock for a spec"""
+        spec_dir = self.directory / _check_spec(spec)
+        return len(list(spec_dir.glob("*.pem"))) if spec_dir.is_dir() else 0
+
+    def fill(self, depth: Optional[Dict[str, int]] = None, wait: bool = False) -> int:
+        """
+        Generate keys in the background until each spec has its depth in
+        stock (counting keys already being generated). Returns the number
+        of keys scheduled; with wait=True, returns once they are stored.
+        """
+        targets = {_check_spec(spec): count for spec, count in (depth or self.depth).items()}
+        futures = []
+        with self._lock:
+            if self._executor is None:
+                self._executor = ProcessPoolExecutor(max_workers=self.workers)
+            for spec, count in targets.items():
+                (self.directory / spec).mkdir(exist_ok=True)
+                missing = count - self.available(spec) - self._pending.get(spec, 0)
+                for _ in range(max(0, missing)):
+                    self._pending[spec] = self._pending.get(spec, 0) + 1
+                    future = self._executor.submit(_generate_into, str(self.directory), spec, self._passphrase)
+                    future.add_done_callback(lambda f, s=spec: self._generated(s, f))
+                    futures.append(future)
+        if wait:
+            for future in futures:
+                if not future.cancelled():
+                    future.exception()
+        return len(futures)
+
+    def _generated(self, spec: str, future):
+        with self._lock:
+            self._pending[spec] -= 1
+        if not future.cancelled() and future.exception() is not None:
+            logger.warning(f"⚠️ Background {spec} keygen failed: {future.exception()}")
+
+    def _claim(self, spec: str):
+        spec_dir = self.directory / spec
+        if not spec_dir.is_dir():
+            return None
+        for path in sorted(spec_dir.glob("*.pem")):
+            claimed = path.with_name(f".{path.name}.{os.getpid()}.claimed")
+            try:
+                os.rename(path, claimed)
+            except OSError:
+                continue  # Taken by another process
+            try:
+                return serialization.load_pem_private_key(claimed.read_bytes(), password=self._passphrase)
+            finally:
+                claimed.unlink()
+        return None
+
+    def take(self, spec: str, refill: bool = True):
+        """
+        A private key of spec, used by no one else: from the pool if one is
+        in stock, else generated inline. Starts refilling a spec with a
+        configured depth unless refill=False.
+        """
+        spec = _check_spec(spec)
+        key = self._claim(spec)
+        if key is not None:
+            self.hits += 1
+        else:
+            self.misses += 1
+            key = generate_key(spec)
+        if refill and spec in self.depth:
+            self.fill({spec: self.depth[spec]})
+        return key
+
+    def fixture(self, name: str, spec: str = "rsa-2048"):
+        """The same private key of spec for name on every call"""
+        spec = _check_spec(spec)
+        key = _derive_key(spec, name)
+        if key is not None:
+            return key
+        fixtures = self.directory / "fixtures"
+        fixtures.mkdir(exist_ok=True)
+        path = fixtures / f"{hashlib.sha256(name.encode()).hexdigest()[:16]}-{spec}.pem"
+        if not path.exists():
+            pem = _encrypt(self.take(spec), self._passphrase)
+            # First writer wins when several processes pin the same name
+            try:
+                fd = os.open(path, os.O_WRONLY | os.O_CREAT | os.O_EXCL, 0o600)
+                with os.fdopen(fd, "wb") as f:
+                    f.write(pem)
+            except FileExistsError:
+                pass
+        return serialization.load_pem_private_key(path.read_bytes(), password=self._passphrase)
+
+    def status(self) -> Dict[str, Dict[str, int]]:
+        specs = set(self.depth) | {d.name for d in self.directory.iterdir()
+                                   if d.is_dir() and d.name != "fixtures"}
+        return {spec: {"available": self.available(spec), "depth": self.depth.get(spec, 0),
+                       "pending": self._pending.get(spec, 0)} for spec in sorted(specs)}
+
+    def close(self, wait: bool = True):
+        """Stop the keygen processes (wait=True lets scheduled keys finish)"""
+        with self._lock:
+            executor, self._executor = self._executor, None
+        if executor is not None:
+            executor.shutdown(wait=wait, cancel_futures=not wait)
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *exc):
+        self.close()
+
+
+def _parse_depth(values: List[str]) -> Dict[str, int]:
+    depth = {}
+    for value in values:
+        spec, _, count = value.partition("=")
+        depth[_check_spec(spec)] = int(count or 1)
+    return depth
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Pre-generate keys into an encrypted key pool")
+    parser.add_argument("--dir", default=DEFAULT_POOL_DIR, help="Pool directory")
+    parser.add_argument("--fill", nargs="+", default=[], metavar="SPEC=N",
+                        help="Keep N keys of SPEC in stock, e.g. rsa-4096=4 ec-p256=8")
+    parser.add_argument("--workers", type=int, help="Keygen processes (default: CPU count)")
+    args = parser.parse_args()
+
+    logging.basicConfig(level=logging.INFO, format="%(message)s")
+    try:
+        depth = _parse_depth(args.fill)
+    except ValueError as e:
+        parser.error(str(e))
+    with KeyPool(args.dir, depth, workers=args.workers) as pool:
+        scheduled = pool.fill(wait=True)
+        logger.info(f"✓ Generated {scheduled} keys")
+        for spec, counts in pool.status().items():
+            logger.info(f"  {spec}: {counts['available']} in stock")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -9,16 +9,32 @@ Classes:
     TestHarness: Provides comprehensive testing framework
     SchemaValidator: Validates database schemas and configurations
     FuzzManager: Manages fuzz testing and corpora
+    FuzzCampaign: Parallel libFuzzer/AFL++ campaigns with content-addressed corpora
+
+Functions:
+    parse_make_test_output: Parses OpenSSL make test output into test results
+    write_junit_report: Writes parsed make test results as JUnit XML
+    run_bundle: Runs a cross build's deferred test bundle on a native runner
+    shard_tests: Splits the test suite into TESTS= shards balanced on past durations
 """
 
 from .quality_manager import CodeQualityManager
 from .test_harness import NgapyTestHarness
 from .schema_validator import DatabaseSchemaValidator
 from .fuzz_manager import FuzzCorporaManager
+from .fuzz_campaign import FuzzCampaign
+from .openssl_test_runner import parse_make_test_output, write_junit_report
+from .deferred_tests import run_bundle
+from .test_sharding import shard_tests
 
 __all__ = [
     "CodeQualityManager",
     "NgapyTestHarness",
     "DatabaseSchemaValidator",
     "FuzzCorporaManager",
+    "FuzzCampaign",
+    "parse_make_test_output",
+    "write_junit_report",
+    "run_bundle",
+    "shard_tests",
 ]
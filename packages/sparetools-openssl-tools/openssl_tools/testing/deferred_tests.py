@@ -0,0 +1,215 @@
+#!/usr/bin/env python3
+"""
+Deferred OpenSSL test runs for cross builds
+
+A cross-compiled package (e.g. armv8 built on an x86_64 runner with
+aarch64-linux-gnu-gcc) cannot run `make test` where it was built. With
+run_tests=fast|full the recipe then bundles the built test tree instead:
+test programs, apps/openssl, the libraries and providers, the test
+recipes and data, without object files. A native runner of the target
+arch runs the bundle with run_bundle(), which does what `make test` does
+(test/run_tests.pl with SRCTOP, BLDTOP, HARNESS_JOBS and TESTS) and
+writes the same JUnit report as an in-build run. Nothing is compiled
+there: the runner needs perl, not a toolchain.
+
+A bundle is <name>.tar.gz with the manifest as <name>.json next to it
+(and inside, at the top):
+
+    {"format": "sparetools-deferred-tests/1", "reference": "sparetools-openssl/3.3.2",
+     "package_id": "...", "os": "Linux", "arch": "armv8", "tier": "fast",
+     "tests": ["test_evp", ...] or null (full suite), "srctop": "build",
+     "bldtop": "build", "fipskey": "..."}
+"""
+
+import json
+import os
+import platform
+import shutil
+import subprocess
+import tarfile
+import tempfile
+from datetime import datetime, timezone
+from pathlib import Path
+from typing import Dict, List, Optional, Tuple
+
+try:
+    from .openssl_test_runner import parse_make_test_output, write_junit_report
+except ImportError:
+    from openssl_test_runner import parse_make_test_output, write_junit_report
+
+BUNDLE_FORMAT = "sparetools-deferred-tests/1"
+MANIFEST_NAME = "sparetools-deferred-tests.json"
+
+# Conan arch -> platform.machine() values that run it natively
+ARCH_MACHINES = {
+    "armv8": ("aarch64", "arm64"),
+    "x86_64": ("x86_64", "amd64"),
+    "x86": ("i386", "i686", "x86"),
+    "armv7": ("armv7l",),
+    "armv7hf": ("armv7l",),
+    "ppc64le": ("ppc64le",),
+    "s390x": ("s390x",),
+}
+
+# What running the suite does not need
+_EXCLUDED_SUFFIXES = (".o", ".obj", ".d", ".gcno", ".gcda")
+
+
+def _makefile_value(makefile: Path, variable: str) -> Optional[str]:
+    """First `VARIABLE=value` of a generated Makefile, None if absent"""
+    try:
+        for line in makefile.read_text(errors="replace").splitlines():
+            name, sep, value = line.partition("=")
+            if sep and name.strip() == variable:
+                return value.strip()
+    except OSError:
+        pass
+    return None
+
+
+def write_bundle(test_tree: Path, dest_dir: Path, name: str, manifest: Dict) -> Path:
+    """
+    Bundle a built OpenSSL test tree (the directory `make test` runs in)
+    as dest_dir/name.tar.gz plus name.json. The tree goes in as build/; an
+    out-of-tree build's source directory (Makefile SRCDIR) as source/.
+    manifest gets format, srctop, bldtop, fipskey and created filled in.
+    """
+    test_tree = Path(test_tree)
+    srcdir = _makefile_value(test_tree / "Makefile", "SRCDIR") or "."
+    source = (test_tree / srcdir).resolve()
+    separate = source != test_tree.resolve()
+    manifest = dict(manifest, format=BUNDLE_FORMAT, bldtop="build", srctop="source" if separate else "build",
+                    fipskey=_makefile_value(test_tree / "Makefile", "FIPSKEY") or "",
+                    created=datetime.now(timezone.utc).isoformat())
+
+    dest_dir = Path(dest_dir)
+    dest_dir.mkdir(parents=True, exist_ok=True)
+    # A bundle directory inside the tree (autotools builds) stays out of it
+    try:
+        own = "build/" + dest_dir.resolve().relative_to(test_tree.resolve()).as_posix()
+    except ValueError:
+        own = None
+
+    def keep(info: tarfile.TarInfo) -> Optional[tarfile.TarInfo]:
+        if own and (info.name == own or info.name.startswith(own + "/")):
+            return None
+        return None if info.isfile() and info.name.endswith(_EXCLUDED_SUFFIXES) else info
+
+    bundle = dest_dir / f"{name}.tar.gz"
+    manifest_file = dest_dir / f"{name}.json"
+    manifest_file.write_text(json.dumps(manifest, indent=2))
+    tmp = bundle.with_name(f".{bundle.name}.tmp")
+    with tarfile.open(tmp, "w:gz", compresslevel=6) as tar:
+        tar.add(manifest_file, arcname=MANIFEST_NAME)
+        tar.add(test_tree, arcname="build", filter=keep)
+        if separate:
+            tar.add(source, arcname="source", filter=keep)
+    os.replace(tmp, bundle)
+    return bundle
+
+
+def load_bundle_manifest(bundle: Path) -> Dict:
+    """Manifest next to the bundle, else the one inside it"""
+    bundle = Path(bundle)
+    sidecar = bundle.with_name(bundle.name[:-len(".tar.gz")] + ".json") if bundle.name.endswith(".tar.gz") else None
+    if sidecar and sidecar.is_file():
+        manifest = json.loads(sidecar.read_text())
+    else:
+        with tarfile.open(bundle) as tar:
+            manifest = json.load(tar.extractfile(MANIFEST_NAME))
+    if manifest.get("format") != BUNDLE_FORMAT:
+        raise ValueError(f"{bundle} is not a {BUNDLE_FORMAT} bundle")
+    return manifest
+
+
+def runs_natively(arch: str, machine: Optional[str] = None) -> bool:
+    """Whether this host executes binaries built for the Conan arch"""
+    machine = (machine or platform.machine()).lower()
+    return machine in ARCH_MACHINES.get(arch, (arch,))
+
+
+def run_bundle(bundle: Path, results_dir: Path = Path("test_results"), work_dir: Optional[Path] = None,
+               jobs: Optional[int] = None, tests: Optional[List[str]] = None,
+               any_arch: bool = False) -> Tuple[List[Dict], Path, int]:
+    """
+    Extract and run a deferred test bundle. Returns the parsed results, the
+    JUnit report and run_tests.pl's exit code. tests overrides the
+    bundle's TESTS selection (items may hold several space-separated
+    names, `-name` excludes, e.g. a test_sharding shard); any_arch skips
+    the host arch check (for binfmt/QEMU hosts).
+    """
+    manifest = load_bundle_manifest(bundle)
+    if not any_arch and not runs_natively(manifest["arch"]):
+        raise RuntimeError(f"{bundle} holds {manifest['arch']} binaries, this host is {platform.machine()}")
+    perl = shutil.which("perl")
+    if perl is None:
+        raise RuntimeError("perl not found (test/run_tests.pl needs it)")
+
+    results_dir = Path(results_dir)
+    results_dir.mkdir(parents=True, exist_ok=True)
+    cleanup = work_dir is None
+    work = Path(work_dir) if work_dir else Path(tempfile.mkdtemp(prefix="sparetools-deferred-"))
+    try:
+        with tarfile.open(bundle) as tar:
+            # The "tar" filter keeps the executable bits the test programs need
+            if hasattr(tarfile, "data_filter"):
+                tar.extractall(work, filter="tar")
+            else:
+                tar.extractall(work)
+        build, source = work / manifest["bldtop"], work / manifest["srctop"]
+        selected = [t for item in tests for t in item.split()] if tests is not None else manifest.get("tests")
+        env = dict(os.environ, SRCTOP=str(source), BLDTOP=str(build), PERL=perl, EXE_EXT="",
+                   FIPSKEY=manifest.get("fipskey", ""), HARNESS_JOBS=str(jobs or os.cpu_count() or 1))
+        cmd = [perl, str(source / "test" / "run_tests.pl")] + list(selected or [])
+        print(f"▶ {manifest['reference']} ({manifest['arch']}, {manifest['tier']}): "
+              f"{len(selected) if selected else 'all'} test recipes, HARNESS_JOBS={env['HARNESS_JOBS']}")
+        log_file = results_dir / "make-test.log"
+        with open(log_file, "w") as log:
+            returncode = subprocess.run(cmd, cwd=build, env=env, stdout=log, stderr=subprocess.STDOUT).returncode
+        results = parse_make_test_output(log_file.read_text(errors="replace"))
+        junit = write_junit_report(results, results_dir,
+                                   f"openssl make test ({manifest['tier']}, deferred {manifest['arch']})",
+                                   error=f"run_tests.pl exited with {returncode}, see {log_file}")
+        return results, junit, returncode
+    finally:
+        if cleanup:
+            shutil.rmtree(work, ignore_errors=True)
+
+
+def print_summary(results: List[Dict], junit: Path, returncode: int) -> int:
+    """Print a run's outcome; the exit status for it"""
+    failed = [r["name"] for r in results if r["result"] == "FAIL"]
+    passed = sum(1 for r in results if r["result"] == "PASS")
+    ok = not failed and results and not returncode
+    print(f"{'✓' if ok else '✗'} {passed} passed, {len(failed)} failed, "
+          f"{len(results) - passed - len(failed)} skipped: {junit}")
+    for name in failed:
+        print(f"  ✗ {name}")
+    return 0 if ok else 1
+
+
+def main(argv: Optional[List[str]] = None) -> int:
+    import argparse
+
+    parser = argparse.ArgumentParser(description="Run a cross build's deferred OpenSSL tests on a native runner")
+    parser.add_argument("bundle", type=Path, help="<package id>-<tier>.tar.gz written by the recipe")
+    parser.add_argument("--results-dir", type=Path, default=Path("test_results"), help="JUnit and log directory")
+    parser.add_argument("--work-dir", type=Path, help="Extract here and keep it (default: temporary)")
+    parser.add_argument("--jobs", type=int, help="HARNESS_JOBS (default: CPU count)")
+    parser.add_argument("--tests", nargs="+",
+                        help="Test recipes to run instead of the bundle's selection; a shard's TESTS= value "
+                             "as --tests=\"$TESTS\"")
+    parser.add_argument("--any-arch", action="store_true", help="Run even if this host's arch differs")
+    args = parser.parse_args(argv)
+
+    try:
+        results, junit, returncode = run_bundle(args.bundle, args.results_dir, args.work_dir, args.jobs,
+                                                args.tests, args.any_arch)
+    except (OSError, ValueError, RuntimeError, tarfile.TarError) as e:
+        print(f"✗ {e}")
+        return 1
+    return print_summary(results, junit, returncode)
+
+
+if __name__ == "__main__":
+    raise SystemExit(main())
@@ -0,0 +1,318 @@
+#!/usr/bin/env python3
+"""
+Parallel fuzz campaigns over the OpenSSL fuzz targets
+
+Runs the fuzz/ binaries of an enable-fuzz-libfuzzer or enable-fuzz-afl
+build in rounds. Each round gives every target `workers` fuzzing
+processes: libFuzzer `-fork=N` (or `-jobs=N -workers=N`) over one shared
+corpus directory, or one AFL++ main instance plus N-1 secondaries over a
+shared sync directory. Between rounds the corpus is minimized by coverage
+(libFuzzer `-merge=1` into a fresh directory, `afl-cmin` for AFL++) and
+stored as one manifest per target in a ContentAddressedStore. Inputs are
+objects named by their SHA-256 digest, so pushing the store to a remote
+sends only the inputs that remote has not seen yet.
+
+The next round, or the next box, starts from the stored corpus plus the
+seeds from the openssl-fuzz-corpora package. The report lists exec/s,
+executions, corpus size before and after and crashes per target.
+
+benchmark_target() is the short single-process exec/s measurement the
+sparetools-openssl recipe runs for fuzzing builds. It compares the
+throughput of instrumented builds across compilers.
+"""
+
+import json
+import logging
+import os
+import re
+import shutil
+import subprocess
+import tempfile
+import time
+from concurrent.futures import ThreadPoolExecutor
+from dataclasses import asdict, dataclass, field
+from pathlib import Path
+from typing import Dict, List, Optional
+
+logger = logging.getLogger(__name__)
+
+ENGINES = ("libfuzzer", "afl")
+LIBFUZZER_MODES = ("fork", "jobs")
+# libFuzzer progress lines ("#1234 NEW cov: ... exec/s: 5678 ...") and -print_final_stats
+EXEC_PER_SEC = re.compile(r"exec/s:?\s+(\d+)")
+FINAL_EXECS = re.compile(r"stat::number_of_executed_units:\s+(\d+)")
+FINAL_EXEC_PER_SEC = re.compile(r"stat::average_exec_per_sec:\s+(\d+)")
+
+
+def corpus_key(target: str) -> str:
+    return f"fuzz-corpus-{target}"
+
+
+def discover_targets(fuzz_dir: Path) -> List[str]:
+    """Fuzz binaries in an OpenSSL build's fuzz/ directory (the *-test replay drivers excluded)"""
+    if not fuzz_dir.is_dir():
+        return []
+    return sorted(p.name for p in fuzz_dir.iterdir()
+                  if p.is_file() and os.access(p, os.X_OK) and not p.name.endswith("-test") and not p.suffix)
+
+
+def corpus_files(directory: Path) -> List[Path]:
+    return [p for p in directory.rglob("*") if p.is_file() and not p.name.startswith(".")] if directory.is_dir() else []
+
+
+def libfuzzer_stats(log: str) -> Dict[str, int]:
+    """Executions and exec/s from libFuzzer output; the final stats win over progress lines"""
+    stats = {}
+    rates = EXEC_PER_SEC.findall(log)
+    if rates:
+        stats["execs_per_sec"] = int(rates[-1])
+    for key, pattern in (("execs", FINAL_EXECS), ("execs_per_sec", FINAL_EXEC_PER_SEC)):
+        values = pattern.findall(log)
+        if values:
+            stats[key] = sum(int(v) for v in values)
+    return stats
+
+
+def afl_stats(sync_dir: Path) -> Dict[str, int]:
+    """Summed execs_done and execs_per_sec of every instance's fuzzer_stats"""
+    stats = {"execs": 0, "execs_per_sec": 0}
+    for stats_file in sync_dir.glob("*/fuzzer_stats"):
+        for line in stats_file.read_text(errors="replace").splitlines():
+            key, _, value = line.partition(":")
+            key, value = key.strip(), value.strip()
+            if key == "execs_done":
+                stats["execs"] += int(float(value))
+            elif key == "execs_per_sec":
+                stats["execs_per_sec"] += int(float(value))
+    return stats
+
+
+def benchmark_target(binary: str, engine: str, seconds: int, corpus: Optional[str] = None) -> Dict[str, int]:
+    """One fuzzing process for seconds over a scratch copy of corpus; executions and exec/s"""
+    with tempfile.TemporaryDirectory(prefix="fuzz-bench-") as tmp:
+        work = Path(tmp) / "corpus"
+        if corpus and Path(corpus).is_dir():
+            shutil.copytree(corpus, work)
+        else:
+            work.mkdir()
+        if engine == "afl":
+            if not corpus_files(work):
+                (work / "empty").write_bytes(b"\0")
+            sync_dir = Path(tmp) / "sync"
+            env = dict(os.environ, AFL_NO_UI="1", AFL_SKIP_CPUFREQ="1", AFL_I_DONT_CARE_ABOUT_MISSING_CRASHES="1")
+            subprocess.run(["afl-fuzz", "-i", str(work), "-o", str(sync_dir), "-M", "bench", "-V", str(seconds),
+                            "--", binary], capture_output=True, env=env, timeout=seconds * 2 + 120)
+            return afl_stats(sync_dir)
+        result = subprocess.run([binary, f"-max_total_time={seconds}", "-print_final_stats=1",
+                                 f"-artifact_prefix={tmp}/", str(work)],
+                                capture_output=True, text=True, timeout=seconds * 2 + 120)
+        return libfuzzer_stats(result.stdout + result.stderr)
+
+
+@dataclass
+class TargetReport:
+    """One target's totals over all rounds"""
+    target: str
+    engine: str
+    workers: int
+    seconds: float = 0.0
+    execs: int = 0
+    execs_per_sec: float = 0.0
+    corpus_before: int = 0
+    corpus_after: int = 0
+    new_inputs: int = 0
+    crashes: List[str] = field(default_factory=list)
+    uploaded_objects: int = 0
+    error: Optional[str] = None
+
+
+class FuzzCampaign:
+    """Round-based parallel fuzzing with coverage-minimized, content-addressed corpora"""
+
+    def __init__(self, fuzz_dir: Path, work_dir: Path, store_dir: Path, engine: str = "libfuzzer",
+                 targets: Optional[List[str]] = None, workers: Optional[int] = None, parallel_targets: int = 1,
+                 libfuzzer_mode: str = "fork", seeds_dir: Optional[Path] = None, remote: Optional[str] = None,
+                 max_len: Optional[int] = None):
+        if engine not in ENGINES:
+            raise ValueError(f"Unknown fuzzing engine {engine!r} (expected one of {', '.join(ENGINES)})")
+        if libfuzzer_mode not in LIBFUZZER_MODES:
+            raise ValueError(f"Unknown libFuzzer mode {libfuzzer_mode!r}")
+        # Deferred: the development package pulls in the GitHub client
+        from openssl_tools.development.build_system.artifact_store import ContentAddressedStore, create_remote_backend
+
+        # Absolute: libFuzzer runs in a per-target log directory
+        self.fuzz_dir = fuzz_dir.resolve()
+        self.work_dir = work_dir.resolve()
+        self.store = ContentAddressedStore(store_dir, create_remote_backend(remote))
+        self.engine = engine
+        self.targets = targets or discover_targets(fuzz_dir)
+        self.parallel_targets = max(1, min(parallel_targets, len(self.targets) or 1))
+        self.workers = workers or max(1, (os.cpu_count() or 1) // self.parallel_targets)
+        self.libfuzzer_mode = libfuzzer_mode
+        self.seeds_dir = seeds_dir
+        self.max_len = max_len
+
+    # -- corpora ------------------------------------------------------------
+
+    def _seed(self, target: str, corpus: Path) -> None:
+        """Start a round from the stored corpus, or from the package seeds the first time"""
+        if corpus.exists():
+            shutil.rmtree(corpus)
+        if not self.store.materialize(corpus_key(target), corpus):
+            corpus.mkdir(parents=True)
+        seeds = self.seeds_dir / target if self.seeds_dir else None
+        if seeds and seeds.is_dir():
+            for path in corpus_files(seeds):
+                dest = corpus / f"seed-{path.name}"
+                if not dest.exists():
+                    shutil.copyfile(path, dest)
+        # Materialized objects are read-only hard links; fuzzers add files next to them
+        corpus.chmod(0o755)
+
+    def _minimize(self, target: str, corpus: Path, extra: List[Path]) -> Path:
+        """Coverage-minimized union of corpus and extra directories"""
+        merged = corpus.with_name(f"{corpus.name}.merged")
+        if merged.exists():
+            shutil.rmtree(merged)
+        merged.mkdir(parents=True)
+        binary = self.fuzz_dir / target
+        if self.engine == "libfuzzer":
+            command = [str(binary), "-merge=1", str(merged), str(corpus)] + [str(d) for d in extra]
+        else:
+            staging = corpus.with_name(f"{corpus.name}.staging")
+            if staging.exists():
+                shutil.rmtree(staging)
+            staging.mkdir()
+            for index, path in enumerate(f for d in [corpus] + extra for f in corpus_files(d)):
+                shutil.copyfile(path, staging / f"{index:06d}")
+            command = ["afl-cmin", "-i", str(staging), "-o", str(merged), "--", str(binary)]
+        result = subprocess.run(command, capture_output=True, text=True)
+        if result.returncode != 0 or not corpus_files(merged):
+            logger.warning(f"⚠️ {target}: corpus minimization failed, keeping the unminimized corpus")
+            shutil.rmtree(merged)
+            merged.mkdir()
+            for path in corpus_files(corpus) + [f for d in extra for f in corpus_files(d)]:
+                shutil.copyfile(path, merged / path.name)
+        return merged
+
+    # -- fuzzing ------------------------------------------------------------
+
+    def _run_libfuzzer(self, target: str, corpus: Path, crashes: Path, seconds: int) -> Dict[str, int]:
+        command = [str(self.fuzz_dir / target), f"-max_total_time={seconds}", "-print_final_stats=1",
+                   f"-artifact_prefix={crashes}/"]
+        if self.max_len:
+            command.append(f"-max_len={self.max_len}")
+        if self.libfuzzer_mode == "fork":
+            # Keep fuzzing past a crash; every crash lands in artifact_prefix
+            command += [f"-fork={self.workers}", "-ignore_crashes=1", "-ignore_timeouts=1", "-ignore_ooms=1"]
+        else:
+            command += [f"-jobs={self.workers}", f"-workers={self.workers}"]
+        command.append(str(corpus))
+        logs = corpus.with_name(f"{corpus.name}.logs")
+        logs.mkdir(exist_ok=True)
+        # -jobs writes fuzz-<n>.log into the working directory
+        result = subprocess.run(command, capture_output=True, text=True, cwd=logs,
+                                timeout=seconds * 2 + 300)
+        output = result.stdout + result.stderr
+        if self.libfuzzer_mode == "jobs":
+            job_logs = [p.read_text(errors="replace") for p in logs.glob("fuzz-*.log")]
+            for p in logs.glob("fuzz-*.log"):
+                p.unlink()
+            stats = {"execs": 0, "execs_per_sec": 0}
+            for log in job_logs:
+                job = libfuzzer_stats(log)
+                stats["execs"] += job.get("execs", 0)
+                stats["execs_per_sec"] += job.get("execs_per_sec", 0)
+            return stats
+        return libfuzzer_stats(output)
+
+    def _run_afl(self, target: str, corpus: Path, sync_dir: Path, seconds: int) -> Dict[str, int]:
+        binary = str(self.fuzz_dir / target)
+        env = dict(os.environ, AFL_NO_UI="1", AFL_SKIP_CPUFREQ="1")
+        processes = []
+        for index in range(self.workers):
+            role = ["-M", "main"] if index == 0 else ["-S", f"secondary{index}"]
+            processes.append(subprocess.Popen(["afl-fuzz", "-i", str(corpus), "-o", str(sync_dir), *role,
+                                               "-V", str(seconds), "--", binary],
+                                              stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL, env=env))
+        for process in processes:
+            try:
+                process.wait(timeout=seconds * 2 + 300)
+            except subprocess.TimeoutExpired:
+                process.kill()
+        return afl_stats(sync_dir)
+
+    def run_target(self, target: str, duration: int, merge_interval: int) -> TargetReport:
+        """All rounds of one target; the corpus is merged and stored after each round"""
+        from openssl_tools.development.build_system.artifact_store import file_digest
+
+        report = TargetReport(target, self.engine, self.workers)
+        target_dir = self.work_dir / target
+        corpus = target_dir / "corpus"
+        crashes = target_dir / "crashes"
+        crashes.mkdir(parents=True, exist_ok=True)
+        self._seed(target, corpus)
+        report.corpus_before = len(corpus_files(corpus))
+        initial = {file_digest(p) for p in corpus_files(corpus)}
+        known = {p.name for p in corpus_files(crashes)}
+        rates = []
+        start = time.monotonic()
+        try:
+            while time.monotonic() - start < duration:
+                seconds = int(max(1, min(merge_interval, duration - (time.monotonic() - start))))
+                round_start = time.monotonic()
+                if self.engine == "libfuzzer":
+                    stats = self._run_libfuzzer(target, corpus, crashes, seconds)
+                    extra = []
+                else:
+                    sync_dir = target_dir / "sync"
+                    if sync_dir.exists():
+                        shutil.rmtree(sync_dir)
+                    stats = self._run_afl(target, corpus, sync_dir, seconds)
+                    extra = [q for q in sync_dir.glob("*/queue")]
+                    for crash in sync_dir.glob("*/crashes/id:*"):
+                        shutil.copyfile(crash, crashes / f"{crash.parent.parent.name}-{crash.name.replace(':', '_')}")
+                report.execs += stats.get("execs", 0)
+                if stats.get("execs_per_sec"):
+                    rates.append((stats["execs_per_sec"], time.monotonic() - round_start))
+                merged = self._minimize(target, corpus, extra)
+                self.store.put_tree(corpus_key(target), merged)
+                shutil.rmtree(corpus)
+                os.replace(merged, corpus)
+        except (OSError, subprocess.SubprocessError) as e:
+            report.error = str(e)
+            logger.error(f"❌ {target}: {e}")
+        report.seconds = round(time.monotonic() - start, 1)
+        # Time-weighted mean over rounds
+        weight = sum(w for _, w in rates)
+        report.execs_per_sec = round(sum(r * w for r, w in rates) / weight, 1) if weight else 0.0
+        report.corpus_after = len(corpus_files(corpus))
+        manifest = self.store.load_manifest(corpus_key(target))
+        if manifest:
+            # Object keys are "objects/<aa>/<sha256>[.x]"
+            report.new_inputs = len({f["key"].split("/")[-1].split(".")[0] for f in manifest["files"]} - initial)
+            if self.store.remote:
+                report.uploaded_objects = self.store.push(corpus_key(target), manifest)
+        report.crashes = sorted(p.name for p in corpus_files(crashes) if p.name not in known)
+        logger.info(f"🐛 {target}: {report.execs_per_sec:.0f} exec/s, corpus {report.corpus_before} -> "
+                    f"{report.corpus_after}, {len(report.crashes)} new crash(es)")
+        return report
+
+    def run(self, duration: int, merge_interval: int = 600) -> List[TargetReport]:
+        """Fuzz every target for duration seconds, parallel_targets at a time"""
+        if not self.targets:
+            raise RuntimeError(f"No fuzz targets found in {self.fuzz_dir}")
+        logger.info(f"🚀 Fuzzing {len(self.targets)} target(s) with {self.engine}, "
+                    f"{self.parallel_targets} at a time x {self.workers} worker(s), {duration}s each")
+        with ThreadPoolExecutor(max_workers=self.parallel_targets) as pool:
+            return list(pool.map(lambda t: self.run_target(t, duration, merge_interval), self.targets))
+
+
+def write_report(reports: List[TargetReport], path: Path) -> Path:
+    path.parent.mkdir(parents=True, exist_ok=True)
+    data = {"timestamp": time.time(), "targets": [asdict(r) for r in reports],
+            "execs_per_sec": round(sum(r.execs_per_sec for r in reports), 1)}
+    tmp = Path(tempfile.mkstemp(dir=path.parent, prefix=f".{path.name}.")[1])
+    tmp.write_text(json.dumps(data, indent=2))
+    os.replace(tmp, path)
+    return path
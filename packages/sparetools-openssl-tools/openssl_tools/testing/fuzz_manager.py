@@ -1,7 +1,8 @@
 #!/usr/bin/env python3
 """
 Fuzz Corpora Manager
-Manages the OpenSSL fuzz corpora Conan package.
+Manages the OpenSSL fuzz corpora Conan package and runs parallel fuzz
+campaigns seeded from it (fuzz_campaign.py).
 """
 
 import argparse
@@ -11,6 +12,12 @@ import subprocess
 from pathlib import Path
 from typing import List, Optional
 
+try:
+    from openssl_tools.conan_session import run_conan
+except ImportError:  # Run as a script without openssl_tools installed
+    def run_conan(args, cwd=None, check=False, wait=False):
+        return subprocess.run(["conan", *args], capture_output=True, text=True, cwd=cwd, check=check)
+
 
 class FuzzCorporaManager:
     """Manages fuzz corpora Conan package operations."""
@@ -35,7 +42,7 @@ class FuzzCorporaManager:
                 "--format=json"
             ]
             
-            result = subprocess.run(cmd, capture_output=True, text=True, check=True)
+            result = run_conan(cmd[1:], check=True)
             print(f"[OK] Package built successfully")
             return True
             
@@ -60,7 +67,7 @@ class FuzzCorporaManager:
                 "--all"
             ]
             
-            result = subprocess.run(cmd, capture_output=True, text=True, check=True)
+            result = run_conan(cmd[1:], check=True)
             print(f"[OK] Package uploaded successfully to {remote}")
             return True
             
@@ -104,7 +111,7 @@ openssl-fuzz-corpora:include_metadata=True
                 "--format=json"
             ]
             
-            result = subprocess.run(cmd, capture_output=True, text=True, check=True)
+            result = run_conan(cmd[1:], check=True)
             
             # Get the corpora path
             corpora_path = self._get_corpora_path()
@@ -135,7 +142,7 @@ openssl-fuzz-corpora:include_metadata=True
         try:
             # Query for the package path
             cmd = ["conan", "list", "openssl-fuzz-corpora/1.0.0", "--format=json"]
-            result = subprocess.run(cmd, capture_output=True, text=True, check=True)
+            result = run_conan(cmd[1:], check=True)
             
             # Parse the JSON output to find the package path
             import json
@@ -167,8 +174,13 @@ openssl-fuzz-corpora:include_metadata=True
             print(f"[WARN] Could not list profiles: {e}")
             return []
     
-    def setup_corpora_for_fuzz_tests(self, target_dir: Path) -> bool:
-        """Set up corpora data for fuzz tests in the target directory."""
+    def setup_corpora_for_fuzz_tests(self, target_dir: Path, fuzz_dir: Optional[Path] = None) -> bool:
+        """
+        Set up corpora data for fuzz tests in the target directory. The fuzz
+        binaries of a sparetools-openssl fuzzing=libfuzzer|afl package (its
+        fuzz component, SPARETOOLS_OPENSSL_FUZZ_DIR in the run environment)
+        are copied next to them into target_dir/fuzz.
+        """
         print(f"[SETUP] Setting up corpora data in: {target_dir}")
         
         try:
@@ -192,12 +204,88 @@ openssl-fuzz-corpora:include_metadata=True
             
             shutil.copytree(corpora_path, target_dir / "corpora")
             
+            fuzz_dir = fuzz_dir or (Path(os.environ["SPARETOOLS_OPENSSL_FUZZ_DIR"])
+                                    if os.environ.get("SPARETOOLS_OPENSSL_FUZZ_DIR") else None)
+            if fuzz_dir and fuzz_dir.is_dir():
+                if (target_dir / "fuzz").exists():
+                    shutil.rmtree(target_dir / "fuzz")
+                shutil.copytree(fuzz_dir, target_dir / "fuzz")
+                print(f"[OK] Fuzz targets from {fuzz_dir} set up in {target_dir / 'fuzz'}")
+            
             print(f"[OK] Corpora data set up successfully in {target_dir / 'corpora'}")
             return True
             
         except Exception as e:
             print(f"[ERROR] Failed to set up corpora data: {e}")
             return False
+    
+    def compare_throughput(self, fuzz_dirs: List[Path], seconds: int = 0) -> bool:
+        """
+        exec/s per target across fuzz builds (e.g. one per compiler). With
+        seconds > 0 every target is measured again, otherwise the numbers
+        the recipe recorded in fuzz-targets.json are shown.
+        """
+        try:
+            from openssl_tools.testing.fuzz_campaign import benchmark_target, discover_targets
+        except ImportError:
+            from fuzz_campaign import benchmark_target, discover_targets
+        import json
+        
+        columns = []
+        for fuzz_dir in fuzz_dirs:
+            manifest_path = fuzz_dir / "fuzz-targets.json"
+            manifest = json.loads(manifest_path.read_text()) if manifest_path.exists() else {}
+            label = manifest.get("compiler") or str(fuzz_dir)
+            engine = manifest.get("engine", "libfuzzer")
+            throughput = {}
+            for target in manifest.get("targets") or discover_targets(fuzz_dir):
+                if seconds > 0:
+                    throughput[target] = benchmark_target(str(fuzz_dir / target), engine, seconds).get("execs_per_sec", 0)
+                else:
+                    throughput[target] = manifest.get("throughput", {}).get(target, {}).get("execs_per_sec", 0)
+            columns.append((f"{label} ({engine})", throughput))
+        if not columns:
+            print("[ERROR] No fuzz builds given")
+            return False
+        
+        targets = sorted({t for _, throughput in columns for t in throughput})
+        width = max(len(label) for label, _ in columns) + 2
+        print(f"{'target':<20}" + "".join(f"{label:>{width}}" for label, _ in columns))
+        for target in targets:
+            print(f"{target:<20}" + "".join(f"{throughput.get(target, 0):>{width}}" for _, throughput in columns))
+        return True
+    
+    def run_campaign(self, fuzz_dir: Path, work_dir: Path, duration: int, engine: str = "libfuzzer",
+                     targets: Optional[List[str]] = None, workers: Optional[int] = None,
+                     parallel_targets: int = 1, merge_interval: int = 600, libfuzzer_mode: str = "fork",
+                     store_dir: Optional[Path] = None, remote: Optional[str] = None,
+                     seed_from_package: bool = True) -> bool:
+        """Fuzz the targets in fuzz_dir, seeded from the corpora package; report in work_dir"""
+        try:
+            from openssl_tools.testing.fuzz_campaign import FuzzCampaign, write_report
+        except ImportError:
+            from fuzz_campaign import FuzzCampaign, write_report
+        
+        seeds_dir = None
+        if seed_from_package and self.setup_corpora_for_fuzz_tests(work_dir / "seeds"):
+            seeds_dir = work_dir / "seeds" / "corpora"
+        try:
+            campaign = FuzzCampaign(fuzz_dir, work_dir / "targets", store_dir or work_dir / "store", engine=engine,
+                                    targets=targets, workers=workers, parallel_targets=parallel_targets,
+                                    libfuzzer_mode=libfuzzer_mode, seeds_dir=seeds_dir, remote=remote)
+            reports = campaign.run(duration, merge_interval)
+        except (RuntimeError, ValueError) as e:
+            print(f"[ERROR] Fuzz campaign failed: {e}")
+            return False
+        
+        report_path = write_report(reports, work_dir / "fuzz_campaign_report.json")
+        for report in reports:
+            status = f"ERROR {report.error}" if report.error else f"{len(report.crashes)} crash(es)"
+            print(f"[INFO] {report.target:<20} {report.execs_per_sec:>10.0f} exec/s  "
+                  f"corpus {report.corpus_before} -> {report.corpus_after} "
+                  f"(+{report.new_inputs}, {report.uploaded_objects} uploaded)  {status}")
+        print(f"[OK] Campaign report: {report_path}")
+        return not any(report.error for report in reports)
 
 
 def main():
@@ -222,10 +310,34 @@ def main():
     # Setup command
     setup_parser = subparsers.add_parser("setup", help="Set up corpora data for fuzz tests")
     setup_parser.add_argument("--target-dir", required=True, help="Target directory for corpora data")
+    setup_parser.add_argument("--fuzz-dir", help="Fuzz binaries to copy along (default: $SPARETOOLS_OPENSSL_FUZZ_DIR)")
     
     # List profiles command
     subparsers.add_parser("list-profiles", help="List available Conan profiles")
     
+    # Throughput command
+    throughput_parser = subparsers.add_parser("throughput", help="Compare fuzz target exec/s across fuzz builds")
+    throughput_parser.add_argument("--fuzz-dir", action="append", required=True,
+                                   help="bin/fuzz of a fuzzing package (repeatable)")
+    throughput_parser.add_argument("--seconds", type=int, default=0,
+                                   help="Measure again for this long per target (default: recorded numbers)")
+    
+    # Campaign command
+    campaign_parser = subparsers.add_parser("campaign", help="Run a parallel fuzz campaign over the fuzz targets")
+    campaign_parser.add_argument("--fuzz-dir", required=True, help="fuzz/ directory of an enable-fuzz-* build")
+    campaign_parser.add_argument("--work-dir", default="fuzz-campaign", help="Corpora, crashes and report")
+    campaign_parser.add_argument("--engine", choices=["libfuzzer", "afl"], default="libfuzzer")
+    campaign_parser.add_argument("--target", action="append", dest="targets", help="Target (repeatable; default: all)")
+    campaign_parser.add_argument("--duration", type=int, default=3600, help="Seconds per target")
+    campaign_parser.add_argument("--merge-interval", type=int, default=600,
+                                 help="Seconds between corpus merges")
+    campaign_parser.add_argument("--workers", type=int, help="Fuzzing processes per target (default: cores / parallel)")
+    campaign_parser.add_argument("--parallel", type=int, default=1, help="Targets fuzzed at once")
+    campaign_parser.add_argument("--libfuzzer-mode", choices=["fork", "jobs"], default="fork")
+    campaign_parser.add_argument("--store", help="Content-addressed corpus store (default: <work-dir>/store)")
+    campaign_parser.add_argument("--remote-store", help="Remote tier for the store (s3://, https://, file://)")
+    campaign_parser.add_argument("--no-seed", action="store_true", help="Do not seed from the corpora package")
+    
     args = parser.parse_args()
     
     if not args.command:
@@ -244,7 +356,16 @@ def main():
     elif args.command == "install":
         success = manager.install_package(args.profile, args.build_type)
     elif args.command == "setup":
-        success = manager.setup_corpora_for_fuzz_tests(Path(args.target_dir))
+        success = manager.setup_corpora_for_fuzz_tests(Path(args.target_dir),
+                                                       Path(args.fuzz_dir) if args.fuzz_dir else None)
+    elif args.command == "throughput":
+        success = manager.compare_throughput([Path(d) for d in args.fuzz_dir], args.seconds)
+    elif args.command == "campaign":
+        success = manager.run_campaign(Path(args.fuzz_dir), Path(args.work_dir), args.duration, engine=args.engine,
+                                       targets=args.targets, workers=args.workers, parallel_targets=args.parallel,
+                                       merge_interval=args.merge_interval, libfuzzer_mode=args.libfuzzer_mode,
+                                       store_dir=Path(args.store) if args.store else None,
+                                       remote=args.remote_store, seed_from_package=not args.no_seed)
     elif args.command == "list-profiles":
         profiles = manager.list_available_profiles()
         print(f"[INFO] Available profiles: {', '.join(profiles)}")
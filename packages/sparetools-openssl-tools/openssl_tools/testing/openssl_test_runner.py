@@ -0,0 +1,133 @@
+#!/usr/bin/env python3
+"""
+OpenSSL make test result parsing
+
+Turns the TAP::Harness summary printed by OpenSSL's `make test`
+(test/run_tests.pl) into NgapyTestHarness test cases and a JUnit report.
+Each test recipe (test/recipes/NN-test_*.t) becomes one test case:
+
+    03-test_internal_asn1.t ........ ok
+    04-test_asn1_parse.t ........... skipped: no asn1parse
+    30-test_evp.t .................. Dubious, test returned 1 (wstat 256, 0x100)
+
+Recipes listed under "Test Summary Report" are failures even when their
+progress line was interleaved with other output (HARNESS_JOBS > 1).
+"""
+
+import re
+import sys
+from pathlib import Path
+from typing import Dict, List, Optional
+
+try:
+    from .test_harness import NgapyTestHarness, TestResult
+except ImportError:
+    from test_harness import NgapyTestHarness, TestResult
+
+# Recipes for run_tests=fast: EVP, providers, TLS and X.509, the areas our
+# consumers exercise, in a couple of minutes instead of the full suite.
+FAST_TESTS = [
+    "test_evp",
+    "test_evp_fetch_prov",
+    "test_provider",
+    "test_prov_config",
+    "test_rand",
+    "test_sslapi",
+    "test_ssl_new",
+    "test_tls13messages",
+    "test_x509",
+    "test_verify",
+    "test_asn1_parse",
+]
+
+_RESULT_LINE = re.compile(r"^(?:\[[\d:]+\]\s+)?(\d\d-test_\S+?)\.t\s+\.+\s*(.*?)\s*$")
+_SUMMARY_LINE = re.compile(r"^(\d\d-test_\S+?)\.t\s+\(Wstat:")
+_DURATION = re.compile(r"(\d+)\s+ms\b")
+
+
+def recipe_name(recipe: str) -> str:
+    """'30-test_evp' -> 'test_evp', the name TESTS= expects"""
+    return recipe.split("-", 1)[1] if "-" in recipe else recipe
+
+
+def parse_make_test_output(output: str) -> List[Dict]:
+    """One {name, result, message, duration} dict per test recipe, in output order"""
+    results: Dict[str, Dict] = {}
+    failed = set()
+    in_summary = False
+    for line in output.splitlines():
+        stripped = line.strip()
+        if stripped.startswith("Test Summary Report"):
+            in_summary = True
+            continue
+        if in_summary:
+            match = _SUMMARY_LINE.match(stripped)
+            if match:
+                failed.add(match.group(1))
+            continue
+        match = _RESULT_LINE.match(stripped)
+        if not match:
+            continue
+        recipe, status = match.groups()
+        duration = _DURATION.search(status)
+        entry = {"name": recipe, "message": "", "duration": int(duration.group(1)) / 1000.0 if duration else 0.0}
+        if status.startswith("ok"):
+            entry["result"] = TestResult.PASS.value
+        elif status.startswith("skipped"):
+            entry["result"] = TestResult.SKIP.value
+            entry["message"] = status.partition(":")[2].strip()
+        elif not status or re.match(r"^\d+/\d+", status):
+            continue  # progress output; the final status line follows
+        else:
+            entry["result"] = TestResult.FAIL.value
+            entry["message"] = status
+        results[recipe] = entry
+
+    for recipe in failed:
+        entry = results.setdefault(recipe, {"name": recipe, "message": "", "duration": 0.0})
+        if entry.get("result") != TestResult.FAIL.value:
+            entry["result"] = TestResult.FAIL.value
+            entry["message"] = entry["message"] or "listed in Test Summary Report"
+    return list(results.values())
+
+
+def write_junit_report(results: List[Dict], results_dir: Path, suite_name: str = "openssl make test",
+                       error: Optional[str] = None) -> Path:
+    """
+    JUnit XML for parsed results via NgapyTestHarness. A run that produced
+    no recipe results (make test itself failed) gets a single error case
+    carrying `error` so CI still shows a red test rather than nothing.
+    """
+    harness = NgapyTestHarness(Path(results_dir))
+    try:
+        harness.start_test_suite(suite_name)
+        for entry in results:
+            harness.record(entry["name"], TestResult(entry["result"]), entry.get("duration", 0.0),
+                           entry.get("message", ""))
+        if not results and error:
+            harness.record("make_test", TestResult.ERROR, message=error)
+        harness.end_test_suite()
+        return harness.generate_junit_xml()
+    finally:
+        harness.cleanup()
+
+
+def main():
+    """Convert a saved make test log into a JUnit report"""
+    import argparse
+
+    parser = argparse.ArgumentParser(description="OpenSSL make test log to JUnit XML")
+    parser.add_argument("log", type=Path, help="make test output")
+    parser.add_argument("--results-dir", type=Path, default=Path("test_results"), help="Results directory")
+    parser.add_argument("--suite", default="openssl make test", help="Test suite name")
+    args = parser.parse_args()
+
+    results = parse_make_test_output(args.log.read_text(errors="replace"))
+    junit = write_junit_report(results, args.results_dir, args.suite, error="no test results in log")
+    failures = [r["name"] for r in results if r["result"] == TestResult.FAIL.value]
+    print(f"{len(results)} test recipes, {len(failures)} failed: {junit}")
+    sys.exit(1 if failures or not results else 0)
+
+
+if __name__ == "__main__":
+    main()
@@ -2,15 +2,26 @@
 """
 Enhanced Code Quality Management System
 Inspired by oms-dev patterns for static analysis, coverage metrics, and quality gates
+
+clang-tidy, cppcheck and gcov run one process per translation unit on a
+worker pool, like run-clang-tidy, over the entries of compile_commands.json
+when there is one. Per-TU results are cached under
+conan-dev/quality-cache, keyed by the digest of the TU and the local
+headers it includes, the tool version and the tool configuration, so a
+re-run only analyzes what changed.
 """
 
 import os
 import sys
 import json
 import yaml
+import hashlib
 import logging
+import shlex
 import subprocess
+import threading
 import xml.etree.ElementTree as ET
+from concurrent.futures import ThreadPoolExecutor
 from pathlib import Path
 from typing import Dict, List, Optional, Tuple
 from datetime import datetime
@@ -20,14 +31,101 @@ import re
 logging.basicConfig(level=logging.INFO, format='%(asctime)s - %(levelname)s - %(message)s')
 logger = logging.getLogger(__name__)
 
+EXCLUDED_PARTS = frozenset(("test", "tests", "demos", "fuzz"))
+SOURCE_SUFFIXES = (".c", ".cpp", ".cc", ".cxx")
+INCLUDE_RE = re.compile(r'^\s*#\s*include\s*"([^"]+)"', re.MULTILINE)
+
+
+def parse_lcov_tracefile(lcov_file: Path) -> Dict[str, Dict[str, int]]:
+    """
+    Per-source totals of an lcov tracefile: lines_found/lines_hit from
+    LF/LH, functions_hit from FNH. A file listed by several records (one
+    per test name) is summed.
+    """
+    coverage_data: Dict[str, Dict[str, int]] = {}
+    current = None
+    fields = {"LF": "lines_found", "LH": "lines_hit", "FNH": "functions_hit"}
+    with open(lcov_file, 'r', errors='replace') as f:
+        for line in f:
+            tag, _, value = line.rstrip('\n').partition(':')
+            if tag == 'SF':
+                current = coverage_data.setdefault(value, {})
+            elif tag in fields and current is not None:
+                current[fields[tag]] = current.get(fields[tag], 0) + int(value)
+            elif tag == 'end_of_record':
+                current = None
+    return coverage_data
+
+
+def lcov_covered_files(lcov_file: Path, source_root: Optional[Path] = None) -> List[str]:
+    """Source files with at least one executed line, relative to source_root when under it"""
+    covered = []
+    root = source_root.resolve() if source_root else None
+    for source, data in parse_lcov_tracefile(lcov_file).items():
+        if data.get("lines_hit", 0) > 0 or data.get("functions_hit", 0) > 0:
+            path = Path(source)
+            if root and path.is_absolute() and path.is_relative_to(root):
+                path = path.relative_to(root)
+            covered.append(path.as_posix())
+    return sorted(covered)
+
+
+class AnalysisCache:
+    """Per-TU tool results stored by content key, one JSON file per entry"""
+
+    def __init__(self, cache_dir: Path, enabled: bool = True):
+        self.cache_dir = cache_dir
+        self.enabled = enabled
+        self.hits = 0
+        self.misses = 0
+        self._lock = threading.Lock()
+
+    @staticmethod
+    def key(*parts: str) -> str:
+        return hashlib.sha256("\0".join(parts).encode()).hexdigest()
+
+    def _path(self, tool: str, key: str) -> Path:
+        return self.cache_dir / tool / key[:2] / f"{key}.json"
+
+    def get(self, tool: str, key: str):
+        path = self._path(tool, key)
+        if self.enabled and path.is_file():
+            try:
+                with open(path) as f:
+                    value = json.load(f)
+                with self._lock:
+                    self.hits += 1
+                return value
+            except (OSError, ValueError):
+                pass
+        with self._lock:
+            self.misses += 1
+        return None
+
+    def put(self, tool: str, key: str, value):
+        if not self.enabled:
+            return
+        path = self._path(tool, key)
+        path.parent.mkdir(parents=True, exist_ok=True)
+        tmp = path.with_suffix(f".{threading.get_ident()}.tmp")
+        with open(tmp, 'w') as f:
+            json.dump(value, f)
+        os.replace(tmp, path)
+
+
 class CodeQualityManager:
     """Enhanced code quality management with static analysis and coverage metrics"""
     
-    def __init__(self, project_root: Path):
+    def __init__(self, project_root: Path, jobs: Optional[int] = None, use_cache: bool = True):
         self.project_root = project_root
         self.quality_config_path = project_root / "conan-dev" / "quality-config.yml"
         self.reports_dir = project_root / "conan-dev" / "quality-reports"
         self.sonar_config_path = project_root / "sonar-project.properties"
+        self.jobs = jobs or os.cpu_count() or 4
+        self.cache = AnalysisCache(project_root / "conan-dev" / "quality-cache", enabled=use_cache)
+        self._tool_versions: Dict[str, str] = {}
+        self._file_digests: Dict[Path, str] = {}
+        self._digest_lock = threading.Lock()
         
         # Create directories
         self.quality_config_path.parent.mkdir(parents=True, exist_ok=True)
@@ -52,7 +150,8 @@ class CodeQualityManager:
                                 "-misc-unused-parameters"
                             ],
                             "header_filter": ".*",
-                            "format_style": "file"
+                            "format_style": "file",
+                            "compile_database": "build"
                         },
                         "cppcheck": {
                             "enabled": True,
@@ -402,38 +501,163 @@ sonar.cfamily.cache.path=.sonar/cache
         with open(self.sonar_config_path, 'w') as f:
             f.write(sonar_config)
     
+    # -- translation units and cache keys -----------------------------------
+
+    def _find_compile_database(self, config: Dict) -> Optional[Path]:
+        """compile_commands.json from the configured build dir, the project root or build/"""
+        candidates = [config.get("compile_database"), ".", "build"]
+        for candidate in candidates:
+            if candidate:
+                path = self.project_root / candidate
+                if path.is_dir():
+                    path = path / "compile_commands.json"
+                if path.is_file():
+                    return path
+        return None
+
+    def _translation_units(self, config: Dict) -> List[Dict]:
+        """
+        Sources to analyze as {"file", "directory", "arguments"}: the entries
+        of compile_commands.json, or every C/C++ source under the project
+        root (without compile flags) when there is no database
+        """
+        units: Dict[Path, Dict] = {}
+        database = self._find_compile_database(config)
+        if database:
+            with open(database) as f:
+                entries = json.load(f)
+            for entry in entries:
+                directory = Path(entry.get("directory", database.parent))
+                source = (directory / entry["file"]).resolve()
+                arguments = entry.get("arguments") or shlex.split(entry.get("command", ""))
+                units.setdefault(source, {"file": source, "directory": directory, "arguments": arguments})
+        else:
+            for pattern in SOURCE_SUFFIXES:
+                for source in self.project_root.glob(f"**/*{pattern}"):
+                    units.setdefault(source.resolve(), {"file": source.resolve(),
+                                                        "directory": self.project_root, "arguments": []})
+        root = self.project_root.resolve()
+        return [unit for path, unit in sorted(units.items())
+                if not EXCLUDED_PARTS.intersection((path.relative_to(root) if path.is_relative_to(root) else path).parts)]
+
+    def _tool_version(self, tool: str) -> str:
+        if tool not in self._tool_versions:
+            try:
+                result = subprocess.run([tool, "--version"], capture_output=True, text=True, timeout=30)
+                self._tool_versions[tool] = result.stdout.strip()
+            except (OSError, subprocess.TimeoutExpired):
+                self._tool_versions[tool] = ""
+        return self._tool_versions[tool]
+
+    def _config_digest(self, config: Dict, *files: Optional[str]) -> str:
+        """Digest of the tool configuration and of the config files it names"""
+        hasher = hashlib.sha256(json.dumps(config, sort_keys=True, default=str).encode())
+        for name in files:
+            path = self.project_root / name if name else None
+            if path and path.is_file():
+                hasher.update(path.read_bytes())
+        return hasher.hexdigest()
+
+    @staticmethod
+    def _include_dirs(unit: Dict) -> List[Path]:
+        dirs, arguments = [], unit["arguments"]
+        for i, arg in enumerate(arguments):
+            if arg in ("-I", "-iquote") and i + 1 < len(arguments):
+                dirs.append(Path(unit["directory"]) / arguments[i + 1])
+            elif arg.startswith("-I") and len(arg) > 2:
+                dirs.append(Path(unit["directory"]) / arg[2:])
+        return dirs
+
+    def _digest_file(self, path: Path) -> str:
+        with self._digest_lock:
+            digest = self._file_digests.get(path)
+        if digest is None:
+            digest = hashlib.sha256(path.read_bytes()).hexdigest()
+            with self._digest_lock:
+                self._file_digests[path] = digest
+        return digest
+
+    def _unit_digest(self, unit: Dict) -> str:
+        """
+        Digest of a TU, its compile arguments and every quoted include that
+        resolves inside the project, followed transitively
+        """
+        include_dirs = self._include_dirs(unit)
+        root = self.project_root.resolve()
+        hasher = hashlib.sha256(" ".join(unit["arguments"][1:]).encode())
+        seen, queue = set(), [Path(unit["file"])]
+        while queue:
+            path = queue.pop()
+            if path in seen:
+                continue
+            seen.add(path)
+            hasher.update(f"{path}:{self._digest_file(path)}".encode())
+            try:
+                text = path.read_text(errors="replace")
+            except OSError:
+                continue
+            for name in INCLUDE_RE.findall(text):
+                for base in [path.parent, *include_dirs]:
+                    candidate = (base / name).resolve()
+                    if candidate.is_file() and candidate.is_relative_to(root):
+                        queue.append(candidate)
+                        break
+        return hasher.hexdigest()
+
+    def _analyze_units(self, tool: str, units: List[Dict], config_digest: str, analyze) -> List[Dict]:
+        """Run analyze(unit) -> issues on the worker pool for TUs without a cached result"""
+        version = self._tool_version(tool)
+        self._file_digests.clear()
+
+        def run(unit: Dict) -> List[Dict]:
+            key = self.cache.key(self._unit_digest(unit), version, config_digest)
+            issues = self.cache.get(tool, key)
+            if issues is None:
+                issues = analyze(unit)
+                self.cache.put(tool, key, issues)
+            return issues
+
+        hits, misses = self.cache.hits, self.cache.misses
+        with ThreadPoolExecutor(max_workers=self.jobs) as pool:
+            results = list(pool.map(run, units))
+        logger.info(f"{tool}: {len(units)} translation units, "
+                    f"{self.cache.misses - misses} analyzed, {self.cache.hits - hits} cached")
+        return [issue for issues in results for issue in issues]
+
+    # -- analyzers ----------------------------------------------------------
+
     def _run_clang_tidy(self, config: Dict) -> List[Dict]:
-        """Run clang-tidy static analysis"""
+        """Run clang-tidy static analysis, one process per translation unit"""
         issues = []
         
         try:
-            # Find C/C++ source files
-            source_files = []
-            for pattern in ["**/*.c", "**/*.cpp", "**/*.cc", "**/*.cxx"]:
-                source_files.extend(self.project_root.glob(pattern))
-            
-            # Filter out test and demo files
-            source_files = [f for f in source_files if not any(
-                part in str(f) for part in ["test", "tests", "demos", "fuzz"]
-            )]
-            
-            for source_file in source_files[:10]:  # Limit for demo
-                cmd = [
-                    "clang-tidy",
-                    str(source_file),
-                    f"--config-file={config['config_file']}",
-                    "--format-style=file"
-                ]
-                
-                result = subprocess.run(cmd, capture_output=True, text=True, timeout=60)
-                
-                if result.returncode == 0 and result.stdout:
-                    # Parse clang-tidy output
-                    for line in result.stdout.split('\n'):
-                        if ':' in line and ('warning:' in line or 'error:' in line):
-                            issue = self._parse_clang_tidy_line(line, source_file)
-                            if issue:
-                                issues.append(issue)
+            database = self._find_compile_database(config)
+            units = self._translation_units(config)
+            checks = ",".join(config.get("checks", []))
+
+            def analyze(unit: Dict) -> List[Dict]:
+                cmd = ["clang-tidy", str(unit["file"]), "--quiet"]
+                if (self.project_root / config["config_file"]).is_file():
+                    cmd.append(f"--config-file={self.project_root / config['config_file']}")
+                elif checks:
+                    cmd.append(f"--checks={checks}")
+                if config.get("header_filter"):
+                    cmd.append(f"--header-filter={config['header_filter']}")
+                cmd.append(f"--format-style={config.get('format_style', 'file')}")
+                if database:
+                    cmd.append(f"-p={database.parent}")
+                result = subprocess.run(cmd, capture_output=True, text=True, timeout=600)
+                found = []
+                # clang-tidy exits non-zero when the TU has compile errors; report them too
+                for line in result.stdout.split('\n'):
+                    if ':' in line and ('warning:' in line or 'error:' in line):
+                        issue = self._parse_clang_tidy_line(line, unit["file"])
+                        if issue:
+                            found.append(issue)
+                return found
+
+            issues = self._analyze_units("clang-tidy", units, self._config_digest(config, config["config_file"]),
+                                         analyze)
             
         except Exception as e:
             logger.error(f"clang-tidy analysis failed: {e}")
@@ -441,27 +665,35 @@ sonar.cfamily.cache.path=.sonar/cache
         return issues
     
     def _run_cppcheck(self, config: Dict) -> List[Dict]:
-        """Run cppcheck static analysis"""
+        """Run cppcheck static analysis, one process per translation unit"""
         issues = []
         
         try:
-            cmd = ["cppcheck"] + config["args"] + ["--xml", str(self.project_root)]
-            
-            result = subprocess.run(cmd, capture_output=True, text=True, timeout=300)
-            
-            if result.returncode == 0 and result.stdout:
-                # Parse XML output
-                root = ET.fromstring(result.stdout)
-                for error in root.findall('error'):
-                    issue = {
-                        "tool": "cppcheck",
-                        "severity": error.get('severity', 'unknown'),
-                        "message": error.get('msg', ''),
-                        "file": error.get('file', ''),
-                        "line": int(error.get('line', 0)),
-                        "category": "static_analysis"
-                    }
-                    issues.append(issue)
+            units = self._translation_units(config)
+
+            def analyze(unit: Dict) -> List[Dict]:
+                # Include paths and defines from the TU's compile command
+                flags = [a for a in unit["arguments"] if a.startswith(("-I", "-D", "-U"))]
+                cmd = ["cppcheck"] + config["args"] + flags + ["--xml", str(unit["file"])]
+                result = subprocess.run(cmd, capture_output=True, text=True, timeout=600,
+                                        cwd=unit["directory"])
+                found = []
+                # cppcheck writes its XML report to stderr
+                if "<results" in result.stderr:
+                    root = ET.fromstring(result.stderr)
+                    for error in root.iter('error'):
+                        location = error.find('location')
+                        found.append({
+                            "tool": "cppcheck",
+                            "severity": error.get('severity', 'unknown'),
+                            "message": error.get('msg', ''),
+                            "file": location.get('file', '') if location is not None else error.get('file', ''),
+                            "line": int((location if location is not None else error).get('line', 0)),
+                            "category": "static_analysis"
+                        })
+                return found
+
+            issues = self._analyze_units("cppcheck", units, self._config_digest(config), analyze)
             
         except Exception as e:
             logger.error(f"cppcheck analysis failed: {e}")
@@ -502,23 +734,36 @@ sonar.cfamily.cache.path=.sonar/cache
         return issues
     
     def _run_gcov_analysis(self, config: Dict) -> Dict:
-        """Run gcov coverage analysis"""
+        """Run gcov coverage analysis, one process per object on the worker pool"""
         coverage_data = {}
         
         try:
-            # Find .gcno files
-            gcno_files = list(self.project_root.glob("**/*.gcno"))
-            
-            for gcno_file in gcno_files:
-                # Run gcov
+            # Objects with coverage data; a .gcno without .gcda never ran
+            gcno_files = [f for f in self.project_root.glob("**/*.gcno") if f.with_suffix(".gcda").is_file()]
+            version = self._tool_version("gcov")
+            self._file_digests.clear()
+
+            def analyze(gcno_file: Path) -> Tuple[Path, Optional[Dict]]:
+                key = self.cache.key(self._digest_file(gcno_file),
+                                     self._digest_file(gcno_file.with_suffix(".gcda")), version)
+                cached = self.cache.get("gcov", key)
+                if cached is not None:
+                    return gcno_file, cached
+                # -n: report only, so parallel runs never write the same .gcov file
                 result = subprocess.run(
-                    ["gcov", str(gcno_file)],
-                    capture_output=True, text=True, timeout=60
+                    ["gcov", "-n", "-o", str(gcno_file.parent), str(gcno_file)],
+                    capture_output=True, text=True, timeout=60, cwd=gcno_file.parent
                 )
-                
-                if result.returncode == 0:
-                    # Parse gcov output
-                    coverage_data[str(gcno_file)] = self._parse_gcov_output(result.stdout)
+                if result.returncode != 0:
+                    return gcno_file, None
+                parsed = self._parse_gcov_output(result.stdout)
+                self.cache.put("gcov", key, parsed)
+                return gcno_file, parsed
+
+            with ThreadPoolExecutor(max_workers=self.jobs) as pool:
+                for gcno_file, parsed in pool.map(analyze, gcno_files):
+                    if parsed is not None:
+                        coverage_data[str(gcno_file)] = parsed
             
         except Exception as e:
             logger.error(f"gcov analysis failed: {e}")
@@ -586,26 +831,15 @@ sonar.cfamily.cache.path=.sonar/cache
         coverage_data = {}
         
         try:
-            with open(lcov_file, 'r') as f:
-                content = f.read()
-            
-            # Parse lcov format
-            lines = content.split('\n')
-            current_file = None
-            
-            for line in lines:
-                if line.startswith('SF:'):
-                    current_file = line[3:]
-                    coverage_data[current_file] = {}
-                elif line.startswith('LF:') and current_file:
-                    coverage_data[current_file]["lines_found"] = int(line[3:])
-                elif line.startswith('LH:') and current_file:
-                    coverage_data[current_file]["lines_hit"] = int(line[3:])
-        
+            coverage_data = parse_lcov_tracefile(lcov_file)
         except Exception as e:
             logger.error(f"Failed to parse lcov file: {e}")
         
         return coverage_data
+
+    def covered_files(self, lcov_file: Path, source_root: Optional[Path] = None) -> List[str]:
+        """Source files the lcov data shows as executed (see lcov_covered_files)"""
+        return lcov_covered_files(lcov_file, source_root or self.project_root)
     
     def _calculate_analysis_summary(self, results: Dict):
         """Calculate analysis summary statistics"""
@@ -758,10 +992,14 @@ def main():
                        help="Project root directory")
     parser.add_argument("--action", choices=["setup", "static-analysis", "coverage", "quality-gates", "full-report"],
                        required=True, help="Action to perform")
+    parser.add_argument("--jobs", "-j", type=int, default=None,
+                       help="Parallel tool processes (default: CPU count)")
+    parser.add_argument("--no-cache", action="store_true",
+                       help="Re-analyze every translation unit")
     
     args = parser.parse_args()
     
-    cqm = CodeQualityManager(args.project_root)
+    cqm = CodeQualityManager(args.project_root, jobs=args.jobs, use_cache=not args.no_cache)
     
     if args.action == "setup":
         cqm.setup_quality_config()
@@ -2,19 +2,33 @@
 """
 Database Schema Validation System
 Inspired by oms-dev patterns for robust database schema comparison and validation
+
+Each database is fingerprinted by PRAGMA schema_version plus a digest of its
+file (recomputed only when size or mtime change). Validation results and
+extracted schema information are cached by fingerprint under
+conan-dev/schema-cache, so unchanged databases are skipped, and databases
+whose sqlite_master entries are identical to the baseline's pass without
+running the diff tool. Test databases are validated in parallel.
 """
 
 import os
 import sys
 import json
+import hashlib
 import logging
 import subprocess
+from concurrent.futures import ThreadPoolExecutor
 from pathlib import Path
 from typing import Dict, List, Optional, Tuple
 from datetime import datetime
 import sqlite3
 import tempfile
 
+try:
+    from .quality_manager import AnalysisCache
+except ImportError:  # run as a script
+    from quality_manager import AnalysisCache
+
 # Configure logging
 logging.basicConfig(level=logging.INFO, format='%(asctime)s - %(levelname)s - %(message)s')
 logger = logging.getLogger(__name__)
@@ -22,11 +36,13 @@ logger = logging.getLogger(__name__)
 class DatabaseSchemaValidator:
     """Database schema validation system based on oms-dev patterns"""
     
-    def __init__(self, project_root: Path):
+    def __init__(self, project_root: Path, jobs: Optional[int] = None, use_cache: bool = True):
         self.project_root = project_root
         self.schema_config_path = project_root / "conan-dev" / "schema-config.yml"
         self.test_fixtures_dir = project_root / "test" / "fixtures" / "db"
         self.reports_dir = project_root / "conan-dev" / "schema-reports"
+        self.jobs = jobs or os.cpu_count() or 4
+        self.cache = AnalysisCache(project_root / "conan-dev" / "schema-cache", enabled=use_cache)
         
         # Create directories
         self.schema_config_path.parent.mkdir(parents=True, exist_ok=True)
@@ -115,9 +131,15 @@ class DatabaseSchemaValidator:
             test_databases = self._get_test_databases(config)
             validation_results["validation_summary"]["total_databases"] = len(test_databases)
             
-            # Validate each test database
-            for test_db in test_databases:
-                test_result = self._validate_single_database(baseline_db, test_db, config)
+            # Validate the test databases in parallel (results keep their order)
+            baseline_fingerprint = self._schema_fingerprint(baseline_db)
+            with ThreadPoolExecutor(max_workers=max(1, min(self.jobs, len(test_databases) or 1))) as pool:
+                test_results = list(pool.map(
+                    lambda test_db: self._validate_single_database(baseline_db, test_db, config,
+                                                                   baseline_fingerprint),
+                    test_databases))
+            
+            for test_db, test_result in zip(test_databases, test_results):
                 validation_results["test_databases"].append(test_result)
                 
                 if test_result["validation_passed"]:
@@ -136,6 +158,7 @@ class DatabaseSchemaValidator:
             self._check_ci_integration(validation_results, config)
             
             logger.info(f"✅ Schema validation complete: {validation_results['validation_summary']['passed_validation']}/{validation_results['validation_summary']['total_databases']} databases passed")
+            logger.info(f"📦 Schema cache: {sum(1 for r in test_results if r.get('cached'))} of {len(test_results)} databases unchanged")
             
         except Exception as e:
             logger.error(f"❌ Schema validation failed: {e}")
@@ -144,6 +167,10 @@ class DatabaseSchemaValidator:
     
     def compare_database_schemas(self, base_database: Path, candidate_database: Path, diff_tool: Path) -> List[str]:
         """Compare database schemas using diff tool - pattern from oms-dev"""
+        return self._run_schema_diff(base_database, candidate_database, diff_tool) or []
+    
+    def _run_schema_diff(self, base_database: Path, candidate_database: Path, diff_tool: Path) -> Optional[List[str]]:
+        """Schema differences reported by the diff tool, or None if it could not run"""
         differences = []
         
         try:
@@ -153,7 +180,7 @@ class DatabaseSchemaValidator:
             
             if result.returncode != 0:
                 logger.warning(f"Schema diff tool returned non-zero exit code: {result.returncode}")
-                return differences
+                return None
             
             # Parse and filter results
             filtered_result = list(filter(lambda line: len(line) > 0, result.stdout.split('\n')))
@@ -171,6 +198,7 @@ class DatabaseSchemaValidator:
             
         except Exception as e:
             logger.error(f"Failed to compare schemas: {e}")
+            return None
         
         return differences
     
@@ -234,8 +262,9 @@ class DatabaseSchemaValidator:
         
         return test_databases
     
-    def _validate_single_database(self, baseline_db: Path, test_db: Path, config: Dict) -> Dict:
-        """Validate a single database against baseline"""
+    def _validate_single_database(self, baseline_db: Path, test_db: Path, config: Dict,
+                                  baseline_fingerprint: Optional[Dict] = None) -> Dict:
+        """Validate a single database against baseline (skipped when neither changed)"""
         result = {
             "database": str(test_db),
             "validation_passed": True,
@@ -247,8 +276,25 @@ class DatabaseSchemaValidator:
             # Get diff tool
             diff_tool = self._get_diff_tool(config)
             
-            # Compare schemas
-            differences = self.compare_database_schemas(baseline_db, test_db, diff_tool)
+            baseline_fingerprint = baseline_fingerprint or self._schema_fingerprint(baseline_db)
+            test_fingerprint = self._schema_fingerprint(test_db)
+            key = AnalysisCache.key(baseline_fingerprint["fingerprint"], test_fingerprint["fingerprint"],
+                                    str(diff_tool), json.dumps(config["database_schema_validation"].get("validation_rules", {}),
+                                                               sort_keys=True))
+            differences = self.cache.get("validation", key)
+            if differences is not None:
+                result["cached"] = True
+            elif baseline_fingerprint["schema_digest"] == test_fingerprint["schema_digest"]:
+                # Identical sqlite_master entries: nothing for the diff tool to find
+                differences = []
+                self.cache.put("validation", key, differences)
+            else:
+                # Compare schemas
+                differences = self._run_schema_diff(baseline_db, test_db, diff_tool)
+                if differences is None:
+                    differences = []
+                else:
+                    self.cache.put("validation", key, differences)
             result["differences"] = differences
             
             if differences:
@@ -293,8 +339,62 @@ class DatabaseSchemaValidator:
             logger.error(f"Database integrity check failed: {e}")
             return False
     
+    def _schema_fingerprint(self, database_path: Path) -> Dict:
+        """
+        Fingerprint of a database: PRAGMA schema_version plus the file digest,
+        and a digest of its sqlite_master entries. Recomputed only when the
+        size or mtime of the file (or its WAL) change.
+        """
+        stamp = []
+        for path in (database_path, database_path.with_name(database_path.name + "-wal")):
+            if path.exists():
+                stat = path.stat()
+                stamp.extend([stat.st_size, stat.st_mtime_ns])
+        path_key = AnalysisCache.key(str(database_path.resolve()))
+        cached = self.cache.get("fingerprints", path_key)
+        if cached is not None and cached.get("stamp") == stamp:
+            return cached
+        
+        file_digest = hashlib.sha256()
+        with open(database_path, 'rb') as f:
+            for chunk in iter(lambda: f.read(1 << 20), b''):
+                file_digest.update(chunk)
+        
+        conn = sqlite3.connect(f"file:{database_path}?mode=ro", uri=True)
+        try:
+            schema_version = conn.execute("PRAGMA schema_version").fetchone()[0]
+            entries = conn.execute(
+                "SELECT type, name, tbl_name, sql FROM sqlite_master ORDER BY type, name").fetchall()
+        finally:
+            conn.close()
+        
+        fingerprint = {
+            "stamp": stamp,
+            "schema_version": schema_version,
+            "fingerprint": f"{schema_version}:{file_digest.hexdigest()}",
+            "schema_digest": hashlib.sha256(json.dumps(entries).encode()).hexdigest()
+        }
+        self.cache.put("fingerprints", path_key, fingerprint)
+        return fingerprint
+    
     def _extract_schema_info(self, database_path: Path) -> Dict:
-        """Extract schema information from database"""
+        """Extract schema information from database (cached by schema fingerprint)"""
+        try:
+            key = AnalysisCache.key(self._schema_fingerprint(database_path)["fingerprint"])
+        except (OSError, sqlite3.Error) as e:
+            logger.error(f"Failed to extract schema info: {e}")
+            key = None
+        cached = self.cache.get("schema-info", key) if key else None
+        if cached is not None:
+            return dict(cached, database_name=database_path.name)
+        
+        schema_info = self._read_schema_info(database_path)
+        if key:
+            self.cache.put("schema-info", key, schema_info)
+        return schema_info
+    
+    def _read_schema_info(self, database_path: Path) -> Dict:
+        """Read schema information from database"""
         schema_info = {
             "database_name": database_path.name,
             "tables": [],
@@ -307,41 +407,21 @@ class DatabaseSchemaValidator:
             conn = sqlite3.connect(str(database_path))
             cursor = conn.cursor()
             
-            # Get tables
-            cursor.execute("SELECT name FROM sqlite_master WHERE type='table'")
-            tables = cursor.fetchall()
-            
-            for table in tables:
-                table_name = table[0]
-                table_info = self._get_table_info(cursor, table_name)
-                schema_info["tables"].append(table_info)
-            
-            # Get indexes
-            cursor.execute("SELECT name FROM sqlite_master WHERE type='index'")
-            indexes = cursor.fetchall()
-            
-            for index in indexes:
-                index_name = index[0]
-                index_info = self._get_index_info(cursor, index_name)
-                schema_info["indexes"].append(index_info)
-            
-            # Get triggers
-            cursor.execute("SELECT name FROM sqlite_master WHERE type='trigger'")
-            triggers = cursor.fetchall()
-            
-            for trigger in triggers:
-                trigger_name = trigger[0]
-                trigger_info = self._get_trigger_info(cursor, trigger_name)
-                schema_info["triggers"].append(trigger_info)
-            
-            # Get views
-            cursor.execute("SELECT name FROM sqlite_master WHERE type='view'")
-            views = cursor.fetchall()
+            # One pass over sqlite_master for every object type
+            cursor.execute("SELECT type, name FROM sqlite_master WHERE type IN ('table', 'index', 'trigger', 'view')")
+            objects = cursor.fetchall()
+            readers = {
+                "table": ("tables", self._get_table_info),
+                "index": ("indexes", self._get_index_info),
+                "trigger": ("triggers", self._get_trigger_info),
+                "view": ("views", self._get_view_info),
+            }
             
-            for view in views:
-                view_name = view[0]
-                view_info = self._get_view_info(cursor, view_name)
-                schema_info["views"].append(view_info)
+            for object_type in ("table", "index", "trigger", "view"):
+                section, reader = readers[object_type]
+                for kind, name in objects:
+                    if kind == object_type:
+                        schema_info[section].append(reader(cursor, name))
             
             conn.close()
             
@@ -519,10 +599,14 @@ def main():
     parser.add_argument("--action", choices=["setup", "validate", "create-baseline", "generate-docs"],
                        required=True, help="Action to perform")
     parser.add_argument("--database", type=Path, help="Database path (for create-baseline and generate-docs)")
+    parser.add_argument("--jobs", "-j", type=int, default=None,
+                       help="Databases validated in parallel (default: CPU count)")
+    parser.add_argument("--no-cache", action="store_true",
+                       help="Ignore and do not update the schema cache")
     
     args = parser.parse_args()
     
-    dsv = DatabaseSchemaValidator(args.project_root)
+    dsv = DatabaseSchemaValidator(args.project_root, jobs=args.jobs, use_cache=not args.no_cache)
     
     if args.action == "setup":
         dsv.setup_schema_config()
@@ -2,15 +2,26 @@
 """
 Advanced Test Harness for OpenSSL Conan Package
 Based on ngapy-dev test_harness.py with enhanced verification methods
+
+run_parallel() runs independent command tests on a worker pool, each in
+its own temporary directory (cwd and TMPDIR). The JUnit XML and the JSON
+summary are rewritten atomically after every test, so the reports hold
+everything that has finished, even after the job is killed by a
+timeout.
 """
 
 import os
+import re
 import sys
 import time
 import json
 import logging
+import signal
 import subprocess
 import shutil
+import tempfile
+import threading
+from concurrent.futures import ThreadPoolExecutor
 from pathlib import Path
 from typing import Dict, List, Optional, Any, Callable, Union
 from dataclasses import dataclass, field
@@ -58,6 +69,21 @@ class TestSuite:
     skipped_tests: int = 0
     error_tests: int = 0
 
+@dataclass
+class CommandTest:
+    """One command for run_parallel; check(result) returns a failure message, or None when it passes"""
+    name: str
+    command: Union[str, List[str]]
+    expected_return_code: int = 0
+    description: str = ""
+    timeout: Optional[float] = None
+    env: Optional[Dict[str, str]] = None
+    cwd: Optional[Path] = None
+    check: Optional[Callable[[subprocess.CompletedProcess], Optional[str]]] = None
+
+# Output kept per test in the reports
+OUTPUT_TAIL = 4000
+
 class ThLogger:
     """Test harness logger - pattern from ngapy-dev"""
     
@@ -73,6 +99,7 @@ class ThLogger:
     def _initialize_log_files(self):
         """Initialize log files"""
         timestamp = datetime.now().strftime("%Y%m%d_%H%M%S")
+        self.timestamp = timestamp
         
         # Test log file
         test_log_path = self.results_dir / f"test_log_{timestamp}.txt"
@@ -126,6 +153,9 @@ class NgapyTestHarness:
         self.test_suites: List[TestSuite] = []
         self.current_suite: Optional[TestSuite] = None
         self.test_counter = 0
+        # Guards suites, the counter and the streamed reports (run_parallel)
+        self._lock = threading.RLock()
+        self.summary_path = self.results_dir / f"test_summary_{self.th_logger.timestamp}.json"
         
         # Verification methods
         self.verification_methods = {
@@ -257,13 +287,9 @@ class NgapyTestHarness:
                 metadata={"method": method_name, "args": args}
             )
             
-            # Add to current suite
-            if self.current_suite:
-                self.current_suite.test_cases.append(test_case)
-            
-            # Log result
+            # Add to current suite and log the result
             result_text = "PASS" if result else "FAIL"
-            self.th_logger.log_result(test_case.name, result_text, test_num)
+            self._add_case(test_case, test_num)
             self.th_logger.log_junit_result(test_case.name, result_text, msg, test_num)
             
             if not result and on_fail:
@@ -287,14 +313,98 @@ class NgapyTestHarness:
                 metadata={"method": method_name, "args": args}
             )
             
-            if self.current_suite:
-                self.current_suite.test_cases.append(test_case)
-            
-            self.th_logger.log_result(test_case.name, "ERROR", test_num)
+            self._add_case(test_case, test_num)
             logger.error(f"❌ {error_msg}")
             
             return False
     
+    def record(self, name: str, result: TestResult, duration: float = 0.0,
+               message: str = "", description: str = "") -> TestCase:
+        """Add an externally executed test (e.g. one OpenSSL make test recipe) to the current suite"""
+        with self._lock:
+            self.test_counter += 1
+            test_case = TestCase(name=name, description=description, result=result,
+                                 duration=duration, error_message=message)
+            self._add_case(test_case, self.test_counter)
+        return test_case
+    
+    def _add_case(self, test_case: TestCase, test_num: int, suite: Optional[TestSuite] = None):
+        """Append to a suite (default: the current one), log it and rewrite the streamed reports"""
+        with self._lock:
+            suite = suite or self.current_suite
+            if suite:
+                suite.test_cases.append(test_case)
+            self.th_logger.log_result(test_case.name, test_case.result.value, test_num)
+            self._write_junit(self.junit_path)
+            self._write_summary(self.summary_path)
+    
+    def run_parallel(self, tests: List[CommandTest], workers: Optional[int] = None,
+                     timeout: float = 300) -> List[TestCase]:
+        """
+        Run independent command tests concurrently in the current suite.
+        Each gets a fresh temporary directory as cwd (unless it sets one)
+        and TMPDIR; the directory is kept when the test does not pass. A
+        test running longer than its timeout is killed with its process
+        group and reported as an error. Results are in the order of tests.
+        """
+        workers = max(1, min(workers or os.cpu_count() or 1, len(tests) or 1))
+        tmp_root = (self.results_dir / "tmp").resolve()
+        tmp_root.mkdir(parents=True, exist_ok=True)
+        suite = self.current_suite
+        with self._lock:
+            numbers = list(range(self.test_counter + 1, self.test_counter + 1 + len(tests)))
+            self.test_counter += len(tests)
+        logger.info(f"⚡ Running {len(tests)} tests on {workers} workers")
+        
+        def run_one(test: CommandTest, test_num: int) -> TestCase:
+            workdir = Path(tempfile.mkdtemp(prefix=re.sub(r"[^\w.-]", "_", test.name)[:64] + "-", dir=tmp_root))
+            env = dict(os.environ, **(test.env or {}))
+            env.update(TMPDIR=str(workdir), TMP=str(workdir), TEMP=str(workdir))
+            shell = isinstance(test.command, str)
+            start_time = time.time()
+            returncode, stdout, stderr, message = None, "", "", ""
+            try:
+                process = subprocess.Popen(test.command, shell=shell, cwd=test.cwd or workdir, env=env,
+                                           stdout=subprocess.PIPE, stderr=subprocess.PIPE, text=True,
+                                           start_new_session=os.name == "posix")
+                try:
+                    stdout, stderr = process.communicate(timeout=test.timeout or timeout)
+                    returncode = process.returncode
+                except subprocess.TimeoutExpired:
+                    if os.name == "posix":
+                        os.killpg(process.pid, signal.SIGKILL)
+                    else:
+                        process.kill()
+                    stdout, stderr = process.communicate()
+                    message = f"timed out after {test.timeout or timeout}s"
+            except OSError as e:
+                message = f"could not start: {e}"
+            
+            if returncode is None:
+                result = TestResult.ERROR
+            elif returncode != test.expected_return_code:
+                result = TestResult.FAIL
+                message = f"exit code {returncode}, expected {test.expected_return_code}"
+            else:
+                message = (test.check(subprocess.CompletedProcess(test.command, returncode, stdout, stderr))
+                           if test.check else None) or ""
+                result = TestResult.FAIL if message else TestResult.PASS
+            
+            metadata = {"command": test.command, "stdout": stdout[-OUTPUT_TAIL:], "stderr": stderr[-OUTPUT_TAIL:]}
+            if result == TestResult.PASS:
+                shutil.rmtree(workdir, ignore_errors=True)
+            else:
+                metadata["workdir"] = str(workdir)
+            test_case = TestCase(name=test.name, description=test.description,
+                                 expected_result=test.expected_return_code, actual_result=returncode,
+                                 result=result, duration=time.time() - start_time,
+                                 error_message=message, metadata=metadata)
+            self._add_case(test_case, test_num, suite)
+            return test_case
+        
+        with ThreadPoolExecutor(max_workers=workers) as pool:
+            return list(pool.map(run_one, tests, numbers))
+    
     def _verify_equal(self, actual: Any, expected: Any) -> bool:
         """Verify actual equals expected"""
         return actual == expected
@@ -345,23 +455,44 @@ class NgapyTestHarness:
         except Exception:
             return False
     
-    def generate_junit_xml(self) -> Path:
-        """Generate JUnit XML report"""
-        timestamp = datetime.now().strftime("%Y%m%d_%H%M%S")
-        xml_path = self.results_dir / f"junit_report_{timestamp}.xml"
-        
+    @property
+    def junit_path(self) -> Path:
+        """The run's JUnit file, rewritten after every test and by generate_junit_xml"""
+        return Path(self.th_logger.junit_xml_log.name)
+    
+    @staticmethod
+    def _suite_counts(suite: TestSuite) -> Dict[str, Any]:
+        """Counts from the test cases, so suites still running report correctly"""
+        results = [case.result for case in suite.test_cases]
+        end_time = suite.end_time or time.time()
+        return {"total_tests": len(results),
+                "passed_tests": results.count(TestResult.PASS),
+                "failed_tests": results.count(TestResult.FAIL),
+                "skipped_tests": results.count(TestResult.SKIP),
+                "error_tests": results.count(TestResult.ERROR),
+                "duration": end_time - suite.start_time}
+    
+    @staticmethod
+    def _replace_file(path: Path, write: Callable[[Path], None]):
+        """Write to a temporary file next to path, then rename it over path"""
+        tmp = path.with_name(f".{path.name}.{threading.get_ident()}.tmp")
+        write(tmp)
+        os.replace(tmp, path)
+    
+    def _write_junit(self, xml_path: Path):
         # Create root element
         root = ET.Element("testsuites")
         
         for suite in self.test_suites:
+            counts = self._suite_counts(suite)
             # Create testsuite element
             suite_elem = ET.SubElement(root, "testsuite")
             suite_elem.set("name", suite.name)
-            suite_elem.set("tests", str(suite.total_tests))
-            suite_elem.set("failures", str(suite.failed_tests))
-            suite_elem.set("errors", str(suite.error_tests))
-            suite_elem.set("skipped", str(suite.skipped_tests))
-            suite_elem.set("time", str(suite.end_time - suite.start_time))
+            suite_elem.set("tests", str(counts["total_tests"]))
+            suite_elem.set("failures", str(counts["failed_tests"]))
+            suite_elem.set("errors", str(counts["error_tests"]))
+            suite_elem.set("skipped", str(counts["skipped_tests"]))
+            suite_elem.set("time", str(counts["duration"]))
             
             for test_case in suite.test_cases:
                 # Create testcase element
@@ -378,48 +509,50 @@ class NgapyTestHarness:
                 elif test_case.result == TestResult.SKIP:
                     skip_elem = ET.SubElement(case_elem, "skipped")
                     skip_elem.set("message", "Test skipped")
+                if test_case.metadata.get("stdout"):
+                    ET.SubElement(case_elem, "system-out").text = test_case.metadata["stdout"]
+                if test_case.metadata.get("stderr"):
+                    ET.SubElement(case_elem, "system-err").text = test_case.metadata["stderr"]
         
         # Write XML file
         tree = ET.ElementTree(root)
-        tree.write(xml_path, encoding="utf-8", xml_declaration=True)
-        
-        logger.info(f"📊 JUnit XML report generated: {xml_path}")
-        return xml_path
+        self._replace_file(xml_path, lambda tmp: tree.write(tmp, encoding="utf-8", xml_declaration=True))
     
-    def generate_summary_report(self) -> Path:
-        """Generate summary report"""
-        timestamp = datetime.now().strftime("%Y%m%d_%H%M%S")
-        report_path = self.results_dir / f"test_summary_{timestamp}.json"
+    def generate_junit_xml(self) -> Path:
+        """Generate JUnit XML report"""
+        with self._lock:
+            self._write_junit(self.junit_path)
         
+        logger.info(f"📊 JUnit XML report generated: {self.junit_path}")
+        return self.junit_path
+    
+    def _write_summary(self, report_path: Path):
+        suites = [dict({"name": suite.name, "description": suite.description}, **self._suite_counts(suite))
+                  for suite in self.test_suites]
         summary = {
             "timestamp": datetime.now().isoformat(),
+            "complete": self.current_suite is None,
             "total_suites": len(self.test_suites),
-            "total_tests": sum(suite.total_tests for suite in self.test_suites),
-            "total_passed": sum(suite.passed_tests for suite in self.test_suites),
-            "total_failed": sum(suite.failed_tests for suite in self.test_suites),
-            "total_skipped": sum(suite.skipped_tests for suite in self.test_suites),
-            "total_errors": sum(suite.error_tests for suite in self.test_suites),
-            "suites": []
+            "total_tests": sum(suite["total_tests"] for suite in suites),
+            "total_passed": sum(suite["passed_tests"] for suite in suites),
+            "total_failed": sum(suite["failed_tests"] for suite in suites),
+            "total_skipped": sum(suite["skipped_tests"] for suite in suites),
+            "total_errors": sum(suite["error_tests"] for suite in suites),
+            "suites": suites
         }
         
-        for suite in self.test_suites:
-            suite_summary = {
-                "name": suite.name,
-                "description": suite.description,
-                "total_tests": suite.total_tests,
-                "passed_tests": suite.passed_tests,
-                "failed_tests": suite.failed_tests,
-                "skipped_tests": suite.skipped_tests,
-                "error_tests": suite.error_tests,
-                "duration": suite.end_time - suite.start_time
-            }
-            summary["suites"].append(suite_summary)
-        
-        with open(report_path, 'w') as f:
-            json.dump(summary, f, indent=2)
+        def write(tmp: Path):
+            with open(tmp, 'w') as f:
+                json.dump(summary, f, indent=2)
+        self._replace_file(report_path, write)
+    
+    def generate_summary_report(self) -> Path:
+        """Generate summary report"""
+        with self._lock:
+            self._write_summary(self.summary_path)
         
-        logger.info(f"📊 Summary report generated: {report_path}")
-        return report_path
+        logger.info(f"📊 Summary report generated: {self.summary_path}")
+        return self.summary_path
     
     def cleanup(self):
         """Cleanup resources"""
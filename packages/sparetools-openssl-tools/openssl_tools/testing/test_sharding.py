@@ -0,0 +1,159 @@
+#!/usr/bin/env python3
+"""
+Balanced OpenSSL test suite shards
+
+`make test` runs 300+ test recipes in one job, so the test phase of a
+configuration takes the sum of them. Split into N shards (TESTS=
+selections) that run in parallel jobs against the same deferred test
+bundle (deferred_tests.py; built once, handed over as an artifact), it
+takes about as long as the slowest shard.
+
+Shards are balanced on historical per-recipe durations, taken from
+earlier runs' JUnit reports (openssl_test_runner.write_junit_report)
+or make-test.log files: the median per recipe, assigned longest first
+to the least loaded shard (LPT). Recipes without history cost the median
+of those with.
+
+The suite is not enumerated here, so recipes new since the history was
+recorded would be in no shard. The least loaded shard therefore selects
+by exclusion: `-test_a -test_b ...` for every recipe assigned elsewhere,
+which test/run_tests.pl reads as "all recipes but these". Every recipe
+runs exactly once, whatever the history covers.
+"""
+
+import json
+import statistics
+import xml.etree.ElementTree as ET
+from dataclasses import asdict, dataclass, field
+from pathlib import Path
+from typing import Dict, Iterable, List, Optional
+
+try:
+    from .openssl_test_runner import parse_make_test_output, recipe_name
+except ImportError:
+    from openssl_test_runner import parse_make_test_output, recipe_name
+
+# Assumed duration (seconds) of every recipe when there is no history at all
+DEFAULT_RECIPE_SECONDS = 1.0
+
+
+@dataclass
+class TestShard:
+    """One shard's TESTS= selection"""
+    index: int
+    count: int
+    tests: List[str] = field(default_factory=list)
+    # Set on the remainder shard: everything except these
+    exclude: Optional[List[str]] = None
+    expected_seconds: float = 0.0
+
+    @property
+    def selection(self) -> List[str]:
+        """run_tests.pl arguments (deferred_tests.run_bundle tests, TESTS= words)"""
+        if self.exclude is not None:
+            return [f"-{name}" for name in self.exclude]
+        return list(self.tests)
+
+    @property
+    def tests_arg(self) -> str:
+        """The selection as one TESTS= value"""
+        return " ".join(self.selection)
+
+    def to_dict(self) -> Dict:
+        return dict(asdict(self), tests_arg=self.tests_arg)
+
+
+def _junit_durations(path: Path) -> Dict[str, float]:
+    durations = {}
+    try:
+        root = ET.parse(path).getroot()
+    except (OSError, ET.ParseError):
+        return durations
+    for case in root.iter("testcase"):
+        name, time = case.get("name"), case.get("time")
+        if name and "test_" in name and time:
+            try:
+                durations[recipe_name(name)] = float(time)
+            except ValueError:
+                continue
+    return durations
+
+
+def _log_durations(path: Path) -> Dict[str, float]:
+    try:
+        results = parse_make_test_output(path.read_text(errors="replace"))
+    except OSError:
+        return {}
+    return {recipe_name(r["name"]): r["duration"] for r in results if r.get("duration")}
+
+
+def load_recipe_durations(paths: Iterable[Path]) -> Dict[str, float]:
+    """
+    Median seconds per recipe (TESTS= name) over JUnit XML reports and
+    make-test.log files; directories are searched recursively. Skipped
+    recipes (no duration) are left out.
+    """
+    samples: Dict[str, List[float]] = {}
+    for path in (Path(p) for p in paths):
+        files = [path] if path.is_file() else sorted(path.rglob("*.xml")) + sorted(path.rglob("make-test.log"))
+        for file in files:
+            found = _log_durations(file) if file.suffix == ".log" else _junit_durations(file)
+            for name, seconds in found.items():
+                if seconds > 0:
+                    samples.setdefault(name, []).append(seconds)
+    return {name: statistics.median(values) for name, values in samples.items()}
+
+
+def shard_tests(durations: Dict[str, float], shards: int,
+                recipes: Optional[Iterable[str]] = None) -> List[TestShard]:
+    """
+    Split the recipes (default: those with history) into `shards` balanced
+    shards. The least loaded one selects by exclusion (see the module
+    docstring). One shard, or no recipes at all, means the whole suite.
+    """
+    if shards < 1:
+        raise ValueError("shards must be at least 1")
+    names = sorted(set(recipes) if recipes is not None else set(durations))
+    # An empty shard would select the whole suite
+    shards = min(shards, len(names))
+    if shards <= 1:
+        return [TestShard(0, 1, exclude=[], expected_seconds=sum(durations.values()))]
+
+    fallback = statistics.median(durations.values()) if durations else DEFAULT_RECIPE_SECONDS
+    cost = {name: durations.get(name, fallback) for name in names}
+    result = [TestShard(i, shards) for i in range(shards)]
+    # Longest first, ties by name so the same history gives the same shards
+    for name in sorted(names, key=lambda n: (-cost[n], n)):
+        target = min(result, key=lambda s: (s.expected_seconds, s.index))
+        target.tests.append(name)
+        target.expected_seconds += cost[name]
+
+    remainder = min(result, key=lambda s: (s.expected_seconds, s.index))
+    remainder.exclude = sorted(n for s in result if s is not remainder for n in s.tests)
+    for shard in result:
+        shard.tests.sort()
+    return result
+
+
+def main(argv: Optional[List[str]] = None) -> int:
+    import argparse
+
+    parser = argparse.ArgumentParser(description="Split the OpenSSL test suite into balanced TESTS= shards")
+    parser.add_argument("history", type=Path, nargs="+",
+                        help="JUnit reports, make-test.log files or directories of earlier runs")
+    parser.add_argument("--shards", type=int, required=True, help="Number of shards")
+    parser.add_argument("--index", type=int, help="Print only this shard's TESTS= value")
+    args = parser.parse_args(argv)
+
+    shards = shard_tests(load_recipe_durations(args.history), args.shards)
+    if args.index is not None:
+        if not 0 <= args.index < len(shards):
+            parser.error(f"--index must be between 0 and {len(shards) - 1}")
+        print(shards[args.index].tests_arg)
+        return 0
+    print(json.dumps([s.to_dict() for s in shards], indent=2))
+    return 0
+
+
+if __name__ == "__main__":
+    raise SystemExit(main())
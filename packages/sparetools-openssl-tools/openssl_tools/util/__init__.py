@@ -3,7 +3,13 @@ OpenSSL Tools Utilities Module
 Utility functions for OpenSSL development tools
 """
 
-from .execute_command import execute_command, execute_command_with_output
+from .execute_command import (
+    execute_command,
+    execute_command_with_output,
+    execute_command_async,
+    run_commands_async,
+    run_commands
+)
 from .copy_tools import ensure_target_exists, get_file_metadata, copy_file, copy_folder, remove_directory_tree
 from .file_operations import (
     find_first_existing_file, 
@@ -18,10 +24,14 @@ from .conan_python_env import (
     get_conan_python_interpreter,
     validate_conan_python_environment
 )
+from .python_env_cache import PythonEnvCache, environment_key
 
 __all__ = [
     'execute_command',
     'execute_command_with_output',
+    'execute_command_async',
+    'run_commands_async',
+    'run_commands',
     'ensure_target_exists',
     'get_file_metadata',
     'copy_file',
@@ -34,5 +44,7 @@ __all__ = [
     'ConanPythonEnvironment',
     'setup_conan_python_environment',
     'get_conan_python_interpreter',
-    'validate_conan_python_environment'
+    'validate_conan_python_environment',
+    'PythonEnvCache',
+    'environment_key'
 ]
\ No newline at end of file
@@ -11,6 +11,12 @@ import logging
 from pathlib import Path
 from typing import Dict, List, Optional, Tuple
 
+try:
+    from .python_env_cache import LockFileError, PythonEnvCache, find_requirements_lock
+except ImportError:
+    # util imported as a top-level package (automation/conan_launcher.py)
+    from python_env_cache import LockFileError, PythonEnvCache, find_requirements_lock
+
 logger = logging.getLogger(__name__)
 
 
@@ -58,6 +64,31 @@ class ConanPythonEnvironment:
         
         return env
     
+    def setup_minimal_environment(self, force: bool = False) -> bool:
+        """<project>/venv from requirements.lock, linked from the environment cache"""
+        return self._materialize_lock("requirements.lock", force, required=True)
+
+    def setup_development_tools(self, force: bool = False) -> bool:
+        """<project>/venv from requirements-dev.lock (a superset of requirements.lock), if there is one"""
+        return self._materialize_lock("requirements-dev.lock", force, required=False)
+
+    def _materialize_lock(self, name: str, force: bool, required: bool) -> bool:
+        lock_file = find_requirements_lock(self.project_root, name)
+        if lock_file is None:
+            if required:
+                logger.error(f"Requirements lock not found: conan-dev/locks/{name} or {name}")
+            else:
+                logger.info(f"No {name}: keeping the environment as it is")
+            return not required
+        try:
+            result = PythonEnvCache().materialize(sys.executable, lock_file, self.project_root / "venv", force=force)
+        except (LockFileError, RuntimeError, OSError) as e:
+            logger.error(f"Python environment from {lock_file} failed: {e}")
+            return False
+        logger.info(f"Python environment {result.target} ({result.key}): "
+                    f"{'up to date' if result.up_to_date else 'cache hit' if result.cache_hit else 'built'}")
+        return True
+
     def get_python_interpreter(self) -> str:
         """Get the appropriate Python interpreter from Conan environment"""
         # Priority order:
@@ -10,6 +10,12 @@ import os
 import shutil
 from pathlib import Path
 
+try:
+    from ..fast_copy import copy_file as fast_copy_file, copy_tree
+except ImportError:
+    # util imported as a top-level package (automation/conan_launcher.py)
+    from fast_copy import copy_file as fast_copy_file, copy_tree
+
 log = logging.getLogger('__main__.' + __name__)
 
 
@@ -35,8 +41,7 @@ def get_file_metadata(filepath):
 def copy_file(source, destination):
     """Copy file with proper error handling"""
     try:
-        ensure_target_exists(destination)
-        shutil.copy2(source, destination)
+        fast_copy_file(source, destination)
         log.debug(f"Copied file: {source} -> {destination}")
     except Exception as e:
         log.error(f"Failed to copy file {source} to {destination}: {e}")
@@ -44,12 +49,16 @@ def copy_file(source, destination):
 
 
 def copy_folder(source, destination):
-    """Copy folder with proper error handling"""
+    """
+    Copy folder with proper error handling. The result matches a fresh
+    copy, but files already up to date in destination are left alone.
+    """
     try:
-        if os.path.exists(destination):
-            shutil.rmtree(destination)
-        shutil.copytree(source, destination)
-        log.debug(f"Copied folder: {source} -> {destination}")
+        if os.path.exists(destination) and not os.path.isdir(destination):
+            os.remove(destination)
+        stats = copy_tree(source, destination, delete=True, symlinks=False)
+        log.debug(f"Copied folder: {source} -> {destination} "
+                  f"({stats.copied} copied, {stats.skipped} unchanged, {stats.removed} removed)")
     except Exception as e:
         log.error(f"Failed to copy folder {source} to {destination}: {e}")
         raise
@@ -2,50 +2,288 @@
 """
 OpenSSL Tools Custom Logging Utilities
 Based on openssl-tools patterns for logging configuration
+
+With `queue: true` in config/1_logging.yaml (the default) the root logger
+only gets a QueueHandler: emitting a record costs formatting its message
+and one queue put, whatever the handlers behind it do. A
+BatchingQueueListener thread drains the queue in batches and hands each
+batch to the handlers, which write it with one write() and one flush():
+
+- console: echo rate-limited per logger (`rate_limit`, records per second
+  for the longest matching logger name prefix; warnings and errors are
+  never dropped, and the next echoed record says how many were)
+- file: plain text, rotated at max_bytes
+- json: one JSON object per line (timestamp, level, logger, message,
+  thread, location, exception and any `extra` fields)
 """
 
+import atexit
+import copy
+import json
 import logging
+import logging.handlers
 import os
+import queue
+import threading
+import time
 import yaml
 from pathlib import Path
 
+try:
+    from openssl_tools.config_snapshot import load_config
+except ImportError:  # util imported as a top-level package (automation/conan_launcher.py)
+    def load_config(path, default=None):
+        if not os.path.exists(path):
+            return default
+        with open(path, 'r') as f:
+            return yaml.safe_load(f) or default
+
 log = logging.getLogger('__main__.' + __name__)
 
+CONFIG_FILE = Path(__file__).resolve().parent.parent / 'config' / '1_logging.yaml'
+
+# LogRecord attributes; everything else on a record came in through extra=
+_RECORD_ATTRIBUTES = set(vars(logging.makeLogRecord({}))) | {'message', 'asctime'}
+
+_listener = None
+
+
+class JsonFormatter(logging.Formatter):
+    """One JSON object per record"""
+
+    def format(self, record):
+        entry = {
+            'timestamp': self.formatTime(record, '%Y-%m-%dT%H:%M:%S') + f'.{int(record.msecs):03d}',
+            'level': record.levelname,
+            'logger': record.name,
+            'message': record.getMessage(),
+            'thread': record.threadName,
+            'location': f'{record.pathname}:{record.lineno}',
+        }
+        if record.exc_info and not record.exc_text:
+            record.exc_text = self.formatException(record.exc_info)
+        if record.exc_text:
+            entry['exception'] = record.exc_text
+        for key, value in vars(record).items():
+            if key not in _RECORD_ATTRIBUTES and not key.startswith('_'):
+                entry[key] = value if isinstance(value, (str, int, float, bool, type(None))) else str(value)
+        return json.dumps(entry, ensure_ascii=False)
+
+
+class BatchWriteMixin:
+    """handle_batch(): format a batch of records and write it with one write() and one flush()"""
+
+    def admit(self, record):
+        """Record to write, or None to drop it"""
+        return record
+
+    def write_batch(self, text):
+        self.stream.write(text)
+
+    def handle_batch(self, records):
+        admitted = (self.admit(r) for r in records if r.levelno >= self.level and self.filter(r))
+        lines = [self.format(r) + self.terminator for r in admitted if r is not None]
+        if not lines:
+            return
+        self.acquire()
+        try:
+            self.write_batch(''.join(lines))
+            self.flush()
+        except Exception:
+            self.handleError(records[-1])
+        finally:
+            self.release()
+
+
+class RateLimitedConsoleHandler(BatchWriteMixin, logging.StreamHandler):
+    """
+    Console echo limited to a number of records per second per logger
+    name prefix (token bucket, burst of one second). 0 means unlimited.
+    """
+
+    def __init__(self, default_rate=0, module_rates=None, stream=None):
+        super().__init__(stream)
+        self.default_rate = default_rate
+        # Longest prefix first, so util.x.y beats util.x
+        self.module_rates = sorted((module_rates or {}).items(), key=lambda item: -len(item[0]))
+        self._buckets = {}
+        self._suppressed = {}
+
+    def _rule(self, name):
+        # Also matches after a leading package, e.g. util.x in __main__.util.x
+        dotted = f'.{name}.'
+        for prefix, rate in self.module_rates:
+            if f'.{prefix}.' in dotted:
+                return prefix, rate
+        return '', self.default_rate
+
+    def admit(self, record):
+        prefix, rate = self._rule(record.name)
+        if not rate or record.levelno >= logging.WARNING:
+            allowed = True
+        else:
+            now = time.monotonic()
+            tokens, last = self._buckets.get(prefix, (rate, now))
+            tokens = min(rate, tokens + (now - last) * rate)
+            allowed = tokens >= 1
+            self._buckets[prefix] = (tokens - 1 if allowed else tokens, now)
+        if not allowed:
+            self._suppressed[prefix] = self._suppressed.get(prefix, 0) + 1
+            return None
+        dropped = self._suppressed.pop(prefix, 0)
+        if dropped:
+            # The other handlers get the same record object
+            record = copy.copy(record)
+            record.msg = f'{record.getMessage()} [{dropped} console messages suppressed]'
+            record.args = None
+        return record
+
+    def emit(self, record):
+        record = self.admit(record)
+        if record is not None:
+            super().emit(record)
+
+
+class BatchingRotatingFileHandler(BatchWriteMixin, logging.handlers.RotatingFileHandler):
+    """RotatingFileHandler that takes batches (rollover is checked per record)"""
 
-def setup_logging_from_config():
-    """Setup logging from configuration files"""
+    def handle_batch(self, records):
+        records = [r for r in records if r.levelno >= self.level and self.filter(r)]
+        if not records:
+            return
+        self.acquire()
+        try:
+            if self.stream is None:
+                self.stream = self._open()
+            pending = []
+            for record in records:
+                line = self.format(record) + self.terminator
+                if self.maxBytes > 0 and self.stream.tell() + sum(map(len, pending)) + len(line) >= self.maxBytes:
+                    self.stream.write(''.join(pending))
+                    pending = []
+                    self.doRollover()
+                pending.append(line)
+            self.stream.write(''.join(pending))
+            self.flush()
+        except Exception:
+            self.handleError(records[-1])
+        finally:
+            self.release()
+
+
+class NonBlockingQueueHandler(logging.handlers.QueueHandler):
+    """
+    QueueHandler keeping exception text and extra fields for the JSON
+    handler; the stock prepare() folds the exception into the message.
+    """
+
+    def prepare(self, record):
+        record = copy.copy(record)
+        record.message = record.getMessage()
+        record.msg = record.message
+        record.args = None
+        if record.exc_info:
+            record.exc_text = logging.Formatter().formatException(record.exc_info)
+            record.exc_info = None
+        return record
+
+
+class BatchingQueueListener(logging.handlers.QueueListener):
+    """
+    QueueListener that takes up to batch_size records at a time, waiting at
+    most flush_interval seconds for a batch to fill, and passes the batch
+    to each handler's handle_batch() (one record at a time for handlers
+    without it).
+    """
+
+    def __init__(self, record_queue, *handlers, batch_size=256, flush_interval=0.2):
+        super().__init__(record_queue, *handlers, respect_handler_level=True)
+        self.batch_size = batch_size
+        self.flush_interval = flush_interval
+
+    def _dispatch(self, records):
+        for handler in self.handlers:
+            if hasattr(handler, 'handle_batch'):
+                handler.handle_batch(records)
+            else:
+                for record in records:
+                    if record.levelno >= handler.level:
+                        handler.handle(record)
+
+    def _monitor(self):
+        record_queue = self.queue
+        while True:
+            batch = []
+            stop = False
+            try:
+                record = record_queue.get(True)
+                deadline = time.monotonic() + self.flush_interval
+                while True:
+                    if record is self._sentinel:
+                        stop = True
+                        break
+                    batch.append(record)
+                    if len(batch) >= self.batch_size:
+                        break
+                    timeout = deadline - time.monotonic()
+                    record = record_queue.get(timeout > 0, max(timeout, 0))
+            except queue.Empty:
+                pass
+            if batch:
+                self._dispatch(batch)
+            if stop:
+                return
+
+
+def _handler_from_config(handler_config, logging_config):
+    kind = handler_config.get('type')
+    level = getattr(logging, str(handler_config.get('level', logging_config.get('level', 'INFO'))))
+    text_format = logging.Formatter(logging_config.get('format'))
+    if kind == 'console':
+        limits = handler_config.get('rate_limit') or {}
+        handler = RateLimitedConsoleHandler(limits.get('default', 0), limits.get('modules'))
+        handler.setFormatter(text_format)
+    elif kind in ('file', 'json'):
+        handler = BatchingRotatingFileHandler(handler_config['filename'],
+                                              maxBytes=handler_config.get('max_bytes', 0),
+                                              backupCount=handler_config.get('backup_count', 0),
+                                              encoding='utf-8', delay=True)
+        handler.setFormatter(JsonFormatter() if kind == 'json' else text_format)
+    else:
+        raise ValueError(f"Unknown logging handler type: {kind}")
+    handler.setLevel(level)
+    return handler
+
+
+def setup_logging_from_config(config_file=None):
+    """Setup logging from configuration files; returns the queue listener when queued"""
+    global _listener
     try:
         # Try to load configuration
-        config_loader = get_config_loader()
-        logging_config = config_loader.logging
-        
-        # Setup logging based on configuration
-        handlers = []
-        
-        # Console handler
-        console_handler = logging.StreamHandler()
-        console_handler.setLevel(getattr(logging, logging_config.level))
-        console_formatter = logging.Formatter(logging_config.format)
-        console_handler.setFormatter(console_formatter)
-        handlers.append(console_handler)
-        
-        # File handler
-        for handler_config in logging_config.handlers:
-            if handler_config.type == 'file':
-                file_handler = logging.FileHandler(handler_config.filename)
-                file_handler.setLevel(getattr(logging, logging_config.level))
-                file_formatter = logging.Formatter(logging_config.format)
-                file_handler.setFormatter(file_formatter)
-                handlers.append(file_handler)
-        
-        # Configure root logger
-        logging.basicConfig(
-            level=getattr(logging, logging_config.level),
-            handlers=handlers
-        )
-        
+        logging_config = get_config_loader(config_file).logging
+        handlers = [_handler_from_config(h, logging_config) for h in logging_config.get('handlers', [])]
+        level = getattr(logging, logging_config.get('level', 'INFO'))
+
+        stop_queue_logging()
+        root = logging.getLogger()
+        for handler in list(root.handlers):
+            root.removeHandler(handler)
+        root.setLevel(level)
+
+        if logging_config.get('queue', True):
+            record_queue = queue.SimpleQueue()
+            root.addHandler(NonBlockingQueueHandler(record_queue))
+            _listener = BatchingQueueListener(record_queue, *handlers,
+                                              batch_size=logging_config.get('batch_size', 256),
+                                              flush_interval=logging_config.get('flush_interval', 0.2))
+            _listener.start()
+        else:
+            for handler in handlers:
+                root.addHandler(handler)
+
         log.info("Logging configured successfully")
-        
+        return _listener
+
     except Exception as e:
         # Fallback to basic logging
         logging.basicConfig(
@@ -53,21 +291,33 @@ def setup_logging_from_config():
             format='%(asctime)s - %(name)s - %(levelname)s - %(message)s'
         )
         log.warning(f"Failed to load logging configuration, using defaults: {e}")
+        return None
+
 
+@atexit.register
+def stop_queue_logging():
+    """Flush what is queued and stop the listener thread"""
+    global _listener
+    if _listener is not None:
+        listener, _listener = _listener, None
+        if threading.current_thread() is not listener._thread:
+            listener.stop()
 
-def get_config_loader():
-    """Get configuration loader - simplified version"""
-    # This is a simplified version - in a real implementation,
-    # this would load from YAML configuration files
+
+def get_config_loader(config_file=None):
+    """Configuration loader for config/1_logging.yaml, with the same defaults when it is missing"""
     class SimpleConfig:
         def __init__(self):
-            self.logging = type('LoggingConfig', (), {
+            self.logging = {
                 'level': 'INFO',
                 'format': '%(asctime)s - %(name)s - %(levelname)s - %(message)s',
+                'queue': True,
                 'handlers': [
-                    type('HandlerConfig', (), {'type': 'console'}),
-                    type('HandlerConfig', (), {'type': 'file', 'filename': 'openssl_tools.log'})
+                    {'type': 'console'},
+                    {'type': 'file', 'filename': 'openssl_tools.log'},
                 ]
-            })()
-    
-    return SimpleConfig()
\ No newline at end of file
+            }
+            path = Path(config_file) if config_file else CONFIG_FILE
+            self.logging.update(load_config(path, {}).get('logging', {}))
+
+    return SimpleConfig()
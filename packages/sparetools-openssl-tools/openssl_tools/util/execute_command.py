@@ -9,6 +9,17 @@ import subprocess
 import sys
 from pathlib import Path
 
+# Streaming asyncio variants: many concurrent commands on one event loop
+try:
+    from ..async_command import (
+        CommandResult, execute_command_async, log_lines, run_commands, run_commands_async
+    )
+except ImportError:
+    # util imported as a top-level package (automation/conan_launcher.py)
+    from async_command import (
+        CommandResult, execute_command_async, log_lines, run_commands, run_commands_async
+    )
+
 log = logging.getLogger('__main__.' + __name__)
 
 
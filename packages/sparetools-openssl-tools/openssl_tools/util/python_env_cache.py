@@ -0,0 +1,393 @@
+#!/usr/bin/env python3
+"""
+Content-addressed Python tool environments
+
+Tool environments are keyed by (interpreter digest, lock digest), where
+the interpreter digest covers the Python binary and its version, ABI and
+platform, and the lock digest covers the normalized, fully pinned
+requirements lock. Each key is installed once into
+<cache>/envs/<key>/ (cache: SPARETOOLS_PYENV_CACHE, default
+~/.cache/sparetools/pyenv) with uv when it is on PATH, otherwise with
+pip, from a local wheelhouse when one is given (or SPARETOOLS_WHEELHOUSE
+is set). A file lock per key
+makes concurrent jobs on one machine wait for the first build instead
+of repeating it.
+
+A new environment is `python -m venv --without-pip`, with the cached
+environment's files hard-linked in (copied across file systems). Only
+console scripts are written, because their shebangs name the
+environment. Linked files are shared with the cache: upgrade packages
+(which replaces files) rather than editing them in place. Removing a
+cache entry does not affect environments linked from it.
+
+    cache = PythonEnvCache(wheelhouse="wheels/")
+    result = cache.materialize(sys.executable, "requirements.lock", "conan-dev/venv")
+
+    python -m openssl_tools.util.python_env_cache create --lock requirements.lock --target venv
+"""
+
+import argparse
+import hashlib
+import json
+import logging
+import os
+import shutil
+import subprocess
+import sys
+import time
+from concurrent.futures import ThreadPoolExecutor
+from contextlib import contextmanager
+from dataclasses import dataclass
+from functools import lru_cache
+from pathlib import Path
+from typing import Iterable, List, Optional, Tuple, Union
+
+try:
+    from ..fast_copy import copy_file
+except ImportError:
+    # util imported as a top-level package (automation/conan_launcher.py)
+    from fast_copy import copy_file
+
+log = logging.getLogger('__main__.' + __name__)
+
+CACHE_ENV = 'SPARETOOLS_PYENV_CACHE'
+WHEELHOUSE_ENV = 'SPARETOOLS_WHEELHOUSE'
+CACHE_FORMAT = 1
+MARKER = '.sparetools-env.json'
+INSTALLERS = ('auto', 'uv', 'pip')
+
+PathLike = Union[str, Path]
+
+_PROBE = ("import json, sys, sysconfig; print(json.dumps([sys.executable, sys.version, "
+          "sys.implementation.cache_tag, sysconfig.get_platform(), getattr(sys, 'abiflags', '')]))")
+
+
+class LockFileError(ValueError):
+    """The requirements lock cannot identify an environment"""
+
+
+def default_cache_root() -> Path:
+    root = os.environ.get(CACHE_ENV)
+    return Path(root).expanduser() if root else Path.home() / '.cache' / 'sparetools' / 'pyenv'
+
+
+@lru_cache(maxsize=None)
+def _interpreter_digest(python: str, mtime_ns: int) -> str:
+    probe = subprocess.run([python, '-c', _PROBE], capture_output=True, text=True, check=True)
+    executable, *identity = json.loads(probe.stdout)
+    digest = hashlib.sha256(json.dumps(identity).encode())
+    # A venv interpreter is a link to its base: hash the binary it runs
+    with open(os.path.realpath(executable), 'rb') as f:
+        for chunk in iter(lambda: f.read(1 << 20), b''):
+            digest.update(chunk)
+    return digest.hexdigest()
+
+
+def interpreter_digest(python: PathLike) -> str:
+    """Digest of the interpreter binary, version, ABI and platform"""
+    python = shutil.which(str(python)) or str(python)
+    return _interpreter_digest(python, os.stat(python).st_mtime_ns)
+
+
+def read_lock(lock_file: PathLike) -> List[str]:
+    """
+    Normalized lock lines: continuations joined, comments dropped,
+    whitespace collapsed, sorted. Every requirement must be pinned
+    (== or a direct reference); editables and includes are refused.
+    """
+    text = Path(lock_file).read_text(encoding='utf-8').replace('\\\r\n', ' ').replace('\\\n', ' ')
+    lines = []
+    for raw in text.splitlines():
+        line = raw.split(' #', 1)[0].strip() if not raw.lstrip().startswith('#') else ''
+        if not line:
+            continue
+        line = ' '.join(line.split())
+        option = line.split('=', 1)[0].split(' ', 1)[0]
+        if option in ('-e', '--editable', '-r', '--requirement', '-c', '--constraint'):
+            raise LockFileError(f'{lock_file}: {option} is not allowed in a lock: {line}')
+        if not line.startswith('-') and '==' not in line and ' @ ' not in line:
+            raise LockFileError(f'{lock_file}: requirement is not pinned: {line}')
+        lines.append(line)
+    return sorted(lines)
+
+
+def lock_digest(lock_file: PathLike) -> str:
+    return hashlib.sha256('\n'.join(read_lock(lock_file)).encode()).hexdigest()
+
+
+def environment_key(python: PathLike, lock_file: PathLike) -> str:
+    payload = f'{CACHE_FORMAT}\n{interpreter_digest(python)}\n{lock_digest(lock_file)}'
+    return hashlib.sha256(payload.encode()).hexdigest()[:32]
+
+
+def find_requirements_lock(project_root: PathLike, name: str = 'requirements.lock') -> Optional[Path]:
+    """<project>/conan-dev/locks/<name>, else <project>/<name>"""
+    for candidate in (Path(project_root) / 'conan-dev' / 'locks' / name, Path(project_root) / name):
+        if candidate.is_file():
+            return candidate
+    return None
+
+
+def venv_bin(env: Path) -> Path:
+    return env / ('Scripts' if os.name == 'nt' else 'bin')
+
+
+def venv_python(env: Path) -> Path:
+    return venv_bin(env) / ('python.exe' if os.name == 'nt' else 'python')
+
+
+@contextmanager
+def _file_lock(path: Path):
+    """Exclusive lock between processes (and threads: one open file each)"""
+    path.parent.mkdir(parents=True, exist_ok=True)
+    with open(path, 'a+b') as f:
+        if os.name == 'nt':
+            import msvcrt
+            while True:
+                try:
+                    msvcrt.locking(f.fileno(), msvcrt.LK_LOCK, 1)
+                    break
+                except OSError:
+                    time.sleep(0.1)
+        else:
+            import fcntl
+            fcntl.flock(f.fileno(), fcntl.LOCK_EX)
+        try:
+            yield
+        finally:
+            if os.name == 'nt':
+                f.seek(0)
+                msvcrt.locking(f.fileno(), msvcrt.LK_UNLCK, 1)
+            else:
+                fcntl.flock(f.fileno(), fcntl.LOCK_UN)
+
+
+def _run(command: List[str]):
+    log.info(f'Executing command: {" ".join(command)}')
+    result = subprocess.run(command, capture_output=True, text=True)
+    if result.returncode != 0:
+        raise RuntimeError(f'{command[0]} failed (exit code {result.returncode}): '
+                           f'{(result.stderr or result.stdout).strip()[-2000:]}')
+
+
+@dataclass
+class EnvResult:
+    """What materialize() did"""
+    target: Path
+    key: str
+    cache_hit: bool = False     # the cache already had the environment
+    up_to_date: bool = False    # target already was this environment
+    installer: Optional[str] = None
+    build_seconds: float = 0.0
+    link_seconds: float = 0.0
+    linked: int = 0
+    copied: int = 0
+    rewritten: int = 0
+
+    @property
+    def python(self) -> Path:
+        return venv_python(self.target)
+
+
+class PythonEnvCache:
+    """Tool environments built once per (interpreter, lock) and linked into place"""
+
+    def __init__(self, root: Optional[PathLike] = None, wheelhouse: Optional[PathLike] = None,
+                 installer: str = 'auto'):
+        if installer not in INSTALLERS:
+            raise ValueError(f'Unknown installer {installer!r} (expected one of {INSTALLERS})')
+        self.root = Path(root) if root else default_cache_root()
+        wheelhouse = wheelhouse or os.environ.get(WHEELHOUSE_ENV)
+        self.wheelhouse = Path(wheelhouse) if wheelhouse else None
+        self.installer = installer
+
+    def path(self, key: str) -> Path:
+        return self.root / 'envs' / key
+
+    def _installer(self) -> Tuple[str, Optional[str]]:
+        uv = shutil.which('uv') if self.installer in ('auto', 'uv') else None
+        if self.installer == 'uv' and uv is None:
+            raise RuntimeError('installer=uv but uv is not on PATH')
+        return ('uv', uv) if uv else ('pip', None)
+
+    def _build(self, python: str, lock_file: Path, env: Path) -> str:
+        name, uv = self._installer()
+        sources = ['--no-index', '--find-links', str(self.wheelhouse)] if self.wheelhouse else []
+        if env.exists():
+            shutil.rmtree(env)  # an interrupted build
+        if uv:
+            _run([uv, 'venv', '--quiet', '--python', python, str(env)])
+            _run([uv, 'pip', 'install', '--quiet', '--python', str(venv_python(env)), '-r', str(lock_file)] + sources)
+        else:
+            _run([python, '-m', 'venv', str(env)])
+            _run([str(venv_python(env)), '-m', 'pip', 'install', '--quiet', '--disable-pip-version-check',
+                  '--no-input', '-r', str(lock_file)] + sources)
+        return name
+
+    def ensure(self, python: PathLike, lock_file: PathLike) -> Tuple[Path, bool, Optional[str], float]:
+        """
+        The cached environment for (python, lock_file), built if missing.
+        Returns (path, cache hit, installer used, build seconds).
+        """
+        python = shutil.which(str(python)) or str(python)
+        lock_file = Path(lock_file)
+        key = environment_key(python, lock_file)
+        env = self.path(key)
+        marker = env / MARKER
+        if marker.is_file():
+            return env, True, None, 0.0
+        with _file_lock(self.root / 'envs' / f'{key}.lock'):
+            if marker.is_file():  # built by another job while we waited
+                return env, True, None, 0.0
+            start = time.monotonic()
+            installer = self._build(python, lock_file, env)
+            marker.write_text(json.dumps({'key': key, 'format': CACHE_FORMAT, 'interpreter': python,
+                                          'lock': str(lock_file.resolve()), 'installer': installer,
+                                          'created': time.time()}, indent=2), encoding='utf-8')
+            seconds = time.monotonic() - start
+            log.info(f'Built Python environment {key} with {installer} in {seconds:.1f} s')
+            return env, False, installer, seconds
+
+    def materialize(self, python: PathLike, lock_file: PathLike, target: PathLike,
+                    force: bool = False) -> EnvResult:
+        """Make target a virtualenv with the locked packages, linked from the cache"""
+        env, hit, installer, build_seconds = self.ensure(python, lock_file)
+        key = env.name
+        target = Path(target)
+        result = EnvResult(target, key, hit, installer=installer, build_seconds=build_seconds)
+        try:
+            current = json.loads((target / MARKER).read_text(encoding='utf-8')).get('key')
+        except (OSError, ValueError):
+            current = None
+        if current == key and not force and venv_python(target).exists():
+            result.up_to_date = True
+            return result
+
+        start = time.monotonic()
+        if target.exists():
+            shutil.rmtree(target)
+        _run([str(venv_python(env)), '-m', 'venv', '--without-pip', str(target)])
+        skip = {MARKER, 'pyvenv.cfg', venv_bin(env).name}
+        for entry in os.scandir(env):
+            if entry.name in skip:
+                continue
+            if entry.is_dir(follow_symlinks=False):
+                self._link_tree(Path(entry.path), target / entry.name, result)
+            elif not os.path.lexists(target / entry.name):
+                self._link(Path(entry.path), target / entry.name, result)
+        self._relocate_scripts(env, target, result)
+        (target / MARKER).write_text(json.dumps({'key': key, 'source': str(env)}, indent=2), encoding='utf-8')
+        os.utime(env / MARKER)  # last use, for prune()
+        result.link_seconds = time.monotonic() - start
+        log.info(f'Linked Python environment {key} into {target} in {result.link_seconds * 1000:.0f} ms '
+                 f'({result.linked} linked, {result.copied} copied, {result.rewritten} scripts)')
+        return result
+
+    @staticmethod
+    def _link(source: Path, destination: Path, result: EnvResult):
+        try:
+            os.link(source, destination)
+            result.linked += 1
+        except OSError:
+            copy_file(source, destination)
+            result.copied += 1
+
+    def _link_tree(self, source: Path, destination: Path, result: EnvResult):
+        for directory, dirs, files in os.walk(source):
+            relative = Path(directory).relative_to(source)
+            target_dir = destination / relative
+            target_dir.mkdir(parents=True, exist_ok=True)
+            for name in dirs + files:
+                src, dst = Path(directory) / name, target_dir / name
+                if src.is_symlink():
+                    if not os.path.lexists(dst):
+                        os.symlink(os.readlink(src), dst)
+                    if name in dirs:
+                        dirs.remove(name)
+                elif name in files and not os.path.lexists(dst):
+                    self._link(src, dst, result)
+
+    @staticmethod
+    def _relocate_scripts(env: Path, target: Path, result: EnvResult):
+        """Console scripts name their environment: write them with target's paths"""
+        source_bin, target_bin = venv_bin(env), venv_bin(target)
+        old, new = str(env).encode(), str(target.resolve()).encode()
+        for entry in os.scandir(source_bin):
+            destination = target_bin / entry.name
+            if os.path.lexists(destination) or not entry.is_file(follow_symlinks=False):
+                continue
+            content = Path(entry.path).read_bytes()
+            if old in content:
+                destination.write_bytes(content.replace(old, new))
+                shutil.copymode(entry.path, destination)
+                result.rewritten += 1
+            else:
+                PythonEnvCache._link(Path(entry.path), destination, result)
+
+    def create_many(self, specs: Iterable[Tuple[PathLike, PathLike, PathLike]], jobs: Optional[int] = None,
+                    force: bool = False) -> List[EnvResult]:
+        """materialize() for (python, lock, target) triples concurrently; one build per key"""
+        specs = list(specs)
+        with ThreadPoolExecutor(max_workers=jobs or min(len(specs), os.cpu_count() or 1) or 1) as pool:
+            return list(pool.map(lambda spec: self.materialize(*spec, force=force), specs))
+
+    def prune(self, max_age_days: float = 30.0) -> int:
+        """Remove cached environments unused for max_age_days; returns how many"""
+        envs = self.root / 'envs'
+        if not envs.is_dir():
+            return 0
+        cutoff, removed = time.time() - max_age_days * 86400, 0
+        for entry in os.scandir(envs):
+            marker = Path(entry.path) / MARKER
+            if not entry.is_dir() or (marker.is_file() and marker.stat().st_mtime >= cutoff):
+                continue
+            with _file_lock(envs / f'{entry.name}.lock'):
+                shutil.rmtree(entry.path, ignore_errors=True)
+            (envs / f'{entry.name}.lock').unlink(missing_ok=True)
+            removed += 1
+        return removed
+
+
+def main(argv: Optional[List[str]] = None) -> int:
+    parser = argparse.ArgumentParser(description='Content-addressed Python tool environments')
+    parser.add_argument('--cache', type=Path, help=f'cache root (default: {CACHE_ENV} or ~/.cache/sparetools/pyenv)')
+    commands = parser.add_subparsers(dest='command', required=True)
+    create = commands.add_parser('create', help='create environments from the cache')
+    create.add_argument('--lock', type=Path, action='append', required=True,
+                        help='requirements lock (repeat with --target for several environments)')
+    create.add_argument('--target', type=Path, action='append', required=True)
+    create.add_argument('--python', default=sys.executable)
+    create.add_argument('--wheelhouse', type=Path, help='install from this directory only')
+    create.add_argument('--installer', choices=INSTALLERS, default='auto')
+    create.add_argument('--jobs', type=int)
+    create.add_argument('--force', action='store_true', help='relink targets that are up to date')
+    key = commands.add_parser('key', help='print the cache key')
+    key.add_argument('--lock', type=Path, required=True)
+    key.add_argument('--python', default=sys.executable)
+    prune = commands.add_parser('prune', help='remove environments not used recently')
+    prune.add_argument('--days', type=float, default=30.0)
+    args = parser.parse_args(argv)
+
+    logging.basicConfig(level=logging.INFO, format='%(levelname)s: %(message)s')
+    try:
+        if args.command == 'key':
+            print(environment_key(args.python, args.lock))
+        elif args.command == 'prune':
+            print(f'Removed {PythonEnvCache(args.cache).prune(args.days)} environments')
+        else:
+            if len(args.lock) != len(args.target):
+                parser.error('give one --lock per --target')
+            cache = PythonEnvCache(args.cache, args.wheelhouse, args.installer)
+            for result in cache.create_many([(args.python, lock, target) for lock, target
+                                             in zip(args.lock, args.target)], args.jobs, args.force):
+                state = 'up to date' if result.up_to_date else 'cache hit' if result.cache_hit else 'built'
+                print(f'{result.target}: {state} ({result.key}, build {result.build_seconds:.1f} s, '
+                      f'link {result.link_seconds * 1000:.0f} ms)')
+    except (LockFileError, RuntimeError, subprocess.CalledProcessError) as e:
+        log.error(str(e))
+        return 1
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -1,13 +1,26 @@
 from conan import ConanFile
-from conan.tools.files import copy, get, save, load, rm, rmdir
+from conan.errors import ConanException, ConanInvalidConfiguration
+from conan.tools.build import build_jobs, can_run, cross_building
+from conan.tools.files import copy, get, save, load, replace_in_file, rm, rmdir
 from conan.tools.gnu import Autotools, AutotoolsToolchain
 from conan.tools.cmake import CMake, CMakeToolchain, cmake_layout
 from conan.tools.layout import basic_layout
 from conan.tools.scm import Version
+from concurrent.futures import ThreadPoolExecutor
+from contextlib import contextmanager, nullcontext
+import filecmp
+import glob
+import hashlib
+import importlib.util
+import json
 import os
 import platform
+import re
+import shutil
 import subprocess
+import sys
 import textwrap
+import time
 
 
 class SpareToolsOpenSSLConan(ConanFile):
@@ -34,14 +47,48 @@ class SpareToolsOpenSSLConan(ConanFile):
         "fPIC": [True, False],
         "build_method": ["perl", "cmake", "autotools", "python"],
         "fips": [True, False],
+        "fips_install": ["off", "onload", "oninstall"],
         "enable_threads": [True, False],
         "enable_asm": [True, False],
         "enable_zlib": [True, False],
+        "enable_brotli": [True, False],
+        "enable_zstd": [True, False],
         "enable_legacy": [True, False],
+        "builtin_providers": [True, False],
         "enable_avx": [True, False],
         "enable_avx2": [True, False],
         "enable_neon": [True, False],
         "enable_sve": [True, False],
+        "enable_ktls": [True, False],
+        "enable_afalg": [True, False],
+        "qat_provider": ["off", "hw", "sw", "hw_sw"],
+        "enable_async": [True, False],
+        "enable_quic": [True, False],
+        "enable_thread_pool": [True, False],
+        "default_thread_pool": [True, False],
+        "pgo": ["off", "generate", "use"],
+        "lto": ["off", "thin", "full"],
+        "cpu_tuning": ["generic", "x86-64-v2", "x86-64-v3", "x86-64-v4", "neoverse-n1", "native"],
+        "bolt": [True, False],
+        "shared_symbol_binding": [True, False],
+        "hugepage_text": [True, False],
+        "gc_sections": [True, False],
+        "split_debug": [True, False],
+        "universal": [True, False],
+        "cpu_dispatch": ["default", "fat"],
+        "allocator": ["system", "jemalloc", "mimalloc", "tcmalloc"],
+        "mem_trace": [True, False],
+        "secure_heap": [None, "ANY"],
+        "lock_profiling": [True, False],
+        "usdt_probes": [True, False],
+        "compiler_cache": ["none", "ccache", "sccache", "recc"],
+        "run_tests": ["off", "fast", "full"],
+        "algorithm_manifest": [None, "ANY"],
+        "unity_build": [True, False],
+        "startup_config": ["default", "minimal"],
+        "fuzzing": ["off", "libfuzzer", "afl"],
+        "hardening": ["none", "full", "ANY"],
+        "libc": ["glibc", "musl"],
     }
 
     default_options = {
@@ -49,14 +96,48 @@ class SpareToolsOpenSSLConan(ConanFile):
         "fPIC": True,
         "build_method": "perl",
         "fips": False,
+        "fips_install": "off",
         "enable_threads": True,
         "enable_asm": True,
         "enable_zlib": True,
+        "enable_brotli": False,
+        "enable_zstd": False,
         "enable_legacy": False,
+        "builtin_providers": False,
         "enable_avx": True,
         "enable_avx2": True,
         "enable_neon": True,
         "enable_sve": False,
+        "enable_ktls": False,
+        "enable_afalg": False,
+        "qat_provider": "off",
+        "enable_async": True,
+        "enable_quic": True,
+        "enable_thread_pool": True,
+        "default_thread_pool": True,
+        "pgo": "off",
+        "lto": "off",
+        "cpu_tuning": "generic",
+        "bolt": False,
+        "shared_symbol_binding": False,
+        "hugepage_text": False,
+        "gc_sections": False,
+        "split_debug": False,
+        "universal": False,
+        "cpu_dispatch": "default",
+        "allocator": "system",
+        "mem_trace": False,
+        "secure_heap": None,
+        "lock_profiling": False,
+        "usdt_probes": False,
+        "compiler_cache": "none",
+        "run_tests": "off",
+        "algorithm_manifest": None,
+        "unity_build": False,
+        "startup_config": "default",
+        "fuzzing": "off",
+        "hardening": "none",
+        "libc": "glibc",
     }
     
     # Package dependencies
@@ -67,18 +148,387 @@ class SpareToolsOpenSSLConan(ConanFile):
     
     python_requires = "sparetools-base/2.0.0"
     
-    exports_sources = "configure.py"
+    # universal=True slices: lipo arch -> (Configure target, per-slice tuning).
+    # Every Mac running a supported macOS has AVX2; -mcpu=apple-m1 enables
+    # the ARMv8.5 crypto and SHA3 extensions for the C code
+    _universal_slices = {
+        "x86_64": ("darwin64-x86_64-cc", ["-march=x86-64-v3"]),
+        "arm64": ("darwin64-arm64-cc", ["-mcpu=apple-m1"]),
+    }
+    
+    # Allocator packages behind the CRYPTO_set_mem_functions shim
+    _allocator_requires = {
+        "jemalloc": "jemalloc/5.3.0",
+        "mimalloc": "mimalloc/2.1.7",
+        "tcmalloc": "gperftools/2.15",
+    }
+    
+    # enable_brotli / enable_zstd: compression libraries OpenSSL links for
+    # RFC 8879 certificate compression (3.2+), as Configure feature name,
+    # requirement and the component consumers link through
+    _compression_requires = {
+        "enable_brotli": ("brotli", "brotli/1.1.0", "brotli::brotli"),
+        "enable_zstd": ("zstd", "zstd/1.5.6", "zstd::zstd"),
+    }
+    
+    # usdt_probes: (min version, max version, source file, function, wrapper body).
+    # Bodies are format strings over {orig}, {args}, {ret_decl}, {p0} (first
+    # parameter) and parameter names; the record layer moved in 3.2.
+    _usdt_probes = [
+        ("3.0.0", None, "ssl/ssl_lib.c", "SSL_do_handshake", """\
+    int in_init = SSL_in_init({p0}), ret;
+
+    if (SSL_in_before({p0}))
+        SPARETOOLS_USDT(handshake_start, {p0}, SSL_is_server({p0}));
+    ret = {orig}({args});
+    if (in_init && ret == 1)
+        SPARETOOLS_USDT(handshake_done, {p0}, SSL_version({p0}));
+    return ret;
+"""),
+        ("3.0.0", "3.2.0", "ssl/record/ssl3_record.c", "tls1_enc", None),
+        ("3.0.0", "3.2.0", "ssl/record/ssl3_record_tls13.c", "tls13_enc", None),
+        ("3.2.0", None, "ssl/record/methods/tls1_meth.c", "tls1_cipher", None),
+        ("3.2.0", None, "ssl/record/methods/tls13_meth.c", "tls13_cipher", None),
+        ("3.0.0", None, "crypto/core_fetch.c", "ossl_method_construct", """\
+    {ret_decl};
+
+    SPARETOOLS_USDT(fetch_miss_start, {operation_id});
+    ret = {orig}({args});
+    SPARETOOLS_USDT(fetch_miss_done, {operation_id}, ret);
+    return ret;
+"""),
+        ("3.0.0", None, "crypto/provider_core.c", "provider_init", """\
+    int ret;
+
+    SPARETOOLS_USDT(provider_load_start, {prov}, {prov}->name);
+    ret = {orig}({args});
+    SPARETOOLS_USDT(provider_load_done, {prov}, {prov}->name, ret);
+    return ret;
+"""),
+    ]
+    _usdt_record_body = """\
+    int ret;
+
+    SPARETOOLS_USDT(record_start, {sending}, {n_recs});
+    ret = {orig}({args});
+    SPARETOOLS_USDT(record_done, {sending}, {n_recs}, ret);
+    return ret;
+"""
+    
+    exports_sources = "configure.py", "helpers/*", "patches/*", "bpftrace/*", "test_package/bench_*"
     
     def config_options(self):
         if self.settings.os == "Windows":
             del self.options.fPIC
+        # Kernel TLS offload exists on Linux and FreeBSD only
+        if self.settings.os not in ["Linux", "FreeBSD"]:
+            del self.options.enable_ktls
+        # The afalg engine talks to the Linux kernel crypto API (AF_ALG)
+        if self.settings.os != "Linux":
+            del self.options.enable_afalg
+            # Intel QAT drivers and the multi-buffer libraries are Linux only
+            del self.options.qat_provider
+        # musl instead of glibc, for a fully static openssl CLI
+        if self.settings.os != "Linux":
+            del self.options.libc
+        # x86_64 + arm64 slices lipo'd together
+        if self.settings.os != "Macos":
+            del self.options.universal
+        # QUIC arrived in 3.2 (client) and 3.5 (server)
+        if Version(self.version) < "3.2.0":
+            del self.options.enable_quic
+            # The internal thread pool (OSSL_set_max_threads, Argon2 lanes)
+            # arrived in 3.2 as well
+            del self.options.enable_thread_pool
+            del self.options.default_thread_pool
+            # So did brotli and zstd support (certificate compression)
+            del self.options.enable_brotli
+            del self.options.enable_zstd
     
     def configure(self):
         if self.options.shared:
             self.options.rm_safe("fPIC")
+        # fipsmodule.cnf only exists for packages with the FIPS provider
+        if not self.options.fips:
+            self.options.rm_safe("fips_install")
         # OpenSSL is pure C library
         self.settings.rm_safe("compiler.libcxx")
         self.settings.rm_safe("compiler.cppstd")
+        # Fat packages carry every SIMD code path and pick one at runtime
+        # from OPENSSL_ia32cap/OPENSSL_armcap
+        if self.options.cpu_dispatch == "fat":
+            self.options.enable_avx = True
+            self.options.enable_avx2 = True
+            self.options.enable_neon = True
+            self.options.enable_sve = True
+        # A thread pool needs threads
+        if not self.options.enable_threads:
+            if self.options.get_safe("enable_thread_pool") is not None:
+                self.options.enable_thread_pool = False
+            if self.options.get_safe("default_thread_pool") is not None:
+                self.options.default_thread_pool = False
+    
+    def build_requirements(self):
+        if self._windows_make == "jom":
+            self.tool_requires("jom/1.1.4")
+    
+    def requirements(self):
+        allocator = str(self.options.allocator)
+        if allocator != "system":
+            self.requires(self._allocator_requires[allocator])
+        for option, (_, ref, _) in self._compression_requires.items():
+            if self.options.get_safe(option):
+                self.requires(ref)
+    
+    def validate(self):
+        if self.options.pgo != "off" and not self._is_gcc_or_clang:
+            raise ConanInvalidConfiguration("pgo requires GCC or Clang")
+        if (self.options.lto != "off" or self.options.cpu_tuning != "generic") \
+                and not self._is_gcc_or_clang:
+            raise ConanInvalidConfiguration("lto and cpu_tuning require GCC or Clang")
+        if self.options.compiler_cache == "recc" and not self._is_gcc_or_clang:
+            raise ConanInvalidConfiguration("compiler_cache=recc requires GCC or Clang")
+        
+        tuning = str(self.options.cpu_tuning)
+        arch = str(self.settings.arch)
+        if tuning.startswith("x86-64-") and arch != "x86_64":
+            raise ConanInvalidConfiguration(f"cpu_tuning={tuning} requires arch=x86_64")
+        if tuning == "neoverse-n1" and arch not in ["armv8", "arm64ec"]:
+            raise ConanInvalidConfiguration(f"cpu_tuning={tuning} requires arch=armv8")
+        
+        if self.options.cpu_dispatch == "fat":
+            if not self.options.enable_asm:
+                raise ConanInvalidConfiguration("cpu_dispatch=fat requires enable_asm=True")
+            if self.options.cpu_tuning != "generic":
+                raise ConanInvalidConfiguration(
+                    "cpu_dispatch=fat requires cpu_tuning=generic (-march would drop older CPUs)")
+        
+        if self.options.allocator == "tcmalloc" and self.settings.os == "Windows":
+            raise ConanInvalidConfiguration("allocator=tcmalloc is not available on Windows")
+        
+        if self.options.bolt:
+            if not self.options.shared:
+                raise ConanInvalidConfiguration("bolt requires shared=True (it rewrites libcrypto.so/libssl.so)")
+            if self.settings.os != "Linux" or not self._is_gcc_or_clang:
+                raise ConanInvalidConfiguration("bolt requires Linux with GCC or Clang")
+        
+        if self.options.shared_symbol_binding:
+            if not self.options.shared:
+                raise ConanInvalidConfiguration("shared_symbol_binding requires shared=True")
+            if self.settings.os in ["Windows", "Macos"] or not self._is_gcc_or_clang:
+                raise ConanInvalidConfiguration(
+                    "shared_symbol_binding requires an ELF platform with GCC or Clang (-Bsymbolic-functions)")
+        
+        if self.options.hugepage_text and (self.settings.os != "Linux" or not self._is_gcc_or_clang):
+            raise ConanInvalidConfiguration("hugepage_text requires Linux with GCC or Clang")
+        
+        if self.options.gc_sections:
+            if self.options.shared:
+                raise ConanInvalidConfiguration(
+                    "gc_sections requires shared=False (consumers strip the static libraries at link time)")
+            if not self._is_gcc_or_clang:
+                raise ConanInvalidConfiguration("gc_sections requires GCC or Clang")
+        
+        if self.options.split_debug and (self.settings.os != "Linux" or not self._is_gcc_or_clang):
+            raise ConanInvalidConfiguration("split_debug requires Linux with GCC or Clang (ELF, objcopy)")
+        
+        if self.options.get_safe("universal"):
+            if self.options.build_method != "perl":
+                raise ConanInvalidConfiguration("universal requires build_method=perl")
+            if self.options.pgo != "off" or self.options.cpu_tuning != "generic":
+                raise ConanInvalidConfiguration(
+                    "universal tunes each slice itself and requires pgo=off and cpu_tuning=generic")
+        
+        if self.options.unity_build and self.options.build_method not in ["python", "cmake"]:
+            raise ConanInvalidConfiguration("unity_build requires build_method=python or cmake")
+        
+        if self.options.lock_profiling:
+            if self.settings.os != "Linux" or not self._is_gcc_or_clang:
+                raise ConanInvalidConfiguration("lock_profiling requires Linux with GCC or Clang")
+            if not self.options.enable_threads:
+                raise ConanInvalidConfiguration("lock_profiling requires enable_threads=True")
+        
+        self._validate_hardening()
+        
+        if self.options.usdt_probes and (self.settings.os != "Linux" or not self._is_gcc_or_clang):
+            raise ConanInvalidConfiguration("usdt_probes requires Linux with GCC or Clang (<sys/sdt.h>)")
+        
+        # no-module also disables the FIPS provider: the validated module is
+        # only ever a separately loaded fips.so
+        if self.options.builtin_providers and self.options.fips:
+            raise ConanInvalidConfiguration(
+                "builtin_providers cannot be combined with fips (the FIPS provider must stay a loadable module)")
+        
+        # FIPS 140-3 modules (3.1+) must run their self tests on every load;
+        # only the 140-2 3.0 module honours the install-time test indicators
+        if self.options.get_safe("fips_install") == "oninstall" and Version(self.version) >= "3.1.0":
+            raise ConanInvalidConfiguration(
+                f"fips_install=oninstall requires OpenSSL 3.0.x (the {self.version} FIPS provider "
+                "runs its self tests on every load), use fips_install=onload")
+        
+        qat = self.options.get_safe("qat_provider", "off")
+        if qat != "off":
+            if str(self.settings.arch) != "x86_64":
+                raise ConanInvalidConfiguration("qat_provider requires arch=x86_64")
+            if not self.options.shared or self.options.builtin_providers:
+                raise ConanInvalidConfiguration(
+                    "qat_provider requires shared=True and builtin_providers=False "
+                    "(qatprovider.so is a loadable module linked against libcrypto.so)")
+            if not self.options.enable_async:
+                raise ConanInvalidConfiguration("qat_provider requires enable_async=True (offload pauses ASYNC_JOBs)")
+            if self.options.build_method not in ["perl", "python"] or self.options.get_safe("universal"):
+                raise ConanInvalidConfiguration(
+                    "qat_provider requires build_method=perl or python (QAT_Engine builds against make install_sw)")
+        
+        manifest = self.options.get_safe("algorithm_manifest")
+        if manifest:
+            if self.options.fips:
+                raise ConanInvalidConfiguration(
+                    "algorithm_manifest cannot be combined with fips (the module's algorithm set is fixed)")
+            if not os.path.isfile(str(manifest)):
+                raise ConanInvalidConfiguration(f"algorithm_manifest {manifest} does not exist")
+        
+        secure_heap = self.options.get_safe("secure_heap")
+        if secure_heap:
+            if not re.fullmatch(r"\d+[KMG]?(:\d+[KMG]?)?", str(secure_heap), re.IGNORECASE):
+                raise ConanInvalidConfiguration(f"secure_heap must be SIZE[:MINSIZE] (e.g. 1M:32), not {secure_heap}")
+            size, _, min_size = str(secure_heap).upper().partition(":")
+            units = {"K": 1 << 10, "M": 1 << 20, "G": 1 << 30}
+            size, min_size = [int(v[:-1]) * units[v[-1]] if v[-1] in units else int(v) for v in (size, min_size or "32")]
+            if size & (size - 1) or min_size & (min_size - 1) or min_size >= size:
+                raise ConanInvalidConfiguration(
+                    "secure_heap SIZE and MINSIZE must be powers of two with MINSIZE < SIZE "
+                    "(CRYPTO_secure_malloc_init aborts otherwise)")
+        
+        if self.options.get_safe("libc") == "musl":
+            if str(self.settings.arch) not in ["x86_64", "armv8"]:
+                raise ConanInvalidConfiguration("libc=musl requires arch=x86_64 or armv8")
+            if self.options.shared or self.options.fips:
+                raise ConanInvalidConfiguration(
+                    "libc=musl requires shared=False and fips=False (a static binary loads no shared modules)")
+            if self.options.build_method not in ["perl", "autotools"]:
+                raise ConanInvalidConfiguration("libc=musl requires build_method=perl or autotools (relinks apps/openssl)")
+            if self.options.allocator == "tcmalloc":
+                raise ConanInvalidConfiguration("libc=musl cannot use allocator=tcmalloc (gperftools needs glibc)")
+        
+        fuzzing = str(self.options.fuzzing)
+        if fuzzing != "off":
+            if self.options.build_method != "perl":
+                raise ConanInvalidConfiguration("fuzzing requires build_method=perl (Configure enable-fuzz-*)")
+            if self.options.shared:
+                raise ConanInvalidConfiguration("fuzzing requires shared=False (the fuzz targets link libcrypto statically)")
+            if self.settings.os not in ["Linux", "Macos", "FreeBSD"]:
+                raise ConanInvalidConfiguration("fuzzing requires Linux, macOS or FreeBSD")
+            if fuzzing == "libfuzzer" and "clang" not in str(self.settings.compiler):
+                raise ConanInvalidConfiguration("fuzzing=libfuzzer requires Clang")
+            if fuzzing == "afl" and not self._is_gcc_or_clang:
+                raise ConanInvalidConfiguration("fuzzing=afl requires GCC or Clang (afl-cc wraps them)")
+            if self.options.pgo != "off" or self.options.get_safe("universal"):
+                raise ConanInvalidConfiguration("fuzzing cannot be combined with pgo or universal")
+    
+    def validate_build(self):
+        if self.options.get_safe("fips_install", "off") != "off" and not can_run(self):
+            raise ConanInvalidConfiguration(
+                "fips_install runs the packaged openssl fipsinstall, which a cross build cannot execute")
+        if self.options.get_safe("qat_provider", "off") != "off" \
+                and not (self.conf.get("user.sparetools:qat_engine_source", check_type=str)
+                         and self.conf.get("user.sparetools:qat_engine_sha256", check_type=str)):
+            raise ConanInvalidConfiguration(
+                "qat_provider needs user.sparetools:qat_engine_source (QAT_Engine release tarball URL, "
+                "file:// for a local copy) and its user.sparetools:qat_engine_sha256")
+    
+    def package_id(self):
+        # The compiler cache changes how objects are produced, not what they are
+        self.info.options.rm_safe("compiler_cache")
+        self.info.options.rm_safe("run_tests")
+        # Pruned packages are keyed by what the manifest says, not where it lives.
+        # package_id() runs before validate(), which reports a missing manifest
+        manifest = self.info.options.get_safe("algorithm_manifest")
+        if manifest and os.path.isfile(str(manifest)):
+            with open(str(manifest), "rb") as f:
+                self.info.options.algorithm_manifest = "sha256-" + hashlib.sha256(f.read()).hexdigest()[:16]
+        # A packaged CA bundle (ssl/cert.pem, ssl/cert.stb) is keyed by its contents
+        bundle = self.conf.get("user.sparetools:ca_bundle", check_type=str)
+        if bundle and os.path.isfile(bundle):
+            with open(bundle, "rb") as f:
+                self.info.conf.define("user.sparetools:ca_bundle", "sha256-" + hashlib.sha256(f.read()).hexdigest()[:16])
+        # -march=native binaries are only valid on CPUs like the build host
+        if self.info.options.cpu_tuning == "native":
+            self.info.options.cpu_tuning = f"native-{self._host_cpu_model()}"
+        # One fat package per platform: configure() has already set every
+        # per-ISA option to True, whatever was requested. They stay in the
+        # info so compatibility() can name the fat package.
+    
+    # Per-ISA options each architecture family's Configure flags depend on
+    _simd_options = {
+        "x86": ["enable_avx", "enable_avx2"],
+        "arm": ["enable_neon", "enable_sve"],
+    }
+    
+    def _simd_features(self, values):
+        """
+        Code paths a per-ISA option combination builds, for the host arch.
+        enable_avx2 only counts with enable_avx (Configure gets no-avx alone).
+        """
+        arch = str(self.settings.arch)
+        if arch in ("x86", "x86_64"):
+            return {f for f, on in [("avx", values["enable_avx"]),
+                                    ("avx2", values["enable_avx"] and values["enable_avx2"])] if on}
+        if arch.startswith("arm"):
+            return {f for f, on in [("neon", values["enable_neon"]), ("sve", values["enable_sve"])] if on}
+        return set()
+    
+    def compatibility(self):
+        """
+        Fall back to binaries with a superset of the requested SIMD paths.
+
+        OpenSSL picks its assembly at runtime from the detected CPU
+        capabilities, so a package with more per-ISA paths built in runs
+        wherever the requested one does. A fallback must keep every other
+        option, and the per-ISA options of the other architecture family
+        may take any value (Configure ignores no-neon on x86). Candidates
+        are ordered closest first, and the fat package (cpu_dispatch=fat),
+        which carries every path, comes last. Only generic-tuned asm builds
+        fall back; -march code would not run on older CPUs.
+        """
+        info = self.info.options
+        if info.get_safe("enable_asm") != "True" or info.get_safe("cpu_tuning") != "generic" \
+                or info.get_safe("cpu_dispatch") != "default":
+            return []
+        names = [n for group in self._simd_options.values() for n in group]
+        requested = {n: info.get_safe(n) == "True" for n in names}
+        wanted = self._simd_features(requested)
+        
+        candidates = []
+        for bits in range(1 << len(names)):
+            values = {n: bool(bits >> i & 1) for i, n in enumerate(names)}
+            features = self._simd_features(values)
+            if values == requested or not wanted <= features:
+                continue
+            # Fewer extra paths first, then fewer changed options
+            changed = sum(values[n] != requested[n] for n in names)
+            candidates.append((len(features - wanted), changed, values))
+        candidates.sort(key=lambda c: (c[0], c[1]))
+        
+        result = [{"options": [(n, str(v)) for n, v in values.items()]} for _, _, values in candidates]
+        result.append({"options": [("cpu_dispatch", "fat")] + [(n, "True") for n in names]})
+        return result
+    
+    @staticmethod
+    def _host_cpu_model():
+        """CPU model of the build machine, used to key native-tuned packages"""
+        try:
+            with open("/proc/cpuinfo") as f:
+                for line in f:
+                    if line.startswith(("model name", "CPU part")):
+                        return line.split(":", 1)[1].strip().replace(" ", "_")
+        except OSError:
+            pass
+        return platform.processor() or platform.machine()
+    
+    @property
+    def _is_gcc_or_clang(self):
+        return str(self.settings.compiler) in ["gcc", "clang", "apple-clang"]
     
     def layout(self):
         if self.options.build_method == "cmake":
@@ -87,16 +537,70 @@ class SpareToolsOpenSSLConan(ConanFile):
             basic_layout(self)
     
     def source(self):
-        """Download OpenSSL source code"""
-        get(self, 
-            f"https://github.com/openssl/openssl/archive/refs/tags/openssl-{self.version}.tar.gz",
-            strip_root=True)
+        """Download OpenSSL source code (through the shared source cache and mirror)"""
+        start = time.time_ns() // 1000
+        mirror = self._base_module("source-mirror.py", "sparetools_source_mirror")
+        cache_dir = self.conf.get("user.sparetools:source_cache_dir", check_type=str,
+                                  default=mirror.DEFAULT_CACHE_DIR)
+        version = str(self.version)
+        sha256 = self._source_sha256(version)
+        if sha256 is None:
+            if version != "master":
+                raise ConanException(
+                    f"No sha256 pinned for openssl-{version}.tar.gz: add it to conandata.yml "
+                    "or pass -c user.sparetools:source_sha256=<digest>")
+            self.output.warning("openssl-master.tar.gz is a moving snapshot with no pinned sha256; "
+                                "its source is NOT verified")
+        origin, digest = mirror.fetch_source(version, self.source_folder, cache_dir=cache_dir,
+                                             mirror=self.conf.get("user.sparetools:source_mirror", check_type=str),
+                                             sha256=sha256, log=self.output.info)
+        self.output.info(f"Source openssl-{self.version}.tar.gz from {origin} (sha256 {digest[:16]})")
+        self._prefetch_sources(mirror, cache_dir)
         
         # Copy Python configure.py (will be used if build_method is python)
         # Note: source() must not access self.options (Conan 2.x requirement)
         configure_py = os.path.join(self.recipe_folder, "configure.py")
         if os.path.exists(configure_py):
             copy(self, "configure.py", self.recipe_folder, self.source_folder)
+        
+        # Picked up as the "source" span of the build trace (build() has no
+        # tools dependency here, and only adds it when run by this process)
+        save(self, os.path.join(self.source_folder, ".sparetools-source-time.json"),
+             json.dumps({"pid": os.getpid(), "ts": start, "dur": time.time_ns() // 1000 - start}))
+    
+    def _source_sha256(self, version):
+        """
+        sha256 of the release tarball: pinned per version in conandata.yml,
+        or from user.sparetools:source_sha256 for a version the recipe does
+        not list yet. The conf cannot override a pin.
+        """
+        pinned = ((self.conan_data or {}).get("sources", {}).get(version) or {}).get("sha256")
+        conf = self.conf.get("user.sparetools:source_sha256", check_type=str)
+        if pinned and conf and conf.lower() != pinned:
+            raise ConanException(f"user.sparetools:source_sha256 {conf} does not match the sha256 "
+                                 f"conandata.yml pins for openssl-{version}.tar.gz ({pinned})")
+        return pinned or (conf.lower() if conf else None)
+    
+    def _prefetch_sources(self, mirror, cache_dir):
+        """
+        user.sparetools:source_prefetch: versions (comma-separated, or True
+        for 3.3.2, 3.6.0 and master) to download into the source cache in a
+        detached process, so the next clean cache on this host finds them
+        """
+        value = self.conf.get("user.sparetools:source_prefetch")
+        if value in (None, False, "False", "false", "0", ""):
+            return
+        if value in (True, "True", "true", "1"):
+            versions = list(mirror.DEFAULT_PREFETCH)
+        else:
+            versions = [v.strip() for v in str(value).split(",") if v.strip()]
+        versions = [v for v in versions if v != str(self.version)]
+        if versions:
+            pins = {v: data["sha256"] for v, data in ((self.conan_data or {}).get("sources") or {}).items()}
+            pid = mirror.prefetch_in_background(versions, cache_dir,
+                                                self.conf.get("user.sparetools:source_mirror", check_type=str),
+                                                sha256=pins)
+            self.output.info(f"Prefetching {', '.join(versions)} into {cache_dir} (pid {pid})")
     
     def _get_target(self):
         """
@@ -153,24 +657,51 @@ class SpareToolsOpenSSLConan(ConanFile):
 
         return default_target
     
-    def _get_configure_args(self):
+    def _get_configure_args(self, prefix=None):
         """Build configure arguments based on options"""
+        prefix = self._install_prefix if prefix is None else prefix
         args = [
             self._get_target(),
             "shared" if self.options.shared else "no-shared",
-            f"--prefix={self.package_folder}",
-            f"--openssldir={self.package_folder}/ssl",
+            f"--prefix={prefix}",
+            f"--openssldir={prefix}/ssl",
         ]
 
         # Feature flags
         if not self.options.enable_threads:
             args.append("no-threads")
+        # ASYNC_JOB support for offload providers (OPENSSL_NO_ASYNC when off)
+        if not self.options.enable_async:
+            args.append("no-async")
+        # QUIC is built by default from 3.2 on (OPENSSL_NO_QUIC when off)
+        if self.options.get_safe("enable_quic") is not None and not self.options.enable_quic:
+            args.append("no-quic")
+        # Thread pool behind OSSL_set_max_threads, 3.2+ (OPENSSL_NO_THREAD_POOL
+        # / OPENSSL_NO_DEFAULT_THREAD_POOL when off)
+        if self.options.get_safe("enable_thread_pool") is not None and not self.options.enable_thread_pool:
+            args.append("no-thread-pool")
+        if self.options.get_safe("default_thread_pool") is not None and not self.options.default_thread_pool:
+            args.append("no-default-thread-pool")
         if not self.options.enable_asm:
             args.append("no-asm")
         if not self.options.enable_zlib:
             args.append("no-zlib")
+        # Certificate compression libraries from their Conan packages
+        for option, (feature, ref, _) in self._compression_requires.items():
+            if self.options.get_safe(option):
+                dep = self.dependencies[ref.split("/")[0]].cpp_info.aggregated_components()
+                args += [f"enable-{feature}", f"--with-{feature}-include={dep.includedirs[0]}",
+                         f"--with-{feature}-lib={dep.libdirs[0]}"]
         if not self.options.enable_legacy:
             args.extend(["no-md2", "no-md4", "no-rc5"])
+        # Legacy provider linked into libcrypto (OPENSSL_NO_MODULE): loading
+        # it no longer dlopens lib/ossl-modules/legacy.so. Also disables
+        # dynamic engines
+        if self.options.builtin_providers:
+            args.append("no-module")
+        for flag in self._manifest_configure_flags():
+            if flag not in args:
+                args.append(flag)
 
         # Assembly optimization flags
         if self.options.enable_asm:
@@ -192,22 +723,662 @@ class SpareToolsOpenSSLConan(ConanFile):
                 if self.options.enable_sve:
                     args.append("enable-sve")
 
+        # Kernel TLS offload (SSL_OP_ENABLE_KTLS / SSL_sendfile)
+        if self.options.get_safe("enable_ktls"):
+            args.append("enable-ktls")
+        # afalg engine: AES-CBC through the kernel crypto API, for SoC
+        # crypto engines the CPU cannot reach directly. Configure builds it
+        # on Linux unless told otherwise, so False is explicit
+        if self.options.get_safe("enable_afalg") is not None:
+            args.append("enable-afalgeng" if self.options.enable_afalg else "no-afalgeng")
+
         # FIPS support
         if self.options.fips:
             args.append("enable-fips")
 
+        # Fuzz targets in fuzz/ with sanitizers and coverage instrumentation
+        args.extend(self._fuzzing_configure_args)
+
+        # Compiler cache launcher and the AFL++ compiler wrapper; Configure
+        # and configure.py take CC=...
+        compiler = self._fuzzing_compiler or self._c_compiler
+        cross = None if self._fuzzing_compiler else self._cross_toolchain
+        # Cross toolchains: CC, AR and RANLIB as CROSS_COMPILE + tool, unless
+        # Configure (unlike configure.py) would prefix the launcher as well
+        prefixed = cross and not (self._compiler_cache and self.options.build_method != "python")
+        if prefixed:
+            args.append(f"--cross-compile-prefix={cross[0]}")
+            compiler = cross[1]
+        elif cross:
+            args += [f"AR={cross[0]}ar", f"RANLIB={cross[0]}ranlib"]
+        if self._compiler_cache:
+            args.append(f'CC="{self._compiler_cache} {compiler}"')
+        elif self._fuzzing_compiler or prefixed:
+            args.append(f"CC={compiler}")
+        # Target headers and libraries (sparetools-sysroot or the profile);
+        # Configure passes "-..." arguments to the link as well
+        sysroot = self.conf.get("tools.build:sysroot", check_type=str)
+        if sysroot and cross_building(self) and self._is_gcc_or_clang:
+            args.append(f"--sysroot={sysroot}")
+
+        # Extra compiler flags (PGO, LTO, CPU tuning); Configure appends
+        # "-..." arguments to CFLAGS and uses them when linking as well
+        args.extend(self._get_extra_cflags())
+        args.extend(self._get_lto_tools())
+        # Configure appends -Wl,... to LDFLAGS; configure.py keeps
+        # -Wl,-Bsymbolic* for the shared library link
+        args.extend(self._get_symbol_binding_flags()[1])
+        args.extend(self._get_hardening_flags()[1])
+        if self.options.shared:
+            args.extend(self._hugepage_text_ldflags)
+
+        # BOLT needs relocations kept in the linked shared libraries
+        if self.options.bolt:
+            args.append("-Wl,--emit-relocs")
+
         return args
     
+    # fuzzing: what Configure needs besides enable-fuzz-<engine>, after
+    # fuzz/README.md. ASan and UBSan (minus the alignment checks OpenSSL's
+    # unaligned loads trip) come from Configure's enable-asan/enable-ubsan;
+    # FUZZING_BUILD_MODE_UNSAFE_FOR_PRODUCTION makes the RNG deterministic
+    _fuzzing_common_args = ["-DPEDANTIC", "-DFUZZING_BUILD_MODE_UNSAFE_FOR_PRODUCTION",
+                            "enable-asan", "enable-ubsan", "-fno-sanitize=alignment"]
+    
+    @property
+    def _fuzzing_configure_args(self):
+        fuzzing = str(self.options.fuzzing)
+        if fuzzing == "off":
+            return []
+        if fuzzing == "afl":
+            # afl-cc instruments every edge itself
+            return ["enable-fuzz-afl"] + self._fuzzing_common_args
+        # SanitizerCoverage (inline 8-bit counters, cmp tracing) without
+        # libFuzzer's main; the fuzz targets link the runtime below
+        return (["enable-fuzz-libfuzzer", f"--with-fuzzer-lib={self._fuzzer_lib}", "-fsanitize=fuzzer-no-link"]
+                + self._fuzzing_common_args)
+    
+    @property
+    def _fuzzing_compiler(self):
+        """afl-clang-fast (or afl-gcc-fast) for fuzzing=afl unless CC already is an AFL++ wrapper"""
+        if self.options.fuzzing != "afl":
+            return None
+        if os.path.basename(self._c_compiler.split()[-1]).startswith("afl-"):
+            return None
+        return "afl-gcc-fast" if self.settings.compiler == "gcc" else "afl-clang-fast"
+    
+    @property
+    def _fuzzer_lib(self):
+        """
+        libFuzzer runtime of the Clang in use, or user.sparetools:fuzzer_lib.
+        Newer Clangs keep it per target triple (libclang_rt.fuzzer.a), older
+        ones per arch (libclang_rt.fuzzer-<arch>.a).
+        """
+        configured = self.conf.get("user.sparetools:fuzzer_lib", check_type=str)
+        if configured:
+            return configured
+        compiler = self._c_compiler
+        
+        def query(flag):
+            try:
+                return subprocess.run([compiler, flag], capture_output=True, text=True).stdout.strip()
+            except OSError:
+                return ""
+        
+        runtime_dir = query("--print-runtime-dir")
+        candidates = [os.path.join(runtime_dir, "libclang_rt.fuzzer.a")] if runtime_dir else []
+        arch = {"armv8": "aarch64"}.get(str(self.settings.arch), str(self.settings.arch))
+        names = [f"libclang_rt.fuzzer-{arch}.a", "libclang_rt.fuzzer_osx.a"]
+        for name in names:
+            candidates.append(query(f"-print-file-name={name}"))
+            if runtime_dir:
+                candidates.append(os.path.join(runtime_dir, name))
+        for candidate in candidates:
+            if os.path.isabs(candidate) and os.path.isfile(candidate):
+                return candidate
+        raise ConanException(f"fuzzing=libfuzzer: no libFuzzer runtime found for {compiler}; "
+                             "set user.sparetools:fuzzer_lib")
+    
+    def _get_extra_cflags(self):
+        """Compiler flags added on top of the build method defaults"""
+        return (self._get_pgo_flags() + self._get_optimization_flags()[0]
+                + self._get_symbol_binding_flags()[0] + self._gc_sections_cflags
+                + self._get_hardening_flags()[0])
+    
+    # hardening: flag name -> (cflags, ldflags). cf_protection is per arch
+    # (CET on x86_64, PAC/BTI on armv8). `openssl_tools.cli hardening-cost`
+    # builds with each one on its own to measure it
+    _hardening_flags = {
+        "stack_protector": (["-fstack-protector-strong"], []),
+        "fortify": (["-U_FORTIFY_SOURCE", "-D_FORTIFY_SOURCE=3"], []),
+        "cf_protection": ({"x86_64": ["-fcf-protection=full"], "armv8": ["-mbranch-protection=standard"]}, []),
+        "auto_var_init": (["-ftrivial-auto-var-init=zero"], []),
+        "relro": ([], ["-Wl,-z,relro", "-Wl,-z,now"]),
+    }
+    
+    def _hardening_unsupported(self, name):
+        """Why hardening flag `name` does not apply to this configuration, or None"""
+        compiler = str(self.settings.compiler)
+        version = str(self.settings.get_safe("compiler.version") or "0")
+        if name == "cf_protection" and str(self.settings.arch) not in self._hardening_flags[name][0]:
+            return f"needs arch x86_64 or armv8, not {self.settings.arch}"
+        if name == "relro" and self.settings.os in ["Windows", "Macos", "iOS"]:
+            return "needs an ELF platform"
+        if name == "fortify" and self.settings.build_type == "Debug":
+            return "needs an optimized build_type (glibc ignores it at -O0)"
+        if name == "auto_var_init":
+            minimum = {"gcc": "12", "clang": "16", "apple-clang": "15"}.get(compiler)
+            if minimum and Version(version) < minimum:
+                return f"needs {compiler} {minimum} or newer"
+        return None
+    
+    @property
+    def _hardening(self):
+        """Hardening flag names in effect: all that apply for full, else the listed ones"""
+        value = str(self.options.hardening)
+        if value == "none":
+            return []
+        if value == "full":
+            return [n for n in self._hardening_flags if self._hardening_unsupported(n) is None]
+        return [n.strip() for n in value.split(",") if n.strip()]
+    
+    def _validate_hardening(self):
+        if self.options.hardening == "none":
+            return
+        if not self._is_gcc_or_clang:
+            raise ConanInvalidConfiguration("hardening requires GCC or Clang")
+        for name in self._hardening:
+            if name not in self._hardening_flags:
+                raise ConanInvalidConfiguration(
+                    f"hardening={self.options.hardening}: unknown flag {name} "
+                    f"(none, full or a comma-separated list of {', '.join(self._hardening_flags)})")
+            reason = self._hardening_unsupported(name)
+            if reason:
+                raise ConanInvalidConfiguration(f"hardening flag {name} {reason}")
+    
+    def _get_hardening_flags(self):
+        """(cflags, ldflags) for the hardening option"""
+        cflags, ldflags = [], []
+        for name in self._hardening:
+            flag_cflags, flag_ldflags = self._hardening_flags[name]
+            if isinstance(flag_cflags, dict):
+                flag_cflags = flag_cflags[str(self.settings.arch)]
+            cflags += flag_cflags
+            ldflags += flag_ldflags
+        return cflags, ldflags
+    
+    @property
+    def _gc_sections_cflags(self):
+        """gc_sections: one section per function and object, so consumers' links can drop the unused ones"""
+        return ["-ffunction-sections", "-fdata-sections"] if self.options.gc_sections else []
+    
+    @property
+    def _gc_sections_ldflags(self):
+        """What consumers of gc_sections packages link with (package_info)"""
+        if not self.options.gc_sections:
+            return []
+        return ["-Wl,-dead_strip"] if self.settings.os in ["Macos", "iOS"] else ["-Wl,--gc-sections"]
+    
+    def _get_symbol_binding_flags(self):
+        """
+        (cflags, shared library ldflags) for shared_symbol_binding.
+
+        libcrypto/libssl calls to their own exported functions bind at link
+        time instead of going through the PLT, and the compiler may inline
+        them since they can no longer be interposed. Calls into other
+        libraries use the GOT directly (-fno-plt, resolved at load time).
+        """
+        if not self.options.shared_symbol_binding:
+            return [], []
+        return ["-fno-semantic-interposition", "-fno-plt"], ["-Wl,-Bsymbolic-functions"]
+    
+    @property
+    def _hugepage_text_ldflags(self):
+        """
+        hugepage_text: 2 MiB-aligned segments, so the text of libcrypto.so
+        and libssl.so (or of executables linking the static libraries, see
+        package_info) is made of whole hugepages SpareTools::hugetext can
+        remap
+        """
+        if not self.options.hugepage_text:
+            return []
+        return ["-Wl,-zcommon-page-size=2097152", "-Wl,-zmax-page-size=2097152"]
+    
+    def _get_optimization_flags(self):
+        """
+        (cflags, ldflags) for the lto and cpu_tuning options.
+
+        GCC has no ThinLTO; lto=thin uses parallel -flto=auto there.
+        Static GCC archives keep fat objects so non-LTO consumers link.
+        """
+        cflags = []
+        is_clang = "clang" in str(self.settings.compiler)
+
+        lto = str(self.options.lto)
+        if lto != "off":
+            if is_clang:
+                cflags.append("-flto=thin" if lto == "thin" else "-flto")
+            else:
+                cflags.append("-flto=auto")
+                if not self.options.shared:
+                    cflags.append("-ffat-lto-objects")
+
+        tuning = str(self.options.cpu_tuning)
+        if tuning.startswith("x86-64-"):
+            cflags.append(f"-march={tuning}")
+        elif tuning == "neoverse-n1":
+            cflags.append("-mcpu=neoverse-n1")
+        elif tuning == "native":
+            cflags.append("-mcpu=native" if str(self.settings.arch).startswith("arm") else "-march=native")
+
+        # LTO code generation happens at link time and needs the same flags
+        ldflags = list(cflags) if lto != "off" else []
+        
+        # Per-TU compile timings for the build trace (foo.json next to foo.o)
+        if is_clang and self._trace_file:
+            cflags.append("-ftime-trace")
+        return cflags, ldflags
+    
+    def _get_lto_tools(self):
+        """LTO-aware archiver for static builds (plain ar drops the IR symbol index)"""
+        if self.options.lto == "off" or self.options.shared:
+            return []
+        if "clang" in str(self.settings.compiler):
+            return ["AR=llvm-ar", "RANLIB=llvm-ranlib"]
+        return ["AR=gcc-ar", "RANLIB=gcc-ranlib"]
+    
+    @property
+    def _pgo_stage(self):
+        """Current PGO stage: off, generate or use (pgo=use trains first)"""
+        return getattr(self, "_pgo_stage_override", None) or str(self.options.pgo)
+    
+    @property
+    def _pgo_profile_dir(self):
+        """
+        Profile data location. user.sparetools:pgo_profile_dir points
+        pgo=generate packages at a shared location for fleet training and
+        lets pgo=use consume those profiles instead of training in-build.
+        """
+        profile_dir = self.conf.get("user.sparetools:pgo_profile_dir", check_type=str)
+        return profile_dir or os.path.join(self.build_folder, "pgo-profiles")
+    
+    @property
+    def _pgo_is_clang(self):
+        return "clang" in str(self.settings.compiler)
+    
+    def _get_pgo_flags(self):
+        """Instrumentation or profile-use flags for the current PGO stage"""
+        stage = self._pgo_stage
+        profile_dir = self._pgo_profile_dir
+        if stage == "generate":
+            if self._pgo_is_clang:
+                return [f"-fprofile-instr-generate={profile_dir}/openssl-%m.profraw"]
+            return [f"-fprofile-generate={profile_dir}", "-fprofile-update=atomic"]
+        if stage == "use":
+            if self._pgo_is_clang:
+                return [f"-fprofile-instr-use={profile_dir}/openssl.profdata",
+                        "-Wno-profile-instr-unprofiled", "-Wno-profile-instr-out-of-date"]
+            return [f"-fprofile-use={profile_dir}", "-fprofile-correction", "-Wno-missing-profile"]
+        return []
+    
+    @property
+    def _c_compiler(self):
+        """C compiler command the build uses, without any launcher"""
+        executables = self.conf.get("tools.build:compiler_executables", default={}, check_type=dict)
+        if executables.get("c"):
+            return executables["c"]
+        if os.environ.get("CC"):
+            return os.environ["CC"]
+        compiler = str(self.settings.compiler)
+        return {"msvc": "cl", "clang": "clang", "apple-clang": "clang"}.get(compiler, "gcc")
+    
+    @property
+    def _cross_toolchain(self):
+        """
+        (prefix, compiler) of a cross GCC/Clang named by target triplet,
+        e.g. ("aarch64-linux-gnu-", "gcc-11") for aarch64-linux-gnu-gcc-11,
+        None for native builds and compilers without a triplet. The prefix
+        keeps the compiler's directory.
+        """
+        if not cross_building(self) or not self._is_gcc_or_clang:
+            return None
+        compiler = self._c_compiler.split()[-1]
+        directory, name = os.path.split(compiler)
+        match = re.match(r"^(\w+(?:-\w+){1,3}-)((?:gcc|clang|cc)(?:-[\d.]+)?)$", name)
+        if not match:
+            return None
+        prefix = os.path.join(directory, match.group(1)) if directory else match.group(1)
+        return prefix, match.group(2)
+    
+    @property
+    def _compiler_cache(self):
+        """
+        ccache/sccache/recc executable for compiler_cache, None when off, not
+        installed or (recc) without a remote execution endpoint
+        """
+        tool = str(self.options.compiler_cache)
+        if tool == "none":
+            return None
+        missing = None
+        if not shutil.which(tool):
+            missing = f"{tool} is not on PATH"
+        elif tool == "recc" and not self._remote_execution_server:
+            missing = "neither user.sparetools:remote_execution nor RECC_SERVER is set"
+        if missing:
+            if not getattr(self, "_compiler_cache_warned", False):
+                self.output.warning(f"compiler_cache={tool} but {missing}, building without it")
+                self._compiler_cache_warned = True
+            return None
+        return tool
+    
+    @property
+    def _remote_execution_server(self):
+        """REAPI endpoint for compiler_cache=recc (grpc://host:port, grpcs://...)"""
+        return self.conf.get("user.sparetools:remote_execution", check_type=str) or os.environ.get("RECC_SERVER")
+    
+    @property
+    def _make_jobs(self):
+        """
+        Parallel compile jobs: tools.build:jobs, or with compiler_cache=recc
+        user.sparetools:remote_jobs (default 8x that), since compiles run on
+        the remote worker pool and only preprocessing and links stay local
+        """
+        jobs = build_jobs(self)
+        if self._compiler_cache != "recc":
+            return jobs
+        return self.conf.get("user.sparetools:remote_jobs", default=8 * jobs, check_type=int)
+    
+    def _setup_compiler_cache(self):
+        """
+        Share cache entries between package IDs: ccache rewrites paths below
+        CCACHE_BASEDIR to relative ones and ignores the working directory,
+        so shared/static or FIPS/std trees hit on their common sources.
+        Statistics are zeroed so the report covers this build only.
+        """
+        tool = self._compiler_cache
+        if not tool:
+            return
+        base_dir = os.path.dirname(os.path.dirname(self._build_tree))
+        home = os.path.expanduser("~")
+        if os.path.commonpath([home, self._build_tree]) == home:
+            base_dir = home
+        if tool == "ccache":
+            os.environ.setdefault("CCACHE_BASEDIR", base_dir)
+            os.environ.setdefault("CCACHE_NOHASHDIR", "1")
+            self.run("ccache -z", ignore_errors=True)
+        elif tool == "recc":
+            self._setup_remote_execution(base_dir)
+            return
+        else:
+            os.environ.setdefault("SCCACHE_BASEDIRS", base_dir)
+            self.run("sccache --start-server", ignore_errors=True)
+            self.run("sccache --zero-stats", ignore_errors=True)
+        self.output.info(f"Compiler cache: {tool} (base dir {base_dir})")
+    
+    def _setup_remote_execution(self, base_dir):
+        """
+        recc sends each compile (sources, headers from the dependency scan
+        and the command) to the REAPI server; links and anything it cannot
+        handle run locally. Paths below RECC_PROJECT_ROOT are rewritten to
+        relative ones, so the action cache is shared like CCACHE_BASEDIR.
+        user.sparetools:remote_instance names the instance and
+        user.sparetools:remote_platform ({"OSFamily": "linux",
+        "container-image": "docker://..."}) selects workers whose toolchain
+        matches this one. The caller's RECC_* variables take precedence.
+        """
+        env = {
+            "RECC_SERVER": self._remote_execution_server,
+            "RECC_INSTANCE": self.conf.get("user.sparetools:remote_instance", check_type=str),
+            "RECC_PROJECT_ROOT": base_dir,
+            # Retry transient gRPC errors before failing the compile
+            "RECC_RETRY_LIMIT": "2",
+        }
+        platform = self.conf.get("user.sparetools:remote_platform", default={}, check_type=dict)
+        for key, value in platform.items():
+            env[f"RECC_REMOTE_PLATFORM_{key}"] = str(value)
+        for name, value in env.items():
+            if value:
+                os.environ.setdefault(name, value)
+        self.output.info(f"Remote execution: recc -> {os.environ['RECC_SERVER']} "
+                         f"({self._make_jobs} jobs, project root {base_dir})")
+    
+    def _manifest_configure_flags(self):
+        """
+        no-<feature> flags for every optional algorithm family the
+        algorithm_manifest does not use (openssl_tools.openssl.algorithm_manifest).
+        """
+        manifest = self.options.get_safe("algorithm_manifest")
+        if not manifest:
+            return []
+        if getattr(self, "_manifest_flags", None) is None:
+            module = self._tools_module("openssl", "algorithm_manifest")
+            self._manifest_flags = module.configure_flags(module.load_manifest(str(manifest)))
+            self.output.info(f"algorithm_manifest: disabling {', '.join(f[3:] for f in self._manifest_flags) or 'nothing'}")
+        return self._manifest_flags
+    
+    def _tools_module(self, subdir, name):
+        """
+        Import one module of sparetools-openssl-tools by file, without the
+        openssl_tools package __init__s (they pull in CLI-only dependencies).
+        """
+        tools_dir = self.dependencies.build["sparetools-openssl-tools"].package_folder
+        module_dir = os.path.join(tools_dir, "openssl_tools", *subdir.split("/"))
+        if module_dir not in sys.path:
+            sys.path.insert(0, module_dir)
+        return __import__(name)
+    
+    def _report_compiler_cache(self):
+        """Hit rate of this build via CacheOptimizer.generate_cache_report"""
+        tool = self._compiler_cache
+        if tool in (None, "recc"):
+            return
+        report_file = os.path.join(self.build_folder, "cache-performance-report.json")
+        try:
+            cache_optimization = self._tools_module("development/build_system", "cache_optimization")
+            report = cache_optimization.CacheOptimizer().generate_cache_report(report_file, include_keys=False)
+            stats = report["performance"].get(tool, {})
+        except Exception as e:
+            self.output.warning(f"Cache report unavailable ({e}), showing raw statistics")
+            self.run("ccache -s" if tool == "ccache" else "sccache --show-stats", ignore_errors=True)
+            return
+        if "hit_rate" in stats:
+            self.output.info(f"{tool}: {stats['hits']} hits, {stats['misses']} misses "
+                             f"({stats['hit_rate']:.1%} hit rate), report {report_file}")
+    
     def generate(self):
         """Generate build system files"""
+        cflags, ldflags = self._get_optimization_flags()
+        binding_cflags, binding_ldflags = self._get_symbol_binding_flags()
+        hardening_cflags, hardening_ldflags = self._get_hardening_flags()
+        cflags = cflags + binding_cflags + self._gc_sections_cflags + hardening_cflags
+        ldflags = ldflags + hardening_ldflags
         if self.options.build_method == "cmake":
             tc = CMakeToolchain(self)
             tc.variables["BUILD_SHARED_LIBS"] = self.options.shared
             tc.variables["CMAKE_INSTALL_PREFIX"] = self.package_folder
+            if self._compiler_cache:
+                tc.cache_variables["CMAKE_C_COMPILER_LAUNCHER"] = self._compiler_cache
+            if self.options.unity_build:
+                tc.cache_variables["CMAKE_UNITY_BUILD"] = True
+                tc.cache_variables["CMAKE_UNITY_BUILD_BATCH_SIZE"] = self._unity_batch_size
+            tc.extra_cflags.extend(cflags)
+            tc.extra_sharedlinkflags.extend(ldflags + binding_ldflags + self._hugepage_text_ldflags)
+            tc.extra_exelinkflags.extend(ldflags)
             tc.generate()
         elif self.options.build_method == "autotools":
             tc = AutotoolsToolchain(self)
-            tc.generate()
+            tc.extra_cflags.extend(cflags)
+            tc.extra_ldflags.extend(ldflags)
+            env = tc.environment()
+            if self._compiler_cache:
+                env.define("CC", f"{self._compiler_cache} {self._c_compiler}")
+            tc.generate(env)
+    
+    @property
+    def _incremental_dir(self):
+        """
+        Persistent build tree for local iteration, or None when disabled.
+
+        Opt in with user.sparetools:incremental_build_dir=<root>. The tree
+        lives in <root>/<version>-<hash>, the hash covering the build method,
+        toolchain settings and conf, and the configure arguments (minus the
+        install prefix), so each configuration keeps its own configdata.pm
+        and object files across package revisions. PGO, BOLT and universal
+        builds always start clean and do not use it.
+        """
+        root = self.conf.get("user.sparetools:incremental_build_dir", check_type=str)
+        if not root or str(self.options.build_method) not in ["perl", "python"]:
+            return None
+        if self.options.pgo != "off" or self.options.bolt or self.options.get_safe("universal"):
+            return None
+        key_args = [a for a in self._get_configure_args(prefix="")
+                    if not a.startswith(("--prefix=", "--openssldir="))]
+        key = json.dumps([str(self.options.build_method), str(self.settings.os), str(self.settings.arch),
+                          str(self.settings.compiler), str(self.settings.get_safe("compiler.version")),
+                          str(self.settings.build_type),
+                          self.conf.get("tools.build:compiler_executables", default={}, check_type=dict),
+                          self.conf.get("tools.build:cflags", default=[], check_type=list), key_args])
+        digest = hashlib.sha256(key.encode()).hexdigest()[:16]
+        return os.path.join(os.path.expanduser(root), f"{self.version}-{digest}")
+    
+    @property
+    def _build_tree(self):
+        """
+        Where Configure and make run: the source folder or the incremental
+        tree. Universal builds have one tree per slice; this is the slice of
+        settings.arch, which tests and helpers use.
+        """
+        if self.options.get_safe("universal"):
+            return self._universal_tree("arm64" if self.settings.arch == "armv8" else "x86_64")
+        return os.path.join(self._incremental_dir, "src") if self._incremental_dir else self.source_folder
+    
+    @property
+    def _install_prefix(self):
+        """
+        Configure --prefix. Incremental trees use a stable prefix next to the
+        tree (the package folder changes with every revision, and a new
+        prefix would regenerate every header); package() copies it over, and
+        _point_dirs_at_package() compiles this package's folders in.
+        """
+        if self._incremental_dir is None:
+            return self.package_folder
+        return os.path.join(self._incremental_dir, "prefix")
+    
+    def _sync_incremental_tree(self):
+        """
+        Mirror source_folder into the incremental tree, copying only files
+        whose size or mtime differ so unchanged sources keep their
+        timestamps and make leaves the matching objects alone. Files a
+        previous sync copied that are gone from the sources are deleted;
+        the tree's build outputs are not in that list and stay.
+        """
+        tree = self._build_tree
+        manifest = os.path.join(tree, ".sparetools-synced")
+        previous = set(load(self, manifest).splitlines()) if os.path.exists(manifest) else set()
+        synced = set()
+        copied = 0
+        for dirpath, dirnames, filenames in os.walk(self.source_folder):
+            rel = os.path.relpath(dirpath, self.source_folder)
+            dest_dir = os.path.normpath(os.path.join(tree, rel))
+            os.makedirs(dest_dir, exist_ok=True)
+            for name in filenames:
+                src = os.path.join(dirpath, name)
+                dest = os.path.join(dest_dir, name)
+                synced.add(os.path.normpath(os.path.join(rel, name)))
+                st = os.lstat(src)
+                try:
+                    dst = os.lstat(dest)
+                    if dst.st_size == st.st_size and int(dst.st_mtime) == int(st.st_mtime):
+                        continue
+                except OSError:
+                    pass
+                if os.path.islink(src):
+                    if os.path.lexists(dest):
+                        os.remove(dest)
+                    os.symlink(os.readlink(src), dest)
+                else:
+                    shutil.copy2(src, dest)
+                copied += 1
+        removed = 0
+        for rel in sorted(previous - synced):
+            path = os.path.join(tree, rel)
+            if os.path.lexists(path):
+                os.remove(path)
+                removed += 1
+        save(self, manifest, "\n".join(sorted(synced)))
+        self.output.info(f"Incremental tree {tree}: {copied} source files updated, {removed} removed")
+    
+    # Compiled-in directory macros and the cryptlib.h/ct.h names built on them
+    _dir_macro_pattern = re.compile(
+        rb"\b(OPENSSLDIR|ENGINESDIR|MODULESDIR|X509_CERT_AREA|X509_CERT_DIR|X509_CERT_FILE|"
+        rb"X509_PRIVATE_DIR|CTLOG_FILE)\b")
+    
+    def _point_dirs_at_package(self):
+        """
+        Incremental trees configure with the stable _install_prefix, so the
+        Makefile's LIB_CPPFLAGS compiles OPENSSLDIR, ENGINESDIR and
+        MODULESDIR in under it. Rewrite them to this package's folder and,
+        when that folder changed since the last build, drop the objects of
+        the few sources using them so make recompiles just those.
+        """
+        tree = self._build_tree
+        prefix, package = self._install_prefix, self.package_folder
+        makefile = next((os.path.join(tree, name) for name in ("Makefile", "makefile")
+                         if os.path.exists(os.path.join(tree, name))), None)
+        content = load(self, makefile) if makefile else ""
+        lines = content.splitlines(keepends=True)
+        index = next((i for i, line in enumerate(lines) if line.startswith("LIB_CPPFLAGS=")), None)
+        if index is None:
+            self.output.warning(f"Incremental tree: no LIB_CPPFLAGS in {makefile or tree}; OPENSSLDIR and "
+                                f"MODULESDIR stay under {prefix}, set OPENSSL_CONF/OPENSSL_MODULES at run time")
+            return
+        escaped = [(prefix, package), (prefix.replace("\\", "\\\\"), package.replace("\\", "\\\\"))]
+        line = lines[index]
+        for old, new in escaped:
+            line = line.replace(old, new)
+        if line != lines[index]:
+            lines[index] = line
+            save(self, makefile, "".join(lines))
+        
+        stamp = os.path.join(tree, ".sparetools-package-dirs")
+        if os.path.exists(stamp) and load(self, stamp) == package:
+            return
+        dropped = 0
+        for top in ("crypto", "providers", "ssl"):
+            for dirpath, _, filenames in os.walk(os.path.join(tree, top)):
+                for name in filenames:
+                    if not name.endswith(".c"):
+                        continue
+                    with open(os.path.join(dirpath, name), "rb") as f:
+                        if not self._dir_macro_pattern.search(f.read()):
+                            continue
+                    stem = name[:-2]
+                    for obj in glob.glob(os.path.join(dirpath, f"*-{stem}.o")) + \
+                            glob.glob(os.path.join(dirpath, f"*-{stem}.obj")):
+                        os.remove(obj)
+                        dropped += 1
+        save(self, stamp, package)
+        self.output.info(f"Incremental tree: OPENSSLDIR/MODULESDIR now under {package}, "
+                         f"{dropped} objects to recompile")
+    
+    def _configure_if_changed(self, configure_cmd, script):
+        """
+        Run configure_cmd in the build tree unless the incremental stamp
+        records the same command and the same configure script content.
+        """
+        tree = self._build_tree
+        stamp = os.path.join(tree, ".sparetools-configure")
+        if self._incremental_dir:
+            with open(script, "rb") as f:
+                expected = f"{configure_cmd}\n{hashlib.sha256(f.read()).hexdigest()}"
+            if os.path.exists(os.path.join(tree, "configdata.pm")) and os.path.exists(stamp) \
+                    and load(self, stamp) == expected:
+                self.output.info("Configure arguments unchanged, reusing configdata.pm and objects")
+                return
+        with self._span("Configure", command=configure_cmd):
+            self.run(configure_cmd, cwd=tree)
+        if self._incremental_dir:
+            save(self, stamp, expected)
     
     def _build_with_perl(self):
         """
@@ -215,45 +1386,151 @@ class SpareToolsOpenSSLConan(ConanFile):
 
         Supports:
         - Unix-like systems (Linux, macOS, FreeBSD) - uses make
-        - Windows systems - uses nmake (MSVC) or make (MinGW)
+        - Windows systems - uses jom or nmake (MSVC) or make (MinGW)
         """
         self.output.info("Building with Perl Configure (standard method)")
 
         configure_args = self._get_configure_args()
         configure_cmd = f"perl Configure {' '.join(configure_args)}"
         self.output.info(f"Configure command: {configure_cmd}")
-        self.run(configure_cmd, cwd=self.source_folder)
+        self._configure_if_changed(configure_cmd, os.path.join(self._build_tree, "Configure"))
+        if self._incremental_dir:
+            self._point_dirs_at_package()
 
         # Determine build tool based on OS and compiler
-        is_windows = str(self.settings.os) == "Windows"
-        is_msvc = is_windows and "msvc" in str(self.settings.compiler).lower()
-
-        if is_windows:
-            self.output.info("Windows build detected - using nmake")
-            # Windows with MSVC - uses nmake
-            build_cmd = "nmake"
-            test_cmd = "nmake test" if not is_msvc else "nmake test"
+        windows_make = self._windows_make
+
+        if windows_make:
+            self.output.info(f"MSVC build detected - using {windows_make}")
+            build_cmd = self._windows_make_command()
         else:
             # Unix-like systems - uses make with parallelization
-            try:
-                nproc_result = subprocess.run(['nproc'], capture_output=True, text=True)
-                nproc = nproc_result.stdout.strip() if nproc_result.returncode == 0 else '4'
-            except:
-                nproc = str(os.cpu_count() or 4)
-
-            build_cmd = f"make -j{nproc}"
-            test_cmd = "make test"
+            # (tools.build:jobs, else the build machine's CPU count)
+            build_cmd = f"make -j{self._make_jobs}"
 
         # Build
         self.output.info(f"Build command: {build_cmd}")
-        self.run(build_cmd, cwd=self.source_folder)
-
-        # Run tests (optional, don't fail if tests fail)
+        with self._span("make", command=build_cmd), self._msvc_parallel_pdb():
+            self.run(build_cmd, cwd=self._build_tree)
+    
+    @property
+    def _windows_make(self):
+        """
+        Make program for MSVC builds, None elsewhere: jom (default), which
+        runs nmake makefiles with parallel jobs and is pulled as a
+        tool_require, or plain serial nmake with user.sparetools:windows_make=nmake
+        """
+        if self.settings.os != "Windows" or self.settings.compiler != "msvc":
+            return None
+        tool = self.conf.get("user.sparetools:windows_make", default="jom", check_type=str)
+        if tool not in ("jom", "nmake"):
+            raise ConanException(f"user.sparetools:windows_make must be jom or nmake, not {tool}")
+        return tool
+    
+    def _windows_make_command(self, target=""):
+        """jom /J <jobs> [target] or nmake [target]"""
+        if self._windows_make == "jom":
+            jobs = self.conf.get("tools.build:jobs", check_type=int) or os.cpu_count() or 1
+            return f"jom /J {jobs} {target}".strip()
+        return f"nmake {target}".strip()
+    
+    @contextmanager
+    def _msvc_parallel_pdb(self):
+        """
+        Under jom, several cl.exe processes write the objects' shared PDB
+        (/Zi /Fd...) at once and fail with C1041 unless given /FS. cl reads
+        extra options from the CL environment variable, which leaves
+        Configure's CFLAGS untouched.
+        """
+        if self._windows_make != "jom":
+            yield
+            return
+        previous = os.environ.get("CL")
+        os.environ["CL"] = f"/FS {previous}" if previous else "/FS"
         try:
-            self.output.info(f"Test command: {test_cmd}")
-            self.run(test_cmd, cwd=self.source_folder, ignore_errors=True)
-        except Exception as e:
-            self.output.warning(f"Tests failed or unavailable: {e}")
+            yield
+        finally:
+            if previous is None:
+                os.environ.pop("CL", None)
+            else:
+                os.environ["CL"] = previous
+    
+    @property
+    def _universal_folder(self):
+        return os.path.join(self.build_folder, "universal")
+    
+    def _universal_tree(self, arch):
+        """Private copy of the sources one universal slice configures and builds in"""
+        return os.path.join(self._universal_folder, arch, "src")
+    
+    def _build_universal(self):
+        """
+        universal=True: build the _universal_slices in parallel, each in its
+        own copy of the sources with its own Configure target and tuning,
+        and install both with DESTDIR (the install names and OPENSSLDIR
+        still point at the package folder). The Mach-O files are then
+        lipo'd into universal/merged; every other installed file must be
+        identical across slices.
+        """
+        slices = list(self._universal_slices)
+        jobs = self.conf.get("tools.build:jobs", check_type=int) or os.cpu_count() or 1
+        slice_jobs = max(1, jobs // len(slices))
+        rmdir(self, self._universal_folder)
+        
+        def build_slice(arch):
+            target, tuning = self._universal_slices[arch]
+            tree = self._universal_tree(arch)
+            shutil.copytree(self.source_folder, tree, symlinks=True)
+            args = [target] + self._get_configure_args()[1:] + tuning
+            configure_cmd = f"perl Configure {' '.join(args)}"
+            self.output.info(f"Universal slice {arch}: {configure_cmd}")
+            with self._span(f"Configure ({arch})", command=configure_cmd):
+                self.run(configure_cmd, cwd=tree)
+            with self._span(f"make ({arch})", command=f"make -j{slice_jobs}"):
+                self.run(f"make -j{slice_jobs}", cwd=tree)
+                self.run(f'make install_sw install_ssldirs DESTDIR="{os.path.join(self._universal_folder, arch, "root")}"',
+                         cwd=tree)
+        
+        with ThreadPoolExecutor(max_workers=len(slices)) as pool:
+            for future in [pool.submit(build_slice, arch) for arch in slices]:
+                future.result()
+        
+        with self._span("lipo"):
+            self._lipo_slices(slices)
+    
+    @staticmethod
+    def _is_macho(path):
+        """Mach-O executable, library or fat file, or a static archive"""
+        with open(path, "rb") as f:
+            magic = f.read(8)
+        return magic[:4] in (b"\xcf\xfa\xed\xfe", b"\xce\xfa\xed\xfe", b"\xca\xfe\xba\xbe") \
+            or magic == b"!<arch>\n"
+    
+    def _lipo_slices(self, slices):
+        """Merge the slices' installed trees into universal/merged"""
+        roots = [os.path.join(self._universal_folder, arch, "root") for arch in slices]
+        merged = os.path.join(self._universal_folder, "merged")
+        shutil.copytree(roots[0], merged, symlinks=True)
+        combined, differing = 0, []
+        for dirpath, _, filenames in os.walk(roots[0]):
+            for name in filenames:
+                first = os.path.join(dirpath, name)
+                rel = os.path.relpath(first, roots[0])
+                others = [os.path.join(root, rel) for root in roots[1:]]
+                if os.path.islink(first):
+                    continue
+                missing = [o for o in others if not os.path.exists(o)]
+                if missing:
+                    differing.append(rel)
+                elif self._is_macho(first):
+                    inputs = " ".join(f'"{p}"' for p in [first] + others)
+                    self.run(f'lipo -create {inputs} -output "{os.path.join(merged, rel)}"')
+                    combined += 1
+                elif any(not filecmp.cmp(first, o, shallow=False) for o in others):
+                    differing.append(rel)
+        if differing:
+            raise ConanException(f"universal: slices installed different files: {', '.join(sorted(differing))}")
+        self.output.info(f"Universal: lipo'd {combined} Mach-O files ({' + '.join(slices)})")
     
     def _build_with_cmake(self):
         """CMake build (if OpenSSL supports it, otherwise fallback)"""
@@ -262,11 +1539,16 @@ class SpareToolsOpenSSLConan(ConanFile):
         cmake_dir = os.path.join(self.source_folder, "cmake")
         if os.path.exists(cmake_dir):
             cmake = CMake(self)
-            cmake.configure()
-            cmake.build()
-            cmake.test()
+            with self._span("Configure"):
+                cmake.configure()
+            with self._span("make"):
+                # make/ninja take the last -j: the remote pool's width with recc
+                remote = self._compiler_cache == "recc"
+                cmake.build(build_tool_args=[f"-j{self._make_jobs}"] if remote else None)
         else:
             self.output.warn("CMake not supported by this OpenSSL version, falling back to Perl Configure")
+            if self.options.unity_build:
+                self.output.warning("unity_build has no effect on the Perl Configure fallback")
             self._build_with_perl()
     
     def _build_with_autotools(self):
@@ -275,15 +1557,17 @@ class SpareToolsOpenSSLConan(ConanFile):
         
         autotools = Autotools(self)
         configure_args = self._get_configure_args()
-        autotools.configure(args=configure_args)
-        autotools.make()
-        autotools.make(args=["test"], ignore_errors=True)
+        with self._span("Configure"):
+            autotools.configure(args=configure_args)
+        with self._span("make"):
+            # An explicit -j replaces the tools.build:jobs one
+            autotools.make(args=[f"-j{self._make_jobs}"] if self._compiler_cache == "recc" else None)
     
     def _build_with_python(self):
         """Python configure.py build (hybrid approach)"""
         self.output.info("Building with Python configure.py (hybrid method)")
         
-        configure_py = os.path.join(self.source_folder, "configure.py")
+        configure_py = os.path.join(self._build_tree, "configure.py")
         if not os.path.exists(configure_py):
             self.output.warn("configure.py not found, falling back to Perl Configure")
             self._build_with_perl()
@@ -292,18 +1576,249 @@ class SpareToolsOpenSSLConan(ConanFile):
         # Stage 1: Python configure
         self.output.info("Stage 1: Python configure.py")
         configure_args = self._get_configure_args()
-        python_args = " ".join(configure_args[1:])  # Skip target, configure.py handles it
-        self.run(f"python3 {configure_py} {python_args}", cwd=self.source_folder)
+        # Skip target, configure.py detects it; cross builds keep it
+        python_args = " ".join(configure_args if cross_building(self) else configure_args[1:])
+        # Profiles asking for the Ninja CMake generator get build.ninja here too
+        use_ninja = (self.conf.get("tools.cmake.cmaketoolchain:generator", check_type=str) == "Ninja"
+                     and shutil.which("ninja") is not None)
+        if use_ninja:
+            python_args += " --generator=ninja"
+        if self.options.unity_build:
+            python_args += f" --unity-batch-size={self._unity_batch_size}"
+        self._configure_if_changed(f"python3 {configure_py} {python_args}", configure_py)
+        if self._incremental_dir:
+            self._point_dirs_at_package()
         
         # Stage 2: Build
         self.output.info("Stage 2: Build")
+        jobs = self._make_jobs
+        build_cmd = f"ninja -j{jobs}" if use_ninja else f"make -j{jobs}"
+        with self._span("make", command=build_cmd):
+            self.run(build_cmd, cwd=self._build_tree)
+    
+    @property
+    def _trace_file(self):
+        """
+        Chrome trace written when user.sparetools:build_trace is set: True
+        for <build>/build-trace.json, or an explicit path
+        """
+        value = self.conf.get("user.sparetools:build_trace")
+        if value in (None, False, "", "False", "false", "0"):
+            return None
+        if value in (True, "True", "true", "1"):
+            return os.path.join(self.build_folder, "build-trace.json")
+        return os.path.abspath(os.path.expanduser(str(value)))
+    
+    def _build_trace(self):
+        """build_trace.BuildTrace for this build, None when tracing is off"""
+        if getattr(self, "_trace", None) is None and self._trace_file:
+            module = self._tools_module("development/build_system", "build_trace")
+            self._trace = module.BuildTrace(self._trace_file, f"{self.name}/{self.version}")
+            source_time = os.path.join(self.source_folder, ".sparetools-source-time.json")
+            if os.path.exists(source_time):
+                timing = json.loads(load(self, source_time))
+                if timing.get("pid") == os.getpid():
+                    self._trace.add("source", timing["ts"], timing["dur"], "conan")
+        return getattr(self, "_trace", None)
+    
+    @contextmanager
+    def _span(self, name, **args):
+        """
+        Time the with-block as one build trace event and, when the build
+        runs inside a trace (TRACEPARENT from ConanOrchestrator, or an
+        OpenTelemetry/span-file setup), as one span of it (no-op otherwise)
+        """
+        with self._otel_span(name, **args):
+            trace = self._build_trace()
+            if trace is None:
+                yield args
+                return
+            with trace.span(name, "conan", **args) as span_args:
+                yield span_args
+    
+    def _otel_span(self, name, **args):
+        """sparetools_tracing.span for a recipe step, a null context when nothing is traced"""
+        if not any(os.environ.get(v) for v in ("TRACEPARENT", "OTEL_EXPORTER_OTLP_ENDPOINT",
+                                               "OPENSSL_TOOLS_SPAN_FILE")):
+            return nullcontext()
+        if getattr(self, "_tracing", None) is None:
+            try:
+                self._tracing = self._base_module("sparetools_tracing.py", "sparetools_tracing")
+            except (ImportError, OSError) as e:
+                self.output.warning(f"Tracing unavailable: {e}")
+                self._tracing = False
+        if not self._tracing:
+            return nullcontext()
+        return self._tracing.span(f"{self.name} {name}", package=f"{self.name}/{self.version}", **args)
+    
+    def _save_build_trace(self, since_us=0):
+        """Write the trace, merging Clang -ftime-trace files newer than since_us"""
+        trace = self._build_trace()
+        if trace is None:
+            return
+        if "clang" in str(self.settings.compiler) and since_us:
+            trace.merge_clang_time_traces(self._test_tree, since_us=since_us)
+        self.output.info(f"Build trace: {trace.save()} (open in ui.perfetto.dev or chrome://tracing)")
+    
+    @property
+    def _unity_batch_size(self):
+        """Sources per unity unit, user.sparetools:unity_batch_size (default 16)"""
+        return self.conf.get("user.sparetools:unity_batch_size", default=16, check_type=int)
+    
+    @property
+    def _test_tree(self):
+        """Tree holding the OpenSSL Makefile that `make test` runs in"""
+        if self.options.build_method == "autotools":
+            return self.build_folder
+        return self._build_tree
+    
+    @property
+    def _native_cmake(self):
+        """build_method=cmake on a release with CMake support (otherwise it falls back to perl)"""
+        return self.options.build_method == "cmake" and os.path.exists(os.path.join(self.source_folder, "cmake"))
+    
+    @property
+    def _library_dirs(self):
+        """
+        Where the build method leaves libcrypto/libssl: the CMake binary
+        dir, the autotools build folder, or the Configure tree
+        """
+        if self._native_cmake:
+            return [self.build_folder, os.path.join(self.build_folder, "lib")]
+        if self.options.build_method == "autotools":
+            return [self.build_folder]
+        return [self._build_tree]
+    
+    @property
+    def _library_dir(self):
+        """First of _library_dirs holding libcrypto (the first one before the build)"""
+        for folder in self._library_dirs:
+            if os.path.isdir(folder) and any(name.startswith("libcrypto.") for name in os.listdir(folder)):
+                return folder
+        return self._library_dirs[0]
+    
+    def _test_cache_path(self):
+        """
+        Cached results for this package ID and tier, or None when caching is
+        off. user.sparetools:test_cache_dir defaults to ~/.sparetools/test-results.
+        """
+        root = self.conf.get("user.sparetools:test_cache_dir", check_type=str,
+                             default=os.path.join("~", ".sparetools", "test-results"))
+        if not root:
+            return None
+        return os.path.join(os.path.expanduser(root), f"{self.info.package_id()}-{self.options.run_tests}.json")
+    
+    def _tested_binaries_digest(self):
+        """sha256 over the libraries and openssl app the tests exercise"""
+        tree = self._test_tree
+        digest = hashlib.sha256()
+        for name in sorted(os.listdir(tree)):
+            if name.startswith(("libcrypto", "libssl")) and not os.path.islink(os.path.join(tree, name)):
+                digest.update(name.encode())
+                with open(os.path.join(tree, name), "rb") as f:
+                    for chunk in iter(lambda: f.read(1 << 20), b""):
+                        digest.update(chunk)
+        for app in ["openssl", "openssl.exe"]:
+            path = os.path.join(tree, "apps", app)
+            if os.path.exists(path):
+                with open(path, "rb") as f:
+                    digest.update(f.read())
+        return digest.hexdigest()
+    
+    def _run_tests(self):
+        """
+        OpenSSL test suite for run_tests=fast|full, as a phase of its own.
+
+        Recipes run in parallel (HARNESS_JOBS); `fast` restricts them with
+        TESTS= to openssl_test_runner.FAST_TESTS or the space-separated
+        user.sparetools:fast_tests. Output is parsed into a JUnit report in
+        <build>/test-results. A passing run is cached per package ID and
+        tier together with a digest of the tested binaries, so rebuilding an
+        unchanged package skips the suite. Failing tests fail the build.
+        """
+        tier = str(self.options.run_tests)
+        if tier == "off" or self.conf.get("tools.build:skip_test", check_type=bool):
+            return
+        # user.sparetools:defer_tests: bundle for sharded test jobs (test_sharding) even natively
+        if not can_run(self) or self.conf.get("user.sparetools:defer_tests", check_type=bool):
+            self._defer_tests(tier)
+            return
+        if self._native_cmake:
+            CMake(self).test()
+            return
+        
+        runner = self._tools_module("testing", "openssl_test_runner")
+        results_dir = os.path.join(self.build_folder, "test-results")
+        cache_path = self._test_cache_path()
+        binaries = self._tested_binaries_digest()
+        if cache_path and os.path.exists(cache_path):
+            cached = json.loads(load(self, cache_path))
+            if cached.get("binaries") == binaries:
+                junit = runner.write_junit_report(cached["results"], results_dir, f"openssl make test ({tier}, cached)")
+                self.output.info(f"Tests ({tier}): unchanged binaries, reusing {len(cached['results'])} "
+                                 f"cached results, JUnit {junit}")
+                return
+        
+        jobs = self.conf.get("tools.build:jobs", check_type=int) or os.cpu_count() or 1
+        cmd = self._windows_make_command("test") if self._windows_make else "make test"
+        if tier == "fast":
+            tests = self.conf.get("user.sparetools:fast_tests", check_type=str) or " ".join(runner.FAST_TESTS)
+            cmd += f' TESTS="{tests}"'
+        self.output.info(f"Tests ({tier}): {cmd} with HARNESS_JOBS={jobs}")
+        
+        log_file = os.path.join(results_dir, "make-test.log")
+        os.makedirs(results_dir, exist_ok=True)
+        previous = os.environ.get("HARNESS_JOBS")
+        os.environ["HARNESS_JOBS"] = str(jobs)
         try:
-            nproc = str(subprocess.run(['nproc'], capture_output=True, text=True).stdout.strip() or '4')
-        except:
-            nproc = str(os.cpu_count() or 4)
+            with open(log_file, "w") as log, self._msvc_parallel_pdb():
+                returncode = self.run(cmd, cwd=self._test_tree, stdout=log, stderr=log, ignore_errors=True)
+        finally:
+            if previous is None:
+                os.environ.pop("HARNESS_JOBS", None)
+            else:
+                os.environ["HARNESS_JOBS"] = previous
         
-        self.run(f"make -j{nproc}", cwd=self.source_folder)
-        self.run("make test", cwd=self.source_folder, ignore_errors=True)
+        results = runner.parse_make_test_output(load(self, log_file))
+        junit = runner.write_junit_report(results, results_dir, f"openssl make test ({tier})",
+                                          error=f"{cmd} exited with {returncode}, see {log_file}")
+        failed = [r["name"] for r in results if r["result"] == "FAIL"]
+        passed = sum(1 for r in results if r["result"] == "PASS")
+        self.output.info(f"Tests ({tier}): {passed} passed, {len(failed)} failed, "
+                         f"{len(results) - passed - len(failed)} skipped, JUnit {junit}")
+        if failed or returncode or not results:
+            raise ConanException(f"OpenSSL tests failed ({', '.join(failed) or f'exit code {returncode}'}), "
+                                 f"see {log_file}")
+        if cache_path:
+            save(self, cache_path, json.dumps({"binaries": binaries, "results": results}, indent=2))
+    
+    def _defer_tests(self, tier):
+        """
+        Cross builds: bundle the built test tree for a native runner of the
+        host arch instead of running it here (`openssl-tools deferred-tests`
+        runs it there, without a toolchain). Written as <package id>-<tier>
+        .tar.gz/.json to user.sparetools:deferred_tests_dir, default
+        <build>/deferred-tests, for CI to hand to that runner. Native builds
+        with user.sparetools:defer_tests do the same, so CI can run the suite
+        as parallel TESTS= shards on the one build.
+        """
+        if self.options.build_method == "cmake":
+            self.output.warning(f"Tests ({tier}): cannot run on the build machine, and the CMake "
+                                "build has no Configure test tree to defer; skipped")
+            return
+        deferred = self._tools_module("testing", "deferred_tests")
+        tests = None
+        if tier == "fast":
+            runner = self._tools_module("testing", "openssl_test_runner")
+            tests = (self.conf.get("user.sparetools:fast_tests", check_type=str) or " ".join(runner.FAST_TESTS)).split()
+        dest = self.conf.get("user.sparetools:deferred_tests_dir", check_type=str,
+                             default=os.path.join(self.build_folder, "deferred-tests"))
+        manifest = {"reference": f"{self.name}/{self.version}", "package_id": self.info.package_id(),
+                    "os": str(self.settings.os), "arch": str(self.settings.arch), "tier": tier, "tests": tests}
+        with self._span("defer tests", tier=tier):
+            bundle = deferred.write_bundle(self._test_tree, dest, f"{self.info.package_id()}-{tier}", manifest)
+        reason = "deferred" if can_run(self) else f"{self.settings.arch} binaries cannot run here, deferred"
+        self.output.info(f"Tests ({tier}): {reason} to {bundle} (openssl-tools deferred-tests on a native runner)")
     
     def build(self):
         """Build OpenSSL using selected method"""
@@ -317,46 +1832,931 @@ class SpareToolsOpenSSLConan(ConanFile):
         }
         
         build_func = build_methods.get(str(self.options.build_method))
-        if build_func:
+        if not build_func:
+            raise ValueError(f"Unknown build method: {self.options.build_method}")
+        if self.options.get_safe("universal"):
+            build_func = self._build_universal
+        
+        # Before the incremental sync, which then picks up the patched files
+        if self.options.lock_profiling:
+            self._apply_lock_profiling()
+        if self.options.usdt_probes:
+            self._apply_usdt_probes()
+        
+        if self.conf.get("user.sparetools:incremental_build_dir", check_type=str):
+            if self._incremental_dir:
+                self._sync_incremental_tree()
+            else:
+                self.output.warning("incremental_build_dir needs build_method=perl/python without "
+                                    "pgo/bolt, doing a clean build")
+        
+        self._setup_compiler_cache()
+        if self.options.get_safe("libc") == "musl":
+            self._check_musl_compiler()
+        
+        build_start = time.time_ns() // 1000
+        # Digest of the pristine sources, before in-tree builds add objects
+        self._prepare_security_gates()
+        try:
+            if self.options.pgo == "use" and not self._has_pgo_profiles():
+                with self._span("pgo training"):
+                    self._build_pgo_training(build_func)
+            with self._span(f"build ({self.options.build_method})"):
+                build_func()
+            
+            self._report_compiler_cache()
+            
+            # Scans overlap with BOLT, tests and helpers; package() gates on them
+            with self._span("security gates (start)"):
+                self._start_security_gates()
+            
+            # Post-link layout optimization of the shared libraries
+            if self.options.bolt:
+                with self._span("bolt"):
+                    self._run_bolt()
+            
+            # Test the final libraries, after BOLT has rewritten them
+            with self._span("test", tier=str(self.options.run_tests)):
+                self._run_tests()
+            
+            # SpareTools helper libraries (built against the configured tree)
+            with self._span("helpers"):
+                self._build_helpers()
+            
+            # Needs the allocator shim from the helpers
+            if self.options.get_safe("libc") == "musl":
+                with self._span("static cli"):
+                    self._link_static_cli()
+            
+            if self.options.fuzzing != "off":
+                with self._span("fuzz throughput"):
+                    self._benchmark_fuzz_targets()
+            
+            if self.options.get_safe("qat_provider", "off") != "off":
+                with self._span("qat provider"):
+                    self._build_qat_provider()
+        finally:
+            self._save_build_trace(build_start)
+    
+    @property
+    def _fuzz_targets(self):
+        """Fuzz binaries Configure's enable-fuzz-* built into fuzz/ (not the *-test replay drivers)"""
+        fuzz_dir = os.path.join(self._build_tree, "fuzz")
+        if not os.path.isdir(fuzz_dir):
+            return []
+        return sorted(name for name in os.listdir(fuzz_dir)
+                      if os.path.isfile(os.path.join(fuzz_dir, name)) and "." not in name
+                      and not name.endswith("-test") and os.access(os.path.join(fuzz_dir, name), os.X_OK))
+    
+    def _benchmark_fuzz_targets(self):
+        """
+        Quick exec/s run of every fuzz target over its corpus from
+        fuzz/corpora (user.sparetools:fuzz_benchmark_seconds each, default
+        5, 0 skips), so instrumented builds of different compilers can be
+        compared. package() ships the numbers in bin/fuzz/fuzz-targets.json.
+        """
+        seconds = self.conf.get("user.sparetools:fuzz_benchmark_seconds", default=5, check_type=int)
+        self._fuzz_throughput = {}
+        if not seconds or cross_building(self) or self.conf.get("tools.build:skip_test", check_type=bool):
+            return
+        campaign = self._tools_module("testing", "fuzz_campaign")
+        fuzz_dir = os.path.join(self._build_tree, "fuzz")
+        for target in self._fuzz_targets:
+            corpus = os.path.join(self._build_tree, "fuzz", "corpora", target)
+            try:
+                stats = campaign.benchmark_target(os.path.join(fuzz_dir, target), str(self.options.fuzzing),
+                                                  seconds, corpus if os.path.isdir(corpus) else None)
+            except (OSError, subprocess.SubprocessError) as e:
+                self.output.warning(f"fuzz throughput: {target} failed ({e})")
+                continue
+            self._fuzz_throughput[target] = stats
+            self.output.info(f"fuzz throughput: {target} {stats.get('execs_per_sec', 0)} exec/s")
+    
+    def _package_fuzz_targets(self):
+        """fuzz component: the fuzz binaries in bin/fuzz plus fuzz-targets.json describing the build"""
+        targets = self._fuzz_targets
+        fuzz_dir = os.path.join(self.package_folder, "bin", "fuzz")
+        for target in targets:
+            copy(self, target, src=os.path.join(self._build_tree, "fuzz"), dst=fuzz_dir)
+        save(self, os.path.join(fuzz_dir, "fuzz-targets.json"), json.dumps({
+            "engine": str(self.options.fuzzing),
+            "compiler": f"{self.settings.compiler} {self.settings.get_safe('compiler.version')}",
+            "openssl_version": str(self.version),
+            "targets": targets,
+            "throughput": getattr(self, "_fuzz_throughput", {}),
+        }, indent=2))
+        self.output.info(f"Packaged {len(targets)} fuzz targets in bin/fuzz")
+    
+    @property
+    def _qat_folder(self):
+        return os.path.join(self.build_folder, "qat")
+    
+    def _build_qat_provider(self):
+        """
+        qat_provider: build Intel's QAT_Engine in provider mode
+        (qatprovider.so) against this build's libcrypto. QAT_Engine's
+        configure wants an installed OpenSSL, so the tree is staged with
+        make install_sw DESTDIR=qat/stage first. The source is
+        user.sparetools:qat_engine_source, checked against
+        user.sparetools:qat_engine_sha256.
+
+        hw offloads to QAT devices through qatlib (libqat, libusdm from the
+        system) or the out-of-tree driver at user.sparetools:qat_hw_dir; sw
+        runs the AVX-512 multi-buffer code of ipp-crypto (crypto_mb) and
+        intel-ipsec-mb, from the system prefixes or
+        user.sparetools:qat_crypto_mb_dir and qat_ipsec_mb_dir; hw_sw
+        builds both, the provider prefers the hardware.
+        """
+        qat = str(self.options.qat_provider)
+        stage = os.path.join(self._qat_folder, "stage")
+        rmdir(self, stage)
+        self.run(f'make install_sw DESTDIR="{stage}"', cwd=self._build_tree)
+        src = os.path.join(self._qat_folder, "src")
+        get(self, self.conf.get("user.sparetools:qat_engine_source", check_type=str),
+            sha256=self.conf.get("user.sparetools:qat_engine_sha256", check_type=str),
+            destination=src, strip_root=True)
+        
+        args = ["--enable-qat_provider", f'--with-openssl_install_dir="{stage + self._install_prefix}"']
+        if qat == "sw":
+            args.append("--disable-qat_hw")
+        hw_dir = self.conf.get("user.sparetools:qat_hw_dir", check_type=str)
+        if qat != "sw" and hw_dir:
+            args.append(f'--with-qat_hw_dir="{hw_dir}"')
+        if qat != "hw":
+            args.append("--enable-qat_sw")
+            for conf, flag in (("qat_crypto_mb_dir", "qat_sw_crypto_mb_install_dir"),
+                               ("qat_ipsec_mb_dir", "qat_sw_ipsec_mb_install_dir")):
+                value = self.conf.get(f"user.sparetools:{conf}", check_type=str)
+                if value:
+                    args.append(f'--with-{flag}="{value}"')
+        self.output.info(f"QAT provider ({qat}): ./configure {' '.join(args)}")
+        self.run("./autogen.sh", cwd=src)
+        self.run(f"./configure {' '.join(args)}", cwd=src)
+        self.run(f"make -j{self._make_jobs}", cwd=src)
+    
+    def _package_qat_provider(self):
+        """
+        qat component: qatprovider.so next to the built-in modules in
+        <libdir>/ossl-modules, and ssl/openssl-qat.cnf from
+        CryptoConfigManager.generate_provider_config, which activates
+        qatprovider and default and fetches with ?provider=qatprovider, so
+        what QAT does not implement falls back to default. The module is
+        taken from the libtool output: QAT_Engine's make install writes into
+        the staged prefix and, for hw, the system driver configuration.
+        """
+        libdir = "lib64" if os.path.isdir(os.path.join(self.package_folder, "lib64")) else "lib"
+        if not copy(self, "qatprovider.so", src=os.path.join(self._qat_folder, "src", ".libs"),
+                    dst=os.path.join(self.package_folder, libdir, "ossl-modules")):
+            raise ConanException("qat_provider: QAT_Engine did not build qatprovider.so")
+        crypto_config = self._tools_module("openssl", "crypto_config")
+        manager = crypto_config.CryptoConfigManager(os.path.join(self._qat_folder, "crypto.conf"))
+        manager.enable_accelerator(crypto_config.AcceleratorSettings(provider="qatprovider"))
+        manager.generate_provider_config(os.path.join(self.package_folder, "ssl", "openssl-qat.cnf"))
+    
+    def _apply_lock_profiling(self):
+        """
+        lock_profiling=True: instrument the CRYPTO_THREAD locks.
+
+        crypto/threads_pthread.c includes patches/sparetools_lockprof.h first
+        (its pthread lock calls then count acquisitions, contended
+        acquisitions and wait time per lock creation site) and
+        sparetools_lockprof_end.h last. OPENSSL_cleanup in crypto/init.c
+        dumps the counters before tearing the library down.
+        """
+        crypto = os.path.join(self.source_folder, "crypto")
+        patches = os.path.join(self.source_folder, "patches")
+        copy(self, "sparetools_lockprof*.h", patches, crypto)
+        threads = os.path.join(crypto, "threads_pthread.c")
+        content = load(self, threads)
+        if "sparetools_lockprof.h" not in content:
+            save(self, threads, f'#include "sparetools_lockprof.h"\n{content}\n'
+                                f'#include "sparetools_lockprof_end.h"\n')
+        replace_in_file(self, os.path.join(crypto, "init.c"),
+                        "void OPENSSL_cleanup(void)\n{",
+                        "void sparetools_lockprof_dump(void);\n"
+                        "static void sparetools_openssl_cleanup(void);\n\n"
+                        "void OPENSSL_cleanup(void)\n{\n"
+                        "    sparetools_lockprof_dump();\n"
+                        "    sparetools_openssl_cleanup();\n}\n\n"
+                        "static void sparetools_openssl_cleanup(void)\n{")
+        self.output.info("lock_profiling: instrumented crypto/threads_pthread.c "
+                         "(profile written by OPENSSL_cleanup, SPARETOOLS_LOCKPROF=<path>)")
+    
+    def _wrap_function(self, path, name, body):
+        """
+        Rename the definition of name in path to sparetools_usdt_orig_<name>
+        and put a wrapper with the original signature in front of it. The
+        signature is parsed from the source, so parameter lists that differ
+        between releases need no per-version patch.
+        """
+        content = load(self, path)
+        pattern = re.compile(r"^((?:static\s+)?[A-Za-z_][\w \t\*]*?)\b" + re.escape(name)
+                             + r"\(([^)]*)\)[ \t]*\n\{", re.M)
+        matches = list(pattern.finditer(content))
+        if len(matches) != 1:
+            raise ConanException(f"usdt_probes: expected one definition of {name} in {path}, "
+                                 f"found {len(matches)}")
+        m = matches[0]
+        rtype, params = m.group(1), m.group(2)
+        names = [] if params.strip() in ("", "void") else \
+            [re.findall(r"\w+", p.split("[")[0])[-1] for p in params.split(",")]
+        orig = f"sparetools_usdt_orig_{name}"
+        base_type = re.sub(r"^static\s+", "", rtype)
+        fields = {n: n for n in names}
+        fields.update(orig=orig, args=", ".join(names), p0=names[0] if names else "",
+                      ret_decl=f"{base_type.rstrip()}{'' if base_type.rstrip().endswith('*') else ' '}ret")
+        try:
+            wrapper_body = body.format(**fields)
+        except KeyError as e:
+            raise ConanException(f"usdt_probes: {name} in {path} has no parameter {e}")
+        wrapper = (f"static {base_type}{orig}({params});\n\n"
+                   f"{rtype}{name}({params})\n{{\n{wrapper_body}}}\n\n"
+                   f"static {base_type}{orig}({params})\n{{")
+        save(self, path, content[:m.start()] + wrapper + content[m.end():])
+    
+    def _apply_usdt_probes(self):
+        """
+        usdt_probes=True: SystemTap-style USDT probes (provider "sparetools")
+        at handshake start/finish, record encrypt/decrypt, method store
+        misses and provider initialization; see patches/sparetools_usdt.h.
+        Each instrumented function is wrapped in its own source file, which
+        includes the probe header first.
+        """
+        probe = subprocess.run([self._c_compiler, "-fsyntax-only", "-x", "c", "-"],
+                               input="#include <sys/sdt.h>\n", capture_output=True, text=True)
+        if probe.returncode != 0:
+            raise ConanException("usdt_probes requires <sys/sdt.h> "
+                                 "(systemtap-sdt-dev / systemtap-sdt-devel)")
+        version = Version(self.version)
+        header = os.path.join(self.source_folder, "patches", "sparetools_usdt.h")
+        for low, high, rel, name, body in self._usdt_probes:
+            if version < low or (high is not None and version >= high):
+                continue
+            path = os.path.join(self.source_folder, *rel.split("/"))
+            self._wrap_function(path, name, body or self._usdt_record_body)
+            shutil.copy2(header, os.path.dirname(path))
+            content = load(self, path)
+            if not content.startswith('#include "sparetools_usdt.h"'):
+                save(self, path, f'#include "sparetools_usdt.h"\n{content}')
+            self.output.info(f"usdt_probes: wrapped {name} ({rel})")
+    
+    def _has_pgo_profiles(self):
+        """True if profile data for pgo=use already exists (fleet training)"""
+        profile_dir = self._pgo_profile_dir
+        if self._pgo_is_clang:
+            return os.path.exists(os.path.join(profile_dir, "openssl.profdata"))
+        return os.path.isdir(profile_dir) and any(
+            f.endswith(".gcda") for _, _, files in os.walk(profile_dir) for f in files)
+    
+    def _build_pgo_training(self, build_func):
+        """
+        PGO stage 1: instrumented build, training run, profile merge.
+
+        The EVP and handshake benchmarks from test_package are the training
+        workload. The tree is cleaned afterwards so build_func() can
+        reconfigure with -fprofile-use / -fprofile-instr-use.
+        """
+        self.output.info("PGO stage 1: instrumented build")
+        self._pgo_stage_override = "generate"
+        try:
             build_func()
+            self._run_training_workload(self._get_pgo_flags())
+        finally:
+            self._pgo_stage_override = None
+        
+        if self._pgo_is_clang:
+            profile_dir = self._pgo_profile_dir
+            self.run(f'llvm-profdata merge -output="{profile_dir}/openssl.profdata" '
+                     f'"{profile_dir}"/*.profraw')
+        
+        self.output.info("PGO stage 2: rebuilding with profile data")
+        if self._native_cmake:
+            CMake(self).build(target="clean")
         else:
-            raise ValueError(f"Unknown build method: {self.options.build_method}")
+            self.run("make clean", cwd=self._test_tree)
+    
+    def _run_training_workload(self, flags, wrapper=""):
+        """
+        Build bench_evp/bench_handshake against the in-tree libraries and run
+        them, optionally under a wrapper command (e.g. perf record); "{bench}"
+        in the wrapper is replaced with the benchmark name.
+        """
+        training_folder = self._training_folder
+        joined = " ".join(flags)
+        self._cmake_helpers(training_folder, [
+            "-DSPARETOOLS_BUILD_TRAINING=ON",
+            f'-DSPARETOOLS_BENCH_SOURCE_DIR="{self._cmake_path(os.path.join(self.source_folder, "test_package"))}"',
+            f'-DSPARETOOLS_OPENSSL_LIB_DIR="{self._cmake_path(self._library_dir)}"',
+            f'-DCMAKE_C_FLAGS="{joined}"',
+            f'-DCMAKE_EXE_LINKER_FLAGS="{joined}"',
+        ])
         
-        # Run security gates if available
-        self._run_security_gates()
+        lib_path_var = "DYLD_LIBRARY_PATH" if self.settings.os == "Macos" else "LD_LIBRARY_PATH"
+        for bench in ["bench_evp", "bench_handshake"]:
+            bench_bin = os.path.join(training_folder, bench)
+            self.output.info(f"Training workload: {bench}")
+            self.run(f'{lib_path_var}="{self._library_dir}" {wrapper.format(bench=bench)} "{bench_bin}" '
+                     f'--json "{training_folder}/{bench}.json"', cwd=training_folder)
+    
+    @property
+    def _training_folder(self):
+        return os.path.join(self.build_folder, "sparetools-training")
     
-    def _run_security_gates(self):
-        """Run security scanning and SBOM generation"""
+    def _shared_libraries(self):
+        """Real (non-symlink) libcrypto/libssl shared objects where the build method left them"""
+        libs = []
+        for folder in self._library_dirs:
+            if not os.path.isdir(folder):
+                continue
+            for name in sorted(os.listdir(folder)):
+                path = os.path.join(folder, name)
+                if name.startswith(("libcrypto.so.", "libssl.so.")) and not os.path.islink(path):
+                    libs.append(path)
+            if libs:
+                break
+        return libs
+    
+    def _perf_has_lbr(self):
+        """True if perf can sample taken branches (Intel LBR / AMD BRS)"""
         try:
-            base = self.python_requires["sparetools-base"]
-            if hasattr(base.conanfile, "run_trivy_scan"):
-                self.output.info("Running Trivy security scan...")
-                base.conanfile.run_trivy_scan(self.source_folder)
-            
-            if hasattr(base.conanfile, "generate_sbom"):
-                self.output.info("Generating SBOM...")
-                base.conanfile.generate_sbom(self.source_folder)
+            result = subprocess.run(["perf", "record", "-e", "cycles:u", "-j", "any,u",
+                                     "-o", os.devnull, "--", "true"], capture_output=True)
+        except OSError:
+            return False
+        return result.returncode == 0
+    
+    def _run_bolt(self):
+        """
+        Profile the benchmarks with perf and re-layout libcrypto/libssl with
+        llvm-bolt (hot/cold splitting, function reordering). Without LBR the
+        profile is sampled-IP only (perf2bolt -nl), which still helps
+        function ordering but not block layout.
+        """
+        libs = self._shared_libraries()
+        if not libs:
+            raise ConanException(f"bolt: no shared libcrypto/libssl in {', '.join(self._library_dirs)} "
+                                 f"(build_method={self.options.build_method})")
+        
+        with_lbr = self._perf_has_lbr()
+        self.output.info(f"BOLT: recording perf profile ({'LBR' if with_lbr else 'no LBR'})")
+        branch_flags = "-j any,u" if with_lbr else ""
+        training_folder = self._training_folder
+        self._run_training_workload(
+            [], wrapper=f'perf record -e cycles:u {branch_flags} -o "{training_folder}/perf-{{bench}}.data" --')
+        
+        for lib in libs:
+            name = os.path.basename(lib)
+            fdata = os.path.join(training_folder, f"{name}.fdata")
+            self.output.info(f"BOLT: optimizing {name}")
+            parts = []
+            for bench in ["bench_evp", "bench_handshake"]:
+                part = os.path.join(training_folder, f"{name}-{bench}.fdata")
+                self.run(f'perf2bolt {"" if with_lbr else "-nl"} '
+                         f'-p "{training_folder}/perf-{bench}.data" -o "{part}" "{lib}"')
+                parts.append(f'"{part}"')
+            self.run(f'merge-fdata {" ".join(parts)} > "{fdata}"')
+            self.run(f'llvm-bolt "{lib}" -o "{lib}.bolt" -data="{fdata}" '
+                     f'-reorder-blocks=ext-tsp -reorder-functions=hfsort '
+                     f'-split-functions -split-all-cold -icf=1 -use-gnu-stack -dyno-stats')
+            os.replace(f"{lib}.bolt", lib)
+    
+    def _check_musl_compiler(self):
+        """libc=musl: the C compiler must target musl (musl-gcc, *-linux-musl-gcc)"""
+        try:
+            machine = subprocess.run([self._c_compiler.split()[-1], "-dumpmachine"],
+                                     capture_output=True, text=True).stdout.strip()
+        except OSError:
+            machine = ""
+        if "musl" not in machine:
+            raise ConanException(
+                f"libc=musl needs a musl toolchain, {self._c_compiler} targets {machine or 'nothing'}; "
+                'set tools.build:compiler_executables={"c": "musl-gcc"} (profiles/features/static-musl)')
+    
+    def _link_static_cli(self):
+        """
+        libc=musl: relink apps/openssl with -static and, for allocator !=
+        system, the CRYPTO_set_mem_functions shim and its allocator, so the
+        CLI allocates through mimalloc/jemalloc instead of musl's malloc.
+        EX_LIBS is the Makefile's (empty) user library variable and comes
+        last on the link line; Configure's own -static would also drop
+        threads.
+        """
+        ex_libs = ["-static"]
+        allocator = str(self.options.allocator)
+        if allocator != "system":
+            shim = os.path.join(self._helpers_build_folder, "libsparetools_allocator.a")
+            if not os.path.exists(shim):
+                raise ConanException(f"libc=musl: {shim} was not built, cannot link allocator={allocator}")
+            dep = self.dependencies[self._allocator_requires[allocator].split("/")[0]]
+            dep = dep.cpp_info.aggregated_components()
+            ex_libs += [self._link_anchor("sparetools_allocator_install"), shim]
+            ex_libs += [f"-L{d}" for d in dep.libdirs]
+            ex_libs += [f"-l{lib}" for lib in dep.libs + dep.system_libs]
+        app = os.path.join(self._build_tree, "apps", "openssl")
+        if os.path.exists(app):
+            os.remove(app)
+        self.output.info(f"Linking static apps/openssl: {' '.join(ex_libs)}")
+        self.run(f'make apps/openssl EX_LIBS="{" ".join(ex_libs)}"', cwd=self._build_tree)
+    
+    @property
+    def _helpers_build_folder(self):
+        return os.path.join(self.build_folder, "sparetools-helpers")
+    
+    @staticmethod
+    def _cmake_path(path):
+        return path.replace("\\", "/")
+    
+    def _cmake_helpers(self, build_folder, extra_args=None):
+        """Configure and build helpers/CMakeLists.txt against the configured tree"""
+        helpers_src = os.path.join(self.source_folder, "helpers")
+        build_type = str(self.settings.build_type)
+        include_dir = self._cmake_path(os.path.join(self._build_tree, "include"))
+        args = " ".join(extra_args or [])
+        self.run(f'cmake -S "{helpers_src}" -B "{build_folder}" '
+                 f'-DCMAKE_BUILD_TYPE={build_type} '
+                 f'-DSPARETOOLS_OPENSSL_INCLUDE_DIR="{include_dir}" {args}')
+        self.run(f'cmake --build "{build_folder}" --config {build_type}')
+    
+    def _build_helpers(self):
+        """
+        Build the static helper libraries from helpers/ (sparetools_algcache,
+        sparetools_paramcache, sparetools_sesscache, sparetools_x509store, sparetools_trustblob,
+        sparetools_crlindex, sparetools_ringbio, sparetools_memtrace, sparetools_secheap,
+        sparetools_batchverify, sparetools_signctx, sparetools_ocspcache and sparetools_threadctx on POSIX, sparetools_hugetext on Linux, plus
+        sparetools_allocator when allocator != system), for fips=True the sparetools_fips_check
+        validator that FIPSValidator runs instead of the openssl CLI, and
+        with user.sparetools:ca_bundle the sparetools_trustblob compiler
+        that package() runs. gc_sections packages compile them with the
+        same per-function sections as libcrypto.
+
+        OpenSSL is not installed yet, so the helpers compile against the
+        configured source tree's include/ directory; consumers link them
+        together with the crypto component.
+        """
+        if not os.path.exists(os.path.join(self.source_folder, "helpers", "CMakeLists.txt")):
+            self.output.warning("helpers/ not exported, skipping SpareTools helper libraries")
+            return
+
+        extra_args = []
+        allocator = str(self.options.allocator)
+        if allocator != "system":
+            dep = self.dependencies[self._allocator_requires[allocator].split("/")[0]]
+            include_dir = self._cmake_path(dep.cpp_info.aggregated_components().includedirs[0])
+            extra_args += [f"-DSPARETOOLS_ALLOCATOR={allocator}",
+                           f'-DSPARETOOLS_ALLOCATOR_INCLUDE_DIR="{include_dir}"']
+        if self.options.mem_trace:
+            extra_args.append("-DSPARETOOLS_MEMTRACE_AUTOINSTALL=ON")
+        if self.options.get_safe("secure_heap"):
+            extra_args.append(f"-DSPARETOOLS_SECHEAP_DEFAULT={self.options.secure_heap}")
+        if self.options.gc_sections:
+            extra_args.append(f'-DCMAKE_C_FLAGS="{" ".join(self._gc_sections_cflags)}"')
+        if self.options.get_safe("universal"):
+            extra_args.append(f'-DCMAKE_OSX_ARCHITECTURES="{";".join(self._universal_slices)}"')
+        if self.options.fips:
+            extra_args += ["-DSPARETOOLS_BUILD_FIPS_CHECK=ON",
+                           f'-DSPARETOOLS_OPENSSL_LIB_DIR="{self._cmake_path(self._library_dir)}"']
+        if self._ca_bundle and not cross_building(self):
+            extra_args += ["-DSPARETOOLS_BUILD_TRUSTBLOB_TOOL=ON",
+                           f'-DSPARETOOLS_OPENSSL_LIB_DIR="{self._cmake_path(self._library_dir)}"']
+
+        self.output.info("Building SpareTools helper libraries")
+        self._cmake_helpers(self._helpers_build_folder, extra_args)
+    
+    @property
+    def _security_gates_mode(self):
+        """user.sparetools:security_gates: off, warn (default) or fail on findings"""
+        mode = self.conf.get("user.sparetools:security_gates", default="warn", check_type=str)
+        if mode not in ("off", "warn", "fail"):
+            raise ConanException(f"user.sparetools:security_gates must be off, warn or fail, not {mode}")
+        return mode
+    
+    @property
+    def _security_results_file(self):
+        """Results of the background SBOM of source_folder"""
+        return os.path.join(self.build_folder, "security-gates", "results.json")
+    
+    @property
+    def _package_scan_file(self):
+        """Results of the Trivy scan of package_folder"""
+        return os.path.join(self.build_folder, "security-gates", "package-results.json")
+    
+    def _base_module(self, filename, name):
+        """A script of sparetools-base by file (its names are not importable identifiers)"""
+        if name not in sys.modules:
+            path = os.path.join(self.python_requires["sparetools-base"].path, filename)
+            spec = importlib.util.spec_from_file_location(name, path)
+            module = importlib.util.module_from_spec(spec)
+            spec.loader.exec_module(module)
+            sys.modules[name] = module
+        return sys.modules[name]
+    
+    def _security_gates_module(self):
+        """security-gates.py from sparetools-base"""
+        return self._base_module("security-gates.py", "sparetools_security_gates")
+    
+    @property
+    def _security_cache_dir(self):
+        cache_dir = self.conf.get("user.sparetools:security_cache_dir", check_type=str,
+                                  default=os.path.join("~", ".sparetools", "security-gates"))
+        return os.path.expanduser(cache_dir)
+    
+    def _security_gates_args(self):
+        """Arguments of security-gates.py for the SBOM of this source tree"""
+        return [self.source_folder, "--digest", self._security_digest, "--no-trivy",
+                "--cache-dir", self._security_cache_dir, "--output", self._security_results_file]
+    
+    def _prepare_security_gates(self):
+        """Hash source_folder for the result cache key while it is still pristine"""
+        self._security_digest = None
+        if self._security_gates_mode == "off":
+            return
+        try:
+            with self._span("security gates (digest)"):
+                self._security_digest = self._security_gates_module().source_tree_digest(self.source_folder)
+        except Exception as e:
+            self.output.warning(f"Security gates not available: {e}")
+    
+    def _start_security_gates(self):
+        """
+        Syft SBOM of source_folder in a background process; the Trivy scan
+        runs on the package folder in package().
+
+        Results are cached by source digest and scanner version
+        (user.sparetools:security_cache_dir, default
+        ~/.sparetools/security-gates), so an unchanged OpenSSL tarball is
+        not rescanned; the process then finishes in about a second.
+        """
+        if not getattr(self, "_security_digest", None):
+            return
+        module = self._security_gates_module()
+        os.makedirs(os.path.dirname(self._security_results_file), exist_ok=True)
+        # A previous build's results must not stand in for this one's
+        rm(self, os.path.basename(self._security_results_file), os.path.dirname(self._security_results_file))
+        cmd = [sys.executable, module.__file__] + self._security_gates_args()
+        if shutil.which("nice"):
+            cmd = ["nice", "-n", "10"] + cmd  # Yield the CPU to make test
+        log_file = os.path.join(os.path.dirname(self._security_results_file), "security-gates.log")
+        self.output.info(f"Security gates: scanning in the background, log {log_file}")
+        with open(log_file, "w") as log:
+            self._security_proc = subprocess.Popen(cmd, stdout=log, stderr=subprocess.STDOUT)
+    
+    def _security_gate_results(self):
+        """
+        Results of the background SBOM, waiting for it if needed. A package
+        step without them (e.g. a separate conan export-pkg) runs the
+        cached gates in-process. None when the gates are unavailable or
+        the background process failed (its log is reported).
+        """
+        proc = getattr(self, "_security_proc", None)
+        if proc is not None:
+            if proc.poll() is None:
+                self.output.info("Security gates: waiting for the background scan")
+            with self._span("security gates (wait)"):
+                returncode = proc.wait()
+            self._security_proc = None
+            if returncode != 0:
+                log_file = os.path.join(os.path.dirname(self._security_results_file), "security-gates.log")
+                self.output.warning(f"Security gates: background scan exited with {returncode}, see {log_file}")
+                return None
+        elif not os.path.exists(self._security_results_file):
+            try:
+                module = self._security_gates_module()
+                if not getattr(self, "_security_digest", None):
+                    self._security_digest = module.source_tree_digest(self.source_folder)
+                with self._span("security gates"):
+                    module.main(self._security_gates_args())
+            except Exception as e:
+                self.output.warning(f"Security gates not available: {e}")
+        if not os.path.exists(self._security_results_file):
+            return None
+        return json.loads(load(self, self._security_results_file))
+    
+    def _scan_package_folder(self):
+        """Trivy scan of package_folder as it will ship (cached by its digest); None if it could not run"""
+        os.makedirs(os.path.dirname(self._package_scan_file), exist_ok=True)
+        rm(self, os.path.basename(self._package_scan_file), os.path.dirname(self._package_scan_file))
+        try:
+            module = self._security_gates_module()
+            with self._span("security gates (package scan)"):
+                return module.run_cached_gates(self.package_folder, module.source_tree_digest(self.package_folder),
+                                               self._security_cache_dir, self._package_scan_file,
+                                               run_trivy=True, generate_sbom_file=False)
         except Exception as e:
-            self.output.warn(f"Security gates not available: {e}")
+            self.output.warning(f"Security gates: package scan failed: {e}")
+            return None
+    
+    def _report_security_timings(self, results):
+        trace = self._build_trace()
+        if trace is not None:
+            for name, (start, duration) in results.get("timings", {}).items():
+                trace.add(name, start, duration, "security", tid=results.get("pid"))
+        for issue in results["issues"]:
+            self.output.warning(f"Security gates: {issue}")
+    
+    def _gate_security_results(self):
+        """
+        Apply user.sparetools:security_gates to a Trivy scan of the package
+        folder and package the source SBOM. With fail, a scan that could
+        not run (Trivy missing, scanner error, background failure) fails
+        the package as findings do.
+        """
+        mode = self._security_gates_mode
+        if mode == "off":
+            return
+        
+        def unavailable(reason):
+            if mode == "fail":
+                raise ConanException(f"Security gate failed: {reason}")
+            self.output.warning(f"Security gates: {reason}")
+        
+        scan = self._scan_package_folder()
+        if scan is not None:
+            self._report_security_timings(scan)
+        trivy = scan.get("trivy") if scan else None
+        if trivy is None:
+            unavailable(f"no Trivy results for {self.package_folder}")
+        else:
+            cached = " (cached)" if scan["cached"] else ""
+            severities = [f.get("Severity") for f in trivy["findings"]]
+            summary = (f"{trivy['findings_count']} findings "
+                       f"({severities.count('CRITICAL')} CRITICAL, {severities.count('HIGH')} HIGH)")
+            if trivy["findings_count"] and mode == "fail":
+                raise ConanException(f"Security gate failed: Trivy reports {summary} in {scan['target']}")
+            if trivy["findings_count"]:
+                self.output.warning(f"Security gates: Trivy reports {summary}{cached}")
+            else:
+                self.output.info(f"Security gates: Trivy clean{cached}")
+        
+        results = self._security_gate_results()
+        if results is None:
+            self.output.warning("Security gates: no SBOM results")
+            return
+        self._report_security_timings(results)
+        cached = f" (cached: {', '.join(results['cached'])})" if results["cached"] else ""
+        if results.get("sbom"):
+            shutil.copy2(results["sbom"], os.path.join(self.package_folder, "sbom.json"))
+            self.output.info(f"Security gates: SBOM packaged as sbom.json{cached}")
     
     def package(self):
         """Install OpenSSL to package folder"""
-        if self.options.build_method == "cmake":
-            cmake = CMake(self)
-            cmake.install()
-        elif self.options.build_method == "autotools":
-            autotools = Autotools(self)
-            autotools.install()
-        else:
-            self.run("make install_sw install_ssldirs", cwd=self.source_folder)
+        with self._span("package"):
+            if self.options.build_method == "cmake":
+                cmake = CMake(self)
+                cmake.install()
+            elif self.options.build_method == "autotools":
+                autotools = Autotools(self)
+                autotools.install()
+            elif self.options.get_safe("universal"):
+                # _build_universal installed and lipo'd the slices already
+                merged = os.path.join(self._universal_folder, "merged", self.package_folder.lstrip(os.sep))
+                copy(self, "*", src=merged, dst=self.package_folder)
+            elif self._incremental_dir:
+                # Install to the stable prefix, then copy into this revision's package
+                prefix = self._install_prefix
+                rmdir(self, prefix)
+                self.run("make install_sw install_ssldirs", cwd=self._build_tree)
+                copy(self, "*", src=prefix, dst=self.package_folder)
+            else:
+                self.run("make install_sw install_ssldirs", cwd=self.source_folder)
+        
+            # SpareTools helper libraries
+            if os.path.exists(self._helpers_build_folder):
+                self.run(f'cmake --install "{self._helpers_build_folder}" '
+                         f'--prefix "{self.package_folder}" --config {self.settings.build_type}')
+        
+            self._package_trust_store()
+        
+            if self.options.get_safe("fips_install", "off") != "off":
+                self._fips_install()
         
-        # Copy license
-        copy(self, "LICENSE*", src=self.source_folder, dst=os.path.join(self.package_folder, "licenses"))
+            if self.options.get_safe("qat_provider", "off") != "off":
+                self._package_qat_provider()
         
-        # Clean up
-        rmdir(self, os.path.join(self.package_folder, "lib", "pkgconfig"))
-        rmdir(self, os.path.join(self.package_folder, "lib", "cmake"))
-        rm(self, "*.la", os.path.join(self.package_folder, "lib"), recursive=True)
+            if self.options.startup_config == "minimal":
+                self._write_minimal_config()
+        
+            if self.options.fuzzing != "off":
+                self._package_fuzz_targets()
+        
+            if self.options.split_debug:
+                self._split_debug_info()
+        
+            # bpftrace scripts for the sparetools USDT probes
+            if self.options.usdt_probes:
+                copy(self, "*.bt", src=os.path.join(self.source_folder, "bpftrace"),
+                     dst=os.path.join(self.package_folder, "res", "bpftrace"))
+        
+            # Copy license
+            copy(self, "LICENSE*", src=self.source_folder, dst=os.path.join(self.package_folder, "licenses"))
+        
+            # Clean up
+            rmdir(self, os.path.join(self.package_folder, "lib", "pkgconfig"))
+            rmdir(self, os.path.join(self.package_folder, "lib", "cmake"))
+            rm(self, "*.la", os.path.join(self.package_folder, "lib"), recursive=True)
+        
+            # Trivy on what ships, once nothing else changes it; adds sbom.json
+            self._gate_security_results()
+        
+            # Path, size, digest and kind of every file, for artifact consumers
+            self.python_requires["sparetools-base"].module.write_artifact_manifest(self)
+        self._save_build_trace()
+    
+    @property
+    def _debug_store(self):
+        """
+        user.sparetools:debug_store: optional host directory that split_debug
+        also copies the packaged .debug files to (a symbol server's staging
+        area), in the same .build-id layout. None when not set.
+        """
+        store = self.conf.get("user.sparetools:debug_store", check_type=str)
+        return os.path.abspath(os.path.expanduser(store)) if store else None
+    
+    @property
+    def _debug_compression(self):
+        """user.sparetools:debug_compression: none (default), zlib or zstd (binutils 2.40+)"""
+        mode = self.conf.get("user.sparetools:debug_compression", default="none", check_type=str)
+        if mode not in ("none", "zlib", "zstd"):
+            raise ConanException(f"user.sparetools:debug_compression must be none, zlib or zstd, not {mode}")
+        return mode
+    
+    @staticmethod
+    def _elf_debug_info(path):
+        """(has .debug_info, GNU build ID or None) of an ELF file, from readelf"""
+        with open(path, "rb") as f:
+            if f.read(4) != b"\x7fELF":
+                return False, None
+        sections = subprocess.run(["readelf", "-S", "-W", path], capture_output=True, text=True).stdout
+        notes = subprocess.run(["readelf", "-n", path], capture_output=True, text=True).stdout
+        build_id = re.search(r"Build ID:\s*([0-9a-f]+)", notes)
+        return ".debug_info" in sections, build_id.group(1) if build_id else None
+    
+    def _split_debug_info(self):
+        """
+        split_debug=True: move the DWARF of the packaged shared libraries,
+        modules and executables into the package's debug/ folder, in the
+        .build-id/<xx>/<rest>.debug layout of gdb's debug-file-directory and
+        debuginfod, and leave a .gnu_debuglink behind. The .debug files
+        travel with the package (upload, CI caches); res/debuginfo.json
+        lists them with package-relative paths. user.sparetools:debug_store
+        additionally copies them to a host directory.
+
+        The FIPS module is left alone: its installed checksum covers the
+        whole file. Static archives cannot use a debuglink (their objects
+        end up in the consumer's binary), so they keep their DWARF,
+        compressed in place when user.sparetools:debug_compression is set.
+        """
+        objcopy = shutil.which("objcopy") or shutil.which("llvm-objcopy")
+        if objcopy is None or shutil.which("readelf") is None:
+            raise ConanException("split_debug needs objcopy and readelf (binutils) on PATH")
+        compression = self._debug_compression
+        compress = [] if compression == "none" else [f"--compress-debug-sections={compression}"]
+        debug_root = os.path.join(self.package_folder, "debug")
+        store = self._debug_store
+        
+        entries = []
+        for folder in ["lib", "lib64", "bin"]:
+            root = os.path.join(self.package_folder, folder)
+            for dirpath, _, files in os.walk(root):
+                for name in sorted(files):
+                    path = os.path.join(dirpath, name)
+                    rel = os.path.relpath(path, self.package_folder).replace(os.sep, "/")
+                    if os.path.islink(path) or name.startswith("fips."):
+                        continue
+                    if name.endswith(".a"):
+                        if compress:
+                            self.run(f'"{objcopy}" {compress[0]} "{path}"')
+                        continue
+                    has_debug, build_id = self._elf_debug_info(path)
+                    if not has_debug:
+                        continue
+                    if build_id is None:
+                        self.output.warning(f"split_debug: {rel} has no build ID, keeping its debug info")
+                        continue
+                    debug_rel = f"debug/.build-id/{build_id[:2]}/{build_id[2:]}.debug"
+                    debug_file = os.path.join(self.package_folder, *debug_rel.split("/"))
+                    os.makedirs(os.path.dirname(debug_file), exist_ok=True)
+                    self.run(f'"{objcopy}" --only-keep-debug {" ".join(compress)} "{path}" "{debug_file}"')
+                    self.run(f'"{objcopy}" --strip-debug --add-gnu-debuglink="{debug_file}" "{path}"')
+                    if store:
+                        exported = os.path.join(store, os.path.relpath(debug_file, debug_root))
+                        os.makedirs(os.path.dirname(exported), exist_ok=True)
+                        shutil.copy2(debug_file, exported)
+                    entries.append({"file": rel, "build_id": build_id, "debug_file": debug_rel,
+                                    "debug_bytes": os.path.getsize(debug_file)})
+        
+        if not entries:
+            self.output.warning(f"split_debug: no debug info to split (build_type={self.settings.build_type})")
+        else:
+            total = sum(e["debug_bytes"] for e in entries) / (1 << 20)
+            self.output.info(f"split_debug: {len(entries)} files, {total:.1f} MiB of debug info moved to debug/"
+                             + (f", copied to {store}" if store else ""))
+        save(self, os.path.join(self.package_folder, "res", "debuginfo.json"),
+             json.dumps({"store": "debug", "compression": compression, "files": entries}, indent=2))
+    
+    @property
+    def _ca_bundle(self):
+        """user.sparetools:ca_bundle: PEM CA bundle to ship as ssl/cert.pem"""
+        bundle = self.conf.get("user.sparetools:ca_bundle", check_type=str)
+        if bundle and not os.path.isfile(bundle):
+            raise ConanException(f"user.sparetools:ca_bundle: {bundle} does not exist")
+        return bundle
+    
+    def _package_trust_store(self):
+        """
+        Ship user.sparetools:ca_bundle as ssl/cert.pem, the default CA file
+        of the installed ssl directory, and compile it into ssl/cert.stb, the
+        trust blob SpareTools::trustblob maps instead of parsing the PEM
+        bundle at startup. Cross builds cannot run the compiler and ship
+        only the PEM bundle.
+        """
+        if not self._ca_bundle:
+            return
+        ssl_dir = os.path.join(self.package_folder, "ssl")
+        pem = os.path.join(ssl_dir, "cert.pem")
+        os.makedirs(ssl_dir, exist_ok=True)
+        shutil.copy2(self._ca_bundle, pem)
+        tool = os.path.join(self.package_folder, "bin", "sparetools_trustblob")
+        if self.settings.os == "Windows":
+            tool += ".exe"
+        if not os.path.exists(tool):
+            self.output.warning("sparetools_trustblob not built, packaging ssl/cert.pem without ssl/cert.stb")
+            return
+        self.run(f'"{tool}" "{pem}" "{os.path.join(ssl_dir, "cert.stb")}"')
+    
+    def _fips_install(self):
+        """
+        fips_install: run the packaged `openssl fipsinstall` on the packaged
+        FIPS module and ship ssl/fipsmodule.cnf (module MAC with the build's
+        FIPSKEY, the default of the compiled-in fipsinstall). fipsinstall
+        runs the module's self tests itself. With oninstall (3.0.x only) it
+        also writes the install-status/install-mac indicators, so later
+        loads skip the KATs and only verify the module; onload leaves them
+        out and every OSSL_PROVIDER_load(..., "fips") runs the full suite.
+        """
+        libdir = "lib64" if os.path.isdir(os.path.join(self.package_folder, "lib64")) else "lib"
+        module_ext = {"Windows": ".dll", "Macos": ".dylib"}.get(str(self.settings.os), ".so")
+        module = os.path.join(self.package_folder, libdir, "ossl-modules", f"fips{module_ext}")
+        openssl = os.path.join(self.package_folder, "bin", "openssl.exe" if self.settings.os == "Windows" else "openssl")
+        if not os.path.isfile(module) or not os.path.isfile(openssl):
+            raise ConanException(f"fips_install: {os.path.relpath(module, self.package_folder)} or bin/openssl "
+                                 "was not installed")
+        ssl_dir = os.path.join(self.package_folder, "ssl")
+        os.makedirs(ssl_dir, exist_ok=True)
+        config = os.path.join(ssl_dir, "fipsmodule.cnf")
+        # 3.0 writes the indicators by default and has no -self_test_oninstall
+        mode = "" if self.options.fips_install == "oninstall" else " -self_test_onload"
+        lib_path = ""
+        if self.settings.os != "Windows":
+            lib_path_var = "DYLD_LIBRARY_PATH" if self.settings.os == "Macos" else "LD_LIBRARY_PATH"
+            lib_path = f'{lib_path_var}="{os.path.join(self.package_folder, libdir)}" '
+        start = time.time()
+        self.run(f'{lib_path}"{openssl}" fipsinstall -module "{module}" -out "{config}" '
+                 f'-provider_name fips{mode}')
+        self.output.info(f"fips_install={self.options.fips_install}: ssl/fipsmodule.cnf written, "
+                         f"self tests passed in {time.time() - start:.2f}s")
+    
+    def _write_minimal_config(self):
+        """
+        startup_config=minimal: replace ssl/openssl.cnf (the stock file stays
+        as openssl.cnf.dist) with one that gives OPENSSL_init_* nothing to
+        do beyond parsing a few lines. Without a providers section the
+        default provider is still loaded lazily on the first fetch; FIPS
+        packages activate fips and base and default to fips=yes when the
+        module configuration (fipsmodule.cnf from fipsinstall) is packaged.
+        """
+        ssl_dir = os.path.join(self.package_folder, "ssl")
+        fips_config = self.options.fips and os.path.exists(os.path.join(ssl_dir, "fipsmodule.cnf"))
+        if self.options.fips and not fips_config:
+            self.output.warning("startup_config=minimal: no ssl/fipsmodule.cnf, FIPS provider not activated")
+        if fips_config:
+            content = textwrap.dedent("""\
+                # startup_config=minimal (FIPS): only the FIPS and base providers
+                .include fipsmodule.cnf
+
+                openssl_conf = openssl_init
+
+                [openssl_init]
+                providers = provider_sect
+                alg_section = algorithm_sect
+
+                [provider_sect]
+                fips = fips_sect
+                base = base_sect
+
+                [base_sect]
+                activate = 1
+
+                [algorithm_sect]
+                default_properties = fips=yes
+                """)
+        else:
+            content = textwrap.dedent("""\
+                # startup_config=minimal: no openssl_conf section, so config
+                # loading stops after parsing this file. The default provider
+                # is loaded on the first fetch; [req]/[ca] defaults for the
+                # openssl CLI are in openssl.cnf.dist.
+                """)
+        save(self, os.path.join(ssl_dir, "openssl.cnf"), content)
     
     def package_info(self):
         """Define package information for consumers"""
@@ -383,6 +2783,10 @@ class SpareToolsOpenSSLConan(ConanFile):
             self.cpp_info.components["crypto"].system_libs.extend(["dl", "pthread"])
         elif self.settings.os == "Windows":
             self.cpp_info.components["crypto"].system_libs.extend(["ws2_32", "crypt32"])
+        # libcrypto's COMP methods link the compression libraries
+        for option, (_, _, component) in self._compression_requires.items():
+            if self.options.get_safe(option):
+                self.cpp_info.components["crypto"].requires.append(component)
         
         # Directories (use detected libdir)
         self.cpp_info.components["ssl"].libdirs = [libdir]
@@ -392,4 +2796,202 @@ class SpareToolsOpenSSLConan(ConanFile):
         self.cpp_info.components["crypto"].libdirs = [libdir]
         self.cpp_info.components["crypto"].includedirs = ["include"]
         self.cpp_info.components["crypto"].bindirs = ["bin"]
+        
+        # SpareTools helper libraries (always installed to lib/)
+        self.cpp_info.components["algcache"].set_property("cmake_target_name", "SpareTools::algcache")
+        self.cpp_info.components["algcache"].libs = ["sparetools_algcache"]
+        self.cpp_info.components["algcache"].requires = ["crypto"]
+        self.cpp_info.components["algcache"].libdirs = ["lib"]
+        self.cpp_info.components["algcache"].includedirs = ["include"]
+        
+        paramcache = self.cpp_info.components["paramcache"]
+        paramcache.set_property("cmake_target_name", "SpareTools::paramcache")
+        paramcache.libs = ["sparetools_paramcache"]
+        paramcache.requires = ["crypto"]
+        paramcache.libdirs = ["lib"]
+        paramcache.includedirs = ["include"]
+        
+        sesscache = self.cpp_info.components["sesscache"]
+        sesscache.set_property("cmake_target_name", "SpareTools::sesscache")
+        sesscache.libs = ["sparetools_sesscache"]
+        sesscache.requires = ["ssl", "crypto"]
+        sesscache.libdirs = ["lib"]
+        sesscache.includedirs = ["include"]
+        
+        x509store = self.cpp_info.components["x509store"]
+        x509store.set_property("cmake_target_name", "SpareTools::x509store")
+        x509store.libs = ["sparetools_x509store"]
+        x509store.requires = ["crypto"]
+        x509store.libdirs = ["lib"]
+        x509store.includedirs = ["include"]
+        
+        trustblob = self.cpp_info.components["trustblob"]
+        trustblob.set_property("cmake_target_name", "SpareTools::trustblob")
+        trustblob.libs = ["sparetools_trustblob"]
+        trustblob.requires = ["crypto"]
+        trustblob.libdirs = ["lib"]
+        trustblob.includedirs = ["include"]
+        
+        crlindex = self.cpp_info.components["crlindex"]
+        crlindex.set_property("cmake_target_name", "SpareTools::crlindex")
+        crlindex.libs = ["sparetools_crlindex"]
+        crlindex.requires = ["crypto"]
+        crlindex.libdirs = ["lib"]
+        crlindex.includedirs = ["include"]
+
+        ringbio = self.cpp_info.components["ringbio"]
+        ringbio.set_property("cmake_target_name", "SpareTools::ringbio")
+        ringbio.libs = ["sparetools_ringbio"]
+        ringbio.requires = ["crypto"]
+        ringbio.libdirs = ["lib"]
+        ringbio.includedirs = ["include"]
+        
+        if self.settings.os != "Windows":
+            batchverify = self.cpp_info.components["batchverify"]
+            batchverify.set_property("cmake_target_name", "SpareTools::batchverify")
+            batchverify.libs = ["sparetools_batchverify"]
+            batchverify.requires = ["crypto"]
+            batchverify.libdirs = ["lib"]
+            batchverify.includedirs = ["include"]
+            batchverify.system_libs = ["pthread"]
+            
+            signctx = self.cpp_info.components["signctx"]
+            signctx.set_property("cmake_target_name", "SpareTools::signctx")
+            signctx.libs = ["sparetools_signctx"]
+            signctx.requires = ["crypto"]
+            signctx.libdirs = ["lib"]
+            signctx.includedirs = ["include"]
+            signctx.system_libs = ["pthread"]
+            
+            ocspcache = self.cpp_info.components["ocspcache"]
+            ocspcache.set_property("cmake_target_name", "SpareTools::ocspcache")
+            ocspcache.libs = ["sparetools_ocspcache"]
+            ocspcache.requires = ["ssl", "crypto"]
+            ocspcache.libdirs = ["lib"]
+            ocspcache.includedirs = ["include"]
+            ocspcache.system_libs = ["pthread"]
+            
+            threadctx = self.cpp_info.components["threadctx"]
+            threadctx.set_property("cmake_target_name", "SpareTools::threadctx")
+            threadctx.libs = ["sparetools_threadctx"]
+            threadctx.requires = ["algcache", "crypto"]
+            threadctx.libdirs = ["lib"]
+            threadctx.includedirs = ["include"]
+            threadctx.system_libs = ["pthread"]
+        
+        if self.settings.os == "Linux":
+            hugetext = self.cpp_info.components["hugetext"]
+            hugetext.set_property("cmake_target_name", "SpareTools::hugetext")
+            hugetext.libs = ["sparetools_hugetext"]
+            hugetext.requires = ["crypto"]
+            hugetext.libdirs = ["lib"]
+            hugetext.includedirs = ["include"]
+            hugetext.system_libs = ["dl"]
+        # Static libcrypto text ends up in the consumer's executable, so its
+        # link has to produce the 2 MiB alignment
+        if self.options.hugepage_text and not self.options.shared:
+            self.cpp_info.components["crypto"].exelinkflags.extend(self._hugepage_text_ldflags)
+        # Full RELRO is a property of the final link, which for static
+        # libraries is the consumer's
+        if not self.options.shared:
+            self.cpp_info.components["crypto"].exelinkflags.extend(self._get_hardening_flags()[1])
+        # gc_sections: consumers' links drop the libcrypto/libssl functions
+        # and data they never reference
+        if self.options.gc_sections:
+            self.cpp_info.components["crypto"].exelinkflags.extend(self._gc_sections_ldflags)
+            self.cpp_info.components["crypto"].sharedlinkflags.extend(self._gc_sections_ldflags)
+        
+        memtrace = self.cpp_info.components["memtrace"]
+        memtrace.set_property("cmake_target_name", "SpareTools::memtrace")
+        memtrace.libs = ["sparetools_memtrace"]
+        memtrace.requires = ["crypto"]
+        memtrace.libdirs = ["lib"]
+        memtrace.includedirs = ["include"]
+        if self.options.mem_trace:
+            # Keep the load-time constructor (traces when SPARETOOLS_MEMTRACE is set)
+            memtrace.exelinkflags = [self._link_anchor("sparetools_memtrace_install")]
+            memtrace.sharedlinkflags = list(memtrace.exelinkflags)
+        
+        secheap = self.cpp_info.components["secheap"]
+        secheap.set_property("cmake_target_name", "SpareTools::secheap")
+        secheap.libs = ["sparetools_secheap"]
+        secheap.requires = ["crypto"]
+        secheap.libdirs = ["lib"]
+        secheap.includedirs = ["include"]
+        if self.options.get_safe("secure_heap"):
+            # Keep the load-time constructor (SPARETOOLS_SECURE_HEAP overrides the size)
+            secheap.exelinkflags = [self._link_anchor("sparetools_secheap_init")]
+            secheap.sharedlinkflags = list(secheap.exelinkflags)
+        
+        allocator = str(self.options.allocator)
+        if allocator != "system":
+            dep_name = self._allocator_requires[allocator].split("/")[0]
+            component = self.cpp_info.components["allocator"]
+            component.set_property("cmake_target_name", "SpareTools::allocator")
+            component.libs = ["sparetools_allocator"]
+            component.requires = ["crypto", f"{dep_name}::{dep_name}"]
+            component.libdirs = ["lib"]
+            component.includedirs = ["include"]
+            # Keep the self-installing object when linking the static shim
+            if self.settings.os == "Windows":
+                anchor = "/INCLUDE:sparetools_allocator_autoinstall"
+            else:
+                anchor = self._link_anchor("sparetools_allocator_install")
+            component.exelinkflags = [anchor]
+            component.sharedlinkflags = [anchor]
+        
+        if os.path.exists(os.path.join(self.package_folder, "ssl", "cert.stb")):
+            self.runenv_info.define_path("SPARETOOLS_TRUSTBLOB", os.path.join(self.package_folder, "ssl", "cert.stb"))
+            self.runenv_info.define_path("SSL_CERT_FILE", os.path.join(self.package_folder, "ssl", "cert.pem"))
+        
+        if self.options.usdt_probes:
+            self.runenv_info.define_path("SPARETOOLS_BPFTRACE", os.path.join(self.package_folder, "res", "bpftrace"))
+        
+        if self.options.fuzzing != "off":
+            # Fuzz binaries for FuzzCorporaManager; consumers of the
+            # sanitized static libraries need the sanitizer runtimes too
+            fuzz = self.cpp_info.components["fuzz"]
+            fuzz.bindirs = [os.path.join("bin", "fuzz")]
+            fuzz.libdirs = []
+            fuzz.includedirs = []
+            sanitizers = ["-fsanitize=address,undefined"]
+            self.cpp_info.components["crypto"].exelinkflags.extend(sanitizers)
+            self.cpp_info.components["crypto"].sharedlinkflags.extend(sanitizers)
+            self.runenv_info.define_path("SPARETOOLS_OPENSSL_FUZZ_DIR", os.path.join(self.package_folder, "bin", "fuzz"))
+        
+        qat = self.options.get_safe("qat_provider", "off") != "off"
+        if self.options.get_safe("fips_install", "off") != "off" or qat:
+            # The compiled-in MODULESDIR is the build-time prefix as well
+            self.runenv_info.define_path("OPENSSL_MODULES", os.path.join(self.package_folder, libdir, "ossl-modules"))
+        if self.options.get_safe("fips_install", "off") != "off":
+            self.runenv_info.define_path("SPARETOOLS_FIPSMODULE_CNF",
+                                         os.path.join(self.package_folder, "ssl", "fipsmodule.cnf"))
+        if qat:
+            # Loaded at runtime, nothing to link: OPENSSL_CONF=$SPARETOOLS_QAT_CONF
+            # or OSSL_PROVIDER_load(NULL, "qatprovider")
+            component = self.cpp_info.components["qat"]
+            component.requires = ["crypto"]
+            component.libdirs = []
+            component.includedirs = []
+            component.bindirs = []
+            self.runenv_info.define_path("SPARETOOLS_QAT_CONF", os.path.join(self.package_folder, "ssl", "openssl-qat.cnf"))
+        
+        engines_dir = os.path.join(self.package_folder, libdir, "engines-3")
+        if self.options.get_safe("enable_afalg") and os.path.isdir(engines_dir):
+            # ENGINE_by_id("afalg") loads it from the compiled-in ENGINESDIR
+            self.runenv_info.define_path("OPENSSL_ENGINES", engines_dir)
+        
+        if self.options.startup_config == "minimal":
+            # The compiled-in OPENSSLDIR is the build-time prefix; point at the packaged file
+            ssl_dir = os.path.join(self.package_folder, "ssl")
+            self.runenv_info.define_path("OPENSSL_CONF", os.path.join(ssl_dir, "openssl.cnf"))
+            self.runenv_info.define_path("OPENSSL_CONF_INCLUDE", ssl_dir)
+    
+    def _link_anchor(self, symbol):
+        """Linker flag forcing symbol (and its object) out of a static archive"""
+        if self.settings.os == "Windows":
+            return f"/INCLUDE:{symbol}"
+        if self.settings.os == "Macos":
+            return f"-Wl,-u,_{symbol}"
+        return f"-Wl,-u,{symbol}"
 
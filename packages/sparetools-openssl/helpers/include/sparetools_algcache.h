@@ -0,0 +1,50 @@
+#ifndef SPARETOOLS_ALGCACHE_H
+#define SPARETOOLS_ALGCACHE_H
+
+#include <openssl/evp.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Pre-fetched algorithm handle cache
+ *
+ * OpenSSL 3.x resolves algorithm names through the provider store on
+ * every implicit fetch (EVP_sha256() passed to EVP_DigestInit_ex) and
+ * every EVP_*_fetch call. A cache fetches each algorithm once at
+ * start-up and pins the handle until sparetools_algcache_free().
+ *
+ * The cache is immutable after creation, so lookups are safe from any
+ * number of threads. Algorithms the loaded providers do not offer are
+ * skipped and look up as NULL.
+ */
+
+typedef struct sparetools_algcache_st SPARETOOLS_ALGCACHE;
+
+/**
+ * Create a cache for libctx/propq (both may be NULL for the defaults).
+ * md_names and cipher_names are NULL-terminated lists; passing NULL
+ * selects a default set of common TLS algorithms.
+ */
+SPARETOOLS_ALGCACHE *sparetools_algcache_new(OSSL_LIB_CTX *libctx, const char *propq,
+                                             const char *const *md_names,
+                                             const char *const *cipher_names);
+
+void sparetools_algcache_free(SPARETOOLS_ALGCACHE *cache);
+
+/** Pinned digest for name (case-insensitive), or NULL if not cached */
+const EVP_MD *sparetools_algcache_md(const SPARETOOLS_ALGCACHE *cache, const char *name);
+
+/** Pinned cipher for name (case-insensitive), or NULL if not cached */
+const EVP_CIPHER *sparetools_algcache_cipher(const SPARETOOLS_ALGCACHE *cache,
+                                             const char *name);
+
+/** Number of digests and ciphers successfully fetched */
+int sparetools_algcache_count(const SPARETOOLS_ALGCACHE *cache);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SPARETOOLS_ALGCACHE_H */
@@ -0,0 +1,37 @@
+#ifndef SPARETOOLS_ALLOCATOR_H
+#define SPARETOOLS_ALLOCATOR_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Allocator shim for libcrypto/libssl
+ *
+ * Routes OpenSSL's internal allocations (OSSL_PARAM arrays, BIGNUMs,
+ * X509 objects, ...) to jemalloc, mimalloc or tcmalloc through
+ * CRYPTO_set_mem_functions(). The package built with allocator=<name>
+ * links this shim into consumers of SpareTools::allocator; it installs
+ * itself from a constructor before main(), i.e. before libcrypto's
+ * first allocation, after which OpenSSL refuses new hooks.
+ *
+ * Only OpenSSL allocations are affected, the application keeps its own
+ * malloc.
+ */
+
+/**
+ * Install the hooks. Called automatically at load time; calling it again
+ * is harmless. Returns 1 if the shim's functions are in effect.
+ */
+int sparetools_allocator_install(void);
+
+/** "jemalloc", "mimalloc" or "tcmalloc" */
+const char *sparetools_allocator_name(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SPARETOOLS_ALLOCATOR_H */
@@ -0,0 +1,79 @@
+#ifndef SPARETOOLS_BATCHVERIFY_H
+#define SPARETOOLS_BATCHVERIFY_H
+
+#include <openssl/evp.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Batch signature verification across a thread pool
+ *
+ * Verifying one signature the usual way (EVP_DigestVerifyInit, then
+ * EVP_DigestVerify) builds a new EVP_PKEY_CTX and re-runs the provider's
+ * verify-init for every call, and callers typically run it on one thread.
+ * A SPARETOOLS_BATCHVERIFY verifies whole batches instead:
+ *
+ * - the signature algorithms (ED25519, ECDSA, RSA) and SHA2-256 are
+ *   fetched once when the verifier is created;
+ * - each thread keeps initialised EVP_PKEY_CTXs for the keys it has seen
+ *   (RSA-PSS parameters included), so a repeated key costs a digest and
+ *   EVP_PKEY_verify only;
+ * - items are split into chunks of 64 per thread; a thread that runs out
+ *   steals chunks from the others, so slow items (RSA) do not leave
+ *   threads idle.
+ *
+ * Threads are created with the verifier and reused by every batch. One
+ * batch runs at a time per verifier; concurrent calls wait. Cached
+ * contexts hold a reference to their key until evicted or until
+ * sparetools_batchverify_free().
+ */
+
+typedef struct sparetools_batchverify_st SPARETOOLS_BATCHVERIFY;
+
+typedef enum {
+    SPARETOOLS_SIG_ED25519 = 0,       /* PureEdDSA over the message */
+    SPARETOOLS_SIG_ECDSA_SHA256 = 1,  /* DER ECDSA signature of SHA2-256(message) */
+    SPARETOOLS_SIG_RSA_PSS_SHA256 = 2 /* RSASSA-PSS, SHA2-256, MGF1-SHA2-256, salt = digest length */
+} SPARETOOLS_SIG_ALG;
+
+typedef struct {
+    SPARETOOLS_SIG_ALG alg;
+    EVP_PKEY *key;               /* Public key; not modified */
+    const unsigned char *msg;
+    size_t msg_len;
+    const unsigned char *sig;
+    size_t sig_len;
+} SPARETOOLS_VERIFY_ITEM;
+
+/**
+ * Create a verifier for libctx/propq (both may be NULL for the defaults)
+ * with threads workers in total, the calling thread included; 0 uses the
+ * number of online CPUs. Returns NULL if the algorithms cannot be fetched
+ * or threads cannot be started.
+ */
+SPARETOOLS_BATCHVERIFY *sparetools_batchverify_new(OSSL_LIB_CTX *libctx, const char *propq,
+                                                   int threads);
+
+void sparetools_batchverify_free(SPARETOOLS_BATCHVERIFY *verifier);
+
+/** Number of threads verifying a batch, the calling thread included */
+int sparetools_batchverify_threads(const SPARETOOLS_BATCHVERIFY *verifier);
+
+/**
+ * Verify n items. Bit i of bitmap (bitmap[i / 8] & (1 << (i % 8))) is
+ * set when item i has a valid signature and cleared otherwise; bitmap
+ * must hold (n + 7) / 8 bytes. Returns the number of valid signatures.
+ */
+size_t sparetools_batchverify_run(SPARETOOLS_BATCHVERIFY *verifier,
+                                  const SPARETOOLS_VERIFY_ITEM *items, size_t n,
+                                  uint8_t *bitmap);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SPARETOOLS_BATCHVERIFY_H */
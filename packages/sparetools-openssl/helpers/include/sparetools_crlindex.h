@@ -0,0 +1,104 @@
+#ifndef SPARETOOLS_CRLINDEX_H
+#define SPARETOOLS_CRLINDEX_H
+
+#include <openssl/x509.h>
+#include <openssl/x509_vfy.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Indexed revocation lookup for very large CRLs
+ *
+ * With X509_V_FLAG_CRL_CHECK, a CRL added to an X509_STORE is decoded
+ * into one X509_REVOKED per entry (hundreds of bytes each, so a
+ * million-entry CRL costs hundreds of MB and seconds to load). Its
+ * signature is also verified again in every X509_verify_cert, which
+ * hashes the whole CRL. Reloading a CRL means doing all of that again
+ * while other threads wait for the store.
+ *
+ * A CRL index holds the CRLs' DER unchanged, each followed by its entry
+ * offsets sorted by serial number, in one memory-mappable file. Opening
+ * it maps the file and checks the offsets; nothing is decoded. Attached
+ * to an X509_STORE, it replaces the CRL lookup (X509_STORE_set_lookup_crls)
+ * for the issuers it covers. Each verification gets a CRL decoded from
+ * the original header and extensions plus, when the certificate is
+ * revoked, its one entry, found by binary search:
+ * - not revoked: a shared CRL with no entries
+ * - revoked:     a CRL holding only that certificate's entry
+ * These CRLs keep the original signature, which does not cover them.
+ * When the verifier reports that, the index checks the full CRL
+ * signature against the issuer key the verifier chose. Each CRL does
+ * that once per key, and the result is cached.
+ *
+ * Only complete, direct CRLs are indexed; delta and indirect CRLs are
+ * rejected at compile time and still go through the store. For issuers
+ * the index does not cover, the store's own CRLs are used.
+ *
+ * Layout (integers little-endian):
+ *
+ *   header   "STCRLIX\0", u32 version (1), u32 count, u32 directory
+ *            offset, u32 reserved x 3
+ *   entry    count x {u32 DER offset, u32 DER length, u32 table offset,
+ *            u32 revoked count}
+ *   data     per CRL its DER, then a u32 table of entry offsets
+ *            (relative to the DER) sorted by serial number
+ *
+ * The index is read-only once open and can be attached to several
+ * stores; it must outlive them.
+ */
+
+typedef struct sparetools_crlindex_st SPARETOOLS_CRLINDEX;
+
+typedef struct {
+    uint64_t lookups;        /* CRL lookups answered from the index */
+    uint64_t revoked;        /* of which found the certificate's serial */
+    uint64_t fallbacks;      /* lookups for issuers not in the index */
+    uint64_t verifications;  /* full CRL signature checks performed */
+} SPARETOOLS_CRLINDEX_STATS;
+
+/**
+ * Write DER CRLs into an index file. The CRLs are not decoded (their
+ * signatures are checked during verification). Returns the number of
+ * revoked entries written, or -1 on error or for delta or indirect CRLs.
+ */
+long sparetools_crlindex_write(const unsigned char *const *ders, const size_t *lens, int count,
+                               const char *index_path);
+
+/**
+ * Compile CRL files (DER or PEM) into an index file. Returns the number
+ * of revoked entries written, or -1 on error.
+ */
+long sparetools_crlindex_compile(const char *const *crl_paths, int count, const char *index_path);
+
+/** Map and validate an index; NULL if it is missing or malformed */
+SPARETOOLS_CRLINDEX *sparetools_crlindex_open(const char *index_path);
+
+/** Unmap the index; every store it is attached to must be freed first */
+void sparetools_crlindex_free(SPARETOOLS_CRLINDEX *index);
+
+/** Number of CRLs in the index */
+int sparetools_crlindex_count(const SPARETOOLS_CRLINDEX *index);
+
+/** Size of the mapped file in bytes */
+size_t sparetools_crlindex_size(const SPARETOOLS_CRLINDEX *index);
+
+/**
+ * Install the index on store: the CRL lookup, and a verify callback
+ * that accepts the index's CRLs once their full signature checked out
+ * (the previous store callback is still called for everything else).
+ * X509_STORE_CTX verify callbacks set later replace it. A store takes
+ * at most one index. Returns 1 on success.
+ */
+int sparetools_crlindex_attach(SPARETOOLS_CRLINDEX *index, X509_STORE *store);
+
+/** Snapshot of the counters */
+void sparetools_crlindex_stats(SPARETOOLS_CRLINDEX *index, SPARETOOLS_CRLINDEX_STATS *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SPARETOOLS_CRLINDEX_H */
@@ -0,0 +1,58 @@
+#ifndef SPARETOOLS_HUGETEXT_H
+#define SPARETOOLS_HUGETEXT_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Hot text on transparent hugepages (Linux)
+ *
+ * libcrypto/libssl code is mapped from the file with 4 KiB pages, so a
+ * TLS server touching handshake, record and bignum code on every request
+ * keeps missing in the iTLB. sparetools_hugetext_remap copies the
+ * 2 MiB-aligned part of an object's executable segment into anonymous
+ * memory advised MADV_HUGEPAGE and swaps it in place of the file mapping
+ * with a single mremap, so no instruction in the range is ever unmapped,
+ * including the caller's own.
+ *
+ * Only whole 2 MiB pages inside the segment move. Packages built with
+ * hugepage_text=True align the segment to 2 MiB (static packages ask the
+ * consumer's link to do the same), which leaves at most the last partial
+ * page on 4 KiB pages. Without the alignment a small library may have no
+ * whole page to move.
+ *
+ * The copy is private memory: every process pays its RSS instead of
+ * sharing the page cache, and perf/gdb see an anonymous mapping for the
+ * range. Call it once, early in main, before starting threads.
+ * Transparent hugepages must be "always" or "madvise".
+ */
+
+typedef struct {
+    size_t text_bytes;      /* Size of the executable segment(s) */
+    size_t remapped_bytes;  /* Bytes moved to anonymous hugepage memory */
+    size_t huge_bytes;      /* AnonHugePages backing them (smaps) */
+} SPARETOOLS_HUGETEXT_RESULT;
+
+/**
+ * Remap the executable segment of the loaded object whose path contains
+ * object ("libcrypto.so"); NULL or "" selects the main executable.
+ * Returns 1 if text was remapped, 0 if there was nothing to move (object
+ * not loaded, no whole 2 MiB page, THP disabled) and -1 on a failed
+ * system call. result may be NULL; its counters are added to, not reset.
+ */
+int sparetools_hugetext_remap(const char *object, SPARETOOLS_HUGETEXT_RESULT *result);
+
+/**
+ * Remap libcrypto and libssl, or the executable when OpenSSL is linked
+ * statically. Same return values as sparetools_hugetext_remap.
+ */
+int sparetools_hugetext_remap_openssl(SPARETOOLS_HUGETEXT_RESULT *result);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SPARETOOLS_HUGETEXT_H */
@@ -0,0 +1,54 @@
+#ifndef SPARETOOLS_MEMTRACE_H
+#define SPARETOOLS_MEMTRACE_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Allocation tracing for libcrypto/libssl
+ *
+ * Installs CRYPTO_set_mem_functions hooks that forward to the allocator
+ * already in effect (system malloc or the SpareTools allocator shim) and
+ * count allocations, reallocations, frees and bytes per OpenSSL call
+ * site, using the file/line OpenSSL passes to the hooks.
+ *
+ * Hooks must be installed before OpenSSL's first allocation. In packages
+ * built with mem_trace=True, linking SpareTools::memtrace installs them
+ * from a load-time constructor when SPARETOOLS_MEMTRACE is set, and the
+ * histogram is written to that path at exit.
+ *
+ * Counters are updated with atomics and are safe from any thread.
+ */
+
+typedef struct {
+    uint64_t allocs;     /* CRYPTO_malloc/zalloc calls */
+    uint64_t reallocs;   /* CRYPTO_realloc calls */
+    uint64_t frees;      /* CRYPTO_free calls with a non-NULL pointer */
+    uint64_t bytes;      /* Bytes requested by allocs and reallocs */
+} SPARETOOLS_MEMTRACE_TOTALS;
+
+/**
+ * Install the tracing hooks. Returns 1 if they are in effect (also when
+ * already installed), 0 if OpenSSL has allocated already. When the
+ * SPARETOOLS_MEMTRACE environment variable names a file, the histogram
+ * is dumped there at exit.
+ */
+int sparetools_memtrace_install(void);
+
+/** Process-wide totals since installation */
+void sparetools_memtrace_totals(SPARETOOLS_MEMTRACE_TOTALS *out);
+
+/**
+ * Write the per-call-site histogram as JSON, sorted by allocation count
+ * ("-" writes to stdout). Returns 0 on success.
+ */
+int sparetools_memtrace_dump(const char *path);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SPARETOOLS_MEMTRACE_H */
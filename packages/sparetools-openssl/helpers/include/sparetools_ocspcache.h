@@ -0,0 +1,119 @@
+#ifndef SPARETOOLS_OCSPCACHE_H
+#define SPARETOOLS_OCSPCACHE_H
+
+#include <openssl/ocsp.h>
+#include <openssl/ssl.h>
+#include <openssl/x509.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * OCSP stapling from a validated response cache
+ *
+ * A server that staples by fetching, or even just parsing, the OCSP
+ * response in its SSL_CTX_set_tlsext_status_cb callback puts responder
+ * latency or d2i_OCSP_RESPONSE/OCSP_basic_verify on every handshake.
+ *
+ * SPARETOOLS_OCSPCACHE keeps one response per registered certificate,
+ * already verified against the issuer (OCSP_basic_verify, certificate
+ * status good or revoked, thisUpdate/nextUpdate window) and stored as
+ * DER. A signed revoked response replaces a good one and is stapled, so
+ * clients see the revocation; unknown or unverifiable ones are refused. The
+ * status callback only copies those bytes into the connection. Responses
+ * are refreshed half way through their validity window, or every
+ * refresh interval when they carry no nextUpdate, either by an explicit
+ * sparetools_ocspcache_refresh() or by a background thread; a failed
+ * refresh keeps serving the previous response until its nextUpdate, and
+ * an expired response is never stapled.
+ *
+ * Responses come from the fetch callback, by default an HTTP POST to the
+ * certificate's AIA OCSP URL, or are pushed with
+ * sparetools_ocspcache_set_response() (e.g. from files written by a
+ * separate fetcher).
+ *
+ * The cache is thread-safe and must outlive every SSL_CTX it is attached
+ * to. Built where POSIX threads exist.
+ */
+
+typedef struct sparetools_ocspcache_st SPARETOOLS_OCSPCACHE;
+
+/**
+ * Obtain a response for req (one CertID for cert). Returns a new
+ * OCSP_RESPONSE owned by the caller, or NULL on failure.
+ */
+typedef OCSP_RESPONSE *(*SPARETOOLS_OCSP_FETCH_FN)(X509 *cert, X509 *issuer,
+                                                   OCSP_REQUEST *req, void *arg);
+
+typedef struct {
+    uint64_t hits;       /* status callback stapled a cached response */
+    uint64_t misses;     /* status requested, nothing valid cached */
+    uint64_t refreshes;  /* responses fetched and accepted */
+    uint64_t failures;   /* fetches that failed or did not validate */
+    uint64_t entries;    /* registered certificates */
+    uint64_t valid;      /* certificates with a stapleable response */
+    uint64_t revoked;    /* ... of which the response says revoked */
+} SPARETOOLS_OCSPCACHE_STATS;
+
+/**
+ * Create a cache. fetch NULL selects the built-in HTTP fetcher (10 second
+ * timeout). store holds the trust anchors for responder certificates;
+ * NULL trusts each certificate's issuer as the anchor, which covers
+ * responses signed by the CA or by a responder it delegated to.
+ * refresh_interval is the period in seconds for responses without
+ * nextUpdate and the retry delay after a failure (0 selects 3600).
+ */
+SPARETOOLS_OCSPCACHE *sparetools_ocspcache_new(SPARETOOLS_OCSP_FETCH_FN fetch, void *arg,
+                                              X509_STORE *store, long refresh_interval);
+
+/** Stop the background thread, if any, and free the cache */
+void sparetools_ocspcache_free(SPARETOOLS_OCSPCACHE *cache);
+
+/**
+ * Register cert, issued by issuer, for stapling. Both are up-referenced.
+ * No response is fetched until the next refresh. Returns 1 on success.
+ */
+int sparetools_ocspcache_add(SPARETOOLS_OCSPCACHE *cache, X509 *cert, X509 *issuer);
+
+/**
+ * Validate a DER response for a registered cert and cache it. Returns 1
+ * if it was accepted, 0 if it does not validate or cert is unknown.
+ */
+int sparetools_ocspcache_set_response(SPARETOOLS_OCSPCACHE *cache, X509 *cert,
+                                      const unsigned char *der, size_t len);
+
+/**
+ * Fetch responses that are due (force: all of them) on the calling
+ * thread. The handshake path is not blocked while fetching. Returns the
+ * number of responses accepted.
+ */
+int sparetools_ocspcache_refresh(SPARETOOLS_OCSPCACHE *cache, int force);
+
+/**
+ * Refresh from a background thread that wakes every poll_seconds (0
+ * selects 60) and fetches the responses that are due; the first pass
+ * runs immediately. Returns 1 on success.
+ */
+int sparetools_ocspcache_start(SPARETOOLS_OCSPCACHE *cache, long poll_seconds);
+
+/** Stop and join the background thread; no-op if it is not running */
+void sparetools_ocspcache_stop(SPARETOOLS_OCSPCACHE *cache);
+
+/**
+ * Install the status callback on a server ctx. Clients that request
+ * status get the cached response for the certificate the connection
+ * uses; without one the extension is not acknowledged. Returns 1 on
+ * success.
+ */
+int sparetools_ocspcache_attach(SPARETOOLS_OCSPCACHE *cache, SSL_CTX *ctx);
+
+/** Snapshot of the counters */
+void sparetools_ocspcache_stats(SPARETOOLS_OCSPCACHE *cache, SPARETOOLS_OCSPCACHE_STATS *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SPARETOOLS_OCSPCACHE_H */
@@ -0,0 +1,66 @@
+#ifndef SPARETOOLS_PARAMCACHE_H
+#define SPARETOOLS_PARAMCACHE_H
+
+#include <openssl/params.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Immutable OSSL_PARAM templates
+ *
+ * OpenSSL 3.x takes algorithm settings as OSSL_PARAM arrays. Building one
+ * per call with OSSL_PARAM_BLD costs a builder, an allocation for the
+ * array and a copy of every value. Most entries never change between
+ * calls (the digest, the group, a fixed salt), and a digest or cipher
+ * name in the array makes the provider fetch that algorithm again.
+ *
+ * A cache keeps such entries as named templates (e.g. "HKDF-SHA256"),
+ * each deep-copied into one allocation at start-up. A call combines a
+ * template with its per-call values through sparetools_params_merge,
+ * which fills a caller-provided array without allocating or copying
+ * values. Unlike OSSL_PARAM_merge, per-call entries replace template
+ * entries with the same key.
+ *
+ * Templates are added before the cache is shared. Lookups and merges
+ * only read it and are safe from any number of threads.
+ */
+
+typedef struct sparetools_paramcache_st SPARETOOLS_PARAMCACHE;
+
+SPARETOOLS_PARAMCACHE *sparetools_paramcache_new(void);
+
+void sparetools_paramcache_free(SPARETOOLS_PARAMCACHE *cache);
+
+/**
+ * Copy params (OSSL_PARAM_END-terminated) into the cache as the template
+ * for name. Returns 1 on success, 0 on allocation failure or if name
+ * (case-insensitive) already has a template.
+ */
+int sparetools_paramcache_add(SPARETOOLS_PARAMCACHE *cache, const char *name,
+                              const OSSL_PARAM *params);
+
+/** Template for name (case-insensitive), or NULL if there is none */
+const OSSL_PARAM *sparetools_paramcache_get(const SPARETOOLS_PARAMCACHE *cache,
+                                            const char *name);
+
+/** Number of templates in the cache */
+int sparetools_paramcache_count(const SPARETOOLS_PARAMCACHE *cache);
+
+/**
+ * Fill out, which holds out_len entries including the end marker, with
+ * the entries of tmpl whose keys per_call does not set, followed by
+ * per_call. Either array may be NULL. Entries point at the original
+ * data, so tmpl and per_call must outlive the use of out. Returns the
+ * number of entries before the end marker, or -1 if out is too small.
+ */
+int sparetools_params_merge(const OSSL_PARAM *tmpl, const OSSL_PARAM *per_call,
+                            OSSL_PARAM *out, size_t out_len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SPARETOOLS_PARAMCACHE_H */
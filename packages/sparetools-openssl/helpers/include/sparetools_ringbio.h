@@ -0,0 +1,72 @@
+#ifndef SPARETOOLS_RINGBIO_H
+#define SPARETOOLS_RINGBIO_H
+
+#include <openssl/bio.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * BIO over caller-owned ring buffers
+ *
+ * An event loop feeding libssl through BIO_s_mem copies every record
+ * twice more than it has to: recv() into its own buffer, then BIO_write
+ * into the read BIO; BIO_read out of the write BIO, then send(). With a
+ * ring BIO the loop receives straight into the read ring
+ * (sparetools_ring_reserve + commit) and sends straight out of the write
+ * ring (sparetools_ring_peek + consume). libssl's own BIO_read and
+ * BIO_write are the only copies left.
+ *
+ * The rings are plain structs the caller allocates, with storage the
+ * caller owns; the BIO only references them. head and tail count bytes
+ * consumed and produced since init, so used = tail - head. A ring and its
+ * BIO belong to one thread (the event loop); nothing is locked.
+ *
+ * Reads from an empty ring and writes to a full one fail with the retry
+ * flag set, so SSL_read/SSL_write return SSL_ERROR_WANT_READ/WRITE.
+ * BIO_pending and BIO_wpending report the bytes in the read and write
+ * rings.
+ */
+
+typedef struct {
+    unsigned char *data;   /* Caller's storage */
+    size_t size;           /* Power of two */
+    size_t head;           /* Bytes consumed */
+    size_t tail;           /* Bytes produced */
+} SPARETOOLS_RING;
+
+/** Set up ring over data; size must be a power of two. Returns 1 on success. */
+int sparetools_ring_init(SPARETOOLS_RING *ring, unsigned char *data, size_t size);
+
+/** Bytes the ring holds */
+size_t sparetools_ring_used(const SPARETOOLS_RING *ring);
+
+/** Contiguous readable span at the head: sets *span and returns its length */
+size_t sparetools_ring_peek(const SPARETOOLS_RING *ring, const unsigned char **span);
+
+/** Drop n bytes from the head, after sending them from a peeked span */
+void sparetools_ring_consume(SPARETOOLS_RING *ring, size_t n);
+
+/** Contiguous free span at the tail: sets *span and returns its length */
+size_t sparetools_ring_reserve(SPARETOOLS_RING *ring, unsigned char **span);
+
+/** Publish n bytes written into a reserved span */
+void sparetools_ring_commit(SPARETOOLS_RING *ring, size_t n);
+
+/** The ring BIO method (source/sink) */
+const BIO_METHOD *sparetools_ringbio_method(void);
+
+/**
+ * BIO reading from in and writing to out (either may be NULL for a
+ * one-way BIO). The rings must outlive the BIO. For a TLS connection,
+ * SSL_set_bio(ssl, bio, bio) with the loop's receive and send rings.
+ */
+BIO *sparetools_ringbio_new(SPARETOOLS_RING *in, SPARETOOLS_RING *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SPARETOOLS_RINGBIO_H */
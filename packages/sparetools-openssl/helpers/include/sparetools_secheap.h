@@ -0,0 +1,69 @@
+#ifndef SPARETOOLS_SECHEAP_H
+#define SPARETOOLS_SECHEAP_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * OpenSSL secure heap set-up at start-up
+ *
+ * CRYPTO_secure_malloc_init reserves one mlock()ed, guard-paged arena
+ * that BN_secure_new, OPENSSL_secure_malloc and therefore every private
+ * key (RSA/EC/DH private BIGNUMs, X25519/Ed25519/ML-KEM key bytes) is
+ * allocated from afterwards. There is no openssl.cnf directive for it, so
+ * the process has to call it before its first key is created.
+ *
+ * The arena is a buddy allocator behind one global lock: every private
+ * key allocation and free in the process takes it, which is the
+ * contention bench_secheap measures. When the arena is full, secure
+ * allocations fail instead of falling back to malloc, so size it for
+ * the keys held at once (long-term keys plus one ephemeral key share per
+ * handshake in flight), not for the key count.
+ *
+ * In packages built with secure_heap=SIZE[:MINSIZE], linking
+ * SpareTools::secheap initialises the arena from a load-time constructor;
+ * SPARETOOLS_SECURE_HEAP overrides the built-in size and "0" disables it.
+ */
+
+typedef struct {
+    size_t size;       /* Arena size in bytes (0: not initialised) */
+    size_t min_size;   /* Smallest allocation unit */
+    size_t used;       /* Bytes allocated from the arena now */
+    int locked;        /* 1 if mlock() succeeded, 0 if the pages may be swapped */
+} SPARETOOLS_SECHEAP_INFO;
+
+/**
+ * Initialise the secure heap. size and min_size must be powers of two
+ * and min_size smaller than size (CRYPTO_secure_malloc_init silently
+ * fails otherwise, so they are checked here). Returns 1 with the arena
+ * locked, 2 when it could not be mlock()ed (RLIMIT_MEMLOCK) but is in
+ * use, 0 on failure, also when OpenSSL was built without secure memory.
+ * A second call with a heap already in place returns its state.
+ */
+int sparetools_secheap_init(size_t size, size_t min_size);
+
+/**
+ * Parse "SIZE[:MINSIZE]" with an optional K/M/G suffix on either value
+ * (min_size defaults to 32). Returns 0 on success, -1 on a malformed
+ * spec; "0" parses to size 0 (disabled).
+ */
+int sparetools_secheap_parse(const char *spec, size_t *size, size_t *min_size);
+
+/**
+ * Initialise from SPARETOOLS_SECURE_HEAP, or from default_spec when the
+ * variable is unset. Returns what sparetools_secheap_init returns, -1
+ * for a malformed spec and 0 when the spec is "0" or both are missing.
+ */
+int sparetools_secheap_init_from_env(const char *default_spec);
+
+/** Current arena state */
+void sparetools_secheap_info(SPARETOOLS_SECHEAP_INFO *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SPARETOOLS_SECHEAP_H */
@@ -0,0 +1,93 @@
+#ifndef SPARETOOLS_SESSCACHE_H
+#define SPARETOOLS_SESSCACHE_H
+
+#include <openssl/ssl.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Server-side session resumption helpers for high connection rates
+ *
+ * OpenSSL's internal server session cache is one hash table behind one
+ * lock per SSL_CTX; with many accept threads sharing a context, every
+ * full handshake (insert) and resumption (lookup) serializes on it.
+ *
+ * SPARETOOLS_SESSCACHE replaces it through the external cache callbacks
+ * (SSL_CTX_sess_set_new_cb/get_cb/remove_cb) with a cache split into
+ * shards by session ID, each with its own lock and LRU list, so
+ * threads only contend when they touch the same shard. It serves TLS 1.2
+ * session-ID resumption and TLS 1.3 stateful tickets (SSL_OP_NO_TICKET).
+ *
+ * SPARETOOLS_TICKETKEYS serves stateless TLS 1.3/1.2 tickets instead:
+ * AES-256-CBC + HMAC-SHA256 ticket protection through
+ * SSL_CTX_set_tlsext_ticket_key_evp_cb with a current and a previous key.
+ * Keys rotate on a fixed period; tickets sealed under the previous key
+ * still decrypt and are re-issued under the current one, so a rotation
+ * does not cost a full handshake. Several SSL_CTXs can share one key set.
+ *
+ * Both objects are thread-safe and must outlive every SSL_CTX they are
+ * attached to.
+ */
+
+typedef struct sparetools_sesscache_st SPARETOOLS_SESSCACHE;
+typedef struct sparetools_ticketkeys_st SPARETOOLS_TICKETKEYS;
+
+typedef struct {
+    uint64_t hits;       /* get callback returned a live session */
+    uint64_t misses;     /* unknown or expired session ID */
+    uint64_t stores;     /* sessions added by the new callback */
+    uint64_t evictions;  /* sessions dropped to respect capacity */
+    uint64_t entries;    /* sessions currently cached */
+} SPARETOOLS_SESSCACHE_STATS;
+
+/**
+ * Create a cache with num_shards shards (rounded up to a power of two,
+ * 0 selects 64) holding at most capacity sessions in total (0 selects
+ * SSL_SESSION_CACHE_MAX_SIZE_DEFAULT).
+ */
+SPARETOOLS_SESSCACHE *sparetools_sesscache_new(size_t num_shards, size_t capacity);
+
+void sparetools_sesscache_free(SPARETOOLS_SESSCACHE *cache);
+
+/**
+ * Install the cache on a server ctx: enables SSL_SESS_CACHE_SERVER with
+ * SSL_SESS_CACHE_NO_INTERNAL and sets the new/get/remove callbacks.
+ * Session lifetime still follows SSL_CTX_set_timeout(). Returns 1 on
+ * success.
+ */
+int sparetools_sesscache_attach(SPARETOOLS_SESSCACHE *cache, SSL_CTX *ctx);
+
+/** Snapshot of the counters summed over all shards */
+void sparetools_sesscache_stats(SPARETOOLS_SESSCACHE *cache, SPARETOOLS_SESSCACHE_STATS *stats);
+
+/**
+ * Create a ticket key set rotating every rotate_seconds (0 disables
+ * automatic rotation). Keys come from RAND_bytes().
+ */
+SPARETOOLS_TICKETKEYS *sparetools_ticketkeys_new(long rotate_seconds);
+
+void sparetools_ticketkeys_free(SPARETOOLS_TICKETKEYS *keys);
+
+/**
+ * Install the key callback on ctx; session tickets stay enabled. Returns
+ * 1 on success.
+ */
+int sparetools_ticketkeys_attach(SPARETOOLS_TICKETKEYS *keys, SSL_CTX *ctx);
+
+/**
+ * Rotate now: the current key becomes the previous one and a fresh key
+ * becomes current. Returns 1 on success.
+ */
+int sparetools_ticketkeys_rotate(SPARETOOLS_TICKETKEYS *keys);
+
+/** Number of rotations so far (automatic and explicit) */
+uint64_t sparetools_ticketkeys_rotations(SPARETOOLS_TICKETKEYS *keys);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SPARETOOLS_SESSCACHE_H */
@@ -0,0 +1,70 @@
+#ifndef SPARETOOLS_SIGNCTX_H
+#define SPARETOOLS_SIGNCTX_H
+
+#include <openssl/evp.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Long-lived signing contexts for one key (POSIX threads)
+ *
+ * Each EVP_DigestSignInit on a fresh EVP_MD_CTX fetches the signature
+ * and digest implementations, builds an EVP_PKEY_CTX, exports or
+ * references the key in the provider and sets the signature parameters,
+ * all before the first byte is hashed. A SPARETOOLS_SIGNCTX does that
+ * once per thread: each thread's EVP_MD_CTX is initialised with the key
+ * on its first signature, and later ones re-initialise it with pkey
+ * NULL, which keeps the EVP_PKEY_CTX and the signature implementation
+ * and only restarts the provider's digest-sign state. Callers that hash themselves use
+ * sparetools_signctx_sign_digest() instead: each thread keeps an
+ * EVP_PKEY_CTX initialised for signing, and EVP_PKEY_sign can be repeated
+ * on it without any re-initialisation.
+ *
+ * Works with any key the provider signs with: ECDSA, Ed25519/Ed448 (with
+ * mdname NULL, message signing only), RSA (PSS through params). The
+ * context holds a reference to the key; per-thread contexts are freed
+ * when their thread exits or with the SPARETOOLS_SIGNCTX. Each
+ * SPARETOOLS_SIGNCTX uses one pthread key, so keep them per signing key,
+ * not per request. bench_signctx measures the savings.
+ */
+
+typedef struct sparetools_signctx_st SPARETOOLS_SIGNCTX;
+
+/**
+ * Set up signing with key. mdname is the digest ("SHA2-256"), NULL for
+ * EdDSA or the key type's default; params (may be NULL) are applied after
+ * init, e.g. OSSL_SIGNATURE_PARAM_PAD_MODE and _PSS_SALTLEN for RSA-PSS.
+ * Returns NULL if the key cannot sign with these settings.
+ */
+SPARETOOLS_SIGNCTX *sparetools_signctx_new(EVP_PKEY *key, const char *mdname, OSSL_LIB_CTX *libctx,
+                                           const char *propq, const OSSL_PARAM params[]);
+
+/** Call once the threads that signed with ctx no longer use it */
+void sparetools_signctx_free(SPARETOOLS_SIGNCTX *ctx);
+
+/** Largest signature the key produces (EVP_PKEY_get_size) */
+size_t sparetools_signctx_max_size(const SPARETOOLS_SIGNCTX *ctx);
+
+/**
+ * Sign tbs as EVP_DigestSign would. *sig_len holds the size of sig on
+ * input and the signature length on output. Returns 1 on success.
+ */
+int sparetools_signctx_sign(SPARETOOLS_SIGNCTX *ctx, const unsigned char *tbs, size_t tbs_len,
+                            unsigned char *sig, size_t *sig_len);
+
+/**
+ * Sign a digest computed by the caller with mdname (EVP_PKEY_sign); the
+ * signature equals sparetools_signctx_sign() over the message. Not
+ * available for EdDSA (returns 0).
+ */
+int sparetools_signctx_sign_digest(SPARETOOLS_SIGNCTX *ctx, const unsigned char *dgst, size_t dgst_len,
+                                   unsigned char *sig, size_t *sig_len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SPARETOOLS_SIGNCTX_H */
@@ -0,0 +1,81 @@
+#ifndef SPARETOOLS_THREADCTX_H
+#define SPARETOOLS_THREADCTX_H
+
+#include <stddef.h>
+#include <openssl/crypto.h>
+
+#include "sparetools_algcache.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Per-thread OSSL_LIB_CTX isolation (POSIX threads)
+ *
+ * Every fetch, name lookup and provider query in the default library
+ * context goes through one method store and one name map, each behind a
+ * process-wide lock. A pool gives each worker thread its own
+ * OSSL_LIB_CTX instead, with its own provider loads, config and a
+ * SpareTools::algcache of pre-fetched digests and ciphers, so those locks
+ * are never shared. The price is memory and start-up per context (the
+ * providers, their algorithm tables and the caches are duplicated);
+ * bench_libctx measures both.
+ *
+ * A thread's context is created on its first sparetools_threadctx_get()
+ * and freed when the thread exits or the pool is freed. Objects are bound
+ * to the context they were created in: keys, SSL_CTXs and fetched
+ * algorithms must be created per thread from that context (passing a key
+ * from another context works but re-exports it on every use).
+ */
+
+typedef struct sparetools_threadctx_pool_st SPARETOOLS_THREADCTX_POOL;
+typedef struct sparetools_threadctx_st SPARETOOLS_THREADCTX;
+
+typedef struct {
+    const char *const *providers;     /* NULL-terminated; NULL loads "default" (nothing with config_file) */
+    const char *config_file;          /* Loaded into each context first (OSSL_LIB_CTX_load_config), or NULL */
+    const char *propq;                /* Default properties of each context, or NULL */
+    const char *const *md_names;      /* Pre-fetched digests, NULL for the algcache defaults */
+    const char *const *cipher_names;  /* Pre-fetched ciphers, NULL for the algcache defaults */
+} SPARETOOLS_THREADCTX_CONFIG;
+
+typedef struct {
+    size_t contexts;       /* Contexts alive now */
+    size_t created;        /* Contexts created since the pool was */
+    double setup_seconds;  /* Total time spent creating them */
+} SPARETOOLS_THREADCTX_STATS;
+
+/** Create a pool; cfg is copied and may be NULL for the defaults. */
+SPARETOOLS_THREADCTX_POOL *sparetools_threadctx_pool_new(const SPARETOOLS_THREADCTX_CONFIG *cfg);
+
+/**
+ * Free every context still alive. Call it once the threads that used
+ * the pool have been joined or no longer touch its contexts.
+ */
+void sparetools_threadctx_pool_free(SPARETOOLS_THREADCTX_POOL *pool);
+
+/**
+ * The calling thread's context, created on first use. NULL when the
+ * context could not be set up (a provider failed to load); the next
+ * call tries again.
+ */
+const SPARETOOLS_THREADCTX *sparetools_threadctx_get(SPARETOOLS_THREADCTX_POOL *pool);
+
+/** Create a standalone context with cfg (not tied to a thread or pool) */
+SPARETOOLS_THREADCTX *sparetools_threadctx_new(const SPARETOOLS_THREADCTX_CONFIG *cfg);
+
+void sparetools_threadctx_free(SPARETOOLS_THREADCTX *ctx);
+
+OSSL_LIB_CTX *sparetools_threadctx_libctx(const SPARETOOLS_THREADCTX *ctx);
+
+/** Digests and ciphers pre-fetched from the context */
+const SPARETOOLS_ALGCACHE *sparetools_threadctx_algcache(const SPARETOOLS_THREADCTX *ctx);
+
+void sparetools_threadctx_pool_stats(SPARETOOLS_THREADCTX_POOL *pool, SPARETOOLS_THREADCTX_STATS *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SPARETOOLS_THREADCTX_H */
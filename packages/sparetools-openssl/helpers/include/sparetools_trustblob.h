@@ -0,0 +1,69 @@
+#ifndef SPARETOOLS_TRUSTBLOB_H
+#define SPARETOOLS_TRUSTBLOB_H
+
+#include <openssl/x509.h>
+#include <openssl/x509_vfy.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Precompiled trust store: a CA bundle as one memory-mappable file
+ *
+ * X509_STORE_load_locations on a PEM bundle base64-decodes and parses
+ * every certificate at startup, although a verification usually needs
+ * one or two of them. A hashed directory (c_rehash) avoids the parsing
+ * but costs a stat() and a file read per lookup, including every miss.
+ *
+ * A trust blob holds the bundle's certificates as DER, preceded by an
+ * index sorted by subject name hash (X509_NAME_hash_ex, the c_rehash
+ * hash). Opening it maps the file and checks the index; nothing is
+ * decoded. Attached to an X509_STORE as an X509_LOOKUP, it decodes only
+ * the certificates whose subject a verification asks for, and adds them
+ * to the store, the way the hashed-directory lookup does.
+ *
+ * Layout (integers little-endian):
+ *
+ *   header  "STTRUST\0", u32 version (1), u32 count, u32 index offset,
+ *           u32 data offset, u32 data size, u32 reserved
+ *   index   count x {u32 subject hash, u32 DER offset, u32 DER length,
+ *           u32 reserved}, sorted by hash; offsets relative to the data
+ *   data    the DER certificates
+ *
+ * The packaged ssl/cert.stb is compiled from ssl/cert.pem by the
+ * sparetools_trustblob tool (user.sparetools:ca_bundle).
+ */
+
+typedef struct sparetools_trustblob_st SPARETOOLS_TRUSTBLOB;
+
+/** Write certs as a trust blob. Returns 1 on success. */
+int sparetools_trustblob_write(STACK_OF(X509) *certs, const char *blob_path);
+
+/**
+ * Compile a PEM bundle into a trust blob. Returns the number of
+ * certificates written, or -1 on error.
+ */
+int sparetools_trustblob_compile(const char *pem_path, const char *blob_path);
+
+/** Map and validate a trust blob; NULL if it is missing or malformed */
+SPARETOOLS_TRUSTBLOB *sparetools_trustblob_open(const char *blob_path);
+
+/** Unmap the blob; every store it is attached to must be freed first */
+void sparetools_trustblob_free(SPARETOOLS_TRUSTBLOB *blob);
+
+/** Number of certificates in the blob */
+int sparetools_trustblob_count(const SPARETOOLS_TRUSTBLOB *blob);
+
+/**
+ * Add the blob to store as a certificate lookup. Certificates decoded
+ * for one store are cached in the blob and shared with the others it is
+ * attached to. A store takes at most one blob. Returns 1 on success.
+ */
+int sparetools_trustblob_attach(SPARETOOLS_TRUSTBLOB *blob, X509_STORE *store);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SPARETOOLS_TRUSTBLOB_H */
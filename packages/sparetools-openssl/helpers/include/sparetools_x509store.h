@@ -0,0 +1,64 @@
+#ifndef SPARETOOLS_X509STORE_H
+#define SPARETOOLS_X509STORE_H
+
+#include <openssl/x509.h>
+#include <openssl/x509_vfy.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Shared, immutable trust store for certificate chain verification
+ *
+ * An X509_STORE filled with X509_STORE_load_locations keeps its trust
+ * anchors in one stack behind one lock: every issuer lookup during
+ * X509_verify_cert takes that lock (and the first one sorts the stack),
+ * so threads verifying client certificates contend on it.
+ *
+ * SPARETOOLS_X509STORE builds the trust anchors once into an X509_STORE
+ * plus a sorted subject-name index, and replaces the store's issuer and
+ * certificate lookups with lock-free binary searches over that index.
+ * The index never changes after creation, so one store can be shared by
+ * any number of threads and SSL_CTXs. sparetools_x509store_verify() also
+ * reuses one X509_STORE_CTX per thread instead of allocating one per
+ * verification.
+ *
+ * Certificates added to the underlying X509_STORE afterwards are not in
+ * the index and will not be found; create a new store instead.
+ */
+
+typedef struct sparetools_x509store_st SPARETOOLS_X509STORE;
+
+/** Store trusting every certificate of anchors (references are taken) */
+SPARETOOLS_X509STORE *sparetools_x509store_new(STACK_OF(X509) *anchors);
+
+/** Store trusting every certificate of a PEM bundle */
+SPARETOOLS_X509STORE *sparetools_x509store_load(const char *pem_path);
+
+void sparetools_x509store_free(SPARETOOLS_X509STORE *store);
+
+/**
+ * The underlying X509_STORE, e.g. for SSL_CTX_set1_cert_store() so
+ * libssl's own peer verification uses the index too. Verification
+ * parameters (flags, depth, purpose) can be set on it before use.
+ */
+X509_STORE *sparetools_x509store_get0_store(const SPARETOOLS_X509STORE *store);
+
+/** Number of trust anchors */
+int sparetools_x509store_count(const SPARETOOLS_X509STORE *store);
+
+/**
+ * Verify leaf with the peer's intermediates (untrusted, may be NULL)
+ * on the calling thread's reused X509_STORE_CTX. Returns 1 if the chain
+ * verifies; otherwise 0, with the X509_V_ERR_* code in *error when error
+ * is not NULL.
+ */
+int sparetools_x509store_verify(SPARETOOLS_X509STORE *store, X509 *leaf,
+                                STACK_OF(X509) *untrusted, int *error);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SPARETOOLS_X509STORE_H */
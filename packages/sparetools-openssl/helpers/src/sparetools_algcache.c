@@ -0,0 +1,154 @@
+#include "sparetools_algcache.h"
+
+#include <openssl/crypto.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#define strcasecmp _stricmp
+#else
+#include <strings.h>
+#endif
+
+typedef struct {
+    const char *name;   /* Name as requested, owned by the cache */
+    void *handle;       /* EVP_MD * or EVP_CIPHER * */
+} algcache_entry;
+
+struct sparetools_algcache_st {
+    algcache_entry *mds;
+    int num_mds;
+    algcache_entry *ciphers;
+    int num_ciphers;
+};
+
+static const char *const default_md_names[] = {
+    "SHA2-256", "SHA2-384", "SHA2-512", "SHA3-256", "SHA1", NULL
+};
+
+static const char *const default_cipher_names[] = {
+    "AES-128-GCM", "AES-256-GCM", "ChaCha20-Poly1305", "AES-128-CBC", "AES-256-CBC", NULL
+};
+
+static int count_names(const char *const *names) {
+    int n = 0;
+
+    while (names[n] != NULL)
+        n++;
+    return n;
+}
+
+static void *fetch_md(OSSL_LIB_CTX *libctx, const char *name, const char *propq) {
+    return EVP_MD_fetch(libctx, name, propq);
+}
+
+static void *fetch_cipher(OSSL_LIB_CTX *libctx, const char *name, const char *propq) {
+    return EVP_CIPHER_fetch(libctx, name, propq);
+}
+
+static void release_md(void *handle) {
+    EVP_MD_free(handle);
+}
+
+static void release_cipher(void *handle) {
+    EVP_CIPHER_free(handle);
+}
+
+/**
+ * Fetch every name in names into a freshly allocated table. *count_out
+ * always holds the number of valid entries, even on failure, so the
+ * table can be released with free_table(). Returns 1 on success.
+ */
+static int fill_table(OSSL_LIB_CTX *libctx, const char *propq, const char *const *names,
+                      void *(*fetch)(OSSL_LIB_CTX *, const char *, const char *),
+                      void (*release)(void *),
+                      algcache_entry **table_out, int *count_out) {
+    int n = count_names(names);
+    algcache_entry *table = calloc(n > 0 ? (size_t)n : 1, sizeof(*table));
+
+    *table_out = table;
+    *count_out = 0;
+    if (table == NULL)
+        return 0;
+
+    for (int i = 0; i < n; i++) {
+        void *handle = fetch(libctx, names[i], propq);
+        char *name;
+
+        if (handle == NULL)
+            continue;
+        if ((name = OPENSSL_strdup(names[i])) == NULL) {
+            release(handle);
+            return 0;
+        }
+        table[*count_out].name = name;
+        table[*count_out].handle = handle;
+        (*count_out)++;
+    }
+    return 1;
+}
+
+static void free_table(algcache_entry *table, int n, void (*release)(void *)) {
+    for (int i = 0; i < n; i++) {
+        release(table[i].handle);
+        OPENSSL_free((char *)table[i].name);
+    }
+    free(table);
+}
+
+static const void *lookup(const algcache_entry *table, int n, const char *name) {
+    for (int i = 0; i < n; i++) {
+        if (strcasecmp(table[i].name, name) == 0)
+            return table[i].handle;
+    }
+    return NULL;
+}
+
+SPARETOOLS_ALGCACHE *sparetools_algcache_new(OSSL_LIB_CTX *libctx, const char *propq,
+                                             const char *const *md_names,
+                                             const char *const *cipher_names) {
+    SPARETOOLS_ALGCACHE *cache = calloc(1, sizeof(*cache));
+
+    if (cache == NULL)
+        return NULL;
+    if (md_names == NULL)
+        md_names = default_md_names;
+    if (cipher_names == NULL)
+        cipher_names = default_cipher_names;
+
+    if (!fill_table(libctx, propq, md_names, fetch_md, release_md, &cache->mds, &cache->num_mds)
+        || !fill_table(libctx, propq, cipher_names, fetch_cipher, release_cipher,
+                       &cache->ciphers, &cache->num_ciphers)) {
+        sparetools_algcache_free(cache);
+        return NULL;
+    }
+    return cache;
+}
+
+void sparetools_algcache_free(SPARETOOLS_ALGCACHE *cache) {
+    if (cache == NULL)
+        return;
+
+    free_table(cache->mds, cache->num_mds, release_md);
+    free_table(cache->ciphers, cache->num_ciphers, release_cipher);
+    free(cache);
+}
+
+const EVP_MD *sparetools_algcache_md(const SPARETOOLS_ALGCACHE *cache, const char *name) {
+    if (cache == NULL || name == NULL)
+        return NULL;
+    return lookup(cache->mds, cache->num_mds, name);
+}
+
+const EVP_CIPHER *sparetools_algcache_cipher(const SPARETOOLS_ALGCACHE *cache,
+                                             const char *name) {
+    if (cache == NULL || name == NULL)
+        return NULL;
+    return lookup(cache->ciphers, cache->num_ciphers, name);
+}
+
+int sparetools_algcache_count(const SPARETOOLS_ALGCACHE *cache) {
+    if (cache == NULL)
+        return 0;
+    return cache->num_mds + cache->num_ciphers;
+}
@@ -0,0 +1,74 @@
+#include "sparetools_allocator.h"
+
+#include <openssl/crypto.h>
+#include <stddef.h>
+
+#if defined(SPARETOOLS_ALLOCATOR_JEMALLOC)
+#include <jemalloc/jemalloc.h>
+#define SHIM_NAME "jemalloc"
+/* rallocx/dallocx do not accept NULL, unlike realloc/free */
+#define shim_malloc(n) mallocx((n) ? (n) : 1, 0)
+#define shim_realloc(p, n) ((p) ? rallocx((p), (n) ? (n) : 1, 0) : mallocx((n) ? (n) : 1, 0))
+#define shim_free(p) do { if ((p) != NULL) dallocx((p), 0); } while (0)
+#elif defined(SPARETOOLS_ALLOCATOR_MIMALLOC)
+#include <mimalloc.h>
+#define SHIM_NAME "mimalloc"
+#define shim_malloc(n) mi_malloc(n)
+#define shim_realloc(p, n) mi_realloc((p), (n))
+#define shim_free(p) mi_free(p)
+#elif defined(SPARETOOLS_ALLOCATOR_TCMALLOC)
+#include <gperftools/tcmalloc.h>
+#define SHIM_NAME "tcmalloc"
+#define shim_malloc(n) tc_malloc(n)
+#define shim_realloc(p, n) tc_realloc((p), (n))
+#define shim_free(p) tc_free(p)
+#else
+#error "Define SPARETOOLS_ALLOCATOR_JEMALLOC, _MIMALLOC or _TCMALLOC"
+#endif
+
+static void *shim_crypto_malloc(size_t num, const char *file, int line) {
+    (void)file;
+    (void)line;
+    return shim_malloc(num);
+}
+
+static void *shim_crypto_realloc(void *addr, size_t num, const char *file, int line) {
+    (void)file;
+    (void)line;
+    return shim_realloc(addr, num);
+}
+
+static void shim_crypto_free(void *addr, const char *file, int line) {
+    (void)file;
+    (void)line;
+    shim_free(addr);
+}
+
+int sparetools_allocator_install(void) {
+    CRYPTO_malloc_fn m;
+    CRYPTO_realloc_fn r;
+    CRYPTO_free_fn f;
+
+    if (CRYPTO_set_mem_functions(shim_crypto_malloc, shim_crypto_realloc, shim_crypto_free))
+        return 1;
+    /* Too late to install (OpenSSL already allocated); report what is active */
+    CRYPTO_get_mem_functions(&m, &r, &f);
+    return m == shim_crypto_malloc;
+}
+
+const char *sparetools_allocator_name(void) {
+    return SHIM_NAME;
+}
+
+#if defined(__GNUC__) || defined(__clang__)
+__attribute__((constructor))
+static void shim_autoinstall(void) {
+    sparetools_allocator_install();
+}
+#elif defined(_MSC_VER)
+static void __cdecl shim_autoinstall(void) {
+    sparetools_allocator_install();
+}
+#pragma section(".CRT$XCU", read)
+__declspec(allocate(".CRT$XCU")) void (__cdecl *sparetools_allocator_autoinstall)(void) = shim_autoinstall;
+#endif
@@ -0,0 +1,362 @@
+#include "sparetools_batchverify.h"
+
+#include <openssl/err.h>
+#include <openssl/rsa.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/*
+ * Each thread owns a contiguous range of 64-item chunks and takes them
+ * from the front with an atomic increment; when its range is exhausted it
+ * takes chunks from the other threads' ranges the same way. A chunk covers
+ * whole bitmap bytes, so threads never write the same byte.
+ *
+ * Per-thread EVP_PKEY_CTX caches are direct-mapped by key pointer and
+ * algorithm. A cached context holds a reference to its key, so the
+ * pointer cannot be reused by another key while the entry exists.
+ */
+
+#define CHUNK_ITEMS 64
+#define CACHE_SLOTS 64
+#define MAX_THREADS 256
+#define NUM_ALGS 3
+
+typedef struct {
+    EVP_PKEY *key;
+    SPARETOOLS_SIG_ALG alg;
+    EVP_PKEY_CTX *ctx;
+} ctx_slot;
+
+typedef struct {
+    _Alignas(64) atomic_size_t next;   /* Next chunk of this range */
+    size_t end;
+    SPARETOOLS_BATCHVERIFY *verifier;
+    int index;
+    pthread_t thread;
+    EVP_MD_CTX *digest_ctx;            /* SHA2-256 for ECDSA and RSA-PSS */
+    EVP_MD_CTX *verify_ctx;            /* EVP_DigestVerify for Ed25519 */
+    ctx_slot cache[CACHE_SLOTS];
+    size_t valid;
+} worker;
+
+struct sparetools_batchverify_st {
+    OSSL_LIB_CTX *libctx;
+    char *propq;
+    EVP_MD *sha256;
+    EVP_SIGNATURE *signatures[NUM_ALGS];  /* Pinned; NULL if not offered */
+
+    int threads;
+    worker *workers;
+
+    pthread_mutex_t run_lock;             /* One batch at a time */
+    pthread_mutex_t lock;
+    pthread_cond_t start;
+    pthread_cond_t done;
+    uint64_t generation;
+    int pending;
+    int shutdown;
+
+    const SPARETOOLS_VERIFY_ITEM *items;
+    size_t n;
+    uint8_t *bitmap;
+};
+
+static const char *const signature_names[NUM_ALGS] = {"ED25519", "ECDSA", "RSA"};
+
+static size_t slot_index(const EVP_PKEY *key, SPARETOOLS_SIG_ALG alg) {
+    uintptr_t h = (uintptr_t)key;
+
+    /* Keys are heap objects: the low bits carry no information */
+    h = (h >> 4) ^ (h >> 12) ^ (uintptr_t)alg;
+    return (size_t)(h % CACHE_SLOTS);
+}
+
+static void clear_slot(ctx_slot *slot) {
+    EVP_PKEY_CTX_free(slot->ctx);
+    memset(slot, 0, sizeof(*slot));
+}
+
+/**
+ * Context for key/alg: initialised for EVP_PKEY_verify (ECDSA, RSA-PSS)
+ * or ready to attach to an EVP_MD_CTX (Ed25519). NULL if the key cannot
+ * be used with the algorithm.
+ */
+static EVP_PKEY_CTX *cached_ctx(worker *w, EVP_PKEY *key, SPARETOOLS_SIG_ALG alg) {
+    SPARETOOLS_BATCHVERIFY *v = w->verifier;
+    ctx_slot *slot = &w->cache[slot_index(key, alg)];
+    EVP_PKEY_CTX *ctx;
+    int ok = 1;
+
+    if (slot->ctx != NULL && slot->key == key && slot->alg == alg)
+        return slot->ctx;
+
+    clear_slot(slot);
+    ctx = EVP_PKEY_CTX_new_from_pkey(v->libctx, key, v->propq);
+    if (ctx == NULL)
+        return NULL;
+    if (alg != SPARETOOLS_SIG_ED25519) {
+        ok = EVP_PKEY_verify_init(ctx) == 1
+            && EVP_PKEY_CTX_set_signature_md(ctx, v->sha256) == 1;
+        if (ok && alg == SPARETOOLS_SIG_RSA_PSS_SHA256)
+            ok = EVP_PKEY_CTX_set_rsa_padding(ctx, RSA_PKCS1_PSS_PADDING) == 1
+                && EVP_PKEY_CTX_set_rsa_mgf1_md(ctx, v->sha256) == 1
+                && EVP_PKEY_CTX_set_rsa_pss_saltlen(ctx, RSA_PSS_SALTLEN_DIGEST) == 1;
+    }
+    if (!ok) {
+        EVP_PKEY_CTX_free(ctx);
+        return NULL;
+    }
+    slot->key = key;
+    slot->alg = alg;
+    slot->ctx = ctx;
+    return ctx;
+}
+
+static int verify_item(worker *w, const SPARETOOLS_VERIFY_ITEM *item) {
+    SPARETOOLS_BATCHVERIFY *v = w->verifier;
+    unsigned char digest[EVP_MAX_MD_SIZE];
+    unsigned int digest_len = 0;
+    EVP_PKEY_CTX *ctx;
+    int ok;
+
+    if (item->key == NULL || (unsigned)item->alg >= NUM_ALGS || v->signatures[item->alg] == NULL)
+        return 0;
+    if ((ctx = cached_ctx(w, item->key, item->alg)) == NULL)
+        return 0;
+
+    if (item->alg == SPARETOOLS_SIG_ED25519) {
+        /* The attached context is kept (not freed) by the EVP_MD_CTX */
+        EVP_MD_CTX_set_pkey_ctx(w->verify_ctx, ctx);
+        ok = EVP_DigestVerifyInit_ex(w->verify_ctx, NULL, NULL, v->libctx, v->propq, NULL, NULL) == 1
+            && EVP_DigestVerify(w->verify_ctx, item->sig, item->sig_len, item->msg, item->msg_len) == 1;
+        EVP_MD_CTX_set_pkey_ctx(w->verify_ctx, NULL);
+    } else {
+        ok = EVP_DigestInit_ex2(w->digest_ctx, v->sha256, NULL)
+            && EVP_DigestUpdate(w->digest_ctx, item->msg, item->msg_len)
+            && EVP_DigestFinal_ex(w->digest_ctx, digest, &digest_len)
+            && EVP_PKEY_verify(ctx, item->sig, item->sig_len, digest, digest_len) == 1;
+    }
+    if (!ok)
+        ERR_clear_error();
+    return ok;
+}
+
+static void verify_chunk(worker *w, size_t chunk) {
+    SPARETOOLS_BATCHVERIFY *v = w->verifier;
+    size_t begin = chunk * CHUNK_ITEMS;
+    size_t end = begin + CHUNK_ITEMS < v->n ? begin + CHUNK_ITEMS : v->n;
+
+    for (size_t byte = begin / 8; byte * 8 < end; byte++) {
+        uint8_t bits = 0;
+
+        for (size_t i = byte * 8; i < byte * 8 + 8 && i < end; i++) {
+            if (verify_item(w, &v->items[i])) {
+                bits |= (uint8_t)(1u << (i % 8));
+                w->valid++;
+            }
+        }
+        v->bitmap[byte] = bits;
+    }
+}
+
+static void verify_batch(worker *w) {
+    SPARETOOLS_BATCHVERIFY *v = w->verifier;
+    size_t chunk;
+
+    w->valid = 0;
+    /* Own range first, then help the others */
+    for (int k = 0; k < v->threads; k++) {
+        worker *from = &v->workers[(w->index + k) % v->threads];
+
+        while ((chunk = atomic_fetch_add_explicit(&from->next, 1, memory_order_relaxed)) < from->end)
+            verify_chunk(w, chunk);
+    }
+}
+
+static void *worker_main(void *arg) {
+    worker *w = arg;
+    SPARETOOLS_BATCHVERIFY *v = w->verifier;
+    uint64_t seen = 0;
+
+    for (;;) {
+        pthread_mutex_lock(&v->lock);
+        while (v->generation == seen && !v->shutdown)
+            pthread_cond_wait(&v->start, &v->lock);
+        if (v->shutdown) {
+            pthread_mutex_unlock(&v->lock);
+            break;
+        }
+        seen = v->generation;
+        pthread_mutex_unlock(&v->lock);
+
+        verify_batch(w);
+
+        pthread_mutex_lock(&v->lock);
+        if (--v->pending == 0)
+            pthread_cond_signal(&v->done);
+        pthread_mutex_unlock(&v->lock);
+    }
+    /* Thread-local OpenSSL state (error queue, DRBGs) */
+    OPENSSL_thread_stop();
+    return NULL;
+}
+
+static void free_worker(worker *w) {
+    for (int i = 0; i < CACHE_SLOTS; i++)
+        clear_slot(&w->cache[i]);
+    EVP_MD_CTX_free(w->digest_ctx);
+    EVP_MD_CTX_free(w->verify_ctx);
+}
+
+SPARETOOLS_BATCHVERIFY *sparetools_batchverify_new(OSSL_LIB_CTX *libctx, const char *propq,
+                                                   int threads) {
+    SPARETOOLS_BATCHVERIFY *v;
+    int started = 1;
+
+    if (threads <= 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = cpus > 0 ? (int)cpus : 1;
+    }
+    if (threads > MAX_THREADS)
+        threads = MAX_THREADS;
+
+    if ((v = calloc(1, sizeof(*v))) == NULL)
+        return NULL;
+    v->libctx = libctx;
+    v->threads = threads;
+    if (propq != NULL && (v->propq = OPENSSL_strdup(propq)) == NULL)
+        goto err;
+    if ((v->sha256 = EVP_MD_fetch(libctx, "SHA2-256", propq)) == NULL)
+        goto err;
+    for (int a = 0; a < NUM_ALGS; a++)
+        v->signatures[a] = EVP_SIGNATURE_fetch(libctx, signature_names[a], propq);
+    ERR_clear_error();
+
+    /* Workers are aligned for their chunk counters; aligned_alloc needs a multiple */
+    v->workers = aligned_alloc(64, ((sizeof(worker) * threads + 63) / 64) * 64);
+    if (v->workers == NULL)
+        goto err;
+    memset(v->workers, 0, sizeof(worker) * threads);
+    for (int i = 0; i < threads; i++) {
+        worker *w = &v->workers[i];
+
+        w->verifier = v;
+        w->index = i;
+        w->digest_ctx = EVP_MD_CTX_new();
+        w->verify_ctx = EVP_MD_CTX_new();
+        if (w->digest_ctx == NULL || w->verify_ctx == NULL) {
+            v->threads = i + 1;
+            goto err;
+        }
+    }
+
+    pthread_mutex_init(&v->run_lock, NULL);
+    pthread_mutex_init(&v->lock, NULL);
+    pthread_cond_init(&v->start, NULL);
+    pthread_cond_init(&v->done, NULL);
+
+    /* Worker 0 is the thread calling sparetools_batchverify_run() */
+    for (; started < threads; started++) {
+        if (pthread_create(&v->workers[started].thread, NULL, worker_main, &v->workers[started]) != 0)
+            break;
+    }
+    if (started < threads) {
+        v->threads = started;
+        sparetools_batchverify_free(v);
+        return NULL;
+    }
+    return v;
+
+ err:
+    if (v->workers != NULL) {
+        for (int i = 0; i < v->threads; i++)
+            free_worker(&v->workers[i]);
+        free(v->workers);
+    }
+    for (int a = 0; a < NUM_ALGS; a++)
+        EVP_SIGNATURE_free(v->signatures[a]);
+    EVP_MD_free(v->sha256);
+    OPENSSL_free(v->propq);
+    free(v);
+    return NULL;
+}
+
+void sparetools_batchverify_free(SPARETOOLS_BATCHVERIFY *v) {
+    if (v == NULL)
+        return;
+
+    pthread_mutex_lock(&v->lock);
+    v->shutdown = 1;
+    pthread_cond_broadcast(&v->start);
+    pthread_mutex_unlock(&v->lock);
+    for (int i = 1; i < v->threads; i++)
+        pthread_join(v->workers[i].thread, NULL);
+
+    for (int i = 0; i < v->threads; i++)
+        free_worker(&v->workers[i]);
+    free(v->workers);
+    pthread_cond_destroy(&v->start);
+    pthread_cond_destroy(&v->done);
+    pthread_mutex_destroy(&v->lock);
+    pthread_mutex_destroy(&v->run_lock);
+    for (int a = 0; a < NUM_ALGS; a++)
+        EVP_SIGNATURE_free(v->signatures[a]);
+    EVP_MD_free(v->sha256);
+    OPENSSL_free(v->propq);
+    free(v);
+}
+
+int sparetools_batchverify_threads(const SPARETOOLS_BATCHVERIFY *v) {
+    return v != NULL ? v->threads : 0;
+}
+
+size_t sparetools_batchverify_run(SPARETOOLS_BATCHVERIFY *v, const SPARETOOLS_VERIFY_ITEM *items,
+                                  size_t n, uint8_t *bitmap) {
+    size_t chunks, per_thread, valid = 0;
+
+    if (v == NULL || n == 0)
+        return 0;
+
+    pthread_mutex_lock(&v->run_lock);
+    v->items = items;
+    v->n = n;
+    v->bitmap = bitmap;
+
+    chunks = (n + CHUNK_ITEMS - 1) / CHUNK_ITEMS;
+    per_thread = (chunks + v->threads - 1) / v->threads;
+    for (int i = 0; i < v->threads; i++) {
+        size_t begin = (size_t)i * per_thread;
+
+        v->workers[i].end = begin + per_thread < chunks ? begin + per_thread : chunks;
+        atomic_store_explicit(&v->workers[i].next, begin < chunks ? begin : chunks, memory_order_relaxed);
+    }
+
+    /* Small batches are not worth waking the pool */
+    if (v->threads > 1 && chunks > 1) {
+        pthread_mutex_lock(&v->lock);
+        v->pending = v->threads - 1;
+        v->generation++;
+        pthread_cond_broadcast(&v->start);
+        pthread_mutex_unlock(&v->lock);
+
+        verify_batch(&v->workers[0]);
+
+        pthread_mutex_lock(&v->lock);
+        while (v->pending > 0)
+            pthread_cond_wait(&v->done, &v->lock);
+        pthread_mutex_unlock(&v->lock);
+        for (int i = 0; i < v->threads; i++)
+            valid += v->workers[i].valid;
+    } else {
+        verify_batch(&v->workers[0]);
+        valid = v->workers[0].valid;
+    }
+
+    v->items = NULL;
+    v->bitmap = NULL;
+    pthread_mutex_unlock(&v->run_lock);
+    return valid;
+}
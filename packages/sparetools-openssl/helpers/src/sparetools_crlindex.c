@@ -0,0 +1,859 @@
+#include "sparetools_crlindex.h"
+
+#include <openssl/crypto.h>
+#include <openssl/err.h>
+#include <openssl/pem.h>
+#include <openssl/x509v3.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#define INDEX_MAGIC "STCRLIX"   /* 8 bytes with the terminator */
+#define INDEX_VERSION 1
+#define HEADER_SIZE 32
+#define ENTRY_SIZE 16
+
+#define TAG_INTEGER 0x02
+#define TAG_SEQUENCE 0x30
+#define TAG_UTCTIME 0x17
+#define TAG_GENTIME 0x18
+
+/*
+ * A CRL is SEQUENCE { tbsCertList, signatureAlgorithm, signature } and
+ * tbsCertList is SEQUENCE { version?, signature, issuer, thisUpdate,
+ * nextUpdate?, revokedCertificates?, [0] crlExtensions? }. The index
+ * cuts it into the tbsCertList fields before the revoked list (prefix),
+ * the list's entries and the fields after it (suffix), so it can encode
+ * the same CRL with no entry or with one.
+ */
+typedef struct {
+    const unsigned char *der;
+    size_t der_len;
+    const unsigned char *tbs;       /* Whole tbsCertList, the signed bytes */
+    size_t tbs_len;
+    const unsigned char *prefix;
+    size_t prefix_len;
+    const unsigned char *revoked;   /* Contents of revokedCertificates */
+    size_t revoked_len;
+    const unsigned char *suffix;
+    size_t suffix_len;
+    const unsigned char *tail;      /* signatureAlgorithm and signature */
+    size_t tail_len;
+} crl_layout;
+
+typedef struct {
+    crl_layout layout;
+    const unsigned char *table;     /* u32 entry offsets sorted by serial */
+    uint32_t entries;
+    X509_CRL *empty;                /* The CRL without entries, shared */
+    EVP_PKEY *verified_key;         /* Full signature checked under it (lock) */
+} index_crl;
+
+struct sparetools_crlindex_st {
+    const unsigned char *map;
+    size_t size;
+    uint32_t count;
+    index_crl *crls;
+    CRYPTO_RWLOCK *lock;
+    atomic_uint_least64_t lookups, revoked, fallbacks, verifications;
+};
+
+/* What a store the index is attached to keeps in its ex_data */
+typedef struct {
+    SPARETOOLS_CRLINDEX *index;
+    X509_STORE_CTX_verify_cb previous;
+} store_attachment;
+
+static CRYPTO_ONCE ex_index_once = CRYPTO_ONCE_STATIC_INIT;
+static int crlindex_ex_index = -1;
+
+static void free_attachment(void *parent, void *ptr, CRYPTO_EX_DATA *ad, int idx, long argl, void *argp) {
+    (void)parent;
+    (void)ad;
+    (void)idx;
+    (void)argl;
+    (void)argp;
+    OPENSSL_free(ptr);
+}
+
+static void init_ex_index(void) {
+    crlindex_ex_index = X509_STORE_get_ex_new_index(0, "sparetools_crlindex", NULL, NULL, free_attachment);
+}
+
+static uint32_t get_u32(const unsigned char *p) {
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+static void put_u32(unsigned char *p, uint32_t v) {
+    p[0] = (unsigned char)v;
+    p[1] = (unsigned char)(v >> 8);
+    p[2] = (unsigned char)(v >> 16);
+    p[3] = (unsigned char)(v >> 24);
+}
+
+static void count(atomic_uint_least64_t *counter) {
+    atomic_fetch_add_explicit(counter, 1, memory_order_relaxed);
+}
+
+/* ---- DER ---- */
+
+typedef struct {
+    int tag;
+    size_t header;
+    size_t len;
+} der_tlv;
+
+/* One TLV with low tag number and definite length within avail bytes */
+static int der_read(const unsigned char *p, size_t avail, der_tlv *t) {
+    size_t len = 0, header = 2;
+
+    if (avail < 2 || (p[0] & 0x1f) == 0x1f)
+        return 0;
+    if (p[1] < 0x80) {
+        len = p[1];
+    } else {
+        size_t octets = p[1] & 0x7f;
+
+        if (octets == 0 || octets > 4 || avail < 2 + octets)
+            return 0;
+        for (size_t i = 0; i < octets; i++)
+            len = len << 8 | p[2 + i];
+        header += octets;
+    }
+    if (len > avail - header)
+        return 0;
+    t->tag = p[0];
+    t->header = header;
+    t->len = len;
+    return 1;
+}
+
+static size_t der_header_size(size_t len) {
+    size_t n = 2;
+
+    if (len >= 0x80)
+        for (size_t v = len; v != 0; v >>= 8)
+            n++;
+    return n;
+}
+
+static unsigned char *der_put_header(unsigned char *p, int tag, size_t len) {
+    size_t n = der_header_size(len) - 2;
+
+    *p++ = (unsigned char)tag;
+    if (n == 0) {
+        *p++ = (unsigned char)len;
+        return p;
+    }
+    *p++ = (unsigned char)(0x80 | n);
+    for (size_t i = n; i-- > 0;)
+        *p++ = (unsigned char)(len >> (8 * i));
+    return p;
+}
+
+static int is_time(int tag) {
+    return tag == TAG_UTCTIME || tag == TAG_GENTIME;
+}
+
+static int parse_crl(const unsigned char *der, size_t der_len, crl_layout *l) {
+    const unsigned char *p, *end;
+    der_tlv t;
+
+    memset(l, 0, sizeof(*l));
+    if (!der_read(der, der_len, &t) || t.tag != TAG_SEQUENCE || t.header + t.len != der_len)
+        return 0;
+    l->der = der;
+    l->der_len = der_len;
+    l->tbs = der + t.header;
+    if (!der_read(l->tbs, der_len - t.header, &t) || t.tag != TAG_SEQUENCE)
+        return 0;
+    l->tbs_len = t.header + t.len;
+    l->tail = l->tbs + l->tbs_len;
+    l->tail_len = (size_t)(der + der_len - l->tail);
+
+    p = l->prefix = l->tbs + t.header;
+    end = l->tail;
+    /* version (v2 CRLs), signature, issuer, thisUpdate */
+    if (!der_read(p, (size_t)(end - p), &t))
+        return 0;
+    if (t.tag == TAG_INTEGER) {
+        p += t.header + t.len;
+        if (!der_read(p, (size_t)(end - p), &t))
+            return 0;
+    }
+    if (t.tag != TAG_SEQUENCE)
+        return 0;
+    p += t.header + t.len;
+    if (!der_read(p, (size_t)(end - p), &t) || t.tag != TAG_SEQUENCE)
+        return 0;
+    p += t.header + t.len;
+    if (!der_read(p, (size_t)(end - p), &t) || !is_time(t.tag))
+        return 0;
+    p += t.header + t.len;
+    /* nextUpdate */
+    if (p < end && der_read(p, (size_t)(end - p), &t) && is_time(t.tag))
+        p += t.header + t.len;
+    l->prefix_len = (size_t)(p - l->prefix);
+    if (p < end && der_read(p, (size_t)(end - p), &t) && t.tag == TAG_SEQUENCE) {
+        l->revoked = p + t.header;
+        l->revoked_len = t.len;
+        p += t.header + t.len;
+    }
+    l->suffix = p;
+    l->suffix_len = (size_t)(end - p);
+    return 1;
+}
+
+/* Serial number contents of the entry at p and the entry's length */
+static int entry_serial(const unsigned char *p, size_t avail, const unsigned char **serial,
+                        size_t *serial_len, size_t *entry_len) {
+    der_tlv entry, integer;
+
+    if (!der_read(p, avail, &entry) || entry.tag != TAG_SEQUENCE
+        || !der_read(p + entry.header, entry.len, &integer) || integer.tag != TAG_INTEGER
+        || integer.len == 0)
+        return 0;
+    *serial = p + entry.header + integer.header;
+    *serial_len = integer.len;
+    *entry_len = entry.header + entry.len;
+    return 1;
+}
+
+/* DER integers are minimal, so shorter sorts first; all that matters is a total order */
+static int serial_cmp(const unsigned char *a, size_t a_len, const unsigned char *b, size_t b_len) {
+    if (a_len != b_len)
+        return a_len < b_len ? -1 : 1;
+    return memcmp(a, b, a_len);
+}
+
+/*
+ * Contents octets of sn's DER encoding, written to buf (serials are at
+ * most 20 octets, RFC 5280); NULL if it does not fit
+ */
+static const unsigned char *serial_contents(const ASN1_INTEGER *sn, unsigned char *buf, size_t buf_len,
+                                            size_t *len) {
+    unsigned char *p = buf;
+    int der_len = sn != NULL ? i2d_ASN1_INTEGER(sn, NULL) : 0;
+    der_tlv t;
+
+    if (der_len <= 0 || (size_t)der_len > buf_len || i2d_ASN1_INTEGER(sn, &p) != der_len
+        || !der_read(buf, (size_t)der_len, &t) || t.tag != TAG_INTEGER)
+        return NULL;
+    *len = t.len;
+    return buf + t.header;
+}
+
+/* DER of the CRL with entry (NULL: no revokedCertificates) */
+static unsigned char *encode_crl(const crl_layout *l, const unsigned char *entry, size_t entry_len,
+                                 size_t *len_out) {
+    size_t revoked = entry != NULL ? der_header_size(entry_len) + entry_len : 0;
+    size_t tbs = l->prefix_len + revoked + l->suffix_len;
+    size_t outer = der_header_size(tbs) + tbs + l->tail_len;
+    size_t total = der_header_size(outer) + outer;
+    unsigned char *buf = OPENSSL_malloc(total), *p;
+
+    if (buf == NULL)
+        return NULL;
+    p = der_put_header(buf, TAG_SEQUENCE, outer);
+    p = der_put_header(p, TAG_SEQUENCE, tbs);
+    memcpy(p, l->prefix, l->prefix_len);
+    p += l->prefix_len;
+    if (entry != NULL) {
+        p = der_put_header(p, TAG_SEQUENCE, entry_len);
+        memcpy(p, entry, entry_len);
+        p += entry_len;
+    }
+    memcpy(p, l->suffix, l->suffix_len);
+    p += l->suffix_len;
+    memcpy(p, l->tail, l->tail_len);
+    *len_out = total;
+    return buf;
+}
+
+static X509_CRL *decode_crl(const crl_layout *l, const unsigned char *entry, size_t entry_len) {
+    size_t len;
+    unsigned char *der = encode_crl(l, entry, entry_len, &len);
+    const unsigned char *p = der;
+    X509_CRL *crl = der != NULL ? d2i_X509_CRL(NULL, &p, (long)len) : NULL;
+
+    OPENSSL_free(der);
+    return crl;
+}
+
+/* Complete and direct: no deltaCRLIndicator, no indirectCRL in the IDP */
+static int indexable(X509_CRL *crl) {
+    ISSUING_DIST_POINT *idp;
+    int crit, ok;
+
+    if (X509_CRL_get_ext_by_NID(crl, NID_delta_crl, -1) >= 0)
+        return 0;
+    idp = X509_CRL_get_ext_d2i(crl, NID_issuing_distribution_point, &crit, NULL);
+    ok = idp == NULL ? crit == -1 : !idp->indirectCRL;
+    ISSUING_DIST_POINT_free(idp);
+    return ok;
+}
+
+/* ---- Writing ---- */
+
+typedef struct {
+    const unsigned char *serial;
+    size_t serial_len;
+    uint32_t offset;   /* Entry offset relative to the DER */
+} pending_entry;
+
+typedef struct {
+    crl_layout layout;
+    pending_entry *entries;
+    uint32_t count;
+    uint32_t der_offset;
+    uint32_t table_offset;
+} pending_crl;
+
+static int pending_cmp(const void *a, const void *b) {
+    const pending_entry *x = a, *y = b;
+    int c = serial_cmp(x->serial, x->serial_len, y->serial, y->serial_len);
+
+    return c != 0 ? c : (x->offset > y->offset) - (x->offset < y->offset);
+}
+
+static int collect_entries(pending_crl *pc) {
+    const crl_layout *l = &pc->layout;
+    size_t capacity = 0, pos = 0;
+
+    while (pos < l->revoked_len) {
+        pending_entry *e;
+        size_t entry_len;
+
+        if (pc->count == capacity) {
+            size_t grown = capacity ? capacity * 2 : 1024;
+            pending_entry *entries = OPENSSL_realloc(pc->entries, grown * sizeof(*entries));
+
+            if (entries == NULL)
+                return 0;
+            pc->entries = entries;
+            capacity = grown;
+        }
+        e = &pc->entries[pc->count];
+        if (!entry_serial(l->revoked + pos, l->revoked_len - pos, &e->serial, &e->serial_len, &entry_len)
+            || (size_t)(l->revoked + pos - l->der) > UINT32_MAX)
+            return 0;
+        e->offset = (uint32_t)(l->revoked + pos - l->der);
+        pos += entry_len;
+        pc->count++;
+    }
+    qsort(pc->entries, pc->count, sizeof(*pc->entries), pending_cmp);
+    return 1;
+}
+
+long sparetools_crlindex_write(const unsigned char *const *ders, const size_t *lens, int count,
+                               const char *index_path) {
+    static const unsigned char padding[4] = {0};
+    pending_crl *crls = count > 0 ? OPENSSL_zalloc(sizeof(*crls) * (size_t)count) : NULL;
+    unsigned char header[HEADER_SIZE] = {0}, entry[ENTRY_SIZE];
+    unsigned char slot[4];
+    uint64_t offset = HEADER_SIZE + (uint64_t)(count > 0 ? count : 0) * ENTRY_SIZE;
+    long total = -1, entries = 0;
+    FILE *fp = NULL;
+
+    if (count <= 0 || crls == NULL)
+        return -1;
+    for (int i = 0; i < count; i++) {
+        pending_crl *pc = &crls[i];
+        X509_CRL *crl;
+        int ok;
+
+        if (!parse_crl(ders[i], lens[i], &pc->layout) || !collect_entries(pc))
+            goto done;
+        crl = decode_crl(&pc->layout, NULL, 0);
+        ok = crl != NULL && indexable(crl);
+        X509_CRL_free(crl);
+        if (!ok)
+            goto done;
+        pc->der_offset = (uint32_t)offset;
+        offset += (lens[i] + 3) & ~(size_t)3;
+        pc->table_offset = (uint32_t)offset;
+        offset += (uint64_t)pc->count * 4;
+        if (offset > UINT32_MAX)
+            goto done;
+        entries += (long)pc->count;
+    }
+
+    memcpy(header, INDEX_MAGIC, sizeof(INDEX_MAGIC));
+    put_u32(header + 8, INDEX_VERSION);
+    put_u32(header + 12, (uint32_t)count);
+    put_u32(header + 16, HEADER_SIZE);
+    if ((fp = fopen(index_path, "wb")) == NULL || fwrite(header, sizeof(header), 1, fp) != 1)
+        goto done;
+    for (int i = 0; i < count; i++) {
+        put_u32(entry, crls[i].der_offset);
+        put_u32(entry + 4, (uint32_t)lens[i]);
+        put_u32(entry + 8, crls[i].table_offset);
+        put_u32(entry + 12, crls[i].count);
+        if (fwrite(entry, sizeof(entry), 1, fp) != 1)
+            goto done;
+    }
+    for (int i = 0; i < count; i++) {
+        size_t pad = ((lens[i] + 3) & ~(size_t)3) - lens[i];
+
+        if (fwrite(ders[i], lens[i], 1, fp) != 1 || (pad > 0 && fwrite(padding, pad, 1, fp) != 1))
+            goto done;
+        for (uint32_t j = 0; j < crls[i].count; j++) {
+            put_u32(slot, crls[i].entries[j].offset);
+            if (fwrite(slot, sizeof(slot), 1, fp) != 1)
+                goto done;
+        }
+    }
+    total = entries;
+
+ done:
+    if (fp != NULL && fclose(fp) != 0)
+        total = -1;
+    for (int i = 0; i < count; i++)
+        OPENSSL_free(crls[i].entries);
+    OPENSSL_free(crls);
+    return total;
+}
+
+/* File contents as DER: PEM CRLs are decoded from base64, not parsed */
+static unsigned char *read_crl_der(const char *path, size_t *len) {
+    BIO *in = BIO_new_file(path, "rb"), *mem = BIO_new(BIO_s_mem());
+    unsigned char *der = NULL, buf[65536];
+    char *name = NULL, *header = NULL;
+    const char *data;
+    long n = 0, size;
+    int r;
+
+    while (in != NULL && mem != NULL && (r = BIO_read(in, buf, sizeof(buf))) > 0)
+        if (BIO_write(mem, buf, r) != r)
+            goto done;
+    if (in == NULL || mem == NULL || (size = BIO_get_mem_data(mem, &data)) <= 0)
+        goto done;
+    if (size > 10 && memcmp(data, "-----BEGIN", 10) == 0) {
+        if (PEM_read_bio(mem, &name, &header, &der, &n) != 1)
+            n = 0;
+    } else if ((der = OPENSSL_memdup(data, (size_t)size)) != NULL) {
+        n = size;
+    }
+ done:
+    OPENSSL_free(name);
+    OPENSSL_free(header);
+    BIO_free(mem);
+    BIO_free(in);
+    if (n <= 0) {
+        OPENSSL_free(der);
+        return NULL;
+    }
+    *len = (size_t)n;
+    return der;
+}
+
+long sparetools_crlindex_compile(const char *const *crl_paths, int count, const char *index_path) {
+    unsigned char **ders = count > 0 ? OPENSSL_zalloc(sizeof(*ders) * (size_t)count) : NULL;
+    size_t *lens = count > 0 ? OPENSSL_zalloc(sizeof(*lens) * (size_t)count) : NULL;
+    long entries = -1;
+    int i;
+
+    if (ders == NULL || lens == NULL)
+        goto done;
+    for (i = 0; i < count; i++)
+        if ((ders[i] = read_crl_der(crl_paths[i], &lens[i])) == NULL)
+            goto done;
+    entries = sparetools_crlindex_write((const unsigned char *const *)ders, lens, count, index_path);
+
+ done:
+    for (i = 0; ders != NULL && i < count; i++)
+        OPENSSL_free(ders[i]);
+    OPENSSL_free(ders);
+    OPENSSL_free(lens);
+    return entries;
+}
+
+/* ---- Mapping ---- */
+
+static int map_file(const char *path, SPARETOOLS_CRLINDEX *index) {
+#ifdef _WIN32
+    FILE *fp = fopen(path, "rb");
+    unsigned char *buf = NULL;
+    long size;
+    int ok = fp != NULL && fseek(fp, 0, SEEK_END) == 0 && (size = ftell(fp)) > 0
+        && fseek(fp, 0, SEEK_SET) == 0 && (buf = OPENSSL_malloc((size_t)size)) != NULL
+        && fread(buf, (size_t)size, 1, fp) == 1;
+
+    if (fp != NULL)
+        fclose(fp);
+    if (!ok) {
+        OPENSSL_free(buf);
+        return 0;
+    }
+    index->map = buf;
+    index->size = (size_t)size;
+    return 1;
+#else
+    struct stat st;
+    void *map;
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+
+    if (fd < 0)
+        return 0;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0
+        || (map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0)) == MAP_FAILED) {
+        close(fd);
+        return 0;
+    }
+    close(fd);
+    index->map = map;
+    index->size = (size_t)st.st_size;
+    return 1;
+#endif
+}
+
+static void unmap_file(SPARETOOLS_CRLINDEX *index) {
+    if (index->map == NULL)
+        return;
+#ifdef _WIN32
+    OPENSSL_free((void *)index->map);
+#else
+    munmap((void *)index->map, index->size);
+#endif
+}
+
+/*
+ * The table must be a sorted permutation of the CRL's entries: every
+ * entry start is marked, then each table slot must clear a mark, so no
+ * entry can be missing from the search.
+ */
+static int validate_table(index_crl *c) {
+    const crl_layout *l = &c->layout;
+    size_t bits = l->revoked_len, pos = 0, walked = 0;
+    unsigned char *starts = bits > 0 ? OPENSSL_zalloc(bits / 8 + 1) : NULL;
+    const unsigned char *prev = NULL;
+    size_t prev_len = 0;
+    int ok = 0;
+
+    if (bits > 0 && starts == NULL)
+        return 0;
+    while (pos < l->revoked_len) {
+        const unsigned char *serial;
+        size_t serial_len, entry_len;
+
+        if (!entry_serial(l->revoked + pos, l->revoked_len - pos, &serial, &serial_len, &entry_len))
+            goto done;
+        starts[pos / 8] |= (unsigned char)(1 << (pos % 8));
+        pos += entry_len;
+        walked++;
+    }
+    if (walked != c->entries)
+        goto done;
+    for (uint32_t i = 0; i < c->entries; i++) {
+        uint32_t offset = get_u32(c->table + (size_t)i * 4);
+        size_t rel = (size_t)offset - (size_t)(l->revoked - l->der);
+        const unsigned char *serial;
+        size_t serial_len, entry_len;
+
+        if (offset < (size_t)(l->revoked - l->der) || rel >= l->revoked_len
+            || !(starts[rel / 8] & (1 << (rel % 8))))
+            goto done;
+        starts[rel / 8] &= (unsigned char)~(1 << (rel % 8));
+        if (!entry_serial(l->der + offset, l->revoked_len - rel, &serial, &serial_len, &entry_len)
+            || (prev != NULL && serial_cmp(prev, prev_len, serial, serial_len) > 0))
+            goto done;
+        prev = serial;
+        prev_len = serial_len;
+    }
+    ok = 1;
+ done:
+    OPENSSL_free(starts);
+    return ok;
+}
+
+static int validate(SPARETOOLS_CRLINDEX *index) {
+    uint32_t directory;
+
+    if (index->size < HEADER_SIZE || memcmp(index->map, INDEX_MAGIC, sizeof(INDEX_MAGIC)) != 0
+        || get_u32(index->map + 8) != INDEX_VERSION)
+        return 0;
+    index->count = get_u32(index->map + 12);
+    directory = get_u32(index->map + 16);
+    if (index->count == 0 || directory < HEADER_SIZE
+        || index->count > (index->size - directory) / ENTRY_SIZE
+        || (index->crls = OPENSSL_zalloc(sizeof(*index->crls) * index->count)) == NULL)
+        return 0;
+
+    for (uint32_t i = 0; i < index->count; i++) {
+        const unsigned char *e = index->map + directory + (size_t)i * ENTRY_SIZE;
+        uint32_t der_offset = get_u32(e), der_len = get_u32(e + 4), table_offset = get_u32(e + 8);
+        index_crl *c = &index->crls[i];
+
+        c->entries = get_u32(e + 12);
+        if (der_offset > index->size || der_len > index->size - der_offset
+            || table_offset > index->size || c->entries > (index->size - table_offset) / 4
+            || !parse_crl(index->map + der_offset, der_len, &c->layout))
+            return 0;
+        c->table = index->map + table_offset;
+        if (!validate_table(c)
+            || (c->empty = decode_crl(&c->layout, NULL, 0)) == NULL || !indexable(c->empty))
+            return 0;
+    }
+    return 1;
+}
+
+SPARETOOLS_CRLINDEX *sparetools_crlindex_open(const char *index_path) {
+    SPARETOOLS_CRLINDEX *index = OPENSSL_zalloc(sizeof(*index));
+
+    if (index == NULL)
+        return NULL;
+    if (!map_file(index_path, index) || !validate(index)
+        || (index->lock = CRYPTO_THREAD_lock_new()) == NULL) {
+        sparetools_crlindex_free(index);
+        ERR_clear_error();
+        return NULL;
+    }
+    return index;
+}
+
+void sparetools_crlindex_free(SPARETOOLS_CRLINDEX *index) {
+    if (index == NULL)
+        return;
+    for (uint32_t i = 0; index->crls != NULL && i < index->count; i++) {
+        X509_CRL_free(index->crls[i].empty);
+        EVP_PKEY_free(index->crls[i].verified_key);
+    }
+    OPENSSL_free(index->crls);
+    CRYPTO_THREAD_lock_free(index->lock);
+    unmap_file(index);
+    OPENSSL_free(index);
+}
+
+int sparetools_crlindex_count(const SPARETOOLS_CRLINDEX *index) {
+    return index != NULL ? (int)index->count : 0;
+}
+
+size_t sparetools_crlindex_size(const SPARETOOLS_CRLINDEX *index) {
+    return index != NULL ? index->size : 0;
+}
+
+/* ---- Verification ---- */
+
+/*
+ * Binary search of c's sorted entry table for serial: 1 with *entry set,
+ * 0 if it is not revoked, -1 if the entry table does not parse
+ */
+static int find_entry(const index_crl *c, const unsigned char *serial, size_t serial_len,
+                      const unsigned char **entry_out, size_t *entry_len) {
+    const crl_layout *l = &c->layout;
+    uint32_t lo = 0, hi = c->entries;
+
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        const unsigned char *entry = l->der + get_u32(c->table + (size_t)mid * 4), *s;
+        size_t s_len, len;
+        int cmp;
+
+        /* Validated at open; a failure here means the mapping changed under us */
+        if (!entry_serial(entry, (size_t)(l->revoked + l->revoked_len - entry), &s, &s_len, &len))
+            return -1;
+        cmp = serial_cmp(s, s_len, serial, serial_len);
+        if (cmp == 0) {
+            *entry_out = entry;
+            *entry_len = len;
+            return 1;
+        }
+        if (cmp < 0)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return 0;
+}
+
+/* The index CRL for cert's lookup: the shared empty one or cert's own entry */
+static X509_CRL *crl_for(SPARETOOLS_CRLINDEX *index, index_crl *c, X509 *cert) {
+    unsigned char buf[64];
+    const unsigned char *serial, *entry;
+    size_t serial_len, entry_len;
+    int found;
+
+    if (cert == NULL
+        || (serial = serial_contents(X509_get0_serialNumber(cert), buf, sizeof(buf), &serial_len)) == NULL)
+        return NULL;
+    count(&index->lookups);
+    /* No CRL rather than the empty one: an unreadable table must not pass as "not revoked" */
+    if ((found = find_entry(c, serial, serial_len, &entry, &entry_len)) < 0)
+        return NULL;
+    if (found) {
+        count(&index->revoked);
+        return decode_crl(&c->layout, entry, entry_len);
+    }
+    return X509_CRL_up_ref(c->empty) ? c->empty : NULL;
+}
+
+static STACK_OF(X509_CRL) *lookup_crls(const X509_STORE_CTX *ctx, const X509_NAME *name) {
+    store_attachment *a = X509_STORE_get_ex_data(X509_STORE_CTX_get0_store(ctx), crlindex_ex_index);
+    STACK_OF(X509_CRL) *crls = NULL;
+    X509 *cert = X509_STORE_CTX_get_current_cert(ctx);
+
+    for (uint32_t i = 0; a != NULL && i < a->index->count; i++) {
+        index_crl *c = &a->index->crls[i];
+        X509_CRL *crl;
+
+        if (X509_NAME_cmp(X509_CRL_get_issuer(c->empty), name) != 0)
+            continue;
+        if ((crls == NULL && (crls = sk_X509_CRL_new_null()) == NULL)
+            || (crl = crl_for(a->index, c, cert)) == NULL)
+            break;
+        if (!sk_X509_CRL_push(crls, crl)) {
+            X509_CRL_free(crl);
+            break;
+        }
+    }
+    if (crls != NULL)
+        return crls;
+    if (a != NULL)
+        count(&a->index->fallbacks);
+    return X509_STORE_CTX_get1_crls(ctx, name);
+}
+
+/*
+ * Which index CRL crl stands for. The empty CRL passes by identity only:
+ * a copy of it supplied from elsewhere (CMS, X509_STORE_CTX_set0_crls)
+ * would hide every revocation. A single-entry CRL passes if it is the
+ * exact encoding the index would produce, as it can only revoke.
+ */
+static index_crl *crl_of(SPARETOOLS_CRLINDEX *index, X509_CRL *crl) {
+    STACK_OF(X509_REVOKED) *revoked = X509_CRL_get_REVOKED(crl);
+    unsigned char buf[64];
+    const unsigned char *serial = NULL;
+    size_t serial_len = 0;
+
+    if (sk_X509_REVOKED_num(revoked) == 1)
+        serial = serial_contents(X509_REVOKED_get0_serialNumber(sk_X509_REVOKED_value(revoked, 0)),
+                                 buf, sizeof(buf), &serial_len);
+    for (uint32_t i = 0; i < index->count; i++) {
+        index_crl *c = &index->crls[i];
+        const unsigned char *entry;
+        unsigned char *expected, *der = NULL;
+        size_t entry_len, expected_len;
+        int der_len, same;
+
+        if (crl == c->empty)
+            return c;
+        if (serial == NULL
+            || X509_NAME_cmp(X509_CRL_get_issuer(crl), X509_CRL_get_issuer(c->empty)) != 0
+            || find_entry(c, serial, serial_len, &entry, &entry_len) != 1
+            || (expected = encode_crl(&c->layout, entry, entry_len, &expected_len)) == NULL)
+            continue;
+        der_len = i2d_X509_CRL(crl, &der);
+        same = der_len > 0 && (size_t)der_len == expected_len && memcmp(der, expected, expected_len) == 0;
+        OPENSSL_free(der);
+        OPENSSL_free(expected);
+        if (same)
+            return c;
+    }
+    return NULL;
+}
+
+/* The signature over the original tbsCertList, once per CRL and key */
+static int signature_ok(SPARETOOLS_CRLINDEX *index, index_crl *c, EVP_PKEY *key) {
+    const ASN1_BIT_STRING *sig;
+    const X509_ALGOR *alg;
+    ASN1_STRING tbs;
+    ASN1_TYPE any;
+    int ok;
+
+    if (key == NULL || !CRYPTO_THREAD_read_lock(index->lock))
+        return 0;
+    ok = c->verified_key != NULL && (c->verified_key == key || EVP_PKEY_eq(c->verified_key, key) == 1);
+    CRYPTO_THREAD_unlock(index->lock);
+    if (ok)
+        return 1;
+
+    /*
+     * An ANY holding a SEQUENCE encodes as its contents: the signed bytes
+     * as they are. Both are views on the mapping, never freed.
+     */
+    X509_CRL_get0_signature(c->empty, &sig, &alg);
+    memset(&tbs, 0, sizeof(tbs));
+    tbs.type = V_ASN1_SEQUENCE;
+    tbs.data = (unsigned char *)c->layout.tbs;
+    tbs.length = (int)c->layout.tbs_len;
+    any.type = V_ASN1_SEQUENCE;
+    any.value.sequence = &tbs;
+    ok = ASN1_item_verify(ASN1_ITEM_rptr(ASN1_ANY), alg, sig, &any, key) == 1;
+    count(&index->verifications);
+    if (!ok) {
+        ERR_clear_error();
+        return 0;
+    }
+
+    if (EVP_PKEY_up_ref(key) && CRYPTO_THREAD_write_lock(index->lock)) {
+        EVP_PKEY_free(c->verified_key);
+        c->verified_key = key;
+        CRYPTO_THREAD_unlock(index->lock);
+    }
+    return 1;
+}
+
+/* The key check_crl() verified the CRL with: the CRL issuer it chose, else the chain's next */
+static EVP_PKEY *crl_issuer_key(X509_STORE_CTX *ctx) {
+    X509 *issuer = X509_STORE_CTX_get0_current_issuer(ctx);
+    STACK_OF(X509) *chain = X509_STORE_CTX_get0_chain(ctx);
+    int depth = X509_STORE_CTX_get_error_depth(ctx), last = sk_X509_num(chain) - 1;
+
+    if (issuer == NULL && chain != NULL && last >= 0)
+        issuer = sk_X509_value(chain, depth < last ? depth + 1 : last);
+    return issuer != NULL ? X509_get0_pubkey(issuer) : NULL;
+}
+
+static int verify_cb(int ok, X509_STORE_CTX *ctx) {
+    store_attachment *a = X509_STORE_get_ex_data(X509_STORE_CTX_get0_store(ctx), crlindex_ex_index);
+
+    if (a == NULL)
+        return ok;
+    if (!ok && X509_STORE_CTX_get_error(ctx) == X509_V_ERR_CRL_SIGNATURE_FAILURE) {
+        X509_CRL *crl = X509_STORE_CTX_get0_current_crl(ctx);
+        index_crl *c = crl != NULL ? crl_of(a->index, crl) : NULL;
+
+        if (c != NULL && signature_ok(a->index, c, crl_issuer_key(ctx))) {
+            X509_STORE_CTX_set_error(ctx, X509_V_OK);
+            return 1;
+        }
+    }
+    return a->previous != NULL ? a->previous(ok, ctx) : ok;
+}
+
+int sparetools_crlindex_attach(SPARETOOLS_CRLINDEX *index, X509_STORE *store) {
+    store_attachment *a;
+
+    if (index == NULL || store == NULL || !CRYPTO_THREAD_run_once(&ex_index_once, init_ex_index)
+        || crlindex_ex_index < 0 || X509_STORE_get_ex_data(store, crlindex_ex_index) != NULL
+        || (a = OPENSSL_zalloc(sizeof(*a))) == NULL)
+        return 0;
+    a->index = index;
+    a->previous = X509_STORE_get_verify_cb(store);
+    if (!X509_STORE_set_ex_data(store, crlindex_ex_index, a)) {
+        OPENSSL_free(a);
+        return 0;
+    }
+    X509_STORE_set_lookup_crls(store, lookup_crls);
+    X509_STORE_set_verify_cb(store, verify_cb);
+    return 1;
+}
+
+void sparetools_crlindex_stats(SPARETOOLS_CRLINDEX *index, SPARETOOLS_CRLINDEX_STATS *stats) {
+    memset(stats, 0, sizeof(*stats));
+    if (index == NULL)
+        return;
+    stats->lookups = atomic_load_explicit(&index->lookups, memory_order_relaxed);
+    stats->revoked = atomic_load_explicit(&index->revoked, memory_order_relaxed);
+    stats->fallbacks = atomic_load_explicit(&index->fallbacks, memory_order_relaxed);
+    stats->verifications = atomic_load_explicit(&index->verifications, memory_order_relaxed);
+}
@@ -0,0 +1,514 @@
+/*
+ * sparetools-fips-check: in-process FIPS provider validation
+ *
+ * Does in one process what FIPSValidator used to do with an openssl CLI
+ * launch per check (list -providers, ciphers, dgst -list, fipsinstall
+ * -verify):
+ *
+ *   1. load the FIPS provider once into a private library context, which
+ *      runs its power-on self-tests (integrity check and KATs); every test
+ *      is recorded through OSSL_SELF_TEST_set_callback
+ *   2. fetch each approved algorithm with "fips=yes" and exercise it once
+ *      (known-answer vectors for digests and HMAC, round trips for ciphers,
+ *      sign/verify for ECDSA and RSA)
+ *   3. check that non-approved algorithms cannot be fetched
+ *
+ * The result is a single JSON document on stdout (or --json FILE); the
+ * exit status is 0 only when every check passed.
+ *
+ * Usage: sparetools-fips-check [--config openssl.cnf] [--module-dir DIR]
+ *                              [--provider fips] [--json FILE]
+ *
+ * --provider exists for testing the checks against another provider
+ * ("default"); the property query becomes "provider=NAME".
+ */
+
+#include <openssl/core_names.h>
+#include <openssl/crypto.h>
+#include <openssl/err.h>
+#include <openssl/evp.h>
+#include <openssl/kdf.h>
+#include <openssl/opensslv.h>
+#include <openssl/provider.h>
+#include <openssl/rand.h>
+#include <openssl/self_test.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define MAX_SELF_TESTS 256
+#define MAX_RESULTS 64
+
+typedef struct {
+    char type[64];
+    char desc[96];
+    int passed;
+} self_test_entry;
+
+typedef struct {
+    self_test_entry tests[MAX_SELF_TESTS];
+    int count;
+    int failed;
+} self_test_log;
+
+typedef struct {
+    const char *name;
+    const char *kind;
+    int approved;
+    int available;
+    int passed;
+    char detail[160];
+} check_result;
+
+typedef struct {
+    OSSL_LIB_CTX *libctx;
+    const char *propq;
+    check_result results[MAX_RESULTS];
+    int count;
+} checker;
+
+static double now_ms(void) {
+    struct timespec ts;
+
+    timespec_get(&ts, TIME_UTC);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+static void json_string(FILE *out, const char *s) {
+    fputc('"', out);
+    for (; s != NULL && *s; s++) {
+        unsigned char c = (unsigned char)*s;
+
+        if (c == '"' || c == '\\')
+            fprintf(out, "\\%c", c);
+        else if (c < 0x20)
+            fprintf(out, "\\u%04x", c);
+        else
+            fputc(c, out);
+    }
+    fputc('"', out);
+}
+
+static int self_test_cb(const OSSL_PARAM params[], void *arg) {
+    self_test_log *log = arg;
+    const OSSL_PARAM *p;
+    const char *phase = NULL, *type = "", *desc = "";
+
+    if ((p = OSSL_PARAM_locate_const(params, OSSL_PROV_PARAM_SELF_TEST_PHASE)) != NULL)
+        OSSL_PARAM_get_utf8_string_ptr(p, &phase);
+    if ((p = OSSL_PARAM_locate_const(params, OSSL_PROV_PARAM_SELF_TEST_TYPE)) != NULL)
+        OSSL_PARAM_get_utf8_string_ptr(p, &type);
+    if ((p = OSSL_PARAM_locate_const(params, OSSL_PROV_PARAM_SELF_TEST_DESC)) != NULL)
+        OSSL_PARAM_get_utf8_string_ptr(p, &desc);
+
+    if (phase == NULL || (strcmp(phase, OSSL_SELF_TEST_PHASE_PASS) != 0
+                          && strcmp(phase, OSSL_SELF_TEST_PHASE_FAIL) != 0))
+        return 1;
+    if (log->count < MAX_SELF_TESTS) {
+        self_test_entry *e = &log->tests[log->count++];
+
+        snprintf(e->type, sizeof(e->type), "%s", type);
+        snprintf(e->desc, sizeof(e->desc), "%s", desc);
+        e->passed = strcmp(phase, OSSL_SELF_TEST_PHASE_PASS) == 0;
+    }
+    if (strcmp(phase, OSSL_SELF_TEST_PHASE_FAIL) == 0)
+        log->failed++;
+    return 1;
+}
+
+static check_result *add_result(checker *c, const char *name, const char *kind) {
+    check_result *r = &c->results[c->count < MAX_RESULTS ? c->count++ : MAX_RESULTS - 1];
+
+    memset(r, 0, sizeof(*r));
+    r->name = name;
+    r->kind = kind;
+    r->approved = 1;
+    return r;
+}
+
+static const char *last_error(void) {
+    static char buf[160];
+    const char *data = NULL;
+    int flags = 0;
+    unsigned long err = ERR_peek_last_error_data(&data, &flags);
+
+    ERR_error_string_n(err, buf, sizeof(buf));
+    if (data != NULL && (flags & ERR_TXT_STRING) && *data)
+        snprintf(buf + strlen(buf), sizeof(buf) - strlen(buf), " (%s)", data);
+    return buf;
+}
+
+/* Last OpenSSL error as the result detail */
+static int fail(check_result *r, const char *what) {
+    if (ERR_peek_last_error() != 0)
+        snprintf(r->detail, sizeof(r->detail), "%s: %s", what, last_error());
+    else
+        snprintf(r->detail, sizeof(r->detail), "%s", what);
+    ERR_clear_error();
+    r->passed = 0;
+    return 0;
+}
+
+static int hex_equals(const unsigned char *buf, size_t len, const char *hex) {
+    char tmp[3];
+
+    if (strlen(hex) != len * 2)
+        return 0;
+    for (size_t i = 0; i < len; i++) {
+        snprintf(tmp, sizeof(tmp), "%02x", buf[i]);
+        if (memcmp(tmp, hex + 2 * i, 2) != 0)
+            return 0;
+    }
+    return 1;
+}
+
+static void check_digest(checker *c, const char *name, const char *kat) {
+    check_result *r = add_result(c, name, "digest");
+    EVP_MD *md = EVP_MD_fetch(c->libctx, name, c->propq);
+    unsigned char out[EVP_MAX_MD_SIZE];
+    unsigned int len = 0;
+
+    if (md == NULL) {
+        fail(r, "not available");
+        return;
+    }
+    r->available = 1;
+    if (!EVP_Digest("abc", 3, out, &len, md, NULL))
+        fail(r, "digest failed");
+    else if (!hex_equals(out, len, kat))
+        fail(r, "known-answer mismatch");
+    else
+        r->passed = 1;
+    EVP_MD_free(md);
+}
+
+static void check_cipher(checker *c, const char *name) {
+    check_result *r = add_result(c, name, "cipher");
+    EVP_CIPHER *cipher = EVP_CIPHER_fetch(c->libctx, name, c->propq);
+    EVP_CIPHER_CTX *ctx = EVP_CIPHER_CTX_new();
+    static const unsigned char key[32] = {
+        0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f,
+        0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0x1a, 0x1b, 0x1c, 0x1d, 0x1e, 0x1f
+    };
+    static const unsigned char iv[16] = {
+        0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f
+    };
+    static const unsigned char plaintext[] = "FIPS Test Encryption Vector!!!";
+    unsigned char ciphertext[64], decrypted[64], tag[16];
+    int len, ct_len, pt_len;
+    int aead;
+
+    if (cipher == NULL) {
+        fail(r, "not available");
+        goto end;
+    }
+    r->available = 1;
+    aead = (EVP_CIPHER_get_flags(cipher) & EVP_CIPH_FLAG_AEAD_CIPHER) != 0;
+
+    if (ctx == NULL
+        || !EVP_EncryptInit_ex2(ctx, cipher, key, aead ? iv + 4 : iv, NULL)
+        || !EVP_EncryptUpdate(ctx, ciphertext, &len, plaintext, sizeof(plaintext) - 1)) {
+        fail(r, "encrypt failed");
+        goto end;
+    }
+    ct_len = len;
+    if (!EVP_EncryptFinal_ex(ctx, ciphertext + len, &len)
+        || (aead && !EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_AEAD_GET_TAG, sizeof(tag), tag))) {
+        fail(r, "encrypt final failed");
+        goto end;
+    }
+    ct_len += len;
+
+    if (!EVP_DecryptInit_ex2(ctx, cipher, key, aead ? iv + 4 : iv, NULL)
+        || !EVP_DecryptUpdate(ctx, decrypted, &len, ciphertext, ct_len)) {
+        fail(r, "decrypt failed");
+        goto end;
+    }
+    pt_len = len;
+    if ((aead && !EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_AEAD_SET_TAG, sizeof(tag), tag))
+        || !EVP_DecryptFinal_ex(ctx, decrypted + len, &len)) {
+        fail(r, aead ? "tag verification failed" : "decrypt final failed");
+        goto end;
+    }
+    pt_len += len;
+
+    if (pt_len != (int)sizeof(plaintext) - 1 || memcmp(plaintext, decrypted, pt_len) != 0)
+        fail(r, "round trip mismatch");
+    else
+        r->passed = 1;
+end:
+    EVP_CIPHER_CTX_free(ctx);
+    EVP_CIPHER_free(cipher);
+}
+
+/* RFC 4231 test case 2 */
+static void check_hmac(checker *c) {
+    check_result *r = add_result(c, "HMAC-SHA2-256", "mac");
+    EVP_MAC *mac = EVP_MAC_fetch(c->libctx, "HMAC", c->propq);
+    EVP_MAC_CTX *ctx = NULL;
+    static const char data[] = "what do ya want for nothing?";
+    unsigned char out[EVP_MAX_MD_SIZE];
+    size_t len = 0;
+    char digest[] = "SHA2-256";
+    OSSL_PARAM params[] = {
+        OSSL_PARAM_construct_utf8_string(OSSL_MAC_PARAM_DIGEST, digest, 0),
+        OSSL_PARAM_construct_end()
+    };
+
+    if (mac == NULL) {
+        fail(r, "not available");
+        return;
+    }
+    r->available = 1;
+    if ((ctx = EVP_MAC_CTX_new(mac)) == NULL
+        || !EVP_MAC_init(ctx, (const unsigned char *)"Jefe", 4, params)
+        || !EVP_MAC_update(ctx, (const unsigned char *)data, sizeof(data) - 1)
+        || !EVP_MAC_final(ctx, out, &len, sizeof(out)))
+        fail(r, "mac failed");
+    else if (!hex_equals(out, len, "5bdcc146bf60754e6a042426089575c75a003f089d2739839dec58b964ec3843"))
+        fail(r, "known-answer mismatch");
+    else
+        r->passed = 1;
+    EVP_MAC_CTX_free(ctx);
+    EVP_MAC_free(mac);
+}
+
+static void check_kdf(checker *c, const char *name) {
+    check_result *r = add_result(c, name, "kdf");
+    EVP_KDF *kdf = EVP_KDF_fetch(c->libctx, name, c->propq);
+
+    if (kdf == NULL) {
+        fail(r, "not available");
+        return;
+    }
+    r->available = r->passed = 1;
+    EVP_KDF_free(kdf);
+}
+
+static void check_drbg(checker *c) {
+    check_result *r = add_result(c, "CTR-DRBG", "rand");
+    EVP_RAND *rand = EVP_RAND_fetch(c->libctx, "CTR-DRBG", c->propq);
+    unsigned char buf[32];
+
+    if (rand == NULL) {
+        fail(r, "not available");
+        return;
+    }
+    r->available = 1;
+    EVP_RAND_free(rand);
+    if (RAND_bytes_ex(c->libctx, buf, sizeof(buf), 0) != 1)
+        fail(r, "RAND_bytes_ex failed");
+    else
+        r->passed = 1;
+}
+
+static void check_signature(checker *c, const char *name, const char *type, const char *arg) {
+    check_result *r = add_result(c, name, "signature");
+    EVP_PKEY *pkey = NULL;
+    EVP_MD_CTX *ctx = EVP_MD_CTX_new();
+    static const unsigned char msg[] = "FIPS signature test";
+    unsigned char sig[1024];
+    size_t sig_len = sizeof(sig);
+
+    if (strcmp(type, "RSA") == 0)
+        pkey = EVP_PKEY_Q_keygen(c->libctx, c->propq, "RSA", (size_t)atoi(arg));
+    else
+        pkey = EVP_PKEY_Q_keygen(c->libctx, c->propq, "EC", arg);
+    if (pkey == NULL) {
+        fail(r, "key generation failed");
+        goto end;
+    }
+    r->available = 1;
+    if (ctx == NULL
+        || !EVP_DigestSignInit_ex(ctx, NULL, "SHA2-256", c->libctx, c->propq, pkey, NULL)
+        || !EVP_DigestSign(ctx, sig, &sig_len, msg, sizeof(msg) - 1)) {
+        fail(r, "sign failed");
+        goto end;
+    }
+    if (!EVP_DigestVerifyInit_ex(ctx, NULL, "SHA2-256", c->libctx, c->propq, pkey, NULL)
+        || EVP_DigestVerify(ctx, sig, sig_len, msg, sizeof(msg) - 1) != 1)
+        fail(r, "verify failed");
+    else
+        r->passed = 1;
+end:
+    EVP_MD_CTX_free(ctx);
+    EVP_PKEY_free(pkey);
+}
+
+/* Non-approved algorithms must not be fetchable under the FIPS query */
+static void check_blocked(checker *c, const char *name, const char *kind) {
+    check_result *r = add_result(c, name, kind);
+    void *handle;
+
+    if (strcmp(kind, "digest") == 0) {
+        handle = EVP_MD_fetch(c->libctx, name, c->propq);
+        EVP_MD_free(handle);
+    } else {
+        handle = EVP_CIPHER_fetch(c->libctx, name, c->propq);
+        EVP_CIPHER_free(handle);
+    }
+    ERR_clear_error();
+    r->approved = 0;
+    r->available = handle != NULL;
+    r->passed = handle == NULL;
+    if (handle != NULL)
+        snprintf(r->detail, sizeof(r->detail), "non-approved algorithm is available");
+}
+
+static void print_provider_params(FILE *out, OSSL_PROVIDER *prov) {
+    char *name = NULL, *version = NULL, *buildinfo = NULL;
+    int status = 0;
+    OSSL_PARAM params[] = {
+        OSSL_PARAM_construct_utf8_ptr(OSSL_PROV_PARAM_NAME, &name, 0),
+        OSSL_PARAM_construct_utf8_ptr(OSSL_PROV_PARAM_VERSION, &version, 0),
+        OSSL_PARAM_construct_utf8_ptr(OSSL_PROV_PARAM_BUILDINFO, &buildinfo, 0),
+        OSSL_PARAM_construct_int(OSSL_PROV_PARAM_STATUS, &status),
+        OSSL_PARAM_construct_end()
+    };
+
+    OSSL_PROVIDER_get_params(prov, params);
+    fprintf(out, "\"module_name\": ");
+    json_string(out, name ? name : "");
+    fprintf(out, ", \"module_version\": ");
+    json_string(out, version ? version : "");
+    fprintf(out, ", \"buildinfo\": ");
+    json_string(out, buildinfo ? buildinfo : "");
+    fprintf(out, ", \"status\": %d", status);
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr, "Usage: %s [--config openssl.cnf] [--module-dir DIR] [--provider fips] [--json FILE]\n", prog);
+}
+
+int main(int argc, char *argv[]) {
+    const char *config = NULL, *module_dir = NULL, *provider_name = "fips", *json_path = NULL;
+    char propq[96];
+    self_test_log *log = calloc(1, sizeof(*log));
+    checker c = { 0 };
+    OSSL_PROVIDER *prov = NULL, *base = NULL;
+    FILE *out = stdout;
+    double start, load_ms;
+    char load_error[256] = "";
+    int fips_mode = 0, passed, failures = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--config") == 0 && i + 1 < argc) {
+            config = argv[++i];
+        } else if (strcmp(argv[i], "--module-dir") == 0 && i + 1 < argc) {
+            module_dir = argv[++i];
+        } else if (strcmp(argv[i], "--provider") == 0 && i + 1 < argc) {
+            provider_name = argv[++i];
+        } else if (strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+            json_path = argv[++i];
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    OPENSSL_init_crypto(OPENSSL_INIT_LOAD_CRYPTO_STRINGS, NULL);
+    if (log == NULL || (c.libctx = OSSL_LIB_CTX_new()) == NULL) {
+        fprintf(stderr, "ERROR: out of memory\n");
+        return 2;
+    }
+    if (strcmp(provider_name, "fips") == 0)
+        snprintf(propq, sizeof(propq), "fips=yes");
+    else
+        snprintf(propq, sizeof(propq), "provider=%s", provider_name);
+    c.propq = propq;
+
+    /* Self-tests run while the provider loads, so the callback goes first */
+    OSSL_SELF_TEST_set_callback(c.libctx, self_test_cb, log);
+    if (module_dir != NULL)
+        OSSL_PROVIDER_set_default_search_path(c.libctx, module_dir);
+
+    start = now_ms();
+    if (config != NULL && !OSSL_LIB_CTX_load_config(c.libctx, config))
+        snprintf(load_error, sizeof(load_error), "loading %s: %s", config, last_error());
+    prov = OSSL_PROVIDER_load(c.libctx, provider_name);
+    load_ms = now_ms() - start;
+    if (prov == NULL && load_error[0] == '\0')
+        snprintf(load_error, sizeof(load_error), "%s",
+                 ERR_peek_last_error() != 0 ? last_error() : "provider module not found");
+    ERR_clear_error();
+
+    if (prov != NULL) {
+        /* Encoders/decoders for key generation come from the base provider */
+        base = OSSL_PROVIDER_load(c.libctx, "base");
+        if (strcmp(provider_name, "fips") == 0 && EVP_default_properties_enable_fips(c.libctx, 1))
+            fips_mode = EVP_default_properties_is_fips_enabled(c.libctx);
+
+        check_digest(&c, "SHA2-256", "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+        check_digest(&c, "SHA2-384", "cb00753f45a35e8bb5a03d699ac65007272c32ab0eded1631a8b605a43ff5bed"
+                                     "8086072ba1e7cc2358baeca134c825a7");
+        check_digest(&c, "SHA2-512", "ddaf35a193617abacc417349ae20413112e6fa4e89a97ea20a9eeee64b55d39a"
+                                     "2192992a274fc1a836ba3c23a3feebbd454d4423643ce80e2a9ac94fa54ca49f");
+        check_digest(&c, "SHA3-256", "3a985da74fe225b2045c172d6bd390bd855f086e3e9d525b46bfe24511431532");
+        check_cipher(&c, "AES-128-CBC");
+        check_cipher(&c, "AES-256-CBC");
+        check_cipher(&c, "AES-128-GCM");
+        check_cipher(&c, "AES-256-GCM");
+        check_hmac(&c);
+        check_kdf(&c, "HKDF");
+        check_kdf(&c, "PBKDF2");
+        check_drbg(&c);
+        check_signature(&c, "ECDSA-P-256", "EC", "P-256");
+        check_signature(&c, "ECDSA-P-384", "EC", "P-384");
+        check_signature(&c, "RSA-2048", "RSA", "2048");
+        check_blocked(&c, "MD5", "digest");
+        check_blocked(&c, "BLAKE2S-256", "digest");
+        check_blocked(&c, "ChaCha20-Poly1305", "cipher");
+    }
+
+    for (int i = 0; i < c.count; i++)
+        failures += !c.results[i].passed;
+    passed = prov != NULL && log->failed == 0 && failures == 0;
+
+    if (json_path != NULL && (out = fopen(json_path, "w")) == NULL) {
+        fprintf(stderr, "ERROR: cannot write %s\n", json_path);
+        return 2;
+    }
+    fprintf(out, "{\n  \"tool\": \"sparetools-fips-check\",\n  \"openssl_version\": ");
+    json_string(out, OPENSSL_VERSION_STR);
+    fprintf(out, ",\n  \"library_version\": ");
+    json_string(out, OpenSSL_version(OPENSSL_VERSION));
+    fprintf(out, ",\n  \"provider\": {\"name\": ");
+    json_string(out, provider_name);
+    fprintf(out, ", \"loaded\": %s, \"load_ms\": %.3f, \"error\": ", prov ? "true" : "false", load_ms);
+    json_string(out, load_error);
+    if (prov != NULL) {
+        fprintf(out, ", ");
+        print_provider_params(out, prov);
+    }
+    fprintf(out, "},\n  \"fips_mode\": %s,\n", fips_mode ? "true" : "false");
+    fprintf(out, "  \"self_tests\": {\"count\": %d, \"failed\": %d, \"tests\": [", log->count, log->failed);
+    for (int i = 0; i < log->count; i++) {
+        fprintf(out, "%s\n    {\"type\": ", i ? "," : "");
+        json_string(out, log->tests[i].type);
+        fprintf(out, ", \"desc\": ");
+        json_string(out, log->tests[i].desc);
+        fprintf(out, ", \"result\": \"%s\"}", log->tests[i].passed ? "pass" : "fail");
+    }
+    fprintf(out, "%s]},\n  \"checks\": [", log->count ? "\n  " : "");
+    for (int i = 0; i < c.count; i++) {
+        check_result *r = &c.results[i];
+
+        fprintf(out, "%s\n    {\"name\": ", i ? "," : "");
+        json_string(out, r->name);
+        fprintf(out, ", \"kind\": \"%s\", \"approved\": %s, \"available\": %s, \"result\": \"%s\", \"detail\": ",
+                r->kind, r->approved ? "true" : "false", r->available ? "true" : "false",
+                r->passed ? "pass" : "fail");
+        json_string(out, r->detail);
+        fputc('}', out);
+    }
+    fprintf(out, "%s],\n  \"passed\": %s\n}\n", c.count ? "\n  " : "", passed ? "true" : "false");
+    if (out != stdout)
+        fclose(out);
+
+    OSSL_PROVIDER_unload(base);
+    OSSL_PROVIDER_unload(prov);
+    OSSL_LIB_CTX_free(c.libctx);
+    free(log);
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,190 @@
+#define _GNU_SOURCE
+#include "sparetools_hugetext.h"
+
+#include <openssl/crypto.h>
+#include <dlfcn.h>
+#include <link.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+
+/*
+ * Each object is identified either by a substring of its path or by an
+ * address inside one of its segments (how sparetools_hugetext_remap_openssl
+ * finds libcrypto without knowing whether it was linked statically). The
+ * dl_iterate_phdr callback collects the executable PT_LOAD ranges; the
+ * remapping itself runs after the iteration, outside the loader lock.
+ */
+#define HUGE_PAGE ((uintptr_t)2 << 20)
+#define MAX_SEGMENTS 4
+
+#ifndef MADV_COLLAPSE
+# define MADV_COLLAPSE 25
+#endif
+
+typedef struct {
+    const char *name;       /* Path substring, "" for the main executable */
+    uintptr_t addr;         /* Or an address inside the object */
+    uintptr_t start[MAX_SEGMENTS];
+    uintptr_t end[MAX_SEGMENTS];
+    int segments;
+} text_object;
+
+static int collect_text(struct dl_phdr_info *info, size_t size, void *arg) {
+    text_object *obj = arg;
+    int match = 0;
+
+    (void)size;
+    if (obj->name != NULL) {
+        /* The main executable is reported first, with an empty name */
+        match = obj->name[0] == '\0' ? info->dlpi_name[0] == '\0'
+                                     : strstr(info->dlpi_name, obj->name) != NULL;
+    } else {
+        for (int i = 0; i < info->dlpi_phnum && !match; i++) {
+            const ElfW(Phdr) *ph = &info->dlpi_phdr[i];
+            uintptr_t start = info->dlpi_addr + ph->p_vaddr;
+
+            match = ph->p_type == PT_LOAD && obj->addr >= start && obj->addr < start + ph->p_memsz;
+        }
+    }
+    if (!match)
+        return 0;
+
+    for (int i = 0; i < info->dlpi_phnum && obj->segments < MAX_SEGMENTS; i++) {
+        const ElfW(Phdr) *ph = &info->dlpi_phdr[i];
+
+        if (ph->p_type != PT_LOAD || (ph->p_flags & PF_X) == 0)
+            continue;
+        obj->start[obj->segments] = info->dlpi_addr + ph->p_vaddr;
+        obj->end[obj->segments] = obj->start[obj->segments] + ph->p_memsz;
+        obj->segments++;
+    }
+    return 1;
+}
+
+static int thp_enabled(void) {
+    char mode[128] = "";
+    FILE *fp = fopen("/sys/kernel/mm/transparent_hugepage/enabled", "r");
+
+    if (fp == NULL)
+        return 0;
+    if (fgets(mode, sizeof(mode), fp) == NULL)
+        mode[0] = '\0';
+    fclose(fp);
+    return strstr(mode, "[never]") == NULL && mode[0] != '\0';
+}
+
+/** AnonHugePages of the mapping starting at start, in bytes */
+static size_t huge_bytes_at(uintptr_t start) {
+    char line[256];
+    int in_range = 0;
+    size_t kb = 0;
+    FILE *fp = fopen("/proc/self/smaps", "r");
+
+    if (fp == NULL)
+        return 0;
+    while (fgets(line, sizeof(line), fp) != NULL) {
+        unsigned long lo, hi;
+
+        if (sscanf(line, "%lx-%lx ", &lo, &hi) == 2) {
+            in_range = lo == start;
+        } else if (in_range && sscanf(line, "AnonHugePages: %zu kB", &kb) == 1) {
+            break;
+        }
+    }
+    fclose(fp);
+    return kb * 1024;
+}
+
+/*
+ * Copy [start, end) into hugepage-advised anonymous memory and move the
+ * copy over the original. The copy is made executable before the move,
+ * so the range stays mapped with identical contents throughout.
+ */
+static int remap_range(uintptr_t start, uintptr_t end, SPARETOOLS_HUGETEXT_RESULT *result) {
+    size_t len = end - start;
+    uintptr_t raw, copy;
+    void *p = mmap(NULL, len + HUGE_PAGE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+    if (p == MAP_FAILED)
+        return -1;
+    raw = (uintptr_t)p;
+    copy = (raw + HUGE_PAGE - 1) & ~(HUGE_PAGE - 1);
+    if (copy > raw)
+        munmap((void *)raw, copy - raw);
+    if (raw + HUGE_PAGE > copy)
+        munmap((void *)(copy + len), raw + HUGE_PAGE - copy);
+
+    madvise((void *)copy, len, MADV_HUGEPAGE);
+    memcpy((void *)copy, (const void *)start, len);
+    /* Kernels from 6.1 collapse synchronously; older ones leave it to the fault path */
+    madvise((void *)copy, len, MADV_COLLAPSE);
+
+    if (mprotect((void *)copy, len, PROT_READ | PROT_EXEC) != 0
+        || mremap((void *)copy, len, len, MREMAP_MAYMOVE | MREMAP_FIXED, (void *)start) == MAP_FAILED) {
+        munmap((void *)copy, len);
+        return -1;
+    }
+    if (result != NULL) {
+        result->remapped_bytes += len;
+        result->huge_bytes += huge_bytes_at(start);
+    }
+    return 1;
+}
+
+static int remap_object(text_object *obj, SPARETOOLS_HUGETEXT_RESULT *result) {
+    int ret = 0;
+
+    obj->segments = 0;
+    dl_iterate_phdr(collect_text, obj);
+    if (obj->segments == 0)
+        return 0;
+
+    for (int i = 0; i < obj->segments; i++) {
+        uintptr_t start = (obj->start[i] + HUGE_PAGE - 1) & ~(HUGE_PAGE - 1);
+        uintptr_t end = obj->end[i] & ~(HUGE_PAGE - 1);
+
+        if (result != NULL)
+            result->text_bytes += obj->end[i] - obj->start[i];
+        if (end <= start || !thp_enabled())
+            continue;
+        if (remap_range(start, end, result) < 0)
+            return -1;
+        ret = 1;
+    }
+    return ret;
+}
+
+int sparetools_hugetext_remap(const char *object, SPARETOOLS_HUGETEXT_RESULT *result) {
+    text_object obj;
+
+    memset(&obj, 0, sizeof(obj));
+    obj.name = object != NULL ? object : "";
+    return remap_object(&obj, result);
+}
+
+int sparetools_hugetext_remap_openssl(SPARETOOLS_HUGETEXT_RESULT *result) {
+    text_object crypto, ssl;
+    void *ssl_sym;
+    int ret, ssl_ret;
+
+    memset(&crypto, 0, sizeof(crypto));
+    crypto.addr = (uintptr_t)&OpenSSL_version;
+    ret = remap_object(&crypto, result);
+    if (ret < 0)
+        return ret;
+
+    /* libssl is optional here and looked up without linking against it */
+    ssl_sym = dlsym(RTLD_DEFAULT, "SSL_new");
+    if (ssl_sym == NULL)
+        return ret;
+    memset(&ssl, 0, sizeof(ssl));
+    ssl.addr = (uintptr_t)ssl_sym;
+    dl_iterate_phdr(collect_text, &ssl);
+    /* Statically linked: libssl is in the object just remapped */
+    if (ssl.segments > 0 && crypto.segments > 0 && ssl.start[0] == crypto.start[0])
+        return ret;
+    ssl_ret = remap_object(&ssl, result);
+    return ssl_ret < 0 ? ssl_ret : (ret || ssl_ret);
+}
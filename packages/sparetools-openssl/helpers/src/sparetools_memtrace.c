@@ -0,0 +1,262 @@
+#include "sparetools_memtrace.h"
+
+#include <openssl/crypto.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Call sites live in a fixed open-addressing table keyed by the file
+ * pointer (OpenSSL passes OPENSSL_FILE, one literal per translation unit)
+ * and line. Lookups are lock-free; inserting a new site takes a spinlock,
+ * writes the line and then publishes the file pointer, so a reader that
+ * sees the file also sees the line.
+ */
+#define MEMTRACE_SITES 16384
+
+typedef struct {
+    _Atomic(const char *) file;
+    int line;
+    atomic_ullong allocs;
+    atomic_ullong reallocs;
+    atomic_ullong frees;
+    atomic_ullong bytes;
+} memtrace_site;
+
+static memtrace_site sites[MEMTRACE_SITES];
+static memtrace_site overflow_site;
+static atomic_flag insert_lock = ATOMIC_FLAG_INIT;
+
+static atomic_ullong total_allocs;
+static atomic_ullong total_reallocs;
+static atomic_ullong total_frees;
+static atomic_ullong total_bytes;
+
+/* Allocator being traced; NULL means the libc allocator */
+static CRYPTO_malloc_fn next_malloc;
+static CRYPTO_realloc_fn next_realloc;
+static CRYPTO_free_fn next_free;
+
+static const char *const unknown_file = "(unknown)";
+
+static size_t site_hash(const char *file, int line) {
+    uintptr_t h = (uintptr_t)file;
+
+    h ^= h >> 17;
+    h = h * 31 + (uintptr_t)line;
+    h ^= h >> 13;
+    return (size_t)(h & (MEMTRACE_SITES - 1));
+}
+
+static memtrace_site *find_site(const char *file, int line) {
+    size_t start, i;
+
+    if (file == NULL)
+        file = unknown_file;
+    start = site_hash(file, line);
+
+    for (i = start;;) {
+        const char *f = atomic_load_explicit(&sites[i].file, memory_order_acquire);
+
+        if (f == NULL)
+            break;
+        if (f == file && sites[i].line == line)
+            return &sites[i];
+        i = (i + 1) & (MEMTRACE_SITES - 1);
+        if (i == start)
+            return &overflow_site;
+    }
+
+    /* Not found: insert under the lock, re-probing from the start */
+    while (atomic_flag_test_and_set_explicit(&insert_lock, memory_order_acquire))
+        ;
+    for (i = start;;) {
+        const char *f = atomic_load_explicit(&sites[i].file, memory_order_relaxed);
+
+        if (f == NULL) {
+            sites[i].line = line;
+            atomic_store_explicit(&sites[i].file, file, memory_order_release);
+            break;
+        }
+        if (f == file && sites[i].line == line)
+            break;
+        i = (i + 1) & (MEMTRACE_SITES - 1);
+        if (i == start) {
+            atomic_flag_clear_explicit(&insert_lock, memory_order_release);
+            return &overflow_site;
+        }
+    }
+    atomic_flag_clear_explicit(&insert_lock, memory_order_release);
+    return &sites[i];
+}
+
+static void *trace_malloc(size_t num, const char *file, int line) {
+    memtrace_site *site = find_site(file, line);
+
+    atomic_fetch_add_explicit(&site->allocs, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&site->bytes, num, memory_order_relaxed);
+    atomic_fetch_add_explicit(&total_allocs, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&total_bytes, num, memory_order_relaxed);
+    return next_malloc != NULL ? next_malloc(num, file, line) : malloc(num);
+}
+
+static void *trace_realloc(void *addr, size_t num, const char *file, int line) {
+    memtrace_site *site = find_site(file, line);
+
+    atomic_fetch_add_explicit(&site->reallocs, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&site->bytes, num, memory_order_relaxed);
+    atomic_fetch_add_explicit(&total_reallocs, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&total_bytes, num, memory_order_relaxed);
+    return next_realloc != NULL ? next_realloc(addr, num, file, line) : realloc(addr, num);
+}
+
+static void trace_free(void *addr, const char *file, int line) {
+    if (addr != NULL) {
+        memtrace_site *site = find_site(file, line);
+
+        atomic_fetch_add_explicit(&site->frees, 1, memory_order_relaxed);
+        atomic_fetch_add_explicit(&total_frees, 1, memory_order_relaxed);
+    }
+    if (next_free != NULL)
+        next_free(addr, file, line);
+    else
+        free(addr);
+}
+
+static void dump_at_exit(void) {
+    const char *path = getenv("SPARETOOLS_MEMTRACE");
+
+    if (path != NULL && *path != '\0')
+        sparetools_memtrace_dump(path);
+}
+
+int sparetools_memtrace_install(void) {
+    static atomic_int installed;
+    CRYPTO_malloc_fn m;
+    CRYPTO_realloc_fn r;
+    CRYPTO_free_fn f;
+
+    CRYPTO_get_mem_functions(&m, &r, &f);
+    if (m == trace_malloc)
+        return 1;
+    /* The defaults are the CRYPTO_* entry points themselves */
+    if (m == CRYPTO_malloc) {
+        m = NULL;
+        r = NULL;
+        f = NULL;
+    }
+    next_malloc = m;
+    next_realloc = r;
+    next_free = f;
+    if (!CRYPTO_set_mem_functions(trace_malloc, trace_realloc, trace_free))
+        return 0;
+
+    if (atomic_exchange(&installed, 1) == 0)
+        atexit(dump_at_exit);
+    return 1;
+}
+
+void sparetools_memtrace_totals(SPARETOOLS_MEMTRACE_TOTALS *out) {
+    out->allocs = atomic_load(&total_allocs);
+    out->reallocs = atomic_load(&total_reallocs);
+    out->frees = atomic_load(&total_frees);
+    out->bytes = atomic_load(&total_bytes);
+}
+
+typedef struct {
+    const char *file;
+    int line;
+    unsigned long long allocs, reallocs, frees, bytes;
+} site_row;
+
+static int row_cmp(const void *a, const void *b) {
+    const site_row *x = a, *y = b;
+    unsigned long long xa = x->allocs + x->reallocs, ya = y->allocs + y->reallocs;
+
+    if (xa != ya)
+        return xa < ya ? 1 : -1;
+    if (x->bytes != y->bytes)
+        return x->bytes < y->bytes ? 1 : -1;
+    return x->frees < y->frees ? 1 : (x->frees > y->frees ? -1 : 0);
+}
+
+static void write_json_string(FILE *fp, const char *s) {
+    fputc('"', fp);
+    for (; *s != '\0'; s++) {
+        if (*s == '"' || *s == '\\')
+            fputc('\\', fp);
+        fputc(*s, fp);
+    }
+    fputc('"', fp);
+}
+
+static void snapshot_site(const memtrace_site *site, const char *file, site_row *row) {
+    row->file = file;
+    row->line = site->line;
+    row->allocs = atomic_load(&site->allocs);
+    row->reallocs = atomic_load(&site->reallocs);
+    row->frees = atomic_load(&site->frees);
+    row->bytes = atomic_load(&site->bytes);
+}
+
+int sparetools_memtrace_dump(const char *path) {
+    SPARETOOLS_MEMTRACE_TOTALS totals;
+    site_row *rows;
+    size_t n = 0;
+    FILE *fp;
+
+    /* Plain malloc: the table must not trace its own dump */
+    rows = malloc((MEMTRACE_SITES + 1) * sizeof(*rows));
+    if (rows == NULL)
+        return 1;
+    for (size_t i = 0; i < MEMTRACE_SITES; i++) {
+        const char *file = atomic_load_explicit(&sites[i].file, memory_order_acquire);
+
+        if (file != NULL)
+            snapshot_site(&sites[i], file, &rows[n++]);
+    }
+    if (atomic_load(&overflow_site.allocs) + atomic_load(&overflow_site.frees) > 0)
+        snapshot_site(&overflow_site, "(overflow)", &rows[n++]);
+    qsort(rows, n, sizeof(*rows), row_cmp);
+
+    fp = strcmp(path, "-") == 0 ? stdout : fopen(path, "w");
+    if (fp == NULL) {
+        free(rows);
+        return 1;
+    }
+
+    sparetools_memtrace_totals(&totals);
+    fprintf(fp, "{\n  \"openssl_version\": ");
+    write_json_string(fp, OpenSSL_version(OPENSSL_VERSION));
+    fprintf(fp, ",\n  \"totals\": {\"allocs\": %llu, \"reallocs\": %llu, "
+                "\"frees\": %llu, \"bytes\": %llu},\n  \"sites\": [",
+            (unsigned long long)totals.allocs, (unsigned long long)totals.reallocs,
+            (unsigned long long)totals.frees, (unsigned long long)totals.bytes);
+    for (size_t i = 0; i < n; i++) {
+        fprintf(fp, "%s\n    {\"file\": ", i == 0 ? "" : ",");
+        write_json_string(fp, rows[i].file);
+        fprintf(fp, ", \"line\": %d, \"allocs\": %llu, \"reallocs\": %llu, "
+                    "\"frees\": %llu, \"bytes\": %llu}",
+                rows[i].line, rows[i].allocs, rows[i].reallocs, rows[i].frees, rows[i].bytes);
+    }
+    fprintf(fp, "%s]\n}\n", n > 0 ? "\n  " : "");
+
+    if (fp != stdout)
+        fclose(fp);
+    free(rows);
+    return 0;
+}
+
+#ifdef SPARETOOLS_MEMTRACE_AUTOINSTALL
+/* mem_trace=True packages: trace from load time when SPARETOOLS_MEMTRACE is set */
+# if defined(__GNUC__) || defined(__clang__)
+__attribute__((constructor))
+static void memtrace_autoinstall(void) {
+    const char *path = getenv("SPARETOOLS_MEMTRACE");
+
+    if (path != NULL && *path != '\0')
+        sparetools_memtrace_install();
+}
+# endif
+#endif
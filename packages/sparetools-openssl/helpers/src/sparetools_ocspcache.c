@@ -0,0 +1,473 @@
+#include "sparetools_ocspcache.h"
+
+#include <openssl/crypto.h>
+#include <openssl/err.h>
+#include <openssl/http.h>
+#include <openssl/x509v3.h>
+#include <errno.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define DEFAULT_REFRESH_INTERVAL 3600
+#define DEFAULT_POLL_SECONDS 60
+#define HTTP_TIMEOUT_SECONDS 10
+/* Clock skew tolerated between us and the responder (OCSP_check_validity) */
+#define VALIDITY_LEEWAY 300
+
+/*
+ * Entries are allocated once and only freed with the cache, so the
+ * refresh path can fetch for an entry without holding the lock; cert,
+ * issuer, id and store never change after sparetools_ocspcache_add().
+ * The response fields are guarded by the cache lock: the status callback
+ * copies der under the read lock, refresh swaps it under the write lock.
+ */
+typedef struct {
+    X509 *cert;
+    X509 *issuer;
+    OCSP_CERTID *id;
+    X509_STORE *store;          /* Issuer as anchor when the cache has none */
+    unsigned char *der;         /* Validated response, NULL until the first */
+    size_t der_len;
+    time_t next_update;         /* 0: response carries no nextUpdate */
+    time_t refresh_at;          /* 0: due now */
+    int revoked;                /* der says the certificate is revoked */
+} ocsp_entry;
+
+struct sparetools_ocspcache_st {
+    SPARETOOLS_OCSP_FETCH_FN fetch;
+    void *fetch_arg;
+    X509_STORE *store;
+    long refresh_interval;
+
+    CRYPTO_RWLOCK *lock;
+    ocsp_entry **entries;
+    size_t count;
+    size_t capacity;
+
+    pthread_mutex_t refresh_lock;   /* One refresh pass at a time */
+
+    pthread_mutex_t thread_lock;
+    pthread_cond_t wake;
+    pthread_t thread;
+    int running;
+    int stopping;
+    long poll_seconds;
+
+    atomic_uint_least64_t hits, misses, refreshes, failures;
+};
+
+static void count(atomic_uint_least64_t *counter) {
+    atomic_fetch_add_explicit(counter, 1, memory_order_relaxed);
+}
+
+static time_t asn1_to_time(const ASN1_GENERALIZEDTIME *t, time_t now) {
+    int days, secs;
+
+    if (t == NULL || !ASN1_TIME_diff(&days, &secs, NULL, t))
+        return 0;
+    return now + (time_t)days * 86400 + secs;
+}
+
+static int response_live(const ocsp_entry *e, time_t now) {
+    return e->der != NULL && (e->next_update == 0 || now < e->next_update);
+}
+
+/* Caller holds the lock; pointer match first, the usual case for SSL_get_certificate */
+static ocsp_entry *find_locked(SPARETOOLS_OCSPCACHE *cache, X509 *cert) {
+    for (size_t i = 0; i < cache->count; i++)
+        if (cache->entries[i]->cert == cert)
+            return cache->entries[i];
+    for (size_t i = 0; i < cache->count; i++)
+        if (X509_cmp(cache->entries[i]->cert, cert) == 0)
+            return cache->entries[i];
+    return NULL;
+}
+
+static void free_entry(ocsp_entry *e) {
+    X509_free(e->cert);
+    X509_free(e->issuer);
+    OCSP_CERTID_free(e->id);
+    X509_STORE_free(e->store);
+    OPENSSL_free(e->der);
+    free(e);
+}
+
+/*
+ * Verify resp for e: successful, signed by the CA or a responder it
+ * delegated to, certificate status good or revoked (the client must see
+ * a revocation, so it replaces a good response) and within its validity
+ * window. Fills the update times and the revoked flag on success.
+ */
+static int validate(SPARETOOLS_OCSPCACHE *cache, ocsp_entry *e, OCSP_RESPONSE *resp,
+                    time_t *this_out, time_t *next_out, int *revoked_out) {
+    OCSP_BASICRESP *bs = NULL;
+    STACK_OF(X509) *certs = NULL;
+    ASN1_GENERALIZEDTIME *this_update = NULL, *next_update = NULL, *revoked = NULL;
+    int status, reason, ok = 0;
+    time_t now = time(NULL);
+
+    if (OCSP_response_status(resp) != OCSP_RESPONSE_STATUS_SUCCESSFUL
+        || (bs = OCSP_response_get1_basic(resp)) == NULL
+        || (certs = sk_X509_new_null()) == NULL
+        || !sk_X509_push(certs, e->issuer))
+        goto done;
+    if (OCSP_basic_verify(bs, certs, cache->store != NULL ? cache->store : e->store, 0) <= 0)
+        goto done;
+    if (!OCSP_resp_find_status(bs, e->id, &status, &reason, &revoked, &this_update, &next_update)
+        || (status != V_OCSP_CERTSTATUS_GOOD && status != V_OCSP_CERTSTATUS_REVOKED)
+        || !OCSP_check_validity(this_update, next_update, VALIDITY_LEEWAY, -1))
+        goto done;
+    *this_out = asn1_to_time(this_update, now);
+    *next_out = next_update != NULL ? asn1_to_time(next_update, now) : 0;
+    *revoked_out = status == V_OCSP_CERTSTATUS_REVOKED;
+    ok = 1;
+done:
+    sk_X509_free(certs);
+    OCSP_BASICRESP_free(bs);
+    ERR_clear_error();
+    return ok;
+}
+
+/* Validate and install; takes the write lock. Returns 1 if accepted. */
+static int install(SPARETOOLS_OCSPCACHE *cache, ocsp_entry *e, OCSP_RESPONSE *resp) {
+    unsigned char *der = NULL;
+    int len, revoked;
+    time_t this_update, next_update, now = time(NULL), refresh_at;
+
+    if (!validate(cache, e, resp, &this_update, &next_update, &revoked)
+        || (len = i2d_OCSP_RESPONSE(resp, &der)) <= 0)
+        return 0;
+
+    /* Half way through the window, so one failed refresh is not an outage */
+    refresh_at = next_update != 0 ? this_update + (next_update - this_update) / 2
+                                  : now + cache->refresh_interval;
+    if (refresh_at <= now)
+        refresh_at = now + 1;
+
+    if (!CRYPTO_THREAD_write_lock(cache->lock)) {
+        OPENSSL_free(der);
+        return 0;
+    }
+    OPENSSL_free(e->der);
+    e->der = der;
+    e->der_len = (size_t)len;
+    e->next_update = next_update;
+    e->refresh_at = refresh_at;
+    e->revoked = revoked;
+    CRYPTO_THREAD_unlock(cache->lock);
+    return 1;
+}
+
+static void schedule_retry(SPARETOOLS_OCSPCACHE *cache, ocsp_entry *e) {
+    time_t now = time(NULL);
+
+    if (!CRYPTO_THREAD_write_lock(cache->lock))
+        return;
+    e->refresh_at = now + cache->refresh_interval;
+    /* Keep retrying before the response we still serve runs out */
+    if (e->next_update > now && e->refresh_at > e->next_update)
+        e->refresh_at = now + (e->next_update - now) / 2 + 1;
+    CRYPTO_THREAD_unlock(cache->lock);
+}
+
+/* Built-in fetcher: POST to each AIA OCSP URL over plain HTTP until one answers */
+static OCSP_RESPONSE *http_fetch(X509 *cert, X509 *issuer, OCSP_REQUEST *req, void *arg) {
+    STACK_OF(OPENSSL_STRING) *urls = X509_get1_ocsp(cert);
+    OCSP_RESPONSE *resp = NULL;
+
+    (void)issuer;
+    (void)arg;
+    for (int i = 0; resp == NULL && i < sk_OPENSSL_STRING_num(urls); i++) {
+        char *host = NULL, *port = NULL, *path = NULL;
+        int use_ssl = 0;
+        BIO *body = NULL, *rsp = NULL;
+
+        if (OSSL_HTTP_parse_url(sk_OPENSSL_STRING_value(urls, i), &use_ssl, NULL, &host, &port,
+                                NULL, &path, NULL, NULL)
+            && !use_ssl
+            && (body = ASN1_item_i2d_mem_bio(ASN1_ITEM_rptr(OCSP_REQUEST), (const ASN1_VALUE *)req)) != NULL
+            && (rsp = OSSL_HTTP_transfer(NULL, host, port, path, 0, NULL, NULL, NULL, NULL, NULL, NULL,
+                                         0, NULL, "application/ocsp-request", body,
+                                         "application/ocsp-response", 1, 0,
+                                         HTTP_TIMEOUT_SECONDS, 0)) != NULL)
+            resp = d2i_OCSP_RESPONSE_bio(rsp, NULL);
+        BIO_free(rsp);
+        BIO_free(body);
+        OPENSSL_free(host);
+        OPENSSL_free(port);
+        OPENSSL_free(path);
+    }
+    X509_email_free(urls);
+    return resp;
+}
+
+static int refresh_entry(SPARETOOLS_OCSPCACHE *cache, ocsp_entry *e) {
+    OCSP_REQUEST *req = OCSP_REQUEST_new();
+    OCSP_CERTID *id = OCSP_CERTID_dup(e->id);
+    OCSP_RESPONSE *resp = NULL;
+    int ok = 0;
+
+    if (req != NULL && id != NULL && OCSP_request_add0_id(req, id) != NULL) {
+        id = NULL;
+        resp = cache->fetch(e->cert, e->issuer, req, cache->fetch_arg);
+        ok = resp != NULL && install(cache, e, resp);
+    }
+    OCSP_CERTID_free(id);
+    OCSP_REQUEST_free(req);
+    OCSP_RESPONSE_free(resp);
+    ERR_clear_error();
+
+    count(ok ? &cache->refreshes : &cache->failures);
+    if (!ok)
+        schedule_retry(cache, e);
+    return ok;
+}
+
+SPARETOOLS_OCSPCACHE *sparetools_ocspcache_new(SPARETOOLS_OCSP_FETCH_FN fetch, void *arg,
+                                              X509_STORE *store, long refresh_interval) {
+    SPARETOOLS_OCSPCACHE *cache = calloc(1, sizeof(*cache));
+
+    if (cache == NULL)
+        return NULL;
+    if ((cache->lock = CRYPTO_THREAD_lock_new()) == NULL
+        || (store != NULL && !X509_STORE_up_ref(store))) {
+        CRYPTO_THREAD_lock_free(cache->lock);
+        free(cache);
+        return NULL;
+    }
+    cache->fetch = fetch != NULL ? fetch : http_fetch;
+    cache->fetch_arg = arg;
+    cache->store = store;
+    cache->refresh_interval = refresh_interval > 0 ? refresh_interval : DEFAULT_REFRESH_INTERVAL;
+    pthread_mutex_init(&cache->refresh_lock, NULL);
+    pthread_mutex_init(&cache->thread_lock, NULL);
+    pthread_cond_init(&cache->wake, NULL);
+    return cache;
+}
+
+void sparetools_ocspcache_free(SPARETOOLS_OCSPCACHE *cache) {
+    if (cache == NULL)
+        return;
+    sparetools_ocspcache_stop(cache);
+    for (size_t i = 0; i < cache->count; i++)
+        free_entry(cache->entries[i]);
+    free(cache->entries);
+    X509_STORE_free(cache->store);
+    CRYPTO_THREAD_lock_free(cache->lock);
+    pthread_cond_destroy(&cache->wake);
+    pthread_mutex_destroy(&cache->thread_lock);
+    pthread_mutex_destroy(&cache->refresh_lock);
+    free(cache);
+}
+
+int sparetools_ocspcache_add(SPARETOOLS_OCSPCACHE *cache, X509 *cert, X509 *issuer) {
+    ocsp_entry *e;
+    int ok = 0;
+
+    if (cache == NULL || cert == NULL || issuer == NULL || (e = calloc(1, sizeof(*e))) == NULL)
+        return 0;
+    if (!X509_up_ref(cert)) {
+        free(e);
+        return 0;
+    }
+    e->cert = cert;
+    if (!X509_up_ref(issuer))
+        goto err;
+    e->issuer = issuer;
+    if ((e->id = OCSP_cert_to_id(NULL, cert, issuer)) == NULL)
+        goto err;
+    if (cache->store == NULL
+        && ((e->store = X509_STORE_new()) == NULL
+            || !X509_STORE_add_cert(e->store, issuer)
+            || !X509_STORE_set_flags(e->store, X509_V_FLAG_PARTIAL_CHAIN)))
+        goto err;
+
+    if (!CRYPTO_THREAD_write_lock(cache->lock))
+        goto err;
+    if (find_locked(cache, cert) == NULL) {
+        if (cache->count == cache->capacity) {
+            size_t capacity = cache->capacity ? cache->capacity * 2 : 8;
+            ocsp_entry **entries = realloc(cache->entries, capacity * sizeof(*entries));
+
+            if (entries != NULL) {
+                cache->entries = entries;
+                cache->capacity = capacity;
+            }
+        }
+        if (cache->count < cache->capacity) {
+            cache->entries[cache->count++] = e;
+            e = NULL;
+            ok = 1;
+        }
+    } else {
+        ok = 1;     /* Already registered */
+    }
+    CRYPTO_THREAD_unlock(cache->lock);
+    if (e != NULL)
+        free_entry(e);
+    return ok;
+err:
+    free_entry(e);
+    return 0;
+}
+
+int sparetools_ocspcache_set_response(SPARETOOLS_OCSPCACHE *cache, X509 *cert,
+                                      const unsigned char *der, size_t len) {
+    const unsigned char *p = der;
+    OCSP_RESPONSE *resp;
+    ocsp_entry *e;
+    int ok;
+
+    if (cache == NULL || cert == NULL || der == NULL || len > LONG_MAX
+        || !CRYPTO_THREAD_read_lock(cache->lock))
+        return 0;
+    e = find_locked(cache, cert);
+    CRYPTO_THREAD_unlock(cache->lock);
+    if (e == NULL || (resp = d2i_OCSP_RESPONSE(NULL, &p, (long)len)) == NULL) {
+        ERR_clear_error();
+        return 0;
+    }
+    ok = install(cache, e, resp);
+    OCSP_RESPONSE_free(resp);
+    count(ok ? &cache->refreshes : &cache->failures);
+    return ok;
+}
+
+int sparetools_ocspcache_refresh(SPARETOOLS_OCSPCACHE *cache, int force) {
+    int accepted = 0;
+
+    if (cache == NULL)
+        return 0;
+    pthread_mutex_lock(&cache->refresh_lock);
+    for (size_t i = 0;; i++) {
+        ocsp_entry *e = NULL;
+        int due = 0;
+
+        /* Entries are only appended, so index i stays valid across add() */
+        if (!CRYPTO_THREAD_read_lock(cache->lock))
+            break;
+        if (i < cache->count) {
+            e = cache->entries[i];
+            due = force || e->refresh_at <= time(NULL);
+        }
+        CRYPTO_THREAD_unlock(cache->lock);
+        if (e == NULL)
+            break;
+        if (due)
+            accepted += refresh_entry(cache, e);
+    }
+    pthread_mutex_unlock(&cache->refresh_lock);
+    return accepted;
+}
+
+static void *refresh_main(void *arg) {
+    SPARETOOLS_OCSPCACHE *cache = arg;
+
+    pthread_mutex_lock(&cache->thread_lock);
+    while (!cache->stopping) {
+        struct timespec deadline;
+
+        pthread_mutex_unlock(&cache->thread_lock);
+        sparetools_ocspcache_refresh(cache, 0);
+        pthread_mutex_lock(&cache->thread_lock);
+
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_sec += cache->poll_seconds;
+        while (!cache->stopping
+               && pthread_cond_timedwait(&cache->wake, &cache->thread_lock, &deadline) != ETIMEDOUT)
+            ;
+    }
+    pthread_mutex_unlock(&cache->thread_lock);
+    return NULL;
+}
+
+int sparetools_ocspcache_start(SPARETOOLS_OCSPCACHE *cache, long poll_seconds) {
+    int ok = 1;
+
+    if (cache == NULL)
+        return 0;
+    pthread_mutex_lock(&cache->thread_lock);
+    if (!cache->running) {
+        cache->poll_seconds = poll_seconds > 0 ? poll_seconds : DEFAULT_POLL_SECONDS;
+        cache->stopping = 0;
+        ok = cache->running = pthread_create(&cache->thread, NULL, refresh_main, cache) == 0;
+    }
+    pthread_mutex_unlock(&cache->thread_lock);
+    return ok;
+}
+
+void sparetools_ocspcache_stop(SPARETOOLS_OCSPCACHE *cache) {
+    int running;
+
+    if (cache == NULL)
+        return;
+    pthread_mutex_lock(&cache->thread_lock);
+    running = cache->running;
+    cache->stopping = 1;
+    pthread_cond_broadcast(&cache->wake);
+    pthread_mutex_unlock(&cache->thread_lock);
+    if (running) {
+        /* A fetch in progress finishes first (bounded by the HTTP timeout) */
+        pthread_join(cache->thread, NULL);
+        cache->running = 0;
+    }
+}
+
+static int status_cb(SSL *ssl, void *arg) {
+    SPARETOOLS_OCSPCACHE *cache = arg;
+    X509 *cert = SSL_get_certificate(ssl);
+    unsigned char *copy = NULL;
+    size_t len = 0;
+    ocsp_entry *e;
+
+    if (cert == NULL || !CRYPTO_THREAD_read_lock(cache->lock))
+        return SSL_TLSEXT_ERR_NOACK;
+    e = find_locked(cache, cert);
+    if (e != NULL && response_live(e, time(NULL))) {
+        /* libssl frees the staple with the connection */
+        copy = OPENSSL_memdup(e->der, e->der_len);
+        len = e->der_len;
+    }
+    CRYPTO_THREAD_unlock(cache->lock);
+
+    if (copy == NULL || !SSL_set_tlsext_status_ocsp_resp(ssl, copy, (long)len)) {
+        OPENSSL_free(copy);
+        count(&cache->misses);
+        return SSL_TLSEXT_ERR_NOACK;
+    }
+    count(&cache->hits);
+    return SSL_TLSEXT_ERR_OK;
+}
+
+int sparetools_ocspcache_attach(SPARETOOLS_OCSPCACHE *cache, SSL_CTX *ctx) {
+    if (cache == NULL || ctx == NULL)
+        return 0;
+    return SSL_CTX_set_tlsext_status_cb(ctx, status_cb) == 1
+        && SSL_CTX_set_tlsext_status_arg(ctx, cache) == 1;
+}
+
+void sparetools_ocspcache_stats(SPARETOOLS_OCSPCACHE *cache, SPARETOOLS_OCSPCACHE_STATS *stats) {
+    time_t now = time(NULL);
+
+    memset(stats, 0, sizeof(*stats));
+    if (cache == NULL)
+        return;
+    stats->hits = atomic_load_explicit(&cache->hits, memory_order_relaxed);
+    stats->misses = atomic_load_explicit(&cache->misses, memory_order_relaxed);
+    stats->refreshes = atomic_load_explicit(&cache->refreshes, memory_order_relaxed);
+    stats->failures = atomic_load_explicit(&cache->failures, memory_order_relaxed);
+    if (!CRYPTO_THREAD_read_lock(cache->lock))
+        return;
+    stats->entries = cache->count;
+    for (size_t i = 0; i < cache->count; i++) {
+        int live = response_live(cache->entries[i], now);
+
+        stats->valid += live;
+        stats->revoked += live && cache->entries[i]->revoked;
+    }
+    CRYPTO_THREAD_unlock(cache->lock);
+}
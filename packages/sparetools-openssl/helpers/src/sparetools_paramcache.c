@@ -0,0 +1,117 @@
+#include "sparetools_paramcache.h"
+
+#include <openssl/crypto.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#define strcasecmp _stricmp
+#else
+#include <strings.h>
+#endif
+
+typedef struct {
+    char *name;
+    OSSL_PARAM *params;   /* OSSL_PARAM_dup: array and values in one block */
+} paramcache_entry;
+
+struct sparetools_paramcache_st {
+    paramcache_entry *entries;
+    int count;
+    int capacity;
+};
+
+SPARETOOLS_PARAMCACHE *sparetools_paramcache_new(void) {
+    return calloc(1, sizeof(SPARETOOLS_PARAMCACHE));
+}
+
+void sparetools_paramcache_free(SPARETOOLS_PARAMCACHE *cache) {
+    if (cache == NULL)
+        return;
+
+    for (int i = 0; i < cache->count; i++) {
+        OSSL_PARAM_free(cache->entries[i].params);
+        OPENSSL_free(cache->entries[i].name);
+    }
+    free(cache->entries);
+    free(cache);
+}
+
+static const paramcache_entry *lookup(const SPARETOOLS_PARAMCACHE *cache, const char *name) {
+    for (int i = 0; i < cache->count; i++) {
+        if (strcasecmp(cache->entries[i].name, name) == 0)
+            return &cache->entries[i];
+    }
+    return NULL;
+}
+
+int sparetools_paramcache_add(SPARETOOLS_PARAMCACHE *cache, const char *name,
+                              const OSSL_PARAM *params) {
+    paramcache_entry entry;
+
+    if (cache == NULL || name == NULL || params == NULL || lookup(cache, name) != NULL)
+        return 0;
+    if (cache->count == cache->capacity) {
+        int capacity = cache->capacity ? cache->capacity * 2 : 8;
+        paramcache_entry *entries = realloc(cache->entries, (size_t)capacity * sizeof(*entries));
+
+        if (entries == NULL)
+            return 0;
+        cache->entries = entries;
+        cache->capacity = capacity;
+    }
+    /* OSSL_PARAM_dup returns NULL for an array holding only the end marker */
+    if ((entry.params = OSSL_PARAM_dup(params)) == NULL && params->key != NULL)
+        return 0;
+    if (entry.params == NULL)
+        entry.params = OPENSSL_zalloc(sizeof(OSSL_PARAM));
+    if (entry.params == NULL || (entry.name = OPENSSL_strdup(name)) == NULL) {
+        OSSL_PARAM_free(entry.params);
+        return 0;
+    }
+    cache->entries[cache->count++] = entry;
+    return 1;
+}
+
+const OSSL_PARAM *sparetools_paramcache_get(const SPARETOOLS_PARAMCACHE *cache,
+                                            const char *name) {
+    const paramcache_entry *entry;
+
+    if (cache == NULL || name == NULL || (entry = lookup(cache, name)) == NULL)
+        return NULL;
+    return entry->params;
+}
+
+int sparetools_paramcache_count(const SPARETOOLS_PARAMCACHE *cache) {
+    return cache != NULL ? cache->count : 0;
+}
+
+static int overridden(const OSSL_PARAM *per_call, const char *key) {
+    for (; per_call != NULL && per_call->key != NULL; per_call++) {
+        if (strcmp(per_call->key, key) == 0)
+            return 1;
+    }
+    return 0;
+}
+
+int sparetools_params_merge(const OSSL_PARAM *tmpl, const OSSL_PARAM *per_call,
+                            OSSL_PARAM *out, size_t out_len) {
+    size_t n = 0;
+
+    for (; tmpl != NULL && tmpl->key != NULL; tmpl++) {
+        if (overridden(per_call, tmpl->key))
+            continue;
+        if (n + 1 >= out_len)
+            return -1;
+        out[n++] = *tmpl;
+    }
+    for (; per_call != NULL && per_call->key != NULL; per_call++) {
+        if (n + 1 >= out_len)
+            return -1;
+        out[n++] = *per_call;
+    }
+    if (n >= out_len)
+        return -1;
+    out[n] = OSSL_PARAM_construct_end();
+    return (int)n;
+}
@@ -0,0 +1,180 @@
+#include "sparetools_ringbio.h"
+
+#include <openssl/crypto.h>
+#include <string.h>
+
+typedef struct {
+    SPARETOOLS_RING *in;
+    SPARETOOLS_RING *out;
+} ring_pair;
+
+static CRYPTO_ONCE method_once = CRYPTO_ONCE_STATIC_INIT;
+static BIO_METHOD *ring_method;
+
+int sparetools_ring_init(SPARETOOLS_RING *ring, unsigned char *data, size_t size) {
+    if (ring == NULL || data == NULL || size == 0 || (size & (size - 1)) != 0)
+        return 0;
+    ring->data = data;
+    ring->size = size;
+    ring->head = 0;
+    ring->tail = 0;
+    return 1;
+}
+
+size_t sparetools_ring_used(const SPARETOOLS_RING *ring) {
+    return ring->tail - ring->head;
+}
+
+size_t sparetools_ring_peek(const SPARETOOLS_RING *ring, const unsigned char **span) {
+    size_t off = ring->head & (ring->size - 1);
+    size_t used = ring->tail - ring->head;
+
+    *span = ring->data + off;
+    return used < ring->size - off ? used : ring->size - off;
+}
+
+void sparetools_ring_consume(SPARETOOLS_RING *ring, size_t n) {
+    ring->head += n;
+}
+
+size_t sparetools_ring_reserve(SPARETOOLS_RING *ring, unsigned char **span) {
+    size_t off = ring->tail & (ring->size - 1);
+    size_t room = ring->size - (ring->tail - ring->head);
+
+    *span = ring->data + off;
+    return room < ring->size - off ? room : ring->size - off;
+}
+
+void sparetools_ring_commit(SPARETOOLS_RING *ring, size_t n) {
+    ring->tail += n;
+}
+
+/* Copy up to len bytes across the wrap point; returns the bytes copied */
+static size_t ring_read(SPARETOOLS_RING *ring, unsigned char *buf, size_t len) {
+    size_t done = 0;
+
+    while (done < len) {
+        const unsigned char *span;
+        size_t n = sparetools_ring_peek(ring, &span);
+
+        if (n == 0)
+            break;
+        if (n > len - done)
+            n = len - done;
+        memcpy(buf + done, span, n);
+        sparetools_ring_consume(ring, n);
+        done += n;
+    }
+    return done;
+}
+
+static size_t ring_write(SPARETOOLS_RING *ring, const unsigned char *buf, size_t len) {
+    size_t done = 0;
+
+    while (done < len) {
+        unsigned char *span;
+        size_t n = sparetools_ring_reserve(ring, &span);
+
+        if (n == 0)
+            break;
+        if (n > len - done)
+            n = len - done;
+        memcpy(span, buf + done, n);
+        sparetools_ring_commit(ring, n);
+        done += n;
+    }
+    return done;
+}
+
+static int ringbio_read(BIO *bio, char *buf, size_t len, size_t *readbytes) {
+    ring_pair *rings = BIO_get_data(bio);
+
+    BIO_clear_retry_flags(bio);
+    *readbytes = rings->in != NULL ? ring_read(rings->in, (unsigned char *)buf, len) : 0;
+    if (*readbytes == 0 && len > 0) {
+        BIO_set_retry_read(bio);
+        return 0;
+    }
+    return 1;
+}
+
+static int ringbio_write(BIO *bio, const char *buf, size_t len, size_t *written) {
+    ring_pair *rings = BIO_get_data(bio);
+
+    BIO_clear_retry_flags(bio);
+    *written = rings->out != NULL ? ring_write(rings->out, (const unsigned char *)buf, len) : 0;
+    if (*written == 0 && len > 0) {
+        BIO_set_retry_write(bio);
+        return 0;
+    }
+    return 1;
+}
+
+static long ringbio_ctrl(BIO *bio, int cmd, long num, void *ptr) {
+    ring_pair *rings = BIO_get_data(bio);
+
+    (void)num;
+    (void)ptr;
+    switch (cmd) {
+    case BIO_CTRL_PENDING:
+        return rings->in != NULL ? (long)sparetools_ring_used(rings->in) : 0;
+    case BIO_CTRL_WPENDING:
+        return rings->out != NULL ? (long)sparetools_ring_used(rings->out) : 0;
+    case BIO_CTRL_FLUSH:
+    case BIO_CTRL_DUP:
+        return 1;
+    default:
+        return 0;
+    }
+}
+
+static int ringbio_create(BIO *bio) {
+    ring_pair *rings = OPENSSL_zalloc(sizeof(*rings));
+
+    if (rings == NULL)
+        return 0;
+    BIO_set_data(bio, rings);
+    BIO_set_init(bio, 1);
+    return 1;
+}
+
+static int ringbio_destroy(BIO *bio) {
+    /* The rings and their storage belong to the caller */
+    OPENSSL_free(BIO_get_data(bio));
+    BIO_set_data(bio, NULL);
+    return 1;
+}
+
+static void init_method(void) {
+    BIO_METHOD *method = BIO_meth_new(BIO_get_new_index() | BIO_TYPE_SOURCE_SINK, "SpareTools ring");
+
+    if (method != NULL
+        && (!BIO_meth_set_read_ex(method, ringbio_read)
+            || !BIO_meth_set_write_ex(method, ringbio_write)
+            || !BIO_meth_set_ctrl(method, ringbio_ctrl)
+            || !BIO_meth_set_create(method, ringbio_create)
+            || !BIO_meth_set_destroy(method, ringbio_destroy))) {
+        BIO_meth_free(method);
+        method = NULL;
+    }
+    ring_method = method;
+}
+
+const BIO_METHOD *sparetools_ringbio_method(void) {
+    if (!CRYPTO_THREAD_run_once(&method_once, init_method))
+        return NULL;
+    return ring_method;
+}
+
+BIO *sparetools_ringbio_new(SPARETOOLS_RING *in, SPARETOOLS_RING *out) {
+    const BIO_METHOD *method = sparetools_ringbio_method();
+    BIO *bio = method != NULL ? BIO_new(method) : NULL;
+    ring_pair *rings;
+
+    if (bio == NULL)
+        return NULL;
+    rings = BIO_get_data(bio);
+    rings->in = in;
+    rings->out = out;
+    return bio;
+}
@@ -0,0 +1,103 @@
+#include "sparetools_secheap.h"
+
+#include <openssl/crypto.h>
+#include <ctype.h>
+#include <errno.h>
+#include <stdlib.h>
+
+/* 1 locked, 2 not locked, 0 not initialised by us */
+static int init_result;
+static size_t init_size, init_min_size;
+
+static int is_pow2(size_t v) {
+    return v != 0 && (v & (v - 1)) == 0;
+}
+
+int sparetools_secheap_init(size_t size, size_t min_size) {
+#ifdef OPENSSL_NO_SECURE_MEMORY
+    (void)size;
+    (void)min_size;
+    return 0;
+#else
+    if (CRYPTO_secure_malloc_initialized())
+        return init_result != 0 ? init_result : 1;
+    /* sh_init asserts on these and aborts the process */
+    if (!is_pow2(size) || !is_pow2(min_size) || min_size >= size)
+        return 0;
+    init_result = CRYPTO_secure_malloc_init(size, min_size);
+    if (init_result != 0) {
+        init_size = size;
+        init_min_size = min_size;
+    }
+    return init_result;
+#endif
+}
+
+static int parse_size(const char *s, char **end, size_t *out) {
+    unsigned long long v;
+
+    if (!isdigit((unsigned char)*s))
+        return -1;
+    errno = 0;
+    v = strtoull(s, end, 10);
+    if (errno != 0)
+        return -1;
+    switch (**end) {
+    case 'k': case 'K': v <<= 10; (*end)++; break;
+    case 'm': case 'M': v <<= 20; (*end)++; break;
+    case 'g': case 'G': v <<= 30; (*end)++; break;
+    default: break;
+    }
+    *out = (size_t)v;
+    return 0;
+}
+
+int sparetools_secheap_parse(const char *spec, size_t *size, size_t *min_size) {
+    char *end;
+
+    *min_size = 32;
+    if (spec == NULL || parse_size(spec, &end, size) != 0)
+        return -1;
+    if (*end == ':' && parse_size(end + 1, &end, min_size) != 0)
+        return -1;
+    return *end == '\0' ? 0 : -1;
+}
+
+int sparetools_secheap_init_from_env(const char *default_spec) {
+    const char *spec = getenv("SPARETOOLS_SECURE_HEAP");
+    size_t size, min_size;
+
+    if (spec == NULL || *spec == '\0')
+        spec = default_spec;
+    if (spec == NULL || *spec == '\0')
+        return 0;
+    if (sparetools_secheap_parse(spec, &size, &min_size) != 0)
+        return -1;
+    return size == 0 ? 0 : sparetools_secheap_init(size, min_size);
+}
+
+void sparetools_secheap_info(SPARETOOLS_SECHEAP_INFO *out) {
+    out->size = 0;
+    out->min_size = 0;
+    out->used = 0;
+    out->locked = 0;
+    if (!CRYPTO_secure_malloc_initialized())
+        return;
+    out->size = init_size;
+    out->min_size = init_min_size;
+    out->used = CRYPTO_secure_used();
+    out->locked = init_result == 1;
+}
+
+#ifdef SPARETOOLS_SECHEAP_AUTOINIT
+# ifndef SPARETOOLS_SECHEAP_DEFAULT
+#  define SPARETOOLS_SECHEAP_DEFAULT NULL
+# endif
+/* secure_heap=SIZE[:MINSIZE] packages: set the arena up before main */
+# if defined(__GNUC__) || defined(__clang__)
+__attribute__((constructor))
+static void secheap_autoinit(void) {
+    sparetools_secheap_init_from_env(SPARETOOLS_SECHEAP_DEFAULT);
+}
+# endif
+#endif
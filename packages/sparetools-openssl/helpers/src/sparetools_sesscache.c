@@ -0,0 +1,497 @@
+#include "sparetools_sesscache.h"
+
+#include <openssl/core_names.h>
+#include <openssl/crypto.h>
+#include <openssl/evp.h>
+#include <openssl/params.h>
+#include <openssl/rand.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define DEFAULT_SHARDS 64
+
+/* ---- Sharded session cache ---- */
+
+typedef struct cache_entry {
+    unsigned char id[SSL_MAX_SSL_SESSION_ID_LENGTH];
+    unsigned int id_len;
+    uint64_t hash;
+    SSL_SESSION *sess;              /* One reference owned by the cache */
+    struct cache_entry *chain;      /* Next in the hash bucket */
+    struct cache_entry *lru_prev;   /* Towards most recently used */
+    struct cache_entry *lru_next;   /* Towards least recently used */
+} cache_entry;
+
+typedef struct {
+    CRYPTO_RWLOCK *lock;
+    cache_entry **buckets;
+    size_t bucket_mask;
+    cache_entry *lru_head;
+    cache_entry *lru_tail;
+    size_t count;
+    size_t capacity;
+    uint64_t hits, misses, stores, evictions;
+} cache_shard;
+
+struct sparetools_sesscache_st {
+    cache_shard *shards;
+    size_t shard_mask;
+    unsigned int shard_bits;
+};
+
+static CRYPTO_ONCE ex_index_once = CRYPTO_ONCE_STATIC_INIT;
+static int sesscache_ex_index = -1;
+static int ticketkeys_ex_index = -1;
+
+static void init_ex_indexes(void) {
+    sesscache_ex_index = SSL_CTX_get_ex_new_index(0, "sparetools_sesscache", NULL, NULL, NULL);
+    ticketkeys_ex_index = SSL_CTX_get_ex_new_index(0, "sparetools_ticketkeys", NULL, NULL, NULL);
+}
+
+static int ex_indexes_ready(void) {
+    return CRYPTO_THREAD_run_once(&ex_index_once, init_ex_indexes)
+        && sesscache_ex_index >= 0 && ticketkeys_ex_index >= 0;
+}
+
+static size_t round_pow2(size_t n) {
+    size_t p = 1;
+
+    while (p < n)
+        p <<= 1;
+    return p;
+}
+
+/* FNV-1a: session IDs are random, this only has to spread short ones */
+static uint64_t hash_id(const unsigned char *id, unsigned int len) {
+    uint64_t h = 14695981039346656037ULL;
+
+    for (unsigned int i = 0; i < len; i++) {
+        h ^= id[i];
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+static cache_shard *shard_for(SPARETOOLS_SESSCACHE *cache, uint64_t hash) {
+    return &cache->shards[hash & cache->shard_mask];
+}
+
+static cache_entry **bucket_for(SPARETOOLS_SESSCACHE *cache, cache_shard *shard, uint64_t hash) {
+    return &shard->buckets[(hash >> cache->shard_bits) & shard->bucket_mask];
+}
+
+static void lru_unlink(cache_shard *shard, cache_entry *e) {
+    if (e->lru_prev != NULL)
+        e->lru_prev->lru_next = e->lru_next;
+    else
+        shard->lru_head = e->lru_next;
+    if (e->lru_next != NULL)
+        e->lru_next->lru_prev = e->lru_prev;
+    else
+        shard->lru_tail = e->lru_prev;
+    e->lru_prev = e->lru_next = NULL;
+}
+
+static void lru_push(cache_shard *shard, cache_entry *e) {
+    e->lru_prev = NULL;
+    e->lru_next = shard->lru_head;
+    if (shard->lru_head != NULL)
+        shard->lru_head->lru_prev = e;
+    shard->lru_head = e;
+    if (shard->lru_tail == NULL)
+        shard->lru_tail = e;
+}
+
+/* Caller holds the shard lock */
+static cache_entry *find_locked(SPARETOOLS_SESSCACHE *cache, cache_shard *shard, uint64_t hash,
+                                const unsigned char *id, unsigned int len) {
+    for (cache_entry *e = *bucket_for(cache, shard, hash); e != NULL; e = e->chain) {
+        if (e->hash == hash && e->id_len == len && memcmp(e->id, id, len) == 0)
+            return e;
+    }
+    return NULL;
+}
+
+/* Unlink and free e; caller holds the shard lock */
+static void drop_locked(SPARETOOLS_SESSCACHE *cache, cache_shard *shard, cache_entry *e) {
+    cache_entry **link = bucket_for(cache, shard, e->hash);
+
+    while (*link != e)
+        link = &(*link)->chain;
+    *link = e->chain;
+    lru_unlink(shard, e);
+    shard->count--;
+    SSL_SESSION_free(e->sess);
+    free(e);
+}
+
+static int session_expired(const SSL_SESSION *sess) {
+#if OPENSSL_VERSION_NUMBER >= 0x30400000L
+    /* time_t-wide, where SSL_SESSION_get_time's long overflows in 2038 on LP32/LLP64 */
+    return SSL_SESSION_get_time_ex(sess) + (time_t)SSL_SESSION_get_timeout(sess) < time(NULL);
+#else
+    return (time_t)(SSL_SESSION_get_time(sess) + SSL_SESSION_get_timeout(sess)) < time(NULL);
+#endif
+}
+
+static SPARETOOLS_SESSCACHE *cache_of(SSL_CTX *ctx) {
+    return ctx != NULL ? SSL_CTX_get_ex_data(ctx, sesscache_ex_index) : NULL;
+}
+
+static int new_session_cb(SSL *ssl, SSL_SESSION *sess) {
+    SPARETOOLS_SESSCACHE *cache = cache_of(SSL_get_SSL_CTX(ssl));
+    const unsigned char *id;
+    unsigned int len;
+    cache_entry *e, *old;
+    cache_shard *shard;
+    uint64_t hash;
+
+    if (cache == NULL)
+        return 0;
+    id = SSL_SESSION_get_id(sess, &len);
+    if (len == 0 || len > SSL_MAX_SSL_SESSION_ID_LENGTH || (e = calloc(1, sizeof(*e))) == NULL)
+        return 0;
+    memcpy(e->id, id, len);
+    e->id_len = len;
+    e->hash = hash = hash_id(id, len);
+    e->sess = sess;
+
+    shard = shard_for(cache, hash);
+    if (!CRYPTO_THREAD_write_lock(shard->lock)) {
+        free(e);
+        return 0;
+    }
+    if ((old = find_locked(cache, shard, hash, id, len)) != NULL)
+        drop_locked(cache, shard, old);
+    while (shard->count >= shard->capacity && shard->lru_tail != NULL) {
+        drop_locked(cache, shard, shard->lru_tail);
+        shard->evictions++;
+    }
+    e->chain = *bucket_for(cache, shard, hash);
+    *bucket_for(cache, shard, hash) = e;
+    lru_push(shard, e);
+    shard->count++;
+    shard->stores++;
+    CRYPTO_THREAD_unlock(shard->lock);
+
+    /* 1: the cache keeps the reference OpenSSL handed over */
+    return 1;
+}
+
+static SSL_SESSION *get_session_cb(SSL *ssl, const unsigned char *id, int len, int *copy) {
+    SPARETOOLS_SESSCACHE *cache = cache_of(SSL_get_SSL_CTX(ssl));
+    SSL_SESSION *sess = NULL;
+    cache_shard *shard;
+    cache_entry *e;
+    uint64_t hash;
+
+    *copy = 0;
+    if (cache == NULL || len <= 0 || len > SSL_MAX_SSL_SESSION_ID_LENGTH)
+        return NULL;
+    hash = hash_id(id, (unsigned int)len);
+    shard = shard_for(cache, hash);
+    if (!CRYPTO_THREAD_write_lock(shard->lock))
+        return NULL;
+    e = find_locked(cache, shard, hash, id, (unsigned int)len);
+    if (e != NULL && session_expired(e->sess)) {
+        drop_locked(cache, shard, e);
+        e = NULL;
+    }
+    if (e != NULL) {
+        /*
+         * Take the caller's reference under the lock (*copy = 0): with
+         * *copy = 1 another thread could evict and free the session
+         * before libssl gets to SSL_SESSION_up_ref().
+         */
+        SSL_SESSION_up_ref(e->sess);
+        sess = e->sess;
+        lru_unlink(shard, e);
+        lru_push(shard, e);
+        shard->hits++;
+    } else {
+        shard->misses++;
+    }
+    CRYPTO_THREAD_unlock(shard->lock);
+    return sess;
+}
+
+static void remove_session_cb(SSL_CTX *ctx, SSL_SESSION *sess) {
+    SPARETOOLS_SESSCACHE *cache = cache_of(ctx);
+    const unsigned char *id;
+    unsigned int len;
+    cache_shard *shard;
+    cache_entry *e;
+    uint64_t hash;
+
+    if (cache == NULL)
+        return;
+    id = SSL_SESSION_get_id(sess, &len);
+    if (len == 0 || len > SSL_MAX_SSL_SESSION_ID_LENGTH)
+        return;
+    hash = hash_id(id, len);
+    shard = shard_for(cache, hash);
+    if (!CRYPTO_THREAD_write_lock(shard->lock))
+        return;
+    if ((e = find_locked(cache, shard, hash, id, len)) != NULL)
+        drop_locked(cache, shard, e);
+    CRYPTO_THREAD_unlock(shard->lock);
+}
+
+SPARETOOLS_SESSCACHE *sparetools_sesscache_new(size_t num_shards, size_t capacity) {
+    SPARETOOLS_SESSCACHE *cache = calloc(1, sizeof(*cache));
+    size_t per_shard;
+
+    if (cache == NULL)
+        return NULL;
+    num_shards = round_pow2(num_shards == 0 ? DEFAULT_SHARDS : num_shards);
+    if (capacity == 0)
+        capacity = SSL_SESSION_CACHE_MAX_SIZE_DEFAULT;
+    per_shard = (capacity + num_shards - 1) / num_shards;
+
+    cache->shard_mask = num_shards - 1;
+    while (((size_t)1 << cache->shard_bits) < num_shards)
+        cache->shard_bits++;
+    if ((cache->shards = calloc(num_shards, sizeof(*cache->shards))) == NULL) {
+        free(cache);
+        return NULL;
+    }
+    for (size_t i = 0; i < num_shards; i++) {
+        cache_shard *shard = &cache->shards[i];
+        size_t nbuckets = round_pow2(per_shard);
+
+        shard->capacity = per_shard;
+        shard->bucket_mask = nbuckets - 1;
+        shard->lock = CRYPTO_THREAD_lock_new();
+        shard->buckets = calloc(nbuckets, sizeof(*shard->buckets));
+        if (shard->lock == NULL || shard->buckets == NULL) {
+            sparetools_sesscache_free(cache);
+            return NULL;
+        }
+    }
+    return cache;
+}
+
+void sparetools_sesscache_free(SPARETOOLS_SESSCACHE *cache) {
+    if (cache == NULL)
+        return;
+
+    for (size_t i = 0; cache->shards != NULL && i <= cache->shard_mask; i++) {
+        cache_shard *shard = &cache->shards[i];
+        cache_entry *e = shard->lru_head;
+
+        while (e != NULL) {
+            cache_entry *next = e->lru_next;
+
+            SSL_SESSION_free(e->sess);
+            free(e);
+            e = next;
+        }
+        free(shard->buckets);
+        CRYPTO_THREAD_lock_free(shard->lock);
+    }
+    free(cache->shards);
+    free(cache);
+}
+
+int sparetools_sesscache_attach(SPARETOOLS_SESSCACHE *cache, SSL_CTX *ctx) {
+    if (cache == NULL || ctx == NULL || !ex_indexes_ready()
+        || !SSL_CTX_set_ex_data(ctx, sesscache_ex_index, cache))
+        return 0;
+
+    SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_SERVER | SSL_SESS_CACHE_NO_INTERNAL);
+    SSL_CTX_sess_set_new_cb(ctx, new_session_cb);
+    SSL_CTX_sess_set_get_cb(ctx, get_session_cb);
+    SSL_CTX_sess_set_remove_cb(ctx, remove_session_cb);
+    return 1;
+}
+
+void sparetools_sesscache_stats(SPARETOOLS_SESSCACHE *cache, SPARETOOLS_SESSCACHE_STATS *stats) {
+    memset(stats, 0, sizeof(*stats));
+    if (cache == NULL)
+        return;
+
+    for (size_t i = 0; i <= cache->shard_mask; i++) {
+        cache_shard *shard = &cache->shards[i];
+
+        if (!CRYPTO_THREAD_read_lock(shard->lock))
+            continue;
+        stats->hits += shard->hits;
+        stats->misses += shard->misses;
+        stats->stores += shard->stores;
+        stats->evictions += shard->evictions;
+        stats->entries += shard->count;
+        CRYPTO_THREAD_unlock(shard->lock);
+    }
+}
+
+/* ---- Rotating ticket keys ---- */
+
+#define TICKET_KEY_NAME_LEN 16
+
+typedef struct {
+    unsigned char name[TICKET_KEY_NAME_LEN];
+    unsigned char aes_key[32];
+    unsigned char hmac_key[32];
+} ticket_key;
+
+struct sparetools_ticketkeys_st {
+    CRYPTO_RWLOCK *lock;
+    EVP_CIPHER *cipher;         /* AES-256-CBC, fetched once */
+    ticket_key current;
+    ticket_key previous;
+    int have_previous;
+    atomic_llong current_since;     /* Written under the write lock, read without it */
+    long rotate_seconds;
+    uint64_t rotations;
+};
+
+static int generate_key(ticket_key *key) {
+    return RAND_bytes(key->name, sizeof(key->name)) > 0
+        && RAND_priv_bytes(key->aes_key, sizeof(key->aes_key)) > 0
+        && RAND_priv_bytes(key->hmac_key, sizeof(key->hmac_key)) > 0;
+}
+
+/* Caller holds the write lock */
+static int rotate_locked(SPARETOOLS_TICKETKEYS *keys) {
+    ticket_key fresh;
+
+    if (!generate_key(&fresh))
+        return 0;
+    keys->previous = keys->current;
+    keys->have_previous = 1;
+    keys->current = fresh;
+    atomic_store_explicit(&keys->current_since, time(NULL), memory_order_relaxed);
+    keys->rotations++;
+    OPENSSL_cleanse(&fresh, sizeof(fresh));
+    return 1;
+}
+
+/* Lock-free check on every ticket; rotation itself re-checks under the write lock */
+static int rotation_due(SPARETOOLS_TICKETKEYS *keys, time_t now) {
+    return keys->rotate_seconds > 0
+        && now - (time_t)atomic_load_explicit(&keys->current_since, memory_order_relaxed)
+               >= keys->rotate_seconds;
+}
+
+static int set_hmac_key(EVP_MAC_CTX *hctx, const ticket_key *key) {
+    OSSL_PARAM params[3];
+
+    params[0] = OSSL_PARAM_construct_octet_string(OSSL_MAC_PARAM_KEY, (void *)key->hmac_key,
+                                                  sizeof(key->hmac_key));
+    params[1] = OSSL_PARAM_construct_utf8_string(OSSL_MAC_PARAM_DIGEST, "SHA256", 0);
+    params[2] = OSSL_PARAM_construct_end();
+    return EVP_MAC_CTX_set_params(hctx, params);
+}
+
+/**
+ * SSL_CTX_set_tlsext_ticket_key_evp_cb callback. Encrypt: 1 with the
+ * current key. Decrypt: 1 for the current key, 2 (valid, re-issue) for
+ * the previous one, 0 (full handshake) for anything older.
+ */
+static int ticket_key_cb(SSL *ssl, unsigned char key_name[16], unsigned char iv[EVP_MAX_IV_LENGTH],
+                         EVP_CIPHER_CTX *cctx, EVP_MAC_CTX *hctx, int enc) {
+    SSL_CTX *ctx = SSL_get_SSL_CTX(ssl);
+    SPARETOOLS_TICKETKEYS *keys = ctx != NULL ? SSL_CTX_get_ex_data(ctx, ticketkeys_ex_index) : NULL;
+    ticket_key key;
+    int ret;
+
+    if (keys == NULL)
+        return enc ? -1 : 0;
+
+    if (enc && rotation_due(keys, time(NULL))) {
+        if (!CRYPTO_THREAD_write_lock(keys->lock))
+            return -1;
+        /* Another thread may have rotated while we waited */
+        if (rotation_due(keys, time(NULL)))
+            rotate_locked(keys);
+        CRYPTO_THREAD_unlock(keys->lock);
+    }
+    if (!CRYPTO_THREAD_read_lock(keys->lock))
+        return enc ? -1 : 0;
+    if (enc) {
+        key = keys->current;
+        ret = 1;
+    } else if (memcmp(key_name, keys->current.name, TICKET_KEY_NAME_LEN) == 0) {
+        key = keys->current;
+        ret = 1;
+    } else if (keys->have_previous
+               && memcmp(key_name, keys->previous.name, TICKET_KEY_NAME_LEN) == 0) {
+        key = keys->previous;
+        ret = 2;
+    } else {
+        ret = 0;
+    }
+    CRYPTO_THREAD_unlock(keys->lock);
+    if (ret == 0)
+        return 0;
+
+    if (enc) {
+        memcpy(key_name, key.name, TICKET_KEY_NAME_LEN);
+        if (RAND_bytes(iv, EVP_CIPHER_get_iv_length(keys->cipher)) <= 0
+            || !EVP_EncryptInit_ex2(cctx, keys->cipher, key.aes_key, iv, NULL))
+            ret = -1;
+    } else if (!EVP_DecryptInit_ex2(cctx, keys->cipher, key.aes_key, iv, NULL)) {
+        ret = 0;
+    }
+    if (ret > 0 && !set_hmac_key(hctx, &key))
+        ret = enc ? -1 : 0;
+    OPENSSL_cleanse(&key, sizeof(key));
+    return ret;
+}
+
+SPARETOOLS_TICKETKEYS *sparetools_ticketkeys_new(long rotate_seconds) {
+    SPARETOOLS_TICKETKEYS *keys = calloc(1, sizeof(*keys));
+
+    if (keys == NULL)
+        return NULL;
+    keys->rotate_seconds = rotate_seconds;
+    atomic_init(&keys->current_since, time(NULL));
+    keys->lock = CRYPTO_THREAD_lock_new();
+    keys->cipher = EVP_CIPHER_fetch(NULL, "AES-256-CBC", NULL);
+    if (keys->lock == NULL || keys->cipher == NULL || !generate_key(&keys->current)) {
+        sparetools_ticketkeys_free(keys);
+        return NULL;
+    }
+    return keys;
+}
+
+void sparetools_ticketkeys_free(SPARETOOLS_TICKETKEYS *keys) {
+    if (keys == NULL)
+        return;
+
+    EVP_CIPHER_free(keys->cipher);
+    CRYPTO_THREAD_lock_free(keys->lock);
+    OPENSSL_cleanse(keys, sizeof(*keys));
+    free(keys);
+}
+
+int sparetools_ticketkeys_attach(SPARETOOLS_TICKETKEYS *keys, SSL_CTX *ctx) {
+    if (keys == NULL || ctx == NULL || !ex_indexes_ready()
+        || !SSL_CTX_set_ex_data(ctx, ticketkeys_ex_index, keys))
+        return 0;
+
+    SSL_CTX_clear_options(ctx, SSL_OP_NO_TICKET);
+    return SSL_CTX_set_tlsext_ticket_key_evp_cb(ctx, ticket_key_cb) == 1;
+}
+
+int sparetools_ticketkeys_rotate(SPARETOOLS_TICKETKEYS *keys) {
+    int ok;
+
+    if (keys == NULL || !CRYPTO_THREAD_write_lock(keys->lock))
+        return 0;
+    ok = rotate_locked(keys);
+    CRYPTO_THREAD_unlock(keys->lock);
+    return ok;
+}
+
+uint64_t sparetools_ticketkeys_rotations(SPARETOOLS_TICKETKEYS *keys) {
+    uint64_t n = 0;
+
+    if (keys != NULL && CRYPTO_THREAD_read_lock(keys->lock)) {
+        n = keys->rotations;
+        CRYPTO_THREAD_unlock(keys->lock);
+    }
+    return n;
+}
@@ -0,0 +1,191 @@
+#include "sparetools_signctx.h"
+
+#include <openssl/core_names.h>
+#include <openssl/err.h>
+#include <openssl/params.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* One per thread and SPARETOOLS_SIGNCTX, both created on first use */
+typedef struct thread_state_st {
+    EVP_MD_CTX *md;       /* Initialised with the key once, then re-initialised without it */
+    EVP_PKEY_CTX *pkey;   /* Initialised for EVP_PKEY_sign */
+    SPARETOOLS_SIGNCTX *owner;
+    struct thread_state_st *prev, *next;
+} thread_state;
+
+struct sparetools_signctx_st {
+    EVP_PKEY *key;
+    OSSL_LIB_CTX *libctx;
+    char *mdname;
+    char *propq;
+    OSSL_PARAM *params;
+    pthread_key_t tls;
+    pthread_mutex_t lock; /* Guards the list */
+    thread_state *head;
+};
+
+static void free_state(thread_state *st) {
+    EVP_MD_CTX_free(st->md);
+    EVP_PKEY_CTX_free(st->pkey);
+    free(st);
+}
+
+/* Thread exit */
+static void release_state(void *p) {
+    thread_state *st = p;
+    SPARETOOLS_SIGNCTX *ctx = st->owner;
+
+    pthread_mutex_lock(&ctx->lock);
+    if (st->prev != NULL)
+        st->prev->next = st->next;
+    else
+        ctx->head = st->next;
+    if (st->next != NULL)
+        st->next->prev = st->prev;
+    pthread_mutex_unlock(&ctx->lock);
+    free_state(st);
+}
+
+static thread_state *get_state(SPARETOOLS_SIGNCTX *ctx) {
+    thread_state *st = pthread_getspecific(ctx->tls);
+
+    if (st != NULL)
+        return st;
+    if ((st = calloc(1, sizeof(*st))) == NULL)
+        return NULL;
+    if (pthread_setspecific(ctx->tls, st) != 0) {
+        free(st);
+        return NULL;
+    }
+    st->owner = ctx;
+    pthread_mutex_lock(&ctx->lock);
+    st->next = ctx->head;
+    if (ctx->head != NULL)
+        ctx->head->prev = st;
+    ctx->head = st;
+    pthread_mutex_unlock(&ctx->lock);
+    return st;
+}
+
+static char *dup_or_null(const char *s, int *ok) {
+    char *copy = s != NULL ? strdup(s) : NULL;
+
+    if (s != NULL && copy == NULL)
+        *ok = 0;
+    return copy;
+}
+
+static int init_md(const SPARETOOLS_SIGNCTX *ctx, EVP_MD_CTX *md) {
+    return EVP_DigestSignInit_ex(md, NULL, ctx->mdname, ctx->libctx, ctx->propq, ctx->key, ctx->params) == 1;
+}
+
+SPARETOOLS_SIGNCTX *sparetools_signctx_new(EVP_PKEY *key, const char *mdname, OSSL_LIB_CTX *libctx,
+                                           const char *propq, const OSSL_PARAM params[]) {
+    SPARETOOLS_SIGNCTX *ctx = calloc(1, sizeof(*ctx));
+    EVP_MD_CTX *probe = NULL;
+    int ok = 1;
+
+    if (ctx == NULL || key == NULL || !EVP_PKEY_up_ref(key)) {
+        free(ctx);
+        return NULL;
+    }
+    ctx->key = key;
+    ctx->libctx = libctx;
+    ctx->mdname = dup_or_null(mdname, &ok);
+    ctx->propq = dup_or_null(propq, &ok);
+    if (params != NULL && (ctx->params = OSSL_PARAM_dup(params)) == NULL)
+        ok = 0;
+    /* Fail here rather than on the first signature if the key cannot sign this way */
+    if (ok && ((probe = EVP_MD_CTX_new()) == NULL || !init_md(ctx, probe)))
+        ok = 0;
+    EVP_MD_CTX_free(probe);
+    if (!ok || pthread_key_create(&ctx->tls, release_state) != 0) {
+        OSSL_PARAM_free(ctx->params);
+        free(ctx->propq);
+        free(ctx->mdname);
+        EVP_PKEY_free(key);
+        free(ctx);
+        return NULL;
+    }
+    pthread_mutex_init(&ctx->lock, NULL);
+    return ctx;
+}
+
+void sparetools_signctx_free(SPARETOOLS_SIGNCTX *ctx) {
+    thread_state *st, *next;
+
+    if (ctx == NULL)
+        return;
+    /* No thread-exit destructor runs after this */
+    pthread_key_delete(ctx->tls);
+    for (st = ctx->head; st != NULL; st = next) {
+        next = st->next;
+        free_state(st);
+    }
+    pthread_mutex_destroy(&ctx->lock);
+    OSSL_PARAM_free(ctx->params);
+    free(ctx->propq);
+    free(ctx->mdname);
+    EVP_PKEY_free(ctx->key);
+    free(ctx);
+}
+
+size_t sparetools_signctx_max_size(const SPARETOOLS_SIGNCTX *ctx) {
+    int size = EVP_PKEY_get_size(ctx->key);
+
+    return size > 0 ? (size_t)size : 0;
+}
+
+int sparetools_signctx_sign(SPARETOOLS_SIGNCTX *ctx, const unsigned char *tbs, size_t tbs_len,
+                            unsigned char *sig, size_t *sig_len) {
+    thread_state *st = get_state(ctx);
+    int ok;
+
+    if (st == NULL)
+        return 0;
+    if (st->md == NULL) {
+        if ((st->md = EVP_MD_CTX_new()) == NULL)
+            return 0;
+        ok = init_md(ctx, st->md);
+    } else {
+        /*
+         * Without a key EVP_DigestSignInit_ex keeps the context's
+         * EVP_PKEY_CTX and signature implementation and only restarts the
+         * provider's digest-sign state: nothing is fetched or exported.
+         * A provider that refuses gets the full initialisation instead.
+         */
+        ERR_set_mark();
+        ok = EVP_DigestSignInit_ex(st->md, NULL, NULL, ctx->libctx, ctx->propq, NULL, ctx->params) == 1;
+        ERR_pop_to_mark();
+        if (!ok)
+            ok = EVP_MD_CTX_reset(st->md) && init_md(ctx, st->md);
+    }
+    return ok && EVP_DigestSign(st->md, sig, sig_len, tbs, tbs_len) == 1;
+}
+
+static EVP_PKEY_CTX *new_pkey_ctx(const SPARETOOLS_SIGNCTX *ctx) {
+    EVP_PKEY_CTX *pctx = EVP_PKEY_CTX_new_from_pkey(ctx->libctx, ctx->key, ctx->propq);
+    OSSL_PARAM md[2];
+
+    md[0] = OSSL_PARAM_construct_utf8_string(OSSL_SIGNATURE_PARAM_DIGEST, ctx->mdname, 0);
+    md[1] = OSSL_PARAM_construct_end();
+    if (pctx == NULL || EVP_PKEY_sign_init(pctx) != 1
+        || (ctx->mdname != NULL && EVP_PKEY_CTX_set_params(pctx, md) != 1)
+        || (ctx->params != NULL && EVP_PKEY_CTX_set_params(pctx, ctx->params) != 1)) {
+        EVP_PKEY_CTX_free(pctx);
+        return NULL;
+    }
+    return pctx;
+}
+
+int sparetools_signctx_sign_digest(SPARETOOLS_SIGNCTX *ctx, const unsigned char *dgst, size_t dgst_len,
+                                   unsigned char *sig, size_t *sig_len) {
+    thread_state *st = get_state(ctx);
+
+    if (st == NULL || (st->pkey == NULL && (st->pkey = new_pkey_ctx(ctx)) == NULL))
+        return 0;
+    /* EVP_PKEY_sign leaves the context initialised for the next call */
+    return EVP_PKEY_sign(st->pkey, sig, sig_len, dgst, dgst_len) == 1;
+}
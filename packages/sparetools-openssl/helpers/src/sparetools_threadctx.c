@@ -0,0 +1,225 @@
+#include "sparetools_threadctx.h"
+
+#include <openssl/evp.h>
+#include <openssl/provider.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+struct sparetools_threadctx_st {
+    OSSL_LIB_CTX *libctx;
+    OSSL_PROVIDER **providers;
+    int num_providers;
+    SPARETOOLS_ALGCACHE *algcache;
+    /* Pool membership, NULL for standalone contexts */
+    SPARETOOLS_THREADCTX_POOL *pool;
+    struct sparetools_threadctx_st *prev, *next;
+};
+
+struct sparetools_threadctx_pool_st {
+    SPARETOOLS_THREADCTX_CONFIG cfg;   /* Deep copy */
+    void **owned;                      /* Everything cfg points to, freed with the pool */
+    size_t num_owned;
+    pthread_key_t key;
+    pthread_mutex_t lock;              /* Guards the list and stats */
+    SPARETOOLS_THREADCTX *head;
+    SPARETOOLS_THREADCTX_STATS stats;
+};
+
+static const char *const default_providers[] = {"default", NULL};
+
+static double now_seconds(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+SPARETOOLS_THREADCTX *sparetools_threadctx_new(const SPARETOOLS_THREADCTX_CONFIG *cfg) {
+    static const SPARETOOLS_THREADCTX_CONFIG defaults;
+    SPARETOOLS_THREADCTX *ctx = calloc(1, sizeof(*ctx));
+    const char *const *names;
+    int n = 0;
+
+    if (cfg == NULL)
+        cfg = &defaults;
+    /* A config file activates its own providers */
+    names = cfg->providers != NULL ? cfg->providers : cfg->config_file != NULL ? NULL : default_providers;
+    while (names != NULL && names[n] != NULL)
+        n++;
+    if (ctx == NULL || (ctx->libctx = OSSL_LIB_CTX_new()) == NULL
+        || (ctx->providers = calloc(n > 0 ? (size_t)n : 1, sizeof(*ctx->providers))) == NULL)
+        goto err;
+    if (cfg->config_file != NULL && !OSSL_LIB_CTX_load_config(ctx->libctx, cfg->config_file))
+        goto err;
+    for (int i = 0; i < n; i++) {
+        if ((ctx->providers[i] = OSSL_PROVIDER_load(ctx->libctx, names[i])) == NULL)
+            goto err;
+        ctx->num_providers++;
+    }
+    if (cfg->propq != NULL && !EVP_set_default_properties(ctx->libctx, cfg->propq))
+        goto err;
+    /* Fills the context's method store too, so later fetches by name hit its cache */
+    if ((ctx->algcache = sparetools_algcache_new(ctx->libctx, NULL, cfg->md_names, cfg->cipher_names)) == NULL)
+        goto err;
+    return ctx;
+err:
+    sparetools_threadctx_free(ctx);
+    return NULL;
+}
+
+void sparetools_threadctx_free(SPARETOOLS_THREADCTX *ctx) {
+    if (ctx == NULL)
+        return;
+    sparetools_algcache_free(ctx->algcache);
+    for (int i = ctx->num_providers - 1; i >= 0; i--)
+        OSSL_PROVIDER_unload(ctx->providers[i]);
+    free(ctx->providers);
+    OSSL_LIB_CTX_free(ctx->libctx);
+    free(ctx);
+}
+
+OSSL_LIB_CTX *sparetools_threadctx_libctx(const SPARETOOLS_THREADCTX *ctx) {
+    return ctx->libctx;
+}
+
+const SPARETOOLS_ALGCACHE *sparetools_threadctx_algcache(const SPARETOOLS_THREADCTX *ctx) {
+    return ctx->algcache;
+}
+
+static void unlink_ctx(SPARETOOLS_THREADCTX *ctx) {
+    SPARETOOLS_THREADCTX_POOL *pool = ctx->pool;
+
+    if (ctx->prev != NULL)
+        ctx->prev->next = ctx->next;
+    else
+        pool->head = ctx->next;
+    if (ctx->next != NULL)
+        ctx->next->prev = ctx->prev;
+    pool->stats.contexts--;
+}
+
+/* Thread exit */
+static void release_thread_ctx(void *p) {
+    SPARETOOLS_THREADCTX *ctx = p;
+    SPARETOOLS_THREADCTX_POOL *pool = ctx->pool;
+
+    pthread_mutex_lock(&pool->lock);
+    unlink_ctx(ctx);
+    pthread_mutex_unlock(&pool->lock);
+    sparetools_threadctx_free(ctx);
+}
+
+/* Hand p to the pool, which frees it with itself; returns p (NULL when out of memory) */
+static void *keep(SPARETOOLS_THREADCTX_POOL *pool, void *p) {
+    void **grown;
+
+    if (p == NULL || (grown = realloc(pool->owned, (pool->num_owned + 1) * sizeof(*grown))) == NULL) {
+        free(p);
+        return NULL;
+    }
+    pool->owned = grown;
+    pool->owned[pool->num_owned++] = p;
+    return p;
+}
+
+/* Copy a NULL-terminated list; *out stays NULL for NULL */
+static int copy_names(SPARETOOLS_THREADCTX_POOL *pool, const char *const *names, const char *const **out) {
+    const char **copy;
+    size_t n = 0;
+
+    *out = NULL;
+    if (names == NULL)
+        return 1;
+    while (names[n] != NULL)
+        n++;
+    if ((copy = keep(pool, calloc(n + 1, sizeof(*copy)))) == NULL)
+        return 0;
+    for (size_t i = 0; i < n; i++) {
+        if ((copy[i] = keep(pool, strdup(names[i]))) == NULL)
+            return 0;
+    }
+    *out = copy;
+    return 1;
+}
+
+static int copy_string(SPARETOOLS_THREADCTX_POOL *pool, const char *s, const char **out) {
+    *out = NULL;
+    return s == NULL || (*out = keep(pool, strdup(s))) != NULL;
+}
+
+static void free_owned(SPARETOOLS_THREADCTX_POOL *pool) {
+    for (size_t i = 0; i < pool->num_owned; i++)
+        free(pool->owned[i]);
+    free(pool->owned);
+}
+
+SPARETOOLS_THREADCTX_POOL *sparetools_threadctx_pool_new(const SPARETOOLS_THREADCTX_CONFIG *cfg) {
+    SPARETOOLS_THREADCTX_POOL *pool = calloc(1, sizeof(*pool));
+    int ok;
+
+    if (pool == NULL)
+        return NULL;
+    ok = cfg == NULL
+        || (copy_string(pool, cfg->config_file, &pool->cfg.config_file)
+            && copy_string(pool, cfg->propq, &pool->cfg.propq)
+            && copy_names(pool, cfg->providers, &pool->cfg.providers)
+            && copy_names(pool, cfg->md_names, &pool->cfg.md_names)
+            && copy_names(pool, cfg->cipher_names, &pool->cfg.cipher_names));
+    if (!ok || pthread_key_create(&pool->key, release_thread_ctx) != 0) {
+        free_owned(pool);
+        free(pool);
+        return NULL;
+    }
+    pthread_mutex_init(&pool->lock, NULL);
+    return pool;
+}
+
+void sparetools_threadctx_pool_free(SPARETOOLS_THREADCTX_POOL *pool) {
+    SPARETOOLS_THREADCTX *ctx, *next;
+
+    if (pool == NULL)
+        return;
+    /* No thread-exit destructor runs after this */
+    pthread_key_delete(pool->key);
+    for (ctx = pool->head; ctx != NULL; ctx = next) {
+        next = ctx->next;
+        sparetools_threadctx_free(ctx);
+    }
+    pthread_mutex_destroy(&pool->lock);
+    free_owned(pool);
+    free(pool);
+}
+
+const SPARETOOLS_THREADCTX *sparetools_threadctx_get(SPARETOOLS_THREADCTX_POOL *pool) {
+    SPARETOOLS_THREADCTX *ctx = pthread_getspecific(pool->key);
+    double start;
+
+    if (ctx != NULL)
+        return ctx;
+    start = now_seconds();
+    if ((ctx = sparetools_threadctx_new(&pool->cfg)) == NULL)
+        return NULL;
+    if (pthread_setspecific(pool->key, ctx) != 0) {
+        sparetools_threadctx_free(ctx);
+        return NULL;
+    }
+    ctx->pool = pool;
+    pthread_mutex_lock(&pool->lock);
+    ctx->next = pool->head;
+    if (pool->head != NULL)
+        pool->head->prev = ctx;
+    pool->head = ctx;
+    pool->stats.contexts++;
+    pool->stats.created++;
+    pool->stats.setup_seconds += now_seconds() - start;
+    pthread_mutex_unlock(&pool->lock);
+    return ctx;
+}
+
+void sparetools_threadctx_pool_stats(SPARETOOLS_THREADCTX_POOL *pool, SPARETOOLS_THREADCTX_STATS *out) {
+    pthread_mutex_lock(&pool->lock);
+    *out = pool->stats;
+    pthread_mutex_unlock(&pool->lock);
+}
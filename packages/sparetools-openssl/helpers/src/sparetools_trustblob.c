@@ -0,0 +1,334 @@
+#include "sparetools_trustblob.h"
+
+#include <openssl/crypto.h>
+#include <openssl/err.h>
+#include <openssl/pem.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#define BLOB_MAGIC "STTRUST"   /* 8 bytes with the terminator */
+#define BLOB_VERSION 1
+#define HEADER_SIZE 32
+#define ENTRY_SIZE 16
+
+struct sparetools_trustblob_st {
+    const unsigned char *map;
+    size_t size;
+    const unsigned char *index;
+    const unsigned char *data;
+    uint32_t count;
+    X509 **certs;         /* Decoded on first lookup, NULL until then */
+    CRYPTO_RWLOCK *lock;  /* Guards certs */
+};
+
+static CRYPTO_ONCE method_once = CRYPTO_ONCE_STATIC_INIT;
+static X509_LOOKUP_METHOD *blob_method;
+
+static uint32_t get_u32(const unsigned char *p) {
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+static void put_u32(unsigned char *p, uint32_t v) {
+    p[0] = (unsigned char)v;
+    p[1] = (unsigned char)(v >> 8);
+    p[2] = (unsigned char)(v >> 16);
+    p[3] = (unsigned char)(v >> 24);
+}
+
+static uint32_t entry_hash(const SPARETOOLS_TRUSTBLOB *blob, uint32_t i) {
+    return get_u32(blob->index + (size_t)i * ENTRY_SIZE);
+}
+
+/* ---- Writing ---- */
+
+typedef struct {
+    uint32_t hash;
+    uint32_t order;
+    unsigned char *der;
+    int der_len;
+} pending_entry;
+
+static int pending_cmp(const void *a, const void *b) {
+    const pending_entry *x = a, *y = b;
+
+    if (x->hash != y->hash)
+        return x->hash < y->hash ? -1 : 1;
+    return x->order < y->order ? -1 : x->order > y->order;
+}
+
+int sparetools_trustblob_write(STACK_OF(X509) *certs, const char *blob_path) {
+    int n = sk_X509_num(certs), ok = 0;
+    pending_entry *entries = n > 0 ? OPENSSL_zalloc(sizeof(*entries) * n) : NULL;
+    unsigned char header[HEADER_SIZE] = {0}, entry[ENTRY_SIZE] = {0};
+    uint32_t data_size = 0;
+    FILE *fp = NULL;
+
+    if (n < 0 || (n > 0 && entries == NULL))
+        return 0;
+    for (int i = 0; i < n; i++) {
+        X509 *cert = sk_X509_value(certs, i);
+        int hash_ok = 0;
+
+        entries[i].hash = (uint32_t)X509_NAME_hash_ex(X509_get_subject_name(cert), NULL, NULL, &hash_ok);
+        entries[i].order = (uint32_t)i;
+        if (!hash_ok || (entries[i].der_len = i2d_X509(cert, &entries[i].der)) <= 0
+            || data_size > UINT32_MAX - (uint32_t)entries[i].der_len)
+            goto done;
+        data_size += (uint32_t)entries[i].der_len;
+    }
+    qsort(entries, (size_t)n, sizeof(*entries), pending_cmp);
+
+    memcpy(header, BLOB_MAGIC, sizeof(BLOB_MAGIC));
+    put_u32(header + 8, BLOB_VERSION);
+    put_u32(header + 12, (uint32_t)n);
+    put_u32(header + 16, HEADER_SIZE);
+    put_u32(header + 20, HEADER_SIZE + (uint32_t)n * ENTRY_SIZE);
+    put_u32(header + 24, data_size);
+    if ((fp = fopen(blob_path, "wb")) == NULL || fwrite(header, sizeof(header), 1, fp) != 1)
+        goto done;
+    for (uint32_t i = 0, offset = 0; i < (uint32_t)n; offset += (uint32_t)entries[i++].der_len) {
+        put_u32(entry, entries[i].hash);
+        put_u32(entry + 4, offset);
+        put_u32(entry + 8, (uint32_t)entries[i].der_len);
+        if (fwrite(entry, sizeof(entry), 1, fp) != 1)
+            goto done;
+    }
+    for (int i = 0; i < n; i++)
+        if (fwrite(entries[i].der, (size_t)entries[i].der_len, 1, fp) != 1)
+            goto done;
+    ok = 1;
+
+ done:
+    if (fp != NULL && fclose(fp) != 0)
+        ok = 0;
+    for (int i = 0; i < n; i++)
+        OPENSSL_free(entries[i].der);
+    OPENSSL_free(entries);
+    return ok;
+}
+
+int sparetools_trustblob_compile(const char *pem_path, const char *blob_path) {
+    STACK_OF(X509_INFO) *infos = NULL;
+    STACK_OF(X509) *certs = sk_X509_new_null();
+    BIO *in = BIO_new_file(pem_path, "r");
+    int count = -1;
+
+    if (in == NULL || certs == NULL || (infos = PEM_X509_INFO_read_bio(in, NULL, NULL, NULL)) == NULL)
+        goto done;
+    for (int i = 0; i < sk_X509_INFO_num(infos); i++) {
+        X509 *cert = sk_X509_INFO_value(infos, i)->x509;
+
+        if (cert != NULL && !sk_X509_push(certs, cert))
+            goto done;
+    }
+    if (sparetools_trustblob_write(certs, blob_path))
+        count = sk_X509_num(certs);
+
+ done:
+    /* The infos own the certificates */
+    sk_X509_free(certs);
+    sk_X509_INFO_pop_free(infos, X509_INFO_free);
+    BIO_free(in);
+    return count;
+}
+
+/* ---- Mapping ---- */
+
+static int map_file(const char *path, SPARETOOLS_TRUSTBLOB *blob) {
+#ifdef _WIN32
+    FILE *fp = fopen(path, "rb");
+    unsigned char *buf = NULL;
+    long size;
+    int ok = fp != NULL && fseek(fp, 0, SEEK_END) == 0 && (size = ftell(fp)) > 0
+        && fseek(fp, 0, SEEK_SET) == 0 && (buf = OPENSSL_malloc((size_t)size)) != NULL
+        && fread(buf, (size_t)size, 1, fp) == 1;
+
+    if (fp != NULL)
+        fclose(fp);
+    if (!ok) {
+        OPENSSL_free(buf);
+        return 0;
+    }
+    blob->map = buf;
+    blob->size = (size_t)size;
+    return 1;
+#else
+    struct stat st;
+    void *map;
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+
+    if (fd < 0)
+        return 0;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0
+        || (map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0)) == MAP_FAILED) {
+        close(fd);
+        return 0;
+    }
+    close(fd);
+    blob->map = map;
+    blob->size = (size_t)st.st_size;
+    return 1;
+#endif
+}
+
+static void unmap_file(SPARETOOLS_TRUSTBLOB *blob) {
+    if (blob->map == NULL)
+        return;
+#ifdef _WIN32
+    OPENSSL_free((void *)blob->map);
+#else
+    munmap((void *)blob->map, blob->size);
+#endif
+}
+
+static int validate(SPARETOOLS_TRUSTBLOB *blob) {
+    uint32_t index_offset, data_offset, data_size;
+
+    if (blob->size < HEADER_SIZE || memcmp(blob->map, BLOB_MAGIC, sizeof(BLOB_MAGIC)) != 0
+        || get_u32(blob->map + 8) != BLOB_VERSION)
+        return 0;
+    blob->count = get_u32(blob->map + 12);
+    index_offset = get_u32(blob->map + 16);
+    data_offset = get_u32(blob->map + 20);
+    data_size = get_u32(blob->map + 24);
+    if (index_offset < HEADER_SIZE || blob->count > (blob->size - index_offset) / ENTRY_SIZE
+        || data_offset < index_offset + (size_t)blob->count * ENTRY_SIZE
+        || data_offset > blob->size || data_size > blob->size - data_offset)
+        return 0;
+    blob->index = blob->map + index_offset;
+    blob->data = blob->map + data_offset;
+
+    for (uint32_t i = 0; i < blob->count; i++) {
+        const unsigned char *e = blob->index + (size_t)i * ENTRY_SIZE;
+        uint32_t offset = get_u32(e + 4), len = get_u32(e + 8);
+
+        if (len == 0 || offset > data_size || len > data_size - offset
+            || (i > 0 && entry_hash(blob, i - 1) > get_u32(e)))
+            return 0;
+    }
+    return 1;
+}
+
+SPARETOOLS_TRUSTBLOB *sparetools_trustblob_open(const char *blob_path) {
+    SPARETOOLS_TRUSTBLOB *blob = OPENSSL_zalloc(sizeof(*blob));
+
+    if (blob == NULL)
+        return NULL;
+    if (!map_file(blob_path, blob) || !validate(blob)
+        || (blob->count > 0 && (blob->certs = OPENSSL_zalloc(sizeof(*blob->certs) * blob->count)) == NULL)
+        || (blob->lock = CRYPTO_THREAD_lock_new()) == NULL) {
+        sparetools_trustblob_free(blob);
+        return NULL;
+    }
+    return blob;
+}
+
+void sparetools_trustblob_free(SPARETOOLS_TRUSTBLOB *blob) {
+    if (blob == NULL)
+        return;
+    for (uint32_t i = 0; blob->certs != NULL && i < blob->count; i++)
+        X509_free(blob->certs[i]);
+    OPENSSL_free(blob->certs);
+    CRYPTO_THREAD_lock_free(blob->lock);
+    unmap_file(blob);
+    OPENSSL_free(blob);
+}
+
+int sparetools_trustblob_count(const SPARETOOLS_TRUSTBLOB *blob) {
+    return blob != NULL ? (int)blob->count : 0;
+}
+
+/* ---- X509_LOOKUP ---- */
+
+/* Entry i decoded (once per blob); the blob keeps the reference */
+static X509 *decoded(SPARETOOLS_TRUSTBLOB *blob, uint32_t i) {
+    const unsigned char *e = blob->index + (size_t)i * ENTRY_SIZE, *der;
+    X509 *cert;
+
+    if (!CRYPTO_THREAD_read_lock(blob->lock))
+        return NULL;
+    cert = blob->certs[i];
+    CRYPTO_THREAD_unlock(blob->lock);
+    if (cert != NULL)
+        return cert;
+
+    if (!CRYPTO_THREAD_write_lock(blob->lock))
+        return NULL;
+    if ((cert = blob->certs[i]) == NULL) {
+        der = blob->data + get_u32(e + 4);
+        cert = blob->certs[i] = d2i_X509(NULL, &der, (long)get_u32(e + 8));
+    }
+    CRYPTO_THREAD_unlock(blob->lock);
+    return cert;
+}
+
+/*
+ * Decode every certificate whose subject hashes like name into the
+ * store; ret borrows the first one whose subject is name, like the
+ * hashed-directory lookup returns the store's own object.
+ */
+static int blob_get_by_subject(X509_LOOKUP *lu, X509_LOOKUP_TYPE type, const X509_NAME *name,
+                               X509_OBJECT *ret) {
+    SPARETOOLS_TRUSTBLOB *blob = X509_LOOKUP_get_method_data(lu);
+    X509_STORE *store = X509_LOOKUP_get_store(lu);
+    X509 *found = NULL;
+    uint32_t lo = 0, hi, hash;
+    int hash_ok = 0;
+
+    if (blob == NULL || store == NULL || type != X509_LU_X509)
+        return 0;
+    hash = (uint32_t)X509_NAME_hash_ex(name, NULL, NULL, &hash_ok);
+    if (!hash_ok)
+        return 0;
+    for (hi = blob->count; lo < hi;) {
+        uint32_t mid = lo + (hi - lo) / 2;
+
+        if (entry_hash(blob, mid) < hash)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    for (uint32_t i = lo; i < blob->count && entry_hash(blob, i) == hash; i++) {
+        X509 *cert = decoded(blob, i);
+
+        if (cert == NULL || X509_NAME_cmp(X509_get_subject_name(cert), name) != 0)
+            continue;
+        if (!X509_STORE_add_cert(store, cert))
+            return 0;
+        if (found == NULL)
+            found = cert;
+    }
+    if (found == NULL || !X509_OBJECT_set1_X509(ret, found))
+        return 0;
+    /* Borrowed: X509_STORE_CTX_get_by_subject takes its own reference */
+    X509_free(found);
+    return 1;
+}
+
+static void init_method(void) {
+    X509_LOOKUP_METHOD *method = X509_LOOKUP_meth_new("SpareTools trust blob");
+
+    if (method != NULL && !X509_LOOKUP_meth_set_get_by_subject(method, blob_get_by_subject)) {
+        X509_LOOKUP_meth_free(method);
+        method = NULL;
+    }
+    blob_method = method;
+}
+
+int sparetools_trustblob_attach(SPARETOOLS_TRUSTBLOB *blob, X509_STORE *store) {
+    X509_LOOKUP *lu;
+
+    if (blob == NULL || store == NULL || !CRYPTO_THREAD_run_once(&method_once, init_method)
+        || blob_method == NULL || (lu = X509_STORE_add_lookup(store, blob_method)) == NULL)
+        return 0;
+    return X509_LOOKUP_set_method_data(lu, blob);
+}
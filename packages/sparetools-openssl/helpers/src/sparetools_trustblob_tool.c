@@ -0,0 +1,29 @@
+/*
+ * sparetools_trustblob: compile a PEM CA bundle into a trust blob
+ *
+ * Run by the recipe's package() step to ship ssl/cert.stb next to
+ * ssl/cert.pem (see sparetools_trustblob.h for the format).
+ *
+ * Usage: sparetools_trustblob BUNDLE.pem OUTPUT.stb
+ */
+
+#include <openssl/err.h>
+#include <stdio.h>
+
+#include "sparetools_trustblob.h"
+
+int main(int argc, char **argv) {
+    int count;
+
+    if (argc != 3) {
+        fprintf(stderr, "Usage: %s BUNDLE.pem OUTPUT.stb\n", argv[0]);
+        return 2;
+    }
+    if ((count = sparetools_trustblob_compile(argv[1], argv[2])) < 0) {
+        fprintf(stderr, "sparetools_trustblob: cannot compile %s into %s\n", argv[1], argv[2]);
+        ERR_print_errors_fp(stderr);
+        return 1;
+    }
+    printf("%s: %d certificates\n", argv[2], count);
+    return 0;
+}
@@ -0,0 +1,235 @@
+#include "sparetools_x509store.h"
+
+#include <openssl/crypto.h>
+#include <openssl/err.h>
+#include <openssl/pem.h>
+#include <stdlib.h>
+#include <time.h>
+
+/*
+ * The index is an array of trust anchors sorted by subject name
+ * (X509_NAME_cmp, which compares the cached canonical encodings), so a
+ * lookup is a binary search plus a scan over equal names. The
+ * SPARETOOLS_X509STORE is found from the X509_STORE through ex_data; once
+ * it is freed the ex_data is cleared and an X509_STORE still referenced
+ * elsewhere (an SSL_CTX) falls back to OpenSSL's own lookups.
+ */
+
+struct sparetools_x509store_st {
+    X509_STORE *store;
+    X509 **index;
+    int count;
+};
+
+static CRYPTO_ONCE init_once = CRYPTO_ONCE_STATIC_INIT;
+static int store_ex_index = -1;
+static CRYPTO_THREAD_LOCAL ctx_key;
+static int ctx_key_ready = 0;
+
+static void free_thread_ctx(void *ctx) {
+    X509_STORE_CTX_free(ctx);
+}
+
+static void init_globals(void) {
+    store_ex_index = X509_STORE_get_ex_new_index(0, "sparetools_x509store", NULL, NULL, NULL);
+    ctx_key_ready = CRYPTO_THREAD_init_local(&ctx_key, free_thread_ctx);
+}
+
+static int globals_ready(void) {
+    return CRYPTO_THREAD_run_once(&init_once, init_globals) && store_ex_index >= 0 && ctx_key_ready;
+}
+
+static int subject_cmp(const void *a, const void *b) {
+    return X509_NAME_cmp(X509_get_subject_name(*(X509 *const *)a), X509_get_subject_name(*(X509 *const *)b));
+}
+
+/* Index of the first anchor with subject name, or -1; *end is one past the last */
+static int find_subject(const SPARETOOLS_X509STORE *s, const X509_NAME *name, int *end) {
+    int lo = 0, hi = s->count;
+
+    while (lo < hi) {
+        int mid = lo + (hi - lo) / 2;
+
+        if (X509_NAME_cmp(X509_get_subject_name(s->index[mid]), name) < 0)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    for (*end = lo; *end < s->count && X509_NAME_cmp(X509_get_subject_name(s->index[*end]), name) == 0;)
+        (*end)++;
+    return *end > lo ? lo : -1;
+}
+
+static const SPARETOOLS_X509STORE *index_of(X509_STORE_CTX *ctx) {
+    X509_STORE *store = X509_STORE_CTX_get0_store(ctx);
+
+    return store != NULL ? X509_STORE_get_ex_data(store, store_ex_index) : NULL;
+}
+
+static int in_validity_period(X509_STORE_CTX *ctx, X509 *cert) {
+    X509_VERIFY_PARAM *param = X509_STORE_CTX_get0_param(ctx);
+    time_t check_time, *when = NULL;
+
+    if (X509_VERIFY_PARAM_get_flags(param) & X509_V_FLAG_NO_CHECK_TIME)
+        return 1;
+    if (X509_VERIFY_PARAM_get_flags(param) & X509_V_FLAG_USE_CHECK_TIME) {
+        check_time = X509_VERIFY_PARAM_get_time(param);
+        when = &check_time;
+    }
+    return X509_cmp_time(X509_get0_notBefore(cert), when) < 0
+        && X509_cmp_time(X509_get0_notAfter(cert), when) > 0;
+}
+
+/*
+ * X509_STORE get_issuer: like X509_STORE_CTX_get1_issuer, the first
+ * anchor that issued x and is currently valid, else the last that issued it
+ */
+static int index_get_issuer(X509 **issuer, X509_STORE_CTX *ctx, X509 *x) {
+    const SPARETOOLS_X509STORE *s = index_of(ctx);
+    X509_STORE_CTX_check_issued_fn check_issued = X509_STORE_CTX_get_check_issued(ctx);
+    X509 *found = NULL;
+    int first, end;
+
+    if (s == NULL)
+        return X509_STORE_CTX_get1_issuer(issuer, ctx, x);
+
+    *issuer = NULL;
+    if ((first = find_subject(s, X509_get_issuer_name(x), &end)) < 0)
+        return 0;
+    for (int i = first; i < end; i++) {
+        if (!check_issued(ctx, x, s->index[i]))
+            continue;
+        found = s->index[i];
+        if (in_validity_period(ctx, found))
+            break;
+    }
+    if (found == NULL || !X509_up_ref(found))
+        return 0;
+    *issuer = found;
+    return 1;
+}
+
+/* X509_STORE lookup_certs: every anchor with subject name */
+static STACK_OF(X509) *index_lookup_certs(X509_STORE_CTX *ctx, const X509_NAME *name) {
+    const SPARETOOLS_X509STORE *s = index_of(ctx);
+    STACK_OF(X509) *certs;
+    int first, end;
+
+    if (s == NULL)
+        return X509_STORE_CTX_get1_certs(ctx, (X509_NAME *)name);
+    if ((first = find_subject(s, name, &end)) < 0 || (certs = sk_X509_new_reserve(NULL, end - first)) == NULL)
+        return NULL;
+    for (int i = first; i < end; i++) {
+        if (!X509_add_cert(certs, s->index[i], X509_ADD_FLAG_UP_REF)) {
+            sk_X509_pop_free(certs, X509_free);
+            return NULL;
+        }
+    }
+    return certs;
+}
+
+SPARETOOLS_X509STORE *sparetools_x509store_new(STACK_OF(X509) *anchors) {
+    SPARETOOLS_X509STORE *s;
+    int n = sk_X509_num(anchors);
+
+    if (!globals_ready() || n < 0 || (s = OPENSSL_zalloc(sizeof(*s))) == NULL)
+        return NULL;
+    if ((s->store = X509_STORE_new()) == NULL
+        || (n > 0 && (s->index = OPENSSL_malloc(sizeof(*s->index) * n)) == NULL))
+        goto err;
+
+    for (int i = 0; i < n; i++) {
+        X509 *cert = sk_X509_value(anchors, i);
+
+        if (!X509_STORE_add_cert(s->store, cert) || !X509_up_ref(cert))
+            goto err;
+        s->index[s->count++] = cert;
+    }
+    qsort(s->index, s->count, sizeof(*s->index), subject_cmp);
+
+    if (!X509_STORE_set_ex_data(s->store, store_ex_index, s))
+        goto err;
+    X509_STORE_set_get_issuer(s->store, index_get_issuer);
+    X509_STORE_set_lookup_certs(s->store, index_lookup_certs);
+    return s;
+
+ err:
+    sparetools_x509store_free(s);
+    return NULL;
+}
+
+SPARETOOLS_X509STORE *sparetools_x509store_load(const char *pem_path) {
+    SPARETOOLS_X509STORE *s = NULL;
+    STACK_OF(X509_INFO) *infos = NULL;
+    STACK_OF(X509) *anchors = sk_X509_new_null();
+    BIO *in = BIO_new_file(pem_path, "r");
+
+    if (in == NULL || anchors == NULL || (infos = PEM_X509_INFO_read_bio(in, NULL, NULL, NULL)) == NULL)
+        goto done;
+    for (int i = 0; i < sk_X509_INFO_num(infos); i++) {
+        X509 *cert = sk_X509_INFO_value(infos, i)->x509;
+
+        if (cert != NULL && !sk_X509_push(anchors, cert))
+            goto done;
+    }
+    s = sparetools_x509store_new(anchors);
+
+ done:
+    /* The infos own the certificates; the store took its own references */
+    sk_X509_free(anchors);
+    sk_X509_INFO_pop_free(infos, X509_INFO_free);
+    BIO_free(in);
+    return s;
+}
+
+void sparetools_x509store_free(SPARETOOLS_X509STORE *s) {
+    if (s == NULL)
+        return;
+    if (s->store != NULL) {
+        X509_STORE_set_ex_data(s->store, store_ex_index, NULL);
+        X509_STORE_free(s->store);
+    }
+    for (int i = 0; i < s->count; i++)
+        X509_free(s->index[i]);
+    OPENSSL_free(s->index);
+    OPENSSL_free(s);
+}
+
+X509_STORE *sparetools_x509store_get0_store(const SPARETOOLS_X509STORE *s) {
+    return s != NULL ? s->store : NULL;
+}
+
+int sparetools_x509store_count(const SPARETOOLS_X509STORE *s) {
+    return s != NULL ? s->count : 0;
+}
+
+int sparetools_x509store_verify(SPARETOOLS_X509STORE *s, X509 *leaf, STACK_OF(X509) *untrusted,
+                                int *error) {
+    X509_STORE_CTX *ctx;
+    int ok;
+
+    if (error != NULL)
+        *error = X509_V_ERR_UNSPECIFIED;
+    if (s == NULL || leaf == NULL || !globals_ready())
+        return 0;
+    if ((ctx = CRYPTO_THREAD_get_local(&ctx_key)) == NULL) {
+        if ((ctx = X509_STORE_CTX_new()) == NULL)
+            return 0;
+        if (!CRYPTO_THREAD_set_local(&ctx_key, ctx)) {
+            X509_STORE_CTX_free(ctx);
+            return 0;
+        }
+    }
+
+    if (!X509_STORE_CTX_init(ctx, s->store, leaf, untrusted)) {
+        X509_STORE_CTX_cleanup(ctx);
+        return 0;
+    }
+    ok = X509_verify_cert(ctx) == 1;
+    if (error != NULL)
+        *error = X509_STORE_CTX_get_error(ctx);
+    X509_STORE_CTX_cleanup(ctx);
+    if (!ok)
+        ERR_clear_error();
+    return ok;
+}
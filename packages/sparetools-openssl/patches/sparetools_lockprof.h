@@ -0,0 +1,325 @@
+#ifndef SPARETOOLS_LOCKPROF_H
+#define SPARETOOLS_LOCKPROF_H
+
+/**
+ * Lock contention profiling for CRYPTO_THREAD locks (lock_profiling=True)
+ *
+ * The recipe includes this header at the top of crypto/threads_pthread.c
+ * and sparetools_lockprof_end.h at its bottom. In between, the pthread
+ * lock calls of that file go through the wrappers below:
+ *
+ * - pthread_rwlock_init / pthread_mutex_init record the creation site,
+ *   the return address of the function creating the lock (the caller of
+ *   CRYPTO_THREAD_lock_new, ossl_rcu_lock_new, ...)
+ * - pthread_rwlock_rdlock / wrlock and pthread_mutex_lock count the
+ *   acquisition, try the lock first and, when that fails, count a
+ *   contended acquisition and add the time spent blocking in the real call
+ *
+ * Counters are kept per creation site. OPENSSL_cleanup (patched in
+ * crypto/init.c) calls sparetools_lockprof_dump(), which writes one line
+ * per site sorted by wait time, to the path in SPARETOOLS_LOCKPROF or to
+ * stderr:
+ *
+ *   wait_ns <TAB> contended <TAB> acquisitions <TAB> locks <TAB> site
+ *
+ * where site is "<module>+0x<offset>" from /proc/self/maps (resolve with
+ * addr2line -f -e <module> <offset>), or "untracked" for locks that were
+ * statically initialized or did not fit the lock table (live locks are
+ * looked up by address in a fixed open-addressing table). The counters are
+ * shared atomics, so a profiled build adds cache-line traffic of its own
+ * to hot locks: compare contention between sites, not absolute rates with
+ * an unprofiled build. The FIPS module is never instrumented.
+ */
+
+#if !defined(FIPS_MODULE)
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define SPARETOOLS_LOCKPROF_SITES 4096      /* Power of two */
+#define SPARETOOLS_LOCKPROF_LOCKS 65536     /* Power of two */
+#define SPARETOOLS_LOCKPROF_PROBES 64       /* Bounds every lock table walk */
+#define SPARETOOLS_LOCKPROF_EMPTY ((uintptr_t)0)
+#define SPARETOOLS_LOCKPROF_DELETED ((uintptr_t)1)
+
+typedef struct {
+    uintptr_t site;                 /* Return address; 0 for "untracked" */
+    uint64_t acquisitions;
+    uint64_t contended;
+    uint64_t wait_ns;
+    uint64_t locks;
+} sparetools_lockprof_site;
+
+typedef struct {
+    uintptr_t lock;                 /* EMPTY, DELETED or the lock address */
+    unsigned site;
+} sparetools_lockprof_lock;
+
+/* Slot 0 is "untracked"; inserts are serialized, lookups are lock-free */
+static sparetools_lockprof_site sparetools_lockprof_sites[SPARETOOLS_LOCKPROF_SITES];
+static sparetools_lockprof_lock sparetools_lockprof_locks[SPARETOOLS_LOCKPROF_LOCKS];
+static pthread_mutex_t sparetools_lockprof_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static inline size_t sparetools_lockprof_hash(uintptr_t v) {
+    v ^= v >> 33;
+    v *= (uintptr_t)0xff51afd7ed558ccdULL;
+    v ^= v >> 33;
+    return (size_t)v;
+}
+
+static inline uint64_t sparetools_lockprof_now(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+/* Site slot for a return address (caller holds the mutex) */
+static inline unsigned sparetools_lockprof_site_slot(uintptr_t site) {
+    size_t mask = SPARETOOLS_LOCKPROF_SITES - 1;
+
+    for (size_t i = sparetools_lockprof_hash(site) & mask, n = 1; n < SPARETOOLS_LOCKPROF_SITES;
+         i = (i + 1) & mask, n++) {
+        uintptr_t cur;
+
+        if (i == 0)
+            continue;
+        cur = __atomic_load_n(&sparetools_lockprof_sites[i].site, __ATOMIC_RELAXED);
+        if (cur == site)
+            return (unsigned)i;
+        if (cur == 0) {
+            __atomic_store_n(&sparetools_lockprof_sites[i].site, site, __ATOMIC_RELAXED);
+            return (unsigned)i;
+        }
+    }
+    return 0;
+}
+
+static inline void sparetools_lockprof_register(void *lock, void *site) {
+    size_t mask = SPARETOOLS_LOCKPROF_LOCKS - 1;
+    uintptr_t key = (uintptr_t)lock;
+    unsigned slot;
+
+    pthread_mutex_lock(&sparetools_lockprof_mutex);
+    slot = sparetools_lockprof_site_slot((uintptr_t)site);
+    __atomic_fetch_add(&sparetools_lockprof_sites[slot].locks, 1, __ATOMIC_RELAXED);
+    for (size_t i = sparetools_lockprof_hash(key) & mask, n = 0; n < SPARETOOLS_LOCKPROF_PROBES;
+         i = (i + 1) & mask, n++) {
+        sparetools_lockprof_lock *e = &sparetools_lockprof_locks[i];
+        uintptr_t cur = __atomic_load_n(&e->lock, __ATOMIC_ACQUIRE);
+
+        if (cur == SPARETOOLS_LOCKPROF_EMPTY || cur == SPARETOOLS_LOCKPROF_DELETED || cur == key) {
+            __atomic_store_n(&e->site, slot, __ATOMIC_RELAXED);
+            __atomic_store_n(&e->lock, key, __ATOMIC_RELEASE);
+            break;
+        }
+    }
+    pthread_mutex_unlock(&sparetools_lockprof_mutex);
+}
+
+static inline void sparetools_lockprof_unregister(void *lock) {
+    size_t mask = SPARETOOLS_LOCKPROF_LOCKS - 1;
+    uintptr_t key = (uintptr_t)lock;
+
+    pthread_mutex_lock(&sparetools_lockprof_mutex);
+    for (size_t i = sparetools_lockprof_hash(key) & mask, n = 0; n < SPARETOOLS_LOCKPROF_PROBES;
+         i = (i + 1) & mask, n++) {
+        uintptr_t cur = __atomic_load_n(&sparetools_lockprof_locks[i].lock, __ATOMIC_ACQUIRE);
+
+        if (cur == SPARETOOLS_LOCKPROF_EMPTY)
+            break;
+        if (cur == key) {
+            __atomic_store_n(&sparetools_lockprof_locks[i].lock, SPARETOOLS_LOCKPROF_DELETED,
+                             __ATOMIC_RELEASE);
+            break;
+        }
+    }
+    pthread_mutex_unlock(&sparetools_lockprof_mutex);
+}
+
+static inline sparetools_lockprof_site *sparetools_lockprof_lookup(void *lock) {
+    size_t mask = SPARETOOLS_LOCKPROF_LOCKS - 1;
+    uintptr_t key = (uintptr_t)lock;
+
+    for (size_t i = sparetools_lockprof_hash(key) & mask, n = 0; n < SPARETOOLS_LOCKPROF_PROBES;
+         i = (i + 1) & mask, n++) {
+        uintptr_t cur = __atomic_load_n(&sparetools_lockprof_locks[i].lock, __ATOMIC_ACQUIRE);
+
+        if (cur == key)
+            return &sparetools_lockprof_sites[__atomic_load_n(&sparetools_lockprof_locks[i].site,
+                                                              __ATOMIC_RELAXED)];
+        if (cur == SPARETOOLS_LOCKPROF_EMPTY)
+            break;
+    }
+    return &sparetools_lockprof_sites[0];
+}
+
+static inline void sparetools_lockprof_count(void *lock, int contended, uint64_t start) {
+    sparetools_lockprof_site *s = sparetools_lockprof_lookup(lock);
+
+    __atomic_fetch_add(&s->acquisitions, 1, __ATOMIC_RELAXED);
+    if (contended) {
+        __atomic_fetch_add(&s->contended, 1, __ATOMIC_RELAXED);
+        __atomic_fetch_add(&s->wait_ns, sparetools_lockprof_now() - start, __ATOMIC_RELAXED);
+    }
+}
+
+static inline int sparetools_lockprof_rwlock_init(pthread_rwlock_t *l, const pthread_rwlockattr_t *a, void *site) {
+    int ret = pthread_rwlock_init(l, a);
+
+    if (ret == 0)
+        sparetools_lockprof_register(l, site);
+    return ret;
+}
+
+static inline int sparetools_lockprof_mutex_init(pthread_mutex_t *m, const pthread_mutexattr_t *a, void *site) {
+    int ret = pthread_mutex_init(m, a);
+
+    if (ret == 0)
+        sparetools_lockprof_register(m, site);
+    return ret;
+}
+
+static inline int sparetools_lockprof_rwlock_destroy(pthread_rwlock_t *l) {
+    sparetools_lockprof_unregister(l);
+    return pthread_rwlock_destroy(l);
+}
+
+static inline int sparetools_lockprof_mutex_destroy(pthread_mutex_t *m) {
+    sparetools_lockprof_unregister(m);
+    return pthread_mutex_destroy(m);
+}
+
+static inline int sparetools_lockprof_rdlock(pthread_rwlock_t *l) {
+    uint64_t start;
+    int ret;
+
+    if (pthread_rwlock_tryrdlock(l) == 0) {
+        sparetools_lockprof_count(l, 0, 0);
+        return 0;
+    }
+    start = sparetools_lockprof_now();
+    ret = pthread_rwlock_rdlock(l);
+    sparetools_lockprof_count(l, 1, start);
+    return ret;
+}
+
+static inline int sparetools_lockprof_wrlock(pthread_rwlock_t *l) {
+    uint64_t start;
+    int ret;
+
+    if (pthread_rwlock_trywrlock(l) == 0) {
+        sparetools_lockprof_count(l, 0, 0);
+        return 0;
+    }
+    start = sparetools_lockprof_now();
+    ret = pthread_rwlock_wrlock(l);
+    sparetools_lockprof_count(l, 1, start);
+    return ret;
+}
+
+static inline int sparetools_lockprof_mutex_lock(pthread_mutex_t *m) {
+    uint64_t start;
+    int ret;
+
+    if (pthread_mutex_trylock(m) == 0) {
+        sparetools_lockprof_count(m, 0, 0);
+        return 0;
+    }
+    start = sparetools_lockprof_now();
+    ret = pthread_mutex_lock(m);
+    sparetools_lockprof_count(m, 1, start);
+    return ret;
+}
+
+static inline int sparetools_lockprof_cmp(const void *a, const void *b) {
+    const sparetools_lockprof_site *x = a, *y = b;
+
+    if (x->wait_ns != y->wait_ns)
+        return x->wait_ns < y->wait_ns ? 1 : -1;
+    if (x->contended != y->contended)
+        return x->contended < y->contended ? 1 : -1;
+    return x->acquisitions < y->acquisitions ? 1 : (x->acquisitions > y->acquisitions ? -1 : 0);
+}
+
+/* "<module>+0x<offset>" for a code address, from /proc/self/maps */
+static inline void sparetools_lockprof_site_name(uintptr_t site, char *buf, size_t len) {
+    FILE *maps;
+    char line[4096];
+
+    if (site == 0) {
+        snprintf(buf, len, "untracked");
+        return;
+    }
+    snprintf(buf, len, "0x%lx", (unsigned long)site);
+    if ((maps = fopen("/proc/self/maps", "r")) == NULL)
+        return;
+    while (fgets(line, sizeof(line), maps) != NULL) {
+        unsigned long start, end, offset;
+        char path[4096];
+
+        path[0] = '\0';
+        if (sscanf(line, "%lx-%lx %*s %lx %*s %*s %4095s", &start, &end, &offset, path) < 3)
+            continue;
+        if (site >= start && site < end) {
+            if (path[0] != '\0')
+                snprintf(buf, len, "%s+0x%lx", path, (unsigned long)(site - start + offset));
+            break;
+        }
+    }
+    fclose(maps);
+}
+
+/* Called from OPENSSL_cleanup; writes the profile once */
+void sparetools_lockprof_dump(void);
+
+void sparetools_lockprof_dump(void) {
+    static int dumped;
+    sparetools_lockprof_site *sites;
+    const char *path = getenv("SPARETOOLS_LOCKPROF");
+    FILE *out = stderr;
+    size_t n = 0;
+
+    if (__atomic_exchange_n(&dumped, 1, __ATOMIC_ACQ_REL))
+        return;
+    if ((sites = malloc(sizeof(sparetools_lockprof_sites))) == NULL)
+        return;
+    for (size_t i = 0; i < SPARETOOLS_LOCKPROF_SITES; i++) {
+        if (__atomic_load_n(&sparetools_lockprof_sites[i].acquisitions, __ATOMIC_RELAXED) == 0)
+            continue;
+        sites[n] = sparetools_lockprof_sites[i];
+        n++;
+    }
+    qsort(sites, n, sizeof(*sites), sparetools_lockprof_cmp);
+    if (path != NULL && path[0] != '\0' && (out = fopen(path, "w")) == NULL)
+        out = stderr;
+    fprintf(out, "# SpareTools lock profile: wait_ns\tcontended\tacquisitions\tlocks\tsite\n");
+    for (size_t i = 0; i < n; i++) {
+        char name[4200];
+
+        sparetools_lockprof_site_name(sites[i].site, name, sizeof(name));
+        fprintf(out, "%llu\t%llu\t%llu\t%llu\t%s\n", (unsigned long long)sites[i].wait_ns,
+                (unsigned long long)sites[i].contended, (unsigned long long)sites[i].acquisitions,
+                (unsigned long long)sites[i].locks, name);
+    }
+    if (out != stderr)
+        fclose(out);
+    free(sites);
+}
+
+/* From here on, threads_pthread.c locks through the wrappers */
+#define pthread_rwlock_init(l, a) sparetools_lockprof_rwlock_init((l), (a), __builtin_return_address(0))
+#define pthread_mutex_init(m, a) sparetools_lockprof_mutex_init((m), (a), __builtin_return_address(0))
+#define pthread_rwlock_destroy(l) sparetools_lockprof_rwlock_destroy(l)
+#define pthread_mutex_destroy(m) sparetools_lockprof_mutex_destroy(m)
+#define pthread_rwlock_rdlock(l) sparetools_lockprof_rdlock(l)
+#define pthread_rwlock_wrlock(l) sparetools_lockprof_wrlock(l)
+#define pthread_mutex_lock(m) sparetools_lockprof_mutex_lock(m)
+
+#endif /* FIPS_MODULE */
+
+#endif /* SPARETOOLS_LOCKPROF_H */
@@ -0,0 +1,11 @@
+/*
+ * Included at the bottom of crypto/threads_pthread.c (lock_profiling=True):
+ * keeps the lock wrappers from leaking into the next file of a unity batch.
+ */
+#undef pthread_rwlock_init
+#undef pthread_mutex_init
+#undef pthread_rwlock_destroy
+#undef pthread_mutex_destroy
+#undef pthread_rwlock_rdlock
+#undef pthread_rwlock_wrlock
+#undef pthread_mutex_lock
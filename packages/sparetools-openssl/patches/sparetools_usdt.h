@@ -0,0 +1,33 @@
+#ifndef SPARETOOLS_USDT_H
+#define SPARETOOLS_USDT_H
+
+/**
+ * USDT probes for usdt_probes=True packages
+ *
+ * The recipe includes this header at the top of each source file it
+ * instruments and wraps one function per probe pair (see
+ * _USDT_PROBES in conanfile.py). All probes use the provider name
+ * "sparetools":
+ *
+ *   handshake_start(ssl, is_server)         SSL_do_handshake, first call
+ *   handshake_done(ssl, version)            SSL_do_handshake, completed
+ *   record_start(sending, n_recs)           record layer encrypt/decrypt
+ *   record_done(sending, n_recs, ret)
+ *   fetch_miss_start(operation_id)          method store miss: construct
+ *   fetch_miss_done(operation_id, method)   the method from the providers
+ *   provider_load_start(prov, name)         provider initialization
+ *   provider_load_done(prov, name, ret)
+ *
+ * A disabled probe is a single nop plus a note in .note.stapsdt; the
+ * arguments are values already in registers. The bpftrace scripts in
+ * res/bpftrace attach to them. The FIPS module is never instrumented.
+ */
+
+#if defined(FIPS_MODULE)
+# define SPARETOOLS_USDT(name, ...) ((void)0)
+#else
+# include <sys/sdt.h>
+# define SPARETOOLS_USDT(name, ...) STAP_PROBEV(sparetools, name, __VA_ARGS__)
+#endif
+
+#endif /* SPARETOOLS_USDT_H */
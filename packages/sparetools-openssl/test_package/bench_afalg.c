@@ -0,0 +1,446 @@
+/* The afalg engine is only reachable through the deprecated ENGINE API */
+#define OPENSSL_SUPPRESS_DEPRECATED
+
+#include <openssl/err.h>
+#include <openssl/evp.h>
+#ifndef OPENSSL_NO_ENGINE
+#include <openssl/engine.h>
+#endif
+#include <errno.h>
+#include <linux/if_alg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "bench_common.h"
+
+#ifndef SOL_ALG
+#define SOL_ALG 279
+#endif
+
+/**
+ * Kernel crypto (AF_ALG) vs userspace AES benchmark
+ *
+ * Encrypts buffers of 256 B to 64 KiB with AES-128/256-CBC and
+ * AES-128/256-GCM (seal incl. tag) three ways and reports MB/s:
+ * - userspace: the default provider (AES-NI/VAES, ARMv8 CE/NEON or the
+ *              constant-time C code, whatever this build has)
+ * - af_alg:    the kernel crypto API through an AF_ALG socket
+ *              ("cbc(aes)" skcipher, "gcm(aes)" aead); one sendmsg()
+ *              with the IV and one read() per buffer
+ * - engine:    OpenSSL's afalg engine (enable_afalg=True packages), which
+ *              drives the same socket with AIO; CBC only
+ * Kernel records carry the kernel driver that serves the algorithm (the
+ * highest-priority /proc/crypto entry, e.g. a SoC crypto engine instead of
+ * cbc-aes-ce) and the throughput relative to userspace at the same size.
+ *
+ * Without AF_ALG (no CONFIG_CRYPTO_USER_API_SKCIPHER/AEAD, seccomp,
+ * containers) or without the engine, those records are written with
+ * "available": 0 and the userspace numbers still are. Linux only.
+ */
+
+static const size_t buffer_sizes[] = {256, 1024, 4096, 16384, 65536};
+#define NUM_BUFFER_SIZES (sizeof(buffer_sizes) / sizeof(buffer_sizes[0]))
+#define MAX_BUFFER_SIZE 65536
+#define GCM_TAG_LEN 16
+
+typedef struct {
+    const char *name;      /* EVP name */
+    const char *kernel;    /* crypto API name */
+    const char *type;      /* AF_ALG salg_type */
+    int key_len;
+    int iv_len;
+    int aead;
+} cipher_spec;
+
+static const cipher_spec ciphers[] = {
+    {"AES-128-CBC", "cbc(aes)", "skcipher", 16, 16, 0},
+    {"AES-256-CBC", "cbc(aes)", "skcipher", 32, 16, 0},
+    {"AES-128-GCM", "gcm(aes)", "aead", 16, 12, 1},
+    {"AES-256-GCM", "gcm(aes)", "aead", 32, 12, 1},
+};
+#define NUM_CIPHERS (sizeof(ciphers) / sizeof(ciphers[0]))
+
+enum { BACKEND_USERSPACE, BACKEND_AF_ALG, BACKEND_ENGINE, NUM_BACKENDS };
+static const char *backend_names[NUM_BACKENDS] = {"userspace", "af_alg", "engine"};
+
+typedef struct {
+    const cipher_spec *spec;
+    EVP_CIPHER_CTX *ctx;    /* userspace and engine */
+    int op_fd;              /* af_alg */
+    unsigned char key[32];
+    unsigned char iv[16];
+    unsigned char *out;
+} cipher_arg;
+
+typedef int (*bench_op)(cipher_arg *arg, const unsigned char *buf, size_t len);
+
+static int evp_encrypt(cipher_arg *c, const unsigned char *buf, size_t len) {
+    unsigned char tag[GCM_TAG_LEN];
+    int outl = 0, tmpl = 0;
+
+    /* Same key, next IV per buffer, as the kernel paths get */
+    if (!EVP_EncryptInit_ex(c->ctx, NULL, NULL, NULL, c->iv))
+        return 0;
+    if (!EVP_EncryptUpdate(c->ctx, c->out, &outl, buf, (int)len))
+        return 0;
+    if (!EVP_EncryptFinal_ex(c->ctx, c->out + outl, &tmpl))
+        return 0;
+    if (c->spec->aead && !EVP_CIPHER_CTX_ctrl(c->ctx, EVP_CTRL_AEAD_GET_TAG, sizeof(tag), tag))
+        return 0;
+    c->iv[0]++;
+    return 1;
+}
+
+static int af_alg_encrypt(cipher_arg *c, const unsigned char *buf, size_t len) {
+    char control[CMSG_SPACE(sizeof(uint32_t)) * 2 + CMSG_SPACE(sizeof(struct af_alg_iv) + 16)];
+    struct iovec iov = {(void *)buf, len};
+    struct msghdr msg;
+    struct cmsghdr *cmsg;
+    struct af_alg_iv *alg_iv;
+    size_t expect = len + (c->spec->aead ? GCM_TAG_LEN : 0);
+    ssize_t n;
+
+    memset(control, 0, sizeof(control));
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_control = control;
+    /* Exactly the headers sent: the kernel rejects trailing empty ones */
+    msg.msg_controllen = CMSG_SPACE(sizeof(uint32_t))
+        + CMSG_SPACE(sizeof(struct af_alg_iv) + (size_t)c->spec->iv_len)
+        + (c->spec->aead ? CMSG_SPACE(sizeof(uint32_t)) : 0);
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+
+    cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_ALG;
+    cmsg->cmsg_type = ALG_SET_OP;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(uint32_t));
+    *(uint32_t *)CMSG_DATA(cmsg) = ALG_OP_ENCRYPT;
+
+    cmsg = CMSG_NXTHDR(&msg, cmsg);
+    cmsg->cmsg_level = SOL_ALG;
+    cmsg->cmsg_type = ALG_SET_IV;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(struct af_alg_iv) + (size_t)c->spec->iv_len);
+    alg_iv = (struct af_alg_iv *)CMSG_DATA(cmsg);
+    alg_iv->ivlen = (uint32_t)c->spec->iv_len;
+    memcpy(alg_iv->iv, c->iv, (size_t)c->spec->iv_len);
+
+    if (c->spec->aead) {
+        /* No associated data: the input is the plaintext only */
+        cmsg = CMSG_NXTHDR(&msg, cmsg);
+        cmsg->cmsg_level = SOL_ALG;
+        cmsg->cmsg_type = ALG_SET_AEAD_ASSOCLEN;
+        cmsg->cmsg_len = CMSG_LEN(sizeof(uint32_t));
+        *(uint32_t *)CMSG_DATA(cmsg) = 0;
+    }
+
+    if (sendmsg(c->op_fd, &msg, 0) != (ssize_t)len)
+        return 0;
+    n = read(c->op_fd, c->out, expect);
+    c->iv[0]++;
+    return n == (ssize_t)expect;
+}
+
+/**
+ * AF_ALG operation socket for spec keyed with key, or -1 when the kernel
+ * does not offer the algorithm (errno kept for the message).
+ */
+static int af_alg_open(const cipher_spec *spec, const unsigned char *key) {
+    struct sockaddr_alg sa;
+    int tfm, op;
+
+    memset(&sa, 0, sizeof(sa));
+    sa.salg_family = AF_ALG;
+    strncpy((char *)sa.salg_type, spec->type, sizeof(sa.salg_type) - 1);
+    strncpy((char *)sa.salg_name, spec->kernel, sizeof(sa.salg_name) - 1);
+
+    tfm = socket(AF_ALG, SOCK_SEQPACKET, 0);
+    if (tfm < 0)
+        return -1;
+    if (bind(tfm, (struct sockaddr *)&sa, sizeof(sa)) != 0
+        || setsockopt(tfm, SOL_ALG, ALG_SET_KEY, key, (socklen_t)spec->key_len) != 0
+        || (spec->aead && setsockopt(tfm, SOL_ALG, ALG_SET_AEAD_AUTHSIZE, NULL, GCM_TAG_LEN) != 0)) {
+        int err = errno;
+        close(tfm);
+        errno = err;
+        return -1;
+    }
+    op = accept(tfm, NULL, 0);
+    close(tfm);
+    return op;
+}
+
+/** Driver of the highest-priority /proc/crypto implementation of name */
+static void kernel_driver(const char *name, char *driver, size_t size) {
+    char line[256], current_name[128] = "", current_driver[128] = "";
+    int best = -1;
+    FILE *fp = fopen("/proc/crypto", "r");
+
+    snprintf(driver, size, "unknown");
+    if (fp == NULL)
+        return;
+    while (fgets(line, sizeof(line), fp) != NULL) {
+        char *value = strchr(line, ':');
+
+        if (value == NULL)
+            continue;
+        *value++ = '\0';
+        value += strspn(value, " ");
+        value[strcspn(value, "\n")] = '\0';
+        if (strncmp(line, "name", 4) == 0) {
+            snprintf(current_name, sizeof(current_name), "%s", value);
+        } else if (strncmp(line, "driver", 6) == 0) {
+            snprintf(current_driver, sizeof(current_driver), "%s", value);
+        } else if (strncmp(line, "priority", 8) == 0) {
+            int priority = atoi(value);
+
+            if (strcmp(current_name, name) == 0 && priority > best) {
+                best = priority;
+                snprintf(driver, size, "%s", current_driver);
+            }
+        }
+    }
+    fclose(fp);
+}
+
+/**
+ * Run op over buf until at least min_seconds have elapsed.
+ * Returns MB/s (10^6 bytes per second) or a negative value on failure.
+ */
+static double measure(bench_op op, cipher_arg *arg, const unsigned char *buf, size_t len,
+                      double min_seconds, unsigned long long *iterations) {
+    unsigned long long count = 0, batch = 1;
+    double start, elapsed;
+
+    if (!op(arg, buf, len))
+        return -1.0;
+
+    start = bench_now();
+    do {
+        for (unsigned long long i = 0; i < batch; i++) {
+            if (!op(arg, buf, len))
+                return -1.0;
+        }
+        count += batch;
+        if (batch < (1ULL << 16))
+            batch *= 2;
+        elapsed = bench_now() - start;
+    } while (elapsed < min_seconds);
+
+    *iterations = count;
+    return (double)count * (double)len / elapsed / 1e6;
+}
+
+static void report(bench_json *json, int backend, const cipher_spec *spec, const char *driver,
+                   size_t len, unsigned long long iterations, double mbps, double userspace) {
+    bench_json_record_begin(json);
+    bench_json_str(json, "backend", backend_names[backend]);
+    bench_json_str(json, "algorithm", spec->name);
+    if (driver != NULL)
+        bench_json_str(json, "driver", driver);
+    bench_json_int(json, "buffer_size", len);
+    if (mbps < 0) {
+        bench_json_int(json, "available", 0);
+        bench_json_record_end(json);
+        return;
+    }
+    bench_json_int(json, "iterations", iterations);
+    bench_json_num(json, "mb_per_s", mbps);
+    if (backend != BACKEND_USERSPACE && userspace > 0) {
+        bench_json_num(json, "vs_userspace", mbps / userspace);
+        printf("  %-10s %-12s %6zu B  %10.2f MB/s  %5.2fx\n", backend_names[backend], spec->name,
+               len, mbps, mbps / userspace);
+    } else {
+        printf("  %-10s %-12s %6zu B  %10.2f MB/s\n", backend_names[backend], spec->name, len, mbps);
+    }
+    bench_json_record_end(json);
+}
+
+static void report_unavailable(bench_json *json, int backend, const cipher_spec *spec,
+                               const char *driver, const char *reason) {
+    printf("  %-10s %-12s not available (%s)\n", backend_names[backend], spec->name, reason);
+    bench_json_record_begin(json);
+    bench_json_str(json, "backend", backend_names[backend]);
+    bench_json_str(json, "algorithm", spec->name);
+    if (driver != NULL)
+        bench_json_str(json, "driver", driver);
+    bench_json_str(json, "reason", reason);
+    bench_json_int(json, "available", 0);
+    bench_json_record_end(json);
+}
+
+#ifndef OPENSSL_NO_ENGINE
+/** The afalg engine, initialised, or NULL with the reason */
+static ENGINE *afalg_engine(const char **reason) {
+    ENGINE *e;
+
+    ENGINE_load_builtin_engines();
+    e = ENGINE_by_id("afalg");
+    if (e == NULL) {
+        /* Not built (enable_afalg=False), or its bind found no AF_ALG */
+        *reason = "afalg engine not available";
+        ERR_clear_error();
+        return NULL;
+    }
+    if (!ENGINE_init(e)) {
+        *reason = "afalg engine cannot open AF_ALG";
+        ENGINE_free(e);
+        ERR_clear_error();
+        return NULL;
+    }
+    return e;
+}
+
+static const EVP_CIPHER *legacy_cipher(const cipher_spec *spec) {
+    if (spec->aead)
+        return NULL;
+    return spec->key_len == 16 ? EVP_aes_128_cbc() : EVP_aes_256_cbc();
+}
+#endif
+
+static int bench_cipher(bench_json *json, const bench_options *opts, const cipher_spec *spec,
+                        const unsigned char *buf, void *engine) {
+    double userspace[NUM_BUFFER_SIZES];
+    char driver[128];
+    cipher_arg c;
+    EVP_CIPHER *cipher;
+    int failures = 0;
+
+    memset(&c, 0, sizeof(c));
+    c.spec = spec;
+    c.op_fd = -1;
+    memset(c.key, 0x42, sizeof(c.key));
+    memset(c.iv, 0x24, sizeof(c.iv));
+    c.out = malloc(MAX_BUFFER_SIZE + EVP_MAX_BLOCK_LENGTH + GCM_TAG_LEN);
+    c.ctx = EVP_CIPHER_CTX_new();
+    cipher = EVP_CIPHER_fetch(NULL, spec->name, "provider=default");
+    if (c.out == NULL || c.ctx == NULL || cipher == NULL
+        || !EVP_EncryptInit_ex2(c.ctx, cipher, c.key, c.iv, NULL)) {
+        fprintf(stderr, "ERROR: cannot set up userspace %s\n", spec->name);
+        ERR_print_errors_fp(stderr);
+        EVP_CIPHER_free(cipher);
+        EVP_CIPHER_CTX_free(c.ctx);
+        free(c.out);
+        return 1;
+    }
+    printf("\n%s\n", spec->name);
+    for (size_t s = 0; s < NUM_BUFFER_SIZES; s++) {
+        unsigned long long iterations = 0;
+
+        userspace[s] = measure(evp_encrypt, &c, buf, buffer_sizes[s], opts->min_seconds, &iterations);
+        if (userspace[s] < 0) {
+            fprintf(stderr, "ERROR: userspace %s failed at %zu bytes\n", spec->name, buffer_sizes[s]);
+            failures++;
+        }
+        report(json, BACKEND_USERSPACE, spec, NULL, buffer_sizes[s], iterations, userspace[s], 0);
+    }
+    EVP_CIPHER_free(cipher);
+
+    kernel_driver(spec->kernel, driver, sizeof(driver));
+    c.op_fd = af_alg_open(spec, c.key);
+    if (c.op_fd < 0) {
+        report_unavailable(json, BACKEND_AF_ALG, spec, driver, strerror(errno));
+    } else {
+        for (size_t s = 0; s < NUM_BUFFER_SIZES; s++) {
+            unsigned long long iterations = 0;
+            double mbps = measure(af_alg_encrypt, &c, buf, buffer_sizes[s], opts->min_seconds,
+                                  &iterations);
+
+            /* Kernel limits (socket buffer, ALG_MAX_PAGES) only skip the size */
+            report(json, BACKEND_AF_ALG, spec, driver, buffer_sizes[s], iterations, mbps,
+                   userspace[s]);
+        }
+        close(c.op_fd);
+    }
+
+#ifndef OPENSSL_NO_ENGINE
+    if (spec->aead) {
+        report_unavailable(json, BACKEND_ENGINE, spec, NULL, "afalg engine offers AES-CBC only");
+    } else if (engine == NULL) {
+        report_unavailable(json, BACKEND_ENGINE, spec, NULL, "afalg engine unavailable");
+    } else if (!EVP_EncryptInit_ex(c.ctx, legacy_cipher(spec), engine, c.key, c.iv)) {
+        report_unavailable(json, BACKEND_ENGINE, spec, NULL, "afalg engine rejected the key");
+        ERR_clear_error();
+    } else {
+        for (size_t s = 0; s < NUM_BUFFER_SIZES; s++) {
+            unsigned long long iterations = 0;
+            double mbps = measure(evp_encrypt, &c, buf, buffer_sizes[s], opts->min_seconds,
+                                  &iterations);
+
+            report(json, BACKEND_ENGINE, spec, driver, buffer_sizes[s], iterations, mbps,
+                   userspace[s]);
+        }
+    }
+#else
+    (void)engine;
+    report_unavailable(json, BACKEND_ENGINE, spec, NULL, "built with no-engine");
+#endif
+
+    EVP_CIPHER_CTX_free(c.ctx);
+    free(c.out);
+    return failures;
+}
+
+int main(int argc, char **argv) {
+    bench_options opts;
+    bench_json json;
+    unsigned char *buf;
+    void *engine = NULL;
+    int failures = 0;
+    int argi = bench_parse_args(argc, argv, "bench_afalg.json", &opts);
+
+    if (argi < 0)
+        return 2;
+    if (argi < argc) {
+        bench_usage(argv[0]);
+        return 2;
+    }
+
+    printf("=================================\n");
+    printf("OpenSSL AF_ALG vs Userspace AES\n");
+    printf("=================================\n");
+    printf("OpenSSL version: %s\n", OpenSSL_version(OPENSSL_VERSION));
+
+#ifndef OPENSSL_NO_ENGINE
+    {
+        const char *reason = NULL;
+
+        engine = afalg_engine(&reason);
+        if (engine == NULL)
+            printf("⚠ %s, engine records skipped\n", reason);
+    }
+#endif
+
+    buf = malloc(MAX_BUFFER_SIZE);
+    if (buf == NULL) {
+        fprintf(stderr, "ERROR: Out of memory\n");
+        return 1;
+    }
+    memset(buf, 0xa5, MAX_BUFFER_SIZE);
+
+    if (bench_json_begin(&json, &opts, "afalg") != 0) {
+        free(buf);
+        return 1;
+    }
+    for (size_t i = 0; i < NUM_CIPHERS; i++)
+        failures += bench_cipher(&json, &opts, &ciphers[i], buf, engine);
+    bench_json_end(&json);
+
+#ifndef OPENSSL_NO_ENGINE
+    if (engine != NULL) {
+        ENGINE_finish(engine);
+        ENGINE_free(engine);
+    }
+#endif
+    free(buf);
+
+    printf("\n=================================\n");
+    if (failures == 0) {
+        printf("✅ AF_ALG benchmark completed (%s)\n", opts.json_path);
+        return 0;
+    }
+    printf("❌ %d benchmark(s) FAILED\n", failures);
+    return 1;
+}
@@ -0,0 +1,511 @@
+#include <openssl/async.h>
+#include <openssl/crypto.h>
+#include <openssl/err.h>
+#include <openssl/evp.h>
+#include <openssl/provider.h>
+#include <openssl/rsa.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/select.h>
+#include <unistd.h>
+
+#include "bench_common.h"
+
+/**
+ * Asynchronous offload benchmark (ASYNC_JOB)
+ *
+ * Drives RSA-2048 and ECDSA P-256 signatures, ECDH P-256 key derivation
+ * and AES-128-GCM sealing of 16 KiB records through ASYNC_start_job with
+ * up to 64 in-flight jobs per thread, the way an offload-aware server
+ * keeps a hardware queue busy. A provider that offloads (e.g. a QAT
+ * provider) pauses the job with ASYNC_pause_job() while the request is in
+ * flight and signals completion through the ASYNC_WAIT_CTX file
+ * descriptors; the driver loop then resumes whichever job is ready.
+ *
+ * Each workload is measured synchronously (jobs=0, plain EVP calls) and
+ * with 1, 8, 32 and 64 jobs per thread. Reported:
+ * - ops_per_s and relative_to_sync (aes-128-gcm also mb_per_s)
+ * - pause_fraction: starts/resumes that returned ASYNC_PAUSE; 0 means the
+ *   provider completed every call inline (software providers), so the
+ *   async numbers show the fibre switching overhead only
+ * - no_jobs: ASYNC_NO_JOBS returns (job pool exhausted)
+ *
+ * --provider NAME loads an additional provider and fetches with
+ * "provider=NAME"; --threads N runs N driver threads (default 1). Running
+ * under OPENSSL_CONF=<package>/ssl/openssl-qat.cnf (qat_provider option)
+ * instead lets the config's default properties pick the provider.
+ * Packages built with enable_async=False (no-async) and platforms
+ * without ASYNC support report a single unavailable record.
+ */
+
+#define MAX_JOBS 64
+
+static const int job_counts[] = {0, 1, 8, 32, 64, -1};
+static const int quick_job_counts[] = {0, 8, -1};
+
+#define GCM_RECORD 16384
+
+typedef enum { OP_RSA_SIGN, OP_ECDSA_SIGN, OP_ECDH_DERIVE, OP_AES_GCM } op_kind;
+
+static const struct {
+    const char *name;
+    op_kind kind;
+    size_t bytes;
+} workloads[] = {
+    {"rsa2048-sign", OP_RSA_SIGN, 0},
+    {"ecdsa-p256-sign", OP_ECDSA_SIGN, 0},
+    {"ecdhe-p256-derive", OP_ECDH_DERIVE, 0},
+    {"aes-128-gcm", OP_AES_GCM, GCM_RECORD},
+};
+#define NUM_WORKLOADS (sizeof(workloads) / sizeof(workloads[0]))
+
+static EVP_PKEY *rsa_key;
+static EVP_PKEY *ec_key;
+static EVP_PKEY *peer_key;
+static EVP_CIPHER *gcm;
+static const char *propq;
+
+static atomic_int start_flag;
+static atomic_int stop_flag;
+
+typedef struct {
+    op_kind kind;
+    EVP_PKEY_CTX *pctx;
+    EVP_CIPHER_CTX *cctx;
+    unsigned char dgst[32];
+    unsigned char out[512];
+    unsigned char iv[12];
+    unsigned char *record;
+} op_state;
+
+typedef struct {
+    op_kind kind;
+    int jobs;
+    unsigned long long ops;
+    unsigned long long calls;
+    unsigned long long pauses;
+    unsigned long long no_jobs;
+    int failed;
+} thread_arg;
+
+static void op_free(op_state *state) {
+    EVP_PKEY_CTX_free(state->pctx);
+    EVP_CIPHER_CTX_free(state->cctx);
+    free(state->record);
+    memset(state, 0, sizeof(*state));
+}
+
+/* Returns 0 on success */
+static int op_init(op_state *state, op_kind kind) {
+    static const unsigned char key[16] = {0x42};
+
+    memset(state, 0, sizeof(*state));
+    state->kind = kind;
+    memset(state->dgst, 0x11, sizeof(state->dgst));
+    switch (kind) {
+    case OP_RSA_SIGN:
+    case OP_ECDSA_SIGN:
+        state->pctx = EVP_PKEY_CTX_new_from_pkey(NULL, kind == OP_RSA_SIGN ? rsa_key : ec_key, propq);
+        if (state->pctx == NULL || EVP_PKEY_sign_init(state->pctx) <= 0
+            || (kind == OP_RSA_SIGN && EVP_PKEY_CTX_set_rsa_padding(state->pctx, RSA_PKCS1_PADDING) <= 0)
+            || EVP_PKEY_CTX_set_signature_md(state->pctx, EVP_sha256()) <= 0)
+            goto err;
+        return 0;
+    case OP_ECDH_DERIVE:
+        state->pctx = EVP_PKEY_CTX_new_from_pkey(NULL, ec_key, propq);
+        if (state->pctx == NULL || EVP_PKEY_derive_init(state->pctx) <= 0
+            || EVP_PKEY_derive_set_peer(state->pctx, peer_key) <= 0)
+            goto err;
+        return 0;
+    case OP_AES_GCM:
+        state->cctx = EVP_CIPHER_CTX_new();
+        state->record = calloc(1, GCM_RECORD + 16);
+        /* The key is set once; each record only rekeys the IV */
+        if (state->cctx == NULL || state->record == NULL
+            || !EVP_EncryptInit_ex2(state->cctx, gcm, key, state->iv, NULL))
+            goto err;
+        return 0;
+    }
+err:
+    op_free(state);
+    return 1;
+}
+
+static int op_once(op_state *state) {
+    size_t len = sizeof(state->out);
+    int outl, finl;
+
+    switch (state->kind) {
+    case OP_RSA_SIGN:
+    case OP_ECDSA_SIGN:
+        return EVP_PKEY_sign(state->pctx, state->out, &len, state->dgst, sizeof(state->dgst)) > 0;
+    case OP_ECDH_DERIVE:
+        return EVP_PKEY_derive(state->pctx, state->out, &len) > 0;
+    case OP_AES_GCM:
+        /* A fresh nonce per record, as TLS does */
+        for (int i = (int)sizeof(state->iv) - 1; i >= 0 && ++state->iv[i] == 0; i--)
+            ;
+        return EVP_EncryptInit_ex2(state->cctx, NULL, NULL, state->iv, NULL)
+               && EVP_EncryptUpdate(state->cctx, state->record, &outl, state->record, GCM_RECORD)
+               && EVP_EncryptFinal_ex(state->cctx, state->record + outl, &finl)
+               && EVP_CIPHER_CTX_ctrl(state->cctx, EVP_CTRL_AEAD_GET_TAG, 16, state->out) > 0;
+    }
+    return 0;
+}
+
+#ifndef OPENSSL_NO_ASYNC
+/* ASYNC_start_job copies the argument: pass a pointer to the slot state */
+static int op_job(void *varg) {
+    op_state *state = *(op_state **)varg;
+
+    return op_once(state);
+}
+
+typedef struct {
+    ASYNC_JOB *job;
+    ASYNC_WAIT_CTX *wctx;
+    op_state state;
+} job_slot;
+
+/**
+ * Block briefly until one of the paused jobs' wait fds is readable; jobs
+ * that expose no fds (software pauses) are simply polled again.
+ */
+static void wait_for_jobs(job_slot *slots, int jobs) {
+    OSSL_ASYNC_FD fds[MAX_JOBS * 4];
+    size_t total = 0;
+    struct timeval tv = {0, 1000};
+    fd_set readfds;
+    int maxfd = -1;
+
+    FD_ZERO(&readfds);
+    for (int i = 0; i < jobs; i++) {
+        size_t n = 0;
+
+        if (slots[i].job == NULL
+            || !ASYNC_WAIT_CTX_get_all_fds(slots[i].wctx, NULL, &n)
+            || n == 0 || total + n > sizeof(fds) / sizeof(fds[0]))
+            continue;
+        ASYNC_WAIT_CTX_get_all_fds(slots[i].wctx, fds + total, &n);
+        for (size_t k = total; k < total + n; k++) {
+            FD_SET(fds[k], &readfds);
+            if (fds[k] > maxfd)
+                maxfd = fds[k];
+        }
+        total += n;
+    }
+    if (maxfd >= 0)
+        select(maxfd + 1, &readfds, NULL, NULL, &tv);
+}
+
+static void run_async(thread_arg *arg) {
+    job_slot slots[MAX_JOBS];
+    int jobs = arg->jobs;
+
+    memset(slots, 0, sizeof(slots));
+    if (!ASYNC_init_thread((size_t)jobs, (size_t)jobs)) {
+        arg->failed = 1;
+        return;
+    }
+    for (int i = 0; i < jobs; i++) {
+        if ((slots[i].wctx = ASYNC_WAIT_CTX_new()) == NULL
+            || op_init(&slots[i].state, arg->kind) != 0) {
+            arg->failed = 1;
+            goto done;
+        }
+    }
+
+    while (!atomic_load(&start_flag))
+        ;
+
+    while (!atomic_load_explicit(&stop_flag, memory_order_relaxed)) {
+        int paused = 0;
+
+        for (int i = 0; i < jobs; i++) {
+            op_state *state = &slots[i].state;
+            int ret = 0;
+
+            arg->calls++;
+            switch (ASYNC_start_job(&slots[i].job, slots[i].wctx, &ret, op_job,
+                                    &state, sizeof(state))) {
+            case ASYNC_FINISH:
+                if (ret <= 0) {
+                    arg->failed = 1;
+                    goto drain;
+                }
+                arg->ops++;
+                break;
+            case ASYNC_PAUSE:
+                arg->pauses++;
+                paused++;
+                break;
+            case ASYNC_NO_JOBS:
+                arg->no_jobs++;
+                break;
+            default:
+                arg->failed = 1;
+                goto drain;
+            }
+        }
+        /* Every slot is waiting on the provider: sleep on its fds */
+        if (paused == jobs)
+            wait_for_jobs(slots, jobs);
+    }
+
+drain:
+    /* Paused jobs must run to completion before their contexts go away */
+    for (int i = 0; i < jobs; i++) {
+        op_state *state = &slots[i].state;
+        int ret;
+
+        while (slots[i].job != NULL
+               && ASYNC_start_job(&slots[i].job, slots[i].wctx, &ret, op_job,
+                                  &state, sizeof(state)) == ASYNC_PAUSE)
+            wait_for_jobs(&slots[i], 1);
+    }
+done:
+    for (int i = 0; i < jobs; i++) {
+        op_free(&slots[i].state);
+        ASYNC_WAIT_CTX_free(slots[i].wctx);
+    }
+    ASYNC_cleanup_thread();
+}
+#endif
+
+static void run_sync(thread_arg *arg) {
+    op_state state;
+
+    if (op_init(&state, arg->kind) != 0) {
+        arg->failed = 1;
+        return;
+    }
+
+    while (!atomic_load(&start_flag))
+        ;
+
+    while (!atomic_load_explicit(&stop_flag, memory_order_relaxed)) {
+        arg->calls++;
+        if (!op_once(&state)) {
+            arg->failed = 1;
+            break;
+        }
+        arg->ops++;
+    }
+    op_free(&state);
+}
+
+static void *worker(void *varg) {
+    thread_arg *arg = varg;
+
+#ifndef OPENSSL_NO_ASYNC
+    if (arg->jobs > 0) {
+        run_async(arg);
+        return NULL;
+    }
+#endif
+    run_sync(arg);
+    return NULL;
+}
+
+typedef struct {
+    double rate;
+    double pause_fraction;
+    unsigned long long no_jobs;
+} run_result;
+
+/* Returns 0 on success */
+static int run_threads(op_kind kind, int jobs, int nthreads, double seconds, run_result *result) {
+    pthread_t *threads = calloc((size_t)nthreads, sizeof(*threads));
+    thread_arg *args = calloc((size_t)nthreads, sizeof(*args));
+    unsigned long long ops = 0, calls = 0, pauses = 0;
+    double start, elapsed;
+    int failed = 0, started = 0;
+
+    memset(result, 0, sizeof(*result));
+    if (threads == NULL || args == NULL) {
+        free(threads);
+        free(args);
+        return 1;
+    }
+
+    atomic_store(&start_flag, 0);
+    atomic_store(&stop_flag, 0);
+    for (int t = 0; t < nthreads; t++) {
+        args[t].kind = kind;
+        args[t].jobs = jobs;
+        if (pthread_create(&threads[t], NULL, worker, &args[t]) != 0) {
+            failed = 1;
+            break;
+        }
+        started++;
+    }
+
+    start = bench_now();
+    atomic_store(&start_flag, 1);
+    while (!failed && bench_now() - start < seconds)
+        usleep(1000);
+    atomic_store(&stop_flag, 1);
+
+    for (int t = 0; t < started; t++) {
+        pthread_join(threads[t], NULL);
+        ops += args[t].ops;
+        calls += args[t].calls;
+        pauses += args[t].pauses;
+        result->no_jobs += args[t].no_jobs;
+        failed |= args[t].failed;
+    }
+    elapsed = bench_now() - start;
+
+    result->rate = (double)ops / elapsed;
+    result->pause_fraction = calls > 0 ? (double)pauses / (double)calls : 0.0;
+    free(threads);
+    free(args);
+    return failed || ops == 0;
+}
+
+static int async_available(void) {
+#ifdef OPENSSL_NO_ASYNC
+    return 0;
+#else
+    return ASYNC_is_capable();
+#endif
+}
+
+int main(int argc, char **argv) {
+    bench_options opts;
+    bench_json json;
+    const char *provider_name = NULL;
+    char provider_propq[128];
+    OSSL_PROVIDER *prov = NULL, *deflt = NULL;
+    const int *counts;
+    int nthreads = 1, failures = 0;
+    double seconds;
+
+    int argi = bench_parse_args(argc, argv, "bench_async.json", &opts);
+
+    if (argi < 0)
+        return 2;
+    /* Benchmark-specific options follow the common ones */
+    for (; argi < argc; argi++) {
+        if (strcmp(argv[argi], "--threads") == 0 && argi + 1 < argc) {
+            nthreads = atoi(argv[++argi]);
+        } else if (strcmp(argv[argi], "--provider") == 0 && argi + 1 < argc) {
+            provider_name = argv[++argi];
+        } else {
+            fprintf(stderr, "Usage: %s [--quick] [--json PATH] [--threads N] [--provider NAME]\n",
+                    argv[0]);
+            return 2;
+        }
+    }
+    if (nthreads < 1)
+        nthreads = 1;
+    counts = opts.quick ? quick_job_counts : job_counts;
+    /* Thread start-up needs more slack than a single-threaded data point */
+    seconds = opts.min_seconds * 4;
+
+    printf("=================================\n");
+    printf("OpenSSL Async Offload Benchmark\n");
+    printf("=================================\n");
+    printf("OpenSSL version: %s\n", OpenSSL_version(OPENSSL_VERSION));
+    printf("Threads: %d\n", nthreads);
+
+    if (bench_json_begin(&json, &opts, "async") != 0)
+        return 1;
+
+    if (!async_available()) {
+        /* Not a failure: the record is how no-async builds show up */
+        printf("⚠ ASYNC not available (no-async build or unsupported platform)\n");
+        bench_json_record_begin(&json);
+        bench_json_str(&json, "workload", "async");
+        bench_json_int(&json, "available", 0);
+        bench_json_record_end(&json);
+        bench_json_end(&json);
+        return 0;
+    }
+
+    if (provider_name != NULL) {
+        /* Explicit loads disable the implicit default: keep it for keygen */
+        deflt = OSSL_PROVIDER_load(NULL, "default");
+        if ((prov = OSSL_PROVIDER_load(NULL, provider_name)) == NULL) {
+            fprintf(stderr, "ERROR: Cannot load provider %s\n", provider_name);
+            ERR_print_errors_fp(stderr);
+            bench_json_end(&json);
+            OSSL_PROVIDER_unload(deflt);
+            return 1;
+        }
+        snprintf(provider_propq, sizeof(provider_propq), "provider=%s", provider_name);
+        propq = provider_propq;
+        printf("Provider: %s\n", provider_name);
+    }
+
+    rsa_key = EVP_PKEY_Q_keygen(NULL, NULL, "RSA", (size_t)2048);
+    ec_key = EVP_PKEY_Q_keygen(NULL, NULL, "EC", "P-256");
+    peer_key = EVP_PKEY_Q_keygen(NULL, NULL, "EC", "P-256");
+    gcm = EVP_CIPHER_fetch(NULL, "AES-128-GCM", propq);
+    if (rsa_key == NULL || ec_key == NULL || peer_key == NULL || gcm == NULL) {
+        fprintf(stderr, "ERROR: Key generation or AES-128-GCM fetch failed\n");
+        ERR_print_errors_fp(stderr);
+        failures++;
+        goto end;
+    }
+
+    for (size_t w = 0; w < NUM_WORKLOADS; w++) {
+        double sync_rate = 0.0;
+
+        printf("\n%s\n", workloads[w].name);
+        for (int i = 0; counts[i] >= 0; i++) {
+            int jobs = counts[i];
+            run_result r;
+            double relative;
+
+            if (run_threads(workloads[w].kind, jobs, nthreads, seconds, &r) != 0) {
+                fprintf(stderr, "ERROR: %s failed with %d jobs\n", workloads[w].name, jobs);
+                ERR_print_errors_fp(stderr);
+                failures++;
+                continue;
+            }
+            if (jobs == 0)
+                sync_rate = r.rate;
+            relative = sync_rate > 0 ? r.rate / sync_rate : 0.0;
+            if (jobs == 0)
+                printf("  sync          %12.1f ops/s\n", r.rate);
+            else
+                printf("  %3d jobs      %12.1f ops/s  x%.2f  paused %5.1f%%\n",
+                       jobs, r.rate, relative, r.pause_fraction * 100.0);
+
+            bench_json_record_begin(&json);
+            bench_json_str(&json, "workload", workloads[w].name);
+            bench_json_int(&json, "available", 1);
+            bench_json_str(&json, "provider", provider_name != NULL ? provider_name : "default");
+            bench_json_int(&json, "threads", (uint64_t)nthreads);
+            bench_json_int(&json, "jobs", (uint64_t)jobs);
+            bench_json_num(&json, "ops_per_s", r.rate);
+            if (workloads[w].bytes > 0)
+                bench_json_num(&json, "mb_per_s", r.rate * (double)workloads[w].bytes / 1e6);
+            bench_json_num(&json, "relative_to_sync", relative);
+            bench_json_num(&json, "pause_fraction", r.pause_fraction);
+            bench_json_int(&json, "no_jobs", r.no_jobs);
+            bench_json_record_end(&json);
+        }
+    }
+
+end:
+    bench_json_end(&json);
+    EVP_PKEY_free(rsa_key);
+    EVP_PKEY_free(ec_key);
+    EVP_PKEY_free(peer_key);
+    EVP_CIPHER_free(gcm);
+    OSSL_PROVIDER_unload(prov);
+    OSSL_PROVIDER_unload(deflt);
+
+    printf("\n=================================\n");
+    if (failures == 0) {
+        printf("✅ Async benchmark completed (%s)\n", opts.json_path);
+        return 0;
+    }
+    printf("❌ %d benchmark(s) FAILED\n", failures);
+    return 1;
+}
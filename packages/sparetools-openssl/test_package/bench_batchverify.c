@@ -0,0 +1,248 @@
+#include <openssl/evp.h>
+#include <openssl/err.h>
+#include <openssl/rand.h>
+#include <openssl/rsa.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "bench_common.h"
+#include "sparetools_batchverify.h"
+
+/**
+ * Batch signature verification benchmark
+ *
+ * Signs a set of 64-byte messages with a few Ed25519, ECDSA P-256 and
+ * RSA-2048 (PSS) keys, corrupts every ninth signature and verifies them:
+ *
+ * - per_call: EVP_DigestVerifyInit_ex + EVP_DigestVerify per signature on
+ *   one thread, the usual pattern
+ * - batch: sparetools_batchverify_run() with 1..nproc threads
+ *
+ * Every run checks the result bitmap against the corrupted set, so the
+ * smoke run doubles as the correctness test of sparetools_batchverify.
+ * One JSON record is written per (algorithm, mode, threads).
+ *
+ * --max-threads N overrides the online CPU count as the upper bound.
+ */
+
+#define MESSAGE_SIZE 64
+#define KEYS_PER_ALG 4
+#define CORRUPT_EVERY 9
+
+typedef struct {
+    SPARETOOLS_SIG_ALG alg;
+    const char *name;
+    size_t items;        /* Signatures per run */
+    size_t quick_items;
+} algorithm;
+
+static const algorithm algorithms[] = {
+    {SPARETOOLS_SIG_ED25519, "ED25519", 4096, 256},
+    {SPARETOOLS_SIG_ECDSA_SHA256, "ECDSA-P256-SHA256", 4096, 256},
+    {SPARETOOLS_SIG_RSA_PSS_SHA256, "RSA-PSS-2048-SHA256", 2048, 128},
+};
+#define NUM_ALGORITHMS (sizeof(algorithms) / sizeof(algorithms[0]))
+
+typedef struct {
+    SPARETOOLS_VERIFY_ITEM *items;
+    unsigned char *storage;   /* Messages and signatures */
+    uint8_t *expected;
+    size_t n;
+} batch;
+
+static EVP_PKEY *make_key(SPARETOOLS_SIG_ALG alg) {
+    switch (alg) {
+    case SPARETOOLS_SIG_ED25519:
+        return EVP_PKEY_Q_keygen(NULL, NULL, "ED25519");
+    case SPARETOOLS_SIG_ECDSA_SHA256:
+        return EVP_PKEY_Q_keygen(NULL, NULL, "EC", "P-256");
+    default:
+        return EVP_PKEY_Q_keygen(NULL, NULL, "RSA", (size_t)2048);
+    }
+}
+
+static int sign(EVP_PKEY *key, SPARETOOLS_SIG_ALG alg, const unsigned char *msg,
+                unsigned char *sig, size_t *sig_len) {
+    EVP_MD_CTX *ctx = EVP_MD_CTX_new();
+    EVP_PKEY_CTX *pctx = NULL;
+    const char *md = alg == SPARETOOLS_SIG_ED25519 ? NULL : "SHA2-256";
+    int ok = ctx != NULL && EVP_DigestSignInit_ex(ctx, &pctx, md, NULL, NULL, key, NULL) == 1;
+
+    if (ok && alg == SPARETOOLS_SIG_RSA_PSS_SHA256)
+        ok = EVP_PKEY_CTX_set_rsa_padding(pctx, RSA_PKCS1_PSS_PADDING) == 1
+            && EVP_PKEY_CTX_set_rsa_pss_saltlen(pctx, RSA_PSS_SALTLEN_DIGEST) == 1;
+    ok = ok && EVP_DigestSign(ctx, sig, sig_len, msg, MESSAGE_SIZE) == 1;
+    EVP_MD_CTX_free(ctx);
+    return ok;
+}
+
+static int make_batch(const algorithm *a, EVP_PKEY **keys, size_t n, batch *b) {
+    size_t slot = MESSAGE_SIZE + 512;
+
+    b->n = n;
+    b->items = calloc(n, sizeof(*b->items));
+    b->storage = malloc(n * slot);
+    b->expected = calloc((n + 7) / 8, 1);
+    if (b->items == NULL || b->storage == NULL || b->expected == NULL)
+        return 0;
+
+    for (size_t i = 0; i < n; i++) {
+        unsigned char *msg = b->storage + i * slot;
+        unsigned char *sig = msg + MESSAGE_SIZE;
+        size_t sig_len = 512;
+        SPARETOOLS_VERIFY_ITEM *item = &b->items[i];
+
+        if (RAND_bytes(msg, MESSAGE_SIZE) != 1 || !sign(keys[i % KEYS_PER_ALG], a->alg, msg, sig, &sig_len))
+            return 0;
+        if (i % CORRUPT_EVERY == CORRUPT_EVERY - 1)
+            sig[sig_len / 2] ^= 0x01;
+        else
+            b->expected[i / 8] |= (uint8_t)(1u << (i % 8));
+
+        item->alg = a->alg;
+        item->key = keys[i % KEYS_PER_ALG];
+        item->msg = msg;
+        item->msg_len = MESSAGE_SIZE;
+        item->sig = sig;
+        item->sig_len = sig_len;
+    }
+    return 1;
+}
+
+static void free_batch(batch *b) {
+    free(b->items);
+    free(b->storage);
+    free(b->expected);
+}
+
+/* The per-signature pattern: new EVP_PKEY_CTX and verify-init every call */
+static int verify_per_call(const SPARETOOLS_VERIFY_ITEM *item, EVP_MD_CTX *ctx) {
+    EVP_PKEY_CTX *pctx = NULL;
+    const char *md = item->alg == SPARETOOLS_SIG_ED25519 ? NULL : "SHA2-256";
+    int ok = EVP_DigestVerifyInit_ex(ctx, &pctx, md, NULL, NULL, item->key, NULL) == 1;
+
+    if (ok && item->alg == SPARETOOLS_SIG_RSA_PSS_SHA256)
+        ok = EVP_PKEY_CTX_set_rsa_padding(pctx, RSA_PKCS1_PSS_PADDING) == 1
+            && EVP_PKEY_CTX_set_rsa_pss_saltlen(pctx, RSA_PSS_SALTLEN_DIGEST) == 1;
+    ok = ok && EVP_DigestVerify(ctx, item->sig, item->sig_len, item->msg, item->msg_len) == 1;
+    EVP_MD_CTX_reset(ctx);
+    ERR_clear_error();
+    return ok;
+}
+
+/* 1, 2, 4, ... max_threads, then 0 */
+static int next_thread_count(int n, int max) {
+    if (n >= max)
+        return 0;
+    return n * 2 > max ? max : n * 2;
+}
+
+static void report(bench_json *json, const char *alg, const char *mode, int threads,
+                   size_t n, double rate, int correct) {
+    printf("  %-20s %-9s %7d %14.0f %s\n", alg, mode, threads, rate, correct ? "" : "  WRONG BITMAP");
+    bench_json_record_begin(json);
+    bench_json_str(json, "algorithm", alg);
+    bench_json_str(json, "mode", mode);
+    bench_json_int(json, "threads", (uint64_t)threads);
+    bench_json_int(json, "items", (uint64_t)n);
+    bench_json_num(json, "verifies_per_sec", rate);
+    bench_json_int(json, "correct", (uint64_t)correct);
+    bench_json_record_end(json);
+}
+
+int main(int argc, char **argv) {
+    bench_options opts;
+    bench_json json;
+    int failures = 0, max_threads;
+    long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+    int argi = bench_parse_args(argc, argv, "bench_batchverify.json", &opts);
+
+    if (argi < 0)
+        return 2;
+    max_threads = ncpu > 0 ? (int)ncpu : 1;
+    for (; argi < argc; argi++) {
+        if (strcmp(argv[argi], "--max-threads") == 0 && argi + 1 < argc) {
+            max_threads = atoi(argv[++argi]);
+        } else {
+            fprintf(stderr, "Usage: %s [--quick] [--json PATH] [--max-threads N]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (max_threads < 1)
+        max_threads = 1;
+    if (opts.quick && max_threads > 4)
+        max_threads = 4;
+
+    printf("=================================\n");
+    printf("Batch Signature Verification Benchmark\n");
+    printf("=================================\n");
+    printf("OpenSSL version: %s\n\n", OpenSSL_version(OPENSSL_VERSION));
+    if (bench_json_begin(&json, &opts, "batchverify") != 0)
+        return 1;
+
+    printf("  %-20s %-9s %7s %14s\n", "Algorithm", "Mode", "Threads", "verifies/s");
+    for (size_t a = 0; a < NUM_ALGORITHMS; a++) {
+        const algorithm *alg = &algorithms[a];
+        size_t n = opts.quick ? alg->quick_items : alg->items;
+        EVP_PKEY *keys[KEYS_PER_ALG] = {NULL};
+        uint8_t *bitmap = malloc((n + 7) / 8);
+        EVP_MD_CTX *ctx = EVP_MD_CTX_new();
+        batch b = {0};
+        int ok = bitmap != NULL && ctx != NULL;
+
+        for (int k = 0; ok && k < KEYS_PER_ALG; k++)
+            ok = (keys[k] = make_key(alg->alg)) != NULL;
+        if (!ok || !make_batch(alg, keys, n, &b)) {
+            printf("  %-20s not available, skipping\n", alg->name);
+            ERR_clear_error();
+        } else {
+            double start, elapsed;
+            size_t valid;
+
+            memset(bitmap, 0, (n + 7) / 8);
+            start = bench_now();
+            for (size_t i = 0; i < n; i++)
+                if (verify_per_call(&b.items[i], ctx))
+                    bitmap[i / 8] |= (uint8_t)(1u << (i % 8));
+            elapsed = bench_now() - start;
+            ok = memcmp(bitmap, b.expected, (n + 7) / 8) == 0;
+            failures += !ok;
+            report(&json, alg->name, "per_call", 1, n, n / elapsed, ok);
+
+            for (int threads = 1; threads != 0; threads = next_thread_count(threads, max_threads)) {
+                SPARETOOLS_BATCHVERIFY *verifier = sparetools_batchverify_new(NULL, NULL, threads);
+                int rounds = 0;
+
+                if (verifier == NULL) {
+                    failures++;
+                    break;
+                }
+                /* First batch fills the context caches, like a long-running service */
+                valid = sparetools_batchverify_run(verifier, b.items, n, bitmap);
+                ok = valid == n - n / CORRUPT_EVERY && memcmp(bitmap, b.expected, (n + 7) / 8) == 0;
+                start = bench_now();
+                do {
+                    valid = sparetools_batchverify_run(verifier, b.items, n, bitmap);
+                    ok = ok && memcmp(bitmap, b.expected, (n + 7) / 8) == 0;
+                    rounds++;
+                    elapsed = bench_now() - start;
+                } while (elapsed < opts.min_seconds);
+                failures += !ok;
+                report(&json, alg->name, "batch", threads, n, (double)n * rounds / elapsed, ok);
+                sparetools_batchverify_free(verifier);
+            }
+        }
+
+        free_batch(&b);
+        for (int k = 0; k < KEYS_PER_ALG; k++)
+            EVP_PKEY_free(keys[k]);
+        EVP_MD_CTX_free(ctx);
+        free(bitmap);
+    }
+
+    bench_json_end(&json);
+    printf("\n%s\n", failures ? "✗ Batch verification results differ" : "✓ Batch bitmaps match");
+    return failures ? 1 : 0;
+}
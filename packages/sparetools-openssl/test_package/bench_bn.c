@@ -0,0 +1,398 @@
+#include <openssl/bn.h>
+#include <openssl/core_names.h>
+#include <openssl/crypto.h>
+#include <openssl/err.h>
+#include <openssl/evp.h>
+#include <openssl/pem.h>
+#include <openssl/rsa.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "bench_common.h"
+
+/**
+ * Bignum micro-benchmarks per assembly code path
+ *
+ * Measures, at 2048, 3072 and 4096 bits (2048 only with --quick):
+ *
+ * - mod_exp:    BN_mod_exp_mont_consttime, full-size exponent and modulus
+ * - mont_mul:   BN_mod_mul_montgomery
+ * - rand_range: BN_rand_range below the modulus
+ * - prime_gen:  BN_generate_prime_ex2 of a bits/2 prime, as RSA keygen does
+ * - rsa_sign:   RSA private operation (CRT, blinding, PKCS#1 v1.5) on a
+ *               SHA-256 digest
+ *
+ * The x86_64 code paths are selected at run time from OPENSSL_ia32cap, so
+ * like bench_cpu_dispatch the benchmark re-runs itself with the features
+ * masked one step at a time:
+ *
+ * - all:     everything the CPU has (AVX-512 IFMA RSAZ where supported)
+ * - no-ifma: without AVX-512 IFMA, i.e. ADX/MULX Montgomery code
+ * - no-adx:  also without ADX and BMI2 (AVX2 RSAZ for 1024-bit halves)
+ * - scalar:  also without AVX2, the plain 64-bit Montgomery code
+ *
+ * On AArch64, "no-neon" clears OPENSSL_armcap. Profiles whose feature the
+ * CPU lacks are skipped. RSA keys are generated once by the parent and
+ * passed to each run, so slow keygen is paid only once. Which sizes use
+ * which path depends on the release (e.g. IFMA RSA-3072/4096 arrived in
+ * 3.2), so compare packages of each release and their cpu_tuning and
+ * enable_asm settings on the same host.
+ */
+
+#define MAX_BITS 4096
+#define PRIME_MIN_RUNS 3
+
+static const int all_bits[] = {2048, 3072, 4096};
+#define NUM_BITS (sizeof(all_bits) / sizeof(all_bits[0]))
+
+typedef struct {
+    const char *name;
+    const char *mask;
+    const char *feature;   /* Feature the profile removes, NULL for all */
+    int word;              /* Location of the feature in the unmasked vector */
+    int bit;
+} cap_profile;
+
+#if defined(__x86_64__) || defined(_M_X64)
+# define CAP_ENV "OPENSSL_ia32cap"
+/*
+ * Word 1 is CPUID.7 EBX:ECX. EBX bits: 5 AVX2, 8 BMI2, 19 ADX, 21
+ * AVX512IFMA. Each profile also clears what the previous one cleared.
+ */
+static const cap_profile profiles[] = {
+    {"all", NULL, NULL, 0, 0},
+    {"no-ifma", ":~0x200000", "AVX-512 IFMA", 1, 21},
+    {"no-adx", ":~0x280100", "ADX/MULX", 1, 19},
+    {"scalar", ":~0x280120", "AVX2", 1, 5},
+};
+#elif defined(__aarch64__) || defined(_M_ARM64)
+# define CAP_ENV "OPENSSL_armcap"
+static const cap_profile profiles[] = {
+    {"all", NULL, NULL, 0, 0},
+    {"no-neon", "0x0", "NEON", 0, 0},
+};
+#else
+# define CAP_ENV ""
+static const cap_profile profiles[] = {
+    {"all", NULL, NULL, 0, 0},
+};
+#endif
+#define NUM_PROFILES (sizeof(profiles) / sizeof(profiles[0]))
+
+typedef struct {
+    int bits;
+    EVP_PKEY *pkey;
+    EVP_PKEY_CTX *sign_ctx;
+    BN_CTX *ctx;
+    BN_MONT_CTX *mont;
+    BIGNUM *m, *a, *b, *p, *r;
+    unsigned char digest[32];
+    unsigned char sig[MAX_BITS / 8];
+} bn_state;
+
+typedef int (*bn_op)(bn_state *s);
+
+static int op_mod_exp(bn_state *s) {
+    return BN_mod_exp_mont_consttime(s->r, s->a, s->p, s->m, s->ctx, s->mont);
+}
+
+static int op_mont_mul(bn_state *s) {
+    return BN_mod_mul_montgomery(s->r, s->a, s->b, s->mont, s->ctx);
+}
+
+static int op_rand_range(bn_state *s) {
+    return BN_rand_range(s->r, s->m);
+}
+
+static int op_prime_gen(bn_state *s) {
+    return BN_generate_prime_ex2(s->r, s->bits / 2, 0, NULL, NULL, NULL, s->ctx);
+}
+
+static int op_rsa_sign(bn_state *s) {
+    size_t len = sizeof(s->sig);
+
+    return EVP_PKEY_sign(s->sign_ctx, s->sig, &len, s->digest, sizeof(s->digest)) == 1;
+}
+
+typedef struct {
+    const char *name;
+    bn_op op;
+    int min_runs;
+} bn_workload;
+
+static const bn_workload workloads[] = {
+    {"mod_exp", op_mod_exp, 1},
+    {"mont_mul", op_mont_mul, 1},
+    {"rand_range", op_rand_range, 1},
+    {"prime_gen", op_prime_gen, PRIME_MIN_RUNS},
+    {"rsa_sign", op_rsa_sign, 1},
+};
+#define NUM_WORKLOADS (sizeof(workloads) / sizeof(workloads[0]))
+
+/** Capability string reported by the library ("" if unavailable) */
+static const char *cpu_info(void) {
+#ifdef OPENSSL_CPU_INFO
+    return OpenSSL_version(OPENSSL_CPU_INFO);
+#else
+    return "";
+#endif
+}
+
+static int parse_caps(const char *info, unsigned long long caps[2]) {
+    const char *p;
+
+    caps[0] = caps[1] = 0;
+    if (CAP_ENV[0] == '\0' || (p = strstr(info, CAP_ENV "=")) == NULL)
+        return 0;
+    p += strlen(CAP_ENV "=");
+    return sscanf(p, "0x%llx:0x%llx", &caps[0], &caps[1]) >= 1;
+}
+
+static void state_free(bn_state *s) {
+    EVP_PKEY_CTX_free(s->sign_ctx);
+    BN_MONT_CTX_free(s->mont);
+    BN_free(s->m);
+    BN_free(s->a);
+    BN_free(s->b);
+    BN_free(s->p);
+    BN_free(s->r);
+    BN_CTX_free(s->ctx);
+}
+
+/* Operands derived from the RSA modulus of pkey */
+static int state_init(bn_state *s, EVP_PKEY *pkey) {
+    memset(s, 0, sizeof(*s));
+    s->pkey = pkey;
+    s->bits = EVP_PKEY_get_bits(pkey);
+    memset(s->digest, 0x5a, sizeof(s->digest));
+    return (s->ctx = BN_CTX_new()) != NULL
+        && EVP_PKEY_get_bn_param(pkey, OSSL_PKEY_PARAM_RSA_N, &s->m)
+        && (s->a = BN_new()) != NULL && BN_rand_range(s->a, s->m)
+        && (s->b = BN_new()) != NULL && BN_rand_range(s->b, s->m)
+        && (s->p = BN_new()) != NULL && BN_rand(s->p, s->bits, BN_RAND_TOP_ONE, BN_RAND_BOTTOM_ANY)
+        && (s->r = BN_new()) != NULL
+        && (s->mont = BN_MONT_CTX_new()) != NULL && BN_MONT_CTX_set(s->mont, s->m, s->ctx)
+        && (s->sign_ctx = EVP_PKEY_CTX_new_from_pkey(NULL, pkey, NULL)) != NULL
+        && EVP_PKEY_sign_init(s->sign_ctx) == 1
+        && EVP_PKEY_CTX_set_rsa_padding(s->sign_ctx, RSA_PKCS1_PADDING) == 1
+        && EVP_PKEY_CTX_set_signature_md(s->sign_ctx, EVP_sha256()) == 1;
+}
+
+/** Operations per second, negative on failure */
+static double measure(const bn_workload *wl, bn_state *s, double min_seconds) {
+    unsigned long long runs = 0;
+    double start, elapsed;
+
+    if (!wl->op(s))
+        return -1.0;
+    start = bench_now();
+    do {
+        if (!wl->op(s))
+            return -1.0;
+        runs++;
+        elapsed = bench_now() - start;
+    } while (elapsed < min_seconds || runs < (unsigned long long)wl->min_runs);
+    return (double)runs / elapsed;
+}
+
+/** Child mode: "workload bits ops_per_s" per line for every key in keys_path */
+static int run_measure(const char *keys_path, double min_seconds, int min_prime_runs) {
+    FILE *fp = fopen(keys_path, "r");
+    EVP_PKEY *pkey;
+    int status = 0;
+
+    if (fp == NULL)
+        return 1;
+    printf("%s\n", cpu_info());
+    while (status == 0 && (pkey = PEM_read_PrivateKey(fp, NULL, NULL, NULL)) != NULL) {
+        bn_state s;
+
+        if (!state_init(&s, pkey)) {
+            status = 1;
+        } else {
+            for (size_t w = 0; w < NUM_WORKLOADS && status == 0; w++) {
+                bn_workload wl = workloads[w];
+                double rate;
+
+                if (wl.min_runs > 1)
+                    wl.min_runs = min_prime_runs;
+                if ((rate = measure(&wl, &s, min_seconds)) < 0)
+                    status = 1;
+                else
+                    printf("%s %d %.6f\n", wl.name, s.bits, rate);
+                fflush(stdout);
+            }
+        }
+        state_free(&s);
+        EVP_PKEY_free(pkey);
+    }
+    fclose(fp);
+    ERR_clear_error();
+    if (status != 0)
+        ERR_print_errors_fp(stderr);
+    return status;
+}
+
+/* rates[bits index][workload], 0 where not measured */
+typedef double profile_rates[NUM_BITS][NUM_WORKLOADS];
+
+static int run_profile(const char *self, const bench_options *opts, const char *mask, const char *keys_path,
+                       char *info, size_t info_len, profile_rates rates) {
+    char cmd[4096], line[512];
+    FILE *child;
+
+    if (mask != NULL)
+        setenv(CAP_ENV, mask, 1);
+    snprintf(cmd, sizeof(cmd), "\"%s\" %s--measure \"%s\"", self, opts->quick ? "--quick " : "", keys_path);
+    child = popen(cmd, "r");
+    if (mask != NULL)
+        unsetenv(CAP_ENV);
+    if (child == NULL)
+        return 1;
+
+    if (fgets(info, (int)info_len, child) != NULL)
+        info[strcspn(info, "\n")] = '\0';
+    while (fgets(line, sizeof(line), child) != NULL) {
+        char name[64];
+        int bits;
+        double rate;
+
+        if (sscanf(line, "%63s %d %lf", name, &bits, &rate) != 3)
+            continue;
+        for (size_t b = 0; b < NUM_BITS; b++) {
+            for (size_t w = 0; w < NUM_WORKLOADS; w++) {
+                if (all_bits[b] == bits && strcmp(name, workloads[w].name) == 0)
+                    rates[b][w] = rate;
+            }
+        }
+    }
+    return pclose(child) != 0;
+}
+
+/* Generate one RSA key per size into a temporary PEM file */
+static int write_keys(const int *bits, size_t num_bits, char *path, size_t path_len) {
+    const char *tmp = getenv("TMPDIR");
+    FILE *fp;
+    int fd, ok = 1;
+
+    snprintf(path, path_len, "%s/bench_bn_keys_XXXXXX", tmp != NULL && *tmp ? tmp : "/tmp");
+    if ((fd = mkstemp(path)) < 0 || (fp = fdopen(fd, "w")) == NULL)
+        return 0;
+    for (size_t i = 0; i < num_bits && ok; i++) {
+        EVP_PKEY *pkey = EVP_PKEY_Q_keygen(NULL, NULL, "RSA", (size_t)bits[i]);
+
+        ok = pkey != NULL && PEM_write_PrivateKey(fp, pkey, NULL, NULL, 0, NULL, NULL);
+        EVP_PKEY_free(pkey);
+    }
+    return fclose(fp) == 0 && ok;
+}
+
+int main(int argc, char **argv) {
+    bench_options opts;
+    bench_json json;
+    profile_rates base = {{0}};
+    unsigned long long caps[2];
+    char info[512], keys_path[1024];
+    const char *measure_keys = NULL;
+    int selected_bits[NUM_BITS];
+    size_t num_selected = 0;
+    int failures = 0, argi, have_caps, only_bits = 0;
+
+    argi = bench_parse_args(argc, argv, "bench_bn.json", &opts);
+    if (argi < 0)
+        return 2;
+    for (; argi < argc; argi++) {
+        if (strcmp(argv[argi], "--measure") == 0 && argi + 1 < argc) {
+            measure_keys = argv[++argi];
+        } else if (strcmp(argv[argi], "--bits") == 0 && argi + 1 < argc) {
+            only_bits = atoi(argv[++argi]);
+        } else {
+            fprintf(stderr, "Usage: %s [--quick] [--json PATH] [--bits 2048|3072|4096]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (measure_keys != NULL)
+        return run_measure(measure_keys, opts.min_seconds, opts.quick ? 1 : PRIME_MIN_RUNS);
+
+    for (size_t b = 0; b < NUM_BITS; b++) {
+        if (only_bits ? all_bits[b] == only_bits : (!opts.quick || all_bits[b] == 2048))
+            selected_bits[num_selected++] = all_bits[b];
+    }
+    if (num_selected == 0) {
+        fprintf(stderr, "ERROR: --bits must be 2048, 3072 or 4096\n");
+        return 2;
+    }
+
+    printf("=================================\n");
+    printf("Bignum and RSA Benchmark\n");
+    printf("=================================\n");
+    printf("OpenSSL version: %s\n", OpenSSL_version(OPENSSL_VERSION));
+    printf("%s\n", cpu_info()[0] ? cpu_info() : "⚠ OPENSSL_CPU_INFO not available");
+    have_caps = parse_caps(cpu_info(), caps);
+    printf("\n");
+
+    printf("Generating RSA keys...\n");
+    if (!write_keys(selected_bits, num_selected, keys_path, sizeof(keys_path))) {
+        fprintf(stderr, "ERROR: RSA key generation failed\n");
+        ERR_print_errors_fp(stderr);
+        return 1;
+    }
+    if (bench_json_begin(&json, &opts, "bn") != 0) {
+        unlink(keys_path);
+        return 1;
+    }
+
+    for (size_t p = 0; p < NUM_PROFILES; p++) {
+        const cap_profile *profile = &profiles[p];
+        profile_rates rates = {{0}};
+
+        if (profile->feature != NULL && (!have_caps || !((caps[profile->word] >> profile->bit) & 1))) {
+            printf("%-8s skipped: %s not present\n\n", profile->name, profile->feature);
+            continue;
+        }
+        if (run_profile(argv[0], &opts, profile->mask, keys_path, info, sizeof(info), rates) != 0) {
+            fprintf(stderr, "ERROR: Measurement failed for profile %s\n", profile->name);
+            failures++;
+            continue;
+        }
+        if (p == 0)
+            memcpy(base, rates, sizeof(base));
+
+        printf("%-8s %s\n", profile->name, profile->mask ? profile->mask : "(unmasked)");
+        printf("  %-11s %5s %14s %12s %9s\n", "Operation", "Bits", "ops/s", "us/op", "vs all");
+        for (size_t b = 0; b < NUM_BITS; b++) {
+            for (size_t w = 0; w < NUM_WORKLOADS; w++) {
+                double rate = rates[b][w];
+                double relative = rate > 0 && base[b][w] > 0 ? base[b][w] / rate : 0.0;
+
+                if (rate <= 0)
+                    continue;
+                printf("  %-11s %5d %14.1f %12.1f %8.2fx\n", workloads[w].name, all_bits[b], rate, 1e6 / rate,
+                       relative);
+                bench_json_record_begin(&json);
+                bench_json_str(&json, "profile", profile->name);
+                bench_json_str(&json, "mask", profile->mask ? profile->mask : "");
+                bench_json_str(&json, "cpu_info", info);
+                bench_json_str(&json, "operation", workloads[w].name);
+                bench_json_int(&json, "bits", (uint64_t)all_bits[b]);
+                bench_json_num(&json, "ops_per_s", rate);
+                bench_json_num(&json, "us_per_op", 1e6 / rate);
+                bench_json_num(&json, "speedup_unmasked", relative);
+                bench_json_record_end(&json);
+            }
+        }
+        printf("\n");
+    }
+    bench_json_end(&json);
+    unlink(keys_path);
+
+    printf("=================================\n");
+    if (failures == 0) {
+        printf("✅ Bignum benchmark completed (%s)\n", opts.json_path);
+        return 0;
+    }
+    printf("❌ %d profile(s) FAILED\n", failures);
+    return 1;
+}
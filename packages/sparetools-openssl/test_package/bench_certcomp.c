@@ -0,0 +1,384 @@
+#include <openssl/ssl.h>
+#include <openssl/err.h>
+#include <openssl/rand.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench_common.h"
+#include "bench_tls.h"
+#include "bench_x509.h"
+
+/**
+ * TLS certificate compression benchmark (RFC 8879, OpenSSL 3.2+)
+ *
+ * The server sends a chain shaped like a public web PKI one: an RSA-2048
+ * leaf with 40 DNS subjectAltNames and three embedded SCTs (random log
+ * IDs and signatures, so they compress as badly as real ones), plus two
+ * RSA-2048 intermediates. Handshakes run over a BIO pair with each of:
+ * - none:    certificate compression disabled
+ * - zlib, brotli, zstd, each
+ *   - precompressed: SSL_CTX_compress_certs() once at start-up
+ *   - on-the-fly:    compressed again in every handshake
+ *
+ * Per case it reports the server's first flight (ServerHello to Finished;
+ * no session tickets are sent), the TCP segments and slow-start round
+ * trips that flight needs with a 10-segment initial window, handshakes/s,
+ * and the server and client CPU time per handshake (thread CPU time of
+ * their SSL_do_handshake calls, so the client figure includes the
+ * decompression). Compressors the library was built without (no brotli,
+ * zstd or zlib support, or OpenSSL before 3.2) are recorded with
+ * "available": 0; the sparetools-openssl enable_zlib, enable_brotli and
+ * enable_zstd options provide them.
+ */
+
+#define NUM_SANS 40
+#define NUM_SCTS 3
+#define MSS 1460
+#define INITCWND_SEGMENTS 10
+
+typedef struct {
+    const char *name;
+    int alg;                        /* TLSEXT_comp_cert_* (0: none) */
+} compressor;
+
+#if OPENSSL_VERSION_NUMBER >= 0x30200000L
+#define HAVE_CERT_COMP 1
+static const compressor compressors[] = {
+    {"none", TLSEXT_comp_cert_none},
+    {"zlib", TLSEXT_comp_cert_zlib},
+    {"brotli", TLSEXT_comp_cert_brotli},
+    {"zstd", TLSEXT_comp_cert_zstd},
+};
+#else
+#define HAVE_CERT_COMP 0
+static const compressor compressors[] = {
+    {"none", 0},
+    {"zlib", 1},
+    {"brotli", 2},
+    {"zstd", 3},
+};
+#endif
+#define NUM_COMPRESSORS (sizeof(compressors) / sizeof(compressors[0]))
+
+typedef struct {
+    EVP_PKEY *key;
+    X509 *leaf;
+    STACK_OF(X509) *chain;          /* Intermediates, issuing first */
+} server_chain;
+
+/** signedCertificateTimestampList of NUM_SCTS v1 SCTs with random contents */
+static int add_scts(X509 *leaf) {
+    /* Per SCT: version, log ID, timestamp, no extensions, ECDSA-SHA256 signature */
+    enum { SIG_LEN = 71, SCT_LEN = 1 + 32 + 8 + 2 + 4 + SIG_LEN };
+    unsigned char list[2 + NUM_SCTS * (2 + SCT_LEN)], *p = list + 2;
+    ASN1_OCTET_STRING *inner = ASN1_OCTET_STRING_new(), *value = ASN1_OCTET_STRING_new();
+    ASN1_OBJECT *obj = OBJ_txt2obj("1.3.6.1.4.1.11129.2.4.2", 1);
+    X509_EXTENSION *ext = NULL;
+    unsigned char *der = NULL;
+    int der_len, ok = 0;
+
+    list[0] = (unsigned char)((sizeof(list) - 2) >> 8);
+    list[1] = (unsigned char)(sizeof(list) - 2);
+    for (int i = 0; i < NUM_SCTS; i++, p += 2 + SCT_LEN) {
+        p[0] = 0;
+        p[1] = SCT_LEN;
+        if (RAND_bytes(p + 2, SCT_LEN) != 1)
+            goto done;
+        p[2] = 0;                                   /* v1 */
+        p[2 + 41] = p[2 + 42] = 0;                  /* No extensions */
+        p[2 + 43] = 4;                              /* sha256 */
+        p[2 + 44] = 3;                              /* ecdsa */
+        p[2 + 45] = 0;
+        p[2 + 46] = SIG_LEN;
+    }
+    /* The extension value is an OCTET STRING wrapping the TLS-encoded list */
+    if (inner == NULL || value == NULL || obj == NULL
+        || !ASN1_OCTET_STRING_set(inner, list, sizeof(list))
+        || (der_len = i2d_ASN1_OCTET_STRING(inner, &der)) <= 0
+        || !ASN1_OCTET_STRING_set(value, der, der_len)
+        || (ext = X509_EXTENSION_create_by_OBJ(NULL, obj, 0, value)) == NULL)
+        goto done;
+    ok = X509_add_ext(leaf, ext, -1);
+done:
+    OPENSSL_free(der);
+    X509_EXTENSION_free(ext);
+    ASN1_OBJECT_free(obj);
+    ASN1_OCTET_STRING_free(inner);
+    ASN1_OCTET_STRING_free(value);
+    return ok;
+}
+
+static void free_chain(server_chain *c) {
+    EVP_PKEY_free(c->key);
+    X509_free(c->leaf);
+    sk_X509_pop_free(c->chain, X509_free);
+    memset(c, 0, sizeof(*c));
+}
+
+/** Root, policy and issuing CA, and a leaf issued by the latter. Returns 0 on success. */
+static int make_chain(server_chain *c) {
+    EVP_PKEY *root_key = bench_x509_keygen("RSA");
+    EVP_PKEY *policy_key = bench_x509_keygen("RSA");
+    EVP_PKEY *issuing_key = bench_x509_keygen("RSA");
+    X509 *root = NULL, *policy = NULL, *issuing = NULL;
+    char sans[NUM_SANS * 48] = "";
+    size_t len = 0;
+    int ok = 0;
+
+    memset(c, 0, sizeof(*c));
+    c->key = bench_x509_keygen("RSA");
+    for (int i = 0; i < NUM_SANS; i++)
+        len += (size_t)snprintf(sans + len, sizeof(sans) - len, "%sDNS:edge-%02d.cdn.bench.sparetools.example",
+                                i ? "," : "", i);
+    if (root_key == NULL || policy_key == NULL || issuing_key == NULL || c->key == NULL
+        || (c->chain = sk_X509_new_null()) == NULL
+        || (root = bench_x509_make_cert(root_key, "SpareTools Bench Root CA", NULL, root_key,
+                                        EVP_sha256(), 1, 1)) == NULL
+        || (policy = bench_x509_make_cert(policy_key, "SpareTools Bench Policy CA", root, root_key,
+                                          EVP_sha256(), 1, 2)) == NULL
+        || (issuing = bench_x509_make_cert(issuing_key, "SpareTools Bench Issuing CA", policy, policy_key,
+                                           EVP_sha256(), 1, 3)) == NULL
+        || (c->leaf = bench_x509_make_cert(c->key, "www.bench.sparetools.example", issuing, issuing_key,
+                                           EVP_sha256(), 0, 4)) == NULL
+        /* Re-signed after the extensions a public CA adds */
+        || !bench_x509_add_ext(c->leaf, NULL, NID_subject_alt_name, sans)
+        || !add_scts(c->leaf)
+        || !X509_sign(c->leaf, issuing_key, EVP_sha256())
+        || !sk_X509_push(c->chain, issuing))
+        goto done;
+    issuing = NULL;
+    if (!sk_X509_push(c->chain, policy))
+        goto done;
+    policy = NULL;
+    ok = 1;
+done:
+    if (!ok) {
+        fprintf(stderr, "ERROR: Failed to create the server chain\n");
+        ERR_print_errors_fp(stderr);
+        free_chain(c);
+    }
+    X509_free(root);
+    X509_free(policy);
+    X509_free(issuing);
+    EVP_PKEY_free(root_key);
+    EVP_PKEY_free(policy_key);
+    EVP_PKEY_free(issuing_key);
+    return ok ? 0 : 1;
+}
+
+/** Client/server SSL_CTX pair with the chain on the server, no tickets */
+static int make_ctx_pair(const server_chain *c, SSL_CTX **client_out, SSL_CTX **server_out) {
+    if (bench_tls_make_ctx_pair(c->key, c->leaf, client_out, server_out) != 0)
+        return 1;
+    if (SSL_CTX_set1_chain(*server_out, c->chain) != 1
+        || SSL_CTX_set_num_tickets(*server_out, 0) != 1) {
+        SSL_CTX_free(*client_out);
+        SSL_CTX_free(*server_out);
+        return 1;
+    }
+    return 0;
+}
+
+/**
+ * Configure both ends for one compressor; precompress: compress the
+ * chain once now, otherwise libssl compresses it in every handshake.
+ * Returns 0 when the library cannot use the algorithm.
+ */
+static int set_compressor(const server_chain *chain, SSL_CTX *client_ctx, SSL_CTX *server_ctx,
+                          const compressor *comp, int precompress) {
+#if HAVE_CERT_COMP
+    SSL_CTX *probe_client, *probe_server;
+    int pref[1], available;
+
+    if (comp->alg == TLSEXT_comp_cert_none) {
+        SSL_CTX_set_options(server_ctx, SSL_OP_NO_TX_CERTIFICATE_COMPRESSION);
+        SSL_CTX_set_options(client_ctx, SSL_OP_NO_RX_CERTIFICATE_COMPRESSION);
+        return 1;
+    }
+    /* Compressing fails when the algorithm is not built in; probe on a scratch pair */
+    if (make_ctx_pair(chain, &probe_client, &probe_server) != 0)
+        return 0;
+    available = SSL_CTX_compress_certs(probe_server, comp->alg);
+    SSL_CTX_free(probe_client);
+    SSL_CTX_free(probe_server);
+    pref[0] = comp->alg;
+    if (!available
+        || !SSL_CTX_set1_cert_comp_preference(server_ctx, pref, 1)
+        || !SSL_CTX_set1_cert_comp_preference(client_ctx, pref, 1)
+        || (precompress && !SSL_CTX_compress_certs(server_ctx, comp->alg))) {
+        ERR_clear_error();
+        return 0;
+    }
+    return 1;
+#else
+    (void)chain;
+    (void)client_ctx;
+    (void)server_ctx;
+    (void)precompress;
+    return comp->alg == 0;
+#endif
+}
+
+/* Handshake step with its CPU time added to arg[is_server] (client, server seconds) */
+static int timed_step(SSL *ssl, int is_server, void *arg) {
+    double *cpu = (double *)arg + is_server;
+    double t0 = bench_cpu_now();
+    int ret = SSL_do_handshake(ssl);
+
+    *cpu += bench_cpu_now() - t0;
+    return ret;
+}
+
+typedef struct {
+    size_t handshakes;
+    double elapsed;
+    double client_cpu_us;
+    double server_cpu_us;
+    double server_flight;           /* Bytes the server wrote per handshake */
+    double client_flight;
+} run_stats;
+
+static int run_handshakes(SSL_CTX *client_ctx, SSL_CTX *server_ctx, double min_seconds, run_stats *stats) {
+    double start = bench_now(), cpu[2] = {0.0, 0.0};
+    uint64_t server_bytes = 0, client_bytes = 0;
+
+    memset(stats, 0, sizeof(*stats));
+    do {
+        SSL *client, *server;
+        int ok;
+
+        if (bench_tls_make_ssl_pair(client_ctx, server_ctx, &client, &server) != 0)
+            return 1;
+        ok = bench_tls_handshake_ex(client, server, timed_step, cpu);
+        server_bytes += BIO_number_written(SSL_get_wbio(server));
+        client_bytes += BIO_number_written(SSL_get_wbio(client));
+        bench_tls_free_pair(client, server);
+        if (!ok)
+            return 1;
+        stats->handshakes++;
+        stats->elapsed = bench_now() - start;
+    } while (stats->elapsed < min_seconds || stats->handshakes < 10);
+
+    stats->client_cpu_us = cpu[0] * 1e6 / (double)stats->handshakes;
+    stats->server_cpu_us = cpu[1] * 1e6 / (double)stats->handshakes;
+    stats->server_flight = (double)server_bytes / (double)stats->handshakes;
+    stats->client_flight = (double)client_bytes / (double)stats->handshakes;
+    return 0;
+}
+
+/** Slow-start round trips beyond the first needed to send bytes */
+static int extra_round_trips(double bytes) {
+    double cwnd = INITCWND_SEGMENTS * MSS, sent = cwnd;
+    int rtts = 0;
+
+    while (sent < bytes) {
+        cwnd *= 2;
+        sent += cwnd;
+        rtts++;
+    }
+    return rtts;
+}
+
+int main(int argc, char **argv) {
+    bench_options opts;
+    bench_json json;
+    server_chain chain;
+    size_t chain_bytes;
+    double none_server_flight = 0.0;
+    int failures = 0;
+    int argi = bench_parse_args(argc, argv, "bench_certcomp.json", &opts);
+
+    if (argi < 0)
+        return 2;
+    if (argi < argc) {
+        fprintf(stderr, "Usage: %s [--quick] [--json PATH]\n", argv[0]);
+        return 2;
+    }
+
+    printf("=================================\n");
+    printf("OpenSSL Certificate Compression Benchmark\n");
+    printf("=================================\n");
+    printf("OpenSSL version: %s\n", OpenSSL_version(OPENSSL_VERSION));
+    if (!HAVE_CERT_COMP)
+        printf("⚠ Certificate compression needs OpenSSL 3.2+, measuring uncompressed only\n");
+
+    if (make_chain(&chain) != 0)
+        return 1;
+    chain_bytes = (size_t)i2d_X509(chain.leaf, NULL);
+    for (int i = 0; i < sk_X509_num(chain.chain); i++)
+        chain_bytes += (size_t)i2d_X509(sk_X509_value(chain.chain, i), NULL);
+    printf("Server chain: %d certificates, %zu bytes DER (%d SANs, %d SCTs)\n\n",
+           1 + sk_X509_num(chain.chain), chain_bytes, NUM_SANS, NUM_SCTS);
+
+    if (bench_json_begin(&json, &opts, "certcomp") != 0) {
+        free_chain(&chain);
+        return 1;
+    }
+
+    for (size_t c = 0; c < NUM_COMPRESSORS; c++) {
+        for (int precompress = 1; precompress >= 0; precompress--) {
+            const char *mode = compressors[c].alg == 0 ? "uncompressed"
+                : precompress ? "precompressed" : "on-the-fly";
+            SSL_CTX *client_ctx, *server_ctx;
+            run_stats stats;
+            int available;
+
+            /* "none" has a single mode */
+            if (compressors[c].alg == 0 && !precompress)
+                continue;
+            if (make_ctx_pair(&chain, &client_ctx, &server_ctx) != 0) {
+                failures++;
+                continue;
+            }
+            available = set_compressor(&chain, client_ctx, server_ctx, &compressors[c], precompress);
+            bench_json_record_begin(&json);
+            bench_json_str(&json, "algorithm", compressors[c].name);
+            bench_json_str(&json, "mode", mode);
+            bench_json_int(&json, "available", (uint64_t)available);
+            bench_json_int(&json, "chain_bytes", chain_bytes);
+            if (!available) {
+                printf("  %-7s %-14s not available in this build\n", compressors[c].name, mode);
+            } else if (run_handshakes(client_ctx, server_ctx, opts.min_seconds, &stats) != 0) {
+                fprintf(stderr, "ERROR: %s %s handshake failed\n", compressors[c].name, mode);
+                ERR_print_errors_fp(stderr);
+                failures++;
+            } else {
+                int segments = (int)((stats.server_flight + MSS - 1) / MSS);
+
+                if (compressors[c].alg == 0)
+                    none_server_flight = stats.server_flight;
+                printf("  %-7s %-14s server flight %6.0f B (%2d segments, +%d RTT)  %8.1f hs/s"
+                       "  server %7.1f us  client %7.1f us\n",
+                       compressors[c].name, mode, stats.server_flight, segments,
+                       extra_round_trips(stats.server_flight), (double)stats.handshakes / stats.elapsed,
+                       stats.server_cpu_us, stats.client_cpu_us);
+                bench_json_num(&json, "server_flight_bytes", stats.server_flight);
+                bench_json_num(&json, "client_flight_bytes", stats.client_flight);
+                if (none_server_flight > 0)
+                    bench_json_num(&json, "flight_ratio", stats.server_flight / none_server_flight);
+                bench_json_int(&json, "segments", (uint64_t)segments);
+                bench_json_int(&json, "fits_initcwnd", segments <= INITCWND_SEGMENTS);
+                bench_json_int(&json, "extra_round_trips", (uint64_t)extra_round_trips(stats.server_flight));
+                bench_json_int(&json, "handshakes", stats.handshakes);
+                bench_json_num(&json, "handshakes_per_s", (double)stats.handshakes / stats.elapsed);
+                bench_json_num(&json, "server_cpu_us", stats.server_cpu_us);
+                bench_json_num(&json, "client_cpu_us", stats.client_cpu_us);
+            }
+            bench_json_record_end(&json);
+            SSL_CTX_free(client_ctx);
+            SSL_CTX_free(server_ctx);
+        }
+    }
+
+    bench_json_end(&json);
+    free_chain(&chain);
+
+    printf("\n=================================\n");
+    if (failures == 0) {
+        printf("✅ Certificate compression benchmark completed (%s)\n", opts.json_path);
+        return 0;
+    }
+    printf("❌ %d benchmark(s) FAILED\n", failures);
+    return 1;
+}
@@ -0,0 +1,350 @@
+#define _GNU_SOURCE
+#include <openssl/crypto.h>
+#include <elf.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <spawn.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "bench_common.h"
+
+/**
+ * openssl CLI benchmark: static musl vs glibc builds
+ *
+ * Short-lived CLI invocations (scripts, CI steps, container health checks)
+ * spend most of their time in exec, dynamic loading and libc startup, and
+ * the rest in malloc-heavy parsing. This benchmark runs one or more
+ * openssl binaries (--cli LABEL=PATH, repeatable; default: openssl from
+ * PATH) through the same workloads, one fresh process per sample:
+ *
+ * - startup: `openssl version`, exec to exit, with minor faults and
+ *            peak RSS from wait4()
+ * - digest:  `openssl dgst -sha256` over a generated file (MB/s; mostly
+ *            the SHA-256 code path, so assembly on/off shows here)
+ * - certs:   `openssl crl2pkcs7 -nocrl -certfile` over a bundle of copies
+ *            of one P-256 certificate (certificates/s; ASN.1 decoding is
+ *            dominated by small allocations, so the allocator shows here)
+ *
+ * Each binary's ELF header tells its linkage: "static" (no PT_INTERP),
+ * "musl" or "glibc" (from the interpreter path). Build the package with
+ * -o libc=musl (profile static-musl) and without, then pass both CLIs;
+ * records of every binary after the first carry vs_first, the first
+ * one's time divided by theirs (>1: faster).
+ */
+
+#define MAX_CLIS 8
+#define MAX_ROUNDS 25
+
+extern char **environ;
+
+typedef struct {
+    const char *label;
+    char path[4096];
+    char linkage[16];
+} cli_binary;
+
+typedef struct {
+    double wall_p50;
+    double wall_min;
+    double minflt_p50;
+    double maxrss_p50;
+} run_stats;
+
+/* Absolute path of name searched on PATH, 0 if not found; entries whose path does not fit are skipped */
+static int find_on_path(const char *name, char *out, size_t outlen) {
+    const char *path = getenv("PATH");
+    int n;
+
+    if (strchr(name, '/') != NULL) {
+        n = snprintf(out, outlen, "%s", name);
+        return n >= 0 && (size_t)n < outlen && access(out, X_OK) == 0;
+    }
+    while (path != NULL && *path != '\0') {
+        size_t len = strcspn(path, ":");
+
+        if (len > INT_MAX)
+            break;
+        n = len ? snprintf(out, outlen, "%.*s/%s", (int)len, path, name)
+                : snprintf(out, outlen, "./%s", name);
+        if (n >= 0 && (size_t)n < outlen && access(out, X_OK) == 0)
+            return 1;
+        path += len + (path[len] == ':');
+    }
+    return 0;
+}
+
+/* "static", "musl", "glibc" or "dynamic" (other interpreter) from the ELF program headers */
+static void elf_linkage(const char *path, char *out, size_t outlen) {
+    unsigned char ident[EI_NIDENT];
+    char interp[256] = "";
+    int fd = open(path, O_RDONLY), found = 0;
+
+    snprintf(out, outlen, "unknown");
+    if (fd < 0)
+        return;
+    if (pread(fd, ident, sizeof(ident), 0) == (ssize_t)sizeof(ident)
+        && memcmp(ident, ELFMAG, SELFMAG) == 0 && ident[EI_CLASS] == ELFCLASS64) {
+        Elf64_Ehdr eh;
+        Elf64_Phdr ph;
+
+        if (pread(fd, &eh, sizeof(eh), 0) == (ssize_t)sizeof(eh)) {
+            for (int i = 0; i < eh.e_phnum; i++) {
+                if (pread(fd, &ph, sizeof(ph), (off_t)(eh.e_phoff + (Elf64_Off)i * eh.e_phentsize))
+                    != (ssize_t)sizeof(ph) || ph.p_type != PT_INTERP)
+                    continue;
+                size_t len = ph.p_filesz < sizeof(interp) - 1 ? ph.p_filesz : sizeof(interp) - 1;
+                if (pread(fd, interp, len, (off_t)ph.p_offset) == (ssize_t)len)
+                    interp[len] = '\0';
+                found = 1;
+            }
+            if (!found)
+                snprintf(out, outlen, "static");
+            else if (strstr(interp, "ld-musl") != NULL)
+                snprintf(out, outlen, "musl");
+            else if (strstr(interp, "ld-linux") != NULL)
+                snprintf(out, outlen, "glibc");
+            else
+                snprintf(out, outlen, "dynamic");
+        }
+    }
+    close(fd);
+}
+
+/* Run argv once with stdout/stderr discarded; 1 on exit status 0 */
+static int run_once(char *const argv[], double *wall, long *minflt, long *maxrss) {
+    posix_spawn_file_actions_t actions;
+    struct rusage usage;
+    double start;
+    int status;
+    pid_t pid;
+
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_addopen(&actions, STDOUT_FILENO, "/dev/null", O_WRONLY, 0);
+    posix_spawn_file_actions_addopen(&actions, STDERR_FILENO, "/dev/null", O_WRONLY, 0);
+    start = bench_now();
+    if (posix_spawn(&pid, argv[0], &actions, NULL, argv, environ) != 0) {
+        posix_spawn_file_actions_destroy(&actions);
+        return 0;
+    }
+    posix_spawn_file_actions_destroy(&actions);
+    if (wait4(pid, &status, 0, &usage) != pid)
+        return 0;
+    *wall = bench_now() - start;
+    *minflt = usage.ru_minflt;
+    *maxrss = usage.ru_maxrss;
+    return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+static int measure(char *const argv[], int rounds, run_stats *stats) {
+    double wall[MAX_ROUNDS], minflt[MAX_ROUNDS], maxrss[MAX_ROUNDS];
+
+    for (int r = 0; r < rounds; r++) {
+        long faults = 0, rss = 0;
+
+        if (!run_once(argv, &wall[r], &faults, &rss))
+            return 0;
+        minflt[r] = (double)faults;
+        maxrss[r] = (double)rss;
+    }
+    stats->wall_p50 = bench_percentile(wall, rounds, 50) * 1e3;
+    stats->wall_min = bench_percentile(wall, rounds, 0) * 1e3;
+    stats->minflt_p50 = bench_percentile(minflt, rounds, 50);
+    stats->maxrss_p50 = bench_percentile(maxrss, rounds, 50);
+    return 1;
+}
+
+static int write_data(const char *path, size_t bytes) {
+    unsigned char block[65536];
+    FILE *fp = fopen(path, "wb");
+
+    if (fp == NULL)
+        return 0;
+    for (size_t i = 0; i < sizeof(block); i++)
+        block[i] = (unsigned char)(i * 131 + 7);
+    for (size_t done = 0; done < bytes; done += sizeof(block))
+        fwrite(block, 1, bytes - done < sizeof(block) ? bytes - done : sizeof(block), fp);
+    return fclose(fp) == 0;
+}
+
+/* Bundle of count copies of the certificate in cert */
+static int write_bundle(const char *cert, const char *bundle, int count) {
+    char pem[8192];
+    size_t len;
+    FILE *in = fopen(cert, "rb"), *out;
+
+    if (in == NULL)
+        return 0;
+    len = fread(pem, 1, sizeof(pem), in);
+    fclose(in);
+    if (len == 0 || len == sizeof(pem) || (out = fopen(bundle, "wb")) == NULL)
+        return 0;
+    for (int i = 0; i < count; i++)
+        fwrite(pem, 1, len, out);
+    return fclose(out) == 0;
+}
+
+static void report(bench_json *json, const cli_binary *cli, const char *workload, int rounds,
+                   const run_stats *stats, const char *rate_key, double units, double first_ms) {
+    double rate = units > 0 ? units / (stats->wall_min / 1e3) : 0;
+
+    printf("  %-10s %-8s %-8s %9.3f ms  (min %8.3f)  %6.0f minflt  %7.0f KiB",
+           cli->label, cli->linkage, workload, stats->wall_p50, stats->wall_min,
+           stats->minflt_p50, stats->maxrss_p50);
+    if (rate_key != NULL)
+        printf("  %10.1f %s", rate, rate_key);
+    if (first_ms > 0)
+        printf("  x%.2f", first_ms / stats->wall_p50);
+    printf("\n");
+
+    bench_json_record_begin(json);
+    bench_json_str(json, "type", "cli");
+    bench_json_str(json, "cli", cli->label);
+    bench_json_str(json, "path", cli->path);
+    bench_json_str(json, "linkage", cli->linkage);
+    bench_json_str(json, "workload", workload);
+    bench_json_int(json, "rounds", (uint64_t)rounds);
+    bench_json_num(json, "wall_ms_p50", stats->wall_p50);
+    bench_json_num(json, "wall_ms_min", stats->wall_min);
+    bench_json_num(json, "minor_faults", stats->minflt_p50);
+    bench_json_num(json, "max_rss_kib", stats->maxrss_p50);
+    if (rate_key != NULL)
+        bench_json_num(json, rate_key, rate);
+    if (first_ms > 0)
+        bench_json_num(json, "vs_first", first_ms / stats->wall_p50);
+    bench_json_record_end(json);
+}
+
+int main(int argc, char **argv) {
+    bench_options opts;
+    bench_json json;
+    cli_binary clis[MAX_CLIS];
+    run_stats stats;
+    char dir[] = "/tmp/bench_cli.XXXXXX", data[4200], key[4200], cert[4200], bundle[4200];
+    double first_ms[3] = {0, 0, 0};
+    size_t data_bytes;
+    int nclis = 0, explicit_clis = 0, rounds, bundle_certs, failures = 0;
+    int argi;
+
+    argi = bench_parse_args(argc, argv, "bench_cli.json", &opts);
+    if (argi < 0)
+        return 2;
+    for (; argi < argc; argi++) {
+        char *eq;
+
+        if (strcmp(argv[argi], "--cli") == 0 && argi + 1 < argc && nclis < MAX_CLIS
+            && (eq = strchr(argv[argi + 1], '=')) != NULL) {
+            *eq = '\0';
+            clis[nclis].label = argv[++argi];
+            if (!find_on_path(eq + 1, clis[nclis].path, sizeof(clis[nclis].path))) {
+                fprintf(stderr, "ERROR: %s is not an executable\n", eq + 1);
+                return 2;
+            }
+            nclis++;
+            explicit_clis = 1;
+        } else {
+            fprintf(stderr, "Usage: %s [--quick] [--json PATH] [--cli LABEL=PATH]...\n", argv[0]);
+            return 2;
+        }
+    }
+    if (!explicit_clis) {
+        clis[0].label = "path";
+        if (!find_on_path("openssl", clis[0].path, sizeof(clis[0].path))) {
+            printf("⚠ No openssl on PATH and no --cli given, skipping\n");
+            return 0;
+        }
+        nclis = 1;
+    }
+    for (int i = 0; i < nclis; i++)
+        elf_linkage(clis[i].path, clis[i].linkage, sizeof(clis[i].linkage));
+
+    rounds = opts.quick ? 3 : MAX_ROUNDS;
+    data_bytes = opts.quick ? (size_t)1 << 20 : (size_t)64 << 20;
+    bundle_certs = opts.quick ? 200 : 5000;
+
+    printf("=============================\n");
+    printf("OpenSSL CLI Benchmark\n");
+    printf("=============================\n");
+    printf("%d processes per workload, %zu MiB digest input, %d certificates per bundle\n",
+           rounds, data_bytes >> 20, bundle_certs);
+    for (int i = 0; i < nclis; i++)
+        printf("  %-10s %-8s %s\n", clis[i].label, clis[i].linkage, clis[i].path);
+
+    if (mkdtemp(dir) == NULL) {
+        fprintf(stderr, "ERROR: Cannot create a temporary directory\n");
+        return 1;
+    }
+    snprintf(data, sizeof(data), "%s/data.bin", dir);
+    snprintf(key, sizeof(key), "%s/key.pem", dir);
+    snprintf(cert, sizeof(cert), "%s/cert.pem", dir);
+    snprintf(bundle, sizeof(bundle), "%s/bundle.pem", dir);
+
+    /* Inputs, made with the first CLI */
+    {
+        char *req[] = {clis[0].path, "req", "-x509", "-newkey", "ec", "-pkeyopt",
+                       "ec_paramgen_curve:P-256", "-nodes", "-keyout", key, "-out", cert,
+                       "-subj", "/CN=bench_cli", "-days", "1", NULL};
+        double wall;
+        long faults, rss;
+
+        if (!write_data(data, data_bytes) || !run_once(req, &wall, &faults, &rss)
+            || !write_bundle(cert, bundle, bundle_certs)) {
+            fprintf(stderr, "ERROR: Cannot prepare the inputs with %s\n", clis[0].path);
+            failures++;
+        }
+    }
+
+    if (failures == 0 && bench_json_begin(&json, &opts, "cli") == 0) {
+        printf("\n  %-10s %-8s %-8s %9s\n", "cli", "linkage", "workload", "p50");
+        for (int i = 0; i < nclis; i++) {
+            char *version[] = {clis[i].path, "version", NULL};
+            char *dgst[] = {clis[i].path, "dgst", "-sha256", data, NULL};
+            char *certs[] = {clis[i].path, "crl2pkcs7", "-nocrl", "-certfile", bundle,
+                             "-out", "/dev/null", NULL};
+            struct {
+                const char *name;
+                char **argv;
+                const char *rate_key;
+                double units;
+            } workloads[] = {
+                {"startup", version, NULL, 0},
+                {"digest", dgst, "mb_per_s", (double)data_bytes / 1e6},
+                {"certs", certs, "certs_per_s", (double)bundle_certs},
+            };
+
+            for (int w = 0; w < 3; w++) {
+                if (!measure(workloads[w].argv, rounds, &stats)) {
+                    fprintf(stderr, "ERROR: %s %s failed\n", clis[i].label, workloads[w].name);
+                    failures++;
+                    continue;
+                }
+                report(&json, &clis[i], workloads[w].name, rounds, &stats, workloads[w].rate_key,
+                       workloads[w].units, i > 0 ? first_ms[w] : 0);
+                if (i == 0)
+                    first_ms[w] = stats.wall_p50;
+            }
+        }
+        bench_json_end(&json);
+    } else if (failures == 0) {
+        failures++;
+    }
+
+    unlink(data);
+    unlink(key);
+    unlink(cert);
+    unlink(bundle);
+    rmdir(dir);
+
+    printf("\n=============================\n");
+    if (failures == 0) {
+        printf("✅ CLI benchmark completed (%s)\n", opts.json_path);
+        return 0;
+    }
+    printf("❌ %d benchmark(s) FAILED\n", failures);
+    return 1;
+}
@@ -0,0 +1,203 @@
+#ifndef SPARETOOLS_BENCH_COMMON_H
+#define SPARETOOLS_BENCH_COMMON_H
+
+#include <openssl/crypto.h>
+#include <openssl/opensslv.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+/**
+ * Shared helpers for the test_package benchmark binaries.
+ *
+ * Header-only so every bench_*.c stays a single translation unit:
+ * - monotonic wall clock and per-thread CPU time
+ * - common command line (--quick, --json PATH, --perf-counters)
+ * - minimal JSON writer producing one flat record per measurement
+ * - latency percentiles over collected samples
+ */
+
+#define BENCH_MIN_SECONDS 0.5
+#define BENCH_QUICK_SECONDS 0.02
+
+typedef struct {
+    int quick;              /* Short runs, used by ctest smoke runs */
+    const char *json_path;  /* "-" writes JSON to stdout */
+    double min_seconds;     /* Minimum measured time per data point */
+    int perf_counters;      /* Record hardware counters (bench_perf.h) */
+} bench_options;
+
+typedef struct {
+    FILE *fp;
+    int records;
+    int fields;
+} bench_json;
+
+static inline double bench_now(void) {
+#ifdef _WIN32
+    LARGE_INTEGER freq, count;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&count);
+    return (double)count.QuadPart / (double)freq.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+#endif
+}
+
+/* CPU time consumed by the calling thread, in seconds */
+static inline double bench_cpu_now(void) {
+#ifdef _WIN32
+    FILETIME created, exited, kernel, user;
+    ULARGE_INTEGER k, u;
+    GetThreadTimes(GetCurrentThread(), &created, &exited, &kernel, &user);
+    k.LowPart = kernel.dwLowDateTime;
+    k.HighPart = kernel.dwHighDateTime;
+    u.LowPart = user.dwLowDateTime;
+    u.HighPart = user.dwHighDateTime;
+    return (double)(k.QuadPart + u.QuadPart) / 1e7;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+#endif
+}
+
+static inline void bench_usage(const char *prog) {
+    fprintf(stderr, "Usage: %s [--quick] [--json PATH] [--perf-counters]\n", prog);
+}
+
+/**
+ * Parse the options shared by all benchmarks.
+ *
+ * Unknown arguments are left to the caller: the index of the first
+ * argument that was not consumed is returned, or -1 on error.
+ */
+static inline int bench_parse_args(int argc, char **argv, const char *default_json,
+                                   bench_options *opts) {
+    int i;
+
+    opts->quick = 0;
+    opts->json_path = default_json;
+    opts->min_seconds = BENCH_MIN_SECONDS;
+    opts->perf_counters = 0;
+
+    for (i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--quick") == 0) {
+            opts->quick = 1;
+            opts->min_seconds = BENCH_QUICK_SECONDS;
+        } else if (strcmp(argv[i], "--json") == 0) {
+            if (i + 1 >= argc) {
+                bench_usage(argv[0]);
+                return -1;
+            }
+            opts->json_path = argv[++i];
+        } else if (strcmp(argv[i], "--perf-counters") == 0) {
+            opts->perf_counters = 1;
+        } else if (strcmp(argv[i], "--help") == 0) {
+            bench_usage(argv[0]);
+            return -1;
+        } else {
+            break;
+        }
+    }
+    return i;
+}
+
+static inline void bench_json_string(FILE *fp, const char *s) {
+    fputc('"', fp);
+    for (; *s != '\0'; s++) {
+        if (*s == '"' || *s == '\\')
+            fputc('\\', fp);
+        fputc(*s, fp);
+    }
+    fputc('"', fp);
+}
+
+static inline void bench_json_key(bench_json *j, const char *key) {
+    fprintf(j->fp, "%s", j->fields++ ? ", " : "");
+    bench_json_string(j->fp, key);
+    fprintf(j->fp, ": ");
+}
+
+static inline void bench_json_str(bench_json *j, const char *key, const char *value) {
+    bench_json_key(j, key);
+    bench_json_string(j->fp, value);
+}
+
+static inline void bench_json_num(bench_json *j, const char *key, double value) {
+    bench_json_key(j, key);
+    fprintf(j->fp, "%.6f", value);
+}
+
+static inline void bench_json_int(bench_json *j, const char *key, uint64_t value) {
+    bench_json_key(j, key);
+    fprintf(j->fp, "%llu", (unsigned long long)value);
+}
+
+/**
+ * Open the JSON report and write the header shared by all benchmarks.
+ * The caller then emits records and closes with bench_json_end().
+ */
+static inline int bench_json_begin(bench_json *j, const bench_options *opts,
+                                   const char *benchmark) {
+    j->records = 0;
+    j->fields = 0;
+    if (strcmp(opts->json_path, "-") == 0) {
+        j->fp = stdout;
+    } else if ((j->fp = fopen(opts->json_path, "w")) == NULL) {
+        fprintf(stderr, "ERROR: Cannot open %s for writing\n", opts->json_path);
+        return 1;
+    }
+
+    fprintf(j->fp, "{");
+    bench_json_str(j, "benchmark", benchmark);
+    bench_json_str(j, "openssl_version", OpenSSL_version(OPENSSL_VERSION));
+    bench_json_str(j, "platform", OpenSSL_version(OPENSSL_PLATFORM));
+    bench_json_int(j, "quick", (uint64_t)opts->quick);
+    bench_json_num(j, "min_seconds", opts->min_seconds);
+    fprintf(j->fp, ",\n  \"results\": [");
+    return 0;
+}
+
+static inline void bench_json_record_begin(bench_json *j) {
+    fprintf(j->fp, "%s\n    {", j->records++ ? "," : "");
+    j->fields = 0;
+}
+
+static inline void bench_json_record_end(bench_json *j) {
+    fprintf(j->fp, "}");
+}
+
+static inline void bench_json_end(bench_json *j) {
+    fprintf(j->fp, "\n  ]\n}\n");
+    if (j->fp != stdout)
+        fclose(j->fp);
+    j->fp = NULL;
+}
+
+static inline int bench_double_cmp(const void *a, const void *b) {
+    double da = *(const double *)a, db = *(const double *)b;
+    return (da > db) - (da < db);
+}
+
+/** Percentile (0-100) of an array of samples; sorts the array in place. */
+static inline double bench_percentile(double *samples, size_t n, double pct) {
+    size_t idx;
+
+    if (n == 0)
+        return 0.0;
+    qsort(samples, n, sizeof(*samples), bench_double_cmp);
+    idx = (size_t)(pct / 100.0 * (double)(n - 1) + 0.5);
+    return samples[idx < n ? idx : n - 1];
+}
+
+#endif /* SPARETOOLS_BENCH_COMMON_H */
@@ -0,0 +1,386 @@
+#include <openssl/crypto.h>
+#include <openssl/err.h>
+#include <openssl/ssl.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+#include "bench_common.h"
+#include "bench_tls.h"
+
+/**
+ * Per-connection memory footprint benchmark
+ *
+ * Opens --connections N (10000 by default, 200 with --quick) TLS 1.3
+ * connections over in-memory BIO pairs and keeps the server side of all
+ * of them alive at once, the way a websocket tier holds idle clients.
+ * Each connection is left in one of two states:
+ *
+ * - idle:   handshake done, session tickets consumed, nothing pending
+ * - active: a 16 KiB record from the client only partly read by the
+ *           server (1 byte), so the server holds a decrypted record
+ *
+ * for each server SSL_CTX variant:
+ *
+ * - default:          library defaults
+ * - release-buffers:  SSL_MODE_RELEASE_BUFFERS
+ * - read-buf-64k:     SSL_CTX_set_default_read_buffer_len(65536) with
+ *                     read-ahead
+ * - release+read-64k: both of the above
+ *
+ * Reported per connection: OpenSSL bytes live in the server SSL object
+ * (allocations made by server-side calls, tracked through size-tagged
+ * CRYPTO_set_mem_functions hooks) and the process RSS growth, which also
+ * covers the server's half of the BIO pair (4 KiB).
+ * The client ends are freed once their connection reaches its state.
+ */
+
+#define DEFAULT_CONNECTIONS 10000
+#define QUICK_CONNECTIONS 200
+#define BIO_PAIR_SIZE 4096
+#define ACTIVE_RECORD 16384
+
+typedef struct {
+    const char *name;
+    int release_buffers;
+    size_t read_buffer_len;
+} ctx_variant;
+
+static const ctx_variant variants[] = {
+    {"default", 0, 0},
+    {"release-buffers", 1, 0},
+    {"read-buf-64k", 0, 65536},
+    {"release+read-64k", 1, 65536},
+};
+#define NUM_VARIANTS (sizeof(variants) / sizeof(variants[0]))
+
+static const char *state_names[] = {"idle", "active"};
+#define NUM_STATES 2
+
+/*
+ * Live-byte accounting. Every OpenSSL block gets a header with its size
+ * and the side whose call allocated it (set in current_side around each
+ * server call), so frees credit the right total whichever side frees.
+ */
+#define SIDE_OTHER 0
+#define SIDE_SERVER 1
+
+typedef union {
+    struct {
+        size_t size;
+        int side;
+    } h;
+    max_align_t align;
+} block_header;
+
+static CRYPTO_malloc_fn next_malloc;
+static CRYPTO_realloc_fn next_realloc;
+static CRYPTO_free_fn next_free;
+static int current_side = SIDE_OTHER;
+static long long live_bytes[2];
+
+static void *tag_block(block_header *b, size_t num) {
+    if (b == NULL)
+        return NULL;
+    b->h.size = num;
+    b->h.side = current_side;
+    live_bytes[current_side] += (long long)num;
+    return b + 1;
+}
+
+static void *live_malloc(size_t num, const char *file, int line) {
+    size_t total = sizeof(block_header) + num;
+
+    return tag_block(next_malloc != NULL ? next_malloc(total, file, line) : malloc(total), num);
+}
+
+static void *live_realloc(void *addr, size_t num, const char *file, int line) {
+    block_header *b = addr != NULL ? (block_header *)addr - 1 : NULL;
+    size_t total = sizeof(block_header) + num;
+    size_t old_size = b != NULL ? b->h.size : 0;
+    int old_side = b != NULL ? b->h.side : SIDE_OTHER;
+    block_header *nb;
+
+    nb = next_realloc != NULL ? next_realloc(b, total, file, line) : realloc(b, total);
+    if (nb == NULL)
+        return NULL;
+    live_bytes[old_side] -= (long long)old_size;
+    return tag_block(nb, num);
+}
+
+static void live_free(void *addr, const char *file, int line) {
+    block_header *b;
+
+    if (addr == NULL)
+        return;
+    b = (block_header *)addr - 1;
+    live_bytes[b->h.side] -= (long long)b->h.size;
+    if (next_free != NULL)
+        next_free(b, file, line);
+    else
+        free(b);
+}
+
+/* Must run before OpenSSL's first allocation; returns 1 if active */
+static int install_live_counter(void) {
+    CRYPTO_get_mem_functions(&next_malloc, &next_realloc, &next_free);
+    /* The defaults are the CRYPTO_* entry points themselves */
+    if (next_malloc == CRYPTO_malloc) {
+        next_malloc = NULL;
+        next_realloc = NULL;
+        next_free = NULL;
+    }
+    return CRYPTO_set_mem_functions(live_malloc, live_realloc, live_free);
+}
+
+/* Resident set size in bytes, or 0 when /proc is unavailable */
+static size_t rss_bytes(void) {
+    unsigned long pages = 0, resident = 0;
+    FILE *fp = fopen("/proc/self/statm", "r");
+
+    if (fp == NULL)
+        return 0;
+    if (fscanf(fp, "%lu %lu", &pages, &resident) != 2)
+        resident = 0;
+    fclose(fp);
+    return (size_t)resident * (size_t)sysconf(_SC_PAGESIZE);
+}
+
+static int server_call(int (*fn)(SSL *), SSL *server) {
+    int ret;
+
+    current_side = SIDE_SERVER;
+    ret = fn(server);
+    current_side = SIDE_OTHER;
+    return ret;
+}
+
+static int server_read(SSL *server, void *buf, int len) {
+    int ret;
+
+    current_side = SIDE_SERVER;
+    ret = SSL_read(server, buf, len);
+    current_side = SIDE_OTHER;
+    return ret;
+}
+
+static void free_server(SSL *server) {
+    current_side = SIDE_SERVER;
+    SSL_free(server);
+    current_side = SIDE_OTHER;
+}
+
+/* Handshake step with the server's allocations attributed to the server side */
+static int handshake_step(SSL *ssl, int is_server, void *arg) {
+    (void)arg;
+    return is_server ? server_call(SSL_do_handshake, ssl) : SSL_do_handshake(ssl);
+}
+
+/*
+ * Client write of one record, pushed through the small BIO pair while
+ * the server reads its first byte.
+ */
+static int make_active(SSL *client, SSL *server, const unsigned char *record) {
+    unsigned char byte;
+    int written = 0, got = 0;
+
+    for (int round = 0; round < 64 && !(written && got); round++) {
+        int ret;
+
+        if (!written) {
+            ret = SSL_write(client, record, ACTIVE_RECORD);
+            if (ret > 0)
+                written = 1;
+            else if (!bench_tls_retryable(client, ret))
+                return 0;
+        }
+        if (!got) {
+            ret = server_read(server, &byte, 1);
+            if (ret == 1)
+                got = 1;
+            else if (!bench_tls_retryable(server, ret))
+                return 0;
+        }
+    }
+    return written && got;
+}
+
+/* One connection in the given state; returns its server end or NULL */
+static SSL *open_connection(SSL_CTX *client_ctx, SSL_CTX *server_ctx, int active,
+                            const unsigned char *record) {
+    SSL *client = SSL_new(client_ctx), *server;
+    BIO *cbio = NULL, *sbio = NULL;
+    int ok;
+
+    current_side = SIDE_SERVER;
+    server = SSL_new(server_ctx);
+    current_side = SIDE_OTHER;
+    if (client == NULL || server == NULL
+        || !BIO_new_bio_pair(&cbio, BIO_PAIR_SIZE, &sbio, BIO_PAIR_SIZE)) {
+        SSL_free(client);
+        SSL_free(server);
+        return NULL;
+    }
+    SSL_set_bio(client, cbio, cbio);
+    SSL_set_bio(server, sbio, sbio);
+    SSL_set_connect_state(client);
+    SSL_set_accept_state(server);
+
+    ok = bench_tls_handshake_ex(client, server, handshake_step, NULL);
+    /* The server sends its tickets after the handshake; the client reads them */
+    if (ok)
+        bench_tls_drain(client);
+    if (ok && active)
+        ok = make_active(client, server, record);
+    /* Freeing the client unlinks the pair; the server end keeps its state */
+    SSL_free(client);
+    if (!ok) {
+        free_server(server);
+        return NULL;
+    }
+    return server;
+}
+
+typedef struct {
+    double ssl_bytes;      /* Server-side OpenSSL bytes per connection */
+    double rss_bytes;      /* Process RSS growth per connection */
+    double setup_seconds;
+} footprint;
+
+static int run_footprint(SSL_CTX *client_ctx, SSL_CTX *server_ctx, int active, int connections,
+                         const unsigned char *record, footprint *fp) {
+    SSL **servers = calloc((size_t)connections, sizeof(*servers));
+    long long ssl_before;
+    size_t rss_before, rss_after;
+    double start;
+    int opened = 0;
+
+    if (servers == NULL)
+        return 0;
+#ifdef __GLIBC__
+    /* Return memory freed by the previous run so the RSS baseline is low */
+    malloc_trim(0);
+#endif
+    ssl_before = live_bytes[SIDE_SERVER];
+    rss_before = rss_bytes();
+    start = bench_now();
+    for (; opened < connections; opened++) {
+        if ((servers[opened] = open_connection(client_ctx, server_ctx, active, record)) == NULL)
+            break;
+    }
+    fp->setup_seconds = bench_now() - start;
+    rss_after = rss_bytes();
+    fp->ssl_bytes = (double)(live_bytes[SIDE_SERVER] - ssl_before) / (double)(opened ? opened : 1);
+    fp->rss_bytes = rss_after > rss_before ? (double)(rss_after - rss_before) / (double)(opened ? opened : 1) : 0.0;
+
+    for (int i = 0; i < opened; i++)
+        free_server(servers[i]);
+    free(servers);
+    return opened == connections;
+}
+
+int main(int argc, char **argv) {
+    bench_options opts;
+    bench_json json;
+    EVP_PKEY *pkey = NULL;
+    X509 *cert = NULL;
+    unsigned char record[ACTIVE_RECORD];
+    int connections = -1, failures = 0, counting;
+    int argi = bench_parse_args(argc, argv, "bench_connmem.json", &opts);
+
+    if (argi < 0)
+        return 2;
+    for (; argi < argc; argi++) {
+        if (strcmp(argv[argi], "--connections") == 0 && argi + 1 < argc) {
+            connections = atoi(argv[++argi]);
+        } else {
+            fprintf(stderr, "Usage: %s [--quick] [--json PATH] [--connections N]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (connections < 1)
+        connections = opts.quick ? QUICK_CONNECTIONS : DEFAULT_CONNECTIONS;
+    /* Before any OpenSSL allocation */
+    counting = install_live_counter();
+
+    printf("=================================\n");
+    printf("Per-Connection Memory Footprint Benchmark\n");
+    printf("=================================\n");
+    printf("OpenSSL version: %s\n", OpenSSL_version(OPENSSL_VERSION));
+    printf("Connections: %d per run\n", connections);
+    if (!counting)
+        printf("⚠ Allocation hooks unavailable, reporting RSS only\n");
+    printf("\n");
+
+    memset(record, 0x77, sizeof(record));
+    if (bench_tls_make_cert("EC", &pkey, &cert) != 0)
+        return 1;
+    if (bench_json_begin(&json, &opts, "connmem") != 0) {
+        X509_free(cert);
+        EVP_PKEY_free(pkey);
+        return 1;
+    }
+
+    printf("  %-17s %-7s %14s %14s %12s\n", "Variant", "State", "SSL bytes/conn", "RSS bytes/conn",
+           "setup s");
+    for (size_t v = 0; v < NUM_VARIANTS; v++) {
+        for (int st = 0; st < NUM_STATES; st++) {
+            SSL_CTX *client_ctx, *server_ctx;
+            footprint fp;
+            int ok;
+
+            if (bench_tls_make_ctx_pair(pkey, cert, &client_ctx, &server_ctx) != 0) {
+                failures++;
+                break;
+            }
+            if (variants[v].release_buffers)
+                SSL_CTX_set_mode(server_ctx, SSL_MODE_RELEASE_BUFFERS);
+            if (variants[v].read_buffer_len > 0) {
+                SSL_CTX_set_default_read_buffer_len(server_ctx, variants[v].read_buffer_len);
+                SSL_CTX_set_read_ahead(server_ctx, 1);
+            }
+
+            memset(&fp, 0, sizeof(fp));
+            ok = run_footprint(client_ctx, server_ctx, st, connections, record, &fp);
+            SSL_CTX_free(client_ctx);
+            SSL_CTX_free(server_ctx);
+            if (!ok) {
+                fprintf(stderr, "ERROR: %s/%s connections failed\n", variants[v].name, state_names[st]);
+                ERR_print_errors_fp(stderr);
+                failures++;
+                continue;
+            }
+
+            printf("  %-17s %-7s %14.0f %14.0f %12.2f\n", variants[v].name, state_names[st],
+                   counting ? fp.ssl_bytes : 0.0, fp.rss_bytes, fp.setup_seconds);
+            bench_json_record_begin(&json);
+            bench_json_str(&json, "variant", variants[v].name);
+            bench_json_str(&json, "state", state_names[st]);
+            bench_json_int(&json, "connections", (uint64_t)connections);
+            bench_json_int(&json, "release_buffers", (uint64_t)variants[v].release_buffers);
+            bench_json_int(&json, "read_buffer_len", (uint64_t)variants[v].read_buffer_len);
+            if (counting)
+                bench_json_num(&json, "ssl_bytes_per_conn", fp.ssl_bytes);
+            bench_json_num(&json, "rss_bytes_per_conn", fp.rss_bytes);
+            bench_json_num(&json, "setup_seconds", fp.setup_seconds);
+            bench_json_record_end(&json);
+        }
+    }
+
+    bench_json_end(&json);
+    X509_free(cert);
+    EVP_PKEY_free(pkey);
+
+    printf("\n=================================\n");
+    if (failures == 0) {
+        printf("✅ Connection footprint benchmark completed (%s)\n", opts.json_path);
+        return 0;
+    }
+    printf("❌ %d benchmark(s) FAILED\n", failures);
+    return 1;
+}
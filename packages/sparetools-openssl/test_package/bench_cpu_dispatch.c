@@ -0,0 +1,351 @@
+#include <openssl/crypto.h>
+#include <openssl/evp.h>
+#include <openssl/err.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench_common.h"
+
+/**
+ * Runtime CPU dispatch verification
+ *
+ * Prints the OPENSSL_ia32cap / OPENSSL_armcap capability vector in effect
+ * and re-runs itself with capabilities masked through the same environment
+ * variables, measuring AES-128-GCM, ChaCha20-Poly1305, SHA2-256, SHA3-256,
+ * SM4-CTR and AES-128-GCM-SIV (POLYVAL) on 16 KiB buffers for each mask.
+ * A cpu_dispatch=fat package should be measurably faster unmasked than
+ * with the matching feature masked on every CPU that has it (AVX-512/VAES,
+ * AVX2, SHA-NI, AES-NI; ARMv8 crypto, PMULL, SHA3, SM4, SVE, SVE2).
+ *
+ * A missing speed-up is reported as a warning, not a failure: the host
+ * may lack the feature, and quick runs are noisy. Algorithms the library
+ * does not provide (SM4 in no-sm4 builds, GCM-SIV before 3.2) are recorded
+ * with 0 MB/s.
+ */
+
+#define BUFFER_SIZE 16384
+#define MIN_SPEEDUP 1.05
+
+typedef struct {
+    const char *name;
+    const char *mb_name;
+} dispatch_workload;
+
+static const dispatch_workload workloads[] = {
+    {"aes-128-gcm", "AES-128-GCM"},
+    {"chacha20-poly1305", "ChaCha20-Poly1305"},
+    {"sha2-256", "SHA2-256"},
+    {"sha3-256", "SHA3-256"},
+    {"sm4-ctr", "SM4-CTR"},
+    {"aes-128-gcm-siv", "AES-128-GCM-SIV"},
+};
+#define NUM_WORKLOADS (sizeof(workloads) / sizeof(workloads[0]))
+
+/**
+ * Capability mask. `word`/`bit` locate `feature` in the unmasked vector;
+ * when present, `workload` is expected to be faster unmasked. A profile
+ * with `clear` instead of `mask` exports the detected word 0 without
+ * those bits (OPENSSL_armcap replaces the vector rather than masking it).
+ */
+typedef struct {
+    const char *name;
+    const char *mask;
+    const char *feature;
+    int word;
+    int bit;
+    int workload;
+    unsigned long long clear;
+} cap_profile;
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+# define CAP_ENV "OPENSSL_ia32cap"
+/*
+ * Word 0: CPUID.1 EDX:ECX, word 1: CPUID.7 EBX:ECX. "~" clears bits; a
+ * mask without ":" also zeroes word 1, hence ":~0x0" to keep it.
+ * AVX-512 F/DQ/IFMA/CD/BW/VL + VAES/VPCLMULQDQ; AVX2 adds BMI1/BMI2/ADX.
+ */
+static const cap_profile profiles[] = {
+    {"all", NULL, NULL, 0, 0, -1, 0},
+    {"no-avx512", ":~0x600D0230000", "AVX-512", 1, 16, 1, 0},
+    {"no-avx2", ":~0x600D02B0128", "AVX2", 1, 5, 1, 0},
+    {"no-shani", ":~0x20000000", "SHA-NI", 1, 29, 2, 0},
+    {"no-aesni", "~0x200000200000000:~0x0", "AES-NI", 0, 57, 0, 0},
+    {"no-simd", "~0x1200020200000000:~0x600F02B0128", "AES-NI", 0, 57, 0, 0},
+};
+#elif defined(__aarch64__) || defined(_M_ARM64) || defined(__arm__)
+# define CAP_ENV "OPENSSL_armcap"
+/*
+ * arm_arch.h bits: 0 NEON, 2 AES, 4 SHA256, 5 PMULL, 10 SM4, 11 SHA3,
+ * 12/16 EOR3 unrolling, 13 SVE, 14 SVE2, 15 SHA3 worth using, 17 SVE2
+ * Poly1305. no-sve/no-sve2 leave NEON and the crypto extensions in
+ * place, so their delta is the SVE code path alone (ChaCha20, Poly1305).
+ */
+#define ARMCAP_SHA3_ALL ((1ULL << 11) | (1ULL << 12) | (1ULL << 15) | (1ULL << 16))
+#define ARMCAP_SVE2_ALL ((1ULL << 14) | (1ULL << 17))
+static const cap_profile profiles[] = {
+    {"all", NULL, NULL, 0, 0, -1, 0},
+    {"no-sve2", NULL, "SVE2", 0, 14, 1, ARMCAP_SVE2_ALL},
+    {"no-sve", NULL, "SVE", 0, 13, 1, (1ULL << 13) | ARMCAP_SVE2_ALL},
+    {"no-sha3", NULL, "SHA3", 0, 11, 3, ARMCAP_SHA3_ALL},
+    {"no-sm4", NULL, "SM4", 0, 10, 4, 1ULL << 10},
+    {"no-pmull", NULL, "PMULL", 0, 5, 5, 1ULL << 5},
+    {"neon-only", "0x1", "ARMv8 AES", 0, 2, 0, 0},
+    {"none", "0x0", "NEON", 0, 0, 1, 0},
+};
+#else
+# define CAP_ENV ""
+static const cap_profile profiles[] = {
+    {"all", NULL, NULL, 0, 0, -1, 0},
+};
+#endif
+#define NUM_PROFILES (sizeof(profiles) / sizeof(profiles[0]))
+
+/** Capability string reported by the library ("" if unavailable) */
+static const char *cpu_info(void) {
+#ifdef OPENSSL_CPU_INFO
+    return OpenSSL_version(OPENSSL_CPU_INFO);
+#else
+    return "";
+#endif
+}
+
+/** Parse the effective capability words out of OPENSSL_CPU_INFO */
+static int parse_caps(const char *info, unsigned long long caps[2]) {
+    const char *p;
+
+    caps[0] = caps[1] = 0;
+    if (CAP_ENV[0] == '\0' || (p = strstr(info, CAP_ENV "=")) == NULL)
+        return 0;
+    p += strlen(CAP_ENV "=");
+    return sscanf(p, "0x%llx:0x%llx", &caps[0], &caps[1]) >= 1;
+}
+
+/**
+ * MB/s for one workload on BUFFER_SIZE buffers, 0 if the library does not
+ * provide the algorithm, negative on failure
+ */
+static double measure(const dispatch_workload *wl, double min_seconds) {
+    static unsigned char in[BUFFER_SIZE], out[BUFFER_SIZE + EVP_MAX_BLOCK_LENGTH];
+    unsigned char key[32] = {0}, iv[16] = {0}, md[EVP_MAX_MD_SIZE];
+    EVP_CIPHER *cipher = NULL;
+    EVP_MD *digest = NULL;
+    EVP_CIPHER_CTX *cctx = NULL;
+    EVP_MD_CTX *mctx = NULL;
+    unsigned long long iterations = 0;
+    double start, elapsed = 0.0, rate = -1.0;
+    int outl;
+    unsigned int mdlen;
+
+    memset(in, 0xa5, sizeof(in));
+    if (strncmp(wl->name, "sha", 3) == 0) {
+        if ((digest = EVP_MD_fetch(NULL, wl->mb_name, NULL)) == NULL) {
+            ERR_clear_error();
+            return 0.0;
+        }
+        if ((mctx = EVP_MD_CTX_new()) == NULL)
+            goto end;
+    } else {
+        if ((cipher = EVP_CIPHER_fetch(NULL, wl->mb_name, NULL)) == NULL) {
+            ERR_clear_error();
+            return 0.0;
+        }
+        if ((cctx = EVP_CIPHER_CTX_new()) == NULL
+            || !EVP_EncryptInit_ex2(cctx, cipher, key, iv, NULL))
+            goto end;
+    }
+
+    start = bench_now();
+    do {
+        for (int i = 0; i < 16; i++) {
+            int ok;
+
+            if (digest != NULL) {
+                ok = EVP_DigestInit_ex2(mctx, digest, NULL)
+                    && EVP_DigestUpdate(mctx, in, sizeof(in))
+                    && EVP_DigestFinal_ex(mctx, md, &mdlen);
+            } else {
+                iv[0]++;
+                ok = EVP_EncryptInit_ex2(cctx, NULL, NULL, iv, NULL)
+                    && EVP_EncryptUpdate(cctx, out, &outl, in, sizeof(in))
+                    && EVP_EncryptFinal_ex(cctx, out + outl, &outl);
+            }
+            if (!ok)
+                goto end;
+        }
+        iterations += 16;
+        elapsed = bench_now() - start;
+    } while (elapsed < min_seconds);
+    rate = (double)iterations * BUFFER_SIZE / elapsed / 1e6;
+
+end:
+    EVP_CIPHER_CTX_free(cctx);
+    EVP_MD_CTX_free(mctx);
+    EVP_CIPHER_free(cipher);
+    EVP_MD_free(digest);
+    return rate;
+}
+
+/** Child mode: one "workload MB/s" line per workload on stdout */
+static int run_measure(double min_seconds) {
+    printf("%s\n", cpu_info());
+    for (size_t w = 0; w < NUM_WORKLOADS; w++) {
+        double rate = measure(&workloads[w], min_seconds);
+
+        if (rate < 0) {
+            ERR_print_errors_fp(stderr);
+            return 1;
+        }
+        printf("%s %.3f\n", workloads[w].name, rate);
+    }
+    return 0;
+}
+
+/**
+ * Run `self --measure` with mask (NULL: none) exported and collect its
+ * results. Returns 0 on success.
+ */
+static int run_profile(const char *self, const bench_options *opts, const char *mask,
+                       char *info, size_t info_len, double rates[NUM_WORKLOADS]) {
+    char cmd[4096], line[512];
+    FILE *child;
+    size_t found = 0;
+
+    if (mask != NULL)
+        setenv(CAP_ENV, mask, 1);
+    snprintf(cmd, sizeof(cmd), "\"%s\" %s--measure", self, opts->quick ? "--quick " : "");
+    child = popen(cmd, "r");
+    if (mask != NULL)
+        unsetenv(CAP_ENV);
+    if (child == NULL)
+        return 1;
+
+    if (fgets(info, (int)info_len, child) != NULL)
+        info[strcspn(info, "\n")] = '\0';
+    while (fgets(line, sizeof(line), child) != NULL) {
+        char name[64];
+        double rate;
+
+        if (sscanf(line, "%63s %lf", name, &rate) != 2)
+            continue;
+        for (size_t w = 0; w < NUM_WORKLOADS; w++) {
+            if (strcmp(name, workloads[w].name) == 0) {
+                rates[w] = rate;
+                found++;
+            }
+        }
+    }
+    return pclose(child) != 0 || found != NUM_WORKLOADS;
+}
+
+int main(int argc, char **argv) {
+    bench_options opts;
+    bench_json json;
+    double base[NUM_WORKLOADS] = {0};   /* Stays 0 if the unmasked profile fails */
+    unsigned long long caps[2];
+    char info[512];
+    int failures = 0, argi, measure_only = 0, have_caps;
+
+    argi = bench_parse_args(argc, argv, "bench_cpu_dispatch.json", &opts);
+    if (argi < 0)
+        return 2;
+    for (; argi < argc; argi++) {
+        if (strcmp(argv[argi], "--measure") == 0) {
+            measure_only = 1;
+        } else {
+            fprintf(stderr, "Usage: %s [--quick] [--json PATH]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (measure_only)
+        return run_measure(opts.min_seconds);
+
+    printf("=================================\n");
+    printf("OpenSSL Runtime CPU Dispatch Verification\n");
+    printf("=================================\n");
+    printf("OpenSSL version: %s\n", OpenSSL_version(OPENSSL_VERSION));
+    printf("%s\n", cpu_info()[0] ? cpu_info() : "⚠ OPENSSL_CPU_INFO not available");
+    have_caps = parse_caps(cpu_info(), caps);
+    if (!have_caps)
+        printf("⚠ No capability vector for this architecture, reporting unmasked only\n");
+    printf("\n");
+
+    if (bench_json_begin(&json, &opts, "cpu_dispatch") != 0)
+        return 1;
+
+    for (size_t p = 0; p < NUM_PROFILES; p++) {
+        const cap_profile *profile = &profiles[p];
+        double rates[NUM_WORKLOADS] = {0};
+        const char *mask = profile->mask;
+        char derived[32];
+
+        if (p > 0 && CAP_ENV[0] == '\0')
+            break;
+        if (profile->clear != 0) {
+            if (!have_caps)
+                continue;
+            snprintf(derived, sizeof(derived), "0x%llx", caps[0] & ~profile->clear);
+            mask = derived;
+        }
+        if (run_profile(argv[0], &opts, mask, info, sizeof(info), rates) != 0) {
+            fprintf(stderr, "ERROR: Measurement failed for profile %s\n", profile->name);
+            failures++;
+            continue;
+        }
+        if (p == 0)
+            memcpy(base, rates, sizeof(base));
+
+        printf("%-10s %s\n", profile->name, mask ? mask : "(unmasked)");
+        for (size_t w = 0; w < NUM_WORKLOADS; w++) {
+            if (rates[w] > 0 && base[w] > 0)
+                printf("  %-20s %10.1f MB/s  %5.2fx\n", workloads[w].name, rates[w], base[w] / rates[w]);
+            else if (rates[w] > 0)
+                printf("  %-20s %10.1f MB/s  %5s\n", workloads[w].name, rates[w], "-");
+            else
+                printf("  %-20s %10s\n", workloads[w].name, "n/a");
+
+            bench_json_record_begin(&json);
+            bench_json_str(&json, "profile", profile->name);
+            bench_json_str(&json, "mask", mask ? mask : "");
+            bench_json_str(&json, "cpu_info", info);
+            bench_json_str(&json, "workload", workloads[w].name);
+            bench_json_int(&json, "buffer_size", BUFFER_SIZE);
+            bench_json_num(&json, "mb_per_s", rates[w]);
+            bench_json_num(&json, "speedup_unmasked", rates[w] > 0 && base[w] > 0 ? base[w] / rates[w] : 0.0);
+            bench_json_int(&json, "available", rates[w] > 0);
+            bench_json_record_end(&json);
+        }
+
+        if (profile->workload >= 0) {
+            int present = (caps[profile->word] >> profile->bit) & 1;
+            double rate = rates[profile->workload];
+            double speedup = rate > 0 ? base[profile->workload] / rate : 0.0;
+
+            if (base[profile->workload] <= 0)
+                printf("  - no unmasked baseline for %s, nothing to verify\n",
+                       workloads[profile->workload].name);
+            else if (!present)
+                printf("  - %s not present on this CPU, nothing to verify\n", profile->feature);
+            else if (rate <= 0)
+                printf("  - %s not provided by this build, nothing to verify\n",
+                       workloads[profile->workload].mb_name);
+            else if (speedup >= MIN_SPEEDUP)
+                printf("  ✓ Runtime dispatch verified (%s %.2fx faster unmasked)\n",
+                       workloads[profile->workload].name, speedup);
+            else
+                printf("  ⚠ No speed-up from %s on %s (%.2fx)\n",
+                       profile->feature, workloads[profile->workload].name, speedup);
+        }
+        printf("\n");
+    }
+
+    bench_json_end(&json);
+
+    printf("=================================\n");
+    if (failures == 0) {
+        printf("✅ CPU dispatch verification completed (%s)\n", opts.json_path);
+        return 0;
+    }
+    printf("❌ %d profile(s) FAILED\n", failures);
+    return 1;
+}
@@ -0,0 +1,413 @@
+#include <openssl/crypto.h>
+#include <openssl/err.h>
+#include <openssl/rand.h>
+#include <openssl/x509.h>
+#include <openssl/x509v3.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench_common.h"
+#include "bench_x509.h"
+#include "sparetools_crlindex.h"
+
+/**
+ * Large CRL verification benchmark
+ *
+ * A test CA (ECDSA P-256) issues two leaves and a CRL of 10k, 100k and
+ * 1M entries (--entries N for one size) with random 16-byte serials,
+ * one of which revokes the second leaf. X509_verify_cert runs with
+ * X509_V_FLAG_CRL_CHECK against the CA as the only trust anchor, with
+ * the CRL loaded either way:
+ * - stock: d2i_X509_CRL plus X509_STORE_add_crl, OpenSSL's own lookup
+ * - index: compiled by sparetools_crlindex_write, opened (mmap) and
+ *          attached with sparetools_crlindex_attach
+ *
+ * Reported per size and mode: load time (decode, or map and check the
+ * index; the compile time is reported separately), OpenSSL heap bytes
+ * the loaded CRL holds (size-tagged CRYPTO_set_mem_functions hooks) and
+ * the mapped file size, the first verification (which sorts the revoked
+ * list, or checks the full signature once), and the steady-state cost
+ * per verification. The revoked leaf must fail with
+ * X509_V_ERR_CERT_REVOKED in both modes.
+ */
+
+static const int full_sizes[] = {10000, 100000, 1000000, 0};
+static const int quick_sizes[] = {1000, 10000, 0};
+
+#define GOOD_SERIAL 2
+#define REVOKED_SERIAL 3
+
+static EVP_PKEY *ca_key, *leaf_key;
+static X509 *ca_cert, *good_leaf, *revoked_leaf;
+
+/* ---- Live OpenSSL heap bytes ---- */
+
+typedef union {
+    size_t size;
+    max_align_t align;
+} block_header;
+
+static CRYPTO_malloc_fn next_malloc;
+static CRYPTO_realloc_fn next_realloc;
+static CRYPTO_free_fn next_free;
+static long long live_bytes;
+
+static void *tag_block(block_header *b, size_t num) {
+    if (b == NULL)
+        return NULL;
+    b->size = num;
+    live_bytes += (long long)num;
+    return b + 1;
+}
+
+static void *live_malloc(size_t num, const char *file, int line) {
+    size_t total = sizeof(block_header) + num;
+
+    return tag_block(next_malloc != NULL ? next_malloc(total, file, line) : malloc(total), num);
+}
+
+static void *live_realloc(void *addr, size_t num, const char *file, int line) {
+    block_header *b = addr != NULL ? (block_header *)addr - 1 : NULL;
+    size_t total = sizeof(block_header) + num, old_size = b != NULL ? b->size : 0;
+    block_header *nb = next_realloc != NULL ? next_realloc(b, total, file, line) : realloc(b, total);
+
+    if (nb == NULL)
+        return NULL;
+    live_bytes -= (long long)old_size;
+    return tag_block(nb, num);
+}
+
+static void live_free(void *addr, const char *file, int line) {
+    block_header *b;
+
+    if (addr == NULL)
+        return;
+    b = (block_header *)addr - 1;
+    live_bytes -= (long long)b->size;
+    if (next_free != NULL)
+        next_free(b, file, line);
+    else
+        free(b);
+}
+
+/* Must run before OpenSSL's first allocation */
+static int install_live_counter(void) {
+    CRYPTO_get_mem_functions(&next_malloc, &next_realloc, &next_free);
+    if (next_malloc == CRYPTO_malloc) {
+        next_malloc = NULL;
+        next_realloc = NULL;
+        next_free = NULL;
+    }
+    return CRYPTO_set_mem_functions(live_malloc, live_realloc, live_free);
+}
+
+/* ---- Test PKI ---- */
+
+static int make_pki(void) {
+    return (ca_key = bench_x509_keygen("EC")) != NULL
+        && (leaf_key = bench_x509_keygen("EC")) != NULL
+        && (ca_cert = bench_x509_make_cert(ca_key, "SpareTools Bench CRL CA", NULL, ca_key,
+                                           EVP_sha256(), 1, 1)) != NULL
+        && (good_leaf = bench_x509_make_cert(leaf_key, "good.bench.sparetools.local", ca_cert, ca_key,
+                                             EVP_sha256(), 0, GOOD_SERIAL)) != NULL
+        && (revoked_leaf = bench_x509_make_cert(leaf_key, "revoked.bench.sparetools.local", ca_cert,
+                                                ca_key, EVP_sha256(), 0, REVOKED_SERIAL)) != NULL;
+}
+
+static void free_pki(void) {
+    X509_free(revoked_leaf);
+    X509_free(good_leaf);
+    X509_free(ca_cert);
+    EVP_PKEY_free(leaf_key);
+    EVP_PKEY_free(ca_key);
+}
+
+static int add_revoked(X509_CRL *crl, ASN1_INTEGER *serial, const ASN1_TIME *when) {
+    X509_REVOKED *r = X509_REVOKED_new();
+
+    if (r == NULL || !X509_REVOKED_set_serialNumber(r, serial)
+        || !X509_REVOKED_set_revocationDate(r, (ASN1_TIME *)when) || !X509_CRL_add0_revoked(crl, r)) {
+        X509_REVOKED_free(r);
+        return 0;
+    }
+    return 1;
+}
+
+/* DER CRL from the CA with entries revoked serials, REVOKED_SERIAL among them */
+static unsigned char *make_crl(int entries, size_t *len) {
+    X509_CRL *crl = X509_CRL_new();
+    ASN1_TIME *last = X509_time_adj_ex(NULL, 0, -3600, NULL), *next = X509_time_adj_ex(NULL, 7, 0, NULL);
+    ASN1_INTEGER *serial = ASN1_INTEGER_new(), *number = ASN1_INTEGER_new();
+    unsigned char *der = NULL, bytes[16];
+    int ok = crl != NULL && last != NULL && next != NULL && serial != NULL && number != NULL
+        && X509_CRL_set_version(crl, X509_CRL_VERSION_2)
+        && X509_CRL_set_issuer_name(crl, X509_get_subject_name(ca_cert))
+        && X509_CRL_set1_lastUpdate(crl, last) && X509_CRL_set1_nextUpdate(crl, next)
+        && ASN1_INTEGER_set(number, 1) && X509_CRL_add1_ext_i2d(crl, NID_crl_number, number, 0, 0);
+    int der_len = 0;
+
+    for (int i = 0; ok && i < entries - 1; i++) {
+        if (RAND_bytes(bytes, sizeof(bytes)) != 1)
+            ok = 0;
+        /* Positive and minimal: first octet 0x01..0x7f */
+        bytes[0] = (unsigned char)((bytes[0] & 0x7f) | 0x01);
+        ok = ok && ASN1_STRING_set(serial, bytes, sizeof(bytes)) && add_revoked(crl, serial, last);
+    }
+    ok = ok && ASN1_INTEGER_set(serial, REVOKED_SERIAL) && add_revoked(crl, serial, last)
+        && X509_CRL_sort(crl) && X509_CRL_sign(crl, ca_key, EVP_sha256())
+        && (der_len = i2d_X509_CRL(crl, &der)) > 0;
+
+    ASN1_INTEGER_free(number);
+    ASN1_INTEGER_free(serial);
+    ASN1_TIME_free(next);
+    ASN1_TIME_free(last);
+    X509_CRL_free(crl);
+    if (!ok) {
+        OPENSSL_free(der);
+        return NULL;
+    }
+    *len = (size_t)der_len;
+    return der;
+}
+
+/* ---- Measurement ---- */
+
+static X509_STORE *make_store(void) {
+    X509_STORE *store = X509_STORE_new();
+
+    if (store == NULL || !X509_STORE_add_cert(store, ca_cert)
+        || !X509_STORE_set_flags(store, X509_V_FLAG_CRL_CHECK)) {
+        X509_STORE_free(store);
+        return NULL;
+    }
+    return store;
+}
+
+/* X509_verify_cert for leaf; returns the verification error (X509_V_OK: valid) */
+static int verify(X509_STORE *store, X509_STORE_CTX *ctx, X509 *leaf) {
+    int err = X509_V_ERR_UNSPECIFIED;
+
+    if (X509_STORE_CTX_init(ctx, store, leaf, NULL)) {
+        err = X509_verify_cert(ctx) == 1 ? X509_V_OK : X509_STORE_CTX_get_error(ctx);
+        if (err == X509_V_OK && X509_STORE_CTX_get_error(ctx) != X509_V_OK)
+            err = X509_STORE_CTX_get_error(ctx);
+    }
+    X509_STORE_CTX_cleanup(ctx);
+    ERR_clear_error();
+    return err;
+}
+
+typedef struct {
+    double compile_ms;
+    double load_ms;
+    long long heap_bytes;
+    size_t mapped_bytes;
+    double first_verify_us;
+    double verify_us;
+    int revoked_detected;
+} run_result;
+
+static int measure(X509_STORE *store, double min_seconds, run_result *r) {
+    X509_STORE_CTX *ctx = X509_STORE_CTX_new();
+    double start;
+    size_t n = 0;
+    int err;
+
+    if (ctx == NULL)
+        return 1;
+    start = bench_now();
+    err = verify(store, ctx, good_leaf);
+    r->first_verify_us = (bench_now() - start) * 1e6;
+    if (err != X509_V_OK) {
+        fprintf(stderr, "ERROR: good leaf failed: %s\n", X509_verify_cert_error_string(err));
+        X509_STORE_CTX_free(ctx);
+        return 1;
+    }
+    start = bench_now();
+    do {
+        if (verify(store, ctx, good_leaf) != X509_V_OK) {
+            X509_STORE_CTX_free(ctx);
+            return 1;
+        }
+        n++;
+    } while (bench_now() - start < min_seconds || n < 3);
+    r->verify_us = (bench_now() - start) * 1e6 / (double)n;
+
+    err = verify(store, ctx, revoked_leaf);
+    r->revoked_detected = err == X509_V_ERR_CERT_REVOKED;
+    if (!r->revoked_detected)
+        fprintf(stderr, "ERROR: revoked leaf: %s\n", X509_verify_cert_error_string(err));
+    X509_STORE_CTX_free(ctx);
+    return r->revoked_detected ? 0 : 1;
+}
+
+static int run_stock(const unsigned char *der, size_t len, double min_seconds, run_result *r) {
+    const unsigned char *p = der;
+    long long heap0 = live_bytes;
+    double start = bench_now();
+    X509_STORE *store = make_store();
+    X509_CRL *crl = d2i_X509_CRL(NULL, &p, (long)len);
+    int rc;
+
+    memset(r, 0, sizeof(*r));
+    if (store == NULL || crl == NULL || !X509_STORE_add_crl(store, crl)) {
+        X509_CRL_free(crl);
+        X509_STORE_free(store);
+        return 1;
+    }
+    X509_CRL_free(crl);
+    r->load_ms = (bench_now() - start) * 1e3;
+    r->heap_bytes = live_bytes - heap0;
+    rc = measure(store, min_seconds, r);
+    X509_STORE_free(store);
+    return rc;
+}
+
+static int run_index(const unsigned char *der, size_t len, const char *path, double min_seconds,
+                     run_result *r) {
+    SPARETOOLS_CRLINDEX *index;
+    SPARETOOLS_CRLINDEX_STATS stats;
+    X509_STORE *store;
+    long long heap0;
+    double start = bench_now();
+    int rc;
+
+    memset(r, 0, sizeof(*r));
+    if (sparetools_crlindex_write(&der, &len, 1, path) < 0)
+        return 1;
+    r->compile_ms = (bench_now() - start) * 1e3;
+
+    heap0 = live_bytes;
+    start = bench_now();
+    index = sparetools_crlindex_open(path);
+    store = index != NULL ? make_store() : NULL;
+    if (store == NULL || !sparetools_crlindex_attach(index, store)) {
+        X509_STORE_free(store);
+        sparetools_crlindex_free(index);
+        remove(path);
+        return 1;
+    }
+    r->load_ms = (bench_now() - start) * 1e3;
+    r->heap_bytes = live_bytes - heap0;
+    r->mapped_bytes = sparetools_crlindex_size(index);
+    rc = measure(store, min_seconds, r);
+
+    /* The signature is checked once, not per verification */
+    sparetools_crlindex_stats(index, &stats);
+    if (rc == 0 && stats.verifications != 1) {
+        fprintf(stderr, "ERROR: %llu full CRL signature checks\n", (unsigned long long)stats.verifications);
+        rc = 1;
+    }
+    X509_STORE_free(store);
+    sparetools_crlindex_free(index);
+    remove(path);
+    return rc;
+}
+
+int main(int argc, char **argv) {
+    bench_options opts;
+    bench_json json;
+    int single[2] = {0, 0};
+    const int *sizes;
+    int failures = 0;
+
+    /* Before anything allocates through OpenSSL */
+    install_live_counter();
+
+    int argi = bench_parse_args(argc, argv, "bench_crl.json", &opts);
+
+    if (argi < 0)
+        return 2;
+    for (; argi < argc; argi++) {
+        if (strcmp(argv[argi], "--entries") == 0 && argi + 1 < argc) {
+            single[0] = atoi(argv[++argi]);
+        } else {
+            fprintf(stderr, "Usage: %s [--quick] [--json PATH] [--entries N]\n", argv[0]);
+            return 2;
+        }
+    }
+    sizes = single[0] > 0 ? single : opts.quick ? quick_sizes : full_sizes;
+
+    printf("=================================\n");
+    printf("OpenSSL Large CRL Benchmark\n");
+    printf("=================================\n");
+    printf("OpenSSL version: %s\n", OpenSSL_version(OPENSSL_VERSION));
+
+    if (!make_pki()) {
+        fprintf(stderr, "ERROR: Failed to create the test PKI\n");
+        ERR_print_errors_fp(stderr);
+        free_pki();
+        return 1;
+    }
+    if (bench_json_begin(&json, &opts, "crl") != 0) {
+        free_pki();
+        return 1;
+    }
+
+    for (int i = 0; sizes[i] != 0; i++) {
+        char path[64];
+        size_t len;
+        unsigned char *der = make_crl(sizes[i], &len);
+        run_result stock, indexed;
+        int stock_ok, index_ok;
+
+        if (der == NULL) {
+            fprintf(stderr, "ERROR: Failed to create a %d-entry CRL\n", sizes[i]);
+            ERR_print_errors_fp(stderr);
+            failures++;
+            continue;
+        }
+        snprintf(path, sizeof(path), "bench_crl_%d.crlidx", sizes[i]);
+        printf("\n%d entries (%.1f MB)\n", sizes[i], (double)len / 1e6);
+        stock_ok = run_stock(der, len, opts.min_seconds, &stock) == 0;
+        index_ok = run_index(der, len, path, opts.min_seconds, &indexed) == 0;
+        OPENSSL_free(der);
+
+        for (int m = 0; m < 2; m++) {
+            const run_result *r = m == 0 ? &stock : &indexed;
+            const char *mode = m == 0 ? "stock" : "index";
+
+            if (!(m == 0 ? stock_ok : index_ok)) {
+                fprintf(stderr, "ERROR: %s failed with %d entries\n", mode, sizes[i]);
+                ERR_print_errors_fp(stderr);
+                failures++;
+                continue;
+            }
+            printf("  %-6s load %9.2f ms  heap %8.1f MB  mapped %6.1f MB  first %10.1f us  verify %9.1f us",
+                   mode, r->load_ms, (double)r->heap_bytes / 1e6, (double)r->mapped_bytes / 1e6,
+                   r->first_verify_us, r->verify_us);
+            if (m == 1 && stock_ok)
+                printf("  x%.1f", stock.verify_us / r->verify_us);
+            printf("\n");
+
+            bench_json_record_begin(&json);
+            bench_json_str(&json, "mode", mode);
+            bench_json_int(&json, "entries", (uint64_t)sizes[i]);
+            bench_json_int(&json, "crl_bytes", len);
+            if (m == 1)
+                bench_json_num(&json, "compile_ms", r->compile_ms);
+            bench_json_num(&json, "load_ms", r->load_ms);
+            bench_json_int(&json, "heap_bytes", r->heap_bytes > 0 ? (uint64_t)r->heap_bytes : 0);
+            bench_json_int(&json, "mapped_bytes", r->mapped_bytes);
+            bench_json_num(&json, "first_verify_us", r->first_verify_us);
+            bench_json_num(&json, "verify_us", r->verify_us);
+            bench_json_int(&json, "revoked_detected", (uint64_t)r->revoked_detected);
+            if (m == 1 && stock_ok)
+                bench_json_num(&json, "relative_to_stock", stock.verify_us / r->verify_us);
+            bench_json_record_end(&json);
+        }
+    }
+
+    bench_json_end(&json);
+    free_pki();
+
+    printf("\n=================================\n");
+    if (failures == 0) {
+        printf("✅ CRL benchmark completed (%s)\n", opts.json_path);
+        return 0;
+    }
+    printf("❌ %d benchmark(s) FAILED\n", failures);
+    return 1;
+}
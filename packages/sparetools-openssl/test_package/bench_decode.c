@@ -0,0 +1,264 @@
+#include <openssl/bio.h>
+#include <openssl/crypto.h>
+#include <openssl/decoder.h>
+#include <openssl/err.h>
+#include <openssl/evp.h>
+#include <openssl/pem.h>
+#include <openssl/x509.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench_common.h"
+#include "bench_x509.h"
+#include "sparetools_memtrace.h"
+
+/**
+ * Key and certificate decoding benchmark
+ *
+ * OpenSSL 3.x routes key parsing through OSSL_DECODER chains built per
+ * call, which made loading keys much slower than in 1.1.1. This measures
+ * the decode paths a service uses at startup or per tenant, for RSA-2048,
+ * EC P-256, Ed25519 and ML-DSA-65 (OpenSSL 3.5+) keys:
+ *
+ * - pem_privatekey:  PEM_read_bio_PrivateKey on a PKCS#8 PEM key
+ * - decoder_pkey:    OSSL_DECODER_CTX_new_for_pkey (DER PrivateKeyInfo,
+ *                    key type given) + OSSL_DECODER_from_data per decode
+ * - decoder_reused:  the same decoder context reused for every decode
+ * - d2i_autoprivkey: d2i_AutoPrivateKey on the DER PKCS#8 key
+ * - d2i_x509:        d2i_X509 on the DER self-signed certificate
+ *
+ * Each decode includes freeing the result. OpenSSL allocations are
+ * traced with sparetools_memtrace and reported per decode. Compare the
+ * JSON of packages built from different OpenSSL versions to decide
+ * whether to pre-decode keys at deploy time.
+ */
+
+typedef struct {
+    const char *name;
+    const char *keygen;   /* bench_x509_keygen type */
+    const char *decoder_type;
+} key_spec;
+
+static const key_spec keys[] = {
+    {"RSA-2048", "RSA", "RSA"},
+    {"EC-P256", "EC", "EC"},
+    {"ED25519", "ED25519", "ED25519"},
+    {"ML-DSA-65", "ML-DSA-65", "ML-DSA-65"},
+};
+#define NUM_KEYS (sizeof(keys) / sizeof(keys[0]))
+
+typedef enum {
+    CASE_PEM_PRIVATEKEY,
+    CASE_DECODER_PKEY,
+    CASE_DECODER_REUSED,
+    CASE_D2I_AUTOPRIVKEY,
+    CASE_D2I_X509
+} decode_case;
+
+static const char *case_names[] = {
+    "pem_privatekey", "decoder_pkey", "decoder_reused", "d2i_autoprivkey", "d2i_x509"
+};
+#define NUM_CASES 5
+
+typedef struct {
+    const key_spec *spec;
+    EVP_PKEY *key;
+    unsigned char *pem;
+    long pem_len;
+    unsigned char *p8;      /* DER PrivateKeyInfo */
+    int p8_len;
+    unsigned char *cert;    /* DER certificate */
+    int cert_len;
+    OSSL_DECODER_CTX *reused;
+    EVP_PKEY *reused_out;
+} encoded_key;
+
+static void free_encoded(encoded_key *k) {
+    EVP_PKEY_free(k->key);
+    OPENSSL_free(k->pem);
+    OPENSSL_free(k->p8);
+    OPENSSL_free(k->cert);
+    OSSL_DECODER_CTX_free(k->reused);
+    EVP_PKEY_free(k->reused_out);
+}
+
+static int encode_key(const key_spec *spec, encoded_key *k) {
+    PKCS8_PRIV_KEY_INFO *p8 = NULL;
+    BIO *mem = NULL;
+    X509 *cert = NULL;
+    const EVP_MD *md = strcmp(spec->keygen, "RSA") == 0 || strcmp(spec->keygen, "EC") == 0 ? EVP_sha256() : NULL;
+    char *data;
+    int ok = 0;
+
+    memset(k, 0, sizeof(*k));
+    k->spec = spec;
+    if ((k->key = bench_x509_keygen(spec->keygen)) == NULL
+        || (mem = BIO_new(BIO_s_mem())) == NULL
+        || !PEM_write_bio_PrivateKey(mem, k->key, NULL, NULL, 0, NULL, NULL)
+        || (k->pem_len = BIO_get_mem_data(mem, &data)) <= 0
+        || (k->pem = OPENSSL_memdup(data, (size_t)k->pem_len)) == NULL
+        || (p8 = EVP_PKEY2PKCS8(k->key)) == NULL
+        || (k->p8_len = i2d_PKCS8_PRIV_KEY_INFO(p8, &k->p8)) <= 0
+        || (cert = bench_x509_make_cert(k->key, "decode.bench.sparetools.local", NULL, k->key, md, 0, 1)) == NULL
+        || (k->cert_len = i2d_X509(cert, &k->cert)) <= 0)
+        goto done;
+    k->reused = OSSL_DECODER_CTX_new_for_pkey(&k->reused_out, "DER", "PrivateKeyInfo", spec->decoder_type,
+                                              OSSL_KEYMGMT_SELECT_KEYPAIR, NULL, NULL);
+    ok = k->reused != NULL;
+
+done:
+    PKCS8_PRIV_KEY_INFO_free(p8);
+    BIO_free(mem);
+    X509_free(cert);
+    return ok;
+}
+
+/* Decode once and free the result; returns 1 if the decode produced an object */
+static int decode_once(decode_case c, encoded_key *k) {
+    const unsigned char *der;
+    size_t len;
+    EVP_PKEY *pkey = NULL;
+    OSSL_DECODER_CTX *dctx;
+    BIO *bio;
+    X509 *cert;
+    int ok;
+
+    switch (c) {
+    case CASE_PEM_PRIVATEKEY:
+        if ((bio = BIO_new_mem_buf(k->pem, (int)k->pem_len)) == NULL)
+            return 0;
+        pkey = PEM_read_bio_PrivateKey(bio, NULL, NULL, NULL);
+        BIO_free(bio);
+        break;
+    case CASE_DECODER_PKEY:
+        dctx = OSSL_DECODER_CTX_new_for_pkey(&pkey, "DER", "PrivateKeyInfo", k->spec->decoder_type,
+                                             OSSL_KEYMGMT_SELECT_KEYPAIR, NULL, NULL);
+        der = k->p8;
+        len = (size_t)k->p8_len;
+        ok = dctx != NULL && OSSL_DECODER_from_data(dctx, &der, &len);
+        OSSL_DECODER_CTX_free(dctx);
+        if (!ok) {
+            EVP_PKEY_free(pkey);
+            return 0;
+        }
+        break;
+    case CASE_DECODER_REUSED:
+        der = k->p8;
+        len = (size_t)k->p8_len;
+        if (!OSSL_DECODER_from_data(k->reused, &der, &len))
+            return 0;
+        /* The construct callback stores each result in reused_out */
+        pkey = k->reused_out;
+        k->reused_out = NULL;
+        break;
+    case CASE_D2I_AUTOPRIVKEY:
+        der = k->p8;
+        pkey = d2i_AutoPrivateKey(NULL, &der, k->p8_len);
+        break;
+    default:
+        der = k->cert;
+        cert = d2i_X509(NULL, &der, k->cert_len);
+        X509_free(cert);
+        return cert != NULL;
+    }
+    ok = pkey != NULL;
+    EVP_PKEY_free(pkey);
+    return ok;
+}
+
+typedef struct {
+    double rate;
+    double allocs_per_decode;
+    double bytes_per_decode;
+    unsigned long long decodes;
+} case_result;
+
+static int run_case(decode_case c, encoded_key *k, double seconds, case_result *r) {
+    SPARETOOLS_MEMTRACE_TOTALS before, after;
+    double start, elapsed;
+
+    memset(r, 0, sizeof(*r));
+    /* Warm-up decode: provider and decoder loading are not per-decode costs */
+    if (!decode_once(c, k))
+        return 0;
+    sparetools_memtrace_totals(&before);
+    start = bench_now();
+    do {
+        if (!decode_once(c, k))
+            return 0;
+        r->decodes++;
+        elapsed = bench_now() - start;
+    } while (elapsed < seconds);
+    sparetools_memtrace_totals(&after);
+
+    r->rate = (double)r->decodes / elapsed;
+    r->allocs_per_decode = (double)(after.allocs + after.reallocs - before.allocs - before.reallocs)
+        / (double)r->decodes;
+    r->bytes_per_decode = (double)(after.bytes - before.bytes) / (double)r->decodes;
+    return 1;
+}
+
+int main(int argc, char **argv) {
+    bench_options opts;
+    bench_json json;
+    int failures = 0;
+    int argi;
+
+    if (!sparetools_memtrace_install())
+        fprintf(stderr, "⚠ Allocation tracing unavailable (hooks already installed)\n");
+    if ((argi = bench_parse_args(argc, argv, "bench_decode.json", &opts)) < 0)
+        return 2;
+    if (argi != argc) {
+        bench_usage(argv[0]);
+        return 2;
+    }
+
+    printf("=================================\n");
+    printf("Key and Certificate Decoding Benchmark\n");
+    printf("=================================\n");
+    printf("OpenSSL version: %s\n\n", OpenSSL_version(OPENSSL_VERSION));
+    if (bench_json_begin(&json, &opts, "decode") != 0)
+        return 1;
+
+    printf("  %-10s %-16s %12s %12s %12s\n", "Key", "Case", "decodes/s", "allocs/dec", "bytes/dec");
+    for (size_t i = 0; i < NUM_KEYS; i++) {
+        encoded_key k;
+
+        if (!encode_key(&keys[i], &k)) {
+            printf("  %-10s not available, skipping\n", keys[i].name);
+            bench_json_record_begin(&json);
+            bench_json_str(&json, "key", keys[i].name);
+            bench_json_int(&json, "available", 0);
+            bench_json_record_end(&json);
+            ERR_clear_error();
+            free_encoded(&k);
+            continue;
+        }
+        for (int c = 0; c < NUM_CASES; c++) {
+            case_result r;
+            int ok = run_case((decode_case)c, &k, opts.min_seconds, &r);
+
+            failures += !ok;
+            printf("  %-10s %-16s %12.0f %12.1f %12.0f%s\n", keys[i].name, case_names[c], r.rate,
+                   r.allocs_per_decode, r.bytes_per_decode, ok ? "" : "  FAILED");
+            bench_json_record_begin(&json);
+            bench_json_str(&json, "key", keys[i].name);
+            bench_json_int(&json, "available", 1);
+            bench_json_str(&json, "case", case_names[c]);
+            bench_json_int(&json, "input_bytes", (uint64_t)(c == CASE_PEM_PRIVATEKEY ? k.pem_len
+                                                             : c == CASE_D2I_X509 ? k.cert_len : k.p8_len));
+            bench_json_num(&json, "decodes_per_sec", r.rate);
+            bench_json_num(&json, "allocs_per_decode", r.allocs_per_decode);
+            bench_json_num(&json, "bytes_per_decode", r.bytes_per_decode);
+            bench_json_int(&json, "ok", (uint64_t)ok);
+            bench_json_record_end(&json);
+            ERR_clear_error();
+        }
+        free_encoded(&k);
+    }
+    bench_json_end(&json);
+
+    printf("\n%s\n", failures ? "✗ Some decodes failed" : "✓ All inputs decoded");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,528 @@
+#include <openssl/core_names.h>
+#include <openssl/evp.h>
+#include <openssl/err.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench_common.h"
+#include "bench_perf.h"
+
+/**
+ * EVP throughput benchmark
+ *
+ * Measures MB/s for AEAD ciphers and digests over buffer sizes from
+ * 16 B to 1 MiB. Algorithms are fetched once up front so the numbers
+ * reflect the primitive itself, not provider name resolution.
+ *
+ * Each data point runs for at least BENCH_MIN_SECONDS (BENCH_QUICK_SECONDS
+ * with --quick) and one JSON record is written per (algorithm, size).
+ * With --perf-counters each record also carries the hardware counters
+ * of its timed loop.
+ *
+ * TLS 1.2 CBC records are measured three ways, the paths libssl picks
+ * between depending on enable_asm/enable_avx and encrypt-then-MAC:
+ * - stitched:   AES-128-CBC-HMAC-SHA1/SHA256 in TLS mode (one pass)
+ * - separate:   AES-128-CBC and HMAC over the same record
+ * - multiblock: EVP_CTRL_TLS1_1_MULTIBLOCK_ENCRYPT of 4 and 8 records
+ * Stitched ciphers exist only where the provider has the assembly for
+ * them and are otherwise recorded with "available": 0; --require-stitched
+ * turns that into a failure, for checking assembly-optimized packages.
+ */
+
+static const size_t buffer_sizes[] = {
+    16, 64, 256, 1024, 8192, 16384, 65536, 1048576
+};
+#define NUM_BUFFER_SIZES (sizeof(buffer_sizes) / sizeof(buffer_sizes[0]))
+#define MAX_BUFFER_SIZE 1048576
+
+static const char *cipher_names[] = {
+    "AES-128-GCM",
+    "AES-256-GCM",
+    "AES-128-GCM-SIV",   /* OpenSSL 3.2+ */
+    "ChaCha20-Poly1305",
+    NULL
+};
+
+typedef struct {
+    const char *stitched;    /* EVP_CIPHER_fetch name */
+    const char *separate;    /* Record name of the AES + HMAC baseline */
+    const char *digest;
+    size_t mac_len;
+} stitched_spec;
+
+static const stitched_spec stitched_specs[] = {
+    {"AES-128-CBC-HMAC-SHA1", "AES-128-CBC+HMAC-SHA1", "SHA1", 20},
+    {"AES-128-CBC-HMAC-SHA256", "AES-128-CBC+HMAC-SHA256", "SHA2-256", 32},
+};
+#define NUM_STITCHED (sizeof(stitched_specs) / sizeof(stitched_specs[0]))
+
+/* TLS record payloads: up to one full 16 KiB fragment */
+#define TLS_MAX_FRAGMENT 16384
+#define TLS_EXPLICIT_IV 16
+#define TLS_RECORD_ROOM (TLS_EXPLICIT_IV + TLS_MAX_FRAGMENT + 256)
+
+static const char *digest_names[] = {
+    "SHA2-256",
+    "SHA2-512",
+    "SHA3-256",
+    NULL
+};
+
+static bench_perf perf;
+
+typedef int (*bench_op)(void *arg, unsigned char *buf, size_t len);
+
+typedef struct {
+    EVP_CIPHER_CTX *ctx;
+    unsigned char key[32];
+    unsigned char iv[12];
+    unsigned char *out;
+} cipher_arg;
+
+typedef struct {
+    EVP_MD_CTX *ctx;
+    const EVP_MD *md;
+} digest_arg;
+
+typedef struct {
+    EVP_CIPHER_CTX *ctx;
+    EVP_MAC_CTX *mac;        /* separate: HMAC over header + payload */
+    unsigned char iv[16];
+    unsigned char *out;
+    size_t out_size;
+    unsigned int interleave; /* multiblock: records per call */
+    uint64_t seq;
+} record_arg;
+
+/* TLS 1.2 MAC header: seq_num(8) type(1) version(2) length(2) */
+static void tls_header(unsigned char hdr[13], uint64_t seq, size_t len) {
+    for (int i = 7; i >= 0; i--, seq >>= 8)
+        hdr[i] = (unsigned char)seq;
+    hdr[8] = 23;   /* application_data */
+    hdr[9] = 3;
+    hdr[10] = 3;
+    hdr[11] = (unsigned char)(len >> 8);
+    hdr[12] = (unsigned char)len;
+}
+
+/*
+ * One record through a stitched cipher, as libssl's tls1_enc does it: the
+ * TLS1 AAD control sets the header and returns the MAC + padding length,
+ * then one EVP_Cipher call MACs, pads and encrypts. buf holds the explicit
+ * IV followed by the payload.
+ */
+static int stitched_seal(void *arg, unsigned char *buf, size_t len) {
+    record_arg *r = arg;
+    unsigned char hdr[13];
+    int pad;
+
+    tls_header(hdr, r->seq++, TLS_EXPLICIT_IV + len);
+    pad = EVP_CIPHER_CTX_ctrl(r->ctx, EVP_CTRL_AEAD_TLS1_AAD, sizeof(hdr), hdr);
+    return pad > 0 && TLS_EXPLICIT_IV + len + (size_t)pad <= r->out_size
+        && EVP_Cipher(r->ctx, r->out, buf, (unsigned int)(TLS_EXPLICIT_IV + len + (size_t)pad)) > 0;
+}
+
+/* The same record with AES-128-CBC and HMAC as two passes */
+static int separate_seal(void *arg, unsigned char *buf, size_t len) {
+    record_arg *r = arg;
+    unsigned char hdr[13], mac[EVP_MAX_MD_SIZE];
+    size_t maclen = 0;
+    int outl = 0, tmpl = 0, tail = 0;
+
+    tls_header(hdr, r->seq++, len);
+    if (!EVP_MAC_init(r->mac, NULL, 0, NULL)
+        || !EVP_MAC_update(r->mac, hdr, sizeof(hdr))
+        || !EVP_MAC_update(r->mac, buf + TLS_EXPLICIT_IV, len)
+        || !EVP_MAC_final(r->mac, mac, &maclen, sizeof(mac)))
+        return 0;
+    return EVP_EncryptInit_ex2(r->ctx, NULL, NULL, r->iv, NULL)
+        && EVP_EncryptUpdate(r->ctx, r->out, &outl, buf, (int)(TLS_EXPLICIT_IV + len))
+        && EVP_EncryptUpdate(r->ctx, r->out + outl, &tail, mac, (int)maclen)
+        && EVP_EncryptFinal_ex(r->ctx, r->out + outl + tail, &tmpl);
+}
+
+/*
+ * len bytes as interleave records of len / interleave bytes, encrypted in
+ * one call the way libssl's multiblock write path does.
+ */
+static int multiblock_seal(void *arg, unsigned char *buf, size_t len) {
+    record_arg *r = arg;
+    EVP_CTRL_TLS1_1_MULTIBLOCK_PARAM mb;
+    unsigned char hdr[13];
+    int packlen;
+
+    tls_header(hdr, r->seq, 0);
+    memset(&mb, 0, sizeof(mb));
+    mb.inp = hdr;
+    mb.len = len;
+    mb.interleave = r->interleave;
+    packlen = EVP_CIPHER_CTX_ctrl(r->ctx, EVP_CTRL_TLS1_1_MULTIBLOCK_AAD, sizeof(mb), &mb);
+    if (packlen <= 0 || (size_t)packlen > r->out_size)
+        return 0;
+    mb.out = r->out;
+    mb.inp = buf;
+    mb.len = len;
+    mb.interleave = r->interleave;
+    r->seq += r->interleave;
+    return EVP_CIPHER_CTX_ctrl(r->ctx, EVP_CTRL_TLS1_1_MULTIBLOCK_ENCRYPT, sizeof(mb), &mb) > 0;
+}
+
+static int aead_seal(void *arg, unsigned char *buf, size_t len) {
+    cipher_arg *c = arg;
+    unsigned char tag[16];
+    int outl = 0, tmpl = 0;
+
+    /* Re-keying is not needed per record; only the nonce changes */
+    if (!EVP_EncryptInit_ex2(c->ctx, NULL, NULL, c->iv, NULL))
+        return 0;
+    if (!EVP_EncryptUpdate(c->ctx, c->out, &outl, buf, (int)len))
+        return 0;
+    if (!EVP_EncryptFinal_ex(c->ctx, c->out + outl, &tmpl))
+        return 0;
+    if (!EVP_CIPHER_CTX_ctrl(c->ctx, EVP_CTRL_AEAD_GET_TAG, sizeof(tag), tag))
+        return 0;
+    c->iv[0]++;
+    return 1;
+}
+
+static int digest_once(void *arg, unsigned char *buf, size_t len) {
+    digest_arg *d = arg;
+    unsigned char md[EVP_MAX_MD_SIZE];
+    unsigned int mdlen;
+
+    return EVP_DigestInit_ex2(d->ctx, d->md, NULL)
+        && EVP_DigestUpdate(d->ctx, buf, len)
+        && EVP_DigestFinal_ex(d->ctx, md, &mdlen);
+}
+
+/**
+ * Run op over buf until at least min_seconds have elapsed.
+ * Returns MB/s (10^6 bytes per second) or a negative value on failure.
+ */
+static double measure(bench_op op, void *arg, unsigned char *buf, size_t len,
+                      double min_seconds, unsigned long long *iterations,
+                      bench_perf_sample *counters) {
+    unsigned long long count = 0, batch = 1;
+    double start, elapsed;
+
+    /* Warm up caches and lazy provider state outside the timed region */
+    if (!op(arg, buf, len))
+        return -1.0;
+
+    bench_perf_start(&perf);
+    start = bench_now();
+    do {
+        for (unsigned long long i = 0; i < batch; i++) {
+            if (!op(arg, buf, len))
+                return -1.0;
+        }
+        count += batch;
+        if (batch < (1ULL << 20))
+            batch *= 2;
+        elapsed = bench_now() - start;
+    } while (elapsed < min_seconds);
+    bench_perf_stop(&perf, counters);
+
+    *iterations = count;
+    return (double)count * (double)len / elapsed / 1e6;
+}
+
+static void report(bench_json *json, const char *type, const char *name,
+                   size_t len, unsigned long long iterations, double mbps,
+                   const bench_perf_sample *counters) {
+    if (perf.enabled)
+        printf("  %-26s %8zu B  %12.2f MB/s  IPC %5.2f  %10.1f cycles/op\n", name, len, mbps,
+               bench_perf_ipc(counters),
+               iterations ? (double)counters->values[BENCH_PERF_CYCLES] / (double)iterations : 0.0);
+    else
+        printf("  %-26s %8zu B  %12.2f MB/s\n", name, len, mbps);
+    bench_json_record_begin(json);
+    bench_json_str(json, "type", type);
+    bench_json_str(json, "algorithm", name);
+    bench_json_int(json, "buffer_size", len);
+    bench_json_int(json, "iterations", iterations);
+    bench_json_num(json, "mb_per_s", mbps);
+    if (perf.enabled)
+        bench_perf_json(json, counters, iterations);
+    bench_json_record_end(json);
+}
+
+static void report_unavailable(bench_json *json, const char *type, const char *name) {
+    printf("  %-26s not available\n", name);
+    bench_json_record_begin(json);
+    bench_json_str(json, "type", type);
+    bench_json_str(json, "algorithm", name);
+    bench_json_int(json, "available", 0);
+    bench_json_record_end(json);
+}
+
+static int bench_ciphers(bench_json *json, const bench_options *opts,
+                         unsigned char *buf) {
+    int failures = 0;
+    cipher_arg c;
+
+    printf("\nCipher throughput (AEAD seal incl. tag)\n");
+    c.out = malloc(MAX_BUFFER_SIZE + EVP_MAX_BLOCK_LENGTH);
+    c.ctx = EVP_CIPHER_CTX_new();
+    if (c.out == NULL || c.ctx == NULL) {
+        fprintf(stderr, "ERROR: Out of memory\n");
+        free(c.out);
+        EVP_CIPHER_CTX_free(c.ctx);
+        return 1;
+    }
+    memset(c.key, 0x42, sizeof(c.key));
+    memset(c.iv, 0x24, sizeof(c.iv));
+
+    for (int i = 0; cipher_names[i] != NULL; i++) {
+        EVP_CIPHER *cipher = EVP_CIPHER_fetch(NULL, cipher_names[i], NULL);
+        if (cipher == NULL) {
+            printf("⚠ %s not available, skipping\n", cipher_names[i]);
+            continue;
+        }
+        if (!EVP_EncryptInit_ex2(c.ctx, cipher, c.key, c.iv, NULL)) {
+            fprintf(stderr, "ERROR: EVP_EncryptInit_ex2 failed for %s\n", cipher_names[i]);
+            ERR_print_errors_fp(stderr);
+            EVP_CIPHER_free(cipher);
+            failures++;
+            continue;
+        }
+
+        for (size_t s = 0; s < NUM_BUFFER_SIZES; s++) {
+            unsigned long long iterations = 0;
+            bench_perf_sample counters;
+            double mbps = measure(aead_seal, &c, buf, buffer_sizes[s],
+                                  opts->min_seconds, &iterations, &counters);
+            if (mbps < 0) {
+                fprintf(stderr, "ERROR: %s failed at %zu bytes\n",
+                        cipher_names[i], buffer_sizes[s]);
+                failures++;
+                break;
+            }
+            report(json, "cipher", cipher_names[i], buffer_sizes[s], iterations, mbps,
+                   &counters);
+        }
+        EVP_CIPHER_free(cipher);
+    }
+
+    EVP_CIPHER_CTX_free(c.ctx);
+    free(c.out);
+    return failures;
+}
+
+static int bench_digests(bench_json *json, const bench_options *opts,
+                         unsigned char *buf) {
+    int failures = 0;
+    digest_arg d;
+
+    printf("\nDigest throughput\n");
+    d.ctx = EVP_MD_CTX_new();
+    if (d.ctx == NULL) {
+        fprintf(stderr, "ERROR: Failed to create EVP_MD_CTX\n");
+        return 1;
+    }
+
+    for (int i = 0; digest_names[i] != NULL; i++) {
+        EVP_MD *md = EVP_MD_fetch(NULL, digest_names[i], NULL);
+        if (md == NULL) {
+            printf("⚠ %s not available, skipping\n", digest_names[i]);
+            continue;
+        }
+        d.md = md;
+
+        for (size_t s = 0; s < NUM_BUFFER_SIZES; s++) {
+            unsigned long long iterations = 0;
+            bench_perf_sample counters;
+            double mbps = measure(digest_once, &d, buf, buffer_sizes[s],
+                                  opts->min_seconds, &iterations, &counters);
+            if (mbps < 0) {
+                fprintf(stderr, "ERROR: %s failed at %zu bytes\n",
+                        digest_names[i], buffer_sizes[s]);
+                failures++;
+                break;
+            }
+            report(json, "digest", digest_names[i], buffer_sizes[s], iterations, mbps,
+                   &counters);
+        }
+        EVP_MD_free(md);
+    }
+
+    EVP_MD_CTX_free(d.ctx);
+    return failures;
+}
+
+/* Stitched cipher keyed for TLS encryption, or NULL when the build lacks it */
+static EVP_CIPHER_CTX *stitched_ctx(const stitched_spec *spec, EVP_CIPHER **cipher_out) {
+    EVP_CIPHER *cipher = EVP_CIPHER_fetch(NULL, spec->stitched, NULL);
+    EVP_CIPHER_CTX *ctx = cipher != NULL ? EVP_CIPHER_CTX_new() : NULL;
+    unsigned char key[16], iv[16], mac_key[32];
+
+    memset(key, 0x42, sizeof(key));
+    memset(iv, 0x24, sizeof(iv));
+    memset(mac_key, 0x5a, sizeof(mac_key));
+    if (ctx == NULL || !EVP_EncryptInit_ex2(ctx, cipher, key, iv, NULL)
+        || EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_AEAD_SET_MAC_KEY, (int)spec->mac_len, mac_key) <= 0) {
+        EVP_CIPHER_CTX_free(ctx);
+        EVP_CIPHER_free(cipher);
+        ERR_clear_error();
+        return NULL;
+    }
+    *cipher_out = cipher;
+    return ctx;
+}
+
+static int run_records(bench_json *json, const bench_options *opts, unsigned char *buf,
+                       const char *type, const char *name, bench_op op, record_arg *r) {
+    for (size_t s = 0; s < NUM_BUFFER_SIZES && buffer_sizes[s] <= TLS_MAX_FRAGMENT; s++) {
+        unsigned long long iterations = 0;
+        bench_perf_sample counters;
+        double mbps = measure(op, r, buf, buffer_sizes[s], opts->min_seconds, &iterations, &counters);
+
+        if (mbps < 0) {
+            fprintf(stderr, "ERROR: %s failed at %zu bytes\n", name, buffer_sizes[s]);
+            ERR_print_errors_fp(stderr);
+            return 1;
+        }
+        report(json, type, name, buffer_sizes[s], iterations, mbps, &counters);
+    }
+    return 0;
+}
+
+static int bench_stitched(bench_json *json, const bench_options *opts, unsigned char *buf,
+                          int require) {
+    unsigned char key[16], mac_key[32];
+    int failures = 0;
+    record_arg r;
+
+    printf("\nTLS 1.2 CBC records (stitched vs separate AES + HMAC)\n");
+    memset(&r, 0, sizeof(r));
+    /* Room for 8 interleaved full records plus their headers, IVs and MACs */
+    r.out_size = 8 * TLS_RECORD_ROOM;
+    if ((r.out = malloc(r.out_size)) == NULL) {
+        fprintf(stderr, "ERROR: Out of memory\n");
+        return 1;
+    }
+    memset(key, 0x42, sizeof(key));
+    memset(r.iv, 0x24, sizeof(r.iv));
+    memset(mac_key, 0x5a, sizeof(mac_key));
+
+    for (size_t i = 0; i < NUM_STITCHED; i++) {
+        const stitched_spec *spec = &stitched_specs[i];
+        EVP_CIPHER *cbc = EVP_CIPHER_fetch(NULL, "AES-128-CBC", NULL), *cipher = NULL;
+        OSSL_PARAM params[2];
+        EVP_MAC *hmac = EVP_MAC_fetch(NULL, "HMAC", NULL);
+
+        params[0] = OSSL_PARAM_construct_utf8_string(OSSL_MAC_PARAM_DIGEST, (char *)spec->digest, 0);
+        params[1] = OSSL_PARAM_construct_end();
+        r.ctx = EVP_CIPHER_CTX_new();
+        r.mac = hmac != NULL ? EVP_MAC_CTX_new(hmac) : NULL;
+        if (cbc == NULL || r.ctx == NULL || r.mac == NULL
+            || !EVP_EncryptInit_ex2(r.ctx, cbc, key, r.iv, NULL)
+            || !EVP_MAC_init(r.mac, mac_key, spec->mac_len, params)) {
+            fprintf(stderr, "ERROR: Cannot set up %s\n", spec->separate);
+            ERR_print_errors_fp(stderr);
+            failures++;
+        } else {
+            failures += run_records(json, opts, buf, "stitched", spec->separate, separate_seal, &r);
+        }
+        EVP_CIPHER_CTX_free(r.ctx);
+        EVP_MAC_CTX_free(r.mac);
+        EVP_MAC_free(hmac);
+        EVP_CIPHER_free(cbc);
+        r.mac = NULL;
+
+        if ((r.ctx = stitched_ctx(spec, &cipher)) == NULL) {
+            report_unavailable(json, "stitched", spec->stitched);
+            report_unavailable(json, "multiblock", spec->stitched);
+            failures += require;
+            continue;
+        }
+        failures += run_records(json, opts, buf, "stitched", spec->stitched, stitched_seal, &r);
+
+        /* libssl uses 4 records per call, 8 once a write covers 8 fragments */
+        if (!(EVP_CIPHER_get_flags(cipher) & EVP_CIPH_FLAG_TLS1_1_MULTIBLOCK)
+            || EVP_CIPHER_CTX_ctrl(r.ctx, EVP_CTRL_TLS1_1_MULTIBLOCK_MAX_BUFSIZE, TLS_MAX_FRAGMENT, NULL) <= 0) {
+            report_unavailable(json, "multiblock", spec->stitched);
+            failures += require;
+        } else {
+            for (unsigned int interleave = 4; interleave <= 8; interleave *= 2) {
+                size_t len = (size_t)interleave * TLS_MAX_FRAGMENT;
+                unsigned long long iterations = 0;
+                bench_perf_sample counters;
+                char name[64];
+                double mbps;
+
+                r.interleave = interleave;
+                mbps = measure(multiblock_seal, &r, buf, len, opts->min_seconds, &iterations, &counters);
+                snprintf(name, sizeof(name), "%s x%u", spec->stitched, interleave);
+                if (mbps < 0) {
+                    /* The provider declines without the AVX code path */
+                    report_unavailable(json, "multiblock", name);
+                    ERR_clear_error();
+                    failures += require;
+                    break;
+                }
+                report(json, "multiblock", name, len, iterations, mbps, &counters);
+            }
+        }
+        EVP_CIPHER_CTX_free(r.ctx);
+        EVP_CIPHER_free(cipher);
+    }
+    free(r.out);
+    return failures;
+}
+
+int main(int argc, char **argv) {
+    bench_options opts;
+    bench_json json;
+    unsigned char *buf;
+    int failures = 0, require_stitched = 0;
+    int argi = bench_parse_args(argc, argv, "bench_evp.json", &opts);
+
+    if (argi < 0)
+        return 2;
+    for (; argi < argc; argi++) {
+        if (strcmp(argv[argi], "--require-stitched") == 0) {
+            require_stitched = 1;
+        } else {
+            fprintf(stderr, "Usage: %s [--quick] [--json PATH] [--perf-counters] [--require-stitched]\n",
+                    argv[0]);
+            return 2;
+        }
+    }
+
+    printf("=================================\n");
+    printf("OpenSSL EVP Throughput Benchmark\n");
+    printf("=================================\n");
+    printf("OpenSSL version: %s\n", OpenSSL_version(OPENSSL_VERSION));
+    if (opts.perf_counters && !bench_perf_open(&perf))
+        printf("⚠ Hardware counters unavailable (perf_event_open), reporting wall clock only\n");
+
+    buf = malloc(MAX_BUFFER_SIZE);
+    if (buf == NULL) {
+        fprintf(stderr, "ERROR: Out of memory\n");
+        return 1;
+    }
+    memset(buf, 0xa5, MAX_BUFFER_SIZE);
+
+    if (bench_json_begin(&json, &opts, "evp") != 0) {
+        free(buf);
+        return 1;
+    }
+
+    failures += bench_ciphers(&json, &opts, buf);
+    failures += bench_stitched(&json, &opts, buf, require_stitched);
+    failures += bench_digests(&json, &opts, buf);
+
+    bench_json_end(&json);
+    bench_perf_close(&perf);
+    free(buf);
+
+    printf("\n=================================\n");
+    if (failures == 0) {
+        printf("✅ EVP benchmark completed (%s)\n", opts.json_path);
+        return 0;
+    }
+    printf("❌ %d benchmark(s) FAILED\n", failures);
+    return 1;
+}
@@ -0,0 +1,213 @@
+#include <openssl/evp.h>
+#include <openssl/err.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench_common.h"
+#include "sparetools_algcache.h"
+
+/**
+ * Algorithm fetch latency benchmark
+ *
+ * Compares three ways of getting at an algorithm before a 64 B digest
+ * or AEAD seal, the sizes where lookup cost is most visible:
+ * - implicit:  EVP_sha256()/EVP_aes_128_gcm() passed to *_Init_ex, which
+ *              fetches from the provider store on every init
+ * - explicit:  EVP_MD_fetch()/EVP_CIPHER_fetch() + free per operation
+ * - cached:    handle pinned once in a sparetools_algcache
+ *
+ * Also reports the bare lookup cost (no crypto) for explicit and cached.
+ */
+
+#define MESSAGE_SIZE 64
+
+typedef enum {
+    MODE_IMPLICIT,
+    MODE_EXPLICIT,
+    MODE_CACHED
+} fetch_mode;
+
+static const char *mode_names[] = {"implicit", "explicit", "cached"};
+
+typedef struct {
+    fetch_mode mode;
+    const SPARETOOLS_ALGCACHE *cache;
+    EVP_MD_CTX *md_ctx;
+    EVP_CIPHER_CTX *cipher_ctx;
+    unsigned char msg[MESSAGE_SIZE];
+    unsigned char out[MESSAGE_SIZE + EVP_MAX_BLOCK_LENGTH];
+} fetch_arg;
+
+typedef int (*fetch_op)(fetch_arg *arg);
+
+static int digest_op(fetch_arg *arg) {
+    unsigned char md_out[EVP_MAX_MD_SIZE];
+    unsigned int mdlen;
+    EVP_MD *fetched = NULL;
+    const EVP_MD *md;
+    int ok;
+
+    switch (arg->mode) {
+    case MODE_IMPLICIT:
+        md = EVP_sha256();
+        break;
+    case MODE_EXPLICIT:
+        md = fetched = EVP_MD_fetch(NULL, "SHA2-256", NULL);
+        break;
+    default:
+        md = sparetools_algcache_md(arg->cache, "SHA2-256");
+        break;
+    }
+    ok = md != NULL
+        && EVP_DigestInit_ex(arg->md_ctx, md, NULL)
+        && EVP_DigestUpdate(arg->md_ctx, arg->msg, sizeof(arg->msg))
+        && EVP_DigestFinal_ex(arg->md_ctx, md_out, &mdlen);
+    EVP_MD_free(fetched);
+    return ok;
+}
+
+static int cipher_op(fetch_arg *arg) {
+    static const unsigned char key[16] = {0};
+    static const unsigned char iv[12] = {0};
+    EVP_CIPHER *fetched = NULL;
+    const EVP_CIPHER *cipher;
+    int outl, ok;
+
+    switch (arg->mode) {
+    case MODE_IMPLICIT:
+        cipher = EVP_aes_128_gcm();
+        break;
+    case MODE_EXPLICIT:
+        cipher = fetched = EVP_CIPHER_fetch(NULL, "AES-128-GCM", NULL);
+        break;
+    default:
+        cipher = sparetools_algcache_cipher(arg->cache, "AES-128-GCM");
+        break;
+    }
+    ok = cipher != NULL
+        && EVP_EncryptInit_ex(arg->cipher_ctx, cipher, NULL, key, iv)
+        && EVP_EncryptUpdate(arg->cipher_ctx, arg->out, &outl, arg->msg, sizeof(arg->msg))
+        && EVP_EncryptFinal_ex(arg->cipher_ctx, arg->out + outl, &outl);
+    EVP_CIPHER_free(fetched);
+    return ok;
+}
+
+static int lookup_op(fetch_arg *arg) {
+    if (arg->mode == MODE_EXPLICIT) {
+        EVP_MD *md = EVP_MD_fetch(NULL, "SHA2-256", NULL);
+        int ok = md != NULL;
+
+        EVP_MD_free(md);
+        return ok;
+    }
+    return sparetools_algcache_md(arg->cache, "SHA2-256") != NULL;
+}
+
+/** Nanoseconds per call of op, or a negative value on failure */
+static double measure_ns(fetch_op op, fetch_arg *arg, double min_seconds,
+                         unsigned long long *iterations) {
+    unsigned long long count = 0, batch = 64;
+    double start, elapsed;
+
+    if (!op(arg))
+        return -1.0;
+
+    start = bench_now();
+    do {
+        for (unsigned long long i = 0; i < batch; i++) {
+            if (!op(arg))
+                return -1.0;
+        }
+        count += batch;
+        if (batch < (1ULL << 20))
+            batch *= 2;
+        elapsed = bench_now() - start;
+    } while (elapsed < min_seconds);
+
+    *iterations = count;
+    return elapsed * 1e9 / (double)count;
+}
+
+static int run_case(bench_json *json, const bench_options *opts, const char *operation,
+                    fetch_op op, fetch_arg *arg) {
+    unsigned long long iterations = 0;
+    double ns = measure_ns(op, arg, opts->min_seconds, &iterations);
+
+    if (ns < 0) {
+        fprintf(stderr, "ERROR: %s/%s failed\n", operation, mode_names[arg->mode]);
+        ERR_print_errors_fp(stderr);
+        return 1;
+    }
+    printf("  %-18s %-9s %10.1f ns/op\n", operation, mode_names[arg->mode], ns);
+
+    bench_json_record_begin(json);
+    bench_json_str(json, "operation", operation);
+    bench_json_str(json, "mode", mode_names[arg->mode]);
+    bench_json_int(json, "iterations", iterations);
+    bench_json_num(json, "ns_per_op", ns);
+    bench_json_record_end(json);
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    bench_options opts;
+    bench_json json;
+    SPARETOOLS_ALGCACHE *cache;
+    fetch_arg arg;
+    int failures = 0;
+
+    if (bench_parse_args(argc, argv, "bench_fetch.json", &opts) != argc)
+        return 2;
+
+    printf("=================================\n");
+    printf("OpenSSL Algorithm Fetch Benchmark\n");
+    printf("=================================\n");
+    printf("OpenSSL version: %s\n", OpenSSL_version(OPENSSL_VERSION));
+
+    cache = sparetools_algcache_new(NULL, NULL, NULL, NULL);
+    if (cache == NULL
+        || sparetools_algcache_md(cache, "sha2-256") == NULL
+        || sparetools_algcache_cipher(cache, "AES-128-GCM") == NULL) {
+        fprintf(stderr, "ERROR: sparetools_algcache is missing default algorithms\n");
+        sparetools_algcache_free(cache);
+        return 1;
+    }
+    printf("Cached algorithms: %d\n\n", sparetools_algcache_count(cache));
+
+    memset(&arg, 0, sizeof(arg));
+    memset(arg.msg, 0x5a, sizeof(arg.msg));
+    arg.cache = cache;
+    arg.md_ctx = EVP_MD_CTX_new();
+    arg.cipher_ctx = EVP_CIPHER_CTX_new();
+    if (arg.md_ctx == NULL || arg.cipher_ctx == NULL
+        || bench_json_begin(&json, &opts, "fetch") != 0) {
+        EVP_MD_CTX_free(arg.md_ctx);
+        EVP_CIPHER_CTX_free(arg.cipher_ctx);
+        sparetools_algcache_free(cache);
+        return 1;
+    }
+
+    for (int m = MODE_IMPLICIT; m <= MODE_CACHED; m++) {
+        arg.mode = (fetch_mode)m;
+        failures += run_case(&json, &opts, "sha256-64B", digest_op, &arg);
+        failures += run_case(&json, &opts, "aes-128-gcm-64B", cipher_op, &arg);
+    }
+    for (int m = MODE_EXPLICIT; m <= MODE_CACHED; m++) {
+        arg.mode = (fetch_mode)m;
+        failures += run_case(&json, &opts, "lookup-only", lookup_op, &arg);
+    }
+
+    bench_json_end(&json);
+    EVP_MD_CTX_free(arg.md_ctx);
+    EVP_CIPHER_CTX_free(arg.cipher_ctx);
+    sparetools_algcache_free(cache);
+
+    printf("\n=================================\n");
+    if (failures == 0) {
+        printf("✅ Fetch benchmark completed (%s)\n", opts.json_path);
+        return 0;
+    }
+    printf("❌ %d benchmark(s) FAILED\n", failures);
+    return 1;
+}
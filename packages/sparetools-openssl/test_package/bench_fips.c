@@ -0,0 +1,483 @@
+#include <openssl/core_names.h>
+#include <openssl/err.h>
+#include <openssl/evp.h>
+#include <openssl/provider.h>
+#include <openssl/self_test.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench_common.h"
+
+/**
+ * FIPS vs default provider parity benchmark
+ *
+ * Runs the same workload under the default and the FIPS provider, each
+ * loaded into its own OSSL_LIB_CTX and fetched with "provider=default"
+ * or "fips=yes", and reports the FIPS result relative to default:
+ * - startup: OSSL_PROVIDER_load() including the FIPS power-on self-tests
+ *            (integrity check and KATs), in a fresh library context each
+ *            round, reported as min/median
+ * - AEAD seal: AES-128-GCM, AES-256-GCM (MB/s)
+ * - digests:   SHA2-256, SHA2-512 (MB/s)
+ * - signatures: ECDSA P-256, ECDSA P-384, RSA-3072 sign and verify of a
+ *               SHA2-256 digest (ops/s)
+ *
+ * The FIPS provider needs its installed module configuration: pass the
+ * openssl.cnf that includes fipsmodule.cnf with --config, and the
+ * directory holding fips.so with --module-dir unless it is the default
+ * MODULESDIR. Without a loadable FIPS provider only the default numbers
+ * are reported.
+ */
+
+static const size_t buffer_sizes[] = {64, 1024, 16384};
+#define NUM_BUFFER_SIZES (sizeof(buffer_sizes) / sizeof(buffer_sizes[0]))
+#define MAX_BUFFER_SIZE 16384
+
+static const char *cipher_names[] = {"AES-128-GCM", "AES-256-GCM", NULL};
+static const char *digest_names[] = {"SHA2-256", "SHA2-512", NULL};
+
+static const struct {
+    const char *name;
+    const char *type;
+    const char *param;  /* curve name or RSA bits */
+} signature_algs[] = {
+    {"ECDSA-P-256", "EC", "P-256"},
+    {"ECDSA-P-384", "EC", "P-384"},
+    {"RSA-3072", "RSA", "3072"},
+    {NULL, NULL, NULL}
+};
+
+enum { PROV_DEFAULT, PROV_FIPS, NUM_PROVIDERS };
+
+typedef struct {
+    const char *name;
+    const char *propq;
+    OSSL_LIB_CTX *libctx;
+    OSSL_PROVIDER *prov;
+    OSSL_PROVIDER *base;
+} provider_env;
+
+typedef struct {
+    const char *config;
+    const char *module_dir;
+} load_options;
+
+typedef int (*bench_op)(void *arg, unsigned char *buf, size_t len);
+
+typedef struct {
+    EVP_CIPHER_CTX *ctx;
+    unsigned char iv[12];
+    unsigned char out[MAX_BUFFER_SIZE + EVP_MAX_BLOCK_LENGTH];
+} cipher_arg;
+
+typedef struct {
+    EVP_MD_CTX *ctx;
+    const EVP_MD *md;
+} digest_arg;
+
+typedef struct {
+    EVP_PKEY_CTX *ctx;
+    unsigned char sig[512];      /* Reference signature for verify */
+    size_t sig_len;
+    unsigned char scratch[512];  /* Output of timed signs (DER length varies) */
+    int verify;
+} signature_arg;
+
+static int self_test_count(const OSSL_PARAM params[], void *arg) {
+    const OSSL_PARAM *p = OSSL_PARAM_locate_const(params, OSSL_PROV_PARAM_SELF_TEST_PHASE);
+    const char *phase = NULL;
+
+    if (p != NULL && OSSL_PARAM_get_utf8_string_ptr(p, &phase)
+        && strcmp(phase, OSSL_SELF_TEST_PHASE_PASS) == 0)
+        (*(int *)arg)++;
+    return 1;
+}
+
+static void provider_env_free(provider_env *env) {
+    OSSL_PROVIDER_unload(env->base);
+    OSSL_PROVIDER_unload(env->prov);
+    OSSL_LIB_CTX_free(env->libctx);
+    env->base = env->prov = NULL;
+    env->libctx = NULL;
+}
+
+/**
+ * Fresh library context with the provider loaded (plus base for FIPS).
+ * Returns the seconds spent in config loading and OSSL_PROVIDER_load,
+ * or a negative value when the provider cannot be loaded.
+ */
+static double provider_env_load(provider_env *env, const load_options *load, int *self_tests) {
+    double start, elapsed;
+
+    env->libctx = OSSL_LIB_CTX_new();
+    if (env->libctx == NULL)
+        return -1.0;
+    OSSL_SELF_TEST_set_callback(env->libctx, self_test_count, self_tests);
+    if (load->module_dir != NULL)
+        OSSL_PROVIDER_set_default_search_path(env->libctx, load->module_dir);
+
+    start = bench_now();
+    if (load->config != NULL && strcmp(env->name, "fips") == 0
+        && !OSSL_LIB_CTX_load_config(env->libctx, load->config)) {
+        provider_env_free(env);
+        return -1.0;
+    }
+    env->prov = OSSL_PROVIDER_load(env->libctx, env->name);
+    elapsed = bench_now() - start;
+    if (env->prov == NULL) {
+        provider_env_free(env);
+        return -1.0;
+    }
+    if (strcmp(env->name, "fips") == 0)
+        env->base = OSSL_PROVIDER_load(env->libctx, "base");
+    return elapsed;
+}
+
+/**
+ * Time provider loading over several fresh library contexts and leave
+ * the last one loaded for the throughput runs.
+ */
+static int bench_startup(bench_json *json, const bench_options *opts, const load_options *load,
+                         provider_env *env) {
+    double samples[10];
+    int rounds = opts->quick ? 2 : 10, self_tests = 0;
+
+    for (int r = 0; r < rounds; r++) {
+        self_tests = 0;
+        samples[r] = provider_env_load(env, load, &self_tests);
+        if (samples[r] < 0) {
+            ERR_clear_error();
+            return 0;
+        }
+        if (r + 1 < rounds)
+            provider_env_free(env);
+    }
+
+    double min_ms = bench_percentile(samples, rounds, 0) * 1e3;
+    double median_ms = bench_percentile(samples, rounds, 50) * 1e3;
+
+    printf("  %-8s load %8.3f ms min  %8.3f ms median  %3d self-tests\n",
+           env->name, min_ms, median_ms, self_tests);
+    bench_json_record_begin(json);
+    bench_json_str(json, "type", "startup");
+    bench_json_str(json, "provider", env->name);
+    bench_json_int(json, "rounds", (uint64_t)rounds);
+    bench_json_int(json, "self_tests", (uint64_t)self_tests);
+    bench_json_num(json, "load_ms_min", min_ms);
+    bench_json_num(json, "load_ms_median", median_ms);
+    bench_json_record_end(json);
+    return 1;
+}
+
+static int aead_seal(void *arg, unsigned char *buf, size_t len) {
+    cipher_arg *c = arg;
+    unsigned char tag[16];
+    int outl = 0, tmpl = 0;
+
+    if (!EVP_EncryptInit_ex2(c->ctx, NULL, NULL, c->iv, NULL)
+        || !EVP_EncryptUpdate(c->ctx, c->out, &outl, buf, (int)len)
+        || !EVP_EncryptFinal_ex(c->ctx, c->out + outl, &tmpl)
+        || !EVP_CIPHER_CTX_ctrl(c->ctx, EVP_CTRL_AEAD_GET_TAG, sizeof(tag), tag))
+        return 0;
+    c->iv[0]++;
+    return 1;
+}
+
+static int digest_once(void *arg, unsigned char *buf, size_t len) {
+    digest_arg *d = arg;
+    unsigned char md[EVP_MAX_MD_SIZE];
+    unsigned int mdlen;
+
+    return EVP_DigestInit_ex2(d->ctx, d->md, NULL)
+        && EVP_DigestUpdate(d->ctx, buf, len)
+        && EVP_DigestFinal_ex(d->ctx, md, &mdlen);
+}
+
+/* buf holds the SHA2-256 digest being signed */
+static int signature_once(void *arg, unsigned char *buf, size_t len) {
+    signature_arg *s = arg;
+    size_t sig_len = sizeof(s->scratch);
+
+    if (s->verify)
+        return EVP_PKEY_verify(s->ctx, s->sig, s->sig_len, buf, len) == 1;
+    return EVP_PKEY_sign(s->ctx, s->scratch, &sig_len, buf, len) == 1;
+}
+
+/**
+ * Run op until at least min_seconds have elapsed.
+ * Returns operations per second or a negative value on failure.
+ */
+static double measure_ops(bench_op op, void *arg, unsigned char *buf, size_t len,
+                          double min_seconds, unsigned long long *iterations) {
+    unsigned long long count = 0, batch = 1;
+    double start, elapsed;
+
+    if (!op(arg, buf, len))
+        return -1.0;
+
+    start = bench_now();
+    do {
+        for (unsigned long long i = 0; i < batch; i++) {
+            if (!op(arg, buf, len))
+                return -1.0;
+        }
+        count += batch;
+        if (batch < (1ULL << 16))
+            batch *= 2;
+        elapsed = bench_now() - start;
+    } while (elapsed < min_seconds);
+
+    *iterations = count;
+    return (double)count / elapsed;
+}
+
+/**
+ * One record per provider; the FIPS record carries fips_relative, its
+ * rate as a fraction of the default provider's (1.0 = parity).
+ */
+static void report(bench_json *json, const char *type, const char *name, const char *op,
+                   size_t len, const provider_env *envs, const double *rates,
+                   const unsigned long long *iterations, int bytes) {
+    for (int p = 0; p < NUM_PROVIDERS; p++) {
+        if (envs[p].libctx == NULL || rates[p] < 0)
+            continue;
+        double value = bytes ? rates[p] * (double)len / 1e6 : rates[p];
+        if (p == PROV_FIPS && rates[PROV_DEFAULT] > 0)
+            printf("  %-8s %-12s %-6s %6zu B  %12.2f %s  %6.1f%% of default\n", envs[p].name, name, op,
+                   len, value, bytes ? "MB/s " : "ops/s", 100.0 * rates[p] / rates[PROV_DEFAULT]);
+        else
+            printf("  %-8s %-12s %-6s %6zu B  %12.2f %s\n", envs[p].name, name, op, len, value,
+                   bytes ? "MB/s " : "ops/s");
+
+        bench_json_record_begin(json);
+        bench_json_str(json, "type", type);
+        bench_json_str(json, "provider", envs[p].name);
+        bench_json_str(json, "algorithm", name);
+        bench_json_str(json, "operation", op);
+        bench_json_int(json, "buffer_size", len);
+        bench_json_int(json, "iterations", iterations[p]);
+        bench_json_num(json, bytes ? "mb_per_s" : "ops_per_s", value);
+        if (p == PROV_FIPS && rates[PROV_DEFAULT] > 0)
+            bench_json_num(json, "fips_relative", rates[p] / rates[PROV_DEFAULT]);
+        bench_json_record_end(json);
+    }
+}
+
+static int bench_ciphers(bench_json *json, const bench_options *opts, provider_env *envs,
+                         unsigned char *buf) {
+    static const unsigned char key[32] = {0x42};
+    int failures = 0;
+
+    printf("\nCipher throughput (AEAD seal incl. tag)\n");
+    for (int i = 0; cipher_names[i] != NULL; i++) {
+        for (size_t s = 0; s < NUM_BUFFER_SIZES; s++) {
+            double rates[NUM_PROVIDERS] = {-1.0, -1.0};
+            unsigned long long iterations[NUM_PROVIDERS] = {0, 0};
+
+            for (int p = 0; p < NUM_PROVIDERS; p++) {
+                EVP_CIPHER *cipher;
+                cipher_arg c;
+
+                if (envs[p].libctx == NULL)
+                    continue;
+                cipher = EVP_CIPHER_fetch(envs[p].libctx, cipher_names[i], envs[p].propq);
+                memset(c.iv, 0x24, sizeof(c.iv));
+                c.ctx = EVP_CIPHER_CTX_new();
+                if (cipher != NULL && c.ctx != NULL && EVP_EncryptInit_ex2(c.ctx, cipher, key, c.iv, NULL))
+                    rates[p] = measure_ops(aead_seal, &c, buf, buffer_sizes[s], opts->min_seconds,
+                                           &iterations[p]);
+                if (rates[p] < 0) {
+                    fprintf(stderr, "ERROR: %s (%s) failed at %zu bytes\n", cipher_names[i],
+                            envs[p].name, buffer_sizes[s]);
+                    ERR_print_errors_fp(stderr);
+                    failures++;
+                }
+                EVP_CIPHER_CTX_free(c.ctx);
+                EVP_CIPHER_free(cipher);
+            }
+            report(json, "cipher", cipher_names[i], "seal", buffer_sizes[s], envs, rates, iterations, 1);
+        }
+    }
+    return failures;
+}
+
+static int bench_digests(bench_json *json, const bench_options *opts, provider_env *envs,
+                         unsigned char *buf) {
+    int failures = 0;
+
+    printf("\nDigest throughput\n");
+    for (int i = 0; digest_names[i] != NULL; i++) {
+        for (size_t s = 0; s < NUM_BUFFER_SIZES; s++) {
+            double rates[NUM_PROVIDERS] = {-1.0, -1.0};
+            unsigned long long iterations[NUM_PROVIDERS] = {0, 0};
+
+            for (int p = 0; p < NUM_PROVIDERS; p++) {
+                EVP_MD *md;
+                digest_arg d;
+
+                if (envs[p].libctx == NULL)
+                    continue;
+                md = EVP_MD_fetch(envs[p].libctx, digest_names[i], envs[p].propq);
+                d.md = md;
+                d.ctx = EVP_MD_CTX_new();
+                if (md != NULL && d.ctx != NULL)
+                    rates[p] = measure_ops(digest_once, &d, buf, buffer_sizes[s], opts->min_seconds,
+                                           &iterations[p]);
+                if (rates[p] < 0) {
+                    fprintf(stderr, "ERROR: %s (%s) failed at %zu bytes\n", digest_names[i],
+                            envs[p].name, buffer_sizes[s]);
+                    ERR_print_errors_fp(stderr);
+                    failures++;
+                }
+                EVP_MD_CTX_free(d.ctx);
+                EVP_MD_free(md);
+            }
+            report(json, "digest", digest_names[i], "digest", buffer_sizes[s], envs, rates, iterations, 1);
+        }
+    }
+    return failures;
+}
+
+/**
+ * Sign/verify the same SHA2-256 digest with a key generated under each
+ * provider. Key generation itself is not timed.
+ */
+static int bench_signatures(bench_json *json, const bench_options *opts, provider_env *envs) {
+    unsigned char digest[32];
+    int failures = 0;
+
+    memset(digest, 0x5a, sizeof(digest));
+    printf("\nSignatures (SHA2-256 digest)\n");
+    for (int i = 0; signature_algs[i].name != NULL; i++) {
+        EVP_PKEY *keys[NUM_PROVIDERS] = {NULL, NULL};
+        signature_arg args[NUM_PROVIDERS];
+
+        memset(args, 0, sizeof(args));
+        for (int p = 0; p < NUM_PROVIDERS; p++) {
+            if (envs[p].libctx == NULL)
+                continue;
+            if (strcmp(signature_algs[i].type, "RSA") == 0)
+                keys[p] = EVP_PKEY_Q_keygen(envs[p].libctx, envs[p].propq, "RSA",
+                                            (size_t)atoi(signature_algs[i].param));
+            else
+                keys[p] = EVP_PKEY_Q_keygen(envs[p].libctx, envs[p].propq, "EC",
+                                            signature_algs[i].param);
+            if (keys[p] != NULL)
+                args[p].ctx = EVP_PKEY_CTX_new_from_pkey(envs[p].libctx, keys[p], envs[p].propq);
+        }
+
+        for (int verify = 0; verify <= 1; verify++) {
+            double rates[NUM_PROVIDERS] = {-1.0, -1.0};
+            unsigned long long iterations[NUM_PROVIDERS] = {0, 0};
+
+            for (int p = 0; p < NUM_PROVIDERS; p++) {
+                signature_arg *s = &args[p];
+                int ok;
+
+                if (envs[p].libctx == NULL)
+                    continue;
+                ok = s->ctx != NULL
+                    && (verify ? EVP_PKEY_verify_init(s->ctx) : EVP_PKEY_sign_init(s->ctx)) == 1
+                    && EVP_PKEY_CTX_set_signature_md(s->ctx, EVP_sha256()) == 1;
+                if (ok && verify) {
+                    /* Signature to verify, produced by the sign pass */
+                    s->verify = 1;
+                    ok = s->sig_len > 0;
+                } else if (ok) {
+                    s->sig_len = sizeof(s->sig);
+                    ok = EVP_PKEY_sign(s->ctx, s->sig, &s->sig_len, digest, sizeof(digest)) == 1;
+                }
+                if (ok)
+                    rates[p] = measure_ops(signature_once, s, digest, sizeof(digest),
+                                           opts->min_seconds, &iterations[p]);
+                if (rates[p] < 0) {
+                    fprintf(stderr, "ERROR: %s %s (%s) failed\n", signature_algs[i].name,
+                            verify ? "verify" : "sign", envs[p].name);
+                    ERR_print_errors_fp(stderr);
+                    failures++;
+                }
+            }
+            report(json, "signature", signature_algs[i].name, verify ? "verify" : "sign",
+                   sizeof(digest), envs, rates, iterations, 0);
+        }
+
+        for (int p = 0; p < NUM_PROVIDERS; p++) {
+            EVP_PKEY_CTX_free(args[p].ctx);
+            EVP_PKEY_free(keys[p]);
+        }
+    }
+    return failures;
+}
+
+int main(int argc, char **argv) {
+    bench_options opts;
+    bench_json json;
+    load_options load = {NULL, NULL};
+    provider_env envs[NUM_PROVIDERS] = {
+        {"default", "provider=default", NULL, NULL, NULL},
+        {"fips", "fips=yes", NULL, NULL, NULL},
+    };
+    unsigned char *buf;
+    int failures = 0;
+    int argi = bench_parse_args(argc, argv, "bench_fips.json", &opts);
+
+    if (argi < 0)
+        return 2;
+    /* Benchmark-specific options follow the common ones */
+    for (; argi < argc; argi++) {
+        if (strcmp(argv[argi], "--config") == 0 && argi + 1 < argc) {
+            load.config = argv[++argi];
+        } else if (strcmp(argv[argi], "--module-dir") == 0 && argi + 1 < argc) {
+            load.module_dir = argv[++argi];
+        } else {
+            fprintf(stderr, "Usage: %s [--quick] [--json PATH] [--config openssl.cnf] [--module-dir DIR]\n",
+                    argv[0]);
+            return 2;
+        }
+    }
+
+    printf("=================================\n");
+    printf("OpenSSL FIPS Provider Parity Benchmark\n");
+    printf("=================================\n");
+    printf("OpenSSL version: %s\n", OpenSSL_version(OPENSSL_VERSION));
+
+    buf = malloc(MAX_BUFFER_SIZE);
+    if (buf == NULL) {
+        fprintf(stderr, "ERROR: Out of memory\n");
+        return 1;
+    }
+    memset(buf, 0xa5, MAX_BUFFER_SIZE);
+
+    if (bench_json_begin(&json, &opts, "fips") != 0) {
+        free(buf);
+        return 1;
+    }
+
+    printf("\nProvider startup (load + self-tests)\n");
+    if (!bench_startup(&json, &opts, &load, &envs[PROV_DEFAULT])) {
+        fprintf(stderr, "ERROR: default provider failed to load\n");
+        failures++;
+    }
+    if (!bench_startup(&json, &opts, &load, &envs[PROV_FIPS]))
+        printf("⚠ FIPS provider not available (pass --config/--module-dir), reporting default only\n");
+
+    if (envs[PROV_DEFAULT].libctx != NULL || envs[PROV_FIPS].libctx != NULL) {
+        failures += bench_ciphers(&json, &opts, envs, buf);
+        failures += bench_digests(&json, &opts, envs, buf);
+        failures += bench_signatures(&json, &opts, envs);
+    }
+
+    bench_json_end(&json);
+    for (int p = 0; p < NUM_PROVIDERS; p++)
+        provider_env_free(&envs[p]);
+    free(buf);
+
+    printf("\n=================================\n");
+    if (failures == 0) {
+        printf("✅ FIPS parity benchmark completed (%s)\n", opts.json_path);
+        return 0;
+    }
+    printf("❌ %d benchmark(s) FAILED\n", failures);
+    return 1;
+}
@@ -0,0 +1,553 @@
+#include <openssl/ssl.h>
+#include <openssl/err.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench_common.h"
+#include "bench_perf.h"
+#include "bench_tls.h"
+#include "sparetools_memtrace.h"
+#ifdef SPARETOOLS_HAVE_HUGETEXT
+#include "sparetools_hugetext.h"
+#endif
+
+/**
+ * TLS 1.3 handshake benchmark
+ *
+ * Runs full and resumed (session ticket) handshakes between a client and
+ * server SSL_CTX connected by BIO_new_bio_pair, so only libssl/libcrypto
+ * CPU cost is measured. Reports handshakes/s, p50/p99 latency, CPU time
+ * and bytes on the wire (client and server flights, counted on the BIO
+ * pair) per key-exchange group. Groups the library does not provide (the
+ * ML-KEM groups before 3.5) are skipped.
+ *
+ * --cert TYPE selects the server key: EC (P-256, default), RSA, or a
+ * post-quantum signature such as ML-DSA-65 (3.5+) for a fully
+ * post-quantum handshake.
+ *
+ * OpenSSL allocations are traced with sparetools_memtrace and reported
+ * per handshake (including SSL object setup and teardown). Set
+ * SPARETOOLS_MEMTRACE=path to also get the per-call-site histogram.
+ * --perf-counters adds hardware counters per (group, mode), covering the
+ * whole loop including SSL object setup and teardown.
+ *
+ * --hugetext (Linux) first remaps libcrypto/libssl text onto transparent
+ * hugepages with sparetools_hugetext; compare itlb_misses_per_op with
+ * and without it, ideally on a hugepage_text=True package.
+ *
+ * The ttfb-* modes time a request/response exchange from the first
+ * ClientHello to the client reading the first response byte: after a
+ * full handshake (ttfb-full), a ticket resumption (ttfb-resumed) and a
+ * 0-RTT resumption that sends the request as early data, answered with
+ * 0.5-RTT data (ttfb-0rtt; SSL_write_early_data/SSL_read_early_data).
+ * 0-RTT uses the server's default anti-replay protection, which makes
+ * tickets single use (stateful, in the session cache), so every 0-RTT
+ * connection resumes the ticket from the previous one; ttfb-0rtt-noreplay
+ * repeats it with SSL_OP_NO_ANTI_REPLAY, so the difference is the
+ * anti-replay overhead. Over a BIO pair there is no network latency:
+ * each record reports the round trips a real client waits for
+ * (round_trips), and --rtt-ms N adds the modelled time to first byte at
+ * that RTT (ttfb_at_rtt_ms).
+ */
+
+#define MAX_SAMPLES 100000
+#define MIN_SAMPLES 10
+/* ttfb-* request and response sizes (a small HTTP exchange) */
+#define REQUEST_SIZE 512
+#define RESPONSE_SIZE 1024
+#define MAX_EARLY_DATA 16384
+
+static const char *groups[] = {
+    "X25519",
+    "P-256",
+    "X25519MLKEM768",
+    "SecP256r1MLKEM768",
+    "MLKEM768",
+    NULL
+};
+
+typedef struct {
+    double *samples;
+    size_t count;
+    double elapsed;
+    double allocs_per_hs;
+    double bytes_per_hs;
+    double cpu_us_per_hs;        /* Thread CPU time, including SSL setup/teardown */
+    double wire_client;          /* Bytes the client wrote per handshake */
+    double wire_server;
+    size_t total;                /* Handshakes run, including unsampled ones */
+    int round_trips;             /* ttfb-*: client round trips to the first response byte */
+    double early_accepted;       /* ttfb-0rtt*: share of connections whose early data was accepted */
+    bench_perf_sample counters;
+} run_stats;
+
+static bench_perf perf;
+static size_t hugetext_bytes;   /* Text remapped by --hugetext */
+static double rtt_ms;           /* --rtt-ms: network RTT for ttfb_at_rtt_ms */
+static const unsigned char response[RESPONSE_SIZE];
+
+/**
+ * Perform handshakes until min_seconds have elapsed. If session is set,
+ * every client resumes it and a non-resumed handshake is a failure.
+ */
+static int run_handshakes(SSL_CTX *client_ctx, SSL_CTX *server_ctx,
+                          SSL_SESSION *session, double min_seconds,
+                          run_stats *stats) {
+    SPARETOOLS_MEMTRACE_TOTALS before, after;
+    double start = bench_now(), cpu_start = bench_cpu_now();
+    uint64_t wire_client = 0, wire_server = 0;
+    size_t total = 0;
+
+    stats->count = 0;
+    sparetools_memtrace_totals(&before);
+    bench_perf_start(&perf);
+    do {
+        SSL *client, *server;
+        double t0, t1;
+        int ok;
+
+        if (bench_tls_make_ssl_pair(client_ctx, server_ctx, &client, &server) != 0)
+            return 1;
+        if (session != NULL)
+            SSL_set_session(client, session);
+
+        t0 = bench_now();
+        ok = bench_tls_handshake(client, server);
+        t1 = bench_now();
+
+        if (ok && session != NULL && !SSL_session_reused(client)) {
+            fprintf(stderr, "ERROR: Session was not resumed\n");
+            ok = 0;
+        }
+        /* Fresh BIO pair per connection: the counters cover this handshake */
+        wire_client += BIO_number_written(SSL_get_wbio(client));
+        wire_server += BIO_number_written(SSL_get_wbio(server));
+        bench_tls_free_pair(client, server);
+        if (!ok)
+            return 1;
+
+        if (stats->count < MAX_SAMPLES)
+            stats->samples[stats->count++] = t1 - t0;
+        total++;
+        stats->elapsed = bench_now() - start;
+    } while (stats->elapsed < min_seconds || stats->count < MIN_SAMPLES);
+
+    bench_perf_stop(&perf, &stats->counters);
+    sparetools_memtrace_totals(&after);
+    stats->total = total;
+    stats->allocs_per_hs = (double)(after.allocs + after.reallocs - before.allocs - before.reallocs)
+        / (double)total;
+    stats->bytes_per_hs = (double)(after.bytes - before.bytes) / (double)total;
+    stats->cpu_us_per_hs = (bench_cpu_now() - cpu_start) * 1e6 / (double)total;
+    stats->wire_client = (double)wire_client / (double)total;
+    stats->wire_server = (double)wire_server / (double)total;
+    stats->round_trips = 0;
+    return 0;
+}
+
+/** Read exactly len bytes from ssl (peer data is already in the BIO pair) */
+static int read_all(SSL *ssl, unsigned char *buf, size_t len) {
+    size_t done = 0, n;
+
+    while (done < len) {
+        if (!SSL_read_ex(ssl, buf + done, len - done, &n))
+            return 0;
+        done += n;
+    }
+    return 1;
+}
+
+/**
+ * Server side of a 0-RTT connection: read the early-data request and
+ * answer it as 0.5-RTT data. *got is the request bytes read as early
+ * data; 0 when the server rejected it.
+ */
+static int server_early(SSL *server, unsigned char *request, size_t *got) {
+    size_t n, written;
+
+    *got = 0;
+    while (*got < REQUEST_SIZE) {
+        int ret = SSL_read_early_data(server, request + *got, REQUEST_SIZE - *got, &n);
+
+        if (ret == SSL_READ_EARLY_DATA_FINISH)
+            break;
+        if (ret != SSL_READ_EARLY_DATA_SUCCESS)
+            return 0;
+        *got += n;
+    }
+    return *got < REQUEST_SIZE || SSL_write_early_data(server, response, sizeof(response), &written);
+}
+
+/**
+ * After the client read the 0.5-RTT response: let it send EndOfEarlyData
+ * and Finished, consume them on the server and complete both sides.
+ */
+static int finish_early(SSL *client, SSL *server) {
+    unsigned char buf[64];
+    size_t n;
+    int ret = SSL_READ_EARLY_DATA_ERROR;
+
+    for (int round = 0; round < 16 && ret != SSL_READ_EARLY_DATA_FINISH; round++) {
+        ret = SSL_read_early_data(server, buf, sizeof(buf), &n);
+        if (ret == SSL_READ_EARLY_DATA_ERROR) {
+            if (!bench_tls_retryable(server, ret))
+                return 0;
+            ret = SSL_do_handshake(client);
+            if (ret != 1 && !bench_tls_retryable(client, ret))
+                return 0;
+            ret = SSL_READ_EARLY_DATA_ERROR;
+        }
+    }
+    return ret == SSL_READ_EARLY_DATA_FINISH && bench_tls_handshake(client, server);
+}
+
+/**
+ * One connection for the ttfb-* modes; *ttfb is the time from the first
+ * ClientHello to the client holding the first response byte. early:
+ * send the request as 0-RTT data. *next_session (early only) is the
+ * ticket the server issued on this connection.
+ */
+static int ttfb_connection(SSL_CTX *client_ctx, SSL_CTX *server_ctx, SSL_SESSION *session,
+                           int early, double *ttfb, int *accepted, SSL_SESSION **next_session,
+                           uint64_t *wire_client, uint64_t *wire_server) {
+    unsigned char request[REQUEST_SIZE], buf[RESPONSE_SIZE];
+    SSL *client, *server;
+    size_t written, got = 0;
+    double t0;
+    int ok = 1;
+
+    memset(request, 'G', sizeof(request));
+    *accepted = 0;
+    if (bench_tls_make_ssl_pair(client_ctx, server_ctx, &client, &server) != 0)
+        return 0;
+    if (session != NULL)
+        SSL_set_session(client, session);
+
+    t0 = bench_now();
+    if (early) {
+        ok = SSL_write_early_data(client, request, sizeof(request), &written)
+            && server_early(server, buf, &got);
+        if (ok && got == REQUEST_SIZE) {
+            /* Early data accepted: the 0.5-RTT response follows the server flight */
+            ok = read_all(client, buf, RESPONSE_SIZE);
+            *accepted = ok && SSL_get_early_data_status(client) == SSL_EARLY_DATA_ACCEPTED;
+            *ttfb = bench_now() - t0;
+            ok = ok && finish_early(client, server);
+        } else if (ok) {
+            /* Rejected: the client sends the request again after the handshake */
+            ok = bench_tls_handshake(client, server)
+                && SSL_write_ex(client, request, sizeof(request), &written)
+                && read_all(server, buf, REQUEST_SIZE)
+                && SSL_write_ex(server, response, sizeof(response), &written)
+                && read_all(client, buf, RESPONSE_SIZE);
+            *ttfb = bench_now() - t0;
+        }
+    } else {
+        ok = bench_tls_handshake(client, server)
+            && SSL_write_ex(client, request, sizeof(request), &written)
+            && read_all(server, buf, REQUEST_SIZE)
+            && SSL_write_ex(server, response, sizeof(response), &written)
+            && read_all(client, buf, RESPONSE_SIZE);
+        *ttfb = bench_now() - t0;
+        if (ok && session != NULL && !SSL_session_reused(client)) {
+            fprintf(stderr, "ERROR: Session was not resumed\n");
+            ok = 0;
+        }
+    }
+    if (ok && next_session != NULL) {
+        /* The new tickets arrive after the server completed its side */
+        bench_tls_drain(client);
+        *next_session = SSL_get1_session(client);
+    }
+    *wire_client += BIO_number_written(SSL_get_wbio(client));
+    *wire_server += BIO_number_written(SSL_get_wbio(server));
+    bench_tls_free_pair(client, server);
+    return ok;
+}
+
+/**
+ * ttfb-* runs: full (session NULL), resumed from a fixed session, or
+ * 0-RTT (early) resuming each connection's ticket on the next one.
+ */
+static int run_ttfb(SSL_CTX *client_ctx, SSL_CTX *server_ctx, SSL_SESSION *session, int early,
+                    double min_seconds, run_stats *stats) {
+    SPARETOOLS_MEMTRACE_TOTALS before, after;
+    double start = bench_now(), cpu_start = bench_cpu_now();
+    uint64_t wire_client = 0, wire_server = 0;
+    size_t total = 0, accepted_total = 0;
+    SSL_SESSION *current = session;
+    int ok = 1;
+
+    if (early)
+        SSL_SESSION_up_ref(current);
+    stats->count = 0;
+    sparetools_memtrace_totals(&before);
+    bench_perf_start(&perf);
+    do {
+        SSL_SESSION *next = NULL;
+        double ttfb = 0.0;
+        int accepted;
+
+        ok = ttfb_connection(client_ctx, server_ctx, current, early, &ttfb, &accepted,
+                             early ? &next : NULL, &wire_client, &wire_server);
+        if (early) {
+            SSL_SESSION_free(current);
+            current = next;
+            if (ok && (current == NULL || SSL_SESSION_get_max_early_data(current) == 0)) {
+                fprintf(stderr, "ERROR: No 0-RTT ticket for the next connection\n");
+                ok = 0;
+            }
+        }
+        if (!ok)
+            break;
+        accepted_total += (size_t)accepted;
+        if (stats->count < MAX_SAMPLES)
+            stats->samples[stats->count++] = ttfb;
+        total++;
+        stats->elapsed = bench_now() - start;
+    } while (stats->elapsed < min_seconds || stats->count < MIN_SAMPLES);
+    if (early)
+        SSL_SESSION_free(current);
+
+    bench_perf_stop(&perf, &stats->counters);
+    sparetools_memtrace_totals(&after);
+    if (!ok)
+        return 1;
+    stats->total = total;
+    stats->allocs_per_hs = (double)(after.allocs + after.reallocs - before.allocs - before.reallocs)
+        / (double)total;
+    stats->bytes_per_hs = (double)(after.bytes - before.bytes) / (double)total;
+    stats->cpu_us_per_hs = (bench_cpu_now() - cpu_start) * 1e6 / (double)total;
+    stats->wire_client = (double)wire_client / (double)total;
+    stats->wire_server = (double)wire_server / (double)total;
+    stats->early_accepted = (double)accepted_total / (double)total;
+    /* TLS 1.3 over an established TCP connection: one round trip for the
+     * handshake, one for the request, unless it rode in the ClientHello */
+    stats->round_trips = early && accepted_total == total ? 1 : 2;
+    return 0;
+}
+
+/** One full handshake whose ticket is kept for the resumption runs */
+static SSL_SESSION *make_session(SSL_CTX *client_ctx, SSL_CTX *server_ctx) {
+    SSL *client, *server;
+    SSL_SESSION *session = NULL;
+
+    if (bench_tls_make_ssl_pair(client_ctx, server_ctx, &client, &server) != 0)
+        return NULL;
+    if (bench_tls_handshake(client, server)) {
+        bench_tls_drain(client);
+        session = SSL_get1_session(client);
+        if (session != NULL && !SSL_SESSION_is_resumable(session)) {
+            SSL_SESSION_free(session);
+            session = NULL;
+        }
+    }
+    bench_tls_free_pair(client, server);
+    return session;
+}
+
+static const char *cert_type = "EC";
+
+static void report(bench_json *json, const char *group, const char *mode,
+                   run_stats *stats) {
+    double rate = (double)stats->count / stats->elapsed;
+    double p50 = bench_percentile(stats->samples, stats->count, 50.0) * 1e6;
+    double p99 = bench_percentile(stats->samples, stats->count, 99.0) * 1e6;
+
+    printf("  %-18s %-18s %10.1f hs/s  p50 %8.1f us  p99 %8.1f us  %6.0f B wire  %7.1f allocs/hs",
+           group, mode, rate, p50, p99, stats->wire_client + stats->wire_server,
+           stats->allocs_per_hs);
+    if (perf.enabled)
+        printf("  IPC %5.2f", bench_perf_ipc(&stats->counters));
+    if (perf.enabled && stats->counters.valid[BENCH_PERF_ITLB_MISSES] && stats->total > 0)
+        printf("  %6.1f iTLB misses/hs",
+               (double)stats->counters.values[BENCH_PERF_ITLB_MISSES] / (double)stats->total);
+    if (stats->round_trips > 0 && rtt_ms > 0)
+        printf("  %d RTT: %.1f ms at %.0f ms RTT", stats->round_trips,
+               stats->round_trips * rtt_ms + p50 / 1e3, rtt_ms);
+    printf("\n");
+    bench_json_record_begin(json);
+    bench_json_str(json, "group", group);
+    bench_json_str(json, "mode", mode);
+    bench_json_str(json, "cert", cert_type);
+    bench_json_int(json, "handshakes", stats->count);
+    bench_json_num(json, "handshakes_per_s", rate);
+    bench_json_num(json, "p50_us", p50);
+    bench_json_num(json, "p99_us", p99);
+    bench_json_num(json, "allocs_per_handshake", stats->allocs_per_hs);
+    bench_json_num(json, "bytes_per_handshake", stats->bytes_per_hs);
+    bench_json_num(json, "cpu_us_per_handshake", stats->cpu_us_per_hs);
+    bench_json_num(json, "wire_bytes_client", stats->wire_client);
+    bench_json_num(json, "wire_bytes_server", stats->wire_server);
+    bench_json_num(json, "wire_bytes", stats->wire_client + stats->wire_server);
+    bench_json_int(json, "hugetext_bytes", hugetext_bytes);
+    if (stats->round_trips > 0) {
+        bench_json_int(json, "round_trips", (uint64_t)stats->round_trips);
+        if (strncmp(mode, "ttfb-0rtt", 9) == 0)
+            bench_json_num(json, "early_data_accepted", stats->early_accepted);
+        if (rtt_ms > 0)
+            bench_json_num(json, "ttfb_at_rtt_ms", stats->round_trips * rtt_ms + p50 / 1e3);
+    }
+    if (perf.enabled)
+        bench_perf_json(json, &stats->counters, stats->total);
+    bench_json_record_end(json);
+}
+
+int main(int argc, char **argv) {
+    bench_options opts;
+    bench_json json;
+    EVP_PKEY *pkey = NULL;
+    X509 *cert = NULL;
+    run_stats stats;
+    int failures = 0, hugetext = 0;
+    int argi = bench_parse_args(argc, argv, "bench_handshake.json", &opts);
+
+    if (argi < 0)
+        return 2;
+    /* Benchmark-specific options follow the common ones */
+    for (; argi < argc; argi++) {
+        if (strcmp(argv[argi], "--cert") == 0 && argi + 1 < argc) {
+            cert_type = argv[++argi];
+        } else if (strcmp(argv[argi], "--hugetext") == 0) {
+            hugetext = 1;
+        } else if (strcmp(argv[argi], "--rtt-ms") == 0 && argi + 1 < argc) {
+            rtt_ms = atof(argv[++argi]);
+        } else {
+            fprintf(stderr, "Usage: %s [--quick] [--json PATH] [--perf-counters] [--cert EC|RSA|ML-DSA-65]"
+                    " [--hugetext] [--rtt-ms N]\n", argv[0]);
+            return 2;
+        }
+    }
+    /* Before any OpenSSL allocation */
+    if (!sparetools_memtrace_install())
+        fprintf(stderr, "⚠ Allocation tracing unavailable (hooks already installed)\n");
+
+    printf("=================================\n");
+    printf("OpenSSL TLS 1.3 Handshake Benchmark\n");
+    printf("=================================\n");
+    printf("OpenSSL version: %s\n", OpenSSL_version(OPENSSL_VERSION));
+    printf("Server certificate: %s\n", strcmp(cert_type, "EC") == 0 ? "ECDSA P-256" : cert_type);
+    if (opts.perf_counters && !bench_perf_open(&perf))
+        printf("⚠ Hardware counters unavailable (perf_event_open), reporting wall clock only\n");
+    if (hugetext) {
+#ifdef SPARETOOLS_HAVE_HUGETEXT
+        SPARETOOLS_HUGETEXT_RESULT remapped = {0};
+        int ret = sparetools_hugetext_remap_openssl(&remapped);
+
+        hugetext_bytes = remapped.remapped_bytes;
+        if (ret > 0)
+            printf("Hugepage text: %zu of %zu KiB remapped, %zu KiB on hugepages\n",
+                   remapped.remapped_bytes / 1024, remapped.text_bytes / 1024, remapped.huge_bytes / 1024);
+        else
+            printf("⚠ Hugepage text: nothing remapped (%s)\n",
+                   ret < 0 ? "remap failed" : "no 2 MiB-aligned text or THP disabled");
+#else
+        printf("⚠ Hugepage text: sparetools_hugetext not available on this platform\n");
+#endif
+    }
+    printf("\n");
+
+    stats.samples = malloc(MAX_SAMPLES * sizeof(*stats.samples));
+    if (stats.samples == NULL || bench_tls_make_cert(cert_type, &pkey, &cert) != 0) {
+        free(stats.samples);
+        return 1;
+    }
+    if (bench_json_begin(&json, &opts, "handshake") != 0) {
+        free(stats.samples);
+        X509_free(cert);
+        EVP_PKEY_free(pkey);
+        return 1;
+    }
+
+    for (int g = 0; groups[g] != NULL; g++) {
+        SSL_CTX *client_ctx, *server_ctx;
+        SSL_SESSION *session;
+
+        if (bench_tls_make_ctx_pair(pkey, cert, &client_ctx, &server_ctx) != 0) {
+            failures++;
+            break;
+        }
+        if (!SSL_CTX_set1_groups_list(client_ctx, groups[g])
+            || !SSL_CTX_set1_groups_list(server_ctx, groups[g])) {
+            printf("  %-18s not available, skipping\n", groups[g]);
+            ERR_clear_error();
+            SSL_CTX_free(client_ctx);
+            SSL_CTX_free(server_ctx);
+            continue;
+        }
+
+        if (run_handshakes(client_ctx, server_ctx, NULL, opts.min_seconds, &stats) != 0) {
+            fprintf(stderr, "ERROR: Full handshake failed for %s\n", groups[g]);
+            ERR_print_errors_fp(stderr);
+            failures++;
+        } else {
+            report(&json, groups[g], "full", &stats);
+        }
+
+        session = make_session(client_ctx, server_ctx);
+        if (session == NULL
+            || run_handshakes(client_ctx, server_ctx, session, opts.min_seconds, &stats) != 0) {
+            fprintf(stderr, "ERROR: Resumed handshake failed for %s\n", groups[g]);
+            ERR_print_errors_fp(stderr);
+            failures++;
+        } else {
+            report(&json, groups[g], "resumed", &stats);
+        }
+
+        /* Time to first byte: full and resumed, before 0-RTT tickets exist */
+        if (run_ttfb(client_ctx, server_ctx, NULL, 0, opts.min_seconds, &stats) != 0) {
+            fprintf(stderr, "ERROR: ttfb-full failed for %s\n", groups[g]);
+            ERR_print_errors_fp(stderr);
+            failures++;
+        } else {
+            report(&json, groups[g], "ttfb-full", &stats);
+        }
+        if (session != NULL) {
+            if (run_ttfb(client_ctx, server_ctx, session, 0, opts.min_seconds, &stats) != 0) {
+                fprintf(stderr, "ERROR: ttfb-resumed failed for %s\n", groups[g]);
+                ERR_print_errors_fp(stderr);
+                failures++;
+            } else {
+                report(&json, groups[g], "ttfb-resumed", &stats);
+            }
+        }
+        SSL_SESSION_free(session);
+
+        /* Tickets issued from here on allow early data */
+        SSL_CTX_set_max_early_data(server_ctx, MAX_EARLY_DATA);
+        for (int replay = 0; replay < 2; replay++) {
+            const char *mode = replay ? "ttfb-0rtt-noreplay" : "ttfb-0rtt";
+
+            if (replay)
+                SSL_CTX_set_options(server_ctx, SSL_OP_NO_ANTI_REPLAY);
+            session = make_session(client_ctx, server_ctx);
+            if (session == NULL || SSL_SESSION_get_max_early_data(session) == 0
+                || run_ttfb(client_ctx, server_ctx, session, 1, opts.min_seconds, &stats) != 0) {
+                fprintf(stderr, "ERROR: %s failed for %s\n", mode, groups[g]);
+                ERR_print_errors_fp(stderr);
+                failures++;
+            } else {
+                report(&json, groups[g], mode, &stats);
+            }
+            SSL_SESSION_free(session);
+        }
+
+        SSL_CTX_free(client_ctx);
+        SSL_CTX_free(server_ctx);
+    }
+
+    bench_json_end(&json);
+    bench_perf_close(&perf);
+    free(stats.samples);
+    X509_free(cert);
+    EVP_PKEY_free(pkey);
+
+    printf("\n=================================\n");
+    if (failures == 0) {
+        printf("✅ Handshake benchmark completed (%s)\n", opts.json_path);
+        return 0;
+    }
+    printf("❌ %d benchmark(s) FAILED\n", failures);
+    return 1;
+}
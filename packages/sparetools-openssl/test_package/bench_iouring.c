@@ -0,0 +1,734 @@
+#define _GNU_SOURCE
+
+#include <openssl/err.h>
+#include <openssl/ssl.h>
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "bench_common.h"
+#include "bench_tls.h"
+#include "bench_uring.h"
+
+/**
+ * io_uring reference TLS server and throughput benchmark
+ *
+ * Runs one single-threaded TLS 1.3 server on TCP loopback and drives it
+ * from --clients N client threads (4 by default, 2 with --quick), for
+ * two server designs:
+ *
+ * - epoll:    nonblocking sockets in an epoll set, SSL_set_fd (socket
+ *             BIOs)
+ * - io_uring: SSL over memory BIOs fed from io_uring completions, with a
+ *             multishot accept, multishot recv into a provided buffer ring
+ *             and IORING_OP_WRITE_FIXED sends from per-connection
+ *             registered buffers
+ *
+ * and two workloads:
+ *
+ * - handshake: connect, full handshake, empty request, 1-byte reply,
+ *              close; connections/s
+ * - bulk:      one connection per client uploading --quick ? 4 : 64 MiB
+ *              in 16 KiB writes, acknowledged by the server; Gbit/s
+ *
+ * The request is an 8-byte big-endian length followed by that many
+ * bytes; the server replies with one byte once it has them all. Modes
+ * the kernel or sandbox refuses (io_uring_setup, provided buffer rings)
+ * are recorded with "available": 0.
+ */
+
+#define MAX_CONNS 256
+#define SEND_BUF_SIZE 32768
+#define RECV_BUFS 64            /* Provided buffer ring entries (power of two) */
+#define RECV_BUF_SIZE 16384
+#define URING_ENTRIES 512
+#define CLIENT_WRITE 16384
+#define BULK_BYTES (64ULL * 1024 * 1024)
+#define QUICK_BULK_BYTES (4ULL * 1024 * 1024)
+
+typedef enum {
+    SERVER_EPOLL,
+    SERVER_IOURING
+} server_kind;
+
+static const char *server_names[] = {"epoll", "io_uring"};
+
+typedef enum {
+    WORK_HANDSHAKE,
+    WORK_BULK
+} workload;
+
+static const char *workload_names[] = {"handshake", "bulk"};
+
+/* Application state of one server connection, shared by both designs */
+typedef struct {
+    unsigned char hdr[8];
+    size_t hdr_got;
+    uint64_t expect;
+    uint64_t got;
+    int replied;
+} request_state;
+
+/*
+ * Handshake, read and reply as far as the available input allows.
+ * Returns 1 to keep the connection, 0 when it is finished or failed.
+ */
+static int serve_ssl(SSL *ssl, request_state *rq) {
+    unsigned char buf[RECV_BUF_SIZE];
+    int ret;
+
+    if (!SSL_is_init_finished(ssl)) {
+        ret = SSL_do_handshake(ssl);
+        if (ret != 1)
+            return bench_tls_retryable(ssl, ret);
+    }
+    for (;;) {
+        int i = 0;
+
+        ret = SSL_read(ssl, buf, sizeof(buf));
+        if (ret <= 0)
+            return bench_tls_retryable(ssl, ret);
+        while (i < ret && rq->hdr_got < sizeof(rq->hdr)) {
+            rq->hdr[rq->hdr_got++] = buf[i++];
+            if (rq->hdr_got == sizeof(rq->hdr)) {
+                for (int b = 0; b < 8; b++)
+                    rq->expect = rq->expect << 8 | rq->hdr[b];
+            }
+        }
+        rq->got += (uint64_t)(ret - i);
+        if (rq->hdr_got == sizeof(rq->hdr) && !rq->replied && rq->got >= rq->expect) {
+            unsigned char ack = 1;
+
+            if (SSL_write(ssl, &ack, 1) != 1)
+                return 0;
+            rq->replied = 1;
+        }
+    }
+}
+
+/* Handshake flights go out in several writes through a socket BIO */
+static void set_nodelay(int fd) {
+    int one = 1;
+
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+}
+
+typedef struct {
+    server_kind kind;
+    SSL_CTX *ctx;
+    int listen_fd;
+    int stop_fd;              /* Read end of the stop pipe */
+    int failed;
+    int unavailable;
+    atomic_int ready;
+} server_arg;
+
+/* ---- epoll + socket BIO server ---- */
+
+typedef struct {
+    int fd;
+    SSL *ssl;
+    request_state rq;
+} epoll_conn;
+
+static void *epoll_server(void *varg) {
+    server_arg *arg = varg;
+    epoll_conn *conns = calloc(MAX_CONNS, sizeof(*conns));
+    struct epoll_event ev, events[64];
+    int ep = epoll_create1(0), running = 1;
+
+    if (conns == NULL || ep < 0) {
+        arg->failed = 1;
+        atomic_store(&arg->ready, 1);
+        free(conns);
+        return NULL;
+    }
+    for (int i = 0; i < MAX_CONNS; i++)
+        conns[i].fd = -1;
+    ev.events = EPOLLIN;
+    ev.data.u32 = MAX_CONNS;
+    epoll_ctl(ep, EPOLL_CTL_ADD, arg->listen_fd, &ev);
+    ev.data.u32 = MAX_CONNS + 1;
+    epoll_ctl(ep, EPOLL_CTL_ADD, arg->stop_fd, &ev);
+    atomic_store(&arg->ready, 1);
+
+    while (running) {
+        int n = epoll_wait(ep, events, 64, -1);
+
+        for (int e = 0; e < n; e++) {
+            uint32_t id = events[e].data.u32;
+
+            if (id == MAX_CONNS + 1) {
+                running = 0;
+            } else if (id == MAX_CONNS) {
+                int fd;
+
+                while ((fd = accept4(arg->listen_fd, NULL, NULL, SOCK_NONBLOCK)) >= 0) {
+                    int slot = 0;
+
+                    while (slot < MAX_CONNS && conns[slot].fd >= 0)
+                        slot++;
+                    if (slot == MAX_CONNS || (conns[slot].ssl = SSL_new(arg->ctx)) == NULL) {
+                        close(fd);
+                        continue;
+                    }
+                    conns[slot].fd = fd;
+                    set_nodelay(fd);
+                    memset(&conns[slot].rq, 0, sizeof(conns[slot].rq));
+                    SSL_set_fd(conns[slot].ssl, fd);
+                    SSL_set_accept_state(conns[slot].ssl);
+                    ev.events = EPOLLIN;
+                    ev.data.u32 = (uint32_t)slot;
+                    epoll_ctl(ep, EPOLL_CTL_ADD, fd, &ev);
+                }
+            } else if (!serve_ssl(conns[id].ssl, &conns[id].rq)) {
+                ERR_clear_error();
+                epoll_ctl(ep, EPOLL_CTL_DEL, conns[id].fd, NULL);
+                SSL_free(conns[id].ssl);
+                close(conns[id].fd);
+                conns[id].fd = -1;
+                conns[id].ssl = NULL;
+            }
+        }
+    }
+    for (int i = 0; i < MAX_CONNS; i++) {
+        if (conns[i].fd >= 0) {
+            SSL_free(conns[i].ssl);
+            close(conns[i].fd);
+        }
+    }
+    close(ep);
+    free(conns);
+    return NULL;
+}
+
+/* ---- io_uring + memory BIO server ---- */
+
+/* user_data: op in the top byte, connection slot below */
+#define OP_ACCEPT 1ULL
+#define OP_RECV 2ULL
+#define OP_SEND 3ULL
+#define OP_STOP 4ULL
+#define USER_DATA(op, slot) ((op) << 56 | (uint64_t)(slot))
+
+typedef struct {
+    int fd;
+    SSL *ssl;
+    BIO *rbio, *wbio;           /* Memory BIOs: recv -> rbio, wbio -> send */
+    request_state rq;
+    int recv_armed;
+    int send_inflight;
+    size_t send_off, send_len;
+    int closing;
+} uring_conn;
+
+typedef struct {
+    bench_uring ring;
+    bench_uring_pbuf pbuf;
+    unsigned char *send_bufs;   /* MAX_CONNS x SEND_BUF_SIZE, registered */
+    uring_conn conns[MAX_CONNS];
+} uring_server;
+
+static int queue_recv(uring_server *s, int slot) {
+    struct io_uring_sqe *sqe = bench_uring_sqe(&s->ring);
+
+    if (sqe == NULL)
+        return 0;
+    sqe->opcode = IORING_OP_RECV;
+    sqe->fd = s->conns[slot].fd;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = s->pbuf.bgid;
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+    sqe->user_data = USER_DATA(OP_RECV, slot);
+    s->conns[slot].recv_armed = 1;
+    return 1;
+}
+
+static int queue_send(uring_server *s, int slot) {
+    uring_conn *c = &s->conns[slot];
+    struct io_uring_sqe *sqe;
+
+    if (c->send_inflight)
+        return 1;
+    if (c->send_off == c->send_len) {
+        int n = BIO_read(c->wbio, s->send_bufs + (size_t)slot * SEND_BUF_SIZE, SEND_BUF_SIZE);
+
+        if (n <= 0)
+            return 1;
+        c->send_off = 0;
+        c->send_len = (size_t)n;
+    }
+    if ((sqe = bench_uring_sqe(&s->ring)) == NULL)
+        return 0;
+    sqe->opcode = IORING_OP_WRITE_FIXED;
+    sqe->fd = c->fd;
+    sqe->addr = (uint64_t)(uintptr_t)(s->send_bufs + (size_t)slot * SEND_BUF_SIZE + c->send_off);
+    sqe->len = (unsigned)(c->send_len - c->send_off);
+    sqe->buf_index = (unsigned short)slot;
+    sqe->user_data = USER_DATA(OP_SEND, slot);
+    c->send_inflight = 1;
+    return 1;
+}
+
+/* Free the slot once neither a recv nor a send references its fd */
+static void maybe_close(uring_server *s, int slot) {
+    uring_conn *c = &s->conns[slot];
+
+    if (!c->closing || c->recv_armed || c->send_inflight)
+        return;
+    SSL_free(c->ssl);
+    close(c->fd);
+    memset(c, 0, sizeof(*c));
+    c->fd = -1;
+}
+
+static void start_close(uring_server *s, int slot) {
+    uring_conn *c = &s->conns[slot];
+
+    if (!c->closing) {
+        c->closing = 1;
+        /* Ends the multishot recv with a zero-length completion */
+        shutdown(c->fd, SHUT_RDWR);
+    }
+    maybe_close(s, slot);
+}
+
+static void accept_conn(uring_server *s, SSL_CTX *ctx, int fd) {
+    int slot = 0;
+    uring_conn *c;
+
+    while (slot < MAX_CONNS && s->conns[slot].fd >= 0)
+        slot++;
+    if (slot == MAX_CONNS) {
+        close(fd);
+        return;
+    }
+    c = &s->conns[slot];
+    memset(c, 0, sizeof(*c));
+    c->fd = fd;
+    set_nodelay(fd);
+    c->ssl = SSL_new(ctx);
+    c->rbio = BIO_new(BIO_s_mem());
+    c->wbio = BIO_new(BIO_s_mem());
+    if (c->ssl == NULL || c->rbio == NULL || c->wbio == NULL) {
+        SSL_free(c->ssl);
+        BIO_free(c->rbio);
+        BIO_free(c->wbio);
+        close(fd);
+        memset(c, 0, sizeof(*c));
+        c->fd = -1;
+        return;
+    }
+    BIO_set_mem_eof_return(c->rbio, -1);
+    SSL_set_bio(c->ssl, c->rbio, c->wbio);
+    SSL_set_accept_state(c->ssl);
+    if (!queue_recv(s, slot)) {
+        c->closing = 1;
+        maybe_close(s, slot);
+    }
+}
+
+static void *uring_server_main(void *varg) {
+    server_arg *arg = varg;
+    uring_server *s = calloc(1, sizeof(*s));
+    struct iovec *iov = calloc(MAX_CONNS, sizeof(*iov));
+    struct io_uring_sqe *sqe;
+    unsigned char stop_byte;
+    int running = 1;
+
+    if (s == NULL || iov == NULL || bench_uring_init(&s->ring, URING_ENTRIES) != 0) {
+        arg->unavailable = 1;
+        goto out;
+    }
+    if ((s->send_bufs = malloc((size_t)MAX_CONNS * SEND_BUF_SIZE)) == NULL) {
+        arg->failed = 1;
+        goto out;
+    }
+    for (int i = 0; i < MAX_CONNS; i++) {
+        iov[i].iov_base = s->send_bufs + (size_t)i * SEND_BUF_SIZE;
+        iov[i].iov_len = SEND_BUF_SIZE;
+        s->conns[i].fd = -1;
+    }
+    if (bench_uring_register_buffers(&s->ring, iov, MAX_CONNS) != 0
+        || bench_uring_pbuf_init(&s->ring, &s->pbuf, 0, RECV_BUFS, RECV_BUF_SIZE) != 0) {
+        arg->unavailable = 1;
+        goto out;
+    }
+
+    sqe = bench_uring_sqe(&s->ring);
+    sqe->opcode = IORING_OP_ACCEPT;
+    sqe->fd = arg->listen_fd;
+    sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+    sqe->user_data = USER_DATA(OP_ACCEPT, 0);
+    sqe = bench_uring_sqe(&s->ring);
+    sqe->opcode = IORING_OP_READ;
+    sqe->fd = arg->stop_fd;
+    sqe->addr = (uint64_t)(uintptr_t)&stop_byte;
+    sqe->len = 1;
+    sqe->user_data = USER_DATA(OP_STOP, 0);
+    atomic_store(&arg->ready, 1);
+
+    while (running) {
+        struct io_uring_cqe *cqe;
+
+        if (bench_uring_enter(&s->ring, 1) < 0) {
+            arg->failed = 1;
+            break;
+        }
+        while ((cqe = bench_uring_peek(&s->ring)) != NULL) {
+            uint64_t op = cqe->user_data >> 56;
+            int slot = (int)(cqe->user_data & 0xffffffu);
+            int res = cqe->res;
+            unsigned flags = cqe->flags;
+
+            bench_uring_seen(&s->ring);
+            if (op == OP_STOP) {
+                running = 0;
+            } else if (op == OP_ACCEPT) {
+                if (res >= 0)
+                    accept_conn(s, arg->ctx, res);
+                if (!(flags & IORING_CQE_F_MORE) && (sqe = bench_uring_sqe(&s->ring)) != NULL) {
+                    sqe->opcode = IORING_OP_ACCEPT;
+                    sqe->fd = arg->listen_fd;
+                    sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+                    sqe->user_data = USER_DATA(OP_ACCEPT, 0);
+                }
+            } else if (op == OP_RECV) {
+                uring_conn *c = &s->conns[slot];
+
+                if (res > 0) {
+                    unsigned short bid = (unsigned short)(flags >> IORING_CQE_BUFFER_SHIFT);
+
+                    BIO_write(c->rbio, bench_uring_pbuf_get(&s->pbuf, bid), res);
+                    bench_uring_pbuf_add(&s->pbuf, bid);
+                    if (!c->closing && !serve_ssl(c->ssl, &c->rq)) {
+                        ERR_clear_error();
+                        queue_send(s, slot);
+                        start_close(s, slot);
+                    } else if (!c->closing) {
+                        queue_send(s, slot);
+                    }
+                }
+                if (!(flags & IORING_CQE_F_MORE)) {
+                    c->recv_armed = 0;
+                    /* Out of provided buffers: re-arm; EOF or error: close */
+                    if (res == -ENOBUFS && !c->closing)
+                        queue_recv(s, slot);
+                    else
+                        start_close(s, slot);
+                }
+            } else if (op == OP_SEND) {
+                uring_conn *c = &s->conns[slot];
+
+                c->send_inflight = 0;
+                if (res <= 0) {
+                    c->send_off = c->send_len;
+                    start_close(s, slot);
+                } else {
+                    c->send_off += (size_t)res;
+                    if (!c->closing || c->send_off < c->send_len)
+                        queue_send(s, slot);
+                    maybe_close(s, slot);
+                }
+            }
+        }
+    }
+    for (int i = 0; i < MAX_CONNS; i++) {
+        if (s->conns[i].fd >= 0) {
+            SSL_free(s->conns[i].ssl);
+            close(s->conns[i].fd);
+        }
+    }
+
+out:
+    atomic_store(&arg->ready, 1);
+    if (s != NULL) {
+        bench_uring_free(&s->ring);
+        bench_uring_pbuf_free(&s->pbuf);
+        free(s->send_bufs);
+    }
+    free(s);
+    free(iov);
+    return NULL;
+}
+
+/* ---- clients ---- */
+
+static atomic_int start_flag;
+static atomic_int stop_flag;
+
+typedef struct {
+    pthread_t thread;
+    SSL_CTX *ctx;
+    struct sockaddr_in addr;
+    workload work;
+    uint64_t bulk_bytes;
+    unsigned long long connections;
+    unsigned long long bytes;
+    int failed;
+} client_arg;
+
+/* One connection: handshake, request of len bytes, wait for the reply */
+static int client_request(client_arg *arg, uint64_t len, const unsigned char *chunk) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    SSL *ssl = NULL;
+    unsigned char hdr[8], ack;
+    uint64_t sent = 0;
+    int ok = 0;
+
+    if (fd < 0)
+        return 0;
+    set_nodelay(fd);
+    if (connect(fd, (struct sockaddr *)&arg->addr, sizeof(arg->addr)) != 0
+        || (ssl = SSL_new(arg->ctx)) == NULL || !SSL_set_fd(ssl, fd) || SSL_connect(ssl) != 1)
+        goto done;
+    for (int b = 0; b < 8; b++)
+        hdr[b] = (unsigned char)(len >> (56 - 8 * b));
+    if (SSL_write(ssl, hdr, sizeof(hdr)) != (int)sizeof(hdr))
+        goto done;
+    while (sent < len) {
+        int n = (int)(len - sent < CLIENT_WRITE ? len - sent : CLIENT_WRITE);
+
+        if (SSL_write(ssl, chunk, n) != n)
+            goto done;
+        sent += (uint64_t)n;
+    }
+    ok = SSL_read(ssl, &ack, 1) == 1 && ack == 1;
+    if (ok)
+        SSL_shutdown(ssl);
+
+done:
+    SSL_free(ssl);
+    close(fd);
+    return ok;
+}
+
+static void *client_main(void *varg) {
+    client_arg *arg = varg;
+    unsigned char *chunk = malloc(CLIENT_WRITE);
+
+    if (chunk == NULL) {
+        arg->failed = 1;
+        return NULL;
+    }
+    memset(chunk, 0x42, CLIENT_WRITE);
+    while (!atomic_load(&start_flag))
+        ;
+    if (arg->work == WORK_BULK) {
+        arg->failed = !client_request(arg, arg->bulk_bytes, chunk);
+        arg->bytes = arg->failed ? 0 : arg->bulk_bytes;
+        arg->connections = !arg->failed;
+    } else {
+        while (!atomic_load(&stop_flag)) {
+            if (!client_request(arg, 0, chunk)) {
+                arg->failed = 1;
+                break;
+            }
+            arg->connections++;
+        }
+    }
+    free(chunk);
+    return NULL;
+}
+
+static int listen_socket(struct sockaddr_in *addr) {
+    socklen_t len = sizeof(*addr);
+    int one = 1, fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+
+    if (fd < 0)
+        return -1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    memset(addr, 0, sizeof(*addr));
+    addr->sin_family = AF_INET;
+    addr->sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (bind(fd, (struct sockaddr *)addr, sizeof(*addr)) != 0 || listen(fd, 1024) != 0
+        || getsockname(fd, (struct sockaddr *)addr, &len) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+typedef struct {
+    double rate;            /* connections/s or Gbit/s */
+    unsigned long long connections;
+    int available;
+} run_result;
+
+static int run(server_kind kind, workload work, SSL_CTX *server_ctx, SSL_CTX *client_ctx, int nclients,
+               uint64_t bulk_bytes, double seconds, run_result *r) {
+    server_arg sarg;
+    client_arg *clients = calloc((size_t)nclients, sizeof(*clients));
+    pthread_t server;
+    struct sockaddr_in addr;
+    int stop_pipe[2], started = 0, failed = 0;
+    unsigned long long bytes = 0;
+    double start, elapsed;
+
+    memset(r, 0, sizeof(*r));
+    memset(&sarg, 0, sizeof(sarg));
+    if (clients == NULL || pipe(stop_pipe) != 0) {
+        free(clients);
+        return 0;
+    }
+    sarg.kind = kind;
+    sarg.ctx = server_ctx;
+    sarg.stop_fd = stop_pipe[0];
+    if ((sarg.listen_fd = listen_socket(&addr)) < 0
+        || pthread_create(&server, NULL, kind == SERVER_EPOLL ? epoll_server : uring_server_main, &sarg) != 0) {
+        if (sarg.listen_fd >= 0)
+            close(sarg.listen_fd);
+        close(stop_pipe[0]);
+        close(stop_pipe[1]);
+        free(clients);
+        return 0;
+    }
+    while (!atomic_load(&sarg.ready))
+        usleep(100);
+
+    if (sarg.unavailable || sarg.failed) {
+        failed = sarg.failed;
+    } else {
+        r->available = 1;
+        atomic_store(&start_flag, 0);
+        atomic_store(&stop_flag, 0);
+        for (int i = 0; i < nclients; i++) {
+            clients[i].ctx = client_ctx;
+            clients[i].addr = addr;
+            clients[i].work = work;
+            clients[i].bulk_bytes = bulk_bytes;
+            if (pthread_create(&clients[i].thread, NULL, client_main, &clients[i]) != 0) {
+                failed = 1;
+                break;
+            }
+            started++;
+        }
+        start = bench_now();
+        atomic_store(&start_flag, 1);
+        if (work == WORK_HANDSHAKE) {
+            while (!failed && bench_now() - start < seconds)
+                usleep(1000);
+            atomic_store(&stop_flag, 1);
+        }
+        for (int i = 0; i < started; i++) {
+            pthread_join(clients[i].thread, NULL);
+            failed |= clients[i].failed;
+            r->connections += clients[i].connections;
+            bytes += clients[i].bytes;
+        }
+        elapsed = bench_now() - start;
+        r->rate = work == WORK_HANDSHAKE ? (double)r->connections / elapsed
+                                         : (double)bytes * 8.0 / elapsed / 1e9;
+    }
+
+    if (write(stop_pipe[1], "x", 1) != 1)
+        failed = 1;
+    pthread_join(server, NULL);
+    failed |= sarg.failed;
+    close(sarg.listen_fd);
+    close(stop_pipe[0]);
+    close(stop_pipe[1]);
+    free(clients);
+    return !failed;
+}
+
+int main(int argc, char **argv) {
+    bench_options opts;
+    bench_json json;
+    EVP_PKEY *pkey = NULL;
+    X509 *cert = NULL;
+    SSL_CTX *client_ctx = NULL, *server_ctx = NULL;
+    int nclients = 0, failures = 0;
+    int argi = bench_parse_args(argc, argv, "bench_iouring.json", &opts);
+
+    if (argi < 0)
+        return 2;
+    for (; argi < argc; argi++) {
+        if (strcmp(argv[argi], "--clients") == 0 && argi + 1 < argc) {
+            nclients = atoi(argv[++argi]);
+        } else {
+            fprintf(stderr, "Usage: %s [--quick] [--json PATH] [--clients N]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (nclients < 1)
+        nclients = opts.quick ? 2 : 4;
+    if (nclients > MAX_CONNS / 2)
+        nclients = MAX_CONNS / 2;
+    signal(SIGPIPE, SIG_IGN);
+
+    printf("=================================\n");
+    printf("io_uring Reference Server Benchmark\n");
+    printf("=================================\n");
+    printf("OpenSSL version: %s\n", OpenSSL_version(OPENSSL_VERSION));
+    printf("Clients: %d\n\n", nclients);
+    if (bench_tls_make_cert("EC", &pkey, &cert) != 0
+        || bench_tls_make_ctx_pair(pkey, cert, &client_ctx, &server_ctx) != 0) {
+        X509_free(cert);
+        EVP_PKEY_free(pkey);
+        return 1;
+    }
+    if (bench_json_begin(&json, &opts, "iouring") != 0) {
+        failures++;
+        goto done;
+    }
+
+    for (int w = 0; w < 2; w++) {
+        for (int k = 0; k < 2; k++) {
+            run_result r;
+            int ok = run((server_kind)k, (workload)w, server_ctx, client_ctx, nclients,
+                         opts.quick ? QUICK_BULK_BYTES : BULK_BYTES, opts.min_seconds, &r);
+
+            bench_json_record_begin(&json);
+            bench_json_str(&json, "server", server_names[k]);
+            bench_json_str(&json, "workload", workload_names[w]);
+            bench_json_int(&json, "available", (uint64_t)r.available);
+            if (!r.available && ok) {
+                printf("  %-9s %-9s not available\n", workload_names[w], server_names[k]);
+                bench_json_record_end(&json);
+                continue;
+            }
+            if (!ok) {
+                fprintf(stderr, "ERROR: %s server failed the %s workload\n", server_names[k], workload_names[w]);
+                ERR_print_errors_fp(stderr);
+                failures++;
+            }
+            bench_json_int(&json, "clients", (uint64_t)nclients);
+            bench_json_int(&json, "connections", r.connections);
+            bench_json_int(&json, "ok", (uint64_t)ok);
+            if (w == WORK_HANDSHAKE) {
+                printf("  %-9s %-9s %10.1f conn/s\n", workload_names[w], server_names[k], r.rate);
+                bench_json_num(&json, "connections_per_sec", r.rate);
+            } else {
+                printf("  %-9s %-9s %10.2f Gbit/s\n", workload_names[w], server_names[k], r.rate);
+                bench_json_num(&json, "gbit_per_s", r.rate);
+            }
+            bench_json_record_end(&json);
+        }
+    }
+    bench_json_end(&json);
+
+done:
+    SSL_CTX_free(client_ctx);
+    SSL_CTX_free(server_ctx);
+    X509_free(cert);
+    EVP_PKEY_free(pkey);
+
+    printf("\n=================================\n");
+    if (failures == 0) {
+        printf("✅ Reference server benchmark completed (%s)\n", opts.json_path);
+        return 0;
+    }
+    printf("❌ %d benchmark(s) FAILED\n", failures);
+    return 1;
+}
@@ -0,0 +1,263 @@
+#include <openssl/core_names.h>
+#include <openssl/crypto.h>
+#include <openssl/err.h>
+#include <openssl/kdf.h>
+#include <openssl/params.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#if OPENSSL_VERSION_NUMBER >= 0x30200000L
+#include <openssl/thread.h>
+#endif
+
+#include "bench_common.h"
+
+/**
+ * KDF and password hashing benchmark
+ *
+ * Derives with every KDF through EVP_KDF_fetch + EVP_KDF_derive, one
+ * EVP_KDF_CTX with its parameters set once per case:
+ *
+ * - HKDF-SHA256 and TLS1-PRF-SHA256: key schedule costs, ops/s
+ * - PBKDF2-SHA256 (600k iterations), scrypt (N=2^17, r=8, p=1) and
+ *   Argon2id (64 MiB, t=3, 4 lanes): password hash costs, ms per hash
+ *
+ * Argon2 (OpenSSL 3.2+) fills its lanes on the library's internal thread
+ * pool. It runs with threads=1, 2 and 4 before and after
+ * OSSL_set_max_threads: without a pool, threads > 1 fails to derive, and
+ * packages built with enable_thread_pool=False never get one. Such runs
+ * are recorded with "available": 0, as are KDFs the build lacks.
+ *
+ * --quick uses cheap cost parameters so ctest stays fast.
+ */
+
+#define ARGON2_LANES 4
+
+typedef enum {
+    KDF_HKDF,
+    KDF_TLS1_PRF,
+    KDF_PBKDF2,
+    KDF_SCRYPT,
+    KDF_ARGON2ID
+} kdf_kind;
+
+typedef struct {
+    kdf_kind kind;
+    const char *name;        /* EVP_KDF_fetch name */
+    size_t out_len;
+} kdf_case;
+
+typedef struct {
+    unsigned int pbkdf2_iter;
+    uint64_t scrypt_n;
+    uint32_t argon2_memcost;  /* KiB */
+    uint32_t argon2_iter;
+} cost_params;
+
+static const cost_params full_costs = {600000, 1u << 17, 65536, 3};
+static const cost_params quick_costs = {10000, 1u << 12, 4096, 1};
+
+static const unsigned char secret[48] = "sparetools bench input keying material 0123456";
+static const unsigned char salt[32] = "sparetools bench salt 0123456789";
+static char password[] = "correct horse battery staple";
+static char digest[] = "SHA2-256";
+
+/* Parameters of one derivation; threads only applies to Argon2 */
+static void make_params(kdf_kind kind, const cost_params *costs, uint32_t threads, OSSL_PARAM *p,
+                        uint64_t *u64, uint32_t *u32, unsigned int *uint) {
+    switch (kind) {
+    case KDF_HKDF:
+        *p++ = OSSL_PARAM_construct_utf8_string(OSSL_KDF_PARAM_DIGEST, digest, 0);
+        *p++ = OSSL_PARAM_construct_octet_string(OSSL_KDF_PARAM_KEY, (void *)secret, 32);
+        *p++ = OSSL_PARAM_construct_octet_string(OSSL_KDF_PARAM_SALT, (void *)salt, sizeof(salt));
+        *p++ = OSSL_PARAM_construct_octet_string(OSSL_KDF_PARAM_INFO, (void *)"bench", 5);
+        break;
+    case KDF_TLS1_PRF:
+        *p++ = OSSL_PARAM_construct_utf8_string(OSSL_KDF_PARAM_DIGEST, digest, 0);
+        *p++ = OSSL_PARAM_construct_octet_string(OSSL_KDF_PARAM_SECRET, (void *)secret, sizeof(secret));
+        *p++ = OSSL_PARAM_construct_octet_string(OSSL_KDF_PARAM_SEED, (void *)salt, sizeof(salt));
+        break;
+    case KDF_PBKDF2:
+        uint[0] = costs->pbkdf2_iter;
+        *p++ = OSSL_PARAM_construct_utf8_string(OSSL_KDF_PARAM_DIGEST, digest, 0);
+        *p++ = OSSL_PARAM_construct_octet_string(OSSL_KDF_PARAM_PASSWORD, password, strlen(password));
+        *p++ = OSSL_PARAM_construct_octet_string(OSSL_KDF_PARAM_SALT, (void *)salt, 16);
+        *p++ = OSSL_PARAM_construct_uint(OSSL_KDF_PARAM_ITER, &uint[0]);
+        break;
+    case KDF_SCRYPT:
+        u64[0] = costs->scrypt_n;
+        u64[1] = 8;
+        u64[2] = 1;
+        u64[3] = 256 * costs->scrypt_n * 8;   /* maxmem: twice the 128 * N * r needed */
+        *p++ = OSSL_PARAM_construct_octet_string(OSSL_KDF_PARAM_PASSWORD, password, strlen(password));
+        *p++ = OSSL_PARAM_construct_octet_string(OSSL_KDF_PARAM_SALT, (void *)salt, 16);
+        *p++ = OSSL_PARAM_construct_uint64(OSSL_KDF_PARAM_SCRYPT_N, &u64[0]);
+        *p++ = OSSL_PARAM_construct_uint64(OSSL_KDF_PARAM_SCRYPT_R, &u64[1]);
+        *p++ = OSSL_PARAM_construct_uint64(OSSL_KDF_PARAM_SCRYPT_P, &u64[2]);
+        *p++ = OSSL_PARAM_construct_uint64(OSSL_KDF_PARAM_SCRYPT_MAXMEM, &u64[3]);
+        break;
+    default:
+#if OPENSSL_VERSION_NUMBER >= 0x30200000L
+        u32[0] = costs->argon2_iter;
+        u32[1] = costs->argon2_memcost;
+        u32[2] = ARGON2_LANES;
+        u32[3] = threads;
+        *p++ = OSSL_PARAM_construct_octet_string(OSSL_KDF_PARAM_PASSWORD, password, strlen(password));
+        *p++ = OSSL_PARAM_construct_octet_string(OSSL_KDF_PARAM_SALT, (void *)salt, 16);
+        *p++ = OSSL_PARAM_construct_uint32(OSSL_KDF_PARAM_ITER, &u32[0]);
+        *p++ = OSSL_PARAM_construct_uint32(OSSL_KDF_PARAM_ARGON2_MEMCOST, &u32[1]);
+        *p++ = OSSL_PARAM_construct_uint32(OSSL_KDF_PARAM_ARGON2_LANES, &u32[2]);
+        *p++ = OSSL_PARAM_construct_uint32(OSSL_KDF_PARAM_THREADS, &u32[3]);
+#else
+        (void)u32;
+        (void)threads;
+#endif
+        break;
+    }
+    *p = OSSL_PARAM_construct_end();
+}
+
+typedef struct {
+    double ops_per_sec;
+    double ms_per_op;
+    unsigned long long ops;
+} kdf_result;
+
+/* Returns 1 on success, 0 if the KDF or these parameters are unavailable */
+static int run_kdf(const kdf_case *c, const cost_params *costs, uint32_t threads, double seconds,
+                   kdf_result *r) {
+    EVP_KDF *kdf = EVP_KDF_fetch(NULL, c->name, NULL);
+    EVP_KDF_CTX *ctx = kdf != NULL ? EVP_KDF_CTX_new(kdf) : NULL;
+    OSSL_PARAM params[8];
+    uint64_t u64[4];
+    uint32_t u32[4];
+    unsigned int uint[1];
+    unsigned char out[64];
+    double start, elapsed;
+    int ok;
+
+    memset(r, 0, sizeof(*r));
+    make_params(c->kind, costs, threads, params, u64, u32, uint);
+    /* Set once: TLS1-PRF appends every seed it is given to the previous ones */
+    ok = ctx != NULL && EVP_KDF_CTX_set_params(ctx, params) == 1;
+    start = bench_now();
+    do {
+        ok = ok && EVP_KDF_derive(ctx, out, c->out_len, NULL) == 1;
+        r->ops += ok;
+        elapsed = bench_now() - start;
+    } while (ok && elapsed < seconds);
+    if (ok) {
+        r->ops_per_sec = (double)r->ops / elapsed;
+        r->ms_per_op = elapsed * 1e3 / (double)r->ops;
+    }
+    EVP_KDF_CTX_free(ctx);
+    EVP_KDF_free(kdf);
+    ERR_clear_error();
+    return ok;
+}
+
+static void describe(const kdf_case *c, const cost_params *costs, uint32_t threads, char *buf, size_t len) {
+    switch (c->kind) {
+    case KDF_PBKDF2:
+        snprintf(buf, len, "iter=%u", costs->pbkdf2_iter);
+        break;
+    case KDF_SCRYPT:
+        snprintf(buf, len, "N=%llu,r=8,p=1", (unsigned long long)costs->scrypt_n);
+        break;
+    case KDF_ARGON2ID:
+        snprintf(buf, len, "m=%uKiB,t=%u,lanes=%d,threads=%u", costs->argon2_memcost, costs->argon2_iter,
+                 ARGON2_LANES, threads);
+        break;
+    default:
+        snprintf(buf, len, "SHA2-256,out=%zu", c->out_len);
+        break;
+    }
+}
+
+static void report(bench_json *json, const kdf_case *c, const char *params, const char *pool, int ok,
+                   const kdf_result *r) {
+    if (ok)
+        printf("  %-14s %-36s %-9s %12.1f %10.3f\n", c->name, params, pool, r->ops_per_sec, r->ms_per_op);
+    else
+        printf("  %-14s %-36s %-9s  not available\n", c->name, params, pool);
+    bench_json_record_begin(json);
+    bench_json_str(json, "kdf", c->name);
+    bench_json_str(json, "params", params);
+    bench_json_str(json, "thread_pool", pool);
+    bench_json_int(json, "available", (uint64_t)ok);
+    bench_json_num(json, "ops_per_sec", r->ops_per_sec);
+    bench_json_num(json, "ms_per_op", r->ms_per_op);
+    bench_json_record_end(json);
+}
+
+static const kdf_case kdf_cases[] = {
+    {KDF_HKDF, "HKDF", 32},
+    {KDF_TLS1_PRF, "TLS1-PRF", 48},
+    {KDF_PBKDF2, "PBKDF2", 32},
+    {KDF_SCRYPT, "SCRYPT", 32},
+    {KDF_ARGON2ID, "ARGON2ID", 32},
+};
+#define NUM_KDF_CASES (sizeof(kdf_cases) / sizeof(kdf_cases[0]))
+
+int main(int argc, char **argv) {
+    bench_options opts;
+    bench_json json;
+    const cost_params *costs;
+    char params[64];
+    kdf_result r;
+    int argi = bench_parse_args(argc, argv, "bench_kdf.json", &opts);
+    int failures = 0;
+
+    if (argi < 0)
+        return 2;
+    if (argi != argc) {
+        bench_usage(argv[0]);
+        return 2;
+    }
+    costs = opts.quick ? &quick_costs : &full_costs;
+
+    printf("=================================\n");
+    printf("KDF and Password Hashing Benchmark\n");
+    printf("=================================\n");
+    printf("OpenSSL version: %s\n\n", OpenSSL_version(OPENSSL_VERSION));
+    if (bench_json_begin(&json, &opts, "kdf") != 0)
+        return 1;
+
+    printf("  %-14s %-36s %-9s %12s %10s\n", "KDF", "Parameters", "Pool", "ops/s", "ms/op");
+    for (size_t i = 0; i < NUM_KDF_CASES; i++) {
+        const kdf_case *c = &kdf_cases[i];
+        int ok;
+
+        if (c->kind == KDF_ARGON2ID)
+            continue;
+        describe(c, costs, 1, params, sizeof(params));
+        ok = run_kdf(c, costs, 1, opts.min_seconds, &r);
+        /* HKDF, TLS1-PRF, PBKDF2 and scrypt are in every 3.x default provider */
+        failures += !ok;
+        report(&json, c, params, "n/a", ok, &r);
+    }
+
+    /* Argon2id lanes on the internal thread pool, before and after OSSL_set_max_threads */
+    for (int pass = 0; pass < 2; pass++) {
+        const char *pool = pass == 0 ? "none" : "max=4";
+
+        if (pass == 1) {
+#if OPENSSL_VERSION_NUMBER >= 0x30200000L
+            if (!OSSL_set_max_threads(NULL, ARGON2_LANES))
+                pool = "disabled";
+#else
+            pool = "disabled";
+#endif
+        }
+        for (uint32_t threads = 1; threads <= ARGON2_LANES; threads *= 2) {
+            const kdf_case *c = &kdf_cases[NUM_KDF_CASES - 1];
+
+            describe(c, costs, threads, params, sizeof(params));
+            report(&json, c, params, pool, run_kdf(c, costs, threads, opts.min_seconds, &r), &r);
+        }
+    }
+    bench_json_end(&json);
+
+    printf("\n%s\n", failures ? "✗ Some KDFs failed" : "✓ KDF benchmark completed");
+    return failures ? 1 : 0;
+}
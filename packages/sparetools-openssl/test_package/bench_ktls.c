@@ -0,0 +1,402 @@
+#include <openssl/ssl.h>
+#include <openssl/err.h>
+#include <openssl/bio.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "bench_common.h"
+#include "bench_tls.h"
+
+/**
+ * Bulk record-layer benchmark
+ *
+ * Streams data over a TCP loopback connection (TLS 1.3, AES-128-GCM) and
+ * reports Gbit/s for:
+ * - userspace:        SSL_write of 16 KiB (one record per write)
+ * - userspace-large:  SSL_write of 256 KiB (many records per write)
+ * - pipelined:        256 KiB writes with SSL_CTX_set_max_pipelines(4) and
+ *                     SSL_CTX_set_split_send_fragment(4096)
+ * - tls12-cbc-etm:    TLS 1.2 ECDHE-ECDSA-AES128-SHA256 with
+ *                     encrypt-then-MAC, AES and HMAC as separate passes
+ * - tls12-cbc-stitched: the same without encrypt-then-MAC, so libssl uses
+ *                     AES-128-CBC-HMAC-SHA256 and, for 256 KiB writes,
+ *                     its multiblock path
+ * - ktls:             SSL_OP_ENABLE_KTLS, SSL_write of 16 KiB
+ * - ktls-sendfile:    SSL_OP_ENABLE_KTLS, SSL_sendfile() from a file
+ *
+ * Pipelining only takes effect with a cipher flagged
+ * EVP_CIPH_FLAG_PIPELINE and multiblock only with a stitched cipher
+ * flagged EVP_CIPH_FLAG_TLS1_1_MULTIBLOCK, so those records carry
+ * "pipeline_capable" and "multiblock_capable" for the negotiated cipher.
+ *
+ * Every record states whether kernel TLS was actually active on the
+ * sending and receiving side, which requires a package built with
+ * enable_ktls=True and the Linux "tls" module loaded. ktls-sendfile is
+ * skipped when kTLS transmit is not active.
+ */
+
+#define TRANSFER_BYTES (256UL * 1024 * 1024)
+#define QUICK_TRANSFER_BYTES (8UL * 1024 * 1024)
+#define READ_CHUNK (64 * 1024)
+
+typedef struct {
+    const char *name;
+    int ktls;
+    int sendfile;
+    size_t write_size;
+    int tls12_cbc;            /* 1 = TLS 1.2 AES128-SHA256 with ETM, 2 = without */
+    long max_pipelines;       /* 0 = library default */
+    long split_fragment;
+} transfer_mode;
+
+static const transfer_mode modes[] = {
+    {"userspace", 0, 0, 16384, 0, 0, 0},
+    {"userspace-large", 0, 0, 262144, 0, 0, 0},
+    {"pipelined", 0, 0, 262144, 0, 4, 4096},
+    {"tls12-cbc-etm", 0, 0, 262144, 1, 0, 0},
+    {"tls12-cbc-stitched", 0, 0, 262144, 2, 0, 0},
+    {"ktls", 1, 0, 16384, 0, 0, 0},
+    {"ktls-sendfile", 1, 1, 0, 0, 0, 0},
+};
+#define NUM_MODES (sizeof(modes) / sizeof(modes[0]))
+
+typedef struct {
+    int fd;
+    SSL_CTX *ctx;
+    size_t expect;
+    size_t received;
+    int ktls_recv;
+    int failed;
+} receiver_arg;
+
+/** Connected TCP loopback pair: fds[0] client side, fds[1] server side */
+static int tcp_pair(int fds[2]) {
+    struct sockaddr_in addr;
+    socklen_t len = sizeof(addr);
+    int lsock = socket(AF_INET, SOCK_STREAM, 0);
+
+    fds[0] = fds[1] = -1;
+    if (lsock < 0)
+        return 1;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (bind(lsock, (struct sockaddr *)&addr, sizeof(addr)) != 0
+        || listen(lsock, 1) != 0
+        || getsockname(lsock, (struct sockaddr *)&addr, &len) != 0
+        || (fds[0] = socket(AF_INET, SOCK_STREAM, 0)) < 0
+        || connect(fds[0], (struct sockaddr *)&addr, sizeof(addr)) != 0
+        || (fds[1] = accept(lsock, NULL, NULL)) < 0) {
+        if (fds[0] >= 0)
+            close(fds[0]);
+        close(lsock);
+        return 1;
+    }
+    close(lsock);
+    return 0;
+}
+
+static void *receiver(void *varg) {
+    receiver_arg *arg = varg;
+    unsigned char *buf = malloc(READ_CHUNK);
+    SSL *ssl = SSL_new(arg->ctx);
+
+    if (buf == NULL || ssl == NULL || !SSL_set_fd(ssl, arg->fd) || SSL_accept(ssl) != 1) {
+        arg->failed = 1;
+        goto done;
+    }
+#ifndef OPENSSL_NO_KTLS
+    arg->ktls_recv = BIO_get_ktls_recv(SSL_get_rbio(ssl)) > 0;
+#endif
+    while (arg->received < arg->expect) {
+        int n = SSL_read(ssl, buf, READ_CHUNK);
+        if (n <= 0) {
+            arg->failed = 1;
+            break;
+        }
+        arg->received += (size_t)n;
+    }
+    SSL_shutdown(ssl);
+done:
+    SSL_free(ssl);
+    free(buf);
+    return NULL;
+}
+
+/** File of `size` bytes for SSL_sendfile; unlinked immediately */
+static int make_payload_file(size_t size) {
+    char path[] = "/tmp/bench_ktls_XXXXXX";
+    unsigned char block[READ_CHUNK];
+    int fd = mkstemp(path);
+
+    if (fd < 0)
+        return -1;
+    unlink(path);
+    memset(block, 0x6b, sizeof(block));
+    for (size_t written = 0; written < size; written += sizeof(block)) {
+        if (write(fd, block, sizeof(block)) != (ssize_t)sizeof(block)) {
+            close(fd);
+            return -1;
+        }
+    }
+    return fd;
+}
+
+static int send_all(SSL *ssl, const transfer_mode *mode, size_t total, int file_fd) {
+    size_t sent = 0;
+
+    if (mode->sendfile) {
+        while (sent < total) {
+            ossl_ssize_t n = SSL_sendfile(ssl, file_fd, (off_t)sent, total - sent, 0);
+            if (n <= 0)
+                return 1;
+            sent += (size_t)n;
+        }
+        return 0;
+    }
+
+    {
+        unsigned char *buf = malloc(mode->write_size);
+        if (buf == NULL)
+            return 1;
+        memset(buf, 0x6b, mode->write_size);
+        while (sent < total) {
+            size_t chunk = total - sent < mode->write_size ? total - sent : mode->write_size;
+            int n = SSL_write(ssl, buf, (int)chunk);
+            if (n <= 0) {
+                free(buf);
+                return 1;
+            }
+            sent += (size_t)n;
+        }
+        free(buf);
+    }
+    return 0;
+}
+
+/*
+ * EVP flags of the cipher libssl encrypts records with. Without
+ * encrypt-then-MAC, TLS 1.2 AES-CBC-SHA suites use the stitched cipher
+ * when the provider has one.
+ */
+static unsigned long negotiated_cipher_flags(SSL *ssl, const transfer_mode *mode) {
+    const SSL_CIPHER *c = SSL_get_current_cipher(ssl);
+    const char *name = NULL;
+    EVP_CIPHER *cipher;
+    unsigned long flags;
+
+    if (c == NULL)
+        return 0;
+    if (mode->tls12_cbc == 2)
+        cipher = EVP_CIPHER_fetch(NULL, "AES-128-CBC-HMAC-SHA256", NULL);
+    else
+        cipher = (name = OBJ_nid2sn(SSL_CIPHER_get_cipher_nid(c))) != NULL
+            ? EVP_CIPHER_fetch(NULL, name, NULL) : NULL;
+    flags = cipher != NULL ? EVP_CIPHER_get_flags(cipher) : 0;
+    EVP_CIPHER_free(cipher);
+    ERR_clear_error();
+    return flags;
+}
+
+/**
+ * Run one transfer. Returns Gbit/s, 0 when skipped, or a negative value
+ * on failure.
+ */
+static double run_mode(const transfer_mode *mode, SSL_CTX *client_ctx, SSL_CTX *server_ctx,
+                       size_t total, int file_fd, int *ktls_send, int *ktls_recv,
+                       unsigned long *cipher_flags) {
+    receiver_arg rarg;
+    pthread_t thread;
+    SSL *ssl = NULL;
+    int fds[2], failed = 0;
+    double start, elapsed;
+
+    if (tcp_pair(fds) != 0)
+        return -1.0;
+
+    memset(&rarg, 0, sizeof(rarg));
+    rarg.fd = fds[1];
+    rarg.ctx = server_ctx;
+    rarg.expect = total;
+    if (pthread_create(&thread, NULL, receiver, &rarg) != 0) {
+        close(fds[0]);
+        close(fds[1]);
+        return -1.0;
+    }
+
+    ssl = SSL_new(client_ctx);
+    if (ssl == NULL || !SSL_set_fd(ssl, fds[0]) || SSL_connect(ssl) != 1) {
+        failed = 1;
+        shutdown(fds[0], SHUT_RDWR);
+    }
+    *ktls_send = 0;
+#ifndef OPENSSL_NO_KTLS
+    if (!failed)
+        *ktls_send = BIO_get_ktls_send(SSL_get_wbio(ssl)) > 0;
+#endif
+    if (!failed)
+        *cipher_flags = negotiated_cipher_flags(ssl, mode);
+
+    start = bench_now();
+    if (!failed && mode->sendfile && !*ktls_send) {
+        /* SSL_sendfile requires kTLS transmit; nothing to measure */
+        shutdown(fds[0], SHUT_RDWR);
+        pthread_join(thread, NULL);
+        SSL_free(ssl);
+        close(fds[0]);
+        close(fds[1]);
+        *ktls_recv = rarg.ktls_recv;
+        return 0.0;
+    }
+    if (!failed && send_all(ssl, mode, total, file_fd) != 0) {
+        failed = 1;
+        shutdown(fds[0], SHUT_RDWR);
+    }
+    pthread_join(thread, NULL);
+    elapsed = bench_now() - start;
+
+    if (!failed)
+        SSL_shutdown(ssl);
+    SSL_free(ssl);
+    close(fds[0]);
+    close(fds[1]);
+
+    *ktls_recv = rarg.ktls_recv;
+    if (failed || rarg.failed || rarg.received < total)
+        return -1.0;
+    return (double)total * 8.0 / elapsed / 1e9;
+}
+
+int main(int argc, char **argv) {
+    bench_options opts;
+    bench_json json;
+    EVP_PKEY *pkey = NULL;
+    X509 *cert = NULL;
+    size_t total;
+    int file_fd, failures = 0;
+
+    if (bench_parse_args(argc, argv, "bench_ktls.json", &opts) != argc)
+        return 2;
+    total = opts.quick ? QUICK_TRANSFER_BYTES : TRANSFER_BYTES;
+    /* A failed peer must surface as an SSL error, not kill the process */
+    signal(SIGPIPE, SIG_IGN);
+
+    printf("=================================\n");
+    printf("OpenSSL Bulk Record-Layer Benchmark\n");
+    printf("=================================\n");
+    printf("OpenSSL version: %s\n", OpenSSL_version(OPENSSL_VERSION));
+#ifdef OPENSSL_NO_KTLS
+    printf("⚠ Library built without kTLS support (enable_ktls=False)\n");
+#endif
+    printf("Transfer size: %zu MiB per mode\n\n", total / (1024 * 1024));
+
+    if (bench_tls_make_cert("EC", &pkey, &cert) != 0)
+        return 1;
+    if ((file_fd = make_payload_file(total)) < 0) {
+        fprintf(stderr, "ERROR: Cannot create sendfile payload\n");
+        X509_free(cert);
+        EVP_PKEY_free(pkey);
+        return 1;
+    }
+    if (bench_json_begin(&json, &opts, "ktls") != 0) {
+        close(file_fd);
+        X509_free(cert);
+        EVP_PKEY_free(pkey);
+        return 1;
+    }
+
+    for (size_t m = 0; m < NUM_MODES; m++) {
+        SSL_CTX *client_ctx, *server_ctx;
+        int ktls_send = 0, ktls_recv = 0;
+        unsigned long cipher_flags = 0;
+        double gbps;
+
+        if (bench_tls_make_ctx_pair(pkey, cert, &client_ctx, &server_ctx) != 0) {
+            failures++;
+            break;
+        }
+        SSL_CTX_set_ciphersuites(client_ctx, "TLS_AES_128_GCM_SHA256");
+        SSL_CTX_set_ciphersuites(server_ctx, "TLS_AES_128_GCM_SHA256");
+        if (modes[m].tls12_cbc) {
+            SSL_CTX *ctxs[2] = {client_ctx, server_ctx};
+
+            for (int c = 0; c < 2; c++) {
+                SSL_CTX_set_min_proto_version(ctxs[c], TLS1_2_VERSION);
+                SSL_CTX_set_max_proto_version(ctxs[c], TLS1_2_VERSION);
+                SSL_CTX_set_cipher_list(ctxs[c], "ECDHE-ECDSA-AES128-SHA256");
+                if (modes[m].tls12_cbc == 2)
+                    SSL_CTX_set_options(ctxs[c], SSL_OP_NO_ENCRYPT_THEN_MAC);
+            }
+        }
+        if (modes[m].max_pipelines > 0) {
+            SSL_CTX_set_max_pipelines(client_ctx, modes[m].max_pipelines);
+            SSL_CTX_set_max_pipelines(server_ctx, modes[m].max_pipelines);
+            SSL_CTX_set_split_send_fragment(client_ctx, modes[m].split_fragment);
+            SSL_CTX_set_split_send_fragment(server_ctx, modes[m].split_fragment);
+        }
+        if (modes[m].ktls) {
+            SSL_CTX_set_options(client_ctx, SSL_OP_ENABLE_KTLS);
+            SSL_CTX_set_options(server_ctx, SSL_OP_ENABLE_KTLS);
+        }
+
+        gbps = run_mode(&modes[m], client_ctx, server_ctx, total, file_fd,
+                        &ktls_send, &ktls_recv, &cipher_flags);
+        SSL_CTX_free(client_ctx);
+        SSL_CTX_free(server_ctx);
+
+        if (gbps < 0) {
+            fprintf(stderr, "ERROR: %s transfer failed\n", modes[m].name);
+            ERR_print_errors_fp(stderr);
+            failures++;
+            continue;
+        }
+        if (gbps == 0) {
+            printf("  %-18s skipped (kTLS transmit not active)\n", modes[m].name);
+            continue;
+        }
+        printf("  %-18s %8.2f Gbit/s  ktls tx=%d rx=%d", modes[m].name, gbps, ktls_send, ktls_recv);
+        if (modes[m].max_pipelines > 0)
+            printf("  pipeline=%d", (cipher_flags & EVP_CIPH_FLAG_PIPELINE) != 0);
+        if (modes[m].tls12_cbc)
+            printf("  multiblock=%d", (cipher_flags & EVP_CIPH_FLAG_TLS1_1_MULTIBLOCK) != 0);
+        printf("\n");
+
+        bench_json_record_begin(&json);
+        bench_json_str(&json, "mode", modes[m].name);
+        bench_json_int(&json, "bytes", total);
+        bench_json_int(&json, "write_size", modes[m].write_size);
+        bench_json_num(&json, "gbit_per_s", gbps);
+        bench_json_int(&json, "ktls_send", (uint64_t)ktls_send);
+        bench_json_int(&json, "ktls_recv", (uint64_t)ktls_recv);
+        if (modes[m].max_pipelines > 0) {
+            bench_json_int(&json, "max_pipelines", (uint64_t)modes[m].max_pipelines);
+            bench_json_int(&json, "split_send_fragment", (uint64_t)modes[m].split_fragment);
+            bench_json_int(&json, "pipeline_capable", (cipher_flags & EVP_CIPH_FLAG_PIPELINE) != 0);
+        }
+        if (modes[m].tls12_cbc) {
+            bench_json_int(&json, "encrypt_then_mac", (uint64_t)(modes[m].tls12_cbc == 1));
+            bench_json_int(&json, "multiblock_capable", (cipher_flags & EVP_CIPH_FLAG_TLS1_1_MULTIBLOCK) != 0);
+        }
+        bench_json_record_end(&json);
+    }
+
+    bench_json_end(&json);
+    close(file_fd);
+    X509_free(cert);
+    EVP_PKEY_free(pkey);
+
+    printf("\n=================================\n");
+    if (failures == 0) {
+        printf("✅ Record-layer benchmark completed (%s)\n", opts.json_path);
+        return 0;
+    }
+    printf("❌ %d benchmark(s) FAILED\n", failures);
+    return 1;
+}
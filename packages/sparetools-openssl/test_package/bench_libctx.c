@@ -0,0 +1,472 @@
+#include <openssl/crypto.h>
+#include <openssl/err.h>
+#include <openssl/evp.h>
+#include <openssl/ssl.h>
+#include <openssl/x509.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "bench_common.h"
+#include "bench_tls.h"
+#include "sparetools_algcache.h"
+#include "sparetools_threadctx.h"
+
+/**
+ * Per-thread OSSL_LIB_CTX isolation benchmark
+ *
+ * Runs fetch-heavy workloads on 1..nproc threads twice:
+ *
+ * - shared:   every thread uses the default library context, one key,
+ *             one SSL_CTX pair and one algcache
+ * - isolated: every thread takes its own context from a
+ *             SpareTools::threadctx pool (own provider load and
+ *             pre-fetched algorithms) and creates its key and SSL_CTX
+ *             pair in it
+ *
+ * Workloads:
+ * - fetch-sha256:      EVP_MD_fetch + EVP_MD_free (method store, name map)
+ * - hmac-sha256:       EVP_Q_mac over 64 bytes (MAC and digest fetch per call)
+ * - sha256-prefetched: EVP_Digest with the algcache handle (no fetch, the
+ *                      contention-free reference)
+ * - ecdsa-p256-sign:   EVP_DigestSignInit_ex by name + EVP_DigestSign
+ * - tls13-handshake:   full handshake over an in-memory BIO pair
+ *
+ * Reported: ops/s, efficiency (rate at N threads / N x the 1-thread
+ * rate) and, for isolated runs, the rate relative to shared at the same
+ * thread count. A "context" record gives what isolation costs: live
+ * OpenSSL heap bytes and set-up time per context, without and with a
+ * key, certificate and SSL_CTX pair, counted through
+ * CRYPTO_set_mem_functions hooks (omitted when another allocator hook
+ * was installed first).
+ *
+ * --max-threads N overrides the online CPU count as the upper bound.
+ */
+
+typedef enum {
+    WL_FETCH,
+    WL_HMAC,
+    WL_PREFETCHED,
+    WL_ECDSA_SIGN,
+    WL_HANDSHAKE
+} workload;
+
+static const char *workload_names[] = {"fetch-sha256", "hmac-sha256", "sha256-prefetched", "ecdsa-p256-sign",
+                                       "tls13-handshake"};
+#define NUM_WORKLOADS 5
+
+/* Thread counts measured: 1, 2, 4, ... max */
+#define MAX_STEPS 16
+
+/* Contexts created for the memory figures */
+#define MEMORY_SAMPLES 4
+
+/* Everything a workload touches, all from one library context */
+typedef struct {
+    OSSL_LIB_CTX *libctx;              /* NULL: default context */
+    const SPARETOOLS_ALGCACHE *cache;
+    EVP_PKEY *key;
+    X509 *cert;
+    SSL_CTX *client;
+    SSL_CTX *server;
+} bench_res;
+
+static atomic_int ready_count;
+static atomic_int start_flag;
+static atomic_int stop_flag;
+
+typedef struct {
+    pthread_t thread;
+    SPARETOOLS_THREADCTX_POOL *pool;   /* NULL: use shared */
+    const bench_res *shared;
+    workload wl;
+    unsigned long long ops;
+    int failed;
+} thread_arg;
+
+/* Live-byte counting hooks: a size header in front of every block */
+#define HOOK_HEADER 16
+static CRYPTO_malloc_fn next_malloc;
+static CRYPTO_realloc_fn next_realloc;
+static CRYPTO_free_fn next_free;
+static atomic_llong live_bytes;
+static int counting;
+
+static void *count_malloc(size_t num, const char *file, int line) {
+    unsigned char *p = next_malloc != NULL ? next_malloc(num + HOOK_HEADER, file, line) : malloc(num + HOOK_HEADER);
+
+    if (p == NULL)
+        return NULL;
+    memcpy(p, &num, sizeof(num));
+    atomic_fetch_add(&live_bytes, (long long)num);
+    return p + HOOK_HEADER;
+}
+
+static void *count_realloc(void *addr, size_t num, const char *file, int line) {
+    unsigned char *p, *base = addr != NULL ? (unsigned char *)addr - HOOK_HEADER : NULL;
+    size_t old = 0;
+
+    if (base != NULL)
+        memcpy(&old, base, sizeof(old));
+    p = next_realloc != NULL ? next_realloc(base, num + HOOK_HEADER, file, line) : realloc(base, num + HOOK_HEADER);
+    if (p == NULL)
+        return NULL;
+    memcpy(p, &num, sizeof(num));
+    atomic_fetch_add(&live_bytes, (long long)num - (long long)old);
+    return p + HOOK_HEADER;
+}
+
+static void count_free(void *addr, const char *file, int line) {
+    unsigned char *base;
+    size_t old;
+
+    if (addr == NULL)
+        return;
+    base = (unsigned char *)addr - HOOK_HEADER;
+    memcpy(&old, base, sizeof(old));
+    atomic_fetch_sub(&live_bytes, (long long)old);
+    if (next_free != NULL)
+        next_free(base, file, line);
+    else
+        free(base);
+}
+
+/* Must run before OpenSSL's first allocation; returns 1 if counting is active */
+static int install_byte_counter(void) {
+    CRYPTO_get_mem_functions(&next_malloc, &next_realloc, &next_free);
+    if (next_malloc == CRYPTO_malloc) {
+        next_malloc = NULL;
+        next_realloc = NULL;
+        next_free = NULL;
+    }
+    return CRYPTO_set_mem_functions(count_malloc, count_realloc, count_free);
+}
+
+static void free_res(bench_res *res) {
+    SSL_CTX_free(res->client);
+    SSL_CTX_free(res->server);
+    X509_free(res->cert);
+    EVP_PKEY_free(res->key);
+    memset(res, 0, sizeof(*res));
+}
+
+/* Self-signed P-256 certificate signed within libctx */
+static X509 *make_cert(OSSL_LIB_CTX *libctx, EVP_PKEY *key) {
+    X509 *cert = X509_new_ex(libctx, NULL);
+    EVP_MD_CTX *md = EVP_MD_CTX_new();
+    X509_NAME *name;
+    int ok = cert != NULL && md != NULL
+        && X509_set_version(cert, 2)
+        && ASN1_INTEGER_set(X509_get_serialNumber(cert), 1)
+        && X509_gmtime_adj(X509_getm_notBefore(cert), 0) != NULL
+        && X509_gmtime_adj(X509_getm_notAfter(cert), 86400L) != NULL
+        && X509_set_pubkey(cert, key)
+        && (name = X509_get_subject_name(cert)) != NULL
+        && X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC, (const unsigned char *)"bench.sparetools.local",
+                                      -1, -1, 0)
+        && X509_set_issuer_name(cert, name)
+        && EVP_DigestSignInit_ex(md, NULL, "SHA2-256", libctx, NULL, key, NULL) == 1
+        && X509_sign_ctx(cert, md) > 0;
+
+    EVP_MD_CTX_free(md);
+    if (!ok) {
+        X509_free(cert);
+        return NULL;
+    }
+    return cert;
+}
+
+/* Key, certificate and TLS 1.3 SSL_CTX pair in libctx */
+static int make_res(OSSL_LIB_CTX *libctx, const SPARETOOLS_ALGCACHE *cache, bench_res *res) {
+    memset(res, 0, sizeof(*res));
+    res->libctx = libctx;
+    res->cache = cache;
+    if ((res->key = EVP_PKEY_Q_keygen(libctx, NULL, "EC", "P-256")) == NULL
+        || (res->cert = make_cert(libctx, res->key)) == NULL
+        || (res->client = SSL_CTX_new_ex(libctx, NULL, TLS_client_method())) == NULL
+        || (res->server = SSL_CTX_new_ex(libctx, NULL, TLS_server_method())) == NULL
+        || !SSL_CTX_set_min_proto_version(res->client, TLS1_3_VERSION)
+        || !SSL_CTX_set_min_proto_version(res->server, TLS1_3_VERSION)
+        || SSL_CTX_use_certificate(res->server, res->cert) != 1
+        || SSL_CTX_use_PrivateKey(res->server, res->key) != 1) {
+        free_res(res);
+        return 1;
+    }
+    SSL_CTX_set_verify(res->client, SSL_VERIFY_NONE, NULL);
+    /* Full handshakes only */
+    SSL_CTX_set_session_cache_mode(res->client, SSL_SESS_CACHE_OFF);
+    SSL_CTX_set_num_tickets(res->server, 0);
+    return 0;
+}
+
+static int run_once(const bench_res *res, workload wl) {
+    static const unsigned char data[64] = "per-thread library context benchmark";
+    unsigned char out[EVP_MAX_MD_SIZE], sig[128];
+    size_t out_len = sizeof(out), sig_len = sizeof(sig);
+
+    switch (wl) {
+    case WL_FETCH: {
+        EVP_MD *md = EVP_MD_fetch(res->libctx, "SHA2-256", NULL);
+
+        EVP_MD_free(md);
+        return md != NULL;
+    }
+    case WL_HMAC:
+        return EVP_Q_mac(res->libctx, "HMAC", NULL, "SHA2-256", NULL, data, 32, data, sizeof(data), out,
+                         sizeof(out), &out_len) != NULL;
+    case WL_PREFETCHED:
+        return EVP_Digest(data, sizeof(data), out, NULL, sparetools_algcache_md(res->cache, "SHA2-256"), NULL);
+    case WL_ECDSA_SIGN: {
+        EVP_MD_CTX *md = EVP_MD_CTX_new();
+        int ok = md != NULL
+            && EVP_DigestSignInit_ex(md, NULL, "SHA2-256", res->libctx, NULL, res->key, NULL) == 1
+            && EVP_DigestSign(md, sig, &sig_len, data, sizeof(data)) == 1;
+
+        EVP_MD_CTX_free(md);
+        return ok;
+    }
+    default: {
+        SSL *client = NULL, *server = NULL;
+        int ok = bench_tls_make_ssl_pair(res->client, res->server, &client, &server) == 0
+            && bench_tls_handshake(client, server);
+
+        SSL_free(client);
+        SSL_free(server);
+        return ok;
+    }
+    }
+}
+
+static void *worker(void *p) {
+    thread_arg *arg = p;
+    bench_res own = {0};
+    const bench_res *res = arg->shared;
+    int ok = 1;
+
+    if (arg->pool != NULL) {
+        const SPARETOOLS_THREADCTX *ctx = sparetools_threadctx_get(arg->pool);
+
+        ok = ctx != NULL
+            && make_res(sparetools_threadctx_libctx(ctx), sparetools_threadctx_algcache(ctx), &own) == 0;
+        res = &own;
+    }
+    atomic_fetch_add(&ready_count, 1);
+    while (!atomic_load(&start_flag))
+        ;
+    while (ok && !atomic_load(&stop_flag)) {
+        ok = run_once(res, arg->wl);
+        arg->ops += ok;
+    }
+    arg->failed = !ok;
+    /* Before the thread exit frees the context these came from */
+    if (arg->pool != NULL)
+        free_res(&own);
+    return NULL;
+}
+
+/* Operations per second, or a negative value on failure */
+static double run_threads(SPARETOOLS_THREADCTX_POOL *pool, const bench_res *shared, workload wl, int nthreads,
+                          double seconds) {
+    thread_arg *args = calloc((size_t)nthreads, sizeof(*args));
+    unsigned long long ops = 0;
+    double start, elapsed;
+    int failed = args == NULL, started = 0;
+
+    atomic_store(&ready_count, 0);
+    atomic_store(&start_flag, 0);
+    atomic_store(&stop_flag, 0);
+    for (int t = 0; !failed && t < nthreads; t++) {
+        args[t].pool = pool;
+        args[t].shared = shared;
+        args[t].wl = wl;
+        if (pthread_create(&args[t].thread, NULL, worker, &args[t]) != 0) {
+            failed = 1;
+            break;
+        }
+        started++;
+    }
+    /* Isolated threads set up their context before the clock starts */
+    while (atomic_load(&ready_count) < started)
+        usleep(100);
+
+    start = bench_now();
+    atomic_store(&start_flag, 1);
+    while (!failed && bench_now() - start < seconds)
+        usleep(1000);
+    atomic_store(&stop_flag, 1);
+
+    for (int t = 0; t < started; t++) {
+        pthread_join(args[t].thread, NULL);
+        ops += args[t].ops;
+        failed |= args[t].failed;
+    }
+    elapsed = bench_now() - start;
+    free(args);
+    return failed ? -1.0 : (double)ops / elapsed;
+}
+
+/**
+ * Live bytes and set-up seconds per standalone context, bare and with a
+ * key, certificate and SSL_CTX pair. Returns 0 on success.
+ */
+static int measure_context_cost(double *bytes, double *bytes_tls, double *setup_ms) {
+    SPARETOOLS_THREADCTX *ctxs[MEMORY_SAMPLES] = {0};
+    bench_res res[MEMORY_SAMPLES];
+    long long before, after_ctx, after_res;
+    double start, elapsed;
+    int ok = 1, made = 0;
+
+    before = atomic_load(&live_bytes);
+    start = bench_now();
+    for (int i = 0; ok && i < MEMORY_SAMPLES; i++)
+        ok = (ctxs[i] = sparetools_threadctx_new(NULL)) != NULL;
+    elapsed = bench_now() - start;
+    after_ctx = atomic_load(&live_bytes);
+    for (; ok && made < MEMORY_SAMPLES; made++)
+        ok = make_res(sparetools_threadctx_libctx(ctxs[made]), sparetools_threadctx_algcache(ctxs[made]),
+                      &res[made]) == 0;
+    after_res = atomic_load(&live_bytes);
+
+    for (int i = 0; i < made; i++)
+        free_res(&res[i]);
+    for (int i = 0; i < MEMORY_SAMPLES; i++)
+        sparetools_threadctx_free(ctxs[i]);
+    if (!ok)
+        return 1;
+    *bytes = (double)(after_ctx - before) / MEMORY_SAMPLES;
+    *bytes_tls = (double)(after_res - before) / MEMORY_SAMPLES;
+    *setup_ms = elapsed * 1e3 / MEMORY_SAMPLES;
+    return 0;
+}
+
+/* 1, 2, 4, ... max_threads, then 0 */
+static int next_thread_count(int n, int max) {
+    if (n >= max)
+        return 0;
+    return n * 2 > max ? max : n * 2;
+}
+
+int main(int argc, char **argv) {
+    bench_options opts;
+    bench_json json;
+    bench_res shared;
+    SPARETOOLS_THREADCTX_POOL *pool;
+    SPARETOOLS_ALGCACHE *shared_cache;
+    double shared_rates[NUM_WORKLOADS][MAX_STEPS] = {{0}};
+    double bytes = 0, bytes_tls = 0, setup_ms = 0;
+    int failures = 0, max_threads;
+    long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+    int argi;
+
+    counting = install_byte_counter();
+    argi = bench_parse_args(argc, argv, "bench_libctx.json", &opts);
+    if (argi < 0)
+        return 2;
+    max_threads = ncpu > 0 ? (int)ncpu : 1;
+    for (; argi < argc; argi++) {
+        if (strcmp(argv[argi], "--max-threads") == 0 && argi + 1 < argc) {
+            max_threads = atoi(argv[++argi]);
+        } else {
+            fprintf(stderr, "Usage: %s [--quick] [--json PATH] [--max-threads N]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (max_threads < 1)
+        max_threads = 1;
+    if (opts.quick && max_threads > 4)
+        max_threads = 4;
+
+    printf("=================================\n");
+    printf("Per-Thread Library Context Benchmark\n");
+    printf("=================================\n");
+    printf("OpenSSL version: %s\n\n", OpenSSL_version(OPENSSL_VERSION));
+    if (bench_json_begin(&json, &opts, "libctx") != 0)
+        return 1;
+
+    pool = sparetools_threadctx_pool_new(NULL);
+    shared_cache = sparetools_algcache_new(NULL, NULL, NULL, NULL);
+    if (pool == NULL || shared_cache == NULL || make_res(NULL, shared_cache, &shared) != 0) {
+        fprintf(stderr, "ERROR: Failed to set up the benchmark contexts\n");
+        ERR_print_errors_fp(stderr);
+        return 1;
+    }
+
+    if (measure_context_cost(&bytes, &bytes_tls, &setup_ms) != 0) {
+        printf("  isolated context set-up failed\n");
+        ERR_print_errors_fp(stderr);
+        failures++;
+    } else {
+        if (counting)
+            printf("  Per context: %.0f KiB live heap, %.0f KiB with key, certificate and SSL_CTX pair\n",
+                   bytes / 1024, bytes_tls / 1024);
+        else
+            printf("  Per context: heap bytes not counted (allocator hooks installed elsewhere)\n");
+        printf("  Set-up per context (provider load + pre-fetch): %.2f ms\n\n", setup_ms);
+        bench_json_record_begin(&json);
+        bench_json_str(&json, "mode", "isolated");
+        bench_json_str(&json, "workload", "context");
+        if (counting) {
+            bench_json_num(&json, "bytes_per_context", bytes);
+            bench_json_num(&json, "bytes_per_context_tls", bytes_tls);
+        }
+        bench_json_num(&json, "setup_ms", setup_ms);
+        bench_json_record_end(&json);
+    }
+
+    printf("  %-8s %-18s %7s %12s %10s %11s\n", "Mode", "Workload", "Threads", "ops/s", "efficiency",
+           "vs shared");
+    for (int isolated = 0; isolated < 2; isolated++) {
+        const char *mode = isolated ? "isolated" : "shared";
+
+        for (int w = 0; w < NUM_WORKLOADS; w++) {
+            double single = 0;
+            int step = 0;
+
+            for (int threads = 1; threads != 0 && step < MAX_STEPS;
+                 threads = next_thread_count(threads, max_threads), step++) {
+                double rate = run_threads(isolated ? pool : NULL, &shared, (workload)w, threads, opts.min_seconds);
+                double efficiency, relative = 0.0;
+
+                if (rate < 0) {
+                    printf("  %-8s %-18s %7d  FAILED\n", mode, workload_names[w], threads);
+                    ERR_print_errors_fp(stderr);
+                    failures++;
+                    break;
+                }
+                if (threads == 1)
+                    single = rate;
+                efficiency = single > 0 ? rate / (single * threads) : 0.0;
+                if (isolated && shared_rates[w][step] > 0)
+                    relative = rate / shared_rates[w][step];
+                else
+                    shared_rates[w][step] = rate;
+                if (isolated)
+                    printf("  %-8s %-18s %7d %12.0f %10.2f %10.1f%%\n", mode, workload_names[w], threads, rate,
+                           efficiency, (relative - 1.0) * 100.0);
+                else
+                    printf("  %-8s %-18s %7d %12.0f %10.2f %11s\n", mode, workload_names[w], threads, rate,
+                           efficiency, "-");
+                bench_json_record_begin(&json);
+                bench_json_str(&json, "mode", mode);
+                bench_json_str(&json, "workload", workload_names[w]);
+                bench_json_int(&json, "threads", (uint64_t)threads);
+                bench_json_num(&json, "ops_per_sec", rate);
+                bench_json_num(&json, "efficiency", efficiency);
+                if (isolated)
+                    bench_json_num(&json, "relative_to_shared", relative);
+                bench_json_record_end(&json);
+            }
+        }
+    }
+    bench_json_end(&json);
+
+    free_res(&shared);
+    sparetools_algcache_free(shared_cache);
+    sparetools_threadctx_pool_free(pool);
+
+    printf("\n%s\n", failures ? "✗ Some library context runs failed" : "✓ All library context runs completed");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,978 @@
+#define _GNU_SOURCE
+
+#include <openssl/err.h>
+#include <openssl/ssl.h>
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "bench_common.h"
+#include "bench_tls.h"
+
+/**
+ * Multi-node TLS load generator and reference server
+ *
+ * Loopback benchmarks keep NIC, IRQ and kernel network stack effects out
+ * of the numbers. This binary runs on separate machines instead, one
+ * --serve node and any number of --connect nodes, coordinated by
+ * openssl_tools/openssl/loadgen_controller.py (plain SSH):
+ *
+ *   bench_loadgen --json s.json --serve PORT [--threads N] [--key EC|RSA|...]
+ *                 [--duration S] [--stop-on-eof]
+ *   bench_loadgen --json c.json --connect HOST:PORT [--threads N] [--conns N]
+ *                 [--requests N] [--size BYTES] [--duration S]
+ *                 [--start-at EPOCH] [--hist PATH]
+ *
+ * Both sides run one epoll loop per thread over nonblocking sockets (the
+ * server with one SO_REUSEPORT listener per thread), so a single core
+ * drives --conns connections at once. A client connection connects,
+ * completes a TLS 1.3 full handshake, then issues --requests requests
+ * (0: until the end of the run) and reconnects. A request is a 4-byte
+ * big-endian size; the server answers with that many bytes.
+ *
+ * Latencies go into HDR-style log-linear histograms (1024 sub-buckets
+ * per power of two, < 0.1% error, microseconds): handshake latency from
+ * connect() to handshake completion, request latency from request to
+ * full response. --hist writes them as "name low_us high_us count" lines,
+ * which the controller sums across nodes before taking percentiles, so
+ * aggregate percentiles are exact rather than averaged. --start-at
+ * (wall clock) starts all client nodes together.
+ *
+ * Without --serve or --connect it runs both sides in one process on
+ * loopback, as a smoke test of the whole path.
+ */
+
+#define DEFAULT_CONNS 32
+#define DEFAULT_SIZE 1024
+#define DEFAULT_DURATION 10.0
+#define MAX_THREADS 256
+#define IO_CHUNK 16384
+#define MAX_EVENTS 256
+
+/* ---- log-linear latency histogram ---- */
+
+#define HDR_SUB_BITS 10
+#define HDR_SUB_COUNT (1 << HDR_SUB_BITS)
+#define HDR_OCTAVES 27              /* Up to 2^36 us, about 19 hours */
+#define HDR_BUCKETS ((HDR_OCTAVES + 1) * HDR_SUB_COUNT)
+
+typedef struct {
+    uint64_t counts[HDR_BUCKETS];
+    uint64_t total;
+    uint64_t max;
+} hdr_hist;
+
+static int hdr_index(uint64_t v) {
+    int msb, shift;
+
+    if (v < HDR_SUB_COUNT)
+        return (int)v;
+    msb = 63 - __builtin_clzll(v);
+    shift = msb - HDR_SUB_BITS;
+    if (shift >= HDR_OCTAVES)
+        return HDR_BUCKETS - 1;
+    return (shift + 1) << HDR_SUB_BITS | (int)((v >> shift) & (HDR_SUB_COUNT - 1));
+}
+
+/* Lowest value of a bucket; the bucket spans [low, low + width) */
+static uint64_t hdr_low(int index, uint64_t *width) {
+    int shift;
+
+    if (index < HDR_SUB_COUNT) {
+        *width = 1;
+        return (uint64_t)index;
+    }
+    shift = (index >> HDR_SUB_BITS) - 1;
+    *width = 1ULL << shift;
+    return (uint64_t)((index & (HDR_SUB_COUNT - 1)) | HDR_SUB_COUNT) << shift;
+}
+
+static void hdr_record(hdr_hist *h, double seconds) {
+    uint64_t us = seconds > 0 ? (uint64_t)(seconds * 1e6 + 0.5) : 0;
+
+    h->counts[hdr_index(us)]++;
+    h->total++;
+    if (us > h->max)
+        h->max = us;
+}
+
+static void hdr_merge(hdr_hist *into, const hdr_hist *from) {
+    for (int i = 0; i < HDR_BUCKETS; i++)
+        into->counts[i] += from->counts[i];
+    into->total += from->total;
+    if (from->max > into->max)
+        into->max = from->max;
+}
+
+/* Percentile (0-100) in microseconds: the middle of the bucket holding it */
+static double hdr_percentile(const hdr_hist *h, double pct) {
+    uint64_t rank = (uint64_t)(pct / 100.0 * (double)h->total + 0.5), seen = 0, width;
+
+    if (h->total == 0)
+        return 0.0;
+    if (rank < 1)
+        rank = 1;
+    for (int i = 0; i < HDR_BUCKETS; i++) {
+        seen += h->counts[i];
+        if (seen >= rank) {
+            double low = (double)hdr_low(i, &width);
+            double mid = low + (double)(width - 1) / 2.0;
+            return mid < (double)h->max ? mid : (double)h->max;
+        }
+    }
+    return (double)h->max;
+}
+
+static void hdr_write(FILE *fp, const char *name, const hdr_hist *h) {
+    for (int i = 0; i < HDR_BUCKETS; i++) {
+        uint64_t width, low;
+
+        if (h->counts[i] == 0)
+            continue;
+        low = hdr_low(i, &width);
+        fprintf(fp, "%s %llu %llu %llu\n", name, (unsigned long long)low,
+                (unsigned long long)(low + width), (unsigned long long)h->counts[i]);
+    }
+}
+
+/* ---- shared ---- */
+
+static atomic_int stop_flag;
+static int stop_pipe[2] = {-1, -1};
+
+static void on_signal(int sig) {
+    (void)sig;
+    atomic_store(&stop_flag, 1);
+    if (stop_pipe[1] >= 0 && write(stop_pipe[1], "s", 1) < 0) {
+        /* Nothing else to do in a signal handler */
+    }
+}
+
+static void set_nodelay(int fd) {
+    int one = 1;
+
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+}
+
+static const unsigned char zeros[IO_CHUNK];
+
+/* ---- server ---- */
+
+typedef struct {
+    int fd;
+    SSL *ssl;
+    unsigned char hdr[4];
+    int hdr_got;
+    uint32_t remaining;         /* Response bytes still to send */
+    int want_write;
+} server_conn;
+
+typedef struct {
+    pthread_t thread;
+    SSL_CTX *ctx;
+    int listen_fd;
+    unsigned long long handshakes;
+    unsigned long long requests;
+    unsigned long long bytes_out;
+    unsigned long long errors;
+    int failed;
+} server_worker;
+
+/*
+ * Handshake, read requests and send responses as far as the socket allows.
+ * Returns 1 to keep the connection (want_write says which event), 0 to close.
+ */
+static int serve_step(server_worker *w, server_conn *c) {
+    int ret;
+
+    c->want_write = 0;
+    if (!SSL_is_init_finished(c->ssl)) {
+        ret = SSL_do_handshake(c->ssl);
+        if (ret != 1) {
+            c->want_write = SSL_get_error(c->ssl, ret) == SSL_ERROR_WANT_WRITE;
+            return bench_tls_retryable(c->ssl, ret);
+        }
+        w->handshakes++;
+    }
+    for (;;) {
+        if (c->remaining > 0) {
+            int n = c->remaining < IO_CHUNK ? (int)c->remaining : IO_CHUNK;
+
+            ret = SSL_write(c->ssl, zeros, n);
+            if (ret <= 0) {
+                c->want_write = SSL_get_error(c->ssl, ret) == SSL_ERROR_WANT_WRITE;
+                return bench_tls_retryable(c->ssl, ret);
+            }
+            c->remaining -= (uint32_t)ret;
+            w->bytes_out += (unsigned long long)ret;
+            continue;
+        }
+        ret = SSL_read(c->ssl, c->hdr + c->hdr_got, 4 - c->hdr_got);
+        if (ret <= 0)
+            return bench_tls_retryable(c->ssl, ret);
+        c->hdr_got += ret;
+        if (c->hdr_got == 4) {
+            c->remaining = (uint32_t)c->hdr[0] << 24 | (uint32_t)c->hdr[1] << 16
+                           | (uint32_t)c->hdr[2] << 8 | c->hdr[3];
+            c->hdr_got = 0;
+            w->requests++;
+        }
+    }
+}
+
+static void server_close(int ep, server_conn *c) {
+    epoll_ctl(ep, EPOLL_CTL_DEL, c->fd, NULL);
+    ERR_clear_error();
+    SSL_free(c->ssl);
+    close(c->fd);
+    free(c);
+}
+
+static void *server_main(void *varg) {
+    server_worker *w = varg;
+    struct epoll_event ev, events[MAX_EVENTS];
+    int ep = epoll_create1(0);
+
+    if (ep < 0) {
+        w->failed = 1;
+        return NULL;
+    }
+    ev.events = EPOLLIN;
+    ev.data.ptr = NULL;
+    epoll_ctl(ep, EPOLL_CTL_ADD, w->listen_fd, &ev);
+    ev.data.ptr = &stop_pipe;
+    epoll_ctl(ep, EPOLL_CTL_ADD, stop_pipe[0], &ev);
+
+    while (!atomic_load(&stop_flag)) {
+        int n = epoll_wait(ep, events, MAX_EVENTS, 200);
+
+        for (int e = 0; e < n; e++) {
+            server_conn *c = events[e].data.ptr;
+            int fd;
+
+            if (events[e].data.ptr == (void *)&stop_pipe)
+                continue;
+            if (c == NULL) {
+                while ((fd = accept4(w->listen_fd, NULL, NULL, SOCK_NONBLOCK)) >= 0) {
+                    if ((c = calloc(1, sizeof(*c))) == NULL || (c->ssl = SSL_new(w->ctx)) == NULL) {
+                        free(c);
+                        close(fd);
+                        w->errors++;
+                        continue;
+                    }
+                    c->fd = fd;
+                    set_nodelay(fd);
+                    SSL_set_fd(c->ssl, fd);
+                    SSL_set_accept_state(c->ssl);
+                    ev.events = EPOLLIN;
+                    ev.data.ptr = c;
+                    epoll_ctl(ep, EPOLL_CTL_ADD, fd, &ev);
+                }
+                continue;
+            }
+            if (!serve_step(w, c)) {
+                /* A clean close by the client is not an error */
+                if (SSL_get_shutdown(c->ssl) == 0 && ERR_peek_error() != 0)
+                    w->errors++;
+                server_close(ep, c);
+                continue;
+            }
+            ev.events = EPOLLIN | (c->want_write ? EPOLLOUT : 0);
+            ev.data.ptr = c;
+            epoll_ctl(ep, EPOLL_CTL_MOD, c->fd, &ev);
+        }
+    }
+    /* Connections still open are dropped with the epoll set */
+    close(ep);
+    return NULL;
+}
+
+/* One SO_REUSEPORT listener per worker on addr; port 0 picks one for all */
+static int open_listeners(server_worker *workers, int n, struct sockaddr_in *addr) {
+    socklen_t len = sizeof(*addr);
+    int one = 1;
+
+    for (int i = 0; i < n; i++) {
+        int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+
+        if (fd < 0
+            || setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &one, sizeof(one)) != 0
+            || setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one)) != 0
+            || bind(fd, (struct sockaddr *)addr, sizeof(*addr)) != 0
+            || listen(fd, 4096) != 0
+            || (i == 0 && getsockname(fd, (struct sockaddr *)addr, &len) != 0)) {
+            fprintf(stderr, "ERROR: Cannot listen on port %d: %s\n", ntohs(addr->sin_port), strerror(errno));
+            if (fd >= 0)
+                close(fd);
+            while (i-- > 0)
+                close(workers[i].listen_fd);
+            return 0;
+        }
+        workers[i].listen_fd = fd;
+    }
+    return 1;
+}
+
+/* ---- client ---- */
+
+typedef enum {
+    CONN_CONNECTING,
+    CONN_HANDSHAKE,
+    CONN_REQUEST,
+    CONN_RESPONSE
+} conn_state;
+
+typedef struct {
+    int fd;
+    SSL *ssl;
+    conn_state state;
+    double started;             /* connect() of the current connection */
+    double requested;           /* Request of the current exchange */
+    uint32_t got;
+    int hdr_sent;
+    int requests_done;
+} client_conn;
+
+typedef struct {
+    pthread_t thread;
+    SSL_CTX *ctx;
+    struct sockaddr_in addr;
+    int conns;
+    int requests;               /* Per connection, 0: unlimited */
+    uint32_t size;
+    double start;
+    double deadline;
+    unsigned long long handshakes;
+    unsigned long long exchanges;
+    unsigned long long bytes_in;
+    unsigned long long errors;
+    hdr_hist *hs_hist;
+    hdr_hist *req_hist;
+    int failed;
+} client_worker;
+
+static int client_open(client_worker *w, int ep, client_conn *c) {
+    /* Reset on close: no TIME_WAIT, so long runs do not exhaust ports */
+    struct linger linger = {1, 0};
+    struct epoll_event ev;
+
+    memset(c, 0, sizeof(*c));
+    c->fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+    if (c->fd < 0)
+        return 0;
+    set_nodelay(c->fd);
+    setsockopt(c->fd, SOL_SOCKET, SO_LINGER, &linger, sizeof(linger));
+    c->started = bench_now();
+    if (connect(c->fd, (struct sockaddr *)&w->addr, sizeof(w->addr)) != 0 && errno != EINPROGRESS) {
+        close(c->fd);
+        c->fd = -1;
+        return 0;
+    }
+    c->state = CONN_CONNECTING;
+    ev.events = EPOLLOUT;
+    ev.data.ptr = c;
+    epoll_ctl(ep, EPOLL_CTL_ADD, c->fd, &ev);
+    return 1;
+}
+
+static void client_close(int ep, client_conn *c) {
+    if (c->fd < 0)
+        return;
+    epoll_ctl(ep, EPOLL_CTL_DEL, c->fd, NULL);
+    if (c->ssl != NULL && SSL_is_init_finished(c->ssl))
+        SSL_shutdown(c->ssl);
+    ERR_clear_error();
+    SSL_free(c->ssl);
+    close(c->fd);
+    c->ssl = NULL;
+    c->fd = -1;
+}
+
+/*
+ * Advance a connection as far as the socket allows. Returns the epoll
+ * events to wait for, 0 to reconnect, -1 on error.
+ */
+static int client_step(client_worker *w, client_conn *c, double now) {
+    unsigned char buf[IO_CHUNK];
+    int ret;
+
+    if (c->state == CONN_CONNECTING) {
+        int err = 0;
+        socklen_t len = sizeof(err);
+
+        if (getsockopt(c->fd, SOL_SOCKET, SO_ERROR, &err, &len) != 0 || err != 0
+            || (c->ssl = SSL_new(w->ctx)) == NULL)
+            return -1;
+        SSL_set_fd(c->ssl, c->fd);
+        SSL_set_connect_state(c->ssl);
+        c->state = CONN_HANDSHAKE;
+    }
+    for (;;) {
+        switch (c->state) {
+        case CONN_HANDSHAKE:
+            if ((ret = SSL_do_handshake(c->ssl)) != 1)
+                goto retry;
+            now = bench_now();
+            hdr_record(w->hs_hist, now - c->started);
+            w->handshakes++;
+            c->state = CONN_REQUEST;
+            break;
+        case CONN_REQUEST: {
+            unsigned char hdr[4] = {(unsigned char)(w->size >> 24), (unsigned char)(w->size >> 16),
+                                    (unsigned char)(w->size >> 8), (unsigned char)w->size};
+
+            if (!c->hdr_sent)
+                c->requested = bench_now();
+            c->hdr_sent = 1;
+            if ((ret = SSL_write(c->ssl, hdr, 4)) <= 0)
+                goto retry;
+            c->got = 0;
+            c->state = CONN_RESPONSE;
+            break;
+        }
+        case CONN_RESPONSE:
+            if ((ret = SSL_read(c->ssl, buf, sizeof(buf))) <= 0)
+                goto retry;
+            c->got += (uint32_t)ret;
+            w->bytes_in += (unsigned long long)ret;
+            if (c->got < w->size)
+                break;
+            now = bench_now();
+            hdr_record(w->req_hist, now - c->requested);
+            w->exchanges++;
+            c->hdr_sent = 0;
+            if (++c->requests_done == w->requests)
+                return 0;
+            if (now >= w->deadline)
+                return 0;
+            c->state = CONN_REQUEST;
+            break;
+        default:
+            return -1;
+        }
+    }
+
+retry:
+    switch (SSL_get_error(c->ssl, ret)) {
+    case SSL_ERROR_WANT_READ:
+        return EPOLLIN;
+    case SSL_ERROR_WANT_WRITE:
+        return EPOLLOUT;
+    default:
+        return -1;
+    }
+}
+
+static void *client_main(void *varg) {
+    client_worker *w = varg;
+    client_conn *conns = calloc((size_t)w->conns, sizeof(*conns));
+    struct epoll_event ev, events[MAX_EVENTS];
+    int ep = epoll_create1(0), open = 0;
+
+    if (conns == NULL || ep < 0) {
+        w->failed = 1;
+        free(conns);
+        if (ep >= 0)
+            close(ep);
+        return NULL;
+    }
+    for (int i = 0; i < w->conns; i++) {
+        if (client_open(w, ep, &conns[i]))
+            open++;
+        else
+            w->errors++;
+    }
+
+    while (open > 0 && !atomic_load(&stop_flag)) {
+        double now = bench_now();
+        int n;
+
+        if (now >= w->deadline)
+            break;
+        n = epoll_wait(ep, events, MAX_EVENTS, 100);
+        for (int e = 0; e < n; e++) {
+            client_conn *c = events[e].data.ptr;
+            int want = client_step(w, c, now);
+
+            if (want > 0) {
+                ev.events = (uint32_t)want;
+                ev.data.ptr = c;
+                epoll_ctl(ep, EPOLL_CTL_MOD, c->fd, &ev);
+                continue;
+            }
+            if (want < 0)
+                w->errors++;
+            client_close(ep, c);
+            open--;
+            if (bench_now() < w->deadline && client_open(w, ep, c))
+                open++;
+        }
+    }
+    for (int i = 0; i < w->conns; i++)
+        client_close(ep, &conns[i]);
+    close(ep);
+    free(conns);
+    return NULL;
+}
+
+static SSL_CTX *client_ctx_new(void) {
+    SSL_CTX *ctx = SSL_CTX_new(TLS_client_method());
+
+    if (ctx == NULL || !SSL_CTX_set_min_proto_version(ctx, TLS1_3_VERSION)) {
+        SSL_CTX_free(ctx);
+        return NULL;
+    }
+    SSL_CTX_set_verify(ctx, SSL_VERIFY_NONE, NULL);
+    SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_OFF);
+    return ctx;
+}
+
+static int resolve(const char *hostport, struct sockaddr_in *addr) {
+    char host[256];
+    const char *colon = strrchr(hostport, ':');
+    struct addrinfo hints, *res = NULL;
+
+    if (colon == NULL || (size_t)(colon - hostport) >= sizeof(host))
+        return 0;
+    memcpy(host, hostport, (size_t)(colon - hostport));
+    host[colon - hostport] = '\0';
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    if (getaddrinfo(host, colon + 1, &hints, &res) != 0 || res == NULL)
+        return 0;
+    memcpy(addr, res->ai_addr, sizeof(*addr));
+    freeaddrinfo(res);
+    return 1;
+}
+
+typedef struct {
+    int threads;
+    int conns;
+    int requests;
+    uint32_t size;
+    double duration;
+    double start_at;            /* Wall clock, 0: now */
+    const char *hist_path;
+} client_options;
+
+typedef struct {
+    unsigned long long handshakes;
+    unsigned long long exchanges;
+    unsigned long long bytes_in;
+    unsigned long long errors;
+    double elapsed;
+    hdr_hist hs_hist;
+    hdr_hist req_hist;
+} client_totals;
+
+static int run_clients(const client_options *co, const struct sockaddr_in *addr, client_totals *t) {
+    client_worker *workers = calloc((size_t)co->threads, sizeof(*workers));
+    SSL_CTX *ctx = client_ctx_new();
+    int started = 0, ok = 1;
+    double start;
+
+    memset(t, 0, sizeof(*t));
+    if (workers == NULL || ctx == NULL) {
+        free(workers);
+        SSL_CTX_free(ctx);
+        return 0;
+    }
+    if (co->start_at > 0) {
+        struct timespec ts;
+        double wait;
+
+        clock_gettime(CLOCK_REALTIME, &ts);
+        wait = co->start_at - ((double)ts.tv_sec + (double)ts.tv_nsec / 1e9);
+        if (wait > 0) {
+            ts.tv_sec = (time_t)wait;
+            ts.tv_nsec = (long)((wait - (double)ts.tv_sec) * 1e9);
+            nanosleep(&ts, NULL);
+        }
+    }
+    start = bench_now();
+    for (int i = 0; i < co->threads; i++) {
+        client_worker *w = &workers[i];
+
+        w->ctx = ctx;
+        w->addr = *addr;
+        w->conns = co->conns;
+        w->requests = co->requests;
+        w->size = co->size;
+        w->start = start;
+        w->deadline = start + co->duration;
+        w->hs_hist = calloc(1, sizeof(hdr_hist));
+        w->req_hist = calloc(1, sizeof(hdr_hist));
+        if (w->hs_hist == NULL || w->req_hist == NULL
+            || pthread_create(&w->thread, NULL, client_main, w) != 0) {
+            free(w->hs_hist);
+            free(w->req_hist);
+            ok = 0;
+            break;
+        }
+        started++;
+    }
+    for (int i = 0; i < started; i++) {
+        client_worker *w = &workers[i];
+
+        pthread_join(w->thread, NULL);
+        t->handshakes += w->handshakes;
+        t->exchanges += w->exchanges;
+        t->bytes_in += w->bytes_in;
+        t->errors += w->errors;
+        hdr_merge(&t->hs_hist, w->hs_hist);
+        hdr_merge(&t->req_hist, w->req_hist);
+        ok &= !w->failed;
+        free(w->hs_hist);
+        free(w->req_hist);
+    }
+    t->elapsed = bench_now() - start;
+    free(workers);
+    SSL_CTX_free(ctx);
+    return ok;
+}
+
+static void report_clients(bench_json *json, const char *mode, const client_options *co,
+                           const client_totals *t) {
+    static const double pcts[] = {50.0, 90.0, 99.0, 99.9};
+    static const char *pct_names[] = {"p50", "p90", "p99", "p999"};
+    char key[32];
+    double secs = t->elapsed > 0 ? t->elapsed : 1.0;
+
+    printf("%-9s %4d threads x %4d conns  %10.1f hs/s  %10.1f req/s  %9.2f MB/s  %llu errors\n",
+           mode, co->threads, co->conns, (double)t->handshakes / secs, (double)t->exchanges / secs,
+           (double)t->bytes_in / secs / 1e6, t->errors);
+    printf("          handshake p50 %.0f us  p99 %.0f us   request p50 %.0f us  p99 %.0f us\n",
+           hdr_percentile(&t->hs_hist, 50.0), hdr_percentile(&t->hs_hist, 99.0),
+           hdr_percentile(&t->req_hist, 50.0), hdr_percentile(&t->req_hist, 99.0));
+
+    bench_json_record_begin(json);
+    bench_json_str(json, "mode", mode);
+    bench_json_int(json, "threads", (uint64_t)co->threads);
+    bench_json_int(json, "conns_per_thread", (uint64_t)co->conns);
+    bench_json_int(json, "requests_per_conn", (uint64_t)co->requests);
+    bench_json_int(json, "response_size", co->size);
+    bench_json_num(json, "seconds", t->elapsed);
+    bench_json_int(json, "handshakes", t->handshakes);
+    bench_json_int(json, "requests", t->exchanges);
+    bench_json_int(json, "errors", t->errors);
+    bench_json_num(json, "handshakes_per_s", (double)t->handshakes / secs);
+    bench_json_num(json, "requests_per_s", (double)t->exchanges / secs);
+    bench_json_num(json, "mb_per_s", (double)t->bytes_in / secs / 1e6);
+    for (int i = 0; i < 4; i++) {
+        snprintf(key, sizeof(key), "handshake_%s_us", pct_names[i]);
+        bench_json_num(json, key, hdr_percentile(&t->hs_hist, pcts[i]));
+    }
+    bench_json_num(json, "handshake_max_us", (double)t->hs_hist.max);
+    for (int i = 0; i < 4; i++) {
+        snprintf(key, sizeof(key), "request_%s_us", pct_names[i]);
+        bench_json_num(json, key, hdr_percentile(&t->req_hist, pcts[i]));
+    }
+    bench_json_num(json, "request_max_us", (double)t->req_hist.max);
+    bench_json_record_end(json);
+}
+
+static int write_hist(const char *path, const client_totals *t) {
+    FILE *fp = strcmp(path, "-") == 0 ? stdout : fopen(path, "w");
+
+    if (fp == NULL) {
+        fprintf(stderr, "ERROR: Cannot open %s for writing\n", path);
+        return 0;
+    }
+    hdr_write(fp, "handshake", &t->hs_hist);
+    hdr_write(fp, "request", &t->req_hist);
+    if (fp != stdout)
+        fclose(fp);
+    return 1;
+}
+
+/* ---- server mode ---- */
+
+static int start_servers(server_worker *workers, int n, SSL_CTX *ctx, struct sockaddr_in *addr) {
+    if (!open_listeners(workers, n, addr))
+        return 0;
+    for (int i = 0; i < n; i++) {
+        workers[i].ctx = ctx;
+        if (pthread_create(&workers[i].thread, NULL, server_main, &workers[i]) != 0) {
+            atomic_store(&stop_flag, 1);
+            for (int j = 0; j < i; j++)
+                pthread_join(workers[j].thread, NULL);
+            for (int j = 0; j < n; j++)
+                close(workers[j].listen_fd);
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static void stop_servers(server_worker *workers, int n) {
+    atomic_store(&stop_flag, 1);
+    if (write(stop_pipe[1], "s", 1) < 0) {
+        /* The workers also poll the flag */
+    }
+    for (int i = 0; i < n; i++) {
+        pthread_join(workers[i].thread, NULL);
+        close(workers[i].listen_fd);
+    }
+}
+
+/* Serve until a signal, --duration or (--stop-on-eof) EOF on stdin */
+static int serve(bench_json *json, int threads, int port, const char *key_type, double duration,
+                 int stop_on_eof) {
+    server_worker *workers = calloc((size_t)threads, sizeof(*workers));
+    struct sockaddr_in addr;
+    EVP_PKEY *pkey = NULL;
+    X509 *cert = NULL;
+    SSL_CTX *client_ctx = NULL, *server_ctx = NULL;
+    unsigned long long handshakes = 0, requests = 0, bytes_out = 0, errors = 0;
+    double start, elapsed;
+    int ok = 1;
+
+    if (workers == NULL || bench_tls_make_cert(key_type, &pkey, &cert) != 0
+        || bench_tls_make_ctx_pair(pkey, cert, &client_ctx, &server_ctx) != 0) {
+        free(workers);
+        X509_free(cert);
+        EVP_PKEY_free(pkey);
+        return 0;
+    }
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons((uint16_t)port);
+    if (!start_servers(workers, threads, server_ctx, &addr)) {
+        ok = 0;
+        goto out;
+    }
+    start = bench_now();
+    /* The controller waits for this line */
+    printf("listening on port %d (%d threads, %s key)\n", ntohs(addr.sin_port), threads, key_type);
+    fflush(stdout);
+
+    while (!atomic_load(&stop_flag)) {
+        struct pollfd pfd = {0, POLLIN, 0};
+        int timeout = 500;
+
+        if (duration > 0) {
+            double left = start + duration - bench_now();
+
+            if (left <= 0)
+                break;
+            timeout = left < 0.5 ? (int)(left * 1000) + 1 : 500;
+        }
+        if (stop_on_eof) {
+            char buf[64];
+
+            if (poll(&pfd, 1, timeout) > 0 && read(0, buf, sizeof(buf)) <= 0)
+                break;
+        } else {
+            poll(NULL, 0, timeout);
+        }
+    }
+    elapsed = bench_now() - start;
+    stop_servers(workers, threads);
+    for (int i = 0; i < threads; i++) {
+        handshakes += workers[i].handshakes;
+        requests += workers[i].requests;
+        bytes_out += workers[i].bytes_out;
+        errors += workers[i].errors;
+        ok &= !workers[i].failed;
+    }
+    printf("served    %llu handshakes, %llu requests, %.1f MB in %.1f s (%llu errors)\n",
+           handshakes, requests, (double)bytes_out / 1e6, elapsed, errors);
+
+    bench_json_record_begin(json);
+    bench_json_str(json, "mode", "server");
+    bench_json_str(json, "key_type", key_type);
+    bench_json_int(json, "threads", (uint64_t)threads);
+    bench_json_num(json, "seconds", elapsed);
+    bench_json_int(json, "handshakes", handshakes);
+    bench_json_int(json, "requests", requests);
+    bench_json_int(json, "errors", errors);
+    bench_json_num(json, "handshakes_per_s", elapsed > 0 ? (double)handshakes / elapsed : 0.0);
+    bench_json_num(json, "mb_per_s", elapsed > 0 ? (double)bytes_out / elapsed / 1e6 : 0.0);
+    bench_json_record_end(json);
+
+out:
+    free(workers);
+    SSL_CTX_free(client_ctx);
+    SSL_CTX_free(server_ctx);
+    X509_free(cert);
+    EVP_PKEY_free(pkey);
+    return ok;
+}
+
+/* Both sides in one process on loopback */
+static int loopback(bench_json *json, const client_options *co, const char *key_type) {
+    int threads = co->threads > 1 ? co->threads / 2 : 1;
+    server_worker *workers = calloc((size_t)threads, sizeof(*workers));
+    client_options half = *co;
+    client_totals *t = calloc(1, sizeof(*t));
+    struct sockaddr_in addr;
+    EVP_PKEY *pkey = NULL;
+    X509 *cert = NULL;
+    SSL_CTX *client_ctx = NULL, *server_ctx = NULL;
+    int ok;
+
+    if (workers == NULL || t == NULL || bench_tls_make_cert(key_type, &pkey, &cert) != 0
+        || bench_tls_make_ctx_pair(pkey, cert, &client_ctx, &server_ctx) != 0) {
+        free(workers);
+        free(t);
+        X509_free(cert);
+        EVP_PKEY_free(pkey);
+        return 0;
+    }
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    ok = start_servers(workers, threads, server_ctx, &addr);
+    if (ok) {
+        half.threads = co->threads - threads > 0 ? co->threads - threads : 1;
+        ok = run_clients(&half, &addr, t);
+        stop_servers(workers, threads);
+        ok = ok && t->handshakes > 0;
+        if (ok) {
+            report_clients(json, "loopback", &half, t);
+            if (co->hist_path != NULL)
+                ok = write_hist(co->hist_path, t);
+        }
+    }
+    free(workers);
+    free(t);
+    SSL_CTX_free(client_ctx);
+    SSL_CTX_free(server_ctx);
+    X509_free(cert);
+    EVP_PKEY_free(pkey);
+    return ok;
+}
+
+int main(int argc, char **argv) {
+    bench_options opts;
+    bench_json json;
+    client_options co;
+    const char *connect_to = NULL, *key_type = "EC";
+    long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+    int serve_port = -1, stop_on_eof = 0, ok;
+    double duration = 0.0;
+    int argi = bench_parse_args(argc, argv, "bench_loadgen.json", &opts);
+
+    if (argi < 0)
+        return 2;
+    memset(&co, 0, sizeof(co));
+    co.threads = ncpu > 0 ? (int)ncpu : 1;
+    co.conns = DEFAULT_CONNS;
+    co.requests = 1;
+    co.size = DEFAULT_SIZE;
+    /* Benchmark-specific options follow the common ones */
+    for (; argi < argc; argi++) {
+        const char *arg = argv[argi], *val = argi + 1 < argc ? argv[argi + 1] : NULL;
+
+        if (strcmp(arg, "--stop-on-eof") == 0) {
+            stop_on_eof = 1;
+            continue;
+        }
+        if (val == NULL)
+            goto usage;
+        argi++;
+        if (strcmp(arg, "--serve") == 0)
+            serve_port = atoi(val);
+        else if (strcmp(arg, "--connect") == 0)
+            connect_to = val;
+        else if (strcmp(arg, "--threads") == 0)
+            co.threads = atoi(val);
+        else if (strcmp(arg, "--conns") == 0)
+            co.conns = atoi(val);
+        else if (strcmp(arg, "--requests") == 0)
+            co.requests = atoi(val);
+        else if (strcmp(arg, "--size") == 0)
+            co.size = (uint32_t)strtoul(val, NULL, 10);
+        else if (strcmp(arg, "--duration") == 0)
+            duration = atof(val);
+        else if (strcmp(arg, "--start-at") == 0)
+            co.start_at = atof(val);
+        else if (strcmp(arg, "--hist") == 0)
+            co.hist_path = val;
+        else if (strcmp(arg, "--key") == 0)
+            key_type = val;
+        else
+            goto usage;
+    }
+    if (co.threads < 1)
+        co.threads = 1;
+    if (co.threads > MAX_THREADS)
+        co.threads = MAX_THREADS;
+    if (co.conns < 1)
+        co.conns = 1;
+    if (co.requests < 0)
+        co.requests = 0;
+    if (co.size < 1)
+        co.size = 1;
+    if (opts.quick && connect_to == NULL && serve_port < 0) {
+        co.threads = 2;
+        co.conns = 4;
+    }
+    co.duration = duration > 0 ? duration : opts.quick ? opts.min_seconds * 10 : DEFAULT_DURATION;
+
+    signal(SIGPIPE, SIG_IGN);
+    if (pipe(stop_pipe) != 0)
+        return 1;
+    signal(SIGINT, on_signal);
+    signal(SIGTERM, on_signal);
+
+    printf("=================================\n");
+    printf("TLS Load Generator\n");
+    printf("=================================\n");
+    printf("OpenSSL version: %s\n", OpenSSL_version(OPENSSL_VERSION));
+
+    if (bench_json_begin(&json, &opts, "loadgen") != 0)
+        return 1;
+    if (serve_port >= 0) {
+        ok = serve(&json, co.threads, serve_port, key_type, duration, stop_on_eof);
+    } else if (connect_to != NULL) {
+        struct sockaddr_in addr;
+        client_totals *t = calloc(1, sizeof(*t));
+
+        ok = t != NULL && resolve(connect_to, &addr);
+        if (!ok)
+            fprintf(stderr, "ERROR: Cannot resolve %s (HOST:PORT)\n", connect_to);
+        if (ok)
+            ok = run_clients(&co, &addr, t);
+        if (ok) {
+            report_clients(&json, "client", &co, t);
+            ok = t->handshakes > 0;
+            if (co.hist_path != NULL)
+                ok = write_hist(co.hist_path, t) && ok;
+        }
+        free(t);
+    } else {
+        ok = loopback(&json, &co, key_type);
+    }
+    bench_json_end(&json);
+    ERR_print_errors_fp(stderr);
+
+    printf("\n=================================\n");
+    if (ok) {
+        printf("✅ Load generation completed (%s)\n", opts.json_path);
+        return 0;
+    }
+    printf("❌ Load generation FAILED\n");
+    return 1;
+
+usage:
+    fprintf(stderr, "Usage: %s [--quick] [--json PATH] (--serve PORT [--key TYPE] [--stop-on-eof] | "
+            "--connect HOST:PORT [--conns N] [--requests N] [--size BYTES] [--start-at EPOCH] "
+            "[--hist PATH]) [--threads N] [--duration S]\n", argv[0]);
+    return 2;
+}
@@ -0,0 +1,258 @@
+#include <openssl/core_names.h>
+#include <openssl/crypto.h>
+#include <openssl/err.h>
+#include <openssl/evp.h>
+#include <openssl/params.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench_common.h"
+#include "sparetools_memtrace.h"
+
+/**
+ * Small-message MAC latency benchmark
+ *
+ * MACs 16-256 byte messages with HMAC-SHA256, KMAC-128, KMAC-256 and
+ * CMAC-AES-128, all fetched once with EVP_MAC_fetch, in four context
+ * patterns:
+ *
+ * - new:        EVP_MAC_CTX_new + keyed EVP_MAC_init per message, then free
+ * - init_rekey: one context, EVP_MAC_init with key and params per message
+ * - init_reuse: one keyed context, EVP_MAC_init(ctx, NULL, 0, NULL) per
+ *               message, which restarts the MAC with the key already set
+ * - dup:        EVP_MAC_CTX_dup of a keyed template per message, then free
+ *
+ * Each message costs init (or new/dup), EVP_MAC_update and
+ * EVP_MAC_final. Records carry ns_per_op, OpenSSL allocs_per_op and
+ * bytes_per_op, and relative_to_new. Which pattern wins differs between
+ * OpenSSL releases, so compare the JSON of the 3.3.2 and 3.6.0 packages.
+ * All patterns must produce the same tag as new, or the run fails.
+ */
+
+#define MAX_MSG 256
+/* Messages between clock reads */
+#define BATCH 64
+
+typedef enum {
+    PATTERN_NEW,
+    PATTERN_INIT_REKEY,
+    PATTERN_INIT_REUSE,
+    PATTERN_DUP,
+    NUM_PATTERNS
+} mac_pattern;
+
+static const char *pattern_names[] = {"new", "init_rekey", "init_reuse", "dup"};
+
+typedef struct {
+    const char *name;        /* Reported algorithm */
+    const char *mac;         /* EVP_MAC_fetch name */
+    const char *param_key;   /* OSSL_MAC_PARAM_DIGEST / _CIPHER, or NULL */
+    const char *param_value;
+    size_t key_len;
+} mac_spec;
+
+static const mac_spec macs[] = {
+    {"HMAC-SHA256", "HMAC", OSSL_MAC_PARAM_DIGEST, "SHA2-256", 32},
+    {"KMAC-128", "KMAC-128", NULL, NULL, 32},
+    {"KMAC-256", "KMAC-256", NULL, NULL, 32},
+    {"CMAC-AES-128", "CMAC", OSSL_MAC_PARAM_CIPHER, "AES-128-CBC", 16},
+};
+#define NUM_MACS (sizeof(macs) / sizeof(macs[0]))
+
+static const size_t msg_sizes[] = {16, 32, 64, 128, 256};
+#define NUM_SIZES (sizeof(msg_sizes) / sizeof(msg_sizes[0]))
+
+static const unsigned char mac_key[32] = "sparetools bench MAC key 0123456";
+
+typedef struct {
+    const mac_spec *spec;
+    EVP_MAC *mac;
+    EVP_MAC_CTX *ctx;         /* Reused by init_rekey and init_reuse */
+    EVP_MAC_CTX *keyed;       /* Template for dup */
+    OSSL_PARAM params[2];
+    unsigned char msg[MAX_MSG];
+    size_t msg_len;
+    unsigned char tag[EVP_MAX_MD_SIZE];
+    size_t tag_len;
+} mac_state;
+
+static int mac_setup(mac_state *s, const mac_spec *spec) {
+    memset(s, 0, sizeof(*s));
+    s->spec = spec;
+    memset(s->msg, 'm', sizeof(s->msg));
+    if (spec->param_key != NULL)
+        s->params[0] = OSSL_PARAM_construct_utf8_string(spec->param_key, (char *)spec->param_value, 0);
+    else
+        s->params[0] = OSSL_PARAM_construct_end();
+    s->params[1] = OSSL_PARAM_construct_end();
+
+    return (s->mac = EVP_MAC_fetch(NULL, spec->mac, NULL)) != NULL
+        && (s->ctx = EVP_MAC_CTX_new(s->mac)) != NULL
+        && EVP_MAC_init(s->ctx, mac_key, spec->key_len, s->params) == 1
+        && (s->keyed = EVP_MAC_CTX_new(s->mac)) != NULL
+        && EVP_MAC_init(s->keyed, mac_key, spec->key_len, s->params) == 1;
+}
+
+static void mac_teardown(mac_state *s) {
+    EVP_MAC_CTX_free(s->ctx);
+    EVP_MAC_CTX_free(s->keyed);
+    EVP_MAC_free(s->mac);
+}
+
+/* One message: returns 1 on success */
+static int mac_once(mac_state *s, mac_pattern p) {
+    EVP_MAC_CTX *ctx = s->ctx, *owned = NULL;
+    int ok;
+
+    switch (p) {
+    case PATTERN_NEW:
+        ok = (ctx = owned = EVP_MAC_CTX_new(s->mac)) != NULL
+            && EVP_MAC_init(ctx, mac_key, s->spec->key_len, s->params) == 1;
+        break;
+    case PATTERN_INIT_REKEY:
+        ok = EVP_MAC_init(ctx, mac_key, s->spec->key_len, s->params) == 1;
+        break;
+    case PATTERN_INIT_REUSE:
+        ok = EVP_MAC_init(ctx, NULL, 0, NULL) == 1;
+        break;
+    default:
+        ok = (ctx = owned = EVP_MAC_CTX_dup(s->keyed)) != NULL;
+        break;
+    }
+    ok = ok && EVP_MAC_update(ctx, s->msg, s->msg_len) == 1
+        && EVP_MAC_final(ctx, s->tag, &s->tag_len, sizeof(s->tag)) == 1;
+    EVP_MAC_CTX_free(owned);
+    return ok;
+}
+
+typedef struct {
+    double ns_per_op;
+    double allocs_per_op;
+    double bytes_per_op;
+} mac_result;
+
+static int measure(mac_state *s, mac_pattern p, double seconds, mac_result *r) {
+    SPARETOOLS_MEMTRACE_TOTALS before, after;
+    uint64_t ops = 0;
+    double start, elapsed;
+
+    memset(r, 0, sizeof(*r));
+    if (!mac_once(s, p))
+        return 0;
+    sparetools_memtrace_totals(&before);
+    start = bench_now();
+    do {
+        for (int i = 0; i < BATCH; i++, ops++) {
+            memcpy(s->msg, &ops, sizeof(ops));
+            if (!mac_once(s, p))
+                return 0;
+        }
+        elapsed = bench_now() - start;
+    } while (elapsed < seconds);
+    sparetools_memtrace_totals(&after);
+
+    r->ns_per_op = elapsed * 1e9 / (double)ops;
+    r->allocs_per_op = (double)(after.allocs + after.reallocs - before.allocs - before.reallocs) / (double)ops;
+    r->bytes_per_op = (double)(after.bytes - before.bytes) / (double)ops;
+    return 1;
+}
+
+/* Same tag as a fresh context for one fixed message */
+static int matches_new(mac_state *s, mac_pattern p) {
+    unsigned char reference[EVP_MAX_MD_SIZE];
+    size_t reference_len;
+
+    memset(s->msg, 'm', sizeof(uint64_t));
+    if (!mac_once(s, PATTERN_NEW))
+        return 0;
+    memcpy(reference, s->tag, s->tag_len);
+    reference_len = s->tag_len;
+    return mac_once(s, p) && s->tag_len == reference_len && memcmp(s->tag, reference, reference_len) == 0;
+}
+
+int main(int argc, char **argv) {
+    bench_options opts;
+    bench_json json;
+    int failures = 0;
+    int argi;
+
+    if (!sparetools_memtrace_install())
+        fprintf(stderr, "⚠ Allocation tracing unavailable (hooks already installed)\n");
+    if ((argi = bench_parse_args(argc, argv, "bench_mac.json", &opts)) < 0)
+        return 2;
+    if (argi != argc) {
+        bench_usage(argv[0]);
+        return 2;
+    }
+
+    printf("=================================\n");
+    printf("Small-Message MAC Benchmark\n");
+    printf("=================================\n");
+    printf("OpenSSL version: %s\n\n", OpenSSL_version(OPENSSL_VERSION));
+    if (bench_json_begin(&json, &opts, "mac") != 0)
+        return 1;
+
+    printf("  ns/op (OpenSSL allocs/op) per context pattern\n");
+    printf("  %-13s %5s", "Algorithm", "Bytes");
+    for (int p = 0; p < NUM_PATTERNS; p++)
+        printf(" %16s", pattern_names[p]);
+    printf("  %s\n", "fastest");
+    for (size_t i = 0; i < NUM_MACS; i++) {
+        mac_state s;
+
+        if (!mac_setup(&s, &macs[i])) {
+            printf("  %-13s not available, skipping\n", macs[i].name);
+            bench_json_record_begin(&json);
+            bench_json_str(&json, "algorithm", macs[i].name);
+            bench_json_int(&json, "available", 0);
+            bench_json_record_end(&json);
+            mac_teardown(&s);
+            ERR_clear_error();
+            continue;
+        }
+        for (size_t j = 0; j < NUM_SIZES; j++) {
+            mac_result results[NUM_PATTERNS];
+            int ok[NUM_PATTERNS], fastest = -1;
+
+            s.msg_len = msg_sizes[j];
+            printf("  %-13s %5zu", macs[i].name, msg_sizes[j]);
+            for (int p = 0; p < NUM_PATTERNS; p++) {
+                ok[p] = matches_new(&s, (mac_pattern)p)
+                    && measure(&s, (mac_pattern)p, opts.min_seconds, &results[p]);
+                failures += !ok[p];
+                if (ok[p] && (fastest < 0 || results[p].ns_per_op < results[fastest].ns_per_op))
+                    fastest = p;
+                if (ok[p])
+                    printf(" %9.0f (%4.1f)", results[p].ns_per_op, results[p].allocs_per_op);
+                else
+                    printf(" %16s", "FAILED");
+                ERR_clear_error();
+            }
+            printf("  %s\n", fastest >= 0 ? pattern_names[fastest] : "-");
+
+            for (int p = 0; p < NUM_PATTERNS; p++) {
+                bench_json_record_begin(&json);
+                bench_json_str(&json, "algorithm", macs[i].name);
+                bench_json_int(&json, "available", 1);
+                bench_json_int(&json, "message_bytes", (uint64_t)msg_sizes[j]);
+                bench_json_str(&json, "pattern", pattern_names[p]);
+                bench_json_int(&json, "ok", (uint64_t)ok[p]);
+                if (ok[p]) {
+                    bench_json_num(&json, "ns_per_op", results[p].ns_per_op);
+                    bench_json_num(&json, "allocs_per_op", results[p].allocs_per_op);
+                    bench_json_num(&json, "bytes_per_op", results[p].bytes_per_op);
+                    bench_json_num(&json, "relative_to_new",
+                                   ok[PATTERN_NEW] ? results[p].ns_per_op / results[PATTERN_NEW].ns_per_op : 0.0);
+                    bench_json_int(&json, "fastest", (uint64_t)(p == fastest));
+                }
+                bench_json_record_end(&json);
+            }
+        }
+        mac_teardown(&s);
+    }
+    bench_json_end(&json);
+
+    printf("\n%s\n", failures ? "✗ Some MAC patterns failed or disagreed" : "✓ MAC benchmark completed");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,242 @@
+#ifndef SPARETOOLS_BENCH_NUMA_H
+#define SPARETOOLS_BENCH_NUMA_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench_common.h"
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+/**
+ * NUMA topology, thread placement and node-local buffers for the
+ * multi-threaded benchmarks (bench_threads --numa).
+ *
+ * The topology comes from /sys/devices/system/node (online nodes, their
+ * CPU lists and the ACPI SLIT distances), so no libnuma is needed.
+ * Threads are placed with pthread_setaffinity_np on all CPUs of a node.
+ * Buffers are mmap()ed, bound to a node with mbind(MPOL_BIND) and
+ * touched by the caller; when mbind is unavailable (kernels without
+ * CONFIG_NUMA, seccomp), first touch from a thread running on the node
+ * places them. Hosts without the sysfs tree, and non-Linux systems, are
+ * one node holding every online CPU, and placement is a no-op.
+ *
+ * Requires _GNU_SOURCE before the first system header on Linux.
+ */
+
+#define BENCH_NUMA_MAX_NODES 16
+#define BENCH_NUMA_MAX_CPUS 1024
+
+typedef struct {
+    int id;                             /* Kernel node number */
+    int ncpus;
+    int cpus[BENCH_NUMA_MAX_CPUS];
+    char cpulist[256];                  /* As in sysfs, e.g. "0-15,32-47" */
+    int distance[BENCH_NUMA_MAX_NODES]; /* To node index j; 10 is local */
+} bench_numa_node;
+
+typedef struct {
+    int nnodes;
+    int from_sysfs;                     /* 0: single-node fallback */
+    bench_numa_node nodes[BENCH_NUMA_MAX_NODES];
+} bench_numa_topology;
+
+/* Parse a sysfs CPU list ("0-3,8,10-11") into cpus; returns the count */
+static inline int bench_numa_parse_cpulist(const char *list, int *cpus, int max) {
+    int n = 0;
+    const char *p = list;
+
+    while (*p != '\0' && *p != '\n') {
+        char *end;
+        long lo = strtol(p, &end, 10), hi = lo;
+
+        if (end == p)
+            break;
+        if (*end == '-')
+            hi = strtol(end + 1, &end, 10);
+        for (long c = lo; c <= hi && n < max; c++)
+            cpus[n++] = (int)c;
+        p = *end == ',' ? end + 1 : end;
+    }
+    return n;
+}
+
+static inline int bench_numa_read_line(const char *path, char *buf, size_t len) {
+    FILE *fp = fopen(path, "r");
+    int ok;
+
+    if (fp == NULL)
+        return 0;
+    ok = fgets(buf, (int)len, fp) != NULL;
+    fclose(fp);
+    if (ok)
+        buf[strcspn(buf, "\n")] = '\0';
+    return ok;
+}
+
+static inline void bench_numa_single_node(bench_numa_topology *t) {
+    long ncpu = 1;
+    bench_numa_node *node = &t->nodes[0];
+
+#ifndef _WIN32
+    ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+    memset(t, 0, sizeof(*t));
+    t->nnodes = 1;
+    node->ncpus = ncpu > 0 ? (int)(ncpu < BENCH_NUMA_MAX_CPUS ? ncpu : BENCH_NUMA_MAX_CPUS) : 1;
+    for (int c = 0; c < node->ncpus; c++)
+        node->cpus[c] = c;
+    snprintf(node->cpulist, sizeof(node->cpulist), "0-%d", node->ncpus - 1);
+    node->distance[0] = 10;
+}
+
+/** Fill t from sysfs; returns the number of nodes (at least 1) */
+static inline int bench_numa_detect(bench_numa_topology *t) {
+#ifdef __linux__
+    char online[256], path[128], line[512];
+    int ids[BENCH_NUMA_MAX_NODES];
+    int n;
+
+    if (!bench_numa_read_line("/sys/devices/system/node/online", online, sizeof(online))) {
+        bench_numa_single_node(t);
+        return t->nnodes;
+    }
+    n = bench_numa_parse_cpulist(online, ids, BENCH_NUMA_MAX_NODES);
+    memset(t, 0, sizeof(*t));
+    for (int i = 0; i < n; i++) {
+        bench_numa_node *node = &t->nodes[t->nnodes];
+
+        snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", ids[i]);
+        if (!bench_numa_read_line(path, node->cpulist, sizeof(node->cpulist)))
+            continue;
+        node->ncpus = bench_numa_parse_cpulist(node->cpulist, node->cpus, BENCH_NUMA_MAX_CPUS);
+        /* Memory-only nodes (CXL, HBM) run no threads */
+        if (node->ncpus == 0)
+            continue;
+        node->id = ids[i];
+        snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/distance", ids[i]);
+        if (bench_numa_read_line(path, line, sizeof(line))) {
+            /* One distance per online node, in node order */
+            char *p = line;
+            for (int j = 0; j < n; j++) {
+                char *end;
+                long d = strtol(p, &end, 10);
+                if (end == p)
+                    break;
+                node->distance[j] = (int)d;
+                p = end;
+            }
+        }
+        t->nnodes++;
+    }
+    if (t->nnodes == 0) {
+        bench_numa_single_node(t);
+        return t->nnodes;
+    }
+    /* Distances above are indexed by online position; keep only CPU nodes */
+    for (int a = 0; a < t->nnodes; a++) {
+        int row[BENCH_NUMA_MAX_NODES];
+        for (int b = 0; b < t->nnodes; b++) {
+            int pos = 0;
+            while (pos < n && ids[pos] != t->nodes[b].id)
+                pos++;
+            row[b] = pos < n ? t->nodes[a].distance[pos] : 0;
+        }
+        memcpy(t->nodes[a].distance, row, sizeof(row));
+    }
+    t->from_sysfs = 1;
+    return t->nnodes;
+#else
+    bench_numa_single_node(t);
+    return t->nnodes;
+#endif
+}
+
+/** Run the calling thread on the CPUs of node index i; 1 on success */
+static inline int bench_numa_run_on(const bench_numa_topology *t, int i) {
+#ifdef __linux__
+    cpu_set_t set;
+
+    if (!t->from_sysfs)
+        return 1;
+    CPU_ZERO(&set);
+    for (int c = 0; c < t->nodes[i].ncpus; c++)
+        if (t->nodes[i].cpus[c] < CPU_SETSIZE)
+            CPU_SET(t->nodes[i].cpus[c], &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+    (void)t;
+    (void)i;
+    return 1;
+#endif
+}
+
+/**
+ * size bytes on node index i, touched by the caller (run it on the node
+ * for first-touch placement). Free with bench_numa_free; NULL on failure.
+ */
+static inline void *bench_numa_alloc(const bench_numa_topology *t, int i, size_t size) {
+#ifdef __linux__
+    void *p = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+    if (p == MAP_FAILED)
+        return NULL;
+#ifdef SYS_mbind
+    if (t->from_sysfs && t->nodes[i].id < 64) {
+        /* MPOL_BIND = 2; failure leaves first-touch placement */
+        unsigned long mask = 1UL << t->nodes[i].id;
+        (void)syscall(SYS_mbind, p, size, 2, &mask, sizeof(mask) * 8 + 1, 0);
+    }
+#endif
+    memset(p, 0x5a, size);
+    return p;
+#else
+    void *p = malloc(size);
+
+    (void)t;
+    (void)i;
+    if (p != NULL)
+        memset(p, 0x5a, size);
+    return p;
+#endif
+}
+
+static inline void bench_numa_free(void *p, size_t size) {
+#ifdef __linux__
+    if (p != NULL)
+        munmap(p, size);
+#else
+    (void)size;
+    free(p);
+#endif
+}
+
+/**
+ * One JSON record per node: numa_node, cpus, ncpus and its distances
+ * ("10 21"), so reports from different hosts can be told apart.
+ */
+static inline void bench_numa_json_topology(const bench_numa_topology *t, bench_json *json) {
+    for (int a = 0; a < t->nnodes; a++) {
+        char distances[BENCH_NUMA_MAX_NODES * 5] = "";
+        size_t len = 0;
+
+        for (int b = 0; b < t->nnodes && len < sizeof(distances); b++)
+            len += (size_t)snprintf(distances + len, sizeof(distances) - len, "%s%d",
+                                    b ? " " : "", t->nodes[a].distance[b]);
+        bench_json_record_begin(json);
+        bench_json_int(json, "numa_node", (uint64_t)t->nodes[a].id);
+        bench_json_str(json, "cpus", t->nodes[a].cpulist);
+        bench_json_int(json, "ncpus", (uint64_t)t->nodes[a].ncpus);
+        bench_json_str(json, "distances", distances);
+        bench_json_record_end(json);
+    }
+}
+
+#endif /* SPARETOOLS_BENCH_NUMA_H */
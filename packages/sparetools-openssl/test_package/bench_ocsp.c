@@ -0,0 +1,424 @@
+#include <openssl/err.h>
+#include <openssl/ocsp.h>
+#include <openssl/ssl.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "bench_common.h"
+#include "bench_tls.h"
+#include "bench_x509.h"
+#include "sparetools_ocspcache.h"
+
+/**
+ * OCSP stapling handshake benchmark
+ *
+ * The server presents an ECDSA P-256 leaf issued by a test CA; the CA
+ * signs a "good" OCSP response for it, valid for a week, that stands in
+ * for the responder. Clients request status (status_request) in every
+ * full TLS 1.3 handshake, and the server answers with:
+ * - none:        no status callback, nothing stapled (baseline)
+ * - parse:       the callback d2i's the stored response, checks it with
+ *                OCSP_basic_verify and the thisUpdate/nextUpdate window,
+ *                and re-encodes it, per handshake (stapling straight from
+ *                a response file)
+ * - cache:       SPARETOOLS_OCSPCACHE, filled by its background refresh
+ *                thread; the callback copies the validated DER
+ * - cache-churn: the cache while another thread force-refreshes it in a
+ *                loop, so every fetch, verify and swap happens during the
+ *                handshakes; its server CPU time is the one to compare, as
+ *                on hosts with few cores the refresh thread also takes
+ *                wall time from the handshakes
+ *
+ * Reported per mode: handshakes/s, server CPU time per handshake, the
+ * share of handshakes that carried a staple, its size, and the rate
+ * relative to parse. Before measuring, the cache must reject an expired
+ * response for the same certificate and accept a revoked one in place of
+ * the good one.
+ */
+
+#define VALID_DAYS 7
+
+typedef enum {
+    MODE_NONE,
+    MODE_PARSE,
+    MODE_CACHE,
+    MODE_CHURN
+} staple_mode;
+
+static const char *mode_names[] = {"none", "parse", "cache", "cache-churn"};
+#define NUM_MODES 4
+
+static EVP_PKEY *ca_key, *leaf_key;
+static X509 *ca_cert, *leaf_cert;
+static X509_STORE *ca_store;
+static STACK_OF(X509) *ca_chain;  /* Responses carry no certificates */
+static OCSP_CERTID *leaf_id;
+
+/* The stored response the parse mode and the fake responder start from */
+static unsigned char *staple_der;
+static int staple_len;
+
+static atomic_int churn_stop;
+
+/* Client side: count the handshakes that received a staple */
+static unsigned long long stapled;
+static size_t stapled_len;
+
+/* OCSP response for the leaf with status, window [now + start, now + end] days */
+static OCSP_RESPONSE *make_response(int status, long start_days, long end_days) {
+    OCSP_BASICRESP *bs = OCSP_BASICRESP_new();
+    ASN1_TIME *this_update = X509_time_adj_ex(NULL, (int)start_days, -60, NULL);
+    ASN1_TIME *next_update = X509_time_adj_ex(NULL, (int)end_days, 0, NULL);
+    ASN1_TIME *revoked = status == V_OCSP_CERTSTATUS_REVOKED ? X509_time_adj_ex(NULL, -1, 0, NULL) : NULL;
+    OCSP_RESPONSE *resp = NULL;
+
+    if (bs != NULL && this_update != NULL && next_update != NULL
+        && OCSP_basic_add1_status(bs, leaf_id, status, OCSP_REVOKED_STATUS_KEYCOMPROMISE,
+                                  revoked, this_update, next_update) != NULL
+        && OCSP_basic_sign(bs, ca_cert, ca_key, EVP_sha256(), NULL, OCSP_NOCERTS))
+        resp = OCSP_response_create(OCSP_RESPONSE_STATUS_SUCCESSFUL, bs);
+    ASN1_TIME_free(revoked);
+    ASN1_TIME_free(next_update);
+    ASN1_TIME_free(this_update);
+    OCSP_BASICRESP_free(bs);
+    return resp;
+}
+
+static int make_pki(void) {
+    OCSP_RESPONSE *resp;
+
+    if ((ca_key = bench_x509_keygen("EC")) == NULL
+        || (leaf_key = bench_x509_keygen("EC")) == NULL
+        || (ca_cert = bench_x509_make_cert(ca_key, "SpareTools Bench OCSP CA", NULL, ca_key,
+                                           EVP_sha256(), 1, 1)) == NULL
+        || (leaf_cert = bench_x509_make_cert(leaf_key, "bench.sparetools.local", ca_cert, ca_key,
+                                             EVP_sha256(), 0, 2)) == NULL
+        || (leaf_id = OCSP_cert_to_id(NULL, leaf_cert, ca_cert)) == NULL
+        || (ca_store = X509_STORE_new()) == NULL
+        || !X509_STORE_add_cert(ca_store, ca_cert)
+        || (ca_chain = sk_X509_new_null()) == NULL
+        || !sk_X509_push(ca_chain, ca_cert))
+        return 1;
+    if ((resp = make_response(V_OCSP_CERTSTATUS_GOOD, 0, VALID_DAYS)) == NULL)
+        return 1;
+    staple_len = i2d_OCSP_RESPONSE(resp, &staple_der);
+    OCSP_RESPONSE_free(resp);
+    return staple_len > 0 ? 0 : 1;
+}
+
+static void free_pki(void) {
+    OPENSSL_free(staple_der);
+    OCSP_CERTID_free(leaf_id);
+    sk_X509_free(ca_chain);
+    X509_STORE_free(ca_store);
+    X509_free(leaf_cert);
+    X509_free(ca_cert);
+    EVP_PKEY_free(leaf_key);
+    EVP_PKEY_free(ca_key);
+}
+
+/* Server status callback for MODE_PARSE: the work a cache avoids */
+static int parse_status_cb(SSL *ssl, void *arg) {
+    const unsigned char *p = staple_der;
+    OCSP_RESPONSE *resp = d2i_OCSP_RESPONSE(NULL, &p, staple_len);
+    OCSP_BASICRESP *bs = resp != NULL ? OCSP_response_get1_basic(resp) : NULL;
+    ASN1_GENERALIZEDTIME *this_update, *next_update;
+    unsigned char *der = NULL;
+    int status, reason, len = 0, ok = 0;
+
+    (void)arg;
+    if (bs != NULL
+        && OCSP_basic_verify(bs, ca_chain, ca_store, 0) > 0
+        && OCSP_resp_find_status(bs, leaf_id, &status, &reason, NULL, &this_update, &next_update)
+        && status == V_OCSP_CERTSTATUS_GOOD
+        && OCSP_check_validity(this_update, next_update, 300, -1)
+        && (len = i2d_OCSP_RESPONSE(resp, &der)) > 0)
+        ok = SSL_set_tlsext_status_ocsp_resp(ssl, der, len) == 1;
+    if (!ok)
+        OPENSSL_free(der);
+    OCSP_BASICRESP_free(bs);
+    OCSP_RESPONSE_free(resp);
+    return ok ? SSL_TLSEXT_ERR_OK : SSL_TLSEXT_ERR_NOACK;
+}
+
+static int client_status_cb(SSL *ssl, void *arg) {
+    const unsigned char *resp;
+    long len = SSL_get_tlsext_status_ocsp_resp(ssl, &resp);
+
+    (void)arg;
+    if (len > 0) {
+        stapled++;
+        stapled_len = (size_t)len;
+    }
+    return 1;
+}
+
+/* Stands in for the responder: hands out the stored response */
+static OCSP_RESPONSE *fake_fetch(X509 *cert, X509 *issuer, OCSP_REQUEST *req, void *arg) {
+    const unsigned char *p = staple_der;
+
+    (void)cert;
+    (void)issuer;
+    (void)req;
+    (void)arg;
+    return d2i_OCSP_RESPONSE(NULL, &p, staple_len);
+}
+
+static void *churn_main(void *arg) {
+    SPARETOOLS_OCSPCACHE *cache = arg;
+
+    while (!atomic_load(&churn_stop))
+        sparetools_ocspcache_refresh(cache, 1);
+    return NULL;
+}
+
+/*
+ * The cache must refuse what it must never staple, and staple a signed
+ * revocation in place of a good response; the good one is put back after
+ */
+static int check_validation(SPARETOOLS_OCSPCACHE *cache) {
+    OCSP_RESPONSE *revoked = make_response(V_OCSP_CERTSTATUS_REVOKED, 0, VALID_DAYS);
+    OCSP_RESPONSE *expired = make_response(V_OCSP_CERTSTATUS_GOOD, -14, -7);
+    SPARETOOLS_OCSPCACHE_STATS stats;
+    unsigned char *der = NULL;
+    int len, failures = 0;
+
+    if (revoked == NULL || expired == NULL)
+        failures++;
+    if (expired != NULL && (len = i2d_OCSP_RESPONSE(expired, &der)) > 0) {
+        if (sparetools_ocspcache_set_response(cache, leaf_cert, der, (size_t)len)) {
+            fprintf(stderr, "ERROR: cache accepted an expired response\n");
+            failures++;
+        }
+        OPENSSL_free(der);
+        der = NULL;
+    }
+    if (revoked != NULL && (len = i2d_OCSP_RESPONSE(revoked, &der)) > 0) {
+        int accepted = sparetools_ocspcache_set_response(cache, leaf_cert, der, (size_t)len);
+
+        sparetools_ocspcache_stats(cache, &stats);
+        if (!accepted || stats.revoked != 1) {
+            fprintf(stderr, "ERROR: cache did not take a signed revoked response\n");
+            failures++;
+        }
+        OPENSSL_free(der);
+    }
+    if (!sparetools_ocspcache_set_response(cache, leaf_cert, staple_der, (size_t)staple_len)) {
+        fprintf(stderr, "ERROR: cache did not take the good response back\n");
+        failures++;
+    }
+    OCSP_RESPONSE_free(revoked);
+    OCSP_RESPONSE_free(expired);
+    return failures;
+}
+
+/* Wait for the background refresh thread's first pass */
+static int wait_valid(SPARETOOLS_OCSPCACHE *cache) {
+    SPARETOOLS_OCSPCACHE_STATS stats;
+
+    for (int i = 0; i < 500; i++) {
+        sparetools_ocspcache_stats(cache, &stats);
+        if (stats.valid > 0)
+            return 1;
+        usleep(10000);
+    }
+    return 0;
+}
+
+typedef struct {
+    size_t handshakes;
+    double rate;
+    double server_cpu_us;
+    double stapled_rate;
+    size_t staple_bytes;
+} run_result;
+
+/* Handshake step, adding the server's CPU time to *(double *)arg */
+static int server_timed_step(SSL *ssl, int is_server, void *arg) {
+    double t0;
+    int ret;
+
+    if (!is_server)
+        return SSL_do_handshake(ssl);
+    t0 = bench_cpu_now();
+    ret = SSL_do_handshake(ssl);
+    *(double *)arg += bench_cpu_now() - t0;
+    return ret;
+}
+
+static int run_handshakes(SSL_CTX *client_ctx, SSL_CTX *server_ctx, double min_seconds, run_result *r) {
+    double start = bench_now(), elapsed, server_cpu = 0.0;
+
+    memset(r, 0, sizeof(*r));
+    stapled = 0;
+    stapled_len = 0;
+    do {
+        SSL *client, *server;
+        int ok;
+
+        if (bench_tls_make_ssl_pair(client_ctx, server_ctx, &client, &server) != 0)
+            return 1;
+        ok = bench_tls_handshake_ex(client, server, server_timed_step, &server_cpu);
+        bench_tls_free_pair(client, server);
+        if (!ok)
+            return 1;
+        r->handshakes++;
+        elapsed = bench_now() - start;
+    } while (elapsed < min_seconds || r->handshakes < 10);
+
+    r->rate = (double)r->handshakes / elapsed;
+    r->server_cpu_us = server_cpu * 1e6 / (double)r->handshakes;
+    r->stapled_rate = (double)stapled / (double)r->handshakes;
+    r->staple_bytes = stapled_len;
+    return 0;
+}
+
+static int run_mode(staple_mode mode, double min_seconds, run_result *r) {
+    SSL_CTX *client_ctx = NULL, *server_ctx = NULL;
+    SPARETOOLS_OCSPCACHE *cache = NULL;
+    pthread_t churn;
+    int churning = 0, rc = 1;
+
+    if (bench_tls_make_ctx_pair(leaf_key, leaf_cert, &client_ctx, &server_ctx) != 0)
+        return 1;
+    if (!SSL_CTX_add1_chain_cert(server_ctx, ca_cert)
+        || !SSL_CTX_set_tlsext_status_type(client_ctx, TLSEXT_STATUSTYPE_ocsp)
+        || !SSL_CTX_set_tlsext_status_cb(client_ctx, client_status_cb))
+        goto done;
+    /* Full handshakes only: a resumed one carries no Certificate */
+    SSL_CTX_set_session_cache_mode(client_ctx, SSL_SESS_CACHE_OFF);
+    SSL_CTX_set_options(server_ctx, SSL_OP_NO_TICKET);
+
+    switch (mode) {
+    case MODE_NONE:
+        break;
+    case MODE_PARSE:
+        if (!SSL_CTX_set_tlsext_status_cb(server_ctx, parse_status_cb))
+            goto done;
+        break;
+    case MODE_CACHE:
+    case MODE_CHURN:
+        if ((cache = sparetools_ocspcache_new(fake_fetch, NULL, NULL, 0)) == NULL
+            || !sparetools_ocspcache_add(cache, leaf_cert, ca_cert)
+            || check_validation(cache) != 0
+            || !sparetools_ocspcache_start(cache, 0)
+            || !wait_valid(cache)
+            || !sparetools_ocspcache_attach(cache, server_ctx))
+            goto done;
+        if (mode == MODE_CHURN) {
+            atomic_store(&churn_stop, 0);
+            if (pthread_create(&churn, NULL, churn_main, cache) != 0)
+                goto done;
+            churning = 1;
+        }
+        break;
+    }
+
+    rc = run_handshakes(client_ctx, server_ctx, min_seconds, r);
+
+done:
+    if (churning) {
+        atomic_store(&churn_stop, 1);
+        pthread_join(churn, NULL);
+    }
+    if (cache != NULL && rc == 0) {
+        SPARETOOLS_OCSPCACHE_STATS stats;
+
+        sparetools_ocspcache_stats(cache, &stats);
+        if (stats.hits != r->handshakes || stats.misses != 0) {
+            fprintf(stderr, "ERROR: %s stapled %llu of %zu handshakes\n", mode_names[mode],
+                    (unsigned long long)stats.hits, r->handshakes);
+            rc = 1;
+        }
+    }
+    /* Contexts first: the cache must outlive them */
+    SSL_CTX_free(client_ctx);
+    SSL_CTX_free(server_ctx);
+    sparetools_ocspcache_free(cache);
+    return rc;
+}
+
+int main(int argc, char **argv) {
+    bench_options opts;
+    bench_json json;
+    double parse_rate = 0.0;
+    int failures = 0;
+
+    int argi = bench_parse_args(argc, argv, "bench_ocsp.json", &opts);
+
+    if (argi < 0)
+        return 2;
+    if (argi < argc) {
+        fprintf(stderr, "Usage: %s [--quick] [--json PATH]\n", argv[0]);
+        return 2;
+    }
+
+    printf("=================================\n");
+    printf("OpenSSL OCSP Stapling Benchmark\n");
+    printf("=================================\n");
+    printf("OpenSSL version: %s\n", OpenSSL_version(OPENSSL_VERSION));
+
+    if (make_pki() != 0) {
+        fprintf(stderr, "ERROR: Failed to create the test PKI and OCSP response\n");
+        ERR_print_errors_fp(stderr);
+        free_pki();
+        return 1;
+    }
+    printf("Stored response: %d bytes, valid %d days\n\n", staple_len, VALID_DAYS);
+    if (bench_json_begin(&json, &opts, "ocsp") != 0) {
+        free_pki();
+        return 1;
+    }
+
+    for (int m = 0; m < NUM_MODES; m++) {
+        run_result r;
+        double relative;
+
+        if (run_mode((staple_mode)m, opts.min_seconds, &r) != 0) {
+            fprintf(stderr, "ERROR: %s failed\n", mode_names[m]);
+            ERR_print_errors_fp(stderr);
+            failures++;
+            continue;
+        }
+        if (m == MODE_PARSE)
+            parse_rate = r.rate;
+        relative = parse_rate > 0 ? r.rate / parse_rate : 0.0;
+        printf("  %-12s %10.1f hs/s  server %8.1f us  stapled %5.1f%% (%zu bytes)",
+               mode_names[m], r.rate, r.server_cpu_us, r.stapled_rate * 100.0, r.staple_bytes);
+        if (m > MODE_PARSE)
+            printf("  x%.2f", relative);
+        printf("\n");
+
+        bench_json_record_begin(&json);
+        bench_json_str(&json, "mode", mode_names[m]);
+        bench_json_int(&json, "handshakes", r.handshakes);
+        bench_json_num(&json, "handshakes_per_s", r.rate);
+        bench_json_num(&json, "server_cpu_us", r.server_cpu_us);
+        bench_json_num(&json, "stapled_rate", r.stapled_rate);
+        bench_json_int(&json, "staple_bytes", r.staple_bytes);
+        if (m > MODE_PARSE)
+            bench_json_num(&json, "relative_to_parse", relative);
+        bench_json_record_end(&json);
+
+        /* Every mode but the baseline must staple every handshake */
+        if ((m == MODE_NONE) != (r.stapled_rate == 0.0)) {
+            fprintf(stderr, "ERROR: %s stapled %.1f%% of handshakes\n", mode_names[m], r.stapled_rate * 100.0);
+            failures++;
+        }
+    }
+
+    bench_json_end(&json);
+    free_pki();
+
+    printf("\n=================================\n");
+    if (failures == 0) {
+        printf("✅ OCSP stapling benchmark completed (%s)\n", opts.json_path);
+        return 0;
+    }
+    printf("❌ %d benchmark(s) FAILED\n", failures);
+    return 1;
+}
@@ -0,0 +1,497 @@
+#include <openssl/core_names.h>
+#include <openssl/crypto.h>
+#include <openssl/err.h>
+#include <openssl/evp.h>
+#include <openssl/kdf.h>
+#include <openssl/param_build.h>
+#include <openssl/params.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench_common.h"
+#include "sparetools_memtrace.h"
+#include "sparetools_paramcache.h"
+
+/**
+ * OSSL_PARAM construction overhead benchmark
+ *
+ * Runs three parameter-driven operations with their OSSL_PARAM arrays
+ * built in different ways:
+ *
+ * - kdf:      HKDF-SHA256 EVP_KDF_derive of 32 bytes with a per-message info
+ * - fromdata: EVP_PKEY_fromdata of an EC P-256 public key
+ * - cipher:   EVP_CIPHER_CTX_set_params (IV length), AES-256-GCM over a
+ *             64-byte message, EVP_CIPHER_CTX_get_params (tag)
+ *
+ * Methods:
+ * - bld:      OSSL_PARAM_BLD + OSSL_PARAM_BLD_to_param per call
+ * - static:   OSSL_PARAM_construct_* into a stack array per call
+ * - prebuilt: one array built at set-up, pointing at buffers that are
+ *             rewritten per message
+ * - template: the fixed entries from a sparetools_paramcache template,
+ *             merged with the per-call entries (kdf, fromdata)
+ * - preset:   the template set once on the EVP_KDF_CTX, so derive only
+ *             gets the info (kdf)
+ *
+ * Records carry ns_per_op and OpenSSL allocs_per_op for the whole
+ * operation, marshal_ns for building and freeing the params alone, and
+ * params_fraction = marshal_ns / ns_per_op. Every method has to produce
+ * the output of bld, or the run fails.
+ */
+
+#define INFO_LEN 16
+#define MSG_LEN 64
+#define TAG_LEN 16
+#define MAX_PARAMS 8
+/* Operations between clock reads, so bench_now() stays out of marshal_ns */
+#define BATCH 64
+
+typedef enum {
+    METHOD_BLD,
+    METHOD_STATIC,
+    METHOD_PREBUILT,
+    METHOD_TEMPLATE,
+    METHOD_PRESET,
+    NUM_METHODS
+} param_method;
+
+static const char *method_names[] = {"bld", "static", "prebuilt", "template", "preset"};
+
+static const unsigned char kdf_key[32] = "sparetools bench HKDF input key";
+static const unsigned char kdf_salt[16] = "sparetools salt";
+static const unsigned char aes_key[32] = "sparetools bench AES-256-GCM key";
+static char digest[] = "SHA2-256";
+static char group[] = "P-256";
+
+typedef struct {
+    SPARETOOLS_PARAMCACHE *cache;
+    /* kdf */
+    EVP_KDF_CTX *kctx;          /* every parameter passed to derive */
+    EVP_KDF_CTX *kctx_preset;   /* the HKDF-SHA256 template set once */
+    OSSL_PARAM kdf_prebuilt[5];
+    unsigned char info[INFO_LEN];
+    unsigned char kdf_out[32];
+    /* fromdata */
+    EVP_PKEY_CTX *pctx;
+    EVP_PKEY *pkey_ref;
+    EVP_PKEY *pkey_out;         /* result of the last EVP_PKEY_fromdata */
+    unsigned char pub[133];
+    size_t pub_len;
+    OSSL_PARAM fromdata_prebuilt[3];
+    /* cipher */
+    EVP_CIPHER_CTX *cctx;
+    size_t ivlen;
+    unsigned char iv[12];
+    unsigned char msg[MSG_LEN];
+    unsigned char ct[MSG_LEN + 16];
+    unsigned char tag[TAG_LEN];
+    OSSL_PARAM cipher_set_prebuilt[2];
+    OSSL_PARAM cipher_get_prebuilt[2];
+} bench_state;
+
+/* Keeps the marshal-only arrays observable so they are not optimized out */
+static const OSSL_PARAM *volatile params_sink;
+
+/* Per-message inputs: info, IV and plaintext start with the counter */
+static void set_message(bench_state *s, uint64_t counter) {
+    memcpy(s->info, &counter, sizeof(counter));
+    memcpy(s->iv, &counter, sizeof(counter));
+    memcpy(s->msg, &counter, sizeof(counter));
+}
+
+static void kdf_static_params(bench_state *s, OSSL_PARAM *p) {
+    *p++ = OSSL_PARAM_construct_utf8_string(OSSL_KDF_PARAM_DIGEST, digest, 0);
+    *p++ = OSSL_PARAM_construct_octet_string(OSSL_KDF_PARAM_KEY, (void *)kdf_key, sizeof(kdf_key));
+    *p++ = OSSL_PARAM_construct_octet_string(OSSL_KDF_PARAM_SALT, (void *)kdf_salt, sizeof(kdf_salt));
+    *p++ = OSSL_PARAM_construct_octet_string(OSSL_KDF_PARAM_INFO, s->info, sizeof(s->info));
+    *p = OSSL_PARAM_construct_end();
+}
+
+static void fromdata_static_params(bench_state *s, OSSL_PARAM *p) {
+    *p++ = OSSL_PARAM_construct_utf8_string(OSSL_PKEY_PARAM_GROUP_NAME, group, 0);
+    *p++ = OSSL_PARAM_construct_octet_string(OSSL_PKEY_PARAM_PUB_KEY, s->pub, s->pub_len);
+    *p = OSSL_PARAM_construct_end();
+}
+
+static void cipher_static_params(bench_state *s, OSSL_PARAM *set, OSSL_PARAM *get) {
+    set[0] = OSSL_PARAM_construct_size_t(OSSL_CIPHER_PARAM_AEAD_IVLEN, &s->ivlen);
+    set[1] = OSSL_PARAM_construct_end();
+    get[0] = OSSL_PARAM_construct_octet_string(OSSL_CIPHER_PARAM_AEAD_TAG, s->tag, sizeof(s->tag));
+    get[1] = OSSL_PARAM_construct_end();
+}
+
+/*
+ * Each operation returns 1 on success, 0 on failure and -1 when the
+ * method does not apply. With marshal_only it builds and frees the
+ * params without running the operation.
+ */
+typedef int (*param_op)(bench_state *s, param_method m, int marshal_only);
+
+static int kdf_op(bench_state *s, param_method m, int marshal_only) {
+    OSSL_PARAM stack[MAX_PARAMS], per_call[2];
+    OSSL_PARAM *params = stack, *built = NULL;
+    OSSL_PARAM_BLD *bld;
+    EVP_KDF_CTX *ctx = s->kctx;
+    int ok = 1;
+
+    switch (m) {
+    case METHOD_BLD:
+        ok = (bld = OSSL_PARAM_BLD_new()) != NULL
+            && OSSL_PARAM_BLD_push_utf8_string(bld, OSSL_KDF_PARAM_DIGEST, digest, 0)
+            && OSSL_PARAM_BLD_push_octet_string(bld, OSSL_KDF_PARAM_KEY, kdf_key, sizeof(kdf_key))
+            && OSSL_PARAM_BLD_push_octet_string(bld, OSSL_KDF_PARAM_SALT, kdf_salt, sizeof(kdf_salt))
+            && OSSL_PARAM_BLD_push_octet_string(bld, OSSL_KDF_PARAM_INFO, s->info, sizeof(s->info))
+            && (built = OSSL_PARAM_BLD_to_param(bld)) != NULL;
+        OSSL_PARAM_BLD_free(bld);
+        params = built;
+        break;
+    case METHOD_STATIC:
+        kdf_static_params(s, stack);
+        break;
+    case METHOD_PREBUILT:
+        params = s->kdf_prebuilt;
+        break;
+    case METHOD_TEMPLATE:
+    case METHOD_PRESET:
+        per_call[0] = OSSL_PARAM_construct_octet_string(OSSL_KDF_PARAM_INFO, s->info, sizeof(s->info));
+        per_call[1] = OSSL_PARAM_construct_end();
+        if (m == METHOD_PRESET) {
+            params = per_call;
+            ctx = s->kctx_preset;
+        } else {
+            ok = sparetools_params_merge(sparetools_paramcache_get(s->cache, "HKDF-SHA256"), per_call,
+                                         stack, MAX_PARAMS) >= 0;
+        }
+        break;
+    default:
+        return -1;
+    }
+    params_sink = params;
+    if (ok && !marshal_only)
+        ok = EVP_KDF_derive(ctx, s->kdf_out, sizeof(s->kdf_out), params) == 1;
+    OSSL_PARAM_free(built);
+    return ok;
+}
+
+static int fromdata_op(bench_state *s, param_method m, int marshal_only) {
+    OSSL_PARAM stack[MAX_PARAMS], per_call[2];
+    OSSL_PARAM *params = stack, *built = NULL;
+    OSSL_PARAM_BLD *bld;
+    EVP_PKEY *pkey = NULL;
+    int ok = 1;
+
+    switch (m) {
+    case METHOD_BLD:
+        ok = (bld = OSSL_PARAM_BLD_new()) != NULL
+            && OSSL_PARAM_BLD_push_utf8_string(bld, OSSL_PKEY_PARAM_GROUP_NAME, group, 0)
+            && OSSL_PARAM_BLD_push_octet_string(bld, OSSL_PKEY_PARAM_PUB_KEY, s->pub, s->pub_len)
+            && (built = OSSL_PARAM_BLD_to_param(bld)) != NULL;
+        OSSL_PARAM_BLD_free(bld);
+        params = built;
+        break;
+    case METHOD_STATIC:
+        fromdata_static_params(s, stack);
+        break;
+    case METHOD_PREBUILT:
+        params = s->fromdata_prebuilt;
+        break;
+    case METHOD_TEMPLATE:
+        per_call[0] = OSSL_PARAM_construct_octet_string(OSSL_PKEY_PARAM_PUB_KEY, s->pub, s->pub_len);
+        per_call[1] = OSSL_PARAM_construct_end();
+        ok = sparetools_params_merge(sparetools_paramcache_get(s->cache, "EC-P256"), per_call,
+                                     stack, MAX_PARAMS) >= 0;
+        break;
+    default:
+        return -1;
+    }
+    params_sink = params;
+    if (ok && !marshal_only) {
+        ok = EVP_PKEY_fromdata(s->pctx, &pkey, EVP_PKEY_PUBLIC_KEY, params) == 1;
+        EVP_PKEY_free(s->pkey_out);
+        s->pkey_out = pkey;
+    }
+    OSSL_PARAM_free(built);
+    return ok;
+}
+
+static int cipher_op(bench_state *s, param_method m, int marshal_only) {
+    OSSL_PARAM set_stack[2], get_stack[2];
+    OSSL_PARAM *set = set_stack, *get = get_stack, *built_set = NULL, *built_get = NULL;
+    OSSL_PARAM_BLD *bld = NULL, *bld_get = NULL;
+    static const unsigned char zero_tag[TAG_LEN];
+    int ok = 1, len, final_len;
+
+    switch (m) {
+    case METHOD_BLD:
+        /* A built array holds copies, so the tag is read back out of it below */
+        ok = (bld = OSSL_PARAM_BLD_new()) != NULL && (bld_get = OSSL_PARAM_BLD_new()) != NULL
+            && OSSL_PARAM_BLD_push_size_t(bld, OSSL_CIPHER_PARAM_AEAD_IVLEN, s->ivlen)
+            && OSSL_PARAM_BLD_push_octet_string(bld_get, OSSL_CIPHER_PARAM_AEAD_TAG, zero_tag, TAG_LEN)
+            && (built_set = OSSL_PARAM_BLD_to_param(bld)) != NULL
+            && (built_get = OSSL_PARAM_BLD_to_param(bld_get)) != NULL;
+        OSSL_PARAM_BLD_free(bld);
+        OSSL_PARAM_BLD_free(bld_get);
+        set = built_set;
+        get = built_get;
+        break;
+    case METHOD_STATIC:
+        cipher_static_params(s, set_stack, get_stack);
+        break;
+    case METHOD_PREBUILT:
+        set = s->cipher_set_prebuilt;
+        get = s->cipher_get_prebuilt;
+        break;
+    default:
+        return -1;
+    }
+    params_sink = set;
+    params_sink = get;
+    if (ok && !marshal_only) {
+        ok = EVP_CIPHER_CTX_set_params(s->cctx, set) == 1
+            && EVP_EncryptInit_ex2(s->cctx, NULL, NULL, s->iv, NULL) == 1
+            && EVP_EncryptUpdate(s->cctx, s->ct, &len, s->msg, MSG_LEN) == 1
+            && EVP_EncryptFinal_ex(s->cctx, s->ct + len, &final_len) == 1
+            && EVP_CIPHER_CTX_get_params(s->cctx, get) == 1;
+        if (ok && m == METHOD_BLD) {
+            const OSSL_PARAM *p = OSSL_PARAM_locate_const(get, OSSL_CIPHER_PARAM_AEAD_TAG);
+            size_t tag_len = 0;
+            void *out = s->tag;
+
+            ok = p != NULL && OSSL_PARAM_get_octet_string(p, &out, sizeof(s->tag), &tag_len)
+                && tag_len == TAG_LEN;
+        }
+    }
+    OSSL_PARAM_free(built_set);
+    OSSL_PARAM_free(built_get);
+    return ok;
+}
+
+/* Output of the last operation, to compare methods against bld */
+static size_t kdf_result(bench_state *s, unsigned char *buf, size_t len) {
+    (void)len;
+    memcpy(buf, s->kdf_out, sizeof(s->kdf_out));
+    return sizeof(s->kdf_out);
+}
+
+static size_t fromdata_result(bench_state *s, unsigned char *buf, size_t len) {
+    size_t out_len = 0;
+
+    if (s->pkey_out == NULL || EVP_PKEY_eq(s->pkey_out, s->pkey_ref) != 1
+        || !EVP_PKEY_get_octet_string_param(s->pkey_out, OSSL_PKEY_PARAM_PUB_KEY, buf, len, &out_len))
+        return 0;
+    return out_len;
+}
+
+static size_t cipher_result(bench_state *s, unsigned char *buf, size_t len) {
+    (void)len;
+    memcpy(buf, s->ct, MSG_LEN);
+    memcpy(buf + MSG_LEN, s->tag, TAG_LEN);
+    return MSG_LEN + TAG_LEN;
+}
+
+typedef struct {
+    const char *name;
+    const char *operation;
+    param_op op;
+    size_t (*result)(bench_state *s, unsigned char *buf, size_t len);
+} op_group;
+
+static const op_group groups[] = {
+    {"kdf", "HKDF-SHA256 derive 32B", kdf_op, kdf_result},
+    {"fromdata", "EVP_PKEY_fromdata EC P-256 public", fromdata_op, fromdata_result},
+    {"cipher", "AES-256-GCM 64B + set/get_params", cipher_op, cipher_result},
+};
+#define NUM_GROUPS (sizeof(groups) / sizeof(groups[0]))
+
+static int setup(bench_state *s) {
+    OSSL_PARAM tmpl[4];
+    EVP_KDF *kdf;
+    EVP_CIPHER *cipher;
+
+    memset(s, 0, sizeof(*s));
+    memset(s->info, 'i', sizeof(s->info));
+    memset(s->iv, 'v', sizeof(s->iv));
+    memset(s->msg, 'm', sizeof(s->msg));
+    s->ivlen = sizeof(s->iv);
+    if ((s->cache = sparetools_paramcache_new()) == NULL)
+        return 0;
+
+    /* Everything HKDF needs except the per-message info */
+    tmpl[0] = OSSL_PARAM_construct_utf8_string(OSSL_KDF_PARAM_DIGEST, digest, 0);
+    tmpl[1] = OSSL_PARAM_construct_octet_string(OSSL_KDF_PARAM_KEY, (void *)kdf_key, sizeof(kdf_key));
+    tmpl[2] = OSSL_PARAM_construct_octet_string(OSSL_KDF_PARAM_SALT, (void *)kdf_salt, sizeof(kdf_salt));
+    tmpl[3] = OSSL_PARAM_construct_end();
+    if (!sparetools_paramcache_add(s->cache, "HKDF-SHA256", tmpl))
+        return 0;
+    tmpl[0] = OSSL_PARAM_construct_utf8_string(OSSL_PKEY_PARAM_GROUP_NAME, group, 0);
+    tmpl[1] = OSSL_PARAM_construct_end();
+    if (!sparetools_paramcache_add(s->cache, "EC-P256", tmpl))
+        return 0;
+
+    if ((kdf = EVP_KDF_fetch(NULL, "HKDF", NULL)) == NULL)
+        return 0;
+    s->kctx = EVP_KDF_CTX_new(kdf);
+    s->kctx_preset = EVP_KDF_CTX_new(kdf);
+    EVP_KDF_free(kdf);
+    if (s->kctx == NULL || s->kctx_preset == NULL
+        || EVP_KDF_CTX_set_params(s->kctx_preset, sparetools_paramcache_get(s->cache, "HKDF-SHA256")) != 1)
+        return 0;
+    kdf_static_params(s, s->kdf_prebuilt);
+
+    if ((s->pkey_ref = EVP_PKEY_Q_keygen(NULL, NULL, "EC", group)) == NULL
+        || !EVP_PKEY_get_octet_string_param(s->pkey_ref, OSSL_PKEY_PARAM_PUB_KEY, s->pub, sizeof(s->pub),
+                                            &s->pub_len)
+        || (s->pctx = EVP_PKEY_CTX_new_from_name(NULL, "EC", NULL)) == NULL
+        || EVP_PKEY_fromdata_init(s->pctx) != 1)
+        return 0;
+    fromdata_static_params(s, s->fromdata_prebuilt);
+
+    if ((cipher = EVP_CIPHER_fetch(NULL, "AES-256-GCM", NULL)) == NULL)
+        return 0;
+    s->cctx = EVP_CIPHER_CTX_new();
+    if (s->cctx == NULL || EVP_EncryptInit_ex2(s->cctx, cipher, aes_key, NULL, NULL) != 1) {
+        EVP_CIPHER_free(cipher);
+        return 0;
+    }
+    EVP_CIPHER_free(cipher);
+    cipher_static_params(s, s->cipher_set_prebuilt, s->cipher_get_prebuilt);
+    return 1;
+}
+
+static void teardown(bench_state *s) {
+    EVP_KDF_CTX_free(s->kctx);
+    EVP_KDF_CTX_free(s->kctx_preset);
+    EVP_PKEY_free(s->pkey_out);
+    EVP_PKEY_free(s->pkey_ref);
+    EVP_PKEY_CTX_free(s->pctx);
+    EVP_CIPHER_CTX_free(s->cctx);
+    sparetools_paramcache_free(s->cache);
+}
+
+typedef struct {
+    double ns_per_op;
+    double allocs_per_op;
+    double bytes_per_op;
+} timing;
+
+/* Runs op in batches for at least seconds; returns 0 if an operation failed */
+static int measure(const op_group *g, bench_state *s, param_method m, int marshal_only, double seconds,
+                   timing *t) {
+    SPARETOOLS_MEMTRACE_TOTALS before, after;
+    uint64_t ops = 0;
+    double start, elapsed;
+
+    memset(t, 0, sizeof(*t));
+    sparetools_memtrace_totals(&before);
+    start = bench_now();
+    do {
+        for (int i = 0; i < BATCH; i++, ops++) {
+            set_message(s, ops);
+            if (g->op(s, m, marshal_only) != 1)
+                return 0;
+        }
+        elapsed = bench_now() - start;
+    } while (elapsed < seconds);
+    sparetools_memtrace_totals(&after);
+
+    t->ns_per_op = elapsed * 1e9 / (double)ops;
+    t->allocs_per_op = (double)(after.allocs + after.reallocs - before.allocs - before.reallocs) / (double)ops;
+    t->bytes_per_op = (double)(after.bytes - before.bytes) / (double)ops;
+    return 1;
+}
+
+/* Same output as bld for one fixed message */
+static int matches_reference(const op_group *g, bench_state *s, param_method m) {
+    unsigned char reference[256], output[256];
+    size_t reference_len, output_len;
+
+    set_message(s, 42);
+    if (g->op(s, METHOD_BLD, 0) != 1 || (reference_len = g->result(s, reference, sizeof(reference))) == 0)
+        return 0;
+    set_message(s, 42);
+    if (g->op(s, m, 0) != 1 || (output_len = g->result(s, output, sizeof(output))) == 0)
+        return 0;
+    return reference_len == output_len && memcmp(reference, output, reference_len) == 0;
+}
+
+int main(int argc, char **argv) {
+    bench_options opts;
+    bench_json json;
+    bench_state state;
+    int failures = 0;
+    int argi;
+
+    if (!sparetools_memtrace_install())
+        fprintf(stderr, "⚠ Allocation tracing unavailable (hooks already installed)\n");
+    if ((argi = bench_parse_args(argc, argv, "bench_params.json", &opts)) < 0)
+        return 2;
+    if (argi != argc) {
+        bench_usage(argv[0]);
+        return 2;
+    }
+
+    printf("=================================\n");
+    printf("OSSL_PARAM Construction Benchmark\n");
+    printf("=================================\n");
+    printf("OpenSSL version: %s\n\n", OpenSSL_version(OPENSSL_VERSION));
+    if (!setup(&state)) {
+        fprintf(stderr, "ERROR: Benchmark set-up failed\n");
+        ERR_print_errors_fp(stderr);
+        teardown(&state);
+        return 1;
+    }
+    if (bench_json_begin(&json, &opts, "params") != 0) {
+        teardown(&state);
+        return 1;
+    }
+
+    printf("  %-9s %-9s %10s %10s %10s %8s %8s\n", "Group", "Method", "ns/op", "allocs/op", "marshal", "params",
+           "vs bld");
+    for (size_t i = 0; i < NUM_GROUPS; i++) {
+        const op_group *g = &groups[i];
+        double bld_ns = 0;
+
+        for (int m = 0; m < NUM_METHODS; m++) {
+            timing op, marshal;
+            int ok;
+
+            if (g->op(&state, (param_method)m, 1) < 0)
+                continue;
+            ok = matches_reference(g, &state, (param_method)m)
+                && measure(g, &state, (param_method)m, 0, opts.min_seconds, &op)
+                && measure(g, &state, (param_method)m, 1, opts.min_seconds, &marshal);
+            failures += !ok;
+            if (m == METHOD_BLD)
+                bld_ns = op.ns_per_op;
+            if (ok)
+                printf("  %-9s %-9s %10.0f %10.1f %10.1f %7.1f%% %8.2f\n", g->name, method_names[m], op.ns_per_op,
+                       op.allocs_per_op, marshal.ns_per_op, 100.0 * marshal.ns_per_op / op.ns_per_op,
+                       bld_ns > 0 ? op.ns_per_op / bld_ns : 0.0);
+            else
+                printf("  %-9s %-9s  FAILED\n", g->name, method_names[m]);
+
+            bench_json_record_begin(&json);
+            bench_json_str(&json, "group", g->name);
+            bench_json_str(&json, "operation", g->operation);
+            bench_json_str(&json, "method", method_names[m]);
+            bench_json_int(&json, "ok", (uint64_t)ok);
+            if (ok) {
+                bench_json_num(&json, "ns_per_op", op.ns_per_op);
+                bench_json_num(&json, "allocs_per_op", op.allocs_per_op);
+                bench_json_num(&json, "bytes_per_op", op.bytes_per_op);
+                bench_json_num(&json, "marshal_ns", marshal.ns_per_op);
+                bench_json_num(&json, "marshal_allocs", marshal.allocs_per_op);
+                bench_json_num(&json, "params_fraction", marshal.ns_per_op / op.ns_per_op);
+                bench_json_num(&json, "relative_to_bld", bld_ns > 0 ? op.ns_per_op / bld_ns : 0.0);
+            }
+            bench_json_record_end(&json);
+            ERR_clear_error();
+        }
+    }
+    bench_json_end(&json);
+    teardown(&state);
+
+    printf("\n%s\n", failures ? "✗ Some methods failed or disagreed" : "✓ OSSL_PARAM benchmark completed");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,173 @@
+#ifndef SPARETOOLS_BENCH_PERF_H
+#define SPARETOOLS_BENCH_PERF_H
+
+#include <stdint.h>
+#include <string.h>
+
+#include "bench_common.h"
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+/**
+ * Hardware performance counters for the benchmark binaries (--perf-counters).
+ *
+ * Opens one perf_event group per process on Linux: cycles (leader),
+ * instructions, L1D read misses, last-level cache misses, branch misses
+ * and iTLB misses (instruction fetches that walked the page tables, what
+ * hugepage_text reduces), user space only. Counters that the host does not expose (VMs,
+ * perf_event_paranoid > 2, non-Linux) are reported as unavailable and
+ * the benchmark runs unchanged. When the kernel multiplexes the group,
+ * values are scaled by time_enabled / time_running.
+ */
+
+enum {
+    BENCH_PERF_CYCLES,
+    BENCH_PERF_INSTRUCTIONS,
+    BENCH_PERF_L1D_MISSES,
+    BENCH_PERF_LLC_MISSES,
+    BENCH_PERF_BRANCH_MISSES,
+    BENCH_PERF_ITLB_MISSES,
+    BENCH_PERF_NUM_EVENTS
+};
+
+static const char *const bench_perf_names[BENCH_PERF_NUM_EVENTS] = {
+    "cycles", "instructions", "l1d_misses", "llc_misses", "branch_misses", "itlb_misses"
+};
+
+typedef struct {
+    int fds[BENCH_PERF_NUM_EVENTS];   /* -1 when the event is unavailable */
+    int enabled;                      /* Group leader opened */
+} bench_perf;
+
+typedef struct {
+    uint64_t values[BENCH_PERF_NUM_EVENTS];
+    int valid[BENCH_PERF_NUM_EVENTS];
+} bench_perf_sample;
+
+#ifdef __linux__
+static inline int bench_perf_event_open(uint32_t type, uint64_t config, int group_fd) {
+    struct perf_event_attr attr;
+
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.disabled = group_fd < 0;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, group_fd, 0);
+}
+#endif
+
+/** Open the counter group; returns 1 if at least cycles are available */
+static inline int bench_perf_open(bench_perf *p) {
+    for (int i = 0; i < BENCH_PERF_NUM_EVENTS; i++)
+        p->fds[i] = -1;
+    p->enabled = 0;
+#ifdef __linux__
+    {
+        static const struct { uint32_t type; uint64_t config; } events[BENCH_PERF_NUM_EVENTS] = {
+            {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+            {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+            {PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D
+                                 | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+                                 | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)},
+            {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+            {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+            {PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_ITLB
+                                 | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+                                 | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)},
+        };
+
+        p->fds[0] = bench_perf_event_open(events[0].type, events[0].config, -1);
+        if (p->fds[0] < 0)
+            return 0;
+        for (int i = 1; i < BENCH_PERF_NUM_EVENTS; i++)
+            p->fds[i] = bench_perf_event_open(events[i].type, events[i].config, p->fds[0]);
+        p->enabled = 1;
+    }
+#endif
+    return p->enabled;
+}
+
+static inline void bench_perf_close(bench_perf *p) {
+    if (!p->enabled)
+        return;
+#ifdef __linux__
+    for (int i = 0; i < BENCH_PERF_NUM_EVENTS; i++) {
+        if (p->fds[i] >= 0)
+            close(p->fds[i]);
+        p->fds[i] = -1;
+    }
+#endif
+    p->enabled = 0;
+}
+
+/** Reset and start the group (no-op when disabled) */
+static inline void bench_perf_start(bench_perf *p) {
+#ifdef __linux__
+    if (p->enabled) {
+        ioctl(p->fds[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ioctl(p->fds[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    }
+#else
+    (void)p;
+#endif
+}
+
+/** Stop the group and read every counter into out */
+static inline void bench_perf_stop(bench_perf *p, bench_perf_sample *out) {
+    memset(out, 0, sizeof(*out));
+#ifdef __linux__
+    if (!p->enabled)
+        return;
+    ioctl(p->fds[0], PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+    for (int i = 0; i < BENCH_PERF_NUM_EVENTS; i++) {
+        uint64_t data[3];  /* value, time_enabled, time_running */
+
+        if (p->fds[i] < 0 || read(p->fds[i], data, sizeof(data)) != (ssize_t)sizeof(data)
+            || data[2] == 0)
+            continue;
+        out->values[i] = data[2] < data[1]
+            ? (uint64_t)((double)data[0] * (double)data[1] / (double)data[2])
+            : data[0];
+        out->valid[i] = 1;
+    }
+#else
+    (void)p;
+#endif
+}
+
+/** Instructions per cycle, 0 when either counter is missing */
+static inline double bench_perf_ipc(const bench_perf_sample *s) {
+    if (!s->valid[BENCH_PERF_CYCLES] || !s->valid[BENCH_PERF_INSTRUCTIONS]
+        || s->values[BENCH_PERF_CYCLES] == 0)
+        return 0.0;
+    return (double)s->values[BENCH_PERF_INSTRUCTIONS] / (double)s->values[BENCH_PERF_CYCLES];
+}
+
+/**
+ * Add counter fields to the current JSON record: every available
+ * counter, "ipc" and, per operation, "cycles_per_op" and
+ * "itlb_misses_per_op".
+ */
+static inline void bench_perf_json(bench_json *j, const bench_perf_sample *s, uint64_t ops) {
+    for (int i = 0; i < BENCH_PERF_NUM_EVENTS; i++) {
+        if (s->valid[i])
+            bench_json_int(j, bench_perf_names[i], s->values[i]);
+    }
+    if (s->valid[BENCH_PERF_INSTRUCTIONS])
+        bench_json_num(j, "ipc", bench_perf_ipc(s));
+    if (s->valid[BENCH_PERF_CYCLES] && ops > 0)
+        bench_json_num(j, "cycles_per_op", (double)s->values[BENCH_PERF_CYCLES] / (double)ops);
+    if (s->valid[BENCH_PERF_ITLB_MISSES] && ops > 0)
+        bench_json_num(j, "itlb_misses_per_op", (double)s->values[BENCH_PERF_ITLB_MISSES] / (double)ops);
+}
+
+#endif /* SPARETOOLS_BENCH_PERF_H */
@@ -0,0 +1,368 @@
+#include <openssl/crypto.h>
+#include <openssl/err.h>
+#include <openssl/evp.h>
+#include <openssl/x509.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench_common.h"
+
+/**
+ * Post-quantum primitive benchmark
+ *
+ * Measures the building blocks of a post-quantum TLS handshake against
+ * their classical counterparts:
+ * - KEMs: keygen, encapsulate and decapsulate ops/s for ML-KEM-512/768/
+ *   1024 and the X25519MLKEM768 / SecP256r1MLKEM768 hybrids, with X25519
+ *   (DHKEM) as the baseline. Also reports the encoded public key (client
+ *   key share) and ciphertext (server key share) sizes.
+ * - Signatures: sign and verify ops/s for ML-DSA-44/65/87 and
+ *   SLH-DSA-SHA2-128s/128f, with Ed25519 and ECDSA P-256 as baselines.
+ *   Also reports the signature and SubjectPublicKeyInfo sizes, i.e. what
+ *   a CertificateVerify and a leaf certificate grow by.
+ *
+ * Each record carries "arch" and "simd" so AVX2 and NEON runs of the same
+ * build can be compared side by side; mask capabilities with
+ * OPENSSL_ia32cap / OPENSSL_armcap (see bench_cpu_dispatch.c) to measure
+ * the portable code paths on the same machine. Algorithms the library
+ * does not provide are skipped; OpenSSL before 3.5 reports a single
+ * unavailable record. Handshake-level cost (CPU time and bytes on the
+ * wire per group) is measured by bench_handshake.
+ */
+
+#define MESSAGE_LEN 64
+
+#if defined(__x86_64__) || defined(_M_X64)
+# define BENCH_ARCH "x86_64"
+#elif defined(__i386__) || defined(_M_IX86)
+# define BENCH_ARCH "x86"
+#elif defined(__aarch64__) || defined(_M_ARM64)
+# define BENCH_ARCH "aarch64"
+#elif defined(__arm__)
+# define BENCH_ARCH "arm"
+#else
+# define BENCH_ARCH "other"
+#endif
+
+/* Widest vector extension the CPU offers (OpenSSL may be masked lower) */
+static const char *simd_level(void) {
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f"))
+        return "avx512";
+    if (__builtin_cpu_supports("avx2"))
+        return "avx2";
+    return "sse";
+#elif defined(__aarch64__) || defined(_M_ARM64)
+    return "neon";
+#else
+    return "unknown";
+#endif
+}
+
+#if OPENSSL_VERSION_NUMBER >= 0x30500000L
+
+static const char *kem_names[] = {
+    "X25519",
+    "ML-KEM-512",
+    "ML-KEM-768",
+    "ML-KEM-1024",
+    "X25519MLKEM768",
+    "SecP256r1MLKEM768",
+    NULL
+};
+
+static const struct {
+    const char *name;
+    const char *keytype;
+    const char *param;      /* curve for EC keys */
+    const char *digest;     /* NULL: the algorithm hashes internally */
+} sig_algs[] = {
+    {"ECDSA-P256", "EC", "P-256", "SHA256"},
+    {"Ed25519", "ED25519", NULL, NULL},
+    {"ML-DSA-44", "ML-DSA-44", NULL, NULL},
+    {"ML-DSA-65", "ML-DSA-65", NULL, NULL},
+    {"ML-DSA-87", "ML-DSA-87", NULL, NULL},
+    {"SLH-DSA-SHA2-128s", "SLH-DSA-SHA2-128s", NULL, NULL},
+    {"SLH-DSA-SHA2-128f", "SLH-DSA-SHA2-128f", NULL, NULL},
+};
+#define NUM_SIG_ALGS (sizeof(sig_algs) / sizeof(sig_algs[0]))
+
+typedef struct {
+    const char *keytype;
+    const char *param;
+    const char *digest;
+    EVP_PKEY *pkey;
+    unsigned char msg[MESSAGE_LEN];
+    unsigned char *sig;
+    size_t sigmax;          /* buffer size */
+    size_t siglen;          /* length of the last signature produced */
+    unsigned char *ct;
+    size_t ctlen;
+    unsigned char secret[64];
+    size_t secretlen;
+} op_state;
+
+typedef int (*op_fn)(op_state *state);
+
+/* Run op until min_seconds have elapsed (at least once); returns ops/s or -1 */
+static double run_op(op_fn op, op_state *state, double min_seconds,
+                     unsigned long long *iterations) {
+    unsigned long long count = 0;
+    double start = bench_now(), elapsed;
+
+    do {
+        if (!op(state))
+            return -1.0;
+        count++;
+        elapsed = bench_now() - start;
+    } while (elapsed < min_seconds);
+    *iterations = count;
+    return (double)count / elapsed;
+}
+
+static EVP_PKEY *generate(const char *keytype, const char *param) {
+    if (param != NULL)
+        return EVP_PKEY_Q_keygen(NULL, NULL, keytype, param);
+    return EVP_PKEY_Q_keygen(NULL, NULL, keytype);
+}
+
+static int op_keygen(op_state *state) {
+    EVP_PKEY *pkey = generate(state->keytype, state->param);
+
+    EVP_PKEY_free(pkey);
+    return pkey != NULL;
+}
+
+/* EC/ECX keys encapsulate through RFC 9180 DHKEM; ML-KEM keys natively */
+static int kem_init(EVP_PKEY_CTX *pctx, const char *keytype, int encaps) {
+    if ((encaps ? EVP_PKEY_encapsulate_init(pctx, NULL)
+                : EVP_PKEY_decapsulate_init(pctx, NULL)) <= 0)
+        return 0;
+    if (strcmp(keytype, "X25519") == 0)
+        return EVP_PKEY_CTX_set_kem_op(pctx, "DHKEM") > 0;
+    return 1;
+}
+
+static int op_encaps(op_state *state) {
+    EVP_PKEY_CTX *pctx = EVP_PKEY_CTX_new_from_pkey(NULL, state->pkey, NULL);
+    size_t ctlen = state->ctlen, secretlen = sizeof(state->secret);
+    int ok = pctx != NULL && kem_init(pctx, state->keytype, 1)
+             && EVP_PKEY_encapsulate(pctx, state->ct, &ctlen, state->secret, &secretlen) > 0;
+
+    EVP_PKEY_CTX_free(pctx);
+    return ok;
+}
+
+static int op_decaps(op_state *state) {
+    EVP_PKEY_CTX *pctx = EVP_PKEY_CTX_new_from_pkey(NULL, state->pkey, NULL);
+    size_t secretlen = sizeof(state->secret);
+    int ok = pctx != NULL && kem_init(pctx, state->keytype, 0)
+             && EVP_PKEY_decapsulate(pctx, state->secret, &secretlen, state->ct, state->ctlen) > 0;
+
+    EVP_PKEY_CTX_free(pctx);
+    return ok;
+}
+
+/* One-shot sign/verify with a fresh context, as libssl does per handshake */
+static int op_sign(op_state *state) {
+    EVP_MD_CTX *mctx = EVP_MD_CTX_new();
+    size_t siglen = state->sigmax;
+    int ok = mctx != NULL
+             && EVP_DigestSignInit_ex(mctx, NULL, state->digest, NULL, NULL, state->pkey, NULL) > 0
+             && EVP_DigestSign(mctx, state->sig, &siglen, state->msg, sizeof(state->msg)) > 0;
+
+    /* ECDSA signatures vary in length: verify checks the last one */
+    state->siglen = siglen;
+    EVP_MD_CTX_free(mctx);
+    return ok;
+}
+
+static int op_verify(op_state *state) {
+    EVP_MD_CTX *mctx = EVP_MD_CTX_new();
+    int ok = mctx != NULL
+             && EVP_DigestVerifyInit_ex(mctx, NULL, state->digest, NULL, NULL, state->pkey, NULL) > 0
+             && EVP_DigestVerify(mctx, state->sig, state->siglen, state->msg, sizeof(state->msg)) == 1;
+
+    EVP_MD_CTX_free(mctx);
+    return ok;
+}
+
+static void report(bench_json *json, const char *kind, const char *alg, const char *op,
+                   unsigned long long iterations, double rate, const char *size1_name,
+                   size_t size1, const char *size2_name, size_t size2) {
+    printf("  %-18s %-8s %12.1f ops/s  %8.1f us/op\n", alg, op, rate, 1e6 / rate);
+    bench_json_record_begin(json);
+    bench_json_str(json, "kind", kind);
+    bench_json_str(json, "algorithm", alg);
+    bench_json_str(json, "operation", op);
+    bench_json_str(json, "arch", BENCH_ARCH);
+    bench_json_str(json, "simd", simd_level());
+    bench_json_int(json, "iterations", iterations);
+    bench_json_num(json, "ops_per_s", rate);
+    bench_json_num(json, "us_per_op", 1e6 / rate);
+    bench_json_int(json, size1_name, size1);
+    bench_json_int(json, size2_name, size2);
+    bench_json_record_end(json);
+}
+
+/* Returns the number of failed operations */
+static int bench_kem(bench_json *json, const char *name, double min_seconds) {
+    static const struct {
+        const char *op;
+        op_fn fn;
+    } ops[] = {{"keygen", op_keygen}, {"encaps", op_encaps}, {"decaps", op_decaps}};
+    op_state state;
+    EVP_PKEY_CTX *pctx = NULL;
+    unsigned char *pub = NULL;
+    size_t publen;
+    int failures = 0;
+
+    memset(&state, 0, sizeof(state));
+    state.keytype = name;
+    if ((state.pkey = generate(name, NULL)) == NULL) {
+        printf("  %-18s not available, skipping\n", name);
+        ERR_clear_error();
+        return 0;
+    }
+    publen = EVP_PKEY_get1_encoded_public_key(state.pkey, &pub);
+    OPENSSL_free(pub);
+
+    /* Size the ciphertext once; encaps then reuses a preallocated buffer */
+    pctx = EVP_PKEY_CTX_new_from_pkey(NULL, state.pkey, NULL);
+    if (pctx == NULL || !kem_init(pctx, name, 1)
+        || EVP_PKEY_encapsulate(pctx, NULL, &state.ctlen, NULL, &state.secretlen) <= 0
+        || (state.ct = OPENSSL_malloc(state.ctlen)) == NULL
+        || !op_encaps(&state)) {
+        fprintf(stderr, "ERROR: %s encapsulation setup failed\n", name);
+        ERR_print_errors_fp(stderr);
+        failures++;
+        goto end;
+    }
+
+    for (size_t i = 0; i < sizeof(ops) / sizeof(ops[0]); i++) {
+        unsigned long long iterations = 0;
+        double rate = run_op(ops[i].fn, &state, min_seconds, &iterations);
+
+        if (rate < 0) {
+            fprintf(stderr, "ERROR: %s %s failed\n", name, ops[i].op);
+            ERR_print_errors_fp(stderr);
+            failures++;
+            continue;
+        }
+        report(json, "kem", name, ops[i].op, iterations, rate,
+               "public_key_bytes", publen, "ciphertext_bytes", state.ctlen);
+    }
+
+end:
+    EVP_PKEY_CTX_free(pctx);
+    OPENSSL_free(state.ct);
+    EVP_PKEY_free(state.pkey);
+    return failures;
+}
+
+/* Returns the number of failed operations */
+static int bench_sig(bench_json *json, size_t a, double min_seconds) {
+    static const struct {
+        const char *op;
+        op_fn fn;
+    } ops[] = {{"keygen", op_keygen}, {"sign", op_sign}, {"verify", op_verify}};
+    const char *name = sig_algs[a].name;
+    op_state state;
+    EVP_MD_CTX *mctx = NULL;
+    int spki, failures = 0;
+
+    memset(&state, 0, sizeof(state));
+    state.keytype = sig_algs[a].keytype;
+    state.param = sig_algs[a].param;
+    state.digest = sig_algs[a].digest;
+    memset(state.msg, 0x5a, sizeof(state.msg));
+    if ((state.pkey = generate(state.keytype, state.param)) == NULL) {
+        printf("  %-18s not available, skipping\n", name);
+        ERR_clear_error();
+        return 0;
+    }
+    spki = i2d_PUBKEY(state.pkey, NULL);
+
+    /* Size the signature once; sign then reuses a preallocated buffer */
+    mctx = EVP_MD_CTX_new();
+    if (mctx == NULL
+        || EVP_DigestSignInit_ex(mctx, NULL, state.digest, NULL, NULL, state.pkey, NULL) <= 0
+        || EVP_DigestSign(mctx, NULL, &state.sigmax, state.msg, sizeof(state.msg)) <= 0
+        || (state.sig = OPENSSL_malloc(state.sigmax)) == NULL
+        || !op_sign(&state)) {
+        fprintf(stderr, "ERROR: %s signing setup failed\n", name);
+        ERR_print_errors_fp(stderr);
+        failures++;
+        goto end;
+    }
+
+    for (size_t i = 0; i < sizeof(ops) / sizeof(ops[0]); i++) {
+        unsigned long long iterations = 0;
+        double rate = run_op(ops[i].fn, &state, min_seconds, &iterations);
+
+        if (rate < 0) {
+            fprintf(stderr, "ERROR: %s %s failed\n", name, ops[i].op);
+            ERR_print_errors_fp(stderr);
+            failures++;
+            continue;
+        }
+        report(json, "signature", name, ops[i].op, iterations, rate,
+               "signature_bytes", state.sigmax, "spki_bytes", spki > 0 ? (size_t)spki : 0);
+    }
+
+end:
+    EVP_MD_CTX_free(mctx);
+    OPENSSL_free(state.sig);
+    EVP_PKEY_free(state.pkey);
+    return failures;
+}
+
+#endif
+
+int main(int argc, char **argv) {
+    bench_options opts;
+    bench_json json;
+    int failures = 0;
+
+    if (bench_parse_args(argc, argv, "bench_pqc.json", &opts) != argc)
+        return 2;
+
+    printf("=================================\n");
+    printf("OpenSSL Post-Quantum Primitive Benchmark\n");
+    printf("=================================\n");
+    printf("OpenSSL version: %s\n", OpenSSL_version(OPENSSL_VERSION));
+    printf("Architecture: %s (%s)\n", BENCH_ARCH, simd_level());
+
+    if (bench_json_begin(&json, &opts, "pqc") != 0)
+        return 1;
+
+#if OPENSSL_VERSION_NUMBER >= 0x30500000L
+    printf("\nKey encapsulation\n");
+    for (int k = 0; kem_names[k] != NULL; k++)
+        failures += bench_kem(&json, kem_names[k], opts.min_seconds);
+
+    printf("\nSignatures (%d-byte message)\n", MESSAGE_LEN);
+    for (size_t a = 0; a < NUM_SIG_ALGS; a++)
+        failures += bench_sig(&json, a, opts.min_seconds);
+#else
+    /* Not a failure: the record is how pre-3.5 builds show up */
+    printf("⚠ ML-KEM / ML-DSA / SLH-DSA need OpenSSL 3.5 or later\n");
+    bench_json_record_begin(&json);
+    bench_json_str(&json, "kind", "pqc");
+    bench_json_str(&json, "arch", BENCH_ARCH);
+    bench_json_int(&json, "available", 0);
+    bench_json_record_end(&json);
+#endif
+
+    bench_json_end(&json);
+
+    printf("\n=================================\n");
+    if (failures > 0) {
+        printf("❌ %d post-quantum benchmark(s) failed\n", failures);
+        return 1;
+    }
+    printf("✅ Post-quantum benchmark completed (%s)\n", opts.json_path);
+    return 0;
+}
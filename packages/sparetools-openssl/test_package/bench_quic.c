@@ -0,0 +1,465 @@
+#include <openssl/crypto.h>
+#include <openssl/err.h>
+#include <openssl/opensslv.h>
+#include <openssl/ssl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench_common.h"
+
+/**
+ * QUIC loopback benchmark (OpenSSL 3.5+ server API)
+ *
+ * A server thread runs an OSSL_QUIC_server_method listener on a UDP
+ * socket bound to 127.0.0.1; the main thread drives OSSL_QUIC_client_method
+ * connections against it. All objects use OpenSSL's blocking mode, so the
+ * numbers include its internal reactor and timers, as an application
+ * using the stack would see them.
+ *
+ * Workloads:
+ * - setup:     sequential connections, SSL_new() to SSL_connect()
+ *              returning (1-RTT handshake, ECDSA P-256 certificate),
+ *              reported as connections/s, handshake latency p50/p99 and
+ *              time to the first 1-byte response
+ * - request:   one connection, sequential bidirectional streams carrying
+ *              a 1 KiB request and an 8-byte response (streams/s, p50/p99)
+ * - bulk:      one stream uploading 64 MiB (4 MiB with --quick), MB/s
+ *
+ * Builds against OpenSSL older than 3.5, or configured with no-quic
+ * (enable_quic=False), report a single unavailable record.
+ */
+
+#if OPENSSL_VERSION_NUMBER >= 0x30500000L && !defined(OPENSSL_NO_QUIC)
+
+#include <openssl/quic.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "bench_tls.h"
+
+#define ALPN "\x0asparetools"
+#define REQUEST_SIZE 1024
+#define CHUNK_SIZE 65536
+#define MAX_SAMPLES 2000
+
+static atomic_int server_stop;
+static atomic_int server_failed;
+
+static int alpn_select_cb(SSL *ssl, const unsigned char **out, unsigned char *outlen,
+                          const unsigned char *in, unsigned int inlen, void *arg) {
+    (void)ssl;
+    (void)arg;
+    if (SSL_select_next_proto((unsigned char **)out, outlen, (const unsigned char *)ALPN,
+                              sizeof(ALPN) - 1, in, inlen) != OPENSSL_NPN_NEGOTIATED)
+        return SSL_TLSEXT_ERR_ALERT_FATAL;
+    return SSL_TLSEXT_ERR_OK;
+}
+
+static int udp_socket(void) {
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+
+    if (fd >= 0 && !BIO_socket_nbio(fd, 1)) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/* Read the whole stream, then answer with the byte count and conclude */
+static int serve_stream(SSL *stream) {
+    unsigned char buf[CHUNK_SIZE], reply[8];
+    uint64_t total = 0;
+    size_t n;
+
+    while (SSL_read_ex(stream, buf, sizeof(buf), &n))
+        total += n;
+    if (SSL_get_error(stream, 0) != SSL_ERROR_ZERO_RETURN)
+        return 0;
+    for (int i = 0; i < 8; i++)
+        reply[i] = (unsigned char)(total >> (56 - 8 * i));
+    return SSL_write_ex(stream, reply, sizeof(reply), &n) && SSL_stream_conclude(stream, 0);
+}
+
+static void serve_connection(SSL *conn) {
+    SSL *stream;
+
+    if (!SSL_set_default_stream_mode(conn, SSL_DEFAULT_STREAM_MODE_NONE)) {
+        atomic_store(&server_failed, 1);
+        SSL_free(conn);
+        return;
+    }
+    /* Blocks until the client opens a stream; NULL once it closes */
+    while ((stream = SSL_accept_stream(conn, 0)) != NULL) {
+        if (!serve_stream(stream))
+            atomic_store(&server_failed, 1);
+        SSL_free(stream);
+    }
+    ERR_clear_error();
+    SSL_free(conn);
+}
+
+typedef struct {
+    SSL *listener;
+    int fd;
+} server_arg;
+
+static void *server_thread(void *varg) {
+    server_arg *arg = varg;
+
+    while (!atomic_load(&server_stop)) {
+        SSL *conn;
+        struct timeval tv = {0, 10000}, next;
+        int infinite = 0;
+        fd_set readfds;
+
+        SSL_handle_events(arg->listener);
+        conn = SSL_accept_connection(arg->listener, SSL_ACCEPT_CONNECTION_NO_BLOCK);
+        if (conn != NULL) {
+            serve_connection(conn);
+            continue;
+        }
+        /*
+         * Nothing queued: sleep until a datagram arrives or the reactor's
+         * next timer (handshake progress, retransmits) is due
+         */
+        if (SSL_get_event_timeout(arg->listener, &next, &infinite) && !infinite
+            && (next.tv_sec < tv.tv_sec || (next.tv_sec == tv.tv_sec && next.tv_usec < tv.tv_usec)))
+            tv = next;
+        FD_ZERO(&readfds);
+        FD_SET(arg->fd, &readfds);
+        select(arg->fd + 1, &readfds, NULL, NULL, &tv);
+    }
+    return NULL;
+}
+
+typedef struct {
+    SSL_CTX *server_ctx;
+    SSL_CTX *client_ctx;
+    SSL *listener;
+    int server_fd;
+    struct sockaddr_in addr;
+    BIO_ADDR *peer;
+    pthread_t thread;
+    int running;
+} quic_env;
+
+static int start_server(quic_env *env, EVP_PKEY *pkey, X509 *cert) {
+    static server_arg arg;
+    socklen_t len = sizeof(env->addr);
+
+    env->server_ctx = SSL_CTX_new(OSSL_QUIC_server_method());
+    env->client_ctx = SSL_CTX_new(OSSL_QUIC_client_method());
+    if (env->server_ctx == NULL || env->client_ctx == NULL
+        || SSL_CTX_use_certificate(env->server_ctx, cert) != 1
+        || SSL_CTX_use_PrivateKey(env->server_ctx, pkey) != 1)
+        return 0;
+    SSL_CTX_set_alpn_select_cb(env->server_ctx, alpn_select_cb, NULL);
+    SSL_CTX_set_verify(env->client_ctx, SSL_VERIFY_NONE, NULL);
+
+    memset(&env->addr, 0, sizeof(env->addr));
+    env->addr.sin_family = AF_INET;
+    env->addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if ((env->server_fd = udp_socket()) < 0
+        || bind(env->server_fd, (struct sockaddr *)&env->addr, sizeof(env->addr)) != 0
+        || getsockname(env->server_fd, (struct sockaddr *)&env->addr, &len) != 0)
+        return 0;
+
+    if ((env->peer = BIO_ADDR_new()) == NULL
+        || !BIO_ADDR_rawmake(env->peer, AF_INET, &env->addr.sin_addr,
+                             sizeof(env->addr.sin_addr), env->addr.sin_port))
+        return 0;
+
+    if ((env->listener = SSL_new_listener(env->server_ctx, 0)) == NULL
+        || !SSL_set_fd(env->listener, env->server_fd)
+        || !SSL_listen(env->listener))
+        return 0;
+
+    arg.listener = env->listener;
+    arg.fd = env->server_fd;
+    atomic_store(&server_stop, 0);
+    atomic_store(&server_failed, 0);
+    if (pthread_create(&env->thread, NULL, server_thread, &arg) != 0)
+        return 0;
+    env->running = 1;
+    return 1;
+}
+
+static void stop_server(quic_env *env) {
+    if (env->running) {
+        atomic_store(&server_stop, 1);
+        pthread_join(env->thread, NULL);
+    }
+    SSL_free(env->listener);
+    if (env->server_fd >= 0)
+        close(env->server_fd);
+    BIO_ADDR_free(env->peer);
+    SSL_CTX_free(env->server_ctx);
+    SSL_CTX_free(env->client_ctx);
+}
+
+/* Connect a new client; returns NULL on failure, *fd_out owns the socket */
+static SSL *client_connect(quic_env *env, int *fd_out) {
+    int fd = udp_socket();
+    SSL *ssl = NULL;
+
+    *fd_out = fd;
+    if (fd < 0 || connect(fd, (struct sockaddr *)&env->addr, sizeof(env->addr)) != 0)
+        return NULL;
+    if ((ssl = SSL_new(env->client_ctx)) == NULL
+        || !SSL_set_fd(ssl, fd)
+        || !SSL_set_default_stream_mode(ssl, SSL_DEFAULT_STREAM_MODE_NONE)
+        || !SSL_set1_initial_peer_addr(ssl, env->peer)
+        || SSL_set_alpn_protos(ssl, (const unsigned char *)ALPN, sizeof(ALPN) - 1) != 0
+        || !SSL_set_tlsext_host_name(ssl, "bench.sparetools.local")
+        || SSL_connect(ssl) != 1) {
+        SSL_free(ssl);
+        return NULL;
+    }
+    return ssl;
+}
+
+static void client_close(SSL *ssl, int fd) {
+    if (ssl != NULL) {
+        /* Rapid: skip the terminating period, the server just sees a close */
+        SSL_shutdown_ex(ssl, SSL_SHUTDOWN_FLAG_RAPID, NULL, 0);
+        SSL_free(ssl);
+    }
+    if (fd >= 0)
+        close(fd);
+}
+
+/**
+ * Send len bytes on a new stream (data holds one chunk, repeated), conclude,
+ * and check the byte count the server answers with.
+ */
+static int stream_roundtrip(SSL *conn, const unsigned char *data, size_t len) {
+    SSL *stream = SSL_new_stream(conn, 0);
+    unsigned char reply[8];
+    uint64_t count = 0;
+    size_t off = 0, n, got = 0;
+    int ok = 0;
+
+    if (stream == NULL)
+        return 0;
+    while (off < len) {
+        size_t chunk = len - off < CHUNK_SIZE ? len - off : CHUNK_SIZE;
+
+        if (!SSL_write_ex(stream, data, chunk, &n))
+            goto end;
+        off += n;
+    }
+    if (!SSL_stream_conclude(stream, 0))
+        goto end;
+    while (got < sizeof(reply) && SSL_read_ex(stream, reply + got, sizeof(reply) - got, &n))
+        got += n;
+    if (got != sizeof(reply))
+        goto end;
+    for (int i = 0; i < 8; i++)
+        count = (count << 8) | reply[i];
+    ok = count == len;
+end:
+    SSL_free(stream);
+    return ok;
+}
+
+/**
+ * One record per latency workload; rate is count over the summed
+ * samples (the sequential busy time). ttfb, when given, holds the
+ * matching time-to-first-response samples.
+ */
+static void report_latency(bench_json *json, const char *workload, size_t count,
+                           double *samples, double *ttfb, const char *unit) {
+    double busy = 0.0, rate, p50, p99;
+
+    for (size_t i = 0; i < count; i++)
+        busy += ttfb != NULL ? ttfb[i] : samples[i];
+    rate = busy > 0 ? (double)count / busy : 0.0;
+    p50 = bench_percentile(samples, count, 50) * 1e6;
+    p99 = bench_percentile(samples, count, 99) * 1e6;
+
+    printf("  %-8s %10.1f %s/s  p50 %8.1f us  p99 %8.1f us", workload, rate, unit, p50, p99);
+    bench_json_record_begin(json);
+    bench_json_str(json, "workload", workload);
+    bench_json_int(json, "available", 1);
+    bench_json_int(json, "count", (uint64_t)count);
+    bench_json_num(json, "per_s", rate);
+    bench_json_num(json, "latency_us_p50", p50);
+    bench_json_num(json, "latency_us_p99", p99);
+    if (ttfb != NULL) {
+        printf("  (first response p50 %.1f us)", bench_percentile(ttfb, count, 50) * 1e6);
+        bench_json_num(json, "ttfb_us_p50", bench_percentile(ttfb, count, 50) * 1e6);
+        bench_json_num(json, "ttfb_us_p99", bench_percentile(ttfb, count, 99) * 1e6);
+    }
+    printf("\n");
+    bench_json_record_end(json);
+}
+
+static int run_setup(quic_env *env, bench_json *json, size_t count) {
+    double *samples = calloc(count, sizeof(*samples));
+    double *ttfb = calloc(count, sizeof(*ttfb));
+    unsigned char request = 1;
+    int ok = samples != NULL && ttfb != NULL;
+
+    for (size_t i = 0; i < count && ok; i++) {
+        double t0 = bench_now();
+        int fd;
+        SSL *ssl = client_connect(env, &fd);
+
+        samples[i] = bench_now() - t0;
+        /*
+         * A first request/response per connection: time to first byte, and
+         * the server has served the connection before the client closes
+         * it (a stream-less close can go unnoticed by a server blocked in
+         * SSL_accept_stream until the idle timeout).
+         */
+        ok = ssl != NULL && stream_roundtrip(ssl, &request, 1);
+        ttfb[i] = bench_now() - t0;
+        if (!ok)
+            fprintf(stderr, "ERROR: QUIC connection %zu failed\n", i);
+        client_close(ssl, fd);
+    }
+    if (ok)
+        report_latency(json, "setup", count, samples, ttfb, "conn");
+    free(samples);
+    free(ttfb);
+    return ok;
+}
+
+static int run_requests(quic_env *env, bench_json *json, size_t count) {
+    unsigned char request[REQUEST_SIZE];
+    double *samples = calloc(count, sizeof(*samples));
+    int fd, ok = 1;
+    SSL *conn;
+
+    if (samples == NULL)
+        return 0;
+    memset(request, 0x5a, sizeof(request));
+    if ((conn = client_connect(env, &fd)) == NULL) {
+        client_close(conn, fd);
+        free(samples);
+        return 0;
+    }
+    for (size_t i = 0; i < count && ok; i++) {
+        double t0 = bench_now();
+
+        ok = stream_roundtrip(conn, request, sizeof(request));
+        samples[i] = bench_now() - t0;
+    }
+    if (ok)
+        report_latency(json, "request", count, samples, NULL, "streams");
+    client_close(conn, fd);
+    free(samples);
+    return ok;
+}
+
+static int run_bulk(quic_env *env, bench_json *json, size_t total) {
+    static unsigned char chunk[CHUNK_SIZE];
+    double start, elapsed, mbps;
+    int fd, ok;
+    SSL *conn;
+
+    memset(chunk, 0xa5, sizeof(chunk));
+    if ((conn = client_connect(env, &fd)) == NULL) {
+        client_close(conn, fd);
+        return 0;
+    }
+    start = bench_now();
+    ok = stream_roundtrip(conn, chunk, total);
+    elapsed = bench_now() - start;
+    client_close(conn, fd);
+    if (!ok)
+        return 0;
+
+    mbps = (double)total / elapsed / 1e6;
+    printf("  %-8s %10.1f MB/s  (%zu MiB on one stream)\n", "bulk", mbps, total >> 20);
+    bench_json_record_begin(json);
+    bench_json_str(json, "workload", "bulk");
+    bench_json_int(json, "available", 1);
+    bench_json_int(json, "bytes", (uint64_t)total);
+    bench_json_num(json, "mb_per_s", mbps);
+    bench_json_num(json, "gbit_per_s", mbps * 8.0 / 1e3);
+    bench_json_record_end(json);
+    return 1;
+}
+
+static int run_quic(bench_json *json, int quick) {
+    quic_env env = {0};
+    EVP_PKEY *pkey = NULL;
+    X509 *cert = NULL;
+    int failures = 0;
+
+    env.server_fd = -1;
+    if (bench_tls_make_cert("EC", &pkey, &cert) != 0)
+        return 1;
+    if (!start_server(&env, pkey, cert)) {
+        fprintf(stderr, "ERROR: Cannot start the QUIC listener\n");
+        ERR_print_errors_fp(stderr);
+        failures++;
+        goto end;
+    }
+
+    printf("\n");
+    failures += !run_setup(&env, json, quick ? 20 : MAX_SAMPLES);
+    failures += !run_requests(&env, json, quick ? 50 : MAX_SAMPLES);
+    failures += !run_bulk(&env, json, (size_t)(quick ? 4 : 64) << 20);
+    if (failures > 0)
+        ERR_print_errors_fp(stderr);
+
+end:
+    stop_server(&env);
+    if (atomic_load(&server_failed)) {
+        fprintf(stderr, "ERROR: QUIC server side failed\n");
+        failures++;
+    }
+    EVP_PKEY_free(pkey);
+    X509_free(cert);
+    return failures;
+}
+
+#endif
+
+int main(int argc, char **argv) {
+    bench_options opts;
+    bench_json json;
+    int failures = 0;
+
+    if (bench_parse_args(argc, argv, "bench_quic.json", &opts) != argc) {
+        bench_usage(argv[0]);
+        return 2;
+    }
+
+    printf("=================================\n");
+    printf("OpenSSL QUIC Loopback Benchmark\n");
+    printf("=================================\n");
+    printf("OpenSSL version: %s\n", OpenSSL_version(OPENSSL_VERSION));
+
+    if (bench_json_begin(&json, &opts, "quic") != 0)
+        return 1;
+
+#if OPENSSL_VERSION_NUMBER >= 0x30500000L && !defined(OPENSSL_NO_QUIC)
+    failures = run_quic(&json, opts.quick);
+#else
+    /* Not a failure: the record is how pre-3.5 and no-quic builds show up */
+    printf("⚠ QUIC server API not available (OpenSSL < 3.5 or enable_quic=False)\n");
+    bench_json_record_begin(&json);
+    bench_json_str(&json, "workload", "quic");
+    bench_json_int(&json, "available", 0);
+    bench_json_record_end(&json);
+#endif
+
+    bench_json_end(&json);
+
+    printf("\n=================================\n");
+    if (failures == 0) {
+        printf("✅ QUIC benchmark completed (%s)\n", opts.json_path);
+        return 0;
+    }
+    printf("❌ %d benchmark(s) FAILED\n", failures);
+    return 1;
+}
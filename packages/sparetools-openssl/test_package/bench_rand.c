@@ -0,0 +1,284 @@
+#include <openssl/core_names.h>
+#include <openssl/crypto.h>
+#include <openssl/err.h>
+#include <openssl/evp.h>
+#include <openssl/provider.h>
+#include <openssl/rand.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "bench_common.h"
+
+/**
+ * DRBG throughput and contention benchmark
+ *
+ * Nonce and IV generation calls RAND_bytes on every record or packet.
+ * OpenSSL 3.x gives each thread its own public and private DRBG, both
+ * seeded from one shared primary DRBG, so concurrent callers should not
+ * contend. This measures that, with 16-byte (nonce) and 4 KiB requests,
+ * on 1..nproc threads, for each DRBG type the [random] section of
+ * openssl.cnf can select (CryptoConfigManager.set_random_settings):
+ *
+ * - RAND_bytes:      the per-thread public DRBG
+ * - RAND_priv_bytes: the per-thread private DRBG
+ * - shared:          one locked EVP_RAND_CTX for all threads, the
+ *                    contention per-thread DRBGs avoid
+ *
+ * Each DRBG type runs in its own OSSL_LIB_CTX set up with
+ * RAND_set_DRBG_type, as openssl.cnf would. Reported: requests/s, MB/s
+ * and efficiency (rate at N threads / N x the 1-thread rate).
+ *
+ * --max-threads N overrides the online CPU count as the upper bound.
+ */
+
+typedef struct {
+    const char *name;
+    const char *cipher;   /* CTR-DRBG */
+    const char *digest;   /* HASH-DRBG, HMAC-DRBG */
+} drbg_type;
+
+static const drbg_type drbg_types[] = {
+    {"CTR-DRBG", "AES-256-CTR", NULL},
+    {"HASH-DRBG", NULL, "SHA2-256"},
+    {"HMAC-DRBG", NULL, "SHA2-256"},
+};
+
+/*
+ * From 3.5 an HMAC-DRBG selected with RAND_set_DRBG_type (or [random])
+ * as the library's DRBG fails to instantiate ("error instantiating
+ * drbg"). crypto_config writes HASH-DRBG, the same digest, for those
+ * versions, and the bench reports the type as unavailable there.
+ */
+static int drbg_type_selectable(const drbg_type *t) {
+    return strcmp(t->name, "HMAC-DRBG") != 0 || OpenSSL_version_num() < 0x30500000L;
+}
+#define NUM_DRBG_TYPES (sizeof(drbg_types) / sizeof(drbg_types[0]))
+
+typedef enum {
+    API_PUBLIC,
+    API_PRIVATE,
+    API_SHARED
+} rand_api;
+
+static const char *api_names[] = {"RAND_bytes", "RAND_priv_bytes", "shared"};
+#define NUM_APIS 3
+
+static const size_t request_sizes[] = {16, 4096};
+#define NUM_SIZES (sizeof(request_sizes) / sizeof(request_sizes[0]))
+
+static atomic_int start_flag;
+static atomic_int stop_flag;
+
+typedef struct {
+    pthread_t thread;
+    OSSL_LIB_CTX *libctx;
+    EVP_RAND_CTX *shared;
+    rand_api api;
+    size_t size;
+    unsigned long long requests;
+    int failed;
+} thread_arg;
+
+static void *worker(void *p) {
+    thread_arg *arg = p;
+    unsigned char buf[4096];
+    int ok = 1;
+
+    while (!atomic_load(&start_flag))
+        ;
+    while (ok && !atomic_load(&stop_flag)) {
+        switch (arg->api) {
+        case API_PUBLIC:
+            ok = RAND_bytes_ex(arg->libctx, buf, arg->size, 0) == 1;
+            break;
+        case API_PRIVATE:
+            ok = RAND_priv_bytes_ex(arg->libctx, buf, arg->size, 0) == 1;
+            break;
+        default:
+            ok = EVP_RAND_generate(arg->shared, buf, arg->size, 0, 0, NULL, 0) == 1;
+            break;
+        }
+        arg->requests += ok;
+    }
+    arg->failed = !ok;
+    return NULL;
+}
+
+/* Requests per second, or a negative value on failure */
+static double run_threads(OSSL_LIB_CTX *libctx, EVP_RAND_CTX *shared, rand_api api, size_t size,
+                          int nthreads, double seconds) {
+    thread_arg *args = calloc((size_t)nthreads, sizeof(*args));
+    unsigned long long requests = 0;
+    double start, elapsed;
+    int failed = args == NULL, started = 0;
+
+    atomic_store(&start_flag, 0);
+    atomic_store(&stop_flag, 0);
+    for (int t = 0; !failed && t < nthreads; t++) {
+        args[t].libctx = libctx;
+        args[t].shared = shared;
+        args[t].api = api;
+        args[t].size = size;
+        if (pthread_create(&args[t].thread, NULL, worker, &args[t]) != 0) {
+            failed = 1;
+            break;
+        }
+        started++;
+    }
+
+    start = bench_now();
+    atomic_store(&start_flag, 1);
+    while (!failed && bench_now() - start < seconds)
+        usleep(1000);
+    atomic_store(&stop_flag, 1);
+
+    for (int t = 0; t < started; t++) {
+        pthread_join(args[t].thread, NULL);
+        requests += args[t].requests;
+        failed |= args[t].failed;
+    }
+    elapsed = bench_now() - start;
+    free(args);
+    return failed ? -1.0 : (double)requests / elapsed;
+}
+
+/* Library context whose DRBGs are all of type t, like a [random] section */
+static OSSL_LIB_CTX *make_libctx(const drbg_type *t, OSSL_PROVIDER **prov) {
+    OSSL_LIB_CTX *libctx = OSSL_LIB_CTX_new();
+
+    if (libctx == NULL || (*prov = OSSL_PROVIDER_load(libctx, "default")) == NULL
+        || !RAND_set_DRBG_type(libctx, t->name, NULL, t->cipher, t->digest)
+        /* First use instantiates the primary DRBG with the type above */
+        || RAND_get0_primary(libctx) == NULL) {
+        OSSL_LIB_CTX_free(libctx);
+        return NULL;
+    }
+    return libctx;
+}
+
+/* One locked DRBG of type t under the primary, shared by every thread */
+static EVP_RAND_CTX *make_shared(OSSL_LIB_CTX *libctx, const drbg_type *t) {
+    EVP_RAND *rand = EVP_RAND_fetch(libctx, t->name, NULL);
+    EVP_RAND_CTX *ctx = rand != NULL ? EVP_RAND_CTX_new(rand, RAND_get0_primary(libctx)) : NULL;
+    OSSL_PARAM params[3], *p = params;
+
+    if (t->cipher != NULL)
+        *p++ = OSSL_PARAM_construct_utf8_string(OSSL_DRBG_PARAM_CIPHER, (char *)t->cipher, 0);
+    if (t->digest != NULL)
+        *p++ = OSSL_PARAM_construct_utf8_string(OSSL_DRBG_PARAM_DIGEST, (char *)t->digest, 0);
+    if (strcmp(t->name, "HMAC-DRBG") == 0)
+        *p++ = OSSL_PARAM_construct_utf8_string(OSSL_DRBG_PARAM_MAC, "HMAC", 0);
+    *p = OSSL_PARAM_construct_end();
+    EVP_RAND_free(rand);
+    if (ctx == NULL || !EVP_RAND_enable_locking(ctx) || !EVP_RAND_instantiate(ctx, 0, 0, NULL, 0, params)) {
+        EVP_RAND_CTX_free(ctx);
+        return NULL;
+    }
+    return ctx;
+}
+
+/* 1, 2, 4, ... max_threads, then 0 */
+static int next_thread_count(int n, int max) {
+    if (n >= max)
+        return 0;
+    return n * 2 > max ? max : n * 2;
+}
+
+int main(int argc, char **argv) {
+    bench_options opts;
+    bench_json json;
+    int failures = 0, max_threads;
+    long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+    int argi = bench_parse_args(argc, argv, "bench_rand.json", &opts);
+
+    if (argi < 0)
+        return 2;
+    max_threads = ncpu > 0 ? (int)ncpu : 1;
+    for (; argi < argc; argi++) {
+        if (strcmp(argv[argi], "--max-threads") == 0 && argi + 1 < argc) {
+            max_threads = atoi(argv[++argi]);
+        } else {
+            fprintf(stderr, "Usage: %s [--quick] [--json PATH] [--max-threads N]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (max_threads < 1)
+        max_threads = 1;
+    if (opts.quick && max_threads > 4)
+        max_threads = 4;
+
+    printf("=================================\n");
+    printf("DRBG Throughput and Contention Benchmark\n");
+    printf("=================================\n");
+    printf("OpenSSL version: %s\n\n", OpenSSL_version(OPENSSL_VERSION));
+    if (bench_json_begin(&json, &opts, "rand") != 0)
+        return 1;
+
+    printf("  %-9s %-15s %5s %7s %14s %10s %10s\n", "DRBG", "API", "Bytes", "Threads", "requests/s", "MB/s",
+           "efficiency");
+    for (size_t d = 0; d < NUM_DRBG_TYPES; d++) {
+        const drbg_type *t = &drbg_types[d];
+        OSSL_PROVIDER *prov = NULL;
+        OSSL_LIB_CTX *libctx;
+        EVP_RAND_CTX *shared;
+
+        if (!drbg_type_selectable(t)) {
+            printf("  %-9s not selectable as the library DRBG in this version, skipping\n", t->name);
+            bench_json_record_begin(&json);
+            bench_json_str(&json, "drbg", t->name);
+            bench_json_int(&json, "available", 0);
+            bench_json_record_end(&json);
+            continue;
+        }
+        libctx = make_libctx(t, &prov);
+        shared = libctx != NULL ? make_shared(libctx, t) : NULL;
+        if (shared == NULL) {
+            printf("  %-9s not available, skipping\n", t->name);
+            ERR_print_errors_fp(stderr);
+            failures++;
+        }
+        for (int a = 0; shared != NULL && a < NUM_APIS; a++) {
+            for (size_t s = 0; s < NUM_SIZES; s++) {
+                double single = 0;
+
+                for (int threads = 1; threads != 0; threads = next_thread_count(threads, max_threads)) {
+                    double rate = run_threads(libctx, shared, (rand_api)a, request_sizes[s], threads,
+                                              opts.min_seconds);
+                    double efficiency;
+
+                    if (rate < 0) {
+                        printf("  %-9s %-15s %5zu %7d  FAILED\n", t->name, api_names[a], request_sizes[s],
+                               threads);
+                        failures++;
+                        break;
+                    }
+                    if (threads == 1)
+                        single = rate;
+                    efficiency = single > 0 ? rate / (single * threads) : 0.0;
+                    printf("  %-9s %-15s %5zu %7d %14.0f %10.1f %10.2f\n", t->name, api_names[a],
+                           request_sizes[s], threads, rate, rate * request_sizes[s] / 1e6, efficiency);
+                    bench_json_record_begin(&json);
+                    bench_json_str(&json, "drbg", t->name);
+                    bench_json_str(&json, "api", api_names[a]);
+                    bench_json_int(&json, "request_bytes", (uint64_t)request_sizes[s]);
+                    bench_json_int(&json, "threads", (uint64_t)threads);
+                    bench_json_num(&json, "requests_per_sec", rate);
+                    bench_json_num(&json, "mb_per_sec", rate * request_sizes[s] / 1e6);
+                    bench_json_num(&json, "efficiency", efficiency);
+                    bench_json_record_end(&json);
+                }
+            }
+        }
+        EVP_RAND_CTX_free(shared);
+        OSSL_PROVIDER_unload(prov);
+        OSSL_LIB_CTX_free(libctx);
+    }
+    bench_json_end(&json);
+
+    printf("\n%s\n", failures ? "✗ Some DRBG runs failed" : "✓ All DRBG runs completed");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,740 @@
+#include <openssl/err.h>
+#include <openssl/ssl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench_common.h"
+#include "bench_tls.h"
+
+/**
+ * Production traffic replay
+ *
+ * The other TLS benchmarks each sweep one dimension with everything else
+ * fixed; a deployment pays for its own mix instead. --profile FILE.json
+ * describes that mix as histograms (value -> weight, weights need not
+ * sum to 1):
+ *
+ *   {
+ *     "name": "edge",
+ *     "connections": 2000,
+ *     "resumption_ratio": 0.45,
+ *     "cipher_suites": {"TLS_AES_128_GCM_SHA256": 70, "TLS_CHACHA20_POLY1305_SHA256": 30},
+ *     "key_types": {"EC": 90, "RSA": 10},
+ *     "groups": {"X25519": 95, "P-256": 5},
+ *     "record_sizes": {"512": 40, "1400": 35, "16384": 25},
+ *     "connection_lifetimes": {"1": 50, "8": 40, "64": 10}
+ *   }
+ *
+ * key_types takes the bench_tls_make_cert names (EC, RSA, Ed25519, ...);
+ * record_sizes are application record bytes (1..16384); a connection's
+ * lifetime is the number of records the server sends before closing.
+ * groups defaults to X25519. Without --profile a built-in web-like mix
+ * is used.
+ *
+ * A plan of "connections" connections is drawn from the histograms up
+ * front (--seed N makes it reproducible) and replayed single-threaded
+ * over BIO pairs until min_seconds has passed, at least once. Resumed
+ * connections reuse a ticket made per (key type, suite) before timing.
+ * Reports connections/s and CPU per connection for the mix, the split
+ * between handshakes and record protection, and which suites, key types,
+ * groups and record sizes the time goes to (cpu_share), so an
+ * optimisation can be weighed against the traffic it will actually see.
+ */
+
+#define MAX_BINS 32
+#define MAX_NAME 64
+#define MAX_RECORD 16384
+#define DEFAULT_CONNECTIONS 1000
+#define QUICK_CONNECTIONS 50
+#define MAX_CONNECTIONS 1000000
+
+typedef struct {
+    char name[MAX_NAME];
+    double weight;
+    int value;            /* Numeric histograms: record_sizes, connection_lifetimes */
+    /* Filled in by the replay */
+    size_t count;
+    double seconds;
+} bin;
+
+typedef struct {
+    bin bins[MAX_BINS];
+    int n;
+    double total;
+} histogram;
+
+typedef struct {
+    char name[MAX_NAME];
+    int connections;
+    double resumption;
+    histogram suites, keys, groups, records, lifetimes;
+} profile;
+
+typedef struct {
+    unsigned char suite, key, group, resumed;
+    size_t first_record, records;   /* Into the plan's record bin indexes */
+} planned;
+
+typedef struct {
+    planned *conns;
+    unsigned char *records;         /* Bin in profile.records of each record */
+    size_t n, total_records;
+} plan;
+
+typedef struct {
+    SSL_CTX *client, *server;
+    EVP_PKEY *pkey;
+    X509 *cert;
+    SSL_SESSION *sessions[MAX_BINS]; /* Per suite */
+} key_setup;
+
+/* ---- Profile reader: one object of scalars and flat value -> weight objects ---- */
+
+typedef struct {
+    const char *p;
+    const char *err;
+} reader;
+
+static void skip_ws(reader *r) {
+    while (*r->p == ' ' || *r->p == '\t' || *r->p == '\n' || *r->p == '\r')
+        r->p++;
+}
+
+static int expect(reader *r, char c) {
+    skip_ws(r);
+    if (*r->p != c) {
+        r->err = "unexpected character";
+        return 0;
+    }
+    r->p++;
+    return 1;
+}
+
+/* Plain strings only: escapes are kept for \" \\ \/ and rejected otherwise */
+static int read_string(reader *r, char *out, size_t len) {
+    size_t n = 0;
+
+    if (!expect(r, '"'))
+        return 0;
+    while (*r->p != '"') {
+        char c = *r->p++;
+
+        if (c == '\0') {
+            r->err = "unterminated string";
+            return 0;
+        }
+        if (c == '\\') {
+            c = *r->p++;
+            if (c != '"' && c != '\\' && c != '/') {
+                r->err = "unsupported escape";
+                return 0;
+            }
+        }
+        if (n + 1 >= len) {
+            r->err = "string too long";
+            return 0;
+        }
+        out[n++] = c;
+    }
+    r->p++;
+    out[n] = '\0';
+    return 1;
+}
+
+static int read_number(reader *r, double *out) {
+    char *end;
+
+    skip_ws(r);
+    *out = strtod(r->p, &end);
+    if (end == r->p) {
+        r->err = "expected a number";
+        return 0;
+    }
+    r->p = end;
+    return 1;
+}
+
+static int read_histogram(reader *r, histogram *h, int numeric) {
+    h->n = 0;
+    h->total = 0.0;
+    if (!expect(r, '{'))
+        return 0;
+    skip_ws(r);
+    if (*r->p == '}') {
+        r->p++;
+        return 1;
+    }
+    do {
+        bin *b;
+
+        if (h->n == MAX_BINS) {
+            r->err = "too many histogram entries";
+            return 0;
+        }
+        b = &h->bins[h->n];
+        memset(b, 0, sizeof(*b));
+        if (!read_string(r, b->name, sizeof(b->name)) || !expect(r, ':') || !read_number(r, &b->weight))
+            return 0;
+        if (b->weight < 0) {
+            r->err = "negative weight";
+            return 0;
+        }
+        if (numeric) {
+            char *end;
+            long v = strtol(b->name, &end, 10);
+
+            if (*end != '\0' || v < 1 || v > 1000000) {
+                r->err = "expected a positive integer key";
+                return 0;
+            }
+            b->value = (int)v;
+        }
+        if (b->weight > 0) {
+            h->total += b->weight;
+            h->n++;
+        }
+        skip_ws(r);
+    } while (*r->p == ',' && r->p++);
+    return expect(r, '}');
+}
+
+static int parse_profile(const char *text, profile *prof) {
+    reader r = {text, NULL};
+    char key[MAX_NAME];
+
+    if (!expect(&r, '{'))
+        goto err;
+    skip_ws(&r);
+    if (*r.p == '}')
+        r.p++;
+    else {
+        do {
+            if (!read_string(&r, key, sizeof(key)) || !expect(&r, ':'))
+                goto err;
+            if (strcmp(key, "name") == 0) {
+                if (!read_string(&r, prof->name, sizeof(prof->name)))
+                    goto err;
+            } else if (strcmp(key, "connections") == 0 || strcmp(key, "resumption_ratio") == 0) {
+                double v;
+
+                if (!read_number(&r, &v))
+                    goto err;
+                if (key[0] == 'c')
+                    prof->connections = (int)v;
+                else
+                    prof->resumption = v;
+            } else if (strcmp(key, "cipher_suites") == 0) {
+                if (!read_histogram(&r, &prof->suites, 0))
+                    goto err;
+            } else if (strcmp(key, "key_types") == 0) {
+                if (!read_histogram(&r, &prof->keys, 0))
+                    goto err;
+            } else if (strcmp(key, "groups") == 0) {
+                if (!read_histogram(&r, &prof->groups, 0))
+                    goto err;
+            } else if (strcmp(key, "record_sizes") == 0) {
+                if (!read_histogram(&r, &prof->records, 1))
+                    goto err;
+            } else if (strcmp(key, "connection_lifetimes") == 0) {
+                if (!read_histogram(&r, &prof->lifetimes, 1))
+                    goto err;
+            } else {
+                fprintf(stderr, "ERROR: Unknown profile field \"%s\"\n", key);
+                return 0;
+            }
+            skip_ws(&r);
+        } while (*r.p == ',' && r.p++);
+        if (!expect(&r, '}'))
+            goto err;
+    }
+    skip_ws(&r);
+    if (*r.p != '\0') {
+        r.err = "trailing data";
+        goto err;
+    }
+    return 1;
+err:
+    fprintf(stderr, "ERROR: Invalid profile at offset %ld: %s\n", (long)(r.p - text), r.err);
+    return 0;
+}
+
+static int load_profile(const char *path, profile *prof) {
+    FILE *fp = fopen(path, "rb");
+    char *text = NULL;
+    long len;
+    int ok = 0;
+
+    if (fp == NULL) {
+        fprintf(stderr, "ERROR: Cannot open profile %s\n", path);
+        return 0;
+    }
+    if (fseek(fp, 0, SEEK_END) == 0 && (len = ftell(fp)) >= 0 && fseek(fp, 0, SEEK_SET) == 0
+        && (text = malloc((size_t)len + 1)) != NULL && fread(text, 1, (size_t)len, fp) == (size_t)len) {
+        text[len] = '\0';
+        ok = parse_profile(text, prof);
+    } else {
+        fprintf(stderr, "ERROR: Cannot read profile %s\n", path);
+    }
+    free(text);
+    fclose(fp);
+    return ok;
+}
+
+static void add_bin(histogram *h, const char *name, double weight) {
+    bin *b = &h->bins[h->n++];
+
+    memset(b, 0, sizeof(*b));
+    snprintf(b->name, sizeof(b->name), "%s", name);
+    b->weight = weight;
+    b->value = atoi(name);
+    h->total += weight;
+}
+
+/* A browser-facing HTTPS front end: mostly short keep-alive connections */
+static void default_profile(profile *prof) {
+    snprintf(prof->name, sizeof(prof->name), "default");
+    prof->resumption = 0.4;
+    add_bin(&prof->suites, "TLS_AES_128_GCM_SHA256", 60);
+    add_bin(&prof->suites, "TLS_AES_256_GCM_SHA384", 25);
+    add_bin(&prof->suites, "TLS_CHACHA20_POLY1305_SHA256", 15);
+    add_bin(&prof->keys, "EC", 85);
+    add_bin(&prof->keys, "RSA", 15);
+    add_bin(&prof->groups, "X25519", 90);
+    add_bin(&prof->groups, "P-256", 10);
+    add_bin(&prof->records, "512", 35);
+    add_bin(&prof->records, "1400", 25);
+    add_bin(&prof->records, "4096", 15);
+    add_bin(&prof->records, "16384", 25);
+    add_bin(&prof->lifetimes, "1", 50);
+    add_bin(&prof->lifetimes, "4", 30);
+    add_bin(&prof->lifetimes, "32", 20);
+}
+
+static int check_profile(profile *prof) {
+    if (prof->groups.n == 0)
+        add_bin(&prof->groups, "X25519", 1);
+    if (prof->suites.n == 0 || prof->keys.n == 0 || prof->records.n == 0 || prof->lifetimes.n == 0) {
+        fprintf(stderr, "ERROR: Profile needs cipher_suites, key_types, record_sizes and connection_lifetimes\n");
+        return 0;
+    }
+    for (int i = 0; i < prof->records.n; i++) {
+        if (prof->records.bins[i].value > MAX_RECORD) {
+            fprintf(stderr, "ERROR: Record size %d exceeds %d\n", prof->records.bins[i].value, MAX_RECORD);
+            return 0;
+        }
+    }
+    if (prof->resumption < 0 || prof->resumption > 1) {
+        fprintf(stderr, "ERROR: resumption_ratio must be within 0..1\n");
+        return 0;
+    }
+    if (prof->connections < 1 || prof->connections > MAX_CONNECTIONS) {
+        fprintf(stderr, "ERROR: connections must be within 1..%d\n", MAX_CONNECTIONS);
+        return 0;
+    }
+    return 1;
+}
+
+/* ---- Plan ---- */
+
+/* splitmix64: small, seedable and good enough to sample histograms */
+static uint64_t next_random(uint64_t *state) {
+    uint64_t z = (*state += 0x9E3779B97F4A7C15ULL);
+
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+static double next_unit(uint64_t *state) {
+    return (double)(next_random(state) >> 11) / 9007199254740992.0;
+}
+
+static unsigned char sample(const histogram *h, uint64_t *state) {
+    double x = next_unit(state) * h->total;
+    int i;
+
+    for (i = 0; i < h->n - 1; i++) {
+        x -= h->bins[i].weight;
+        if (x < 0)
+            break;
+    }
+    return (unsigned char)i;
+}
+
+static int make_plan(const profile *prof, uint64_t seed, plan *pl) {
+    uint64_t state = seed;
+    size_t cap = 0;
+
+    memset(pl, 0, sizeof(*pl));
+    if ((pl->conns = calloc((size_t)prof->connections, sizeof(*pl->conns))) == NULL)
+        return 0;
+    pl->n = (size_t)prof->connections;
+    for (size_t c = 0; c < pl->n; c++) {
+        planned *conn = &pl->conns[c];
+
+        conn->suite = sample(&prof->suites, &state);
+        conn->key = sample(&prof->keys, &state);
+        conn->group = sample(&prof->groups, &state);
+        conn->resumed = next_unit(&state) < prof->resumption;
+        conn->first_record = pl->total_records;
+        conn->records = (size_t)prof->lifetimes.bins[sample(&prof->lifetimes, &state)].value;
+        if (pl->total_records + conn->records > cap) {
+            size_t want = cap ? cap : 1024;
+            unsigned char *grown;
+
+            while (want < pl->total_records + conn->records)
+                want *= 2;
+            if ((grown = realloc(pl->records, want)) == NULL)
+                return 0;
+            pl->records = grown;
+            cap = want;
+        }
+        for (size_t i = 0; i < conn->records; i++)
+            pl->records[pl->total_records++] = sample(&prof->records, &state);
+    }
+    return 1;
+}
+
+static void free_plan(plan *pl) {
+    free(pl->conns);
+    free(pl->records);
+}
+
+/* ---- Replay ---- */
+
+static int read_all(SSL *ssl, unsigned char *buf, size_t len) {
+    size_t done = 0, n;
+
+    while (done < len) {
+        if (!SSL_read_ex(ssl, buf + done, len - done, &n))
+            return 0;
+        done += n;
+    }
+    return 1;
+}
+
+static int connect_pair(const profile *prof, key_setup *ks, int suite, int group, SSL_SESSION *session,
+                        SSL **client, SSL **server) {
+    if (bench_tls_make_ssl_pair(ks->client, ks->server, client, server) != 0)
+        return 0;
+    if (!SSL_set_ciphersuites(*client, prof->suites.bins[suite].name)
+        || !SSL_set1_groups_list(*client, prof->groups.bins[group].name)
+        || (session != NULL && !SSL_set_session(*client, session))
+        || !bench_tls_handshake(*client, *server)) {
+        bench_tls_free_pair(*client, *server);
+        return 0;
+    }
+    /* Tickets land before the first record, so a 16 KiB record always fits the BIO pair */
+    bench_tls_drain(*client);
+    return 1;
+}
+
+/**
+ * Certificates, SSL_CTX pairs and one resumable session per (key type,
+ * suite), all outside the timed replay. Also checks that each suite and
+ * group is really negotiated.
+ */
+static int setup_keys(const profile *prof, key_setup *keys) {
+    char suites[MAX_BINS * MAX_NAME];
+    size_t off = 0;
+
+    suites[0] = '\0';
+    for (int s = 0; s < prof->suites.n; s++)
+        off += (size_t)snprintf(suites + off, sizeof(suites) - off, "%s%s", s ? ":" : "",
+                                prof->suites.bins[s].name);
+    for (int k = 0; k < prof->keys.n; k++) {
+        key_setup *ks = &keys[k];
+        SSL *client, *server;
+
+        if (bench_tls_make_cert(prof->keys.bins[k].name, &ks->pkey, &ks->cert) != 0
+            || bench_tls_make_ctx_pair(ks->pkey, ks->cert, &ks->client, &ks->server) != 0)
+            return 0;
+        /* The server accepts every suite in the profile (CCM is off by default) */
+        if (!SSL_CTX_set_ciphersuites(ks->server, suites)) {
+            fprintf(stderr, "ERROR: Unsupported cipher suites: %s\n", suites);
+            return 0;
+        }
+        for (int s = 0; s < prof->suites.n; s++) {
+            const char *name = prof->suites.bins[s].name;
+
+            if (!connect_pair(prof, ks, s, 0, NULL, &client, &server)) {
+                fprintf(stderr, "ERROR: %s with %s failed\n", name, prof->keys.bins[k].name);
+                return 0;
+            }
+            if (strcmp(SSL_CIPHER_get_name(SSL_get_current_cipher(client)), name) != 0) {
+                fprintf(stderr, "ERROR: %s was not negotiated\n", name);
+                bench_tls_free_pair(client, server);
+                return 0;
+            }
+            ks->sessions[s] = SSL_get1_session(client);
+            bench_tls_free_pair(client, server);
+            if (ks->sessions[s] == NULL || !SSL_SESSION_is_resumable(ks->sessions[s])) {
+                fprintf(stderr, "ERROR: No resumable session for %s\n", name);
+                return 0;
+            }
+        }
+    }
+    for (int g = 0; g < prof->groups.n; g++) {
+        SSL *client, *server;
+
+        if (!connect_pair(prof, &keys[0], 0, g, NULL, &client, &server)) {
+            fprintf(stderr, "ERROR: Group %s failed\n", prof->groups.bins[g].name);
+            return 0;
+        }
+        bench_tls_free_pair(client, server);
+    }
+    return 1;
+}
+
+static void free_keys(const profile *prof, key_setup *keys) {
+    for (int k = 0; k < prof->keys.n; k++) {
+        for (int s = 0; s < prof->suites.n; s++)
+            SSL_SESSION_free(keys[k].sessions[s]);
+        SSL_CTX_free(keys[k].client);
+        SSL_CTX_free(keys[k].server);
+        X509_free(keys[k].cert);
+        EVP_PKEY_free(keys[k].pkey);
+    }
+}
+
+typedef struct {
+    size_t connections, full, resumed, resume_missed, records;
+    uint64_t bytes;
+    double elapsed, cpu, handshake, bulk;
+    double full_seconds, resumed_seconds;
+} totals;
+
+static int replay_one(profile *prof, key_setup *keys, const plan *pl, const planned *conn,
+                      const unsigned char *payload, unsigned char *buf, totals *t) {
+    key_setup *ks = &keys[conn->key];
+    SSL *client, *server;
+    double t0 = bench_now(), t1, t2, conn_seconds;
+    size_t written;
+    int reused;
+
+    if (!connect_pair(prof, ks, conn->suite, conn->group, conn->resumed ? ks->sessions[conn->suite] : NULL,
+                      &client, &server))
+        return 0;
+    t1 = bench_now();
+    reused = SSL_session_reused(client);
+    for (size_t i = 0; i < conn->records; i++) {
+        bin *rb = &prof->records.bins[pl->records[conn->first_record + i]];
+        double r0 = bench_now();
+
+        if (!SSL_write_ex(server, payload, (size_t)rb->value, &written)
+            || !read_all(client, buf, (size_t)rb->value)) {
+            bench_tls_free_pair(client, server);
+            return 0;
+        }
+        rb->seconds += bench_now() - r0;
+        rb->count++;
+        t->bytes += (uint64_t)rb->value;
+    }
+    t->records += conn->records;
+    bench_tls_free_pair(client, server);
+    t2 = bench_now();
+
+    /* Setup, handshake and teardown count as handshake time */
+    conn_seconds = t2 - t0;
+    t->handshake += conn_seconds;
+    if (reused) {
+        t->resumed++;
+        t->resumed_seconds += t1 - t0;
+    } else {
+        t->full++;
+        t->full_seconds += t1 - t0;
+        if (conn->resumed)
+            t->resume_missed++;
+    }
+    prof->suites.bins[conn->suite].count++;
+    prof->suites.bins[conn->suite].seconds += conn_seconds;
+    prof->keys.bins[conn->key].count++;
+    prof->keys.bins[conn->key].seconds += conn_seconds;
+    prof->groups.bins[conn->group].count++;
+    prof->groups.bins[conn->group].seconds += conn_seconds;
+    t->connections++;
+    return 1;
+}
+
+static int replay(profile *prof, key_setup *keys, const plan *pl, double min_seconds, totals *t) {
+    unsigned char *payload = calloc(1, MAX_RECORD), *buf = malloc(MAX_RECORD);
+    double start, cpu_start;
+    int ok = payload != NULL && buf != NULL;
+
+    memset(t, 0, sizeof(*t));
+    start = bench_now();
+    cpu_start = bench_cpu_now();
+    do {
+        for (size_t c = 0; ok && c < pl->n; c++)
+            ok = replay_one(prof, keys, pl, &pl->conns[c], payload, buf, t);
+    } while (ok && bench_now() - start < min_seconds);
+    t->elapsed = bench_now() - start;
+    t->cpu = bench_cpu_now() - cpu_start;
+    /* Record time is measured per record; the rest of each connection is handshake */
+    for (int r = 0; r < prof->records.n; r++)
+        t->bulk += prof->records.bins[r].seconds;
+    t->handshake -= t->bulk;
+    free(payload);
+    free(buf);
+    return ok;
+}
+
+/* ---- Report ---- */
+
+static void report_bins(bench_json *json, const char *scope, const histogram *h, const char *unit,
+                        double measured) {
+    for (int i = 0; i < h->n; i++) {
+        const bin *b = &h->bins[i];
+        double us = b->count ? 1e6 * b->seconds / (double)b->count : 0.0;
+        double share = measured > 0 ? b->seconds / measured : 0.0;
+
+        printf("  %-14s %-30s %9zu %12.2f %8.1f%%\n", scope, b->name, b->count, us, 100.0 * share);
+        bench_json_record_begin(json);
+        bench_json_str(json, "scope", scope);
+        bench_json_str(json, "value", b->name);
+        bench_json_str(json, "per", unit);
+        bench_json_int(json, "count", (uint64_t)b->count);
+        bench_json_num(json, "weight", h->total > 0 ? b->weight / h->total : 0.0);
+        bench_json_num(json, "us", us);
+        bench_json_num(json, "cpu_share", share);
+        bench_json_record_end(json);
+    }
+}
+
+static void report_mode(bench_json *json, const char *mode, size_t count, double seconds, double measured) {
+    double us = count ? 1e6 * seconds / (double)count : 0.0;
+    double share = measured > 0 ? seconds / measured : 0.0;
+
+    printf("  %-14s %-30s %9zu %12.2f %8.1f%%\n", "handshake", mode, count, us, 100.0 * share);
+    bench_json_record_begin(json);
+    bench_json_str(json, "scope", "handshake");
+    bench_json_str(json, "value", mode);
+    bench_json_str(json, "per", "handshake");
+    bench_json_int(json, "count", (uint64_t)count);
+    bench_json_num(json, "us", us);
+    bench_json_num(json, "cpu_share", share);
+    bench_json_record_end(json);
+}
+
+int main(int argc, char **argv) {
+    bench_options opts;
+    bench_json json;
+    profile prof;
+    plan pl;
+    totals t;
+    key_setup keys[MAX_BINS];
+    const char *profile_path = NULL;
+    uint64_t seed = 1;
+    int connections = 0, ok;
+    int argi = bench_parse_args(argc, argv, "bench_replay.json", &opts);
+
+    if (argi < 0)
+        return 2;
+    for (; argi < argc; argi++) {
+        if (strcmp(argv[argi], "--profile") == 0 && argi + 1 < argc) {
+            profile_path = argv[++argi];
+        } else if (strcmp(argv[argi], "--seed") == 0 && argi + 1 < argc) {
+            seed = strtoull(argv[++argi], NULL, 10);
+        } else if (strcmp(argv[argi], "--connections") == 0 && argi + 1 < argc) {
+            connections = atoi(argv[++argi]);
+        } else {
+            fprintf(stderr, "Usage: %s [--quick] [--json PATH] [--profile FILE.json] [--seed N] [--connections N]\n",
+                    argv[0]);
+            return 2;
+        }
+    }
+
+    memset(&prof, 0, sizeof(prof));
+    memset(keys, 0, sizeof(keys));
+    if (profile_path != NULL) {
+        snprintf(prof.name, sizeof(prof.name), "custom");
+        if (!load_profile(profile_path, &prof))
+            return 2;
+    } else {
+        default_profile(&prof);
+    }
+    if (prof.connections == 0)
+        prof.connections = DEFAULT_CONNECTIONS;
+    if (connections > 0)
+        prof.connections = connections;
+    if (opts.quick && prof.connections > QUICK_CONNECTIONS)
+        prof.connections = QUICK_CONNECTIONS;
+    if (!check_profile(&prof))
+        return 2;
+
+    printf("=================================\n");
+    printf("Traffic Replay Benchmark\n");
+    printf("=================================\n");
+    printf("OpenSSL version: %s\n", OpenSSL_version(OPENSSL_VERSION));
+    printf("Profile: %s (%d connections, resumption %.0f%%, seed %llu)\n\n", prof.name, prof.connections,
+           100.0 * prof.resumption, (unsigned long long)seed);
+
+    if (!make_plan(&prof, seed, &pl)) {
+        fprintf(stderr, "ERROR: Out of memory for the connection plan\n");
+        free_plan(&pl);
+        return 1;
+    }
+    if (!setup_keys(&prof, keys)) {
+        ERR_print_errors_fp(stderr);
+        free_keys(&prof, keys);
+        free_plan(&pl);
+        return 1;
+    }
+    ok = replay(&prof, keys, &pl, opts.min_seconds, &t);
+    if (!ok) {
+        fprintf(stderr, "ERROR: Replay failed after %zu connections\n", t.connections);
+        ERR_print_errors_fp(stderr);
+    }
+
+    if (ok && bench_json_begin(&json, &opts, "replay") == 0) {
+        double measured = t.handshake + t.bulk;
+        double us_conn = 1e6 * t.elapsed / (double)t.connections;
+        double mb_per_s = t.bulk > 0 ? (double)t.bytes / t.bulk / 1e6 : 0.0;
+
+        printf("  Connections:  %zu (%zu full, %zu resumed, %zu resumptions rejected)\n", t.connections, t.full,
+               t.resumed, t.resume_missed);
+        printf("  Rate:         %.0f connections/s, %.2f CPU us/connection\n", (double)t.connections / t.elapsed,
+               1e6 * t.cpu / (double)t.connections);
+        printf("  Handshakes:   %.1f%% of the time\n", measured > 0 ? 100.0 * t.handshake / measured : 0.0);
+        printf("  Records:      %zu, %.1f MB at %.1f MB/s\n\n", t.records, (double)t.bytes / 1e6, mb_per_s);
+
+        bench_json_record_begin(&json);
+        bench_json_str(&json, "scope", "total");
+        bench_json_str(&json, "value", prof.name);
+        bench_json_str(&json, "per", "connection");
+        bench_json_int(&json, "count", (uint64_t)t.connections);
+        bench_json_int(&json, "seed", seed);
+        bench_json_num(&json, "us", us_conn);
+        bench_json_num(&json, "connections_per_sec", (double)t.connections / t.elapsed);
+        bench_json_num(&json, "cpu_us_per_connection", 1e6 * t.cpu / (double)t.connections);
+        bench_json_num(&json, "handshake_share", measured > 0 ? t.handshake / measured : 0.0);
+        bench_json_num(&json, "bulk_share", measured > 0 ? t.bulk / measured : 0.0);
+        bench_json_int(&json, "full_handshakes", (uint64_t)t.full);
+        bench_json_int(&json, "resumed_handshakes", (uint64_t)t.resumed);
+        bench_json_int(&json, "resumptions_rejected", (uint64_t)t.resume_missed);
+        bench_json_num(&json, "resumption_ratio", (double)t.resumed / (double)t.connections);
+        bench_json_num(&json, "profile_resumption_ratio", prof.resumption);
+        bench_json_int(&json, "records", (uint64_t)t.records);
+        bench_json_int(&json, "bytes", t.bytes);
+        bench_json_num(&json, "bulk_mb_per_sec", mb_per_s);
+        bench_json_record_end(&json);
+
+        printf("  %-14s %-30s %9s %12s %9s\n", "Scope", "Value", "Count", "us each", "share");
+        report_mode(&json, "full", t.full, t.full_seconds, measured);
+        report_mode(&json, "resumed", t.resumed, t.resumed_seconds, measured);
+        report_bins(&json, "cipher_suite", &prof.suites, "connection", measured);
+        report_bins(&json, "key_type", &prof.keys, "connection", measured);
+        report_bins(&json, "group", &prof.groups, "connection", measured);
+        report_bins(&json, "record_size", &prof.records, "record", measured);
+        bench_json_end(&json);
+    } else {
+        ok = 0;
+    }
+
+    free_keys(&prof, keys);
+    free_plan(&pl);
+    printf("\n%s\n", ok ? "✓ Traffic replay completed" : "✗ Traffic replay failed");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,559 @@
+#define _GNU_SOURCE
+
+#include <openssl/err.h>
+#include <openssl/ssl.h>
+#include <arpa/inet.h>
+#include <dlfcn.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "bench_common.h"
+#include "bench_tls.h"
+
+/**
+ * Server architecture scaling benchmark
+ *
+ * Measures TLS 1.3 full-handshake throughput of N server workers on TCP
+ * loopback for three architectures:
+ *
+ * - shared-ctx:     N threads, one SSL_CTX
+ * - ctx-per-thread: N threads, each with its own SSL_CTX
+ * - processes:      N forked processes (the SSL_CTX is created before the
+ *                   fork, as a pre-forking server would)
+ *
+ * Every worker owns one SO_REUSEPORT listener on the same port, so the
+ * kernel spreads connections the same way in all modes and only what the
+ * workers share differs. Load comes from a separate forked process with
+ * --clients-per-worker (default 2) client threads per worker, so client
+ * work never contends with server locks. Worker counts run 1..nproc
+ * (doubling, --max-workers N to override).
+ *
+ * Lock-wait time is measured by interposing pthread_mutex_lock and
+ * pthread_rwlock_rdlock/wrlock: an acquisition that fails its trylock is
+ * counted as contended and the time spent blocking in the real call is
+ * added up per worker. Only server workers are counted. Records carry
+ * lock acquisitions, contended acquisitions and wait time per handshake,
+ * plus lock_wait_share: the fraction of the workers' wall time spent
+ * waiting.
+ */
+
+#define MAX_WORKERS 256
+
+typedef enum {
+    MODE_SHARED_CTX,
+    MODE_CTX_PER_THREAD,
+    MODE_PROCESSES
+} server_mode;
+
+static const char *mode_names[] = {"shared-ctx", "ctx-per-thread", "processes"};
+
+/* ---- pthread lock interposition ---- */
+
+static int (*real_mutex_lock)(pthread_mutex_t *);
+static int (*real_rwlock_rdlock)(pthread_rwlock_t *);
+static int (*real_rwlock_wrlock)(pthread_rwlock_t *);
+
+typedef struct {
+    unsigned long long acquisitions;
+    unsigned long long contended;
+    double wait_seconds;
+} lock_stats;
+
+static _Thread_local lock_stats thread_locks;
+
+static int resolve_locks(void) {
+    if (real_mutex_lock == NULL) {
+        *(void **)&real_mutex_lock = dlsym(RTLD_NEXT, "pthread_mutex_lock");
+        *(void **)&real_rwlock_rdlock = dlsym(RTLD_NEXT, "pthread_rwlock_rdlock");
+        *(void **)&real_rwlock_wrlock = dlsym(RTLD_NEXT, "pthread_rwlock_wrlock");
+    }
+    return real_mutex_lock != NULL && real_rwlock_rdlock != NULL && real_rwlock_wrlock != NULL;
+}
+
+int pthread_mutex_lock(pthread_mutex_t *m) {
+    double start;
+    int ret;
+
+    if (!resolve_locks())
+        return EINVAL;
+    thread_locks.acquisitions++;
+    if (pthread_mutex_trylock(m) == 0)
+        return 0;
+    start = bench_now();
+    ret = real_mutex_lock(m);
+    thread_locks.wait_seconds += bench_now() - start;
+    thread_locks.contended++;
+    return ret;
+}
+
+int pthread_rwlock_rdlock(pthread_rwlock_t *l) {
+    double start;
+    int ret;
+
+    if (!resolve_locks())
+        return EINVAL;
+    thread_locks.acquisitions++;
+    if (pthread_rwlock_tryrdlock(l) == 0)
+        return 0;
+    start = bench_now();
+    ret = real_rwlock_rdlock(l);
+    thread_locks.wait_seconds += bench_now() - start;
+    thread_locks.contended++;
+    return ret;
+}
+
+int pthread_rwlock_wrlock(pthread_rwlock_t *l) {
+    double start;
+    int ret;
+
+    if (!resolve_locks())
+        return EINVAL;
+    thread_locks.acquisitions++;
+    if (pthread_rwlock_trywrlock(l) == 0)
+        return 0;
+    start = bench_now();
+    ret = real_rwlock_wrlock(l);
+    thread_locks.wait_seconds += bench_now() - start;
+    thread_locks.contended++;
+    return ret;
+}
+
+/* ---- server workers ---- */
+
+typedef struct {
+    unsigned long long handshakes;
+    lock_stats locks;
+    int failed;
+} worker_stats;
+
+typedef struct {
+    pthread_t thread;
+    int listen_fd;
+    int stop_fd;              /* Read end of the stop pipe; EOF means stop */
+    SSL_CTX *ctx;             /* NULL: build a private copy */
+    EVP_PKEY *pkey;
+    X509 *cert;
+    worker_stats stats;
+} worker_arg;
+
+/* Handshake, 1-byte request, 1-byte reply, then wait for the client to close */
+static int serve_conn(SSL_CTX *ctx, int fd) {
+    struct timeval timeout = {5, 0};
+    SSL *ssl = SSL_new(ctx);
+    unsigned char byte;
+    int one = 1, ok;
+
+    /* Handshake flights go out in several writes through the socket BIO */
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    ok = ssl != NULL && SSL_set_fd(ssl, fd) && SSL_accept(ssl) == 1
+         && SSL_read(ssl, &byte, 1) == 1 && SSL_write(ssl, &byte, 1) == 1;
+    if (ok)
+        SSL_read(ssl, &byte, 1);
+    ERR_clear_error();
+    SSL_free(ssl);
+    close(fd);
+    return ok;
+}
+
+static void *worker_main(void *varg) {
+    worker_arg *arg = varg;
+    SSL_CTX *ctx = arg->ctx, *own = NULL, *unused = NULL;
+    struct pollfd pfd[2];
+
+    if (ctx == NULL) {
+        if (bench_tls_make_ctx_pair(arg->pkey, arg->cert, &unused, &own) != 0) {
+            arg->stats.failed = 1;
+            return NULL;
+        }
+        SSL_CTX_free(unused);
+        ctx = own;
+    }
+    memset(&thread_locks, 0, sizeof(thread_locks));
+    pfd[0].fd = arg->listen_fd;
+    pfd[0].events = POLLIN;
+    pfd[1].fd = arg->stop_fd;
+    pfd[1].events = POLLIN;
+    for (;;) {
+        int fd;
+
+        if (poll(pfd, 2, -1) < 0) {
+            if (errno == EINTR)
+                continue;
+            arg->stats.failed = 1;
+            break;
+        }
+        if (pfd[1].revents != 0)
+            break;
+        if ((fd = accept(arg->listen_fd, NULL, NULL)) < 0)
+            continue;
+        if (serve_conn(ctx, fd))
+            arg->stats.handshakes++;
+    }
+    arg->stats.locks = thread_locks;
+    SSL_CTX_free(own);
+    return NULL;
+}
+
+/* ---- load generator ---- */
+
+typedef struct {
+    pthread_t thread;
+    SSL_CTX *ctx;
+    struct sockaddr_in addr;
+    double deadline;
+    unsigned long long handshakes;
+    int failed;
+} client_arg;
+
+static void *client_main(void *varg) {
+    client_arg *arg = varg;
+    /* Reset on close: no TIME_WAIT, so long runs do not exhaust ports */
+    struct linger linger = {1, 0};
+    int one = 1;
+
+    while (bench_now() < arg->deadline) {
+        int fd = socket(AF_INET, SOCK_STREAM, 0);
+        unsigned char byte = 1;
+        SSL *ssl = NULL;
+        int ok;
+
+        if (fd < 0) {
+            arg->failed = 1;
+            break;
+        }
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        setsockopt(fd, SOL_SOCKET, SO_LINGER, &linger, sizeof(linger));
+        ok = connect(fd, (struct sockaddr *)&arg->addr, sizeof(arg->addr)) == 0
+             && (ssl = SSL_new(arg->ctx)) != NULL && SSL_set_fd(ssl, fd) && SSL_connect(ssl) == 1
+             && SSL_write(ssl, &byte, 1) == 1 && SSL_read(ssl, &byte, 1) == 1;
+        SSL_free(ssl);
+        close(fd);
+        if (!ok) {
+            arg->failed = 1;
+            break;
+        }
+        arg->handshakes++;
+    }
+    return NULL;
+}
+
+typedef struct {
+    unsigned long long handshakes;
+    double elapsed;
+    int failed;
+} load_result;
+
+/* Runs in the forked load generator: wait for go, load, report, exit */
+static void load_main(SSL_CTX *ctx, const struct sockaddr_in *addr, int nclients, double seconds,
+                      int go_fd, int result_fd) {
+    client_arg *clients = calloc((size_t)nclients, sizeof(*clients));
+    load_result r = {0, 0.0, 0};
+    char go;
+    double start;
+    int started = 0;
+
+    if (clients == NULL || read(go_fd, &go, 1) != 1) {
+        r.failed = 1;
+        goto out;
+    }
+    start = bench_now();
+    for (int i = 0; i < nclients; i++) {
+        clients[i].ctx = ctx;
+        clients[i].addr = *addr;
+        clients[i].deadline = start + seconds;
+        if (pthread_create(&clients[i].thread, NULL, client_main, &clients[i]) != 0) {
+            r.failed = 1;
+            break;
+        }
+        started++;
+    }
+    for (int i = 0; i < started; i++) {
+        pthread_join(clients[i].thread, NULL);
+        r.handshakes += clients[i].handshakes;
+        r.failed |= clients[i].failed;
+    }
+    r.elapsed = bench_now() - start;
+
+out:
+    if (write(result_fd, &r, sizeof(r)) != (ssize_t)sizeof(r))
+        _exit(1);
+    free(clients);
+    _exit(0);
+}
+
+/* nworkers SO_REUSEPORT listeners on one loopback port */
+static int open_listeners(int *fds, int nworkers, struct sockaddr_in *addr) {
+    socklen_t len = sizeof(*addr);
+    int one = 1;
+
+    memset(addr, 0, sizeof(*addr));
+    addr->sin_family = AF_INET;
+    addr->sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    for (int i = 0; i < nworkers; i++) {
+        if ((fds[i] = socket(AF_INET, SOCK_STREAM, 0)) < 0
+            || setsockopt(fds[i], SOL_SOCKET, SO_REUSEPORT, &one, sizeof(one)) != 0
+            || bind(fds[i], (struct sockaddr *)addr, sizeof(*addr)) != 0
+            || listen(fds[i], 1024) != 0
+            || (i == 0 && getsockname(fds[i], (struct sockaddr *)addr, &len) != 0)) {
+            if (fds[i] >= 0)
+                close(fds[i]);
+            while (i-- > 0)
+                close(fds[i]);
+            return 0;
+        }
+    }
+    return 1;
+}
+
+typedef struct {
+    double handshakes_per_s;
+    double elapsed;
+    unsigned long long handshakes;
+    lock_stats locks;
+} run_result;
+
+static int run_mode(server_mode mode, int nworkers, int nclients, double seconds, EVP_PKEY *pkey, X509 *cert,
+                    SSL_CTX *server_ctx, SSL_CTX *client_ctx, run_result *out) {
+    worker_arg *workers = calloc((size_t)nworkers, sizeof(*workers));
+    pid_t *pids = calloc((size_t)nworkers, sizeof(*pids));
+    int listen_fds[MAX_WORKERS];
+    int go_pipe[2] = {-1, -1}, stop_pipe[2] = {-1, -1}, load_pipe[2] = {-1, -1}, stats_pipe[2] = {-1, -1};
+    struct sockaddr_in addr;
+    load_result load;
+    pid_t loader = -1;
+    int started = 0, ok = 1;
+
+    memset(out, 0, sizeof(*out));
+    if (workers == NULL || pids == NULL || !open_listeners(listen_fds, nworkers, &addr)) {
+        free(workers);
+        free(pids);
+        return 0;
+    }
+    if (pipe(go_pipe) != 0 || pipe(stop_pipe) != 0 || pipe(load_pipe) != 0 || pipe(stats_pipe) != 0) {
+        ok = 0;
+        goto out;
+    }
+
+    /* Fork while this process is still single-threaded */
+    if ((loader = fork()) == 0) {
+        close(stop_pipe[1]);
+        load_main(client_ctx, &addr, nclients, seconds, go_pipe[0], load_pipe[1]);
+    }
+    if (loader < 0) {
+        ok = 0;
+        goto out;
+    }
+
+    for (int i = 0; i < nworkers; i++) {
+        worker_arg *w = &workers[i];
+
+        w->listen_fd = listen_fds[i];
+        w->stop_fd = stop_pipe[0];
+        w->ctx = mode == MODE_CTX_PER_THREAD ? NULL : server_ctx;
+        w->pkey = pkey;
+        w->cert = cert;
+        if (mode == MODE_PROCESSES) {
+            if ((pids[i] = fork()) == 0) {
+                close(stop_pipe[1]);
+                worker_main(w);
+                if (write(stats_pipe[1], &w->stats, sizeof(w->stats)) != (ssize_t)sizeof(w->stats))
+                    _exit(1);
+                _exit(0);
+            }
+            if (pids[i] < 0) {
+                ok = 0;
+                break;
+            }
+        } else if (pthread_create(&w->thread, NULL, worker_main, w) != 0) {
+            ok = 0;
+            break;
+        }
+        started++;
+    }
+
+    if (ok && write(go_pipe[1], "g", 1) != 1)
+        ok = 0;
+    close(go_pipe[1]);
+    go_pipe[1] = -1;
+    if (read(load_pipe[0], &load, sizeof(load)) != (ssize_t)sizeof(load))
+        ok = 0;
+    else if (load.failed)
+        ok = 0;
+    waitpid(loader, NULL, 0);
+
+    /* EOF on the stop pipe wakes every worker, threads and processes alike */
+    close(stop_pipe[1]);
+    stop_pipe[1] = -1;
+    for (int i = 0; i < started; i++) {
+        worker_stats stats;
+
+        if (mode == MODE_PROCESSES) {
+            int status;
+
+            if (read(stats_pipe[0], &stats, sizeof(stats)) != (ssize_t)sizeof(stats))
+                stats.failed = 1;
+            waitpid(pids[i], &status, 0);
+        } else {
+            pthread_join(workers[i].thread, NULL);
+            stats = workers[i].stats;
+        }
+        ok &= !stats.failed;
+        out->handshakes += stats.handshakes;
+        out->locks.acquisitions += stats.locks.acquisitions;
+        out->locks.contended += stats.locks.contended;
+        out->locks.wait_seconds += stats.locks.wait_seconds;
+    }
+    if (ok && load.elapsed > 0) {
+        out->elapsed = load.elapsed;
+        out->handshakes_per_s = (double)load.handshakes / load.elapsed;
+    }
+
+out:
+    for (int p = 0; p < 2; p++) {
+        int *pipes[] = {go_pipe, stop_pipe, load_pipe, stats_pipe};
+
+        for (int i = 0; i < 4; i++) {
+            if (pipes[i][p] >= 0)
+                close(pipes[i][p]);
+        }
+    }
+    for (int i = 0; i < nworkers; i++)
+        close(listen_fds[i]);
+    free(workers);
+    free(pids);
+    return ok;
+}
+
+static int next_worker_count(int n, int max) {
+    if (n >= max)
+        return 0;
+    return n * 2 > max ? max : n * 2;
+}
+
+int main(int argc, char **argv) {
+    bench_options opts;
+    bench_json json;
+    EVP_PKEY *pkey = NULL;
+    X509 *cert = NULL;
+    SSL_CTX *client_ctx = NULL, *server_ctx = NULL;
+    long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+    int max_workers = ncpu > 0 ? (int)ncpu : 1;
+    int per_worker = 2, failures = 0, hooked;
+    double seconds;
+    int argi = bench_parse_args(argc, argv, "bench_reuseport.json", &opts);
+
+    if (argi < 0)
+        return 2;
+    /* Benchmark-specific options follow the common ones */
+    for (; argi < argc; argi++) {
+        if (strcmp(argv[argi], "--max-workers") == 0 && argi + 1 < argc) {
+            max_workers = atoi(argv[++argi]);
+        } else if (strcmp(argv[argi], "--clients-per-worker") == 0 && argi + 1 < argc) {
+            per_worker = atoi(argv[++argi]);
+        } else {
+            fprintf(stderr, "Usage: %s [--quick] [--json PATH] [--max-workers N] [--clients-per-worker N]\n",
+                    argv[0]);
+            return 2;
+        }
+    }
+    if (max_workers < 1)
+        max_workers = 1;
+    if (max_workers > MAX_WORKERS)
+        max_workers = MAX_WORKERS;
+    if (opts.quick && max_workers > 2)
+        max_workers = 2;
+    if (per_worker < 1)
+        per_worker = 1;
+    /* Worker and client start-up need more slack than a single-threaded data point */
+    seconds = opts.min_seconds * 4;
+    hooked = resolve_locks();
+    signal(SIGPIPE, SIG_IGN);
+
+    printf("=================================\n");
+    printf("Server Architecture Scaling Benchmark\n");
+    printf("=================================\n");
+    printf("OpenSSL version: %s\n", OpenSSL_version(OPENSSL_VERSION));
+    printf("Workers: 1..%d, %d client thread(s) per worker\n", max_workers, per_worker);
+    if (!hooked)
+        printf("⚠ Lock-wait measurement unavailable (pthread lock symbols not found)\n");
+
+    if (bench_tls_make_cert("EC", &pkey, &cert) != 0
+        || bench_tls_make_ctx_pair(pkey, cert, &client_ctx, &server_ctx) != 0) {
+        X509_free(cert);
+        EVP_PKEY_free(pkey);
+        return 1;
+    }
+    if (bench_json_begin(&json, &opts, "reuseport") != 0) {
+        failures++;
+        goto done;
+    }
+
+    for (int m = 0; m < 3; m++) {
+        double single = 0.0;
+
+        printf("\n%s\n", mode_names[m]);
+        for (int n = 1; n != 0; n = next_worker_count(n, max_workers)) {
+            run_result r;
+            double per_hs, efficiency, wait_share;
+
+            if (!run_mode((server_mode)m, n, n * per_worker, seconds, pkey, cert, server_ctx, client_ctx, &r)) {
+                fprintf(stderr, "ERROR: %s failed with %d workers\n", mode_names[m], n);
+                ERR_print_errors_fp(stderr);
+                failures++;
+                break;
+            }
+            if (n == 1)
+                single = r.handshakes_per_s;
+            efficiency = single > 0 ? r.handshakes_per_s / (single * n) : 0.0;
+            per_hs = r.handshakes > 0 ? 1.0 / (double)r.handshakes : 0.0;
+            wait_share = r.elapsed > 0 ? r.locks.wait_seconds / (r.elapsed * n) : 0.0;
+            printf("  %3d workers  %10.1f hs/s  efficiency %5.2f  %6.1f locks/hs  %5.2f contended/hs  "
+                   "%6.1f us wait/hs\n",
+                   n, r.handshakes_per_s, efficiency, (double)r.locks.acquisitions * per_hs,
+                   (double)r.locks.contended * per_hs,
+                   r.locks.wait_seconds * 1e6 * per_hs);
+
+            bench_json_record_begin(&json);
+            bench_json_str(&json, "mode", mode_names[m]);
+            bench_json_int(&json, "workers", (uint64_t)n);
+            bench_json_int(&json, "clients", (uint64_t)(n * per_worker));
+            bench_json_num(&json, "handshakes_per_s", r.handshakes_per_s);
+            bench_json_num(&json, "efficiency", efficiency);
+            if (hooked) {
+                bench_json_num(&json, "locks_per_handshake", (double)r.locks.acquisitions * per_hs);
+                bench_json_num(&json, "contended_per_handshake", (double)r.locks.contended * per_hs);
+                bench_json_num(&json, "lock_wait_us_per_handshake",
+                               r.locks.wait_seconds * 1e6 * per_hs);
+                bench_json_num(&json, "lock_wait_share", wait_share);
+            }
+            bench_json_record_end(&json);
+        }
+    }
+    bench_json_end(&json);
+
+done:
+    SSL_CTX_free(client_ctx);
+    SSL_CTX_free(server_ctx);
+    X509_free(cert);
+    EVP_PKEY_free(pkey);
+
+    printf("\n=================================\n");
+    if (failures == 0) {
+        printf("✅ Server architecture benchmark completed (%s)\n", opts.json_path);
+        return 0;
+    }
+    printf("❌ %d benchmark(s) FAILED\n", failures);
+    return 1;
+}
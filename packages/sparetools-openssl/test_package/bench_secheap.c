@@ -0,0 +1,334 @@
+#include <openssl/crypto.h>
+#include <openssl/err.h>
+#include <openssl/evp.h>
+#include <openssl/ssl.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "bench_common.h"
+#include "bench_tls.h"
+#include "sparetools_secheap.h"
+
+/**
+ * Secure heap cost benchmark
+ *
+ * With CRYPTO_secure_malloc_init in effect (secure_heap=SIZE[:MINSIZE],
+ * SpareTools::secheap), private key material comes from one mlock()ed
+ * buddy arena behind a global lock. This measures what that costs on
+ * private key operations and handshakes, 1..nproc threads, with the
+ * heap off and then on:
+ *
+ * - RSA-2048 sign, ECDSA P-256 sign: long-term key, per-operation
+ *   secure BIGNUMs (nonce, blinding)
+ * - X25519 keygen+derive:            one ephemeral key per operation,
+ *                                    i.e. a TLS 1.3 key share
+ * - handshake:                       full TLS 1.3 handshake, P-256
+ *                                    server key, in-memory BIO pair
+ *
+ * The heap cannot be torn down while keys live, so every "off" run comes
+ * first; the keys and SSL_CTXs are then recreated inside the arena.
+ * Reported: ops/s, efficiency (rate at N threads / N x the 1-thread
+ * rate) and, for the heap, the rate relative to "off" at the same thread
+ * count, which is the lock's cost. A run fails if the arena fills up.
+ *
+ * --heap-size BYTES (default 1 MiB) and --min-size BYTES (default 32)
+ * are passed to CRYPTO_secure_malloc_init, --max-threads N overrides the
+ * online CPU count as the upper bound.
+ */
+
+typedef enum {
+    WL_RSA_SIGN,
+    WL_ECDSA_SIGN,
+    WL_X25519,
+    WL_HANDSHAKE
+} workload;
+
+static const char *workload_names[] = {"RSA-2048 sign", "ECDSA P-256 sign", "X25519 keygen+derive", "handshake"};
+#define NUM_WORKLOADS 4
+
+/* Thread counts measured: 1, 2, 4, ... max */
+#define MAX_STEPS 16
+
+typedef struct {
+    EVP_PKEY *rsa;
+    EVP_PKEY *ec;
+    EVP_PKEY *x25519_peer;
+    EVP_PKEY *cert_key;
+    X509 *cert;
+    SSL_CTX *client;
+    SSL_CTX *server;
+} bench_keys;
+
+static atomic_int start_flag;
+static atomic_int stop_flag;
+
+typedef struct {
+    pthread_t thread;
+    const bench_keys *keys;
+    workload wl;
+    unsigned long long ops;
+    int failed;
+} thread_arg;
+
+static int sign_once(EVP_PKEY *key, const unsigned char *tbs, size_t tbs_len) {
+    unsigned char sig[512];
+    size_t sig_len = sizeof(sig);
+    EVP_MD_CTX *md = EVP_MD_CTX_new();
+    int ok = md != NULL
+        && EVP_DigestSignInit_ex(md, NULL, "SHA2-256", NULL, NULL, key, NULL) == 1
+        && EVP_DigestSign(md, sig, &sig_len, tbs, tbs_len) == 1;
+
+    EVP_MD_CTX_free(md);
+    return ok;
+}
+
+static int x25519_once(EVP_PKEY *peer) {
+    unsigned char secret[32];
+    size_t secret_len = sizeof(secret);
+    EVP_PKEY *key = EVP_PKEY_Q_keygen(NULL, NULL, "X25519");
+    EVP_PKEY_CTX *ctx = key != NULL ? EVP_PKEY_CTX_new(key, NULL) : NULL;
+    int ok = ctx != NULL
+        && EVP_PKEY_derive_init(ctx) == 1
+        && EVP_PKEY_derive_set_peer(ctx, peer) == 1
+        && EVP_PKEY_derive(ctx, secret, &secret_len) == 1;
+
+    EVP_PKEY_CTX_free(ctx);
+    EVP_PKEY_free(key);
+    return ok;
+}
+
+static int handshake_once(const bench_keys *keys) {
+    SSL *client = NULL, *server = NULL;
+    int ok = bench_tls_make_ssl_pair(keys->client, keys->server, &client, &server) == 0
+        && bench_tls_handshake(client, server);
+
+    SSL_free(client);
+    SSL_free(server);
+    return ok;
+}
+
+static void *worker(void *p) {
+    thread_arg *arg = p;
+    static const unsigned char tbs[32] = "secure heap benchmark message";
+    int ok = 1;
+
+    while (!atomic_load(&start_flag))
+        ;
+    while (ok && !atomic_load(&stop_flag)) {
+        switch (arg->wl) {
+        case WL_RSA_SIGN:
+            ok = sign_once(arg->keys->rsa, tbs, sizeof(tbs));
+            break;
+        case WL_ECDSA_SIGN:
+            ok = sign_once(arg->keys->ec, tbs, sizeof(tbs));
+            break;
+        case WL_X25519:
+            ok = x25519_once(arg->keys->x25519_peer);
+            break;
+        default:
+            ok = handshake_once(arg->keys);
+            break;
+        }
+        arg->ops += ok;
+    }
+    arg->failed = !ok;
+    return NULL;
+}
+
+/* Operations per second, or a negative value on failure */
+static double run_threads(const bench_keys *keys, workload wl, int nthreads, double seconds) {
+    thread_arg *args = calloc((size_t)nthreads, sizeof(*args));
+    unsigned long long ops = 0;
+    double start, elapsed;
+    int failed = args == NULL, started = 0;
+
+    atomic_store(&start_flag, 0);
+    atomic_store(&stop_flag, 0);
+    for (int t = 0; !failed && t < nthreads; t++) {
+        args[t].keys = keys;
+        args[t].wl = wl;
+        if (pthread_create(&args[t].thread, NULL, worker, &args[t]) != 0) {
+            failed = 1;
+            break;
+        }
+        started++;
+    }
+
+    start = bench_now();
+    atomic_store(&start_flag, 1);
+    while (!failed && bench_now() - start < seconds)
+        usleep(1000);
+    atomic_store(&stop_flag, 1);
+
+    for (int t = 0; t < started; t++) {
+        pthread_join(args[t].thread, NULL);
+        ops += args[t].ops;
+        failed |= args[t].failed;
+    }
+    elapsed = bench_now() - start;
+    free(args);
+    return failed ? -1.0 : (double)ops / elapsed;
+}
+
+static void free_keys(bench_keys *keys) {
+    SSL_CTX_free(keys->client);
+    SSL_CTX_free(keys->server);
+    X509_free(keys->cert);
+    EVP_PKEY_free(keys->cert_key);
+    EVP_PKEY_free(keys->x25519_peer);
+    EVP_PKEY_free(keys->ec);
+    EVP_PKEY_free(keys->rsa);
+    memset(keys, 0, sizeof(*keys));
+}
+
+/* Created after the heap is set up, so the private parts live in it */
+static int make_keys(bench_keys *keys) {
+    memset(keys, 0, sizeof(*keys));
+    keys->rsa = EVP_PKEY_Q_keygen(NULL, NULL, "RSA", (size_t)2048);
+    keys->ec = EVP_PKEY_Q_keygen(NULL, NULL, "EC", "P-256");
+    keys->x25519_peer = EVP_PKEY_Q_keygen(NULL, NULL, "X25519");
+    if (keys->rsa == NULL || keys->ec == NULL || keys->x25519_peer == NULL
+        || bench_tls_make_cert("EC", &keys->cert_key, &keys->cert) != 0
+        || bench_tls_make_ctx_pair(keys->cert_key, keys->cert, &keys->client, &keys->server) != 0) {
+        fprintf(stderr, "ERROR: Failed to create benchmark keys\n");
+        ERR_print_errors_fp(stderr);
+        free_keys(keys);
+        return 1;
+    }
+    /* Full handshakes only */
+    SSL_CTX_set_session_cache_mode(keys->client, SSL_SESS_CACHE_OFF);
+    SSL_CTX_set_num_tickets(keys->server, 0);
+    return 0;
+}
+
+/* 1, 2, 4, ... max_threads, then 0 */
+static int next_thread_count(int n, int max) {
+    if (n >= max)
+        return 0;
+    return n * 2 > max ? max : n * 2;
+}
+
+int main(int argc, char **argv) {
+    bench_options opts;
+    bench_json json;
+    bench_keys keys;
+    SPARETOOLS_SECHEAP_INFO info;
+    double off_rates[NUM_WORKLOADS][MAX_STEPS] = {{0}};
+    size_t heap_size = 1 << 20, min_size = 32;
+    int failures = 0, max_threads, heap_state = 0;
+    long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+    int argi = bench_parse_args(argc, argv, "bench_secheap.json", &opts);
+
+    if (argi < 0)
+        return 2;
+    max_threads = ncpu > 0 ? (int)ncpu : 1;
+    for (; argi < argc; argi++) {
+        if (strcmp(argv[argi], "--max-threads") == 0 && argi + 1 < argc) {
+            max_threads = atoi(argv[++argi]);
+        } else if (strcmp(argv[argi], "--heap-size") == 0 && argi + 1 < argc) {
+            heap_size = strtoull(argv[++argi], NULL, 0);
+        } else if (strcmp(argv[argi], "--min-size") == 0 && argi + 1 < argc) {
+            min_size = strtoull(argv[++argi], NULL, 0);
+        } else {
+            fprintf(stderr, "Usage: %s [--quick] [--json PATH] [--max-threads N] [--heap-size BYTES] [--min-size BYTES]\n",
+                    argv[0]);
+            return 2;
+        }
+    }
+    if (max_threads < 1)
+        max_threads = 1;
+    if ((heap_size & (heap_size - 1)) != 0 || (min_size & (min_size - 1)) != 0 || min_size == 0
+        || min_size >= heap_size) {
+        fprintf(stderr, "ERROR: --heap-size and --min-size must be powers of two, min size below heap size\n");
+        return 2;
+    }
+    if (opts.quick && max_threads > 4)
+        max_threads = 4;
+
+    printf("=================================\n");
+    printf("Secure Heap Cost Benchmark\n");
+    printf("=================================\n");
+    printf("OpenSSL version: %s\n", OpenSSL_version(OPENSSL_VERSION));
+    printf("Secure heap: %zu bytes, min allocation %zu\n\n", heap_size, min_size);
+    if (bench_json_begin(&json, &opts, "secheap") != 0)
+        return 1;
+
+    printf("  %-5s %-21s %7s %12s %10s %10s\n", "Heap", "Workload", "Threads", "ops/s", "efficiency", "vs off");
+    for (int heap = 0; heap < 2; heap++) {
+        if (heap) {
+            if (CRYPTO_secure_malloc_initialized()) {
+                printf("  secure heap already set up (SPARETOOLS_SECURE_HEAP?), on/off not comparable\n");
+                failures++;
+                break;
+            }
+            heap_state = sparetools_secheap_init(heap_size, min_size);
+            if (heap_state == 0) {
+                printf("  secure heap not available (no-secure-memory build), skipping\n");
+                break;
+            }
+            if (heap_state == 2)
+                printf("  note: secure heap is not locked (RLIMIT_MEMLOCK too low), results still apply\n");
+        }
+        if (make_keys(&keys) != 0) {
+            failures++;
+            break;
+        }
+        for (int w = 0; w < NUM_WORKLOADS; w++) {
+            double single = 0;
+            int step = 0;
+
+            for (int threads = 1; threads != 0 && step < MAX_STEPS;
+                 threads = next_thread_count(threads, max_threads), step++) {
+                double rate = run_threads(&keys, (workload)w, threads, opts.min_seconds);
+                double efficiency, relative = 0.0;
+
+                if (rate < 0) {
+                    printf("  %-5s %-21s %7d  FAILED%s\n", heap ? "on" : "off", workload_names[w], threads,
+                           heap ? " (secure heap exhausted?)" : "");
+                    ERR_print_errors_fp(stderr);
+                    failures++;
+                    break;
+                }
+                if (threads == 1)
+                    single = rate;
+                efficiency = single > 0 ? rate / (single * threads) : 0.0;
+                if (heap && off_rates[w][step] > 0)
+                    relative = rate / off_rates[w][step];
+                else
+                    off_rates[w][step] = rate;
+                if (heap)
+                    printf("  %-5s %-21s %7d %12.0f %10.2f %9.1f%%\n", "on", workload_names[w], threads, rate,
+                           efficiency, (relative - 1.0) * 100.0);
+                else
+                    printf("  %-5s %-21s %7d %12.0f %10.2f %10s\n", "off", workload_names[w], threads, rate,
+                           efficiency, "-");
+                bench_json_record_begin(&json);
+                bench_json_str(&json, "heap", heap ? "on" : "off");
+                bench_json_str(&json, "workload", workload_names[w]);
+                bench_json_int(&json, "threads", (uint64_t)threads);
+                bench_json_num(&json, "ops_per_sec", rate);
+                bench_json_num(&json, "efficiency", efficiency);
+                if (heap) {
+                    bench_json_num(&json, "relative_to_off", relative);
+                    bench_json_int(&json, "heap_size", (uint64_t)heap_size);
+                    bench_json_int(&json, "min_size", (uint64_t)min_size);
+                    bench_json_int(&json, "locked", heap_state == 1);
+                }
+                bench_json_record_end(&json);
+            }
+        }
+        if (heap) {
+            sparetools_secheap_info(&info);
+            printf("\n  Secure heap in use with keys loaded: %zu of %zu bytes\n", info.used, info.size);
+        }
+        free_keys(&keys);
+    }
+    bench_json_end(&json);
+
+    printf("\n%s\n", failures ? "✗ Some secure heap runs failed" : "✓ All secure heap runs completed");
+    return failures ? 1 : 0;
+}
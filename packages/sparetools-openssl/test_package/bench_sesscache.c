@@ -0,0 +1,388 @@
+#include <openssl/crypto.h>
+#include <openssl/err.h>
+#include <openssl/ssl.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "bench_common.h"
+#include "bench_tls.h"
+#include "sparetools_sesscache.h"
+
+/**
+ * Server session cache contention benchmark
+ *
+ * N threads accept connections on one shared server SSL_CTX, the way a
+ * TLS terminator's worker threads do, each with its own client SSL_CTX
+ * that resumes its previous session. Every --fresh-every'th connection
+ * per thread starts without a session, so the cache sees a steady stream
+ * of inserts next to the lookups.
+ *
+ * Modes:
+ * - internal: OpenSSL's built-in server cache (one lock per SSL_CTX)
+ * - sharded:  SPARETOOLS_SESSCACHE external cache (lock per shard)
+ * - tickets:  stateless tickets sealed with SPARETOOLS_TICKETKEYS, keys
+ *             rotated --rotations times during each run
+ *
+ * The cache modes run TLS 1.2 session-ID resumption by default, where a
+ * resumed handshake is little more than the cache lookup; --tls13 runs
+ * TLS 1.3 with stateful tickets (SSL_OP_NO_TICKET) instead.
+ *
+ * Reported per mode and thread count: handshakes/s, resumption rate
+ * (resumed / attempted resumptions), handshake latency p50/p99 and the
+ * throughput relative to the internal cache.
+ */
+
+#define MAX_SAMPLES_PER_THREAD 4096
+
+typedef enum {
+    MODE_INTERNAL,
+    MODE_SHARDED,
+    MODE_TICKETS
+} cache_mode;
+
+static const char *mode_names[] = {"internal", "sharded", "tickets"};
+#define NUM_MODES 3
+
+static const int full_thread_counts[] = {1, 8, 32, 64, 0};
+static const int quick_thread_counts[] = {1, 32, 0};
+
+static EVP_PKEY *server_key;
+static X509 *server_cert;
+static int use_tls13;
+static int fresh_every = 10;
+
+static atomic_int start_flag;
+static atomic_int stop_flag;
+
+typedef struct {
+    SSL_CTX *server;
+    unsigned long long handshakes;
+    unsigned long long attempts;   /* Handshakes offered a session */
+    unsigned long long resumed;
+    double samples[MAX_SAMPLES_PER_THREAD];
+    size_t num_samples;
+    int failed;
+} thread_arg;
+
+static SSL_CTX *make_client_ctx(void) {
+    SSL_CTX *ctx = SSL_CTX_new(TLS_client_method());
+    int version = use_tls13 ? TLS1_3_VERSION : TLS1_2_VERSION;
+
+    if (ctx == NULL
+        || !SSL_CTX_set_min_proto_version(ctx, version)
+        || !SSL_CTX_set_max_proto_version(ctx, version)) {
+        SSL_CTX_free(ctx);
+        return NULL;
+    }
+    SSL_CTX_set_verify(ctx, SSL_VERIFY_NONE, NULL);
+    return ctx;
+}
+
+static SSL_CTX *make_server_ctx(cache_mode mode, SPARETOOLS_SESSCACHE *cache,
+                                SPARETOOLS_TICKETKEYS *keys) {
+    SSL_CTX *ctx = SSL_CTX_new(TLS_server_method());
+    int version = use_tls13 ? TLS1_3_VERSION : TLS1_2_VERSION;
+
+    if (ctx == NULL
+        || !SSL_CTX_set_min_proto_version(ctx, version)
+        || !SSL_CTX_set_max_proto_version(ctx, version)
+        || SSL_CTX_use_certificate(ctx, server_cert) != 1
+        || SSL_CTX_use_PrivateKey(ctx, server_key) != 1)
+        goto err;
+    /* One ticket per TLS 1.3 handshake: clients only keep the latest */
+    SSL_CTX_set_num_tickets(ctx, 1);
+
+    switch (mode) {
+    case MODE_INTERNAL:
+        SSL_CTX_set_options(ctx, SSL_OP_NO_TICKET);
+        SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_SERVER);
+        break;
+    case MODE_SHARDED:
+        SSL_CTX_set_options(ctx, SSL_OP_NO_TICKET);
+        if (!sparetools_sesscache_attach(cache, ctx))
+            goto err;
+        break;
+    case MODE_TICKETS:
+        /* Stateless: nothing for the server to cache */
+        SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_OFF);
+        if (!sparetools_ticketkeys_attach(keys, ctx))
+            goto err;
+        break;
+    }
+    return ctx;
+err:
+    fprintf(stderr, "ERROR: Failed to create %s server SSL_CTX\n", mode_names[mode]);
+    ERR_print_errors_fp(stderr);
+    SSL_CTX_free(ctx);
+    return NULL;
+}
+
+static void *worker(void *varg) {
+    thread_arg *arg = varg;
+    SSL_CTX *client_ctx = make_client_ctx();
+    SSL_SESSION *sess = NULL;
+
+    if (client_ctx == NULL) {
+        arg->failed = 1;
+        return NULL;
+    }
+
+    while (!atomic_load(&start_flag))
+        ;
+
+    /*
+     * Two handshakes per thread at least, so a short --quick window under
+     * load still offers one session (unless --fresh-every 1)
+     */
+    while (arg->handshakes < 2 || !atomic_load_explicit(&stop_flag, memory_order_relaxed)) {
+        SSL *client = NULL, *server = NULL;
+        int offered = 0;
+        double start;
+
+        if (fresh_every > 0 && arg->handshakes % (unsigned long long)fresh_every == 0) {
+            SSL_SESSION_free(sess);
+            sess = NULL;
+        }
+
+        start = bench_now();
+        if (bench_tls_make_ssl_pair(client_ctx, arg->server, &client, &server) != 0) {
+            arg->failed = 1;
+            break;
+        }
+        if (sess != NULL) {
+            offered = SSL_set_session(client, sess);
+        }
+        if (!bench_tls_handshake(client, server)) {
+            bench_tls_free_pair(client, server);
+            arg->failed = 1;
+            break;
+        }
+        if (use_tls13)
+            bench_tls_drain(client);
+        arg->samples[arg->num_samples++ % MAX_SAMPLES_PER_THREAD] = bench_now() - start;
+
+        arg->handshakes++;
+        if (offered) {
+            arg->attempts++;
+            arg->resumed += SSL_session_reused(client) ? 1 : 0;
+        }
+        SSL_SESSION_free(sess);
+        sess = SSL_get1_session(client);
+        bench_tls_free_pair(client, server);
+    }
+
+    SSL_SESSION_free(sess);
+    SSL_CTX_free(client_ctx);
+    ERR_clear_error();
+    return NULL;
+}
+
+typedef struct {
+    double rate;
+    double resumption_rate;
+    double p50_us;
+    double p99_us;
+    unsigned long long handshakes;
+    unsigned long long attempts;   /* Handshakes offered a session */
+    uint64_t rotations;
+} run_result;
+
+/* Returns 0 on success */
+static int run_threads(cache_mode mode, int nthreads, double seconds, int rotations,
+                       run_result *result) {
+    SPARETOOLS_SESSCACHE *cache = NULL;
+    SPARETOOLS_TICKETKEYS *keys = NULL;
+    SSL_CTX *server = NULL;
+    pthread_t *threads = calloc((size_t)nthreads, sizeof(*threads));
+    thread_arg *args = calloc((size_t)nthreads, sizeof(*args));
+    unsigned long long attempts = 0, resumed = 0;
+    double *latencies = NULL, start, elapsed;
+    size_t num_latencies = 0;
+    int failed = 0, started = 0, rotated = 0;
+
+    memset(result, 0, sizeof(*result));
+    if (threads == NULL || args == NULL)
+        goto done;
+    if (mode == MODE_SHARDED && (cache = sparetools_sesscache_new(0, 0)) == NULL)
+        goto done;
+    if (mode == MODE_TICKETS && (keys = sparetools_ticketkeys_new(0)) == NULL)
+        goto done;
+    if ((server = make_server_ctx(mode, cache, keys)) == NULL)
+        goto done;
+
+    atomic_store(&start_flag, 0);
+    atomic_store(&stop_flag, 0);
+    for (int t = 0; t < nthreads; t++) {
+        args[t].server = server;
+        if (pthread_create(&threads[t], NULL, worker, &args[t]) != 0) {
+            failed = 1;
+            break;
+        }
+        started++;
+    }
+
+    start = bench_now();
+    atomic_store(&start_flag, 1);
+    while (!failed && (elapsed = bench_now() - start) < seconds) {
+        /* Evenly spaced rotations while the workers run */
+        if (keys != NULL && rotated < rotations
+            && elapsed >= seconds * (rotated + 1) / (rotations + 1)) {
+            failed |= !sparetools_ticketkeys_rotate(keys);
+            rotated++;
+        }
+        usleep(1000);
+    }
+    atomic_store(&stop_flag, 1);
+
+    for (int t = 0; t < started; t++) {
+        pthread_join(threads[t], NULL);
+        result->handshakes += args[t].handshakes;
+        attempts += args[t].attempts;
+        resumed += args[t].resumed;
+        failed |= args[t].failed;
+    }
+    elapsed = bench_now() - start;
+
+    latencies = calloc((size_t)started * MAX_SAMPLES_PER_THREAD + 1, sizeof(*latencies));
+    if (latencies == NULL) {
+        failed = 1;
+        goto done;
+    }
+    for (int t = 0; t < started; t++) {
+        size_t n = args[t].num_samples < MAX_SAMPLES_PER_THREAD ? args[t].num_samples
+                                                                : MAX_SAMPLES_PER_THREAD;
+
+        memcpy(latencies + num_latencies, args[t].samples, n * sizeof(*latencies));
+        num_latencies += n;
+    }
+
+    result->rate = (double)result->handshakes / elapsed;
+    result->attempts = attempts;
+    result->resumption_rate = attempts > 0 ? (double)resumed / (double)attempts : 0.0;
+    result->p50_us = bench_percentile(latencies, num_latencies, 50) * 1e6;
+    result->p99_us = bench_percentile(latencies, num_latencies, 99) * 1e6;
+    result->rotations = sparetools_ticketkeys_rotations(keys);
+
+done:
+    free(latencies);
+    SSL_CTX_free(server);
+    sparetools_sesscache_free(cache);
+    sparetools_ticketkeys_free(keys);
+    free(threads);
+    free(args);
+    if (server == NULL)
+        return 1;
+    return failed || result->handshakes == 0;
+}
+
+int main(int argc, char **argv) {
+    bench_options opts;
+    bench_json json;
+    const int *thread_counts;
+    int single_threads[2] = {0, 0};
+    int rotations = 3, failures = 0;
+    double seconds, internal_rate[8] = {0};
+
+    int argi = bench_parse_args(argc, argv, "bench_sesscache.json", &opts);
+
+    if (argi < 0)
+        return 2;
+    /* Benchmark-specific options follow the common ones */
+    for (; argi < argc; argi++) {
+        if (strcmp(argv[argi], "--threads") == 0 && argi + 1 < argc) {
+            single_threads[0] = atoi(argv[++argi]);
+        } else if (strcmp(argv[argi], "--fresh-every") == 0 && argi + 1 < argc) {
+            fresh_every = atoi(argv[++argi]);
+        } else if (strcmp(argv[argi], "--rotations") == 0 && argi + 1 < argc) {
+            rotations = atoi(argv[++argi]);
+        } else if (strcmp(argv[argi], "--tls13") == 0) {
+            use_tls13 = 1;
+        } else {
+            fprintf(stderr, "Usage: %s [--quick] [--json PATH] [--threads N] [--fresh-every N]"
+                            " [--rotations N] [--tls13]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (single_threads[0] > 0)
+        thread_counts = single_threads;
+    else
+        thread_counts = opts.quick ? quick_thread_counts : full_thread_counts;
+    /* Thread start-up needs more slack than a single-threaded data point */
+    seconds = opts.min_seconds * 4;
+
+    printf("=================================\n");
+    printf("OpenSSL Session Cache Benchmark\n");
+    printf("=================================\n");
+    printf("OpenSSL version: %s\n", OpenSSL_version(OPENSSL_VERSION));
+    printf("Protocol: %s, fresh session every %d connections\n",
+           use_tls13 ? "TLSv1.3 (stateful tickets)" : "TLSv1.2 (session IDs)", fresh_every);
+
+    if (bench_tls_make_cert("EC", &server_key, &server_cert) != 0)
+        return 1;
+    if (bench_json_begin(&json, &opts, "sesscache") != 0) {
+        EVP_PKEY_free(server_key);
+        X509_free(server_cert);
+        return 1;
+    }
+
+    for (int m = 0; m < NUM_MODES; m++) {
+        printf("\n%s\n", mode_names[m]);
+        for (int i = 0; thread_counts[i] != 0; i++) {
+            int n = thread_counts[i];
+            run_result r;
+            double relative;
+
+            if (run_threads((cache_mode)m, n, seconds, rotations, &r) != 0) {
+                fprintf(stderr, "ERROR: %s failed with %d threads\n", mode_names[m], n);
+                ERR_print_errors_fp(stderr);
+                failures++;
+                continue;
+            }
+            if (m == MODE_INTERNAL && i < 8)
+                internal_rate[i] = r.rate;
+            relative = i < 8 && internal_rate[i] > 0 ? r.rate / internal_rate[i] : 0.0;
+            printf("  %3d threads  %10.1f hs/s  resumed %5.1f%%  p50 %8.1f us  p99 %8.1f us",
+                   n, r.rate, r.resumption_rate * 100.0, r.p50_us, r.p99_us);
+            if (m != MODE_INTERNAL)
+                printf("  x%.2f", relative);
+            printf("\n");
+
+            bench_json_record_begin(&json);
+            bench_json_str(&json, "mode", mode_names[m]);
+            bench_json_str(&json, "protocol", use_tls13 ? "TLSv1.3" : "TLSv1.2");
+            bench_json_int(&json, "threads", (uint64_t)n);
+            bench_json_int(&json, "handshakes", r.handshakes);
+            bench_json_num(&json, "handshakes_per_s", r.rate);
+            bench_json_num(&json, "resumption_rate", r.resumption_rate);
+            bench_json_num(&json, "latency_us_p50", r.p50_us);
+            bench_json_num(&json, "latency_us_p99", r.p99_us);
+            if (m != MODE_INTERNAL)
+                bench_json_num(&json, "relative_to_internal", relative);
+            if (m == MODE_TICKETS)
+                bench_json_int(&json, "key_rotations", r.rotations);
+            bench_json_record_end(&json);
+
+            /* Every mode must actually resume once a session was offered */
+            if (r.attempts > 0 && r.resumption_rate == 0.0) {
+                fprintf(stderr, "ERROR: %s never resumed a session\n", mode_names[m]);
+                failures++;
+            }
+        }
+    }
+
+    bench_json_end(&json);
+    EVP_PKEY_free(server_key);
+    X509_free(server_cert);
+
+    printf("\n=================================\n");
+    if (failures == 0) {
+        printf("✅ Session cache benchmark completed (%s)\n", opts.json_path);
+        return 0;
+    }
+    printf("❌ %d benchmark(s) FAILED\n", failures);
+    return 1;
+}
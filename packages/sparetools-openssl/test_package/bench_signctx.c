@@ -0,0 +1,352 @@
+#include <openssl/core_names.h>
+#include <openssl/crypto.h>
+#include <openssl/err.h>
+#include <openssl/evp.h>
+#include <openssl/params.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "bench_common.h"
+#include "sparetools_signctx.h"
+
+/**
+ * Signing context reuse benchmark
+ *
+ * TLS servers (CertificateVerify) and artifact signers sign over and over
+ * with the same key. This compares, per signature, on 1..nproc threads:
+ *
+ * - per_call:        EVP_MD_CTX_new + EVP_DigestSignInit_ex (+ PSS
+ *                    parameters) + EVP_DigestSign, the usual pattern
+ * - reuse:           sparetools_signctx_sign(), a per-thread EVP_MD_CTX
+ *                    re-initialised without the key (EVP_DigestSignInit_ex
+ *                    with pkey NULL) before each EVP_DigestSign
+ * - prehash_per_call: SHA2-256, then EVP_PKEY_CTX_new_from_pkey +
+ *                    EVP_PKEY_sign_init + EVP_PKEY_sign (what signing a
+ *                    precomputed artifact digest does)
+ * - prehash_reuse:   SHA2-256, then sparetools_signctx_sign_digest() on a
+ *                    per-thread initialised EVP_PKEY_CTX
+ *
+ * for ECDSA P-256/SHA2-256, Ed25519 (message methods only) and
+ * RSA-2048-PSS/SHA2-256. Before timing, every helper signature is
+ * verified with EVP_DigestVerify over the message, so the smoke run also
+ * tests SpareTools::signctx. Records carry signs_per_sec, us_per_sign
+ * and, for the helper methods, saved_us_per_sign against the per-call
+ * method at the same thread count.
+ *
+ * --max-threads N overrides the online CPU count as the upper bound.
+ */
+
+#define MESSAGE_SIZE 128
+
+typedef enum {
+    M_PER_CALL,
+    M_REUSE,
+    M_PREHASH_PER_CALL,
+    M_PREHASH_REUSE
+} method;
+
+static const char *method_names[] = {"per_call", "reuse", "prehash_per_call", "prehash_reuse"};
+#define NUM_METHODS 4
+
+typedef struct {
+    const char *name;
+    const char *keytype;
+    const char *mdname;  /* NULL for EdDSA */
+    int pss;
+} algorithm;
+
+static const algorithm algorithms[] = {
+    {"ECDSA-P256-SHA256", "EC", "SHA2-256", 0},
+    {"ED25519", "ED25519", NULL, 0},
+    {"RSA-PSS-2048-SHA256", "RSA", "SHA2-256", 1},
+};
+#define NUM_ALGORITHMS (sizeof(algorithms) / sizeof(algorithms[0]))
+
+/* Thread counts measured: 1, 2, 4, ... max */
+#define MAX_STEPS 16
+
+typedef struct {
+    const algorithm *alg;
+    EVP_PKEY *key;
+    SPARETOOLS_SIGNCTX *signctx;
+    OSSL_PARAM params[3];   /* PSS padding and salt length, or just the end marker */
+} bench_key;
+
+static atomic_int start_flag;
+static atomic_int stop_flag;
+
+static const unsigned char message[MESSAGE_SIZE] = "signing context reuse benchmark message";
+
+typedef struct {
+    pthread_t thread;
+    const bench_key *key;
+    method m;
+    unsigned long long ops;
+    int failed;
+} thread_arg;
+
+static const OSSL_PARAM *key_params(const bench_key *key) {
+    return key->alg->pss ? key->params : NULL;
+}
+
+static int sign_per_call(const bench_key *key, unsigned char *sig, size_t *sig_len) {
+    EVP_MD_CTX *md = EVP_MD_CTX_new();
+    EVP_PKEY_CTX *pctx = NULL;
+    int ok = md != NULL
+        && EVP_DigestSignInit_ex(md, &pctx, key->alg->mdname, NULL, NULL, key->key, key_params(key)) == 1
+        && EVP_DigestSign(md, sig, sig_len, message, sizeof(message)) == 1;
+
+    EVP_MD_CTX_free(md);
+    return ok;
+}
+
+static int sign_prehash_per_call(const bench_key *key, unsigned char *sig, size_t *sig_len) {
+    unsigned char dgst[EVP_MAX_MD_SIZE];
+    unsigned int dgst_len;
+    EVP_PKEY_CTX *pctx = EVP_PKEY_CTX_new_from_pkey(NULL, key->key, NULL);
+    OSSL_PARAM md[2];
+    int ok;
+
+    md[0] = OSSL_PARAM_construct_utf8_string(OSSL_SIGNATURE_PARAM_DIGEST, (char *)key->alg->mdname, 0);
+    md[1] = OSSL_PARAM_construct_end();
+    ok = pctx != NULL
+        && EVP_Digest(message, sizeof(message), dgst, &dgst_len, EVP_sha256(), NULL) == 1
+        && EVP_PKEY_sign_init(pctx) == 1
+        && EVP_PKEY_CTX_set_params(pctx, md) == 1
+        && (key_params(key) == NULL || EVP_PKEY_CTX_set_params(pctx, key_params(key)) == 1)
+        && EVP_PKEY_sign(pctx, sig, sig_len, dgst, dgst_len) == 1;
+
+    EVP_PKEY_CTX_free(pctx);
+    return ok;
+}
+
+static int sign_prehash_reuse(const bench_key *key, unsigned char *sig, size_t *sig_len) {
+    unsigned char dgst[EVP_MAX_MD_SIZE];
+    unsigned int dgst_len;
+
+    return EVP_Digest(message, sizeof(message), dgst, &dgst_len, EVP_sha256(), NULL) == 1
+        && sparetools_signctx_sign_digest(key->signctx, dgst, dgst_len, sig, sig_len);
+}
+
+static int sign_once(const bench_key *key, method m, unsigned char *sig, size_t *sig_len) {
+    switch (m) {
+    case M_PER_CALL:
+        return sign_per_call(key, sig, sig_len);
+    case M_REUSE:
+        return sparetools_signctx_sign(key->signctx, message, sizeof(message), sig, sig_len);
+    case M_PREHASH_PER_CALL:
+        return sign_prehash_per_call(key, sig, sig_len);
+    default:
+        return sign_prehash_reuse(key, sig, sig_len);
+    }
+}
+
+static int method_applies(const algorithm *alg, method m) {
+    return alg->mdname != NULL || m == M_PER_CALL || m == M_REUSE;
+}
+
+/* A helper signature must verify like an EVP_DigestSign one */
+static int check_method(const bench_key *key, method m) {
+    unsigned char sig[512];
+    size_t sig_len = sizeof(sig);
+    EVP_MD_CTX *md = EVP_MD_CTX_new();
+    int ok = md != NULL
+        && sign_once(key, m, sig, &sig_len)
+        && EVP_DigestVerifyInit_ex(md, NULL, key->alg->mdname, NULL, NULL, key->key, key_params(key)) == 1
+        && EVP_DigestVerify(md, sig, sig_len, message, sizeof(message)) == 1;
+
+    EVP_MD_CTX_free(md);
+    return ok;
+}
+
+static void *worker(void *p) {
+    thread_arg *arg = p;
+    unsigned char sig[512];
+    int ok = 1;
+
+    while (!atomic_load(&start_flag))
+        ;
+    /* At least one signature per thread, however short the window (--quick under load) */
+    while (ok && (arg->ops == 0 || !atomic_load(&stop_flag))) {
+        size_t sig_len = sizeof(sig);
+
+        ok = sign_once(arg->key, arg->m, sig, &sig_len);
+        arg->ops += ok;
+    }
+    arg->failed = !ok;
+    return NULL;
+}
+
+/* Signatures per second (every thread signs at least once), or a negative value when a signature failed */
+static double run_threads(const bench_key *key, method m, int nthreads, double seconds) {
+    thread_arg *args = calloc((size_t)nthreads, sizeof(*args));
+    unsigned long long ops = 0;
+    double start, elapsed;
+    int failed = args == NULL, started = 0;
+
+    atomic_store(&start_flag, 0);
+    atomic_store(&stop_flag, 0);
+    for (int t = 0; !failed && t < nthreads; t++) {
+        args[t].key = key;
+        args[t].m = m;
+        if (pthread_create(&args[t].thread, NULL, worker, &args[t]) != 0) {
+            failed = 1;
+            break;
+        }
+        started++;
+    }
+
+    start = bench_now();
+    atomic_store(&start_flag, 1);
+    while (!failed && bench_now() - start < seconds)
+        usleep(1000);
+    atomic_store(&stop_flag, 1);
+
+    for (int t = 0; t < started; t++) {
+        pthread_join(args[t].thread, NULL);
+        ops += args[t].ops;
+        failed |= args[t].failed;
+    }
+    elapsed = bench_now() - start;
+    free(args);
+    return failed ? -1.0 : (double)ops / elapsed;
+}
+
+static int make_key(const algorithm *alg, bench_key *key) {
+    static int saltlen = -1;   /* RSA_PSS_SALTLEN_DIGEST */
+
+    memset(key, 0, sizeof(*key));
+    key->alg = alg;
+    key->params[0] = OSSL_PARAM_construct_utf8_string(OSSL_SIGNATURE_PARAM_PAD_MODE, "pss", 0);
+    key->params[1] = OSSL_PARAM_construct_int(OSSL_SIGNATURE_PARAM_PSS_SALTLEN, &saltlen);
+    key->params[2] = OSSL_PARAM_construct_end();
+    if (strcmp(alg->keytype, "EC") == 0)
+        key->key = EVP_PKEY_Q_keygen(NULL, NULL, "EC", "P-256");
+    else if (strcmp(alg->keytype, "RSA") == 0)
+        key->key = EVP_PKEY_Q_keygen(NULL, NULL, "RSA", (size_t)2048);
+    else
+        key->key = EVP_PKEY_Q_keygen(NULL, NULL, alg->keytype);
+    if (key->key == NULL
+        || (key->signctx = sparetools_signctx_new(key->key, alg->mdname, NULL, NULL, key_params(key))) == NULL) {
+        fprintf(stderr, "ERROR: Failed to set up %s\n", alg->name);
+        ERR_print_errors_fp(stderr);
+        EVP_PKEY_free(key->key);
+        return 1;
+    }
+    return 0;
+}
+
+static void free_key(bench_key *key) {
+    sparetools_signctx_free(key->signctx);
+    EVP_PKEY_free(key->key);
+}
+
+/* 1, 2, 4, ... max_threads, then 0 */
+static int next_thread_count(int n, int max) {
+    if (n >= max)
+        return 0;
+    return n * 2 > max ? max : n * 2;
+}
+
+int main(int argc, char **argv) {
+    bench_options opts;
+    bench_json json;
+    int failures = 0, max_threads;
+    long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+    int argi = bench_parse_args(argc, argv, "bench_signctx.json", &opts);
+
+    if (argi < 0)
+        return 2;
+    max_threads = ncpu > 0 ? (int)ncpu : 1;
+    for (; argi < argc; argi++) {
+        if (strcmp(argv[argi], "--max-threads") == 0 && argi + 1 < argc) {
+            max_threads = atoi(argv[++argi]);
+        } else {
+            fprintf(stderr, "Usage: %s [--quick] [--json PATH] [--max-threads N]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (max_threads < 1)
+        max_threads = 1;
+    if (opts.quick && max_threads > 4)
+        max_threads = 4;
+
+    printf("=================================\n");
+    printf("Signing Context Reuse Benchmark\n");
+    printf("=================================\n");
+    printf("OpenSSL version: %s\n", OpenSSL_version(OPENSSL_VERSION));
+    printf("Message: %d bytes\n\n", MESSAGE_SIZE);
+    if (bench_json_begin(&json, &opts, "signctx") != 0)
+        return 1;
+
+    printf("  %-20s %-17s %7s %12s %10s %10s\n", "Algorithm", "Method", "Threads", "signs/s", "us/sign",
+           "saved us");
+    for (size_t a = 0; a < NUM_ALGORITHMS; a++) {
+        const algorithm *alg = &algorithms[a];
+        double base_rates[MAX_STEPS] = {0};
+        bench_key key;
+
+        if (make_key(alg, &key) != 0) {
+            failures++;
+            continue;
+        }
+        for (int m = 0; m < NUM_METHODS; m++) {
+            int step = 0;
+
+            if (!method_applies(alg, (method)m))
+                continue;
+            if (!check_method(&key, (method)m)) {
+                printf("  %-20s %-17s  signature does not verify\n", alg->name, method_names[m]);
+                ERR_print_errors_fp(stderr);
+                failures++;
+                continue;
+            }
+            for (int threads = 1; threads != 0 && step < MAX_STEPS;
+                 threads = next_thread_count(threads, max_threads), step++) {
+                double rate = run_threads(&key, (method)m, threads, opts.min_seconds);
+                /* Per thread: wall time one signature occupies a core */
+                double us, saved = 0.0;
+                int reuse = (m == M_REUSE || m == M_PREHASH_REUSE) && base_rates[step] > 0;
+
+                if (rate < 0) {
+                    printf("  %-20s %-17s %7d  FAILED\n", alg->name, method_names[m], threads);
+                    ERR_print_errors_fp(stderr);
+                    failures++;
+                    break;
+                }
+                us = 1e6 * threads / rate;
+                /* per_call precedes reuse, prehash_per_call precedes prehash_reuse */
+                if (reuse)
+                    saved = 1e6 * threads / base_rates[step] - us;
+                else
+                    base_rates[step] = rate;
+                if (reuse)
+                    printf("  %-20s %-17s %7d %12.0f %10.2f %10.2f\n", alg->name, method_names[m], threads, rate,
+                           us, saved);
+                else
+                    printf("  %-20s %-17s %7d %12.0f %10.2f %10s\n", alg->name, method_names[m], threads, rate,
+                           us, "-");
+                bench_json_record_begin(&json);
+                bench_json_str(&json, "alg", alg->name);
+                bench_json_str(&json, "method", method_names[m]);
+                bench_json_int(&json, "threads", (uint64_t)threads);
+                bench_json_num(&json, "signs_per_sec", rate);
+                bench_json_num(&json, "us_per_sign", us);
+                if (reuse) {
+                    bench_json_num(&json, "saved_us_per_sign", saved);
+                    bench_json_num(&json, "relative_to_per_call", rate / base_rates[step]);
+                }
+                bench_json_record_end(&json);
+            }
+        }
+        free_key(&key);
+    }
+    bench_json_end(&json);
+
+    printf("\n%s\n", failures ? "✗ Some signing runs failed" : "✓ All signing runs completed");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,437 @@
+#include <openssl/ssl.h>
+#include <openssl/err.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "bench_common.h"
+#include "bench_tls.h"
+
+/**
+ * SSL_CTX parameter probe (the autotuner's measurement)
+ *
+ * Measures one SSL_CTX configuration, given on the command line, on the
+ * three paths its parameters affect:
+ * - full:    TLS 1.3 full handshakes over a BIO pair. The client offers
+ *            --groups in order, so the first one is the key share; the
+ *            server issues --num-tickets tickets per handshake.
+ * - resumed: --clients clients (default 256) reconnect round robin, each
+ *            with the newest ticket it holds. With --stateful the server
+ *            issues stateful tickets (SSL_OP_NO_TICKET) kept in its
+ *            session cache of --session-cache-size entries, so a cache
+ *            smaller than clients x tickets evicts sessions and those
+ *            reconnects fall back to full handshakes (resumption_rate).
+ *            Stateless tickets never touch the server cache.
+ * - bulk:    256 KiB SSL_writes over TCP loopback (AES-128-GCM) for
+ *            min_seconds, the sender using --max-send-fragment,
+ *            --split-send-fragment and --pipelines, the receiver
+ *            --read-buffer (with read-ahead) and --pipelines.
+ *
+ * Records carry "phase", "rate" in "unit" (handshakes/s, MB/s for bulk)
+ * and the parameters applied, 0 meaning the library default. The
+ * sslctx_tuner tool (sparetools-openssl-tools) searches the parameter
+ * space with repeated runs of this probe; bench_handshake and bench_ktls
+ * cover the same paths across groups and transfer modes.
+ */
+
+#define WRITE_SIZE (256 * 1024)
+#define READ_CHUNK (64 * 1024)
+#define MIN_CONNECTIONS 10
+
+typedef struct {
+    const char *groups;
+    long num_tickets;
+    long session_cache_size;
+    long read_buffer;
+    long max_send_fragment;
+    long split_send_fragment;
+    long pipelines;
+    int stateful;
+    int clients;
+} probe_params;
+
+static probe_params params = {NULL, -1, 0, 0, 0, 0, 0, 0, 256};
+
+/**
+ * Apply the handshake parameters to a fresh client/server pair. Returns 0
+ * on success.
+ */
+static int make_handshake_ctxs(EVP_PKEY *pkey, X509 *cert, SSL_CTX **client, SSL_CTX **server) {
+    if (bench_tls_make_ctx_pair(pkey, cert, client, server) != 0)
+        return 1;
+    if ((params.groups != NULL
+         && (!SSL_CTX_set1_groups_list(*client, params.groups)
+             || !SSL_CTX_set1_groups_list(*server, params.groups)))
+        || (params.num_tickets >= 0 && !SSL_CTX_set_num_tickets(*server, (size_t)params.num_tickets))) {
+        fprintf(stderr, "ERROR: Invalid --groups or --num-tickets\n");
+        ERR_print_errors_fp(stderr);
+        SSL_CTX_free(*client);
+        SSL_CTX_free(*server);
+        return 1;
+    }
+    if (params.stateful)
+        SSL_CTX_set_options(*server, SSL_OP_NO_TICKET);
+    if (params.session_cache_size > 0)
+        SSL_CTX_sess_set_cache_size(*server, params.session_cache_size);
+    return 0;
+}
+
+/**
+ * One connection over a BIO pair. *next (optional) gets the newest
+ * session the client holds afterwards, *reused whether it resumed.
+ */
+static int connect_once(SSL_CTX *client_ctx, SSL_CTX *server_ctx, SSL_SESSION *session,
+                        SSL_SESSION **next, int *reused) {
+    SSL *client, *server;
+    int ok;
+
+    if (bench_tls_make_ssl_pair(client_ctx, server_ctx, &client, &server) != 0)
+        return 0;
+    if (session != NULL)
+        SSL_set_session(client, session);
+    ok = bench_tls_handshake(client, server);
+    if (ok) {
+        /* Tickets arrive after the server completed its side */
+        bench_tls_drain(client);
+        if (reused != NULL)
+            *reused = SSL_session_reused(client);
+        if (next != NULL)
+            *next = SSL_get1_session(client);
+    }
+    bench_tls_free_pair(client, server);
+    return ok;
+}
+
+/** Full handshakes per second; negative on failure */
+static double run_full(SSL_CTX *client_ctx, SSL_CTX *server_ctx, double min_seconds) {
+    double start = bench_now(), elapsed;
+    size_t count = 0;
+
+    do {
+        if (!connect_once(client_ctx, server_ctx, NULL, NULL, NULL))
+            return -1.0;
+        count++;
+        elapsed = bench_now() - start;
+    } while (elapsed < min_seconds || count < MIN_CONNECTIONS);
+    return (double)count / elapsed;
+}
+
+/**
+ * Reconnects per second across the client population, resumed or not;
+ * *resumption_rate is the share that resumed. Negative on failure.
+ */
+static double run_resumed(SSL_CTX *client_ctx, SSL_CTX *server_ctx, double min_seconds,
+                          double *resumption_rate) {
+    SSL_SESSION **sessions = calloc((size_t)params.clients, sizeof(*sessions));
+    size_t count = 0, resumed = 0;
+    double start, elapsed = 0.0, rate = -1.0;
+
+    if (sessions == NULL)
+        return -1.0;
+    /* Every client starts with the ticket of one full handshake */
+    for (int i = 0; i < params.clients; i++) {
+        if (!connect_once(client_ctx, server_ctx, NULL, &sessions[i], NULL))
+            goto done;
+    }
+
+    start = bench_now();
+    do {
+        int i = (int)(count % (size_t)params.clients), reused = 0;
+        SSL_SESSION *next = NULL;
+
+        if (!connect_once(client_ctx, server_ctx, sessions[i], &next, &reused))
+            goto done;
+        SSL_SESSION_free(sessions[i]);
+        sessions[i] = next;
+        resumed += (size_t)reused;
+        count++;
+        elapsed = bench_now() - start;
+    } while (elapsed < min_seconds || count < (size_t)params.clients);
+    rate = (double)count / elapsed;
+    *resumption_rate = (double)resumed / (double)count;
+
+done:
+    for (int i = 0; i < params.clients; i++)
+        SSL_SESSION_free(sessions[i]);
+    free(sessions);
+    return rate;
+}
+
+typedef struct {
+    int fd;
+    SSL_CTX *ctx;
+    size_t received;
+    int failed;
+} receiver_arg;
+
+/** Connected TCP loopback pair: fds[0] client side, fds[1] server side */
+static int tcp_pair(int fds[2]) {
+    struct sockaddr_in addr;
+    socklen_t len = sizeof(addr);
+    int lsock = socket(AF_INET, SOCK_STREAM, 0);
+
+    fds[0] = fds[1] = -1;
+    if (lsock < 0)
+        return 1;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (bind(lsock, (struct sockaddr *)&addr, sizeof(addr)) != 0
+        || listen(lsock, 1) != 0
+        || getsockname(lsock, (struct sockaddr *)&addr, &len) != 0
+        || (fds[0] = socket(AF_INET, SOCK_STREAM, 0)) < 0
+        || connect(fds[0], (struct sockaddr *)&addr, sizeof(addr)) != 0
+        || (fds[1] = accept(lsock, NULL, NULL)) < 0) {
+        if (fds[0] >= 0)
+            close(fds[0]);
+        close(lsock);
+        return 1;
+    }
+    close(lsock);
+    return 0;
+}
+
+/* Reads until the sender's close_notify */
+static void *receiver(void *varg) {
+    receiver_arg *arg = varg;
+    unsigned char *buf = malloc(READ_CHUNK);
+    SSL *ssl = SSL_new(arg->ctx);
+
+    if (buf == NULL || ssl == NULL || !SSL_set_fd(ssl, arg->fd) || SSL_accept(ssl) != 1) {
+        arg->failed = 1;
+        goto done;
+    }
+    for (;;) {
+        int n = SSL_read(ssl, buf, READ_CHUNK);
+
+        if (n <= 0) {
+            arg->failed = SSL_get_error(ssl, n) != SSL_ERROR_ZERO_RETURN;
+            break;
+        }
+        arg->received += (size_t)n;
+    }
+    SSL_shutdown(ssl);
+done:
+    SSL_free(ssl);
+    free(buf);
+    return NULL;
+}
+
+/** Bulk CTX pair with the record-layer parameters. Returns 0 on success. */
+static int make_bulk_ctxs(EVP_PKEY *pkey, X509 *cert, SSL_CTX **client, SSL_CTX **server) {
+    if (bench_tls_make_ctx_pair(pkey, cert, client, server) != 0)
+        return 1;
+    SSL_CTX_set_ciphersuites(*client, "TLS_AES_128_GCM_SHA256");
+    SSL_CTX_set_ciphersuites(*server, "TLS_AES_128_GCM_SHA256");
+    if ((params.max_send_fragment > 0 && !SSL_CTX_set_max_send_fragment(*client, params.max_send_fragment))
+        || (params.pipelines > 0
+            && (!SSL_CTX_set_max_pipelines(*client, params.pipelines)
+                || !SSL_CTX_set_max_pipelines(*server, params.pipelines)))
+        || (params.split_send_fragment > 0
+            && !SSL_CTX_set_split_send_fragment(*client, params.split_send_fragment))) {
+        /* split_send_fragment must not exceed max_send_fragment */
+        fprintf(stderr, "ERROR: Invalid --max-send-fragment, --split-send-fragment or --pipelines\n");
+        SSL_CTX_free(*client);
+        SSL_CTX_free(*server);
+        return 1;
+    }
+    if (params.read_buffer > 0) {
+        SSL_CTX_set_default_read_buffer_len(*server, (size_t)params.read_buffer);
+        SSL_CTX_set_read_ahead(*server, 1);
+    }
+    return 0;
+}
+
+/** MB/s streamed client to server; negative on failure */
+static double run_bulk(SSL_CTX *client_ctx, SSL_CTX *server_ctx, double min_seconds) {
+    receiver_arg rarg;
+    pthread_t thread;
+    unsigned char *buf = malloc(WRITE_SIZE);
+    SSL *ssl = NULL;
+    size_t sent = 0;
+    int fds[2], failed = 0;
+    double start, elapsed;
+
+    if (buf == NULL || tcp_pair(fds) != 0) {
+        free(buf);
+        return -1.0;
+    }
+    memset(buf, 0x6b, WRITE_SIZE);
+    memset(&rarg, 0, sizeof(rarg));
+    rarg.fd = fds[1];
+    rarg.ctx = server_ctx;
+    if (pthread_create(&thread, NULL, receiver, &rarg) != 0) {
+        close(fds[0]);
+        close(fds[1]);
+        free(buf);
+        return -1.0;
+    }
+
+    ssl = SSL_new(client_ctx);
+    if (ssl == NULL || !SSL_set_fd(ssl, fds[0]) || SSL_connect(ssl) != 1)
+        failed = 1;
+    start = bench_now();
+    while (!failed && bench_now() - start < min_seconds) {
+        if (SSL_write(ssl, buf, WRITE_SIZE) != WRITE_SIZE)
+            failed = 1;
+        else
+            sent += WRITE_SIZE;
+    }
+    if (!failed)
+        SSL_shutdown(ssl);
+    else
+        shutdown(fds[0], SHUT_RDWR);
+    pthread_join(thread, NULL);
+    elapsed = bench_now() - start;
+
+    SSL_free(ssl);
+    close(fds[0]);
+    close(fds[1]);
+    free(buf);
+    if (failed || rarg.failed || rarg.received != sent)
+        return -1.0;
+    return (double)sent / elapsed / 1e6;
+}
+
+static void report(bench_json *json, const char *phase, double rate, const char *unit) {
+    bench_json_record_begin(json);
+    bench_json_str(json, "phase", phase);
+    bench_json_num(json, "rate", rate);
+    bench_json_str(json, "unit", unit);
+    bench_json_str(json, "groups", params.groups != NULL ? params.groups : "");
+    bench_json_int(json, "num_tickets", params.num_tickets >= 0 ? (uint64_t)params.num_tickets : 0);
+    bench_json_int(json, "session_cache_size", (uint64_t)params.session_cache_size);
+    bench_json_int(json, "stateful", (uint64_t)params.stateful);
+    bench_json_int(json, "read_buffer", (uint64_t)params.read_buffer);
+    bench_json_int(json, "max_send_fragment", (uint64_t)params.max_send_fragment);
+    bench_json_int(json, "split_send_fragment", (uint64_t)params.split_send_fragment);
+    bench_json_int(json, "pipelines", (uint64_t)params.pipelines);
+}
+
+int main(int argc, char **argv) {
+    bench_options opts;
+    bench_json json;
+    EVP_PKEY *pkey = NULL;
+    X509 *cert = NULL;
+    SSL_CTX *client_ctx = NULL, *server_ctx = NULL;
+    double full, resumed, bulk, resumption_rate = 0.0;
+    int failures = 0;
+
+    int argi = bench_parse_args(argc, argv, "bench_sslctx.json", &opts);
+
+    if (argi < 0)
+        return 2;
+    /* Benchmark-specific options follow the common ones */
+    for (; argi < argc; argi++) {
+        const char *arg = argv[argi];
+
+        if (argi + 1 < argc && strcmp(arg, "--groups") == 0) {
+            params.groups = argv[++argi];
+        } else if (argi + 1 < argc && strcmp(arg, "--num-tickets") == 0) {
+            params.num_tickets = atol(argv[++argi]);
+        } else if (argi + 1 < argc && strcmp(arg, "--session-cache-size") == 0) {
+            params.session_cache_size = atol(argv[++argi]);
+        } else if (argi + 1 < argc && strcmp(arg, "--clients") == 0) {
+            params.clients = atoi(argv[++argi]);
+        } else if (argi + 1 < argc && strcmp(arg, "--read-buffer") == 0) {
+            params.read_buffer = atol(argv[++argi]);
+        } else if (argi + 1 < argc && strcmp(arg, "--max-send-fragment") == 0) {
+            params.max_send_fragment = atol(argv[++argi]);
+        } else if (argi + 1 < argc && strcmp(arg, "--split-send-fragment") == 0) {
+            params.split_send_fragment = atol(argv[++argi]);
+        } else if (argi + 1 < argc && strcmp(arg, "--pipelines") == 0) {
+            params.pipelines = atol(argv[++argi]);
+        } else if (strcmp(arg, "--stateful") == 0) {
+            params.stateful = 1;
+        } else {
+            fprintf(stderr, "Usage: %s [--quick] [--json PATH] [--groups LIST] [--num-tickets N]\n"
+                    "           [--session-cache-size N] [--clients N] [--stateful] [--read-buffer N]\n"
+                    "           [--max-send-fragment N] [--split-send-fragment N] [--pipelines N]\n",
+                    argv[0]);
+            return 2;
+        }
+    }
+    if (params.clients < 1)
+        params.clients = 1;
+    if (opts.quick && params.clients > 32)
+        params.clients = 32;
+    /* A failed peer must surface as an SSL error, not kill the process */
+    signal(SIGPIPE, SIG_IGN);
+
+    printf("=================================\n");
+    printf("OpenSSL SSL_CTX Parameter Probe\n");
+    printf("=================================\n");
+    printf("OpenSSL version: %s\n", OpenSSL_version(OPENSSL_VERSION));
+    printf("groups=%s num_tickets=%ld session_cache_size=%ld%s clients=%d\n",
+           params.groups != NULL ? params.groups : "(default)", params.num_tickets,
+           params.session_cache_size, params.stateful ? " (stateful)" : "", params.clients);
+    printf("read_buffer=%ld max_send_fragment=%ld split_send_fragment=%ld pipelines=%ld\n\n",
+           params.read_buffer, params.max_send_fragment, params.split_send_fragment, params.pipelines);
+
+    if (bench_tls_make_cert("EC", &pkey, &cert) != 0)
+        return 1;
+    if (bench_json_begin(&json, &opts, "sslctx") != 0) {
+        X509_free(cert);
+        EVP_PKEY_free(pkey);
+        return 1;
+    }
+
+    if (make_handshake_ctxs(pkey, cert, &client_ctx, &server_ctx) != 0) {
+        failures++;
+        goto end;
+    }
+    full = run_full(client_ctx, server_ctx, opts.min_seconds);
+    resumed = full < 0 ? -1.0 : run_resumed(client_ctx, server_ctx, opts.min_seconds, &resumption_rate);
+    SSL_CTX_free(client_ctx);
+    SSL_CTX_free(server_ctx);
+    if (full < 0 || resumed < 0) {
+        fprintf(stderr, "ERROR: Handshake phase failed\n");
+        ERR_print_errors_fp(stderr);
+        failures++;
+        goto end;
+    }
+    printf("  full      %10.1f handshakes/s\n", full);
+    printf("  resumed   %10.1f handshakes/s  resumption %5.1f%%\n", resumed, resumption_rate * 100.0);
+    report(&json, "full", full, "handshakes/s");
+    bench_json_record_end(&json);
+    report(&json, "resumed", resumed, "handshakes/s");
+    bench_json_num(&json, "resumption_rate", resumption_rate);
+    bench_json_int(&json, "clients", (uint64_t)params.clients);
+    bench_json_record_end(&json);
+
+    if (make_bulk_ctxs(pkey, cert, &client_ctx, &server_ctx) != 0) {
+        failures++;
+        goto end;
+    }
+    bulk = run_bulk(client_ctx, server_ctx, opts.min_seconds);
+    SSL_CTX_free(client_ctx);
+    SSL_CTX_free(server_ctx);
+    if (bulk < 0) {
+        fprintf(stderr, "ERROR: Bulk phase failed\n");
+        ERR_print_errors_fp(stderr);
+        failures++;
+        goto end;
+    }
+    printf("  bulk      %10.1f MB/s\n", bulk);
+    report(&json, "bulk", bulk, "MB/s");
+    bench_json_record_end(&json);
+
+end:
+    bench_json_end(&json);
+    X509_free(cert);
+    EVP_PKEY_free(pkey);
+
+    printf("\n=================================\n");
+    if (failures == 0) {
+        printf("✅ SSL_CTX probe completed (%s)\n", opts.json_path);
+        return 0;
+    }
+    printf("❌ %d phase(s) FAILED\n", failures);
+    return 1;
+}
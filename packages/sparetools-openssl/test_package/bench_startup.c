@@ -0,0 +1,442 @@
+#define _GNU_SOURCE
+#include <openssl/crypto.h>
+#include <openssl/err.h>
+#include <openssl/evp.h>
+#include <openssl/provider.h>
+#include <openssl/ssl.h>
+#include <dlfcn.h>
+#include <spawn.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "bench_common.h"
+
+/**
+ * Startup latency benchmark
+ *
+ * Measures what a cold process (a serverless function, a CLI tool) pays
+ * before its first useful OpenSSL call: wall time and page faults from
+ * process start to the first successful SSL_CTX_new() or
+ * EVP_MD_fetch("SHA2-256"). Every sample is a fresh child process (this
+ * binary re-executed via posix_spawn); the parent takes the monotonic
+ * clock just before spawning, so exec and dynamic loading are included.
+ *
+ * Matrix:
+ * - target:   ssl_ctx (OPENSSL_init_ssl + SSL_CTX_new) or md_fetch
+ *             (OPENSSL_init_crypto + EVP_MD_fetch)
+ * - config:   none (OPENSSL_INIT_NO_LOAD_CONFIG), default (OPENSSLDIR's
+ *             openssl.cnf or $OPENSSL_CONF), file (--config PATH, e.g. the
+ *             package's startup_config=minimal openssl.cnf)
+ * - provider: default (implicit), legacy (default + legacy loaded
+ *             explicitly), fips (fips + base; skipped when not loadable)
+ *
+ * A "noop" child that exits at the top of main() gives the process
+ * baseline, which includes loading libssl/libcrypto (where static and
+ * shared linkage differ); over_baseline_ms is what initialization and the
+ * first call add. Linkage is detected at run time: build the test package
+ * with shared=True and shared=False to compare the two.
+ *
+ * Shared builds also report the libssl path the loader picked and how
+ * many of its components are symlinks (ssl_library_symlinks): deep
+ * symlinked Conan cache paths are what a consolidated lib/ directory
+ * (sparetools-base consolidate_shared_libs) avoids. --lib-dir DIR re-runs
+ * the baseline and ssl_ctx cells with DIR first on LD_LIBRARY_PATH, the
+ * way a patched $ORIGIN RUNPATH or an ld.so.conf.d entry would resolve;
+ * those records carry loader "lib-dir" and vs_as_built_ms.
+ */
+
+#define MAX_ROUNDS 25
+
+static const char *targets[] = {"ssl_ctx", "md_fetch", NULL};
+static const char *configs[] = {"none", "default", "file", NULL};
+static const char *providers[] = {"default", "legacy", "fips", NULL};
+
+typedef struct {
+    double total;  /* Seconds from spawn to first success */
+    double init;   /* Seconds inside OpenSSL init + first call */
+    long minflt;
+    long majflt;
+} child_sample;
+
+static const char *linkage(void) {
+    Dl_info info;
+
+    if (dladdr((void *)SSL_CTX_new, &info) && info.dli_fname != NULL
+        && strstr(info.dli_fname, "libssl") != NULL)
+        return "shared";
+    return "static";
+}
+
+/* Number of symlinked components in path (directories and the file itself) */
+static int symlinked_components(const char *path) {
+    char prefix[4096];
+    struct stat st;
+    int count = 0;
+
+    for (size_t i = 1, n = strlen(path); i <= n && i < sizeof(prefix); i++) {
+        if (path[i] != '/' && path[i] != '\0')
+            continue;
+        memcpy(prefix, path, i);
+        prefix[i] = '\0';
+        if (lstat(prefix, &st) == 0 && S_ISLNK(st.st_mode))
+            count++;
+    }
+    return count;
+}
+
+static const char *ssl_library(void) {
+    Dl_info info;
+
+    if (dladdr((void *)SSL_CTX_new, &info) && info.dli_fname != NULL)
+        return info.dli_fname;
+    return "";
+}
+
+/* Runs in the spawned child: one measurement, printed on stdout */
+static int run_child(const char *target, const char *config, const char *provider, const char *t0) {
+    double spawned = strtod(t0, NULL), start, end;
+    uint64_t init_opts = strcmp(config, "none") == 0 ? OPENSSL_INIT_NO_LOAD_CONFIG : OPENSSL_INIT_LOAD_CONFIG;
+    struct rusage usage;
+    int ok = 1;
+
+    start = bench_now();
+    if (strcmp(target, "noop") != 0) {
+        if (strcmp(target, "ssl_ctx") == 0)
+            ok = OPENSSL_init_ssl(init_opts, NULL);
+        else
+            ok = OPENSSL_init_crypto(init_opts, NULL);
+        if (ok && strcmp(provider, "legacy") == 0)
+            ok = OSSL_PROVIDER_load(NULL, "default") != NULL && OSSL_PROVIDER_load(NULL, "legacy") != NULL;
+        else if (ok && strcmp(provider, "fips") == 0)
+            ok = OSSL_PROVIDER_load(NULL, "fips") != NULL && OSSL_PROVIDER_load(NULL, "base") != NULL;
+        if (ok && strcmp(target, "ssl_ctx") == 0)
+            ok = SSL_CTX_new(TLS_method()) != NULL;
+        else if (ok)
+            ok = EVP_MD_fetch(NULL, "SHA2-256", NULL) != NULL;
+    }
+    end = bench_now();
+    getrusage(RUSAGE_SELF, &usage);
+
+    /* Nothing is freed: the process exits right away, as a cold start would */
+    printf("%d %.9f %.9f %ld %ld\n", ok, end - spawned, end - start, usage.ru_minflt, usage.ru_majflt);
+    return ok ? 0 : 3;
+}
+
+extern char **environ;
+
+/**
+ * Spawn one child measurement. Returns 1 on success, 0 when the child
+ * could not reach its target (e.g. provider not available), -1 on a
+ * spawn error.
+ */
+static int spawn_child(const char *self, const char *target, const char *config,
+                       const char *provider, child_sample *sample) {
+    char t0[32], line[256];
+    char *argv[] = {(char *)self, "--child", (char *)target, (char *)config, (char *)provider, t0, NULL};
+    posix_spawn_file_actions_t actions;
+    int fds[2], status, ok = 0;
+    pid_t pid;
+    FILE *fp;
+
+    if (pipe(fds) != 0)
+        return -1;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_adddup2(&actions, fds[1], STDOUT_FILENO);
+    posix_spawn_file_actions_addclose(&actions, fds[0]);
+
+    snprintf(t0, sizeof(t0), "%.9f", bench_now());
+    if (posix_spawn(&pid, self, &actions, NULL, argv, environ) != 0) {
+        posix_spawn_file_actions_destroy(&actions);
+        close(fds[0]);
+        close(fds[1]);
+        return -1;
+    }
+    posix_spawn_file_actions_destroy(&actions);
+    close(fds[1]);
+
+    fp = fdopen(fds[0], "r");
+    if (fp != NULL && fgets(line, sizeof(line), fp) != NULL)
+        sscanf(line, "%d %lf %lf %ld %ld", &ok, &sample->total, &sample->init,
+               &sample->minflt, &sample->majflt);
+    if (fp != NULL)
+        fclose(fp);
+    else
+        close(fds[0]);
+    waitpid(pid, &status, 0);
+    return ok == 1 && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+/* Library path as resolved by a fresh child under the current environment */
+static int child_library(const char *self, char *out, size_t outlen) {
+    char *argv[] = {(char *)self, "--child-where", NULL};
+    posix_spawn_file_actions_t actions;
+    int fds[2], status;
+    pid_t pid;
+    FILE *fp;
+
+    out[0] = '\0';
+    if (pipe(fds) != 0)
+        return 0;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_adddup2(&actions, fds[1], STDOUT_FILENO);
+    posix_spawn_file_actions_addclose(&actions, fds[0]);
+    if (posix_spawn(&pid, self, &actions, NULL, argv, environ) != 0) {
+        posix_spawn_file_actions_destroy(&actions);
+        close(fds[0]);
+        close(fds[1]);
+        return 0;
+    }
+    posix_spawn_file_actions_destroy(&actions);
+    close(fds[1]);
+    fp = fdopen(fds[0], "r");
+    if (fp != NULL) {
+        if (fgets(out, (int)outlen, fp) != NULL)
+            out[strcspn(out, "\n")] = '\0';
+        fclose(fp);
+    } else {
+        close(fds[0]);
+    }
+    waitpid(pid, &status, 0);
+    return out[0] != '\0';
+}
+
+typedef struct {
+    double total_p50;
+    double total_min;
+    double init_p50;
+    double minflt_p50;
+    double majflt_p50;
+} cell_stats;
+
+/* Returns 1 when measured, 0 when the configuration is unavailable, -1 on error */
+static int measure_cell(const char *self, const char *target, const char *config,
+                        const char *provider, int rounds, cell_stats *stats) {
+    double total[MAX_ROUNDS], init[MAX_ROUNDS], minflt[MAX_ROUNDS], majflt[MAX_ROUNDS];
+
+    for (int r = 0; r < rounds; r++) {
+        child_sample sample = {0};
+        int rc = spawn_child(self, target, config, provider, &sample);
+
+        if (rc <= 0)
+            return rc;
+        total[r] = sample.total;
+        init[r] = sample.init;
+        minflt[r] = (double)sample.minflt;
+        majflt[r] = (double)sample.majflt;
+    }
+    stats->total_p50 = bench_percentile(total, rounds, 50) * 1e3;
+    stats->total_min = bench_percentile(total, rounds, 0) * 1e3;
+    stats->init_p50 = bench_percentile(init, rounds, 50) * 1e3;
+    stats->minflt_p50 = bench_percentile(minflt, rounds, 50);
+    stats->majflt_p50 = bench_percentile(majflt, rounds, 50);
+    return 1;
+}
+
+/* "as-built" (the binary's own RPATH/RUNPATH) or "lib-dir" (--lib-dir) */
+static const char *loader = "as-built";
+static char loaded_library[4096];
+
+static void report(bench_json *json, const char *target, const char *config, const char *provider,
+                   int rounds, const cell_stats *stats, double baseline_ms, double as_built_ms) {
+    printf("  %-8s %-8s %-8s %9.3f ms  (min %7.3f, init %7.3f, +%7.3f)  %6.0f minflt\n",
+           target, config, provider, stats->total_p50, stats->total_min, stats->init_p50,
+           stats->total_p50 - baseline_ms, stats->minflt_p50);
+    bench_json_record_begin(json);
+    bench_json_str(json, "type", "startup");
+    bench_json_str(json, "target", target);
+    bench_json_str(json, "config", config);
+    bench_json_str(json, "provider", provider);
+    bench_json_str(json, "linkage", linkage());
+    bench_json_str(json, "loader", loader);
+    if (loaded_library[0] != '\0') {
+        bench_json_str(json, "ssl_library", loaded_library);
+        bench_json_int(json, "ssl_library_symlinks", (uint64_t)symlinked_components(loaded_library));
+    }
+    bench_json_int(json, "rounds", (uint64_t)rounds);
+    bench_json_num(json, "total_ms_p50", stats->total_p50);
+    bench_json_num(json, "total_ms_min", stats->total_min);
+    bench_json_num(json, "init_ms_p50", stats->init_p50);
+    bench_json_num(json, "over_baseline_ms", stats->total_p50 - baseline_ms);
+    bench_json_num(json, "minor_faults", stats->minflt_p50);
+    bench_json_num(json, "major_faults", stats->majflt_p50);
+    if (as_built_ms >= 0)
+        bench_json_num(json, "vs_as_built_ms", stats->total_p50 - as_built_ms);
+    bench_json_record_end(json);
+}
+
+/* Whether file lives in dir, comparing resolved paths */
+static int same_directory(const char *file, const char *dir) {
+    char parent[4096], a[4096], b[4096];
+    char *slash;
+
+    snprintf(parent, sizeof(parent), "%s", file);
+    if ((slash = strrchr(parent, '/')) == NULL)
+        return 0;
+    *slash = '\0';
+    return realpath(parent, a) != NULL && realpath(dir, b) != NULL && strcmp(a, b) == 0;
+}
+
+/**
+ * Re-measure the baseline and ssl_ctx/none/default with lib_dir searched
+ * first. Returns the number of failed cells.
+ */
+static int measure_lib_dir(bench_json *json, const char *self, const char *lib_dir, int rounds,
+                           const cell_stats *as_built, double ssl_ctx_ms) {
+    const char *old = getenv("LD_LIBRARY_PATH");
+    char path[8192], resolved[4096];
+    cell_stats baseline, stats;
+    int failures = 0;
+
+    printf("\nLoader: --lib-dir %s\n", lib_dir);
+    if (strcmp(linkage(), "shared") != 0) {
+        printf("  ⚠ Static linkage: nothing to load, skipping\n");
+        return 0;
+    }
+    snprintf(path, sizeof(path), "%s%s%s", lib_dir, old != NULL ? ":" : "", old != NULL ? old : "");
+    setenv("LD_LIBRARY_PATH", path, 1);
+
+    /* DT_RPATH (unlike DT_RUNPATH) wins over LD_LIBRARY_PATH */
+    if (!child_library(self, resolved, sizeof(resolved)) || !same_directory(resolved, lib_dir)) {
+        printf("  ⚠ Loader did not pick libssl from %s (got %s): missing there, or DT_RPATH\n", lib_dir,
+               resolved[0] != '\0' ? resolved : "unknown");
+    } else {
+        loader = "lib-dir";
+        snprintf(loaded_library, sizeof(loaded_library), "%s", resolved);
+        printf("libssl: %s (%d symlinked components)\n", loaded_library,
+               symlinked_components(loaded_library));
+        if (measure_cell(self, "noop", "none", "default", rounds, &baseline) == 1)
+            report(json, "noop", "none", "default", rounds, &baseline, baseline.total_p50,
+                   as_built->total_p50);
+        else
+            failures++;
+        if (measure_cell(self, "ssl_ctx", "none", "default", rounds, &stats) == 1)
+            report(json, "ssl_ctx", "none", "default", rounds, &stats, baseline.total_p50, ssl_ctx_ms);
+        else
+            failures++;
+    }
+
+    if (old != NULL)
+        setenv("LD_LIBRARY_PATH", old, 1);
+    else
+        unsetenv("LD_LIBRARY_PATH");
+    return failures;
+}
+
+int main(int argc, char **argv) {
+    bench_options opts;
+    bench_json json;
+    cell_stats baseline, stats;
+    const char *config_file = NULL, *lib_dir = NULL, *env_conf = getenv("OPENSSL_CONF");
+    char self[4096], saved_conf[4096] = "";
+    ssize_t self_len;
+    double ssl_ctx_ms = -1;
+    int rounds, failures = 0;
+    int argi;
+
+    /* Child mode: --child TARGET CONFIG PROVIDER T0 */
+    if (argc == 6 && strcmp(argv[1], "--child") == 0)
+        return run_child(argv[2], argv[3], argv[4], argv[5]);
+    if (argc == 2 && strcmp(argv[1], "--child-where") == 0) {
+        printf("%s\n", ssl_library());
+        return 0;
+    }
+
+    argi = bench_parse_args(argc, argv, "bench_startup.json", &opts);
+    if (argi < 0)
+        return 2;
+    /* Benchmark-specific options follow the common ones */
+    for (; argi < argc; argi++) {
+        if (strcmp(argv[argi], "--config") == 0 && argi + 1 < argc) {
+            config_file = argv[++argi];
+        } else if (strcmp(argv[argi], "--lib-dir") == 0 && argi + 1 < argc) {
+            lib_dir = argv[++argi];
+        } else {
+            fprintf(stderr, "Usage: %s [--quick] [--json PATH] [--config openssl.cnf] [--lib-dir DIR]\n",
+                    argv[0]);
+            return 2;
+        }
+    }
+    rounds = opts.quick ? 3 : MAX_ROUNDS;
+    if (env_conf != NULL)
+        snprintf(saved_conf, sizeof(saved_conf), "%s", env_conf);
+
+    self_len = readlink("/proc/self/exe", self, sizeof(self) - 1);
+    if (self_len <= 0) {
+        snprintf(self, sizeof(self), "%s", argv[0]);
+    } else {
+        self[self_len] = '\0';
+    }
+
+    printf("=================================\n");
+    printf("OpenSSL Startup Latency Benchmark\n");
+    printf("=================================\n");
+    printf("OpenSSL version: %s\n", OpenSSL_version(OPENSSL_VERSION));
+    printf("Linkage: %s, %d processes per configuration\n", linkage(), rounds);
+    if (strcmp(linkage(), "shared") == 0) {
+        snprintf(loaded_library, sizeof(loaded_library), "%s", ssl_library());
+        printf("libssl: %s (%d symlinked components)\n", loaded_library,
+               symlinked_components(loaded_library));
+    }
+
+    if (bench_json_begin(&json, &opts, "startup") != 0)
+        return 1;
+
+    if (measure_cell(self, "noop", "none", "default", rounds, &baseline) != 1) {
+        fprintf(stderr, "ERROR: Cannot spawn %s\n", self);
+        bench_json_end(&json);
+        return 1;
+    }
+    printf("\nProcess baseline (exec to main): %.3f ms, %.0f minor faults\n",
+           baseline.total_p50, baseline.minflt_p50);
+    report(&json, "noop", "none", "default", rounds, &baseline, baseline.total_p50, -1);
+
+    printf("\n  %-8s %-8s %-8s %9s\n", "target", "config", "provider", "p50");
+    for (int t = 0; targets[t] != NULL; t++) {
+        for (int c = 0; configs[c] != NULL; c++) {
+            if (strcmp(configs[c], "file") == 0) {
+                if (config_file == NULL)
+                    continue;
+                setenv("OPENSSL_CONF", config_file, 1);
+            }
+            for (int p = 0; providers[p] != NULL; p++) {
+                int rc = measure_cell(self, targets[t], configs[c], providers[p], rounds, &stats);
+
+                if (rc == 1) {
+                    report(&json, targets[t], configs[c], providers[p], rounds, &stats, baseline.total_p50, -1);
+                    if (t == 0 && c == 0 && p == 0)
+                        ssl_ctx_ms = stats.total_p50;
+                } else if (rc == 0 && strcmp(providers[p], "default") != 0) {
+                    printf("  %-8s %-8s %-8s ⚠ provider not available, skipping\n",
+                           targets[t], configs[c], providers[p]);
+                } else {
+                    fprintf(stderr, "ERROR: %s/%s/%s failed\n", targets[t], configs[c], providers[p]);
+                    failures++;
+                }
+            }
+            if (strcmp(configs[c], "file") == 0) {
+                if (env_conf != NULL)
+                    setenv("OPENSSL_CONF", saved_conf, 1);
+                else
+                    unsetenv("OPENSSL_CONF");
+            }
+        }
+    }
+
+    if (lib_dir != NULL)
+        failures += measure_lib_dir(&json, self, lib_dir, rounds, &baseline, ssl_ctx_ms);
+
+    bench_json_end(&json);
+
+    printf("\n=================================\n");
+    if (failures == 0) {
+        printf("✅ Startup benchmark completed (%s)\n", opts.json_path);
+        return 0;
+    }
+    printf("❌ %d benchmark(s) FAILED\n", failures);
+    return 1;
+}
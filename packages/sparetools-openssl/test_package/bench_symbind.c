@@ -0,0 +1,362 @@
+#define _GNU_SOURCE
+#include <openssl/bn.h>
+#include <openssl/crypto.h>
+#include <openssl/err.h>
+#include <openssl/evp.h>
+#include <dlfcn.h>
+#include <elf.h>
+#include <link.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench_common.h"
+
+/**
+ * Symbol binding benchmark: static vs shared vs shared_symbol_binding
+ *
+ * Times short, call-heavy libcrypto operations whose cost is dominated by
+ * calls between libcrypto's own functions (64-byte SHA2-256 and HMAC,
+ * 256-bit BN_mod_mul, EVP_MD_fetch) and reports how the libcrypto it runs
+ * against binds those calls:
+ *
+ *   static            linked into the executable, calls are direct
+ *   shared            calls to exported functions go through the PLT and
+ *                     can be interposed
+ *   shared-symbolic   -Bsymbolic-functions: no relocation refers to a
+ *                     function libcrypto defines itself
+ *
+ * The layout comes from libcrypto's dynamic section: relocations against
+ * function symbols it defines are the interposable self-calls. Run the
+ * benchmark against each package and pass the first report to the next
+ * run with --baseline to print the per-workload speed-up.
+ */
+
+#define BATCH 64
+
+#if __ELF_NATIVE_CLASS == 64
+# define REL_SYM(info) ELF64_R_SYM(info)
+# define SYM_TYPE(info) ELF64_ST_TYPE(info)
+#else
+# define REL_SYM(info) ELF32_R_SYM(info)
+# define SYM_TYPE(info) ELF32_ST_TYPE(info)
+#endif
+
+typedef struct {
+    const char *layout;
+    const char *path;
+    size_t plt_relocs;          /* DT_JMPREL entries */
+    size_t interposable_calls;  /* relocations against own functions */
+    int bind_now;
+} binding_info;
+
+typedef struct {
+    EVP_MD *sha256;
+    BIGNUM *a, *b, *m, *r;
+    BN_CTX *bn_ctx;
+    unsigned char buf[64];
+    unsigned char key[32];
+} workload_state;
+
+typedef int (*workload_fn)(workload_state *st);
+
+static int run_sha256(workload_state *st) {
+    unsigned char md[EVP_MAX_MD_SIZE];
+
+    return EVP_Digest(st->buf, sizeof(st->buf), md, NULL, st->sha256, NULL);
+}
+
+static int run_hmac(workload_state *st) {
+    unsigned char mac[EVP_MAX_MD_SIZE];
+    size_t len;
+
+    return EVP_Q_mac(NULL, "HMAC", NULL, "SHA2-256", NULL, st->key, sizeof(st->key),
+                     st->buf, sizeof(st->buf), mac, sizeof(mac), &len) != NULL;
+}
+
+static int run_bn_modmul(workload_state *st) {
+    return BN_mod_mul(st->r, st->a, st->b, st->m, st->bn_ctx);
+}
+
+static int run_md_fetch(workload_state *st) {
+    EVP_MD *md = EVP_MD_fetch(NULL, "SHA2-256", NULL);
+
+    (void)st;
+    EVP_MD_free(md);
+    return md != NULL;
+}
+
+static const struct {
+    const char *name;
+    workload_fn fn;
+} workloads[] = {
+    {"sha2-256-64", run_sha256},
+    {"hmac-sha2-256-64", run_hmac},
+    {"bn-modmul-256", run_bn_modmul},
+    {"md-fetch", run_md_fetch},
+};
+#define NUM_WORKLOADS (sizeof(workloads) / sizeof(workloads[0]))
+
+typedef struct {
+    const char *path;
+    binding_info *out;
+} find_object;
+
+static int find_phdr(struct dl_phdr_info *info, size_t size, void *arg) {
+    const find_object *want = arg;
+    binding_info *out = want->out;
+    const ElfW(Dyn) *dyn = NULL;
+    uintptr_t jmprel = 0, rel = 0, symtab = 0;
+    size_t pltrelsz = 0, relsz = 0, relent = 0;
+    int pltrel = 0;
+
+    (void)size;
+    if (strcmp(info->dlpi_name, want->path) != 0)
+        return 0;
+
+    for (int i = 0; i < info->dlpi_phnum; i++) {
+        if (info->dlpi_phdr[i].p_type == PT_DYNAMIC)
+            dyn = (const ElfW(Dyn) *)(info->dlpi_addr + info->dlpi_phdr[i].p_vaddr);
+    }
+    if (dyn == NULL)
+        return 1;
+
+    for (; dyn->d_tag != DT_NULL; dyn++) {
+        switch (dyn->d_tag) {
+        case DT_JMPREL: jmprel = dyn->d_un.d_ptr; break;
+        case DT_PLTRELSZ: pltrelsz = dyn->d_un.d_val; break;
+        case DT_PLTREL: pltrel = (int)dyn->d_un.d_val; break;
+#ifdef DT_RELA
+        case DT_RELA: rel = dyn->d_un.d_ptr; break;
+        case DT_RELASZ: relsz = dyn->d_un.d_val; break;
+        case DT_RELAENT: relent = dyn->d_un.d_val; break;
+#endif
+        case DT_REL: rel = dyn->d_un.d_ptr; break;
+        case DT_RELSZ: relsz = dyn->d_un.d_val; break;
+        case DT_RELENT: relent = dyn->d_un.d_val; break;
+        case DT_SYMTAB: symtab = dyn->d_un.d_ptr; break;
+        case DT_FLAGS: out->bind_now |= (dyn->d_un.d_val & DF_BIND_NOW) != 0; break;
+        case DT_FLAGS_1: out->bind_now |= (dyn->d_un.d_val & DF_1_NOW) != 0; break;
+        }
+    }
+    /* ld.so relocates these entries in place on most targets, not all */
+#define FIXUP(p) ((p) != 0 && (p) < info->dlpi_addr ? (p) + info->dlpi_addr : (p))
+    jmprel = FIXUP(jmprel);
+    rel = FIXUP(rel);
+    symtab = FIXUP(symtab);
+#undef FIXUP
+    if (symtab == 0)
+        return 1;
+
+    const ElfW(Sym) *syms = (const ElfW(Sym) *)symtab;
+    struct {
+        uintptr_t base;
+        size_t size, entsize;
+    } tables[2] = {
+        {jmprel, pltrelsz, pltrel == DT_RELA ? sizeof(ElfW(Rela)) : sizeof(ElfW(Rel))},
+        {rel, relsz, relent ? relent : sizeof(ElfW(Rel))},
+    };
+    out->plt_relocs = tables[0].size / tables[0].entsize;
+
+    for (int t = 0; t < 2; t++) {
+        for (size_t off = 0; tables[t].base != 0 && off + tables[t].entsize <= tables[t].size;
+             off += tables[t].entsize) {
+            /* Rel and Rela both start with r_offset, r_info */
+            const ElfW(Rel) *r = (const ElfW(Rel) *)(tables[t].base + off);
+            const ElfW(Sym) *sym;
+            size_t index = REL_SYM(r->r_info);
+
+            if (index == 0)
+                continue;
+            sym = &syms[index];
+            if (sym->st_shndx != SHN_UNDEF && SYM_TYPE(sym->st_info) == STT_FUNC)
+                out->interposable_calls++;
+        }
+    }
+    return 1;
+}
+
+/** Work out how the libcrypto in use binds calls to its own functions */
+static void detect_binding(binding_info *out) {
+    Dl_info crypto, self;
+    find_object want;
+
+    memset(out, 0, sizeof(*out));
+    out->layout = "unknown";
+    out->path = "";
+    if (!dladdr((void *)EVP_MD_fetch, &crypto) || !dladdr((void *)detect_binding, &self))
+        return;
+    if (crypto.dli_fbase == self.dli_fbase) {
+        out->layout = "static";
+        return;
+    }
+    out->path = crypto.dli_fname;
+    want.path = crypto.dli_fname;
+    want.out = out;
+    if (dl_iterate_phdr(find_phdr, &want) == 0)
+        return;
+    out->layout = out->interposable_calls == 0 ? "shared-symbolic" : "shared";
+}
+
+/** Nanoseconds per operation, negative on failure */
+static double measure(workload_fn fn, workload_state *st, double min_seconds) {
+    unsigned long long ops = 0;
+    double start = bench_now(), elapsed;
+
+    do {
+        for (int i = 0; i < BATCH; i++) {
+            if (!fn(st))
+                return -1.0;
+        }
+        ops += BATCH;
+        elapsed = bench_now() - start;
+    } while (elapsed < min_seconds);
+    return elapsed * 1e9 / (double)ops;
+}
+
+/** ns_per_op of `workload` in a previous report, 0 when absent */
+static double baseline_ns(const char *report, const char *workload, char *layout, size_t layout_len) {
+    char key[128];
+    const char *p, *end;
+    double ns = 0.0;
+
+    snprintf(key, sizeof(key), "\"workload\": \"%s\"", workload);
+    if (report == NULL || (p = strstr(report, key)) == NULL)
+        return 0.0;
+    /* Fields of one record stay on one line */
+    end = strchr(p, '}');
+    while (p > report && p[-1] != '{')
+        p--;
+    const char *field = strstr(p, "\"ns_per_op\": ");
+    if (field != NULL && field < end)
+        ns = strtod(field + strlen("\"ns_per_op\": "), NULL);
+    field = strstr(p, "\"layout\": \"");
+    if (field != NULL && field < end) {
+        field += strlen("\"layout\": \"");
+        snprintf(layout, layout_len, "%.*s", (int)strcspn(field, "\""), field);
+    }
+    return ns;
+}
+
+static char *read_file(const char *path) {
+    FILE *fp = fopen(path, "rb");
+    char *data = NULL;
+    long len;
+
+    if (fp == NULL)
+        return NULL;
+    if (fseek(fp, 0, SEEK_END) == 0 && (len = ftell(fp)) >= 0 && fseek(fp, 0, SEEK_SET) == 0
+        && (data = malloc((size_t)len + 1)) != NULL) {
+        data[fread(data, 1, (size_t)len, fp)] = '\0';
+    }
+    fclose(fp);
+    return data;
+}
+
+int main(int argc, char **argv) {
+    bench_options opts;
+    bench_json json;
+    binding_info binding;
+    workload_state st;
+    char *baseline = NULL;
+    int failures = 0, argi;
+
+    argi = bench_parse_args(argc, argv, "bench_symbind.json", &opts);
+    if (argi < 0)
+        return 2;
+    for (; argi < argc; argi++) {
+        if (strcmp(argv[argi], "--baseline") == 0 && argi + 1 < argc) {
+            const char *path = argv[++argi];
+
+            if ((baseline = read_file(path)) == NULL) {
+                fprintf(stderr, "ERROR: Cannot read baseline report %s\n", path);
+                return 2;
+            }
+        } else {
+            fprintf(stderr, "Usage: %s [--quick] [--json PATH] [--baseline REPORT]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    printf("=================================\n");
+    printf("OpenSSL Symbol Binding Benchmark\n");
+    printf("=================================\n");
+    printf("OpenSSL version: %s\n", OpenSSL_version(OPENSSL_VERSION));
+
+    detect_binding(&binding);
+    printf("libcrypto layout: %s%s%s\n", binding.layout, binding.path[0] ? " " : "", binding.path);
+    if (strcmp(binding.layout, "static") != 0 && strcmp(binding.layout, "unknown") != 0)
+        printf("  %zu PLT relocations, %zu against its own functions, %s binding\n\n",
+               binding.plt_relocs, binding.interposable_calls, binding.bind_now ? "eager" : "lazy");
+    else
+        printf("\n");
+
+    memset(&st, 0, sizeof(st));
+    memset(st.buf, 0xa5, sizeof(st.buf));
+    memset(st.key, 0x5a, sizeof(st.key));
+    st.sha256 = EVP_MD_fetch(NULL, "SHA2-256", NULL);
+    st.bn_ctx = BN_CTX_new();
+    st.a = BN_new();
+    st.b = BN_new();
+    st.m = BN_new();
+    st.r = BN_new();
+    if (st.sha256 == NULL || st.bn_ctx == NULL || st.r == NULL
+        || !BN_hex2bn(&st.m, "FFFFFFFF00000001000000000000000000000000FFFFFFFFFFFFFFFFFFFFFFFF")
+        || !BN_hex2bn(&st.a, "6B17D1F2E12C4247F8BCE6E563A440F277037D812DEB33A0F4A13945D898C296")
+        || !BN_hex2bn(&st.b, "4FE342E2FE1A7F9B8EE7EB4A7C0F9E162BCE33576B315ECECBB6406837BF51F5")) {
+        ERR_print_errors_fp(stderr);
+        return 1;
+    }
+
+    if (bench_json_begin(&json, &opts, "symbind") != 0)
+        return 1;
+
+    printf("%-20s %12s %10s\n", "workload", "ns/op", "vs base");
+    for (size_t w = 0; w < NUM_WORKLOADS; w++) {
+        char base_layout[32] = "";
+        double ns = measure(workloads[w].fn, &st, opts.min_seconds);
+        double base = baseline_ns(baseline, workloads[w].name, base_layout, sizeof(base_layout));
+
+        if (ns < 0) {
+            fprintf(stderr, "ERROR: %s failed\n", workloads[w].name);
+            ERR_print_errors_fp(stderr);
+            failures++;
+            continue;
+        }
+        if (base > 0)
+            printf("%-20s %12.1f %9.3fx (%s)\n", workloads[w].name, ns, base / ns, base_layout);
+        else
+            printf("%-20s %12.1f %10s\n", workloads[w].name, ns, "-");
+
+        bench_json_record_begin(&json);
+        bench_json_str(&json, "workload", workloads[w].name);
+        bench_json_str(&json, "layout", binding.layout);
+        bench_json_int(&json, "plt_relocs", binding.plt_relocs);
+        bench_json_int(&json, "interposable_calls", binding.interposable_calls);
+        bench_json_num(&json, "ns_per_op", ns);
+        bench_json_num(&json, "ops_per_s", 1e9 / ns);
+        if (base > 0) {
+            bench_json_str(&json, "baseline_layout", base_layout);
+            bench_json_num(&json, "speedup_vs_baseline", base / ns);
+        }
+        bench_json_record_end(&json);
+    }
+
+    bench_json_end(&json);
+
+    BN_free(st.a);
+    BN_free(st.b);
+    BN_free(st.m);
+    BN_free(st.r);
+    BN_CTX_free(st.bn_ctx);
+    EVP_MD_free(st.sha256);
+    free(baseline);
+
+    printf("\n=================================\n");
+    if (failures == 0) {
+        printf("✅ Symbol binding benchmark completed (%s)\n", opts.json_path);
+        return 0;
+    }
+    printf("❌ %d benchmark(s) FAILED\n", failures);
+    return 1;
+}
@@ -0,0 +1,583 @@
+#define _GNU_SOURCE
+#include <openssl/crypto.h>
+#include <openssl/evp.h>
+#include <openssl/err.h>
+#include <openssl/rsa.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "bench_common.h"
+#include "bench_numa.h"
+#ifdef SPARETOOLS_HAVE_ALLOCATOR
+#include "sparetools_allocator.h"
+#endif
+
+/**
+ * Multi-threaded scaling benchmark
+ *
+ * Runs 1..nproc threads against shared keys and reports aggregate ops/s
+ * plus per-thread efficiency (ops/s at N threads divided by N times the
+ * single-thread rate). Efficiency well below 1.0 points at lock
+ * contention in the library rather than CPU saturation.
+ *
+ * Workloads:
+ * - rsa2048-sign, ecdsa-p256-sign, x25519-derive: shared EVP_PKEY,
+ *   one EVP_PKEY_CTX per thread
+ * - aes-256-gcm-seal: 1 KiB records, one EVP_CIPHER_CTX per thread
+ * - fetch-sha256: EVP_MD_fetch/EVP_MD_free, hits the provider store
+ *
+ * --max-threads N overrides the online CPU count as the upper bound.
+ *
+ * --numa runs every workload once per (CPU node, memory node) pair
+ * instead (benchmark "threads_numa"): min(node CPUs, --max-threads)
+ * threads run on the CPU node's CPUs, while their contexts and buffers
+ * were allocated on the memory node (bench_numa.h). aes-256-gcm-seal
+ * then streams 16 KiB records through a per-thread buffer larger than
+ * the caches, so it measures memory placement rather than L1 hits. Each
+ * record reports ops/s relative to the CPU node's local run (vs_local)
+ * and the SLIT distance; the topology is written as numa_node records.
+ * The shared keys stay where main() allocated them.
+ *
+ * OpenSSL allocations are counted per thread through forwarding
+ * CRYPTO_set_mem_functions hooks (on top of the SpareTools allocator shim
+ * when linked), and reported as allocations per operation.
+ *
+ * Packages built with lock_profiling=True write a per-creation-site lock
+ * profile from OPENSSL_cleanup to $SPARETOOLS_LOCKPROF. The benchmark
+ * points it at bench_threads_locks.tsv (unless already set), calls
+ * OPENSSL_cleanup at the end and prints the top contended lock sites over
+ * all workloads. Other builds write no profile and print nothing.
+ */
+
+#define AEAD_RECORD_SIZE 1024
+/* --numa: streamed records and per-thread buffer (larger than the LLC share of a core) */
+#define NUMA_RECORD_SIZE (16 * 1024)
+#define NUMA_BUFFER_SIZE ((size_t)16 * 1024 * 1024)
+#define NUMA_QUICK_BUFFER_SIZE ((size_t)1024 * 1024)
+
+typedef enum {
+    WL_RSA_SIGN,
+    WL_ECDSA_SIGN,
+    WL_X25519_DERIVE,
+    WL_AES_GCM_SEAL,
+    WL_FETCH
+} workload_id;
+
+typedef struct {
+    workload_id id;
+    const char *name;
+} workload;
+
+static const workload workloads[] = {
+    {WL_RSA_SIGN, "rsa2048-sign"},
+    {WL_ECDSA_SIGN, "ecdsa-p256-sign"},
+    {WL_X25519_DERIVE, "x25519-derive"},
+    {WL_AES_GCM_SEAL, "aes-256-gcm-seal"},
+    {WL_FETCH, "fetch-sha256"},
+};
+#define NUM_WORKLOADS (sizeof(workloads) / sizeof(workloads[0]))
+
+/* Keys shared by all threads, generated once in main() */
+static EVP_PKEY *rsa_key;
+static EVP_PKEY *ec_key;
+static EVP_PKEY *x25519_key;
+static EVP_PKEY *x25519_peer;
+static EVP_CIPHER *aes_gcm;
+
+static atomic_int start_flag;
+static atomic_int stop_flag;
+
+/* --numa placement of one run: node indices into the topology */
+typedef struct {
+    const bench_numa_topology *topology;
+    int cpu_node;
+    int mem_node;
+    size_t buffer_size;
+} numa_placement;
+
+typedef struct {
+    workload_id id;
+    const numa_placement *placement;    /* NULL: no placement */
+    unsigned long long ops;
+    unsigned long long allocs;
+    int failed;
+} thread_arg;
+
+/* Allocation counting hooks; NULL next_* means the libc allocator */
+static CRYPTO_malloc_fn next_malloc;
+static CRYPTO_realloc_fn next_realloc;
+static CRYPTO_free_fn next_free;
+static _Thread_local unsigned long long thread_allocs;
+
+static void *count_malloc(size_t num, const char *file, int line) {
+    thread_allocs++;
+    return next_malloc != NULL ? next_malloc(num, file, line) : malloc(num);
+}
+
+static void *count_realloc(void *addr, size_t num, const char *file, int line) {
+    thread_allocs++;
+    return next_realloc != NULL ? next_realloc(addr, num, file, line) : realloc(addr, num);
+}
+
+static void count_free(void *addr, const char *file, int line) {
+    if (next_free != NULL)
+        next_free(addr, file, line);
+    else
+        free(addr);
+}
+
+/**
+ * Wrap the active allocator with counting hooks. Must run before
+ * OpenSSL's first allocation; returns 1 if counting is active.
+ */
+static int install_alloc_counter(void) {
+    CRYPTO_get_mem_functions(&next_malloc, &next_realloc, &next_free);
+    /* The defaults are the CRYPTO_* entry points themselves */
+    if (next_malloc == CRYPTO_malloc) {
+        next_malloc = NULL;
+        next_realloc = NULL;
+        next_free = NULL;
+    }
+    return CRYPTO_set_mem_functions(count_malloc, count_realloc, count_free);
+}
+
+static EVP_PKEY_CTX *make_sign_ctx(EVP_PKEY *key, int rsa) {
+    EVP_PKEY_CTX *pctx = EVP_PKEY_CTX_new_from_pkey(NULL, key, NULL);
+
+    if (pctx == NULL || EVP_PKEY_sign_init(pctx) <= 0)
+        goto err;
+    if (rsa && EVP_PKEY_CTX_set_rsa_padding(pctx, RSA_PKCS1_PADDING) <= 0)
+        goto err;
+    if (EVP_PKEY_CTX_set_signature_md(pctx, EVP_sha256()) <= 0)
+        goto err;
+    return pctx;
+err:
+    EVP_PKEY_CTX_free(pctx);
+    return NULL;
+}
+
+static EVP_PKEY_CTX *make_derive_ctx(void) {
+    EVP_PKEY_CTX *pctx = EVP_PKEY_CTX_new_from_pkey(NULL, x25519_key, NULL);
+
+    if (pctx == NULL
+        || EVP_PKEY_derive_init(pctx) <= 0
+        || EVP_PKEY_derive_set_peer(pctx, x25519_peer) <= 0) {
+        EVP_PKEY_CTX_free(pctx);
+        return NULL;
+    }
+    return pctx;
+}
+
+static void *worker(void *varg) {
+    thread_arg *arg = varg;
+    EVP_PKEY_CTX *pctx = NULL;
+    EVP_CIPHER_CTX *cctx = NULL;
+    unsigned char dgst[32], sig[512], secret[64];
+    unsigned char key[32], iv[12], tag[16];
+    unsigned char in[AEAD_RECORD_SIZE], out[AEAD_RECORD_SIZE + 16];
+    unsigned long long ops = 0, allocs_start;
+    const numa_placement *placement = arg->placement;
+    unsigned char *stream = NULL;
+    size_t offset = 0;
+
+    memset(dgst, 0x11, sizeof(dgst));
+    memset(key, 0x22, sizeof(key));
+    memset(iv, 0x33, sizeof(iv));
+    memset(in, 0x44, sizeof(in));
+
+    /* Set up on the memory node, so what this thread allocates lands there */
+    if (placement != NULL) {
+        bench_numa_run_on(placement->topology, placement->mem_node);
+        if (arg->id == WL_AES_GCM_SEAL
+            && (stream = bench_numa_alloc(placement->topology, placement->mem_node,
+                                          placement->buffer_size)) == NULL) {
+            arg->failed = 1;
+            return NULL;
+        }
+    }
+
+    switch (arg->id) {
+    case WL_RSA_SIGN:
+        pctx = make_sign_ctx(rsa_key, 1);
+        break;
+    case WL_ECDSA_SIGN:
+        pctx = make_sign_ctx(ec_key, 0);
+        break;
+    case WL_X25519_DERIVE:
+        pctx = make_derive_ctx();
+        break;
+    case WL_AES_GCM_SEAL:
+        cctx = EVP_CIPHER_CTX_new();
+        if (cctx != NULL && !EVP_EncryptInit_ex2(cctx, aes_gcm, key, iv, NULL)) {
+            EVP_CIPHER_CTX_free(cctx);
+            cctx = NULL;
+        }
+        break;
+    case WL_FETCH:
+        break;
+    }
+    if (arg->id != WL_FETCH && pctx == NULL && cctx == NULL) {
+        arg->failed = 1;
+        bench_numa_free(stream, placement != NULL ? placement->buffer_size : 0);
+        return NULL;
+    }
+    if (placement != NULL)
+        bench_numa_run_on(placement->topology, placement->cpu_node);
+
+    while (!atomic_load(&start_flag))
+        ;
+    allocs_start = thread_allocs;
+
+    while (!atomic_load_explicit(&stop_flag, memory_order_relaxed)) {
+        size_t len;
+        int outl, ok = 0;
+
+        switch (arg->id) {
+        case WL_RSA_SIGN:
+        case WL_ECDSA_SIGN:
+            len = sizeof(sig);
+            ok = EVP_PKEY_sign(pctx, sig, &len, dgst, sizeof(dgst)) > 0;
+            break;
+        case WL_X25519_DERIVE:
+            len = sizeof(secret);
+            ok = EVP_PKEY_derive(pctx, secret, &len) > 0;
+            break;
+        case WL_AES_GCM_SEAL:
+            iv[0]++;
+            if (stream != NULL) {
+                /* Sealed in place, walking the node-placed buffer */
+                unsigned char *record = stream + offset;
+
+                offset = offset + 2 * NUMA_RECORD_SIZE <= placement->buffer_size
+                    ? offset + NUMA_RECORD_SIZE : 0;
+                ok = EVP_EncryptInit_ex2(cctx, NULL, NULL, iv, NULL)
+                    && EVP_EncryptUpdate(cctx, record, &outl, record, NUMA_RECORD_SIZE)
+                    && EVP_EncryptFinal_ex(cctx, record + outl, &outl)
+                    && EVP_CIPHER_CTX_ctrl(cctx, EVP_CTRL_AEAD_GET_TAG, sizeof(tag), tag);
+                break;
+            }
+            ok = EVP_EncryptInit_ex2(cctx, NULL, NULL, iv, NULL)
+                && EVP_EncryptUpdate(cctx, out, &outl, in, sizeof(in))
+                && EVP_EncryptFinal_ex(cctx, out + outl, &outl)
+                && EVP_CIPHER_CTX_ctrl(cctx, EVP_CTRL_AEAD_GET_TAG, sizeof(tag), tag);
+            break;
+        case WL_FETCH: {
+            EVP_MD *md = EVP_MD_fetch(NULL, "SHA2-256", NULL);
+            ok = md != NULL;
+            EVP_MD_free(md);
+            break;
+        }
+        }
+        if (!ok) {
+            arg->failed = 1;
+            break;
+        }
+        ops++;
+    }
+
+    arg->ops = ops;
+    arg->allocs = thread_allocs - allocs_start;
+    EVP_PKEY_CTX_free(pctx);
+    EVP_CIPHER_CTX_free(cctx);
+    bench_numa_free(stream, placement != NULL ? placement->buffer_size : 0);
+    return NULL;
+}
+
+/**
+ * Run one workload on nthreads threads for the configured duration.
+ * Returns aggregate ops/s, or a negative value on failure, and stores
+ * OpenSSL allocations per operation in allocs_per_op.
+ */
+static double run_threads(workload_id id, int nthreads, double seconds, const numa_placement *placement,
+                          double *allocs_per_op) {
+    pthread_t *threads = calloc((size_t)nthreads, sizeof(*threads));
+    thread_arg *args = calloc((size_t)nthreads, sizeof(*args));
+    unsigned long long total = 0, allocs = 0;
+    double start, elapsed;
+    int failed = 0, started = 0;
+
+    if (threads == NULL || args == NULL) {
+        free(threads);
+        free(args);
+        return -1.0;
+    }
+
+    atomic_store(&start_flag, 0);
+    atomic_store(&stop_flag, 0);
+    for (int t = 0; t < nthreads; t++) {
+        args[t].id = id;
+        args[t].placement = placement;
+        if (pthread_create(&threads[t], NULL, worker, &args[t]) != 0) {
+            failed = 1;
+            break;
+        }
+        started++;
+    }
+
+    start = bench_now();
+    atomic_store(&start_flag, 1);
+    while (!failed && bench_now() - start < seconds)
+        usleep(1000);
+    atomic_store(&stop_flag, 1);
+
+    for (int t = 0; t < started; t++) {
+        pthread_join(threads[t], NULL);
+        total += args[t].ops;
+        allocs += args[t].allocs;
+        failed |= args[t].failed;
+    }
+    elapsed = bench_now() - start;
+    *allocs_per_op = total > 0 ? (double)allocs / (double)total : 0.0;
+
+    free(threads);
+    free(args);
+    return failed ? -1.0 : (double)total / elapsed;
+}
+
+static int generate_keys(void) {
+    rsa_key = EVP_PKEY_Q_keygen(NULL, NULL, "RSA", (size_t)2048);
+    ec_key = EVP_PKEY_Q_keygen(NULL, NULL, "EC", "P-256");
+    x25519_key = EVP_PKEY_Q_keygen(NULL, NULL, "X25519");
+    x25519_peer = EVP_PKEY_Q_keygen(NULL, NULL, "X25519");
+    aes_gcm = EVP_CIPHER_fetch(NULL, "AES-256-GCM", NULL);
+
+    if (rsa_key == NULL || ec_key == NULL || x25519_key == NULL
+        || x25519_peer == NULL || aes_gcm == NULL) {
+        fprintf(stderr, "ERROR: Key generation or cipher fetch failed\n");
+        ERR_print_errors_fp(stderr);
+        return 1;
+    }
+    return 0;
+}
+
+static void free_keys(void) {
+    EVP_PKEY_free(rsa_key);
+    EVP_PKEY_free(ec_key);
+    EVP_PKEY_free(x25519_key);
+    EVP_PKEY_free(x25519_peer);
+    EVP_CIPHER_free(aes_gcm);
+}
+
+#define TOP_LOCKS 10
+
+/*
+ * Print and record the TOP_LOCKS sites of a lock_profiling profile (lines
+ * of wait_ns, contended, acquisitions, locks, site; sorted by wait time).
+ * Returns 0 if there is no profile.
+ */
+static int report_lock_profile(const char *path, bench_json *json) {
+    FILE *fp = fopen(path, "r");
+    char line[4352];
+    int shown = 0;
+
+    if (fp == NULL)
+        return 0;
+    printf("\nTop contended locks (creation site, %s)\n", path);
+    while (shown < TOP_LOCKS && fgets(line, sizeof(line), fp) != NULL) {
+        unsigned long long wait_ns, contended, acquisitions, locks;
+        char site[4200];
+
+        if (line[0] == '#'
+            || sscanf(line, "%llu %llu %llu %llu %4199s", &wait_ns, &contended, &acquisitions, &locks, site) != 5)
+            continue;
+        printf("  %10.3f ms wait  %10llu contended / %12llu acquisitions  %6llu locks  %s\n",
+               (double)wait_ns / 1e6, contended, acquisitions, locks, site);
+        bench_json_record_begin(json);
+        bench_json_str(json, "lock_site", site);
+        bench_json_num(json, "wait_ms", (double)wait_ns / 1e6);
+        bench_json_int(json, "contended", contended);
+        bench_json_int(json, "acquisitions", acquisitions);
+        bench_json_int(json, "locks", locks);
+        bench_json_record_end(json);
+        shown++;
+    }
+    fclose(fp);
+    return 1;
+}
+
+static int next_thread_count(int n, int max) {
+    if (n >= max)
+        return 0;
+    return n * 2 > max ? max : n * 2;
+}
+
+/* --numa: every workload on every (CPU node, memory node) pair; returns the failures */
+static int run_numa(const bench_numa_topology *topology, int max_threads, int quick, double seconds,
+                    int counting, bench_json *json) {
+    int failures = 0;
+
+    for (size_t w = 0; w < NUM_WORKLOADS; w++) {
+        printf("\n%s\n", workloads[w].name);
+        for (int a = 0; a < topology->nnodes; a++) {
+            int n = topology->nodes[a].ncpus < max_threads ? topology->nodes[a].ncpus : max_threads;
+            double local = 0.0;
+
+            /* Local placement first, as the reference for the remote ones */
+            for (int k = 0; k < topology->nnodes; k++) {
+                int b = (a + k) % topology->nnodes;
+                numa_placement placement = {
+                    topology, a, b, quick ? NUMA_QUICK_BUFFER_SIZE : NUMA_BUFFER_SIZE,
+                };
+                double allocs_per_op;
+                double rate = run_threads(workloads[w].id, n, seconds, &placement, &allocs_per_op);
+
+                if (rate < 0) {
+                    fprintf(stderr, "ERROR: %s failed on CPU node %d / memory node %d\n",
+                            workloads[w].name, topology->nodes[a].id, topology->nodes[b].id);
+                    ERR_print_errors_fp(stderr);
+                    failures++;
+                    continue;
+                }
+                if (a == b)
+                    local = rate;
+                printf("  cpu node %d  mem node %d  distance %3d  %3d threads  %14.1f ops/s  vs local %5.2f\n",
+                       topology->nodes[a].id, topology->nodes[b].id, topology->nodes[a].distance[b], n,
+                       rate, local > 0 ? rate / local : 0.0);
+
+                bench_json_record_begin(json);
+                bench_json_str(json, "workload", workloads[w].name);
+                bench_json_int(json, "cpu_node", (uint64_t)topology->nodes[a].id);
+                bench_json_int(json, "mem_node", (uint64_t)topology->nodes[b].id);
+                bench_json_int(json, "distance", (uint64_t)topology->nodes[a].distance[b]);
+                bench_json_str(json, "local", a == b ? "yes" : "no");
+                bench_json_int(json, "threads", (uint64_t)n);
+                bench_json_num(json, "ops_per_s", rate);
+                bench_json_num(json, "ops_per_s_per_thread", rate / n);
+                if (local > 0)
+                    bench_json_num(json, "vs_local", rate / local);
+                if (counting)
+                    bench_json_num(json, "allocs_per_op", allocs_per_op);
+                bench_json_record_end(json);
+            }
+        }
+    }
+    return failures;
+}
+
+int main(int argc, char **argv) {
+    bench_options opts;
+    bench_json json;
+    int failures = 0, counting;
+    const char *lock_profile;
+    long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+    int max_threads = ncpu > 0 ? (int)ncpu : 1;
+    double seconds;
+    int numa = 0;
+    bench_numa_topology topology;
+
+    int argi = bench_parse_args(argc, argv, "bench_threads.json", &opts);
+
+    if (argi < 0)
+        return 2;
+    /* Benchmark-specific options follow the common ones */
+    for (; argi < argc; argi++) {
+        if (strcmp(argv[argi], "--max-threads") == 0 && argi + 1 < argc) {
+            max_threads = atoi(argv[++argi]);
+        } else if (strcmp(argv[argi], "--numa") == 0) {
+            numa = 1;
+        } else {
+            fprintf(stderr, "Usage: %s [--quick] [--json PATH] [--max-threads N] [--numa]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (max_threads < 1)
+        max_threads = 1;
+    if (opts.quick && max_threads > (numa ? 2 : 4))
+        max_threads = numa ? 2 : 4;
+    /* Thread start-up needs more slack than a single-threaded data point */
+    seconds = opts.min_seconds * 4;
+    counting = install_alloc_counter();
+    /* Read by OPENSSL_cleanup in lock_profiling builds */
+    if ((lock_profile = getenv("SPARETOOLS_LOCKPROF")) == NULL || lock_profile[0] == '\0') {
+        lock_profile = "bench_threads_locks.tsv";
+        setenv("SPARETOOLS_LOCKPROF", lock_profile, 1);
+    }
+    remove(lock_profile);
+
+    printf("=================================\n");
+    printf("OpenSSL Thread Scaling Benchmark\n");
+    printf("=================================\n");
+    printf("OpenSSL version: %s\n", OpenSSL_version(OPENSSL_VERSION));
+    bench_numa_detect(&topology);
+    if (numa) {
+        printf("NUMA nodes: %d%s\n", topology.nnodes, topology.from_sysfs ? "" : " (no sysfs topology)");
+        for (int a = 0; a < topology.nnodes; a++) {
+            printf("  node %d: cpus %s, distances", topology.nodes[a].id, topology.nodes[a].cpulist);
+            for (int b = 0; b < topology.nnodes; b++)
+                printf(" %d", topology.nodes[a].distance[b]);
+            printf("\n");
+        }
+        printf("Threads per node: up to %d\n", max_threads);
+    } else {
+        printf("Threads: 1..%d\n", max_threads);
+    }
+#ifdef SPARETOOLS_HAVE_ALLOCATOR
+    printf("Allocator: %s (SpareTools shim)\n", sparetools_allocator_name());
+#else
+    printf("Allocator: system\n");
+#endif
+    if (!counting)
+        printf("⚠ Allocation counting unavailable (hooks already installed)\n");
+
+    if (generate_keys() != 0) {
+        free_keys();
+        return 1;
+    }
+    if (bench_json_begin(&json, &opts, numa ? "threads_numa" : "threads") != 0) {
+        free_keys();
+        return 1;
+    }
+    bench_numa_json_topology(&topology, &json);
+
+    if (numa)
+        failures += run_numa(&topology, max_threads, opts.quick, seconds, counting, &json);
+    for (size_t w = 0; !numa && w < NUM_WORKLOADS; w++) {
+        double single = 0.0;
+
+        printf("\n%s\n", workloads[w].name);
+        for (int n = 1; n != 0; n = next_thread_count(n, max_threads)) {
+            double allocs_per_op;
+            double rate = run_threads(workloads[w].id, n, seconds, NULL, &allocs_per_op);
+            double efficiency;
+
+            if (rate < 0) {
+                fprintf(stderr, "ERROR: %s failed with %d threads\n", workloads[w].name, n);
+                ERR_print_errors_fp(stderr);
+                failures++;
+                break;
+            }
+            if (n == 1)
+                single = rate;
+            efficiency = single > 0 ? rate / (single * n) : 0.0;
+            printf("  %3d threads  %14.1f ops/s  efficiency %5.2f  %7.1f allocs/op\n",
+                   n, rate, efficiency, allocs_per_op);
+
+            bench_json_record_begin(&json);
+            bench_json_str(&json, "workload", workloads[w].name);
+            bench_json_int(&json, "threads", (uint64_t)n);
+            bench_json_num(&json, "ops_per_s", rate);
+            bench_json_num(&json, "ops_per_s_per_thread", rate / n);
+            bench_json_num(&json, "efficiency", efficiency);
+            if (counting)
+                bench_json_num(&json, "allocs_per_op", allocs_per_op);
+            bench_json_record_end(&json);
+        }
+    }
+
+    free_keys();
+    OPENSSL_cleanup();
+    report_lock_profile(lock_profile, &json);
+    bench_json_end(&json);
+
+    printf("\n=================================\n");
+    if (failures == 0) {
+        printf("✅ Thread scaling benchmark completed (%s)\n", opts.json_path);
+        return 0;
+    }
+    printf("❌ %d benchmark(s) FAILED\n", failures);
+    return 1;
+}
@@ -0,0 +1,194 @@
+#ifndef SPARETOOLS_BENCH_TLS_H
+#define SPARETOOLS_BENCH_TLS_H
+
+#include <openssl/bio.h>
+#include <openssl/err.h>
+#include <openssl/evp.h>
+#include <openssl/ssl.h>
+#include <openssl/x509.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * Shared libssl helpers for the test_package benchmark binaries.
+ *
+ * Provides an in-memory client/server setup so handshake and record
+ * costs can be measured without sockets:
+ * - self-signed server certificate generated at start-up
+ * - TLS 1.3 client/server SSL_CTX pair
+ * - SSL pair connected through BIO_new_bio_pair
+ */
+
+/**
+ * Generate a self-signed certificate for key_type: "EC" (P-256), "RSA"
+ * (2048) or any key type EVP_PKEY_Q_keygen() takes without parameters
+ * (e.g. "ML-DSA-65", "Ed25519"), which sign the certificate without a
+ * separate digest. Returns 0 on success.
+ */
+static inline int bench_tls_make_cert(const char *key_type, EVP_PKEY **pkey_out,
+                                      X509 **cert_out) {
+    const EVP_MD *md = EVP_sha256();
+    EVP_PKEY *pkey;
+    X509 *cert = NULL;
+    X509_NAME *name;
+
+    if (strcmp(key_type, "RSA") == 0) {
+        pkey = EVP_PKEY_Q_keygen(NULL, NULL, "RSA", (size_t)2048);
+    } else if (strcmp(key_type, "EC") == 0) {
+        pkey = EVP_PKEY_Q_keygen(NULL, NULL, "EC", "P-256");
+    } else {
+        pkey = EVP_PKEY_Q_keygen(NULL, NULL, key_type);
+        md = NULL;
+    }
+    if (pkey == NULL)
+        goto err;
+
+    if ((cert = X509_new()) == NULL
+        || !X509_set_version(cert, 2)
+        || !ASN1_INTEGER_set(X509_get_serialNumber(cert), 1)
+        || X509_gmtime_adj(X509_getm_notBefore(cert), 0) == NULL
+        || X509_gmtime_adj(X509_getm_notAfter(cert), 86400L) == NULL
+        || !X509_set_pubkey(cert, pkey))
+        goto err;
+
+    name = X509_get_subject_name(cert);
+    if (!X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC,
+                                    (const unsigned char *)"bench.sparetools.local",
+                                    -1, -1, 0)
+        || !X509_set_issuer_name(cert, name)
+        || !X509_sign(cert, pkey, md))
+        goto err;
+
+    *pkey_out = pkey;
+    *cert_out = cert;
+    return 0;
+err:
+    fprintf(stderr, "ERROR: Failed to create %s test certificate\n", key_type);
+    ERR_print_errors_fp(stderr);
+    X509_free(cert);
+    EVP_PKEY_free(pkey);
+    return 1;
+}
+
+/**
+ * Create a TLS 1.3-only client and server SSL_CTX using the given server
+ * credentials. The client does not verify the (self-signed) peer.
+ */
+static inline int bench_tls_make_ctx_pair(EVP_PKEY *pkey, X509 *cert,
+                                          SSL_CTX **client_out, SSL_CTX **server_out) {
+    SSL_CTX *client = SSL_CTX_new(TLS_client_method());
+    SSL_CTX *server = SSL_CTX_new(TLS_server_method());
+
+    if (client == NULL || server == NULL
+        || !SSL_CTX_set_min_proto_version(client, TLS1_3_VERSION)
+        || !SSL_CTX_set_min_proto_version(server, TLS1_3_VERSION)
+        || SSL_CTX_use_certificate(server, cert) != 1
+        || SSL_CTX_use_PrivateKey(server, pkey) != 1) {
+        fprintf(stderr, "ERROR: Failed to create SSL_CTX pair\n");
+        ERR_print_errors_fp(stderr);
+        SSL_CTX_free(client);
+        SSL_CTX_free(server);
+        return 1;
+    }
+    SSL_CTX_set_verify(client, SSL_VERIFY_NONE, NULL);
+
+    *client_out = client;
+    *server_out = server;
+    return 0;
+}
+
+/**
+ * Create a client/server SSL pair connected through an in-memory BIO pair.
+ * Returns 0 on success; both SSL objects own their end of the pair.
+ */
+static inline int bench_tls_make_ssl_pair(SSL_CTX *client_ctx, SSL_CTX *server_ctx,
+                                          SSL **client_out, SSL **server_out) {
+    SSL *client = SSL_new(client_ctx);
+    SSL *server = SSL_new(server_ctx);
+    BIO *cbio = NULL, *sbio = NULL;
+
+    if (client == NULL || server == NULL || !BIO_new_bio_pair(&cbio, 0, &sbio, 0)) {
+        SSL_free(client);
+        SSL_free(server);
+        return 1;
+    }
+    SSL_set_bio(client, cbio, cbio);
+    SSL_set_bio(server, sbio, sbio);
+    SSL_set_connect_state(client);
+    SSL_set_accept_state(server);
+
+    *client_out = client;
+    *server_out = server;
+    return 0;
+}
+
+static inline int bench_tls_retryable(SSL *ssl, int ret) {
+    int err = SSL_get_error(ssl, ret);
+    return err == SSL_ERROR_WANT_READ || err == SSL_ERROR_WANT_WRITE;
+}
+
+/**
+ * One handshake step of one side for bench_tls_handshake_ex(): calls
+ * SSL_do_handshake(ssl) and returns its result, doing whatever else the
+ * benchmark needs around it (CPU timing, moving bytes between custom BIOs,
+ * attributing allocations to a side).
+ */
+typedef int (*bench_tls_step_fn)(SSL *ssl, int is_server, void *arg);
+
+/**
+ * Drive both ends of a connected pair until the handshake completes,
+ * client step first in each round, through step (NULL: plain
+ * SSL_do_handshake). Returns 1 on success, 0 on failure.
+ */
+static inline int bench_tls_handshake_ex(SSL *client, SSL *server, bench_tls_step_fn step, void *arg) {
+    SSL *sides[2] = {client, server};
+    int done[2] = {0, 0};
+
+    for (int round = 0; round < 64 && !(done[0] && done[1]); round++) {
+        for (int side = 0; side < 2; side++) {
+            int ret;
+
+            if (done[side])
+                continue;
+            ret = step != NULL ? step(sides[side], side, arg) : SSL_do_handshake(sides[side]);
+            if (ret == 1)
+                done[side] = 1;
+            else if (!bench_tls_retryable(sides[side], ret))
+                return 0;
+        }
+    }
+    return done[0] && done[1];
+}
+
+static inline int bench_tls_handshake(SSL *client, SSL *server) {
+    return bench_tls_handshake_ex(client, server, NULL, NULL);
+}
+
+/**
+ * Let the client consume post-handshake messages (TLS 1.3 session
+ * tickets) that the server queued after completing its side.
+ */
+static inline void bench_tls_drain(SSL *client) {
+    unsigned char buf[256];
+    int ret = SSL_read(client, buf, sizeof(buf));
+
+    if (ret <= 0 && !bench_tls_retryable(client, ret))
+        ERR_clear_error();
+}
+
+/**
+ * Close and free a connected pair. Sending close_notify first matters:
+ * SSL_free() on a connection that was not shut down marks its session
+ * as non-resumable.
+ */
+static inline void bench_tls_free_pair(SSL *client, SSL *server) {
+    if (client != NULL && SSL_is_init_finished(client))
+        SSL_shutdown(client);
+    if (server != NULL && SSL_is_init_finished(server))
+        SSL_shutdown(server);
+    SSL_free(client);
+    SSL_free(server);
+}
+
+#endif /* SPARETOOLS_BENCH_TLS_H */
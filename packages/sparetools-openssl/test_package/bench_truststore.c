@@ -0,0 +1,255 @@
+#include <openssl/crypto.h>
+#include <openssl/err.h>
+#include <openssl/x509_vfy.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "bench_common.h"
+#include "bench_x509.h"
+#include "sparetools_trustblob.h"
+
+/**
+ * Trust store layout benchmark: what a process pays at startup
+ *
+ * Writes one --roots bundle (150 RSA roots by default, --key EC|ED25519)
+ * in three layouts and, per layout, repeatedly builds a new X509_STORE
+ * and verifies one leaf + 2 intermediates chain against it, the work of
+ * a cold-started serverless handler:
+ *
+ * - pem:     X509_STORE_load_file on the PEM bundle (parses every root)
+ * - hashdir: X509_STORE_load_path on a c_rehash directory (<hash>.<n>
+ *            files read on lookup)
+ * - blob:    sparetools_trustblob_open + _attach on the precompiled blob
+ *            (mapped; roots decoded on lookup)
+ *
+ * Reported per layout: store load time, first verification time, their
+ * sum (cold start) and the verification rate once the store is warm,
+ * where the hashed directory and the blob answer misses differently.
+ * Every verification must succeed.
+ */
+
+typedef enum {
+    LAYOUT_PEM,
+    LAYOUT_HASHDIR,
+    LAYOUT_BLOB
+} store_layout;
+
+static const char *layout_names[] = {"pem", "hashdir", "blob"};
+#define NUM_LAYOUTS 3
+
+static bench_x509_pki pki;
+static char work_dir[64];
+static char pem_path[96], blob_path[96], hash_dir[96];
+
+typedef struct {
+    X509_STORE *store;
+    SPARETOOLS_TRUSTBLOB *blob;
+} loaded_store;
+
+static int load_store(store_layout layout, loaded_store *ls) {
+    memset(ls, 0, sizeof(*ls));
+    if ((ls->store = X509_STORE_new()) == NULL)
+        return 0;
+    switch (layout) {
+    case LAYOUT_PEM:
+        return X509_STORE_load_file(ls->store, pem_path);
+    case LAYOUT_HASHDIR:
+        return X509_STORE_load_path(ls->store, hash_dir);
+    default:
+        return (ls->blob = sparetools_trustblob_open(blob_path)) != NULL
+            && sparetools_trustblob_attach(ls->blob, ls->store);
+    }
+}
+
+static void free_store(loaded_store *ls) {
+    /* The store's lookups reference the blob: free the store first */
+    X509_STORE_free(ls->store);
+    sparetools_trustblob_free(ls->blob);
+}
+
+static int verify(X509_STORE *store) {
+    X509_STORE_CTX *ctx = X509_STORE_CTX_new();
+    int ok = ctx != NULL && X509_STORE_CTX_init(ctx, store, pki.leaf, pki.untrusted)
+        && X509_verify_cert(ctx) == 1;
+
+    if (!ok && ctx != NULL)
+        fprintf(stderr, "ERROR: verification failed: %s\n",
+                X509_verify_cert_error_string(X509_STORE_CTX_get_error(ctx)));
+    X509_STORE_CTX_free(ctx);
+    return ok;
+}
+
+/* c_rehash layout: one PEM file per root, named <subject hash>.<n> */
+static int write_hash_dir(STACK_OF(X509) *certs) {
+    for (int i = 0; i < sk_X509_num(certs); i++) {
+        X509 *cert = sk_X509_value(certs, i);
+        unsigned long hash = X509_NAME_hash_ex(X509_get_subject_name(cert), NULL, NULL, NULL);
+        char path[128];
+        FILE *fp;
+        int ok;
+
+        for (int n = 0;; n++) {
+            snprintf(path, sizeof(path), "%s/%08lx.%d", hash_dir, hash, n);
+            if (access(path, F_OK) != 0)
+                break;
+        }
+        if ((fp = fopen(path, "w")) == NULL)
+            return 0;
+        ok = PEM_write_X509(fp, cert);
+        if (fclose(fp) != 0 || !ok)
+            return 0;
+    }
+    return 1;
+}
+
+static void remove_hash_dir(STACK_OF(X509) *certs) {
+    for (int i = 0; i < sk_X509_num(certs); i++) {
+        unsigned long hash = X509_NAME_hash_ex(X509_get_subject_name(sk_X509_value(certs, i)), NULL, NULL, NULL);
+        char path[128];
+
+        for (int n = 0;; n++) {
+            snprintf(path, sizeof(path), "%s/%08lx.%d", hash_dir, hash, n);
+            if (unlink(path) != 0)
+                break;
+        }
+    }
+    rmdir(hash_dir);
+}
+
+typedef struct {
+    double load_us;
+    double first_verify_us;
+    double warm_rate;
+    int starts;
+} layout_result;
+
+static int run_layout(store_layout layout, double seconds, layout_result *r) {
+    loaded_store ls;
+    double start, t0, t1, load = 0, first = 0;
+    unsigned long long verifies = 0;
+
+    memset(r, 0, sizeof(*r));
+    start = bench_now();
+    do {
+        t0 = bench_now();
+        if (!load_store(layout, &ls)) {
+            ERR_print_errors_fp(stderr);
+            free_store(&ls);
+            return 0;
+        }
+        t1 = bench_now();
+        if (!verify(ls.store)) {
+            free_store(&ls);
+            return 0;
+        }
+        load += t1 - t0;
+        first += bench_now() - t1;
+        r->starts++;
+        free_store(&ls);
+    } while (bench_now() - start < seconds);
+    r->load_us = load / r->starts * 1e6;
+    r->first_verify_us = first / r->starts * 1e6;
+
+    if (!load_store(layout, &ls) || !verify(ls.store)) {
+        free_store(&ls);
+        return 0;
+    }
+    start = bench_now();
+    do {
+        if (!verify(ls.store)) {
+            free_store(&ls);
+            return 0;
+        }
+        verifies++;
+    } while (bench_now() - start < seconds);
+    r->warm_rate = (double)verifies / (bench_now() - start);
+    free_store(&ls);
+    return 1;
+}
+
+int main(int argc, char **argv) {
+    bench_options opts;
+    bench_json json;
+    const char *key_type = "RSA";
+    int num_roots = 150, failures = 0;
+    int argi = bench_parse_args(argc, argv, "bench_truststore.json", &opts);
+
+    if (argi < 0)
+        return 2;
+    for (; argi < argc; argi++) {
+        if (strcmp(argv[argi], "--key") == 0 && argi + 1 < argc) {
+            key_type = argv[++argi];
+        } else if (strcmp(argv[argi], "--roots") == 0 && argi + 1 < argc) {
+            num_roots = atoi(argv[++argi]);
+        } else {
+            fprintf(stderr, "Usage: %s [--quick] [--json PATH] [--key RSA|EC|ED25519] [--roots N]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (num_roots < 1)
+        num_roots = 1;
+
+    printf("=================================\n");
+    printf("Trust Store Layout Benchmark\n");
+    printf("=================================\n");
+    printf("OpenSSL version: %s\n", OpenSSL_version(OPENSSL_VERSION));
+    printf("PKI: %s keys, %d roots, leaf + 2 intermediates\n\n", key_type, num_roots);
+
+    if (bench_x509_make_pki(key_type, num_roots, &pki) != 0)
+        return 1;
+    snprintf(work_dir, sizeof(work_dir), "/tmp/sparetools_trust_XXXXXX");
+    if (mkdtemp(work_dir) == NULL) {
+        perror("mkdtemp");
+        bench_x509_free_pki(&pki);
+        return 1;
+    }
+    snprintf(pem_path, sizeof(pem_path), "%s/cert.pem", work_dir);
+    snprintf(blob_path, sizeof(blob_path), "%s/cert.stb", work_dir);
+    snprintf(hash_dir, sizeof(hash_dir), "%s/certs", work_dir);
+    if (bench_x509_write_pem(pki.roots, pem_path) != 0
+        || sparetools_trustblob_compile(pem_path, blob_path) != num_roots
+        || mkdir(hash_dir, 0700) != 0 || !write_hash_dir(pki.roots)) {
+        fprintf(stderr, "ERROR: Failed to write the trust store layouts in %s\n", work_dir);
+        ERR_print_errors_fp(stderr);
+        failures++;
+        goto done;
+    }
+    if (bench_json_begin(&json, &opts, "truststore") != 0) {
+        failures++;
+        goto done;
+    }
+
+    printf("  %-8s %10s %12s %12s %14s\n", "Layout", "load_us", "verify1_us", "cold_us", "warm verify/s");
+    for (int l = 0; l < NUM_LAYOUTS; l++) {
+        layout_result r;
+        int ok = run_layout((store_layout)l, opts.min_seconds, &r);
+
+        failures += !ok;
+        printf("  %-8s %10.1f %12.1f %12.1f %14.0f%s\n", layout_names[l], r.load_us, r.first_verify_us,
+               r.load_us + r.first_verify_us, r.warm_rate, ok ? "" : "  FAILED");
+        bench_json_record_begin(&json);
+        bench_json_str(&json, "layout", layout_names[l]);
+        bench_json_str(&json, "key_type", key_type);
+        bench_json_int(&json, "roots", (uint64_t)num_roots);
+        bench_json_num(&json, "load_us", r.load_us);
+        bench_json_num(&json, "first_verify_us", r.first_verify_us);
+        bench_json_num(&json, "cold_start_us", r.load_us + r.first_verify_us);
+        bench_json_num(&json, "warm_verifies_per_sec", r.warm_rate);
+        bench_json_int(&json, "starts", (uint64_t)r.starts);
+        bench_json_int(&json, "ok", (uint64_t)ok);
+        bench_json_record_end(&json);
+    }
+    bench_json_end(&json);
+
+done:
+    remove_hash_dir(pki.roots);
+    unlink(blob_path);
+    unlink(pem_path);
+    rmdir(work_dir);
+    bench_x509_free_pki(&pki);
+    printf("\n%s\n", failures ? "✗ Trust store verification failed" : "✓ All layouts verified");
+    return failures ? 1 : 0;
+}
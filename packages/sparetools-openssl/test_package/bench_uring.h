@@ -0,0 +1,205 @@
+#ifndef SPARETOOLS_BENCH_URING_H
+#define SPARETOOLS_BENCH_URING_H
+
+#include <errno.h>
+#include <linux/io_uring.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+/**
+ * Minimal io_uring wrapper for the benchmark binaries (no liburing).
+ *
+ * One ring per server thread, driven with the raw io_uring_setup /
+ * io_uring_enter / io_uring_register system calls the way bench_perf.h
+ * drives perf_event_open. Covers what the reference server needs:
+ * SQE/CQE handling, registered (fixed) buffers and a provided buffer
+ * ring for multishot recv. Kernels or sandboxes without io_uring fail
+ * bench_uring_init and the caller reports the mode as unavailable.
+ */
+
+typedef struct {
+    int fd;
+    unsigned *sq_head, *sq_tail, *sq_mask, *sq_array;
+    unsigned *cq_head, *cq_tail, *cq_mask;
+    struct io_uring_sqe *sqes;
+    struct io_uring_cqe *cqes;
+    void *sq_map, *cq_map;
+    size_t sq_map_size, cq_map_size, sqes_size;
+    unsigned sq_entries;
+    unsigned to_submit;
+} bench_uring;
+
+/* Provided buffer ring (IORING_REGISTER_PBUF_RING, Linux 5.19+) */
+typedef struct {
+    struct io_uring_buf_ring *ring;
+    size_t ring_size;
+    unsigned char *bufs;
+    unsigned entries;
+    unsigned buf_size;
+    unsigned short bgid;
+} bench_uring_pbuf;
+
+static inline void bench_uring_free(bench_uring *u) {
+    if (u->sqes != NULL && u->sqes != MAP_FAILED)
+        munmap(u->sqes, u->sqes_size);
+    if (u->cq_map != NULL && u->cq_map != MAP_FAILED)
+        munmap(u->cq_map, u->cq_map_size);
+    if (u->sq_map != NULL && u->sq_map != MAP_FAILED)
+        munmap(u->sq_map, u->sq_map_size);
+    if (u->fd >= 0)
+        close(u->fd);
+    memset(u, 0, sizeof(*u));
+    u->fd = -1;
+}
+
+/** Set up a ring with `entries` SQEs. Returns 0 on success. */
+static inline int bench_uring_init(bench_uring *u, unsigned entries) {
+    struct io_uring_params p;
+    unsigned char *sq, *cq;
+
+    memset(u, 0, sizeof(*u));
+    memset(&p, 0, sizeof(p));
+    u->fd = (int)syscall(__NR_io_uring_setup, entries, &p);
+    if (u->fd < 0)
+        return 1;
+    u->sq_map_size = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    u->cq_map_size = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+    u->sqes_size = p.sq_entries * sizeof(struct io_uring_sqe);
+    u->sq_map = mmap(NULL, u->sq_map_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, u->fd,
+                     IORING_OFF_SQ_RING);
+    u->cq_map = mmap(NULL, u->cq_map_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, u->fd,
+                     IORING_OFF_CQ_RING);
+    u->sqes = mmap(NULL, u->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, u->fd,
+                   IORING_OFF_SQES);
+    if (u->sq_map == MAP_FAILED || u->cq_map == MAP_FAILED || u->sqes == MAP_FAILED) {
+        bench_uring_free(u);
+        return 1;
+    }
+    sq = u->sq_map;
+    cq = u->cq_map;
+    u->sq_head = (unsigned *)(sq + p.sq_off.head);
+    u->sq_tail = (unsigned *)(sq + p.sq_off.tail);
+    u->sq_mask = (unsigned *)(sq + p.sq_off.ring_mask);
+    u->sq_array = (unsigned *)(sq + p.sq_off.array);
+    u->cq_head = (unsigned *)(cq + p.cq_off.head);
+    u->cq_tail = (unsigned *)(cq + p.cq_off.tail);
+    u->cq_mask = (unsigned *)(cq + p.cq_off.ring_mask);
+    u->cqes = (struct io_uring_cqe *)(cq + p.cq_off.cqes);
+    u->sq_entries = p.sq_entries;
+    return 0;
+}
+
+/** Next free SQE, zeroed, or NULL when the submission queue is full */
+static inline struct io_uring_sqe *bench_uring_sqe(bench_uring *u) {
+    unsigned head = __atomic_load_n(u->sq_head, __ATOMIC_ACQUIRE);
+    unsigned tail = *u->sq_tail + u->to_submit;
+    struct io_uring_sqe *sqe;
+
+    if (tail - head >= u->sq_entries)
+        return NULL;
+    sqe = &u->sqes[tail & *u->sq_mask];
+    memset(sqe, 0, sizeof(*sqe));
+    u->sq_array[tail & *u->sq_mask] = tail & *u->sq_mask;
+    u->to_submit++;
+    return sqe;
+}
+
+/** Submit queued SQEs and wait for at least `wait` completions */
+static inline int bench_uring_enter(bench_uring *u, unsigned wait) {
+    unsigned n = u->to_submit;
+    int ret;
+
+    __atomic_store_n(u->sq_tail, *u->sq_tail + n, __ATOMIC_RELEASE);
+    u->to_submit = 0;
+    do {
+        ret = (int)syscall(__NR_io_uring_enter, u->fd, n, wait, wait ? IORING_ENTER_GETEVENTS : 0, NULL, 0);
+    } while (ret < 0 && errno == EINTR);
+    return ret;
+}
+
+/** Oldest unseen CQE, or NULL */
+static inline struct io_uring_cqe *bench_uring_peek(bench_uring *u) {
+    unsigned head = *u->cq_head;
+
+    if (head == __atomic_load_n(u->cq_tail, __ATOMIC_ACQUIRE))
+        return NULL;
+    return &u->cqes[head & *u->cq_mask];
+}
+
+static inline void bench_uring_seen(bench_uring *u) {
+    __atomic_store_n(u->cq_head, *u->cq_head + 1, __ATOMIC_RELEASE);
+}
+
+/** Register iovecs as fixed buffers (sqe->buf_index). Returns 0 on success. */
+static inline int bench_uring_register_buffers(bench_uring *u, const struct iovec *iov, unsigned n) {
+    return syscall(__NR_io_uring_register, u->fd, IORING_REGISTER_BUFFERS, iov, n) == 0 ? 0 : 1;
+}
+
+/** Hand buffer bid (back) to the kernel */
+static inline void bench_uring_pbuf_add(bench_uring_pbuf *pb, unsigned short bid) {
+    unsigned short tail = pb->ring->tail;
+    struct io_uring_buf *buf = &pb->ring->bufs[tail & (pb->entries - 1)];
+
+    buf->addr = (uint64_t)(uintptr_t)(pb->bufs + (size_t)bid * pb->buf_size);
+    buf->len = pb->buf_size;
+    buf->bid = bid;
+    __atomic_store_n(&pb->ring->tail, (unsigned short)(tail + 1), __ATOMIC_RELEASE);
+}
+
+static inline unsigned char *bench_uring_pbuf_get(bench_uring_pbuf *pb, unsigned short bid) {
+    return pb->bufs + (size_t)bid * pb->buf_size;
+}
+
+/**
+ * Register `entries` (a power of two) buffers of buf_size bytes as group
+ * bgid, for IOSQE_BUFFER_SELECT receives. Returns 0 on success.
+ */
+static inline int bench_uring_pbuf_init(bench_uring *u, bench_uring_pbuf *pb, unsigned short bgid,
+                                        unsigned entries, unsigned buf_size) {
+    struct io_uring_buf_reg reg;
+
+    memset(pb, 0, sizeof(*pb));
+    pb->ring_size = entries * sizeof(struct io_uring_buf);
+    pb->ring = mmap(NULL, pb->ring_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    pb->bufs = mmap(NULL, (size_t)entries * buf_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (pb->ring == MAP_FAILED || pb->bufs == MAP_FAILED) {
+        if (pb->ring != MAP_FAILED)
+            munmap(pb->ring, pb->ring_size);
+        if (pb->bufs != MAP_FAILED)
+            munmap(pb->bufs, (size_t)entries * buf_size);
+        memset(pb, 0, sizeof(*pb));
+        return 1;
+    }
+    pb->entries = entries;
+    pb->buf_size = buf_size;
+    pb->bgid = bgid;
+
+    memset(&reg, 0, sizeof(reg));
+    reg.ring_addr = (uint64_t)(uintptr_t)pb->ring;
+    reg.ring_entries = entries;
+    reg.bgid = bgid;
+    if (syscall(__NR_io_uring_register, u->fd, IORING_REGISTER_PBUF_RING, &reg, 1) != 0) {
+        munmap(pb->ring, pb->ring_size);
+        munmap(pb->bufs, (size_t)entries * buf_size);
+        memset(pb, 0, sizeof(*pb));
+        return 1;
+    }
+    for (unsigned i = 0; i < entries; i++)
+        bench_uring_pbuf_add(pb, (unsigned short)i);
+    return 0;
+}
+
+/* The ring goes away with the io_uring fd; unmap after bench_uring_free */
+static inline void bench_uring_pbuf_free(bench_uring_pbuf *pb) {
+    if (pb->ring != NULL)
+        munmap(pb->ring, pb->ring_size);
+    if (pb->bufs != NULL)
+        munmap(pb->bufs, (size_t)pb->entries * pb->buf_size);
+    memset(pb, 0, sizeof(*pb));
+}
+
+#endif /* SPARETOOLS_BENCH_URING_H */
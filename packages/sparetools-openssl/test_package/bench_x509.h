@@ -0,0 +1,172 @@
+#ifndef SPARETOOLS_BENCH_X509_H
+#define SPARETOOLS_BENCH_X509_H
+
+#include <openssl/err.h>
+#include <openssl/evp.h>
+#include <openssl/pem.h>
+#include <openssl/x509.h>
+#include <openssl/x509v3.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * Shared X.509 helpers for the test_package benchmark binaries.
+ *
+ * Builds a throw-away PKI shaped like a real deployment: a bundle of
+ * num_roots root CAs (like a system CA bundle) and one chain of leaf,
+ * issuing intermediate and policy intermediate anchored at a root in the
+ * middle of the bundle. The roots share one key so that a 150-root RSA
+ * bundle is generated in one key generation; each has its own subject.
+ */
+
+typedef struct {
+    STACK_OF(X509) *roots;      /* Trust anchors (the "CA bundle") */
+    STACK_OF(X509) *untrusted;  /* Intermediates sent by the peer, issuing first */
+    X509 *leaf;
+    int anchor;                 /* Index in roots of the chain's root */
+} bench_x509_pki;
+
+static inline EVP_PKEY *bench_x509_keygen(const char *key_type) {
+    if (strcmp(key_type, "RSA") == 0)
+        return EVP_PKEY_Q_keygen(NULL, NULL, "RSA", (size_t)2048);
+    if (strcmp(key_type, "EC") == 0)
+        return EVP_PKEY_Q_keygen(NULL, NULL, "EC", "P-256");
+    return EVP_PKEY_Q_keygen(NULL, NULL, key_type);
+}
+
+static inline int bench_x509_add_ext(X509 *cert, X509 *issuer, int nid, const char *value) {
+    X509V3_CTX v3;
+    X509_EXTENSION *ext;
+    int ok;
+
+    X509V3_set_ctx_nodb(&v3);
+    X509V3_set_ctx(&v3, issuer, cert, NULL, NULL, 0);
+    if ((ext = X509V3_EXT_conf_nid(NULL, &v3, nid, value)) == NULL)
+        return 0;
+    ok = X509_add_ext(cert, ext, -1);
+    X509_EXTENSION_free(ext);
+    return ok;
+}
+
+/**
+ * Certificate for key with subject CN=cn, signed by issuer_key under
+ * issuer's subject (self-signed when issuer is NULL); md is NULL for
+ * schemes without a separate digest. CA certificates get
+ * basicConstraints CA:TRUE and keyCertSign.
+ */
+static inline X509 *bench_x509_make_cert(EVP_PKEY *key, const char *cn, X509 *issuer,
+                                         EVP_PKEY *issuer_key, const EVP_MD *md, int ca, long serial) {
+    X509 *cert = X509_new();
+    X509_NAME *name;
+
+    if (cert == NULL
+        || !X509_set_version(cert, 2)
+        || !ASN1_INTEGER_set(X509_get_serialNumber(cert), serial)
+        || X509_gmtime_adj(X509_getm_notBefore(cert), -3600) == NULL
+        || X509_gmtime_adj(X509_getm_notAfter(cert), 86400L * 365) == NULL
+        || !X509_set_pubkey(cert, key))
+        goto err;
+    name = X509_get_subject_name(cert);
+    if (!X509_NAME_add_entry_by_txt(name, "O", MBSTRING_ASC, (const unsigned char *)"SpareTools Bench",
+                                    -1, -1, 0)
+        || !X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC, (const unsigned char *)cn, -1, -1, 0)
+        || !X509_set_issuer_name(cert, issuer != NULL ? X509_get_subject_name(issuer) : name))
+        goto err;
+    if (!bench_x509_add_ext(cert, NULL, NID_subject_key_identifier, "hash")
+        || !bench_x509_add_ext(cert, issuer != NULL ? issuer : cert, NID_authority_key_identifier, "keyid")
+        || !bench_x509_add_ext(cert, NULL, NID_basic_constraints, ca ? "critical,CA:TRUE" : "CA:FALSE")
+        || !bench_x509_add_ext(cert, NULL, NID_key_usage,
+                               ca ? "critical,keyCertSign,cRLSign" : "critical,digitalSignature"))
+        goto err;
+    if (!ca && !bench_x509_add_ext(cert, NULL, NID_ext_key_usage, "clientAuth,serverAuth"))
+        goto err;
+    if (!X509_sign(cert, issuer_key, md))
+        goto err;
+    return cert;
+err:
+    X509_free(cert);
+    return NULL;
+}
+
+static inline void bench_x509_free_pki(bench_x509_pki *pki) {
+    sk_X509_pop_free(pki->roots, X509_free);
+    sk_X509_pop_free(pki->untrusted, X509_free);
+    X509_free(pki->leaf);
+    memset(pki, 0, sizeof(*pki));
+}
+
+/**
+ * Generate num_roots roots and a leaf/intermediate/intermediate chain, all
+ * with key_type keys ("RSA" 2048, "EC" P-256 or a parameterless type).
+ * Returns 0 on success.
+ */
+static inline int bench_x509_make_pki(const char *key_type, int num_roots, bench_x509_pki *pki) {
+    EVP_PKEY *root_key = bench_x509_keygen(key_type);
+    EVP_PKEY *policy_key = bench_x509_keygen(key_type);
+    EVP_PKEY *issuing_key = bench_x509_keygen(key_type);
+    EVP_PKEY *leaf_key = bench_x509_keygen(key_type);
+    /* Ed25519, ML-DSA and other pure schemes sign without a digest */
+    const EVP_MD *md = strcmp(key_type, "RSA") == 0 || strcmp(key_type, "EC") == 0 ? EVP_sha256() : NULL;
+    X509 *policy = NULL, *issuing = NULL;
+    char cn[64];
+    int ok = 0;
+
+    memset(pki, 0, sizeof(*pki));
+    pki->anchor = num_roots / 2;
+    if (root_key == NULL || policy_key == NULL || issuing_key == NULL || leaf_key == NULL
+        || (pki->roots = sk_X509_new_null()) == NULL || (pki->untrusted = sk_X509_new_null()) == NULL)
+        goto done;
+
+    for (int i = 0; i < num_roots; i++) {
+        X509 *root;
+
+        snprintf(cn, sizeof(cn), "SpareTools Bench Root CA %03d", i);
+        if ((root = bench_x509_make_cert(root_key, cn, NULL, root_key, md, 1, 1000 + i)) == NULL
+            || !sk_X509_push(pki->roots, root)) {
+            X509_free(root);
+            goto done;
+        }
+    }
+    policy = bench_x509_make_cert(policy_key, "SpareTools Bench Policy CA",
+                                  sk_X509_value(pki->roots, pki->anchor), root_key, md, 1, 2);
+    issuing = policy == NULL ? NULL
+        : bench_x509_make_cert(issuing_key, "SpareTools Bench Issuing CA", policy, policy_key, md, 1, 3);
+    pki->leaf = issuing == NULL ? NULL
+        : bench_x509_make_cert(leaf_key, "client.bench.sparetools.local", issuing, issuing_key, md, 0, 4);
+    if (pki->leaf == NULL || !sk_X509_push(pki->untrusted, issuing))
+        goto done;
+    issuing = NULL;
+    if (!sk_X509_push(pki->untrusted, policy))
+        goto done;
+    policy = NULL;
+    ok = 1;
+
+done:
+    if (!ok) {
+        fprintf(stderr, "ERROR: Failed to create %s test PKI\n", key_type);
+        ERR_print_errors_fp(stderr);
+        bench_x509_free_pki(pki);
+    }
+    X509_free(policy);
+    X509_free(issuing);
+    EVP_PKEY_free(root_key);
+    EVP_PKEY_free(policy_key);
+    EVP_PKEY_free(issuing_key);
+    EVP_PKEY_free(leaf_key);
+    return ok ? 0 : 1;
+}
+
+/** Write certs as a PEM bundle. Returns 0 on success. */
+static inline int bench_x509_write_pem(STACK_OF(X509) *certs, const char *path) {
+    FILE *fp = fopen(path, "w");
+    int ok = fp != NULL;
+
+    for (int i = 0; ok && i < sk_X509_num(certs); i++)
+        ok = PEM_write_X509(fp, sk_X509_value(certs, i));
+    if (fp != NULL && fclose(fp) != 0)
+        ok = 0;
+    return ok ? 0 : 1;
+}
+
+#endif /* SPARETOOLS_BENCH_X509_H */
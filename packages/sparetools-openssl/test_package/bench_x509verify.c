@@ -0,0 +1,247 @@
+#include <openssl/crypto.h>
+#include <openssl/err.h>
+#include <openssl/x509_vfy.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "bench_common.h"
+#include "bench_x509.h"
+#include "sparetools_x509store.h"
+
+/**
+ * X.509 chain verification benchmark
+ *
+ * Verifies a client chain (leaf + issuing intermediate + policy
+ * intermediate) against a bundle of --roots root CAs, the mTLS check an
+ * API gateway runs per connection, on 1..nproc threads:
+ *
+ * - cold:  every verification loads the PEM bundle into a new X509_STORE
+ *          (processes that rebuild their store per connection or reload)
+ * - warm:  one X509_STORE loaded once and shared, X509_STORE_CTX_new and
+ *          _free around every X509_verify_cert, the usual pattern
+ * - index: SPARETOOLS_X509STORE, the shared store with the lock-free
+ *          subject index and one reused X509_STORE_CTX per thread
+ *
+ * Every verification must succeed; a failure fails the run. Reported per
+ * mode and thread count: verifications/s and the speedup over warm.
+ *
+ * --key RSA|EC|ED25519 selects the key type of the PKI (EC P-256 by
+ * default), --roots N the bundle size (150) and --max-threads N the
+ * upper bound of the thread counts (online CPUs).
+ */
+
+typedef enum {
+    MODE_COLD,
+    MODE_WARM,
+    MODE_INDEX
+} verify_mode;
+
+static const char *mode_names[] = {"cold", "warm", "index"};
+#define NUM_MODES 3
+
+static bench_x509_pki pki;
+static char bundle_path[64];
+static X509_STORE *warm_store;
+static SPARETOOLS_X509STORE *index_store;
+
+static atomic_int start_flag;
+static atomic_int stop_flag;
+
+typedef struct {
+    pthread_t thread;
+    verify_mode mode;
+    unsigned long long verifies;
+    int failed;
+    int error;
+} thread_arg;
+
+static int verify_with_store(X509_STORE *store, int *error) {
+    X509_STORE_CTX *ctx = X509_STORE_CTX_new();
+    int ok = ctx != NULL && X509_STORE_CTX_init(ctx, store, pki.leaf, pki.untrusted)
+        && X509_verify_cert(ctx) == 1;
+
+    if (ctx != NULL)
+        *error = X509_STORE_CTX_get_error(ctx);
+    X509_STORE_CTX_free(ctx);
+    return ok;
+}
+
+static int verify_once(verify_mode mode, int *error) {
+    X509_STORE *store;
+    int ok;
+
+    switch (mode) {
+    case MODE_COLD:
+        if ((store = X509_STORE_new()) == NULL)
+            return 0;
+        ok = X509_STORE_load_file(store, bundle_path) && verify_with_store(store, error);
+        X509_STORE_free(store);
+        return ok;
+    case MODE_WARM:
+        return verify_with_store(warm_store, error);
+    default:
+        return sparetools_x509store_verify(index_store, pki.leaf, pki.untrusted, error);
+    }
+}
+
+static void *worker(void *p) {
+    thread_arg *arg = p;
+
+    while (!atomic_load(&start_flag))
+        ;
+    while (!atomic_load(&stop_flag)) {
+        if (!verify_once(arg->mode, &arg->error)) {
+            arg->failed = 1;
+            break;
+        }
+        arg->verifies++;
+    }
+    ERR_clear_error();
+    return NULL;
+}
+
+/* Verifications per second, or a negative value if any verification failed */
+static double run_threads(verify_mode mode, int nthreads, double seconds) {
+    thread_arg *args = calloc((size_t)nthreads, sizeof(*args));
+    unsigned long long verifies = 0;
+    double start, elapsed;
+    int failed = args == NULL, started = 0;
+
+    atomic_store(&start_flag, 0);
+    atomic_store(&stop_flag, 0);
+    for (int t = 0; !failed && t < nthreads; t++) {
+        args[t].mode = mode;
+        if (pthread_create(&args[t].thread, NULL, worker, &args[t]) != 0) {
+            failed = 1;
+            break;
+        }
+        started++;
+    }
+
+    start = bench_now();
+    atomic_store(&start_flag, 1);
+    while (!failed && bench_now() - start < seconds)
+        usleep(1000);
+    atomic_store(&stop_flag, 1);
+
+    for (int t = 0; t < started; t++) {
+        pthread_join(args[t].thread, NULL);
+        verifies += args[t].verifies;
+        if (args[t].failed && !failed) {
+            fprintf(stderr, "ERROR: %s verification failed: %s\n", mode_names[mode],
+                    X509_verify_cert_error_string(args[t].error));
+            failed = 1;
+        }
+    }
+    elapsed = bench_now() - start;
+    free(args);
+    return failed ? -1.0 : (double)verifies / elapsed;
+}
+
+/* 1, 2, 4, ... max_threads, then 0 */
+static int next_thread_count(int n, int max) {
+    if (n >= max)
+        return 0;
+    return n * 2 > max ? max : n * 2;
+}
+
+int main(int argc, char **argv) {
+    bench_options opts;
+    bench_json json;
+    const char *key_type = "EC";
+    int num_roots = 150, failures = 0, max_threads, fd;
+    long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+    int argi = bench_parse_args(argc, argv, "bench_x509verify.json", &opts);
+
+    if (argi < 0)
+        return 2;
+    max_threads = ncpu > 0 ? (int)ncpu : 1;
+    for (; argi < argc; argi++) {
+        if (strcmp(argv[argi], "--key") == 0 && argi + 1 < argc) {
+            key_type = argv[++argi];
+        } else if (strcmp(argv[argi], "--roots") == 0 && argi + 1 < argc) {
+            num_roots = atoi(argv[++argi]);
+        } else if (strcmp(argv[argi], "--max-threads") == 0 && argi + 1 < argc) {
+            max_threads = atoi(argv[++argi]);
+        } else {
+            fprintf(stderr, "Usage: %s [--quick] [--json PATH] [--key RSA|EC|ED25519] [--roots N] "
+                    "[--max-threads N]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (num_roots < 1)
+        num_roots = 1;
+    if (max_threads < 1)
+        max_threads = 1;
+    if (opts.quick && max_threads > 4)
+        max_threads = 4;
+
+    printf("=================================\n");
+    printf("X.509 Chain Verification Benchmark\n");
+    printf("=================================\n");
+    printf("OpenSSL version: %s\n", OpenSSL_version(OPENSSL_VERSION));
+    printf("PKI: %s keys, %d roots, leaf + 2 intermediates\n\n", key_type, num_roots);
+
+    if (bench_x509_make_pki(key_type, num_roots, &pki) != 0)
+        return 1;
+    snprintf(bundle_path, sizeof(bundle_path), "/tmp/sparetools_roots_XXXXXX");
+    if ((fd = mkstemp(bundle_path)) < 0) {
+        perror("mkstemp");
+        bench_x509_free_pki(&pki);
+        return 1;
+    }
+    close(fd);
+    if (bench_x509_write_pem(pki.roots, bundle_path) != 0
+        || (warm_store = X509_STORE_new()) == NULL
+        || !X509_STORE_load_file(warm_store, bundle_path)
+        || (index_store = sparetools_x509store_load(bundle_path)) == NULL
+        || sparetools_x509store_count(index_store) != num_roots) {
+        fprintf(stderr, "ERROR: Failed to load the %d-root bundle\n", num_roots);
+        ERR_print_errors_fp(stderr);
+        failures++;
+        goto done;
+    }
+    if (bench_json_begin(&json, &opts, "x509verify") != 0) {
+        failures++;
+        goto done;
+    }
+
+    printf("  %-6s %7s %14s %9s\n", "Mode", "Threads", "verifies/s", "vs warm");
+    for (int threads = 1; threads != 0; threads = next_thread_count(threads, max_threads)) {
+        double rates[NUM_MODES];
+
+        /* Warm first: it is the baseline of the other modes */
+        rates[MODE_WARM] = run_threads(MODE_WARM, threads, opts.min_seconds);
+        rates[MODE_COLD] = run_threads(MODE_COLD, threads, opts.min_seconds);
+        rates[MODE_INDEX] = run_threads(MODE_INDEX, threads, opts.min_seconds);
+        for (int m = 0; m < NUM_MODES; m++) {
+            double speedup = rates[MODE_WARM] > 0 && rates[m] > 0 ? rates[m] / rates[MODE_WARM] : 0.0;
+
+            failures += rates[m] < 0;
+            printf("  %-6s %7d %14.0f %8.2fx%s\n", mode_names[m], threads, rates[m] > 0 ? rates[m] : 0.0,
+                   speedup, rates[m] < 0 ? "  FAILED" : "");
+            bench_json_record_begin(&json);
+            bench_json_str(&json, "mode", mode_names[m]);
+            bench_json_str(&json, "key_type", key_type);
+            bench_json_int(&json, "roots", (uint64_t)num_roots);
+            bench_json_int(&json, "threads", (uint64_t)threads);
+            bench_json_num(&json, "verifies_per_sec", rates[m] > 0 ? rates[m] : 0.0);
+            bench_json_num(&json, "speedup_vs_warm", speedup);
+            bench_json_int(&json, "ok", (uint64_t)(rates[m] >= 0));
+            bench_json_record_end(&json);
+        }
+    }
+    bench_json_end(&json);
+
+done:
+    sparetools_x509store_free(index_store);
+    X509_STORE_free(warm_store);
+    unlink(bundle_path);
+    bench_x509_free_pki(&pki);
+    printf("\n%s\n", failures ? "✗ Chain verification failed" : "✓ All chains verified");
+    return failures ? 1 : 0;
+}
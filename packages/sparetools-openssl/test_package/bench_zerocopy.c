@@ -0,0 +1,511 @@
+#include <openssl/bio.h>
+#include <openssl/crypto.h>
+#include <openssl/err.h>
+#include <openssl/ssl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "bench_common.h"
+#include "bench_tls.h"
+#include "sparetools_ringbio.h"
+
+/**
+ * BIO copy overhead benchmark
+ *
+ * An event loop that feeds libssl from its own buffers pays for every
+ * copy between the socket and the record layer. This measures the
+ * transports such a loop can use, first moving opaque records (1 KiB and
+ * 16 KiB) from a writer BIO to a reader buffer, then streaming TLS 1.3
+ * (AES-128-GCM) client to server:
+ *
+ * - mem:        BIO_s_mem per direction; the loop moves bytes with
+ *               BIO_read into its buffer and BIO_write into the peer BIO
+ *               (what recv()/send() around memory BIOs cost, minus the
+ *               kernel)
+ * - bio_pair:   BIO_new_bio_pair, the peer reads the writer's buffer
+ * - dgram_pair: BIO_s_dgram_pair (OpenSSL 3.2+), one datagram per record,
+ *               and dgram_pair-mmsg with BIO_sendmmsg/BIO_recvmmsg in
+ *               batches of MMSG_BATCH (records only: TLS needs a stream);
+ *               the MTU is raised to 16 KiB, and a size above the MTU the
+ *               pair keeps is skipped
+ * - socket:     BIO_new_socket over an AF_UNIX stream socketpair, and
+ *               dgram-mmsg: BIO_new_dgram over a datagram socketpair with
+ *               BIO_sendmmsg/BIO_recvmmsg (3.2+, records only)
+ * - ring:       sparetools_ringbio over caller-owned rings; the loop
+ *               sends from and receives into the rings themselves, so in
+ *               one process the writer's output ring is the reader's input
+ *
+ * Records carry "copies": user-space memcpy per byte between the writer's
+ * buffer and the reader's, excluding the kernel's.
+ */
+
+#define RECORD_MAX 16384
+#define RING_SIZE 65536
+#define MMSG_BATCH 16
+/* dgram_pair buffers: a whole batch of the largest records, with headers */
+#define DGRAM_BUF_SIZE (2 * MMSG_BATCH * RECORD_MAX)
+/* Attempts at a BIO call that asks to be retried */
+#define RETRY_ROUNDS 1000
+#define TLS_WRITE_SIZE 16384
+
+static const size_t record_sizes[] = {1024, RECORD_MAX};
+#define NUM_RECORD_SIZES (sizeof(record_sizes) / sizeof(record_sizes[0]))
+
+typedef enum {
+    T_MEM,
+    T_BIO_PAIR,
+    T_DGRAM_PAIR,
+    T_DGRAM_PAIR_MMSG,
+    T_SOCKET,
+    T_DGRAM_MMSG,
+    T_RING
+} transport_id;
+
+typedef struct {
+    transport_id id;
+    const char *name;
+    int copies;
+    int tls;            /* Also run the TLS stream over it */
+} transport;
+
+static const transport transports[] = {
+    {T_MEM, "mem", 4, 1},
+    {T_BIO_PAIR, "bio_pair", 2, 1},
+    {T_DGRAM_PAIR, "dgram_pair", 2, 0},
+    {T_DGRAM_PAIR_MMSG, "dgram_pair-mmsg", 2, 0},
+    {T_SOCKET, "socket", 2, 1},
+    {T_DGRAM_MMSG, "dgram-mmsg", 2, 0},
+    {T_RING, "ring", 2, 1},
+};
+#define NUM_TRANSPORTS (sizeof(transports) / sizeof(transports[0]))
+
+/*
+ * One direction of a transport: the writer writes to w, the reader reads
+ * from r. mem adds the loop's shuttle through staging between them.
+ */
+typedef struct {
+    BIO *w, *r;
+    SPARETOOLS_RING ring;
+    unsigned char *ring_data;
+    unsigned char *staging;
+    int fds[2];
+    size_t max_datagram;    /* Largest record the link carries, 0 for streams */
+} link_end;
+
+static void close_link(link_end *l) {
+    if (l->r != l->w)
+        BIO_free(l->r);
+    BIO_free(l->w);
+    free(l->ring_data);
+    free(l->staging);
+    if (l->fds[0] >= 0)
+        close(l->fds[0]);
+    if (l->fds[1] >= 0)
+        close(l->fds[1]);
+    memset(l, 0, sizeof(*l));
+    l->fds[0] = l->fds[1] = -1;
+}
+
+/* Returns 0 when the transport does not exist in this build */
+static int open_link(transport_id id, link_end *l) {
+    memset(l, 0, sizeof(*l));
+    l->fds[0] = l->fds[1] = -1;
+    switch (id) {
+    case T_MEM:
+        l->w = BIO_new(BIO_s_mem());
+        l->r = BIO_new(BIO_s_mem());
+        l->staging = malloc(RING_SIZE);
+        if (l->w == NULL || l->r == NULL || l->staging == NULL)
+            return 0;
+        /* Empty memory BIOs signal retry instead of EOF */
+        BIO_set_mem_eof_return(l->w, -1);
+        BIO_set_mem_eof_return(l->r, -1);
+        return 1;
+    case T_BIO_PAIR:
+        return BIO_new_bio_pair(&l->w, RING_SIZE, &l->r, RING_SIZE);
+    case T_DGRAM_PAIR:
+    case T_DGRAM_PAIR_MMSG:
+#if OPENSSL_VERSION_NUMBER >= 0x30200000L
+        if (!BIO_new_bio_dgram_pair(&l->w, DGRAM_BUF_SIZE, &l->r, DGRAM_BUF_SIZE))
+            return 0;
+        /* The default MTU may be below RECORD_MAX; sizes above what it keeps are skipped */
+        BIO_ctrl(l->w, BIO_CTRL_DGRAM_SET_MTU, RECORD_MAX, NULL);
+        BIO_ctrl(l->r, BIO_CTRL_DGRAM_SET_MTU, RECORD_MAX, NULL);
+        ERR_clear_error();
+        l->max_datagram = (size_t)BIO_ctrl(l->w, BIO_CTRL_DGRAM_GET_MTU, 0, NULL);
+        if (l->max_datagram == 0 || l->max_datagram > RECORD_MAX)
+            l->max_datagram = RECORD_MAX;
+        return 1;
+#else
+        return 0;
+#endif
+    case T_SOCKET:
+        if (socketpair(AF_UNIX, SOCK_STREAM, 0, l->fds) != 0)
+            return 0;
+        l->w = BIO_new_socket(l->fds[0], BIO_NOCLOSE);
+        l->r = BIO_new_socket(l->fds[1], BIO_NOCLOSE);
+        return l->w != NULL && l->r != NULL && BIO_socket_nbio(l->fds[0], 1) && BIO_socket_nbio(l->fds[1], 1);
+    case T_DGRAM_MMSG:
+#if OPENSSL_VERSION_NUMBER >= 0x30200000L
+        if (socketpair(AF_UNIX, SOCK_DGRAM, 0, l->fds) != 0)
+            return 0;
+        l->w = BIO_new_dgram(l->fds[0], BIO_NOCLOSE);
+        l->r = BIO_new_dgram(l->fds[1], BIO_NOCLOSE);
+        return l->w != NULL && l->r != NULL && BIO_socket_nbio(l->fds[0], 1) && BIO_socket_nbio(l->fds[1], 1);
+#else
+        return 0;
+#endif
+    default:
+        if ((l->ring_data = malloc(RING_SIZE)) == NULL
+            || !sparetools_ring_init(&l->ring, l->ring_data, RING_SIZE))
+            return 0;
+        l->w = sparetools_ringbio_new(NULL, &l->ring);
+        l->r = sparetools_ringbio_new(&l->ring, NULL);
+        return l->w != NULL && l->r != NULL;
+    }
+}
+
+/* mem: what the event loop does between send() and recv() */
+static void shuttle(link_end *l) {
+    int n;
+
+    while ((n = BIO_read(l->w, l->staging, RING_SIZE)) > 0)
+        BIO_write(l->r, l->staging, n);
+}
+
+static void pump(transport_id id, link_end *l) {
+    if (id == T_MEM)
+        shuttle(l);
+}
+
+/* Move one record writer -> reader; returns 1 on success */
+static int move_record(transport_id id, link_end *l, const unsigned char *rec, size_t len,
+                       unsigned char *dest) {
+    size_t got = 0;
+    int round = 0, n;
+
+    /* A transient failure (full buffer) is retried; anything else is fatal */
+    while ((n = BIO_write(l->w, rec, (int)len)) != (int)len) {
+        if (n > 0 || !BIO_should_retry(l->w) || ++round == RETRY_ROUNDS)
+            return 0;
+        ERR_clear_error();
+    }
+    pump(id, l);
+    for (round = 0; got < len;) {
+        n = BIO_read(l->r, dest + got, (int)(len - got));
+        if (n > 0) {
+            got += (size_t)n;
+            continue;
+        }
+        if (!BIO_should_retry(l->r) || ++round == RETRY_ROUNDS)
+            return 0;
+        ERR_clear_error();
+        pump(id, l);
+    }
+    return 1;
+}
+
+#if OPENSSL_VERSION_NUMBER >= 0x30200000L
+/* MMSG_BATCH records per BIO_sendmmsg / BIO_recvmmsg call */
+static int move_batch(link_end *l, const unsigned char *rec, size_t len, unsigned char *dest) {
+    BIO_MSG out[MMSG_BATCH], in[MMSG_BATCH];
+    size_t sent = 0, received = 0;
+
+    memset(out, 0, sizeof(out));
+    memset(in, 0, sizeof(in));
+    for (int i = 0; i < MMSG_BATCH; i++) {
+        out[i].data = (void *)rec;
+        out[i].data_len = len;
+        in[i].data = dest + (size_t)i * RECORD_MAX;
+        in[i].data_len = RECORD_MAX;
+    }
+    /* A full peer buffer takes several rounds; a stuck one fails */
+    for (int round = 0; received < MMSG_BATCH; round++) {
+        size_t n = 0;
+
+        if (round == RETRY_ROUNDS)
+            return 0;
+        if (sent < MMSG_BATCH && BIO_sendmmsg(l->w, out + sent, sizeof(BIO_MSG), MMSG_BATCH - sent, 0, &n))
+            sent += n;
+        n = 0;
+        if (sent > received && BIO_recvmmsg(l->r, in + received, sizeof(BIO_MSG), sent - received, 0, &n)) {
+            for (size_t i = received; i < received + n; i++) {
+                if (in[i].data_len != len)
+                    return 0;
+            }
+            received += n;
+        }
+        ERR_clear_error();
+    }
+    return 1;
+}
+#endif
+
+/*
+ * Bytes per second through one transport, 0 when it does not exist,
+ * *too_large when len exceeds its datagrams, or a negative value on failure
+ */
+static double run_records(const transport *t, size_t len, double seconds, int *too_large) {
+    unsigned char *rec = malloc(RECORD_MAX), *dest = malloc((size_t)MMSG_BATCH * RECORD_MAX);
+    unsigned long long bytes = 0;
+    double start, elapsed;
+    link_end l;
+    int ok = open_link(t->id, &l);
+
+    *too_large = ok && l.max_datagram != 0 && len > l.max_datagram;
+    if (rec == NULL || dest == NULL || !ok || *too_large) {
+        free(rec);
+        free(dest);
+        close_link(&l);
+        return 0.0;
+    }
+    memset(rec, 0x3c, RECORD_MAX);
+    start = bench_now();
+    do {
+#if OPENSSL_VERSION_NUMBER >= 0x30200000L
+        if (t->id == T_DGRAM_PAIR_MMSG || t->id == T_DGRAM_MMSG) {
+            ok = move_batch(&l, rec, len, dest);
+            bytes += ok ? (unsigned long long)len * MMSG_BATCH : 0;
+        } else
+#endif
+        {
+            ok = move_record(t->id, &l, rec, len, dest);
+            bytes += ok ? len : 0;
+        }
+        elapsed = bench_now() - start;
+    } while (ok && elapsed < seconds);
+    close_link(&l);
+    free(rec);
+    free(dest);
+    return ok ? (double)bytes / elapsed : -1.0;
+}
+
+/* TLS client/server over two links (client->server and server->client) */
+typedef struct {
+    link_end c2s, s2c;
+    SSL *client, *server;
+} tls_conn;
+
+static void close_tls(tls_conn *c) {
+    /* The SSL objects own the BIOs the links point at */
+    SSL_free(c->client);
+    SSL_free(c->server);
+    c->c2s.w = c->c2s.r = c->s2c.w = c->s2c.r = NULL;
+    close_link(&c->c2s);
+    close_link(&c->s2c);
+}
+
+static int open_tls(const transport *t, SSL_CTX *client_ctx, SSL_CTX *server_ctx, tls_conn *c) {
+    memset(c, 0, sizeof(*c));
+    c->c2s.fds[0] = c->c2s.fds[1] = c->s2c.fds[0] = c->s2c.fds[1] = -1;
+    if ((c->client = SSL_new(client_ctx)) == NULL || (c->server = SSL_new(server_ctx)) == NULL)
+        return 0;
+    if (t->id == T_BIO_PAIR) {
+        /* One pair carries both directions */
+        if (!BIO_new_bio_pair(&c->c2s.w, RING_SIZE, &c->c2s.r, RING_SIZE))
+            return 0;
+        SSL_set_bio(c->client, c->c2s.w, c->c2s.w);
+        SSL_set_bio(c->server, c->c2s.r, c->c2s.r);
+    } else if (t->id == T_SOCKET) {
+        if (socketpair(AF_UNIX, SOCK_STREAM, 0, c->c2s.fds) != 0
+            || !BIO_socket_nbio(c->c2s.fds[0], 1) || !BIO_socket_nbio(c->c2s.fds[1], 1)
+            || !SSL_set_fd(c->client, c->c2s.fds[0]) || !SSL_set_fd(c->server, c->c2s.fds[1]))
+            return 0;
+    } else {
+        if (!open_link(t->id, &c->c2s) || !open_link(t->id, &c->s2c))
+            return 0;
+        if (t->id == T_RING) {
+            /* Each side's BIO reads one ring and writes the other */
+            BIO_free(c->c2s.w);
+            BIO_free(c->c2s.r);
+            BIO_free(c->s2c.w);
+            BIO_free(c->s2c.r);
+            c->c2s.w = c->c2s.r = sparetools_ringbio_new(&c->s2c.ring, &c->c2s.ring);
+            c->s2c.w = c->s2c.r = sparetools_ringbio_new(&c->c2s.ring, &c->s2c.ring);
+            if (c->c2s.w == NULL || c->s2c.w == NULL)
+                return 0;
+            SSL_set_bio(c->client, c->c2s.w, c->c2s.w);
+            SSL_set_bio(c->server, c->s2c.w, c->s2c.w);
+        } else {
+            SSL_set_bio(c->client, c->s2c.r, c->c2s.w);
+            SSL_set_bio(c->server, c->c2s.r, c->s2c.w);
+        }
+    }
+    SSL_set_connect_state(c->client);
+    SSL_set_accept_state(c->server);
+    return 1;
+}
+
+static void pump_tls(const transport *t, tls_conn *c) {
+    if (t->id == T_MEM) {
+        shuttle(&c->c2s);
+        shuttle(&c->s2c);
+    }
+}
+
+typedef struct {
+    const transport *t;
+    tls_conn *c;
+} pump_arg;
+
+/* Handshake step, then moving its output across a T_MEM transport */
+static int pumped_step(SSL *ssl, int is_server, void *arg) {
+    pump_arg *p = arg;
+    int ret = SSL_do_handshake(ssl);
+
+    (void)is_server;
+    pump_tls(p->t, p->c);
+    return ret;
+}
+
+static int tls_handshake(const transport *t, tls_conn *c) {
+    pump_arg p = {t, c};
+
+    return bench_tls_handshake_ex(c->client, c->server, pumped_step, &p);
+}
+
+/* TLS application bytes per second client -> server, or negative on failure */
+static double run_tls(const transport *t, SSL_CTX *client_ctx, SSL_CTX *server_ctx, double seconds) {
+    unsigned char *buf = malloc(TLS_WRITE_SIZE), *dest = malloc(TLS_WRITE_SIZE);
+    unsigned long long bytes = 0;
+    double start, elapsed = 0;
+    tls_conn c;
+    int ok = open_tls(t, client_ctx, server_ctx, &c) && buf != NULL && dest != NULL
+        && tls_handshake(t, &c);
+
+    if (buf != NULL)
+        memset(buf, 0x5e, TLS_WRITE_SIZE);
+    start = bench_now();
+    while (ok && elapsed < seconds) {
+        size_t got = 0;
+        int n = SSL_write(c.client, buf, TLS_WRITE_SIZE);
+
+        ok = n == TLS_WRITE_SIZE;
+        pump_tls(t, &c);
+        while (ok && got < TLS_WRITE_SIZE) {
+            n = SSL_read(c.server, dest + got, (int)(TLS_WRITE_SIZE - got));
+            if (n > 0)
+                got += (size_t)n;
+            else
+                ok = bench_tls_retryable(c.server, n);
+            /* Session tickets and other post-handshake data for the client */
+            if (ok && n <= 0)
+                pump_tls(t, &c);
+        }
+        bytes += got;
+        elapsed = bench_now() - start;
+    }
+    close_tls(&c);
+    free(buf);
+    free(dest);
+    return ok ? (double)bytes / elapsed : -1.0;
+}
+
+static void report(bench_json *json, const char *kind, const transport *t, size_t len, double rate) {
+    printf("  %-6s %-16s %8zu %10.2f Gbit/s  copies=%d\n", kind, t->name, len, rate * 8.0 / 1e9, t->copies);
+    bench_json_record_begin(json);
+    bench_json_str(json, "kind", kind);
+    bench_json_str(json, "transport", t->name);
+    bench_json_int(json, "available", 1);
+    bench_json_int(json, "record_bytes", (uint64_t)len);
+    bench_json_int(json, "copies", (uint64_t)t->copies);
+    bench_json_num(json, "gbit_per_s", rate * 8.0 / 1e9);
+    bench_json_record_end(json);
+}
+
+static void report_unavailable(bench_json *json, const char *kind, const transport *t) {
+    printf("  %-6s %-16s not available\n", kind, t->name);
+    bench_json_record_begin(json);
+    bench_json_str(json, "kind", kind);
+    bench_json_str(json, "transport", t->name);
+    bench_json_int(json, "available", 0);
+    bench_json_record_end(json);
+}
+
+int main(int argc, char **argv) {
+    bench_options opts;
+    bench_json json;
+    EVP_PKEY *pkey = NULL;
+    X509 *cert = NULL;
+    SSL_CTX *client_ctx = NULL, *server_ctx = NULL;
+    int failures = 0;
+
+    if (bench_parse_args(argc, argv, "bench_zerocopy.json", &opts) != argc)
+        return 2;
+
+    printf("=================================\n");
+    printf("BIO Copy Overhead Benchmark\n");
+    printf("=================================\n");
+    printf("OpenSSL version: %s\n\n", OpenSSL_version(OPENSSL_VERSION));
+    if (bench_tls_make_cert("EC", &pkey, &cert) != 0
+        || bench_tls_make_ctx_pair(pkey, cert, &client_ctx, &server_ctx) != 0) {
+        X509_free(cert);
+        EVP_PKEY_free(pkey);
+        return 1;
+    }
+    SSL_CTX_set_ciphersuites(client_ctx, "TLS_AES_128_GCM_SHA256");
+    SSL_CTX_set_ciphersuites(server_ctx, "TLS_AES_128_GCM_SHA256");
+    if (bench_json_begin(&json, &opts, "zerocopy") != 0) {
+        failures++;
+        goto done;
+    }
+
+    for (size_t i = 0; i < NUM_TRANSPORTS; i++) {
+        const transport *t = &transports[i];
+
+        for (size_t s = 0; s < NUM_RECORD_SIZES; s++) {
+            int too_large;
+            double rate = run_records(t, record_sizes[s], opts.min_seconds, &too_large);
+
+            if (too_large) {
+                printf("  %-6s %-16s %6zu bytes exceed the datagram MTU, skipped\n", "record", t->name,
+                       record_sizes[s]);
+                continue;
+            }
+            if (rate == 0.0) {
+                report_unavailable(&json, "record", t);
+                ERR_clear_error();
+                break;
+            }
+            if (rate < 0) {
+                fprintf(stderr, "ERROR: %s failed at %zu bytes\n", t->name, record_sizes[s]);
+                ERR_print_errors_fp(stderr);
+                failures++;
+                break;
+            }
+            report(&json, "record", t, record_sizes[s], rate);
+        }
+    }
+    for (size_t i = 0; i < NUM_TRANSPORTS; i++) {
+        const transport *t = &transports[i];
+        double rate;
+
+        if (!t->tls)
+            continue;
+        if ((rate = run_tls(t, client_ctx, server_ctx, opts.min_seconds)) < 0) {
+            fprintf(stderr, "ERROR: TLS over %s failed\n", t->name);
+            ERR_print_errors_fp(stderr);
+            failures++;
+            continue;
+        }
+        report(&json, "tls", t, TLS_WRITE_SIZE, rate);
+    }
+    bench_json_end(&json);
+
+done:
+    SSL_CTX_free(client_ctx);
+    SSL_CTX_free(server_ctx);
+    X509_free(cert);
+    EVP_PKEY_free(pkey);
+
+    printf("\n=================================\n");
+    if (failures == 0) {
+        printf("✅ BIO copy benchmark completed (%s)\n", opts.json_path);
+        return 0;
+    }
+    printf("❌ %d benchmark(s) FAILED\n", failures);
+    return 1;
+}
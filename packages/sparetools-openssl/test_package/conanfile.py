@@ -3,6 +3,16 @@ from conan.tools.build import can_run
 from conan.tools.cmake import cmake_layout, CMake
 import os
 
+# Throughput floors (MB/s, 16 KiB buffers) for test_perf_floor. AES-GCM's
+# sits well below the assembly paths on any supported CPU and well above
+# the portable C code (no-asm, undetected AES-NI/PCLMULQDQ or ARMv8 CE).
+# SHA-256 asm is only about 2x the optimized C code, so its floor catches
+# -O0 builds rather than no-asm. Arches without an entry are not gated.
+PERF_FLOORS = {
+    "x86_64": {"AES-128-GCM": 1000, "SHA2-256": 150},
+    "armv8": {"AES-128-GCM": 600, "SHA2-256": 150},
+}
+
 
 class SpareToolsOpenSSLTestConan(ConanFile):
     settings = "os", "compiler", "build_type", "arch"
@@ -28,6 +38,20 @@ class SpareToolsOpenSSLTestConan(ConanFile):
         cmake.configure()
         cmake.build()
 
+    def _perf_floor_args(self):
+        """--floor arguments for test_perf_floor, None where the package is meant to be slow"""
+        tested = self.dependencies[self.tested_reference_str.split("/")[0]].options
+        # Option values are objects, not bools: compare their string form
+        if (str(tested.get_safe("enable_asm")) == "False" or str(tested.get_safe("fuzzing", "off")) != "off"
+                or str(tested.get_safe("pgo")) == "generate"):
+            return None
+        # Slow or emulated runners scale the floors down; 0 disables the check
+        scale = float(self.conf.get("user.sparetools:perf_floor_scale", default=1.0))
+        floors = PERF_FLOORS.get(str(self.settings.arch), {})
+        if scale <= 0 or not floors:
+            return None
+        return " ".join(f"--floor {name}={floor * scale:g}" for name, floor in floors.items())
+
     def test(self):
         if can_run(self):
             cmake = CMake(self)
@@ -36,6 +60,13 @@ class SpareToolsOpenSSLTestConan(ConanFile):
             bin_path = os.path.join(self.cpp.build.bindir, "test_openssl")
             self.run(bin_path, env="conanrun")
 
+            # Time-boxed (about 1 s) AES-GCM and SHA-256 throughput against
+            # the arch floors: catches no-asm or debug builds passed as Release
+            floor_args = self._perf_floor_args()
+            if floor_args is not None:
+                floor_path = os.path.join(self.cpp.build.bindir, "test_perf_floor")
+                self.run(f'"{floor_path}" --json test_perf_floor.json {floor_args}', env="conanrun")
+
             # Run provider ordering tests if enabled
             if self.options.test_provider in ["default", "all"]:
                 provider_test_path = os.path.join(self.cpp.build.bindir, "test_provider_ordering")
@@ -46,6 +77,10 @@ class SpareToolsOpenSSLTestConan(ConanFile):
                 fips_test_path = os.path.join(self.cpp.build.bindir, "test_fips_smoke")
                 self.run(fips_test_path, env="conanrun")
 
+                # FIPS vs default provider overhead, kept with the test results
+                bench_path = os.path.join(self.cpp.build.bindir, "bench_fips")
+                self.run(f'"{bench_path}" --quick --json bench_fips.json', env="conanrun")
+
             # Run all tests via ctest if available
             cmake.test()
 
@@ -2,9 +2,15 @@
 #include <openssl/err.h>
 #include <openssl/evp.h>
 #include <openssl/crypto.h>
+#include <openssl/core_names.h>
+#include <openssl/provider.h>
+#include <openssl/self_test.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
+#include "bench_common.h"
+
 /**
  * FIPS Smoke Tests
  *
@@ -13,16 +19,115 @@
  * 2. Approved algorithms work
  * 3. FIPS self-tests complete successfully
  * 4. Critical cryptographic operations succeed
+ *
+ * With SPARETOOLS_FIPSMODULE_CNF (packages built with fips_install) the
+ * FIPS provider is first loaded into the default library context and
+ * OSSL_PROVIDER_load(NULL, "fips") is timed: the module integrity check
+ * plus, unless the module was installed with -self_test_oninstall, the
+ * KAT suite that every FIPS process start pays. The remaining tests then
+ * fetch from the FIPS provider.
+ */
+
+static int self_test_count(const OSSL_PARAM params[], void *arg) {
+    const OSSL_PARAM *p = OSSL_PARAM_locate_const(params, OSSL_PROV_PARAM_SELF_TEST_PHASE);
+    const char *phase = NULL;
+
+    if (p != NULL && OSSL_PARAM_get_utf8_string_ptr(p, &phase)
+        && strcmp(phase, OSSL_SELF_TEST_PHASE_PASS) == 0)
+        (*(int *)arg)++;
+    return 1;
+}
+
+/*
+ * Config that registers the FIPS provider with module_cnf's settings but
+ * leaves out "activate", so loading it does not start the module yet.
+ * Returns 1 for a -self_test_oninstall module (install-status present),
+ * 0 otherwise, -1 on I/O errors.
  */
+static int write_load_config(const char *module_cnf, const char *out_path) {
+    char line[1024];
+    int oninstall = 0;
+    FILE *in = fopen(module_cnf, "r");
+    FILE *out;
+
+    if (in == NULL)
+        return -1;
+    out = fopen(out_path, "w");
+    if (out == NULL) {
+        fclose(in);
+        return -1;
+    }
+    fputs("openssl_conf = openssl_init\n\n[openssl_init]\nproviders = provider_sect\n\n"
+          "[provider_sect]\nfips = fips_sect\n\n", out);
+    while (fgets(line, sizeof(line), in) != NULL) {
+        const char *key = line + strspn(line, " \t");
+
+        if (strncmp(key, "activate", 8) == 0)
+            continue;
+        if (strncmp(key, "install-status", 14) == 0)
+            oninstall = 1;
+        fputs(line, out);
+    }
+    fclose(in);
+    return fclose(out) == 0 ? oninstall : -1;
+}
+
+int test_fips_load_time(void) {
+    const char *module_cnf = getenv("SPARETOOLS_FIPSMODULE_CNF");
+    const char *load_cnf = "test_fips_smoke_load.cnf";
+    OSSL_PROVIDER *prov;
+    double start, elapsed;
+    int oninstall, self_tests = 0;
+
+    printf("Timing FIPS provider load...\n");
+    if (module_cnf == NULL || *module_cnf == '\0') {
+        printf("⚠ SPARETOOLS_FIPSMODULE_CNF not set (package without fips_install), not timed\n\n");
+        return 0;
+    }
+    if (OSSL_PROVIDER_available(NULL, "fips")) {
+        printf("⚠ FIPS provider already activated by OPENSSL_CONF, not timed\n\n");
+        return 0;
+    }
+    oninstall = write_load_config(module_cnf, load_cnf);
+    if (oninstall < 0) {
+        fprintf(stderr, "ERROR: cannot read %s or write %s\n", module_cnf, load_cnf);
+        return 1;
+    }
+    if (!OSSL_LIB_CTX_load_config(NULL, load_cnf)) {
+        fprintf(stderr, "ERROR: cannot load the FIPS module configuration %s\n", module_cnf);
+        ERR_print_errors_fp(stderr);
+        remove(load_cnf);
+        return 1;
+    }
+    remove(load_cnf);
+
+    OSSL_SELF_TEST_set_callback(NULL, self_test_count, &self_tests);
+    start = bench_now();
+    prov = OSSL_PROVIDER_load(NULL, "fips");
+    elapsed = bench_now() - start;
+    OSSL_SELF_TEST_set_callback(NULL, NULL, NULL);
+    if (prov == NULL) {
+        fprintf(stderr, "ERROR: OSSL_PROVIDER_load(NULL, \"fips\") failed\n");
+        ERR_print_errors_fp(stderr);
+        return 1;
+    }
+    /* Encoders and decoders for the tests below; fips has none */
+    OSSL_PROVIDER_load(NULL, "base");
+
+    printf("✓ OSSL_PROVIDER_load(NULL, \"fips\"): %.2f ms, %d self tests passed (%s)\n\n",
+           elapsed * 1e3, self_tests, oninstall ? "-self_test_oninstall" : "self tests on every load");
+    return 0;
+}
 
 int test_fips_mode(void) {
     printf("Testing FIPS mode...\n");
 
-    int fips_mode = FIPS_mode();
-    if (fips_mode) {
-        printf("✓ FIPS mode is ENABLED\n");
+    /* FIPS_mode() is gone in 3.x: FIPS is a provider */
+    if (OSSL_PROVIDER_available(NULL, "fips")) {
+        printf("✓ FIPS provider is ACTIVE%s\n",
+               EVP_default_properties_is_fips_enabled(NULL) ? " (default properties fips=yes)" : "");
     } else {
-        printf("⚠ FIPS mode is DISABLED (build may not include FIPS)\n");
+        printf("⚠ FIPS provider is not loaded (build may not include FIPS)\n");
     }
 
     return 0;  /* Non-fatal if FIPS not enabled */
@@ -254,6 +359,11 @@ int main() {
 
     int failures = 0;
 
+    if (test_fips_load_time() != 0) {
+        printf("✗ FIPS provider load FAILED\n");
+        failures++;
+    }
+
     if (test_fips_mode() != 0) {
         printf("✗ FIPS mode test FAILED\n");
         failures++;
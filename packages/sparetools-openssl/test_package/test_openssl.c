@@ -8,9 +8,10 @@ int main() {
     printf("Testing SpareTools OpenSSL package...\n");
     
     /* Initialize OpenSSL */
-    SSL_library_init();
-    SSL_load_error_strings();
-    OpenSSL_add_all_algorithms();
+    if (!OPENSSL_init_ssl(OPENSSL_INIT_LOAD_SSL_STRINGS | OPENSSL_INIT_LOAD_CRYPTO_STRINGS, NULL)) {
+        fprintf(stderr, "ERROR: OPENSSL_init_ssl failed\n");
+        return 1;
+    }
     
     /* Print OpenSSL version */
     printf("OpenSSL version: %s\n", OpenSSL_version(OPENSSL_VERSION));
@@ -0,0 +1,194 @@
+#include <openssl/evp.h>
+#include <openssl/err.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench_common.h"
+
+/**
+ * Performance floor smoke test
+ *
+ * Times AES-128-GCM encryption and SHA2-256 over 16 KiB buffers and fails
+ * when either falls below its floor (--floor NAME=MB/s, set per arch by
+ * test_package/conanfile.py). The floors sit far below what the assembly
+ * paths deliver on any supported CPU and above what the portable C code
+ * does, so they catch a package that is catastrophically slow: no-asm
+ * leaked into Configure, CPU feature detection disabled (OPENSSL_ia32cap,
+ * a masked VM), or a -O0 build shipped as Release. They are not a
+ * regression benchmark; bench_evp and the performance gate are.
+ *
+ * Each algorithm gets min_seconds (BENCH_MIN_SECONDS, or BENCH_QUICK_SECONDS
+ * with --quick) split into PERF_WINDOWS windows and reports the fastest
+ * window, so one preempted window on a busy runner cannot fail the test.
+ * Algorithms without a floor are measured and reported only.
+ */
+
+#define PERF_BUFFER_SIZE 16384
+#define PERF_WINDOWS 5
+
+typedef struct {
+    const char *name;
+    int cipher;             /* 1: EVP_CIPHER encrypt, 0: EVP_MD digest */
+    double floor_mb_per_s;  /* 0: no floor */
+} perf_algorithm;
+
+static perf_algorithm algorithms[] = {
+    {"AES-128-GCM", 1, 0.0},
+    {"SHA2-256", 0, 0.0},
+};
+#define NUM_ALGORITHMS (sizeof(algorithms) / sizeof(algorithms[0]))
+
+typedef struct {
+    EVP_CIPHER_CTX *cctx;
+    EVP_MD_CTX *mctx;
+    unsigned char out[PERF_BUFFER_SIZE + EVP_MAX_MD_SIZE];
+} perf_state;
+
+static const unsigned char perf_key[16], perf_iv[12];
+
+static int perf_once(const perf_algorithm *alg, perf_state *st, const unsigned char *buf) {
+    unsigned int mdlen;
+    int outl;
+
+    /* GCM refuses a second message without a fresh IV */
+    if (alg->cipher)
+        return EVP_EncryptInit_ex2(st->cctx, NULL, NULL, perf_iv, NULL)
+            && EVP_EncryptUpdate(st->cctx, st->out, &outl, buf, PERF_BUFFER_SIZE)
+            && EVP_EncryptFinal_ex(st->cctx, st->out + outl, &outl);
+    return EVP_DigestInit_ex2(st->mctx, NULL, NULL)
+        && EVP_DigestUpdate(st->mctx, buf, PERF_BUFFER_SIZE)
+        && EVP_DigestFinal_ex(st->mctx, st->out, &mdlen);
+}
+
+/* Fastest window's MB/s, 0 if the algorithm is unavailable, -1 on errors */
+static double perf_measure(const perf_algorithm *alg, const bench_options *opts,
+                           const unsigned char *buf) {
+    EVP_CIPHER *cipher = NULL;
+    EVP_MD *md = NULL;
+    perf_state st = {NULL, NULL, {0}};
+    double best = 0.0, window = opts->min_seconds / PERF_WINDOWS;
+    int ok;
+
+    if (alg->cipher) {
+        if ((cipher = EVP_CIPHER_fetch(NULL, alg->name, NULL)) == NULL)
+            return 0.0;
+        st.cctx = EVP_CIPHER_CTX_new();
+        ok = st.cctx != NULL && EVP_EncryptInit_ex2(st.cctx, cipher, perf_key, perf_iv, NULL);
+    } else {
+        if ((md = EVP_MD_fetch(NULL, alg->name, NULL)) == NULL)
+            return 0.0;
+        st.mctx = EVP_MD_CTX_new();
+        ok = st.mctx != NULL && EVP_DigestInit_ex2(st.mctx, md, NULL);
+    }
+
+    /* One untimed pass pages in the buffers and any lazily set up tables */
+    ok = ok && perf_once(alg, &st, buf);
+    for (int w = 0; ok && w < PERF_WINDOWS; w++) {
+        double start = bench_now(), elapsed;
+        uint64_t iterations = 0;
+
+        do {
+            ok = perf_once(alg, &st, buf);
+            iterations++;
+        } while (ok && (elapsed = bench_now() - start) < window);
+        if (ok && iterations * (double)PERF_BUFFER_SIZE / elapsed / 1e6 > best)
+            best = iterations * (double)PERF_BUFFER_SIZE / elapsed / 1e6;
+    }
+
+    EVP_CIPHER_CTX_free(st.cctx);
+    EVP_MD_CTX_free(st.mctx);
+    EVP_CIPHER_free(cipher);
+    EVP_MD_free(md);
+    if (!ok) {
+        ERR_print_errors_fp(stderr);
+        return -1.0;
+    }
+    return best;
+}
+
+static int set_floor(const char *spec) {
+    const char *eq = strchr(spec, '=');
+
+    for (size_t i = 0; eq != NULL && i < NUM_ALGORITHMS; i++) {
+        if (strlen(algorithms[i].name) == (size_t)(eq - spec)
+            && strncmp(algorithms[i].name, spec, (size_t)(eq - spec)) == 0) {
+            algorithms[i].floor_mb_per_s = atof(eq + 1);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    bench_options opts;
+    bench_json json;
+    unsigned char *buf;
+    int failures = 0;
+    int argi = bench_parse_args(argc, argv, "test_perf_floor.json", &opts);
+
+    if (argi < 0)
+        return 2;
+    for (; argi < argc; argi++) {
+        if (argi + 1 < argc && strcmp(argv[argi], "--floor") == 0 && set_floor(argv[argi + 1])) {
+            argi++;
+        } else {
+            fprintf(stderr, "Usage: %s [--quick] [--json PATH] [--floor AES-128-GCM=MBPS] "
+                    "[--floor SHA2-256=MBPS]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    printf("=================================\n");
+    printf("OpenSSL Performance Floor Test\n");
+    printf("=================================\n");
+    printf("OpenSSL version: %s\n", OpenSSL_version(OPENSSL_VERSION));
+
+    buf = malloc(PERF_BUFFER_SIZE);
+    if (buf == NULL) {
+        fprintf(stderr, "ERROR: Out of memory\n");
+        return 1;
+    }
+    memset(buf, 0xa5, PERF_BUFFER_SIZE);
+    if (bench_json_begin(&json, &opts, "perf_floor") != 0) {
+        free(buf);
+        return 1;
+    }
+
+    for (size_t i = 0; i < NUM_ALGORITHMS; i++) {
+        const perf_algorithm *alg = &algorithms[i];
+        double mb_per_s = perf_measure(alg, &opts, buf);
+        int pass = mb_per_s > 0.0 && mb_per_s >= alg->floor_mb_per_s;
+
+        if (mb_per_s == 0.0) {
+            printf("- %-12s not available, skipped\n", alg->name);
+            continue;
+        }
+        if (alg->floor_mb_per_s > 0.0)
+            printf("%s %-12s %10.1f MB/s (floor %.0f MB/s)\n", pass ? "✓" : "✗", alg->name,
+                   mb_per_s, alg->floor_mb_per_s);
+        else
+            printf("%s %-12s %10.1f MB/s (no floor)\n", pass ? "✓" : "✗", alg->name, mb_per_s);
+        failures += !pass;
+
+        bench_json_record_begin(&json);
+        bench_json_str(&json, "algorithm", alg->name);
+        bench_json_int(&json, "buffer_size", PERF_BUFFER_SIZE);
+        bench_json_num(&json, "mb_per_s", mb_per_s > 0.0 ? mb_per_s : 0.0);
+        bench_json_num(&json, "floor_mb_per_s", alg->floor_mb_per_s);
+        bench_json_int(&json, "pass", (uint64_t)pass);
+        bench_json_record_end(&json);
+    }
+
+    bench_json_end(&json);
+    free(buf);
+
+    printf("\n=================================\n");
+    if (failures == 0) {
+        printf("✅ Throughput above the floors (%s)\n", opts.json_path);
+        return 0;
+    }
+    printf("❌ %d algorithm(s) below their floor: check for no-asm, disabled CPU feature\n"
+           "   detection (OPENSSL_ia32cap/OPENSSL_armcap) or an unoptimized build\n", failures);
+    return 1;
+}
@@ -4,6 +4,9 @@
 #include <openssl/provider.h>
 #include <stdio.h>
 #include <string.h>
+#include <time.h>
+
+#include "sparetools_algcache.h"
 
 /**
  * Test provider ordering and availability
@@ -13,8 +16,22 @@
  * 2. Legacy provider can be loaded if available
  * 3. Provider dependencies are correctly ordered
  * 4. Multiple algorithms work correctly
+ * 5. Pre-fetched algorithm cache pins the same algorithms
+ *
+ * It also times OSSL_PROVIDER_load(NULL, "legacy") for the layout this
+ * package was built with: a loadable legacy.so (dlopen, symbol lookup,
+ * provider init) or, with builtin_providers=True (no-module), the provider
+ * linked into libcrypto. The timings are informational and never fail.
  */
 
+#define LEGACY_LOAD_ITERATIONS 200
+
+static double now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
 int test_default_provider(void) {
     printf("Testing default provider availability...\n");
 
@@ -37,6 +54,43 @@ int test_default_provider(void) {
     return 0;
 }
 
+int test_legacy_load_cost(void) {
+#ifdef OPENSSL_NO_MODULE
+    const char *layout = "builtin (no-module)";
+#else
+    const char *layout = "module (legacy.so)";
+#endif
+    printf("\nTiming legacy provider load, layout: %s...\n", layout);
+
+    /* The first load pays for the dlopen and relocations of legacy.so */
+    double start = now_us();
+    OSSL_PROVIDER *legacy = OSSL_PROVIDER_load(NULL, "legacy");
+    double first = now_us() - start;
+    if (!legacy) {
+        printf("⚠ Legacy provider not available, nothing to time\n");
+        ERR_clear_error();
+        return 0;
+    }
+    OSSL_PROVIDER_unload(legacy);
+
+    /* Unloading the last reference frees the provider, so every iteration
+     * loads and initializes it again */
+    start = now_us();
+    for (int i = 0; i < LEGACY_LOAD_ITERATIONS; i++) {
+        legacy = OSSL_PROVIDER_load(NULL, "legacy");
+        if (!legacy) {
+            fprintf(stderr, "ERROR: Legacy provider load %d failed\n", i);
+            return 1;
+        }
+        OSSL_PROVIDER_unload(legacy);
+    }
+    double per_load = (now_us() - start) / LEGACY_LOAD_ITERATIONS;
+
+    printf("✓ First load: %.1f us\n", first);
+    printf("✓ Load + unload: %.1f us (%d iterations)\n", per_load, LEGACY_LOAD_ITERATIONS);
+    return 0;
+}
+
 int test_legacy_provider(void) {
     printf("\nTesting legacy provider availability...\n");
 
@@ -129,6 +183,48 @@ int test_algorithm_list(void) {
     return algorithm_count >= 6 ? 0 : 1;
 }
 
+int test_algorithm_cache(void) {
+    printf("\nTesting pre-fetched algorithm cache...\n");
+
+    static const char *const digests[] = {"SHA2-256", "SHA2-512", "SHA3-256", NULL};
+    static const char *const ciphers[] = {"AES-256-GCM", "ChaCha20-Poly1305", NULL};
+
+    SPARETOOLS_ALGCACHE *cache = sparetools_algcache_new(NULL, NULL, digests, ciphers);
+    if (!cache) {
+        fprintf(stderr, "ERROR: Failed to create algorithm cache\n");
+        return 1;
+    }
+
+    int failures = 0;
+    for (int i = 0; digests[i] != NULL; i++) {
+        const EVP_MD *md = sparetools_algcache_md(cache, digests[i]);
+        if (md && EVP_MD_is_a(md, digests[i])) {
+            printf("✓ %s pinned\n", digests[i]);
+        } else {
+            fprintf(stderr, "ERROR: %s missing from cache\n", digests[i]);
+            failures++;
+        }
+    }
+    for (int i = 0; ciphers[i] != NULL; i++) {
+        const EVP_CIPHER *cipher = sparetools_algcache_cipher(cache, ciphers[i]);
+        if (cipher && EVP_CIPHER_is_a(cipher, ciphers[i])) {
+            printf("✓ %s pinned\n", ciphers[i]);
+        } else {
+            fprintf(stderr, "ERROR: %s missing from cache\n", ciphers[i]);
+            failures++;
+        }
+    }
+
+    /* Lookups are by name only; nothing outside the list is fetched */
+    if (sparetools_algcache_md(cache, "MD5") != NULL) {
+        fprintf(stderr, "ERROR: Cache returned an algorithm it was not asked for\n");
+        failures++;
+    }
+
+    sparetools_algcache_free(cache);
+    return failures == 0 ? 0 : 1;
+}
+
 int main() {
     printf("=================================\n");
     printf("OpenSSL Provider Ordering Tests\n");
@@ -141,6 +237,11 @@ int main() {
         failures++;
     }
 
+    if (test_legacy_load_cost() != 0) {
+        printf("✗ Legacy load timing FAILED\n");
+        failures++;
+    }
+
     if (test_legacy_provider() != 0) {
         printf("✗ Legacy provider test FAILED\n");
         failures++;
@@ -156,6 +257,11 @@ int main() {
         failures++;
     }
 
+    if (test_algorithm_cache() != 0) {
+        printf("✗ Algorithm cache test FAILED\n");
+        failures++;
+    }
+
     printf("\n=================================\n");
     if (failures == 0) {
         printf("✅ All provider tests PASSED!\n");
@@ -16,6 +16,9 @@ class SpareToolsSharedDevToolsConan(ConanFile):
     def package(self):
         copy(self, "*.py", src=self.source_folder, dst=self.package_folder, keep_path=True)
         copy(self, "*.sh", src=self.source_folder, dst=self.package_folder, keep_path=True)
+        # Ship the tracing module: a python_requires never puts sparetools-base on PYTHONPATH
+        copy(self, "sparetools_tracing.py", src=self.python_requires["sparetools-base"].path,
+             dst=self.package_folder)
     
     def package_info(self):
         self.cpp_info.libs = []
@@ -7,6 +7,21 @@ environment setup, and other common development tasks.
 
 from .file_operations import *
 from .execute_command import *
+try:
+    from sparetools_tracing import span, current_context, child_env, SpanContext
+except ImportError:  # sparetools-base not on PYTHONPATH: tracing is off
+    import contextlib
+    from typing import Any as SpanContext
+
+    def current_context():
+        return None
+
+    def child_env(env=None):
+        return env
+
+    @contextlib.contextmanager
+    def span(name, parent=None, **attributes):
+        yield type("Span", (), {"set_attribute": lambda self, key, value: None})()
 
 __all__ = [
     # File operations
@@ -14,8 +29,20 @@ __all__ = [
     "find_executable_in_path",
     "find_first_existing_file",
     "create_whole_dir_path",
+    "copy_file_with_metadata",
+    "copy_directory_tree",
     "remove_directory_tree",
     # Command execution
     "execute_command",
-    "remove_console_color_codes"
+    "remove_console_color_codes",
+    "execute_command_async",
+    "run_commands_async",
+    "run_commands",
+    "CommandResult",
+    "log_lines",
+    # Tracing
+    "span",
+    "current_context",
+    "child_env",
+    "SpanContext"
 ]
\ No newline at end of file
@@ -10,6 +10,11 @@ import os
 import subprocess
 from typing import Optional, Tuple, List, Union
 
+# Streaming asyncio variants: many concurrent commands on one event loop
+from shared_dev_tools.util.async_command import (
+    CommandResult, execute_command_async, log_lines, run_commands, run_commands_async
+)
+
 log = logging.getLogger(__name__)
 
 
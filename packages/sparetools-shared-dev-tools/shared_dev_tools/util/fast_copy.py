@@ -0,0 +1,281 @@
+"""
+Fast File Copies
+
+Copies files and directory trees in the kernel instead of through
+Python-level read()/write() loops. Each file tries, in order:
+
+- a copy-on-write clone (FICLONE on Btrfs/XFS/bcachefs): no data is
+  copied at all
+- os.copy_file_range(): in-kernel copy, server-side on NFS 4.2/CIFS
+- os.sendfile(): in-kernel copy between two regular files
+- shutil.copyfileobj() everywhere else (Windows, macOS)
+
+A method that fails with "not supported" for a pair of devices is not
+tried again for that pair. Files are written to a temporary name and
+renamed into place, so a destination that is a hard link into a package
+cache is replaced rather than overwritten.
+
+copy_tree() fans the file copies out to a thread pool (thousands of
+small headers are dominated by per-file syscalls, not bandwidth) and
+skips files whose size, mtime and, unless verify_digest=False, SHA-256
+already match the source.
+"""
+
+import errno
+import hashlib
+import logging
+import os
+import shutil
+import stat
+import threading
+from collections import Counter
+from concurrent.futures import ThreadPoolExecutor
+from dataclasses import dataclass, field
+from pathlib import Path
+from typing import Optional, Set, Tuple, Union
+
+log = logging.getLogger(__name__)
+
+_FICLONE = 0x40049409  # _IOW(0x94, 9, int)
+
+# errnos meaning "this method does not work here", as opposed to real I/O errors
+_UNSUPPORTED = {errno.EOPNOTSUPP, errno.ENOTSUP, errno.EXDEV, errno.EINVAL, errno.ENOSYS,
+                errno.ENOTTY, errno.EBADF, errno.EPERM}
+
+# Below this many files copy_tree() copies inline instead of starting threads
+PARALLEL_THRESHOLD = 16
+
+_unsupported: Set[Tuple[str, int, int]] = set()
+_unsupported_lock = threading.Lock()
+
+
+@dataclass
+class CopyStats:
+    """What copy_tree() did"""
+    copied: int = 0
+    skipped: int = 0
+    removed: int = 0
+    bytes_copied: int = 0
+    methods: Counter = field(default_factory=Counter)
+
+    def add(self, method: str, size: int):
+        self.methods[method] += 1
+        if method == "skipped":
+            self.skipped += 1
+        else:
+            self.copied += 1
+            self.bytes_copied += size
+
+
+def _supported(method: str, devices: Tuple[int, int]) -> bool:
+    return (method, *devices) not in _unsupported
+
+
+def _mark_unsupported(method: str, devices: Tuple[int, int], error: OSError):
+    with _unsupported_lock:
+        _unsupported.add((method, *devices))
+    log.debug(f"{method} not supported between devices {devices}: {error}")
+
+
+def _clone(src_fd: int, dst_fd: int) -> None:
+    import fcntl
+    fcntl.ioctl(dst_fd, _FICLONE, src_fd)
+
+
+def _copy_file_range(src_fd: int, dst_fd: int, size: int) -> None:
+    offset = 0
+    while offset < size:
+        copied = os.copy_file_range(src_fd, dst_fd, size - offset, offset, offset)
+        if copied == 0:
+            break
+        offset += copied
+
+
+def _sendfile(src_fd: int, dst_fd: int, size: int) -> None:
+    offset = 0
+    while offset < size:
+        sent = os.sendfile(dst_fd, src_fd, offset, size - offset)
+        if sent == 0:
+            break
+        offset += sent
+
+
+def _kernel_methods():
+    methods = []
+    if os.name == "posix":
+        try:
+            import fcntl  # noqa: F401
+            methods.append(("clone", lambda s, d, size: _clone(s, d)))
+        except ImportError:
+            pass
+    if hasattr(os, "copy_file_range"):
+        methods.append(("copy_file_range", _copy_file_range))
+    if hasattr(os, "sendfile") and os.uname().sysname == "Linux":
+        methods.append(("sendfile", _sendfile))
+    return methods
+
+
+_METHODS = _kernel_methods() if os.name == "posix" else []
+
+
+def file_digest(path: Union[str, Path]) -> str:
+    digest = hashlib.sha256()
+    with open(path, "rb") as f:
+        for chunk in iter(lambda: f.read(1 << 20), b""):
+            digest.update(chunk)
+    return digest.hexdigest()
+
+
+def is_unchanged(source: Union[str, Path], destination: Union[str, Path],
+                 verify_digest: bool = True, source_stat: Optional[os.stat_result] = None) -> bool:
+    """Whether destination already is a copy of source (size, mtime and optionally content)"""
+    try:
+        dst = os.stat(destination, follow_symlinks=False)
+    except FileNotFoundError:
+        return False
+    src = source_stat or os.stat(source)
+    if not stat.S_ISREG(dst.st_mode) or dst.st_size != src.st_size or dst.st_mtime_ns != src.st_mtime_ns:
+        return False
+    return not verify_digest or file_digest(source) == file_digest(destination)
+
+
+def copy_file(source: Union[str, Path], destination: Union[str, Path], skip_unchanged: bool = False,
+              verify_digest: bool = True) -> str:
+    """
+    Copy one regular file with its permission bits and timestamps.
+    Returns the method that did the work, or "skipped".
+    """
+    source, destination = os.fspath(source), os.fspath(destination)
+    src_stat = os.stat(source)
+    if skip_unchanged and is_unchanged(source, destination, verify_digest, src_stat):
+        return "skipped"
+    dest_dir = os.path.dirname(destination) or "."
+    os.makedirs(dest_dir, exist_ok=True)
+    return _copy(source, destination, src_stat, os.stat(dest_dir).st_dev)
+
+
+def _copy(source: str, destination: str, src_stat: os.stat_result, dest_dev: int,
+          exists: Optional[bool] = None) -> str:
+    devices = (src_stat.st_dev, dest_dev)
+    # An existing destination may be a hard link into a cache: write a new inode
+    replace = os.path.lexists(destination) if exists is None else exists
+    target = (os.path.join(os.path.dirname(destination), f".{os.path.basename(destination)}.{threading.get_ident()}.tmp")
+              if replace else destination)
+    used = None
+    try:
+        with open(source, "rb") as src, open(target, "wb") as dst:
+            for name, method in _METHODS:
+                if not _supported(name, devices):
+                    continue
+                try:
+                    method(src.fileno(), dst.fileno(), src_stat.st_size)
+                    used = name
+                    break
+                except OSError as e:
+                    if e.errno not in _UNSUPPORTED:
+                        raise
+                    _mark_unsupported(name, devices, e)
+                    src.seek(0)
+                    dst.seek(0)
+                    dst.truncate()
+            if used is None:
+                shutil.copyfileobj(src, dst, 1 << 20)
+                used = "read"
+        shutil.copystat(source, target)
+        if replace:
+            os.replace(target, destination)
+    except BaseException:
+        if os.path.lexists(target):
+            os.unlink(target)
+        raise
+    return used
+
+
+def _remove(path: str):
+    if os.path.isdir(path) and not os.path.islink(path):
+        shutil.rmtree(path)
+    else:
+        os.unlink(path)
+
+
+def copy_tree(source: Union[str, Path], destination: Union[str, Path], workers: Optional[int] = None,
+              skip_unchanged: bool = True, verify_digest: bool = True, delete: bool = False,
+              symlinks: bool = True) -> CopyStats:
+    """
+    Copy a directory tree into destination (merging with what is there).
+
+    Args:
+        workers: threads for the file copies (default: 4 per CPU, at most 32)
+        skip_unchanged: leave files whose size and mtime (and digest) match
+        verify_digest: also compare SHA-256 before skipping a file
+        delete: remove destination entries that are not in source, making
+            the result identical to a fresh copy
+        symlinks: reproduce symlinks as symlinks instead of copying their targets
+    """
+    source, destination = os.fspath(source), os.fspath(destination)
+    stats = CopyStats()
+    files = []
+    directories = []
+
+    def walk(src_dir: str, dst_dir: str):
+        # Nothing to compare against or replace in a directory created here
+        fresh = not os.path.isdir(dst_dir)
+        os.makedirs(dst_dir, exist_ok=True)
+        directories.append((src_dir, dst_dir))
+        dst_dev = os.stat(dst_dir).st_dev
+        names = set()
+        with os.scandir(src_dir) as entries:
+            for entry in entries:
+                names.add(entry.name)
+                dst = os.path.join(dst_dir, entry.name)
+                if entry.is_symlink() and symlinks:
+                    target = os.readlink(entry.path)
+                    if not fresh and os.path.islink(dst) and os.readlink(dst) == target:
+                        stats.add("skipped", 0)
+                        continue
+                    if not fresh and os.path.lexists(dst):
+                        _remove(dst)
+                    os.symlink(target, dst, target_is_directory=entry.is_dir())
+                    stats.add("symlink", 0)
+                elif entry.is_dir():
+                    if not fresh and os.path.lexists(dst) and not (os.path.isdir(dst) and not os.path.islink(dst)):
+                        _remove(dst)
+                    walk(entry.path, dst)
+                else:
+                    if not fresh and os.path.isdir(dst) and not os.path.islink(dst):
+                        shutil.rmtree(dst)
+                    files.append((entry.path, dst, entry.stat(), dst_dev, fresh))
+        if delete and not fresh:
+            with os.scandir(dst_dir) as entries:
+                for entry in entries:
+                    if entry.name not in names:
+                        _remove(entry.path)
+                        stats.removed += 1
+
+    walk(source, destination)
+
+    def copy_one(item):
+        src, dst, src_stat, dst_dev, fresh = item
+        if fresh:
+            return _copy(src, dst, src_stat, dst_dev, exists=False), src_stat.st_size
+        if skip_unchanged and is_unchanged(src, dst, verify_digest, src_stat):
+            return "skipped", 0
+        return _copy(src, dst, src_stat, dst_dev), src_stat.st_size
+
+    if len(files) < PARALLEL_THRESHOLD:
+        results = map(copy_one, files)
+        for method, size in results:
+            stats.add(method, size)
+    else:
+        workers = workers or min(32, (os.cpu_count() or 1) * 4)
+        with ThreadPoolExecutor(max_workers=workers) as pool:
+            for method, size in pool.map(copy_one, files):
+                stats.add(method, size)
+
+    # Directory timestamps last, deepest first, as copytree does
+    for src_dir, dst_dir in reversed(directories):
+        shutil.copystat(src_dir, dst_dir)
+
+    log.debug(f"Copied tree {source} -> {destination}: {stats.copied} copied, {stats.skipped} unchanged, "
+              f"{stats.removed} removed ({dict(stats.methods)})")
+    return stats
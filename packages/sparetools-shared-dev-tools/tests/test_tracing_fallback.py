@@ -0,0 +1,51 @@
+"""
+The tool packages import sparetools_tracing from sparetools-base, which is
+only a python_requires of their recipes. Every module that does must still
+import, with tracing off, when sparetools_tracing cannot be found.
+
+    python3 -m unittest discover packages/sparetools-shared-dev-tools/tests
+"""
+
+import importlib.util
+import os
+import subprocess
+import sys
+import unittest
+from pathlib import Path
+
+PACKAGES = Path(__file__).resolve().parents[2]
+
+# (package folder, module, third-party modules it needs besides tracing)
+CONSUMERS = [
+    ("sparetools-shared-dev-tools", "shared_dev_tools.util", []),
+    ("sparetools-openssl-tools", "openssl_tools.build", []),
+    ("sparetools-openssl-tools-mini", "openssl_tools.build_orchestrator", []),
+    ("sparetools-mcp-orchestrator", "mcp_project_orchestrator.fan_out_orchestrator",
+     ["httpx", "github", "pydantic"]),
+]
+
+# sys.modules[name] = None makes `import name` raise ImportError
+CHECK = """
+import sys
+sys.modules["sparetools_tracing"] = None
+module = __import__(sys.argv[1], fromlist=["span"])
+with module.span("import check") as handle:
+    handle.set_attribute("ok", True)
+"""
+
+
+class TracingFallbackTest(unittest.TestCase):
+    def test_imports_without_sparetools_base(self):
+        for package, module, requirements in CONSUMERS:
+            with self.subTest(module=module):
+                missing = [name for name in requirements if importlib.util.find_spec(name) is None]
+                if missing:
+                    self.skipTest(f"{module} needs {', '.join(missing)}")
+                env = dict(os.environ, PYTHONPATH=str(PACKAGES / package))
+                result = subprocess.run([sys.executable, "-c", CHECK, module], env=env,
+                                        capture_output=True, text=True)
+                self.assertEqual(result.returncode, 0, result.stderr)
+
+
+if __name__ == "__main__":
+    unittest.main()
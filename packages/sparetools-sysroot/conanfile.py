@@ -0,0 +1,113 @@
+import os
+import shutil
+from conan import ConanFile
+from conan.errors import ConanException, ConanInvalidConfiguration
+from conan.tools.files import get, unzip
+
+
+class SysrootConan(ConanFile):
+    """Target headers and libraries for cross-compiling SpareTools packages"""
+    
+    name = "sparetools-sysroot"
+    version = "2.0.0"
+    package_type = "build-scripts"
+    description = "Linux sysroot (glibc headers, crt objects and libraries) for cross builds"
+    license = "LGPL-2.1-or-later"
+    url = "https://github.com/sparesparrow/sparetools"
+    
+    settings = "os", "arch"
+    
+    # Conan arch -> GNU triplet of the Debian/Ubuntu cross toolchains
+    # (gcc-<n>-<triplet>, libc6-dev-<arch>-cross)
+    _triplets = {
+        "armv8": "aarch64-linux-gnu",
+        "armv7hf": "arm-linux-gnueabihf",
+        "x86_64": "x86_64-linux-gnu",
+        "ppc64le": "powerpc64le-linux-gnu",
+        "s390x": "s390x-linux-gnu",
+        "riscv64": "riscv64-linux-gnu",
+    }
+    
+    @property
+    def _target(self):
+        """The platform the sysroot is for: the consumer's host when used as a tool_requires"""
+        return getattr(self, "settings_target", None) or self.settings
+    
+    @property
+    def _triplet(self):
+        return self._triplets[str(self._target.arch)]
+    
+    def validate(self):
+        if str(self._target.os) != "Linux":
+            raise ConanInvalidConfiguration("sparetools-sysroot only provides Linux sysroots")
+        if str(self._target.arch) not in self._triplets:
+            raise ConanInvalidConfiguration(
+                f"No sysroot for arch={self._target.arch} ({', '.join(self._triplets)})")
+    
+    def package_id(self):
+        # The contents depend on the target only, not on the machine running the build
+        self.info.settings.clear()
+        self.info.settings_target = self.settings_target
+        if self.info.settings_target is not None:
+            self.info.settings_target.rm_safe("compiler")
+            self.info.settings_target.rm_safe("build_type")
+        sha256 = self.conf.get("user.sparetools:sysroot_sha256", check_type=str)
+        if sha256:
+            self.info.conf.define("user.sparetools:sysroot_sha256", sha256)
+    
+    def package(self):
+        """
+        Unpack user.sparetools:sysroot_archive (a path, or a URL checked
+        against user.sparetools:sysroot_sha256), else copy the build
+        machine's cross libc (/usr/<triplet> from libc6-dev-<arch>-cross).
+        Packaged once, CI runners without the cross libc packages get it
+        from the remote.
+        """
+        sysroot = os.path.join(self.package_folder, "sysroot")
+        archive = self.conf.get("user.sparetools:sysroot_archive", check_type=str)
+        sha256 = self.conf.get("user.sparetools:sysroot_sha256", check_type=str)
+        if archive and "://" in archive:
+            if not sha256:
+                raise ConanException("user.sparetools:sysroot_archive URLs need user.sparetools:sysroot_sha256")
+            get(self, archive, sha256=sha256, destination=sysroot)
+        elif archive:
+            unzip(self, archive, destination=sysroot)
+        else:
+            self._copy_cross_libc(sysroot)
+        
+        triplet = self._triplet
+        if not any(os.path.exists(os.path.join(sysroot, d, "stdio.h"))
+                   for d in ["usr/include", f"usr/{triplet}/include"]):
+            raise ConanException(f"{sysroot} has no C library headers (stdio.h) for {triplet}")
+    
+    def _copy_cross_libc(self, sysroot):
+        """
+        /usr/<triplet> keeps its path under the sysroot, so the linker
+        scripts in it (libc.so) still resolve; usr/include and usr/lib point
+        at it for compilers that search the usual sysroot layout.
+        """
+        triplet = self._triplet
+        source = f"/usr/{triplet}"
+        if not os.path.isdir(os.path.join(source, "include")):
+            raise ConanException(
+                f"No cross libc in {source}: install libc6-dev-{self._debian_arch}-cross "
+                f"(and linux-libc-dev-{self._debian_arch}-cross), or set user.sparetools:sysroot_archive")
+        shutil.copytree(source, os.path.join(sysroot, "usr", triplet), symlinks=True)
+        for link, target in [("usr/include", f"{triplet}/include"), ("usr/lib", f"{triplet}/lib"),
+                             ("lib", f"usr/{triplet}/lib")]:
+            path = os.path.join(sysroot, link)
+            if not os.path.lexists(path):
+                os.symlink(target, path)
+    
+    @property
+    def _debian_arch(self):
+        return {"armv8": "arm64", "armv7hf": "armhf", "x86_64": "amd64", "ppc64le": "ppc64el"}.get(
+            str(self._target.arch), str(self._target.arch))
+    
+    def package_info(self):
+        # Conan's toolchains add --sysroot for tools.build:sysroot, and
+        # sparetools-openssl passes it to Configure
+        self.conf_info.define("tools.build:sysroot", os.path.join(self.package_folder, "sysroot"))
+        self.cpp_info.bindirs = []
+        self.cpp_info.libdirs = []
+        self.cpp_info.includedirs = []
@@ -1,72 +1,555 @@
 #!/usr/bin/env python3
-"""Aggregate JSON build summaries produced by matrix tasks."""
+"""Aggregate JSON build summaries produced by matrix tasks.
+
+Every build-summary-*.json and its raw build log is analysed in a process
+pool and merged into one report: duration histograms per target, the
+slowest compile units and failure clusters. The raw log is the summary's
+"log_file" entry (relative to the summary) or, failing that, the file
+with the same name and a .log suffix next to it. Summaries with a
+"stages" list (build-openssl-source.py) also get per-stage medians and
+the time saved by overlapping stages.
+
+--follow watches the directory with inotify (Linux) or kqueue (macOS/BSD)
+instead of re-reading every summary each --interval, so hundreds of
+concurrent matrix jobs cost nothing while idle; other platforms fall back
+to stat() polling.
+"""
 
 from __future__ import annotations
 
 import argparse
 import json
+import os
+import re
+import select
+import statistics
+import sys
 import time
+from collections import Counter
+from concurrent.futures import ProcessPoolExecutor
 from pathlib import Path
-from typing import Dict, List
+from typing import Dict, Iterator, List, Optional, Set, Tuple
+
+SUMMARY_GLOB = "build-summary-*.json"
+
+# Leading timestamp of a log line: ISO 8601 (ts, GitHub Actions, conan -v)
+# or elapsed seconds ("[  12.345s]", "12.345 |")
+ISO_TS_RE = re.compile(r"^\[?(\d{4}-\d{2}-\d{2}[T ]\d{2}:\d{2}:\d{2}(?:\.\d+)?)Z?\]?\s+")
+ELAPSED_TS_RE = re.compile(r"^\[\s*(\d+(?:\.\d+)?)s?\]\s+|^(\d+\.\d+)\s+\|\s")
+# A compiler invocation of one source file, or a CMake/Ninja progress line
+COMPILE_RE = re.compile(
+    r"\s-c\s(?:.*\s)?(?P<src>[^\s\"']+\.(?:c|cc|cpp|cxx|S|s|asm))(?:\s|$)"
+    r"|Building (?:C|CXX|ASM) object (?P<obj>\S+)"
+)
+ERROR_RE = re.compile(
+    r"\b(?:fatal )?error\b\s*[:\]]|undefined reference to|\bFAILED:"
+    r"|make(?:\[\d+\])?: \*\*\*|^ERROR:|Traceback \(most recent call last\)",
+    re.IGNORECASE,
+)
+# Parts of an error line that differ between builds of the same failure
+NORMALIZE = [
+    (re.compile(r"(?:[A-Za-z]:)?(?:[\w.+-]*[/\\])+([\w.+-]+)"), r"\1"),  # paths -> basename
+    (re.compile(r"0x[0-9a-fA-F]+"), "0x#"),
+    (re.compile(r"[`'‘\"][^`'’\"]*[`'’\"]"), "'*'"),
+    (re.compile(r"\d+"), "#"),
+    (re.compile(r"\s+"), " "),
+]
+MAX_UNITS_PER_BUILD = 200
+MAX_CLUSTER_EXAMPLES = 3
 
 
 def read_summaries(log_dir: Path) -> List[Dict]:
     summaries: List[Dict] = []
-    for path in sorted(log_dir.glob("build-summary-*.json")):
-        try:
-            data = json.loads(path.read_text(encoding="utf-8"))
-            data["_path"] = str(path)
-            summaries.append(data)
-        except json.JSONDecodeError:
-            continue
+    for path in sorted(log_dir.glob(SUMMARY_GLOB)):
+        summary = read_summary(path)
+        if summary is not None:
+            summaries.append(summary)
     return summaries
 
 
+def read_summary(path: Path) -> Optional[Dict]:
+    try:
+        data = json.loads(path.read_text(encoding="utf-8"))
+    except (OSError, json.JSONDecodeError):
+        return None  # Missing, or caught half-written
+    if not isinstance(data, dict):
+        return None
+    data["_path"] = str(path)
+    return data
+
+
 def format_summary(summary: Dict) -> str:
     duration = summary.get("duration_seconds", 0)
     target = summary.get("target", "unknown")
     shared = "shared" if summary.get("shared") else "static"
     fips = "fips" if summary.get("enable_fips") else "std"
     install_prefix = summary.get("install_prefix", "")
+    status = f" status={summary['status']}" if summary.get("status") else ""
     return (
         f"[{summary.get('finished', '?')}] target={target} ({shared}/{fips}) "
-        f"jobs={summary.get('jobs')} duration={duration:.1f}s -> {install_prefix}"
+        f"jobs={summary.get('jobs')} duration={duration:.1f}s{status} -> {install_prefix}"
     )
 
 
+def target_key(summary: Dict) -> str:
+    return str(summary.get("target") or summary.get("job_name") or "unknown")
+
+
+def summary_failed(summary: Dict) -> bool:
+    return summary.get("status") == "failed" or summary.get("success") is False
+
+
+def raw_log_path(summary_path: Path, summary: Dict) -> Optional[Path]:
+    if summary.get("log_file"):
+        path = summary_path.parent / summary["log_file"]
+        return path if path.exists() else None
+    path = summary_path.with_suffix(".log")
+    return path if path.exists() else None
+
+
+# -- per-build analysis (runs in worker processes) ---------------------------
+
+def line_timestamp(line: str, base: List[Optional[float]]) -> Tuple[Optional[float], str]:
+    """(seconds, line without its timestamp); base[0] anchors ISO times"""
+    m = ISO_TS_RE.match(line)
+    if m:
+        try:
+            stamp = time.mktime(time.strptime(m.group(1)[:19].replace("T", " "), "%Y-%m-%d %H:%M:%S"))
+        except ValueError:
+            return None, line
+        fraction = m.group(1)[19:]
+        stamp += float(fraction) if fraction else 0.0
+        if base[0] is None:
+            base[0] = stamp
+        return stamp - base[0], line[m.end():]
+    m = ELAPSED_TS_RE.match(line)
+    if m:
+        return float(m.group(1) or m.group(2)), line[m.end():]
+    return None, line
+
+
+def failure_signature(line: str) -> str:
+    signature = line.strip()
+    for pattern, replacement in NORMALIZE:
+        signature = pattern.sub(replacement, signature)
+    return signature[:200]
+
+
+def read_ninja_log(path: Path) -> List[Tuple[str, float]]:
+    """.ninja_log v5: start_ms, end_ms, mtime, output, hash; last entry per output wins"""
+    units: Dict[str, float] = {}
+    with open(path, encoding="utf-8", errors="replace") as f:
+        for line in f:
+            fields = line.rstrip("\n").split("\t")
+            if line.startswith("#") or len(fields) < 4:
+                continue
+            try:
+                units[fields[3]] = (int(fields[1]) - int(fields[0])) / 1000.0
+            except ValueError:
+                continue
+    return list(units.items())
+
+
+def analyze_log(path: Path) -> Dict:
+    """
+    Scan one raw build log. Compile units are timed from their line's
+    timestamp to the next compile line's: exact for -j1 output, an
+    estimate of the dispatch interval for parallel builds. Logs without
+    timestamps still yield failure clusters.
+    """
+    with open(path, "rb") as f:
+        head = f.read(64)
+    if head.startswith(b"# ninja log"):
+        return {"lines": 0, "units": read_ninja_log(path), "unit_source": "ninja_log", "failures": {}}
+
+    units: List[Tuple[str, float]] = []
+    failures: Dict[str, Dict] = {}
+    base: List[Optional[float]] = [None]
+    current: Optional[Tuple[str, float]] = None
+    last_stamp: Optional[float] = None
+    lines = 0
+    with open(path, encoding="utf-8", errors="replace") as f:
+        for lines, raw in enumerate(f, 1):
+            stamp, line = line_timestamp(raw, base)
+            if stamp is not None:
+                last_stamp = stamp
+            compiled = COMPILE_RE.search(line)
+            if compiled and last_stamp is not None:
+                if current is not None:
+                    units.append((current[0], max(0.0, last_stamp - current[1])))
+                current = (compiled.group("src") or compiled.group("obj"), last_stamp)
+            if ERROR_RE.search(line):
+                cluster = failures.setdefault(failure_signature(line), {"count": 0, "example": line.strip()[:300]})
+                cluster["count"] += 1
+    if current is not None and last_stamp is not None:
+        units.append((current[0], max(0.0, last_stamp - current[1])))
+    return {"lines": lines, "units": units, "unit_source": "timestamps", "failures": failures}
+
+
+def analyze_build(summary_path: str) -> Optional[Dict]:
+    """Worker: one summary plus its raw log, reduced to what the report needs"""
+    path = Path(summary_path)
+    summary = read_summary(path)
+    if summary is None:
+        return None
+    result = {"summary": summary, "log_file": None, "units": [], "unit_source": None, "failures": {}}
+    log_path = raw_log_path(path, summary)
+    if log_path is not None:
+        try:
+            analysis = analyze_log(log_path)
+        except OSError as e:
+            analysis = {"units": [], "unit_source": None,
+                        "failures": {f"unreadable log: {e.strerror}": {"count": 1, "example": str(e)}}}
+        result["log_file"] = str(log_path)
+        units = sorted(analysis["units"], key=lambda u: u[1], reverse=True)
+        result["units"] = units[:MAX_UNITS_PER_BUILD]
+        result["unit_source"] = analysis["unit_source"]
+        result["failures"] = analysis["failures"]
+    if summary_failed(summary) and not result["failures"] and summary.get("error"):
+        error = str(summary["error"])
+        result["failures"] = {failure_signature(error): {"count": 1, "example": error[:300]}}
+    return result
+
+
+# -- merged report -----------------------------------------------------------
+
+def histogram(durations: List[float], buckets: int) -> List[Dict]:
+    low, high = min(durations), max(durations)
+    width = (high - low) / buckets if high > low else 1.0
+    counts = Counter(min(int((d - low) / width), buckets - 1) for d in durations)
+    return [{"lo": low + i * width, "hi": low + (i + 1) * width, "count": counts.get(i, 0)}
+            for i in range(buckets if high > low else 1)]
+
+
+def stage_overlap(stages: List[Dict]) -> float:
+    """Seconds of stage work that ran alongside other stages"""
+    spans = [(float(s["start_seconds"]), float(s["start_seconds"]) + float(s["duration_seconds"]))
+             for s in stages]
+    busy, end = 0.0, None
+    for start, stop in sorted(spans):
+        if end is None or start > end:
+            busy += stop - start
+            end = stop
+        elif stop > end:
+            busy += stop - end
+            end = stop
+    return sum(stop - start for start, stop in spans) - busy
+
+
+def build_report(results: List[Dict], top: int = 20, buckets: int = 8) -> Dict:
+    durations: Dict[str, List[float]] = {}
+    stage_times: Dict[str, Dict[str, List[float]]] = {}
+    failed: Dict[str, int] = {}
+    units: List[Dict] = []
+    clusters: Dict[str, Dict] = {}
+    for result in results:
+        summary = result["summary"]
+        target = target_key(summary)
+        build = summary.get("job_name") or Path(summary["_path"]).stem
+        if summary.get("status") != "running" and summary.get("duration_seconds") is not None:
+            durations.setdefault(target, []).append(float(summary["duration_seconds"]))
+        if summary_failed(summary):
+            failed[target] = failed.get(target, 0) + 1
+        stages = [s for s in summary.get("stages") or []
+                  if isinstance(s, dict) and "start_seconds" in s and "duration_seconds" in s]
+        if stages:
+            per_stage = stage_times.setdefault(target, {})
+            for stage in stages:
+                per_stage.setdefault(str(stage.get("name")), []).append(float(stage["duration_seconds"]))
+            per_stage.setdefault("overlap saved", []).append(stage_overlap(stages))
+        for unit, seconds in result["units"]:
+            units.append({"unit": unit, "seconds": seconds, "target": target, "build": build,
+                          "source": result["unit_source"]})
+        for signature, info in result["failures"].items():
+            cluster = clusters.setdefault(signature, {"signature": signature, "count": 0,
+                                                      "builds": [], "targets": [], "examples": []})
+            cluster["count"] += info["count"]
+            if build not in cluster["builds"]:
+                cluster["builds"].append(build)
+            if target not in cluster["targets"]:
+                cluster["targets"].append(target)
+            if len(cluster["examples"]) < MAX_CLUSTER_EXAMPLES:
+                cluster["examples"].append(info["example"])
+
+    targets = {}
+    for target, values in sorted(durations.items()):
+        targets[target] = {
+            "builds": len(values),
+            "failed": failed.get(target, 0),
+            "min": min(values),
+            "median": statistics.median(values),
+            "max": max(values),
+            "histogram": histogram(values, buckets),
+        }
+        if target in stage_times:
+            targets[target]["stages"] = {name: statistics.median(times)
+                                         for name, times in stage_times[target].items()}
+    units.sort(key=lambda u: u["seconds"], reverse=True)
+    return {
+        "generated": time.strftime("%Y-%m-%dT%H:%M:%SZ", time.gmtime()),
+        "builds": len(results),
+        "failed_builds": sum(failed.values()),
+        "logs_analyzed": sum(1 for r in results if r["log_file"]),
+        "targets": targets,
+        "slowest_units": units[:top],
+        # Spread over most builds first: a shared cause beats one noisy log
+        "failure_clusters": sorted(clusters.values(), key=lambda c: (len(c["builds"]), c["count"]),
+                                   reverse=True),
+    }
+
+
+def analyze_directory(log_dir: Path, jobs: Optional[int]) -> List[Dict]:
+    paths = [str(p) for p in sorted(log_dir.glob(SUMMARY_GLOB))]
+    if len(paths) < 2 or jobs == 1:
+        results = map(analyze_build, paths)
+    else:
+        with ProcessPoolExecutor(max_workers=jobs) as pool:
+            results = list(pool.map(analyze_build, paths, chunksize=max(1, len(paths) // 64)))
+    return [r for r in results if r is not None]
+
+
+def format_report(report: Dict, width: int = 30) -> str:
+    out = [f"{report['builds']} builds, {report['failed_builds']} failed, "
+           f"{report['logs_analyzed']} raw logs analysed"]
+    for target, info in report["targets"].items():
+        out.append("")
+        out.append(f"{target}: {info['builds']} builds ({info['failed']} failed), "
+                   f"min {info['min']:.1f}s / median {info['median']:.1f}s / max {info['max']:.1f}s")
+        peak = max(b["count"] for b in info["histogram"]) or 1
+        for bucket in info["histogram"]:
+            bar = "#" * round(bucket["count"] * width / peak)
+            out.append(f"  {bucket['lo']:8.1f} - {bucket['hi']:8.1f}s {bar} {bucket['count']}")
+        if info.get("stages"):
+            out.append("  median stages: " + ", ".join(f"{name} {seconds:.1f}s"
+                                                       for name, seconds in info["stages"].items()))
+    if report["slowest_units"]:
+        out.append("")
+        out.append("Slowest compile units:")
+        for unit in report["slowest_units"]:
+            out.append(f"  {unit['seconds']:8.2f}s  {unit['unit']}  ({unit['build']})")
+    if report["failure_clusters"]:
+        out.append("")
+        out.append("Failure clusters:")
+        for cluster in report["failure_clusters"]:
+            out.append(f"  {len(cluster['builds'])} builds / {cluster['count']}x  {cluster['signature']}")
+            out.append(f"      e.g. {cluster['examples'][0]}")
+    return "\n".join(out)
+
+
+# -- following ---------------------------------------------------------------
+
+class DirectoryWatcher:
+    """
+    Names of files in a directory that were written to, from inotify or
+    kqueue when available, else from comparing stat() results every poll.
+    """
+
+    IN_MODIFY, IN_CLOSE_WRITE, IN_MOVED_TO, IN_CREATE = 0x2, 0x8, 0x80, 0x100
+
+    def __init__(self, directory: Path, interval: float):
+        self.directory = directory
+        self.interval = interval
+        self.backend = "poll"
+        self._stats: Dict[str, Tuple[int, int]] = {}
+        self._kq_files: Dict[int, str] = {}
+        if sys.platform.startswith("linux") and self._init_inotify():
+            self.backend = "inotify"
+        elif hasattr(select, "kqueue"):
+            self._init_kqueue()
+            self.backend = "kqueue"
+        else:
+            self._scan()
+
+    def _init_inotify(self) -> bool:
+        import ctypes
+        import ctypes.util
+        try:
+            libc = ctypes.CDLL(ctypes.util.find_library("c") or "libc.so.6", use_errno=True)
+            fd = libc.inotify_init1(os.O_NONBLOCK | os.O_CLOEXEC)
+        except (OSError, AttributeError):
+            return False
+        if fd < 0:
+            return False
+        mask = self.IN_MODIFY | self.IN_CLOSE_WRITE | self.IN_MOVED_TO | self.IN_CREATE
+        if libc.inotify_add_watch(fd, os.fsencode(self.directory), mask) < 0:
+            os.close(fd)
+            return False
+        self._fd = fd
+        return True
+
+    def _init_kqueue(self) -> None:
+        self._kq = select.kqueue()
+        self._dir_fd = os.open(self.directory, os.O_RDONLY)
+        self._kq.control([select.kevent(self._dir_fd, select.KQ_FILTER_VNODE,
+                                        select.KQ_EV_ADD | select.KQ_EV_CLEAR, select.KQ_NOTE_WRITE)], 0)
+        for entry in os.scandir(self.directory):
+            self._kq_watch(entry.name)
+
+    def _kq_watch(self, name: str) -> None:
+        if name in self._kq_files.values():
+            return
+        try:
+            # O_EVTONLY (macOS) does not keep the volume busy
+            fd = os.open(self.directory / name, os.O_RDONLY | getattr(os, "O_EVTONLY", 0))
+        except OSError:
+            return
+        flags = select.KQ_NOTE_WRITE | select.KQ_NOTE_EXTEND | select.KQ_NOTE_DELETE | select.KQ_NOTE_RENAME
+        self._kq.control([select.kevent(fd, select.KQ_FILTER_VNODE,
+                                        select.KQ_EV_ADD | select.KQ_EV_CLEAR, flags)], 0)
+        self._kq_files[fd] = name
+
+    def _scan(self) -> Set[str]:
+        changed = set()
+        stats = {}
+        for entry in os.scandir(self.directory):
+            try:
+                st = entry.stat()
+            except OSError:
+                continue
+            stats[entry.name] = (st.st_mtime_ns, st.st_size)
+            if self._stats.get(entry.name) != stats[entry.name]:
+                changed.add(entry.name)
+        self._stats = stats
+        return changed
+
+    def wait(self) -> Dict[str, bool]:
+        """Changed file name -> True once the writer closed it (inotify only)"""
+        if self.backend == "inotify":
+            return self._wait_inotify()
+        if self.backend == "kqueue":
+            return self._wait_kqueue()
+        time.sleep(self.interval)
+        return {name: False for name in self._scan()}
+
+    def _wait_inotify(self) -> Dict[str, bool]:
+        import struct
+        changed: Dict[str, bool] = {}
+        if not select.select([self._fd], [], [], self.interval)[0]:
+            return changed
+        try:
+            data = os.read(self._fd, 64 * 1024)
+        except BlockingIOError:
+            return changed
+        offset = 0
+        while offset + 16 <= len(data):
+            _wd, mask, _cookie, length = struct.unpack_from("iIII", data, offset)
+            name = data[offset + 16:offset + 16 + length].rstrip(b"\0").decode(errors="replace")
+            offset += 16 + length
+            if name:
+                closed = bool(mask & (self.IN_CLOSE_WRITE | self.IN_MOVED_TO))
+                changed[name] = changed.get(name, False) or closed
+        return changed
+
+    def _wait_kqueue(self) -> Dict[str, bool]:
+        changed: Dict[str, bool] = {}
+        for event in self._kq.control(None, 256, self.interval):
+            if event.ident == self._dir_fd:
+                for entry in os.scandir(self.directory):
+                    if entry.name not in self._kq_files.values():
+                        self._kq_watch(entry.name)
+                        changed[entry.name] = False
+                continue
+            name = self._kq_files.get(event.ident)
+            if name is None:
+                continue
+            if event.fflags & (select.KQ_NOTE_DELETE | select.KQ_NOTE_RENAME):
+                os.close(event.ident)
+                del self._kq_files[event.ident]
+            changed[name] = False
+        return changed
+
+
+def follow(log_dir: Path, interval: float, errors: bool, emitted: Dict[str, Tuple]) -> None:
+    """
+    Print a summary line whenever a build-summary-*.json is created or
+    rewritten with a new status; with errors, also print new error lines
+    from the *.log files as they are appended. Only the files named by
+    change notifications are read.
+    """
+    watcher = DirectoryWatcher(log_dir, interval)
+    offsets: Dict[str, int] = {}
+    if errors:
+        for path in log_dir.glob("*.log"):
+            offsets[path.name] = path.stat().st_size
+    print(f"# following {log_dir} ({watcher.backend})", file=sys.stderr, flush=True)
+    while True:
+        for name, closed in sorted(watcher.wait().items()):
+            path = log_dir / name
+            if name.startswith("build-summary-") and name.endswith(".json"):
+                if watcher.backend == "inotify" and not closed:
+                    continue  # IN_CLOSE_WRITE follows once the summary is complete
+                summary = read_summary(path)
+                if summary is None:
+                    continue
+                state = (summary.get("status"), summary.get("finished"), summary.get("attempt"))
+                if emitted.get(name) != state:
+                    emitted[name] = state
+                    print(format_summary(summary), flush=True)
+            elif errors and name.endswith(".log"):
+                for line in tail_new_lines(path, offsets):
+                    if ERROR_RE.search(line):
+                        print(f"  [{path.stem}] {line.rstrip()}", flush=True)
+
+
+def tail_new_lines(path: Path, offsets: Dict[str, int]) -> Iterator[str]:
+    """Complete lines appended to path since the last call"""
+    try:
+        with open(path, "rb") as f:
+            size = os.fstat(f.fileno()).st_size
+            offset = offsets.get(path.name, 0)
+            if size < offset:
+                offset = 0  # Truncated or replaced
+            f.seek(offset)
+            data = f.read()
+    except OSError:
+        return
+    end = data.rfind(b"\n") + 1
+    offsets[path.name] = offset + end
+    yield from data[:end].decode("utf-8", errors="replace").splitlines()
+
+
 def main() -> int:
-    parser = argparse.ArgumentParser(description=__doc__)
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
     parser.add_argument("log_dir", help="Directory containing build-summary-*.json files")
     parser.add_argument("--follow", action="store_true", help="Stream summaries in real-time")
-    parser.add_argument("--interval", type=float, default=5.0, help="Polling interval when following")
+    parser.add_argument("--interval", type=float, default=5.0,
+                        help="Polling interval when following without inotify/kqueue")
+    parser.add_argument("--errors", action="store_true",
+                        help="With --follow, also stream error lines from the raw *.log files")
+    parser.add_argument("--jobs", type=int, help="Worker processes for log analysis (default: all cores)")
+    parser.add_argument("--report", type=Path, help="Also write the merged report as JSON")
+    parser.add_argument("--top", type=int, default=20, help="Slowest compile units to list")
+    parser.add_argument("--buckets", type=int, default=8, help="Duration histogram buckets per target")
+    parser.add_argument("--no-analyze", action="store_true", help="Only list the summaries")
     args = parser.parse_args()
 
     log_dir = Path(args.log_dir).expanduser().resolve()
     if not log_dir.exists():
         raise SystemExit(f"Log directory not found: {log_dir}")
 
-    seen: set[str] = set()
+    emitted: Dict[str, Tuple] = {}
+    for summary in read_summaries(log_dir):
+        emitted[Path(summary["_path"]).name] = (summary.get("status"), summary.get("finished"),
+                                                summary.get("attempt"))
+        print(format_summary(summary))
 
-    def emit_new() -> None:
-        for summary in read_summaries(log_dir):
-            path = summary.get("_path")
-            if path in seen:
-                continue
-            seen.add(path)
-            print(format_summary(summary))
-
-    emit_new()
     if args.follow:
+        sys.stdout.flush()
         try:
-            while True:
-                time.sleep(args.interval)
-                emit_new()
+            follow(log_dir, args.interval, args.errors, emitted)
         except KeyboardInterrupt:
             pass
+        return 0
+
+    if not args.no_analyze:
+        report = build_report(analyze_directory(log_dir, args.jobs), top=args.top, buckets=max(1, args.buckets))
+        print()
+        print(format_report(report))
+        if args.report:
+            args.report.write_text(json.dumps(report, indent=2), encoding="utf-8")
 
     return 0
 
 
 if __name__ == "__main__":
     raise SystemExit(main())
-
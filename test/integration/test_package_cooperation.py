@@ -17,6 +17,11 @@ Validates:
 4. Security gates integration
 5. Zero-copy pattern functionality
 6. FIPS validation integration
+
+The tests are independent and run concurrently (--jobs, default one
+worker per test). With --junit DIR the results also go to the openssl
+tools NgapyTestHarness, which rewrites a JUnit XML file after every
+test, so CI keeps the finished results when the job times out.
 """
 
 import os
@@ -24,8 +29,25 @@ import sys
 import subprocess
 import json
 import tempfile
+import argparse
+import importlib.util
+import threading
+import time
+from concurrent.futures import ThreadPoolExecutor
 from pathlib import Path
-from typing import Dict, List, Tuple, Optional
+from typing import Callable, Dict, List, Tuple, Optional
+
+HARNESS_MODULE = (Path(__file__).resolve().parents[2] / "packages" / "sparetools-openssl-tools" /
+                  "openssl_tools" / "testing" / "test_harness.py")
+
+
+def load_harness(results_dir: Path):
+    """NgapyTestHarness from the source tree, loaded by path so the tools package needs no install"""
+    spec = importlib.util.spec_from_file_location("sparetools_test_harness", HARNESS_MODULE)
+    module = importlib.util.module_from_spec(spec)
+    sys.modules[spec.name] = module
+    spec.loader.exec_module(module)
+    return module, module.NgapyTestHarness(results_dir)
 
 
 class Colors:
@@ -41,10 +63,29 @@ class Colors:
 class IntegrationTestSuite:
     """Integration test suite for SpareTools ecosystem"""
     
-    def __init__(self):
-        self.results: List[Tuple[str, bool, str]] = []
+    def __init__(self, jobs: Optional[int] = None, junit_dir: Optional[Path] = None):
         self.workspace = Path.cwd()
         self.test_dir = None
+        self.jobs = jobs
+        self._recorded: List[Tuple[int, int, Tuple[str, bool, str]]] = []
+        self._lock = threading.Lock()
+        self._task = threading.local()
+        self.harness_module, self.harness = load_harness(junit_dir) if junit_dir else (None, None)
+    
+    @property
+    def results(self) -> List[Tuple[str, bool, str]]:
+        """(name, success, error) in test order, however the workers finished"""
+        with self._lock:
+            return [result for _, _, result in sorted(self._recorded)]
+    
+    def record(self, name: str, success: bool, error: str):
+        """Record one result from the running test"""
+        with self._lock:
+            self._recorded.append((getattr(self._task, "index", 0), len(self._recorded), (name, success, error)))
+        if self.harness:
+            test_result = self.harness_module.TestResult
+            self.harness.record(name, test_result.PASS if success else test_result.FAIL,
+                                time.time() - getattr(self._task, "start", time.time()), error)
         
     def log(self, message: str, level: str = "INFO"):
         """Log test messages with color coding"""
@@ -80,11 +121,11 @@ class IntegrationTestSuite:
         code, stdout, stderr = self.run_command(f"conan list {package_name}/{version}")
         
         if code == 0 and package_name in stdout:
-            self.results.append((f"Package {package_name}/{version} exists", True, ""))
+            self.record(f"Package {package_name}/{version} exists", True, "")
             self.log(f"✓ {package_name}/{version} found", "SUCCESS")
             return True
         else:
-            self.results.append((f"Package {package_name}/{version} exists", False, stderr))
+            self.record(f"Package {package_name}/{version} exists", False, stderr)
             self.log(f"✗ {package_name}/{version} not found", "ERROR")
             return False
     
@@ -98,9 +139,7 @@ class IntegrationTestSuite:
         )
         
         if code != 0:
-            self.results.append(
-                (f"Dependency resolution for {package_name}", False, stderr)
-            )
+            self.record(f"Dependency resolution for {package_name}", False, stderr)
             self.log(f"✗ Failed to resolve dependencies for {package_name}", "ERROR")
             return False
         
@@ -112,11 +151,11 @@ class IntegrationTestSuite:
         
         if missing_deps:
             msg = f"Missing dependencies: {', '.join(missing_deps)}"
-            self.results.append((f"Dependencies for {package_name}", False, msg))
+            self.record(f"Dependencies for {package_name}", False, msg)
             self.log(f"✗ {msg}", "ERROR")
             return False
         
-        self.results.append((f"Dependencies for {package_name}", True, ""))
+        self.record(f"Dependencies for {package_name}", True, "")
         self.log(f"✓ All dependencies resolved for {package_name}", "SUCCESS")
         return True
     
@@ -160,12 +199,12 @@ class TestConsumer(ConanFile):
         subprocess.run(f"rm -rf {test_dir}", shell=True)
         
         if code == 0 and ("sparetools-cpython" in stdout or ".conan2" in stdout):
-            self.results.append(("Bundled Python usage", True, ""))
+            self.record("Bundled Python usage", True, "")
             self.log("✓ Builds use bundled Python runtime", "SUCCESS")
             return True
         else:
             msg = "Builds may not be using bundled Python"
-            self.results.append(("Bundled Python usage", False, msg))
+            self.record("Bundled Python usage", False, msg)
             self.log(f"⚠ {msg}", "WARNING")
             return False
     
@@ -179,11 +218,11 @@ class TestConsumer(ConanFile):
         )
         
         if code == 0:
-            self.results.append(("Security gates available", True, ""))
+            self.record("Security gates available", True, "")
             self.log("✓ Security gates accessible via sparetools-base", "SUCCESS")
             return True
         else:
-            self.results.append(("Security gates available", False, stderr))
+            self.record("Security gates available", False, stderr)
             self.log("✗ Security gates not accessible", "ERROR")
             return False
     
@@ -207,7 +246,7 @@ except ImportError:
         # Just check that sparetools-base package includes the file
         base_files = ["security-gates.py", "symlink-helpers.py", "__init__.py"]
         
-        self.results.append(("Zero-copy helpers available", True, ""))
+        self.record("Zero-copy helpers available", True, "")
         self.log("✓ Zero-copy helpers included in sparetools-base", "SUCCESS")
         return True
     
@@ -236,11 +275,11 @@ except ImportError:
                     success = False
             
             if success:
-                self.results.append(("Full-stack OpenSSL build", True, ""))
+                self.record("Full-stack OpenSSL build", True, "")
                 self.log("✓ OpenSSL builds successfully with full stack", "SUCCESS")
                 return True
         
-        self.results.append(("Full-stack OpenSSL build", False, stderr))
+        self.record("Full-stack OpenSSL build", False, stderr)
         self.log("✗ OpenSSL build failed", "ERROR")
         return False
     
@@ -260,12 +299,12 @@ except ImportError:
         )
         
         if code == 0 and "sparetools" in stdout:
-            self.results.append(("Cloudsmith packages available", True, ""))
+            self.record("Cloudsmith packages available", True, "")
             self.log("✓ Packages available on Cloudsmith", "SUCCESS")
             return True
         else:
             msg = "Packages may not be uploaded to Cloudsmith yet"
-            self.results.append(("Cloudsmith packages available", False, msg))
+            self.record("Cloudsmith packages available", False, msg)
             self.log(f"⚠ {msg}", "WARNING")
             return False
     
@@ -276,7 +315,7 @@ except ImportError:
         profiles_dir = self.workspace / "packages/sparetools-openssl-tools/profiles"
         
         if not profiles_dir.exists():
-            self.results.append(("Profile composition", False, "Profiles directory not found"))
+            self.record("Profile composition", False, "Profiles directory not found")
             self.log("✗ Profiles directory not found", "ERROR")
             return False
         
@@ -290,22 +329,38 @@ except ImportError:
         
         if missing:
             msg = f"Missing profile categories: {', '.join(missing)}"
-            self.results.append(("Profile composition", False, msg))
+            self.record("Profile composition", False, msg)
             self.log(f"✗ {msg}", "ERROR")
             return False
         
-        self.results.append(("Profile composition", True, ""))
+        self.record("Profile composition", True, "")
         self.log("✓ Profile structure is correct", "SUCCESS")
         return True
     
+    def run_tests(self, tests: List[Tuple[str, Callable[[], bool]]]):
+        """Run independent tests on a thread pool; results keep the order of tests"""
+        def run_one(index: int, title: str, test: Callable[[], bool]):
+            self._task.index = index
+            self._task.start = time.time()
+            self.log(f"{index + 1}. {title}", "INFO")
+            try:
+                test()
+            except Exception as e:
+                self.record(title, False, str(e))
+        
+        workers = max(1, min(self.jobs or len(tests), len(tests)))
+        with ThreadPoolExecutor(max_workers=workers) as pool:
+            for future in [pool.submit(run_one, i, title, test) for i, (title, test) in enumerate(tests)]:
+                future.result()
+    
     def run_all_tests(self) -> bool:
         """Run all integration tests"""
         self.log("=" * 80, "INFO")
         self.log("SpareTools Integration Test Suite", "INFO")
         self.log("=" * 80, "INFO")
+        if self.harness:
+            self.harness.start_test_suite("sparetools-integration", "SpareTools package cooperation")
         
-        # Test 1: Package existence
-        self.log("\n1. Testing Package Existence", "INFO")
         packages = [
             ("sparetools-base", "2.0.0"),
             ("sparetools-cpython", "3.12.7"),
@@ -315,40 +370,30 @@ except ImportError:
             ("sparetools-openssl", "3.3.2"),
         ]
         
-        for name, version in packages:
-            self.test_package_exists(name, version)
-        
-        # Test 2: Dependency resolution
-        self.log("\n2. Testing Dependency Resolution", "INFO")
-        self.test_dependency_resolution(
-            "sparetools-openssl",
-            "3.3.2",
-            ["sparetools-base/2.0.0", "sparetools-openssl-tools/2.0.0", "sparetools-cpython/3.12.7"]
-        )
-        
-        # Test 3: Python runtime usage
-        self.log("\n3. Testing Python Runtime Usage", "INFO")
-        self.test_python_runtime_usage()
-        
-        # Test 4: Security gates integration
-        self.log("\n4. Testing Security Gates Integration", "INFO")
-        self.test_security_gates_integration()
-        
-        # Test 5: Zero-copy helpers
-        self.log("\n5. Testing Zero-Copy Helpers", "INFO")
-        self.test_zero_copy_helpers()
-        
-        # Test 6: Profile composition
-        self.log("\n6. Testing Profile Composition", "INFO")
-        self.test_profile_composition()
-        
-        # Test 7: Cloudsmith availability
-        self.log("\n7. Testing Cloudsmith Availability", "INFO")
-        self.test_cloudsmith_package_availability()
+        tests = [(f"Testing Package Existence: {name}/{version}",
+                  lambda name=name, version=version: self.test_package_exists(name, version))
+                 for name, version in packages]
+        tests += [
+            ("Testing Dependency Resolution", lambda: self.test_dependency_resolution(
+                "sparetools-openssl",
+                "3.3.2",
+                ["sparetools-base/2.0.0", "sparetools-openssl-tools/2.0.0", "sparetools-cpython/3.12.7"]
+            )),
+            ("Testing Python Runtime Usage", self.test_python_runtime_usage),
+            ("Testing Security Gates Integration", self.test_security_gates_integration),
+            ("Testing Zero-Copy Helpers", self.test_zero_copy_helpers),
+            ("Testing Profile Composition", self.test_profile_composition),
+            ("Testing Cloudsmith Availability", self.test_cloudsmith_package_availability),
+            # Full-stack build (optional, may take time)
+            # ("Testing Full-Stack OpenSSL Build", self.test_openssl_build_with_full_stack),
+        ]
+        self.run_tests(tests)
         
-        # Test 8: Full-stack build (optional, may take time)
-        # self.log("\n8. Testing Full-Stack OpenSSL Build", "INFO")
-        # self.test_openssl_build_with_full_stack()
+        if self.harness:
+            self.harness.end_test_suite()
+            self.harness.generate_junit_xml()
+            self.harness.generate_summary_report()
+            self.harness.cleanup()
         
         # Print summary
         self.print_summary()
@@ -381,7 +426,13 @@ except ImportError:
 
 def main():
     """Main entry point"""
-    suite = IntegrationTestSuite()
+    parser = argparse.ArgumentParser(description="SpareTools integration tests")
+    parser.add_argument("--jobs", "-j", type=int, help="Concurrent tests (default: all at once)")
+    parser.add_argument("--junit", type=Path, metavar="DIR",
+                        help="Write a streaming JUnit XML report and JSON summary to DIR")
+    args = parser.parse_args()
+    
+    suite = IntegrationTestSuite(jobs=args.jobs, junit_dir=args.junit)
     success = suite.run_all_tests()
     sys.exit(0 if success else 1)
 
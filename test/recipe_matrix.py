@@ -0,0 +1,419 @@
+#!/usr/bin/env python3
+"""
+Cross-platform checks against the real sparetools-openssl recipe
+
+Evaluates SpareToolsOpenSSLConan._get_target() and _get_configure_args()
+for every entry of MATRIX (OS, arch, compiler, options) without running
+Conan: the recipe class is loaded from packages/sparetools-openssl and
+given stand-ins for settings, options and conf. When Conan is not
+installed the handful of conan modules the recipe imports are stubbed.
+
+- evaluate_matrix() runs the configurations on a process pool.
+- configure_check() runs OpenSSL's Configure with the recipe's arguments
+  in a container, out of tree and without compiling, so Configure itself
+  validates the target and flag combination. Linux targets run in a
+  container of their own architecture (QEMU user emulation through
+  binfmt, as docker buildx sets up); other targets are configured in a
+  host container.
+- ResultCache stores both kinds of results in a JSON file, keyed by the
+  recipe digest (plus the OpenSSL source digest for Configure checks), so
+  an unchanged recipe is not evaluated twice.
+"""
+
+import hashlib
+import importlib.util
+import json
+import os
+import platform
+import shutil
+import subprocess
+import sys
+import threading
+import types
+from concurrent.futures import ProcessPoolExecutor, ThreadPoolExecutor
+from pathlib import Path
+from typing import Any, Dict, List, Optional
+
+REPO_ROOT = Path(__file__).resolve().parents[1]
+RECIPE = REPO_ROOT / "packages" / "sparetools-openssl" / "conanfile.py"
+DEFAULT_CACHE = REPO_ROOT / "test_results" / "cross_platform_cache.json"
+PACKAGE_FOLDER = "/opt/openssl"
+DEFAULT_IMAGE = "perl:5-slim"
+
+# Configurations every recipe change has to keep working
+MATRIX: List[Dict[str, Any]] = [
+    {"name": "Ubuntu 22.04 x86_64", "os": "Linux", "arch": "x86_64", "compiler": "gcc",
+     "expected_target": "linux-x86_64", "expected_args": ["no-shared"]},
+    {"name": "Ubuntu 22.04 x86_64 shared", "os": "Linux", "arch": "x86_64", "compiler": "gcc",
+     "options": {"shared": True}, "expected_target": "linux-x86_64", "expected_args": ["shared"]},
+    {"name": "Linux x86_64 static FIPS", "os": "Linux", "arch": "x86_64", "compiler": "gcc",
+     "options": {"shared": False, "fips": True},
+     "expected_target": "linux-x86_64", "expected_args": ["no-shared", "enable-fips"]},
+    {"name": "Linux x86_64 no-asm", "os": "Linux", "arch": "x86_64", "compiler": "gcc",
+     "options": {"enable_asm": False}, "expected_target": "linux-x86_64", "expected_args": ["no-asm"]},
+    {"name": "Linux x86_64 clang ThinLTO static", "os": "Linux", "arch": "x86_64", "compiler": "clang",
+     "options": {"shared": False, "lto": "thin"},
+     "expected_target": "linux-x86_64", "expected_args": ["AR=llvm-ar", "RANLIB=llvm-ranlib"]},
+    {"name": "Linux 32-bit x86", "os": "Linux", "arch": "x86", "compiler": "gcc",
+     "expected_target": "linux-x86"},
+    {"name": "Raspberry Pi 4 (64-bit)", "os": "Linux", "arch": "armv8", "compiler": "gcc",
+     "expected_target": "linux-aarch64"},
+    {"name": "Raspberry Pi 3 (32-bit) static", "os": "Linux", "arch": "armv7", "compiler": "gcc",
+     "options": {"shared": False}, "expected_target": "linux-armv4", "expected_args": ["no-shared"]},
+    {"name": "Linux ppc64le", "os": "Linux", "arch": "ppc64le", "compiler": "gcc",
+     "expected_target": "linux-ppc64le"},
+    {"name": "Linux mips64", "os": "Linux", "arch": "mips64", "compiler": "gcc",
+     "expected_target": "linux-mips64"},
+    {"name": "macOS Intel", "os": "Macos", "arch": "x86_64", "compiler": "apple-clang",
+     "expected_target": "darwin64-x86_64-cc"},
+    {"name": "macOS Apple Silicon", "os": "Macos", "arch": "armv8", "compiler": "apple-clang",
+     "expected_target": "darwin64-arm64-cc"},
+    {"name": "Windows x64 (MSVC)", "os": "Windows", "arch": "x86_64", "compiler": "msvc",
+     "expected_target": "VC-WIN64A"},
+    {"name": "Windows x86 (MSVC)", "os": "Windows", "arch": "x86", "compiler": "msvc",
+     "expected_target": "VC-WIN32"},
+    {"name": "Windows ARM64 (MSVC)", "os": "Windows", "arch": "armv8", "compiler": "msvc",
+     "expected_target": "VC-WIN-ARM64"},
+    {"name": "FreeBSD x86_64", "os": "FreeBSD", "arch": "x86_64", "compiler": "clang",
+     "expected_target": "BSD-x86_64"},
+    {"name": "Android arm64", "os": "Android", "arch": "armv8", "compiler": "clang",
+     "options": {"shared": False}, "expected_target": "android-arm64"},
+    {"name": "Android armv7", "os": "Android", "arch": "armv7", "compiler": "clang",
+     "options": {"shared": False}, "expected_target": "android-arm"},
+    {"name": "iOS arm64", "os": "iOS", "arch": "armv8", "compiler": "apple-clang",
+     "options": {"shared": False}, "expected_target": "ios64-cross"},
+]
+
+# Linux Configure targets checked in a container of their own architecture
+DOCKER_PLATFORMS = {
+    "linux-x86_64": "linux/amd64",
+    "linux-x86": "linux/386",
+    "linux-aarch64": "linux/arm64",
+    "linux-armv4": "linux/arm/v7",
+    "linux-ppc64le": "linux/ppc64le",
+    "linux-mips64": "linux/mips64le",
+}
+
+
+def file_digest(*paths: Path) -> str:
+    digest = hashlib.sha256()
+    for path in paths:
+        digest.update(path.read_bytes())
+    return digest.hexdigest()
+
+
+def recipe_digest(recipe: Path = RECIPE) -> str:
+    return file_digest(recipe)
+
+
+def source_digest(source_dir: Path) -> str:
+    """What Configure's result depends on: Configure, the target configs and the version"""
+    files = [source_dir / "Configure", source_dir / "VERSION.dat"]
+    files += sorted((source_dir / "Configurations").glob("*.conf"))
+    return file_digest(*[f for f in files if f.is_file()])
+
+
+def config_key(config: Dict[str, Any]) -> str:
+    return json.dumps({k: config.get(k) for k in ("os", "arch", "compiler", "options")}, sort_keys=True)
+
+
+# --- recipe stand-ins --------------------------------------------------------
+
+def _install_conan_stubs():
+    """The conan API names the recipe imports, as no-ops (never called while evaluating)"""
+    def module(name, **attrs):
+        mod = types.ModuleType(name)
+        mod.__dict__.update(attrs)
+        sys.modules[name] = mod
+        return mod
+
+    class ConanException(Exception):
+        pass
+
+    class ConanInvalidConfiguration(ConanException):
+        pass
+
+    noop = lambda *args, **kwargs: None
+    module("conan", ConanFile=object)
+    module("conan.errors", ConanException=ConanException, ConanInvalidConfiguration=ConanInvalidConfiguration)
+    module("conan.tools")
+    module("conan.tools.build", cross_building=lambda conanfile: False)
+    module("conan.tools.files", copy=noop, save=noop, load=noop, patch=noop, replace_in_file=noop,
+           rm=noop, rmdir=noop)
+    module("conan.tools.gnu", Autotools=None, AutotoolsToolchain=None)
+    module("conan.tools.cmake", CMake=None, CMakeToolchain=None, cmake_layout=noop)
+    module("conan.tools.layout", basic_layout=noop)
+    module("conan.tools.scm", Version=str)
+
+
+def load_recipe_class(recipe: Path = RECIPE):
+    try:
+        import conan  # noqa: F401
+    except ImportError:
+        _install_conan_stubs()
+    spec = importlib.util.spec_from_file_location("sparetools_openssl_recipe", recipe)
+    module = importlib.util.module_from_spec(spec)
+    spec.loader.exec_module(module)
+    return module.SpareToolsOpenSSLConan
+
+
+class Value(str):
+    """A setting or option value: compares as a string, "False"/"None" are falsy"""
+
+    def __new__(cls, value, **subsettings):
+        self = super().__new__(cls, str(value))
+        self._subsettings = subsettings
+        return self
+
+    def __bool__(self):
+        return str(self) not in ("False", "None", "")
+
+    def __getattr__(self, name):
+        if name.startswith("_"):
+            raise AttributeError(name)
+        return Value(self._subsettings.get(name))
+
+
+class Attributes:
+    """settings/options: attribute access to Values, get_safe() for optional names"""
+
+    def __init__(self, values: Dict[str, Any]):
+        self._values = values
+
+    def __getattr__(self, name):
+        if name.startswith("_") or name not in self._values:
+            raise AttributeError(name)
+        value = self._values[name]
+        return value if isinstance(value, Value) else Value(value)
+
+    def get_safe(self, name, default=None):
+        head, _, tail = name.partition(".")
+        if head not in self._values:
+            return default
+        value = getattr(self, head)
+        if tail:
+            value = getattr(value, tail)
+        return default if str(value) == "None" else value
+
+
+class Conf:
+    def __init__(self, values: Optional[Dict[str, Any]] = None):
+        self._values = values or {}
+
+    def get(self, name, default=None, check_type=None):
+        return self._values.get(name, default)
+
+
+class Output:
+    def __init__(self):
+        self.messages: List[str] = []
+
+    def _log(self, level):
+        return lambda message, *args, **kwargs: self.messages.append(f"{level}: {message}")
+
+    def __getattr__(self, level):
+        return self._log(level)
+
+
+def make_conanfile(recipe_class, config: Dict[str, Any]):
+    """A recipe instance for one MATRIX entry; Conan's ConanFile.__init__ is not run"""
+    probe_class = type("RecipeProbe", (recipe_class,), {
+        "output": property(lambda self: self._probe_output),
+        "package_folder": PACKAGE_FOLDER,
+        "build_folder": "/tmp/sparetools-openssl-build",
+        "source_folder": "/tmp/sparetools-openssl-src",
+        "dependencies": None,
+    })
+    conanfile = object.__new__(probe_class)
+    compiler = config.get("compiler", "gcc")
+    conanfile.settings = Attributes({
+        "os": config["os"],
+        "arch": config["arch"],
+        "build_type": config.get("build_type", "Release"),
+        "compiler": Value(compiler, version=config.get("compiler_version", "13"),
+                          libcxx=None, cppstd=None),
+    })
+    options = dict(recipe_class.default_options)
+    options.update(config.get("options", {}))
+    conanfile.options = Attributes(options)
+    # Hermetic: neither the host's CC nor its ccache leak into the arguments
+    conanfile.conf = Conf({"tools.build:compiler_executables": {"c": config.get("cc") or
+                           {"msvc": "cl", "gcc": "gcc"}.get(compiler, "clang")}})
+    conanfile._probe_output = Output()
+    return conanfile
+
+
+# --- evaluation --------------------------------------------------------------
+
+def evaluate(config: Dict[str, Any], recipe: str = str(RECIPE)) -> Dict[str, Any]:
+    """_get_target() and _get_configure_args() for one configuration"""
+    result = {"name": config["name"], "key": config_key(config)}
+    try:
+        conanfile = make_conanfile(load_recipe_class(Path(recipe)), config)
+        result["target"] = conanfile._get_target()
+        result["args"] = conanfile._get_configure_args()
+        result["warnings"] = conanfile._probe_output.messages
+    except Exception as e:
+        result["error"] = f"{type(e).__name__}: {e}"
+    return result
+
+
+def check_expectations(config: Dict[str, Any], result: Dict[str, Any]) -> Dict[str, Any]:
+    """passed/error from the configuration's expected_target and expected_args"""
+    if "target" not in result:
+        return dict(result, passed=False)
+    problems = []
+    if config.get("expected_target") and result["target"] != config["expected_target"]:
+        problems.append(f"target {result['target']}, expected {config['expected_target']}")
+    if result["args"][:1] != [result["target"]]:
+        problems.append("configure arguments do not start with the target")
+    missing = [arg for arg in config.get("expected_args", []) if arg not in result["args"]]
+    if missing:
+        problems.append(f"missing arguments {', '.join(missing)}")
+    return dict(result, passed=not problems, error="; ".join(problems))
+
+
+class ResultCache:
+    """JSON file of results, one section per recipe (and source) digest"""
+
+    def __init__(self, path: Optional[Path] = DEFAULT_CACHE):
+        self.path = path
+        self._lock = threading.Lock()
+        self._data: Dict[str, Dict[str, Any]] = {}
+        if path and path.is_file():
+            try:
+                self._data = json.loads(path.read_text())
+            except (OSError, json.JSONDecodeError):
+                self._data = {}
+
+    def get(self, section: str, key: str) -> Optional[Dict[str, Any]]:
+        with self._lock:
+            return self._data.get(section, {}).get(key)
+
+    def put(self, section: str, key: str, result: Dict[str, Any]):
+        with self._lock:
+            self._data.setdefault(section, {})[key] = result
+
+    def save(self, keep_sections: List[str]):
+        """Write the file, dropping sections of older recipe revisions"""
+        if not self.path:
+            return
+        with self._lock:
+            data = {section: self._data[section] for section in keep_sections if section in self._data}
+        self.path.parent.mkdir(parents=True, exist_ok=True)
+        tmp = self.path.with_suffix(".tmp")
+        tmp.write_text(json.dumps(data, indent=2, sort_keys=True))
+        os.replace(tmp, self.path)
+
+
+def _worker_init():
+    # _c_compiler falls back to CC; evaluation must not depend on the caller's shell
+    os.environ.pop("CC", None)
+
+
+def evaluate_matrix(configs: List[Dict[str, Any]] = MATRIX, jobs: Optional[int] = None,
+                    cache: Optional[ResultCache] = None, recipe: Path = RECIPE) -> List[Dict[str, Any]]:
+    """
+    Evaluate configurations in parallel and check them against their
+    expectations; evaluations cached for this recipe digest are reused
+    """
+    section = f"recipe:{recipe_digest(recipe)}"
+    results: List[Optional[Dict[str, Any]]] = [None] * len(configs)
+    pending = []
+    for index, config in enumerate(configs):
+        cached = cache.get(section, config_key(config)) if cache else None
+        if cached is not None:
+            results[index] = check_expectations(config, dict(cached, name=config["name"], cached=True))
+        else:
+            pending.append(index)
+    if pending:
+        with ProcessPoolExecutor(max_workers=jobs, initializer=_worker_init) as pool:
+            for index, result in zip(pending, pool.map(evaluate, [configs[i] for i in pending],
+                                                       [str(recipe)] * len(pending))):
+                if cache and "target" in result:
+                    cache.put(section, config_key(configs[index]), result)
+                results[index] = check_expectations(configs[index], dict(result, cached=False))
+    return results
+
+
+# --- Configure dry runs --------------------------------------------------------
+
+def container_engine() -> Optional[str]:
+    for engine in ("docker", "podman"):
+        if shutil.which(engine):
+            return engine
+    return None
+
+
+def host_platform() -> str:
+    machine = platform.machine().lower()
+    return {"x86_64": "linux/amd64", "amd64": "linux/amd64", "aarch64": "linux/arm64",
+            "arm64": "linux/arm64"}.get(machine, "linux/amd64")
+
+
+def configure_check(result: Dict[str, Any], source_dir: Path, engine: str, image: str = DEFAULT_IMAGE,
+                    timeout: int = 600) -> Dict[str, Any]:
+    """Run Configure with the recipe's arguments in a container; passes when configdata.pm is written"""
+    target = result["target"]
+    docker_platform = DOCKER_PLATFORMS.get(target, host_platform())
+    # CC="launcher cc" is quoted for a shell; the container gets plain argv
+    args = [arg.replace('"', "") for arg in result["args"]]
+    script = 'cd "$(mktemp -d)" && perl /src/Configure "$@" >configure.log 2>&1; ' \
+             'status=$?; tail -n 20 configure.log; test $status -eq 0 && test -f configdata.pm'
+    command = [engine, "run", "--rm", "--network=none", "--platform", docker_platform,
+               "-v", f"{source_dir.resolve()}:/src:ro", image, "sh", "-c", script, "configure"] + args
+    check = {"name": result["name"], "target": target, "platform": docker_platform}
+    try:
+        proc = subprocess.run(command, capture_output=True, text=True, timeout=timeout)
+        check["passed"] = proc.returncode == 0
+        check["error"] = "" if check["passed"] else (proc.stdout + proc.stderr).strip()[-2000:]
+    except subprocess.TimeoutExpired:
+        check.update(passed=False, error=f"Configure timed out after {timeout}s")
+    except OSError as e:
+        check.update(passed=False, error=str(e))
+    return check
+
+
+def configure_checks(results: List[Dict[str, Any]], source_dir: Path, jobs: Optional[int] = None,
+                     cache: Optional[ResultCache] = None, image: str = DEFAULT_IMAGE,
+                     recipe: Path = RECIPE) -> List[Dict[str, Any]]:
+    """Configure every evaluated configuration concurrently, one container per target"""
+    engine = container_engine()
+    if engine is None:
+        return []
+    section = f"configure:{recipe_digest(recipe)}:{source_digest(source_dir)}:{image}"
+    evaluated = [r for r in results if "target" in r]
+    checks: List[Optional[Dict[str, Any]]] = [None] * len(evaluated)
+    pending = []
+    for index, result in enumerate(evaluated):
+        cached = cache.get(section, result["key"]) if cache else None
+        if cached is not None:
+            checks[index] = dict(cached, cached=True)
+        else:
+            pending.append(index)
+    with ThreadPoolExecutor(max_workers=jobs or len(pending) or 1) as pool:
+        for index, check in zip(pending, pool.map(lambda i: configure_check(evaluated[i], source_dir, engine, image),
+                                                  pending)):
+            checks[index] = dict(check, cached=False)
+            if cache and check["passed"]:
+                cache.put(section, evaluated[index]["key"], check)
+    return checks
+
+
+def cache_sections(source_dir: Optional[Path] = None, image: str = DEFAULT_IMAGE,
+                   recipe: Path = RECIPE) -> List[str]:
+    """The cache sections of the current recipe (and source tree), the ones save() keeps"""
+    sections = [f"recipe:{recipe_digest(recipe)}"]
+    if source_dir:
+        sections.append(f"configure:{recipe_digest(recipe)}:{source_digest(source_dir)}:{image}")
+    return sections
+
+
+def find_openssl_source() -> Optional[Path]:
+    """OPENSSL_SOURCE_DIR, or an openssl-* tree next to the recipe"""
+    candidates = [os.environ.get("OPENSSL_SOURCE_DIR")]
+    candidates += [str(p) for p in sorted(RECIPE.parent.glob("openssl-*"))]
+    for candidate in candidates:
+        if candidate and (Path(candidate) / "Configure").is_file():
+            return Path(candidate)
+    return None
@@ -1,11 +1,24 @@
 #!/usr/bin/env python3
 """
 Simulate Conan cross-platform builds to test the DevEnv conanfile.py
+
+The recipe matrix runs the real sparetools-openssl _get_target() and
+_get_configure_args() for every configuration of recipe_matrix.MATRIX
+on a process pool. Results are cached per recipe digest
+(test_results/cross_platform_cache.json). With --configure, OpenSSL's
+Configure is run with those arguments in one Docker/Podman container
+per configuration, concurrently (QEMU emulation for non-native Linux
+targets).
 """
 
+import argparse
 import sys
+import time
 from pathlib import Path
 
+sys.path.insert(0, str(Path(__file__).resolve().parent))
+import recipe_matrix
+
 def simulate_conan_settings():
     """Simulate different Conan settings objects and test platform detection"""
 
@@ -218,6 +231,67 @@ def test_real_world_scenarios():
         print()
 
 
+def test_recipe_matrix(jobs=None, cache=None):
+    """Evaluate the real recipe for every matrix configuration in parallel"""
+
+    print("="*70)
+    print("RECIPE CONFIGURE MATRIX")
+    print("="*70)
+    print()
+
+    start = time.time()
+    results = recipe_matrix.evaluate_matrix(jobs=jobs, cache=cache)
+
+    for r in results:
+        status = "✅" if r["passed"] else "❌"
+        source = " (cached)" if r["cached"] else ""
+        print(f"{status} {r['name']:35} → {r.get('target', '-'):20}{source}")
+        if not r["passed"]:
+            print(f"     {r['error']}")
+
+    passed_count = sum(1 for r in results if r["passed"])
+    print()
+    print(f"Results: {passed_count}/{len(results)} configurations passed "
+          f"({sum(1 for r in results if r['cached'])} cached, {time.time() - start:.2f}s)")
+    print()
+    return results, passed_count == len(results)
+
+
+def test_configure_dry_runs(results, source_dir, jobs=None, cache=None, image=recipe_matrix.DEFAULT_IMAGE):
+    """Run Configure for every evaluated configuration in containers, concurrently"""
+
+    print("="*70)
+    print("CONFIGURE DRY RUNS")
+    print("="*70)
+    print()
+
+    if source_dir is None:
+        print("⚠️  SKIP: no OpenSSL source tree (--openssl-source or OPENSSL_SOURCE_DIR)")
+        print()
+        return True
+    if recipe_matrix.container_engine() is None:
+        print("⚠️  SKIP: neither docker nor podman is installed")
+        print()
+        return True
+
+    start = time.time()
+    checks = recipe_matrix.configure_checks(results, source_dir, jobs=jobs, cache=cache, image=image)
+
+    for check in checks:
+        status = "✅" if check["passed"] else "❌"
+        source = " (cached)" if check["cached"] else ""
+        print(f"{status} {check['name']:35} {check['target']:20} [{check['platform']}]{source}")
+        if not check["passed"]:
+            for line in check["error"].splitlines()[-5:]:
+                print(f"     {line}")
+
+    passed_count = sum(1 for c in checks if c["passed"])
+    print()
+    print(f"Results: {passed_count}/{len(checks)} Configure runs passed ({time.time() - start:.1f}s)")
+    print()
+    return passed_count == len(checks)
+
+
 def verify_files_exist():
     """Verify that all the fixed files exist and contain expected content"""
 
@@ -289,13 +363,32 @@ def verify_files_exist():
 
 
 if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description="Cross-platform checks of the sparetools-openssl recipe")
+    parser.add_argument("--jobs", "-j", type=int, help="Parallel evaluations and containers")
+    parser.add_argument("--cache", type=Path, default=recipe_matrix.DEFAULT_CACHE,
+                        help="Result cache keyed by recipe digest")
+    parser.add_argument("--no-cache", action="store_true", help="Evaluate everything again")
+    parser.add_argument("--configure", action="store_true",
+                        help="Also run Configure for every configuration in containers")
+    parser.add_argument("--openssl-source", type=Path, help="OpenSSL source tree for --configure")
+    parser.add_argument("--image", default=recipe_matrix.DEFAULT_IMAGE, help="Container image with perl")
+    args = parser.parse_args()
+
     print("\n🧪 COMPREHENSIVE CROSS-PLATFORM TEST SUITE\n")
 
+    cache = None if args.no_cache else recipe_matrix.ResultCache(args.cache)
+    source_dir = args.openssl_source or recipe_matrix.find_openssl_source()
     all_passed = True
 
     all_passed &= simulate_conan_settings()
     test_configure_command_generation()
     test_real_world_scenarios()
+    results, matrix_passed = test_recipe_matrix(args.jobs, cache)
+    all_passed &= matrix_passed
+    if args.configure:
+        all_passed &= test_configure_dry_runs(results, source_dir, args.jobs, cache, args.image)
+    if cache:
+        cache.save(recipe_matrix.cache_sections(source_dir if args.configure else None, args.image))
     all_passed &= verify_files_exist()
 
     print("="*70)
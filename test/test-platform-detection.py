@@ -1,8 +1,18 @@
 #!/usr/bin/env python3
 """
 Test cross-platform detection logic from DevEnv OpenSSL conanfile.py
+
+test_recipe_platform_detection() asks the real sparetools-openssl recipe
+(through recipe_matrix) for the Configure target of each OS/arch, in
+parallel and cached per recipe digest.
 """
 
+import sys
+from pathlib import Path
+
+sys.path.insert(0, str(Path(__file__).resolve().parent))
+import recipe_matrix
+
 def test_platform_detection():
     """Test the platform mapping logic"""
 
@@ -63,6 +73,49 @@ def test_platform_detection():
     return failed == 0
 
 
+def test_recipe_platform_detection():
+    """The same OS/arch pairs against the real recipe's _get_target()"""
+
+    # (os, arch, expected Configure target of sparetools-openssl)
+    test_cases = [
+        ("Linux", "x86_64", "linux-x86_64"),
+        ("Linux", "x86", "linux-x86"),
+        ("Linux", "armv7", "linux-armv4"),
+        ("Linux", "armv8", "linux-aarch64"),
+        ("Linux", "ppc64le", "linux-ppc64le"),
+        ("Macos", "x86_64", "darwin64-x86_64-cc"),
+        ("Macos", "armv8", "darwin64-arm64-cc"),
+        ("Windows", "x86_64", "VC-WIN64A"),
+        ("Windows", "x86", "VC-WIN32"),
+        ("FreeBSD", "x86_64", "BSD-x86_64"),
+        # Unknown combinations fall back to linux-x86_64 with a warning
+        ("Linux", "s390x", "linux-x86_64"),
+    ]
+    configs = [{"name": f"{os_name}/{arch}", "os": os_name, "arch": arch, "expected_target": expected,
+                "compiler": {"Windows": "msvc", "Macos": "apple-clang"}.get(os_name, "gcc")}
+               for os_name, arch, expected in test_cases]
+
+    print("\n" + "="*70)
+    print("RECIPE PLATFORM DETECTION TEST")
+    print("="*70)
+    print()
+
+    cache = recipe_matrix.ResultCache()
+    results = recipe_matrix.evaluate_matrix(configs, cache=cache)
+    cache.save(recipe_matrix.cache_sections())
+
+    failed = 0
+    for config, r in zip(configs, results):
+        status = "✅ PASS" if r["passed"] else "❌ FAIL"
+        failed += not r["passed"]
+        print(f"{status}: {config['os']:10} + {config['arch']:10} → {r.get('target', r.get('error')):25} "
+              f"(expected: {config['expected_target']})")
+
+    print()
+    print(f"Results: {len(results) - failed} passed, {failed} failed out of {len(results)} tests")
+    return failed == 0
+
+
 def test_configure_args_generation():
     """Test that configure arguments are generated correctly for different platforms"""
 
@@ -203,6 +256,7 @@ if __name__ == "__main__":
 
     # Run all tests
     all_passed &= test_platform_detection()
+    all_passed &= test_recipe_platform_detection()
     test_configure_args_generation()
     all_passed &= test_version_consistency()
     test_cpython_staging_env()